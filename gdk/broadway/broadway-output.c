@@ -18,11 +18,15 @@ struct BroadwayOutput {
   GString *buf;
   int error;
   guint32 serial;
+  guint32 next_node_id;
+  GConverter *deflate;
+  GByteArray *deflate_buf;
 };
 
 static void
 broadway_output_send_cmd (BroadwayOutput *output,
-                          gboolean fin, BroadwayWSOpCode code,
+                          gboolean fin, gboolean compressed,
+                          BroadwayWSOpCode code,
                           const void *buf, gsize count)
 {
   gboolean mask = FALSE;
@@ -33,7 +37,7 @@ broadway_output_send_cmd (BroadwayOutput *output,
   gboolean long_header = count > 65535;
 
   /* NB. big-endian spec => bit 0 == MSB */
-  header[0] = ( (fin ? 0x80 : 0) | (code & 0x0f) );
+  header[0] = ( (fin ? 0x80 : 0) | (compressed ? 0x40 : 0) | (code & 0x0f) );
   header[1] = ( (mask ? 0x80 : 0) |
                 (mid_header ? 126 : long_header ? 127 : count) );
   p = 2;
@@ -55,7 +59,44 @@ broadway_output_send_cmd (BroadwayOutput *output,
 
 void broadway_output_pong (BroadwayOutput *output)
 {
-  broadway_output_send_cmd (output, TRUE, BROADWAY_WS_CNX_PONG, NULL, 0);
+  broadway_output_send_cmd (output, TRUE, FALSE, BROADWAY_WS_CNX_PONG, NULL, 0);
+}
+
+/* Compresses the buffer as a permessage-deflate message (RFC 7692),
+ * keeping the compression context between messages. */
+static gboolean
+broadway_output_deflate (BroadwayOutput *output)
+{
+  const guchar *in = (const guchar *)output->buf->str;
+  gsize in_len = output->buf->len;
+  gsize pos, space, bytes_read, bytes_written;
+  GByteArray *out = output->deflate_buf;
+
+  pos = 0;
+  do
+    {
+      space = MAX (in_len, 1024);
+      g_byte_array_set_size (out, pos + space);
+      if (g_converter_convert (output->deflate,
+                               in, in_len,
+                               out->data + pos, space,
+                               G_CONVERTER_FLUSH,
+                               &bytes_read, &bytes_written,
+                               NULL) == G_CONVERTER_ERROR)
+        return FALSE;
+      in += bytes_read;
+      in_len -= bytes_read;
+      pos += bytes_written;
+    }
+  /* The flush is only complete once there is output space left */
+  while (in_len > 0 || bytes_written == space);
+
+  /* Drop the 0x00 0x00 0xff 0xff that ends the sync flush */
+  if (pos >= 4 && memcmp (out->data + pos - 4, "\x00\x00\xff\xff", 4) == 0)
+    pos -= 4;
+  g_byte_array_set_size (out, pos);
+
+  return TRUE;
 }
 
 int
@@ -64,8 +105,17 @@ broadway_output_flush (BroadwayOutput *output)
   if (output->buf->len == 0)
     return TRUE;
 
-  broadway_output_send_cmd (output, TRUE, BROADWAY_WS_BINARY,
-                            output->buf->str, output->buf->len);
+  if (output->deflate != NULL)
+    {
+      if (broadway_output_deflate (output))
+        broadway_output_send_cmd (output, TRUE, TRUE, BROADWAY_WS_BINARY,
+                                  output->deflate_buf->data, output->deflate_buf->len);
+      else
+        output->error = TRUE;
+    }
+  else
+    broadway_output_send_cmd (output, TRUE, FALSE, BROADWAY_WS_BINARY,
+                              output->buf->str, output->buf->len);
 
   g_string_set_size (output->buf, 0);
 
@@ -91,9 +141,25 @@ void
 broadway_output_free (BroadwayOutput *output)
 {
   g_object_unref (output->out);
+  if (output->deflate)
+    {
+      g_object_unref (output->deflate);
+      g_byte_array_unref (output->deflate_buf);
+    }
   free (output);
 }
 
+/* Call after negotiating permessage-deflate with the client */
+void
+broadway_output_enable_deflate (BroadwayOutput *output)
+{
+  if (output->deflate != NULL)
+    return;
+
+  output->deflate = G_CONVERTER (g_zlib_compressor_new (G_ZLIB_COMPRESSOR_FORMAT_RAW, -1));
+  output->deflate_buf = g_byte_array_new ();
+}
+
 guint32
 broadway_output_get_next_serial (BroadwayOutput *output)
 {
@@ -333,7 +399,7 @@ append_type (BroadwayOutput *output, guint32 type, BroadwayNode *node)
  * parts.
  *
  * Reusing existing dom nodes are problematic because doing so
- * automatically inherits all their children.  There are two cases
+ * automatically inherits all their children.  There are three cases
  * where we do this:
  *
  * If the entire sub tree is identical we emit a KEEP_ALL node which
@@ -343,13 +409,166 @@ append_type (BroadwayOutput *output, guint32 type, BroadwayNode *node)
  * and all parents are also unchanged, then we can just avoid
  * changing the dom node at all, and we emit a KEEP_THIS node.
  *
+ * If an identical sub tree exists anywhere else in the old tree we
+ * emit a REUSE node with the id of its dom node, which the client
+ * then moves into place. This handles reordered and reparented
+ * subtrees.  For this to work the old dom node must not be used
+ * by any KEEP_ALL or KEEP_THIS, so we first do a pass over the
+ * tree that collects the old nodes these will use.
+ *
+ * Every node that is sent gets a new id, both sides count these
+ * in the order the nodes appear in the stream, so the ids never
+ * need to be sent. Kept and reused nodes keep their old ids.
+ *
  ***********************************/
+
+typedef struct {
+  GHashTable *old_nodes; /* all old subtrees, by content */
+  GHashTable *parents;   /* old node -> old parent */
+  GHashTable *kept;      /* old node -> KEEP_ALL or KEEP_THIS */
+  GHashTable *reusable;  /* unused old subtrees, by content */
+} NodeDiff;
+
+static guint
+node_hash (gconstpointer key)
+{
+  return ((const BroadwayNode *)key)->hash;
+}
+
+static gboolean
+node_deep_equal (gconstpointer a,
+                 gconstpointer b)
+{
+  return broadway_node_deep_equal ((BroadwayNode *)a, (BroadwayNode *)b);
+}
+
+static void
+collect_old_nodes (NodeDiff     *diff,
+                   BroadwayNode *old_node,
+                   BroadwayNode *parent)
+{
+  guint32 i;
+
+  if (!g_hash_table_contains (diff->old_nodes, old_node))
+    g_hash_table_add (diff->old_nodes, old_node);
+  if (parent)
+    g_hash_table_insert (diff->parents, old_node, parent);
+
+  for (i = 0; i < old_node->n_children; i++)
+    collect_old_nodes (diff, old_node->children[i], old_node);
+}
+
+/* This must make the same decisions as append_node() */
+static void
+collect_kept_nodes (NodeDiff     *diff,
+                    BroadwayNode *node,
+                    BroadwayNode *old_node,
+                    gboolean      all_parents_are_kept)
+{
+  guint32 i;
+
+  if (old_node != NULL && broadway_node_equal (node, old_node))
+    {
+      if (broadway_node_deep_equal (node, old_node))
+        {
+          g_hash_table_insert (diff->kept, old_node, GINT_TO_POINTER (BROADWAY_NODE_KEEP_ALL));
+          return;
+        }
+
+      if (all_parents_are_kept)
+        {
+          g_hash_table_insert (diff->kept, old_node, GINT_TO_POINTER (BROADWAY_NODE_KEEP_THIS));
+          for (i = 0; i < node->n_children; i++)
+            collect_kept_nodes (diff, node->children[i],
+                                i < old_node->n_children ? old_node->children[i] : NULL,
+                                TRUE);
+          return;
+        }
+    }
+
+  /* This will be reused, or sent without looking at old_node */
+  if (g_hash_table_contains (diff->old_nodes, node))
+    return;
+
+  for (i = 0; i < node->n_children; i++)
+    collect_kept_nodes (diff,
+                        node->children[i],
+                        (old_node != NULL && i < old_node->n_children) ? old_node->children[i] : NULL,
+                        FALSE);
+}
+
+/* Returns TRUE if old_node or any of its descendants are kept */
+static gboolean
+collect_reusable_nodes (NodeDiff     *diff,
+                        BroadwayNode *old_node)
+{
+  gpointer keep;
+  gboolean in_use;
+  guint32 i;
+
+  keep = g_hash_table_lookup (diff->kept, old_node);
+  if (GPOINTER_TO_INT (keep) == BROADWAY_NODE_KEEP_ALL)
+    return TRUE;
+
+  in_use = keep != NULL;
+  for (i = 0; i < old_node->n_children; i++)
+    {
+      if (collect_reusable_nodes (diff, old_node->children[i]))
+        in_use = TRUE;
+    }
+
+  if (!in_use && !g_hash_table_contains (diff->reusable, old_node))
+    g_hash_table_add (diff->reusable, old_node);
+
+  return in_use;
+}
+
+static void
+forget_reusable_subtree (NodeDiff     *diff,
+                         BroadwayNode *old_node)
+{
+  guint32 i;
+
+  g_hash_table_remove (diff->reusable, old_node);
+  for (i = 0; i < old_node->n_children; i++)
+    forget_reusable_subtree (diff, old_node->children[i]);
+}
+
+/* Once a dom node is moved neither it, its children, nor the
+ * parents that it was moved out of can be reused again */
+static void
+forget_reusable (NodeDiff     *diff,
+                 BroadwayNode *old_node)
+{
+  BroadwayNode *parent;
+
+  forget_reusable_subtree (diff, old_node);
+
+  for (parent = g_hash_table_lookup (diff->parents, old_node);
+       parent != NULL;
+       parent = g_hash_table_lookup (diff->parents, parent))
+    g_hash_table_remove (diff->reusable, parent);
+}
+
+static void
+copy_node_ids (BroadwayNode *node,
+               BroadwayNode *old_node)
+{
+  guint32 i;
+
+  node->id = old_node->id;
+  for (i = 0; i < node->n_children; i++)
+    copy_node_ids (node->children[i], old_node->children[i]);
+}
+
 static void
 append_node (BroadwayOutput *output,
+             NodeDiff       *diff,
              BroadwayNode   *node,
              BroadwayNode   *old_node,
              gboolean        all_parents_are_kept)
 {
+  BroadwayNode *reused;
   guint32 i;
 
   append_node_depth++;
@@ -359,15 +578,17 @@ append_node (BroadwayOutput *output,
       if (broadway_node_deep_equal (node, old_node))
         {
           append_type (output, BROADWAY_NODE_KEEP_ALL, node);
+          copy_node_ids (node, old_node);
           goto out;
         }
 
       if (all_parents_are_kept)
         {
           append_type (output, BROADWAY_NODE_KEEP_THIS, node);
+          node->id = old_node->id;
           append_uint32 (output, node->n_children);
           for (i = 0; i < node->n_children; i++)
-            append_node (output, node->children[i],
+            append_node (output, diff, node->children[i],
                          i < old_node->n_children ? old_node->children[i] : NULL,
                          TRUE);
 
@@ -375,11 +596,29 @@ append_node (BroadwayOutput *output,
         }
     }
 
+  if (g_hash_table_contains (diff->old_nodes, node))
+    {
+      reused = g_hash_table_lookup (diff->reusable, node);
+      if (reused != NULL)
+        {
+          append_type (output, BROADWAY_NODE_REUSE, node);
+          append_uint32 (output, reused->id);
+          copy_node_ids (node, reused);
+          forget_reusable (diff, reused);
+          goto out;
+        }
+
+      /* Must match collect_kept_nodes() */
+      old_node = NULL;
+    }
+
+  node->id = ++output->next_node_id;
+
   append_type (output, node->type, node);
   for (i = 0; i < node->n_data; i++)
     append_uint32 (output, node->data[i]);
   for (i = 0; i < node->n_children; i++)
-    append_node (output,
+    append_node (output, diff,
                  node->children[i],
                  (old_node != NULL && i < old_node->n_children) ? old_node->children[i] : NULL,
                  FALSE);
@@ -394,12 +633,28 @@ broadway_output_surface_set_nodes (BroadwayOutput *output,
                                    BroadwayNode   *root,
                                    BroadwayNode   *old_root)
 {
+  NodeDiff diff;
   gsize size_pos, start, end;
 
   /* Early return if nothing changed */
   if (old_root != NULL &&
       broadway_node_deep_equal (root, old_root))
-    return;
+    {
+      copy_node_ids (root, old_root);
+      return;
+    }
+
+  diff.old_nodes = g_hash_table_new (node_hash, node_deep_equal);
+  diff.parents = g_hash_table_new (NULL, NULL);
+  diff.kept = g_hash_table_new (NULL, NULL);
+  diff.reusable = g_hash_table_new (node_hash, node_deep_equal);
+
+  if (old_root != NULL)
+    {
+      collect_old_nodes (&diff, old_root, NULL);
+      collect_kept_nodes (&diff, root, old_root, TRUE);
+      collect_reusable_nodes (&diff, old_root);
+    }
 
   write_header (output, BROADWAY_OP_SET_NODES);
 
@@ -412,9 +667,14 @@ broadway_output_surface_set_nodes (BroadwayOutput *output,
 #ifdef DEBUG_NODE_SENDING
   g_print ("====== node tree for %d =======\n", id);
 #endif
-  append_node (output, root, old_root, TRUE);
+  append_node (output, &diff, root, old_root, TRUE);
   end = output->buf->len;
   patch_uint32 (output, (end - start) / 4, size_pos);
+
+  g_hash_table_unref (diff.old_nodes);
+  g_hash_table_unref (diff.parents);
+  g_hash_table_unref (diff.kept);
+  g_hash_table_unref (diff.reusable);
 }
 
 void
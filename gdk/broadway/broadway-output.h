@@ -20,6 +20,7 @@ typedef enum {
 BroadwayOutput *broadway_output_new                 (GOutputStream  *out,
                                                      guint32         serial);
 void            broadway_output_free                (BroadwayOutput *output);
+void            broadway_output_enable_deflate      (BroadwayOutput *output);
 int             broadway_output_flush               (BroadwayOutput *output);
 int             broadway_output_has_error           (BroadwayOutput *output);
 void            broadway_output_set_next_serial     (BroadwayOutput *output,
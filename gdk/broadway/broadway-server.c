@@ -39,6 +39,7 @@
 typedef struct {
   int id;
   guint32 tag;
+  gint64 send_time;
 } BroadwayOutstandingRoundtrip;
 
 typedef struct BroadwayInput BroadwayInput;
@@ -89,6 +90,11 @@ struct _BroadwayServer {
   int future_mouse_in_surface;
 
   GList *outstanding_roundtrips;
+
+  /* Motion held back until the browser has handled the last roundtrip */
+  BroadwayInputMsg *pending_motion;
+
+  BroadwayServerStats stats;
 };
 
 struct _BroadwayServerClass
@@ -110,6 +116,8 @@ struct BroadwayInput {
   GIOStream *connection;
   GByteArray *buffer;
   GSource *source;
+  GConverter *inflate;
+  GByteArray *inflate_buf;
   gboolean seen_time;
   gint64 time_base;
   gboolean active;
@@ -228,6 +236,7 @@ broadway_server_finalize (GObject *object)
   g_free (server->ssl_cert);
   g_free (server->ssl_key);
   g_hash_table_destroy (server->textures);
+  g_free (server->pending_motion);
 
   G_OBJECT_CLASS (broadway_server_parent_class)->finalize (object);
 }
@@ -273,6 +282,11 @@ broadway_input_free (BroadwayInput *input)
 {
   g_object_unref (input->connection);
   g_byte_array_free (input->buffer, FALSE);
+  if (input->inflate)
+    {
+      g_object_unref (input->inflate);
+      g_byte_array_unref (input->inflate_buf);
+    }
   g_source_destroy (input->source);
   g_free (input);
 }
@@ -381,6 +395,10 @@ broadway_server_lookahead_event (BroadwayServer  *server,
   BroadwayInputMsg *message;
   GList *l;
 
+  if (server->pending_motion != NULL &&
+      strchr (types, BROADWAY_EVENT_POINTER_MOVE) != NULL)
+    return TRUE;
+
   for (l = server->input_messages; l != NULL; l = l->next)
     {
       message = l->data;
@@ -420,6 +438,22 @@ process_input_message (BroadwayServer *server,
   broadway_events_got_input (message, client);
 }
 
+static void
+process_pending_motion (BroadwayServer *server)
+{
+  if (server->pending_motion == NULL)
+    return;
+
+  process_input_message (server, server->pending_motion);
+  g_clear_pointer (&server->pending_motion, g_free);
+}
+
+/* While the browser has not yet answered a roundtrip, i.e. not yet
+ * caught up with the frames we sent, there is no point in sending
+ * every pointer motion on to the clients, so we only keep the last
+ * one. It is sent when any other event comes in, which includes the
+ * roundtrip reply, so the order of events is unchanged.
+ */
 static void
 process_input_messages (BroadwayServer *server)
 {
@@ -440,9 +474,48 @@ process_input_messages (BroadwayServer *server)
           message->base.serial = server->saved_serial - 1;
         }
 
+      if (message->base.type == BROADWAY_EVENT_POINTER_MOVE &&
+          server->outstanding_roundtrips != NULL)
+        {
+          if (server->pending_motion != NULL)
+            {
+              g_free (server->pending_motion);
+              server->stats.n_coalesced_motions++;
+            }
+          server->pending_motion = message;
+          continue;
+        }
+
+      process_pending_motion (server);
+
       process_input_message (server, message);
       g_free (message);
     }
+
+  if (server->outstanding_roundtrips == NULL)
+    process_pending_motion (server);
+}
+
+static void
+record_roundtrip_time (BroadwayServer *server,
+                       gint64          time)
+{
+  BroadwayServerStats *stats = &server->stats;
+
+  if (stats->n_roundtrips == 0 || time < stats->min_roundtrip)
+    stats->min_roundtrip = time;
+  if (time > stats->max_roundtrip)
+    stats->max_roundtrip = time;
+  stats->last_roundtrip = time;
+  stats->total_roundtrip += time;
+  stats->n_roundtrips++;
+}
+
+void
+broadway_server_get_stats (BroadwayServer      *server,
+                           BroadwayServerStats *stats)
+{
+  *stats = server->stats;
 }
 
 static void
@@ -605,6 +678,7 @@ parse_input_message (BroadwayInput *input, const unsigned char *message)
         if (rt->id == msg.roundtrip_notify.id &&
             rt->tag == msg.roundtrip_notify.tag)
           {
+            record_roundtrip_time (server, g_get_monotonic_time () - rt->send_time);
             server->outstanding_roundtrips = g_list_delete_link (server->outstanding_roundtrips, l);
             g_free (rt);
             break;
@@ -654,6 +728,52 @@ hex_dump (guchar *data, gsize len)
 #endif
 }
 
+/* We ask for client_no_context_takeover, so every compressed
+ * message can be inflated on its own */
+static const guchar *
+inflate_message (BroadwayInput *input,
+                 const guchar  *data,
+                 gsize          len)
+{
+  static const guchar tail[] = { 0x00, 0x00, 0xff, 0xff };
+  GByteArray *in, *out = input->inflate_buf;
+  gsize in_pos, pos, space, bytes_read, bytes_written;
+  GConverterResult res;
+
+  in = g_byte_array_sized_new (len + sizeof (tail));
+  g_byte_array_append (in, data, len);
+  g_byte_array_append (in, tail, sizeof (tail));
+
+  g_converter_reset (input->inflate);
+
+  in_pos = 0;
+  pos = 0;
+  do
+    {
+      space = MAX (4 * in->len, 256);
+      g_byte_array_set_size (out, pos + space);
+      res = g_converter_convert (input->inflate,
+                                 in->data + in_pos, in->len - in_pos,
+                                 out->data + pos, space,
+                                 G_CONVERTER_FLUSH,
+                                 &bytes_read, &bytes_written,
+                                 NULL);
+      in_pos += bytes_read;
+      pos += bytes_written;
+    }
+  while (res != G_CONVERTER_ERROR &&
+         (in_pos < in->len || bytes_written == space));
+
+  g_byte_array_unref (in);
+
+  if (res == G_CONVERTER_ERROR)
+    return NULL;
+
+  g_byte_array_set_size (out, pos);
+
+  return out->data;
+}
+
 static void
 parse_input (BroadwayInput *input)
 {
@@ -666,8 +786,9 @@ parse_input (BroadwayInput *input)
     {
       gsize len, payload_len;
       BroadwayWSOpCode code;
-      gboolean is_mask, fin;
+      gboolean is_mask, fin, compressed;
       guchar *buf, *data, *mask;
+      const guchar *message;
 
       buf = input->buffer->data;
       len = input->buffer->len;
@@ -677,6 +798,7 @@ parse_input (BroadwayInput *input)
 #endif
 
       fin = buf[0] & 0x80;
+      compressed = buf[0] & 0x40;
       code = buf[0] & 0x0f;
       payload_len = buf[1] & 0x7f;
       is_mask = buf[1] & 0x80;
@@ -728,7 +850,14 @@ parse_input (BroadwayInput *input)
           }
         else
           {
-            parse_input_message (input, data);
+            message = data;
+            if (compressed && input->inflate != NULL)
+              message = inflate_message (input, data, payload_len);
+
+            if (message != NULL)
+              parse_input_message (input, message);
+            else
+              g_warning ("can't inflate compressed input");
           }
         break;
       case BROADWAY_WS_CNX_PING:
@@ -898,6 +1027,7 @@ broadway_server_roundtrip (BroadwayServer *server,
       BroadwayOutstandingRoundtrip *rt = g_new0 (BroadwayOutstandingRoundtrip, 1);
       rt->id = id;
       rt->tag = tag;
+      rt->send_time = g_get_monotonic_time ();
       server->outstanding_roundtrips = g_list_prepend (server->outstanding_roundtrips, rt);
 
       broadway_output_roundtrip (server->output, id, tag);
@@ -984,6 +1114,7 @@ start_input (HttpRequest *request)
   gsize data_buffer_size;
   GInputStream *in;
   const char *key;
+  gboolean deflate;
   GSocket *socket;
   int flag = 1;
 
@@ -995,10 +1126,13 @@ start_input (HttpRequest *request)
   key = NULL;
   origin = NULL;
   host = NULL;
+  deflate = FALSE;
   for (i = 0; lines[i] != NULL; i++)
     {
       if ((p = parse_line (lines[i], "Sec-WebSocket-Key")))
         key = p;
+      else if ((p = parse_line (lines[i], "Sec-WebSocket-Extensions")))
+        deflate |= strstr (p, "permessage-deflate") != NULL;
       else if ((p = parse_line (lines[i], "Origin")))
         origin = p;
       else if ((p = parse_line (lines[i], "Host")))
@@ -1024,9 +1158,11 @@ start_input (HttpRequest *request)
                              "%s%s%s"
                              "Sec-WebSocket-Location: ws://%s/socket\r\n"
                              "Sec-WebSocket-Protocol: broadway\r\n"
+                             "%s"
                              "\r\n", accept,
                              origin?"Sec-WebSocket-Origin: ":"", origin?origin:"", origin?"\r\n":"",
-                             host);
+                             host,
+                             deflate?"Sec-WebSocket-Extensions: permessage-deflate; client_no_context_takeover\r\n":"");
       g_free (accept);
 
 #ifdef DEBUG_WEBSOCKETS
@@ -1059,6 +1195,13 @@ start_input (HttpRequest *request)
   input->output =
     broadway_output_new (g_io_stream_get_output_stream (request->connection), 0);
 
+  if (deflate)
+    {
+      broadway_output_enable_deflate (input->output);
+      input->inflate = G_CONVERTER (g_zlib_decompressor_new (G_ZLIB_COMPRESSOR_FORMAT_RAW));
+      input->inflate_buf = g_byte_array_new ();
+    }
+
   /* This will free and close the data input stream, but we got all the buffered content already */
   http_request_free (request);
 
@@ -23,12 +23,22 @@ typedef struct _BroadwayNode BroadwayNode;
 struct _BroadwayNode {
   guint32 type;
   guint32 hash; /* deep hash */
+  guint32 id; /* id of the dom node on the client, assigned when sent */
   guint32 n_children;
   BroadwayNode **children;
   guint32 n_data;
   guint32 data[1];
 };
 
+typedef struct {
+  guint32 n_roundtrips;
+  gint64 last_roundtrip; /* in microseconds */
+  gint64 min_roundtrip;
+  gint64 max_roundtrip;
+  gint64 total_roundtrip;
+  guint32 n_coalesced_motions;
+} BroadwayServerStats;
+
 gboolean            broadway_node_equal                       (BroadwayNode    *a,
                                                                BroadwayNode    *b);
 gboolean            broadway_node_deep_equal                  (BroadwayNode    *a,
@@ -111,6 +121,8 @@ gboolean            broadway_server_surface_move_resize       (BroadwayServer  *
                                                                int              height);
 void                broadway_server_focus_surface             (BroadwayServer  *server,
                                                                gint             new_focused_surface);
+void                broadway_server_get_stats                 (BroadwayServer      *server,
+                                                               BroadwayServerStats *stats);
 
 
 #endif /* __BROADWAY_SERVER__ */
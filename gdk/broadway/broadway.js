@@ -82,6 +82,7 @@ var realSurfaceWithMouse = 0;
 var surfaceWithMouse = 0;
 var surfaces = {};
 var textures = {};
+var lastNodeId = 0;
 var stackingOrder = [];
 var outstandingCommands = new Array();
 var inputSocket = null;
@@ -303,6 +304,27 @@ function SwapNodes(node_data, div) {
     this.data_pos = 0;
     this.div = div;
     this.outstanding = 1;
+    this.removed = [];
+    this.nodesById = null;
+}
+
+/* Finds an old dom node by id, looking both in the surface and in
+   the subtrees that were already replaced by this update */
+SwapNodes.prototype.lookupNode = function(id) {
+    if (!this.nodesById) {
+        var roots = [this.div].concat(this.removed);
+        this.nodesById = {};
+        for (var i = 0; i < roots.length; i++) {
+            var elements = roots[i].getElementsByTagName('*');
+            if (roots[i].broadwayId)
+                this.nodesById[roots[i].broadwayId] = roots[i];
+            for (var j = 0; j < elements.length; j++) {
+                if (elements[j].broadwayId)
+                    this.nodesById[elements[j].broadwayId] = elements[j];
+            }
+        }
+    }
+    return this.nodesById[id];
 }
 
 SwapNodes.prototype.decode_uint32 = function() {
@@ -419,6 +441,11 @@ SwapNodes.prototype.insertNode = function(parent, posInParent, oldNode)
 {
     var type = this.decode_uint32();
     var newNode = null;
+    var nodeId = 0;
+
+    // Ids are given to new nodes in stream order, same as on the server
+    if (type < 11)
+        nodeId = ++lastNodeId;
 
     // We need to dup this because as we reuse children the original order is lost
     var oldChildren = [];
@@ -647,7 +674,8 @@ SwapNodes.prototype.insertNode = function(parent, posInParent, oldNode)
             if (!oldNode)
                 alert("KEEP_ALL with no oldNode");
 
-            if (oldNode.parentNode != parent)
+            if (oldNode.parentNode != parent ||
+                (posInParent >= 0 && parent.children[posInParent] != oldNode))
                 newNode = oldNode;
             else
                 newNode = null;
@@ -659,10 +687,6 @@ SwapNodes.prototype.insertNode = function(parent, posInParent, oldNode)
             if (!oldNode)
                 alert("KEEP_THIS with no oldNode ");
 
-            /* We only get keep-this if all parents were kept, check this */
-            if (oldNode.parentNode != parent)
-                alert("Got KEEP_THIS for non-kept parent");
-
             var len = this.decode_uint32();
             var i;
 
@@ -671,12 +695,28 @@ SwapNodes.prototype.insertNode = function(parent, posInParent, oldNode)
                                 oldChildren[i]);
             }
 
-            /* Remove children that are after the new length */
-            for (i = oldChildren.length - 1; i > len - 1; i--)
-                oldNode.removeChild(oldChildren[i]);
+            /* Remove children that are after the new length. Some
+               old children may have been reused earlier in the list,
+               so go by the current children */
+            while (oldNode.children.length > len)
+                this.removed.push(oldNode.removeChild(oldNode.lastElementChild));
 
-            /* NOTE: No need to modify the parent, we're keeping this node as is */
-            newNode = null;
+            /* We only get keep-this if all parents were kept, so normally
+               there is no need to modify the parent. However, a reused
+               sibling can have moved this node */
+            if (parent.children[posInParent] != oldNode)
+                newNode = oldNode;
+            else
+                newNode = null;
+        }
+        break;
+
+    case 13:  // REUSE
+        {
+            var id = this.decode_uint32();
+            newNode = this.lookupNode(id);
+            if (!newNode)
+                alert("REUSE of unknown node " + id);
         }
         break;
 
@@ -684,9 +724,12 @@ SwapNodes.prototype.insertNode = function(parent, posInParent, oldNode)
         alert("Unexpected node type " + type);
     }
 
+    if (nodeId)
+        newNode.broadwayId = nodeId;
+
     if (newNode) {
         if (posInParent >= 0 && parent.children[posInParent])
-            parent.replaceChild(newNode, parent.children[posInParent]);
+            this.removed.push(parent.replaceChild(newNode, parent.children[posInParent]));
         else
             parent.appendChild(newNode);
     }
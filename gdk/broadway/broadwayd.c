@@ -298,6 +298,7 @@ decode_nodes (BroadwayClient *client,
 
   node = g_malloc (sizeof(BroadwayNode) + (size - 1) * sizeof(guint32) + n_children * sizeof (BroadwayNode *));
   node->type = type;
+  node->id = 0;
   node->n_children = n_children;
   node->children = (BroadwayNode **)((char *)node + sizeof(BroadwayNode) + (size - 1) * sizeof(guint32));
   node->n_data = size;
@@ -634,6 +635,24 @@ incoming_client (GSocketService    *service,
   return TRUE;
 }
 
+static gboolean
+print_stats (gpointer data)
+{
+  BroadwayServerStats stats;
+
+  broadway_server_get_stats (server, &stats);
+
+  g_print ("roundtrips: %u", stats.n_roundtrips);
+  if (stats.n_roundtrips > 0)
+    g_print (", latency last %.1f ms, min %.1f ms, avg %.1f ms, max %.1f ms",
+             stats.last_roundtrip / 1000.,
+             stats.min_roundtrip / 1000.,
+             stats.total_roundtrip / 1000. / stats.n_roundtrips,
+             stats.max_roundtrip / 1000.);
+  g_print ("; coalesced motions: %u\n", stats.n_coalesced_motions);
+
+  return G_SOURCE_CONTINUE;
+}
 
 int
 main (int argc, char *argv[])
@@ -648,6 +667,7 @@ main (int argc, char *argv[])
   int http_port = 0;
   char *ssl_cert = NULL;
   char *ssl_key = NULL;
+  int stats_interval = 0;
   const char *display;
   int port = 0;
   const GOptionEntry entries[] = {
@@ -658,6 +678,7 @@ main (int argc, char *argv[])
 #endif
     { "cert", 'c', 0, G_OPTION_ARG_STRING, &ssl_cert, "SSL certificate path", "PATH" },
     { "key", 'k', 0, G_OPTION_ARG_STRING, &ssl_key, "SSL key path", "PATH" },
+    { "stats", 's', 0, G_OPTION_ARG_INT, &stats_interval, "Print latency statistics every SECONDS", "SECONDS" },
     { NULL }
   };
 
@@ -742,6 +763,9 @@ main (int argc, char *argv[])
 
   g_socket_service_start (G_SOCKET_SERVICE (listener));
 
+  if (stats_interval > 0)
+    g_timeout_add_seconds (stats_interval, print_stats, NULL);
+
   loop = g_main_loop_new (NULL, FALSE);
   g_main_loop_run (loop);
   
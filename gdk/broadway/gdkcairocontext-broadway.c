@@ -21,14 +21,41 @@
 #include "gdkconfig.h"
 
 #include "gdkcairocontext-broadway.h"
+#include "gdkcairo.h"
 #include "gdktextureprivate.h"
 #include "gdkprivate-broadway.h"
 
+/* Frames are sent to the browser as a grid of textures, and only
+ * the tiles that were painted in a frame are encoded and uploaded
+ * again. The other tiles keep their texture, and the node diffing
+ * in the server leaves them alone in the browser.
+ */
+#define TILE_SIZE 128
+
 G_DEFINE_TYPE (GdkBroadwayCairoContext, gdk_broadway_cairo_context, GDK_TYPE_CAIRO_CONTEXT)
 
+static void
+gdk_broadway_cairo_context_clear_tiles (GdkBroadwayCairoContext *self)
+{
+  int i;
+
+  for (i = 0; i < self->n_columns * self->n_rows; i++)
+    g_clear_object (&self->tiles[i]);
+
+  g_clear_pointer (&self->tiles, g_free);
+  self->n_columns = 0;
+  self->n_rows = 0;
+
+  g_clear_pointer (&self->paint_surface, cairo_surface_destroy);
+}
+
 static void
 gdk_broadway_cairo_context_dispose (GObject *object)
 {
+  GdkBroadwayCairoContext *self = GDK_BROADWAY_CAIRO_CONTEXT (object);
+
+  gdk_broadway_cairo_context_clear_tiles (self);
+
   G_OBJECT_CLASS (gdk_broadway_cairo_context_parent_class)->dispose (object);
 }
 
@@ -39,23 +66,37 @@ gdk_broadway_cairo_context_begin_frame (GdkDrawContext *draw_context,
   GdkBroadwayCairoContext *self = GDK_BROADWAY_CAIRO_CONTEXT (draw_context);
   GdkSurface *surface = gdk_draw_context_get_surface (GDK_DRAW_CONTEXT (self));
   cairo_t *cr;
-  cairo_region_t *repaint_region;
   int width, height, scale;
 
   width = gdk_surface_get_width (surface);
   height = gdk_surface_get_height (surface);
   scale = gdk_surface_get_scale_factor (surface);
-  self->paint_surface = cairo_image_surface_create (CAIRO_FORMAT_ARGB32,
-                                                    width * scale, height * scale);
-  cairo_surface_set_device_scale (self->paint_surface, scale, scale);
 
-  repaint_region = cairo_region_create_rectangle (&(cairo_rectangle_int_t) { 0, 0, width, height });
-  cairo_region_union (region, repaint_region);
-  cairo_region_destroy (repaint_region);
+  if (self->paint_surface == NULL ||
+      cairo_image_surface_get_width (self->paint_surface) != width * scale ||
+      cairo_image_surface_get_height (self->paint_surface) != height * scale)
+    {
+      cairo_region_t *repaint_region;
+
+      gdk_broadway_cairo_context_clear_tiles (self);
+
+      self->paint_surface = cairo_image_surface_create (CAIRO_FORMAT_ARGB32,
+                                                        width * scale, height * scale);
+      cairo_surface_set_device_scale (self->paint_surface, scale, scale);
+
+      self->n_columns = (width + TILE_SIZE - 1) / TILE_SIZE;
+      self->n_rows = (height + TILE_SIZE - 1) / TILE_SIZE;
+      self->tiles = g_new0 (GdkTexture *, self->n_columns * self->n_rows);
+
+      repaint_region = cairo_region_create_rectangle (&(cairo_rectangle_int_t) { 0, 0, width, height });
+      cairo_region_union (region, repaint_region);
+      cairo_region_destroy (repaint_region);
+    }
 
   /* clear the repaint area */
   cr = cairo_create (self->paint_surface);
   cairo_set_operator (cr, CAIRO_OPERATOR_CLEAR);
+  gdk_cairo_region (cr, region);
   cairo_fill (cr);
   cairo_destroy (cr);
 }
@@ -74,6 +115,32 @@ add_float (GArray *nodes, float f)
   g_array_append_val (nodes, u);
 }
 
+static GdkTexture *
+create_tile_texture (cairo_surface_t             *paint_surface,
+                     const cairo_rectangle_int_t *rect)
+{
+  cairo_surface_t *tile_surface;
+  GdkTexture *texture;
+  double sx, sy;
+  cairo_t *cr;
+
+  cairo_surface_get_device_scale (paint_surface, &sx, &sy);
+  tile_surface = cairo_image_surface_create (CAIRO_FORMAT_ARGB32,
+                                             rect->width * sx, rect->height * sy);
+  cairo_surface_set_device_scale (tile_surface, sx, sy);
+
+  cr = cairo_create (tile_surface);
+  cairo_set_operator (cr, CAIRO_OPERATOR_SOURCE);
+  cairo_set_source_surface (cr, paint_surface, - rect->x, - rect->y);
+  cairo_paint (cr);
+  cairo_destroy (cr);
+
+  texture = gdk_texture_new_for_surface (tile_surface);
+  cairo_surface_destroy (tile_surface);
+
+  return texture;
+}
+
 static void
 gdk_broadway_cairo_context_end_frame (GdkDrawContext *draw_context,
                                       cairo_region_t *painted)
@@ -81,36 +148,65 @@ gdk_broadway_cairo_context_end_frame (GdkDrawContext *draw_context,
   GdkBroadwayCairoContext *self = GDK_BROADWAY_CAIRO_CONTEXT (draw_context);
   GdkDisplay *display = gdk_draw_context_get_display (draw_context);
   GdkSurface *surface = gdk_draw_context_get_surface (draw_context);
-  GdkTexture *texture;
   GPtrArray *node_textures;
   GArray *nodes;
-  guint32 texture_id;
+  int width, height;
+  int row, column;
+
+  width = gdk_surface_get_width (surface);
+  height = gdk_surface_get_height (surface);
+
+  cairo_surface_flush (self->paint_surface);
 
   nodes = g_array_new (FALSE, FALSE, sizeof(guint32));
   node_textures = g_ptr_array_new_with_free_func (g_object_unref);
 
-  texture = gdk_texture_new_for_surface ((cairo_surface_t *)self->paint_surface);
-  g_ptr_array_add (node_textures, g_object_ref (texture)); /* Transfers ownership to node_textures */
-  texture_id = gdk_broadway_display_ensure_texture (display, texture);
-
-  add_uint32 (nodes, BROADWAY_NODE_TEXTURE);
-  add_float (nodes, 0);
-  add_float (nodes, 0);
-  add_float (nodes, cairo_image_surface_get_width (self->paint_surface));
-  add_float (nodes, cairo_image_surface_get_height (self->paint_surface));
-  add_uint32 (nodes, texture_id);
+  add_uint32 (nodes, BROADWAY_NODE_CONTAINER);
+  add_uint32 (nodes, self->n_columns * self->n_rows);
+
+  for (row = 0; row < self->n_rows; row++)
+    {
+      for (column = 0; column < self->n_columns; column++)
+        {
+          GdkTexture **tile = &self->tiles[row * self->n_columns + column];
+          cairo_rectangle_int_t rect;
+          guint32 texture_id;
+
+          rect.x = column * TILE_SIZE;
+          rect.y = row * TILE_SIZE;
+          rect.width = MIN (TILE_SIZE, width - rect.x);
+          rect.height = MIN (TILE_SIZE, height - rect.y);
+
+          if (*tile == NULL ||
+              cairo_region_contains_rectangle (painted, &rect) != CAIRO_REGION_OVERLAP_OUT)
+            {
+              g_clear_object (tile);
+              *tile = create_tile_texture (self->paint_surface, &rect);
+            }
+
+          g_ptr_array_add (node_textures, g_object_ref (*tile));
+          texture_id = gdk_broadway_display_ensure_texture (display, *tile);
+
+          add_uint32 (nodes, BROADWAY_NODE_TEXTURE);
+          add_float (nodes, rect.x);
+          add_float (nodes, rect.y);
+          add_float (nodes, rect.width);
+          add_float (nodes, rect.height);
+          add_uint32 (nodes, texture_id);
+        }
+    }
 
   gdk_broadway_surface_set_nodes (surface, nodes, node_textures);
   g_array_unref (nodes);
   g_ptr_array_unref (node_textures);
-
-  cairo_surface_destroy (self->paint_surface);
-  self->paint_surface = NULL;
 }
 
 static void
 gdk_broadway_cairo_context_surface_resized (GdkDrawContext *draw_context)
 {
+  GdkBroadwayCairoContext *self = GDK_BROADWAY_CAIRO_CONTEXT (draw_context);
+
+  gdk_broadway_cairo_context_clear_tiles (self);
 }
 
 static cairo_t *
@@ -40,6 +40,11 @@ struct _GdkBroadwayCairoContext
   GdkCairoContext parent_instance;
 
   cairo_surface_t *paint_surface;
+
+  /* The contents of the last frame, split into tiles of TILE_SIZE */
+  GdkTexture **tiles;
+  int n_columns;
+  int n_rows;
 };
 
 struct _GdkBroadwayCairoContextClass
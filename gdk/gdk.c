@@ -32,6 +32,7 @@
 #include "gdkresources.h"
 
 #include "gdk-private.h"
+#include "gdkprofilerprivate.h"
 
 #ifndef HAVE_XCONVERTCASE
 #include "gdkkeysyms.h"
@@ -150,7 +151,8 @@ static const GDebugKey gdk_debug_keys[] = {
   { "gl-legacy",       GDK_DEBUG_GL_LEGACY },
   { "gl-gles",         GDK_DEBUG_GL_GLES },
   { "vulkan-disable",  GDK_DEBUG_VULKAN_DISABLE },
-  { "vulkan-validate", GDK_DEBUG_VULKAN_VALIDATE }
+  { "vulkan-validate", GDK_DEBUG_VULKAN_VALIDATE },
+  { "fixed-frame-time", GDK_DEBUG_FIXED_FRAME_TIME }
 };
 #endif
 
@@ -220,6 +222,8 @@ gdk_pre_parse (void)
 #ifndef G_HAS_CONSTRUCTORS
   stash_desktop_startup_notification_id ();
 #endif
+
+  gdk_profiler_start ();
 }
 
 /*< private >
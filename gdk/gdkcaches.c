@@ -0,0 +1,384 @@
+/* GDK - The GIMP Drawing Kit
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "config.h"
+
+#include "gdkcachesprivate.h"
+
+#include <gio/gio.h>
+#include <stdlib.h>
+#include <string.h>
+
+/* A registry of the caches in GDK, GSK and GTK, so their memory use can
+ * be shown in one place, and so they can all be trimmed when the system
+ * runs low on memory.
+ *
+ * Every cache has a name, and all caches of the same kind, like the
+ * glyph caches of several renderers, share it. Budgets are per cache,
+ * not per name. Caches query their budget whenever they would grow
+ * and trim themselves; the registry never does that behind their back,
+ * except in low memory situations.
+ *
+ * GDK_CACHE_BUDGETS overrides the budgets, like
+ * GDK_CACHE_BUDGETS=glyphs=8M,icons=512K. A budget of 0 means none.
+ *
+ * Caches can be registered and query their budget from any thread, as
+ * the shadow cache does from the cairo renderer's tile workers. The
+ * registry lock is never held while calling into a cache, so caches
+ * may call these functions with their own locks held. Unregistering,
+ * trimming and getting the info only happen on the main thread, which
+ * is what keeps caches alive while they are called without the lock.
+ */
+
+struct _GdkCache
+{
+  char *name;
+  gsize default_budget;
+  GdkCacheSizeFunc size_func;
+  GdkCacheTrimFunc trim_func;
+  gpointer data;
+};
+
+G_LOCK_DEFINE_STATIC (caches);
+static GPtrArray *caches = NULL;
+/* name => budget, overriding the defaults */
+static GHashTable *budgets = NULL;
+
+static gboolean
+parse_size (const char *str,
+            gsize      *size)
+{
+  guint64 value;
+  char *end;
+
+  value = g_ascii_strtoull (str, &end, 10);
+  if (end == str)
+    return FALSE;
+
+  switch (*end)
+    {
+    case 'G': case 'g':
+      value *= 1024;
+      /* fallthrough */
+    case 'M': case 'm':
+      value *= 1024;
+      /* fallthrough */
+    case 'K': case 'k':
+      value *= 1024;
+      end++;
+      break;
+    default:
+      break;
+    }
+
+  if (*end != '\0')
+    return FALSE;
+
+  *size = value;
+  return TRUE;
+}
+
+static void
+parse_budgets (void)
+{
+  const char *env;
+  char **items;
+  int i;
+
+  budgets = g_hash_table_new_full (g_str_hash, g_str_equal, g_free, NULL);
+
+  env = g_getenv ("GDK_CACHE_BUDGETS");
+  if (env == NULL)
+    return;
+
+  items = g_strsplit (env, ",", -1);
+  for (i = 0; items[i]; i++)
+    {
+      char *eq = strchr (items[i], '=');
+      gsize budget;
+
+      if (eq == NULL || !parse_size (eq + 1, &budget))
+        {
+          g_warning ("Invalid cache budget \"%s\" in GDK_CACHE_BUDGETS", items[i]);
+          continue;
+        }
+
+      *eq = '\0';
+      g_hash_table_insert (budgets, g_strdup (items[i]), GSIZE_TO_POINTER (budget));
+    }
+  g_strfreev (items);
+}
+
+#if GLIB_CHECK_VERSION (2, 64, 0)
+static void
+low_memory_warning (GMemoryMonitor             *monitor,
+                    GMemoryMonitorWarningLevel  level,
+                    gpointer                    data)
+{
+  if (level >= G_MEMORY_MONITOR_WARNING_LEVEL_CRITICAL)
+    gdk_cache_trim_all (0.0);
+  else if (level >= G_MEMORY_MONITOR_WARNING_LEVEL_MEDIUM)
+    gdk_cache_trim_all (0.25);
+  else
+    gdk_cache_trim_all (0.5);
+}
+#endif
+
+static void
+gdk_caches_init (void)
+{
+  static gsize initialized = 0;
+
+  if (!g_once_init_enter (&initialized))
+    return;
+
+  caches = g_ptr_array_new ();
+  parse_budgets ();
+
+#if GLIB_CHECK_VERSION (2, 64, 0)
+  {
+    GMemoryMonitor *monitor = g_memory_monitor_dup_default ();
+
+    /* keep it around for the lifetime of the process */
+    g_signal_connect (monitor, "low-memory-warning",
+                      G_CALLBACK (low_memory_warning), NULL);
+  }
+#endif
+
+  g_once_init_leave (&initialized, 1);
+}
+
+/* Returns a copy of the list of caches, so they can be called
+ * without holding the lock */
+static GPtrArray *
+gdk_caches_copy (void)
+{
+  GPtrArray *copy;
+  guint i;
+
+  G_LOCK (caches);
+  copy = g_ptr_array_sized_new (caches->len);
+  for (i = 0; i < caches->len; i++)
+    g_ptr_array_add (copy, g_ptr_array_index (caches, i));
+  G_UNLOCK (caches);
+
+  return copy;
+}
+
+/*
+ * gdk_cache_register:
+ * @name: the name of the kind of cache
+ * @default_budget: the budget in bytes if none is configured, or 0
+ * @size_func: function returning the size of the cache
+ * @trim_func: (nullable): function to shrink the cache
+ * @data: data passed to @size_func and @trim_func
+ *
+ * Registers a cache, so its memory is accounted for and it can be
+ * trimmed when memory runs low. Caches without @trim_func are only
+ * accounted for.
+ *
+ * Returns: the cache, to be unregistered with gdk_cache_unregister()
+ */
+GdkCache *
+gdk_cache_register (const char       *name,
+                    gsize             default_budget,
+                    GdkCacheSizeFunc  size_func,
+                    GdkCacheTrimFunc  trim_func,
+                    gpointer          data)
+{
+  GdkCache *cache;
+
+  g_return_val_if_fail (name != NULL, NULL);
+  g_return_val_if_fail (size_func != NULL, NULL);
+
+  gdk_caches_init ();
+
+  cache = g_slice_new (GdkCache);
+  cache->name = g_strdup (name);
+  cache->default_budget = default_budget;
+  cache->size_func = size_func;
+  cache->trim_func = trim_func;
+  cache->data = data;
+
+  G_LOCK (caches);
+  g_ptr_array_add (caches, cache);
+  G_UNLOCK (caches);
+
+  return cache;
+}
+
+void
+gdk_cache_unregister (GdkCache *cache)
+{
+  if (cache == NULL)
+    return;
+
+  G_LOCK (caches);
+  g_ptr_array_remove (caches, cache);
+  G_UNLOCK (caches);
+
+  g_free (cache->name);
+  g_slice_free (GdkCache, cache);
+}
+
+/*
+ * gdk_cache_get_budget:
+ * @cache: a #GdkCache
+ *
+ * Returns: the number of bytes @cache should hold at most,
+ *     or 0 if it is unlimited
+ */
+gsize
+gdk_cache_get_budget (GdkCache *cache)
+{
+  gpointer budget;
+  gsize result;
+
+  G_LOCK (caches);
+  if (g_hash_table_lookup_extended (budgets, cache->name, NULL, &budget))
+    result = GPOINTER_TO_SIZE (budget);
+  else
+    result = cache->default_budget;
+  G_UNLOCK (caches);
+
+  return result;
+}
+
+/*
+ * gdk_cache_set_budget:
+ * @name: the name of the kind of cache
+ * @budget: the budget in bytes, or 0 for none
+ *
+ * Changes the budget of all caches of the kind @name, and trims
+ * them to it.
+ */
+void
+gdk_cache_set_budget (const char *name,
+                      gsize       budget)
+{
+  GPtrArray *copy;
+  guint i;
+
+  gdk_caches_init ();
+
+  G_LOCK (caches);
+  g_hash_table_insert (budgets, g_strdup (name), GSIZE_TO_POINTER (budget));
+  G_UNLOCK (caches);
+
+  if (budget == 0)
+    return;
+
+  copy = gdk_caches_copy ();
+  for (i = 0; i < copy->len; i++)
+    {
+      GdkCache *cache = g_ptr_array_index (copy, i);
+
+      if (cache->trim_func && strcmp (cache->name, name) == 0)
+        cache->trim_func (cache->data, budget);
+    }
+  g_ptr_array_unref (copy);
+}
+
+/*
+ * gdk_cache_trim_all:
+ * @fraction: how much of its current size each cache may keep
+ *
+ * Shrinks all caches, for when memory is low.
+ */
+void
+gdk_cache_trim_all (double fraction)
+{
+  GPtrArray *copy;
+  guint i;
+
+  gdk_caches_init ();
+
+  copy = gdk_caches_copy ();
+  for (i = 0; i < copy->len; i++)
+    {
+      GdkCache *cache = g_ptr_array_index (copy, i);
+      gsize cpu_bytes = 0, gpu_bytes = 0;
+
+      if (cache->trim_func == NULL)
+        continue;
+
+      cache->size_func (cache->data, &cpu_bytes, &gpu_bytes);
+      cache->trim_func (cache->data, (cpu_bytes + gpu_bytes) * fraction);
+    }
+  g_ptr_array_unref (copy);
+}
+
+static int
+compare_info (gconstpointer a,
+              gconstpointer b)
+{
+  return strcmp (((const GdkCacheInfo *) a)->name, ((const GdkCacheInfo *) b)->name);
+}
+
+/*
+ * gdk_cache_get_info:
+ *
+ * Returns: (transfer full) (element-type GdkCacheInfo): the sizes of
+ *     all registered caches, added up per kind and sorted by name. The
+ *     names are only valid until the next cache is unregistered.
+ */
+GArray *
+gdk_cache_get_info (void)
+{
+  GPtrArray *copy;
+  GArray *infos;
+  guint i, j;
+
+  gdk_caches_init ();
+
+  infos = g_array_new (FALSE, TRUE, sizeof (GdkCacheInfo));
+
+  copy = gdk_caches_copy ();
+  for (i = 0; i < copy->len; i++)
+    {
+      GdkCache *cache = g_ptr_array_index (copy, i);
+      GdkCacheInfo *info = NULL;
+      gsize cpu_bytes = 0, gpu_bytes = 0;
+
+      for (j = 0; j < infos->len; j++)
+        {
+          if (strcmp (g_array_index (infos, GdkCacheInfo, j).name, cache->name) == 0)
+            {
+              info = &g_array_index (infos, GdkCacheInfo, j);
+              break;
+            }
+        }
+
+      if (info == NULL)
+        {
+          g_array_set_size (infos, infos->len + 1);
+          info = &g_array_index (infos, GdkCacheInfo, infos->len - 1);
+          info->name = cache->name;
+          info->budget = gdk_cache_get_budget (cache);
+        }
+
+      cache->size_func (cache->data, &cpu_bytes, &gpu_bytes);
+      info->n_caches++;
+      info->cpu_bytes += cpu_bytes;
+      info->gpu_bytes += gpu_bytes;
+    }
+
+  g_ptr_array_unref (copy);
+
+  g_array_sort (infos, compare_info);
+
+  return infos;
+}
@@ -0,0 +1,58 @@
+/* GDK - The GIMP Drawing Kit
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef __GDK_CACHES_PRIVATE_H__
+#define __GDK_CACHES_PRIVATE_H__
+
+#include <glib.h>
+
+G_BEGIN_DECLS
+
+typedef struct _GdkCache GdkCache;
+
+/* Returns the bytes currently held in CPU and in GPU memory */
+typedef void (* GdkCacheSizeFunc) (gpointer  data,
+                                   gsize    *cpu_bytes,
+                                   gsize    *gpu_bytes);
+/* Frees as much as needed to get below @max_bytes, if possible */
+typedef void (* GdkCacheTrimFunc) (gpointer  data,
+                                   gsize     max_bytes);
+
+typedef struct {
+  const char *name;
+  guint       n_caches;
+  gsize       cpu_bytes;
+  gsize       gpu_bytes;
+  gsize       budget;     /* per cache, 0 for none */
+} GdkCacheInfo;
+
+GdkCache *      gdk_cache_register              (const char       *name,
+                                                 gsize             default_budget,
+                                                 GdkCacheSizeFunc  size_func,
+                                                 GdkCacheTrimFunc  trim_func,
+                                                 gpointer          data);
+void            gdk_cache_unregister            (GdkCache         *cache);
+
+gsize           gdk_cache_get_budget            (GdkCache         *cache);
+void            gdk_cache_set_budget            (const char       *name,
+                                                 gsize             budget);
+
+void            gdk_cache_trim_all              (double            fraction);
+GArray *        gdk_cache_get_info              (void);
+
+G_END_DECLS
+
+#endif /* __GDK_CACHES_PRIVATE_H__ */
@@ -70,6 +70,12 @@ struct _GdkClipboardPrivate
   GdkContentFormats *formats;
   GdkContentProvider *content;
 
+  /* Values read from the current contents, GType => GValue. Every claim
+   * bumps the serial and empties the cache, reads that were started
+   * before that are not added to it. */
+  GHashTable *value_cache;
+  guint serial;
+
   guint local : 1;
 };
 
@@ -92,6 +98,13 @@ static guint signals[N_SIGNALS] = { 0 };
 
 G_DEFINE_TYPE_WITH_PRIVATE (GdkClipboard, gdk_clipboard, G_TYPE_OBJECT)
 
+static void
+free_value (gpointer value)
+{
+  g_value_unset (value);
+  g_slice_free (GValue, value);
+}
+
 static void
 gdk_clipboard_set_property (GObject      *gobject,
                             guint         prop_id,
@@ -154,6 +167,7 @@ gdk_clipboard_finalize (GObject *object)
   GdkClipboardPrivate *priv = gdk_clipboard_get_instance_private (clipboard);
 
   g_clear_pointer (&priv->formats, gdk_content_formats_unref);
+  g_hash_table_unref (priv->value_cache);
 
   G_OBJECT_CLASS (gdk_clipboard_parent_class)->finalize (object);
 }
@@ -172,6 +186,9 @@ gdk_clipboard_real_claim (GdkClipboard       *clipboard,
 
   g_object_freeze_notify (G_OBJECT (clipboard));
 
+  priv->serial++;
+  g_hash_table_remove_all (priv->value_cache);
+
   gdk_content_formats_unref (priv->formats);
   gdk_content_formats_ref (formats);
   formats = gdk_content_formats_union_deserialize_gtypes (formats);
@@ -440,6 +457,7 @@ gdk_clipboard_init (GdkClipboard *clipboard)
   GdkClipboardPrivate *priv = gdk_clipboard_get_instance_private (clipboard);
 
   priv->formats = gdk_content_formats_new (NULL, 0);
+  priv->value_cache = g_hash_table_new_full (NULL, NULL, NULL, free_value);
   priv->local = TRUE;
 }
 
@@ -710,15 +728,31 @@ gdk_clipboard_read_value_done (GObject      *source,
                                gpointer      data)
 {
   GTask *task = data;
+  GdkClipboard *clipboard = g_task_get_source_object (task);
+  GdkClipboardPrivate *priv = gdk_clipboard_get_instance_private (clipboard);
   GError *error = NULL;
   GValue *value;
 
   value = g_task_get_task_data (task);
 
   if (!gdk_content_deserialize_finish (result, value, &error))
-    g_task_return_error (task, error);
+    {
+      g_task_return_error (task, error);
+    }
   else
-    g_task_return_pointer (task, value, NULL);
+    {
+      if (!priv->local &&
+          GPOINTER_TO_UINT (g_object_get_data (G_OBJECT (task), "gdk-clipboard-serial")) == priv->serial)
+        {
+          GValue *cached = g_slice_new0 (GValue);
+
+          g_value_init (cached, G_VALUE_TYPE (value));
+          g_value_copy (value, cached);
+          g_hash_table_insert (priv->value_cache, GSIZE_TO_POINTER (G_VALUE_TYPE (value)), cached);
+        }
+
+      g_task_return_pointer (task, value, NULL);
+    }
 
   g_object_unref (task);
 }
@@ -750,13 +784,6 @@ gdk_clipboard_read_value_got_stream (GObject      *source,
   g_object_unref (stream);
 }
 
-static void
-free_value (gpointer value)
-{
-  g_value_unset (value);
-  g_slice_free (GValue, value);
-}
-
 static void
 gdk_clipboard_read_value_internal (GdkClipboard        *clipboard,
                                    GType                type,
@@ -769,6 +796,7 @@ gdk_clipboard_read_value_internal (GdkClipboard        *clipboard,
   GdkClipboardPrivate *priv = gdk_clipboard_get_instance_private (clipboard);
   GdkContentFormatsBuilder *builder;
   GdkContentFormats *formats;
+  const GValue *cached;
   GValue *value;
   GTask *task;
  
@@ -779,6 +807,17 @@ gdk_clipboard_read_value_internal (GdkClipboard        *clipboard,
   g_value_init (value, type);
   g_task_set_task_data (task, value, free_value);
 
+  /* Repeated reads of unchanged contents, like the ones done for
+   * checking if pasting is possible, should not go to the owner */
+  cached = priv->local ? NULL : g_hash_table_lookup (priv->value_cache, GSIZE_TO_POINTER (type));
+  if (cached)
+    {
+      g_value_copy (cached, value);
+      g_task_return_pointer (task, value, NULL);
+      g_object_unref (task);
+      return;
+    }
+
   if (priv->local)
     {
       GError *error = NULL;
@@ -815,6 +854,8 @@ gdk_clipboard_read_value_internal (GdkClipboard        *clipboard,
   formats = gdk_content_formats_builder_free_to_formats (builder);
   formats = gdk_content_formats_union_deserialize_mime_types (formats);
 
+  g_object_set_data (G_OBJECT (task), "gdk-clipboard-serial", GUINT_TO_POINTER (priv->serial));
+
   gdk_clipboard_read_internal (clipboard,
                                formats,
                                io_priority,
@@ -843,6 +884,10 @@ gdk_clipboard_read_value_internal (GdkClipboard        *clipboard,
  * For local clipboard contents that are available in the given #GType, the
  * value will be copied directly. Otherwise, GDK will try to use
  * gdk_content_deserialize_async() to convert the clipboard's data.
+ *
+ * The converted values of remote contents are kept until the contents
+ * change, so reading the same @type again does not contact the
+ * application owning the clipboard again.
  **/
 void
 gdk_clipboard_read_value_async (GdkClipboard        *clipboard,
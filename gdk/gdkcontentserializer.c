@@ -585,6 +585,162 @@ gdk_content_serialize_finish (GAsyncResult  *result,
 
 /*** SERIALIZERS ***/
 
+/* Large payloads are not built in memory and written in one go.
+ * Instead, they are produced in chunks of this size, and the next
+ * chunk is only produced once the previous one has been written.
+ * That way memory stays bounded and a slow reader throttles us.
+ */
+#define CHUNK_SIZE (64 * 1024)
+
+/* Fills @chunk with the next piece of data. Returns %FALSE when
+ * there is nothing more to write after @chunk.
+ */
+typedef gboolean (* ChunkFunc) (gpointer  data,
+                                GString  *chunk);
+
+typedef struct _ChunkWriter ChunkWriter;
+
+struct _ChunkWriter
+{
+  GOutputStream *stream;
+  GString *chunk;
+  ChunkFunc next_chunk;
+  gpointer data;
+  GDestroyNotify notify;
+  gboolean more;
+};
+
+static void
+chunk_writer_free (gpointer data)
+{
+  ChunkWriter *writer = data;
+
+  g_object_unref (writer->stream);
+  g_string_free (writer->chunk, TRUE);
+  if (writer->notify)
+    writer->notify (writer->data);
+
+  g_slice_free (ChunkWriter, writer);
+}
+
+static void chunk_writer_write_next (GdkContentSerializer *serializer);
+
+static void
+chunk_writer_written (GObject      *source,
+                      GAsyncResult *result,
+                      gpointer      serializer)
+{
+  GOutputStream *stream = G_OUTPUT_STREAM (source);
+  ChunkWriter *writer;
+  GError *error = NULL;
+
+  if (!g_output_stream_write_all_finish (stream, result, NULL, &error))
+    {
+      gdk_content_serializer_return_error (serializer, error);
+      return;
+    }
+
+  writer = gdk_content_serializer_get_task_data (serializer);
+  if (writer->more)
+    chunk_writer_write_next (serializer);
+  else
+    gdk_content_serializer_return_success (serializer);
+}
+
+static void
+chunk_writer_write_next (GdkContentSerializer *serializer)
+{
+  ChunkWriter *writer = gdk_content_serializer_get_task_data (serializer);
+
+  g_string_truncate (writer->chunk, 0);
+  writer->more = writer->next_chunk (writer->data, writer->chunk);
+
+  g_output_stream_write_all_async (writer->stream,
+                                   writer->chunk->str,
+                                   writer->chunk->len,
+                                   gdk_content_serializer_get_priority (serializer),
+                                   gdk_content_serializer_get_cancellable (serializer),
+                                   chunk_writer_written,
+                                   serializer);
+}
+
+static void
+serializer_write_chunked (GdkContentSerializer *serializer,
+                          GOutputStream        *stream,
+                          ChunkFunc             next_chunk,
+                          gpointer              data,
+                          GDestroyNotify        notify)
+{
+  ChunkWriter *writer;
+
+  writer = g_slice_new0 (ChunkWriter);
+  writer->stream = g_object_ref (stream);
+  writer->chunk = g_string_sized_new (CHUNK_SIZE);
+  writer->next_chunk = next_chunk;
+  writer->data = data;
+  writer->notify = notify;
+
+  gdk_content_serializer_set_task_data (serializer, writer, chunk_writer_free);
+
+  chunk_writer_write_next (serializer);
+}
+
+typedef struct _PixbufData PixbufData;
+
+struct _PixbufData
+{
+  GdkPixbuf *pixbuf;
+  cairo_surface_t *surface;
+  GOutputStream *stream;
+  const char *name;
+};
+
+static void
+pixbuf_data_free (gpointer data)
+{
+  PixbufData *pd = data;
+
+  g_clear_object (&pd->pixbuf);
+  g_clear_pointer (&pd->surface, cairo_surface_destroy);
+  g_object_unref (pd->stream);
+
+  g_slice_free (PixbufData, pd);
+}
+
+/* Runs in a thread: the conversion from the texture's memory format
+ * and the encoding are the expensive parts, and the blocking writes
+ * let the reader pace the encoder instead of us buffering the image.
+ */
+static void
+pixbuf_serializer_thread (GTask        *task,
+                          gpointer      source_object,
+                          gpointer      task_data,
+                          GCancellable *cancellable)
+{
+  PixbufData *pd = task_data;
+  GError *error = NULL;
+
+  if (pd->pixbuf == NULL)
+    {
+      pd->pixbuf = gdk_pixbuf_get_from_surface (pd->surface,
+                                                0, 0,
+                                                cairo_image_surface_get_width (pd->surface),
+                                                cairo_image_surface_get_height (pd->surface));
+      g_clear_pointer (&pd->surface, cairo_surface_destroy);
+    }
+
+  if (!gdk_pixbuf_save_to_stream (pd->pixbuf,
+                                  pd->stream,
+                                  pd->name,
+                                  cancellable,
+                                  &error,
+                                  g_str_equal (pd->name, "png") ? "compression" : NULL, "2",
+                                  NULL))
+    g_task_return_error (task, error);
+  else
+    g_task_return_boolean (task, TRUE);
+}
+
 static void
 pixbuf_serializer_finish (GObject      *source,
                           GAsyncResult *res,
@@ -592,7 +748,7 @@ pixbuf_serializer_finish (GObject      *source,
 {
   GError *error = NULL;
 
-  if (!gdk_pixbuf_save_to_stream_finish (res, &error))
+  if (!g_task_propagate_boolean (G_TASK (res), &error))
     gdk_content_serializer_return_error (serializer, error);
   else
     gdk_content_serializer_return_success (serializer);
@@ -602,53 +758,68 @@ static void
 pixbuf_serializer (GdkContentSerializer *serializer)
 {
   const GValue *value;
-  GdkPixbuf *pixbuf;
-  const char *name;
-  
-  name = gdk_content_serializer_get_user_data (serializer);
+  PixbufData *pd;
+  GTask *task;
+
   value = gdk_content_serializer_get_value (serializer);
 
+  pd = g_slice_new0 (PixbufData);
+  pd->stream = g_object_ref (gdk_content_serializer_get_output_stream (serializer));
+  pd->name = gdk_content_serializer_get_user_data (serializer);
+
   if (G_VALUE_HOLDS (value, GDK_TYPE_PIXBUF))
     {
-      pixbuf = g_value_dup_object (value);
+      pd->pixbuf = g_value_dup_object (value);
     }
   else if (G_VALUE_HOLDS (value, GDK_TYPE_TEXTURE))
     {
-      GdkTexture *texture = g_value_get_object (value);
-      cairo_surface_t *surface = gdk_texture_download_surface (texture);
-      pixbuf = gdk_pixbuf_get_from_surface (surface,
-                                            0, 0,
-                                            gdk_texture_get_width (texture), gdk_texture_get_height (texture));
-      cairo_surface_destroy (surface);
+      /* Downloading may need the GL context, so it has to happen here */
+      pd->surface = gdk_texture_download_surface (g_value_get_object (value));
     }
   else
     {
       g_assert_not_reached ();
     }
 
-  gdk_pixbuf_save_to_stream_async (pixbuf,
-                                   gdk_content_serializer_get_output_stream (serializer),
-                                   name,
-				   gdk_content_serializer_get_cancellable (serializer),
-                                   pixbuf_serializer_finish,
-                                   serializer,
-                                   g_str_equal (name, "png") ? "compression" : NULL, "2",
-                                   NULL);
-  g_object_unref (pixbuf);
+  task = g_task_new (NULL,
+                     gdk_content_serializer_get_cancellable (serializer),
+                     pixbuf_serializer_finish,
+                     serializer);
+  g_task_set_priority (task, gdk_content_serializer_get_priority (serializer));
+  g_task_set_source_tag (task, pixbuf_serializer);
+  g_task_set_task_data (task, pd, pixbuf_data_free);
+  g_task_run_in_thread (task, pixbuf_serializer_thread);
+  g_object_unref (task);
 }
 
-static void
-string_serializer_finish (GObject      *source,
-                          GAsyncResult *result,
-                          gpointer      serializer)
+typedef struct _StringData StringData;
+
+struct _StringData
 {
-  GOutputStream *stream = G_OUTPUT_STREAM (source);
-  GError *error = NULL;
+  const char *text;
+  gsize len;
+};
 
-  if (!g_output_stream_write_all_finish (stream, result, NULL, &error))
-    gdk_content_serializer_return_error (serializer, error);
-  else
-    gdk_content_serializer_return_success (serializer);
+static gboolean
+string_next_chunk (gpointer  data,
+                   GString  *chunk)
+{
+  StringData *sd = data;
+  gsize n;
+
+  /* The converter stream keeps characters split between chunks */
+  n = MIN (sd->len, CHUNK_SIZE);
+  g_string_append_len (chunk, sd->text, n);
+  sd->text += n;
+  sd->len -= n;
+
+  return sd->len > 0;
+}
+
+static void
+string_data_free (gpointer data)
+{
+  g_slice_free (StringData, data);
 }
 
 static void
@@ -657,6 +828,7 @@ string_serializer (GdkContentSerializer *serializer)
   GOutputStream *filter;
   GCharsetConverter *converter;
   GError *error = NULL;
+  StringData *sd;
   const char *text;
 
   converter = g_charset_converter_new (gdk_content_serializer_get_user_data (serializer),
@@ -677,16 +849,80 @@ string_serializer (GdkContentSerializer *serializer)
   if (text == NULL)
     text = "";
 
-  g_output_stream_write_all_async (filter,
-                                   text,
-                                   strlen (text) + 1,
-                                   gdk_content_serializer_get_priority (serializer),
-                                   gdk_content_serializer_get_cancellable (serializer),
-                                   string_serializer_finish,
-                                   serializer);
+  /* The string is owned by the serializer's value, so it outlives us */
+  sd = g_slice_new (StringData);
+  sd->text = text;
+  sd->len = strlen (text) + 1;
+
+  serializer_write_chunked (serializer, filter, string_next_chunk, sd, string_data_free);
   g_object_unref (filter);
 }
 
+typedef struct _FileListData FileListData;
+
+struct _FileListData
+{
+  GSList *next; /* owned by the serializer's value */
+  gboolean as_text;
+};
+
+static gboolean
+file_list_next_chunk (gpointer  data,
+                      GString  *chunk)
+{
+  FileListData *fd = data;
+  char *str;
+
+  while (fd->next && chunk->len < CHUNK_SIZE)
+    {
+      GFile *file = fd->next->data;
+
+      if (fd->as_text)
+        {
+          str = g_file_get_path (file);
+          if (str == NULL)
+            str = g_file_get_uri (file);
+          g_string_append (chunk, str);
+          if (fd->next->next)
+            g_string_append (chunk, " ");
+        }
+      else
+        {
+          str = g_file_get_uri (file);
+          g_string_append (chunk, str);
+          g_string_append (chunk, "\r\n");
+        }
+      g_free (str);
+
+      fd->next = fd->next->next;
+    }
+
+  return fd->next != NULL;
+}
+
+static void
+file_list_data_free (gpointer data)
+{
+  g_slice_free (FileListData, data);
+}
+
+static void
+file_list_serializer (GdkContentSerializer *serializer,
+                      gboolean              as_text)
+{
+  FileListData *fd;
+
+  fd = g_slice_new (FileListData);
+  fd->next = g_value_get_boxed (gdk_content_serializer_get_value (serializer));
+  fd->as_text = as_text;
+
+  serializer_write_chunked (serializer,
+                            gdk_content_serializer_get_output_stream (serializer),
+                            file_list_next_chunk,
+                            fd,
+                            file_list_data_free);
+}
+
 static void
 file_serializer_finish (GObject      *source,
                         GAsyncResult *result,
@@ -709,9 +945,16 @@ file_uri_serializer (GdkContentSerializer *serializer)
   const GValue *value;
   char *uri;
 
-  str = g_string_new (NULL);
   value = gdk_content_serializer_get_value (serializer);
 
+  if (G_VALUE_HOLDS (value, GDK_TYPE_FILE_LIST))
+    {
+      file_list_serializer (serializer, FALSE);
+      return;
+    }
+
+  str = g_string_new (NULL);
+
   if (G_VALUE_HOLDS (value, G_TYPE_FILE))
     {
       file = g_value_get_object (gdk_content_serializer_get_value (serializer));
@@ -727,18 +970,6 @@ file_uri_serializer (GdkContentSerializer *serializer)
         }
       g_string_append (str, "\r\n");
     }
-  else if (G_VALUE_HOLDS (value, GDK_TYPE_FILE_LIST))
-    {
-      GSList *l;
-      
-      for (l = g_value_get_boxed (value); l; l = l->next)
-        {
-          uri = g_file_get_uri (l->data);
-          g_string_append (str, uri);
-          g_free (uri);
-          g_string_append (str, "\r\n");
-        }
-    }
 
   g_output_stream_write_all_async (gdk_content_serializer_get_output_stream (serializer),
                                    str->str,
@@ -758,6 +989,12 @@ file_text_serializer (GdkContentSerializer *serializer)
 
   value = gdk_content_serializer_get_value (serializer);
 
+  if (G_VALUE_HOLDS (value, GDK_TYPE_FILE_LIST))
+    {
+      file_list_serializer (serializer, TRUE);
+      return;
+    }
+
   if (G_VALUE_HOLDS (value, G_TYPE_FILE))
     {
       GFile *file;
@@ -770,25 +1007,6 @@ file_text_serializer (GdkContentSerializer *serializer)
             path = g_file_get_uri (file);
         }
     }
-  else if (G_VALUE_HOLDS (value, GDK_TYPE_FILE_LIST))
-    {
-      GString *str;
-      GSList *l;
-      
-      str = g_string_new (NULL);
-
-      for (l = g_value_get_boxed (value); l; l = l->next)
-        {
-          path = g_file_get_path (l->data);
-          if (path == NULL)
-            path = g_file_get_uri (l->data);
-          g_string_append (str, path);
-          g_free (path);
-          if (l->next)
-            g_string_append (str, " ");
-        }
-      path = g_string_free (str, FALSE);
-    }
 
   g_assert (path != NULL);
 
@@ -397,6 +397,10 @@ gdk_display_finalize (GObject *object)
 
   g_list_free_full (display->seats, g_object_unref);
 
+  if (display->gl_share_context)
+    g_object_remove_weak_pointer (G_OBJECT (display->gl_share_context),
+                                  (gpointer *) &display->gl_share_context);
+
   G_OBJECT_CLASS (gdk_display_parent_class)->finalize (object);
 }
 
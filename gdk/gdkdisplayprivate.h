@@ -108,6 +108,10 @@ struct _GdkDisplay
   GdkDebugFlags debug_flags;
 
   GList *seats;
+
+  /* A GL paint context that new paint contexts share their GL objects
+   * with, so renderers of different surfaces can share textures */
+  GdkGLContext *gl_share_context;
 };
 
 struct _GdkDisplayClass
@@ -338,87 +338,89 @@ static void
 gdk_event_push_history (GdkEvent       *event,
                         const GdkEvent *history_event)
 {
-  GdkTimeCoord *hist;
+  GdkTimeCoord hist = { 0, };
+  GArray *older;
   GdkDevice *device;
   gint i, n_axes;
 
   g_assert (event->any.type == GDK_MOTION_NOTIFY);
   g_assert (history_event->any.type == GDK_MOTION_NOTIFY);
 
-  hist = g_new0 (GdkTimeCoord, 1);
-
   device = gdk_event_get_device (history_event);
   n_axes = gdk_device_get_n_axes (device);
 
+  hist.time = history_event->motion.time;
   for (i = 0; i <= MIN (n_axes, GDK_MAX_TIMECOORD_AXES); i++)
-    gdk_event_get_axis (history_event, i, &hist->axes[i]);
+    gdk_event_get_axis (history_event, i, &hist.axes[i]);
+
+  if (event->motion.history == NULL)
+    event->motion.history = g_array_new (FALSE, FALSE, sizeof (GdkTimeCoord));
 
-  event->motion.history = g_list_prepend (event->motion.history, hist);
+  /* @history_event is older than @event, so it and its own history
+   * go in front of what @event has accumulated so far.
+   */
+  older = history_event->motion.history;
+  if (older && older->len > 0)
+    {
+      g_array_insert_vals (event->motion.history, 0, older->data, older->len);
+      g_array_insert_vals (event->motion.history, older->len, &hist, 1);
+    }
+  else
+    g_array_prepend_val (event->motion.history, hist);
 }
 
-void
-_gdk_event_queue_handle_motion_compression (GdkDisplay *display)
+static gboolean
+gdk_event_is_compressible_motion (GdkEvent *event,
+                                  GdkEvent *last_motion)
 {
-  GList *tmp_list;
-  GList *pending_motions = NULL;
-  GdkSurface *pending_motion_surface = NULL;
-  GdkDevice *pending_motion_device = NULL;
-  GdkEvent *last_motion = NULL;
-
-  /* If the last N events in the event queue are motion notify
-   * events for the same surface, drop all but the last */
-
-  tmp_list = display->queued_tail;
-
-  while (tmp_list)
-    {
-      GdkEvent *event = tmp_list->data;
+  if (event->any.flags & GDK_EVENT_PENDING)
+    return FALSE;
 
-      if (event->any.flags & GDK_EVENT_PENDING)
-        break;
+  if (event->any.type != GDK_MOTION_NOTIFY)
+    return FALSE;
 
-      if (event->any.type != GDK_MOTION_NOTIFY)
-        break;
+  return event->any.surface == last_motion->any.surface &&
+         event->any.device == last_motion->any.device;
+}
 
-      if (pending_motion_surface != NULL &&
-          pending_motion_surface != event->any.surface)
-        break;
+void
+_gdk_event_queue_handle_motion_compression (GdkDisplay *display)
+{
+  GList *tail;
+  GdkEvent *last_motion;
 
-      if (pending_motion_device != NULL &&
-          pending_motion_device != event->any.device)
-        break;
+  /* This is called every time an event is completed, so motions are
+   * merged into their successor as soon as it arrives and the queue
+   * holds at most one motion per surface and device at its tail.
+   * Only the events right before the tail need to be looked at.
+   */
+  tail = display->queued_tail;
+  if (tail == NULL)
+    return;
 
-      if (!last_motion)
-        last_motion = event;
+  last_motion = tail->data;
+  if (!gdk_event_is_compressible_motion (last_motion, last_motion))
+    return;
 
-      pending_motion_surface = event->any.surface;
-      pending_motion_device = event->any.device;
-      pending_motions = tmp_list;
+  while (tail->prev &&
+         gdk_event_is_compressible_motion (tail->prev->data, last_motion))
+    {
+      GList *prev = tail->prev;
+      GdkEvent *event = prev->data;
 
-      tmp_list = tmp_list->prev;
-    }
+      if (last_motion->motion.state &
+          (GDK_BUTTON1_MASK | GDK_BUTTON2_MASK | GDK_BUTTON3_MASK |
+           GDK_BUTTON4_MASK | GDK_BUTTON5_MASK))
+        gdk_event_push_history (last_motion, event);
 
-  while (pending_motions && pending_motions->next != NULL)
-    {
-      GList *next = pending_motions->next;
-
-      if (last_motion &&
-          (last_motion->motion.state &
-           (GDK_BUTTON1_MASK | GDK_BUTTON2_MASK | GDK_BUTTON3_MASK |
-            GDK_BUTTON4_MASK | GDK_BUTTON5_MASK)))
-        gdk_event_push_history (last_motion, pending_motions->data);
-
-      g_object_unref (pending_motions->data);
-      display->queued_events = g_list_delete_link (display->queued_events,
-                                                   pending_motions);
-      pending_motions = next;
+      _gdk_event_queue_remove_link (display, prev);
+      g_list_free_1 (prev);
+      g_object_unref (event);
     }
 
-  if (pending_motions &&
-      pending_motions == display->queued_events &&
-      pending_motions == display->queued_tail)
+  if (tail == display->queued_events)
     {
-      GdkFrameClock *clock = gdk_surface_get_frame_clock (pending_motion_surface);
+      GdkFrameClock *clock = gdk_surface_get_frame_clock (last_motion->any.surface);
       if (clock) /* might be NULL if surface was destroyed */
 	gdk_frame_clock_request_phase (clock, GDK_FRAME_CLOCK_PHASE_FLUSH_EVENTS);
     }
@@ -580,12 +582,6 @@ gdk_event_get_pointer_emulated (GdkEvent *event)
   return (event->any.flags & GDK_EVENT_POINTER_EMULATED) != 0;
 }
 
-static GdkTimeCoord *
-copy_time_coord (const GdkTimeCoord *coord)
-{
-  return g_memdup (coord, sizeof (GdkTimeCoord));
-}
-
 /**
  * gdk_event_copy:
  * @event: a #GdkEvent
@@ -659,8 +655,11 @@ gdk_event_copy (const GdkEvent *event)
 
       if (event->motion.history)
         {
-          new_event->motion.history = g_list_copy_deep (event->motion.history,
-                                                        (GCopyFunc) copy_time_coord, NULL);
+          new_event->motion.history = g_array_sized_new (FALSE, FALSE, sizeof (GdkTimeCoord),
+                                                         event->motion.history->len);
+          g_array_append_vals (new_event->motion.history,
+                               event->motion.history->data,
+                               event->motion.history->len);
         }
       break;
 
@@ -709,7 +708,8 @@ gdk_event_finalize (GObject *object)
     case GDK_MOTION_NOTIFY:
       g_clear_object (&event->motion.tool);
       g_free (event->motion.axes);
-      g_list_free_full (event->motion.history, g_free);
+      if (event->motion.history)
+        g_array_unref (event->motion.history);
       break;
 
     default:
@@ -2434,7 +2434,16 @@ gdk_event_get_axes (GdkEvent  *event,
 GList *
 gdk_event_get_motion_history (const GdkEvent *event)
 {
-  if (event->any.type != GDK_MOTION_NOTIFY)
+  GList *history = NULL;
+  guint i;
+
+  if (event->any.type != GDK_MOTION_NOTIFY ||
+      event->motion.history == NULL)
     return NULL;
-  return g_list_reverse (g_list_copy (event->motion.history));
+
+  for (i = event->motion.history->len; i > 0; i--)
+    history = g_list_prepend (history,
+                              &g_array_index (event->motion.history, GdkTimeCoord, i - 1));
+
+  return history;
 }
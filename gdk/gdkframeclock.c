@@ -95,6 +95,8 @@ struct _GdkFrameClockPrivate
   gint n_timings;
   gint current;
   GdkFrameTimings *timings[FRAME_HISTORY_MAX_LENGTH];
+
+  GdkFramePacing pacing;
 };
 
 G_DEFINE_ABSTRACT_TYPE_WITH_PRIVATE (GdkFrameClock, gdk_frame_clock, G_TYPE_OBJECT)
@@ -524,6 +526,11 @@ _gdk_frame_clock_debug_print_timings (GdkFrameClock   *clock,
     g_string_append_printf (str, " predicted=%-4.1f", (timings->predicted_presentation_time - timings->frame_time) / 1000.);
   if (timings->refresh_interval != 0)
     g_string_append_printf (str, " refresh_interval=%-4.1f", timings->refresh_interval / 1000.);
+  g_string_append_printf (str, " events=%-4.1f update=%-4.1f layout=%-4.1f paint=%-4.1f",
+                          timings->events_duration / 1000.,
+                          timings->update_duration / 1000.,
+                          timings->layout_duration / 1000.,
+                          timings->paint_duration / 1000.);
 
   g_message ("%s", str->str);
   g_string_free (str, TRUE);
@@ -604,6 +611,44 @@ gdk_frame_clock_get_refresh_info (GdkFrameClock *frame_clock,
     }
 }
 
+/**
+ * gdk_frame_clock_set_pacing:
+ * @frame_clock: a #GdkFrameClock
+ * @pacing: the new pacing mode
+ *
+ * Sets when @frame_clock starts producing frames, relative to the
+ * time they are predicted to be presented.
+ *
+ * Applications that draw in direct response to input, such as
+ * drawing programs, can use %GDK_FRAME_PACING_LOW_LATENCY to
+ * reduce the delay between the input and its result appearing
+ * on screen.
+ */
+void
+gdk_frame_clock_set_pacing (GdkFrameClock  *frame_clock,
+                            GdkFramePacing  pacing)
+{
+  g_return_if_fail (GDK_IS_FRAME_CLOCK (frame_clock));
+
+  frame_clock->priv->pacing = pacing;
+}
+
+/**
+ * gdk_frame_clock_get_pacing:
+ * @frame_clock: a #GdkFrameClock
+ *
+ * Gets the pacing mode set with gdk_frame_clock_set_pacing().
+ *
+ * Returns: the pacing mode of @frame_clock
+ */
+GdkFramePacing
+gdk_frame_clock_get_pacing (GdkFrameClock *frame_clock)
+{
+  g_return_val_if_fail (GDK_IS_FRAME_CLOCK (frame_clock), GDK_FRAME_PACING_DEFAULT);
+
+  return frame_clock->priv->pacing;
+}
+
 void
 _gdk_frame_clock_emit_flush_events (GdkFrameClock *frame_clock)
 {
@@ -70,6 +70,25 @@ typedef enum {
   GDK_FRAME_CLOCK_PHASE_AFTER_PAINT   = 1 << 6
 } GdkFrameClockPhase;
 
+/**
+ * GdkFramePacing:
+ * @GDK_FRAME_PACING_DEFAULT: start each frame about half a refresh
+ *     interval before the vblank it targets. This leaves the most room
+ *     for slow frames.
+ * @GDK_FRAME_PACING_LOW_LATENCY: start each frame as late as possible
+ *     before the vblank it targets, based on how long recent frames
+ *     took. This minimizes the time between handling input and
+ *     presenting the result, at the risk of missing a vblank when a
+ *     frame is much slower than the previous ones.
+ *
+ * #GdkFramePacing determines when a #GdkFrameClock starts producing
+ * a frame, relative to the predicted presentation time.
+ */
+typedef enum {
+  GDK_FRAME_PACING_DEFAULT,
+  GDK_FRAME_PACING_LOW_LATENCY
+} GdkFramePacing;
+
 GDK_AVAILABLE_IN_ALL
 GType    gdk_frame_clock_get_type             (void) G_GNUC_CONST;
 
@@ -103,6 +122,12 @@ void gdk_frame_clock_get_refresh_info (GdkFrameClock *frame_clock,
                                        gint64        *refresh_interval_return,
                                        gint64        *presentation_time_return);
 
+GDK_AVAILABLE_IN_ALL
+void             gdk_frame_clock_set_pacing (GdkFrameClock  *frame_clock,
+                                             GdkFramePacing  pacing);
+GDK_AVAILABLE_IN_ALL
+GdkFramePacing   gdk_frame_clock_get_pacing (GdkFrameClock  *frame_clock);
+
 G_END_DECLS
 
 #endif /* __GDK_FRAME_CLOCK_H__ */
@@ -28,6 +28,7 @@
 
 #include "gdkinternals.h"
 #include "gdkframeclockprivate.h"
+#include "gdkprofilerprivate.h"
 #include "gdk.h"
 
 #ifdef G_OS_WIN32
@@ -36,6 +37,18 @@
 
 #define FRAME_INTERVAL 16667 /* microseconds */
 
+/* Low latency pacing: how many frames to look back to estimate
+ * the cost of the next frame, and how much slack to leave for
+ * the compositor and main loop dispatch.
+ */
+#define FRAME_COST_HISTORY 4
+#define FRAME_PACING_MARGIN 2000 /* microseconds */
+
+/* Frame interval while the surface can't be seen. Animations keep
+ * progressing, but without burning CPU on frames nobody sees.
+ */
+#define THROTTLED_FRAME_INTERVAL 1000000 /* microseconds */
+
 struct _GdkFrameClockIdlePrivate
 {
   GTimer *timer;
@@ -44,6 +57,7 @@ struct _GdkFrameClockIdlePrivate
   gint64 frame_time;
   gint64 min_next_frame_time;
   gint64 sleep_serial;
+  gint64 events_duration;
 
   guint flush_idle_id;
   guint paint_idle_id;
@@ -54,6 +68,7 @@ struct _GdkFrameClockIdlePrivate
   GdkFrameClockPhase phase;
 
   guint in_paint_idle : 1;
+  guint throttled : 1;
 #ifdef G_OS_WIN32
   guint begin_period : 1;
 #endif
@@ -192,6 +207,10 @@ gdk_frame_clock_idle_get_frame_time (GdkFrameClock *clock)
       priv->phase != GDK_FRAME_CLOCK_PHASE_FLUSH_EVENTS)
     return priv->frame_time;
 
+  /* Frame time only moves with frames, see gdk_frame_clock_paint_idle() */
+  if (GDK_DEBUG_CHECK (FIXED_FRAME_TIME))
+    return priv->frame_time;
+
   /* Outside a paint, pick something close to "now" */
   computed_frame_time = compute_frame_time (GDK_FRAME_CLOCK_IDLE (clock));
 
@@ -277,6 +296,36 @@ maybe_stop_idle (GdkFrameClockIdle *clock_idle)
     }
 }
 
+/* Estimates how long the next frame will take to produce,
+ * from the slowest of the last few frames.
+ */
+static gint64
+estimate_frame_cost (GdkFrameClockIdle *clock_idle)
+{
+  GdkFrameClock *clock = GDK_FRAME_CLOCK (clock_idle);
+  gint64 frame_counter;
+  gint64 cost;
+  int i;
+
+  frame_counter = gdk_frame_clock_get_frame_counter (clock);
+  cost = 0;
+
+  for (i = 0; i < FRAME_COST_HISTORY; i++)
+    {
+      GdkFrameTimings *timings = gdk_frame_clock_get_timings (clock, frame_counter - i);
+
+      if (timings == NULL)
+        break;
+
+      cost = MAX (cost, timings->events_duration +
+                        timings->update_duration +
+                        timings->layout_duration +
+                        timings->paint_duration);
+    }
+
+  return cost;
+}
+
 static gint64
 compute_min_next_frame_time (GdkFrameClockIdle *clock_idle,
                              gint64             last_frame_time)
@@ -288,10 +337,27 @@ compute_min_next_frame_time (GdkFrameClockIdle *clock_idle,
                                     last_frame_time,
                                     &refresh_interval, &presentation_time);
 
+  if (clock_idle->priv->throttled)
+    return last_frame_time + THROTTLED_FRAME_INTERVAL;
+
   if (presentation_time == 0)
     return last_frame_time + refresh_interval;
-  else
-    return presentation_time + refresh_interval / 2;
+
+  if (gdk_frame_clock_get_pacing (GDK_FRAME_CLOCK (clock_idle)) == GDK_FRAME_PACING_LOW_LATENCY)
+    {
+      gint64 frame_cost;
+
+      /* The next frame targets the vblank after presentation_time.
+       * Start it as late as we can while still making that vblank,
+       * so that the events it handles are as fresh as possible.
+       */
+      frame_cost = estimate_frame_cost (clock_idle) + FRAME_PACING_MARGIN;
+
+      return MAX (presentation_time,
+                  presentation_time + refresh_interval - frame_cost);
+    }
+
+  return presentation_time + refresh_interval / 2;
 }
 
 static gboolean
@@ -300,6 +366,7 @@ gdk_frame_clock_flush_idle (void *data)
   GdkFrameClock *clock = GDK_FRAME_CLOCK (data);
   GdkFrameClockIdle *clock_idle = GDK_FRAME_CLOCK_IDLE (clock);
   GdkFrameClockIdlePrivate *priv = clock_idle->priv;
+  gint64 start_time;
 
   priv->flush_idle_id = 0;
 
@@ -309,13 +376,24 @@ gdk_frame_clock_flush_idle (void *data)
   priv->phase = GDK_FRAME_CLOCK_PHASE_FLUSH_EVENTS;
   priv->requested &= ~GDK_FRAME_CLOCK_PHASE_FLUSH_EVENTS;
 
+  start_time = g_get_monotonic_time ();
   _gdk_frame_clock_emit_flush_events (clock);
+  gdk_profiler_end_mark (start_time * 1000, "events", NULL);
 
+  /* The frame hasn't begun yet, so keep the duration
+   * until the paint idle has timings to put it in.
+   */
   if ((priv->requested & ~GDK_FRAME_CLOCK_PHASE_FLUSH_EVENTS) != 0 ||
       priv->updating_count > 0)
-    priv->phase = GDK_FRAME_CLOCK_PHASE_BEFORE_PAINT;
+    {
+      priv->events_duration += g_get_monotonic_time () - start_time;
+      priv->phase = GDK_FRAME_CLOCK_PHASE_BEFORE_PAINT;
+    }
   else
-    priv->phase = GDK_FRAME_CLOCK_PHASE_NONE;
+    {
+      priv->events_duration = 0;
+      priv->phase = GDK_FRAME_CLOCK_PHASE_NONE;
+    }
 
   return FALSE;
 }
@@ -328,6 +406,7 @@ gdk_frame_clock_paint_idle (void *data)
   GdkFrameClockIdlePrivate *priv = clock_idle->priv;
   gboolean skip_to_resume_events;
   GdkFrameTimings *timings = NULL;
+  gint64 start_time;
 
   priv->paint_idle_id = 0;
   priv->in_paint_idle = TRUE;
@@ -376,7 +455,11 @@ gdk_frame_clock_paint_idle (void *data)
               smoothest_frame_time = priv->frame_time + frame_interval;
               reset_frame_time = compute_frame_time (clock_idle);
               frame_time_error = ABS (reset_frame_time - smoothest_frame_time);
-              if (frame_time_error >= frame_interval)
+              /* For benchmarks, animations must not depend on how long
+               * frames actually took */
+              if (GDK_DEBUG_CHECK (FIXED_FRAME_TIME))
+                priv->frame_time = priv->frame_time + FRAME_INTERVAL;
+              else if (frame_time_error >= frame_interval)
                 priv->frame_time = reset_frame_time;
               else
                 priv->frame_time = smoothest_frame_time;
@@ -387,6 +470,8 @@ gdk_frame_clock_paint_idle (void *data)
 
               timings->frame_time = priv->frame_time;
               timings->slept_before = priv->sleep_serial != get_sleep_serial ();
+              timings->events_duration = priv->events_duration;
+              priv->events_duration = 0;
 
               priv->phase = GDK_FRAME_CLOCK_PHASE_BEFORE_PAINT;
 
@@ -407,7 +492,10 @@ gdk_frame_clock_paint_idle (void *data)
                   priv->updating_count > 0)
                 {
                   priv->requested &= ~GDK_FRAME_CLOCK_PHASE_UPDATE;
+                  start_time = g_get_monotonic_time ();
                   _gdk_frame_clock_emit_update (clock);
+                  timings->update_duration += g_get_monotonic_time () - start_time;
+                  gdk_profiler_end_mark (start_time * 1000, "update", NULL);
                 }
             }
           /* fallthrough */
@@ -431,12 +519,18 @@ gdk_frame_clock_paint_idle (void *data)
 	       * resizes and natural size changes.
 	       */
 	      iter = 0;
+              start_time = g_get_monotonic_time ();
               while ((priv->requested & GDK_FRAME_CLOCK_PHASE_LAYOUT) &&
 		     priv->freeze_count == 0 && iter++ < 4)
                 {
                   priv->requested &= ~GDK_FRAME_CLOCK_PHASE_LAYOUT;
                   _gdk_frame_clock_emit_layout (clock);
                 }
+              if (iter > 0)
+                {
+                  timings->layout_duration += g_get_monotonic_time () - start_time;
+                  gdk_profiler_end_mark (start_time * 1000, "layout", NULL);
+                }
 	      if (iter == 5)
 		g_warning ("gdk-frame-clock: layout continuously requested, giving up after 4 tries");
             }
@@ -457,7 +551,10 @@ gdk_frame_clock_paint_idle (void *data)
               if (priv->requested & GDK_FRAME_CLOCK_PHASE_PAINT)
                 {
                   priv->requested &= ~GDK_FRAME_CLOCK_PHASE_PAINT;
+                  start_time = g_get_monotonic_time ();
                   _gdk_frame_clock_emit_paint (clock);
+                  timings->paint_duration += g_get_monotonic_time () - start_time;
+                  gdk_profiler_end_mark (start_time * 1000, "paint", NULL);
                 }
             }
           /* fallthrough */
@@ -617,6 +714,43 @@ gdk_frame_clock_idle_class_init (GdkFrameClockIdleClass *klass)
   frame_clock_class->thaw = gdk_frame_clock_idle_thaw;
 }
 
+/* Throttles the clock while its surface is hidden. When the surface
+ * becomes visible again, pending frames are started right away rather
+ * than waiting for the throttled frame interval to pass.
+ */
+void
+_gdk_frame_clock_idle_set_throttled (GdkFrameClockIdle *clock_idle,
+                                     gboolean           throttled)
+{
+  GdkFrameClockIdlePrivate *priv = clock_idle->priv;
+
+  throttled = !!throttled;
+
+  if (priv->throttled == throttled)
+    return;
+
+  priv->throttled = throttled;
+
+  if (!throttled)
+    {
+      priv->min_next_frame_time = 0;
+
+      if (priv->flush_idle_id != 0)
+        {
+          g_source_remove (priv->flush_idle_id);
+          priv->flush_idle_id = 0;
+        }
+
+      if (priv->paint_idle_id != 0)
+        {
+          g_source_remove (priv->paint_idle_id);
+          priv->paint_idle_id = 0;
+        }
+
+      maybe_start_idle (clock_idle);
+    }
+}
+
 GdkFrameClock *
 _gdk_frame_clock_idle_new (void)
 {
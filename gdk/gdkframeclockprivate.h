@@ -94,6 +94,14 @@ struct _GdkFrameTimings
   gint64 refresh_interval;
   gint64 predicted_presentation_time;
 
+  /* time spent in each phase, in microseconds */
+  gint64 events_duration;
+  gint64 update_duration;
+  gint64 layout_duration;
+  gint64 paint_duration;
+  /* part of the layout phase spent on validating styles, set by GTK */
+  gint64 style_duration;
+
 #ifdef G_ENABLE_DEBUG
   gint64 layout_start_time;
   gint64 paint_start_time;
@@ -233,3 +233,71 @@ gdk_frame_timings_get_refresh_interval (GdkFrameTimings *timings)
 
   return timings->refresh_interval;
 }
+
+/**
+ * gdk_frame_timings_get_events_duration:
+ * @timings: a #GdkFrameTimings
+ *
+ * Gets the time spent flushing events for this frame, in the
+ * #GdkFrameClock::flush-events phase.
+ *
+ * Returns: the duration in microseconds
+ */
+gint64
+gdk_frame_timings_get_events_duration (GdkFrameTimings *timings)
+{
+  g_return_val_if_fail (timings != NULL, 0);
+
+  return timings->events_duration;
+}
+
+/**
+ * gdk_frame_timings_get_update_duration:
+ * @timings: a #GdkFrameTimings
+ *
+ * Gets the time spent in the #GdkFrameClock::update phase
+ * of this frame.
+ *
+ * Returns: the duration in microseconds
+ */
+gint64
+gdk_frame_timings_get_update_duration (GdkFrameTimings *timings)
+{
+  g_return_val_if_fail (timings != NULL, 0);
+
+  return timings->update_duration;
+}
+
+/**
+ * gdk_frame_timings_get_layout_duration:
+ * @timings: a #GdkFrameTimings
+ *
+ * Gets the time spent in the #GdkFrameClock::layout phase
+ * of this frame.
+ *
+ * Returns: the duration in microseconds
+ */
+gint64
+gdk_frame_timings_get_layout_duration (GdkFrameTimings *timings)
+{
+  g_return_val_if_fail (timings != NULL, 0);
+
+  return timings->layout_duration;
+}
+
+/**
+ * gdk_frame_timings_get_paint_duration:
+ * @timings: a #GdkFrameTimings
+ *
+ * Gets the time spent in the #GdkFrameClock::paint phase
+ * of this frame.
+ *
+ * Returns: the duration in microseconds
+ */
+gint64
+gdk_frame_timings_get_paint_duration (GdkFrameTimings *timings)
+{
+  g_return_val_if_fail (timings != NULL, 0);
+
+  return timings->paint_duration;
+}
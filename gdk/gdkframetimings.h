@@ -51,6 +51,15 @@ gint64           gdk_frame_timings_get_refresh_interval  (GdkFrameTimings *timin
 GDK_AVAILABLE_IN_ALL
 gint64           gdk_frame_timings_get_predicted_presentation_time (GdkFrameTimings *timings);
 
+GDK_AVAILABLE_IN_ALL
+gint64           gdk_frame_timings_get_events_duration   (GdkFrameTimings *timings);
+GDK_AVAILABLE_IN_ALL
+gint64           gdk_frame_timings_get_update_duration   (GdkFrameTimings *timings);
+GDK_AVAILABLE_IN_ALL
+gint64           gdk_frame_timings_get_layout_duration   (GdkFrameTimings *timings);
+GDK_AVAILABLE_IN_ALL
+gint64           gdk_frame_timings_get_paint_duration    (GdkFrameTimings *timings);
+
 G_END_DECLS
 
 #endif /* __GDK_FRAME_TIMINGS_H__ */
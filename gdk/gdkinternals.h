@@ -64,7 +64,8 @@ typedef enum {
   GDK_DEBUG_GL_LEGACY       = 1 << 15,
   GDK_DEBUG_GL_GLES         = 1 << 16,
   GDK_DEBUG_VULKAN_DISABLE  = 1 << 17,
-  GDK_DEBUG_VULKAN_VALIDATE = 1 << 18
+  GDK_DEBUG_VULKAN_VALIDATE = 1 << 18,
+  GDK_DEBUG_FIXED_FRAME_TIME = 1 << 19
 } GdkDebugFlags;
 
 extern guint _gdk_debug_flags;
@@ -184,6 +185,7 @@ struct _GdkSurface
   guint viewable : 1; /* mapped and all parents mapped */
   guint in_update : 1;
   guint frame_clock_events_paused : 1;
+  guint occluded : 1; /* fully covered by other windows */
 
   /* The GdkSurface that has the impl, ref:ed if another surface.
    * This ref is required to keep the wrapper of the impl surface alive
@@ -286,6 +288,8 @@ void       _gdk_surface_destroy           (GdkSurface      *surface,
 void       _gdk_surface_clear_update_area (GdkSurface      *surface);
 void       _gdk_surface_update_size       (GdkSurface      *surface);
 gboolean   _gdk_surface_update_viewable   (GdkSurface      *surface);
+void       _gdk_surface_set_occluded      (GdkSurface      *surface,
+                                           gboolean         occluded);
 GdkGLContext * gdk_surface_get_paint_gl_context (GdkSurface *surface,
                                                  GError   **error);
 void gdk_surface_get_unscaled_size (GdkSurface *surface,
@@ -55,6 +55,10 @@ gdk_memory_format_bytes_per_pixel (GdkMemoryFormat format)
     case GDK_MEMORY_B8G8R8:
       return 3;
 
+    case GDK_MEMORY_R16G16B16A16_PREMULTIPLIED:
+    case GDK_MEMORY_R16G16B16A16_FLOAT_PREMULTIPLIED:
+      return 8;
+
     case GDK_MEMORY_N_FORMATS:
     default:
       g_assert_not_reached ();
@@ -90,6 +94,37 @@ gdk_memory_texture_download (GdkTexture         *texture,
                       area->width, area->height);
 }
 
+static const cairo_user_data_key_t bytes_key;
+
+static cairo_surface_t *
+gdk_memory_texture_download_surface (GdkTexture *texture)
+{
+  GdkMemoryTexture *self = GDK_MEMORY_TEXTURE (texture);
+  const guchar *data;
+  cairo_surface_t *surface;
+
+  data = g_bytes_get_data (self->bytes, NULL);
+
+  /* Data that is already laid out the way Cairo wants it can be
+   * wrapped instead of copied. The surfaces handed out by
+   * gdk_texture_download_surface() are only ever read from.
+   */
+  if (self->format != GDK_MEMORY_CAIRO_FORMAT_ARGB32 ||
+      self->stride % 4 != 0 ||
+      GPOINTER_TO_SIZE (data) % 4 != 0)
+    return GDK_TEXTURE_CLASS (gdk_memory_texture_parent_class)->download_surface (texture);
+
+  surface = cairo_image_surface_create_for_data ((guchar *) data,
+                                                 CAIRO_FORMAT_ARGB32,
+                                                 texture->width, texture->height,
+                                                 self->stride);
+  cairo_surface_set_user_data (surface, &bytes_key,
+                               g_bytes_ref (self->bytes),
+                               (cairo_destroy_func_t) g_bytes_unref);
+
+  return surface;
+}
+
 static void
 gdk_memory_texture_class_init (GdkMemoryTextureClass *klass)
 {
@@ -97,6 +132,7 @@ gdk_memory_texture_class_init (GdkMemoryTextureClass *klass)
   GObjectClass *gobject_class = G_OBJECT_CLASS (klass);
 
   texture_class->download = gdk_memory_texture_download;
+  texture_class->download_surface = gdk_memory_texture_download_surface;
   gobject_class->dispose = gdk_memory_texture_dispose;
 }
 
@@ -117,6 +153,12 @@ gdk_memory_texture_init (GdkMemoryTexture *self)
  * The #GBytes must contain @stride x @height pixels
  * in the given format.
  *
+ * The data is not copied, so memory owned by someone else, like
+ * a mmap()ed or shared memory buffer, can be wrapped with
+ * g_bytes_new_with_free_func(). It must not be modified while
+ * the texture exists. Data in the %GDK_MEMORY_DEFAULT format is
+ * also not copied when renderers upload the texture.
+ *
  * Returns: A newly-created #GdkTexture
  */
 GdkTexture *
@@ -172,33 +214,35 @@ convert_memcpy (guchar       *dest_data,
     memcpy (dest_data + y * dest_stride, src_data + y * src_stride, 4 * width);
 }
 
-#define SWIZZLE(A,R,G,B) \
-static void \
-convert_swizzle ## A ## R ## G ## B (guchar       *dest_data, \
-                                     gsize         dest_stride, \
-                                     const guchar *src_data, \
-                                     gsize         src_stride, \
-                                     gsize         width, \
-                                     gsize         height) \
-{ \
-  gsize x, y; \
-\
-  for (y = 0; y < height; y++) \
-    { \
-      for (x = 0; x < width; x++) \
-        { \
-          dest_data[4 * x + A] = src_data[4 * x + 0]; \
-          dest_data[4 * x + R] = src_data[4 * x + 1]; \
-          dest_data[4 * x + G] = src_data[4 * x + 2]; \
-          dest_data[4 * x + B] = src_data[4 * x + 3]; \
-        } \
-\
-      dest_data += dest_stride; \
-      src_data += src_stride; \
-    } \
-}
+/* Reversing the byte order of whole pixels is something compilers turn
+ * into byte swap or vector shuffle instructions, which they don't do
+ * for the same thing written one byte at a time.
+ */
+static void
+convert_swizzle3210 (guchar       *dest_data,
+                     gsize         dest_stride,
+                     const guchar *src_data,
+                     gsize         src_stride,
+                     gsize         width,
+                     gsize         height)
+{
+  gsize x, y;
+  guint32 pixel;
 
-SWIZZLE(3,2,1,0)
+  for (y = 0; y < height; y++)
+    {
+      for (x = 0; x < width; x++)
+        {
+          /* The data doesn't need to be aligned */
+          memcpy (&pixel, src_data + 4 * x, sizeof (guint32));
+          pixel = GUINT32_SWAP_LE_BE (pixel);
+          memcpy (dest_data + 4 * x, &pixel, sizeof (guint32));
+        }
+
+      dest_data += dest_stride;
+      src_data += src_stride;
+    }
+}
 
 #define SWIZZLE_OPAQUE(A,R,G,B) \
 static void \
@@ -248,10 +292,29 @@ convert_swizzle_premultiply_ ## A ## R ## G ## B ## _ ## A2 ## R2 ## G2 ## B2 \
     { \
       for (x = 0; x < width; x++) \
         { \
-          dest_data[4 * x + A] = src_data[4 * x + A2]; \
-          PREMULTIPLY(dest_data[4 * x + R], src_data[4 * x + R2], src_data[4 * x + A2]); \
-          PREMULTIPLY(dest_data[4 * x + G], src_data[4 * x + G2], src_data[4 * x + A2]); \
-          PREMULTIPLY(dest_data[4 * x + B], src_data[4 * x + B2], src_data[4 * x + A2]); \
+          guchar alpha = src_data[4 * x + A2]; \
+\
+          dest_data[4 * x + A] = alpha; \
+          /* Most pixels of icons and photos are opaque or fully \
+           * transparent, and those don't need the multiplications */ \
+          if (alpha == 0xFF) \
+            { \
+              dest_data[4 * x + R] = src_data[4 * x + R2]; \
+              dest_data[4 * x + G] = src_data[4 * x + G2]; \
+              dest_data[4 * x + B] = src_data[4 * x + B2]; \
+            } \
+          else if (alpha == 0) \
+            { \
+              dest_data[4 * x + R] = 0; \
+              dest_data[4 * x + G] = 0; \
+              dest_data[4 * x + B] = 0; \
+            } \
+          else \
+            { \
+              PREMULTIPLY(dest_data[4 * x + R], src_data[4 * x + R2], alpha); \
+              PREMULTIPLY(dest_data[4 * x + G], src_data[4 * x + G2], alpha); \
+              PREMULTIPLY(dest_data[4 * x + B], src_data[4 * x + B2], alpha); \
+            } \
         } \
 \
       dest_data += dest_stride; \
@@ -268,6 +331,83 @@ SWIZZLE_PREMULTIPLY (0,1,2,3, 3,0,1,2)
 SWIZZLE_PREMULTIPLY (3,2,1,0, 0,3,2,1)
 SWIZZLE_PREMULTIPLY (0,1,2,3, 0,3,2,1)
 
+static inline guint16
+read_u16 (const guchar *data)
+{
+  guint16 value;
+
+  /* The data doesn't need to be aligned */
+  memcpy (&value, data, sizeof (guint16));
+
+  return value;
+}
+
+static inline guchar
+unorm16_to_8 (guint16 value)
+{
+  return ((guint) value * 255 + 32767) / 65535;
+}
+
+static inline guchar
+half_to_8 (guint16 value)
+{
+  union { guint32 u; float f; } result;
+  guint32 sign, exponent, mantissa;
+
+  sign = (value & 0x8000) << 16;
+  exponent = (value >> 10) & 0x1f;
+  mantissa = value & 0x3ff;
+
+  if (exponent == 0)
+    {
+      /* zero or denormal, which is less than half a step in 8 bits */
+      return 0;
+    }
+  else if (exponent == 0x1f)
+    result.u = sign | 0x7f800000 | (mantissa << 13);
+  else
+    result.u = sign | ((exponent + 127 - 15) << 23) | (mantissa << 13);
+
+  /* written so that NaN ends up as 0 */
+  if (result.f >= 1.0f)
+    return 255;
+  else if (result.f > 0.0f)
+    return result.f * 255.f + 0.5f;
+  else
+    return 0;
+}
+
+#define CONVERT_16(A,R,G,B,name,convert) \
+static void \
+convert_ ## name ## _ ## A ## R ## G ## B (guchar       *dest_data, \
+                                           gsize         dest_stride, \
+                                           const guchar *src_data, \
+                                           gsize         src_stride, \
+                                           gsize         width, \
+                                           gsize         height) \
+{ \
+  gsize x, y; \
+\
+  for (y = 0; y < height; y++) \
+    { \
+      for (x = 0; x < width; x++) \
+        { \
+          dest_data[4 * x + R] = convert (read_u16 (src_data + 8 * x + 0)); \
+          dest_data[4 * x + G] = convert (read_u16 (src_data + 8 * x + 2)); \
+          dest_data[4 * x + B] = convert (read_u16 (src_data + 8 * x + 4)); \
+          dest_data[4 * x + A] = convert (read_u16 (src_data + 8 * x + 6)); \
+        } \
+\
+      dest_data += dest_stride; \
+      src_data += src_stride; \
+    } \
+}
+
+CONVERT_16 (3,2,1,0, unorm16, unorm16_to_8)
+CONVERT_16 (0,1,2,3, unorm16, unorm16_to_8)
+CONVERT_16 (3,2,1,0, half, half_to_8)
+CONVERT_16 (0,1,2,3, half, half_to_8)
+
 typedef void (* ConversionFunc) (guchar       *dest_data,
                                  gsize         dest_stride,
                                  const guchar *src_data,
@@ -284,9 +424,87 @@ static ConversionFunc converters[GDK_MEMORY_N_FORMATS][2] =
   { convert_swizzle_premultiply_3210_3012, convert_swizzle_premultiply_0123_3012 },
   { convert_swizzle_premultiply_3210_0321, convert_swizzle_premultiply_0123_0321 },
   { convert_swizzle_opaque_3210, convert_swizzle_opaque_0123 },
-  { convert_swizzle_opaque_3012, convert_swizzle_opaque_0321 }
+  { convert_swizzle_opaque_3012, convert_swizzle_opaque_0321 },
+  { convert_unorm16_3210, convert_unorm16_0123 },
+  { convert_half_3210, convert_half_0123 }
 };
 
+/* Images smaller than this are converted on the calling thread, handing
+ * them to other threads costs more than it saves */
+#define MIN_PARALLEL_PIXELS (512 * 512)
+#define MAX_CONVERT_THREADS 8
+
+typedef struct {
+  ConversionFunc func;
+  guchar *dest_data;
+  gsize dest_stride;
+  const guchar *src_data;
+  gsize src_stride;
+  gsize width;
+  gsize height;
+  gsize rows_per_band;
+  int n_bands;
+  int next;
+  int n_workers;
+  GMutex mutex;
+  GCond cond;
+} ConvertJob;
+
+static void
+convert_job_run (ConvertJob *job)
+{
+  int i;
+
+  while ((i = g_atomic_int_add (&job->next, 1)) < job->n_bands)
+    {
+      gsize y = i * job->rows_per_band;
+
+      job->func (job->dest_data + y * job->dest_stride, job->dest_stride,
+                 job->src_data + y * job->src_stride, job->src_stride,
+                 job->width, MIN (job->rows_per_band, job->height - y));
+    }
+}
+
+static void
+convert_worker (gpointer data,
+                gpointer user_data)
+{
+  ConvertJob *job = data;
+
+  convert_job_run (job);
+
+  g_mutex_lock (&job->mutex);
+  job->n_workers--;
+  if (job->n_workers == 0)
+    g_cond_signal (&job->cond);
+  g_mutex_unlock (&job->mutex);
+}
+
+static GThreadPool *
+get_convert_pool (int *max_workers)
+{
+  static GThreadPool *pool = NULL;
+  static int workers = 0;
+
+  if (g_once_init_enter (&pool))
+    {
+      GThreadPool *new_pool = NULL;
+
+      workers = MIN (g_get_num_processors (), MAX_CONVERT_THREADS) - 1;
+      if (workers > 0)
+        new_pool = g_thread_pool_new (convert_worker, NULL, workers, FALSE, NULL);
+      if (new_pool == NULL)
+        workers = 0;
+
+      /* g_once_init_leave() doesn't take NULL */
+      g_once_init_leave (&pool, new_pool ? new_pool : GSIZE_TO_POINTER (1));
+    }
+
+  *max_workers = workers;
+
+  return workers > 0 ? pool : NULL;
+}
+
 void
 gdk_memory_convert (guchar          *dest_data,
                     gsize            dest_stride,
@@ -297,8 +515,49 @@ gdk_memory_convert (guchar          *dest_data,
                     gsize            width,
                     gsize            height)
 {
+  GThreadPool *pool;
+  ConvertJob job;
+  int i, max_workers;
+
   g_assert (dest_format < 2);
   g_assert (src_format < GDK_MEMORY_N_FORMATS);
 
-  converters[src_format][dest_format] (dest_data, dest_stride, src_data, src_stride, width, height);
+  job.func = converters[src_format][dest_format];
+
+  if (width * height < MIN_PARALLEL_PIXELS ||
+      (pool = get_convert_pool (&max_workers)) == NULL)
+    {
+      job.func (dest_data, dest_stride, src_data, src_stride, width, height);
+      return;
+    }
+
+  /* Bands of rows, more of them than threads so that a thread that got
+   * descheduled doesn't hold up the others for long */
+  job.dest_data = dest_data;
+  job.dest_stride = dest_stride;
+  job.src_data = src_data;
+  job.src_stride = src_stride;
+  job.width = width;
+  job.height = height;
+  job.n_bands = MIN (height, 4 * (max_workers + 1));
+  job.rows_per_band = (height + job.n_bands - 1) / job.n_bands;
+  job.n_bands = (height + job.rows_per_band - 1) / job.rows_per_band;
+  job.next = 0;
+  job.n_workers = MIN (max_workers, width * height / MIN_PARALLEL_PIXELS);
+  g_mutex_init (&job.mutex);
+  g_cond_init (&job.cond);
+
+  for (i = 0; i < job.n_workers; i++)
+    g_thread_pool_push (pool, &job, NULL);
+
+  /* Help out instead of waiting */
+  convert_job_run (&job);
+
+  g_mutex_lock (&job.mutex);
+  while (job.n_workers > 0)
+    g_cond_wait (&job.cond, &job.mutex);
+  g_mutex_unlock (&job.mutex);
+
+  g_mutex_clear (&job.mutex);
+  g_cond_clear (&job.cond);
 }
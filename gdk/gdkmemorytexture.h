@@ -40,6 +40,10 @@ G_BEGIN_DECLS
  * @GDK_MEMORY_A8B8G8R8: 4 bytes; for alpha, blue, green, red.
  * @GDK_MEMORY_R8G8B8: 3 bytes; for red, green, blue. The data is opaque.
  * @GDK_MEMORY_B8G8R8: 3 bytes; for blue, green, red. The data is opaque.
+ * @GDK_MEMORY_R16G16B16A16_PREMULTIPLIED: 4 guint16s; for red, green, blue, alpha.
+ *     The color values are premultiplied with the alpha value.
+ * @GDK_MEMORY_R16G16B16A16_FLOAT_PREMULTIPLIED: 4 half-float values; for red,
+ *     green, blue, alpha. The color values are premultiplied with the alpha value.
  * @GDK_MEMORY_N_FORMATS: The number of formats. This value will change as
  *     more formats get added, so do not rely on its concrete integer.
  *
@@ -49,7 +53,9 @@ G_BEGIN_DECLS
  * So GDK_MEMORY_A8R8G8B8 will be 1 byte (8 bits) of alpha, followed by a
  * byte each of red, green and blue. It is not endian-dependent, so
  * CAIRO_FORMAT_ARGB32 is represented by different #GdkMemoryFormats on
- * architectures with different endiannesses.
+ * architectures with different endiannesses. Formats with more than 8 bits
+ * per channel are the exception, their channels are stored in the native
+ * endianness.
  * 
  * Its naming is modelled after VkFormat (see
  * https://www.khronos.org/registry/vulkan/specs/1.0/html/vkspec.html#VkFormat
@@ -64,6 +70,8 @@ typedef enum {
   GDK_MEMORY_A8B8G8R8,
   GDK_MEMORY_R8G8B8,
   GDK_MEMORY_B8G8R8,
+  GDK_MEMORY_R16G16B16A16_PREMULTIPLIED,
+  GDK_MEMORY_R16G16B16A16_FLOAT_PREMULTIPLIED,
 
   GDK_MEMORY_N_FORMATS
 } GdkMemoryFormat;
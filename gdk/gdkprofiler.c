@@ -0,0 +1,111 @@
+/* GDK - The GIMP Drawing Kit
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "config.h"
+
+#include "gdkprofilerprivate.h"
+
+#include <stdlib.h>
+#ifdef HAVE_UNISTD_H
+#include <unistd.h>
+#endif
+
+#ifdef HAVE_SYSPROF_CAPTURE
+#include <sysprof-capture.h>
+#endif
+
+/* Marks for the sysprof capture, when GTK is run under sysprof, which
+ * passes the capture file in SYSPROF_TRACE_FD. Marks are spans of time
+ * with a name, in the same capture as the CPU samples and scheduler
+ * data, so they line up with them.
+ *
+ * Without sysprof-capture, or when not run under sysprof, marks cost no
+ * more than a check whether the profiler is running.
+ */
+
+#ifdef HAVE_SYSPROF_CAPTURE
+static SysprofCaptureWriter *writer = NULL;
+
+static void
+profiler_stop (void)
+{
+  if (writer)
+    sysprof_capture_writer_unref (writer);
+  writer = NULL;
+}
+#endif
+
+void
+gdk_profiler_start (void)
+{
+#ifdef HAVE_SYSPROF_CAPTURE
+  if (writer)
+    return;
+
+  writer = sysprof_capture_writer_new_from_env (0);
+  if (writer)
+    atexit (profiler_stop);
+#endif
+}
+
+gboolean
+gdk_profiler_is_running (void)
+{
+#ifdef HAVE_SYSPROF_CAPTURE
+  return writer != NULL;
+#else
+  return FALSE;
+#endif
+}
+
+gint64
+gdk_profiler_current_time (void)
+{
+#ifdef HAVE_SYSPROF_CAPTURE
+  return SYSPROF_CAPTURE_CURRENT_TIME;
+#else
+  return g_get_monotonic_time () * 1000;
+#endif
+}
+
+void
+gdk_profiler_add_mark (gint64      start,
+                       gint64      duration,
+                       const char *name,
+                       const char *message)
+{
+#ifdef HAVE_SYSPROF_CAPTURE
+  if (writer == NULL)
+    return;
+
+  sysprof_capture_writer_add_mark (writer,
+                                   start,
+                                   -1, getpid (),
+                                   duration,
+                                   "gtk", name, message ? message : "");
+#endif
+}
+
+void
+gdk_profiler_end_mark (gint64      start,
+                       const char *name,
+                       const char *message)
+{
+  if (!gdk_profiler_is_running ())
+    return;
+
+  gdk_profiler_add_mark (start, gdk_profiler_current_time () - start, name, message);
+}
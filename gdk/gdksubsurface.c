@@ -0,0 +1,140 @@
+/* GDK - The GIMP Drawing Kit
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "config.h"
+
+#include "gdksubsurfaceprivate.h"
+
+#include "gdkinternals.h"
+#include "gdksurfaceimpl.h"
+
+G_DEFINE_ABSTRACT_TYPE (GdkSubsurface, gdk_subsurface, G_TYPE_OBJECT)
+
+static gboolean
+gdk_subsurface_default_attach (GdkSubsurface         *subsurface,
+                               GdkTexture            *texture,
+                               const graphene_rect_t *rect)
+{
+  return FALSE;
+}
+
+static void
+gdk_subsurface_default_detach (GdkSubsurface *subsurface)
+{
+}
+
+static void
+gdk_subsurface_dispose (GObject *object)
+{
+  GdkSubsurface *subsurface = GDK_SUBSURFACE (object);
+
+  g_clear_object (&subsurface->parent);
+
+  G_OBJECT_CLASS (gdk_subsurface_parent_class)->dispose (object);
+}
+
+static void
+gdk_subsurface_class_init (GdkSubsurfaceClass *klass)
+{
+  GObjectClass *object_class = G_OBJECT_CLASS (klass);
+
+  object_class->dispose = gdk_subsurface_dispose;
+
+  klass->attach = gdk_subsurface_default_attach;
+  klass->detach = gdk_subsurface_default_detach;
+}
+
+static void
+gdk_subsurface_init (GdkSubsurface *subsurface)
+{
+}
+
+/*< private >
+ * gdk_surface_create_subsurface:
+ * @surface: a #GdkSurface
+ *
+ * Creates a subsurface of @surface, if the backend supports it.
+ *
+ * Returns: (nullable) (transfer full): the new subsurface
+ */
+GdkSubsurface *
+gdk_surface_create_subsurface (GdkSurface *surface)
+{
+  GdkSurfaceImplClass *impl_class;
+  GdkSubsurface *subsurface;
+
+  g_return_val_if_fail (GDK_IS_SURFACE (surface), NULL);
+
+  if (GDK_SURFACE_DESTROYED (surface))
+    return NULL;
+
+  impl_class = GDK_SURFACE_IMPL_GET_CLASS (surface->impl);
+  if (impl_class->create_subsurface == NULL)
+    return NULL;
+
+  subsurface = impl_class->create_subsurface (surface);
+  if (subsurface != NULL)
+    subsurface->parent = g_object_ref (surface);
+
+  return subsurface;
+}
+
+GdkSurface *
+gdk_subsurface_get_parent (GdkSubsurface *subsurface)
+{
+  g_return_val_if_fail (GDK_IS_SUBSURFACE (subsurface), NULL);
+
+  return subsurface->parent;
+}
+
+/*< private >
+ * gdk_subsurface_attach:
+ * @subsurface: a #GdkSubsurface
+ * @texture: the texture to show
+ * @rect: where to show @texture, in coordinates of the parent surface
+ *
+ * Shows @texture in @subsurface, scaled to @rect. The change takes
+ * effect together with the next frame drawn on the parent surface.
+ *
+ * Returns: %FALSE if @texture can't be shown this way, in which
+ *     case it must be drawn into the parent surface instead
+ */
+gboolean
+gdk_subsurface_attach (GdkSubsurface         *subsurface,
+                       GdkTexture            *texture,
+                       const graphene_rect_t *rect)
+{
+  g_return_val_if_fail (GDK_IS_SUBSURFACE (subsurface), FALSE);
+  g_return_val_if_fail (GDK_IS_TEXTURE (texture), FALSE);
+  g_return_val_if_fail (rect != NULL, FALSE);
+
+  return GDK_SUBSURFACE_GET_CLASS (subsurface)->attach (subsurface, texture, rect);
+}
+
+/*< private >
+ * gdk_subsurface_detach:
+ * @subsurface: a #GdkSubsurface
+ *
+ * Hides @subsurface, together with the next frame drawn on the
+ * parent surface.
+ */
+void
+gdk_subsurface_detach (GdkSubsurface *subsurface)
+{
+  g_return_if_fail (GDK_IS_SUBSURFACE (subsurface));
+
+  GDK_SUBSURFACE_GET_CLASS (subsurface)->detach (subsurface);
+}
@@ -0,0 +1,68 @@
+/* GDK - The GIMP Drawing Kit
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef __GDK_SUBSURFACE_PRIVATE_H__
+#define __GDK_SUBSURFACE_PRIVATE_H__
+
+#include "gdksurface.h"
+#include "gdktexture.h"
+
+#include <graphene.h>
+
+G_BEGIN_DECLS
+
+#define GDK_TYPE_SUBSURFACE             (gdk_subsurface_get_type ())
+#define GDK_SUBSURFACE(object)          (G_TYPE_CHECK_INSTANCE_CAST ((object), GDK_TYPE_SUBSURFACE, GdkSubsurface))
+#define GDK_SUBSURFACE_CLASS(klass)     (G_TYPE_CHECK_CLASS_CAST ((klass), GDK_TYPE_SUBSURFACE, GdkSubsurfaceClass))
+#define GDK_IS_SUBSURFACE(object)       (G_TYPE_CHECK_INSTANCE_TYPE ((object), GDK_TYPE_SUBSURFACE))
+#define GDK_SUBSURFACE_GET_CLASS(obj)   (G_TYPE_INSTANCE_GET_CLASS ((obj), GDK_TYPE_SUBSURFACE, GdkSubsurfaceClass))
+
+typedef struct _GdkSubsurface GdkSubsurface;
+typedef struct _GdkSubsurfaceClass GdkSubsurfaceClass;
+
+/* A GdkSubsurface shows a texture on top of its parent surface,
+ * without it being drawn into the parent. The compositor takes
+ * care of putting it on screen. */
+struct _GdkSubsurface
+{
+  GObject parent_instance;
+
+  GdkSurface *parent;
+};
+
+struct _GdkSubsurfaceClass
+{
+  GObjectClass parent_class;
+
+  gboolean      (* attach)                      (GdkSubsurface          *subsurface,
+                                                 GdkTexture             *texture,
+                                                 const graphene_rect_t  *rect);
+  void          (* detach)                      (GdkSubsurface          *subsurface);
+};
+
+GType           gdk_subsurface_get_type         (void) G_GNUC_CONST;
+
+GdkSubsurface * gdk_surface_create_subsurface   (GdkSurface             *surface);
+
+GdkSurface *    gdk_subsurface_get_parent       (GdkSubsurface          *subsurface);
+gboolean        gdk_subsurface_attach           (GdkSubsurface          *subsurface,
+                                                 GdkTexture             *texture,
+                                                 const graphene_rect_t  *rect);
+void            gdk_subsurface_detach           (GdkSubsurface          *subsurface);
+
+G_END_DECLS
+
+#endif /* __GDK_SUBSURFACE_PRIVATE_H__ */
@@ -1342,6 +1342,7 @@ gdk_surface_get_paint_gl_context (GdkSurface  *surface,
   if (surface->impl_surface->gl_paint_context == NULL)
     {
       GdkSurfaceImplClass *impl_class = GDK_SURFACE_IMPL_GET_CLASS (surface->impl);
+      GdkDisplay *display = surface->display;
 
       if (impl_class->create_gl_context == NULL)
         {
@@ -1350,11 +1351,26 @@ gdk_surface_get_paint_gl_context (GdkSurface  *surface,
           return NULL;
         }
 
-      surface->impl_surface->gl_paint_context =
-        impl_class->create_gl_context (surface->impl_surface,
-                                       TRUE,
-                                       NULL,
-                                       &internal_error);
+      /* Share with the other paint contexts of the display if we can */
+      if (display->gl_share_context)
+        {
+          surface->impl_surface->gl_paint_context =
+            impl_class->create_gl_context (surface->impl_surface,
+                                           TRUE,
+                                           display->gl_share_context,
+                                           NULL);
+
+          if (surface->impl_surface->gl_paint_context &&
+              !gdk_gl_context_realize (surface->impl_surface->gl_paint_context, NULL))
+            g_clear_object (&(surface->impl_surface->gl_paint_context));
+        }
+
+      if (surface->impl_surface->gl_paint_context == NULL)
+        surface->impl_surface->gl_paint_context =
+          impl_class->create_gl_context (surface->impl_surface,
+                                         TRUE,
+                                         NULL,
+                                         &internal_error);
     }
 
   if (internal_error != NULL)
@@ -1372,6 +1388,15 @@ gdk_surface_get_paint_gl_context (GdkSurface  *surface,
       return NULL;
     }
 
+  /* Contexts keep the context they share with alive, so the share
+   * group lives as long as one of its contexts does */
+  if (surface->display->gl_share_context == NULL)
+    {
+      surface->display->gl_share_context = surface->impl_surface->gl_paint_context;
+      g_object_add_weak_pointer (G_OBJECT (surface->display->gl_share_context),
+                                 (gpointer *) &surface->display->gl_share_context);
+    }
+
   return surface->impl_surface->gl_paint_context;
 }
 
@@ -2223,6 +2248,38 @@ _gdk_surface_update_viewable (GdkSurface *surface)
   return set_viewable (surface, viewable);
 }
 
+/* Throttle the frame clock of toplevels that can't be seen */
+static void
+gdk_surface_update_frame_clock_throttle (GdkSurface *surface)
+{
+  gboolean hidden;
+
+  if (surface->frame_clock == NULL ||
+      !GDK_IS_FRAME_CLOCK_IDLE (surface->frame_clock))
+    return;
+
+  hidden = surface->occluded ||
+           (surface->state & GDK_SURFACE_STATE_ICONIFIED) != 0;
+
+  _gdk_frame_clock_idle_set_throttled (GDK_FRAME_CLOCK_IDLE (surface->frame_clock), hidden);
+}
+
+/* Called by backends when they learn that the surface is fully
+ * covered by other windows, or no longer is.
+ */
+void
+_gdk_surface_set_occluded (GdkSurface *surface,
+                           gboolean    occluded)
+{
+  occluded = !!occluded;
+
+  if (surface->occluded == occluded)
+    return;
+
+  surface->occluded = occluded;
+  gdk_surface_update_frame_clock_throttle (surface);
+}
+
 static void
 gdk_surface_show_internal (GdkSurface *surface, gboolean raise)
 {
@@ -5183,6 +5240,8 @@ gdk_surface_set_frame_clock (GdkSurface     *surface,
     }
 
   surface->frame_clock = clock;
+
+  gdk_surface_update_frame_clock_throttle (surface);
 }
 
 /**
@@ -5430,6 +5489,7 @@ gdk_surface_set_state (GdkSurface      *surface,
   mapped = GDK_SURFACE_IS_MAPPED (surface);
 
   _gdk_surface_update_viewable (surface);
+  gdk_surface_update_frame_clock_throttle (surface);
 
   /* We only really send the event to toplevels, since
    * all the surface states don't apply to non-toplevels.
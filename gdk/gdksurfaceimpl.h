@@ -27,6 +27,7 @@
 
 #include <gdk/gdksurface.h>
 #include <gdk/gdkproperty.h>
+#include "gdksubsurfaceprivate.h"
 
 G_BEGIN_DECLS
 
@@ -219,6 +220,7 @@ struct _GdkSurfaceImplClass
                                            GdkGLContext   *share,
                                            GError        **error);
   gboolean     (* supports_edge_constraints)(GdkSurface    *surface);
+  GdkSubsurface *(*create_subsurface)     (GdkSurface      *surface);
 };
 
 /* Interface Functions */
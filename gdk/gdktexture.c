@@ -416,6 +416,156 @@ gdk_texture_new_from_file (GFile   *file,
   return texture;
 }
 
+typedef struct {
+  GFile *file;
+  int width;
+  int height;
+} LoadData;
+
+static void
+load_data_free (gpointer data)
+{
+  LoadData *load = data;
+
+  g_object_unref (load->file);
+  g_slice_free (LoadData, load);
+}
+
+static void
+on_loader_size_prepared (GdkPixbufLoader *loader,
+                         int              width,
+                         int              height,
+                         gpointer         user_data)
+{
+  LoadData *load = user_data;
+  double scale = 1.0;
+
+  if (load->width > 0 && width > load->width)
+    scale = MIN (scale, (double) load->width / width);
+  if (load->height > 0 && height > load->height)
+    scale = MIN (scale, (double) load->height / height);
+
+  if (scale < 1.0)
+    gdk_pixbuf_loader_set_size (loader,
+                                MAX (1, (int) (width * scale + 0.5)),
+                                MAX (1, (int) (height * scale + 0.5)));
+}
+
+static void
+gdk_texture_load_thread (GTask        *task,
+                         gpointer      source_object,
+                         gpointer      task_data,
+                         GCancellable *cancellable)
+{
+  LoadData *load = task_data;
+  GdkPixbufLoader *loader;
+  GdkPixbuf *pixbuf;
+  GError *error = NULL;
+  GBytes *bytes;
+
+  bytes = g_file_load_bytes (load->file, cancellable, NULL, &error);
+  if (bytes == NULL)
+    {
+      g_task_return_error (task, error);
+      return;
+    }
+
+  loader = gdk_pixbuf_loader_new ();
+  g_signal_connect (loader, "size-prepared", G_CALLBACK (on_loader_size_prepared), load);
+
+  if (!gdk_pixbuf_loader_write_bytes (loader, bytes, &error) ||
+      !gdk_pixbuf_loader_close (loader, &error))
+    {
+      gdk_pixbuf_loader_close (loader, NULL);
+      g_task_return_error (task, error);
+      goto out;
+    }
+
+  if (g_task_return_error_if_cancelled (task))
+    goto out;
+
+  pixbuf = gdk_pixbuf_loader_get_pixbuf (loader);
+  if (pixbuf == NULL)
+    {
+      g_task_return_new_error (task, GDK_PIXBUF_ERROR, GDK_PIXBUF_ERROR_FAILED,
+                               "Failed to load image");
+      goto out;
+    }
+
+  g_task_return_pointer (task, gdk_texture_new_for_pixbuf (pixbuf), g_object_unref);
+
+out:
+  g_object_unref (loader);
+  g_bytes_unref (bytes);
+}
+
+/**
+ * gdk_texture_new_from_file_async:
+ * @file: #GFile to load
+ * @width: the maximum width of the texture, or -1 for no limit
+ * @height: the maximum height of the texture, or -1 for no limit
+ * @cancellable: (nullable): optional #GCancellable object
+ * @callback: (scope async): callback to call when the texture is loaded
+ * @user_data: (closure): the data to pass to the callback function
+ *
+ * Asynchronously loads an image from a file and creates a texture for it.
+ *
+ * Reading and decoding happen in a worker thread. Images larger than
+ * @width x @height are scaled down while decoding, preserving their
+ * aspect ratio, so only the pixels that will be displayed are kept
+ * in memory. Images are never scaled up.
+ *
+ * When the operation is finished, @callback is called in the thread-default
+ * main context of the caller. You can then call
+ * gdk_texture_new_from_file_finish() to get the result.
+ */
+void
+gdk_texture_new_from_file_async (GFile               *file,
+                                 int                  width,
+                                 int                  height,
+                                 GCancellable        *cancellable,
+                                 GAsyncReadyCallback  callback,
+                                 gpointer             user_data)
+{
+  LoadData *load;
+  GTask *task;
+
+  g_return_if_fail (G_IS_FILE (file));
+  g_return_if_fail (cancellable == NULL || G_IS_CANCELLABLE (cancellable));
+
+  load = g_slice_new (LoadData);
+  load->file = g_object_ref (file);
+  load->width = width;
+  load->height = height;
+
+  task = g_task_new (NULL, cancellable, callback, user_data);
+  g_task_set_source_tag (task, gdk_texture_new_from_file_async);
+  g_task_set_task_data (task, load, load_data_free);
+  g_task_run_in_thread (task, gdk_texture_load_thread);
+  g_object_unref (task);
+}
+
+/**
+ * gdk_texture_new_from_file_finish:
+ * @result: a #GAsyncResult
+ * @error: Return location for an error
+ *
+ * Finishes an asynchronous texture load started with
+ * gdk_texture_new_from_file_async().
+ *
+ * Returns: (transfer full) (nullable): A newly-created #GdkTexture or %NULL
+ *     if an error occured.
+ */
+GdkTexture *
+gdk_texture_new_from_file_finish (GAsyncResult  *result,
+                                  GError       **error)
+{
+  g_return_val_if_fail (g_task_is_valid (result, NULL), NULL);
+  g_return_val_if_fail (g_task_get_source_tag (G_TASK (result)) == gdk_texture_new_from_file_async, NULL);
+
+  return g_task_propagate_pointer (G_TASK (result), error);
+}
+
 /**
  * gdk_texture_get_width:
  * @texture: a #GdkTexture
@@ -24,6 +24,12 @@
 
 #include "gdkinternals.h"
 
+/* Released buffers kept around for reuse. With the one attached to
+ * the surface and one that the compositor may still be reading from,
+ * this covers double and triple buffering compositors.
+ */
+#define MAX_CACHED_SURFACES 2
+
 static const cairo_user_data_key_t gdk_wayland_cairo_context_key;
 static const cairo_user_data_key_t gdk_wayland_cairo_region_key;
 
@@ -83,6 +89,9 @@ gdk_wayland_cairo_context_remove_surface (GdkWaylandCairoContext *self,
                                           cairo_surface_t        *surface)
 {
   self->surfaces = g_slist_remove (self->surfaces, surface);
+  self->cached_surfaces = g_slist_remove (self->cached_surfaces, surface);
+  if (self->front_surface == surface)
+    self->front_surface = NULL;
 
   cairo_surface_set_user_data (surface, &gdk_wayland_cairo_context_key, NULL, NULL);
   cairo_surface_destroy (surface);
@@ -99,10 +108,12 @@ gdk_wayland_cairo_context_buffer_release (void             *_data,
   if (self == NULL)
     return;
 
-  /* Cache one surface for reuse when drawing */
-  if (self->cached_surface == NULL)
+  /* Cache a few surfaces for reuse when drawing. The most recently
+   * released one goes first, it has the least to redraw.
+   */
+  if (g_slist_length (self->cached_surfaces) < MAX_CACHED_SURFACES)
     {
-      self->cached_surface = cairo_surface;
+      self->cached_surfaces = g_slist_prepend (self->cached_surfaces, cairo_surface);
       return;
     }
 
@@ -149,14 +160,44 @@ gdk_wayland_cairo_context_begin_frame (GdkDrawContext *draw_context,
   GSList *l;
   cairo_t *cr;
 
-  if (self->cached_surface)
-    self->paint_surface = g_steal_pointer (&self->cached_surface);
+  if (self->cached_surfaces)
+    {
+      self->paint_surface = self->cached_surfaces->data;
+      self->cached_surfaces = g_slist_delete_link (self->cached_surfaces,
+                                                   self->cached_surfaces);
+    }
   else
     self->paint_surface = gdk_wayland_cairo_context_create_surface (self);
 
+  cr = cairo_create (self->paint_surface);
+
+  /* The parts of the buffer that are outdated but not being repainted
+   * are up to date in the buffer we attached last, so copy them from
+   * there instead of redrawing them. Only when there is no such buffer
+   * we have to repaint them.
+   */
   surface_region = gdk_wayland_cairo_context_surface_get_region (self->paint_surface);
   if (surface_region)
-    cairo_region_union (region, surface_region);
+    {
+      if (self->front_surface && self->front_surface != self->paint_surface)
+        {
+          cairo_region_t *copy_region;
+
+          copy_region = cairo_region_copy (surface_region);
+          cairo_region_subtract (copy_region, region);
+
+          cairo_save (cr);
+          cairo_set_operator (cr, CAIRO_OPERATOR_SOURCE);
+          cairo_set_source_surface (cr, self->front_surface, 0, 0);
+          gdk_cairo_region (cr, copy_region);
+          cairo_fill (cr);
+          cairo_restore (cr);
+
+          cairo_region_destroy (copy_region);
+        }
+      else
+        cairo_region_union (region, surface_region);
+    }
 
   for (l = self->surfaces; l; l = l->next)
     {
@@ -164,7 +205,6 @@ gdk_wayland_cairo_context_begin_frame (GdkDrawContext *draw_context,
     }
 
   /* clear the repaint area */
-  cr = cairo_create (self->paint_surface);
   cairo_set_operator (cr, CAIRO_OPERATOR_CLEAR);
   gdk_cairo_region (cr, region);
   cairo_fill (cr);
@@ -182,13 +222,12 @@ gdk_wayland_cairo_context_end_frame (GdkDrawContext *draw_context,
   gdk_wayland_surface_sync (surface);
 
   gdk_wayland_cairo_context_surface_clear_region (self->paint_surface);
-  self->paint_surface = NULL;
+  self->front_surface = g_steal_pointer (&self->paint_surface);
 }
 
 static void
 gdk_wayland_cairo_context_clear_all_cairo_surfaces (GdkWaylandCairoContext *self)
 {
-  self->cached_surface = NULL;
   while (self->surfaces)
     gdk_wayland_cairo_context_remove_surface (self, self->surfaces->data);
 }
@@ -40,7 +40,8 @@ struct _GdkWaylandCairoContext
   GdkCairoContext parent_instance;
 
   GSList *surfaces;
-  cairo_surface_t *cached_surface;
+  GSList *cached_surfaces;
+  cairo_surface_t *front_surface;
   cairo_surface_t *paint_surface;
 };
 
@@ -107,6 +107,9 @@ gdk_wayland_clipboard_data_source_send (void                  *data,
                                    source, mime_type, fd));
 
   mime_type = gdk_intern_mime_type (mime_type);
+  /* Without this, a reader that is slow to drain the pipe would
+   * block the main loop in write() for as long as it takes */
+  g_unix_set_fd_nonblocking (fd, TRUE, NULL);
   stream = g_unix_output_stream_new (fd, TRUE);
 
   gdk_clipboard_write_async (GDK_CLIPBOARD (cb),
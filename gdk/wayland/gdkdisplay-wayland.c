@@ -390,6 +390,21 @@ gdk_wayland_display_prefers_ssd (GdkDisplay *display)
   return FALSE;
 }
 
+static void
+presentation_clock_id (void                   *data,
+                       struct wp_presentation *presentation,
+                       uint32_t                clk_id)
+{
+  GdkWaylandDisplay *display_wayland = data;
+
+  GDK_NOTE (MISC, g_message ("presentation clock %u", clk_id));
+  display_wayland->presentation_clock_id = clk_id;
+}
+
+static const struct wp_presentation_listener presentation_listener = {
+  presentation_clock_id
+};
+
 static void gdk_wayland_display_set_has_gtk_shell (GdkWaylandDisplay *display_wayland);
 static void gdk_wayland_display_add_output        (GdkWaylandDisplay *display_wayland,
                                                    guint32            id,
@@ -414,8 +429,8 @@ gdk_registry_handle_global (void               *data,
   if (strcmp (interface, "wl_compositor") == 0)
     {
       display_wayland->compositor =
-        wl_registry_bind (display_wayland->wl_registry, id, &wl_compositor_interface, MIN (version, 3));
-      display_wayland->compositor_version = MIN (version, 3);
+        wl_registry_bind (display_wayland->wl_registry, id, &wl_compositor_interface, MIN (version, 4));
+      display_wayland->compositor_version = MIN (version, 4);
     }
   else if (strcmp (interface, "wl_shm") == 0)
     {
@@ -528,6 +543,21 @@ gdk_registry_handle_global (void               *data,
                                                            &server_decoration_listener,
                                                            display_wayland);
     }
+  else if (strcmp (interface, "wp_presentation") == 0)
+    {
+      display_wayland->presentation =
+        wl_registry_bind (display_wayland->wl_registry, id,
+                          &wp_presentation_interface, 1);
+      wp_presentation_add_listener (display_wayland->presentation,
+                                    &presentation_listener,
+                                    display_wayland);
+    }
+  else if (strcmp (interface, "wp_viewporter") == 0)
+    {
+      display_wayland->viewporter =
+        wl_registry_bind (display_wayland->wl_registry, id,
+                          &wp_viewporter_interface, 1);
+    }
 
   g_hash_table_insert (display_wayland->known_globals,
                        GUINT_TO_POINTER (id), g_strdup (interface));
@@ -35,6 +35,8 @@
 #include <gdk/wayland/xdg-foreign-unstable-v1-client-protocol.h>
 #include <gdk/wayland/keyboard-shortcuts-inhibit-unstable-v1-client-protocol.h>
 #include <gdk/wayland/server-decoration-client-protocol.h>
+#include <gdk/wayland/presentation-time-client-protocol.h>
+#include <gdk/wayland/viewporter-client-protocol.h>
 
 #include <glib.h>
 #include <gdk/gdkkeys.h>
@@ -109,6 +111,8 @@ struct _GdkWaylandDisplay
   struct zxdg_importer_v1 *xdg_importer;
   struct zwp_keyboard_shortcuts_inhibit_manager_v1 *keyboard_shortcuts_inhibit;
   struct org_kde_kwin_server_decoration_manager *server_decoration_manager;
+  struct wp_presentation *presentation;
+  struct wp_viewporter *viewporter;
 
   GList *async_roundtrips;
 
@@ -137,6 +141,7 @@ struct _GdkWaylandDisplay
   int gtk_shell_version;
 
   uint32_t server_decoration_mode;
+  uint32_t presentation_clock_id;
 
   struct xkb_context *xkb_context;
 
@@ -268,6 +268,7 @@ data_source_send (void                  *data,
 
   //mime_type = gdk_intern_mime_type (mime_type);
   mime_type = g_intern_string (mime_type);
+  g_unix_set_fd_nonblocking (fd, TRUE, NULL);
   stream = g_unix_output_stream_new (fd, TRUE);
 
   gdk_drag_write_async (drag,
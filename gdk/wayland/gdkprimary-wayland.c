@@ -217,6 +217,7 @@ gdk_wayland_primary_data_source_send (void                                *data,
                                    source, mime_type, fd));
 
   mime_type = gdk_intern_mime_type (mime_type);
+  g_unix_set_fd_nonblocking (fd, TRUE, NULL);
   stream = g_unix_output_stream_new (fd, TRUE);
 
   gdk_clipboard_write_async (GDK_CLIPBOARD (cb),
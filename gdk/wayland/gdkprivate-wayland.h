@@ -41,6 +41,7 @@
 #include "wayland/gtk-primary-selection-client-protocol.h"
 
 #define WL_SURFACE_HAS_BUFFER_SCALE 3
+#define WL_SURFACE_HAS_BUFFER_DAMAGE 4
 #define WL_POINTER_HAS_FRAME 5
 
 #define GDK_SURFACE_IS_WAYLAND(win)    (GDK_IS_SURFACE_IMPL_WAYLAND (((GdkSurface *)win)->impl))
@@ -180,6 +181,8 @@ cairo_surface_t * _gdk_wayland_display_create_shm_surface (GdkWaylandDisplay *di
 struct wl_buffer *_gdk_wayland_shm_surface_get_wl_buffer (cairo_surface_t *surface);
 gboolean _gdk_wayland_is_shm_surface (cairo_surface_t *surface);
 
+GdkSubsurface *_gdk_wayland_surface_create_subsurface (GdkSurface *surface);
+
 EGLSurface gdk_wayland_surface_get_egl_surface (GdkSurface *surface,
                                                EGLConfig config);
 EGLSurface gdk_wayland_surface_get_dummy_egl_surface (GdkSurface *surface,
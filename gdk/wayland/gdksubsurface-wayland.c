@@ -0,0 +1,309 @@
+/* GDK - The GIMP Drawing Kit
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "config.h"
+
+#include "gdksubsurfaceprivate.h"
+
+#include "gdkdisplay-wayland.h"
+#include "gdkprivate-wayland.h"
+#include "gdkinternals.h"
+
+#define MAX_CACHED_BUFFERS 2
+
+#define GDK_TYPE_WAYLAND_SUBSURFACE (gdk_wayland_subsurface_get_type ())
+#define GDK_WAYLAND_SUBSURFACE(object) (G_TYPE_CHECK_INSTANCE_CAST ((object), GDK_TYPE_WAYLAND_SUBSURFACE, GdkWaylandSubsurface))
+
+typedef struct _GdkWaylandSubsurface GdkWaylandSubsurface;
+typedef struct _GdkWaylandSubsurfaceClass GdkWaylandSubsurfaceClass;
+
+struct _GdkWaylandSubsurface
+{
+  GdkSubsurface parent_instance;
+
+  /* the wl_surface of the parent we were created for; it is
+   * destroyed and recreated when the parent is hidden and shown */
+  struct wl_surface *parent_wl_surface;
+
+  struct wl_surface *wl_surface;
+  struct wl_subsurface *wl_subsurface;
+  struct wp_viewport *viewport;
+
+  /* the texture currently shown */
+  GdkTexture *texture;
+  cairo_rectangle_int_t dest;
+  gboolean attached;
+
+  GSList *busy_buffers;
+  GSList *cached_buffers;
+};
+
+struct _GdkWaylandSubsurfaceClass
+{
+  GdkSubsurfaceClass parent_class;
+};
+
+static GType gdk_wayland_subsurface_get_type (void);
+
+G_DEFINE_TYPE (GdkWaylandSubsurface, gdk_wayland_subsurface, GDK_TYPE_SUBSURFACE)
+
+static const cairo_user_data_key_t gdk_wayland_subsurface_key;
+
+static void
+buffer_release (void             *data,
+                struct wl_buffer *wl_buffer)
+{
+  cairo_surface_t *cairo_surface = data;
+  GdkWaylandSubsurface *self;
+
+  self = cairo_surface_get_user_data (cairo_surface, &gdk_wayland_subsurface_key);
+
+  /* subsurface was destroyed before the compositor released the buffer */
+  if (self == NULL)
+    {
+      cairo_surface_destroy (cairo_surface);
+      return;
+    }
+
+  self->busy_buffers = g_slist_remove (self->busy_buffers, cairo_surface);
+
+  if (g_slist_length (self->cached_buffers) < MAX_CACHED_BUFFERS)
+    {
+      self->cached_buffers = g_slist_prepend (self->cached_buffers, cairo_surface);
+      return;
+    }
+
+  cairo_surface_destroy (cairo_surface);
+}
+
+static const struct wl_buffer_listener buffer_listener = {
+  buffer_release
+};
+
+static cairo_surface_t *
+gdk_wayland_subsurface_get_buffer (GdkWaylandSubsurface *self,
+                                   int                   width,
+                                   int                   height)
+{
+  GdkWaylandDisplay *display_wayland;
+  cairo_surface_t *cairo_surface;
+  GSList *l;
+
+  for (l = self->cached_buffers; l; l = l->next)
+    {
+      cairo_surface = l->data;
+
+      if (cairo_image_surface_get_width (cairo_surface) == width &&
+          cairo_image_surface_get_height (cairo_surface) == height)
+        {
+          self->cached_buffers = g_slist_delete_link (self->cached_buffers, l);
+          self->busy_buffers = g_slist_prepend (self->busy_buffers, cairo_surface);
+          return cairo_surface;
+        }
+    }
+
+  /* The sizes don't match, the cached ones are of no use anymore */
+  g_slist_free_full (self->cached_buffers, (GDestroyNotify) cairo_surface_destroy);
+  self->cached_buffers = NULL;
+
+  display_wayland = GDK_WAYLAND_DISPLAY (gdk_surface_get_display (GDK_SUBSURFACE (self)->parent));
+  cairo_surface = _gdk_wayland_display_create_shm_surface (display_wayland, width, height, 1);
+  cairo_surface_set_user_data (cairo_surface, &gdk_wayland_subsurface_key, self, NULL);
+  wl_buffer_add_listener (_gdk_wayland_shm_surface_get_wl_buffer (cairo_surface),
+                          &buffer_listener,
+                          cairo_surface);
+
+  self->busy_buffers = g_slist_prepend (self->busy_buffers, cairo_surface);
+
+  return cairo_surface;
+}
+
+static void
+gdk_wayland_subsurface_destroy_surface (GdkWaylandSubsurface *self)
+{
+  g_clear_pointer (&self->viewport, wp_viewport_destroy);
+  g_clear_pointer (&self->wl_subsurface, wl_subsurface_destroy);
+  g_clear_pointer (&self->wl_surface, wl_surface_destroy);
+  self->parent_wl_surface = NULL;
+  g_clear_object (&self->texture);
+  self->attached = FALSE;
+}
+
+static gboolean
+gdk_wayland_subsurface_ensure_surface (GdkWaylandSubsurface *self)
+{
+  GdkSurface *parent = GDK_SUBSURFACE (self)->parent;
+  GdkWaylandDisplay *display_wayland = GDK_WAYLAND_DISPLAY (gdk_surface_get_display (parent));
+  struct wl_surface *parent_wl_surface;
+  struct wl_region *region;
+
+  parent_wl_surface = gdk_wayland_surface_get_wl_surface (parent);
+  if (parent_wl_surface == NULL)
+    return FALSE;
+
+  if (self->wl_surface && self->parent_wl_surface == parent_wl_surface)
+    return TRUE;
+
+  gdk_wayland_subsurface_destroy_surface (self);
+
+  self->wl_surface = wl_compositor_create_surface (display_wayland->compositor);
+  self->wl_subsurface = wl_subcompositor_get_subsurface (display_wayland->subcompositor,
+                                                         self->wl_surface,
+                                                         parent_wl_surface);
+  self->viewport = wp_viewporter_get_viewport (display_wayland->viewporter, self->wl_surface);
+  self->parent_wl_surface = parent_wl_surface;
+
+  wl_subsurface_place_above (self->wl_subsurface, parent_wl_surface);
+
+  /* Input goes to the parent, like for the content we replace */
+  region = wl_compositor_create_region (display_wayland->compositor);
+  wl_surface_set_input_region (self->wl_surface, region);
+  wl_region_destroy (region);
+
+  return TRUE;
+}
+
+static gboolean
+gdk_wayland_subsurface_attach (GdkSubsurface         *subsurface,
+                               GdkTexture            *texture,
+                               const graphene_rect_t *rect)
+{
+  GdkWaylandSubsurface *self = GDK_WAYLAND_SUBSURFACE (subsurface);
+  GdkWaylandDisplay *display_wayland = GDK_WAYLAND_DISPLAY (gdk_surface_get_display (subsurface->parent));
+  cairo_rectangle_int_t dest;
+  cairo_surface_t *buffer;
+  int width, height;
+
+  dest.x = rect->origin.x;
+  dest.y = rect->origin.y;
+  dest.width = rect->size.width;
+  dest.height = rect->size.height;
+
+  /* The protocol only takes integer positions and sizes */
+  if (dest.x != rect->origin.x || dest.y != rect->origin.y ||
+      dest.width != rect->size.width || dest.height != rect->size.height ||
+      dest.width <= 0 || dest.height <= 0)
+    return FALSE;
+
+  if (!gdk_wayland_subsurface_ensure_surface (self))
+    return FALSE;
+
+  if (self->attached && self->texture == texture &&
+      self->dest.x == dest.x && self->dest.y == dest.y &&
+      self->dest.width == dest.width && self->dest.height == dest.height)
+    return TRUE;
+
+  if (self->texture != texture || !self->attached)
+    {
+      width = gdk_texture_get_width (texture);
+      height = gdk_texture_get_height (texture);
+
+      buffer = gdk_wayland_subsurface_get_buffer (self, width, height);
+      cairo_surface_flush (buffer);
+      gdk_texture_download (texture,
+                            cairo_image_surface_get_data (buffer),
+                            cairo_image_surface_get_stride (buffer));
+      cairo_surface_mark_dirty (buffer);
+
+      wl_surface_attach (self->wl_surface, _gdk_wayland_shm_surface_get_wl_buffer (buffer), 0, 0);
+      if (display_wayland->compositor_version >= WL_SURFACE_HAS_BUFFER_DAMAGE)
+        wl_surface_damage_buffer (self->wl_surface, 0, 0, width, height);
+      else
+        wl_surface_damage (self->wl_surface, 0, 0, dest.width, dest.height);
+    }
+
+  wl_subsurface_set_position (self->wl_subsurface, dest.x, dest.y);
+  wp_viewport_set_destination (self->viewport, dest.width, dest.height);
+
+  /* The subsurface is in synchronized mode, this only takes
+   * effect when the parent commits its next frame */
+  wl_surface_commit (self->wl_surface);
+
+  g_set_object (&self->texture, texture);
+  self->dest = dest;
+  self->attached = TRUE;
+
+  return TRUE;
+}
+
+static void
+gdk_wayland_subsurface_detach (GdkSubsurface *subsurface)
+{
+  GdkWaylandSubsurface *self = GDK_WAYLAND_SUBSURFACE (subsurface);
+
+  if (!self->attached)
+    return;
+
+  if (self->parent_wl_surface == gdk_wayland_surface_get_wl_surface (subsurface->parent))
+    {
+      wl_surface_attach (self->wl_surface, NULL, 0, 0);
+      wl_surface_commit (self->wl_surface);
+    }
+
+  g_clear_object (&self->texture);
+  self->attached = FALSE;
+}
+
+static void
+forget_buffer (gpointer data)
+{
+  cairo_surface_t *cairo_surface = data;
+
+  /* buffer_release() frees it */
+  cairo_surface_set_user_data (cairo_surface, &gdk_wayland_subsurface_key, NULL, NULL);
+}
+
+static void
+gdk_wayland_subsurface_finalize (GObject *object)
+{
+  GdkWaylandSubsurface *self = GDK_WAYLAND_SUBSURFACE (object);
+
+  gdk_wayland_subsurface_destroy_surface (self);
+
+  g_slist_free_full (self->cached_buffers, (GDestroyNotify) cairo_surface_destroy);
+  g_slist_free_full (self->busy_buffers, forget_buffer);
+
+  G_OBJECT_CLASS (gdk_wayland_subsurface_parent_class)->finalize (object);
+}
+
+static void
+gdk_wayland_subsurface_class_init (GdkWaylandSubsurfaceClass *klass)
+{
+  GObjectClass *object_class = G_OBJECT_CLASS (klass);
+  GdkSubsurfaceClass *subsurface_class = GDK_SUBSURFACE_CLASS (klass);
+
+  object_class->finalize = gdk_wayland_subsurface_finalize;
+
+  subsurface_class->attach = gdk_wayland_subsurface_attach;
+  subsurface_class->detach = gdk_wayland_subsurface_detach;
+}
+
+static void
+gdk_wayland_subsurface_init (GdkWaylandSubsurface *self)
+{
+}
+
+GdkSubsurface *
+_gdk_wayland_surface_create_subsurface (GdkSurface *surface)
+{
+  GdkWaylandDisplay *display_wayland = GDK_WAYLAND_DISPLAY (gdk_surface_get_display (surface));
+
+  if (display_wayland->subcompositor == NULL ||
+      display_wayland->viewporter == NULL)
+    return NULL;
+
+  return g_object_new (GDK_TYPE_WAYLAND_SUBSURFACE, NULL);
+}
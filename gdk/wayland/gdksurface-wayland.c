@@ -39,6 +39,7 @@
 #include <stdio.h>
 #include <string.h>
 #include <errno.h>
+#include <time.h>
 
 enum {
   COMMITTED,
@@ -121,6 +122,9 @@ struct _GdkSurfaceImplWayland
     struct wl_egl_window *dummy_egl_window;
     struct zxdg_exported_v1 *xdg_exported;
     struct org_kde_kwin_server_decoration *server_decoration;
+
+    /* GdkWaylandPresentationFeedback, for frames not presented yet */
+    GList *presentation_feedbacks;
   } display_server;
 
   EGLSurface egl_surface;
@@ -373,6 +377,145 @@ fill_presentation_time_from_frame_time (GdkFrameTimings *timings,
     }
 }
 
+static gint64
+get_refresh_interval (GdkSurface *surface)
+{
+  GdkSurfaceImplWayland *impl = GDK_SURFACE_IMPL_WAYLAND (surface->impl);
+  GdkWaylandDisplay *display_wayland =
+    GDK_WAYLAND_DISPLAY (gdk_surface_get_display (surface));
+
+  if (impl->display_server.outputs)
+    {
+      /* We pick a random output out of the outputs that the surface touches
+       * The rate here is in milli-hertz */
+      int refresh_rate =
+        gdk_wayland_display_get_output_refresh_rate (display_wayland,
+                                                     impl->display_server.outputs->data);
+      if (refresh_rate != 0)
+        return G_GINT64_CONSTANT(1000000000) / refresh_rate;
+    }
+
+  return 16667; /* default to 1/60th of a second */
+}
+
+typedef struct
+{
+  GdkSurface *surface;
+  struct wp_presentation_feedback *feedback;
+  gint64 frame_counter;
+} GdkWaylandPresentationFeedback;
+
+static GdkWaylandPresentationFeedback *
+find_presentation_feedback (GdkSurface *surface,
+                            gint64      frame_counter)
+{
+  GdkSurfaceImplWayland *impl = GDK_SURFACE_IMPL_WAYLAND (surface->impl);
+  GList *l;
+
+  for (l = impl->display_server.presentation_feedbacks; l; l = l->next)
+    {
+      GdkWaylandPresentationFeedback *presentation_feedback = l->data;
+
+      if (presentation_feedback->frame_counter == frame_counter)
+        return presentation_feedback;
+    }
+
+  return NULL;
+}
+
+static void
+presentation_feedback_free (GdkWaylandPresentationFeedback *presentation_feedback)
+{
+  GdkSurfaceImplWayland *impl = GDK_SURFACE_IMPL_WAYLAND (presentation_feedback->surface->impl);
+
+  impl->display_server.presentation_feedbacks =
+    g_list_remove (impl->display_server.presentation_feedbacks, presentation_feedback);
+
+  wp_presentation_feedback_destroy (presentation_feedback->feedback);
+  g_slice_free (GdkWaylandPresentationFeedback, presentation_feedback);
+}
+
+static void
+presentation_feedback_complete (GdkWaylandPresentationFeedback *presentation_feedback)
+{
+  GdkSurface *surface = presentation_feedback->surface;
+  GdkFrameClock *clock = gdk_surface_get_frame_clock (surface);
+  GdkFrameTimings *timings;
+
+  timings = gdk_frame_clock_get_timings (clock, presentation_feedback->frame_counter);
+  if (timings)
+    {
+      if (timings->refresh_interval == 0)
+        timings->refresh_interval = get_refresh_interval (surface);
+
+      timings->complete = TRUE;
+
+#ifdef G_ENABLE_DEBUG
+      if ((_gdk_debug_flags & GDK_DEBUG_FRAMES) != 0)
+        _gdk_frame_clock_debug_print_timings (clock, timings);
+#endif
+    }
+
+  presentation_feedback_free (presentation_feedback);
+}
+
+static void
+presentation_feedback_sync_output (void                            *data,
+                                   struct wp_presentation_feedback *feedback,
+                                   struct wl_output                *output)
+{
+}
+
+static void
+presentation_feedback_presented (void                            *data,
+                                 struct wp_presentation_feedback *feedback,
+                                 uint32_t                         tv_sec_hi,
+                                 uint32_t                         tv_sec_lo,
+                                 uint32_t                         tv_nsec,
+                                 uint32_t                         refresh,
+                                 uint32_t                         seq_hi,
+                                 uint32_t                         seq_lo,
+                                 uint32_t                         flags)
+{
+  GdkWaylandPresentationFeedback *presentation_feedback = data;
+  GdkSurface *surface = presentation_feedback->surface;
+  GdkWaylandDisplay *display_wayland =
+    GDK_WAYLAND_DISPLAY (gdk_surface_get_display (surface));
+  GdkFrameClock *clock = gdk_surface_get_frame_clock (surface);
+  GdkFrameTimings *timings;
+
+  GDK_DISPLAY_NOTE (GDK_DISPLAY (display_wayland), EVENTS, g_message ("presented %p", surface));
+
+  timings = gdk_frame_clock_get_timings (clock, presentation_feedback->frame_counter);
+  if (timings)
+    {
+      /* The frame clock works with g_get_monotonic_time(), so the
+       * timestamp is only useful if it's in the same clock domain.
+       */
+      if (display_wayland->presentation_clock_id == CLOCK_MONOTONIC)
+        timings->presentation_time =
+          (((gint64) tv_sec_hi << 32) + tv_sec_lo) * G_USEC_PER_SEC + tv_nsec / 1000;
+
+      if (refresh != 0)
+        timings->refresh_interval = refresh / 1000;
+    }
+
+  presentation_feedback_complete (presentation_feedback);
+}
+
+static void
+presentation_feedback_discarded (void                            *data,
+                                 struct wp_presentation_feedback *feedback)
+{
+  presentation_feedback_complete (data);
+}
+
+static const struct wp_presentation_feedback_listener presentation_feedback_listener = {
+  presentation_feedback_sync_output,
+  presentation_feedback_presented,
+  presentation_feedback_discarded
+};
+
 static void
 frame_callback (void               *data,
                 struct wl_callback *callback,
@@ -384,6 +527,7 @@ frame_callback (void               *data,
     GDK_WAYLAND_DISPLAY (gdk_surface_get_display (surface));
   GdkFrameClock *clock = gdk_surface_get_frame_clock (surface);
   GdkFrameTimings *timings;
+  gint64 frame_counter;
 
   GDK_DISPLAY_NOTE (GDK_DISPLAY (display_wayland), EVENTS, g_message ("frame %p", surface));
 
@@ -398,23 +542,20 @@ frame_callback (void               *data,
   impl->awaiting_frame = FALSE;
   _gdk_frame_clock_thaw (clock);
 
-  timings = gdk_frame_clock_get_timings (clock, impl->pending_frame_counter);
+  frame_counter = impl->pending_frame_counter;
+  timings = gdk_frame_clock_get_timings (clock, frame_counter);
   impl->pending_frame_counter = 0;
 
-  if (timings == NULL)
+  if (timings == NULL || timings->complete)
     return;
 
-  timings->refresh_interval = 16667; /* default to 1/60th of a second */
-  if (impl->display_server.outputs)
-    {
-      /* We pick a random output out of the outputs that the surface touches
-       * The rate here is in milli-hertz */
-      int refresh_rate =
-        gdk_wayland_display_get_output_refresh_rate (display_wayland,
-                                                     impl->display_server.outputs->data);
-      if (refresh_rate != 0)
-        timings->refresh_interval = G_GINT64_CONSTANT(1000000000) / refresh_rate;
-    }
+  timings->refresh_interval = get_refresh_interval (surface);
+
+  /* With presentation feedback, the timings get completed with the
+   * real presentation time once the compositor reports it.
+   */
+  if (find_presentation_feedback (surface, frame_counter))
+    return;
 
   fill_presentation_time_from_frame_time (timings, time);
 
@@ -467,6 +608,8 @@ void
 gdk_wayland_surface_request_frame (GdkSurface *surface)
 {
   GdkSurfaceImplWayland *impl = GDK_SURFACE_IMPL_WAYLAND (surface->impl);
+  GdkWaylandDisplay *display_wayland =
+    GDK_WAYLAND_DISPLAY (gdk_surface_get_display (surface));
   struct wl_callback *callback;
   GdkFrameClock *clock;
 
@@ -479,6 +622,24 @@ gdk_wayland_surface_request_frame (GdkSurface *surface)
   wl_callback_add_listener (callback, &frame_listener, surface);
   impl->pending_frame_counter = gdk_frame_clock_get_frame_counter (clock);
   impl->awaiting_frame = TRUE;
+
+  if (display_wayland->presentation)
+    {
+      GdkWaylandPresentationFeedback *presentation_feedback;
+
+      presentation_feedback = g_slice_new (GdkWaylandPresentationFeedback);
+      presentation_feedback->surface = surface;
+      presentation_feedback->frame_counter = impl->pending_frame_counter;
+      presentation_feedback->feedback =
+        wp_presentation_feedback (display_wayland->presentation,
+                                  impl->display_server.wl_surface);
+      wp_presentation_feedback_add_listener (presentation_feedback->feedback,
+                                             &presentation_feedback_listener,
+                                             presentation_feedback);
+
+      impl->display_server.presentation_feedbacks =
+        g_list_prepend (impl->display_server.presentation_feedbacks, presentation_feedback);
+    }
 }
 
 static void
@@ -638,7 +799,12 @@ gdk_wayland_surface_attach_image (GdkSurface           *surface,
   for (i = 0; i < n; i++)
     {
       cairo_region_get_rectangle (damage, i, &rect);
-      wl_surface_damage (impl->display_server.wl_surface, rect.x, rect.y, rect.width, rect.height);
+      if (display->compositor_version >= WL_SURFACE_HAS_BUFFER_DAMAGE)
+        wl_surface_damage_buffer (impl->display_server.wl_surface,
+                                  rect.x * impl->scale, rect.y * impl->scale,
+                                  rect.width * impl->scale, rect.height * impl->scale);
+      else
+        wl_surface_damage (impl->display_server.wl_surface, rect.x, rect.y, rect.width, rect.height);
     }
   impl->pending_commit = TRUE;
 }
@@ -2627,6 +2793,9 @@ gdk_wayland_surface_hide_surface (GdkSurface *surface)
             _gdk_frame_clock_thaw (frame_clock);
         }
 
+      while (impl->display_server.presentation_feedbacks)
+        presentation_feedback_free (impl->display_server.presentation_feedbacks->data);
+
       if (impl->display_server.gtk_surface)
         {
           gtk_surface1_destroy (impl->display_server.gtk_surface);
@@ -3890,6 +4059,7 @@ _gdk_surface_impl_wayland_class_init (GdkSurfaceImplWaylandClass *klass)
   impl_class->show_window_menu = gdk_wayland_surface_show_window_menu;
   impl_class->create_gl_context = gdk_wayland_surface_create_gl_context;
   impl_class->supports_edge_constraints = gdk_wayland_surface_supports_edge_constraints;
+  impl_class->create_subsurface = _gdk_wayland_surface_create_subsurface;
 
   signals[COMMITTED] = g_signal_new (g_intern_static_string ("committed"),
                                      G_TYPE_FROM_CLASS (object_class),
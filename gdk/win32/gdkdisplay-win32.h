@@ -89,6 +89,7 @@ struct _GdkWin32Display
   guint hasWglOMLSyncControl : 1;
   guint hasWglARBPixelFormat : 1;
   guint hasWglARBmultisample : 1;
+  guint hasWglNVDXInterop : 1;
 
   /* HiDPI Items */
   guint have_at_least_win81 : 1;
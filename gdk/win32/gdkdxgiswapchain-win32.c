@@ -0,0 +1,352 @@
+/* GDK - The GIMP Drawing Kit
+ *
+ * gdkdxgiswapchain-win32.c: DXGI flip model presentation for WGL
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Library General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Library General Public License for more details.
+ *
+ * You should have received a copy of the GNU Library General Public
+ * License along with this library. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/*
+ * Presenting with SwapBuffers() makes DWM copy the redirected window
+ * contents, and always presents the whole window.  With a DXGI flip
+ * model swap chain DWM uses our buffers directly, and Present1() can
+ * tell it which parts changed.
+ *
+ * GSK keeps rendering into the back buffer of the window, which is
+ * never swapped and so keeps its contents.  At the end of the frame
+ * the damaged area is blitted into the back buffer of the swap chain,
+ * which is shared with GL through WGL_NV_DX_interop.
+ */
+
+#define COBJMACROS
+
+#include "config.h"
+
+#include "gdkdxgiswapchain-win32.h"
+
+#include "gdkinternals.h"
+
+#include <d3d11.h>
+#include <dxgi1_2.h>
+#include <epoxy/gl.h>
+#include <epoxy/wgl.h>
+
+struct _GdkWin32DxgiSwapChain
+{
+  ID3D11Device *device;
+  IDXGISwapChain1 *swap_chain;
+  ID3D11Texture2D *buffer;
+
+  HANDLE gl_device;
+  HANDLE gl_buffer;
+  GLuint renderbuffer;
+  GLuint framebuffer;
+
+  int width;
+  int height;
+
+  /* The flip model rotates between two buffers, so the back buffer
+   * misses what was painted for the previous frame. NULL if it is
+   * not valid at all. In pixels. */
+  cairo_region_t *previous_painted;
+};
+
+static gboolean
+attach_buffer (GdkWin32DxgiSwapChain *chain)
+{
+  HRESULT hr;
+
+  hr = IDXGISwapChain1_GetBuffer (chain->swap_chain, 0, &IID_ID3D11Texture2D,
+                                  (void **) &chain->buffer);
+  if (FAILED (hr))
+    {
+      GDK_NOTE (OPENGL, g_print ("Getting the DXGI back buffer failed: 0x%lx\n", hr));
+      return FALSE;
+    }
+
+  chain->gl_buffer = wglDXRegisterObjectNV (chain->gl_device,
+                                            chain->buffer,
+                                            chain->renderbuffer,
+                                            GL_RENDERBUFFER,
+                                            WGL_ACCESS_WRITE_DISCARD_NV);
+  if (chain->gl_buffer == NULL)
+    {
+      GDK_NOTE (OPENGL, g_print ("Registering the DXGI back buffer with GL failed\n"));
+      ID3D11Texture2D_Release (chain->buffer);
+      chain->buffer = NULL;
+      return FALSE;
+    }
+
+  glBindFramebuffer (GL_FRAMEBUFFER, chain->framebuffer);
+  glFramebufferRenderbuffer (GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0,
+                             GL_RENDERBUFFER, chain->renderbuffer);
+  glBindFramebuffer (GL_FRAMEBUFFER, 0);
+
+  return TRUE;
+}
+
+static void
+detach_buffer (GdkWin32DxgiSwapChain *chain)
+{
+  if (chain->gl_buffer != NULL)
+    {
+      wglDXUnregisterObjectNV (chain->gl_device, chain->gl_buffer);
+      chain->gl_buffer = NULL;
+    }
+
+  if (chain->buffer != NULL)
+    {
+      ID3D11Texture2D_Release (chain->buffer);
+      chain->buffer = NULL;
+    }
+
+  g_clear_pointer (&chain->previous_painted, cairo_region_destroy);
+}
+
+GdkWin32DxgiSwapChain *
+_gdk_win32_dxgi_swap_chain_new (HWND hwnd,
+                                int  width,
+                                int  height)
+{
+  GdkWin32DxgiSwapChain *chain;
+  DXGI_SWAP_CHAIN_DESC1 desc = { 0 };
+  IDXGIDevice *dxgi_device;
+  IDXGIAdapter *adapter;
+  IDXGIFactory2 *factory;
+  HRESULT hr;
+
+  chain = g_new0 (GdkWin32DxgiSwapChain, 1);
+  chain->width = width;
+  chain->height = height;
+
+  hr = D3D11CreateDevice (NULL, D3D_DRIVER_TYPE_HARDWARE, NULL,
+                          D3D11_CREATE_DEVICE_BGRA_SUPPORT,
+                          NULL, 0, D3D11_SDK_VERSION,
+                          &chain->device, NULL, NULL);
+  if (FAILED (hr))
+    {
+      GDK_NOTE (OPENGL, g_print ("Creating a D3D11 device failed: 0x%lx\n", hr));
+      goto fail;
+    }
+
+  hr = ID3D11Device_QueryInterface (chain->device, &IID_IDXGIDevice, (void **) &dxgi_device);
+  if (FAILED (hr))
+    goto fail;
+
+  hr = IDXGIDevice_GetAdapter (dxgi_device, &adapter);
+  IDXGIDevice_Release (dxgi_device);
+  if (FAILED (hr))
+    goto fail;
+
+  /* Flip model needs DXGI 1.2, i.e. Windows 8 */
+  hr = IDXGIAdapter_GetParent (adapter, &IID_IDXGIFactory2, (void **) &factory);
+  IDXGIAdapter_Release (adapter);
+  if (FAILED (hr))
+    {
+      GDK_NOTE (OPENGL, g_print ("DXGI 1.2 is not available\n"));
+      goto fail;
+    }
+
+  desc.Width = width;
+  desc.Height = height;
+  desc.Format = DXGI_FORMAT_B8G8R8A8_UNORM;
+  desc.SampleDesc.Count = 1;
+  desc.BufferUsage = DXGI_USAGE_RENDER_TARGET_OUTPUT;
+  desc.BufferCount = 2;
+  desc.Scaling = DXGI_SCALING_NONE;
+  desc.SwapEffect = DXGI_SWAP_EFFECT_FLIP_SEQUENTIAL;
+  desc.AlphaMode = DXGI_ALPHA_MODE_IGNORE;
+
+  hr = IDXGIFactory2_CreateSwapChainForHwnd (factory, (IUnknown *) chain->device,
+                                             hwnd, &desc, NULL, NULL,
+                                             &chain->swap_chain);
+  if (SUCCEEDED (hr))
+    IDXGIFactory2_MakeWindowAssociation (factory, hwnd, DXGI_MWA_NO_ALT_ENTER);
+  IDXGIFactory2_Release (factory);
+  if (FAILED (hr))
+    {
+      GDK_NOTE (OPENGL, g_print ("Creating a DXGI swap chain failed: 0x%lx\n", hr));
+      goto fail;
+    }
+
+  chain->gl_device = wglDXOpenDeviceNV (chain->device);
+  if (chain->gl_device == NULL)
+    {
+      GDK_NOTE (OPENGL, g_print ("Opening the D3D11 device in GL failed\n"));
+      goto fail;
+    }
+
+  glGenRenderbuffers (1, &chain->renderbuffer);
+  glGenFramebuffers (1, &chain->framebuffer);
+
+  if (!attach_buffer (chain))
+    goto fail;
+
+  GDK_NOTE (OPENGL, g_print ("Presenting through a DXGI flip model swap chain\n"));
+
+  return chain;
+
+fail:
+  _gdk_win32_dxgi_swap_chain_free (chain);
+
+  return NULL;
+}
+
+void
+_gdk_win32_dxgi_swap_chain_free (GdkWin32DxgiSwapChain *chain)
+{
+  detach_buffer (chain);
+
+  if (chain->framebuffer != 0)
+    glDeleteFramebuffers (1, &chain->framebuffer);
+  if (chain->renderbuffer != 0)
+    glDeleteRenderbuffers (1, &chain->renderbuffer);
+
+  if (chain->gl_device != NULL)
+    wglDXCloseDeviceNV (chain->gl_device);
+
+  if (chain->swap_chain != NULL)
+    IDXGISwapChain1_Release (chain->swap_chain);
+  if (chain->device != NULL)
+    ID3D11Device_Release (chain->device);
+
+  g_free (chain);
+}
+
+/* Returns TRUE if the window back buffer must be fully repainted */
+gboolean
+_gdk_win32_dxgi_swap_chain_begin_frame (GdkWin32DxgiSwapChain *chain,
+                                        int                    width,
+                                        int                    height)
+{
+  HRESULT hr;
+
+  if (chain->width == width && chain->height == height)
+    return chain->previous_painted == NULL;
+
+  detach_buffer (chain);
+
+  hr = IDXGISwapChain1_ResizeBuffers (chain->swap_chain, 0, width, height,
+                                      DXGI_FORMAT_UNKNOWN, 0);
+  if (FAILED (hr))
+    GDK_NOTE (OPENGL, g_print ("Resizing the DXGI swap chain failed: 0x%lx\n", hr));
+
+  chain->width = width;
+  chain->height = height;
+
+  attach_buffer (chain);
+
+  return TRUE;
+}
+
+void
+_gdk_win32_dxgi_swap_chain_present (GdkWin32DxgiSwapChain *chain,
+                                    const cairo_region_t  *painted,
+                                    int                    scale,
+                                    gboolean               sync)
+{
+  DXGI_PRESENT_PARAMETERS params = { 0 };
+  cairo_region_t *damage, *blit;
+  cairo_rectangle_int_t rect;
+  RECT *dirty_rects;
+  gboolean scissor;
+  int i, n_rects;
+
+  if (chain->gl_buffer == NULL)
+    return;
+
+  /* The region in pixels, from the top */
+  damage = cairo_region_create ();
+  n_rects = cairo_region_num_rectangles (painted);
+  for (i = 0; i < n_rects; i++)
+    {
+      cairo_region_get_rectangle (painted, i, &rect);
+      rect.x *= scale;
+      rect.y *= scale;
+      rect.width *= scale;
+      rect.height *= scale;
+      cairo_region_union_rectangle (damage, &rect);
+    }
+  cairo_region_intersect_rectangle (damage, &(cairo_rectangle_int_t) { 0, 0, chain->width, chain->height });
+
+  if (chain->previous_painted != NULL)
+    {
+      blit = cairo_region_copy (chain->previous_painted);
+      cairo_region_union (blit, damage);
+    }
+  else
+    blit = cairo_region_create_rectangle (&(cairo_rectangle_int_t) { 0, 0, chain->width, chain->height });
+
+  if (!wglDXLockObjectsNV (chain->gl_device, 1, &chain->gl_buffer))
+    {
+      cairo_region_destroy (damage);
+      cairo_region_destroy (blit);
+      return;
+    }
+
+  scissor = glIsEnabled (GL_SCISSOR_TEST);
+  glDisable (GL_SCISSOR_TEST);
+
+  glBindFramebuffer (GL_READ_FRAMEBUFFER, 0);
+  glReadBuffer (GL_BACK);
+  glBindFramebuffer (GL_DRAW_FRAMEBUFFER, chain->framebuffer);
+
+  /* GL sees the D3D texture upside down, so flip while copying */
+  n_rects = cairo_region_num_rectangles (blit);
+  for (i = 0; i < n_rects; i++)
+    {
+      cairo_region_get_rectangle (blit, i, &rect);
+      glBlitFramebuffer (rect.x, chain->height - rect.y - rect.height,
+                         rect.x + rect.width, chain->height - rect.y,
+                         rect.x, rect.y + rect.height,
+                         rect.x + rect.width, rect.y,
+                         GL_COLOR_BUFFER_BIT, GL_NEAREST);
+    }
+
+  glBindFramebuffer (GL_FRAMEBUFFER, 0);
+  if (scissor)
+    glEnable (GL_SCISSOR_TEST);
+
+  wglDXUnlockObjectsNV (chain->gl_device, 1, &chain->gl_buffer);
+
+  /* The first present of a buffer must be complete */
+  dirty_rects = NULL;
+  if (chain->previous_painted != NULL)
+    {
+      n_rects = cairo_region_num_rectangles (damage);
+      dirty_rects = g_new (RECT, MAX (n_rects, 1));
+      for (i = 0; i < n_rects; i++)
+        {
+          cairo_region_get_rectangle (damage, i, &rect);
+          dirty_rects[i].left = rect.x;
+          dirty_rects[i].top = rect.y;
+          dirty_rects[i].right = rect.x + rect.width;
+          dirty_rects[i].bottom = rect.y + rect.height;
+        }
+      /* No dirty rects means everything changed */
+      if (n_rects == 0)
+        {
+          dirty_rects[0] = (RECT) { 0, 0, 1, 1 };
+          n_rects = 1;
+        }
+      params.DirtyRectsCount = n_rects;
+      params.pDirtyRects = dirty_rects;
+    }
+
+  IDXGISwapChain1_Present1 (chain->swap_chain, sync ? 1 : 0, 0, &params);
+
+  g_free (dirty_rects);
+  cairo_region_destroy (blit);
+  g_clear_pointer (&chain->previous_painted, cairo_region_destroy);
+  chain->previous_painted = damage;
+}
@@ -0,0 +1,45 @@
+/* GDK - The GIMP Drawing Kit
+ *
+ * gdkdxgiswapchain-win32.h: DXGI flip model presentation for WGL
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Library General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Library General Public License for more details.
+ *
+ * You should have received a copy of the GNU Library General Public
+ * License along with this library. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef __GDK_DXGI_SWAP_CHAIN_WIN32_H__
+#define __GDK_DXGI_SWAP_CHAIN_WIN32_H__
+
+#include <windows.h>
+#include <cairo.h>
+#include <glib.h>
+
+G_BEGIN_DECLS
+
+typedef struct _GdkWin32DxgiSwapChain GdkWin32DxgiSwapChain;
+
+/* All of these must be called with the GL context current */
+GdkWin32DxgiSwapChain * _gdk_win32_dxgi_swap_chain_new         (HWND                   hwnd,
+                                                                int                    width,
+                                                                int                    height);
+void                    _gdk_win32_dxgi_swap_chain_free        (GdkWin32DxgiSwapChain *chain);
+gboolean                _gdk_win32_dxgi_swap_chain_begin_frame (GdkWin32DxgiSwapChain *chain,
+                                                                int                    width,
+                                                                int                    height);
+void                    _gdk_win32_dxgi_swap_chain_present     (GdkWin32DxgiSwapChain *chain,
+                                                                const cairo_region_t  *painted,
+                                                                int                    scale,
+                                                                gboolean               sync);
+
+G_END_DECLS
+
+#endif /* __GDK_DXGI_SWAP_CHAIN_WIN32_H__ */
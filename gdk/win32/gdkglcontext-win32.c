@@ -53,6 +53,12 @@ _gdk_win32_gl_context_dispose (GObject *gobject)
 
   if (context_win32->hglrc != NULL)
     {
+      if (context_win32->swap_chain != NULL)
+        {
+          wglMakeCurrent (context_win32->gl_hdc, context_win32->hglrc);
+          g_clear_pointer (&context_win32->swap_chain, _gdk_win32_dxgi_swap_chain_free);
+        }
+
       if (wglGetCurrentContext () == context_win32->hglrc)
         wglMakeCurrent (NULL, NULL);
 
@@ -117,6 +123,15 @@ gdk_win32_gl_context_end_frame (GdkDrawContext *draw_context,
 
   gdk_gl_context_make_current (context);
 
+  if (context_win32->swap_chain != NULL)
+    {
+      _gdk_win32_dxgi_swap_chain_present (context_win32->swap_chain,
+                                          painted,
+                                          gdk_surface_get_scale_factor (surface),
+                                          context_win32->do_frame_sync);
+      return;
+    }
+
   if (context_win32->do_frame_sync)
     {
       if (context_win32->do_frame_sync)
@@ -165,18 +180,45 @@ gdk_win32_gl_context_begin_frame (GdkDrawContext *draw_context,
                                   cairo_region_t *update_area)
 {
   GdkGLContext *context = GDK_GL_CONTEXT (draw_context);
+  GdkWin32GLContext *context_win32 = GDK_WIN32_GL_CONTEXT (context);
+  GdkWin32Display *display = GDK_WIN32_DISPLAY (gdk_gl_context_get_display (context));
   GdkSurface *surface;
+  int scale, width, height;
 
   GDK_DRAW_CONTEXT_CLASS (gdk_win32_gl_context_parent_class)->begin_frame (draw_context, update_area);
   if (gdk_gl_context_get_shared_context (context))
     return;
 
-  if (gdk_gl_context_has_framebuffer_blit (context))
+  surface = gdk_gl_context_get_surface (context);
+  scale = gdk_surface_get_scale_factor (surface);
+  width = gdk_surface_get_width (surface) * scale;
+  height = gdk_surface_get_height (surface) * scale;
+
+  if (context_win32->swap_chain == NULL &&
+      !context_win32->swap_chain_failed &&
+      display->hasWglNVDXInterop &&
+      context_win32->is_attached &&
+      g_getenv ("GDK_WIN32_NO_DXGI") == NULL)
+    {
+      gdk_gl_context_make_current (context);
+      context_win32->swap_chain = _gdk_win32_dxgi_swap_chain_new (GDK_SURFACE_HWND (surface),
+                                                                  width, height);
+      if (context_win32->swap_chain == NULL)
+        context_win32->swap_chain_failed = TRUE;
+    }
+
+  if (context_win32->swap_chain != NULL)
+    {
+      /* The window back buffer is never swapped, so it keeps its contents */
+      gdk_gl_context_make_current (context);
+      if (!_gdk_win32_dxgi_swap_chain_begin_frame (context_win32->swap_chain, width, height))
+        return;
+    }
+  else if (gdk_gl_context_has_framebuffer_blit (context))
     return;
 
   /* If nothing else is known, repaint everything so that the back
      buffer is fully up-to-date for the swapbuffer */
-  surface = gdk_gl_context_get_surface (context);
   cairo_region_union_rectangle (update_area, &(GdkRectangle) {
                                                  0, 0,
                                                  gdk_surface_get_width (surface),
@@ -429,6 +471,8 @@ _gdk_win32_display_init_gl (GdkDisplay *display)
     epoxy_has_wgl_extension (dummy.hdc, "WGL_ARB_pixel_format");
   display_win32->hasWglARBmultisample =
     epoxy_has_wgl_extension (dummy.hdc, "WGL_ARB_multisample");
+  display_win32->hasWglNVDXInterop =
+    epoxy_has_wgl_extension (dummy.hdc, "WGL_NV_DX_interop");
 
   GDK_NOTE (OPENGL,
             g_print ("WGL API version %d.%d found\n"
@@ -438,7 +482,8 @@ _gdk_win32_display_init_gl (GdkDisplay *display)
                      "\t* WGL_ARB_create_context: %s\n"
                      "\t* WGL_EXT_swap_control: %s\n"
                      "\t* WGL_OML_sync_control: %s\n"
-                     "\t* WGL_ARB_multisample: %s\n",
+                     "\t* WGL_ARB_multisample: %s\n"
+                     "\t* WGL_NV_DX_interop: %s\n",
                      display_win32->gl_version / 10,
                      display_win32->gl_version % 10,
                      glGetString (GL_VENDOR),
@@ -446,7 +491,8 @@ _gdk_win32_display_init_gl (GdkDisplay *display)
                      display_win32->hasWglARBCreateContext ? "yes" : "no",
                      display_win32->hasWglEXTSwapControl ? "yes" : "no",
                      display_win32->hasWglOMLSyncControl ? "yes" : "no",
-                     display_win32->hasWglARBmultisample ? "yes" : "no"));
+                     display_win32->hasWglARBmultisample ? "yes" : "no",
+                     display_win32->hasWglNVDXInterop ? "yes" : "no"));
 
   wglMakeCurrent (NULL, NULL);
   _destroy_dummy_gl_context (dummy);
@@ -28,6 +28,7 @@
 #include "gdkdisplayprivate.h"
 #include "gdksurface.h"
 #include "gdkinternals.h"
+#include "gdkdxgiswapchain-win32.h"
 
 G_BEGIN_DECLS
 
@@ -43,6 +44,10 @@ struct _GdkWin32GLContext
   /* other items */
   guint is_attached : 1;
   guint do_frame_sync : 1;
+  guint swap_chain_failed : 1;
+
+  /* Used instead of SwapBuffers() where available */
+  GdkWin32DxgiSwapChain *swap_chain;
 };
 
 struct _GdkWin32GLContextClass
@@ -22,6 +22,8 @@
 
 #include "gdkcairocontext-x11.h"
 
+#include "gdkdisplay-x11.h"
+
 #include "gdkprivate-x11.h"
 
 #include "gdkcairo.h"
@@ -29,8 +31,331 @@
 
 #include <X11/Xlib.h>
 
+#ifdef HAVE_XSHM
+#include <sys/ipc.h>
+#include <sys/shm.h>
+#include <X11/extensions/XShm.h>
+#endif
+
 G_DEFINE_TYPE (GdkX11CairoContext, gdk_x11_cairo_context, GDK_TYPE_CAIRO_CONTEXT)
 
+#ifdef HAVE_XSHM
+
+/* On local displays, frames are rendered on the client side into an
+ * image in shared memory, and the painted area is handed to the server
+ * with XShmPutImage(), instead of rendering with Xlib requests. Two
+ * images are used, so the next frame can be drawn while the server is
+ * still reading the previous one. The server tells us it is done with
+ * an image through a ShmCompletion event.
+ *
+ * Only the painted area is ever sent to the server, so the contents of
+ * an image outside of it don't matter and need not be kept up to date.
+ */
+struct _GdkX11ShmBuffer
+{
+  GdkDisplay *display;
+  XShmSegmentInfo shm_info;
+  XImage *ximage;
+  cairo_surface_t *surface;
+  int width;
+  int height;
+  guint busy : 1;
+};
+
+static void
+gdk_x11_shm_buffer_free (GdkX11ShmBuffer *buffer)
+{
+  GdkX11Display *display_x11 = GDK_X11_DISPLAY (buffer->display);
+
+  g_hash_table_remove (display_x11->shm_buffers, GUINT_TO_POINTER (buffer->shm_info.shmseg));
+
+  cairo_surface_destroy (buffer->surface);
+
+  XShmDetach (display_x11->xdisplay, &buffer->shm_info);
+  buffer->ximage->data = NULL;
+  XDestroyImage (buffer->ximage);
+  shmdt (buffer->shm_info.shmaddr);
+
+  g_slice_free (GdkX11ShmBuffer, buffer);
+}
+
+static GdkX11ShmBuffer *
+gdk_x11_shm_buffer_new (GdkDisplay *display,
+                        int         width,
+                        int         height,
+                        int         scale)
+{
+  GdkX11Display *display_x11 = GDK_X11_DISPLAY (display);
+  GdkX11ShmBuffer *buffer;
+  XImage *ximage;
+  Visual *visual;
+  cairo_format_t format;
+  int depth;
+
+  visual = gdk_x11_display_get_window_visual (display_x11);
+  depth = gdk_x11_display_get_window_depth (display_x11);
+
+  /* Cairo can only render into the image if the pixel layouts match */
+  if (depth == 32)
+    format = CAIRO_FORMAT_ARGB32;
+  else if (depth == 24)
+    format = CAIRO_FORMAT_RGB24;
+  else
+    return NULL;
+
+  if (visual->red_mask != 0xff0000 ||
+      visual->green_mask != 0xff00 ||
+      visual->blue_mask != 0xff)
+    return NULL;
+
+  buffer = g_slice_new0 (GdkX11ShmBuffer);
+  buffer->display = display;
+  buffer->width = width * scale;
+  buffer->height = height * scale;
+
+  ximage = XShmCreateImage (display_x11->xdisplay, visual, depth, ZPixmap, NULL,
+                            &buffer->shm_info, buffer->width, buffer->height);
+  if (ximage == NULL)
+    goto fail;
+
+  if (ximage->bits_per_pixel != 32 ||
+      ximage->byte_order != (G_BYTE_ORDER == G_LITTLE_ENDIAN ? LSBFirst : MSBFirst))
+    {
+      XDestroyImage (ximage);
+      goto fail;
+    }
+
+  buffer->shm_info.shmid = shmget (IPC_PRIVATE, ximage->bytes_per_line * ximage->height,
+                                   IPC_CREAT | 0600);
+  if (buffer->shm_info.shmid == -1)
+    {
+      XDestroyImage (ximage);
+      goto fail;
+    }
+
+  buffer->shm_info.shmaddr = shmat (buffer->shm_info.shmid, NULL, 0);
+  if (buffer->shm_info.shmaddr == (char *) -1)
+    {
+      shmctl (buffer->shm_info.shmid, IPC_RMID, NULL);
+      XDestroyImage (ximage);
+      goto fail;
+    }
+
+  buffer->shm_info.readOnly = False;
+
+  /* This fails if the server can't access our memory after all,
+   * for example when it runs in another container.
+   */
+  gdk_x11_display_error_trap_push (display);
+  XShmAttach (display_x11->xdisplay, &buffer->shm_info);
+  XSync (display_x11->xdisplay, False);
+  if (gdk_x11_display_error_trap_pop (display))
+    {
+      GDK_DISPLAY_NOTE (display, MISC, g_message ("Failed to attach MIT-SHM segment, disabling MIT-SHM"));
+
+      display_x11->have_shm = FALSE;
+      shmdt (buffer->shm_info.shmaddr);
+      shmctl (buffer->shm_info.shmid, IPC_RMID, NULL);
+      XDestroyImage (ximage);
+      goto fail;
+    }
+
+  /* The segment goes away once both we and the server detached */
+  shmctl (buffer->shm_info.shmid, IPC_RMID, NULL);
+
+  ximage->data = buffer->shm_info.shmaddr;
+  buffer->ximage = ximage;
+
+  buffer->surface = cairo_image_surface_create_for_data ((guchar *) ximage->data,
+                                                         format,
+                                                         buffer->width,
+                                                         buffer->height,
+                                                         ximage->bytes_per_line);
+  cairo_surface_set_device_scale (buffer->surface, scale, scale);
+
+  g_hash_table_insert (display_x11->shm_buffers,
+                       GUINT_TO_POINTER (buffer->shm_info.shmseg),
+                       buffer);
+
+  return buffer;
+
+fail:
+  g_slice_free (GdkX11ShmBuffer, buffer);
+  return NULL;
+}
+
+static Bool
+is_shm_completion_for_buffer (Display  *xdisplay,
+                              XEvent   *xevent,
+                              XPointer  arg)
+{
+  GdkX11ShmBuffer *buffer = (GdkX11ShmBuffer *) arg;
+  GdkX11Display *display_x11 = GDK_X11_DISPLAY (buffer->display);
+
+  return xevent->type == display_x11->shm_event_base + ShmCompletion &&
+         ((XShmCompletionEvent *) xevent)->shmseg == buffer->shm_info.shmseg;
+}
+
+static void
+gdk_x11_shm_buffer_wait (GdkX11ShmBuffer *buffer)
+{
+  XEvent xevent;
+
+  if (!buffer->busy)
+    return;
+
+  /* The completion event has not been handled yet, so it is either
+   * in the Xlib queue or still on its way.
+   */
+  XIfEvent (GDK_DISPLAY_XDISPLAY (buffer->display), &xevent,
+            is_shm_completion_for_buffer, (XPointer) buffer);
+  buffer->busy = FALSE;
+}
+
+void
+_gdk_x11_cairo_context_shm_completion (GdkDisplay   *display,
+                                       const XEvent *xevent)
+{
+  GdkX11Display *display_x11 = GDK_X11_DISPLAY (display);
+  const XShmCompletionEvent *completion = (const XShmCompletionEvent *) xevent;
+  GdkX11ShmBuffer *buffer;
+
+  buffer = g_hash_table_lookup (display_x11->shm_buffers,
+                                GUINT_TO_POINTER (completion->shmseg));
+  if (buffer)
+    buffer->busy = FALSE;
+}
+
+static void
+gdk_x11_cairo_context_clear_shm_buffers (GdkX11CairoContext *self)
+{
+  guint i;
+
+  for (i = 0; i < G_N_ELEMENTS (self->shm_buffers); i++)
+    g_clear_pointer (&self->shm_buffers[i], gdk_x11_shm_buffer_free);
+
+  if (self->shm_gc)
+    {
+      GdkDisplay *display = gdk_draw_context_get_display (GDK_DRAW_CONTEXT (self));
+
+      XFreeGC (GDK_DISPLAY_XDISPLAY (display), self->shm_gc);
+      self->shm_gc = NULL;
+    }
+}
+
+static gboolean
+gdk_x11_cairo_context_begin_shm_frame (GdkX11CairoContext *self,
+                                       cairo_region_t     *region)
+{
+  GdkDisplay *display = gdk_draw_context_get_display (GDK_DRAW_CONTEXT (self));
+  GdkSurface *surface = gdk_draw_context_get_surface (GDK_DRAW_CONTEXT (self));
+  GdkX11ShmBuffer *buffer = NULL;
+  int width, height, scale;
+  guint i;
+  cairo_t *cr;
+
+  if (!GDK_X11_DISPLAY (display)->have_shm)
+    return FALSE;
+
+  scale = gdk_surface_get_scale_factor (surface);
+  width = gdk_surface_get_width (surface) * scale;
+  height = gdk_surface_get_height (surface) * scale;
+
+  /* Prefer a buffer the server is done with, so we don't have to wait */
+  for (i = 0; i < G_N_ELEMENTS (self->shm_buffers); i++)
+    {
+      if (self->shm_buffers[i] == NULL)
+        continue;
+
+      if (self->shm_buffers[i]->width != width ||
+          self->shm_buffers[i]->height != height)
+        {
+          gdk_x11_shm_buffer_wait (self->shm_buffers[i]);
+          g_clear_pointer (&self->shm_buffers[i], gdk_x11_shm_buffer_free);
+          continue;
+        }
+
+      if (buffer == NULL || (buffer->busy && !self->shm_buffers[i]->busy))
+        buffer = self->shm_buffers[i];
+    }
+
+  if (buffer == NULL || buffer->busy)
+    {
+      for (i = 0; i < G_N_ELEMENTS (self->shm_buffers); i++)
+        {
+          if (self->shm_buffers[i] == NULL)
+            {
+              self->shm_buffers[i] = gdk_x11_shm_buffer_new (display,
+                                                             gdk_surface_get_width (surface),
+                                                             gdk_surface_get_height (surface),
+                                                             scale);
+              if (self->shm_buffers[i])
+                buffer = self->shm_buffers[i];
+              break;
+            }
+        }
+    }
+
+  if (buffer == NULL)
+    return FALSE;
+
+  gdk_x11_shm_buffer_wait (buffer);
+
+  self->shm_paint_buffer = buffer;
+  self->paint_surface = cairo_surface_reference (buffer->surface);
+
+  /* clear the repaint area */
+  cr = cairo_create (self->paint_surface);
+  cairo_set_operator (cr, CAIRO_OPERATOR_CLEAR);
+  gdk_cairo_region (cr, region);
+  cairo_fill (cr);
+  cairo_destroy (cr);
+
+  return TRUE;
+}
+
+static void
+gdk_x11_cairo_context_end_shm_frame (GdkX11CairoContext *self,
+                                     cairo_region_t     *painted)
+{
+  GdkDisplay *display = gdk_draw_context_get_display (GDK_DRAW_CONTEXT (self));
+  GdkSurface *surface = gdk_draw_context_get_surface (GDK_DRAW_CONTEXT (self));
+  GdkX11ShmBuffer *buffer = self->shm_paint_buffer;
+  Display *xdisplay = GDK_DISPLAY_XDISPLAY (display);
+  cairo_rectangle_int_t rect;
+  int i, n, scale;
+
+  cairo_surface_flush (buffer->surface);
+
+  if (self->shm_gc == NULL)
+    self->shm_gc = XCreateGC (xdisplay, GDK_SURFACE_XID (surface), 0, NULL);
+
+  scale = gdk_surface_get_scale_factor (surface);
+  n = cairo_region_num_rectangles (painted);
+  for (i = 0; i < n; i++)
+    {
+      cairo_region_get_rectangle (painted, i, &rect);
+
+      /* Requests are handled in order, so it is enough to know
+       * when the server is done with the last one.
+       */
+      XShmPutImage (xdisplay, GDK_SURFACE_XID (surface), self->shm_gc,
+                    buffer->ximage,
+                    rect.x * scale, rect.y * scale,
+                    rect.x * scale, rect.y * scale,
+                    rect.width * scale, rect.height * scale,
+                    i == n - 1);
+    }
+
+  buffer->busy = n > 0;
+  XFlush (xdisplay);
+
+  self->shm_paint_buffer = NULL;
+  g_clear_pointer (&self->paint_surface, cairo_surface_destroy);
+}
+
+#endif /* HAVE_XSHM */
+
 static cairo_surface_t *
 create_cairo_surface_for_surface (GdkSurface *surface)
 {
@@ -62,6 +387,11 @@ gdk_x11_cairo_context_begin_frame (GdkDrawContext *draw_context,
   GdkSurface *surface;
   double sx, sy;
 
+#ifdef HAVE_XSHM
+  if (gdk_x11_cairo_context_begin_shm_frame (self, region))
+    return;
+#endif
+
   surface = gdk_draw_context_get_surface (draw_context);
   cairo_region_get_extents (region, &clip_box);
 
@@ -83,6 +413,14 @@ gdk_x11_cairo_context_end_frame (GdkDrawContext *draw_context,
   GdkX11CairoContext *self = GDK_X11_CAIRO_CONTEXT (draw_context);
   cairo_t *cr;
 
+#ifdef HAVE_XSHM
+  if (self->shm_paint_buffer)
+    {
+      gdk_x11_cairo_context_end_shm_frame (self, painted);
+      return;
+    }
+#endif
+
   cr = cairo_create (self->window_surface);
 
   cairo_set_source_surface (cr, self->paint_surface, 0, 0);
@@ -108,12 +446,27 @@ gdk_x11_cairo_context_cairo_create (GdkCairoContext *context)
   return cairo_create (self->paint_surface);
 }
 
+static void
+gdk_x11_cairo_context_dispose (GObject *object)
+{
+#ifdef HAVE_XSHM
+  GdkX11CairoContext *self = GDK_X11_CAIRO_CONTEXT (object);
+
+  gdk_x11_cairo_context_clear_shm_buffers (self);
+#endif
+
+  G_OBJECT_CLASS (gdk_x11_cairo_context_parent_class)->dispose (object);
+}
+
 static void
 gdk_x11_cairo_context_class_init (GdkX11CairoContextClass *klass)
 {
+  GObjectClass *gobject_class = G_OBJECT_CLASS (klass);
   GdkDrawContextClass *draw_context_class = GDK_DRAW_CONTEXT_CLASS (klass);
   GdkCairoContextClass *cairo_context_class = GDK_CAIRO_CONTEXT_CLASS (klass);
 
+  gobject_class->dispose = gdk_x11_cairo_context_dispose;
+
   draw_context_class->begin_frame = gdk_x11_cairo_context_begin_frame;
   draw_context_class->end_frame = gdk_x11_cairo_context_end_frame;
 
@@ -25,6 +25,8 @@
 
 #include "gdkcairocontextprivate.h"
 
+#include <X11/Xlib.h>
+
 G_BEGIN_DECLS
 
 #define GDK_TYPE_X11_CAIRO_CONTEXT		(gdk_x11_cairo_context_get_type ())
@@ -37,12 +39,19 @@ G_BEGIN_DECLS
 typedef struct _GdkX11CairoContext GdkX11CairoContext;
 typedef struct _GdkX11CairoContextClass GdkX11CairoContextClass;
 
+typedef struct _GdkX11ShmBuffer GdkX11ShmBuffer;
+
 struct _GdkX11CairoContext
 {
   GdkCairoContext parent_instance;
 
   cairo_surface_t *window_surface;
   cairo_surface_t *paint_surface;
+
+  /* MIT-SHM double buffering, see gdkcairocontext-x11.c */
+  GdkX11ShmBuffer *shm_buffers[2];
+  GdkX11ShmBuffer *shm_paint_buffer;
+  GC shm_gc;
 };
 
 struct _GdkX11CairoContextClass
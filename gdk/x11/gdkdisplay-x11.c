@@ -77,6 +77,10 @@
 #include <X11/extensions/Xrandr.h>
 #endif
 
+#ifdef HAVE_XSHM
+#include <X11/extensions/XShm.h>
+#endif
+
 enum {
   XEVENT,
   LAST_SIGNAL
@@ -749,6 +753,9 @@ gdk_x11_display_translate_event (GdkEventTranslator *translator,
         y2 = (xevent->xexpose.y + xevent->xexpose.height + surface_impl->surface_scale -1) / surface_impl->surface_scale;
         expose_rect.height = y2 - expose_rect.y;
 
+        /* Something is visible, don't wait for the throttled clock */
+        _gdk_surface_set_occluded (surface, FALSE);
+
         gdk_surface_invalidate_rect (surface, &expose_rect);
         return_val = FALSE;
       }
@@ -805,6 +812,9 @@ gdk_x11_display_translate_event (GdkEventTranslator *translator,
             break;
 	  }
 #endif /* G_ENABLE_DEBUG */
+      if (surface)
+        _gdk_surface_set_occluded (surface, xevent->xvisibility.state == VisibilityFullyObscured);
+
       /* not handled */
       return_val = FALSE;
       break;
@@ -1081,6 +1091,15 @@ gdk_x11_display_translate_event (GdkEventTranslator *translator,
       break;
 
     default:
+#ifdef HAVE_XSHM
+      if (display_x11->have_shm &&
+          xevent->type == display_x11->shm_event_base + ShmCompletion)
+        {
+          _gdk_x11_cairo_context_shm_completion (display, xevent);
+          return_val = FALSE;
+        }
+      else
+#endif
 #ifdef HAVE_RANDR
       if (xevent->type - display_x11->xrandr_event_base == RRScreenChangeNotify ||
           xevent->type - display_x11->xrandr_event_base == RRNotify)
@@ -1652,6 +1671,22 @@ gdk_x11_display_open (const gchar *display_name)
   }
 #endif
 
+  display_x11->have_shm = FALSE;
+#ifdef HAVE_XSHM
+  {
+    const char *display_string = DisplayString (display_x11->xdisplay);
+
+    /* Shared memory only works if the server runs on this machine */
+    if ((display_string[0] == ':' || g_str_has_prefix (display_string, "unix:")) &&
+        XShmQueryExtension (display_x11->xdisplay))
+      {
+        display_x11->have_shm = TRUE;
+        display_x11->shm_event_base = XShmGetEventBase (display_x11->xdisplay);
+        display_x11->shm_buffers = g_hash_table_new (NULL, NULL);
+      }
+  }
+#endif
+
   display_x11->use_sync = FALSE;
 #ifdef HAVE_XSYNC
   {
@@ -1995,6 +2030,8 @@ gdk_x11_display_finalize (GObject *object)
   /* X ID hashtable */
   g_hash_table_destroy (display_x11->xid_ht);
 
+  g_clear_pointer (&display_x11->shm_buffers, g_hash_table_destroy);
+
   XCloseDisplay (display_x11->xdisplay);
 
   /* error traps */
@@ -133,6 +133,11 @@ struct _GdkX11Display
   guint have_input_shapes : 1;
   gint shape_event_base;
 
+  /* MIT-SHM, only used for local displays */
+  guint have_shm : 1;
+  gint shm_event_base;
+  GHashTable *shm_buffers;
+
   GSList *error_traps;
 
   gint wm_moveresize_button;
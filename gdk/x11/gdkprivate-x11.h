@@ -66,6 +66,9 @@ int           gdk_x11_display_get_window_depth           (GdkX11Display  *displa
 Visual *      gdk_x11_display_get_window_visual          (GdkX11Display  *display);
 Colormap      gdk_x11_display_get_window_colormap        (GdkX11Display  *display);
 
+void _gdk_x11_cairo_context_shm_completion (GdkDisplay   *display,
+                                            const XEvent *xevent);
+
 void _gdk_x11_display_add_window    (GdkDisplay *display,
                                      XID        *xid,
                                      GdkSurface  *window);
@@ -324,6 +324,19 @@ gdk_x11_selection_output_stream_invoke_flush (gpointer data)
   return G_SOURCE_REMOVE;
 }
 
+/* Only accept what fits into one flush per write. Writers of large
+ * payloads then loop, which lets the requestor's pace throttle them
+ * instead of having us copy everything they have into priv->data.
+ */
+static gsize
+gdk_x11_selection_output_stream_limit_write (GdkX11SelectionOutputStream *stream,
+                                             gsize                        count)
+{
+  GdkX11SelectionOutputStreamPrivate *priv = gdk_x11_selection_output_stream_get_instance_private (stream);
+
+  return MIN (count, gdk_x11_display_get_max_request_size (priv->display));
+}
+
 static gssize
 gdk_x11_selection_output_stream_write (GOutputStream  *output_stream,
                                        const void     *buffer,
@@ -334,6 +347,8 @@ gdk_x11_selection_output_stream_write (GOutputStream  *output_stream,
   GdkX11SelectionOutputStream *stream = GDK_X11_SELECTION_OUTPUT_STREAM (output_stream);
   GdkX11SelectionOutputStreamPrivate *priv = gdk_x11_selection_output_stream_get_instance_private (stream);
 
+  count = gdk_x11_selection_output_stream_limit_write (stream, count);
+
   g_mutex_lock (&priv->mutex);
   g_byte_array_append (priv->data, buffer, count);
   GDK_NOTE (SELECTION, g_printerr ("%s:%s: wrote %zu bytes, %u total now\n",
@@ -367,6 +382,8 @@ gdk_x11_selection_output_stream_write_async (GOutputStream        *output_stream
   g_task_set_source_tag (task, gdk_x11_selection_output_stream_write_async);
   g_task_set_priority (task, io_priority);
 
+  count = gdk_x11_selection_output_stream_limit_write (stream, count);
+
   g_mutex_lock (&priv->mutex);
   g_byte_array_append (priv->data, buffer, count);
   GDK_NOTE (SELECTION, g_printerr ("%s:%s: async wrote %zu bytes, %u total now\n",
@@ -4,12 +4,24 @@
 
 #include "gskdebugprivate.h"
 #include "gskprofilerprivate.h"
+#include "gdk/gdkcachesprivate.h"
 #include "gdk/gdktextureprivate.h"
 #include "gdk/gdkgltextureprivate.h"
+#include "gdk/gdkmemorytextureprivate.h"
 
 #include <gdk/gdk.h>
 #include <epoxy/gl.h>
 
+/* Render targets that have not been used for a frame are kept in a pool,
+ * keyed by their size, and handed out again by gsk_gl_driver_create_render_target_texture().
+ * Pooled render targets that have not been reused for MAX_POOL_AGE frames
+ * are freed, and the pool never holds more than the budget of the
+ * "gl-textures" cache, MAX_POOL_BYTES by default. The other textures
+ * are in use, so only the pool can be trimmed.
+ */
+#define MAX_POOL_AGE 60
+#define MAX_POOL_BYTES (64 * 1024 * 1024)
+
  typedef struct {
   GLuint fbo_id;
   GLuint depth_stencil_id;
@@ -21,10 +33,18 @@ typedef struct {
   int height;
   GLuint min_filter;
   GLuint mag_filter;
+  int level;            /* scaled down by 2^level from the user's size */
   Fbo fbo;
   GdkTexture *user;
+  cairo_surface_t *owner;
+  const cairo_user_data_key_t *owner_key;
   guint in_use : 1;
   guint permanent : 1;
+  guint pooled : 1;
+  guint in_pool : 1;
+  guint has_depth_buffer : 1;
+  guint has_stencil_buffer : 1;
+  guint64 pool_timestamp;
 
   /* TODO: Make this optional and not for every texture... */
   TextureSlice *slices;
@@ -36,11 +56,16 @@ struct _GskGLDriver
   GObject parent_instance;
 
   GdkGLContext *gl_context;
+  /* The key for the render data of uploaded textures */
+  GdkGLContext *share_group;
   GskProfiler *profiler;
   struct {
     GQuark created_textures;
     GQuark reused_textures;
     GQuark surface_uploads;
+    GQuark created_render_targets;
+    GQuark reused_render_targets;
+    GQuark render_target_pool_size;
   } counters;
 
   Fbo default_fbo;
@@ -48,11 +73,24 @@ struct _GskGLDriver
   GHashTable *textures;
   GHashTable *pointer_textures;
 
+  /* Size key -> GSList of pooled render target textures */
+  GHashTable *render_target_pool;
+  gsize render_target_pool_size;
+  guint64 timestamp;
+
+  /* Used to tie the lifetime of owned textures to their cairo surface */
+  cairo_user_data_key_t owner_key;
+
   const Texture *bound_source_texture;
   const Fbo *bound_fbo;
 
   int max_texture_size;
 
+  /* Bytes of pixel data uploaded since the frame began */
+  gsize upload_bytes;
+
+  GdkCache *cache;
+
   gboolean in_frame : 1;
 };
 
@@ -82,6 +120,9 @@ texture_free (gpointer data)
   if (t->user)
     gdk_texture_clear_render_data (t->user);
 
+  if (t->owner)
+    cairo_surface_set_user_data (t->owner, t->owner_key, NULL, NULL);
+
   if (t->fbo.fbo_id != 0)
     fbo_clear (&t->fbo);
 
@@ -100,6 +141,12 @@ texture_free (gpointer data)
   g_slice_free (Texture, t);
 }
 
+static inline gboolean
+filter_needs_mipmaps (int min_filter)
+{
+  return min_filter != GL_NEAREST && min_filter != GL_LINEAR;
+}
+
 static void
 gsk_gl_driver_set_texture_parameters (GskGLDriver *self,
                                       int          min_filter,
@@ -117,8 +164,12 @@ gsk_gl_driver_finalize (GObject *gobject)
 {
   GskGLDriver *self = GSK_GL_DRIVER (gobject);
 
+  gdk_cache_unregister (self->cache);
+
   gdk_gl_context_make_current (self->gl_context);
 
+  /* The pooled textures are freed with the other textures */
+  g_clear_pointer (&self->render_target_pool, g_hash_table_unref);
   g_clear_pointer (&self->textures, g_hash_table_unref);
   g_clear_pointer (&self->pointer_textures, g_hash_table_unref);
   g_clear_object (&self->profiler);
@@ -141,6 +192,7 @@ static void
 gsk_gl_driver_init (GskGLDriver *self)
 {
   self->textures = g_hash_table_new_full (NULL, NULL, NULL, texture_free);
+  self->render_target_pool = g_hash_table_new_full (NULL, NULL, NULL, (GDestroyNotify) g_slist_free);
 
   self->max_texture_size = -1;
 
@@ -158,9 +210,27 @@ gsk_gl_driver_init (GskGLDriver *self)
                                                              "surface_uploads",
                                                              "Texture uploads from surfaces this frame",
                                                              TRUE);
+  self->counters.created_render_targets = gsk_profiler_add_counter (self->profiler,
+                                                                    "created_render_targets",
+                                                                    "Render targets created this frame",
+                                                                    TRUE);
+  self->counters.reused_render_targets = gsk_profiler_add_counter (self->profiler,
+                                                                   "reused_render_targets",
+                                                                   "Render targets reused from the pool this frame",
+                                                                   TRUE);
+  self->counters.render_target_pool_size = gsk_profiler_add_counter (self->profiler,
+                                                                     "render_target_pool_size",
+                                                                     "Bytes held by pooled render targets",
+                                                                     FALSE);
 #endif
 }
 
+static void gsk_gl_driver_get_cache_size (gpointer  data,
+                                          gsize    *cpu_bytes,
+                                          gsize    *gpu_bytes);
+static void gsk_gl_driver_trim_cache     (gpointer  data,
+                                          gsize     max_bytes);
+
 GskGLDriver *
 gsk_gl_driver_new (GdkGLContext *context)
 {
@@ -170,6 +240,20 @@ gsk_gl_driver_new (GdkGLContext *context)
   self = (GskGLDriver *) g_object_new (GSK_TYPE_GL_DRIVER, NULL);
   self->gl_context = context;
 
+  /* All contexts sharing GL objects lead to the same first context of
+   * their share group, which they keep alive. Using it as the key lets
+   * the drivers of all surfaces of a display use the textures that one
+   * of them uploaded, instead of each uploading its own copy.
+   */
+  self->share_group = context;
+  while (gdk_gl_context_get_shared_context (self->share_group))
+    self->share_group = gdk_gl_context_get_shared_context (self->share_group);
+  self->cache = gdk_cache_register ("gl-textures",
+                                    MAX_POOL_BYTES,
+                                    gsk_gl_driver_get_cache_size,
+                                    gsk_gl_driver_trim_cache,
+                                    self);
+
   return self;
 }
 
@@ -180,6 +264,7 @@ gsk_gl_driver_begin_frame (GskGLDriver *self)
   g_return_if_fail (!self->in_frame);
 
   self->in_frame = TRUE;
+  self->upload_bytes = 0;
 
   if (self->max_texture_size < 0)
     {
@@ -221,10 +306,16 @@ gsk_gl_driver_end_frame (GskGLDriver *self)
   GSK_NOTE (OPENGL,
             g_message ("Textures created: %" G_GINT64_FORMAT "\n"
                      " Textures reused: %" G_GINT64_FORMAT "\n"
-                     " Surface uploads: %" G_GINT64_FORMAT,
+                     " Surface uploads: %" G_GINT64_FORMAT "\n"
+                     " Render targets created: %" G_GINT64_FORMAT "\n"
+                     " Render targets reused: %" G_GINT64_FORMAT "\n"
+                     " Render target pool: %" G_GINT64_FORMAT " bytes",
                      gsk_profiler_counter_get (self->profiler, self->counters.created_textures),
                      gsk_profiler_counter_get (self->profiler, self->counters.reused_textures),
-                     gsk_profiler_counter_get (self->profiler, self->counters.surface_uploads)));
+                     gsk_profiler_counter_get (self->profiler, self->counters.surface_uploads),
+                     gsk_profiler_counter_get (self->profiler, self->counters.created_render_targets),
+                     gsk_profiler_counter_get (self->profiler, self->counters.reused_render_targets),
+                     gsk_profiler_counter_get (self->profiler, self->counters.render_target_pool_size)));
 #endif
 
   GSK_NOTE (OPENGL,
@@ -234,6 +325,148 @@ gsk_gl_driver_end_frame (GskGLDriver *self)
   self->in_frame = FALSE;
 }
 
+static inline gpointer
+pool_key (int      width,
+          int      height,
+          gboolean add_depth_buffer,
+          gboolean add_stencil_buffer)
+{
+  return GUINT_TO_POINTER (((guint)width << 17) | ((guint)height << 2) |
+                           (add_depth_buffer << 1) | add_stencil_buffer);
+}
+
+static inline gsize
+texture_size (const Texture *t)
+{
+  gsize size = (gsize)t->width * t->height * 4;
+
+  if (t->has_depth_buffer || t->has_stencil_buffer)
+    size *= 2;
+
+  return size;
+}
+
+static void
+remove_pointer_texture (GskGLDriver *self,
+                        int          texture_id)
+{
+  /* TODO: Is there a better way for this? */
+  if (self->pointer_textures)
+    {
+      GHashTableIter pointer_iter;
+      gpointer value;
+      gpointer p;
+
+      g_hash_table_iter_init (&pointer_iter, self->pointer_textures);
+      while (g_hash_table_iter_next (&pointer_iter, &p, &value))
+        {
+          if (GPOINTER_TO_INT (value) == texture_id)
+            {
+              g_hash_table_iter_remove (&pointer_iter);
+              break;
+            }
+        }
+    }
+}
+
+static void
+pool_remove (GskGLDriver *self,
+             Texture     *t)
+{
+  gpointer key = pool_key (t->width, t->height, t->has_depth_buffer, t->has_stencil_buffer);
+  GSList *bucket;
+
+  bucket = g_hash_table_lookup (self->render_target_pool, key);
+  g_hash_table_steal (self->render_target_pool, key);
+  bucket = g_slist_remove (bucket, t);
+  if (bucket)
+    g_hash_table_insert (self->render_target_pool, key, bucket);
+
+  self->render_target_pool_size -= texture_size (t);
+  t->in_pool = FALSE;
+}
+
+/* Returns TRUE if @t was put into the pool, FALSE if it should be freed */
+static gboolean
+pool_add (GskGLDriver *self,
+          Texture     *t)
+{
+  gpointer key;
+  GSList *bucket;
+  gsize budget;
+
+  budget = gdk_cache_get_budget (self->cache);
+  if (budget > 0 && self->render_target_pool_size + texture_size (t) > budget)
+    return FALSE;
+
+  key = pool_key (t->width, t->height, t->has_depth_buffer, t->has_stencil_buffer);
+  bucket = g_hash_table_lookup (self->render_target_pool, key);
+  g_hash_table_steal (self->render_target_pool, key);
+  g_hash_table_insert (self->render_target_pool, key, g_slist_prepend (bucket, t));
+
+  self->render_target_pool_size += texture_size (t);
+  t->in_pool = TRUE;
+  t->pool_timestamp = self->timestamp;
+
+  return TRUE;
+}
+
+static void
+gsk_gl_driver_get_cache_size (gpointer  data,
+                              gsize    *cpu_bytes,
+                              gsize    *gpu_bytes)
+{
+  GskGLDriver *self = data;
+  GHashTableIter iter;
+  gpointer value_p;
+
+  *cpu_bytes = 0;
+  *gpu_bytes = 0;
+
+  g_hash_table_iter_init (&iter, self->textures);
+  while (g_hash_table_iter_next (&iter, NULL, &value_p))
+    *gpu_bytes += texture_size (value_p);
+}
+
+/* Frees pooled render targets, oldest first */
+static void
+gsk_gl_driver_trim_cache (gpointer data,
+                          gsize    max_bytes)
+{
+  GskGLDriver *self = data;
+  gsize cpu_bytes, gpu_bytes;
+
+  if (self->in_frame)
+    return;
+
+  gsk_gl_driver_get_cache_size (self, &cpu_bytes, &gpu_bytes);
+
+  gdk_gl_context_make_current (self->gl_context);
+
+  while (gpu_bytes > max_bytes && self->render_target_pool_size > 0)
+    {
+      GHashTableIter iter;
+      gpointer value_p;
+      Texture *oldest = NULL;
+
+      g_hash_table_iter_init (&iter, self->textures);
+      while (g_hash_table_iter_next (&iter, NULL, &value_p))
+        {
+          Texture *t = value_p;
+
+          if (t->in_pool && (oldest == NULL || t->pool_timestamp < oldest->pool_timestamp))
+            oldest = t;
+        }
+
+      if (oldest == NULL)
+        break;
+
+      gpu_bytes -= texture_size (oldest);
+      pool_remove (self, oldest);
+      g_hash_table_remove (self->textures, GINT_TO_POINTER (oldest->texture_id));
+    }
+}
+
 int
 gsk_gl_driver_collect_textures (GskGLDriver *self)
 {
@@ -245,6 +478,7 @@ gsk_gl_driver_collect_textures (GskGLDriver *self)
   g_return_val_if_fail (!self->in_frame, 0);
 
   old_size = g_hash_table_size (self->textures);
+  self->timestamp++;
 
   g_hash_table_iter_init (&iter, self->textures);
   while (g_hash_table_iter_next (&iter, NULL, &value_p))
@@ -254,11 +488,20 @@ gsk_gl_driver_collect_textures (GskGLDriver *self)
       if (t->user || t->permanent)
         continue;
 
-      if (t->in_use)
+      if (t->in_pool)
+        {
+          if (self->timestamp - t->pool_timestamp > MAX_POOL_AGE)
+            {
+              pool_remove (self, t);
+              g_hash_table_iter_remove (&iter);
+            }
+        }
+      else if (t->in_use)
         {
           t->in_use = FALSE;
 
-          if (t->fbo.fbo_id != 0)
+          /* Pooled render targets keep their framebuffer */
+          if (t->fbo.fbo_id != 0 && !t->pooled)
             {
               fbo_clear (&t->fbo);
               t->fbo.fbo_id = 0;
@@ -267,31 +510,27 @@ gsk_gl_driver_collect_textures (GskGLDriver *self)
       else
         {
           /* Remove from self->pointer_textures. */
-          /* TODO: Is there a better way for this? */
-          if (self->pointer_textures)
-            {
-              GHashTableIter pointer_iter;
-              gpointer value;
-              gpointer p;
-
-              g_hash_table_iter_init (&pointer_iter, self->pointer_textures);
-              while (g_hash_table_iter_next (&pointer_iter, &p, &value))
-                {
-                  if (GPOINTER_TO_INT (value) == t->texture_id)
-                    {
-                      g_hash_table_iter_remove (&pointer_iter);
-                      break;
-                    }
-                }
-            }
+          remove_pointer_texture (self, t->texture_id);
 
-          g_hash_table_iter_remove (&iter);
+          if (!t->pooled || !pool_add (self, t))
+            g_hash_table_iter_remove (&iter);
         }
     }
 
+#ifdef G_ENABLE_DEBUG
+  gsk_profiler_counter_set (self->profiler, self->counters.render_target_pool_size,
+                            self->render_target_pool_size);
+#endif
+
   return old_size - g_hash_table_size (self->textures);
 }
 
+GdkGLContext *
+gsk_gl_driver_get_gl_context (GskGLDriver *self)
+{
+  return self->gl_context;
+}
+
 int
 gsk_gl_driver_get_max_texture_size (GskGLDriver *self)
 {
@@ -306,6 +545,20 @@ gsk_gl_driver_get_max_texture_size (GskGLDriver *self)
   return self->max_texture_size;
 }
 
+/* Accounts for @n_bytes of pixel data uploaded outside the driver */
+void
+gsk_gl_driver_count_upload (GskGLDriver *self,
+                            gsize        n_bytes)
+{
+  self->upload_bytes += n_bytes;
+}
+
+gsize
+gsk_gl_driver_get_upload_bytes (GskGLDriver *self)
+{
+  return self->upload_bytes;
+}
+
 static Texture *
 gsk_gl_driver_get_texture (GskGLDriver *self,
                            int          texture_id)
@@ -378,6 +631,17 @@ gsk_gl_driver_release_texture (gpointer data)
   t->user = NULL;
 }
 
+static void
+gsk_gl_driver_release_owned_texture (gpointer data)
+{
+  Texture *t = data;
+
+  /* The owner is gone, so let the next collection drop the texture */
+  t->owner = NULL;
+  t->permanent = FALSE;
+  t->in_use = FALSE;
+}
+
 void
 gsk_gl_driver_slice_texture (GskGLDriver   *self,
                              GdkTexture    *texture,
@@ -397,7 +661,7 @@ gsk_gl_driver_slice_texture (GskGLDriver   *self,
   g_assert (tex_width > max_texture_size || tex_height > max_texture_size);
 
 
-  tex = gdk_texture_get_render_data (texture, self);
+  tex = gdk_texture_get_render_data (texture, self->share_group);
 
   if (tex != NULL)
     {
@@ -444,6 +708,7 @@ gsk_gl_driver_slice_texture (GskGLDriver   *self,
           glBindTexture (GL_TEXTURE_2D, texture_id);
           gsk_gl_driver_set_texture_parameters (self, GL_NEAREST, GL_NEAREST);
           gdk_cairo_surface_upload_to_gl (surface, GL_TEXTURE_2D, slice_width, slice_height, NULL);
+          self->upload_bytes += stride * slice_height;
 
 #ifdef G_ENABLE_DEBUG
           gsk_profiler_counter_inc (self->profiler, self->counters.surface_uploads);
@@ -474,15 +739,109 @@ gsk_gl_driver_slice_texture (GskGLDriver   *self,
 
   /* Use texture_free as destroy notify here since we are not inserting this Texture
    * into self->textures! */
-  gdk_texture_set_render_data (texture, self, tex, texture_free);
+  gdk_texture_set_render_data (texture, self->share_group, tex, texture_free);
 
   *out_slices = slices;
   *out_n_slices = cols * rows;
 }
 
+/* Formats with more than 8 bits per channel are uploaded as they are,
+ * so their precision isn't lost in the 8 bit Cairo surface that other
+ * textures are uploaded from.
+ */
+static gboolean
+get_native_memory_format (GskGLDriver     *self,
+                          GdkMemoryFormat  format,
+                          GLenum          *internal_format,
+                          GLenum          *gl_format,
+                          GLenum          *gl_type)
+{
+  if (gdk_gl_context_get_use_es (self->gl_context))
+    return FALSE;
+
+  switch ((int) format)
+    {
+    case GDK_MEMORY_R16G16B16A16_PREMULTIPLIED:
+      *internal_format = GL_RGBA16;
+      *gl_format = GL_RGBA;
+      *gl_type = GL_UNSIGNED_SHORT;
+      return TRUE;
+
+    case GDK_MEMORY_R16G16B16A16_FLOAT_PREMULTIPLIED:
+      *internal_format = GL_RGBA16F;
+      *gl_format = GL_RGBA;
+      *gl_type = GL_HALF_FLOAT;
+      return TRUE;
+
+    default:
+      return FALSE;
+    }
+}
+
+static void
+gsk_gl_driver_init_texture_with_memory (GskGLDriver      *self,
+                                        Texture          *t,
+                                        GdkMemoryTexture *texture,
+                                        GLenum            internal_format,
+                                        GLenum            gl_format,
+                                        GLenum            gl_type,
+                                        int               min_filter,
+                                        int               mag_filter)
+{
+  gsize stride = gdk_memory_texture_get_stride (texture);
+
+  gsk_gl_driver_set_texture_parameters (self, min_filter, mag_filter);
+
+  glPixelStorei (GL_UNPACK_ALIGNMENT, 2);
+  glPixelStorei (GL_UNPACK_ROW_LENGTH, stride / 8);
+  glTexImage2D (GL_TEXTURE_2D, 0, internal_format, t->width, t->height, 0,
+                gl_format, gl_type, gdk_memory_texture_get_data (texture));
+  glPixelStorei (GL_UNPACK_ROW_LENGTH, 0);
+  glPixelStorei (GL_UNPACK_ALIGNMENT, 4);
+
+  self->upload_bytes += stride * t->height;
+
+#ifdef G_ENABLE_DEBUG
+  gsk_profiler_counter_inc (self->profiler, self->counters.surface_uploads);
+#endif
+
+  t->min_filter = min_filter;
+  t->mag_filter = mag_filter;
+
+  if (filter_needs_mipmaps (min_filter))
+    glGenerateMipmap (GL_TEXTURE_2D);
+}
+
+/* Scales the surface down by 2^@level */
+static cairo_surface_t *
+scale_surface (cairo_surface_t *surface,
+               int              level)
+{
+  int width = cairo_image_surface_get_width (surface);
+  int height = cairo_image_surface_get_height (surface);
+  int scaled_width = MAX (1, (width + (1 << level) - 1) >> level);
+  int scaled_height = MAX (1, (height + (1 << level) - 1) >> level);
+  cairo_surface_t *scaled;
+  cairo_t *cr;
+
+  scaled = cairo_image_surface_create (CAIRO_FORMAT_ARGB32, scaled_width, scaled_height);
+  cr = cairo_create (scaled);
+  cairo_scale (cr, (double) scaled_width / width, (double) scaled_height / height);
+  cairo_set_source_surface (cr, surface, 0, 0);
+  cairo_pattern_set_filter (cairo_get_source (cr), CAIRO_FILTER_GOOD);
+  cairo_set_operator (cr, CAIRO_OPERATOR_SOURCE);
+  cairo_paint (cr);
+  cairo_destroy (cr);
+
+  return scaled;
+}
+
+/* @level is a hint to scale the texture down by 2^@level before
+ * uploading it, when it is drawn a lot smaller than its size. */
 int
 gsk_gl_driver_get_texture_for_texture (GskGLDriver *self,
                                        GdkTexture  *texture,
+                                       int          level,
                                        int          min_filter,
                                        int          mag_filter)
 {
@@ -500,6 +859,7 @@ gsk_gl_driver_get_texture_for_texture (GskGLDriver *self,
           gdk_gl_context_make_current (texture_context);
           surface = gdk_texture_download_surface (texture);
           gdk_gl_context_make_current (self->gl_context);
+          level = 0;
         }
       else
         {
@@ -509,20 +869,72 @@ gsk_gl_driver_get_texture_for_texture (GskGLDriver *self,
     }
   else
     {
-      t = gdk_texture_get_render_data (texture, self);
+      t = gdk_texture_get_render_data (texture, self->share_group);
 
-      if (t)
+      if (t && t->level == level && t->mag_filter == mag_filter)
         {
-          if (t->min_filter == min_filter && t->mag_filter == mag_filter)
+          /* Mipmaps don't change how textures look at their size */
+          if (t->min_filter == min_filter ||
+              (min_filter == GL_LINEAR && filter_needs_mipmaps (t->min_filter)))
             return t->texture_id;
+
+          /* The texture is now also drawn smaller, add mipmaps */
+          if (t->min_filter == GL_LINEAR && filter_needs_mipmaps (min_filter))
+            {
+              glActiveTexture (GL_TEXTURE0);
+              glBindTexture (GL_TEXTURE_2D, t->texture_id);
+              glTexParameteri (GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, min_filter);
+              glGenerateMipmap (GL_TEXTURE_2D);
+              self->bound_source_texture = NULL;
+
+              t->min_filter = min_filter;
+              return t->texture_id;
+            }
+        }
+
+      if (GDK_IS_MEMORY_TEXTURE (texture) && level == 0)
+        {
+          GdkMemoryTexture *memory_texture = GDK_MEMORY_TEXTURE (texture);
+          GLenum internal_format, gl_format, gl_type;
+
+          if (get_native_memory_format (self,
+                                        gdk_memory_texture_get_format (memory_texture),
+                                        &internal_format, &gl_format, &gl_type) &&
+              gdk_memory_texture_get_stride (memory_texture) % 8 == 0 &&
+              gdk_texture_get_width (texture) <= self->max_texture_size &&
+              gdk_texture_get_height (texture) <= self->max_texture_size)
+            {
+              t = create_texture (self, gdk_texture_get_width (texture), gdk_texture_get_height (texture));
+
+              if (gdk_texture_set_render_data (texture, self->share_group, t, gsk_gl_driver_release_texture))
+                t->user = texture;
+
+              gsk_gl_driver_bind_source_texture (self, t->texture_id);
+              gsk_gl_driver_init_texture_with_memory (self, t, memory_texture,
+                                                      internal_format, gl_format, gl_type,
+                                                      min_filter, mag_filter);
+
+              return t->texture_id;
+            }
         }
 
       surface = gdk_texture_download_surface (texture);
+
+      if (level > 0)
+        {
+          cairo_surface_t *scaled = scale_surface (surface, level);
+
+          cairo_surface_destroy (surface);
+          surface = scaled;
+        }
     }
 
-  t = create_texture (self, gdk_texture_get_width (texture), gdk_texture_get_height (texture));
+  t = create_texture (self,
+                      cairo_image_surface_get_width (surface),
+                      cairo_image_surface_get_height (surface));
+  t->level = level;
 
-  if (gdk_texture_set_render_data (texture, self, t, gsk_gl_driver_release_texture))
+  if (gdk_texture_set_render_data (texture, self->share_group, t, gsk_gl_driver_release_texture))
     t->user = texture;
 
   gsk_gl_driver_bind_source_texture (self, t->texture_id);
@@ -561,6 +973,64 @@ gsk_gl_driver_set_texture_for_pointer (GskGLDriver *self,
   g_hash_table_insert (self->pointer_textures, pointer, GINT_TO_POINTER (texture_id));
 }
 
+/* Returns the texture previously created with gsk_gl_driver_create_owned_texture()
+ * and registered for @pointer, as long as it is still owned by @owner and has
+ * the given size. Returns 0 otherwise. */
+int
+gsk_gl_driver_get_owned_texture_for_pointer (GskGLDriver     *self,
+                                             gpointer         pointer,
+                                             cairo_surface_t *owner,
+                                             int              width,
+                                             int              height)
+{
+  Texture *t;
+  int id;
+
+  g_return_val_if_fail (GSK_IS_GL_DRIVER (self), 0);
+
+  id = gsk_gl_driver_get_texture_for_pointer (self, pointer);
+  if (id == 0)
+    return 0;
+
+  t = gsk_gl_driver_get_texture (self, id);
+  if (t == NULL ||
+      t->owner != owner ||
+      t->width != width ||
+      t->height != height)
+    return 0;
+
+#ifdef G_ENABLE_DEBUG
+  gsk_profiler_counter_inc (self->profiler, self->counters.reused_textures);
+#endif
+
+  return id;
+}
+
+/* Creates a texture that is kept alive across frames until @owner is
+ * destroyed. Only one texture per driver can be owned by a surface;
+ * a previously owned texture gets released. */
+int
+gsk_gl_driver_create_owned_texture (GskGLDriver     *self,
+                                    cairo_surface_t *owner,
+                                    float            width,
+                                    float            height)
+{
+  Texture *t;
+
+  g_return_val_if_fail (GSK_IS_GL_DRIVER (self), -1);
+  g_return_val_if_fail (owner != NULL, -1);
+
+  t = create_texture (self, width, height);
+  t->permanent = TRUE;
+  t->owner = owner;
+  t->owner_key = &self->owner_key;
+
+  cairo_surface_set_user_data (owner, &self->owner_key,
+                               t, gsk_gl_driver_release_owned_texture);
+
+  return t->texture_id;
+}
+
 int
 gsk_gl_driver_create_permanent_texture (GskGLDriver *self,
                                         float        width,
@@ -645,6 +1115,59 @@ gsk_gl_driver_create_render_target (GskGLDriver *self,
   return fbo_id;
 }
 
+/* Returns a texture of the given size with a render target attached, taken
+ * from the pool of render targets of previous frames if possible. The texture
+ * is only valid for the current frame and its contents are undefined, so callers
+ * need to clear it. The render target is returned in @out_render_target. */
+int
+gsk_gl_driver_create_render_target_texture (GskGLDriver *self,
+                                            float        fwidth,
+                                            float        fheight,
+                                            gboolean     add_depth_buffer,
+                                            gboolean     add_stencil_buffer,
+                                            int         *out_render_target)
+{
+  int width = MIN (ceilf (fwidth), self->max_texture_size);
+  int height = MIN (ceilf (fheight), self->max_texture_size);
+  GSList *bucket;
+  Texture *t;
+
+  g_return_val_if_fail (GSK_IS_GL_DRIVER (self), -1);
+  g_return_val_if_fail (self->in_frame, -1);
+
+  bucket = g_hash_table_lookup (self->render_target_pool,
+                                pool_key (width, height, add_depth_buffer, add_stencil_buffer));
+  if (bucket != NULL)
+    {
+      t = bucket->data;
+      pool_remove (self, t);
+      t->in_use = TRUE;
+
+#ifdef G_ENABLE_DEBUG
+      gsk_profiler_counter_inc (self->profiler, self->counters.reused_render_targets);
+#endif
+
+      *out_render_target = t->fbo.fbo_id;
+      return t->texture_id;
+    }
+
+  t = create_texture (self, width, height);
+  t->pooled = TRUE;
+  t->has_depth_buffer = add_depth_buffer;
+  t->has_stencil_buffer = add_stencil_buffer;
+
+  gsk_gl_driver_bind_source_texture (self, t->texture_id);
+  gsk_gl_driver_init_texture_empty (self, t->texture_id);
+  *out_render_target = gsk_gl_driver_create_render_target (self, t->texture_id,
+                                                           add_depth_buffer, add_stencil_buffer);
+
+#ifdef G_ENABLE_DEBUG
+  gsk_profiler_counter_inc (self->profiler, self->counters.created_render_targets);
+#endif
+
+  return t->texture_id;
+}
+
 void
 gsk_gl_driver_bind_source_texture (GskGLDriver *self,
                                    int          texture_id)
@@ -775,6 +1298,7 @@ gsk_gl_driver_init_texture_with_surface (GskGLDriver     *self,
   gsk_gl_driver_set_texture_parameters (self, min_filter, mag_filter);
 
   gdk_cairo_surface_upload_to_gl (surface, GL_TEXTURE_2D, t->width, t->height, NULL);
+  self->upload_bytes += t->width * t->height * 4;
 
 #ifdef G_ENABLE_DEBUG
   gsk_profiler_counter_inc (self->profiler, self->counters.surface_uploads);
@@ -783,6 +1307,6 @@ gsk_gl_driver_init_texture_with_surface (GskGLDriver     *self,
   t->min_filter = min_filter;
   t->mag_filter = mag_filter;
 
-  if (t->min_filter != GL_NEAREST)
+  if (filter_needs_mipmaps (t->min_filter))
     glGenerateMipmap (GL_TEXTURE_2D);
 }
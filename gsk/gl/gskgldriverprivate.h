@@ -24,13 +24,18 @@ typedef struct {
 
 GskGLDriver *   gsk_gl_driver_new                       (GdkGLContext    *context);
 
+GdkGLContext *  gsk_gl_driver_get_gl_context            (GskGLDriver     *driver);
 int             gsk_gl_driver_get_max_texture_size      (GskGLDriver     *driver);
+void            gsk_gl_driver_count_upload              (GskGLDriver     *driver,
+                                                         gsize            n_bytes);
+gsize           gsk_gl_driver_get_upload_bytes          (GskGLDriver     *driver);
 
 void            gsk_gl_driver_begin_frame               (GskGLDriver     *driver);
 void            gsk_gl_driver_end_frame                 (GskGLDriver     *driver);
 
 int             gsk_gl_driver_get_texture_for_texture   (GskGLDriver     *driver,
                                                          GdkTexture      *texture,
+                                                         int              level,
                                                          int              min_filter,
                                                          int              mag_filter);
 int             gsk_gl_driver_get_texture_for_pointer   (GskGLDriver     *driver,
@@ -38,6 +43,15 @@ int             gsk_gl_driver_get_texture_for_pointer   (GskGLDriver     *driver
 void            gsk_gl_driver_set_texture_for_pointer   (GskGLDriver     *driver,
                                                          gpointer         pointer,
                                                          int              texture_id);
+int             gsk_gl_driver_get_owned_texture_for_pointer (GskGLDriver     *driver,
+                                                             gpointer         pointer,
+                                                             cairo_surface_t *owner,
+                                                             int              width,
+                                                             int              height);
+int             gsk_gl_driver_create_owned_texture      (GskGLDriver     *driver,
+                                                         cairo_surface_t *owner,
+                                                         float            width,
+                                                         float            height);
 int             gsk_gl_driver_create_permanent_texture  (GskGLDriver     *driver,
                                                          float            width,
                                                          float            height);
@@ -48,6 +62,12 @@ int             gsk_gl_driver_create_render_target      (GskGLDriver     *driver
                                                          int              texture_id,
                                                          gboolean         add_depth_buffer,
                                                          gboolean         add_stencil_buffer);
+int             gsk_gl_driver_create_render_target_texture (GskGLDriver *driver,
+                                                            float        width,
+                                                            float        height,
+                                                            gboolean     add_depth_buffer,
+                                                            gboolean     add_stencil_buffer,
+                                                            int         *out_render_target);
 
 void            gsk_gl_driver_bind_source_texture       (GskGLDriver     *driver,
                                                          int              texture_id);
@@ -3,7 +3,9 @@
 #include "gskglglyphcacheprivate.h"
 #include "gskgldriverprivate.h"
 #include "gskdebugprivate.h"
+#include "gskglyphrasterizerprivate.h"
 #include "gskprivate.h"
+#include "gskprofilerprivate.h"
 
 #include <graphene.h>
 #include <cairo.h>
@@ -12,17 +14,36 @@
 /* Parameters for our cache eviction strategy.
  *
  * Each cached glyph has an age that gets reset every time a cached glyph gets used.
- * Glyphs that have not been used for the MAX_AGE frames are considered old. We keep
- * count of the pixels of each atlas that are taken up by old glyphs. We check the
- * fraction of old pixels every CHECK_INTERVAL frames, and if it is above MAX_OLD, then
- * we drop the atlas an all the glyphs contained in it from the cache.
+ * Glyphs that have not been used for the MAX_AGE frames are considered old. All
+ * glyphs that live in an atlas are kept in a LRU list, and when a new glyph does
+ * not fit into any atlas anymore, we evict old glyphs one by one, starting with the
+ * least recently used one, and reuse the area they took up. Only if that does not
+ * free up a suitable area, a new atlas gets created.
+ *
+ * We keep count of the pixels of each atlas that are taken up by old glyphs. We check
+ * the old pixels every CHECK_INTERVAL frames, and atlases that contain nothing but
+ * old glyphs are dropped from the cache altogether.
+ *
+ * If the "glyphs" cache has a budget, we also drop the atlases with the fewest
+ * recently used pixels when the atlases take up more than that.
+ *
+ * Glyphs that are empty or too big for any atlas only have their extents cached.
+ * They are kept in a LRU list of their own and dropped once they are old.
  */
 
 #define MAX_AGE 60
 #define CHECK_INTERVAL 10
-#define MAX_OLD 0.333
 
-#define ATLAS_SIZE 512
+/* Every new atlas is twice as big as the previous one, starting at MIN_ATLAS_SIZE,
+ * up to MAX_ATLAS_SIZE or the maximum texture size, whichever is smaller.
+ */
+#define MIN_ATLAS_SIZE 1024
+#define MAX_ATLAS_SIZE 4096
+
+/* Glyphs that are bigger than this in either direction go into separate atlases,
+ * so they don't waste the rows we pack small glyphs into.
+ */
+#define LARGE_GLYPH_SIZE 128
 
 static guint    glyph_cache_hash       (gconstpointer v);
 static gboolean glyph_cache_equal      (gconstpointer v1,
@@ -30,19 +51,28 @@ static gboolean glyph_cache_equal      (gconstpointer v1,
 static void     glyph_cache_key_free   (gpointer      v);
 static void     glyph_cache_value_free (gpointer      v);
 static void     dirty_glyph_free       (gpointer      v);
+static void     glyph_cache_get_size   (gpointer      data,
+                                        gsize        *cpu_bytes,
+                                        gsize        *gpu_bytes);
+static void     glyph_cache_trim       (gpointer      data,
+                                        gsize         max_bytes);
 
 static GskGLGlyphAtlas *
-create_atlas (GskGLGlyphCache *cache)
+create_atlas (GskGLGlyphCache *cache,
+              int              size,
+              gboolean         large)
 {
   GskGLGlyphAtlas *atlas;
 
   atlas = g_new0 (GskGLGlyphAtlas, 1);
-  atlas->width = ATLAS_SIZE;
-  atlas->height = ATLAS_SIZE;
+  atlas->width = size;
+  atlas->height = size;
   atlas->y0 = 1;
   atlas->y = 1;
   atlas->x = 1;
+  atlas->large = large;
   atlas->image = NULL;
+  atlas->free_slots = g_array_new (FALSE, FALSE, sizeof (cairo_rectangle_int_t));
 
   return atlas;
 }
@@ -58,6 +88,7 @@ free_atlas (gpointer v)
       g_free (atlas->image);
     }
 
+  g_array_unref (atlas->free_slots);
   g_free (atlas);
 }
 
@@ -68,11 +99,19 @@ gsk_gl_glyph_cache_init (GskGLGlyphCache *self,
 {
   self->hash_table = g_hash_table_new_full (glyph_cache_hash, glyph_cache_equal,
                                             glyph_cache_key_free, glyph_cache_value_free);
+  /* Atlases are created on demand, once we know the maximum texture size */
   self->atlases = g_ptr_array_new_with_free_func (free_atlas);
-  g_ptr_array_add (self->atlases, create_atlas (self));
+  g_queue_init (&self->lru);
+  g_queue_init (&self->no_atlas_lru);
 
   self->renderer = renderer;
   self->gl_driver = gl_driver;
+  self->rasterizer = g_object_ref (gsk_glyph_rasterizer_get_for_display (gsk_renderer_get_display (renderer)));
+
+  self->hits_counter = g_quark_from_static_string ("glyph-cache-hits");
+  self->misses_counter = g_quark_from_static_string ("glyph-cache-misses");
+
+  self->cache = gdk_cache_register ("glyphs", 0, glyph_cache_get_size, glyph_cache_trim, self);
 }
 
 void
@@ -80,6 +119,8 @@ gsk_gl_glyph_cache_free (GskGLGlyphCache *self)
 {
   guint i;
 
+  g_clear_pointer (&self->cache, gdk_cache_unregister);
+
   for (i = 0; i < self->atlases->len; i ++)
     {
       GskGLGlyphAtlas *atlas = g_ptr_array_index (self->atlases, i);
@@ -92,7 +133,11 @@ gsk_gl_glyph_cache_free (GskGLGlyphCache *self)
     }
 
   g_ptr_array_unref (self->atlases);
+  /* The LRU links are embedded in the values */
   g_hash_table_unref (self->hash_table);
+  g_queue_init (&self->lru);
+  g_queue_init (&self->no_atlas_lru);
+  g_clear_object (&self->rasterizer);
 }
 
 static gboolean
@@ -138,60 +183,202 @@ dirty_glyph_free (gpointer v)
     cairo_surface_destroy (glyph->surface);
 }
 
+static inline guint
+slot_pixels (const cairo_rectangle_int_t *slot)
+{
+  return slot->width * slot->height;
+}
+
+static int
+get_atlas_size (GskGLGlyphCache *cache,
+                int              width,
+                int              height,
+                gboolean         large)
+{
+  int max_size = MIN (gsk_gl_driver_get_max_texture_size (cache->gl_driver), MAX_ATLAS_SIZE);
+  int size = MIN_ATLAS_SIZE;
+  guint i;
+
+  if (!large)
+    {
+      for (i = 0; i < cache->atlases->len; i++)
+        {
+          GskGLGlyphAtlas *atlas = g_ptr_array_index (cache->atlases, i);
+
+          if (!atlas->large)
+            size = MAX (size, atlas->width * 2);
+        }
+    }
+
+  while (size < width + 2 || size < height + 2)
+    size *= 2;
+
+  return MIN (size, max_size);
+}
+
+static gboolean
+atlas_find_free_slot (GskGLGlyphAtlas       *atlas,
+                      int                    width,
+                      int                    height,
+                      cairo_rectangle_int_t *slot)
+{
+  int best = -1;
+  guint i;
+
+  /* Best fit, to keep the waste as small as possible */
+  for (i = 0; i < atlas->free_slots->len; i++)
+    {
+      const cairo_rectangle_int_t *r = &g_array_index (atlas->free_slots, cairo_rectangle_int_t, i);
+
+      if (r->width < width || r->height < height)
+        continue;
+
+      if (best == -1 ||
+          slot_pixels (r) < slot_pixels (&g_array_index (atlas->free_slots, cairo_rectangle_int_t, best)))
+        best = i;
+    }
+
+  if (best == -1)
+    return FALSE;
+
+  *slot = g_array_index (atlas->free_slots, cairo_rectangle_int_t, best);
+  g_array_remove_index_fast (atlas->free_slots, best);
+
+  return TRUE;
+}
+
+static gboolean
+atlas_allocate_slot (GskGLGlyphAtlas       *atlas,
+                     int                    width,
+                     int                    height,
+                     cairo_rectangle_int_t *slot)
+{
+  int x = atlas->x;
+  int y0 = atlas->y0;
+
+  if (x + width + 1 >= atlas->width)
+    {
+      /* start a new row */
+      y0 = atlas->y + 1;
+      x = 1;
+    }
+
+  if (x + width + 1 >= atlas->width ||
+      y0 + height + 1 >= atlas->height)
+    return FALSE;
+
+  slot->x = x;
+  slot->y = y0;
+  slot->width = width;
+  slot->height = height;
+
+  atlas->y0 = y0;
+  atlas->x = x + width + 1;
+  atlas->y = MAX (atlas->y, y0 + height + 1);
+
+  return TRUE;
+}
+
+static void
+glyph_cache_evict (GskGLGlyphCache  *cache,
+                   GskGLCachedGlyph *value)
+{
+  GskGLGlyphAtlas *atlas = value->atlas;
+
+  g_assert (atlas != NULL);
+  g_assert (atlas->pending_glyph.value != value);
+
+  atlas->used_pixels -= slot_pixels (&value->slot);
+  if (value->counted_old)
+    atlas->old_pixels -= slot_pixels (&value->slot);
+
+  if (atlas->used_pixels == 0)
+    {
+      /* Start over with an empty atlas, but keep the texture around */
+      g_array_set_size (atlas->free_slots, 0);
+      atlas->old_pixels = 0;
+      atlas->x = 1;
+      atlas->y = 1;
+      atlas->y0 = 1;
+    }
+  else
+    {
+      g_array_append_val (atlas->free_slots, value->slot);
+    }
+
+  g_queue_unlink (&cache->lru, &value->lru_link);
+  g_hash_table_remove (cache->hash_table, value->key);
+}
+
 static void
 add_to_cache (GskGLGlyphCache  *cache,
               GlyphCacheKey    *key,
               GskGLCachedGlyph *value)
 {
-  GskGLGlyphAtlas *atlas;
-  int i;
+  GskGLGlyphAtlas *atlas = NULL;
+  cairo_rectangle_int_t slot;
+  guint i;
   int width = value->draw_width * key->scale / 1024;
   int height = value->draw_height * key->scale / 1024;
+  gboolean large = width > LARGE_GLYPH_SIZE || height > LARGE_GLYPH_SIZE;
 
   for (i = 0; i < cache->atlases->len; i++)
     {
-      int x, y, y0;
-
       atlas = g_ptr_array_index (cache->atlases, i);
-      x = atlas->x;
-      y = atlas->y;
-      y0 = atlas->y0;
 
-      if (atlas->x + width + 1 >= atlas->width)
-        {
-          /* start a new row */
-          y0 = y + 1;
-          x = 1;
-        }
+      if (atlas->large == large &&
+          (atlas_find_free_slot (atlas, width, height, &slot) ||
+           atlas_allocate_slot (atlas, width, height, &slot)))
+        goto found;
+    }
 
-      if (y0 + height + 1 >= atlas->height)
-        continue;
+  /* No room left, so reuse the space of old glyphs, least recently used first.
+   * Old glyphs have not been used in this frame, so nothing refers to them.
+   */
+  while (cache->lru.head != NULL)
+    {
+      GskGLCachedGlyph *oldest = cache->lru.head->data;
+
+      if (cache->timestamp - oldest->timestamp < MAX_AGE)
+        break;
 
-      atlas->y0 = y0;
-      atlas->x = x;
-      atlas->y = y;
-      break;
+      atlas = oldest->atlas;
+      glyph_cache_evict (cache, oldest);
+
+      if (atlas->large == large &&
+          (atlas_find_free_slot (atlas, width, height, &slot) ||
+           atlas_allocate_slot (atlas, width, height, &slot)))
+        goto found;
     }
 
-  if (i == cache->atlases->len)
+  atlas = create_atlas (cache, get_atlas_size (cache, width, height, large), large);
+  if (!atlas_allocate_slot (atlas, width, height, &slot))
     {
-      atlas = create_atlas (cache);
-      g_ptr_array_add (cache->atlases, atlas);
+      /* Bigger than the biggest texture we can create, so don't cache it */
+      GSK_RENDERER_NOTE(cache->renderer, GLYPH_CACHE,
+               g_message ("Glyph of size %dx%d does not fit into an atlas", width, height));
+      free_atlas (atlas);
+      return;
     }
 
-  value->tx = (float)atlas->x / atlas->width;
-  value->ty = (float)atlas->y0 / atlas->height;
+  g_ptr_array_add (cache->atlases, atlas);
+
+found:
+  value->tx = (float)slot.x / atlas->width;
+  value->ty = (float)slot.y / atlas->height;
   value->tw = (float)width / atlas->width;
   value->th = (float)height / atlas->height;
 
   value->atlas = atlas;
+  value->slot = slot;
+  value->lru_link.data = value;
+  g_queue_push_tail_link (&cache->lru, &value->lru_link);
+
+  atlas->used_pixels += slot_pixels (&slot);
 
   atlas->pending_glyph.key = key;
   atlas->pending_glyph.value = value;
 
-  atlas->x = atlas->x + width + 1;
-  atlas->y = MAX (atlas->y, atlas->y0 + height + 1);
-
 #ifdef G_ENABLE_DEBUG
   if (GSK_RENDERER_DEBUG_CHECK (cache->renderer, GLYPH_CACHE))
     {
@@ -199,55 +386,29 @@ add_to_cache (GskGLGlyphCache  *cache,
       for (i = 0; i < cache->atlases->len; i++)
         {
           atlas = g_ptr_array_index (cache->atlases, i);
-          g_print ("\tGskGLGlyphAtlas %d (%dx%d): %.2g%% old pixels, filled to %d, %d / %d\n",
-                   i, atlas->width, atlas->height,
+          g_print ("\tGskGLGlyphAtlas %d (%dx%d%s): %.2g%% used, %.2g%% old pixels, %d free slots, filled to %d, %d / %d\n",
+                   i, atlas->width, atlas->height, atlas->large ? ", large" : "",
+                   100.0 * (double)atlas->used_pixels / (double)(atlas->width * atlas->height),
                    100.0 * (double)atlas->old_pixels / (double)(atlas->width * atlas->height),
+                   atlas->free_slots->len,
                    atlas->x, atlas->y0, atlas->y);
         }
     }
 #endif
 }
 
-static void
-render_glyph (const GskGLGlyphAtlas *atlas,
-              DirtyGlyph            *glyph,
-              GskImageRegion        *region)
+static gboolean
+render_glyph (GskGLGlyphCache *cache,
+              DirtyGlyph      *glyph,
+              GskImageRegion  *region)
 {
   GlyphCacheKey *key = glyph->key;
   GskGLCachedGlyph *value = glyph->value;
   cairo_surface_t *surface;
-  cairo_t *cr;
-  cairo_scaled_font_t *scaled_font;
-  PangoGlyphString glyph_string;
-  PangoGlyphInfo glyph_info;
-
-  scaled_font = pango_cairo_font_get_scaled_font ((PangoCairoFont *)key->font);
-  if (G_UNLIKELY (!scaled_font || cairo_scaled_font_status (scaled_font) != CAIRO_STATUS_SUCCESS))
-    return;
-
-  surface = cairo_image_surface_create (CAIRO_FORMAT_ARGB32,
-                                        value->draw_width * key->scale / 1024,
-                                        value->draw_height * key->scale / 1024);
-  cairo_surface_set_device_scale (surface, key->scale / 1024.0, key->scale / 1024.0);
-
-  cr = cairo_create (surface);
-
-  cairo_set_scaled_font (cr, scaled_font);
-  cairo_set_source_rgba (cr, 1, 1, 1, 1);
-
-  glyph_info.glyph = key->glyph;
-  glyph_info.geometry.width = value->draw_width * 1024;
-  if (key->glyph & PANGO_GLYPH_UNKNOWN_FLAG)
-    glyph_info.geometry.x_offset = 0;
-  else
-    glyph_info.geometry.x_offset = - value->draw_x * 1024;
-  glyph_info.geometry.y_offset = - value->draw_y * 1024;
 
-  glyph_string.num_glyphs = 1;
-  glyph_string.glyphs = &glyph_info;
-
-  pango_cairo_show_glyph_string (cr, key->font, &glyph_string);
-  cairo_destroy (cr);
+  surface = gsk_glyph_rasterizer_get_surface (cache->rasterizer, key->font, key->glyph, key->scale);
+  if (G_UNLIKELY (surface == NULL))
+    return FALSE;
 
   glyph->surface = surface;
 
@@ -255,8 +416,10 @@ render_glyph (const GskGLGlyphAtlas *atlas,
   region->width = cairo_image_surface_get_width (surface);
   region->height = cairo_image_surface_get_height (surface);
   region->stride = cairo_image_surface_get_stride (surface);
-  region->x = (gsize)(value->tx * atlas->width);
-  region->y = (gsize)(value->ty * atlas->height);
+  region->x = value->slot.x;
+  region->y = value->slot.y;
+
+  return TRUE;
 }
 
 static void
@@ -267,13 +430,13 @@ upload_dirty_glyph (GskGLGlyphCache *self,
 
   g_assert (atlas->pending_glyph.key != NULL);
 
-  render_glyph (atlas, &atlas->pending_glyph, &region);
-
-  gsk_gl_image_upload_regions (atlas->image, self->gl_driver, 1, &region);
+  if (render_glyph (self, &atlas->pending_glyph, &region))
+    gsk_gl_image_upload_regions (atlas->image, self->gl_driver, 1, &region);
 
   dirty_glyph_free (&atlas->pending_glyph);
   atlas->pending_glyph.key = NULL;
   atlas->pending_glyph.value = NULL;
+  atlas->pending_glyph.surface = NULL;
 }
 
 const GskGLCachedGlyph *
@@ -292,16 +455,32 @@ gsk_gl_glyph_cache_lookup (GskGLGlyphCache *cache,
                                  .scale = (guint)(scale * 1024)
                                });
 
-  if (value)
+  if (create)
+    gsk_profiler_counter_inc (gsk_renderer_get_profiler (cache->renderer),
+                              value ? cache->hits_counter : cache->misses_counter);
+
+  if (value && value->timestamp != cache->timestamp)
     {
-      if (cache->timestamp - value->timestamp >= MAX_AGE)
-        {
-          GskGLGlyphAtlas *atlas = value->atlas;
+      GskGLGlyphAtlas *atlas = value->atlas;
 
-          if (atlas)
-            atlas->old_pixels -= value->draw_width * value->draw_height;
+      value->timestamp = cache->timestamp;
+
+      if (atlas)
+        {
+          if (value->counted_old)
+            {
+              atlas->old_pixels -= slot_pixels (&value->slot);
+              value->counted_old = FALSE;
+            }
 
-          value->timestamp = cache->timestamp;
+          /* Move to the most recently used end */
+          g_queue_unlink (&cache->lru, &value->lru_link);
+          g_queue_push_tail_link (&cache->lru, &value->lru_link);
+        }
+      else
+        {
+          g_queue_unlink (&cache->no_atlas_lru, &value->lru_link);
+          g_queue_push_tail_link (&cache->no_atlas_lru, &value->lru_link);
         }
     }
 
@@ -313,8 +492,8 @@ gsk_gl_glyph_cache_lookup (GskGLGlyphCache *cache,
       key = g_new0 (GlyphCacheKey, 1);
       value = g_new0 (GskGLCachedGlyph, 1);
 
-      pango_font_get_glyph_extents (font, glyph, &ink_rect, NULL);
-      pango_extents_to_pixels (&ink_rect, NULL);
+      gsk_glyph_rasterizer_get_extents (cache->rasterizer, font, glyph,
+                                        (guint)(scale * 1024), &ink_rect);
 
       value->draw_x = ink_rect.x;
       value->draw_y = ink_rect.y;
@@ -328,9 +507,17 @@ gsk_gl_glyph_cache_lookup (GskGLGlyphCache *cache,
       key->glyph = glyph;
       key->scale = (guint)(scale * 1024);
 
+      value->key = key;
+
       if (ink_rect.width > 0 && ink_rect.height > 0 && key->scale > 0)
         add_to_cache (cache, key, value);
 
+      if (value->atlas == NULL)
+        {
+          value->lru_link.data = value;
+          g_queue_push_tail_link (&cache->no_atlas_lru, &value->lru_link);
+        }
+
       g_hash_table_insert (cache->hash_table, key, value);
     }
 
@@ -357,47 +544,154 @@ gsk_gl_glyph_cache_get_glyph_image (GskGLGlyphCache        *self,
   return atlas->image;
 }
 
+static void
+glyph_cache_get_size (gpointer  data,
+                      gsize    *cpu_bytes,
+                      gsize    *gpu_bytes)
+{
+  GskGLGlyphCache *self = data;
+  guint i;
+
+  *cpu_bytes = 0;
+  *gpu_bytes = 0;
+
+  for (i = 0; i < self->atlases->len; i++)
+    {
+      GskGLGlyphAtlas *atlas = g_ptr_array_index (self->atlases, i);
+
+      if (atlas->image)
+        *gpu_bytes += (gsize) atlas->width * atlas->height * 4;
+    }
+}
+
+/* Drops the atlas with the fewest recently used pixels, and all
+ * glyphs in it. Returns FALSE if there is none to drop. */
+static gboolean
+glyph_cache_drop_atlas (GskGLGlyphCache *self)
+{
+  GskGLGlyphAtlas *atlas = NULL;
+  GList *l, *next;
+  guint i, index = 0;
+
+  for (i = 0; i < self->atlases->len; i++)
+    {
+      GskGLGlyphAtlas *a = g_ptr_array_index (self->atlases, i);
+
+      /* Its glyph is about to be drawn */
+      if (a->pending_glyph.key != NULL)
+        continue;
+
+      if (atlas == NULL ||
+          a->used_pixels - a->old_pixels < atlas->used_pixels - atlas->old_pixels)
+        {
+          atlas = a;
+          index = i;
+        }
+    }
+
+  if (atlas == NULL)
+    return FALSE;
+
+  if (atlas->image)
+    {
+      gsk_gl_image_destroy (atlas->image, self->gl_driver);
+      atlas->image->texture_id = 0;
+    }
+
+  for (l = self->lru.head; l != NULL; l = next)
+    {
+      GskGLCachedGlyph *value = l->data;
+
+      next = l->next;
+
+      if (value->atlas == atlas)
+        {
+          g_queue_unlink (&self->lru, l);
+          g_hash_table_remove (self->hash_table, value->key);
+        }
+    }
+
+  g_ptr_array_remove_index (self->atlases, index);
+
+  return TRUE;
+}
+
+static void
+glyph_cache_trim (gpointer data,
+                  gsize    max_bytes)
+{
+  GskGLGlyphCache *self = data;
+  gsize cpu_bytes, gpu_bytes;
+
+  gdk_gl_context_make_current (gsk_gl_driver_get_gl_context (self->gl_driver));
+
+  for (glyph_cache_get_size (self, &cpu_bytes, &gpu_bytes);
+       gpu_bytes > max_bytes;
+       glyph_cache_get_size (self, &cpu_bytes, &gpu_bytes))
+    {
+      if (!glyph_cache_drop_atlas (self))
+        break;
+    }
+}
+
 void
 gsk_gl_glyph_cache_begin_frame (GskGLGlyphCache *self)
 {
   int i;
-  GHashTableIter iter;
-  GlyphCacheKey *key;
-  GskGLCachedGlyph *value;
+  GList *l, *next;
   guint dropped = 0;
+  gsize budget, cpu_bytes, gpu_bytes;
 
   self->timestamp++;
 
+  budget = gdk_cache_get_budget (self->cache);
+  if (budget > 0)
+    {
+      glyph_cache_get_size (self, &cpu_bytes, &gpu_bytes);
+      if (gpu_bytes > budget)
+        glyph_cache_trim (self, budget);
+    }
 
   if (self->timestamp % CHECK_INTERVAL != 0)
     return;
 
+  /* drop glyphs without an atlas that have grown old */
+  while (self->no_atlas_lru.head != NULL)
+    {
+      GskGLCachedGlyph *value = self->no_atlas_lru.head->data;
+
+      if (self->timestamp - value->timestamp < MAX_AGE)
+        break;
+
+      g_queue_unlink (&self->no_atlas_lru, &value->lru_link);
+      g_hash_table_remove (self->hash_table, value->key);
+      dropped++;
+    }
+
   /* look for glyphs that have grown old since last time */
-  g_hash_table_iter_init (&iter, self->hash_table);
-  while (g_hash_table_iter_next (&iter, (gpointer *)&key, (gpointer *)&value))
+  for (l = self->lru.head; l != NULL; l = l->next)
     {
-      guint age;
+      GskGLCachedGlyph *value = l->data;
 
-      age = self->timestamp - value->timestamp;
-      if (MAX_AGE <= age && age < MAX_AGE + CHECK_INTERVAL)
-        {
-          GskGLGlyphAtlas *atlas = value->atlas;
+      if (self->timestamp - value->timestamp < MAX_AGE)
+        break;
 
-          if (atlas)
-            atlas->old_pixels += value->draw_width * value->draw_height;
+      if (!value->counted_old)
+        {
+          value->atlas->old_pixels += slot_pixels (&value->slot);
+          value->counted_old = TRUE;
         }
     }
 
-  /* look for atlases to drop, and create a mapping of updated texture indices */
+  /* look for atlases that contain nothing but old glyphs, and drop them */
   for (i = self->atlases->len - 1; i >= 0; i--)
     {
       GskGLGlyphAtlas *atlas = g_ptr_array_index (self->atlases, i);
 
-      if (atlas->old_pixels > MAX_OLD * atlas->width * atlas->height)
+      if (atlas->used_pixels > 0 && atlas->old_pixels == atlas->used_pixels)
         {
           GSK_RENDERER_NOTE(self->renderer, GLYPH_CACHE,
-                   g_message ("Dropping atlas %d (%g.2%% old)",
-                            i, 100.0 * (double)atlas->old_pixels / (double)(atlas->width * atlas->height)));
+                   g_message ("Dropping atlas %d (%dx%d)", i, atlas->width, atlas->height));
 
           if (atlas->image)
             {
@@ -405,14 +699,25 @@ gsk_gl_glyph_cache_begin_frame (GskGLGlyphCache *self)
               atlas->image->texture_id = 0;
             }
 
-          /* Remove all glyphs that point to this atlas */
-          g_hash_table_iter_init (&iter, self->hash_table);
-          while (g_hash_table_iter_next (&iter, (gpointer *)&key, (gpointer *)&value))
+          /* Remove all glyphs that point to this atlas. They are all old,
+           * so they are all at the start of the LRU list.
+           */
+          for (l = self->lru.head; l != NULL; l = next)
             {
+              GskGLCachedGlyph *value = l->data;
+
+              next = l->next;
+
+              if (self->timestamp - value->timestamp < MAX_AGE)
+                break;
+
               if (value->atlas == atlas)
-                g_hash_table_iter_remove (&iter);
+                {
+                  g_queue_unlink (&self->lru, l);
+                  g_hash_table_remove (self->hash_table, value->key);
+                  dropped++;
+                }
             }
-          /* TODO: The above loop inside this other loop could be slow... */
 
           g_ptr_array_remove_index (self->atlases, i);
         }
@@ -4,18 +4,31 @@
 #include "gskgldriverprivate.h"
 #include "gskglimageprivate.h"
 #include "gskrendererprivate.h"
+#include "gskglyphrasterizerprivate.h"
 #include <pango/pango.h>
 #include <gdk/gdk.h>
+#include "gdk/gdkcachesprivate.h"
 
 typedef struct
 {
   GskGLDriver *gl_driver;
   GskRenderer *renderer;
+  GskGlyphRasterizer *rasterizer;
 
   GHashTable *hash_table;
   GPtrArray *atlases;
 
+  /* All glyphs living in an atlas, least recently used first */
+  GQueue lru;
+  /* The glyphs that are empty or too big for an atlas, in the same order */
+  GQueue no_atlas_lru;
+
   guint64 timestamp;
+
+  GQuark hits_counter;
+  GQuark misses_counter;
+
+  GdkCache *cache;
 } GskGLGlyphCache;
 
 typedef struct
@@ -40,14 +53,23 @@ typedef struct
   GskGLImage *image;
   int width, height;
   int x, y, y0;
+  guint used_pixels;
   guint old_pixels;
+  guint large : 1;
+
+  /* Areas of evicted glyphs that can be reused */
+  GArray *free_slots;
 
   DirtyGlyph pending_glyph;
 } GskGLGlyphAtlas;
 
 struct _GskGLCachedGlyph
 {
+  GlyphCacheKey *key;
   GskGLGlyphAtlas *atlas;
+  cairo_rectangle_int_t slot;
+  GList lru_link;
+  guint counted_old : 1;
 
   float tx;
   float ty;
@@ -58,6 +58,7 @@ gsk_gl_image_upload_regions (GskGLImage           *self,
 
       glTexSubImage2D (GL_TEXTURE_2D, 0, region->x, region->y, region->width, region->height,
                        GL_BGRA, GL_UNSIGNED_INT_8_8_8_8_REV, region->data);
+      gsk_gl_driver_count_upload (gl_driver, region->width * region->height * 4);
     }
 
 #ifdef G_ENABLE_DEBUG
@@ -0,0 +1,126 @@
+#include "config.h"
+
+#include "gskgllayercacheprivate.h"
+
+/* Layers are render nodes that were marked with a cache hint, rendered
+ * into a texture of their own once, and then drawn from that texture
+ * for as long as the same node gets rendered.
+ *
+ * Since render nodes are immutable, the node itself makes the key. We
+ * hold a reference on it, so its address can't be reused by a different
+ * node while the layer is alive. Layers that did not get drawn for
+ * MAX_LAYER_AGE frames are dropped; we don't drop them right away since
+ * a node that is outside of the damaged area doesn't get drawn, but is
+ * likely to be needed again.
+ */
+
+#define MAX_LAYER_AGE 60
+
+typedef struct
+{
+  GskRenderNode *node;
+  float scale;
+
+  int texture_id;
+  guint age;
+} CacheItem;
+
+static void
+cache_item_free (gpointer data)
+{
+  CacheItem *item = data;
+
+  gsk_render_node_unref (item->node);
+  g_slice_free (CacheItem, item);
+}
+
+void
+gsk_gl_layer_cache_init (GskGLLayerCache *self)
+{
+  self->layers = g_hash_table_new_full (NULL, NULL, NULL, cache_item_free);
+}
+
+void
+gsk_gl_layer_cache_free (GskGLLayerCache *self,
+                         GskGLDriver     *gl_driver)
+{
+  GHashTableIter iter;
+  CacheItem *item;
+
+  g_hash_table_iter_init (&iter, self->layers);
+  while (g_hash_table_iter_next (&iter, NULL, (gpointer *) &item))
+    gsk_gl_driver_destroy_texture (gl_driver, item->texture_id);
+
+  g_clear_pointer (&self->layers, g_hash_table_unref);
+}
+
+void
+gsk_gl_layer_cache_begin_frame (GskGLLayerCache *self,
+                                GskGLDriver     *gl_driver)
+{
+  GHashTableIter iter;
+  CacheItem *item;
+
+  g_hash_table_iter_init (&iter, self->layers);
+  while (g_hash_table_iter_next (&iter, NULL, (gpointer *) &item))
+    {
+      item->age ++;
+
+      if (item->age > MAX_LAYER_AGE)
+        {
+          gsk_gl_driver_destroy_texture (gl_driver, item->texture_id);
+          g_hash_table_iter_remove (&iter);
+        }
+    }
+}
+
+int
+gsk_gl_layer_cache_get_texture_id (GskGLLayerCache *self,
+                                   GskGLDriver     *gl_driver,
+                                   GskRenderNode   *node,
+                                   float            scale)
+{
+  CacheItem *item;
+
+  g_assert (self != NULL);
+  g_assert (node != NULL);
+
+  item = g_hash_table_lookup (self->layers, node);
+  if (item == NULL)
+    return 0;
+
+  /* The layer was drawn for a different scale, and the node is unlikely
+   * to be drawn at the old one again */
+  if (item->scale != scale)
+    {
+      gsk_gl_driver_destroy_texture (gl_driver, item->texture_id);
+      g_hash_table_remove (self->layers, node);
+      return 0;
+    }
+
+  item->age = 0;
+
+  g_assert (item->texture_id != 0);
+
+  return item->texture_id;
+}
+
+void
+gsk_gl_layer_cache_commit (GskGLLayerCache *self,
+                           GskRenderNode   *node,
+                           float            scale,
+                           int              texture_id)
+{
+  CacheItem *item;
+
+  g_assert (self != NULL);
+  g_assert (node != NULL);
+  g_assert (texture_id > 0);
+
+  item = g_slice_new0 (CacheItem);
+  item->node = gsk_render_node_ref (node);
+  item->scale = scale;
+  item->texture_id = texture_id;
+
+  g_hash_table_replace (self->layers, node, item);
+}
@@ -0,0 +1,29 @@
+#ifndef __GSK_GL_LAYER_CACHE_H__
+#define __GSK_GL_LAYER_CACHE_H__
+
+#include <glib.h>
+#include "gskgldriverprivate.h"
+#include "gskrendernode.h"
+
+typedef struct
+{
+  GHashTable *layers;
+} GskGLLayerCache;
+
+
+void gsk_gl_layer_cache_init           (GskGLLayerCache *self);
+void gsk_gl_layer_cache_free           (GskGLLayerCache *self,
+                                        GskGLDriver     *gl_driver);
+void gsk_gl_layer_cache_begin_frame    (GskGLLayerCache *self,
+                                        GskGLDriver     *gl_driver);
+int  gsk_gl_layer_cache_get_texture_id (GskGLLayerCache *self,
+                                        GskGLDriver     *gl_driver,
+                                        GskRenderNode   *node,
+                                        float            scale);
+void gsk_gl_layer_cache_commit         (GskGLLayerCache *self,
+                                        GskRenderNode   *node,
+                                        float            scale,
+                                        int              texture_id);
+
+
+#endif
@@ -13,12 +13,15 @@
 #include "gskglglyphcacheprivate.h"
 #include "gskglrenderopsprivate.h"
 #include "gskcairoblurprivate.h"
-#include "gskglshadowcacheprivate.h"
+#include "gskgllayercacheprivate.h"
 #include "gskglnodesampleprivate.h"
+#include "gskshadowcacheprivate.h"
 
 #include "gskprivate.h"
 
+#include "gdk/gdkcachesprivate.h"
 #include "gdk/gdkgltextureprivate.h"
+#include "gdk/gdkprofilerprivate.h"
 
 #include <epoxy/gl.h>
 #include <cairo-ft.h>
@@ -34,7 +37,7 @@
 #define HIGHLIGHT_FALLBACK 0
 #define DEBUG_OPS          0
 
-#define SHADOW_EXTRA_SIZE  4
+#define MAX_RENDER_REGION_RECTS 4
 
 #if DEBUG_OPS
 #define OP_PRINT(format, ...) g_print(format, ## __VA_ARGS__)
@@ -44,9 +47,14 @@
 
 #define INIT_PROGRAM_UNIFORM_LOCATION(program_name, uniform_basename) \
               G_STMT_START{\
-                self->program_name ## _program.program_name.uniform_basename ## _location = \
-                              glGetUniformLocation(self->program_name ## _program.id, "u_" #uniform_basename);\
-                g_assert_cmpint (self->program_name ## _program.program_name.uniform_basename ## _location, >, -1); \
+                int clip_mode_; \
+                for (clip_mode_ = 0; clip_mode_ < N_CLIP_MODES; clip_mode_++) \
+                  { \
+                    Program *variant_ = (Program *) self->program_name ## _program.variants[clip_mode_]; \
+                    variant_->program_name.uniform_basename ## _location = \
+                              glGetUniformLocation(variant_->id, "u_" #uniform_basename);\
+                    g_assert_cmpint (variant_->program_name.uniform_basename ## _location, >, -1); \
+                  } \
               }G_STMT_END
 
 #define INIT_COMMON_UNIFORM_LOCATION(program_ptr, uniform_basename) \
@@ -163,13 +171,46 @@ font_has_color_glyphs (const PangoFont *font)
   return has_color;
 }
 
+/* Textures drawn at less than half their size are sampled from
+ * mipmaps, so they don't alias. If they are drawn at less than a
+ * quarter of their size, they are also scaled down by 2^@level_r
+ * before they are uploaded, so they don't take up memory for pixels
+ * that are never seen.
+ */
 static void
-get_gl_scaling_filters (GskRenderNode *node,
-                        int           *min_filter_r,
-                        int           *mag_filter_r)
+get_gl_scaling_filters (GskGLRenderer         *self,
+                        const RenderOpBuilder *builder,
+                        GskRenderNode         *node,
+                        int                   *min_filter_r,
+                        int                   *mag_filter_r,
+                        int                   *level_r)
 {
+  GdkTexture *texture = gsk_texture_node_get_texture (node);
+  const float scale = ops_get_scale (builder);
+  float ratio;
+  int major, minor;
+
   *min_filter_r = GL_LINEAR;
   *mag_filter_r = GL_LINEAR;
+  *level_r = 0;
+
+  if (node->bounds.size.width <= 0 || node->bounds.size.height <= 0)
+    return;
+
+  ratio = MIN (texture->width / (node->bounds.size.width * scale),
+               texture->height / (node->bounds.size.height * scale));
+  if (ratio < 2)
+    return;
+
+  /* GLES 2 can only mipmap textures with power of two sizes */
+  gdk_gl_context_get_version (self->gl_context, &major, &minor);
+  if (!gdk_gl_context_get_use_es (self->gl_context) || major >= 3)
+    *min_filter_r = GL_LINEAR_MIPMAP_LINEAR;
+
+  /* Leave the last factor of 2 to the mipmaps, so the texture doesn't
+   * have to be uploaded again when the size changes a little */
+  if (ratio >= 4)
+    *level_r = (int) floorf (log2f (ratio)) - 1;
 }
 
 static inline void
@@ -229,17 +270,9 @@ color_matrix_modifies_alpha (GskRenderNode *node)
   return !graphene_vec4_equal (graphene_vec4_w_axis (), &row3);
 }
 
-static inline void
-gsk_rounded_rect_shrink_to_minimum (GskRoundedRect *self)
-{
-  self->bounds.size.width = ceilf (MAX (MAX (self->corner[0].width, self->corner[1].width),
-                                        MAX (self->corner[2].width, self->corner[3].width)) * 2);
-  self->bounds.size.height = ceilf (MAX (MAX (self->corner[0].height, self->corner[1].height),
-                                         MAX (self->corner[2].height, self->corner[3].height)) * 2);
-}
-
 static inline gboolean
-node_supports_transform (GskRenderNode *node)
+node_supports_transform (RenderOpBuilder *builder,
+                         GskRenderNode   *node)
 {
   /* Some nodes can't handle non-trivial transforms without being
    * rendered to a texture (e.g. rotated clips, etc.). Some however
@@ -256,6 +289,11 @@ node_supports_transform (GskRenderNode *node)
       case GSK_TEXTURE_NODE:
         return TRUE;
 
+      /* Glyphs are rasterized at the modelview's scale and drawn as
+       * transformed quads, that only looks right without perspective */
+      case GSK_TEXT_NODE:
+        return ops_modelview_is_flat (builder);
+
       default:
         return FALSE;
     }
@@ -264,6 +302,12 @@ node_supports_transform (GskRenderNode *node)
 
 
 static void gsk_gl_renderer_setup_render_mode (GskGLRenderer   *self);
+static void add_offscreen_ops_for_render_target (GskGLRenderer         *self,
+                                                RenderOpBuilder       *builder,
+                                                const graphene_rect_t *bounds,
+                                                GskRenderNode         *child_node,
+                                                int                    render_target,
+                                                guint                  flags);
 static void add_offscreen_ops                 (GskGLRenderer   *self,
                                                RenderOpBuilder       *builder,
                                                const graphene_rect_t *bounds,
@@ -299,26 +343,43 @@ struct _GskGLRenderer
       Program unblurred_outset_shadow_program;
       Program border_program;
       Program cross_fade_program;
+      Program blend_program;
+      Program repeat_program;
+      Program glyph_program;
     };
   };
+  /* The variants of the programs above for the other clip modes */
+  Program clip_variants[CLIP_MODE_ROUNDED][GL_N_PROGRAMS];
 
   GArray *render_ops;
+  GArray *glyph_instances;
+  /* Glyphs of the text node being added, see render_text_node() */
+  GArray *pending_glyphs;
 
   GskGLGlyphCache glyph_cache;
-  GskGLShadowCache shadow_cache;
+  GskShadowCache shadow_cache;
+  GdkCache *shadow_cache_entry;
+  GskGLLayerCache layer_cache;
+  /* The layer we are currently rendering into its texture */
+  GskRenderNode *current_layer;
 
-#ifdef G_ENABLE_DEBUG
   struct {
-    GQuark frames;
     GQuark draw_calls;
+    GQuark offscreens;
+    GQuark upload_bytes;
+    GQuark fallback_nodes;
+    GQuark culled_nodes;
   } profile_counters;
   struct {
-    GQuark cpu_time;
     GQuark gpu_time;
   } profile_timers;
-#endif
 
   cairo_region_t *render_region;
+  /* The rectangle of render_region we are currently drawing */
+  int render_region_rect;
+
+  /* Whether glyphs are drawn with the instanced glyph program */
+  guint has_instancing : 1;
 };
 
 struct _GskGLRendererClass
@@ -406,6 +467,7 @@ render_fallback_node (GskGLRenderer       *self,
   const float scale = ops_get_scale (builder);
   const int surface_width = ceilf (node->bounds.size.width) * scale;
   const int surface_height = ceilf (node->bounds.size.height) * scale;
+  cairo_surface_t *owner = NULL;
   cairo_surface_t *surface;
   cairo_t *cr;
   int texture_id;
@@ -414,6 +476,33 @@ render_fallback_node (GskGLRenderer       *self,
       surface_height <= 0)
     return;
 
+  gsk_profiler_counter_inc (gsk_renderer_get_profiler (GSK_RENDERER (self)),
+                            self->profile_counters.fallback_nodes);
+
+  /* Cairo nodes are immutable once they are handed to us, so we can
+   * keep their texture around for as long as their surface lives. */
+  if (gsk_render_node_get_node_type (node) == GSK_CAIRO_NODE)
+    {
+      owner = (cairo_surface_t *) gsk_cairo_node_peek_surface (node);
+
+      /* Nothing to draw */
+      if (owner == NULL)
+        return;
+
+      texture_id = gsk_gl_driver_get_owned_texture_for_pointer (self->gl_driver,
+                                                                node,
+                                                                owner,
+                                                                surface_width,
+                                                                surface_height);
+      if (texture_id != 0)
+        {
+          ops_set_program (builder, &self->blit_program);
+          ops_set_texture (builder, texture_id);
+          ops_draw (builder, vertex_data);
+          return;
+        }
+    }
+
   surface = cairo_image_surface_create (CAIRO_FORMAT_ARGB32,
                                         surface_width,
                                         surface_height);
@@ -437,9 +526,20 @@ render_fallback_node (GskGLRenderer       *self,
   cairo_destroy (cr);
 
   /* Upload the Cairo surface to a GL texture */
-  texture_id = gsk_gl_driver_create_texture (self->gl_driver,
-                                             surface_width,
-                                             surface_height);
+  if (owner != NULL)
+    {
+      texture_id = gsk_gl_driver_create_owned_texture (self->gl_driver,
+                                                       owner,
+                                                       surface_width,
+                                                       surface_height);
+      gsk_gl_driver_set_texture_for_pointer (self->gl_driver, node, texture_id);
+    }
+  else
+    {
+      texture_id = gsk_gl_driver_create_texture (self->gl_driver,
+                                                 surface_width,
+                                                 surface_height);
+    }
 
   gsk_gl_driver_bind_source_texture (self->gl_driver, texture_id);
   gsk_gl_driver_init_texture_with_surface (self->gl_driver,
@@ -454,6 +554,19 @@ render_fallback_node (GskGLRenderer       *self,
   ops_draw (builder, vertex_data);
 }
 
+typedef struct
+{
+  int texture_id;
+  GlyphInstance instance;
+} PendingGlyph;
+
+static int
+compare_pending_glyphs (gconstpointer a,
+                        gconstpointer b)
+{
+  return ((const PendingGlyph *) a)->texture_id - ((const PendingGlyph *) b)->texture_id;
+}
+
 static inline void
 render_text_node (GskGLRenderer   *self,
                   GskRenderNode   *node,
@@ -469,10 +582,18 @@ render_text_node (GskGLRenderer   *self,
   int x_position = 0;
   float x = gsk_text_node_get_x (node) + builder->dx;
   float y = gsk_text_node_get_y (node) + builder->dy;
+  const gboolean recolor = force_color || !font_has_color_glyphs (font);
 
-  /* If the font has color glyphs, we don't need to recolor anything */
-  if (!force_color && font_has_color_glyphs (font))
+  if (self->has_instancing)
+    {
+      /* The color is part of the glyph instances, so text nodes in
+       * different colors can share the draw calls */
+      ops_set_program (builder, &self->glyph_program);
+      g_array_set_size (self->pending_glyphs, 0);
+    }
+  else if (!recolor)
     {
+      /* If the font has color glyphs, we don't need to recolor anything */
       ops_set_program (builder, &self->blit_program);
     }
   else
@@ -505,9 +626,29 @@ render_text_node (GskGLRenderer   *self,
       if (glyph->draw_width <= 0 || glyph->draw_height <= 0 || glyph->scale <= 0)
         goto next;
 
+      /* Too big for any atlas */
+      if (glyph->atlas == NULL)
+        goto next;
+
       cx = (double)(x_position + gi->geometry.x_offset) / PANGO_SCALE;
       cy = (double)(gi->geometry.y_offset) / PANGO_SCALE;
 
+      if (self->has_instancing)
+        {
+          PendingGlyph pending = {
+            gsk_gl_glyph_cache_get_glyph_image (&self->glyph_cache, glyph)->texture_id,
+            {
+              { x + cx + glyph->draw_x, y + cy + glyph->draw_y, glyph->draw_width, glyph->draw_height },
+              { glyph->tx, glyph->ty, glyph->tw, glyph->th },
+              { color->red, color->green, color->blue, color->alpha },
+              recolor ? 1.f : 0.f
+            }
+          };
+
+          g_array_append_val (self->pending_glyphs, pending);
+          goto next;
+        }
+
       ops_set_texture (builder, gsk_gl_glyph_cache_get_glyph_image (&self->glyph_cache,
                                                                     glyph)->texture_id);
 
@@ -534,6 +675,25 @@ render_text_node (GskGLRenderer   *self,
 next:
       x_position += gi->geometry.width;
     }
+
+  if (self->has_instancing && self->pending_glyphs->len > 0)
+    {
+      guint j;
+
+      /* Glyphs of one color blend the same in any order, so group
+       * them by atlas. g_array_sort() is stable, so glyphs in the same
+       * atlas keep their order, which matters for color glyphs. */
+      if (recolor)
+        g_array_sort (self->pending_glyphs, compare_pending_glyphs);
+
+      for (j = 0; j < self->pending_glyphs->len; j++)
+        {
+          const PendingGlyph *pending = &g_array_index (self->pending_glyphs, PendingGlyph, j);
+
+          ops_set_texture (builder, pending->texture_id);
+          ops_draw_glyph (builder, &pending->instance);
+        }
+    }
 }
 
 static inline void
@@ -704,8 +864,12 @@ render_texture_node (GskGLRenderer       *self,
   const float min_y = builder->dy + node->bounds.origin.y;
   const float max_x = min_x + node->bounds.size.width;
   const float max_y = min_y + node->bounds.size.height;
+  int gl_min_filter, gl_mag_filter, level;
 
-  if (texture->width > max_texture_size || texture->height > max_texture_size)
+  get_gl_scaling_filters (self, builder, node, &gl_min_filter, &gl_mag_filter, &level);
+
+  if ((texture->width + (1 << level) - 1) >> level > max_texture_size ||
+      (texture->height + (1 << level) - 1) >> level > max_texture_size)
     {
       const float scale_x = (max_x - min_x) / texture->width;
       const float scale_y = (max_y - min_y) / texture->height;
@@ -740,13 +904,11 @@ render_texture_node (GskGLRenderer       *self,
     }
   else
     {
-      int gl_min_filter = GL_NEAREST, gl_mag_filter = GL_NEAREST;
       int texture_id;
 
-      get_gl_scaling_filters (node, &gl_min_filter, &gl_mag_filter);
-
       texture_id = gsk_gl_driver_get_texture_for_texture (self->gl_driver,
                                                           texture,
+                                                          level,
                                                           gl_min_filter,
                                                           gl_mag_filter);
       ops_set_program (builder, &self->blit_program);
@@ -798,7 +960,7 @@ render_transform_node (GskGLRenderer   *self,
 
   ops_push_modelview (builder, &transformed_mv);
   if (ops_modelview_is_simple (builder) ||
-      node_supports_transform (child))
+      node_supports_transform (builder, child))
     {
       const float dx = builder->dx;
       const float dy = builder->dy;
@@ -844,19 +1006,192 @@ render_transform_node (GskGLRenderer   *self,
   ops_pop_modelview (builder);
 }
 
+static int
+compare_rect_y (gconstpointer a,
+                gconstpointer b,
+                gpointer      data)
+{
+  const graphene_rect_t *ra = a;
+  const graphene_rect_t *rb = b;
+
+  if (ra->origin.y < rb->origin.y)
+    return -1;
+  if (ra->origin.y > rb->origin.y)
+    return 1;
+
+  return 0;
+}
+
+/* Whether drawing @node can touch a pixel more than once. If it can't,
+ * applying an opacity to each draw gives the same result as applying
+ * it to the finished node, and we don't need an offscreen for it. */
+static gboolean
+node_has_overlapping_content (GskRenderNode *node)
+{
+  switch (gsk_render_node_get_node_type (node))
+    {
+    /* One draw, or several that don't overlap */
+    case GSK_COLOR_NODE:
+    case GSK_TEXTURE_NODE:
+    case GSK_LINEAR_GRADIENT_NODE:
+    case GSK_REPEATING_LINEAR_GRADIENT_NODE:
+    case GSK_BORDER_NODE:
+    case GSK_INSET_SHADOW_NODE:
+    case GSK_OUTSET_SHADOW_NODE:
+    case GSK_CAIRO_NODE:
+    /* Glyphs only overlap for the odd combining mark */
+    case GSK_TEXT_NODE:
+    /* Drawn from a texture in the end */
+    case GSK_OPACITY_NODE:
+    case GSK_COLOR_MATRIX_NODE:
+    case GSK_BLUR_NODE:
+    case GSK_CROSS_FADE_NODE:
+    case GSK_BLEND_NODE:
+    case GSK_REPEAT_NODE:
+      return FALSE;
+
+    case GSK_DEBUG_NODE:
+      return node_has_overlapping_content (gsk_debug_node_get_child (node));
+
+    case GSK_OFFSET_NODE:
+      return node_has_overlapping_content (gsk_offset_node_get_child (node));
+
+    case GSK_TRANSFORM_NODE:
+      return node_has_overlapping_content (gsk_transform_node_get_child (node));
+
+    case GSK_CLIP_NODE:
+      return node_has_overlapping_content (gsk_clip_node_get_child (node));
+
+    case GSK_ROUNDED_CLIP_NODE:
+      return node_has_overlapping_content (gsk_rounded_clip_node_get_child (node));
+
+    case GSK_CONTAINER_NODE:
+      {
+        guint n = gsk_container_node_get_n_children (node);
+        graphene_rect_t *bounds;
+        gboolean overlap = FALSE;
+        guint i, j, n_bounds;
+
+        if (n == 1)
+          return node_has_overlapping_content (gsk_container_node_get_child (node, 0));
+
+        /* Lots of children are likely to overlap somewhere, and
+         * finding out gets expensive */
+        if (n > 64)
+          return TRUE;
+
+        bounds = g_newa (graphene_rect_t, n);
+        n_bounds = 0;
+
+        for (i = 0; i < n; i++)
+          {
+            GskRenderNode *child = gsk_container_node_get_child (node, i);
+
+            if (child->bounds.size.width <= 0 || child->bounds.size.height <= 0)
+              continue;
+
+            if (node_has_overlapping_content (child))
+              return TRUE;
+
+            bounds[n_bounds++] = child->bounds;
+          }
+
+        /* Sorted by their top edge, a child can only overlap the
+         * following ones that start above its bottom edge */
+        g_qsort_with_data (bounds, n_bounds, sizeof (graphene_rect_t), compare_rect_y, NULL);
+
+        for (i = 0; i < n_bounds && !overlap; i++)
+          {
+            const graphene_rect_t *a = &bounds[i];
+
+            for (j = i + 1; j < n_bounds; j++)
+              {
+                const graphene_rect_t *b = &bounds[j];
+
+                if (b->origin.y >= a->origin.y + a->size.height)
+                  break;
+
+                if (b->origin.x < a->origin.x + a->size.width &&
+                    a->origin.x < b->origin.x + b->size.width)
+                  {
+                    overlap = TRUE;
+                    break;
+                  }
+              }
+          }
+
+        return overlap;
+      }
+
+    case GSK_SHADOW_NODE:
+    case GSK_NOT_A_RENDER_NODE:
+    default:
+      return TRUE;
+    }
+}
+
 static inline void
-render_opacity_node (GskGLRenderer   *self,
-                     GskRenderNode   *node,
-                     RenderOpBuilder *builder)
+render_opacity_node (GskGLRenderer       *self,
+                     GskRenderNode       *node,
+                     RenderOpBuilder     *builder,
+                     const GskQuadVertex *vertex_data)
 {
+  GskRenderNode *child = gsk_opacity_node_get_child (node);
   float prev_opacity;
 
-  prev_opacity = ops_set_opacity (builder,
-                                  builder->current_opacity * gsk_opacity_node_get_opacity (node));
+  if (!node_has_overlapping_content (child))
+    {
+      prev_opacity = ops_set_opacity (builder,
+                                      builder->current_opacity * gsk_opacity_node_get_opacity (node));
+
+      gsk_gl_renderer_add_render_ops (self, child, builder);
+
+      ops_set_opacity (builder, prev_opacity);
+    }
+  else
+    {
+      const float min_x = builder->dx + node->bounds.origin.x;
+      const float min_y = builder->dy + node->bounds.origin.y;
+      const float max_x = min_x + node->bounds.size.width;
+      const float max_y = min_y + node->bounds.size.height;
+      int texture_id;
+      gboolean is_offscreen;
+
+      /* Overlapping draws would show through each other,
+       * so the opacity has to go on the finished child */
+      add_offscreen_ops (self, builder,
+                         &node->bounds,
+                         child,
+                         &texture_id, &is_offscreen,
+                         RESET_CLIP | RESET_OPACITY);
+
+      prev_opacity = ops_set_opacity (builder,
+                                      builder->current_opacity * gsk_opacity_node_get_opacity (node));
+
+      ops_set_program (builder, &self->blit_program);
+      ops_set_texture (builder, texture_id);
 
-  gsk_gl_renderer_add_render_ops (self, gsk_opacity_node_get_child (node), builder);
+      if (is_offscreen)
+        {
+          GskQuadVertex offscreen_vertex_data[GL_N_VERTICES] = {
+            { { min_x, min_y }, { 0, 1 }, },
+            { { min_x, max_y }, { 0, 0 }, },
+            { { max_x, min_y }, { 1, 1 }, },
+
+            { { max_x, max_y }, { 1, 0 }, },
+            { { min_x, max_y }, { 0, 0 }, },
+            { { max_x, min_y }, { 1, 1 }, },
+          };
 
-  ops_set_opacity (builder, prev_opacity);
+          ops_draw (builder, offscreen_vertex_data);
+        }
+      else
+        {
+          ops_draw (builder, vertex_data);
+        }
+
+      ops_set_opacity (builder, prev_opacity);
+    }
 }
 
 static inline void
@@ -892,6 +1227,7 @@ render_linear_gradient_node (GskGLRenderer       *self,
   op.linear_gradient.end_point = *end;
   op.linear_gradient.end_point.x += builder->dx;
   op.linear_gradient.end_point.y += builder->dy;
+  op.linear_gradient.repeat = gsk_render_node_get_node_type (node) == GSK_REPEATING_LINEAR_GRADIENT_NODE;
   ops_add (builder, &op);
 
   ops_draw (builder, vertex_data);
@@ -1207,7 +1543,9 @@ render_outset_shadow_node (GskGLRenderer       *self,
                            RenderOpBuilder     *builder)
 {
   const GskRoundedRect *outline = gsk_outset_shadow_node_peek_outline (node);
-  GskRoundedRect offset_outline;
+  GskShadowNineSlice slice;
+  GskShadowKey key;
+  const GskRoundedRect *offset_outline;
   const float blur_radius = gsk_outset_shadow_node_get_blur_radius (node);
   const float blur_extra = gsk_cairo_blur_compute_pixels (blur_radius);
   const float spread = gsk_outset_shadow_node_get_spread (node);
@@ -1224,43 +1562,34 @@ render_outset_shadow_node (GskGLRenderer       *self,
   graphene_rect_t prev_viewport;
   graphene_matrix_t item_proj;
   int blurred_texture_id;
-  int cached_tid;
 
   /* offset_outline is the minimal outline we need to draw the given drop shadow,
    * enlarged by the spread and offset by the blur radius. */
-  offset_outline = *outline;
-  /* Shrink our outline to the minimum size that can still hold all the border radii */
-  gsk_rounded_rect_shrink_to_minimum (&offset_outline);
-  /* Increase by the spread */
-  gsk_rounded_rect_shrink (&offset_outline, -spread, -spread, -spread, -spread);
-  /* No we need to incorporate the blur radius; since we blur an edge an equal blur_extra/2.0
-   * on both sides, the minimum side of both width and height needs to be blur_extra */
-  offset_outline.bounds.size.width = MAX (offset_outline.bounds.size.width, blur_extra);
-  offset_outline.bounds.size.height = MAX (offset_outline.bounds.size.height, blur_extra);
-  /* For the center part, we add a few pixels */
-  offset_outline.bounds.size.width += SHADOW_EXTRA_SIZE;
-  offset_outline.bounds.size.height += SHADOW_EXTRA_SIZE;
-  offset_outline.bounds.origin.x = blur_extra / 2.0f;
-  offset_outline.bounds.origin.y = blur_extra / 2.0f;
-
-  texture_width = offset_outline.bounds.size.width   + blur_extra;
-  texture_height = offset_outline.bounds.size.height + blur_extra;
-
-  cached_tid = gsk_gl_shadow_cache_get_texture_id (&self->shadow_cache,
-                                                   self->gl_driver,
-                                                   &offset_outline,
-                                                   blur_radius);
-  if (cached_tid == 0)
+  gsk_shadow_nine_slice_init (&slice, outline, spread, blur_extra / 2.0f);
+  offset_outline = &slice.outline;
+
+  texture_width = slice.width;
+  texture_height = slice.height;
+
+  key.outline = slice.outline;
+  key.blur_radius = blur_radius;
+  key.color = *gsk_outset_shadow_node_peek_color (node);
+  key.scale = 1;
+
+  blurred_texture_id = GPOINTER_TO_INT (gsk_shadow_cache_lookup (&self->shadow_cache, &key));
+  if (blurred_texture_id == 0)
     {
       int texture_id, render_target;
       int blurred_render_target;
       int prev_render_target;
       GskRoundedRect blit_clip;
 
-      texture_id = gsk_gl_driver_create_texture (self->gl_driver, texture_width, texture_height);
-      gsk_gl_driver_bind_source_texture (self->gl_driver, texture_id);
-      gsk_gl_driver_init_texture_empty (self->gl_driver, texture_id);
-      render_target = gsk_gl_driver_create_render_target (self->gl_driver, texture_id, FALSE, FALSE);
+      texture_id = gsk_gl_driver_create_render_target_texture (self->gl_driver,
+                                                               texture_width, texture_height,
+                                                               FALSE, FALSE,
+                                                               &render_target);
+      gsk_profiler_counter_inc (gsk_renderer_get_profiler (GSK_RENDERER (self)),
+                                self->profile_counters.offscreens);
 
 
       graphene_matrix_init_ortho (&item_proj,
@@ -1278,7 +1607,7 @@ render_outset_shadow_node (GskGLRenderer       *self,
 
       /* Draw outline */
       ops_set_program (builder, &self->color_program);
-      ops_push_clip (builder, &offset_outline);
+      ops_push_clip (builder, offset_outline);
       ops_set_color (builder, gsk_outset_shadow_node_peek_color (node));
       ops_draw (builder, (GskQuadVertex[GL_N_VERTICES]) {
         { { 0,                            }, { 0, 1 }, },
@@ -1303,6 +1632,9 @@ render_outset_shadow_node (GskGLRenderer       *self,
       gsk_rounded_rect_init_from_rect (&blit_clip,
                                        &GRAPHENE_RECT_INIT (0, 0, texture_width, texture_height), 0.0f);
 
+      /* Push the clip first, it decides which variant of the program
+       * the blur uniforms go to */
+      ops_push_clip (builder, &blit_clip);
       ops_set_program (builder, &self->blur_program);
       op.op = OP_CHANGE_BLUR;
       op.blur.size.width = texture_width;
@@ -1310,7 +1642,6 @@ render_outset_shadow_node (GskGLRenderer       *self,
       op.blur.radius = blur_radius;
       ops_add (builder, &op);
 
-      ops_push_clip (builder, &blit_clip);
       ops_set_texture (builder, texture_id);
       ops_draw (builder, (GskQuadVertex[GL_N_VERTICES]) {
         { { 0,             0              }, { 0, 1 }, },
@@ -1329,14 +1660,8 @@ render_outset_shadow_node (GskGLRenderer       *self,
       ops_set_projection (builder, &prev_projection);
       ops_set_render_target (builder, prev_render_target);
 
-      gsk_gl_shadow_cache_commit (&self->shadow_cache,
-                                  &offset_outline,
-                                  blur_radius,
-                                  blurred_texture_id);
-    }
-  else
-    {
-      blurred_texture_id = cached_tid;
+      gsk_shadow_cache_insert (&self->shadow_cache, &key, GINT_TO_POINTER (blurred_texture_id),
+                               (gsize) texture_width * texture_height * 4);
     }
 
   ops_set_program (builder, &self->outset_shadow_program);
@@ -1351,18 +1676,12 @@ render_outset_shadow_node (GskGLRenderer       *self,
 
   /* We use the one outset shadow op from above to draw all 8 sides/corners. */
   {
-    const GskRoundedRect *o = &offset_outline;
-    float top_height = MAX (o->corner[0].height, o->corner[1].height);
-    float bottom_height = MAX (o->corner[2].height, o->corner[3].height);
-    float left_width = MAX (o->corner[0].width, o->corner[3].width);
-    float right_width = MAX (o->corner[1].width, o->corner[2].width);
+    const float top_height = slice.top;
+    const float bottom_height = slice.bottom;
+    const float left_width = slice.left;
+    const float right_width = slice.right;
     float x1, x2, y1, y2, tx1, tx2, ty1, ty2;
 
-    top_height    = MAX (top_height,    blur_extra / 2.0f) + (blur_extra / 2.0f);
-    bottom_height = MAX (bottom_height, blur_extra / 2.0f) + (blur_extra / 2.0f);
-    left_width    = MAX (left_width,    blur_extra / 2.0f) + (blur_extra / 2.0f);
-    right_width   = MAX (right_width,   blur_extra / 2.0f) + (blur_extra / 2.0f);
-
     /* Top left */
     if (top_height > 0 && left_width > 0)
       {
@@ -1460,8 +1779,8 @@ render_outset_shadow_node (GskGLRenderer       *self,
         y2 = max_y + dy - bottom_height;
         tx1 = 0;
         tx2 = left_width / texture_width;
-        ty1 = 0.5f - SHADOW_EXTRA_SIZE / 2.0f / texture_height;
-        ty2 = ty1 + (SHADOW_EXTRA_SIZE / texture_height);
+        ty1 = 0.5f - GSK_SHADOW_STRETCH_SIZE / 2.0f / texture_height;
+        ty2 = ty1 + (GSK_SHADOW_STRETCH_SIZE / texture_height);
         ops_draw (builder, (GskQuadVertex[GL_N_VERTICES]) {
           { { x1, y1 }, { tx1, ty2 }, },
           { { x1, y2 }, { tx1, ty1 }, },
@@ -1482,8 +1801,8 @@ render_outset_shadow_node (GskGLRenderer       *self,
         y2 = max_y + dy - bottom_height;
         tx1 = 1 - (right_width / texture_width);
         tx2 = 1;
-        ty1 = 0.5f - SHADOW_EXTRA_SIZE / 2.0f / texture_height;
-        ty2 = ty1 + (SHADOW_EXTRA_SIZE / texture_height);
+        ty1 = 0.5f - GSK_SHADOW_STRETCH_SIZE / 2.0f / texture_height;
+        ty2 = ty1 + (GSK_SHADOW_STRETCH_SIZE / texture_height);
         ops_draw (builder, (GskQuadVertex[GL_N_VERTICES]) {
           { { x1, y1 }, { tx1, ty2 }, },
           { { x1, y2 }, { tx1, ty1 }, },
@@ -1502,8 +1821,8 @@ render_outset_shadow_node (GskGLRenderer       *self,
         x2 = max_x + dx - right_width;
         y1 = min_y + dy;
         y2 = min_y + dy + top_height;
-        tx1 = 0.5f - (SHADOW_EXTRA_SIZE / 2.0f / texture_width);
-        tx2 = tx1 + (SHADOW_EXTRA_SIZE / texture_width);
+        tx1 = 0.5f - (GSK_SHADOW_STRETCH_SIZE / 2.0f / texture_width);
+        tx2 = tx1 + (GSK_SHADOW_STRETCH_SIZE / texture_width);
         ty1 = 1 - (top_height / texture_height);
         ty2 = 1;
         ops_draw (builder, (GskQuadVertex[GL_N_VERTICES]) {
@@ -1524,8 +1843,8 @@ render_outset_shadow_node (GskGLRenderer       *self,
         x2 = max_x + dx - right_width;
         y1 = max_y + dy - bottom_height;
         y2 = max_y + dy;
-        tx1 = 0.5f - (SHADOW_EXTRA_SIZE / 2.0f / texture_width);
-        tx2 = tx1 + (SHADOW_EXTRA_SIZE / texture_width);
+        tx1 = 0.5f - (GSK_SHADOW_STRETCH_SIZE / 2.0f / texture_width);
+        tx2 = tx1 + (GSK_SHADOW_STRETCH_SIZE / texture_width);
         ty1 = 0;
         ty2 = bottom_height / texture_height;
         ops_draw (builder, (GskQuadVertex[GL_N_VERTICES]) {
@@ -1546,10 +1865,10 @@ render_outset_shadow_node (GskGLRenderer       *self,
     y2 = max_y + dy - bottom_height;
     if (x2 > x1 && y2 > y1)
       {
-        tx1 = (texture_width - SHADOW_EXTRA_SIZE)  / 2.0f / texture_width;
-        tx2 = (texture_width + SHADOW_EXTRA_SIZE)  / 2.0f / texture_width;
-        ty1 = (texture_height - SHADOW_EXTRA_SIZE) / 2.0f / texture_height;
-        ty2 = (texture_height + SHADOW_EXTRA_SIZE) / 2.0f / texture_height;
+        tx1 = (texture_width - GSK_SHADOW_STRETCH_SIZE)  / 2.0f / texture_width;
+        tx2 = (texture_width + GSK_SHADOW_STRETCH_SIZE)  / 2.0f / texture_width;
+        ty1 = (texture_height - GSK_SHADOW_STRETCH_SIZE) / 2.0f / texture_height;
+        ty2 = (texture_height + GSK_SHADOW_STRETCH_SIZE) / 2.0f / texture_height;
         ops_draw (builder, (GskQuadVertex[GL_N_VERTICES]) {
           { { x1, y1 }, { tx1, ty2 }, },
           { { x1, y2 }, { tx1, ty1 }, },
@@ -1719,6 +2038,109 @@ render_cross_fade_node (GskGLRenderer       *self,
   ops_draw (builder, vertex_data);
 }
 
+static inline void
+render_blend_node (GskGLRenderer   *self,
+                   GskRenderNode   *node,
+                   RenderOpBuilder *builder)
+{
+  GskRenderNode *top_child = gsk_blend_node_get_top_child (node);
+  GskRenderNode *bottom_child = gsk_blend_node_get_bottom_child (node);
+  const float min_x = builder->dx + node->bounds.origin.x;
+  const float min_y = builder->dy + node->bounds.origin.y;
+  const float max_x = min_x + node->bounds.size.width;
+  const float max_y = min_y + node->bounds.size.height;
+  int top_texture_id;
+  int bottom_texture_id;
+  gboolean is_offscreen1, is_offscreen2;
+  RenderOp op;
+  const GskQuadVertex vertex_data[GL_N_VERTICES] = {
+    { { min_x, min_y }, { 0, 1 }, },
+    { { min_x, max_y }, { 0, 0 }, },
+    { { max_x, min_y }, { 1, 1 }, },
+
+    { { max_x, max_y }, { 1, 0 }, },
+    { { min_x, max_y }, { 0, 0 }, },
+    { { max_x, min_y }, { 1, 1 }, },
+  };
+
+  /* Both children are drawn into an offscreen the size of the blend node,
+   * so the same texture coordinates work for both of them. */
+  add_offscreen_ops (self, builder,
+                     &node->bounds,
+                     top_child,
+                     &top_texture_id, &is_offscreen1,
+                     FORCE_OFFSCREEN | RESET_CLIP | RESET_OPACITY);
+
+  add_offscreen_ops (self, builder,
+                     &node->bounds,
+                     bottom_child,
+                     &bottom_texture_id, &is_offscreen2,
+                     FORCE_OFFSCREEN | RESET_CLIP | RESET_OPACITY);
+
+  ops_set_program (builder, &self->blend_program);
+  ops_set_texture (builder, top_texture_id);
+  op.op = OP_CHANGE_BLEND;
+  op.blend.source2 = bottom_texture_id;
+  op.blend.mode = gsk_blend_node_get_blend_mode (node);
+  ops_add (builder, &op);
+
+  ops_draw (builder, vertex_data);
+}
+
+static inline void
+render_repeat_node (GskGLRenderer   *self,
+                    GskRenderNode   *node,
+                    RenderOpBuilder *builder)
+{
+  GskRenderNode *child = gsk_repeat_node_get_child (node);
+  const graphene_rect_t *child_bounds = gsk_repeat_node_peek_child_bounds (node);
+  const float min_x = builder->dx + node->bounds.origin.x;
+  const float min_y = builder->dy + node->bounds.origin.y;
+  const float max_x = min_x + node->bounds.size.width;
+  const float max_y = min_y + node->bounds.size.height;
+  float tx1, tx2, ty1, ty2;
+  int texture_id;
+  gboolean is_offscreen;
+
+  if (child_bounds->size.width <= 0 || child_bounds->size.height <= 0)
+    return;
+
+  /* We draw the repeated area of the child only once and let the repeat
+   * program wrap the texture coordinates around. If the child is a texture
+   * node covering exactly the repeated area, we can use that one directly. */
+  add_offscreen_ops (self, builder,
+                     child_bounds,
+                     child,
+                     &texture_id, &is_offscreen,
+                     (graphene_rect_equal (child_bounds, &child->bounds) ? 0 : FORCE_OFFSCREEN) |
+                     RESET_CLIP | RESET_OPACITY);
+
+  /* Texture coordinates in units of the child bounds */
+  tx1 = (node->bounds.origin.x - child_bounds->origin.x) / child_bounds->size.width;
+  tx2 = tx1 + node->bounds.size.width / child_bounds->size.width;
+  ty1 = (node->bounds.origin.y - child_bounds->origin.y) / child_bounds->size.height;
+  ty2 = ty1 + node->bounds.size.height / child_bounds->size.height;
+
+  /* Offscreen textures are upside down */
+  if (is_offscreen)
+    {
+      ty1 = 1 - ty1;
+      ty2 = 1 - ty2;
+    }
+
+  ops_set_program (builder, &self->repeat_program);
+  ops_set_texture (builder, texture_id);
+  ops_draw (builder, (GskQuadVertex[GL_N_VERTICES]) {
+    { { min_x, min_y }, { tx1, ty1 }, },
+    { { min_x, max_y }, { tx1, ty2 }, },
+    { { max_x, min_y }, { tx2, ty1 }, },
+
+    { { max_x, max_y }, { tx2, ty2 }, },
+    { { min_x, max_y }, { tx1, ty2 }, },
+    { { max_x, min_y }, { tx2, ty1 }, },
+  });
+}
+
 static inline void
 apply_viewport_op (const Program  *program,
                    const RenderOp *op)
@@ -1923,6 +2345,7 @@ apply_linear_gradient_op (const Program  *program,
                op->linear_gradient.start_point.x, op->linear_gradient.start_point.y);
   glUniform2f (program->linear_gradient.end_point_location,
                op->linear_gradient.end_point.x, op->linear_gradient.end_point.y);
+  glUniform1i (program->linear_gradient.repeat_location, op->linear_gradient.repeat);
 }
 
 static inline void
@@ -1993,26 +2416,57 @@ apply_cross_fade_op (const Program  *program,
   glUniform1f (program->cross_fade.progress_location, op->cross_fade.progress);
 }
 
+static inline void
+apply_blend_op (const Program  *program,
+                const RenderOp *op)
+{
+  OP_PRINT (" -> Blend mode %d", op->blend.mode);
+  /* Bottom texture id */
+  glUniform1i (program->blend.source2_location, 1);
+  glActiveTexture (GL_TEXTURE0 + 1);
+  glBindTexture (GL_TEXTURE_2D, op->blend.source2);
+  glUniform1i (program->blend.mode_location, op->blend.mode);
+}
+
 static void
 gsk_gl_renderer_dispose (GObject *gobject)
 {
   GskGLRenderer *self = GSK_GL_RENDERER (gobject);
 
   g_clear_pointer (&self->render_ops, g_array_unref);
+  g_clear_pointer (&self->glyph_instances, g_array_unref);
+  g_clear_pointer (&self->pending_glyphs, g_array_unref);
 
   G_OBJECT_CLASS (gsk_gl_renderer_parent_class)->dispose (gobject);
 }
 
+static gboolean
+gl_has_instancing (GdkGLContext *context)
+{
+  if (gdk_gl_context_get_use_es (context))
+    return epoxy_gl_version () >= 30;
+
+  return epoxy_gl_version () >= 33 ||
+         (epoxy_has_gl_extension ("GL_ARB_instanced_arrays") &&
+          epoxy_has_gl_extension ("GL_ARB_draw_instanced"));
+}
+
 static gboolean
 gsk_gl_renderer_create_programs (GskGLRenderer  *self,
                                  GError        **error)
 {
   GskShaderBuilder *builder;
   GError *shader_error = NULL;
-  int i;
+  int i, clip_mode;
+  static const char *clip_mode_defines[N_CLIP_MODES] = {
+    "GSK_NO_CLIP",
+    "GSK_RECT_CLIP",
+    NULL
+  };
   static const struct {
     const char *name;
     const char *fs;
+    const char *vs; /* NULL for blit.vs.glsl */
   } program_definitions[] = {
     { "blit",            "blit.fs.glsl" },
     { "color",           "color.fs.glsl" },
@@ -2025,6 +2479,9 @@ gsk_gl_renderer_create_programs (GskGLRenderer  *self,
     { "unblurred outset shadow",   "unblurred_outset_shadow.fs.glsl" },
     { "border",          "border.fs.glsl" },
     { "cross fade",      "cross_fade.fs.glsl" },
+    { "blend",           "blend.fs.glsl" },
+    { "repeat",          "repeat.fs.glsl" },
+    { "glyph",           "glyph.fs.glsl", "glyph.vs.glsl" },
   };
 
   builder = gsk_shader_builder_new ();
@@ -2065,6 +2522,16 @@ gsk_gl_renderer_create_programs (GskGLRenderer  *self,
     gsk_shader_builder_add_define (builder, "GSK_DEBUG", "1");
 #endif
 
+  gsk_shader_builder_enable_program_cache (builder);
+
+  /* gsk_gl_renderer_render_ops() sets up the vertex data for these */
+  gsk_shader_builder_bind_attribute (builder, "aPosition", 0);
+  gsk_shader_builder_bind_attribute (builder, "aUv", 1);
+  gsk_shader_builder_bind_attribute (builder, "aGlyphRect", 2);
+  gsk_shader_builder_bind_attribute (builder, "aGlyphUv", 3);
+  gsk_shader_builder_bind_attribute (builder, "aGlyphColor", 4);
+  gsk_shader_builder_bind_attribute (builder, "aGlyphRecolor", 5);
+
   gsk_shader_builder_set_common_vertex_shader (builder, "blit.vs.glsl",
                                                &shader_error);
 
@@ -2072,33 +2539,50 @@ gsk_gl_renderer_create_programs (GskGLRenderer  *self,
 
   for (i = 0; i < GL_N_PROGRAMS; i ++)
     {
-      Program *prog = &self->programs[i];
-
-      prog->index = i;
-      prog->id = gsk_shader_builder_create_program (builder,
-                                                    program_definitions[i].fs,
-                                                    &shader_error);
+      Program *variants[N_CLIP_MODES];
 
-      if (shader_error != NULL)
+      for (clip_mode = 0; clip_mode < N_CLIP_MODES; clip_mode++)
         {
-          g_propagate_prefixed_error (error, shader_error,
-                                      "Unable to create '%s' program (from %s and %s):\n",
-                                      program_definitions[i].name,
-                                      "blit.vs.glsl",
-                                      program_definitions[i].fs);
-
-          g_object_unref (builder);
-          return FALSE;
+          if (clip_mode == CLIP_MODE_ROUNDED)
+            variants[clip_mode] = &self->programs[i];
+          else
+            variants[clip_mode] = &self->clip_variants[clip_mode][i];
         }
 
-      INIT_COMMON_UNIFORM_LOCATION (prog, alpha);
-      INIT_COMMON_UNIFORM_LOCATION (prog, source);
-      INIT_COMMON_UNIFORM_LOCATION (prog, clip);
-      INIT_COMMON_UNIFORM_LOCATION (prog, clip_corner_widths);
-      INIT_COMMON_UNIFORM_LOCATION (prog, clip_corner_heights);
-      INIT_COMMON_UNIFORM_LOCATION (prog, viewport);
-      INIT_COMMON_UNIFORM_LOCATION (prog, projection);
-      INIT_COMMON_UNIFORM_LOCATION (prog, modelview);
+      for (clip_mode = 0; clip_mode < N_CLIP_MODES; clip_mode++)
+        {
+          Program *prog = variants[clip_mode];
+
+          prog->index = clip_mode * GL_N_PROGRAMS + i;
+          prog->clip_mode = clip_mode;
+          memcpy (prog->variants, variants, sizeof (variants));
+          prog->id = gsk_shader_builder_create_program_full (builder,
+                                                             program_definitions[i].vs,
+                                                             program_definitions[i].fs,
+                                                             clip_mode_defines[clip_mode],
+                                                             &shader_error);
+
+          if (shader_error != NULL)
+            {
+              g_propagate_prefixed_error (error, shader_error,
+                                          "Unable to create '%s' program (from %s and %s):\n",
+                                          program_definitions[i].name,
+                                          program_definitions[i].vs ? program_definitions[i].vs : "blit.vs.glsl",
+                                          program_definitions[i].fs);
+
+              g_object_unref (builder);
+              return FALSE;
+            }
+
+          INIT_COMMON_UNIFORM_LOCATION (prog, alpha);
+          INIT_COMMON_UNIFORM_LOCATION (prog, source);
+          INIT_COMMON_UNIFORM_LOCATION (prog, clip);
+          INIT_COMMON_UNIFORM_LOCATION (prog, clip_corner_widths);
+          INIT_COMMON_UNIFORM_LOCATION (prog, clip_corner_heights);
+          INIT_COMMON_UNIFORM_LOCATION (prog, viewport);
+          INIT_COMMON_UNIFORM_LOCATION (prog, projection);
+          INIT_COMMON_UNIFORM_LOCATION (prog, modelview);
+        }
     }
 
   /* color */
@@ -2117,6 +2601,7 @@ gsk_gl_renderer_create_programs (GskGLRenderer  *self,
   INIT_PROGRAM_UNIFORM_LOCATION (linear_gradient, num_color_stops);
   INIT_PROGRAM_UNIFORM_LOCATION (linear_gradient, start_point);
   INIT_PROGRAM_UNIFORM_LOCATION (linear_gradient, end_point);
+  INIT_PROGRAM_UNIFORM_LOCATION (linear_gradient, repeat);
 
   /* blur */
   INIT_PROGRAM_UNIFORM_LOCATION (blur, blur_radius);
@@ -2155,10 +2640,42 @@ gsk_gl_renderer_create_programs (GskGLRenderer  *self,
   INIT_PROGRAM_UNIFORM_LOCATION (cross_fade, progress);
   INIT_PROGRAM_UNIFORM_LOCATION (cross_fade, source2);
 
+  /* blend */
+  INIT_PROGRAM_UNIFORM_LOCATION (blend, source2);
+  INIT_PROGRAM_UNIFORM_LOCATION (blend, mode);
+
   g_object_unref (builder);
   return TRUE;
 }
 
+static void
+destroy_shadow_texture (gpointer data,
+                        gpointer user_data)
+{
+  gsk_gl_driver_destroy_texture (user_data, GPOINTER_TO_INT (data));
+}
+
+static void
+shadow_cache_get_size (gpointer  data,
+                       gsize    *cpu_bytes,
+                       gsize    *gpu_bytes)
+{
+  GskGLRenderer *self = data;
+
+  *cpu_bytes = 0;
+  *gpu_bytes = gsk_shadow_cache_get_size (&self->shadow_cache);
+}
+
+static void
+shadow_cache_trim (gpointer data,
+                   gsize    max_bytes)
+{
+  GskGLRenderer *self = data;
+
+  gdk_gl_context_make_current (self->gl_context);
+  gsk_shadow_cache_trim_size (&self->shadow_cache, max_bytes);
+}
+
 static gboolean
 gsk_gl_renderer_realize (GskRenderer  *renderer,
                          GdkSurface    *surface,
@@ -2189,8 +2706,17 @@ gsk_gl_renderer_realize (GskRenderer  *renderer,
   if (!gsk_gl_renderer_create_programs (self, error))
     return FALSE;
 
+  self->has_instancing = gl_has_instancing (self->gl_context);
+  GSK_RENDERER_NOTE (renderer, OPENGL,
+                     g_message ("Instanced glyphs: %s", self->has_instancing ? "yes" : "no"));
+
   gsk_gl_glyph_cache_init (&self->glyph_cache, renderer, self->gl_driver);
-  gsk_gl_shadow_cache_init (&self->shadow_cache);
+  gsk_shadow_cache_init (&self->shadow_cache, destroy_shadow_texture, self->gl_driver);
+  self->shadow_cache_entry = gdk_cache_register ("shadows", 0,
+                                                 shadow_cache_get_size,
+                                                 shadow_cache_trim,
+                                                 self);
+  gsk_gl_layer_cache_init (&self->layer_cache);
 
   return TRUE;
 }
@@ -2210,12 +2736,19 @@ gsk_gl_renderer_unrealize (GskRenderer *renderer)
    * as they will be dropped when we finalize the GskGLDriver
    */
   g_array_set_size (self->render_ops, 0);
+  g_array_set_size (self->glyph_instances, 0);
 
   for (i = 0; i < GL_N_PROGRAMS; i ++)
-    glDeleteProgram (self->programs[i].id);
+    {
+      glDeleteProgram (self->programs[i].id);
+      glDeleteProgram (self->clip_variants[CLIP_MODE_NONE][i].id);
+      glDeleteProgram (self->clip_variants[CLIP_MODE_RECT][i].id);
+    }
 
   gsk_gl_glyph_cache_free (&self->glyph_cache);
-  gsk_gl_shadow_cache_free (&self->shadow_cache, self->gl_driver);
+  g_clear_pointer (&self->shadow_cache_entry, gdk_cache_unregister);
+  gsk_shadow_cache_free (&self->shadow_cache);
+  gsk_gl_layer_cache_free (&self->layer_cache, self->gl_driver);
 
   g_clear_object (&self->gl_profiler);
   g_clear_object (&self->gl_driver);
@@ -2237,6 +2770,7 @@ gsk_gl_renderer_clear_tree (GskGLRenderer *self)
   gdk_gl_context_make_current (self->gl_context);
 
   g_array_remove_range (self->render_ops, 0, self->render_ops->len);
+  g_array_set_size (self->glyph_instances, 0);
   removed_textures = gsk_gl_driver_collect_textures (self->gl_driver);
 
   GSK_RENDERER_NOTE (GSK_RENDERER (self), OPENGL, g_message ("Collected: %d textures", removed_textures));
@@ -2263,10 +2797,8 @@ gsk_gl_renderer_setup_render_mode (GskGLRenderer *self)
       cairo_rectangle_int_t extents;
       int surface_height;
 
-      g_assert (cairo_region_num_rectangles (self->render_region) == 1);
-
       surface_height = gdk_surface_get_height (surface) * self->scale_factor;
-      cairo_region_get_rectangle (self->render_region, 0, &extents);
+      cairo_region_get_rectangle (self->render_region, self->render_region_rect, &extents);
 
       glEnable (GL_SCISSOR_TEST);
       glScissor (extents.x * self->scale_factor,
@@ -2277,6 +2809,77 @@ gsk_gl_renderer_setup_render_mode (GskGLRenderer *self)
 }
 
 
+/* Draws @node from its layer texture, rendering it into that first if
+ * necessary. Returns %FALSE if @node can't be drawn as a layer, in which
+ * case it needs to be drawn normally. */
+static gboolean
+render_layer (GskGLRenderer   *self,
+              GskRenderNode   *node,
+              RenderOpBuilder *builder)
+{
+  const float scale = ops_get_scale (builder);
+  const float min_x = builder->dx + node->bounds.origin.x;
+  const float min_y = builder->dy + node->bounds.origin.y;
+  const float max_x = min_x + node->bounds.size.width;
+  const float max_y = min_y + node->bounds.size.height;
+  int texture_id;
+
+  texture_id = gsk_gl_layer_cache_get_texture_id (&self->layer_cache, self->gl_driver, node, scale);
+
+  if (texture_id == 0)
+    {
+      const int max_texture_size = gsk_gl_driver_get_max_texture_size (self->gl_driver);
+      const float width = node->bounds.size.width * scale;
+      const float height = node->bounds.size.height * scale;
+      GskRenderNode *prev_layer;
+      int render_target;
+
+      if (ceilf (width) > max_texture_size || ceilf (height) > max_texture_size)
+        return FALSE;
+
+      texture_id = gsk_gl_driver_create_permanent_texture (self->gl_driver, width, height);
+      gsk_gl_driver_bind_source_texture (self->gl_driver, texture_id);
+      gsk_gl_driver_init_texture_empty (self->gl_driver, texture_id);
+      render_target = gsk_gl_driver_create_render_target (self->gl_driver, texture_id, TRUE, TRUE);
+
+      prev_layer = self->current_layer;
+      self->current_layer = node;
+      add_offscreen_ops_for_render_target (self, builder, &node->bounds, node, render_target,
+                                           RESET_CLIP | RESET_OPACITY);
+      self->current_layer = prev_layer;
+
+      gsk_gl_layer_cache_commit (&self->layer_cache, node, scale, texture_id);
+    }
+
+  ops_set_program (builder, &self->blit_program);
+  ops_set_texture (builder, texture_id);
+  ops_draw (builder, (GskQuadVertex[GL_N_VERTICES]) {
+    { { min_x, min_y }, { 0, 1 }, },
+    { { min_x, max_y }, { 0, 0 }, },
+    { { max_x, min_y }, { 1, 1 }, },
+
+    { { max_x, max_y }, { 1, 0 }, },
+    { { min_x, max_y }, { 0, 0 }, },
+    { { max_x, min_y }, { 1, 1 }, },
+  });
+
+  return TRUE;
+}
+
+static inline gboolean
+node_is_outside_clip (const RenderOpBuilder *builder,
+                      const GskRenderNode   *node)
+{
+  graphene_rect_t transformed_node_bounds;
+
+  ops_transform_bounds_modelview (builder,
+                                  &node->bounds,
+                                  &transformed_node_bounds);
+
+  return !graphene_rect_intersection (&builder->current_clip->bounds,
+                                      &transformed_node_bounds, NULL);
+}
+
 static void
 gsk_gl_renderer_add_render_ops (GskGLRenderer   *self,
                                 GskRenderNode   *node,
@@ -2302,19 +2905,19 @@ gsk_gl_renderer_add_render_ops (GskGLRenderer   *self,
   if (node->bounds.size.width == 0.0f || node->bounds.size.height == 0.0f)
     return;
 
-  /* Check whether the render node is entirely out of the current
-   * already transformed clip region */
-  {
-    graphene_rect_t transformed_node_bounds;
-
-    ops_transform_bounds_modelview (builder,
-                                    &node->bounds,
-                                    &transformed_node_bounds);
-
-    if (!graphene_rect_intersection (&builder->current_clip->bounds,
-                                     &transformed_node_bounds, NULL))
+  /* Skip the whole subtree if it is entirely out of the current
+   * already transformed clip region, e.g. the children of a scrolled
+   * container that are not in view */
+  if (node_is_outside_clip (builder, node))
+    {
+      gsk_profiler_counter_inc (gsk_renderer_get_profiler (GSK_RENDERER (self)),
+                                self->profile_counters.culled_nodes);
       return;
-  }
+    }
+
+  if (node->cache_hint && node != self->current_layer &&
+      render_layer (self, node, builder))
+    return;
 
   switch (gsk_render_node_get_node_type (node))
     {
@@ -2323,13 +2926,28 @@ gsk_gl_renderer_add_render_ops (GskGLRenderer   *self,
 
     case GSK_CONTAINER_NODE:
       {
+        graphene_rect_t clip;
         guint i, p;
 
-        for (i = 0, p = gsk_container_node_get_n_children (node); i < p; i ++)
+        p = gsk_container_node_get_n_children (node);
+
+        /* Let the container skip groups of children outside of the clip.
+         * Those don't show up in the culled-nodes counter. */
+        if (ops_untransform_bounds_modelview (builder, &builder->current_clip->bounds, &clip))
           {
-            GskRenderNode *child = gsk_container_node_get_child (node, i);
+            for (i = gsk_container_node_find_child (node, &clip, 0);
+                 i < p;
+                 i = gsk_container_node_find_child (node, &clip, i + 1))
+              gsk_gl_renderer_add_render_ops (self, gsk_container_node_get_child (node, i), builder);
+          }
+        else
+          {
+            for (i = 0; i < p; i ++)
+              {
+                GskRenderNode *child = gsk_container_node_get_child (node, i);
 
-            gsk_gl_renderer_add_render_ops (self, child, builder);
+                gsk_gl_renderer_add_render_ops (self, child, builder);
+              }
           }
       }
     break;
@@ -2357,10 +2975,11 @@ gsk_gl_renderer_add_render_ops (GskGLRenderer   *self,
     break;
 
     case GSK_OPACITY_NODE:
-      render_opacity_node (self, node, builder);
+      render_opacity_node (self, node, builder, vertex_data);
     break;
 
     case GSK_LINEAR_GRADIENT_NODE:
+    case GSK_REPEATING_LINEAR_GRADIENT_NODE:
       render_linear_gradient_node (self, node, builder, vertex_data);
     break;
 
@@ -2408,9 +3027,14 @@ gsk_gl_renderer_add_render_ops (GskGLRenderer   *self,
       render_cross_fade_node (self, node, builder);
     break;
 
-    case GSK_REPEATING_LINEAR_GRADIENT_NODE:
     case GSK_BLEND_NODE:
+      render_blend_node (self, node, builder);
+    break;
+
     case GSK_REPEAT_NODE:
+      render_repeat_node (self, node, builder);
+    break;
+
     case GSK_CAIRO_NODE:
     default:
       {
@@ -2431,16 +3055,7 @@ add_offscreen_ops (GskGLRenderer         *self,
   const float scale = ops_get_scale (builder);
   const float width  = bounds->size.width  * scale;
   const float height = bounds->size.height * scale;
-  const float dx = builder->dx;
-  const float dy = builder->dy;
   int render_target;
-  int prev_render_target;
-  RenderOp op;
-  graphene_matrix_t identity;
-  graphene_matrix_t prev_projection;
-  graphene_rect_t prev_viewport;
-  graphene_matrix_t item_proj;
-  float prev_opacity;
   int texture_id = 0;
 
   /* We need the child node as a texture. If it already is one, we don't need to draw
@@ -2449,12 +3064,13 @@ add_offscreen_ops (GskGLRenderer         *self,
       (flags & FORCE_OFFSCREEN) == 0)
     {
       GdkTexture *texture = gsk_texture_node_get_texture (child_node);
-      int gl_min_filter = GL_NEAREST, gl_mag_filter = GL_NEAREST;
+      int gl_min_filter, gl_mag_filter, level;
 
-      get_gl_scaling_filters (child_node, &gl_min_filter, &gl_mag_filter);
+      get_gl_scaling_filters (self, builder, child_node, &gl_min_filter, &gl_mag_filter, &level);
 
       *texture_id_out = gsk_gl_driver_get_texture_for_texture (self->gl_driver,
                                                                texture,
+                                                               level,
                                                                gl_min_filter,
                                                                gl_mag_filter);
       *is_offscreen = FALSE;
@@ -2474,10 +3090,44 @@ add_offscreen_ops (GskGLRenderer         *self,
       }
   }
 
-  texture_id = gsk_gl_driver_create_texture (self->gl_driver, width, height);
-  gsk_gl_driver_bind_source_texture (self->gl_driver, texture_id);
-  gsk_gl_driver_init_texture_empty (self->gl_driver, texture_id);
-  render_target = gsk_gl_driver_create_render_target (self->gl_driver, texture_id, TRUE, TRUE);
+  texture_id = gsk_gl_driver_create_render_target_texture (self->gl_driver,
+                                                           width, height,
+                                                           TRUE, TRUE,
+                                                           &render_target);
+
+  add_offscreen_ops_for_render_target (self, builder, bounds, child_node, render_target, flags);
+
+  *is_offscreen = TRUE;
+  *texture_id_out = texture_id;
+
+  gsk_gl_driver_set_texture_for_pointer (self->gl_driver, child_node, texture_id);
+}
+
+/* Renders @child_node into @render_target, whose texture is expected to
+ * match @bounds at the current scale */
+static void
+add_offscreen_ops_for_render_target (GskGLRenderer         *self,
+                                     RenderOpBuilder       *builder,
+                                     const graphene_rect_t *bounds,
+                                     GskRenderNode         *child_node,
+                                     int                    render_target,
+                                     guint                  flags)
+{
+  const float scale = ops_get_scale (builder);
+  const float width  = bounds->size.width  * scale;
+  const float height = bounds->size.height * scale;
+  const float dx = builder->dx;
+  const float dy = builder->dy;
+  int prev_render_target;
+  RenderOp op;
+  graphene_matrix_t identity;
+  graphene_matrix_t prev_projection;
+  graphene_rect_t prev_viewport;
+  graphene_matrix_t item_proj;
+  float prev_opacity;
+
+  gsk_profiler_counter_inc (gsk_renderer_get_profiler (GSK_RENDERER (self)),
+                            self->profile_counters.offscreens);
 
   graphene_matrix_init_ortho (&item_proj,
                               bounds->origin.x * scale,
@@ -2525,11 +3175,6 @@ add_offscreen_ops (GskGLRenderer         *self,
   ops_pop_modelview (builder);
   ops_set_projection (builder, &prev_projection);
   ops_set_render_target (builder, prev_render_target);
-
-  *is_offscreen = TRUE;
-  *texture_id_out = texture_id;
-
-  gsk_gl_driver_set_texture_for_pointer (self->gl_driver, child_node, texture_id);
 }
 
 static void
@@ -2538,6 +3183,7 @@ gsk_gl_renderer_render_ops (GskGLRenderer *self,
 {
   guint i;
   guint n_ops = self->render_ops->len;
+  guint n_draws = 0;
   const Program *program = NULL;
   gsize buffer_index = 0;
   float *vertex_data = g_malloc (vertex_data_size);
@@ -2546,6 +3192,49 @@ gsk_gl_renderer_render_ops (GskGLRenderer *self,
 
 
   GLuint buffer_id, vao_id;
+  GLuint glyph_buffer_id = 0, glyph_vao_id = 0;
+
+  if (self->glyph_instances->len > 0)
+    {
+      /* One unit quad, followed by the instances */
+      static const GskQuadVertex unit_quad[GL_N_VERTICES] = {
+        { { 0, 0 }, { 0, 0 }, },
+        { { 0, 1 }, { 0, 1 }, },
+        { { 1, 0 }, { 1, 0 }, },
+
+        { { 1, 1 }, { 1, 1 }, },
+        { { 0, 1 }, { 0, 1 }, },
+        { { 1, 0 }, { 1, 0 }, },
+      };
+      const gsize instances_size = self->glyph_instances->len * sizeof (GlyphInstance);
+
+      glGenVertexArrays (1, &glyph_vao_id);
+      glBindVertexArray (glyph_vao_id);
+
+      glGenBuffers (1, &glyph_buffer_id);
+      glBindBuffer (GL_ARRAY_BUFFER, glyph_buffer_id);
+      glBufferData (GL_ARRAY_BUFFER, sizeof (unit_quad) + instances_size, NULL, GL_STATIC_DRAW);
+      glBufferSubData (GL_ARRAY_BUFFER, 0, sizeof (unit_quad), unit_quad);
+      glBufferSubData (GL_ARRAY_BUFFER, sizeof (unit_quad), instances_size,
+                       self->glyph_instances->data);
+
+      glEnableVertexAttribArray (0);
+      glVertexAttribPointer (0, 2, GL_FLOAT, GL_FALSE,
+                             sizeof (GskQuadVertex),
+                             (void *) G_STRUCT_OFFSET (GskQuadVertex, position));
+      glEnableVertexAttribArray (1);
+      glVertexAttribPointer (1, 2, GL_FLOAT, GL_FALSE,
+                             sizeof (GskQuadVertex),
+                             (void *) G_STRUCT_OFFSET (GskQuadVertex, uv));
+
+      /* The pointers for 2 - 5 are set for each draw, see below */
+      for (i = 2; i <= 5; i++)
+        {
+          glEnableVertexAttribArray (i);
+          glVertexAttribDivisor (i, 1);
+        }
+    }
+
   glGenVertexArrays (1, &vao_id);
   glBindVertexArray (vao_id);
 
@@ -2656,6 +3345,11 @@ gsk_gl_renderer_render_ops (GskGLRenderer *self,
           apply_cross_fade_op (program, op);
           break;
 
+        case OP_CHANGE_BLEND:
+          g_assert (program == &self->blend_program);
+          apply_blend_op (program, op);
+          break;
+
         case OP_CHANGE_LINEAR_GRADIENT:
           apply_linear_gradient_op (program, op);
           break;
@@ -2688,6 +3382,35 @@ gsk_gl_renderer_render_ops (GskGLRenderer *self,
           OP_PRINT (" -> draw %ld, size %ld and program %d\n",
                     op->draw.vao_offset, op->draw.vao_size, program->index);
           glDrawArrays (GL_TRIANGLES, op->draw.vao_offset, op->draw.vao_size);
+          n_draws++;
+          break;
+
+        case OP_DRAW_GLYPHS:
+          {
+            /* There is no glDrawArraysInstancedBaseInstance() before GL 4.2,
+             * so point the instanced attributes at the first instance */
+            const gsize base = sizeof (GskQuadVertex) * GL_N_VERTICES +
+                               op->draw_glyphs.offset * sizeof (GlyphInstance);
+
+            OP_PRINT (" -> draw %ld glyphs from %ld and program %d\n",
+                      op->draw_glyphs.n_instances, op->draw_glyphs.offset, program->index);
+
+            glBindVertexArray (glyph_vao_id);
+            glBindBuffer (GL_ARRAY_BUFFER, glyph_buffer_id);
+            glVertexAttribPointer (2, 4, GL_FLOAT, GL_FALSE, sizeof (GlyphInstance),
+                                   (void *) (base + G_STRUCT_OFFSET (GlyphInstance, rect)));
+            glVertexAttribPointer (3, 4, GL_FLOAT, GL_FALSE, sizeof (GlyphInstance),
+                                   (void *) (base + G_STRUCT_OFFSET (GlyphInstance, uv)));
+            glVertexAttribPointer (4, 4, GL_FLOAT, GL_FALSE, sizeof (GlyphInstance),
+                                   (void *) (base + G_STRUCT_OFFSET (GlyphInstance, color)));
+            glVertexAttribPointer (5, 1, GL_FLOAT, GL_FALSE, sizeof (GlyphInstance),
+                                   (void *) (base + G_STRUCT_OFFSET (GlyphInstance, recolor)));
+            glDrawArraysInstanced (GL_TRIANGLES, 0, GL_N_VERTICES, op->draw_glyphs.n_instances);
+
+            glBindVertexArray (vao_id);
+            glBindBuffer (GL_ARRAY_BUFFER, buffer_id);
+            n_draws++;
+          }
           break;
 
         case OP_DUMP_FRAMEBUFFER:
@@ -2701,11 +3424,40 @@ gsk_gl_renderer_render_ops (GskGLRenderer *self,
       OP_PRINT ("\n");
     }
 
+  gsk_profiler_counter_add (gsk_renderer_get_profiler (GSK_RENDERER (self)),
+                            self->profile_counters.draw_calls,
+                            n_draws);
+
   /* Done drawing, destroy the buffer again.
    * TODO: Can we reuse the memory, though? */
   g_free (vertex_data);
   glDeleteVertexArrays (1, &vao_id);
   glDeleteBuffers (1, &buffer_id);
+
+  if (glyph_vao_id != 0)
+    {
+      glDeleteVertexArrays (1, &glyph_vao_id);
+      glDeleteBuffers (1, &glyph_buffer_id);
+    }
+}
+
+/* Whether any of the ops draw into an offscreen target */
+static gboolean
+gsk_gl_renderer_uses_offscreens (GskGLRenderer *self,
+                                 int            fbo_id)
+{
+  guint i;
+
+  for (i = 0; i < self->render_ops->len; i ++)
+    {
+      const RenderOp *op = &g_array_index (self->render_ops, RenderOp, i);
+
+      if (op->op == OP_CHANGE_RENDER_TARGET &&
+          op->render_target_id != fbo_id)
+        return TRUE;
+    }
+
+  return FALSE;
 }
 
 static void
@@ -2718,14 +3470,12 @@ gsk_gl_renderer_do_render (GskRenderer           *renderer,
   GskGLRenderer *self = GSK_GL_RENDERER (renderer);
   RenderOpBuilder render_op_builder;
   graphene_matrix_t modelview, projection;
-#ifdef G_ENABLE_DEBUG
+  int i, n_passes;
   GskProfiler *profiler;
-  gint64 gpu_time, cpu_time;
-#endif
+  gint64 gpu_time;
+  gint64 before;
 
-#ifdef G_ENABLE_DEBUG
   profiler = gsk_renderer_get_profiler (renderer);
-#endif
 
   if (self->gl_context == NULL)
     {
@@ -2746,7 +3496,10 @@ gsk_gl_renderer_do_render (GskRenderer           *renderer,
 
   gsk_gl_driver_begin_frame (self->gl_driver);
   gsk_gl_glyph_cache_begin_frame (&self->glyph_cache);
-  gsk_gl_shadow_cache_begin_frame (&self->shadow_cache, self->gl_driver);
+  gsk_shadow_cache_begin_frame (&self->shadow_cache);
+  if (gdk_cache_get_budget (self->shadow_cache_entry) > 0)
+    gsk_shadow_cache_trim_size (&self->shadow_cache, gdk_cache_get_budget (self->shadow_cache_entry));
+  gsk_gl_layer_cache_begin_frame (&self->layer_cache, self->gl_driver);
 
   memset (&render_op_builder, 0, sizeof (render_op_builder));
   render_op_builder.renderer = self;
@@ -2754,6 +3507,7 @@ gsk_gl_renderer_do_render (GskRenderer           *renderer,
   render_op_builder.current_viewport = *viewport;
   render_op_builder.current_opacity = 1.0f;
   render_op_builder.render_ops = self->render_ops;
+  render_op_builder.glyph_instances = self->glyph_instances;
   ops_push_modelview (&render_op_builder, &modelview);
 
   /* Initial clip is self->render_region! */
@@ -2784,49 +3538,67 @@ gsk_gl_renderer_do_render (GskRenderer           *renderer,
   if (fbo_id != 0)
     ops_set_render_target (&render_op_builder, fbo_id);
 
+  before = gdk_profiler_current_time ();
   gsk_gl_renderer_add_render_ops (self, root, &render_op_builder);
 
   /* We correctly reset the state everywhere */
   g_assert_cmpint (render_op_builder.current_render_target, ==, fbo_id);
   ops_pop_modelview (&render_op_builder);
   ops_pop_clip (&render_op_builder);
+  ops_batch (&render_op_builder);
   ops_finish (&render_op_builder);
+  gdk_profiler_end_mark (before, "gl build ops", NULL);
+
+  /* Offscreens would be rendered again for every rectangle of the render
+   * region, which costs more than drawing its bounding box in one pass. */
+  if (self->render_region != NULL &&
+      cairo_region_num_rectangles (self->render_region) > 1 &&
+      gsk_gl_renderer_uses_offscreens (self, fbo_id))
+    {
+      cairo_rectangle_int_t extents;
+
+      cairo_region_get_extents (self->render_region, &extents);
+      cairo_region_destroy (self->render_region);
+      self->render_region = cairo_region_create_rectangle (&extents);
+    }
 
   /*g_message ("Ops: %u", self->render_ops->len);*/
 
   /* Now actually draw things... */
-#ifdef G_ENABLE_DEBUG
   gsk_gl_profiler_begin_gpu_region (self->gl_profiler);
-  gsk_profiler_timer_begin (profiler, self->profile_timers.cpu_time);
-#endif
 
   glViewport (0, 0, ceilf (viewport->size.width), ceilf (viewport->size.height));
-  gsk_gl_renderer_setup_render_mode (self);
-  gsk_gl_renderer_clear (self);
 
-  glEnable (GL_DEPTH_TEST);
-  glDepthFunc (GL_LEQUAL);
+  /* If the render region consists of several rectangles, the ops get executed
+   * once per rectangle, scissored to it. */
+  before = gdk_profiler_current_time ();
+  n_passes = self->render_region ? cairo_region_num_rectangles (self->render_region) : 1;
+  for (i = 0; i < n_passes; i ++)
+    {
+      self->render_region_rect = i;
+      gsk_gl_renderer_setup_render_mode (self);
+      gsk_gl_renderer_clear (self);
 
-  /* Pre-multiplied alpha! */
-  glEnable (GL_BLEND);
-  glBlendFunc (GL_ONE, GL_ONE_MINUS_SRC_ALPHA);
-  glBlendEquation (GL_FUNC_ADD);
+      glEnable (GL_DEPTH_TEST);
+      glDepthFunc (GL_LEQUAL);
 
-  gsk_gl_renderer_render_ops (self, render_op_builder.buffer_size);
+      /* Pre-multiplied alpha! */
+      glEnable (GL_BLEND);
+      glBlendFunc (GL_ONE, GL_ONE_MINUS_SRC_ALPHA);
+      glBlendEquation (GL_FUNC_ADD);
 
-  gsk_gl_driver_end_frame (self->gl_driver);
+      gsk_gl_renderer_render_ops (self, render_op_builder.buffer_size);
+    }
+  gdk_profiler_end_mark (before, "gl draw", NULL);
 
-#ifdef G_ENABLE_DEBUG
-  gsk_profiler_counter_inc (profiler, self->profile_counters.frames);
+  gsk_profiler_counter_add (profiler,
+                            self->profile_counters.upload_bytes,
+                            gsk_gl_driver_get_upload_bytes (self->gl_driver));
 
-  cpu_time = gsk_profiler_timer_end (profiler, self->profile_timers.cpu_time);
-  gsk_profiler_timer_set (profiler, self->profile_timers.cpu_time, cpu_time);
+  gsk_gl_driver_end_frame (self->gl_driver);
 
   gpu_time = gsk_gl_profiler_end_gpu_region (self->gl_profiler);
   gsk_profiler_timer_set (profiler, self->profile_timers.gpu_time, gpu_time);
-
-  gsk_profiler_push_samples (profiler);
-#endif
 }
 
 static GdkTexture *
@@ -2878,6 +3650,30 @@ gsk_gl_renderer_render_texture (GskRenderer           *renderer,
   return texture;
 }
 
+/* Whether to draw the rectangles of @region one by one instead of
+ * drawing its bounding box. Every rectangle costs a pass over the
+ * render ops, so this only pays off if it saves enough pixels. */
+static gboolean
+should_split_render_region (const cairo_region_t        *region,
+                            const cairo_rectangle_int_t *extents)
+{
+  cairo_rectangle_int_t rect;
+  int n_rects = cairo_region_num_rectangles (region);
+  gint64 area = 0;
+  int i;
+
+  if (n_rects < 2 || n_rects > MAX_RENDER_REGION_RECTS)
+    return FALSE;
+
+  for (i = 0; i < n_rects; i ++)
+    {
+      cairo_region_get_rectangle (region, i, &rect);
+      area += (gint64) rect.width * rect.height;
+    }
+
+  return area * 2 < (gint64) extents->width * extents->height;
+}
+
 static void
 gsk_gl_renderer_render (GskRenderer          *renderer,
                         GskRenderNode        *root,
@@ -2893,10 +3689,11 @@ gsk_gl_renderer_render (GskRenderer          *renderer,
     return;
 
   surface = gsk_renderer_get_surface (renderer);
+  /* The frame region is in surface coordinates, not in device pixels */
   whole_surface = (GdkRectangle) {
                       0, 0,
-                      gdk_surface_get_width (surface) * self->scale_factor,
-                      gdk_surface_get_height (surface) * self->scale_factor
+                      gdk_surface_get_width (surface),
+                      gdk_surface_get_height (surface)
                   };
 
   gdk_draw_context_begin_frame (GDK_DRAW_CONTEXT (self->gl_context),
@@ -2916,6 +3713,8 @@ gsk_gl_renderer_render (GskRenderer          *renderer,
 
       if (gdk_rectangle_equal (&extents, &whole_surface))
         self->render_region = NULL;
+      else if (should_split_render_region (damage, &extents))
+        self->render_region = cairo_region_copy (damage);
       else
         self->render_region = cairo_region_create_rectangle (&extents);
     }
@@ -2958,16 +3757,14 @@ gsk_gl_renderer_init (GskGLRenderer *self)
   gsk_ensure_resources ();
 
   self->render_ops = g_array_new (FALSE, FALSE, sizeof (RenderOp));
-
-#ifdef G_ENABLE_DEBUG
-  {
-    GskProfiler *profiler = gsk_renderer_get_profiler (GSK_RENDERER (self));
-
-    self->profile_counters.frames = gsk_profiler_add_counter (profiler, "frames", "Frames", FALSE);
-    self->profile_counters.draw_calls = gsk_profiler_add_counter (profiler, "draws", "glDrawArrays", TRUE);
-
-    self->profile_timers.cpu_time = gsk_profiler_add_timer (profiler, "cpu-time", "CPU time", FALSE, TRUE);
-    self->profile_timers.gpu_time = gsk_profiler_add_timer (profiler, "gpu-time", "GPU time", FALSE, TRUE);
-  }
-#endif
+  self->glyph_instances = g_array_new (FALSE, FALSE, sizeof (GlyphInstance));
+  self->pending_glyphs = g_array_new (FALSE, FALSE, sizeof (PendingGlyph));
+
+  /* Registered by GskRenderer */
+  self->profile_counters.draw_calls = g_quark_from_static_string ("draw-calls");
+  self->profile_counters.offscreens = g_quark_from_static_string ("offscreens");
+  self->profile_counters.upload_bytes = g_quark_from_static_string ("upload-bytes");
+  self->profile_counters.fallback_nodes = g_quark_from_static_string ("fallback-nodes");
+  self->profile_counters.culled_nodes = g_quark_from_static_string ("culled-nodes");
+  self->profile_timers.gpu_time = g_quark_from_static_string ("gpu-time");
 }
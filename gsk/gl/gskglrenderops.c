@@ -111,6 +111,11 @@ extract_matrix_metadata (const graphene_matrix_t *m,
 
 out:
   md->only_translation = (md->simple && md->scale_x == 1 && md->scale_y == 1);
+
+  /* No perspective, so everything in a plane is scaled the same */
+  md->flat = (graphene_matrix_get_value (m, 0, 3) == 0.0f &&
+              graphene_matrix_get_value (m, 1, 3) == 0.0f &&
+              graphene_matrix_get_value (m, 3, 3) == 1.0f);
 }
 
 
@@ -144,6 +149,32 @@ ops_transform_bounds_modelview (const RenderOpBuilder *builder,
   graphene_rect_offset (dst, builder->dx * scale, builder->dy * scale);
 }
 
+/* The inverse of ops_transform_bounds_modelview(), only implemented for
+ * modelviews that just translate. Returns %FALSE for other ones. */
+gboolean
+ops_untransform_bounds_modelview (const RenderOpBuilder *builder,
+                                  const graphene_rect_t *src,
+                                  graphene_rect_t       *dst)
+{
+  const float scale = ops_get_scale (builder);
+  const MatrixStackEntry *head;
+
+  g_assert (builder->mv_stack != NULL);
+  g_assert (builder->mv_stack->len >= 1);
+
+  head = &g_array_index (builder->mv_stack, MatrixStackEntry, builder->mv_stack->len - 1);
+
+  if (!head->metadata.only_translation)
+    return FALSE;
+
+  *dst = *src;
+  graphene_rect_offset (dst,
+                        - head->metadata.translate_x - builder->dx * scale,
+                        - head->metadata.translate_y - builder->dy * scale);
+
+  return TRUE;
+}
+
 gboolean
 ops_modelview_is_simple (const RenderOpBuilder *builder)
 {
@@ -157,6 +188,19 @@ ops_modelview_is_simple (const RenderOpBuilder *builder)
   return head->metadata.simple;
 }
 
+gboolean
+ops_modelview_is_flat (const RenderOpBuilder *builder)
+{
+  const MatrixStackEntry *head;
+
+  g_assert (builder->mv_stack != NULL);
+  g_assert (builder->mv_stack->len >= 1);
+
+  head = &g_array_index (builder->mv_stack, MatrixStackEntry, builder->mv_stack->len - 1);
+
+  return head->metadata.flat;
+}
+
 void
 ops_set_program (RenderOpBuilder *builder,
                  const Program   *program)
@@ -169,6 +213,8 @@ ops_set_program (RenderOpBuilder *builder,
   RenderOp op;
   ProgramState *program_state;
 
+  program = program->variants[builder->current_clip_mode];
+
   if (builder->current_program == program)
     return;
 
@@ -227,6 +273,37 @@ ops_set_program (RenderOpBuilder *builder,
   builder->current_program_state = &builder->program_state[program->index];
 }
 
+/* The clip is a plain rectangle most of the time, and the scissor test
+ * or the viewport already take care of the root clip and of clips that
+ * contain the viewport. */
+static void
+ops_update_clip_mode (RenderOpBuilder *builder)
+{
+  const GskRoundedRect *clip = builder->current_clip;
+  int clip_mode;
+
+  if (clip == NULL)
+    clip_mode = CLIP_MODE_NONE;
+  else if (!gsk_rounded_rect_is_rectilinear (clip))
+    clip_mode = CLIP_MODE_ROUNDED;
+  else if (builder->clip_stack->len == 1 ||
+           graphene_rect_contains_rect (&clip->bounds, &builder->current_viewport))
+    clip_mode = CLIP_MODE_NONE;
+  else
+    clip_mode = CLIP_MODE_RECT;
+
+  if (clip_mode == builder->current_clip_mode)
+    return;
+
+  builder->current_clip_mode = clip_mode;
+
+  /* Switch to the right variant of the current program. This syncs the
+   * common uniforms, the program specific ones are set again before the
+   * next draw anyway. */
+  if (builder->current_program != NULL)
+    ops_set_program (builder, builder->current_program);
+}
+
 static void
 ops_set_clip (RenderOpBuilder      *builder,
               const GskRoundedRect *clip)
@@ -235,7 +312,10 @@ ops_set_clip (RenderOpBuilder      *builder,
 
   if (builder->current_program_state &&
       memcmp (&builder->current_program_state->clip, clip,sizeof (GskRoundedRect)) == 0)
-    return;
+    {
+      ops_update_clip_mode (builder);
+      return;
+    }
 
   if (builder->render_ops->len > 0)
     {
@@ -257,6 +337,8 @@ ops_set_clip (RenderOpBuilder      *builder,
 
   if (builder->current_program != NULL)
     builder->current_program_state->clip = *clip;
+
+  ops_update_clip_mode (builder);
 }
 
 void
@@ -441,6 +523,8 @@ ops_set_viewport (RenderOpBuilder       *builder,
   prev_viewport = builder->current_viewport;
   builder->current_viewport = *viewport;
 
+  ops_update_clip_mode (builder);
+
   return prev_viewport;
 }
 
@@ -684,6 +768,33 @@ ops_draw (RenderOpBuilder     *builder,
   builder->buffer_size += sizeof (GskQuadVertex) * GL_N_VERTICES;
 }
 
+/* Glyphs are drawn instanced from builder->glyph_instances, so
+ * consecutive glyphs only make the last draw longer */
+void
+ops_draw_glyph (RenderOpBuilder     *builder,
+                const GlyphInstance *instance)
+{
+  RenderOp *last_op;
+
+  last_op = &g_array_index (builder->render_ops, RenderOp, builder->render_ops->len - 1);
+  if (last_op->op == OP_DRAW_GLYPHS &&
+      last_op->draw_glyphs.offset + last_op->draw_glyphs.n_instances == builder->glyph_instances->len)
+    {
+      last_op->draw_glyphs.n_instances++;
+    }
+  else
+    {
+      RenderOp op;
+
+      op.op = OP_DRAW_GLYPHS;
+      op.draw_glyphs.offset = builder->glyph_instances->len;
+      op.draw_glyphs.n_instances = 1;
+      g_array_append_val (builder->render_ops, op);
+    }
+
+  g_array_append_val (builder->glyph_instances, *instance);
+}
+
 void
 ops_offset (RenderOpBuilder *builder,
             float            x,
@@ -699,3 +810,155 @@ ops_add (RenderOpBuilder *builder,
 {
   g_array_append_val (builder->render_ops, *op);
 }
+
+static inline gsize
+op_payload_size (guint kind)
+{
+  const RenderOp *op = NULL;
+
+  switch (kind)
+    {
+    case OP_CHANGE_OPACITY:         return sizeof (op->opacity);
+    case OP_CHANGE_COLOR:           return sizeof (op->color);
+    case OP_CHANGE_PROJECTION:      return sizeof (op->projection);
+    case OP_CHANGE_MODELVIEW:       return sizeof (op->modelview);
+    case OP_CHANGE_CLIP:            return sizeof (op->clip);
+    case OP_CHANGE_LINEAR_GRADIENT: return sizeof (op->linear_gradient);
+    case OP_CHANGE_COLOR_MATRIX:    return sizeof (op->color_matrix);
+    case OP_CHANGE_BLUR:            return sizeof (op->blur);
+    case OP_CHANGE_INSET_SHADOW:    return sizeof (op->inset_shadow);
+    case OP_CHANGE_OUTSET_SHADOW:   return sizeof (op->outset_shadow);
+    case OP_CHANGE_UNBLURRED_OUTSET_SHADOW: return sizeof (op->unblurred_outset_shadow);
+    case OP_CHANGE_BORDER:          return sizeof (op->border.outline);
+    case OP_CHANGE_BORDER_COLOR:    return sizeof (op->border.color);
+    case OP_CHANGE_BORDER_WIDTH:    return sizeof (op->border.widths);
+    default:                        return 0;
+    }
+}
+
+static inline gconstpointer
+op_payload (const RenderOp *op)
+{
+  switch (op->op)
+    {
+    case OP_CHANGE_BORDER:          return &op->border.outline;
+    case OP_CHANGE_BORDER_COLOR:    return &op->border.color;
+    case OP_CHANGE_BORDER_WIDTH:    return &op->border.widths;
+    default:                        return &op->opacity; /* Start of the union */
+    }
+}
+
+/* Walks the recorded ops the way gsk_gl_renderer_render_ops() will execute
+ * them, drops state changes that set a value the current program already
+ * has and merges draw calls that end up next to each other.
+ *
+ * Uniform values are part of the program object, so we track them per
+ * program. Everything else (viewport, render target, the second texture
+ * unit used for cross fades and blending, ...) is treated as a barrier. */
+void
+ops_batch (RenderOpBuilder *builder)
+{
+  const RenderOp *applied[GL_N_PROGRAM_VARIANTS][OP_LAST] = { { NULL, }, };
+  const Program *program = NULL;
+  RenderOp *last_draw = NULL;
+  RenderOp *last_glyph_draw = NULL;
+  int current_texture = 0;
+  guint i;
+
+  for (i = 0; i < builder->render_ops->len; i ++)
+    {
+      RenderOp *op = &g_array_index (builder->render_ops, RenderOp, i);
+
+      switch (op->op)
+        {
+        case OP_NONE:
+        case OP_CHANGE_VAO:
+          /* Vertex data only */
+          break;
+
+        case OP_CHANGE_PROGRAM:
+          if (op->program == program)
+            {
+              op->op = OP_NONE;
+              break;
+            }
+
+          program = op->program;
+          last_draw = NULL;
+          last_glyph_draw = NULL;
+          break;
+
+        case OP_CHANGE_SOURCE_TEXTURE:
+          /* Skipped by the renderer if no program is set */
+          if (program == NULL)
+            break;
+
+          if (op->texture_id == current_texture)
+            {
+              op->op = OP_NONE;
+              break;
+            }
+
+          current_texture = op->texture_id;
+          last_draw = NULL;
+          last_glyph_draw = NULL;
+          break;
+
+        case OP_DRAW:
+          if (program == NULL)
+            break;
+
+          if (last_draw != NULL &&
+              last_draw->draw.vao_offset + last_draw->draw.vao_size == op->draw.vao_offset)
+            {
+              last_draw->draw.vao_size += op->draw.vao_size;
+              op->op = OP_NONE;
+            }
+          else
+            {
+              last_draw = op;
+            }
+          last_glyph_draw = NULL;
+          break;
+
+        case OP_DRAW_GLYPHS:
+          if (program == NULL)
+            break;
+
+          if (last_glyph_draw != NULL &&
+              last_glyph_draw->draw_glyphs.offset + last_glyph_draw->draw_glyphs.n_instances == op->draw_glyphs.offset)
+            {
+              last_glyph_draw->draw_glyphs.n_instances += op->draw_glyphs.n_instances;
+              op->op = OP_NONE;
+            }
+          else
+            {
+              last_glyph_draw = op;
+            }
+          last_draw = NULL;
+          break;
+
+        default:
+          {
+            const gsize size = op_payload_size (op->op);
+
+            if (program != NULL && size > 0)
+              {
+                const RenderOp **prev = &applied[program->index][op->op];
+
+                if (*prev != NULL &&
+                    memcmp (op_payload (*prev), op_payload (op), size) == 0)
+                  {
+                    op->op = OP_NONE;
+                    break;
+                  }
+
+                *prev = op;
+              }
+
+            last_draw = NULL;
+            last_glyph_draw = NULL;
+          }
+        }
+    }
+}
@@ -10,8 +10,18 @@
 #include "gskglrendererprivate.h"
 
 #define GL_N_VERTICES 6
-#define GL_N_PROGRAMS 11
+#define GL_N_PROGRAMS 14
 
+/* Every program is compiled once per clip mode, so draws that don't need
+ * the rounded rect math in the fragment shader don't pay for it */
+enum {
+  CLIP_MODE_NONE,
+  CLIP_MODE_RECT,
+  CLIP_MODE_ROUNDED,
+  N_CLIP_MODES
+};
+
+#define GL_N_PROGRAM_VARIANTS (GL_N_PROGRAMS * N_CLIP_MODES)
 
 
 typedef struct
@@ -23,6 +33,7 @@ typedef struct
 
   guint simple : 1;
   guint only_translation : 1;
+  guint flat : 1;
 } OpsMatrixMetadata;
 
 typedef struct
@@ -56,11 +67,28 @@ enum {
   OP_CLEAR                  =  21,
   OP_DRAW                   =  22,
   OP_DUMP_FRAMEBUFFER       =  23,
+  OP_CHANGE_BLEND           =  24,
+  OP_DRAW_GLYPHS            =  25,
+  OP_LAST
 };
 
+typedef struct _Program Program;
+
+/* The per-glyph attributes of the glyph program, drawn instanced */
 typedef struct
 {
-  int index;        /* Into the renderer's program array */
+  float rect[4];
+  float uv[4];
+  float color[4];
+  float recolor;
+} GlyphInstance;
+
+struct _Program
+{
+  int index;        /* Into the builder's program state, unique per variant */
+  int clip_mode;
+  /* The same program for all clip modes, including this one */
+  const Program *variants[N_CLIP_MODES];
 
   int id;
   /* Common locations (gl_common)*/
@@ -93,6 +121,7 @@ typedef struct
       int color_offsets_location;
       int start_point_location;
       int end_point_location;
+      int repeat_location;
     } linear_gradient;
     struct {
       int blur_radius_location;
@@ -131,9 +160,12 @@ typedef struct
       int source2_location;
       int progress_location;
     } cross_fade;
+    struct {
+      int source2_location;
+      int mode_location;
+    } blend;
   };
-
-} Program;
+};
 
 typedef struct
 {
@@ -156,11 +188,16 @@ typedef struct
       float color_stops[4 * 8];
       graphene_point_t start_point;
       graphene_point_t end_point;
+      gboolean repeat;
     } linear_gradient;
     struct {
       gsize vao_offset;
       gsize vao_size;
     } draw;
+    struct {
+      gsize offset;
+      gsize n_instances;
+    } draw_glyphs;
     struct {
       graphene_matrix_t matrix;
       graphene_vec4_t offset;
@@ -209,6 +246,10 @@ typedef struct
       float progress;
       int source2;
     } cross_fade;
+    struct {
+      int source2;
+      int mode;
+    } blend;
     struct {
       char *filename;
       int width;
@@ -242,10 +283,12 @@ typedef struct
 
 typedef struct
 {
-  ProgramState program_state[GL_N_PROGRAMS];
+  ProgramState program_state[GL_N_PROGRAM_VARIANTS];
   /* Current global state */
   ProgramState *current_program_state;
+  /* The variant of the program set by ops_set_program() for current_clip_mode */
   const Program *current_program;
+  int current_clip_mode;
   int current_render_target;
   int current_texture;
 
@@ -257,6 +300,8 @@ typedef struct
   gsize buffer_size;
 
   GArray *render_ops;
+  /* GlyphInstances referenced by OP_DRAW_GLYPHS */
+  GArray *glyph_instances;
   GskGLRenderer *renderer;
 
   /* Stack of modelview matrices */
@@ -276,10 +321,12 @@ void              ops_dump_framebuffer   (RenderOpBuilder         *builder,
                                           int                      height);
 
 void              ops_finish             (RenderOpBuilder         *builder);
+void              ops_batch              (RenderOpBuilder         *builder);
 void              ops_push_modelview     (RenderOpBuilder         *builder,
                                           const graphene_matrix_t *mv);
 void              ops_pop_modelview      (RenderOpBuilder         *builder);
 gboolean          ops_modelview_is_simple (const RenderOpBuilder  *builder);
+gboolean          ops_modelview_is_flat  (const RenderOpBuilder   *builder);
 float             ops_get_scale          (const RenderOpBuilder   *builder);
 
 void              ops_set_program        (RenderOpBuilder         *builder,
@@ -293,6 +340,9 @@ gboolean          ops_has_clip           (RenderOpBuilder         *builder);
 void              ops_transform_bounds_modelview (const RenderOpBuilder *builder,
                                                   const graphene_rect_t *src,
                                                   graphene_rect_t       *dst);
+gboolean          ops_untransform_bounds_modelview (const RenderOpBuilder *builder,
+                                                    const graphene_rect_t *src,
+                                                    graphene_rect_t       *dst);
 
 graphene_matrix_t ops_set_projection     (RenderOpBuilder         *builder,
                                           const graphene_matrix_t *projection);
@@ -326,6 +376,9 @@ void              ops_set_border_color   (RenderOpBuilder         *builder,
 void              ops_draw               (RenderOpBuilder        *builder,
                                           const GskQuadVertex     vertex_data[GL_N_VERTICES]);
 
+void              ops_draw_glyph         (RenderOpBuilder        *builder,
+                                          const GlyphInstance    *instance);
+
 void              ops_offset             (RenderOpBuilder        *builder,
                                           float                   x,
                                           float                   y);
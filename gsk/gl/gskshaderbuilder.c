@@ -3,9 +3,11 @@
 #include "gskshaderbuilderprivate.h"
 
 #include "gskdebugprivate.h"
+#include "gskdiskcacheprivate.h"
 
 #include <gdk/gdk.h>
 #include <epoxy/gl.h>
+#include <string.h>
 
 struct _GskShaderBuilder
 {
@@ -16,12 +18,22 @@ struct _GskShaderBuilder
   char *fragment_preamble;
 
 
+  /* The common vertex shader is only compiled when a program
+   * could not be loaded from the program cache */
+  char *common_vertex_source;
+  char *common_vertex_name;
   int common_vertex_shader_id;
 
+  /* Identifies the GL driver, NULL if the program cache is disabled */
+  char *program_cache_key;
+
   int version;
 
   GPtrArray *defines;
 
+  /* Attribute names, indexed by their location */
+  GPtrArray *attributes;
+
   /* We reuse this one for all the shaders */
   GString *shader_code;
 };
@@ -36,9 +48,13 @@ gsk_shader_builder_finalize (GObject *gobject)
   g_free (self->resource_base_path);
   g_free (self->vertex_preamble);
   g_free (self->fragment_preamble);
+  g_free (self->common_vertex_source);
+  g_free (self->common_vertex_name);
+  g_free (self->program_cache_key);
   g_string_free (self->shader_code, TRUE);
 
   g_clear_pointer (&self->defines, g_ptr_array_unref);
+  g_clear_pointer (&self->attributes, g_ptr_array_unref);
 
   if (self->common_vertex_shader_id > 0)
     glDeleteShader (self->common_vertex_shader_id);
@@ -56,6 +72,7 @@ static void
 gsk_shader_builder_init (GskShaderBuilder *self)
 {
   self->defines = g_ptr_array_new_with_free_func (g_free);
+  self->attributes = g_ptr_array_new_with_free_func (g_free);
   self->shader_code = g_string_new (NULL);
 }
 
@@ -117,6 +134,30 @@ gsk_shader_builder_add_define (GskShaderBuilder *builder,
   g_ptr_array_add (builder->defines, g_strdup (define_value));
 }
 
+/**
+ * gsk_shader_builder_bind_attribute:
+ * @builder: a #GskShaderBuilder
+ * @name: the name of a vertex attribute
+ * @location: the location to use for it
+ *
+ * Makes all programs created afterwards use @location for the
+ * vertex attribute called @name, if their vertex shader has it.
+ */
+void
+gsk_shader_builder_bind_attribute (GskShaderBuilder *builder,
+                                   const char       *name,
+                                   guint             location)
+{
+  g_return_if_fail (GSK_IS_SHADER_BUILDER (builder));
+  g_return_if_fail (name != NULL);
+
+  if (location >= builder->attributes->len)
+    g_ptr_array_set_size (builder->attributes, location + 1);
+
+  g_free (g_ptr_array_index (builder->attributes, location));
+  builder->attributes->pdata[location] = g_strdup (name);
+}
+
 static gboolean
 lookup_shader_code (GString *code,
                     const char *base_path,
@@ -144,17 +185,14 @@ lookup_shader_code (GString *code,
   return TRUE;
 }
 
-static int
-gsk_shader_builder_compile_shader (GskShaderBuilder *builder,
-                                   int               shader_type,
-                                   const char       *shader_preamble,
-                                   const char       *shader_source,
-                                   GError          **error)
+static char *
+gsk_shader_builder_build_source (GskShaderBuilder *builder,
+                                 const char       *shader_preamble,
+                                 const char       *shader_source,
+                                 const char       *extra_define,
+                                 GError          **error)
 {
   GString *code;
-  const char *source;
-  int shader_id;
-  int status;
   int i;
 
   /* Clear possibly previously set shader code */
@@ -180,21 +218,36 @@ gsk_shader_builder_compile_shader (GskShaderBuilder *builder,
       g_string_append_c (code, '\n');
     }
 
+  if (extra_define != NULL)
+    g_string_append_printf (code, "#define %s 1\n", extra_define);
+
   g_string_append_c (code, '\n');
 
   if (!lookup_shader_code (code, builder->resource_base_path, shader_preamble, error))
     {
-      return -1;
+      return NULL;
     }
 
   g_string_append_c (code, '\n');
 
   if (!lookup_shader_code (code, builder->resource_base_path, shader_source, error))
     {
-      return -1;
+      return NULL;
     }
 
-  source = code->str;
+  return g_strndup (code->str, code->len);
+}
+
+static int
+gsk_shader_builder_compile_shader (GskShaderBuilder *builder,
+                                   int               shader_type,
+                                   const char       *shader_preamble,
+                                   const char       *shader_name,
+                                   const char       *source,
+                                   GError          **error)
+{
+  int shader_id;
+  int status;
 
   shader_id = glCreateShader (shader_type);
   glShaderSource (shader_id, 1, (const GLchar **) &source, NULL);
@@ -206,7 +259,7 @@ gsk_shader_builder_compile_shader (GskShaderBuilder *builder,
       g_print ("*** Compiling %s shader from '%s' + '%s' ***\n"
                "%s\n",
                shader_type == GL_VERTEX_SHADER ? "vertex" : "fragment",
-               shader_preamble, shader_source,
+               shader_preamble, shader_name,
                source);
     }
 #endif
@@ -241,17 +294,124 @@ gsk_shader_builder_set_common_vertex_shader (GskShaderBuilder  *self,
                                              const char        *vertex_shader,
                                              GError           **error)
 {
-  int shader_id;
+  char *source;
+
+  source = gsk_shader_builder_build_source (self,
+                                            self->vertex_preamble,
+                                            vertex_shader,
+                                            NULL,
+                                            error);
+
+  g_assert (source != NULL);
+
+  g_free (self->common_vertex_source);
+  self->common_vertex_source = source;
+  g_free (self->common_vertex_name);
+  self->common_vertex_name = g_strdup (vertex_shader);
+}
+
+/**
+ * gsk_shader_builder_enable_program_cache:
+ * @builder: a #GskShaderBuilder
+ *
+ * Makes gsk_shader_builder_create_program() store the binaries of
+ * linked programs on disk and load them from there next time, instead
+ * of compiling the shaders again.
+ *
+ * This needs a GL context to be current, and does nothing if the GL
+ * implementation doesn't support program binaries.
+ */
+void
+gsk_shader_builder_enable_program_cache (GskShaderBuilder *builder)
+{
+  int n_formats = 0;
+
+  g_return_if_fail (GSK_IS_SHADER_BUILDER (builder));
+
+  if (epoxy_is_desktop_gl ())
+    {
+      if (epoxy_gl_version () < 41 && !epoxy_has_gl_extension ("GL_ARB_get_program_binary"))
+        return;
+    }
+  else
+    {
+      /* GL_OES_get_program_binary lacks glProgramParameteri() */
+      if (epoxy_gl_version () < 30)
+        return;
+    }
+
+  /* Some drivers advertise the extension but support no formats */
+  glGetIntegerv (GL_NUM_PROGRAM_BINARY_FORMATS, &n_formats);
+  if (n_formats == 0)
+    return;
+
+  g_free (builder->program_cache_key);
+  builder->program_cache_key = g_strdup_printf ("%s\n%s\n%s",
+                                                (const char *) glGetString (GL_VENDOR),
+                                                (const char *) glGetString (GL_RENDERER),
+                                                (const char *) glGetString (GL_VERSION));
+}
+
+static int
+load_cached_program (const char *key)
+{
+  GBytes *bytes;
+  const guchar *data;
+  gsize size;
+  guint32 format;
+  int program_id;
+  int status;
 
+  bytes = gsk_disk_cache_load ("gl", key);
+  if (bytes == NULL)
+    return -1;
 
-  shader_id = gsk_shader_builder_compile_shader (self,
-                                                 GL_VERTEX_SHADER,
-                                                 self->vertex_preamble,
-                                                 vertex_shader,
-                                                 error);
+  data = g_bytes_get_data (bytes, &size);
+  if (size <= sizeof (guint32))
+    {
+      g_bytes_unref (bytes);
+      return -1;
+    }
+
+  memcpy (&format, data, sizeof (guint32));
+
+  program_id = glCreateProgram ();
+  glProgramBinary (program_id, format, data + sizeof (guint32), size - sizeof (guint32));
+  g_bytes_unref (bytes);
+
+  /* The driver rejects binaries it can't use anymore, e.g. after
+   * an update that kept the version string */
+  glGetProgramiv (program_id, GL_LINK_STATUS, &status);
+  if (status == GL_FALSE)
+    {
+      glDeleteProgram (program_id);
+      return -1;
+    }
 
-  g_assert (shader_id > 0);
-  self->common_vertex_shader_id = shader_id;
+  return program_id;
+}
+
+static void
+save_program (const char *key,
+              int         program_id)
+{
+  int length = 0;
+  guchar *data;
+  GLenum format;
+  guint32 format32;
+
+  glGetProgramiv (program_id, GL_PROGRAM_BINARY_LENGTH, &length);
+  if (length <= 0)
+    return;
+
+  data = g_malloc (sizeof (guint32) + length);
+  glGetProgramBinary (program_id, length, NULL, &format, data + sizeof (guint32));
+  format32 = format;
+  memcpy (data, &format32, sizeof (guint32));
+
+  gsk_disk_cache_save ("gl", key, data, sizeof (guint32) + length);
+
+  g_free (data);
 }
 
 int
@@ -259,29 +419,161 @@ gsk_shader_builder_create_program (GskShaderBuilder *builder,
                                    const char       *fragment_shader,
                                    GError          **error)
 {
+  return gsk_shader_builder_create_program_full (builder, NULL, fragment_shader, NULL, error);
+}
+
+/**
+ * gsk_shader_builder_create_program_with_define:
+ * @builder: a #GskShaderBuilder
+ * @fragment_shader: the fragment shader
+ * @define_name: (nullable): a define to add for this program only
+ * @error: return location for an error
+ *
+ * Like gsk_shader_builder_create_program(), but defines @define_name
+ * to 1 in the fragment shader, to compile variants of one shader.
+ *
+ * Returns: the program id, or -1 on error
+ */
+int
+gsk_shader_builder_create_program_with_define (GskShaderBuilder *builder,
+                                               const char       *fragment_shader,
+                                               const char       *define_name,
+                                               GError          **error)
+{
+  return gsk_shader_builder_create_program_full (builder, NULL, fragment_shader, define_name, error);
+}
+
+/**
+ * gsk_shader_builder_create_program_full:
+ * @builder: a #GskShaderBuilder
+ * @vertex_shader: (nullable): the vertex shader, or %NULL for the
+ *   common one
+ * @fragment_shader: the fragment shader
+ * @define_name: (nullable): a define to add for this program only
+ * @error: return location for an error
+ *
+ * Like gsk_shader_builder_create_program_with_define(), but can use
+ * its own vertex shader instead of the common one.
+ *
+ * Returns: the program id, or -1 on error
+ */
+int
+gsk_shader_builder_create_program_full (GskShaderBuilder *builder,
+                                        const char       *vertex_shader,
+                                        const char       *fragment_shader,
+                                        const char       *define_name,
+                                        GError          **error)
+{
+  char *vertex_source = NULL;
+  char *fragment_source;
+  char *cache_key = NULL;
   int vertex_id;
   int fragment_id;
   int program_id;
   int status;
+  guint i;
 
   g_return_val_if_fail (GSK_IS_SHADER_BUILDER (builder), -1);
   g_return_val_if_fail (fragment_shader != NULL, -1);
-  g_return_val_if_fail (builder->common_vertex_shader_id != 0, -1);
+  g_return_val_if_fail (vertex_shader != NULL || builder->common_vertex_source != NULL, -1);
+
+  if (vertex_shader != NULL)
+    {
+      vertex_source = gsk_shader_builder_build_source (builder,
+                                                       builder->vertex_preamble,
+                                                       vertex_shader,
+                                                       NULL,
+                                                       error);
+      if (vertex_source == NULL)
+        return -1;
+    }
+
+  fragment_source = gsk_shader_builder_build_source (builder,
+                                                     builder->fragment_preamble,
+                                                     fragment_shader,
+                                                     define_name,
+                                                     error);
+  if (fragment_source == NULL)
+    {
+      g_free (vertex_source);
+      return -1;
+    }
+
+  if (builder->program_cache_key != NULL && !GSK_DEBUG_CHECK (SHADERS))
+    {
+      cache_key = g_strconcat (builder->program_cache_key, "\n",
+                               vertex_source ? vertex_source : builder->common_vertex_source, "\n",
+                               fragment_source, NULL);
+
+      program_id = load_cached_program (cache_key);
+      if (program_id > 0)
+        {
+          g_free (cache_key);
+          g_free (vertex_source);
+          g_free (fragment_source);
+          return program_id;
+        }
+    }
+
+  if (vertex_source != NULL)
+    {
+      vertex_id = gsk_shader_builder_compile_shader (builder, GL_VERTEX_SHADER,
+                                                     builder->vertex_preamble,
+                                                     vertex_shader,
+                                                     vertex_source,
+                                                     error);
+      g_free (vertex_source);
+      if (vertex_id < 0)
+        {
+          g_free (fragment_source);
+          g_free (cache_key);
+          return -1;
+        }
+    }
+  else
+    {
+      if (builder->common_vertex_shader_id == 0)
+        {
+          builder->common_vertex_shader_id =
+            gsk_shader_builder_compile_shader (builder, GL_VERTEX_SHADER,
+                                               builder->vertex_preamble,
+                                               builder->common_vertex_name,
+                                               builder->common_vertex_source,
+                                               error);
+          g_assert (builder->common_vertex_shader_id > 0);
+        }
+
+      vertex_id = builder->common_vertex_shader_id;
+    }
 
-  vertex_id = builder->common_vertex_shader_id;
   fragment_id = gsk_shader_builder_compile_shader (builder, GL_FRAGMENT_SHADER,
                                                    builder->fragment_preamble,
                                                    fragment_shader,
+                                                   fragment_source,
                                                    error);
+  g_free (fragment_source);
   if (fragment_id < 0)
     {
-      glDeleteShader (vertex_id);
+      if (vertex_id != builder->common_vertex_shader_id)
+        glDeleteShader (vertex_id);
+      g_free (cache_key);
       return -1;
     }
 
   program_id = glCreateProgram ();
+  if (cache_key != NULL)
+    glProgramParameteri (program_id, GL_PROGRAM_BINARY_RETRIEVABLE_HINT, GL_TRUE);
   glAttachShader (program_id, vertex_id);
   glAttachShader (program_id, fragment_id);
+
+  for (i = 0; i < builder->attributes->len; i++)
+    {
+      const char *name = g_ptr_array_index (builder->attributes, i);
+
+      if (name != NULL)
+        glBindAttribLocation (program_id, i, name);
+    }
+
   glLinkProgram (program_id);
 
   glGetProgramiv (program_id, GL_LINK_STATUS, &status);
@@ -305,11 +597,16 @@ gsk_shader_builder_create_program (GskShaderBuilder *builder,
       goto out;
     }
 
+  if (cache_key != NULL)
+    save_program (cache_key, program_id);
+
 out:
   if (vertex_id > 0)
     {
       /* We delete the common vertex shader when destroying the shader builder */
       glDetachShader (program_id, vertex_id);
+      if (vertex_id != builder->common_vertex_shader_id)
+        glDeleteShader (vertex_id);
     }
 
   if (fragment_id > 0)
@@ -318,5 +615,7 @@ out:
       glDeleteShader (fragment_id);
     }
 
+  g_free (cache_key);
+
   return program_id;
 }
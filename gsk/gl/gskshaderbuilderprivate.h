@@ -25,13 +25,28 @@ void                    gsk_shader_builder_add_define                   (GskShad
                                                                          const char       *define_name,
                                                                          const char       *define_value);
 
+void                    gsk_shader_builder_bind_attribute               (GskShaderBuilder *builder,
+                                                                         const char       *name,
+                                                                         guint             location);
+
 void                    gsk_shader_builder_set_common_vertex_shader     (GskShaderBuilder  *self,
                                                                          const char        *vertex_shader,
                                                                          GError           **error);
 
+void                    gsk_shader_builder_enable_program_cache         (GskShaderBuilder *builder);
+
 int                     gsk_shader_builder_create_program               (GskShaderBuilder *builder,
                                                                          const char       *fragment_shader,
                                                                          GError          **error);
+int                     gsk_shader_builder_create_program_with_define   (GskShaderBuilder *builder,
+                                                                         const char       *fragment_shader,
+                                                                         const char       *define_name,
+                                                                         GError          **error);
+int                     gsk_shader_builder_create_program_full          (GskShaderBuilder *builder,
+                                                                         const char       *vertex_shader,
+                                                                         const char       *fragment_shader,
+                                                                         const char       *define_name,
+                                                                         GError          **error);
 
 G_END_DECLS
 
@@ -51,6 +51,20 @@
 #define BOX_FILTER_SIZE_9 16
 #define BOX_FILTER_SIZE_10 18
 
+/* For box sizes below this, dividing a sum of up to 256 * d by d can be
+ * replaced by a multiplication with a 23-bit fixed point reciprocal
+ * without changing the result, and without overflowing 32 bits.
+ */
+#define MAX_RECIPROCAL_SIZE 181
+
+static inline guint
+box_reciprocal (int d)
+{
+  return ((1 << 23) + d - 1) / d;
+}
+
+#define DIVIDE_BY_RECIPROCAL(sum, d, reciprocal) ((((sum) + (d) / 2) * (reciprocal)) >> 23)
+
 /* This applies a single box blur pass to a horizontal range of pixels;
  * since the box blur has the same weight for all pixels, we can
  * implement an efficient sliding window algorithm where we add
@@ -81,10 +95,8 @@ blur_xspan (guchar *row,
    * be well predicted and there are enough different possibilities
    * that trying to write this as a series of unconditional loops
    * is hard and not an obvious win. The main slow down here seems
-   * to be the integer division per pixel; one possible optimization
-   * would be to accumulate into two 16-bit integer buffers and
-   * only divide down after all three passes. (SSE parallel implementation
-   * of the divide step is possible.)
+   * to be the integer division per pixel, which is why sizes that
+   * aren't unrolled use a multiplication with the reciprocal.
    */
 
 #define BLUR_ROW_KERNEL(D)                                      \
@@ -103,6 +115,25 @@ blur_xspan (guchar *row,
     }								\
   break;
 
+#define BLUR_ROW_KERNEL_RECIPROCAL(D)                           \
+  {                                                             \
+    const guint reciprocal = box_reciprocal (D);                \
+                                                                \
+    for (i = -(D) + offset; i < row_width + offset; i++)        \
+      {                                                         \
+        if (i >= 0 && i < row_width)                            \
+          sum += row[i];                                        \
+                                                                \
+        if (i >= offset)                                        \
+          {                                                     \
+            if (i >= (D))                                       \
+              sum -= row[i - (D)];                              \
+                                                                \
+            tmp_buffer[i - offset] = DIVIDE_BY_RECIPROCAL (sum, D, reciprocal); \
+          }                                                     \
+      }                                                         \
+  }
+
   /* We unroll the values for d for radius 2-10 to avoid a generic
    * divide operation (not radius 1, because its a no-op) */
   switch (d)
@@ -116,9 +147,18 @@ blur_xspan (guchar *row,
     case BOX_FILTER_SIZE_8: BLUR_ROW_KERNEL (BOX_FILTER_SIZE_8);
     case BOX_FILTER_SIZE_9: BLUR_ROW_KERNEL (BOX_FILTER_SIZE_9);
     case BOX_FILTER_SIZE_10: BLUR_ROW_KERNEL (BOX_FILTER_SIZE_10);
-    default: BLUR_ROW_KERNEL (d);
+    default:
+      if (d >= MAX_RECIPROCAL_SIZE)
+        {
+          BLUR_ROW_KERNEL (d);
+        }
+      BLUR_ROW_KERNEL_RECIPROCAL (d);
+      break;
     }
 
+#undef BLUR_ROW_KERNEL_RECIPROCAL
+#undef BLUR_ROW_KERNEL
+
   memcpy (row, tmp_buffer, row_width);
 }
 
@@ -156,33 +196,97 @@ blur_rows (guchar *dst_buffer,
     }
 }
 
-/* Swaps width and height.
+/* The vertical counterpart of blur_xspan(). Instead of sliding the
+ * window along a single column, it keeps one running sum per column
+ * and slides all of them down at once, adding and removing whole rows.
+ * That keeps memory accesses linear and lets the compiler vectorize
+ * the inner loops, without transposing the buffer first.
+ *
+ * Unlike blur_xspan() this can't work in place, @src and @dst must
+ * not overlap.
  */
 static void
-flip_buffer (guchar *dst_buffer,
-             guchar *src_buffer,
-             int     width,
-             int     height)
+blur_yspan (guchar       *dst,
+            const guchar *src,
+            guint        *sums,
+            int           width,
+            int           height,
+            int           d,
+            int           shift)
 {
-  /* Working in blocks increases cache efficiency, compared to reading
-   * or writing an entire column at once
-   */
-#define BLOCK_SIZE 16
-
-  int i0, j0;
-
-  for (i0 = 0; i0 < width; i0 += BLOCK_SIZE)
-    for (j0 = 0; j0 < height; j0 += BLOCK_SIZE)
-      {
-        int max_j = MIN(j0 + BLOCK_SIZE, height);
-        int max_i = MIN(i0 + BLOCK_SIZE, width);
-        int i, j;
-
-        for (i = i0; i < max_i; i++)
-          for (j = j0; j < max_j; j++)
-            dst_buffer[i * height + j] = src_buffer[j * width + i];
-      }
-#undef BLOCK_SIZE
+  const guint reciprocal = d < MAX_RECIPROCAL_SIZE ? box_reciprocal (d) : 0;
+  int offset;
+  int i, x;
+
+  if (d % 2 == 1)
+    offset = d / 2;
+  else
+    offset = (d - shift) / 2;
+
+  memset (sums, 0, sizeof (guint) * width);
+
+  for (i = -d + offset; i < height + offset; i++)
+    {
+      if (i >= 0 && i < height)
+        {
+          const guchar *in = src + i * width;
+
+          for (x = 0; x < width; x++)
+            sums[x] += in[x];
+        }
+
+      if (i >= offset)
+        {
+          guchar *out = dst + (i - offset) * width;
+
+          if (i >= d)
+            {
+              const guchar *in = src + (i - d) * width;
+
+              for (x = 0; x < width; x++)
+                sums[x] -= in[x];
+            }
+
+          if (reciprocal)
+            {
+              for (x = 0; x < width; x++)
+                out[x] = DIVIDE_BY_RECIPROCAL (sums[x], d, reciprocal);
+            }
+          else
+            {
+              for (x = 0; x < width; x++)
+                out[x] = (sums[x] + d / 2) / d;
+            }
+        }
+    }
+}
+
+static void
+blur_columns (guchar *buffer,
+              guchar *tmp_buffer,
+              int     buffer_width,
+              int     buffer_height,
+              int     d)
+{
+  guint *sums = g_new (guint, buffer_width);
+
+  /* Same symmetric setup as blur_rows() */
+  if (d % 2 == 1)
+    {
+      blur_yspan (tmp_buffer, buffer, sums, buffer_width, buffer_height, d, 0);
+      blur_yspan (buffer, tmp_buffer, sums, buffer_width, buffer_height, d, 0);
+      blur_yspan (tmp_buffer, buffer, sums, buffer_width, buffer_height, d, 0);
+    }
+  else
+    {
+      blur_yspan (tmp_buffer, buffer, sums, buffer_width, buffer_height, d, 1);
+      blur_yspan (buffer, tmp_buffer, sums, buffer_width, buffer_height, d, -1);
+      blur_yspan (tmp_buffer, buffer, sums, buffer_width, buffer_height, d + 1, 0);
+    }
+
+  memcpy (buffer, tmp_buffer, buffer_width * buffer_height);
+
+  g_free (sums);
 }
 
 static void
@@ -192,30 +296,18 @@ _boxblur (guchar      *buffer,
           int          radius,
           GskBlurFlags flags)
 {
-  guchar *flipped_buffer;
+  guchar *tmp_buffer;
   int d = get_box_filter_size (radius);
 
-  flipped_buffer = g_malloc (width * height);
+  tmp_buffer = g_malloc (width * height);
 
   if (flags & GSK_BLUR_Y)
-    {
-      /* Step 1: swap rows and columns */
-      flip_buffer (flipped_buffer, buffer, width, height);
-
-      /* Step 2: blur rows (really columns) */
-      blur_rows (flipped_buffer, buffer, height, width, d);
-
-      /* Step 3: swap rows and columns */
-      flip_buffer (buffer, flipped_buffer, height, width);
-    }
+    blur_columns (buffer, tmp_buffer, width, height, d);
 
   if (flags & GSK_BLUR_X)
-    {
-      /* Step 4: blur rows */
-      blur_rows (buffer, flipped_buffer, width, height, d);
-    }
+    blur_rows (buffer, tmp_buffer, width, height, d);
 
-  g_free (flipped_buffer);
+  g_free (tmp_buffer);
 }
 
 /*
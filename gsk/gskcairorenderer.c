@@ -6,13 +6,14 @@
 #include "gskrendererprivate.h"
 #include "gskrendernodeprivate.h"
 #include "gdk/gdktextureprivate.h"
+#include "gdk/gdkgltextureprivate.h"
 
-#ifdef G_ENABLE_DEBUG
-typedef struct {
-  GQuark cpu_time;
-  GQuark gpu_time;
-} ProfileTimers;
-#endif
+#include <pango/pangocairo.h>
+
+/* Frames covering at least MIN_TILES tiles of TILE_SIZE x TILE_SIZE
+ * pixels are rasterized in parallel, one tile per thread pool job */
+#define TILE_SIZE 256
+#define MIN_TILES 4
 
 struct _GskCairoRenderer
 {
@@ -20,11 +21,26 @@ struct _GskCairoRenderer
 
   GdkCairoContext *cairo_context;
 
-#ifdef G_ENABLE_DEBUG
-  ProfileTimers profile_timers;
-#endif
+  GThreadPool *tile_pool;
 };
 
+typedef struct
+{
+  GskRenderNode *root;
+  double x_scale, y_scale;
+
+  GMutex lock;
+  GCond done;
+  guint n_pending;
+} TiledFrame;
+
+typedef struct
+{
+  TiledFrame *frame;
+  cairo_rectangle_int_t area;
+  cairo_surface_t *surface;
+} Tile;
+
 struct _GskCairoRendererClass
 {
   GskRendererClass parent_class;
@@ -52,30 +68,212 @@ gsk_cairo_renderer_unrealize (GskRenderer *renderer)
   g_clear_object (&self->cairo_context);
 }
 
+/* Render nodes are immutable, but drawing some of them touches state
+ * that is not safe to share between threads: GL textures need their
+ * context to be current, and replaying a recording surface lets cairo
+ * build lazy caches. Frames containing those are drawn on the calling
+ * thread. As a side effect, this creates the scaled fonts of text nodes
+ * upfront, so the tiles don't race to do that.
+ */
+static gboolean
+node_can_draw_threaded (GskRenderNode *node)
+{
+  guint i;
+
+  switch (gsk_render_node_get_node_type (node))
+    {
+    case GSK_CONTAINER_NODE:
+      for (i = 0; i < gsk_container_node_get_n_children (node); i++)
+        {
+          if (!node_can_draw_threaded (gsk_container_node_get_child (node, i)))
+            return FALSE;
+        }
+      return TRUE;
+
+    case GSK_CAIRO_NODE:
+      {
+        const cairo_surface_t *surface = gsk_cairo_node_peek_surface (node);
+
+        return surface == NULL ||
+               cairo_surface_get_type ((cairo_surface_t *) surface) == CAIRO_SURFACE_TYPE_IMAGE;
+      }
+
+    case GSK_TEXTURE_NODE:
+      return !GDK_IS_GL_TEXTURE (gsk_texture_node_get_texture (node));
+
+    case GSK_TEXT_NODE:
+      pango_cairo_font_get_scaled_font ((PangoCairoFont *) gsk_text_node_peek_font (node));
+      return TRUE;
+
+    case GSK_TRANSFORM_NODE:
+      return node_can_draw_threaded (gsk_transform_node_get_child (node));
+    case GSK_OFFSET_NODE:
+      return node_can_draw_threaded (gsk_offset_node_get_child (node));
+    case GSK_OPACITY_NODE:
+      return node_can_draw_threaded (gsk_opacity_node_get_child (node));
+    case GSK_COLOR_MATRIX_NODE:
+      return node_can_draw_threaded (gsk_color_matrix_node_get_child (node));
+    case GSK_REPEAT_NODE:
+      return node_can_draw_threaded (gsk_repeat_node_get_child (node));
+    case GSK_CLIP_NODE:
+      return node_can_draw_threaded (gsk_clip_node_get_child (node));
+    case GSK_ROUNDED_CLIP_NODE:
+      return node_can_draw_threaded (gsk_rounded_clip_node_get_child (node));
+    case GSK_SHADOW_NODE:
+      return node_can_draw_threaded (gsk_shadow_node_get_child (node));
+    case GSK_BLUR_NODE:
+      return node_can_draw_threaded (gsk_blur_node_get_child (node));
+    case GSK_DEBUG_NODE:
+      return node_can_draw_threaded (gsk_debug_node_get_child (node));
+
+    case GSK_BLEND_NODE:
+      return node_can_draw_threaded (gsk_blend_node_get_bottom_child (node)) &&
+             node_can_draw_threaded (gsk_blend_node_get_top_child (node));
+
+    case GSK_CROSS_FADE_NODE:
+      return node_can_draw_threaded (gsk_cross_fade_node_get_start_child (node)) &&
+             node_can_draw_threaded (gsk_cross_fade_node_get_end_child (node));
+
+    case GSK_COLOR_NODE:
+    case GSK_LINEAR_GRADIENT_NODE:
+    case GSK_REPEATING_LINEAR_GRADIENT_NODE:
+    case GSK_BORDER_NODE:
+    case GSK_INSET_SHADOW_NODE:
+    case GSK_OUTSET_SHADOW_NODE:
+      return TRUE;
+
+    case GSK_NOT_A_RENDER_NODE:
+    default:
+      return FALSE;
+    }
+}
+
 static void
-gsk_cairo_renderer_do_render (GskRenderer   *renderer,
-                              cairo_t       *cr,
-                              GskRenderNode *root)
+draw_tile (gpointer data,
+           gpointer user_data)
 {
-#ifdef G_ENABLE_DEBUG
-  GskCairoRenderer *self = GSK_CAIRO_RENDERER (renderer);
-  GskProfiler *profiler;
-  gint64 cpu_time;
-#endif
+  Tile *tile = data;
+  TiledFrame *frame = tile->frame;
+  cairo_t *cr;
 
-#ifdef G_ENABLE_DEBUG
-  profiler = gsk_renderer_get_profiler (renderer);
-  gsk_profiler_timer_begin (profiler, self->profile_timers.cpu_time);
-#endif
+  tile->surface = cairo_image_surface_create (CAIRO_FORMAT_ARGB32,
+                                              ceil (tile->area.width * frame->x_scale),
+                                              ceil (tile->area.height * frame->y_scale));
+  cairo_surface_set_device_scale (tile->surface, frame->x_scale, frame->y_scale);
+  cairo_surface_set_device_offset (tile->surface,
+                                   - tile->area.x * frame->x_scale,
+                                   - tile->area.y * frame->y_scale);
+
+  cr = cairo_create (tile->surface);
+  cairo_rectangle (cr, tile->area.x, tile->area.y, tile->area.width, tile->area.height);
+  cairo_clip (cr);
+  gsk_render_node_draw (frame->root, cr);
+  cairo_destroy (cr);
 
-  gsk_render_node_draw (root, cr);
+  g_mutex_lock (&frame->lock);
+  frame->n_pending--;
+  if (frame->n_pending == 0)
+    g_cond_signal (&frame->done);
+  g_mutex_unlock (&frame->lock);
+}
 
-#ifdef G_ENABLE_DEBUG
-  cpu_time = gsk_profiler_timer_end (profiler, self->profile_timers.cpu_time);
-  gsk_profiler_timer_set (profiler, self->profile_timers.cpu_time, cpu_time);
+/* Splits @region into tiles, draws them in the thread pool and
+ * composites them onto @cr. Returns %FALSE without drawing anything
+ * if the frame is better drawn directly. */
+static gboolean
+gsk_cairo_renderer_render_tiled (GskCairoRenderer     *self,
+                                 cairo_t              *cr,
+                                 GskRenderNode        *root,
+                                 const cairo_region_t *region)
+{
+  cairo_matrix_t ctm;
+  TiledFrame frame;
+  GArray *tiles;
+  guint i;
+  int r, n_rects;
+
+  if (g_get_num_processors () < 2)
+    return FALSE;
+
+  /* Tiles are composited pixel-aligned, so only allow integral translations */
+  cairo_surface_get_device_scale (cairo_get_target (cr), &frame.x_scale, &frame.y_scale);
+  cairo_get_matrix (cr, &ctm);
+  if (ctm.xx != 1 || ctm.yy != 1 || ctm.xy != 0 || ctm.yx != 0 ||
+      ctm.x0 != floor (ctm.x0) || ctm.y0 != floor (ctm.y0))
+    return FALSE;
+
+  tiles = g_array_new (FALSE, FALSE, sizeof (Tile));
+
+  n_rects = cairo_region_num_rectangles (region);
+  for (r = 0; r < n_rects; r++)
+    {
+      cairo_rectangle_int_t rect;
+      int x, y;
 
-  gsk_profiler_push_samples (profiler);
-#endif
+      cairo_region_get_rectangle (region, r, &rect);
+
+      for (y = rect.y; y < rect.y + rect.height; y += TILE_SIZE)
+        for (x = rect.x; x < rect.x + rect.width; x += TILE_SIZE)
+          {
+            Tile tile = { &frame, { x, y, MIN (TILE_SIZE, rect.x + rect.width - x),
+                                          MIN (TILE_SIZE, rect.y + rect.height - y) }, NULL };
+
+            g_array_append_val (tiles, tile);
+          }
+    }
+
+  if (tiles->len < MIN_TILES || !node_can_draw_threaded (root))
+    {
+      g_array_unref (tiles);
+      return FALSE;
+    }
+
+  if (self->tile_pool == NULL)
+    self->tile_pool = g_thread_pool_new (draw_tile, NULL, g_get_num_processors (), FALSE, NULL);
+
+  frame.root = root;
+  frame.n_pending = tiles->len;
+  g_mutex_init (&frame.lock);
+  g_cond_init (&frame.done);
+
+  for (i = 0; i < tiles->len; i++)
+    g_thread_pool_push (self->tile_pool, &g_array_index (tiles, Tile, i), NULL);
+
+  g_mutex_lock (&frame.lock);
+  while (frame.n_pending > 0)
+    g_cond_wait (&frame.done, &frame.lock);
+  g_mutex_unlock (&frame.lock);
+
+  g_mutex_clear (&frame.lock);
+  g_cond_clear (&frame.done);
+
+  for (i = 0; i < tiles->len; i++)
+    {
+      Tile *tile = &g_array_index (tiles, Tile, i);
+
+      /* The device offset already places the tile in user space */
+      cairo_set_source_surface (cr, tile->surface, 0, 0);
+      cairo_rectangle (cr, tile->area.x, tile->area.y, tile->area.width, tile->area.height);
+      cairo_fill (cr);
+
+      cairo_surface_destroy (tile->surface);
+    }
+
+  g_array_unref (tiles);
+
+  return TRUE;
+}
+
+static void
+gsk_cairo_renderer_do_render (GskRenderer          *renderer,
+                              cairo_t              *cr,
+                              GskRenderNode        *root,
+                              const cairo_region_t *region)
+{
+  if (gsk_cairo_renderer_render_tiled (GSK_CAIRO_RENDERER (renderer), cr, root, region))
+    return;
+
+  gsk_render_node_draw (root, cr);
 }
 
 static GdkTexture *
@@ -85,14 +283,24 @@ gsk_cairo_renderer_render_texture (GskRenderer           *renderer,
 {
   GdkTexture *texture;
   cairo_surface_t *surface;
+  cairo_region_t *region;
   cairo_t *cr;
+  int width, height;
 
-  surface = cairo_image_surface_create (CAIRO_FORMAT_ARGB32, ceil (viewport->size.width), ceil (viewport->size.height));
+  width = ceil (viewport->size.width);
+  height = ceil (viewport->size.height);
+  surface = cairo_image_surface_create (CAIRO_FORMAT_ARGB32, width, height);
   cr = cairo_create (surface);
 
   cairo_translate (cr, - viewport->origin.x, - viewport->origin.y);
 
-  gsk_cairo_renderer_do_render (renderer, cr, root);
+  region = cairo_region_create_rectangle (&(cairo_rectangle_int_t) {
+                                              floor (viewport->origin.x),
+                                              floor (viewport->origin.y),
+                                              width, height
+                                          });
+  gsk_cairo_renderer_do_render (renderer, cr, root, region);
+  cairo_region_destroy (region);
 
   cairo_destroy (cr);
 
@@ -132,18 +340,33 @@ gsk_cairo_renderer_render (GskRenderer          *renderer,
     }
 #endif
 
-  gsk_cairo_renderer_do_render (renderer, cr, root);
+  gsk_cairo_renderer_do_render (renderer, cr, root,
+                                gdk_draw_context_get_frame_region (GDK_DRAW_CONTEXT (self->cairo_context)));
 
   cairo_destroy (cr);
 
   gdk_draw_context_end_frame (GDK_DRAW_CONTEXT (self->cairo_context));
 }
 
+static void
+gsk_cairo_renderer_finalize (GObject *gobject)
+{
+  GskCairoRenderer *self = GSK_CAIRO_RENDERER (gobject);
+
+  if (self->tile_pool)
+    g_thread_pool_free (self->tile_pool, FALSE, TRUE);
+
+  G_OBJECT_CLASS (gsk_cairo_renderer_parent_class)->finalize (gobject);
+}
+
 static void
 gsk_cairo_renderer_class_init (GskCairoRendererClass *klass)
 {
+  GObjectClass *gobject_class = G_OBJECT_CLASS (klass);
   GskRendererClass *renderer_class = GSK_RENDERER_CLASS (klass);
 
+  gobject_class->finalize = gsk_cairo_renderer_finalize;
+
   renderer_class->realize = gsk_cairo_renderer_realize;
   renderer_class->unrealize = gsk_cairo_renderer_unrealize;
   renderer_class->render = gsk_cairo_renderer_render;
@@ -153,9 +376,4 @@ gsk_cairo_renderer_class_init (GskCairoRendererClass *klass)
 static void
 gsk_cairo_renderer_init (GskCairoRenderer *self)
 {
-#ifdef G_ENABLE_DEBUG
-  GskProfiler *profiler = gsk_renderer_get_profiler (GSK_RENDERER (self));
-
-  self->profile_timers.cpu_time = gsk_profiler_add_timer (profiler, "cpu-time", "CPU time", FALSE, TRUE);
-#endif
 }
@@ -0,0 +1,96 @@
+#include "config.h"
+
+#include "gskdiskcacheprivate.h"
+
+#include "gskdebugprivate.h"
+
+#include <glib/gstdio.h>
+
+/* A small on-disk cache for compiled shaders and pipelines, kept below
+ * $XDG_CACHE_HOME/gtk-4.0/gsk. Entries are looked up by a key which the
+ * callers build from everything the data depends on, like the driver and
+ * its version or the shader sources. The GTK version is always made part
+ * of the key, so upgrading GTK doesn't pick up stale data.
+ *
+ * Failure to read or write the cache is never fatal, callers fall back
+ * to compiling from scratch.
+ */
+
+static char *
+gsk_disk_cache_get_path (const char *subdir,
+                         const char *key,
+                         gboolean    create_dir)
+{
+  char *full_key;
+  char *checksum;
+  char *dir;
+  char *path;
+
+  full_key = g_strconcat (GTK_VERSION, "\n", key, NULL);
+  checksum = g_compute_checksum_for_string (G_CHECKSUM_SHA256, full_key, -1);
+  g_free (full_key);
+
+  dir = g_build_filename (g_get_user_cache_dir (), "gtk-4.0", "gsk", subdir, NULL);
+
+  if (create_dir && g_mkdir_with_parents (dir, 0755) != 0)
+    {
+      GSK_NOTE (RENDERER, g_message ("Failed to create cache directory %s", dir));
+      g_free (dir);
+      g_free (checksum);
+      return NULL;
+    }
+
+  path = g_build_filename (dir, checksum, NULL);
+
+  g_free (dir);
+  g_free (checksum);
+
+  return path;
+}
+
+GBytes *
+gsk_disk_cache_load (const char *subdir,
+                     const char *key)
+{
+  char *path;
+  char *contents;
+  gsize length;
+
+  path = gsk_disk_cache_get_path (subdir, key, FALSE);
+
+  if (!g_file_get_contents (path, &contents, &length, NULL))
+    {
+      g_free (path);
+      return NULL;
+    }
+
+  GSK_NOTE (RENDERER, g_message ("Loaded %" G_GSIZE_FORMAT " bytes from %s", length, path));
+
+  g_free (path);
+
+  return g_bytes_new_take (contents, length);
+}
+
+void
+gsk_disk_cache_save (const char    *subdir,
+                     const char    *key,
+                     gconstpointer  data,
+                     gsize          size)
+{
+  GError *error = NULL;
+  char *path;
+
+  path = gsk_disk_cache_get_path (subdir, key, TRUE);
+  if (path == NULL)
+    return;
+
+  /* g_file_set_contents() replaces the file atomically, so concurrent
+   * readers never see partial data */
+  if (!g_file_set_contents (path, data, size, &error))
+    {
+      GSK_NOTE (RENDERER, g_message ("Failed to write %s: %s", path, error->message));
+      g_error_free (error);
+    }
+
+  g_free (path);
+}
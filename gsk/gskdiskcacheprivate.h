@@ -0,0 +1,17 @@
+#ifndef __GSK_DISK_CACHE_PRIVATE_H__
+#define __GSK_DISK_CACHE_PRIVATE_H__
+
+#include <glib.h>
+
+G_BEGIN_DECLS
+
+GBytes *        gsk_disk_cache_load             (const char    *subdir,
+                                                 const char    *key);
+void            gsk_disk_cache_save             (const char    *subdir,
+                                                 const char    *key,
+                                                 gconstpointer  data,
+                                                 gsize          size);
+
+G_END_DECLS
+
+#endif /* __GSK_DISK_CACHE_PRIVATE_H__ */
@@ -0,0 +1,291 @@
+#include "config.h"
+
+#include "gskframecaptureprivate.h"
+
+#include <glib/gstdio.h>
+
+#ifdef G_OS_UNIX
+#include <glib-unix.h>
+#include <signal.h>
+#endif
+
+/* Keeps the last few frames of a renderer, so slow frames can be looked
+ * at after the fact. It is enabled with GSK_FRAME_CAPTURE=N[:MS], for
+ * the last N frames. A frame taking longer than MS milliseconds, 50 by
+ * default, from the start of its layout to the end of its rendering
+ * writes out all captured frames, and so does SIGUSR2 on Unix.
+ *
+ * Each dump is a directory below $XDG_CACHE_HOME/gtk-4.0/frame-captures
+ * with a .node file per frame, for showrendernode, and a frames.ini
+ * with the frame timings and profiler values of each frame.
+ */
+
+#define DEFAULT_THRESHOLD_MS 50
+
+typedef struct
+{
+  GskRenderNode *node;
+  gint64 frame_counter;
+  gint64 frame_time;
+  /* from the start of the layout to the end of rendering, in µs */
+  gint64 duration;
+  GVariant *statistics;
+} CapturedFrame;
+
+struct _GskFrameCapture
+{
+  GdkFrameClock *frame_clock;
+
+  CapturedFrame *frames;
+  guint n_frames;
+  /* the slot the next frame goes to */
+  guint next;
+  guint n_captured;
+  /* new frames since the last dump, so one slow stretch is not
+   * dumped over and over again */
+  guint since_dump;
+};
+
+static guint capture_size;
+static gint64 threshold;
+static GList *captures;
+
+static void
+captured_frame_clear (CapturedFrame *frame)
+{
+  g_clear_pointer (&frame->node, gsk_render_node_unref);
+  g_clear_pointer (&frame->statistics, g_variant_unref);
+}
+
+#ifdef G_OS_UNIX
+static gboolean
+dump_all (gpointer data)
+{
+  GList *l;
+
+  for (l = captures; l; l = l->next)
+    gsk_frame_capture_dump (l->data, "signal");
+
+  return G_SOURCE_CONTINUE;
+}
+#endif
+
+static void
+init_capture (void)
+{
+  static gsize initialized;
+
+  if (g_once_init_enter (&initialized))
+    {
+      const char *env = g_getenv ("GSK_FRAME_CAPTURE");
+
+      if (env)
+        {
+          char *end;
+
+          capture_size = CLAMP (g_ascii_strtoull (env, &end, 10), 0, 1000);
+          threshold = DEFAULT_THRESHOLD_MS;
+          if (*end == ':')
+            threshold = g_ascii_strtoull (end + 1, NULL, 10);
+          threshold *= 1000;
+
+#ifdef G_OS_UNIX
+          if (capture_size > 0)
+            g_unix_signal_add (SIGUSR2, dump_all, NULL);
+#endif
+        }
+
+      g_once_init_leave (&initialized, TRUE);
+    }
+}
+
+/* Returns %NULL unless capturing was asked for */
+GskFrameCapture *
+gsk_frame_capture_new (void)
+{
+  GskFrameCapture *capture;
+
+  init_capture ();
+
+  if (capture_size == 0)
+    return NULL;
+
+  capture = g_slice_new0 (GskFrameCapture);
+  capture->n_frames = capture_size;
+  capture->frames = g_new0 (CapturedFrame, capture_size);
+
+  captures = g_list_prepend (captures, capture);
+
+  return capture;
+}
+
+void
+gsk_frame_capture_free (GskFrameCapture *capture)
+{
+  guint i;
+
+  captures = g_list_remove (captures, capture);
+
+  for (i = 0; i < capture->n_frames; i++)
+    captured_frame_clear (&capture->frames[i]);
+  g_free (capture->frames);
+  g_clear_object (&capture->frame_clock);
+
+  g_slice_free (GskFrameCapture, capture);
+}
+
+void
+gsk_frame_capture_add (GskFrameCapture *capture,
+                       GdkSurface      *surface,
+                       GskRenderNode   *root,
+                       GskProfiler     *profiler)
+{
+  CapturedFrame *frame;
+  GdkFrameClock *frame_clock;
+  GdkFrameTimings *timings;
+  GVariantBuilder builder;
+
+  frame = &capture->frames[capture->next];
+  captured_frame_clear (frame);
+
+  frame->node = gsk_render_node_ref (root);
+
+  g_variant_builder_init (&builder, G_VARIANT_TYPE ("a{sx}"));
+  gsk_profiler_append_values (profiler, &builder);
+  frame->statistics = g_variant_ref_sink (g_variant_builder_end (&builder));
+
+  /* nanoseconds */
+  frame->duration = gsk_profiler_timer_get (profiler, g_quark_from_static_string ("cpu-time")) / 1000;
+  frame->frame_counter = -1;
+  frame->frame_time = 0;
+
+  frame_clock = gdk_surface_get_frame_clock (surface);
+  if (frame_clock)
+    {
+      g_set_object (&capture->frame_clock, frame_clock);
+
+      /* the paint phase is still running, it is where we are */
+      timings = gdk_frame_clock_get_current_timings (frame_clock);
+      if (timings)
+        {
+          frame->frame_counter = gdk_frame_timings_get_frame_counter (timings);
+          frame->frame_time = gdk_frame_timings_get_frame_time (timings);
+          frame->duration += gdk_frame_timings_get_update_duration (timings) +
+                             gdk_frame_timings_get_layout_duration (timings);
+        }
+    }
+
+  capture->next = (capture->next + 1) % capture->n_frames;
+  capture->n_captured = MIN (capture->n_captured + 1, capture->n_frames);
+  capture->since_dump++;
+
+  if (frame->duration > threshold && capture->since_dump >= capture->n_frames)
+    gsk_frame_capture_dump (capture, "slow frame");
+}
+
+static void
+add_frame_timings (GKeyFile        *key_file,
+                   const char      *group,
+                   GdkFrameTimings *timings)
+{
+  g_key_file_set_int64 (key_file, group, "events-duration",
+                        gdk_frame_timings_get_events_duration (timings));
+  g_key_file_set_int64 (key_file, group, "update-duration",
+                        gdk_frame_timings_get_update_duration (timings));
+  g_key_file_set_int64 (key_file, group, "layout-duration",
+                        gdk_frame_timings_get_layout_duration (timings));
+  g_key_file_set_int64 (key_file, group, "paint-duration",
+                        gdk_frame_timings_get_paint_duration (timings));
+
+  if (gdk_frame_timings_get_complete (timings) &&
+      gdk_frame_timings_get_presentation_time (timings) != 0)
+    g_key_file_set_int64 (key_file, group, "presentation-time",
+                          gdk_frame_timings_get_presentation_time (timings));
+}
+
+/* Writes all captured frames, oldest first */
+void
+gsk_frame_capture_dump (GskFrameCapture *capture,
+                        const char      *reason)
+{
+  GKeyFile *key_file;
+  GError *error = NULL;
+  char *dirname, *basename, *filename;
+  guint i;
+
+  if (capture->n_captured == 0)
+    return;
+
+  basename = g_strdup_printf ("%s-%" G_GINT64_FORMAT,
+                              g_get_prgname () ? g_get_prgname () : "gtk",
+                              g_get_real_time ());
+  dirname = g_build_filename (g_get_user_cache_dir (), "gtk-4.0", "frame-captures", basename, NULL);
+  g_free (basename);
+
+  if (g_mkdir_with_parents (dirname, 0700) != 0)
+    {
+      g_warning ("Could not create %s to capture frames", dirname);
+      g_free (dirname);
+      return;
+    }
+
+  key_file = g_key_file_new ();
+  g_key_file_set_string (key_file, "capture", "reason", reason);
+
+  for (i = 0; i < capture->n_captured; i++)
+    {
+      guint index = (capture->next + capture->n_frames - capture->n_captured + i) % capture->n_frames;
+      CapturedFrame *frame = &capture->frames[index];
+      GVariantIter iter;
+      const char *name;
+      gint64 value;
+      char *group;
+
+      group = g_strdup_printf ("frame %u", i);
+      basename = g_strdup_printf ("frame-%u.node", i);
+      filename = g_build_filename (dirname, basename, NULL);
+
+      if (!gsk_render_node_write_to_file (frame->node, filename, &error))
+        {
+          g_warning ("Could not write captured frame: %s", error->message);
+          g_clear_error (&error);
+        }
+
+      g_key_file_set_string (key_file, group, "node", basename);
+      g_key_file_set_int64 (key_file, group, "frame-counter", frame->frame_counter);
+      g_key_file_set_int64 (key_file, group, "frame-time", frame->frame_time);
+      g_key_file_set_int64 (key_file, group, "duration", frame->duration);
+
+      /* Complete timings of the frame, if the clock still has them */
+      if (capture->frame_clock && frame->frame_counter >= 0)
+        {
+          GdkFrameTimings *timings = gdk_frame_clock_get_timings (capture->frame_clock,
+                                                                  frame->frame_counter);
+          if (timings)
+            add_frame_timings (key_file, group, timings);
+        }
+
+      g_variant_iter_init (&iter, frame->statistics);
+      while (g_variant_iter_next (&iter, "{&sx}", &name, &value))
+        g_key_file_set_int64 (key_file, group, name, value);
+
+      g_free (filename);
+      g_free (basename);
+      g_free (group);
+    }
+
+  filename = g_build_filename (dirname, "frames.ini", NULL);
+  if (!g_key_file_save_to_file (key_file, filename, &error))
+    {
+      g_warning ("Could not write captured frames: %s", error->message);
+      g_clear_error (&error);
+    }
+  else
+    g_message ("Captured %u frames to %s (%s)", capture->n_captured, dirname, reason);
+
+  g_free (filename);
+  g_key_file_free (key_file);
+  g_free (dirname);
+
+  capture->since_dump = 0;
+}
@@ -0,0 +1,25 @@
+#ifndef __GSK_FRAME_CAPTURE_PRIVATE_H__
+#define __GSK_FRAME_CAPTURE_PRIVATE_H__
+
+#include <gdk/gdk.h>
+
+#include "gskrendernode.h"
+#include "gskprofilerprivate.h"
+
+G_BEGIN_DECLS
+
+typedef struct _GskFrameCapture GskFrameCapture;
+
+GskFrameCapture *       gsk_frame_capture_new           (void);
+void                    gsk_frame_capture_free          (GskFrameCapture *capture);
+
+void                    gsk_frame_capture_add           (GskFrameCapture *capture,
+                                                         GdkSurface      *surface,
+                                                         GskRenderNode   *root,
+                                                         GskProfiler     *profiler);
+void                    gsk_frame_capture_dump          (GskFrameCapture *capture,
+                                                         const char      *reason);
+
+G_END_DECLS
+
+#endif /* __GSK_FRAME_CAPTURE_PRIVATE_H__ */
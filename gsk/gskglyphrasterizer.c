@@ -0,0 +1,288 @@
+#include "config.h"
+
+#include "gskglyphrasterizerprivate.h"
+
+#include <pango/pangocairo.h>
+
+/* The glyph rasterizer is shared by all renderers of a display, so glyphs
+ * that are shown in several windows only get rendered with cairo once.
+ * The renderers keep their own atlases and only upload the resulting
+ * surfaces.
+ *
+ * Rasterized glyphs are kept around in a LRU list, until they take up more
+ * than MAX_CACHED_BYTES, at which point the least recently used ones are
+ * dropped. Scales are given times 1024, like in the renderers' glyph caches.
+ */
+
+#define MAX_CACHED_BYTES (4 * 1024 * 1024)
+
+typedef struct {
+  PangoFont *font;
+  PangoGlyph glyph;
+  guint scale; /* times 1024 */
+} GlyphKey;
+
+typedef struct {
+  GlyphKey key;
+  PangoRectangle ink_rect;
+  cairo_surface_t *surface;
+  GList link;
+} RasterizedGlyph;
+
+struct _GskGlyphRasterizer
+{
+  GObject parent_instance;
+
+  GHashTable *glyphs;
+  GQueue lru;
+  gsize cached_bytes;
+};
+
+G_DEFINE_TYPE (GskGlyphRasterizer, gsk_glyph_rasterizer, G_TYPE_OBJECT)
+
+static guint
+glyph_key_hash (gconstpointer v)
+{
+  const GlyphKey *key = v;
+
+  return GPOINTER_TO_UINT (key->font) ^ key->glyph ^ key->scale;
+}
+
+static gboolean
+glyph_key_equal (gconstpointer v1,
+                 gconstpointer v2)
+{
+  const GlyphKey *key1 = v1;
+  const GlyphKey *key2 = v2;
+
+  return key1->font == key2->font &&
+         key1->glyph == key2->glyph &&
+         key1->scale == key2->scale;
+}
+
+static void
+rasterized_glyph_free (gpointer v)
+{
+  RasterizedGlyph *glyph = v;
+
+  g_object_unref (glyph->key.font);
+  if (glyph->surface)
+    cairo_surface_destroy (glyph->surface);
+  g_free (glyph);
+}
+
+static gsize
+rasterized_glyph_size (RasterizedGlyph *glyph)
+{
+  gsize size = sizeof (RasterizedGlyph);
+
+  if (glyph->surface)
+    size += cairo_image_surface_get_stride (glyph->surface) *
+            cairo_image_surface_get_height (glyph->surface);
+
+  return size;
+}
+
+static void
+gsk_glyph_rasterizer_finalize (GObject *object)
+{
+  GskGlyphRasterizer *self = GSK_GLYPH_RASTERIZER (object);
+
+  /* The LRU links are embedded in the glyphs */
+  g_hash_table_unref (self->glyphs);
+
+  G_OBJECT_CLASS (gsk_glyph_rasterizer_parent_class)->finalize (object);
+}
+
+static void
+gsk_glyph_rasterizer_class_init (GskGlyphRasterizerClass *klass)
+{
+  GObjectClass *object_class = G_OBJECT_CLASS (klass);
+
+  object_class->finalize = gsk_glyph_rasterizer_finalize;
+}
+
+static void
+gsk_glyph_rasterizer_init (GskGlyphRasterizer *self)
+{
+  self->glyphs = g_hash_table_new_full (glyph_key_hash, glyph_key_equal,
+                                        NULL, rasterized_glyph_free);
+  g_queue_init (&self->lru);
+}
+
+/**
+ * gsk_glyph_rasterizer_get_for_display:
+ * @display: a #GdkDisplay
+ *
+ * Returns the glyph rasterizer that is shared by all renderers of @display.
+ *
+ * Returns: (transfer none): the glyph rasterizer
+ */
+GskGlyphRasterizer *
+gsk_glyph_rasterizer_get_for_display (GdkDisplay *display)
+{
+  GskGlyphRasterizer *self;
+
+  g_return_val_if_fail (GDK_IS_DISPLAY (display), NULL);
+
+  self = g_object_get_data (G_OBJECT (display), "gsk-glyph-rasterizer");
+  if (self == NULL)
+    {
+      self = g_object_new (GSK_TYPE_GLYPH_RASTERIZER, NULL);
+      g_object_set_data_full (G_OBJECT (display), "gsk-glyph-rasterizer",
+                              self, g_object_unref);
+    }
+
+  return self;
+}
+
+static void
+gsk_glyph_rasterizer_shrink (GskGlyphRasterizer *self,
+                             RasterizedGlyph    *keep)
+{
+  while (self->cached_bytes > MAX_CACHED_BYTES &&
+         self->lru.head != NULL &&
+         self->lru.head->data != keep)
+    {
+      RasterizedGlyph *oldest = self->lru.head->data;
+
+      self->cached_bytes -= rasterized_glyph_size (oldest);
+      g_queue_unlink (&self->lru, &oldest->link);
+      g_hash_table_remove (self->glyphs, &oldest->key);
+    }
+}
+
+static RasterizedGlyph *
+gsk_glyph_rasterizer_lookup (GskGlyphRasterizer *self,
+                             PangoFont          *font,
+                             PangoGlyph          glyph,
+                             guint               scale)
+{
+  RasterizedGlyph *value;
+
+  value = g_hash_table_lookup (self->glyphs,
+                               &(GlyphKey) {
+                                 .font = font,
+                                 .glyph = glyph,
+                                 .scale = scale
+                               });
+
+  if (value)
+    {
+      g_queue_unlink (&self->lru, &value->link);
+      g_queue_push_tail_link (&self->lru, &value->link);
+      return value;
+    }
+
+  value = g_new0 (RasterizedGlyph, 1);
+  value->key.font = g_object_ref (font);
+  value->key.glyph = glyph;
+  value->key.scale = scale;
+  value->link.data = value;
+
+  pango_font_get_glyph_extents (font, glyph, &value->ink_rect, NULL);
+  pango_extents_to_pixels (&value->ink_rect, NULL);
+
+  g_hash_table_insert (self->glyphs, &value->key, value);
+  g_queue_push_tail_link (&self->lru, &value->link);
+
+  self->cached_bytes += rasterized_glyph_size (value);
+  gsk_glyph_rasterizer_shrink (self, value);
+
+  return value;
+}
+
+/**
+ * gsk_glyph_rasterizer_get_extents:
+ * @self: a #GskGlyphRasterizer
+ * @font: the font of the glyph
+ * @glyph: the glyph
+ * @scale: the scale to render at, times 1024
+ * @ink_rect: (out): return location for the ink extents, in pixels
+ *
+ * Gets the ink extents of @glyph, the way pango_font_get_glyph_extents()
+ * would return them after they have been converted to pixels.
+ */
+void
+gsk_glyph_rasterizer_get_extents (GskGlyphRasterizer *self,
+                                  PangoFont          *font,
+                                  PangoGlyph          glyph,
+                                  guint               scale,
+                                  PangoRectangle     *ink_rect)
+{
+  RasterizedGlyph *value;
+
+  value = gsk_glyph_rasterizer_lookup (self, font, glyph, scale);
+
+  *ink_rect = value->ink_rect;
+}
+
+/**
+ * gsk_glyph_rasterizer_get_surface:
+ * @self: a #GskGlyphRasterizer
+ * @font: the font of the glyph
+ * @glyph: the glyph
+ * @scale: the scale to render at, times 1024
+ *
+ * Renders @glyph into an image surface that covers its ink extents
+ * at the given scale. The result is cached, so a glyph that is requested
+ * by several renderers only gets rendered once.
+ *
+ * Returns: (transfer full) (nullable): a new reference to the surface,
+ *   or %NULL if the glyph could not be rendered
+ */
+cairo_surface_t *
+gsk_glyph_rasterizer_get_surface (GskGlyphRasterizer *self,
+                                  PangoFont          *font,
+                                  PangoGlyph          glyph,
+                                  guint               scale)
+{
+  RasterizedGlyph *value;
+  cairo_surface_t *surface;
+  cairo_t *cr;
+  cairo_scaled_font_t *scaled_font;
+  PangoGlyphString glyph_string;
+  PangoGlyphInfo glyph_info;
+
+  value = gsk_glyph_rasterizer_lookup (self, font, glyph, scale);
+
+  if (value->surface)
+    return cairo_surface_reference (value->surface);
+
+  scaled_font = pango_cairo_font_get_scaled_font ((PangoCairoFont *)font);
+  if (G_UNLIKELY (!scaled_font || cairo_scaled_font_status (scaled_font) != CAIRO_STATUS_SUCCESS))
+    return NULL;
+
+  surface = cairo_image_surface_create (CAIRO_FORMAT_ARGB32,
+                                        value->ink_rect.width * scale / 1024,
+                                        value->ink_rect.height * scale / 1024);
+  cairo_surface_set_device_scale (surface, scale / 1024.0, scale / 1024.0);
+
+  cr = cairo_create (surface);
+
+  cairo_set_scaled_font (cr, scaled_font);
+  cairo_set_source_rgba (cr, 1, 1, 1, 1);
+
+  glyph_info.glyph = glyph;
+  glyph_info.geometry.width = value->ink_rect.width * 1024;
+  if (glyph & PANGO_GLYPH_UNKNOWN_FLAG)
+    glyph_info.geometry.x_offset = 0;
+  else
+    glyph_info.geometry.x_offset = - value->ink_rect.x * 1024;
+  glyph_info.geometry.y_offset = - value->ink_rect.y * 1024;
+
+  glyph_string.num_glyphs = 1;
+  glyph_string.glyphs = &glyph_info;
+
+  pango_cairo_show_glyph_string (cr, font, &glyph_string);
+  cairo_destroy (cr);
+
+  cairo_surface_flush (surface);
+
+  self->cached_bytes -= rasterized_glyph_size (value);
+  value->surface = surface;
+  self->cached_bytes += rasterized_glyph_size (value);
+  gsk_glyph_rasterizer_shrink (self, value);
+
+  return cairo_surface_reference (surface);
+}
@@ -0,0 +1,27 @@
+#ifndef __GSK_GLYPH_RASTERIZER_PRIVATE_H__
+#define __GSK_GLYPH_RASTERIZER_PRIVATE_H__
+
+#include <gdk/gdk.h>
+#include <pango/pango.h>
+#include <cairo.h>
+
+G_BEGIN_DECLS
+
+#define GSK_TYPE_GLYPH_RASTERIZER (gsk_glyph_rasterizer_get_type ())
+G_DECLARE_FINAL_TYPE (GskGlyphRasterizer, gsk_glyph_rasterizer, GSK, GLYPH_RASTERIZER, GObject)
+
+GskGlyphRasterizer * gsk_glyph_rasterizer_get_for_display (GdkDisplay         *display);
+
+void                 gsk_glyph_rasterizer_get_extents     (GskGlyphRasterizer *self,
+                                                           PangoFont          *font,
+                                                           PangoGlyph          glyph,
+                                                           guint               scale,
+                                                           PangoRectangle     *ink_rect);
+cairo_surface_t *    gsk_glyph_rasterizer_get_surface     (GskGlyphRasterizer *self,
+                                                           PangoFont          *font,
+                                                           PangoGlyph          glyph,
+                                                           guint               scale);
+
+G_END_DECLS
+
+#endif /* __GSK_GLYPH_RASTERIZER_PRIVATE_H__ */
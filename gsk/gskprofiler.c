@@ -513,3 +513,34 @@ gsk_profiler_append_timers (GskProfiler *profiler,
       g_string_append (buffer, "\n");
     }
 }
+
+void
+gsk_profiler_append_values (GskProfiler     *profiler,
+                            GVariantBuilder *builder)
+{
+  GHashTableIter iter;
+  gpointer value_p = NULL;
+
+  g_return_if_fail (GSK_IS_PROFILER (profiler));
+  g_return_if_fail (builder != NULL);
+
+  g_hash_table_iter_init (&iter, profiler->counters);
+  while (g_hash_table_iter_next (&iter, NULL, &value_p))
+    {
+      NamedCounter *counter = value_p;
+
+      g_variant_builder_add (builder, "{sx}",
+                             g_quark_to_string (counter->id),
+                             counter->value);
+    }
+
+  g_hash_table_iter_init (&iter, profiler->timers);
+  while (g_hash_table_iter_next (&iter, NULL, &value_p))
+    {
+      NamedTimer *timer = value_p;
+
+      g_variant_builder_add (builder, "{sx}",
+                             g_quark_to_string (timer->id),
+                             gsk_profiler_timer_get (profiler, timer->id));
+    }
+}
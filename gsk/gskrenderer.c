@@ -38,12 +38,16 @@
 
 #include "gskcairorendererprivate.h"
 #include "gskdebugprivate.h"
+#include "gskframecaptureprivate.h"
 #include "gl/gskglrendererprivate.h"
 #include "gskprofilerprivate.h"
 #include "gskrendernodeprivate.h"
 
 #include "gskenumtypes.h"
 
+#include "gdk/gdkprofilerprivate.h"
+#include "gdk/gdksubsurfaceprivate.h"
+
 #include <graphene-gobject.h>
 #include <cairo-gobject.h>
 #include <gdk/gdk.h>
@@ -71,10 +75,26 @@ typedef struct
   GdkDisplay *display;
 
   GskProfiler *profiler;
+  struct {
+    GQuark frames;
+  } profile_counters;
+  struct {
+    GQuark cpu_time;
+  } profile_timers;
 
   GskDebugFlags debug_flags;
 
+  /* The last frames, if GSK_FRAME_CAPTURE is set */
+  GskFrameCapture *capture;
+
+  /* Shows a texture node of the last frame, if any, instead of
+   * us drawing it */
+  GdkSubsurface *subsurface;
+  GdkTexture *offload_texture;
+  graphene_rect_t offload_rect;
+
   gboolean is_realized : 1;
+  gboolean subsurface_failed : 1;
 } GskRendererPrivate;
 
 G_DEFINE_ABSTRACT_TYPE_WITH_PRIVATE (GskRenderer, gsk_renderer, G_TYPE_OBJECT)
@@ -250,6 +270,43 @@ gsk_renderer_init (GskRenderer *self)
 
   priv->profiler = gsk_profiler_new ();
   priv->debug_flags = gsk_get_debug_flags ();
+
+  /* The counters every renderer provides, see gsk_renderer_get_statistics().
+   * Renderers look them up by name with g_quark_from_static_string(). */
+  priv->profile_counters.frames = gsk_profiler_add_counter (priv->profiler, "frames", "Frames", FALSE);
+  gsk_profiler_add_counter (priv->profiler, "draw-calls", "Draw calls", TRUE);
+  gsk_profiler_add_counter (priv->profiler, "offscreens", "Offscreens", TRUE);
+  gsk_profiler_add_counter (priv->profiler, "upload-bytes", "Uploaded bytes", TRUE);
+  gsk_profiler_add_counter (priv->profiler, "fallback-nodes", "Fallback nodes", TRUE);
+  gsk_profiler_add_counter (priv->profiler, "culled-nodes", "Culled nodes", TRUE);
+  gsk_profiler_add_counter (priv->profiler, "glyph-cache-hits", "Glyph cache hits", TRUE);
+  gsk_profiler_add_counter (priv->profiler, "glyph-cache-misses", "Glyph cache misses", TRUE);
+
+  priv->profile_timers.cpu_time = gsk_profiler_add_timer (priv->profiler, "cpu-time", "CPU time", FALSE, TRUE);
+  gsk_profiler_add_timer (priv->profiler, "gpu-time", "GPU time", FALSE, TRUE);
+}
+
+static void
+gsk_renderer_begin_profile (GskRenderer *renderer)
+{
+  GskRendererPrivate *priv = gsk_renderer_get_instance_private (renderer);
+
+  gsk_profiler_reset (priv->profiler);
+  gsk_profiler_timer_begin (priv->profiler, priv->profile_timers.cpu_time);
+}
+
+static void
+gsk_renderer_end_profile (GskRenderer *renderer)
+{
+  GskRendererPrivate *priv = gsk_renderer_get_instance_private (renderer);
+  gint64 cpu_time;
+
+  gsk_profiler_counter_inc (priv->profiler, priv->profile_counters.frames);
+
+  cpu_time = gsk_profiler_timer_end (priv->profiler, priv->profile_timers.cpu_time);
+  gsk_profiler_timer_set (priv->profiler, priv->profile_timers.cpu_time, cpu_time);
+
+  gsk_profiler_push_samples (priv->profiler);
 }
 
 /**
@@ -354,6 +411,8 @@ gsk_renderer_realize (GskRenderer  *renderer,
       return FALSE;
     }
 
+  priv->capture = gsk_frame_capture_new ();
+
   priv->is_realized = TRUE;
   return TRUE;
 }
@@ -377,6 +436,10 @@ gsk_renderer_unrealize (GskRenderer *renderer)
   GSK_RENDERER_GET_CLASS (renderer)->unrealize (renderer);
 
   g_clear_pointer (&priv->prev_node, gsk_render_node_unref);
+  g_clear_object (&priv->subsurface);
+  g_clear_object (&priv->offload_texture);
+  priv->subsurface_failed = FALSE;
+  g_clear_pointer (&priv->capture, gsk_frame_capture_free);
 
   priv->is_realized = FALSE;
 }
@@ -420,7 +483,9 @@ gsk_renderer_render_texture (GskRenderer           *renderer,
       viewport = &real_viewport;
     }
 
+  gsk_renderer_begin_profile (renderer);
   texture = GSK_RENDERER_GET_CLASS (renderer)->render_texture (renderer, root, viewport);
+  gsk_renderer_end_profile (renderer);
 
 #ifdef G_ENABLE_DEBUG
   if (GSK_RENDERER_DEBUG_CHECK (renderer, RENDERER))
@@ -444,36 +509,215 @@ gsk_renderer_render_texture (GskRenderer           *renderer,
   return texture;
 }
 
-/**
- * gsk_renderer_render:
- * @renderer: a #GskRenderer
- * @root: a #GskRenderNode
- * @region: (nullable): the #cairo_region_t that must be redrawn or %NULL
- *     for the whole window
- *
- * Renders the scene graph, described by a tree of #GskRenderNode instances,
- * ensuring that the given @region gets redrawn.
- *
- * Renderers must ensure that changes of the contents given by the @root
- * node as well as the area given by @region are redrawn. They are however
- * free to not redraw any pixel outside of @region if they can guarantee that
- * it didn't change.
- *
- * The @renderer will acquire a reference on the #GskRenderNode tree while
- * the rendering is in progress.
- */
-void
-gsk_renderer_render (GskRenderer          *renderer,
-                     GskRenderNode        *root,
-                     const cairo_region_t *region)
+/* Textures smaller than this are cheaper to draw than to hand
+ * to the compositor */
+#define MIN_OFFLOAD_SIZE 256
+
+/* Finds the texture node that is drawn on top of everything else
+ * in its area, so that showing it in a subsurface above the window
+ * gives the same result as drawing it. We only look through nodes
+ * that don't change how the texture is drawn. */
+static GskRenderNode *
+find_offload_node (GskRenderNode   *node,
+                   float            dx,
+                   float            dy,
+                   graphene_rect_t *rect)
+{
+  switch (gsk_render_node_get_node_type (node))
+    {
+    case GSK_TEXTURE_NODE:
+      {
+        GdkTexture *texture = gsk_texture_node_get_texture (node);
+
+        if (gdk_texture_get_width (texture) < MIN_OFFLOAD_SIZE ||
+            gdk_texture_get_height (texture) < MIN_OFFLOAD_SIZE)
+          return NULL;
+
+        graphene_rect_offset_r (&node->bounds, dx, dy, rect);
+
+        return node;
+      }
+
+    case GSK_OFFSET_NODE:
+      return find_offload_node (gsk_offset_node_get_child (node),
+                                dx + gsk_offset_node_get_x_offset (node),
+                                dy + gsk_offset_node_get_y_offset (node),
+                                rect);
+
+    case GSK_CLIP_NODE:
+      {
+        GskRenderNode *found;
+        graphene_rect_t clip;
+
+        found = find_offload_node (gsk_clip_node_get_child (node), dx, dy, rect);
+        if (found == NULL)
+          return NULL;
+
+        graphene_rect_offset_r (gsk_clip_node_peek_clip (node), dx, dy, &clip);
+        if (!graphene_rect_contains_rect (&clip, rect))
+          return NULL;
+
+        return found;
+      }
+
+    case GSK_CONTAINER_NODE:
+      {
+        guint i, j, n_children;
+
+        n_children = gsk_container_node_get_n_children (node);
+
+        for (i = n_children; i > 0; i--)
+          {
+            GskRenderNode *found;
+
+            found = find_offload_node (gsk_container_node_get_child (node, i - 1), dx, dy, rect);
+            if (found == NULL)
+              continue;
+
+            for (j = i; j < n_children; j++)
+              {
+                graphene_rect_t bounds;
+
+                graphene_rect_offset_r (&gsk_container_node_get_child (node, j)->bounds, dx, dy, &bounds);
+                if (graphene_rect_intersection (&bounds, rect, NULL))
+                  return NULL;
+              }
+
+            return found;
+          }
+
+        return NULL;
+      }
+
+    default:
+      return NULL;
+    }
+}
+
+/* Returns a copy of @node with @target replaced by an empty node */
+static GskRenderNode *
+replace_offload_node (GskRenderNode *node,
+                      GskRenderNode *target)
+{
+  GskRenderNode *child, *result;
+
+  if (node == target)
+    return gsk_container_node_new (NULL, 0);
+
+  switch (gsk_render_node_get_node_type (node))
+    {
+    case GSK_OFFSET_NODE:
+      child = replace_offload_node (gsk_offset_node_get_child (node), target);
+      result = gsk_offset_node_new (child,
+                                    gsk_offset_node_get_x_offset (node),
+                                    gsk_offset_node_get_y_offset (node));
+      gsk_render_node_unref (child);
+      return result;
+
+    case GSK_CLIP_NODE:
+      child = replace_offload_node (gsk_clip_node_get_child (node), target);
+      result = gsk_clip_node_new (child, gsk_clip_node_peek_clip (node));
+      gsk_render_node_unref (child);
+      return result;
+
+    case GSK_CONTAINER_NODE:
+      {
+        guint i, n_children;
+        GskRenderNode **children;
+
+        n_children = gsk_container_node_get_n_children (node);
+        children = g_newa (GskRenderNode *, n_children);
+
+        for (i = 0; i < n_children; i++)
+          children[i] = replace_offload_node (gsk_container_node_get_child (node, i), target);
+
+        result = gsk_container_node_new (children, n_children);
+
+        for (i = 0; i < n_children; i++)
+          gsk_render_node_unref (children[i]);
+
+        return result;
+      }
+
+    default:
+      return gsk_render_node_ref (node);
+    }
+}
+
+/* Hands the topmost big texture of @root to the compositor if the
+ * backend supports it, and returns the node to draw ourselves.
+ * @changed is set if the subsurface needs a new frame of the
+ * window to be committed. */
+static GskRenderNode *
+gsk_renderer_offload (GskRenderer   *renderer,
+                      GskRenderNode *root,
+                      gboolean      *changed)
+{
+  GskRendererPrivate *priv = gsk_renderer_get_instance_private (renderer);
+  GskRenderNode *node;
+  GdkTexture *texture;
+  graphene_rect_t rect;
+
+  *changed = FALSE;
+
+  if (priv->subsurface == NULL)
+    {
+      if (priv->subsurface_failed || GSK_RENDERER_DEBUG_CHECK (renderer, NO_OFFLOAD))
+        return gsk_render_node_ref (root);
+
+      priv->subsurface = gdk_surface_create_subsurface (priv->surface);
+      if (priv->subsurface == NULL)
+        {
+          priv->subsurface_failed = TRUE;
+          return gsk_render_node_ref (root);
+        }
+    }
+
+  node = find_offload_node (root, 0, 0, &rect);
+  texture = node ? gsk_texture_node_get_texture (node) : NULL;
+
+  if (texture && gdk_subsurface_attach (priv->subsurface, texture, &rect))
+    {
+      *changed = texture != priv->offload_texture ||
+                 !graphene_rect_equal (&rect, &priv->offload_rect);
+
+      g_set_object (&priv->offload_texture, texture);
+      priv->offload_rect = rect;
+
+      GSK_RENDERER_NOTE (renderer, RENDERER,
+                         g_message ("Offloading %dx%d texture to subsurface",
+                                    gdk_texture_get_width (texture),
+                                    gdk_texture_get_height (texture)));
+
+      return replace_offload_node (root, node);
+    }
+
+  if (priv->offload_texture)
+    {
+      gdk_subsurface_detach (priv->subsurface);
+      g_clear_object (&priv->offload_texture);
+      *changed = TRUE;
+    }
+
+  return gsk_render_node_ref (root);
+}
+
+static void
+gsk_renderer_render_internal (GskRenderer          *renderer,
+                              GskRenderNode        *root,
+                              const cairo_region_t *region,
+                              gboolean              region_is_damage)
 {
   GskRendererPrivate *priv = gsk_renderer_get_instance_private (renderer);
+  GskRenderNode *frame = root;
   cairo_region_t *clip;
+  gboolean offload_changed;
+  gint64 before;
 
-  g_return_if_fail (GSK_IS_RENDERER (renderer));
-  g_return_if_fail (priv->is_realized);
-  g_return_if_fail (GSK_IS_RENDER_NODE (root));
-  g_return_if_fail (priv->root_node == NULL);
+  /* If a texture goes to a subsurface, we draw the tree without it,
+   * and diffing against the previous frame sees no change when only
+   * the texture did */
+  root = gsk_renderer_offload (renderer, root, &offload_changed);
 
   if (region == NULL || priv->prev_node == NULL || GSK_RENDERER_DEBUG_CHECK (renderer, FULL_REDRAW))
     {
@@ -486,18 +730,41 @@ gsk_renderer_render (GskRenderer          *renderer,
   else
     {
       clip = cairo_region_copy (region);
-      gsk_render_node_diff (priv->prev_node, root, clip);
+      if (!region_is_damage)
+        gsk_render_node_diff (priv->prev_node, root, clip);
+
+      /* Subsurface changes are only applied with the next commit
+       * of the window, so we need a frame even if nothing else changed */
+      if (cairo_region_is_empty (clip) && offload_changed)
+        {
+          /* the subsurface only takes integral positions and sizes */
+          cairo_region_union_rectangle (clip, &(cairo_rectangle_int_t) {
+                                                  priv->offload_rect.origin.x,
+                                                  priv->offload_rect.origin.y,
+                                                  MAX (1, priv->offload_rect.size.width),
+                                                  MAX (1, priv->offload_rect.size.height)
+                                              });
+        }
 
       if (cairo_region_is_empty (clip))
         {
           cairo_region_destroy (clip);
+          gsk_render_node_unref (root);
           return;
         }
     }
 
   priv->root_node = gsk_render_node_ref (root);
 
+  before = gdk_profiler_current_time ();
+  gsk_renderer_begin_profile (renderer);
   GSK_RENDERER_GET_CLASS (renderer)->render (renderer, root, clip);
+  gsk_renderer_end_profile (renderer);
+  gdk_profiler_end_mark (before, "render", G_OBJECT_TYPE_NAME (renderer));
+
+  /* with the offloaded texture, so it can be replayed */
+  if (priv->capture)
+    gsk_frame_capture_add (priv->capture, priv->surface, frame, priv->profiler);
 
 #ifdef G_ENABLE_DEBUG
   if (GSK_RENDERER_DEBUG_CHECK (renderer, RENDERER))
@@ -520,6 +787,111 @@ gsk_renderer_render (GskRenderer          *renderer,
   cairo_region_destroy (clip);
   priv->prev_node = priv->root_node;
   priv->root_node = NULL;
+  gsk_render_node_unref (root);
+}
+
+/**
+ * gsk_renderer_render:
+ * @renderer: a #GskRenderer
+ * @root: a #GskRenderNode
+ * @region: (nullable): the #cairo_region_t that must be redrawn or %NULL
+ *     for the whole window
+ *
+ * Renders the scene graph, described by a tree of #GskRenderNode instances,
+ * ensuring that the given @region gets redrawn.
+ *
+ * Renderers must ensure that changes of the contents given by the @root
+ * node as well as the area given by @region are redrawn. They are however
+ * free to not redraw any pixel outside of @region if they can guarantee that
+ * it didn't change.
+ *
+ * The @renderer will acquire a reference on the #GskRenderNode tree while
+ * the rendering is in progress.
+ */
+void
+gsk_renderer_render (GskRenderer          *renderer,
+                     GskRenderNode        *root,
+                     const cairo_region_t *region)
+{
+  GskRendererPrivate *priv = gsk_renderer_get_instance_private (renderer);
+
+  g_return_if_fail (GSK_IS_RENDERER (renderer));
+  g_return_if_fail (priv->is_realized);
+  g_return_if_fail (GSK_IS_RENDER_NODE (root));
+  g_return_if_fail (priv->root_node == NULL);
+
+  gsk_renderer_render_internal (renderer, root, region, FALSE);
+}
+
+/*< private >
+ * gsk_renderer_render_damage:
+ * @renderer: a #GskRenderer
+ * @root: a #GskRenderNode
+ * @damage: the region that changed since the last rendered frame
+ *
+ * Like gsk_renderer_render(), but the caller guarantees that @damage
+ * covers every difference between the previously rendered node and
+ * @root, so the two trees are not diffed and only @damage is redrawn.
+ */
+void
+gsk_renderer_render_damage (GskRenderer          *renderer,
+                            GskRenderNode        *root,
+                            const cairo_region_t *damage)
+{
+  GskRendererPrivate *priv = gsk_renderer_get_instance_private (renderer);
+
+  g_return_if_fail (GSK_IS_RENDERER (renderer));
+  g_return_if_fail (priv->is_realized);
+  g_return_if_fail (GSK_IS_RENDER_NODE (root));
+  g_return_if_fail (priv->root_node == NULL);
+  g_return_if_fail (damage != NULL);
+
+  gsk_renderer_render_internal (renderer, root, damage, TRUE);
+}
+
+/**
+ * gsk_renderer_get_statistics:
+ * @renderer: a #GskRenderer
+ *
+ * Retrieves statistics about the last frame that @renderer drew with
+ * gsk_renderer_render() or gsk_renderer_render_texture().
+ *
+ * The statistics are returned as a dictionary of type `a{sx}`, mapping
+ * the names of counters and timers to their values. The following
+ * names are provided by all renderers:
+ *
+ * - `frames`: the number of frames drawn since the renderer was created
+ * - `draw-calls`: the number of draw calls submitted to the GPU
+ * - `offscreens`: the number of nodes drawn to an offscreen first
+ * - `upload-bytes`: the number of bytes of pixel data uploaded to the GPU
+ * - `fallback-nodes`: the number of nodes drawn with cairo on the CPU
+ *   instead of natively by the renderer
+ * - `culled-nodes`: the number of nodes skipped, together with their
+ *   children, because they were entirely outside of the clip
+ * - `glyph-cache-hits`, `glyph-cache-misses`: the number of glyph
+ *   lookups that found, or did not find, the glyph in the cache
+ * - `cpu-time`: the time spent drawing the frame, in nanoseconds
+ * - `gpu-time`: the time the GPU spent on drawing, in nanoseconds,
+ *   if the renderer can measure it. This may refer to an earlier frame,
+ *   as the GPU finishes its work after the frame has been submitted.
+ *
+ * Renderers may provide further values. Counters a renderer does
+ * not use are 0.
+ *
+ * Returns: (transfer full): a new #GVariant with the statistics
+ */
+GVariant *
+gsk_renderer_get_statistics (GskRenderer *renderer)
+{
+  GskRendererPrivate *priv = gsk_renderer_get_instance_private (renderer);
+  GVariantBuilder builder;
+
+  g_return_val_if_fail (GSK_IS_RENDERER (renderer), NULL);
+
+  g_variant_builder_init (&builder, G_VARIANT_TYPE ("a{sx}"));
+  gsk_profiler_append_values (priv->profiler, &builder);
+
+  return g_variant_builder_end (&builder);
 }
 
 /*< private >
@@ -64,6 +64,9 @@ void                    gsk_renderer_render                     (GskRenderer
                                                                  GskRenderNode           *root,
                                                                  const cairo_region_t    *region);
 
+GDK_AVAILABLE_IN_ALL
+GVariant *              gsk_renderer_get_statistics             (GskRenderer             *renderer);
+
 G_END_DECLS
 
 #endif /* __GSK_RENDERER_H__ */
@@ -55,6 +55,10 @@ gboolean                gsk_renderer_is_realized                (GskRenderer
 
 GskRenderNode *         gsk_renderer_get_root_node              (GskRenderer    *renderer);
 
+void                    gsk_renderer_render_damage              (GskRenderer          *renderer,
+                                                                 GskRenderNode        *root,
+                                                                 const cairo_region_t *damage);
+
 GskProfiler *           gsk_renderer_get_profiler               (GskRenderer    *renderer);
 
 GskDebugFlags           gsk_renderer_get_debug_flags            (GskRenderer    *renderer);
@@ -43,6 +43,8 @@
 #include "gskdebugprivate.h"
 #include "gskrendererprivate.h"
 
+#include "gdk/gdkcachesprivate.h"
+
 #include <graphene-gobject.h>
 
 #include <math.h>
@@ -61,11 +63,25 @@ G_DEFINE_BOXED_TYPE (GskRenderNode, gsk_render_node,
 
 G_DEFINE_QUARK (gsk-serialization-error-quark, gsk_serialization_error)
 
+/* Bytes of all live nodes, not counting what they reference */
+static gsize live_bytes;
+
+static void
+render_nodes_get_size (gpointer  data,
+                       gsize    *cpu_bytes,
+                       gsize    *gpu_bytes)
+{
+  *cpu_bytes = (gsize) g_atomic_pointer_get (&live_bytes);
+  *gpu_bytes = 0;
+}
+
 static void
 gsk_render_node_finalize (GskRenderNode *self)
 {
   self->node_class->finalize (self);
 
+  g_atomic_pointer_add (&live_bytes, - (gssize) self->alloc_size);
+
   g_free (self);
 }
 
@@ -78,14 +94,24 @@ gsk_render_node_finalize (GskRenderNode *self)
 GskRenderNode *
 gsk_render_node_new (const GskRenderNodeClass *node_class, gsize extra_size)
 {
+  static gsize registered = 0;
   GskRenderNode *self;
 
   g_return_val_if_fail (node_class != NULL, NULL);
   g_return_val_if_fail (node_class->node_type != GSK_NOT_A_RENDER_NODE, NULL);
 
+  /* Nodes can't be trimmed, they are only accounted for */
+  if (g_once_init_enter (&registered))
+    g_once_init_leave (&registered,
+                       GPOINTER_TO_SIZE (gdk_cache_register ("render-nodes", 0,
+                                                             render_nodes_get_size,
+                                                             NULL, NULL)));
+
   self = g_malloc0 (node_class->struct_size + extra_size);
 
   self->node_class = node_class;
+  self->alloc_size = node_class->struct_size + extra_size;
+  g_atomic_pointer_add (&live_bytes, self->alloc_size);
 
   self->ref_count = 1;
 
@@ -162,6 +188,24 @@ gsk_render_node_get_bounds (GskRenderNode   *node,
   graphene_rect_init_from_rect (bounds, &node->bounds);
 }
 
+/*< private >
+ * gsk_render_node_set_cache_hint:
+ * @node: a #GskRenderNode
+ * @cache_hint: whether @node is worth caching
+ *
+ * Tells renderers that @node is likely to be drawn unchanged for many
+ * frames, so it is worth keeping its rendering around as a texture
+ * and drawing that instead of the whole subtree.
+ */
+void
+gsk_render_node_set_cache_hint (GskRenderNode *node,
+                                gboolean       cache_hint)
+{
+  g_return_if_fail (GSK_IS_RENDER_NODE (node));
+
+  node->cache_hint = cache_hint != FALSE;
+}
+
 /**
  * gsk_render_node_draw:
  * @node: a #GskRenderNode
@@ -300,12 +344,244 @@ gsk_render_node_diff (GskRenderNode  *node1,
   if (node1 == node2)
     return;
 
+  /* The hash covers the type and bounds, too */
+  if (node1->hash != 0 && node1->hash == node2->hash)
+    return;
+
   if (gsk_render_node_get_node_type (node1) != gsk_render_node_get_node_type (node2))
     return gsk_render_node_diff_impossible (node1, node2, region);
 
   return node1->node_class->diff (node1, node2, region);
 }
 
+static GskRenderNode *
+gsk_render_node_replace_nodes_recurse (GskRenderNode *node,
+                                       GHashTable    *replacements,
+                                       guint         *n_replaced);
+
+static GskRenderNode *
+gsk_render_node_replace_nodes_in_child (GskRenderNode *child,
+                                        GHashTable    *replacements,
+                                        guint         *n_replaced,
+                                        gboolean      *changed)
+{
+  GskRenderNode *result;
+
+  result = gsk_render_node_replace_nodes_recurse (child, replacements, n_replaced);
+  if (result != child)
+    *changed = TRUE;
+
+  return result;
+}
+
+static GskRenderNode *
+gsk_render_node_replace_nodes_recurse (GskRenderNode *node,
+                                       GHashTable    *replacements,
+                                       guint         *n_replaced)
+{
+  GskRenderNode *result, *child, *child2;
+  gpointer replacement;
+  gboolean changed = FALSE;
+
+  if (g_hash_table_lookup_extended (replacements, node, NULL, &replacement))
+    {
+      if (replacement != node)
+        (*n_replaced)++;
+
+      return gsk_render_node_ref (replacement);
+    }
+
+  switch (gsk_render_node_get_node_type (node))
+    {
+    case GSK_CONTAINER_NODE:
+      {
+        guint i, n_children = gsk_container_node_get_n_children (node);
+        GskRenderNode **children = g_new (GskRenderNode *, n_children);
+
+        for (i = 0; i < n_children; i++)
+          children[i] = gsk_render_node_replace_nodes_in_child (gsk_container_node_get_child (node, i),
+                                                                replacements, n_replaced, &changed);
+
+        if (changed)
+          result = gsk_container_node_new (children, n_children);
+        else
+          result = gsk_render_node_ref (node);
+
+        for (i = 0; i < n_children; i++)
+          gsk_render_node_unref (children[i]);
+        g_free (children);
+      }
+      break;
+
+    case GSK_TRANSFORM_NODE:
+      child = gsk_render_node_replace_nodes_in_child (gsk_transform_node_get_child (node),
+                                                      replacements, n_replaced, &changed);
+      result = changed ? gsk_transform_node_new (child, gsk_transform_node_peek_transform (node))
+                       : gsk_render_node_ref (node);
+      gsk_render_node_unref (child);
+      break;
+
+    case GSK_OFFSET_NODE:
+      child = gsk_render_node_replace_nodes_in_child (gsk_offset_node_get_child (node),
+                                                      replacements, n_replaced, &changed);
+      result = changed ? gsk_offset_node_new (child,
+                                              gsk_offset_node_get_x_offset (node),
+                                              gsk_offset_node_get_y_offset (node))
+                       : gsk_render_node_ref (node);
+      gsk_render_node_unref (child);
+      break;
+
+    case GSK_OPACITY_NODE:
+      child = gsk_render_node_replace_nodes_in_child (gsk_opacity_node_get_child (node),
+                                                      replacements, n_replaced, &changed);
+      result = changed ? gsk_opacity_node_new (child, gsk_opacity_node_get_opacity (node))
+                       : gsk_render_node_ref (node);
+      gsk_render_node_unref (child);
+      break;
+
+    case GSK_COLOR_MATRIX_NODE:
+      child = gsk_render_node_replace_nodes_in_child (gsk_color_matrix_node_get_child (node),
+                                                      replacements, n_replaced, &changed);
+      result = changed ? gsk_color_matrix_node_new (child,
+                                                    gsk_color_matrix_node_peek_color_matrix (node),
+                                                    gsk_color_matrix_node_peek_color_offset (node))
+                       : gsk_render_node_ref (node);
+      gsk_render_node_unref (child);
+      break;
+
+    case GSK_REPEAT_NODE:
+      child = gsk_render_node_replace_nodes_in_child (gsk_repeat_node_get_child (node),
+                                                      replacements, n_replaced, &changed);
+      result = changed ? gsk_repeat_node_new (&node->bounds,
+                                              child,
+                                              gsk_repeat_node_peek_child_bounds (node))
+                       : gsk_render_node_ref (node);
+      gsk_render_node_unref (child);
+      break;
+
+    case GSK_CLIP_NODE:
+      child = gsk_render_node_replace_nodes_in_child (gsk_clip_node_get_child (node),
+                                                      replacements, n_replaced, &changed);
+      result = changed ? gsk_clip_node_new (child, gsk_clip_node_peek_clip (node))
+                       : gsk_render_node_ref (node);
+      gsk_render_node_unref (child);
+      break;
+
+    case GSK_ROUNDED_CLIP_NODE:
+      child = gsk_render_node_replace_nodes_in_child (gsk_rounded_clip_node_get_child (node),
+                                                      replacements, n_replaced, &changed);
+      result = changed ? gsk_rounded_clip_node_new (child, gsk_rounded_clip_node_peek_clip (node))
+                       : gsk_render_node_ref (node);
+      gsk_render_node_unref (child);
+      break;
+
+    case GSK_SHADOW_NODE:
+      child = gsk_render_node_replace_nodes_in_child (gsk_shadow_node_get_child (node),
+                                                      replacements, n_replaced, &changed);
+      if (changed)
+        {
+          gsize i, n_shadows = gsk_shadow_node_get_n_shadows (node);
+          GskShadow *shadows = g_new (GskShadow, n_shadows);
+
+          for (i = 0; i < n_shadows; i++)
+            shadows[i] = *gsk_shadow_node_peek_shadow (node, i);
+
+          result = gsk_shadow_node_new (child, shadows, n_shadows);
+          g_free (shadows);
+        }
+      else
+        result = gsk_render_node_ref (node);
+      gsk_render_node_unref (child);
+      break;
+
+    case GSK_BLUR_NODE:
+      child = gsk_render_node_replace_nodes_in_child (gsk_blur_node_get_child (node),
+                                                      replacements, n_replaced, &changed);
+      result = changed ? gsk_blur_node_new (child, gsk_blur_node_get_radius (node))
+                       : gsk_render_node_ref (node);
+      gsk_render_node_unref (child);
+      break;
+
+    case GSK_DEBUG_NODE:
+      child = gsk_render_node_replace_nodes_in_child (gsk_debug_node_get_child (node),
+                                                      replacements, n_replaced, &changed);
+      result = changed ? gsk_debug_node_new (child, g_strdup (gsk_debug_node_get_message (node)))
+                       : gsk_render_node_ref (node);
+      gsk_render_node_unref (child);
+      break;
+
+    case GSK_BLEND_NODE:
+      child = gsk_render_node_replace_nodes_in_child (gsk_blend_node_get_bottom_child (node),
+                                                      replacements, n_replaced, &changed);
+      child2 = gsk_render_node_replace_nodes_in_child (gsk_blend_node_get_top_child (node),
+                                                       replacements, n_replaced, &changed);
+      result = changed ? gsk_blend_node_new (child, child2, gsk_blend_node_get_blend_mode (node))
+                       : gsk_render_node_ref (node);
+      gsk_render_node_unref (child);
+      gsk_render_node_unref (child2);
+      break;
+
+    case GSK_CROSS_FADE_NODE:
+      child = gsk_render_node_replace_nodes_in_child (gsk_cross_fade_node_get_start_child (node),
+                                                      replacements, n_replaced, &changed);
+      child2 = gsk_render_node_replace_nodes_in_child (gsk_cross_fade_node_get_end_child (node),
+                                                       replacements, n_replaced, &changed);
+      result = changed ? gsk_cross_fade_node_new (child, child2, gsk_cross_fade_node_get_progress (node))
+                       : gsk_render_node_ref (node);
+      gsk_render_node_unref (child);
+      gsk_render_node_unref (child2);
+      break;
+
+    case GSK_NOT_A_RENDER_NODE:
+    case GSK_CAIRO_NODE:
+    case GSK_COLOR_NODE:
+    case GSK_LINEAR_GRADIENT_NODE:
+    case GSK_REPEATING_LINEAR_GRADIENT_NODE:
+    case GSK_BORDER_NODE:
+    case GSK_TEXTURE_NODE:
+    case GSK_INSET_SHADOW_NODE:
+    case GSK_OUTSET_SHADOW_NODE:
+    case GSK_TEXT_NODE:
+    default:
+      result = gsk_render_node_ref (node);
+      break;
+    }
+
+  if (result != node)
+    result->cache_hint = node->cache_hint;
+
+  return result;
+}
+
+/*< private >
+ * gsk_render_node_replace_nodes:
+ * @node: a #GskRenderNode
+ * @replacements: a hash table mapping nodes to the nodes that replace them
+ * @n_replaced: (out): return location for the number of nodes that were
+ *     replaced with a different node
+ *
+ * Creates a copy of @node in which every node that is a key in
+ * @replacements is swapped for its value. Only the nodes on the way to
+ * a replaced node are created again, everything else is shared with
+ * @node. Nodes found in @replacements are not descended into, so mapping
+ * a node to itself is a cheap way to skip a subtree.
+ *
+ * Returns: (transfer full): the new node, or a new reference to @node
+ *     if nothing was replaced
+ */
+GskRenderNode *
+gsk_render_node_replace_nodes (GskRenderNode *node,
+                               GHashTable    *replacements,
+                               guint         *n_replaced)
+{
+  g_return_val_if_fail (GSK_IS_RENDER_NODE (node), NULL);
+  g_return_val_if_fail (replacements != NULL, NULL);
+
+  *n_replaced = 0;
+
+  return gsk_render_node_replace_nodes_recurse (node, replacements, n_replaced);
+}
+
 #define GSK_RENDER_NODE_SERIALIZATION_VERSION 0
 #define GSK_RENDER_NODE_SERIALIZATION_ID "GskRenderNode"
 
@@ -323,26 +599,16 @@ gsk_render_node_diff (GskRenderNode  *node1,
  * The intended use of this functions is testing, benchmarking and debugging.
  * The format is not meant as a permanent storage format.
  *
+ * Textures and strings that are used more than once are only stored once.
+ *
  * Returns: a #GBytes representing the node.
  **/
 GBytes *
 gsk_render_node_serialize (GskRenderNode *node)
 {
-  GVariant *node_variant, *variant;
-  GBytes *result;
-
-  node_variant = gsk_render_node_serialize_node (node);
-
-  variant = g_variant_new ("(suuv)",
-                           GSK_RENDER_NODE_SERIALIZATION_ID,
-                           (guint32) GSK_RENDER_NODE_SERIALIZATION_VERSION,
-                           (guint32) gsk_render_node_get_node_type (node),
-                           node_variant);
-
-  result = g_variant_get_data_as_bytes (variant);
-  g_variant_unref (variant);
+  g_return_val_if_fail (GSK_IS_RENDER_NODE (node), NULL);
 
-  return result;
+  return gsk_render_node_serialize_binary (node);
 }
 
 /**
@@ -390,6 +656,10 @@ gsk_render_node_write_to_file (GskRenderNode *node,
  * Loads data previously created via gsk_render_node_serialize(). For a
  * discussion of the supported format, see that function.
  *
+ * The pixel data of textures is not copied, it keeps referencing @bytes.
+ * Passing the bytes of a #GMappedFile avoids reading images into memory
+ * until they are used.
+ *
  * Returns: (nullable) (transfer full): a new #GskRenderNode or %NULL on
  *     error.
  **/
@@ -402,6 +672,9 @@ gsk_render_node_deserialize (GBytes  *bytes,
   GVariant *variant, *node_variant;
   GskRenderNode *node = NULL;
 
+  if (gsk_render_node_is_binary (bytes))
+    return gsk_render_node_deserialize_binary (bytes, error);
+
   variant = g_variant_new_from_bytes (G_VARIANT_TYPE ("(suuv)"), bytes, FALSE);
 
   g_variant_get (variant, "(suuv)", &id_string, &version, &node_type, &node_variant);
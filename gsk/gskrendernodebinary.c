@@ -0,0 +1,1465 @@
+/* GSK - The GTK Scene Kit
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/* The compact binary serialization format for render nodes.
+ *
+ * The data starts with a 16 byte header: the magic "GSKN", followed by
+ * the format version, the size of the node stream and a reserved word,
+ * all as little-endian 32bit integers. The node stream follows the
+ * header. After it, aligned to BLOB_ALIGNMENT, comes the blob section
+ * holding the pixel data of all textures and cairo surfaces.
+ *
+ * The node stream is a preorder walk of the tree. Every node starts
+ * with its type, followed by its properties and its children.
+ * Integers are LEB128 varints, with signed ones zigzag-encoded.
+ * Geometry is stored as fixed point with 6 fractional bits when that
+ * is exact, which makes most coordinates one or two bytes, and as a
+ * raw double otherwise. Colors whose channels are all multiples of
+ * 1/255 take 5 bytes.
+ *
+ * Strings and textures are written in full on first use only; later
+ * uses refer to them by index. The pixel data of the blob section is
+ * handed out to the deserialized textures without copying, so loading
+ * a mapped file never touches the pixels.
+ */
+
+#include "config.h"
+
+#include "gskrendernodeprivate.h"
+
+#include "gskroundedrectprivate.h"
+
+#include <pango/pangocairo.h>
+#include <string.h>
+
+#define BINARY_MAGIC "GSKN"
+#define BINARY_VERSION 1
+#define HEADER_SIZE 16
+#define BLOB_ALIGNMENT 16
+
+#define ALIGN_BLOB(offset) (((offset) + BLOB_ALIGNMENT - 1) & ~(gsize) (BLOB_ALIGNMENT - 1))
+
+/* Fixed point precision used for geometry */
+#define FIXED_SCALE 64.0
+
+/* Sanity limit for the size of stored pixel data */
+#define MAX_IMAGE_SIZE (1 << 20)
+
+typedef struct
+{
+  GByteArray *stream;
+  GByteArray *blobs;
+
+  /* Maps strings and textures to their index + 1 */
+  GHashTable *strings;
+  GHashTable *textures;
+} GskBinaryWriter;
+
+typedef struct
+{
+  GBytes *bytes;
+  const guchar *data;
+  gsize pos;
+  gsize end;
+  gsize blob_start;
+  gsize blob_size;
+
+  GPtrArray *strings;
+  GPtrArray *textures;
+
+  /* Fonts loaded so far, keyed by their interned description */
+  GHashTable *fonts;
+  PangoContext *context;
+
+  GError **error;
+} GskBinaryReader;
+
+static const cairo_user_data_key_t gsk_binary_bytes_key;
+
+static void
+write_uint (GskBinaryWriter *writer,
+            guint64          value)
+{
+  guchar buf[10];
+  guint n = 0;
+
+  do
+    {
+      buf[n] = value & 0x7f;
+      value >>= 7;
+      if (value)
+        buf[n] |= 0x80;
+      n++;
+    }
+  while (value);
+
+  g_byte_array_append (writer->stream, buf, n);
+}
+
+static void
+write_int (GskBinaryWriter *writer,
+           gint64           value)
+{
+  write_uint (writer, ((guint64) value << 1) ^ (guint64) (value >> 63));
+}
+
+static void
+write_double (GskBinaryWriter *writer,
+              double           value)
+{
+  double fixed = value * FIXED_SCALE;
+  guint64 bits;
+
+  /* The lowest bit tells fixed point and raw values apart */
+  if (fixed >= G_MININT32 && fixed <= G_MAXINT32 && fixed == (gint32) fixed)
+    {
+      gint64 i = (gint32) fixed;
+
+      write_uint (writer, (((guint64) i << 1) ^ (guint64) (i >> 63)) << 1);
+      return;
+    }
+
+  write_uint (writer, 1);
+  memcpy (&bits, &value, sizeof (bits));
+  bits = GUINT64_TO_LE (bits);
+  g_byte_array_append (writer->stream, (guchar *) &bits, sizeof (bits));
+}
+
+static gboolean
+is_byte_channel (double value)
+{
+  return value >= 0.0 && value <= 1.0 &&
+         (guint8) (value * 255.0 + 0.5) / 255.0 == value;
+}
+
+static void
+write_color (GskBinaryWriter *writer,
+             const GdkRGBA   *color)
+{
+  if (is_byte_channel (color->red) &&
+      is_byte_channel (color->green) &&
+      is_byte_channel (color->blue) &&
+      is_byte_channel (color->alpha))
+    {
+      guchar bytes[5] = {
+        0,
+        color->red * 255.0 + 0.5,
+        color->green * 255.0 + 0.5,
+        color->blue * 255.0 + 0.5,
+        color->alpha * 255.0 + 0.5,
+      };
+
+      g_byte_array_append (writer->stream, bytes, sizeof (bytes));
+    }
+  else
+    {
+      write_uint (writer, 1);
+      write_double (writer, color->red);
+      write_double (writer, color->green);
+      write_double (writer, color->blue);
+      write_double (writer, color->alpha);
+    }
+}
+
+static void
+write_point (GskBinaryWriter        *writer,
+             const graphene_point_t *point)
+{
+  write_double (writer, point->x);
+  write_double (writer, point->y);
+}
+
+static void
+write_rect (GskBinaryWriter       *writer,
+            const graphene_rect_t *rect)
+{
+  write_double (writer, rect->origin.x);
+  write_double (writer, rect->origin.y);
+  write_double (writer, rect->size.width);
+  write_double (writer, rect->size.height);
+}
+
+static void
+write_rounded_rect (GskBinaryWriter      *writer,
+                    const GskRoundedRect *rect)
+{
+  guint i;
+
+  write_rect (writer, &rect->bounds);
+  for (i = 0; i < 4; i++)
+    {
+      write_double (writer, rect->corner[i].width);
+      write_double (writer, rect->corner[i].height);
+    }
+}
+
+static void
+write_matrix (GskBinaryWriter         *writer,
+              const graphene_matrix_t *matrix)
+{
+  float values[16];
+  guint i;
+
+  graphene_matrix_to_float (matrix, values);
+  for (i = 0; i < 16; i++)
+    write_double (writer, values[i]);
+}
+
+static void
+write_string (GskBinaryWriter *writer,
+              const char      *string)
+{
+  guint idx;
+  gsize len;
+
+  idx = GPOINTER_TO_UINT (g_hash_table_lookup (writer->strings, string));
+  if (idx)
+    {
+      write_uint (writer, idx);
+      return;
+    }
+
+  len = strlen (string);
+  write_uint (writer, 0);
+  write_uint (writer, len);
+  g_byte_array_append (writer->stream, (const guchar *) string, len);
+
+  g_hash_table_insert (writer->strings,
+                       g_strdup (string),
+                       GUINT_TO_POINTER (g_hash_table_size (writer->strings) + 1));
+}
+
+static void
+write_pixels (GskBinaryWriter *writer,
+              const guchar    *data,
+              int              width,
+              int              height,
+              gsize            stride)
+{
+  static const guchar padding[BLOB_ALIGNMENT] = { 0, };
+  gsize offset;
+  int y;
+
+  offset = ALIGN_BLOB (writer->blobs->len);
+  g_byte_array_append (writer->blobs, padding, offset - writer->blobs->len);
+
+  for (y = 0; y < height; y++)
+    g_byte_array_append (writer->blobs, data + y * stride, width * 4);
+
+  write_uint (writer, width);
+  write_uint (writer, height);
+  write_uint (writer, offset);
+}
+
+static void
+write_texture (GskBinaryWriter *writer,
+               GdkTexture      *texture)
+{
+  guint idx;
+  int width, height;
+  guchar *data;
+
+  idx = GPOINTER_TO_UINT (g_hash_table_lookup (writer->textures, texture));
+  if (idx)
+    {
+      write_uint (writer, idx);
+      return;
+    }
+
+  width = gdk_texture_get_width (texture);
+  height = gdk_texture_get_height (texture);
+  data = g_malloc (width * height * 4);
+  gdk_texture_download (texture, data, width * 4);
+
+  write_uint (writer, 0);
+  write_pixels (writer, data, width, height, width * 4);
+
+  g_free (data);
+
+  g_hash_table_insert (writer->textures,
+                       g_object_ref (texture),
+                       GUINT_TO_POINTER (g_hash_table_size (writer->textures) + 1));
+}
+
+static void
+write_cairo_surface (GskBinaryWriter       *writer,
+                     cairo_surface_t       *surface,
+                     const graphene_rect_t *bounds)
+{
+  cairo_surface_t *image;
+
+  if (surface == NULL)
+    {
+      write_uint (writer, 0);
+      return;
+    }
+
+  image = cairo_surface_map_to_image (surface,
+                                      &(cairo_rectangle_int_t) {
+                                          bounds->origin.x, bounds->origin.y,
+                                          bounds->size.width, bounds->size.height
+                                      });
+
+  if (cairo_image_surface_get_width (image) == 0 ||
+      cairo_image_surface_get_height (image) == 0)
+    {
+      write_uint (writer, 0);
+      cairo_surface_unmap_image (surface, image);
+      return;
+    }
+
+  write_uint (writer, 1);
+  write_pixels (writer,
+                cairo_image_surface_get_data (image),
+                cairo_image_surface_get_width (image),
+                cairo_image_surface_get_height (image),
+                cairo_image_surface_get_stride (image));
+
+  cairo_surface_unmap_image (surface, image);
+}
+
+static void write_node (GskBinaryWriter *writer,
+                        GskRenderNode   *node);
+
+static void
+write_color_stops (GskBinaryWriter *writer,
+                   GskRenderNode   *node)
+{
+  const GskColorStop *stops = gsk_linear_gradient_node_peek_color_stops (node);
+  gsize i, n_stops = gsk_linear_gradient_node_get_n_color_stops (node);
+
+  write_uint (writer, n_stops);
+  for (i = 0; i < n_stops; i++)
+    {
+      write_double (writer, stops[i].offset);
+      write_color (writer, &stops[i].color);
+    }
+}
+
+static void
+write_text (GskBinaryWriter *writer,
+            GskRenderNode   *node)
+{
+  PangoFontDescription *desc;
+  const PangoGlyphInfo *glyphs;
+  char *s;
+  guint i, n_glyphs;
+
+  desc = pango_font_describe ((PangoFont *) gsk_text_node_peek_font (node));
+  s = pango_font_description_to_string (desc);
+  write_string (writer, s);
+  g_free (s);
+  pango_font_description_free (desc);
+
+  write_color (writer, gsk_text_node_peek_color (node));
+  write_double (writer, gsk_text_node_get_x (node));
+  write_double (writer, gsk_text_node_get_y (node));
+
+  /* Storing the bounds saves measuring the glyphs again when loading */
+  write_rect (writer, &node->bounds);
+
+  n_glyphs = gsk_text_node_get_num_glyphs (node);
+  glyphs = gsk_text_node_peek_glyphs (node);
+  write_uint (writer, n_glyphs);
+  for (i = 0; i < n_glyphs; i++)
+    {
+      write_uint (writer, ((guint64) glyphs[i].glyph << 1) | glyphs[i].attr.is_cluster_start);
+      write_int (writer, glyphs[i].geometry.width);
+      write_int (writer, glyphs[i].geometry.x_offset);
+      write_int (writer, glyphs[i].geometry.y_offset);
+    }
+}
+
+static void
+write_node (GskBinaryWriter *writer,
+            GskRenderNode   *node)
+{
+  GskRenderNodeType type = gsk_render_node_get_node_type (node);
+  guint i;
+
+  write_uint (writer, type);
+
+  switch (type)
+    {
+    case GSK_CONTAINER_NODE:
+      write_uint (writer, gsk_container_node_get_n_children (node));
+      for (i = 0; i < gsk_container_node_get_n_children (node); i++)
+        write_node (writer, gsk_container_node_get_child (node, i));
+      break;
+
+    case GSK_CAIRO_NODE:
+      write_rect (writer, &node->bounds);
+      write_cairo_surface (writer,
+                           (cairo_surface_t *) gsk_cairo_node_peek_surface (node),
+                           &node->bounds);
+      break;
+
+    case GSK_COLOR_NODE:
+      write_rect (writer, &node->bounds);
+      write_color (writer, gsk_color_node_peek_color (node));
+      break;
+
+    case GSK_LINEAR_GRADIENT_NODE:
+    case GSK_REPEATING_LINEAR_GRADIENT_NODE:
+      write_rect (writer, &node->bounds);
+      write_point (writer, gsk_linear_gradient_node_peek_start (node));
+      write_point (writer, gsk_linear_gradient_node_peek_end (node));
+      write_color_stops (writer, node);
+      break;
+
+    case GSK_BORDER_NODE:
+      write_rounded_rect (writer, gsk_border_node_peek_outline (node));
+      for (i = 0; i < 4; i++)
+        write_double (writer, gsk_border_node_peek_widths (node)[i]);
+      for (i = 0; i < 4; i++)
+        write_color (writer, &gsk_border_node_peek_colors (node)[i]);
+      break;
+
+    case GSK_TEXTURE_NODE:
+      write_rect (writer, &node->bounds);
+      write_texture (writer, gsk_texture_node_get_texture (node));
+      break;
+
+    case GSK_INSET_SHADOW_NODE:
+      write_rounded_rect (writer, gsk_inset_shadow_node_peek_outline (node));
+      write_color (writer, gsk_inset_shadow_node_peek_color (node));
+      write_double (writer, gsk_inset_shadow_node_get_dx (node));
+      write_double (writer, gsk_inset_shadow_node_get_dy (node));
+      write_double (writer, gsk_inset_shadow_node_get_spread (node));
+      write_double (writer, gsk_inset_shadow_node_get_blur_radius (node));
+      break;
+
+    case GSK_OUTSET_SHADOW_NODE:
+      write_rounded_rect (writer, gsk_outset_shadow_node_peek_outline (node));
+      write_color (writer, gsk_outset_shadow_node_peek_color (node));
+      write_double (writer, gsk_outset_shadow_node_get_dx (node));
+      write_double (writer, gsk_outset_shadow_node_get_dy (node));
+      write_double (writer, gsk_outset_shadow_node_get_spread (node));
+      write_double (writer, gsk_outset_shadow_node_get_blur_radius (node));
+      break;
+
+    case GSK_TRANSFORM_NODE:
+      write_matrix (writer, gsk_transform_node_peek_transform (node));
+      write_node (writer, gsk_transform_node_get_child (node));
+      break;
+
+    case GSK_OPACITY_NODE:
+      write_double (writer, gsk_opacity_node_get_opacity (node));
+      write_node (writer, gsk_opacity_node_get_child (node));
+      break;
+
+    case GSK_COLOR_MATRIX_NODE:
+      {
+        float offset[4];
+
+        graphene_vec4_to_float (gsk_color_matrix_node_peek_color_offset (node), offset);
+        write_matrix (writer, gsk_color_matrix_node_peek_color_matrix (node));
+        for (i = 0; i < 4; i++)
+          write_double (writer, offset[i]);
+        write_node (writer, gsk_color_matrix_node_get_child (node));
+      }
+      break;
+
+    case GSK_REPEAT_NODE:
+      write_rect (writer, &node->bounds);
+      write_rect (writer, gsk_repeat_node_peek_child_bounds (node));
+      write_node (writer, gsk_repeat_node_get_child (node));
+      break;
+
+    case GSK_CLIP_NODE:
+      write_rect (writer, gsk_clip_node_peek_clip (node));
+      write_node (writer, gsk_clip_node_get_child (node));
+      break;
+
+    case GSK_ROUNDED_CLIP_NODE:
+      write_rounded_rect (writer, gsk_rounded_clip_node_peek_clip (node));
+      write_node (writer, gsk_rounded_clip_node_get_child (node));
+      break;
+
+    case GSK_SHADOW_NODE:
+      write_uint (writer, gsk_shadow_node_get_n_shadows (node));
+      for (i = 0; i < gsk_shadow_node_get_n_shadows (node); i++)
+        {
+          const GskShadow *shadow = gsk_shadow_node_peek_shadow (node, i);
+
+          write_color (writer, &shadow->color);
+          write_double (writer, shadow->dx);
+          write_double (writer, shadow->dy);
+          write_double (writer, shadow->radius);
+        }
+      write_node (writer, gsk_shadow_node_get_child (node));
+      break;
+
+    case GSK_BLEND_NODE:
+      write_uint (writer, gsk_blend_node_get_blend_mode (node));
+      write_node (writer, gsk_blend_node_get_bottom_child (node));
+      write_node (writer, gsk_blend_node_get_top_child (node));
+      break;
+
+    case GSK_CROSS_FADE_NODE:
+      write_double (writer, gsk_cross_fade_node_get_progress (node));
+      write_node (writer, gsk_cross_fade_node_get_start_child (node));
+      write_node (writer, gsk_cross_fade_node_get_end_child (node));
+      break;
+
+    case GSK_TEXT_NODE:
+      write_text (writer, node);
+      break;
+
+    case GSK_BLUR_NODE:
+      write_double (writer, gsk_blur_node_get_radius (node));
+      write_node (writer, gsk_blur_node_get_child (node));
+      break;
+
+    case GSK_OFFSET_NODE:
+      write_double (writer, gsk_offset_node_get_x_offset (node));
+      write_double (writer, gsk_offset_node_get_y_offset (node));
+      write_node (writer, gsk_offset_node_get_child (node));
+      break;
+
+    case GSK_DEBUG_NODE:
+      {
+        const char *message = gsk_debug_node_get_message (node);
+
+        write_string (writer, message ? message : "");
+      }
+      write_node (writer, gsk_debug_node_get_child (node));
+      break;
+
+    case GSK_NOT_A_RENDER_NODE:
+    default:
+      g_assert_not_reached ();
+    }
+}
+
+GBytes *
+gsk_render_node_serialize_binary (GskRenderNode *node)
+{
+  GskBinaryWriter writer;
+  static const guchar padding[BLOB_ALIGNMENT] = { 0, };
+  guint32 header[4];
+  GByteArray *result;
+
+  writer.stream = g_byte_array_new ();
+  writer.blobs = g_byte_array_new ();
+  writer.strings = g_hash_table_new_full (g_str_hash, g_str_equal, g_free, NULL);
+  writer.textures = g_hash_table_new_full (NULL, NULL, g_object_unref, NULL);
+
+  write_node (&writer, node);
+
+  memcpy (&header[0], BINARY_MAGIC, 4);
+  header[1] = GUINT32_TO_LE (BINARY_VERSION);
+  header[2] = GUINT32_TO_LE (writer.stream->len);
+  header[3] = 0;
+
+  result = g_byte_array_sized_new (HEADER_SIZE + writer.stream->len + BLOB_ALIGNMENT + writer.blobs->len);
+  g_byte_array_append (result, (guchar *) header, HEADER_SIZE);
+  g_byte_array_append (result, writer.stream->data, writer.stream->len);
+  if (writer.blobs->len > 0)
+    {
+      g_byte_array_append (result, padding, ALIGN_BLOB (result->len) - result->len);
+      g_byte_array_append (result, writer.blobs->data, writer.blobs->len);
+    }
+
+  g_byte_array_unref (writer.stream);
+  g_byte_array_unref (writer.blobs);
+  g_hash_table_unref (writer.strings);
+  g_hash_table_unref (writer.textures);
+
+  return g_byte_array_free_to_bytes (result);
+}
+
+static gboolean
+reader_fail (GskBinaryReader *reader)
+{
+  if (reader->error && *reader->error == NULL)
+    g_set_error (reader->error, GSK_SERIALIZATION_ERROR, GSK_SERIALIZATION_INVALID_DATA,
+                 "Corrupt render node data at offset %"G_GSIZE_FORMAT, reader->pos);
+
+  return FALSE;
+}
+
+static gboolean
+read_uint (GskBinaryReader *reader,
+           guint64         *value)
+{
+  guint shift = 0;
+
+  *value = 0;
+
+  while (reader->pos < reader->end && shift < 64)
+    {
+      guchar b = reader->data[reader->pos++];
+
+      *value |= (guint64) (b & 0x7f) << shift;
+      if ((b & 0x80) == 0)
+        return TRUE;
+
+      shift += 7;
+    }
+
+  return reader_fail (reader);
+}
+
+static gboolean
+read_uint32 (GskBinaryReader *reader,
+             guint           *value)
+{
+  guint64 v;
+
+  if (!read_uint (reader, &v) || v > G_MAXUINT32)
+    return reader_fail (reader);
+
+  *value = v;
+  return TRUE;
+}
+
+static gboolean
+read_int (GskBinaryReader *reader,
+          int             *value)
+{
+  guint64 v;
+  gint64 i;
+
+  if (!read_uint (reader, &v))
+    return FALSE;
+
+  i = (gint64) (v >> 1) ^ -(gint64) (v & 1);
+  if (i < G_MININT || i > G_MAXINT)
+    return reader_fail (reader);
+
+  *value = i;
+  return TRUE;
+}
+
+static gboolean
+read_double (GskBinaryReader *reader,
+             double          *value)
+{
+  guint64 v;
+
+  if (!read_uint (reader, &v))
+    return FALSE;
+
+  if (v & 1)
+    {
+      guint64 bits;
+
+      if (v != 1 || reader->end - reader->pos < sizeof (bits))
+        return reader_fail (reader);
+
+      memcpy (&bits, reader->data + reader->pos, sizeof (bits));
+      reader->pos += sizeof (bits);
+      bits = GUINT64_FROM_LE (bits);
+      memcpy (value, &bits, sizeof (bits));
+    }
+  else
+    {
+      v >>= 1;
+      *value = ((gint64) (v >> 1) ^ -(gint64) (v & 1)) / FIXED_SCALE;
+    }
+
+  return TRUE;
+}
+
+static gboolean
+read_float (GskBinaryReader *reader,
+            float           *value)
+{
+  double d;
+
+  if (!read_double (reader, &d))
+    return FALSE;
+
+  *value = d;
+  return TRUE;
+}
+
+static gboolean
+read_color (GskBinaryReader *reader,
+            GdkRGBA         *color)
+{
+  guint64 tag;
+
+  if (!read_uint (reader, &tag))
+    return FALSE;
+
+  if (tag == 0)
+    {
+      const guchar *bytes;
+
+      if (reader->end - reader->pos < 4)
+        return reader_fail (reader);
+
+      bytes = reader->data + reader->pos;
+      reader->pos += 4;
+
+      color->red = bytes[0] / 255.0;
+      color->green = bytes[1] / 255.0;
+      color->blue = bytes[2] / 255.0;
+      color->alpha = bytes[3] / 255.0;
+
+      return TRUE;
+    }
+  else if (tag == 1)
+    {
+      return read_double (reader, &color->red) &&
+             read_double (reader, &color->green) &&
+             read_double (reader, &color->blue) &&
+             read_double (reader, &color->alpha);
+    }
+
+  return reader_fail (reader);
+}
+
+static gboolean
+read_point (GskBinaryReader  *reader,
+            graphene_point_t *point)
+{
+  return read_float (reader, &point->x) &&
+         read_float (reader, &point->y);
+}
+
+static gboolean
+read_rect (GskBinaryReader *reader,
+           graphene_rect_t *rect)
+{
+  return read_float (reader, &rect->origin.x) &&
+         read_float (reader, &rect->origin.y) &&
+         read_float (reader, &rect->size.width) &&
+         read_float (reader, &rect->size.height);
+}
+
+static gboolean
+read_rounded_rect (GskBinaryReader *reader,
+                   GskRoundedRect  *rect)
+{
+  guint i;
+
+  if (!read_rect (reader, &rect->bounds))
+    return FALSE;
+
+  for (i = 0; i < 4; i++)
+    {
+      if (!read_float (reader, &rect->corner[i].width) ||
+          !read_float (reader, &rect->corner[i].height))
+        return FALSE;
+    }
+
+  return TRUE;
+}
+
+static gboolean
+read_matrix (GskBinaryReader   *reader,
+             graphene_matrix_t *matrix)
+{
+  float values[16];
+  guint i;
+
+  for (i = 0; i < 16; i++)
+    {
+      if (!read_float (reader, &values[i]))
+        return FALSE;
+    }
+
+  graphene_matrix_init_from_float (matrix, values);
+
+  return TRUE;
+}
+
+static const char *
+read_string (GskBinaryReader *reader)
+{
+  guint64 idx, len;
+  char *s;
+
+  if (!read_uint (reader, &idx))
+    return NULL;
+
+  if (idx > 0)
+    {
+      if (idx > reader->strings->len)
+        {
+          reader_fail (reader);
+          return NULL;
+        }
+
+      return g_ptr_array_index (reader->strings, idx - 1);
+    }
+
+  if (!read_uint (reader, &len) || len > reader->end - reader->pos)
+    {
+      reader_fail (reader);
+      return NULL;
+    }
+
+  s = g_strndup ((const char *) reader->data + reader->pos, len);
+  reader->pos += len;
+  g_ptr_array_add (reader->strings, s);
+
+  return s;
+}
+
+/* Returns a new reference to the bytes of the blob section holding
+ * a width x height image, checking that they exist */
+static GBytes *
+read_pixels (GskBinaryReader *reader,
+             guint           *width,
+             guint           *height)
+{
+  guint64 offset;
+
+  if (!read_uint32 (reader, width) ||
+      !read_uint32 (reader, height) ||
+      !read_uint (reader, &offset))
+    return NULL;
+
+  if (*width == 0 || *width > MAX_IMAGE_SIZE ||
+      *height == 0 || *height > MAX_IMAGE_SIZE ||
+      offset > reader->blob_size ||
+      (guint64) *width * *height * 4 > reader->blob_size - offset)
+    {
+      reader_fail (reader);
+      return NULL;
+    }
+
+  return g_bytes_new_from_bytes (reader->bytes,
+                                 reader->blob_start + offset,
+                                 (gsize) *width * *height * 4);
+}
+
+static GdkTexture *
+read_texture (GskBinaryReader *reader)
+{
+  GdkTexture *texture;
+  GBytes *pixels;
+  guint64 idx;
+  guint width, height;
+
+  if (!read_uint (reader, &idx))
+    return NULL;
+
+  if (idx > 0)
+    {
+      if (idx > reader->textures->len)
+        {
+          reader_fail (reader);
+          return NULL;
+        }
+
+      return g_ptr_array_index (reader->textures, idx - 1);
+    }
+
+  pixels = read_pixels (reader, &width, &height);
+  if (pixels == NULL)
+    return NULL;
+
+  texture = gdk_memory_texture_new (width, height,
+                                    GDK_MEMORY_DEFAULT,
+                                    pixels,
+                                    width * 4);
+  g_bytes_unref (pixels);
+
+  g_ptr_array_add (reader->textures, texture);
+
+  return texture;
+}
+
+static GskRenderNode *
+read_cairo (GskBinaryReader *reader)
+{
+  GskRenderNode *result;
+  graphene_rect_t bounds;
+  cairo_surface_t *surface;
+  GBytes *pixels;
+  guint64 has_surface;
+  guint width, height;
+
+  if (!read_rect (reader, &bounds) ||
+      !read_uint (reader, &has_surface))
+    return NULL;
+
+  if (has_surface == 0)
+    return gsk_cairo_node_new (&bounds);
+
+  pixels = read_pixels (reader, &width, &height);
+  if (pixels == NULL)
+    return NULL;
+
+  surface = cairo_image_surface_create_for_data ((guchar *) g_bytes_get_data (pixels, NULL),
+                                                 CAIRO_FORMAT_ARGB32,
+                                                 width, height, width * 4);
+  cairo_surface_set_user_data (surface,
+                               &gsk_binary_bytes_key,
+                               pixels,
+                               (cairo_destroy_func_t) g_bytes_unref);
+
+  result = gsk_cairo_node_new_for_surface (&bounds, surface);
+
+  cairo_surface_destroy (surface);
+
+  return result;
+}
+
+static GskRenderNode *
+read_linear_gradient (GskBinaryReader *reader,
+                      gboolean         repeating)
+{
+  GskRenderNode *result;
+  graphene_rect_t bounds;
+  graphene_point_t start, end;
+  GskColorStop *stops;
+  guint64 i, n_stops;
+
+  if (!read_rect (reader, &bounds) ||
+      !read_point (reader, &start) ||
+      !read_point (reader, &end) ||
+      !read_uint (reader, &n_stops))
+    return NULL;
+
+  /* Every stop takes at least 6 bytes */
+  if (n_stops < 2 || n_stops > (reader->end - reader->pos) / 6)
+    {
+      reader_fail (reader);
+      return NULL;
+    }
+
+  stops = g_new (GskColorStop, n_stops);
+  for (i = 0; i < n_stops; i++)
+    {
+      double offset;
+
+      if (!read_double (reader, &offset) ||
+          !read_color (reader, &stops[i].color))
+        {
+          g_free (stops);
+          return NULL;
+        }
+      stops[i].offset = offset;
+    }
+
+  if (repeating)
+    result = gsk_repeating_linear_gradient_node_new (&bounds, &start, &end, stops, n_stops);
+  else
+    result = gsk_linear_gradient_node_new (&bounds, &start, &end, stops, n_stops);
+
+  g_free (stops);
+
+  return result;
+}
+
+static PangoFont *
+read_font (GskBinaryReader *reader)
+{
+  PangoFontDescription *desc;
+  PangoFontMap *fontmap;
+  PangoFont *font;
+  const char *s;
+
+  s = read_string (reader);
+  if (s == NULL)
+    return NULL;
+
+  /* Strings are deduplicated, so the pointer identifies the font */
+  font = g_hash_table_lookup (reader->fonts, s);
+  if (font)
+    return font;
+
+  fontmap = pango_cairo_font_map_get_default ();
+  if (reader->context == NULL)
+    reader->context = pango_font_map_create_context (fontmap);
+
+  desc = pango_font_description_from_string (s);
+  font = pango_font_map_load_font (fontmap, reader->context, desc);
+  pango_font_description_free (desc);
+
+  if (font == NULL)
+    {
+      g_set_error (reader->error, GSK_SERIALIZATION_ERROR, GSK_SERIALIZATION_INVALID_DATA,
+                   "Could not load font \"%s\"", s);
+      return NULL;
+    }
+
+  g_hash_table_insert (reader->fonts, (gpointer) s, font);
+
+  return font;
+}
+
+static GskRenderNode *
+read_text (GskBinaryReader *reader)
+{
+  GskRenderNode *result;
+  PangoGlyphString *glyphs;
+  PangoFont *font;
+  graphene_rect_t bounds;
+  GdkRGBA color;
+  double x, y;
+  guint64 i, n_glyphs;
+
+  font = read_font (reader);
+  if (font == NULL)
+    return NULL;
+
+  if (!read_color (reader, &color) ||
+      !read_double (reader, &x) ||
+      !read_double (reader, &y) ||
+      !read_rect (reader, &bounds) ||
+      !read_uint (reader, &n_glyphs))
+    return NULL;
+
+  /* Every glyph takes at least 4 bytes */
+  if (n_glyphs > (reader->end - reader->pos) / 4)
+    {
+      reader_fail (reader);
+      return NULL;
+    }
+
+  glyphs = pango_glyph_string_new ();
+  pango_glyph_string_set_size (glyphs, n_glyphs);
+  for (i = 0; i < n_glyphs; i++)
+    {
+      PangoGlyphInfo *glyph = &glyphs->glyphs[i];
+      guint64 packed;
+
+      if (!read_uint (reader, &packed) ||
+          packed > G_MAXUINT32 ||
+          !read_int (reader, &glyph->geometry.width) ||
+          !read_int (reader, &glyph->geometry.x_offset) ||
+          !read_int (reader, &glyph->geometry.y_offset))
+        {
+          pango_glyph_string_free (glyphs);
+          reader_fail (reader);
+          return NULL;
+        }
+
+      glyph->glyph = packed >> 1;
+      glyph->attr.is_cluster_start = packed & 1;
+    }
+
+  result = gsk_text_node_new_with_bounds (font, glyphs, &color, x, y, &bounds);
+
+  pango_glyph_string_free (glyphs);
+
+  return result;
+}
+
+static GskRenderNode *read_node (GskBinaryReader *reader);
+
+/* Reads the child of a node taking a single child, for
+ * the properties that precede it have already been read */
+#define READ_CHILD(child) \
+  G_STMT_START { \
+    child = read_node (reader); \
+    if (child == NULL) \
+      return NULL; \
+  } G_STMT_END
+
+static GskRenderNode *
+read_node (GskBinaryReader *reader)
+{
+  GskRenderNode *result = NULL;
+  GskRenderNode *child;
+  guint64 type;
+  guint i;
+
+  if (!read_uint (reader, &type))
+    return NULL;
+
+  switch (type)
+    {
+    case GSK_CONTAINER_NODE:
+      {
+        GskRenderNode **children;
+        guint64 n_children;
+
+        if (!read_uint (reader, &n_children))
+          return NULL;
+
+        /* Every child takes at least 2 bytes */
+        if (n_children > (reader->end - reader->pos) / 2)
+          {
+            reader_fail (reader);
+            return NULL;
+          }
+
+        children = g_new (GskRenderNode *, n_children);
+        for (i = 0; i < n_children; i++)
+          {
+            children[i] = read_node (reader);
+            if (children[i] == NULL)
+              break;
+          }
+
+        if (i == n_children)
+          result = gsk_container_node_new (children, n_children);
+
+        n_children = i;
+        for (i = 0; i < n_children; i++)
+          gsk_render_node_unref (children[i]);
+        g_free (children);
+      }
+      return result;
+
+    case GSK_CAIRO_NODE:
+      return read_cairo (reader);
+
+    case GSK_COLOR_NODE:
+      {
+        graphene_rect_t bounds;
+        GdkRGBA color;
+
+        if (!read_rect (reader, &bounds) ||
+            !read_color (reader, &color))
+          return NULL;
+
+        return gsk_color_node_new (&color, &bounds);
+      }
+
+    case GSK_LINEAR_GRADIENT_NODE:
+    case GSK_REPEATING_LINEAR_GRADIENT_NODE:
+      return read_linear_gradient (reader, type == GSK_REPEATING_LINEAR_GRADIENT_NODE);
+
+    case GSK_BORDER_NODE:
+      {
+        GskRoundedRect outline;
+        float widths[4];
+        GdkRGBA colors[4];
+
+        if (!read_rounded_rect (reader, &outline))
+          return NULL;
+        for (i = 0; i < 4; i++)
+          if (!read_float (reader, &widths[i]))
+            return NULL;
+        for (i = 0; i < 4; i++)
+          if (!read_color (reader, &colors[i]))
+            return NULL;
+
+        return gsk_border_node_new (&outline, widths, colors);
+      }
+
+    case GSK_TEXTURE_NODE:
+      {
+        graphene_rect_t bounds;
+        GdkTexture *texture;
+
+        if (!read_rect (reader, &bounds))
+          return NULL;
+
+        texture = read_texture (reader);
+        if (texture == NULL)
+          return NULL;
+
+        return gsk_texture_node_new (texture, &bounds);
+      }
+
+    case GSK_INSET_SHADOW_NODE:
+    case GSK_OUTSET_SHADOW_NODE:
+      {
+        GskRoundedRect outline;
+        GdkRGBA color;
+        float dx, dy, spread, blur_radius;
+
+        if (!read_rounded_rect (reader, &outline) ||
+            !read_color (reader, &color) ||
+            !read_float (reader, &dx) ||
+            !read_float (reader, &dy) ||
+            !read_float (reader, &spread) ||
+            !read_float (reader, &blur_radius))
+          return NULL;
+
+        if (type == GSK_INSET_SHADOW_NODE)
+          return gsk_inset_shadow_node_new (&outline, &color, dx, dy, spread, blur_radius);
+        else
+          return gsk_outset_shadow_node_new (&outline, &color, dx, dy, spread, blur_radius);
+      }
+
+    case GSK_TRANSFORM_NODE:
+      {
+        graphene_matrix_t transform;
+
+        if (!read_matrix (reader, &transform))
+          return NULL;
+        READ_CHILD (child);
+
+        result = gsk_transform_node_new (child, &transform);
+      }
+      break;
+
+    case GSK_OPACITY_NODE:
+      {
+        double opacity;
+
+        if (!read_double (reader, &opacity))
+          return NULL;
+        READ_CHILD (child);
+
+        result = gsk_opacity_node_new (child, opacity);
+      }
+      break;
+
+    case GSK_COLOR_MATRIX_NODE:
+      {
+        graphene_matrix_t matrix;
+        graphene_vec4_t offset;
+        float values[4];
+
+        if (!read_matrix (reader, &matrix))
+          return NULL;
+        for (i = 0; i < 4; i++)
+          if (!read_float (reader, &values[i]))
+            return NULL;
+        READ_CHILD (child);
+
+        graphene_vec4_init_from_float (&offset, values);
+        result = gsk_color_matrix_node_new (child, &matrix, &offset);
+      }
+      break;
+
+    case GSK_REPEAT_NODE:
+      {
+        graphene_rect_t bounds, child_bounds;
+
+        if (!read_rect (reader, &bounds) ||
+            !read_rect (reader, &child_bounds))
+          return NULL;
+        READ_CHILD (child);
+
+        result = gsk_repeat_node_new (&bounds, child, &child_bounds);
+      }
+      break;
+
+    case GSK_CLIP_NODE:
+      {
+        graphene_rect_t clip;
+
+        if (!read_rect (reader, &clip))
+          return NULL;
+        READ_CHILD (child);
+
+        result = gsk_clip_node_new (child, &clip);
+      }
+      break;
+
+    case GSK_ROUNDED_CLIP_NODE:
+      {
+        GskRoundedRect clip;
+
+        if (!read_rounded_rect (reader, &clip))
+          return NULL;
+        READ_CHILD (child);
+
+        result = gsk_rounded_clip_node_new (child, &clip);
+      }
+      break;
+
+    case GSK_SHADOW_NODE:
+      {
+        GskShadow *shadows;
+        guint64 n_shadows;
+
+        if (!read_uint (reader, &n_shadows))
+          return NULL;
+
+        /* Every shadow takes at least 8 bytes */
+        if (n_shadows == 0 || n_shadows > (reader->end - reader->pos) / 8)
+          {
+            reader_fail (reader);
+            return NULL;
+          }
+
+        shadows = g_new (GskShadow, n_shadows);
+        for (i = 0; i < n_shadows; i++)
+          {
+            if (!read_color (reader, &shadows[i].color) ||
+                !read_float (reader, &shadows[i].dx) ||
+                !read_float (reader, &shadows[i].dy) ||
+                !read_float (reader, &shadows[i].radius))
+              {
+                g_free (shadows);
+                return NULL;
+              }
+          }
+
+        child = read_node (reader);
+        if (child)
+          {
+            result = gsk_shadow_node_new (child, shadows, n_shadows);
+            gsk_render_node_unref (child);
+          }
+
+        g_free (shadows);
+      }
+      return result;
+
+    case GSK_BLEND_NODE:
+      {
+        GskRenderNode *top;
+        guint64 mode;
+
+        if (!read_uint (reader, &mode))
+          return NULL;
+        if (mode > GSK_BLEND_MODE_LUMINOSITY)
+          {
+            reader_fail (reader);
+            return NULL;
+          }
+        READ_CHILD (child);
+
+        top = read_node (reader);
+        if (top)
+          {
+            result = gsk_blend_node_new (child, top, mode);
+            gsk_render_node_unref (top);
+          }
+      }
+      break;
+
+    case GSK_CROSS_FADE_NODE:
+      {
+        GskRenderNode *end;
+        double progress;
+
+        if (!read_double (reader, &progress))
+          return NULL;
+        READ_CHILD (child);
+
+        end = read_node (reader);
+        if (end)
+          {
+            result = gsk_cross_fade_node_new (child, end, progress);
+            gsk_render_node_unref (end);
+          }
+      }
+      break;
+
+    case GSK_TEXT_NODE:
+      return read_text (reader);
+
+    case GSK_BLUR_NODE:
+      {
+        double radius;
+
+        if (!read_double (reader, &radius))
+          return NULL;
+        READ_CHILD (child);
+
+        result = gsk_blur_node_new (child, radius);
+      }
+      break;
+
+    case GSK_OFFSET_NODE:
+      {
+        float dx, dy;
+
+        if (!read_float (reader, &dx) ||
+            !read_float (reader, &dy))
+          return NULL;
+        READ_CHILD (child);
+
+        result = gsk_offset_node_new (child, dx, dy);
+      }
+      break;
+
+    case GSK_DEBUG_NODE:
+      {
+        const char *message;
+
+        message = read_string (reader);
+        if (message == NULL)
+          return NULL;
+        READ_CHILD (child);
+
+        result = gsk_debug_node_new (child, g_strdup (message));
+      }
+      break;
+
+    case GSK_NOT_A_RENDER_NODE:
+    default:
+      g_set_error (reader->error, GSK_SERIALIZATION_ERROR, GSK_SERIALIZATION_INVALID_DATA,
+                   "Type %u is not a valid render node type", (guint) type);
+      return NULL;
+    }
+
+  gsk_render_node_unref (child);
+
+  return result;
+}
+
+#undef READ_CHILD
+
+gboolean
+gsk_render_node_is_binary (GBytes *bytes)
+{
+  gsize size;
+  const guchar *data = g_bytes_get_data (bytes, &size);
+
+  return size >= HEADER_SIZE && memcmp (data, BINARY_MAGIC, 4) == 0;
+}
+
+GskRenderNode *
+gsk_render_node_deserialize_binary (GBytes  *bytes,
+                                    GError **error)
+{
+  GskBinaryReader reader;
+  GskRenderNode *node;
+  guint32 header[4];
+  gsize size;
+
+  g_return_val_if_fail (gsk_render_node_is_binary (bytes), NULL);
+
+  reader.data = g_bytes_get_data (bytes, &size);
+  memcpy (header, reader.data, HEADER_SIZE);
+
+  if (GUINT32_FROM_LE (header[1]) != BINARY_VERSION)
+    {
+      g_set_error (error, GSK_SERIALIZATION_ERROR, GSK_SERIALIZATION_UNSUPPORTED_VERSION,
+                   "Format version %u not supported.", GUINT32_FROM_LE (header[1]));
+      return NULL;
+    }
+
+  if (GUINT32_FROM_LE (header[2]) > size - HEADER_SIZE)
+    {
+      g_set_error (error, GSK_SERIALIZATION_ERROR, GSK_SERIALIZATION_INVALID_DATA,
+                   "Render node data is truncated.");
+      return NULL;
+    }
+
+  reader.bytes = bytes;
+  reader.pos = HEADER_SIZE;
+  reader.end = HEADER_SIZE + GUINT32_FROM_LE (header[2]);
+  reader.blob_start = MIN (ALIGN_BLOB (reader.end), size);
+  reader.blob_size = size - reader.blob_start;
+  reader.strings = g_ptr_array_new_with_free_func (g_free);
+  reader.textures = g_ptr_array_new_with_free_func (g_object_unref);
+  reader.fonts = g_hash_table_new_full (NULL, NULL, NULL, g_object_unref);
+  reader.context = NULL;
+  reader.error = error;
+
+  node = read_node (&reader);
+
+  if (node && reader.pos != reader.end)
+    {
+      reader_fail (&reader);
+      g_clear_pointer (&node, gsk_render_node_unref);
+    }
+
+  g_ptr_array_unref (reader.strings);
+  g_ptr_array_unref (reader.textures);
+  g_hash_table_unref (reader.fonts);
+  g_clear_object (&reader.context);
+
+  return node;
+}
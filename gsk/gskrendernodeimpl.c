@@ -25,9 +25,15 @@
 #include "gskdiffprivate.h"
 #include "gskrendererprivate.h"
 #include "gskroundedrectprivate.h"
+#include "gskshadowcacheprivate.h"
 
+#include "gdk/gdkcachesprivate.h"
 #include "gdk/gdktextureprivate.h"
 
+#ifdef HAVE_PIXMAN
+#include <pixman.h>
+#endif
+
 static void
 rectangle_init_from_graphene (cairo_rectangle_int_t *cairo,
                               const graphene_rect_t *graphene)
@@ -61,6 +67,399 @@ gsk_render_node_can_diff_true (GskRenderNode *node1,
   return TRUE;
 }
 
+/*** Structural hashes ***/
+
+/* Nodes get a hash of their type, bounds and everything else that
+ * affects their drawing when they are created, with the hashes of their
+ * children standing in for the children. Nodes are immutable, so diffing
+ * can stop at two nodes with the same hash instead of walking both
+ * subtrees, which is the common case for widgets that were snapshotted
+ * again without changing.
+ *
+ * Textures and fonts are hashed by address, the nodes keep them alive
+ * while they are compared. A hash of 0 means unknown, it is used for
+ * Cairo nodes, which are drawn to after they are created, and spreads
+ * to their parents.
+ */
+#define GSK_HASH_INIT G_GUINT64_CONSTANT (14695981039346656037)
+#define GSK_HASH_PRIME G_GUINT64_CONSTANT (1099511628211)
+
+static void
+gsk_render_node_hash_data (GskRenderNode *node,
+                           gconstpointer  data,
+                           gsize          size)
+{
+  const guchar *bytes = data;
+  guint64 hash = node->hash;
+  gsize i;
+
+  if (hash == 0)
+    return;
+
+  /* FNV-1a */
+  for (i = 0; i < size; i++)
+    {
+      hash ^= bytes[i];
+      hash *= GSK_HASH_PRIME;
+    }
+
+  node->hash = hash;
+}
+
+/* Call once the bounds are known */
+static void
+gsk_render_node_hash_begin (GskRenderNode *node)
+{
+  GskRenderNodeType type = node->node_class->node_type;
+
+  node->hash = GSK_HASH_INIT;
+  gsk_render_node_hash_data (node, &type, sizeof (GskRenderNodeType));
+  gsk_render_node_hash_data (node, &node->bounds, sizeof (graphene_rect_t));
+}
+
+static void
+gsk_render_node_hash_child (GskRenderNode *node,
+                            GskRenderNode *child)
+{
+  if (child->hash == 0)
+    node->hash = 0;
+  else
+    gsk_render_node_hash_data (node, &child->hash, sizeof (guint64));
+}
+
+/*** Interned nodes ***/
+
+/* Widgets create the same small leaf nodes, like their backgrounds,
+ * borders and shadows, every time they are snapshotted. Constructors
+ * of those fill in a zeroed node on the stack and look it up here by
+ * its hash, so repeated primitives share one node, saving allocations
+ * and letting renderers find data they cache per node by pointer.
+ *
+ * The table is direct-mapped: a new node replaces the one in its slot,
+ * so at most N_INTERNED_NODES nodes are kept alive. Only the part of
+ * the node after its refcount and cache hint is compared and copied.
+ */
+#define N_INTERNED_NODES 256
+
+G_LOCK_DEFINE_STATIC (interned_nodes);
+static GskRenderNode *interned_nodes[N_INTERNED_NODES];
+
+static GskRenderNode *
+gsk_render_node_new_from_template (const GskRenderNode *template)
+{
+  gsize offset = G_STRUCT_OFFSET (GskRenderNode, hash);
+  GskRenderNode *node;
+
+  node = gsk_render_node_new (template->node_class, 0);
+  memcpy ((guchar *) node + offset,
+          (const guchar *) template + offset,
+          template->node_class->struct_size - offset);
+
+  return node;
+}
+
+static GskRenderNode *
+gsk_render_node_intern (const GskRenderNode *template)
+{
+  gsize offset = G_STRUCT_OFFSET (GskRenderNode, hash);
+  GskRenderNode **slot;
+  GskRenderNode *node;
+
+  if (GSK_DEBUG_CHECK (NO_INTERN) || template->hash == 0)
+    return gsk_render_node_new_from_template (template);
+
+  G_LOCK (interned_nodes);
+
+  slot = &interned_nodes[template->hash % N_INTERNED_NODES];
+  if (*slot == NULL ||
+      (*slot)->node_class != template->node_class ||
+      memcmp ((guchar *) *slot + offset,
+              (const guchar *) template + offset,
+              template->node_class->struct_size - offset) != 0)
+    {
+      g_clear_pointer (slot, gsk_render_node_unref);
+      *slot = gsk_render_node_new_from_template (template);
+    }
+
+  node = gsk_render_node_ref (*slot);
+
+  G_UNLOCK (interned_nodes);
+
+  return node;
+}
+
+/*** Cached renderings ***/
+
+/* Blurring is the most expensive part of drawing with Cairo, and it is
+ * redone every frame for nodes that did not change. So blur and shadow
+ * nodes keep their last rendering, covering all of their bounds, and
+ * reuse it when they are drawn at the same device scale and subpixel
+ * offset again. Nodes are immutable, so nothing else needs to match.
+ * The Cairo renderer draws tiles from several threads, hence the lock.
+ */
+#define MAX_CACHED_RENDERING_PIXELS (1024 * 1024)
+
+typedef struct
+{
+  cairo_surface_t *surface;
+  double x_scale, y_scale;
+  /* subpixel position of the node's origin in the surface */
+  double x_offset, y_offset;
+} GskCachedRendering;
+
+G_LOCK_DEFINE_STATIC (cached_renderings);
+
+static void
+gsk_cached_rendering_clear (GskCachedRendering *cache)
+{
+  g_clear_pointer (&cache->surface, cairo_surface_destroy);
+}
+
+static void
+gsk_render_node_draw_cached (GskRenderNode      *node,
+                             cairo_t            *cr,
+                             GskCachedRendering *cache,
+                             void              (*draw_func) (GskRenderNode *node,
+                                                             cairo_t       *cr))
+{
+  cairo_surface_t *target, *surface;
+  cairo_matrix_t ctm;
+  double device_x_scale, device_y_scale, device_x_offset, device_y_offset;
+  double x_scale, y_scale, x_offset, y_offset, x, y;
+  int width, height;
+
+  cairo_get_matrix (cr, &ctm);
+  if (ctm.xy != 0 || ctm.yx != 0 || ctm.xx <= 0 || ctm.yy <= 0)
+    {
+      draw_func (node, cr);
+      return;
+    }
+
+  target = cairo_get_group_target (cr);
+  cairo_surface_get_device_scale (target, &device_x_scale, &device_y_scale);
+  cairo_surface_get_device_offset (target, &device_x_offset, &device_y_offset);
+
+  x_scale = ctm.xx * device_x_scale;
+  y_scale = ctm.yy * device_y_scale;
+  x = (node->bounds.origin.x * ctm.xx + ctm.x0) * device_x_scale + device_x_offset;
+  y = (node->bounds.origin.y * ctm.yy + ctm.y0) * device_y_scale + device_y_offset;
+  x_offset = x - floor (x);
+  y_offset = y - floor (y);
+
+  width = ceil (x_offset + node->bounds.size.width * x_scale);
+  height = ceil (y_offset + node->bounds.size.height * y_scale);
+  if (width <= 0 || height <= 0 ||
+      (gint64) width * height > MAX_CACHED_RENDERING_PIXELS)
+    {
+      draw_func (node, cr);
+      return;
+    }
+
+  surface = NULL;
+
+  G_LOCK (cached_renderings);
+  if (cache->surface &&
+      cache->x_scale == x_scale && cache->y_scale == y_scale &&
+      cache->x_offset == x_offset && cache->y_offset == y_offset)
+    surface = cairo_surface_reference (cache->surface);
+  G_UNLOCK (cached_renderings);
+
+  if (surface == NULL)
+    {
+      cairo_t *surface_cr;
+
+      surface = cairo_image_surface_create (CAIRO_FORMAT_ARGB32, width, height);
+      cairo_surface_set_device_scale (surface, x_scale, y_scale);
+      cairo_surface_set_device_offset (surface,
+                                       x_offset - node->bounds.origin.x * x_scale,
+                                       y_offset - node->bounds.origin.y * y_scale);
+
+      surface_cr = cairo_create (surface);
+      draw_func (node, surface_cr);
+      cairo_destroy (surface_cr);
+
+      G_LOCK (cached_renderings);
+      g_clear_pointer (&cache->surface, cairo_surface_destroy);
+      cache->surface = cairo_surface_reference (surface);
+      cache->x_scale = x_scale;
+      cache->y_scale = y_scale;
+      cache->x_offset = x_offset;
+      cache->y_offset = y_offset;
+      G_UNLOCK (cached_renderings);
+    }
+
+  /* The device offset already places the surface in user space */
+  cairo_save (cr);
+  cairo_set_source_surface (cr, surface, 0, 0);
+  cairo_paint (cr);
+  cairo_restore (cr);
+
+  cairo_surface_destroy (surface);
+}
+
+/*** Pixman fast paths ***/
+
+#ifdef HAVE_PIXMAN
+
+/* Cairo only knows paths, so even a pixel-aligned rectangle goes through
+ * path construction, clipping and span compositing. When drawing into
+ * an image surface at an integer scale and offset, with a clip made of
+ * pixel-aligned rectangles, color, texture and simple border nodes hand
+ * their boxes to pixman directly instead.
+ */
+typedef struct
+{
+  cairo_surface_t *surface;
+  pixman_image_t *image;
+  int scale;
+  /* the device pixel of the origin of user space */
+  int x_offset, y_offset;
+  /* in device pixels */
+  pixman_region32_t clip;
+} GskPixmanTarget;
+
+static gboolean
+gsk_pixman_target_init (GskPixmanTarget *target,
+                        cairo_t         *cr)
+{
+  cairo_rectangle_list_t *rects;
+  cairo_matrix_t ctm;
+  double x_scale, y_scale, x_offset, y_offset;
+  int i;
+
+  if (cairo_get_operator (cr) != CAIRO_OPERATOR_OVER)
+    return FALSE;
+
+  target->surface = cairo_get_group_target (cr);
+  if (cairo_surface_get_type (target->surface) != CAIRO_SURFACE_TYPE_IMAGE ||
+      cairo_image_surface_get_format (target->surface) != CAIRO_FORMAT_ARGB32)
+    return FALSE;
+
+  cairo_get_matrix (cr, &ctm);
+  cairo_surface_get_device_scale (target->surface, &x_scale, &y_scale);
+  cairo_surface_get_device_offset (target->surface, &x_offset, &y_offset);
+  if (ctm.xx != 1 || ctm.yy != 1 || ctm.xy != 0 || ctm.yx != 0 ||
+      x_scale != y_scale || x_scale < 1 || x_scale != floor (x_scale))
+    return FALSE;
+
+  x_offset += ctm.x0 * x_scale;
+  y_offset += ctm.y0 * y_scale;
+  if (x_offset != floor (x_offset) || y_offset != floor (y_offset))
+    return FALSE;
+
+  /* Without a clip, this fails as well, since that is unbounded */
+  rects = cairo_copy_clip_rectangle_list (cr);
+  if (rects->status != CAIRO_STATUS_SUCCESS)
+    {
+      cairo_rectangle_list_destroy (rects);
+      return FALSE;
+    }
+
+  target->scale = x_scale;
+  target->x_offset = x_offset;
+  target->y_offset = y_offset;
+  pixman_region32_init (&target->clip);
+
+  for (i = 0; i < rects->num_rectangles; i++)
+    {
+      const cairo_rectangle_t *r = &rects->rectangles[i];
+      double x1, y1, x2, y2;
+
+      x1 = r->x * target->scale + target->x_offset;
+      y1 = r->y * target->scale + target->y_offset;
+      x2 = (r->x + r->width) * target->scale + target->x_offset;
+      y2 = (r->y + r->height) * target->scale + target->y_offset;
+      if (x1 != floor (x1) || y1 != floor (y1) ||
+          x2 != floor (x2) || y2 != floor (y2))
+        {
+          pixman_region32_fini (&target->clip);
+          cairo_rectangle_list_destroy (rects);
+          return FALSE;
+        }
+
+      pixman_region32_union_rect (&target->clip, &target->clip, x1, y1, x2 - x1, y2 - y1);
+    }
+
+  cairo_rectangle_list_destroy (rects);
+
+  pixman_region32_intersect_rect (&target->clip, &target->clip,
+                                  0, 0,
+                                  cairo_image_surface_get_width (target->surface),
+                                  cairo_image_surface_get_height (target->surface));
+
+  cairo_surface_flush (target->surface);
+  target->image = pixman_image_create_bits (PIXMAN_a8r8g8b8,
+                                            cairo_image_surface_get_width (target->surface),
+                                            cairo_image_surface_get_height (target->surface),
+                                            (uint32_t *) cairo_image_surface_get_data (target->surface),
+                                            cairo_image_surface_get_stride (target->surface));
+
+  return TRUE;
+}
+
+static void
+gsk_pixman_target_finish (GskPixmanTarget *target,
+                          gboolean         drawn)
+{
+  pixman_image_unref (target->image);
+  pixman_region32_fini (&target->clip);
+
+  if (drawn)
+    cairo_surface_mark_dirty (target->surface);
+}
+
+/* Converts @rect to device pixels, returns %FALSE if it isn't pixel-aligned */
+static gboolean
+gsk_pixman_target_get_box (GskPixmanTarget       *target,
+                           const graphene_rect_t *rect,
+                           pixman_box32_t        *box)
+{
+  double x1, y1, x2, y2;
+
+  x1 = rect->origin.x * target->scale + target->x_offset;
+  y1 = rect->origin.y * target->scale + target->y_offset;
+  x2 = (rect->origin.x + rect->size.width) * target->scale + target->x_offset;
+  y2 = (rect->origin.y + rect->size.height) * target->scale + target->y_offset;
+  if (x1 != floor (x1) || y1 != floor (y1) ||
+      x2 != floor (x2) || y2 != floor (y2))
+    return FALSE;
+
+  box->x1 = x1;
+  box->y1 = y1;
+  box->x2 = x2;
+  box->y2 = y2;
+
+  return TRUE;
+}
+
+/* Fills @region, which gets clipped, with @color */
+static void
+gsk_pixman_target_fill (GskPixmanTarget   *target,
+                        pixman_region32_t *region,
+                        const GdkRGBA     *color)
+{
+  pixman_color_t pixman_color = {
+    color->red * color->alpha * 0xffff,
+    color->green * color->alpha * 0xffff,
+    color->blue * color->alpha * 0xffff,
+    color->alpha * 0xffff
+  };
+  pixman_box32_t *boxes;
+  int n_boxes;
+
+  pixman_region32_intersect (region, region, &target->clip);
+  boxes = pixman_region32_rectangles (region, &n_boxes);
+  if (n_boxes == 0)
+    return;
+
+  pixman_image_fill_boxes (color->alpha >= 1.0 ? PIXMAN_OP_SRC : PIXMAN_OP_OVER,
+                           target->image,
+                           &pixman_color,
+                           n_boxes, boxes);
+}
+
+#endif /* HAVE_PIXMAN */
+
 /*** GSK_COLOR_NODE ***/
 
 typedef struct _GskColorNode GskColorNode;
@@ -82,6 +481,28 @@ gsk_color_node_draw (GskRenderNode *node,
                      cairo_t       *cr)
 {
   GskColorNode *self = (GskColorNode *) node;
+#ifdef HAVE_PIXMAN
+  GskPixmanTarget target;
+
+  if (gsk_pixman_target_init (&target, cr))
+    {
+      pixman_region32_t region;
+      pixman_box32_t box;
+      gboolean drawn;
+
+      drawn = gsk_pixman_target_get_box (&target, &node->bounds, &box);
+      if (drawn)
+        {
+          pixman_region32_init_rects (&region, &box, 1);
+          gsk_pixman_target_fill (&target, &region, &self->color);
+          pixman_region32_fini (&region);
+        }
+
+      gsk_pixman_target_finish (&target, drawn);
+      if (drawn)
+        return;
+    }
+#endif
 
   gdk_cairo_set_source_rgba (cr, &self->color);
 
@@ -171,17 +592,21 @@ GskRenderNode *
 gsk_color_node_new (const GdkRGBA         *rgba,
                     const graphene_rect_t *bounds)
 {
-  GskColorNode *self;
+  GskColorNode template;
 
   g_return_val_if_fail (rgba != NULL, NULL);
   g_return_val_if_fail (bounds != NULL, NULL);
 
-  self = (GskColorNode *) gsk_render_node_new (&GSK_COLOR_NODE_CLASS, 0);
+  memset (&template, 0, sizeof (GskColorNode));
+  template.render_node.node_class = &GSK_COLOR_NODE_CLASS;
 
-  self->color = *rgba;
-  graphene_rect_init_from_rect (&self->render_node.bounds, bounds);
+  template.color = *rgba;
+  graphene_rect_init_from_rect (&template.render_node.bounds, bounds);
 
-  return &self->render_node;
+  gsk_render_node_hash_begin (&template.render_node);
+  gsk_render_node_hash_data (&template.render_node, &template.color, sizeof (GdkRGBA));
+
+  return gsk_render_node_intern (&template.render_node);
 }
 
 /*** GSK_LINEAR_GRADIENT_NODE ***/
@@ -414,6 +839,16 @@ gsk_linear_gradient_node_new (const graphene_rect_t  *bounds,
   memcpy (&self->stops, color_stops, sizeof (GskColorStop) * n_color_stops);
   self->n_stops = n_color_stops;
 
+  gsk_render_node_hash_begin (&self->render_node);
+  gsk_render_node_hash_data (&self->render_node, &self->start, sizeof (graphene_point_t));
+  gsk_render_node_hash_data (&self->render_node, &self->end, sizeof (graphene_point_t));
+  /* Color stops have padding */
+  for (i = 0; i < n_color_stops; i++)
+    {
+      gsk_render_node_hash_data (&self->render_node, &self->stops[i].offset, sizeof (float));
+      gsk_render_node_hash_data (&self->render_node, &self->stops[i].color, sizeof (GdkRGBA));
+    }
+
   return &self->render_node;
 }
 
@@ -460,6 +895,16 @@ gsk_repeating_linear_gradient_node_new (const graphene_rect_t  *bounds,
   memcpy (&self->stops, color_stops, sizeof (GskColorStop) * n_color_stops);
   self->n_stops = n_color_stops;
 
+  gsk_render_node_hash_begin (&self->render_node);
+  gsk_render_node_hash_data (&self->render_node, &self->start, sizeof (graphene_point_t));
+  gsk_render_node_hash_data (&self->render_node, &self->end, sizeof (graphene_point_t));
+  /* Color stops have padding */
+  for (i = 0; i < n_color_stops; i++)
+    {
+      gsk_render_node_hash_data (&self->render_node, &self->stops[i].offset, sizeof (float));
+      gsk_render_node_hash_data (&self->render_node, &self->stops[i].color, sizeof (GdkRGBA));
+    }
+
   return &self->render_node;
 }
 
@@ -520,6 +965,47 @@ gsk_border_node_draw (GskRenderNode *node,
   GskBorderNode *self = (GskBorderNode *) node;
   GskRoundedRect inside;
 
+#ifdef HAVE_PIXMAN
+  if (gsk_rounded_rect_is_rectilinear (&self->outline) &&
+      gdk_rgba_equal (&self->border_color[0], &self->border_color[1]) &&
+      gdk_rgba_equal (&self->border_color[0], &self->border_color[2]) &&
+      gdk_rgba_equal (&self->border_color[0], &self->border_color[3]))
+    {
+      GskPixmanTarget target;
+
+      if (gsk_pixman_target_init (&target, cr))
+        {
+          graphene_rect_t inner;
+          pixman_box32_t outer_box, inner_box;
+          gboolean drawn;
+
+          graphene_rect_init (&inner,
+                              self->outline.bounds.origin.x + self->border_width[3],
+                              self->outline.bounds.origin.y + self->border_width[0],
+                              MAX (0, self->outline.bounds.size.width - self->border_width[1] - self->border_width[3]),
+                              MAX (0, self->outline.bounds.size.height - self->border_width[0] - self->border_width[2]));
+
+          drawn = gsk_pixman_target_get_box (&target, &self->outline.bounds, &outer_box) &&
+                  gsk_pixman_target_get_box (&target, &inner, &inner_box);
+          if (drawn)
+            {
+              pixman_region32_t region, inner_region;
+
+              pixman_region32_init_rects (&region, &outer_box, 1);
+              pixman_region32_init_rects (&inner_region, &inner_box, 1);
+              pixman_region32_subtract (&region, &region, &inner_region);
+              gsk_pixman_target_fill (&target, &region, &self->border_color[0]);
+              pixman_region32_fini (&inner_region);
+              pixman_region32_fini (&region);
+            }
+
+          gsk_pixman_target_finish (&target, drawn);
+          if (drawn)
+            return;
+        }
+    }
+#endif
+
   cairo_save (cr);
 
   gsk_rounded_rect_init_copy (&inside, &self->outline);
@@ -727,21 +1213,27 @@ gsk_border_node_new (const GskRoundedRect     *outline,
                      const float               border_width[4],
                      const GdkRGBA             border_color[4])
 {
-  GskBorderNode *self;
+  GskBorderNode template;
 
   g_return_val_if_fail (outline != NULL, NULL);
   g_return_val_if_fail (border_width != NULL, NULL);
   g_return_val_if_fail (border_color != NULL, NULL);
 
-  self = (GskBorderNode *) gsk_render_node_new (&GSK_BORDER_NODE_CLASS, 0);
+  memset (&template, 0, sizeof (GskBorderNode));
+  template.render_node.node_class = &GSK_BORDER_NODE_CLASS;
 
-  gsk_rounded_rect_init_copy (&self->outline, outline);
-  memcpy (self->border_width, border_width, sizeof (self->border_width));
-  memcpy (self->border_color, border_color, sizeof (self->border_color));
+  gsk_rounded_rect_init_copy (&template.outline, outline);
+  memcpy (template.border_width, border_width, sizeof (template.border_width));
+  memcpy (template.border_color, border_color, sizeof (template.border_color));
 
-  graphene_rect_init_from_rect (&self->render_node.bounds, &self->outline.bounds);
+  graphene_rect_init_from_rect (&template.render_node.bounds, &template.outline.bounds);
 
-  return &self->render_node;
+  gsk_render_node_hash_begin (&template.render_node);
+  gsk_render_node_hash_data (&template.render_node, &template.outline, sizeof (GskRoundedRect));
+  gsk_render_node_hash_data (&template.render_node, template.border_width, sizeof (template.border_width));
+  gsk_render_node_hash_data (&template.render_node, template.border_color, sizeof (template.border_color));
+
+  return gsk_render_node_intern (&template.render_node);
 }
 
 /*** GSK_TEXTURE_NODE ***/
@@ -772,6 +1264,60 @@ gsk_texture_node_draw (GskRenderNode *node,
 
   surface = gdk_texture_download_surface (self->texture);
 
+#ifdef HAVE_PIXMAN
+  if (cairo_surface_get_type (surface) == CAIRO_SURFACE_TYPE_IMAGE &&
+      cairo_image_surface_get_format (surface) == CAIRO_FORMAT_ARGB32)
+    {
+      GskPixmanTarget target;
+
+      if (gsk_pixman_target_init (&target, cr))
+        {
+          pixman_box32_t box;
+          gboolean drawn;
+
+          /* Only unscaled blits */
+          drawn = gsk_pixman_target_get_box (&target, &node->bounds, &box) &&
+                  box.x2 - box.x1 == cairo_image_surface_get_width (surface) &&
+                  box.y2 - box.y1 == cairo_image_surface_get_height (surface);
+          if (drawn)
+            {
+              pixman_image_t *source;
+              pixman_region32_t region;
+              pixman_box32_t *boxes;
+              int i, n_boxes;
+
+              cairo_surface_flush (surface);
+              source = pixman_image_create_bits (PIXMAN_a8r8g8b8,
+                                                 cairo_image_surface_get_width (surface),
+                                                 cairo_image_surface_get_height (surface),
+                                                 (uint32_t *) cairo_image_surface_get_data (surface),
+                                                 cairo_image_surface_get_stride (surface));
+
+              pixman_region32_init_rects (&region, &box, 1);
+              pixman_region32_intersect (&region, &region, &target.clip);
+              boxes = pixman_region32_rectangles (&region, &n_boxes);
+              for (i = 0; i < n_boxes; i++)
+                pixman_image_composite32 (PIXMAN_OP_OVER,
+                                          source, NULL, target.image,
+                                          boxes[i].x1 - box.x1, boxes[i].y1 - box.y1,
+                                          0, 0,
+                                          boxes[i].x1, boxes[i].y1,
+                                          boxes[i].x2 - boxes[i].x1, boxes[i].y2 - boxes[i].y1);
+
+              pixman_region32_fini (&region);
+              pixman_image_unref (source);
+            }
+
+          gsk_pixman_target_finish (&target, drawn);
+          if (drawn)
+            {
+              cairo_surface_destroy (surface);
+              return;
+            }
+        }
+    }
+#endif
+
   cairo_save (cr);
 
   cairo_translate (cr, node->bounds.origin.x, node->bounds.origin.y);
@@ -929,6 +1475,9 @@ gsk_texture_node_new (GdkTexture            *texture,
   self->texture = g_object_ref (texture);
   graphene_rect_init_from_rect (&self->render_node.bounds, bounds);
 
+  gsk_render_node_hash_begin (&self->render_node);
+  gsk_render_node_hash_data (&self->render_node, &self->texture, sizeof (GdkTexture *));
+
   return &self->render_node;
 }
 
@@ -1046,6 +1595,7 @@ draw_shadow_corner (cairo_t               *cr,
   cairo_matrix_t matrix;
   float sx, sy;
   static GHashTable *corner_mask_cache = NULL;
+  G_LOCK_DEFINE_STATIC (corner_mask_cache);
   float max_other;
   CornerMask key;
   gboolean overlapped;
@@ -1133,6 +1683,11 @@ draw_shadow_corner (cairo_t               *cr,
    * mask, so we cache rendered masks based on the blur radius and the
    * corner radius.
    */
+  /* Nodes may be drawn from several threads at once by the Cairo
+   * renderer. Masks are never evicted, so they stay valid after
+   * unlocking. */
+  G_LOCK (corner_mask_cache);
+
   if (corner_mask_cache == NULL)
     corner_mask_cache = g_hash_table_new_full ((GHashFunc)corner_mask_hash,
                                                (GEqualFunc)corner_mask_equal,
@@ -1157,6 +1712,8 @@ draw_shadow_corner (cairo_t               *cr,
       g_hash_table_insert (corner_mask_cache, g_memdup (&key, sizeof (key)), mask);
     }
 
+  G_UNLOCK (corner_mask_cache);
+
   gdk_cairo_set_source_rgba (cr, color);
   pattern = cairo_pattern_create_for_surface (mask);
   cairo_matrix_init_identity (&matrix);
@@ -1438,23 +1995,32 @@ gsk_inset_shadow_node_new (const GskRoundedRect *outline,
                            float                 spread,
                            float                 blur_radius)
 {
-  GskInsetShadowNode *self;
+  GskInsetShadowNode template;
 
   g_return_val_if_fail (outline != NULL, NULL);
   g_return_val_if_fail (color != NULL, NULL);
 
-  self = (GskInsetShadowNode *) gsk_render_node_new (&GSK_INSET_SHADOW_NODE_CLASS, 0);
+  memset (&template, 0, sizeof (GskInsetShadowNode));
+  template.render_node.node_class = &GSK_INSET_SHADOW_NODE_CLASS;
 
-  gsk_rounded_rect_init_copy (&self->outline, outline);
-  self->color = *color;
-  self->dx = dx;
-  self->dy = dy;
-  self->spread = spread;
-  self->blur_radius = blur_radius;
+  gsk_rounded_rect_init_copy (&template.outline, outline);
+  template.color = *color;
+  template.dx = dx;
+  template.dy = dy;
+  template.spread = spread;
+  template.blur_radius = blur_radius;
 
-  graphene_rect_init_from_rect (&self->render_node.bounds, &self->outline.bounds);
+  graphene_rect_init_from_rect (&template.render_node.bounds, &template.outline.bounds);
 
-  return &self->render_node;
+  gsk_render_node_hash_begin (&template.render_node);
+  gsk_render_node_hash_data (&template.render_node, &template.outline, sizeof (GskRoundedRect));
+  gsk_render_node_hash_data (&template.render_node, &template.color, sizeof (GdkRGBA));
+  gsk_render_node_hash_data (&template.render_node, &template.dx, sizeof (float));
+  gsk_render_node_hash_data (&template.render_node, &template.dy, sizeof (float));
+  gsk_render_node_hash_data (&template.render_node, &template.spread, sizeof (float));
+  gsk_render_node_hash_data (&template.render_node, &template.blur_radius, sizeof (float));
+
+  return gsk_render_node_intern (&template.render_node);
 }
 
 const GskRoundedRect *
@@ -1554,6 +2120,123 @@ gsk_outset_shadow_get_extents (GskOutsetShadowNode *self,
   *left = MAX (0, ceil (clip_radius + self->spread - self->dx));
 }
 
+#define MAX_CACHED_SHADOWS 32
+
+/* Shared by all threads drawing with cairo */
+static GskShadowCache shadow_cache;
+G_LOCK_DEFINE_STATIC (shadow_cache);
+
+static void
+free_shadow_surface (gpointer data,
+                     gpointer user_data)
+{
+  cairo_surface_destroy (data);
+}
+
+static void
+shadow_cache_get_size (gpointer  data,
+                       gsize    *cpu_bytes,
+                       gsize    *gpu_bytes)
+{
+  G_LOCK (shadow_cache);
+  *cpu_bytes = shadow_cache.items ? gsk_shadow_cache_get_size (&shadow_cache) : 0;
+  *gpu_bytes = 0;
+  G_UNLOCK (shadow_cache);
+}
+
+static void
+shadow_cache_trim (gpointer data,
+                   gsize    max_bytes)
+{
+  G_LOCK (shadow_cache);
+  if (shadow_cache.items)
+    gsk_shadow_cache_trim_size (&shadow_cache, max_bytes);
+  G_UNLOCK (shadow_cache);
+}
+
+/* Draws the blurred shadow from a cached nine-slice image, so only the
+ * first frame pays for the blur. Returns FALSE if the shadow can't be
+ * drawn that way.
+ */
+static gboolean
+draw_shadow_nine_slice (cairo_t              *cr,
+                        const GskRoundedRect *outline,
+                        const GskRoundedRect *box,
+                        float                 spread,
+                        float                 blur_radius,
+                        const GdkRGBA        *color)
+{
+  static GdkCache *cache;
+  GskShadowNineSlice slice;
+  GskShadowSlice slices[9];
+  GskShadowKey key;
+  cairo_surface_t *surface;
+  graphene_rect_t bounds;
+  double sx, sy;
+  guint i, n;
+
+  gsk_shadow_nine_slice_init (&slice, outline, spread, gsk_cairo_blur_compute_pixels (blur_radius));
+  bounds = box->bounds;
+  graphene_rect_inset (&bounds, - slice.extent, - slice.extent);
+  n = gsk_shadow_nine_slice_get_slices (&slice, &bounds, slices);
+  if (n == 0)
+    return FALSE;
+
+  cairo_surface_get_device_scale (cairo_get_target (cr), &sx, &sy);
+
+  key.outline = slice.outline;
+  key.blur_radius = blur_radius;
+  key.color = *color;
+  key.scale = MAX (sx, sy);
+
+  G_LOCK (shadow_cache);
+
+  if (shadow_cache.items == NULL)
+    {
+      gsk_shadow_cache_init (&shadow_cache, free_shadow_surface, NULL);
+      cache = gdk_cache_register ("shadows", 0, shadow_cache_get_size, shadow_cache_trim, NULL);
+    }
+
+  surface = gsk_shadow_cache_lookup (&shadow_cache, &key);
+  if (surface == NULL)
+    {
+      surface = gsk_shadow_nine_slice_render (&slice, blur_radius, color, key.scale);
+      gsk_shadow_cache_insert (&shadow_cache, &key, surface,
+                               (gsize) cairo_image_surface_get_stride (surface) *
+                               cairo_image_surface_get_height (surface));
+      gsk_shadow_cache_trim (&shadow_cache, MAX_CACHED_SHADOWS);
+      if (gdk_cache_get_budget (cache) > 0)
+        gsk_shadow_cache_trim_size (&shadow_cache, gdk_cache_get_budget (cache));
+    }
+
+  /* Keep the surface alive after other threads trim the cache */
+  cairo_surface_reference (surface);
+
+  G_UNLOCK (shadow_cache);
+
+  for (i = 0; i < n; i++)
+    {
+      const graphene_rect_t *dest = &slices[i].dest;
+      const graphene_rect_t *source = &slices[i].source;
+      cairo_pattern_t *pattern;
+
+      cairo_save (cr);
+      cairo_rectangle (cr, dest->origin.x, dest->origin.y, dest->size.width, dest->size.height);
+      cairo_clip (cr);
+      cairo_translate (cr, dest->origin.x, dest->origin.y);
+      cairo_scale (cr, dest->size.width / source->size.width, dest->size.height / source->size.height);
+      cairo_set_source_surface (cr, surface, - source->origin.x, - source->origin.y);
+      pattern = cairo_get_source (cr);
+      cairo_pattern_set_extend (pattern, CAIRO_EXTEND_PAD);
+      cairo_paint (cr);
+      cairo_restore (cr);
+    }
+
+  cairo_surface_destroy (surface);
+
+  return TRUE;
+}
+
 static void
 gsk_outset_shadow_node_draw (GskRenderNode *node,
                              cairo_t       *cr)
@@ -1594,7 +2277,7 @@ gsk_outset_shadow_node_draw (GskRenderNode *node,
 
   if (!needs_blur (self->blur_radius))
     draw_shadow (cr, FALSE, &box, &clip_box, self->blur_radius, &self->color, GSK_BLUR_NONE);
-  else
+  else if (!draw_shadow_nine_slice (cr, &self->outline, &box, self->spread, self->blur_radius, &self->color))
     {
       int i;
       cairo_region_t *remaining;
@@ -1760,31 +2443,40 @@ gsk_outset_shadow_node_new (const GskRoundedRect *outline,
                             float                 spread,
                             float                 blur_radius)
 {
-  GskOutsetShadowNode *self;
+  GskOutsetShadowNode template;
   float top, right, bottom, left;
 
   g_return_val_if_fail (outline != NULL, NULL);
   g_return_val_if_fail (color != NULL, NULL);
 
-  self = (GskOutsetShadowNode *) gsk_render_node_new (&GSK_OUTSET_SHADOW_NODE_CLASS, 0);
+  memset (&template, 0, sizeof (GskOutsetShadowNode));
+  template.render_node.node_class = &GSK_OUTSET_SHADOW_NODE_CLASS;
 
-  gsk_rounded_rect_init_copy (&self->outline, outline);
-  self->color = *color;
-  self->dx = dx;
-  self->dy = dy;
-  self->spread = spread;
-  self->blur_radius = blur_radius;
+  gsk_rounded_rect_init_copy (&template.outline, outline);
+  template.color = *color;
+  template.dx = dx;
+  template.dy = dy;
+  template.spread = spread;
+  template.blur_radius = blur_radius;
 
-  gsk_outset_shadow_get_extents (self, &top, &right, &bottom, &left);
+  gsk_outset_shadow_get_extents (&template, &top, &right, &bottom, &left);
 
-  graphene_rect_init_from_rect (&self->render_node.bounds, &self->outline.bounds);
+  graphene_rect_init_from_rect (&template.render_node.bounds, &template.outline.bounds);
 
-  self->render_node.bounds.origin.x -= left;
-  self->render_node.bounds.origin.y -= top;
-  self->render_node.bounds.size.width += left + right;
-  self->render_node.bounds.size.height += top + bottom;
+  template.render_node.bounds.origin.x -= left;
+  template.render_node.bounds.origin.y -= top;
+  template.render_node.bounds.size.width += left + right;
+  template.render_node.bounds.size.height += top + bottom;
 
-  return &self->render_node;
+  gsk_render_node_hash_begin (&template.render_node);
+  gsk_render_node_hash_data (&template.render_node, &template.outline, sizeof (GskRoundedRect));
+  gsk_render_node_hash_data (&template.render_node, &template.color, sizeof (GdkRGBA));
+  gsk_render_node_hash_data (&template.render_node, &template.dx, sizeof (float));
+  gsk_render_node_hash_data (&template.render_node, &template.dy, sizeof (float));
+  gsk_render_node_hash_data (&template.render_node, &template.spread, sizeof (float));
+  gsk_render_node_hash_data (&template.render_node, &template.blur_radius, sizeof (float));
+
+  return gsk_render_node_intern (&template.render_node);
 }
 
 const GskRoundedRect *
@@ -2114,15 +2806,111 @@ gsk_cairo_node_get_draw_context (GskRenderNode *node)
 /**** GSK_CONTAINER_NODE ***/
 
 typedef struct _GskContainerNode GskContainerNode;
+typedef struct _GskContainerTree GskContainerTree;
+
+/* Containers with at least MIN_TREE_CHILDREN children get a tree of
+ * bounds on first use, so that looking for the children in an area can
+ * skip groups of TREE_ARITY consecutive children at once, and groups of
+ * TREE_ARITY of those groups, and so on.
+ *
+ * Children are grouped by their order and not by their position, since
+ * they have to be drawn in order. Containers with that many children
+ * are usually lists or grids, where neighbours in the list are close
+ * to each other on screen as well.
+ */
+#define MIN_TREE_CHILDREN 64
+#define TREE_ARITY 16
+
+struct _GskContainerTree
+{
+  guint n_levels;
+  /* levels[0] has the bounds of groups of TREE_ARITY children,
+   * levels[1] those of groups of TREE_ARITY * TREE_ARITY, ... */
+  graphene_rect_t *levels[];
+};
 
 struct _GskContainerNode
 {
   GskRenderNode render_node;
 
+  GskContainerTree *tree; /* built lazily, use gsk_container_node_get_tree() */
+
   guint n_children;
   GskRenderNode *children[];
 };
 
+static GskContainerTree *
+gsk_container_tree_new (GskContainerNode *container)
+{
+  GskContainerTree *tree;
+  graphene_rect_t *rects;
+  guint n_levels, n_rects, n, l, i;
+
+  n_levels = 0;
+  n_rects = 0;
+  for (n = container->n_children; n > TREE_ARITY; n = (n + TREE_ARITY - 1) / TREE_ARITY)
+    {
+      n_levels++;
+      n_rects += (n + TREE_ARITY - 1) / TREE_ARITY;
+    }
+
+  tree = g_malloc (sizeof (GskContainerTree) +
+                   n_levels * sizeof (graphene_rect_t *) +
+                   n_rects * sizeof (graphene_rect_t));
+  tree->n_levels = n_levels;
+  rects = (graphene_rect_t *) &tree->levels[n_levels];
+
+  n = container->n_children;
+  for (l = 0; l < n_levels; l++)
+    {
+      tree->levels[l] = rects;
+
+      for (i = 0; i < n; i++)
+        {
+          const graphene_rect_t *bounds;
+
+          if (l == 0)
+            bounds = &container->children[i]->bounds;
+          else
+            bounds = &tree->levels[l - 1][i];
+
+          if (i % TREE_ARITY == 0)
+            rects[i / TREE_ARITY] = *bounds;
+          else
+            graphene_rect_union (&rects[i / TREE_ARITY], bounds, &rects[i / TREE_ARITY]);
+        }
+
+      n = (n + TREE_ARITY - 1) / TREE_ARITY;
+      rects += n;
+    }
+
+  return tree;
+}
+
+/* Returns %NULL for containers that are too small to be worth it */
+static const GskContainerTree *
+gsk_container_node_get_tree (GskContainerNode *container)
+{
+  GskContainerTree *tree;
+
+  if (container->n_children < MIN_TREE_CHILDREN)
+    return NULL;
+
+  tree = g_atomic_pointer_get (&container->tree);
+  if (tree)
+    return tree;
+
+  /* Nodes may be drawn from several threads, let the first one win */
+  tree = gsk_container_tree_new (container);
+  if (!g_atomic_pointer_compare_and_exchange (&container->tree, NULL, tree))
+    {
+      g_free (tree);
+      tree = g_atomic_pointer_get (&container->tree);
+    }
+
+  return tree;
+}
+
 static void
 gsk_container_node_finalize (GskRenderNode *node)
 {
@@ -2131,6 +2919,8 @@ gsk_container_node_finalize (GskRenderNode *node)
 
   for (i = 0; i < container->n_children; i++)
     gsk_render_node_unref (container->children[i]);
+
+  g_free (container->tree);
 }
 
 static void
@@ -2138,9 +2928,16 @@ gsk_container_node_draw (GskRenderNode *node,
                          cairo_t       *cr)
 {
   GskContainerNode *container = (GskContainerNode *) node;
+  graphene_rect_t clip;
+  double x1, y1, x2, y2;
   guint i;
 
-  for (i = 0; i < container->n_children; i++)
+  cairo_clip_extents (cr, &x1, &y1, &x2, &y2);
+  graphene_rect_init (&clip, x1, y1, x2 - x1, y2 - y1);
+
+  for (i = gsk_container_node_find_child (node, &clip, 0);
+       i < container->n_children;
+       i = gsk_container_node_find_child (node, &clip, i + 1))
     {
       gsk_render_node_draw (container->children[i], cr);
     }
@@ -2335,6 +3132,10 @@ gsk_container_node_new (GskRenderNode **children,
 
   gsk_container_node_get_bounds (container, &container->render_node.bounds);
 
+  gsk_render_node_hash_begin (&container->render_node);
+  for (i = 0; i < container->n_children; i++)
+    gsk_render_node_hash_child (&container->render_node, container->children[i]);
+
   return &container->render_node;
 }
 
@@ -2377,6 +3178,68 @@ gsk_container_node_get_child (GskRenderNode *node,
   return container->children[idx];
 }
 
+/*
+ * gsk_container_node_find_child:
+ * @node: a container #GskRenderNode
+ * @rect: the area to look in
+ * @start: the position of the first child to consider
+ *
+ * Finds the first child of @node, starting from @start, whose bounds
+ * intersect @rect. For containers with many children, this skips
+ * whole groups of children outside of @rect at once.
+ *
+ * Returns: the position of that child, or the number of children of
+ *     @node if there is none
+ */
+guint
+gsk_container_node_find_child (GskRenderNode         *node,
+                               const graphene_rect_t *rect,
+                               guint                  start)
+{
+  GskContainerNode *container = (GskContainerNode *) node;
+  const GskContainerTree *tree;
+  guint i, l, size;
+
+  g_return_val_if_fail (GSK_IS_RENDER_NODE_TYPE (node, GSK_CONTAINER_NODE), 0);
+
+  tree = gsk_container_node_get_tree (container);
+
+  i = start;
+  while (i < container->n_children)
+    {
+      if (tree)
+        {
+          gboolean skipped = FALSE;
+
+          /* Skip the biggest group starting at i that is outside of @rect */
+          for (l = tree->n_levels; l > 0 && !skipped; l--)
+            {
+              guint p;
+
+              for (size = TREE_ARITY, p = 1; p < l; p++)
+                size *= TREE_ARITY;
+
+              if (i % size == 0 &&
+                  !graphene_rect_intersection (&tree->levels[l - 1][i / size], rect, NULL))
+                {
+                  i += size;
+                  skipped = TRUE;
+                }
+            }
+
+          if (skipped)
+            continue;
+        }
+
+      if (graphene_rect_intersection (&container->children[i]->bounds, rect, NULL))
+        return i;
+
+      i++;
+    }
+
+  return container->n_children;
+}
+
 /*** GSK_TRANSFORM_NODE ***/
 
 typedef struct _GskTransformNode GskTransformNode;
@@ -2521,6 +3384,11 @@ gsk_transform_node_new (GskRenderNode           *child,
   graphene_matrix_transform_bounds (&self->transform,
                                     &child->bounds,
                                     &self->render_node.bounds);
+
+  gsk_render_node_hash_begin (&self->render_node);
+  gsk_render_node_hash_data (&self->render_node, &self->transform, sizeof (graphene_matrix_t));
+  gsk_render_node_hash_child (&self->render_node, child);
+
   return &self->render_node;
 }
 
@@ -2711,6 +3579,12 @@ gsk_offset_node_new (GskRenderNode *child,
                           x_offset, y_offset,
                           &self->render_node.bounds);
 
+  /* The bounds don't tell moved children apart from resized ones */
+  gsk_render_node_hash_begin (&self->render_node);
+  gsk_render_node_hash_data (&self->render_node, &self->x_offset, sizeof (float));
+  gsk_render_node_hash_data (&self->render_node, &self->y_offset, sizeof (float));
+  gsk_render_node_hash_child (&self->render_node, child);
+
   return &self->render_node;
 }
 
@@ -2884,6 +3758,10 @@ gsk_debug_node_new (GskRenderNode *child,
 
   graphene_rect_init_from_rect (&self->render_node.bounds, &child->bounds);
 
+  /* The message is not drawn */
+  gsk_render_node_hash_begin (&self->render_node);
+  gsk_render_node_hash_child (&self->render_node, child);
+
   return &self->render_node;
 }
 
@@ -3059,6 +3937,10 @@ gsk_opacity_node_new (GskRenderNode *child,
 
   graphene_rect_init_from_rect (&self->render_node.bounds, &child->bounds);
 
+  gsk_render_node_hash_begin (&self->render_node);
+  gsk_render_node_hash_data (&self->render_node, &self->opacity, sizeof (double));
+  gsk_render_node_hash_child (&self->render_node, child);
+
   return &self->render_node;
 }
 
@@ -3303,6 +4185,11 @@ gsk_color_matrix_node_new (GskRenderNode           *child,
 
   graphene_rect_init_from_rect (&self->render_node.bounds, &child->bounds);
 
+  gsk_render_node_hash_begin (&self->render_node);
+  gsk_render_node_hash_data (&self->render_node, &self->color_matrix, sizeof (graphene_matrix_t));
+  gsk_render_node_hash_data (&self->render_node, &self->color_offset, sizeof (graphene_vec4_t));
+  gsk_render_node_hash_child (&self->render_node, child);
+
   return &self->render_node;
 }
 
@@ -3492,6 +4379,10 @@ gsk_repeat_node_new (const graphene_rect_t *bounds,
   else
     graphene_rect_init_from_rect (&self->child_bounds, &child->bounds);
 
+  gsk_render_node_hash_begin (&self->render_node);
+  gsk_render_node_hash_data (&self->render_node, &self->child_bounds, sizeof (graphene_rect_t));
+  gsk_render_node_hash_child (&self->render_node, child);
+
   return &self->render_node;
 }
 
@@ -3660,6 +4551,10 @@ gsk_clip_node_new (GskRenderNode         *child,
 
   graphene_rect_intersection (&self->clip, &child->bounds, &self->render_node.bounds);
 
+  gsk_render_node_hash_begin (&self->render_node);
+  gsk_render_node_hash_data (&self->render_node, &self->clip, sizeof (graphene_rect_t));
+  gsk_render_node_hash_child (&self->render_node, child);
+
   return &self->render_node;
 }
 
@@ -3849,6 +4744,10 @@ gsk_rounded_clip_node_new (GskRenderNode         *child,
 
   graphene_rect_intersection (&self->clip.bounds, &child->bounds, &self->render_node.bounds);
 
+  gsk_render_node_hash_begin (&self->render_node);
+  gsk_render_node_hash_data (&self->render_node, &self->clip, sizeof (GskRoundedRect));
+  gsk_render_node_hash_child (&self->render_node, child);
+
   return &self->render_node;
 }
 
@@ -3890,6 +4789,8 @@ struct _GskShadowNode
 
   GskRenderNode *child;
 
+  GskCachedRendering rendering;
+
   gsize n_shadows;
   GskShadow shadows[];
 };
@@ -3900,11 +4801,12 @@ gsk_shadow_node_finalize (GskRenderNode *node)
   GskShadowNode *self = (GskShadowNode *) node;
 
   gsk_render_node_unref (self->child);
+  gsk_cached_rendering_clear (&self->rendering);
 }
 
 static void
-gsk_shadow_node_draw (GskRenderNode *node,
-                      cairo_t       *cr)
+gsk_shadow_node_draw_uncached (GskRenderNode *node,
+                               cairo_t       *cr)
 {
   GskShadowNode *self = (GskShadowNode *) node;
   cairo_pattern_t *pattern;
@@ -3939,6 +4841,15 @@ gsk_shadow_node_draw (GskRenderNode *node,
   cairo_pattern_destroy (pattern);
 }
 
+static void
+gsk_shadow_node_draw (GskRenderNode *node,
+                      cairo_t       *cr)
+{
+  GskShadowNode *self = (GskShadowNode *) node;
+
+  gsk_render_node_draw_cached (node, cr, &self->rendering, gsk_shadow_node_draw_uncached);
+}
+
 static void
 gsk_shadow_node_diff (GskRenderNode  *node1,
                       GskRenderNode  *node2,
@@ -4121,6 +5032,7 @@ gsk_shadow_node_new (GskRenderNode         *child,
                      gsize                  n_shadows)
 {
   GskShadowNode *self;
+  gsize i;
 
   g_return_val_if_fail (GSK_IS_RENDER_NODE (child), NULL);
   g_return_val_if_fail (shadows != NULL, NULL);
@@ -4134,6 +5046,17 @@ gsk_shadow_node_new (GskRenderNode         *child,
 
   gsk_shadow_node_get_bounds (self, &self->render_node.bounds);
 
+  gsk_render_node_hash_begin (&self->render_node);
+  /* Shadows have padding */
+  for (i = 0; i < n_shadows; i++)
+    {
+      gsk_render_node_hash_data (&self->render_node, &self->shadows[i].color, sizeof (GdkRGBA));
+      gsk_render_node_hash_data (&self->render_node, &self->shadows[i].dx, sizeof (float));
+      gsk_render_node_hash_data (&self->render_node, &self->shadows[i].dy, sizeof (float));
+      gsk_render_node_hash_data (&self->render_node, &self->shadows[i].radius, sizeof (float));
+    }
+  gsk_render_node_hash_child (&self->render_node, child);
+
   return &self->render_node;
 }
 
@@ -4368,6 +5291,11 @@ gsk_blend_node_new (GskRenderNode *bottom,
 
   graphene_rect_union (&bottom->bounds, &top->bounds, &self->render_node.bounds);
 
+  gsk_render_node_hash_begin (&self->render_node);
+  gsk_render_node_hash_data (&self->render_node, &self->blend_mode, sizeof (GskBlendMode));
+  gsk_render_node_hash_child (&self->render_node, bottom);
+  gsk_render_node_hash_child (&self->render_node, top);
+
   return &self->render_node;
 }
 
@@ -4558,6 +5486,11 @@ gsk_cross_fade_node_new (GskRenderNode *start,
 
   graphene_rect_union (&start->bounds, &end->bounds, &self->render_node.bounds);
 
+  gsk_render_node_hash_begin (&self->render_node);
+  gsk_render_node_hash_data (&self->render_node, &self->progress, sizeof (double));
+  gsk_render_node_hash_child (&self->render_node, start);
+  gsk_render_node_hash_child (&self->render_node, end);
+
   return &self->render_node;
 }
 
@@ -4856,6 +5789,7 @@ gsk_text_node_new_with_bounds (PangoFont             *font,
                                const graphene_rect_t *bounds)
 {
   GskTextNode *self;
+  guint i;
 
   self = (GskTextNode *) gsk_render_node_new (&GSK_TEXT_NODE_CLASS, sizeof (PangoGlyphInfo) * glyphs->num_glyphs);
 
@@ -4868,6 +5802,18 @@ gsk_text_node_new_with_bounds (PangoFont             *font,
 
   graphene_rect_init_from_rect (&self->render_node.bounds, bounds);
 
+  gsk_render_node_hash_begin (&self->render_node);
+  gsk_render_node_hash_data (&self->render_node, &self->font, sizeof (PangoFont *));
+  gsk_render_node_hash_data (&self->render_node, &self->color, sizeof (GdkRGBA));
+  gsk_render_node_hash_data (&self->render_node, &self->x, sizeof (double));
+  gsk_render_node_hash_data (&self->render_node, &self->y, sizeof (double));
+  /* The attributes are bitfields with unset bits and not drawn */
+  for (i = 0; i < self->num_glyphs; i++)
+    {
+      gsk_render_node_hash_data (&self->render_node, &self->glyphs[i].glyph, sizeof (PangoGlyph));
+      gsk_render_node_hash_data (&self->render_node, &self->glyphs[i].geometry, sizeof (PangoGlyphGeometry));
+    }
+
   return &self->render_node;
 }
 
@@ -4941,6 +5887,8 @@ struct _GskBlurNode
 
   GskRenderNode *child;
   double radius;
+
+  GskCachedRendering rendering;
 };
 
 static void
@@ -4949,6 +5897,7 @@ gsk_blur_node_finalize (GskRenderNode *node)
   GskBlurNode *self = (GskBlurNode *) node;
 
   gsk_render_node_unref (self->child);
+  gsk_cached_rendering_clear (&self->rendering);
 }
 
 static void
@@ -5094,8 +6043,8 @@ blur_image_surface (cairo_surface_t *surface, int radius, int iterations)
 }
 
 static void
-gsk_blur_node_draw (GskRenderNode *node,
-                    cairo_t       *cr)
+gsk_blur_node_draw_uncached (GskRenderNode *node,
+                             cairo_t       *cr)
 {
   GskBlurNode *self = (GskBlurNode *) node;
   cairo_pattern_t *pattern;
@@ -5127,6 +6076,15 @@ gsk_blur_node_draw (GskRenderNode *node,
   cairo_pattern_destroy (pattern);
 }
 
+static void
+gsk_blur_node_draw (GskRenderNode *node,
+                    cairo_t       *cr)
+{
+  GskBlurNode *self = (GskBlurNode *) node;
+
+  gsk_render_node_draw_cached (node, cr, &self->rendering, gsk_blur_node_draw_uncached);
+}
+
 static void
 gsk_blur_node_diff (GskRenderNode  *node1,
                     GskRenderNode  *node2,
@@ -5238,6 +6196,10 @@ gsk_blur_node_new (GskRenderNode *child,
   graphene_rect_inset (&self->render_node.bounds,
                        - clip_radius, - clip_radius);
 
+  gsk_render_node_hash_begin (&self->render_node);
+  gsk_render_node_hash_data (&self->render_node, &self->radius, sizeof (double));
+  gsk_render_node_hash_child (&self->render_node, child);
+
   return &self->render_node;
 }
 
@@ -16,6 +16,15 @@ struct _GskRenderNode
 
   volatile int ref_count;
 
+  /* Size of the allocation, including the node's extra data */
+  guint alloc_size;
+
+  /* Renderers may keep this node's rendering around as a texture */
+  guint cache_hint : 1;
+
+  /* Same for nodes that draw the same, 0 if unknown */
+  guint64 hash;
+
   graphene_rect_t bounds;
 };
 
@@ -41,6 +50,9 @@ struct _GskRenderNodeClass
 GskRenderNode * gsk_render_node_new              (const GskRenderNodeClass  *node_class,
                                                   gsize                      extra_size);
 
+void            gsk_render_node_set_cache_hint   (GskRenderNode             *node,
+                                                  gboolean                   cache_hint);
+
 gboolean        gsk_render_node_can_diff         (GskRenderNode             *node1,
                                                   GskRenderNode             *node2);
 void            gsk_render_node_diff             (GskRenderNode             *node1,
@@ -50,11 +62,24 @@ void            gsk_render_node_diff_impossible  (GskRenderNode             *nod
                                                   GskRenderNode             *node2,
                                                   cairo_region_t            *region);
 
+GskRenderNode * gsk_render_node_replace_nodes    (GskRenderNode             *node,
+                                                  GHashTable                *replacements,
+                                                  guint                     *n_replaced);
+
 GVariant *      gsk_render_node_serialize_node   (GskRenderNode             *node);
 GskRenderNode * gsk_render_node_deserialize_node (GskRenderNodeType          type,
                                                   GVariant                  *variant,
                                                   GError                   **error);
 
+GBytes *        gsk_render_node_serialize_binary   (GskRenderNode          *node);
+gboolean        gsk_render_node_is_binary          (GBytes                 *bytes);
+GskRenderNode * gsk_render_node_deserialize_binary (GBytes                 *bytes,
+                                                    GError                **error);
+
+guint           gsk_container_node_find_child    (GskRenderNode             *node,
+                                                  const graphene_rect_t     *rect,
+                                                  guint                      start);
+
 GskRenderNode * gsk_cairo_node_new_for_surface   (const graphene_rect_t    *bounds,
                                                   cairo_surface_t          *surface);
 
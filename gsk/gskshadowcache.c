@@ -0,0 +1,318 @@
+#include "config.h"
+
+#include "gskshadowcacheprivate.h"
+
+#include "gskcairoblurprivate.h"
+#include "gskroundedrectprivate.h"
+
+#include <math.h>
+
+/* A cache for blurred outset shadow textures, shared by the renderers.
+ * What is stored is up to the renderer (a GL texture id, a cairo surface),
+ * the cache only keeps track of the keys and when they were last used.
+ *
+ * The shadows are small nine-slice images, see GskShadowNineSlice, so the
+ * cache hits for all shadows with the same corners, no matter their size.
+ */
+
+typedef struct
+{
+  GskShadowKey key;
+  gpointer data;
+  gsize size;
+  guint64 stamp;
+} CacheItem;
+
+static gboolean
+key_equal (const GskShadowKey *a,
+           const GskShadowKey *b)
+{
+  return gsk_rounded_rect_equal (&a->outline, &b->outline) &&
+         a->blur_radius == b->blur_radius &&
+         a->scale == b->scale &&
+         gdk_rgba_equal (&a->color, &b->color);
+}
+
+void
+gsk_shadow_cache_init (GskShadowCache         *self,
+                       GskShadowCacheFreeFunc  free_func,
+                       gpointer                user_data)
+{
+  self->items = g_array_new (FALSE, TRUE, sizeof (CacheItem));
+  self->free_func = free_func;
+  self->user_data = user_data;
+  self->size = 0;
+  self->stamp = 0;
+  self->frame_start = 0;
+}
+
+static void
+gsk_shadow_cache_remove (GskShadowCache *self,
+                         guint           i)
+{
+  CacheItem *item = &g_array_index (self->items, CacheItem, i);
+
+  self->free_func (item->data, self->user_data);
+  self->size -= item->size;
+  g_array_remove_index_fast (self->items, i);
+}
+
+void
+gsk_shadow_cache_free (GskShadowCache *self)
+{
+  guint i;
+
+  for (i = 0; i < self->items->len; i ++)
+    {
+      const CacheItem *item = &g_array_index (self->items, CacheItem, i);
+
+      self->free_func (item->data, self->user_data);
+    }
+
+  g_array_free (self->items, TRUE);
+  self->items = NULL;
+  self->size = 0;
+}
+
+void
+gsk_shadow_cache_begin_frame (GskShadowCache *self)
+{
+  guint i;
+
+  /* Drop everything that has not been used since the previous frame started */
+  for (i = 0; i < self->items->len; )
+    {
+      const CacheItem *item = &g_array_index (self->items, CacheItem, i);
+
+      if (item->stamp <= self->frame_start)
+        gsk_shadow_cache_remove (self, i);
+      else
+        i ++;
+    }
+
+  self->frame_start = self->stamp;
+}
+
+static void
+gsk_shadow_cache_remove_oldest (GskShadowCache *self)
+{
+  guint i, oldest = 0;
+
+  for (i = 1; i < self->items->len; i ++)
+    {
+      if (g_array_index (self->items, CacheItem, i).stamp <
+          g_array_index (self->items, CacheItem, oldest).stamp)
+        oldest = i;
+    }
+
+  gsk_shadow_cache_remove (self, oldest);
+}
+
+void
+gsk_shadow_cache_trim (GskShadowCache *self,
+                       guint           max_items)
+{
+  while (self->items->len > max_items)
+    gsk_shadow_cache_remove_oldest (self);
+}
+
+/* Removes the least recently used shadows until the
+ * cached ones take up at most @max_bytes */
+void
+gsk_shadow_cache_trim_size (GskShadowCache *self,
+                            gsize           max_bytes)
+{
+  while (self->items->len > 0 && self->size > max_bytes)
+    gsk_shadow_cache_remove_oldest (self);
+}
+
+gsize
+gsk_shadow_cache_get_size (GskShadowCache *self)
+{
+  return self->size;
+}
+
+gpointer
+gsk_shadow_cache_lookup (GskShadowCache     *self,
+                         const GskShadowKey *key)
+{
+  guint i;
+
+  g_assert (self != NULL);
+  g_assert (key != NULL);
+
+  for (i = 0; i < self->items->len; i ++)
+    {
+      CacheItem *item = &g_array_index (self->items, CacheItem, i);
+
+      if (key_equal (key, &item->key))
+        {
+          item->stamp = ++self->stamp;
+          return item->data;
+        }
+    }
+
+  return NULL;
+}
+
+/* @size is the memory taken up by @data, in bytes */
+void
+gsk_shadow_cache_insert (GskShadowCache     *self,
+                         const GskShadowKey *key,
+                         gpointer            data,
+                         gsize               size)
+{
+  CacheItem *item;
+
+  g_assert (self != NULL);
+  g_assert (key != NULL);
+  g_assert (data != NULL);
+
+  g_array_set_size (self->items, self->items->len + 1);
+  item = &g_array_index (self->items, CacheItem, self->items->len - 1);
+
+  item->key = *key;
+  item->data = data;
+  item->size = size;
+  item->stamp = ++self->stamp;
+
+  self->size += size;
+}
+
+/* @extent is how far the blurred shadow reaches outside of the outline.
+ * The same outline, spread and extent always give the same minimal shape,
+ * which is what makes it useful as a cache key.
+ */
+void
+gsk_shadow_nine_slice_init (GskShadowNineSlice   *self,
+                            const GskRoundedRect *outline,
+                            float                 spread,
+                            float                 extent)
+{
+  GskRoundedRect *o = &self->outline;
+
+  *o = *outline;
+  /* Shrink our outline to the minimum size that can still hold all the border radii */
+  o->bounds.size.width = ceilf (MAX (MAX (o->corner[0].width, o->corner[1].width),
+                                     MAX (o->corner[2].width, o->corner[3].width)) * 2);
+  o->bounds.size.height = ceilf (MAX (MAX (o->corner[0].height, o->corner[1].height),
+                                      MAX (o->corner[2].height, o->corner[3].height)) * 2);
+  /* Increase by the spread */
+  gsk_rounded_rect_shrink (o, -spread, -spread, -spread, -spread);
+  /* The blur reaches @extent into the shape from both sides, so the shape
+   * needs to be at least twice that to have a solid middle */
+  o->bounds.size.width = MAX (o->bounds.size.width, 2 * extent);
+  o->bounds.size.height = MAX (o->bounds.size.height, 2 * extent);
+  /* For the center part, we add a few pixels */
+  o->bounds.size.width += GSK_SHADOW_STRETCH_SIZE;
+  o->bounds.size.height += GSK_SHADOW_STRETCH_SIZE;
+  o->bounds.origin.x = extent;
+  o->bounds.origin.y = extent;
+
+  self->extent = extent;
+  self->width = o->bounds.size.width + 2 * extent;
+  self->height = o->bounds.size.height + 2 * extent;
+
+  self->top    = MAX (MAX (o->corner[0].height, o->corner[1].height), extent) + extent;
+  self->bottom = MAX (MAX (o->corner[2].height, o->corner[3].height), extent) + extent;
+  self->left   = MAX (MAX (o->corner[0].width,  o->corner[3].width),  extent) + extent;
+  self->right  = MAX (MAX (o->corner[1].width,  o->corner[2].width),  extent) + extent;
+}
+
+/* Splits @shadow_bounds, the area covered by the blurred shadow, into up
+ * to 9 parts and says where in the texture each of them comes from.
+ * Returns 0 if the shadow is too small to be split this way.
+ */
+guint
+gsk_shadow_nine_slice_get_slices (const GskShadowNineSlice *self,
+                                  const graphene_rect_t    *shadow_bounds,
+                                  GskShadowSlice            slices[9])
+{
+  float dx[4], dy[4], sx[4], sy[4];
+  guint x, y, n;
+
+  dx[0] = shadow_bounds->origin.x;
+  dx[1] = dx[0] + self->left;
+  dx[3] = shadow_bounds->origin.x + shadow_bounds->size.width;
+  dx[2] = dx[3] - self->right;
+  dy[0] = shadow_bounds->origin.y;
+  dy[1] = dy[0] + self->top;
+  dy[3] = shadow_bounds->origin.y + shadow_bounds->size.height;
+  dy[2] = dy[3] - self->bottom;
+
+  if (dx[2] < dx[1] || dy[2] < dy[1])
+    return 0;
+
+  sx[0] = 0;
+  sx[1] = (self->width - GSK_SHADOW_STRETCH_SIZE) / 2;
+  sx[2] = (self->width + GSK_SHADOW_STRETCH_SIZE) / 2;
+  sx[3] = self->width;
+  sy[0] = 0;
+  sy[1] = (self->height - GSK_SHADOW_STRETCH_SIZE) / 2;
+  sy[2] = (self->height + GSK_SHADOW_STRETCH_SIZE) / 2;
+  sy[3] = self->height;
+
+  n = 0;
+  for (y = 0; y < 3; y++)
+    {
+      if (dy[y + 1] <= dy[y])
+        continue;
+
+      for (x = 0; x < 3; x++)
+        {
+          if (dx[x + 1] <= dx[x])
+            continue;
+
+          /* The corners are copied as they are, everything else is
+           * stretched from the middle of the texture */
+          graphene_rect_init (&slices[n].dest,
+                              dx[x], dy[y],
+                              dx[x + 1] - dx[x], dy[y + 1] - dy[y]);
+          graphene_rect_init (&slices[n].source,
+                              x == 0 ? 0 : x == 2 ? self->width - self->right : sx[1],
+                              y == 0 ? 0 : y == 2 ? self->height - self->bottom : sy[1],
+                              x == 0 ? self->left : x == 2 ? self->right : sx[2] - sx[1],
+                              y == 0 ? self->top : y == 2 ? self->bottom : sy[2] - sy[1]);
+          n++;
+        }
+    }
+
+  return n;
+}
+
+/* Draws the blurred shadow of the minimal shape with cairo, for the
+ * renderers that don't blur on the GPU.
+ */
+cairo_surface_t *
+gsk_shadow_nine_slice_render (const GskShadowNineSlice *self,
+                              float                     blur_radius,
+                              const GdkRGBA            *color,
+                              float                     scale)
+{
+  cairo_surface_t *mask, *surface;
+  cairo_t *cr;
+  int width, height;
+
+  width = ceilf (self->width * scale);
+  height = ceilf (self->height * scale);
+
+  mask = cairo_image_surface_create (CAIRO_FORMAT_A8, width, height);
+  cairo_surface_set_device_scale (mask, scale, scale);
+  cr = cairo_create (mask);
+  gsk_rounded_rect_path (&self->outline, cr);
+  cairo_fill (cr);
+  cairo_destroy (cr);
+
+  gsk_cairo_blur_surface (mask, blur_radius * scale, GSK_BLUR_X | GSK_BLUR_Y);
+
+  surface = cairo_image_surface_create (CAIRO_FORMAT_ARGB32, width, height);
+  cairo_surface_set_device_scale (surface, scale, scale);
+  cr = cairo_create (surface);
+  gdk_cairo_set_source_rgba (cr, color);
+  cairo_mask_surface (cr, mask, 0, 0);
+  cairo_destroy (cr);
+
+  cairo_surface_destroy (mask);
+
+  return surface;
+}
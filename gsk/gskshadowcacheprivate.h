@@ -0,0 +1,98 @@
+#ifndef __GSK_SHADOW_CACHE_PRIVATE_H__
+#define __GSK_SHADOW_CACHE_PRIVATE_H__
+
+#include <gdk/gdk.h>
+#include <cairo.h>
+
+#include "gskroundedrect.h"
+
+G_BEGIN_DECLS
+
+/* Blurred outset shadows are drawn from a small texture that holds the
+ * shadow of the minimal shape with the same corners. Its corners are
+ * drawn as they are and its middle rows and columns are stretched to
+ * the size of the actual shadow, so large shadows cost the same as
+ * small ones.
+ */
+typedef struct
+{
+  /* The minimal shape, positioned inside the texture */
+  GskRoundedRect outline;
+  /* How far the blur reaches outside of the shape */
+  float extent;
+  /* The size of the texture */
+  float width;
+  float height;
+  /* The size of the corner slices. The edge slices between them are
+   * stretched from the middle GSK_SHADOW_STRETCH_SIZE pixels */
+  float left;
+  float right;
+  float top;
+  float bottom;
+} GskShadowNineSlice;
+
+#define GSK_SHADOW_STRETCH_SIZE 4
+
+typedef struct
+{
+  graphene_rect_t dest;
+  graphene_rect_t source;
+} GskShadowSlice;
+
+void            gsk_shadow_nine_slice_init              (GskShadowNineSlice     *self,
+                                                         const GskRoundedRect   *outline,
+                                                         float                   spread,
+                                                         float                   extent);
+guint           gsk_shadow_nine_slice_get_slices        (const GskShadowNineSlice *self,
+                                                         const graphene_rect_t  *shadow_bounds,
+                                                         GskShadowSlice          slices[9]);
+cairo_surface_t *
+                gsk_shadow_nine_slice_render            (const GskShadowNineSlice *self,
+                                                         float                   blur_radius,
+                                                         const GdkRGBA          *color,
+                                                         float                   scale);
+
+typedef struct
+{
+  GskRoundedRect outline;
+  float blur_radius;
+  GdkRGBA color;
+  float scale;
+} GskShadowKey;
+
+typedef void (* GskShadowCacheFreeFunc) (gpointer data,
+                                         gpointer user_data);
+
+typedef struct
+{
+  GArray *items;
+  GskShadowCacheFreeFunc free_func;
+  gpointer user_data;
+
+  gsize size;
+  guint64 stamp;
+  guint64 frame_start;
+} GskShadowCache;
+
+void            gsk_shadow_cache_init                   (GskShadowCache         *self,
+                                                         GskShadowCacheFreeFunc  free_func,
+                                                         gpointer                user_data);
+void            gsk_shadow_cache_free                   (GskShadowCache         *self);
+
+void            gsk_shadow_cache_begin_frame            (GskShadowCache         *self);
+void            gsk_shadow_cache_trim                   (GskShadowCache         *self,
+                                                         guint                   max_items);
+void            gsk_shadow_cache_trim_size              (GskShadowCache         *self,
+                                                         gsize                   max_bytes);
+gsize           gsk_shadow_cache_get_size               (GskShadowCache         *self);
+
+gpointer        gsk_shadow_cache_lookup                 (GskShadowCache         *self,
+                                                         const GskShadowKey     *key);
+void            gsk_shadow_cache_insert                 (GskShadowCache         *self,
+                                                         const GskShadowKey     *key,
+                                                         gpointer                data,
+                                                         gsize                   size);
+
+G_END_DECLS
+
+#endif /* __GSK_SHADOW_CACHE_PRIVATE_H__ */
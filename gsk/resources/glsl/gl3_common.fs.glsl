@@ -44,6 +44,16 @@ ellipsis_coverage (vec2 point, vec2 center, vec2 radius)
   return clamp (0.5 - d, 0.0, 1.0);
 }
 
+float
+rect_coverage (vec4 bounds, vec2 p)
+{
+  if (p.x < bounds.x || p.y < bounds.y ||
+      p.x >= bounds.z || p.y >= bounds.w)
+    return 0.0;
+
+  return 1.0;
+}
+
 float
 rounded_rect_coverage (RoundedRect r, vec2 p)
 {
@@ -91,6 +101,9 @@ vec4 Texture(sampler2D sampler, vec2 texCoords) {
 }
 
 void setOutputColor(vec4 color) {
+#if defined(GSK_NO_CLIP)
+  outputColor = color;
+#else
   vec4 clipBounds = u_clip;
   vec4 f = gl_FragCoord;
 
@@ -100,8 +113,12 @@ void setOutputColor(vec4 color) {
   clipBounds.z = clipBounds.x + clipBounds.z;
   clipBounds.w = clipBounds.y + clipBounds.w;
 
+#if defined(GSK_RECT_CLIP)
+  outputColor = color * rect_coverage(clipBounds, f.xy);
+#else
   RoundedRect r = RoundedRect(clipBounds, u_clip_corner_widths, u_clip_corner_heights);
 
   outputColor = color * rounded_rect_coverage(r, f.xy);
-  /*outputColor = color;*/
+#endif
+#endif
 }
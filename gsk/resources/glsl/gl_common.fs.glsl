@@ -40,6 +40,16 @@ ellipsis_coverage (vec2 point, vec2 center, vec2 radius)
   return clamp (0.5 - d, 0.0, 1.0);
 }
 
+float
+rect_coverage (vec4 bounds, vec2 p)
+{
+  if (p.x < bounds.x || p.y < bounds.y ||
+      p.x >= bounds.z || p.y >= bounds.w)
+    return 0.0;
+
+  return 1.0;
+}
+
 float
 rounded_rect_coverage (RoundedRect r, vec2 p)
 {
@@ -87,6 +97,9 @@ vec4 Texture(sampler2D sampler, vec2 texCoords) {
 }
 
 void setOutputColor(vec4 color) {
+#if defined(GSK_NO_CLIP)
+  gl_FragColor = color;
+#else
   vec4 clipBounds = u_clip;
   vec4 f = gl_FragCoord;
 
@@ -96,7 +109,12 @@ void setOutputColor(vec4 color) {
   clipBounds.z = clipBounds.x + clipBounds.z;
   clipBounds.w = clipBounds.y + clipBounds.w;
 
+#if defined(GSK_RECT_CLIP)
+  gl_FragColor = color * rect_coverage(clipBounds, f.xy);
+#else
   RoundedRect r = RoundedRect(clipBounds, u_clip_corner_widths, u_clip_corner_heights);
 
   gl_FragColor = color * rounded_rect_coverage(r, f.xy);
+#endif
+#endif
 }
@@ -0,0 +1,17 @@
+#if defined(GSK_GL3)
+in vec4 vColor;
+in float vRecolor;
+#else
+varying vec4 vColor;
+varying float vRecolor;
+#endif
+
+void main() {
+  vec4 diffuse = Texture(u_source, vUv);
+
+  // Like coloring.fs.glsl for normal glyphs, and like blit.fs.glsl
+  // for color glyphs, which keep the colors of the atlas.
+  vec4 color = vec4(vColor.rgb * diffuse.a, diffuse.a * vColor.a);
+
+  setOutputColor(mix(diffuse, color, vRecolor) * u_alpha);
+}
@@ -0,0 +1,28 @@
+// aPosition is a corner of the unit quad, the rest is per glyph
+#if defined(GSK_GL3)
+in vec4 aGlyphRect;
+in vec4 aGlyphUv;
+in vec4 aGlyphColor;
+in float aGlyphRecolor;
+
+out vec4 vColor;
+out float vRecolor;
+#else
+attribute vec4 aGlyphRect;
+attribute vec4 aGlyphUv;
+attribute vec4 aGlyphColor;
+attribute float aGlyphRecolor;
+
+varying vec4 vColor;
+varying float vRecolor;
+#endif
+
+void main() {
+  vec2 position = aGlyphRect.xy + aPosition * aGlyphRect.zw;
+
+  gl_Position = u_projection * u_modelview * vec4(position, 0.0, 1.0);
+
+  vUv = aGlyphUv.xy + aPosition * aGlyphUv.zw;
+  vColor = aGlyphColor;
+  vRecolor = aGlyphRecolor;
+}
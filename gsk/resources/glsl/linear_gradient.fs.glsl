@@ -3,6 +3,7 @@ uniform float u_color_offsets[8];
 uniform int u_num_color_stops;
 uniform vec2 u_start_point;
 uniform vec2 u_end_point;
+uniform int u_repeat;
 
 vec4 fragCoord() {
   vec4 f = gl_FragCoord;
@@ -23,12 +24,15 @@ void main() {
   vec2 gradient = endPoint - startPoint;
   float gradientLength = length(gradient);
 
-  // Current pixel, projected onto the line between the start point and the end point
-  // The projection will be relative to the start point!
-  vec2 proj = (dot(gradient, pos) / (gradientLength * gradientLength)) * gradient;
+  // Current pixel, projected onto the line between the start point and the end point,
+  // relative to the start point and in units of the gradient length.
+  float offset = dot(gradient, pos) / (gradientLength * maxDist);
 
-  // Offset of the current pixel
-  float offset = length(proj) / maxDist;
+  // Repeating gradients wrap around, the others only care about the distance
+  if (u_repeat != 0)
+    offset = fract(offset);
+  else
+    offset = abs(offset);
 
   vec4 color = u_color_stops[0];
   for (int i = 1; i < u_num_color_stops; i ++) {
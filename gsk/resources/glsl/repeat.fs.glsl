@@ -0,0 +1,8 @@
+void main() {
+  /* vUv is in units of the child bounds, so wrap it around here
+   * instead of relying on GL_REPEAT, which GLES 2 does not support
+   * for non-power-of-two textures. */
+  vec4 diffuse = Texture(u_source, fract(vUv));
+
+  setOutputColor(diffuse * u_alpha);
+}
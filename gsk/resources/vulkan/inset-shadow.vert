@@ -17,6 +17,7 @@ layout(location = 3) out flat vec4 outOutlineCornerHeights;
 layout(location = 4) out flat vec4 outColor;
 layout(location = 5) out flat vec2 outOffset;
 layout(location = 6) out flat float outSpread;
+layout(location = 7) out flat float outBlurRadius;
 
 vec2 offsets[6] = { vec2(0.0, 0.0),
                     vec2(1.0, 0.0),
@@ -38,4 +39,5 @@ void main() {
   outColor = inColor;
   outOffset = inOffset;
   outSpread = inSpread;
+  outBlurRadius = inBlurRadius;
 }
@@ -19,9 +19,9 @@ void main()
   RoundedRect outline = RoundedRect (vec4(inOutline.xy, inOutline.xy + inOutline.zw), inOutlineCornerWidths, inOutlineCornerHeights);
   RoundedRect outside = rounded_rect_shrink (outline, vec4(-inSpread));
 
+  /* The blur radius is twice the standard deviation, like for CSS */
   color = vec4(inColor.rgb * inColor.a, inColor.a);
-  color = color * clamp (rounded_rect_coverage (outside, inPos - inOffset) -
-                         rounded_rect_coverage (outline, inPos),
-                         0.0, 1.0);
+  color = color * rounded_rect_blurred_coverage (outside, inPos - inOffset, inBlurRadius / 2.0) *
+                  (1.0 - rounded_rect_coverage (outline, inPos));
   color = clip (inPos, color);
 }
@@ -56,6 +56,73 @@ rounded_rect_coverage (RoundedRect r, vec2 p)
   return 1.0 - dot(vec4(is_out), corner_coverages);
 }
 
+float
+gauss (float x, float sigma)
+{
+  return exp (-(x * x) / (2.0 * sigma * sigma)) / (sqrt (2.0 * 3.141592653589793) * sigma);
+}
+
+/* Abramowitz and Stegun, 7.1.27 */
+vec2
+erf_approx (vec2 x)
+{
+  vec2 s = sign (x);
+  vec2 a = abs (x);
+
+  x = 1.0 + (0.278393 + (0.230389 + 0.078108 * (a * a)) * a) * a;
+  x *= x;
+
+  return s - s / (x * x);
+}
+
+/* The blurred coverage of one row of a box with the given corner
+ * radius, which is the difference of two error functions */
+float
+blurred_box_row (float x, float y, float sigma, float corner, vec2 half_size)
+{
+  float delta = min (half_size.y - corner - abs (y), 0.0);
+  float curved = half_size.x - corner + sqrt (max (0.0, corner * corner - delta * delta));
+  vec2 integral = 0.5 + 0.5 * erf_approx ((x + vec2 (-curved, curved)) * (sqrt (0.5) / sigma));
+
+  return integral.y - integral.x;
+}
+
+/* The coverage of r blurred with a gaussian of deviation sigma. It is
+ * exact along x and sums a few rows along y, and uses the radius of
+ * the corner closest to p for all of them. */
+float
+rounded_rect_blurred_coverage (RoundedRect r, vec2 p, float sigma)
+{
+  if (sigma <= 0.0)
+    return rounded_rect_coverage (r, p);
+
+  vec2 half_size = max ((r.bounds.zw - r.bounds.xy) * 0.5, 0.0);
+  vec4 radii = max (r.corner_widths, r.corner_heights);
+  float corner;
+
+  p -= (r.bounds.xy + r.bounds.zw) * 0.5;
+
+  if (p.y < 0.0)
+    corner = p.x < 0.0 ? radii.x : radii.y;
+  else
+    corner = p.x < 0.0 ? radii.w : radii.z;
+  corner = min (corner, min (half_size.x, half_size.y));
+
+  float start = clamp (-3.0 * sigma, p.y - half_size.y, p.y + half_size.y);
+  float end = clamp (3.0 * sigma, p.y - half_size.y, p.y + half_size.y);
+  float step = (end - start) / 4.0;
+  float y = start + step * 0.5;
+  float value = 0.0;
+
+  for (int i = 0; i < 4; i++)
+    {
+      value += blurred_box_row (p.x, p.y - y, sigma, corner, half_size) * gauss (y, sigma) * step;
+      y += step;
+    }
+
+  return value;
+}
+
 RoundedRect
 rounded_rect_shrink (RoundedRect r, vec4 amount)
 {
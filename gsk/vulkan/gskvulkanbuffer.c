@@ -44,14 +44,13 @@ gsk_vulkan_buffer_new_internal (GdkVulkanContext  *context,
                                  &requirements);
 
   self->memory = gsk_vulkan_memory_new (context,
-                                        requirements.memoryTypeBits,
-                                        VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT,
-                                        size);
+                                        &requirements,
+                                        VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT);
 
   GSK_VK_CHECK (vkBindBufferMemory, gdk_vulkan_context_get_device (context),
                                     self->vk_buffer,
                                     gsk_vulkan_memory_get_device_memory (self->memory),
-                                    0);
+                                    gsk_vulkan_memory_get_offset (self->memory));
   return self;
 }
 
@@ -8,7 +8,10 @@ struct _GskVulkanCommandPool
   GdkVulkanContext *vulkan;
 
   VkCommandPool vk_command_pool;
+  /* Command buffers are kept across resets of the pool, the first
+   * n_used_buffers of them have been handed out since the last reset */
   GPtrArray *buffers;
+  guint n_used_buffers;
 };
 
 GskVulkanCommandPool *
@@ -37,12 +40,14 @@ gsk_vulkan_command_pool_new (GdkVulkanContext *context)
 static void
 gsk_vulkan_command_pool_free_buffers (GskVulkanCommandPool *self)
 {
-  vkFreeCommandBuffers (gdk_vulkan_context_get_device (self->vulkan),
-                        self->vk_command_pool,
-                        self->buffers->len,
-                        (VkCommandBuffer *) self->buffers->pdata);
+  if (self->buffers->len > 0)
+    vkFreeCommandBuffers (gdk_vulkan_context_get_device (self->vulkan),
+                          self->vk_command_pool,
+                          self->buffers->len,
+                          (VkCommandBuffer *) self->buffers->pdata);
 
   g_ptr_array_set_size (self->buffers, 0);
+  self->n_used_buffers = 0;
 }
 
 void
@@ -61,11 +66,12 @@ gsk_vulkan_command_pool_free (GskVulkanCommandPool *self)
 void
 gsk_vulkan_command_pool_reset (GskVulkanCommandPool *self)
 {
-  gsk_vulkan_command_pool_free_buffers (self);
-
+  /* This resets all command buffers, so they can be recorded again */
   GSK_VK_CHECK (vkResetCommandPool, gdk_vulkan_context_get_device (self->vulkan),
                                     self->vk_command_pool,
                                     0);
+
+  self->n_used_buffers = 0;
 }
 
 VkCommandBuffer
@@ -73,15 +79,23 @@ gsk_vulkan_command_pool_get_buffer (GskVulkanCommandPool *self)
 {
   VkCommandBuffer command_buffer;
 
-  GSK_VK_CHECK (vkAllocateCommandBuffers, gdk_vulkan_context_get_device (self->vulkan),
-                                          &(VkCommandBufferAllocateInfo) {
-                                              .sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_ALLOCATE_INFO,
-                                              .commandPool = self->vk_command_pool,
-                                              .level = VK_COMMAND_BUFFER_LEVEL_PRIMARY,
-                                              .commandBufferCount = 1,
-                                          },
-                                          &command_buffer);
-  g_ptr_array_add (self->buffers, command_buffer);
+  if (self->n_used_buffers < self->buffers->len)
+    {
+      command_buffer = g_ptr_array_index (self->buffers, self->n_used_buffers);
+    }
+  else
+    {
+      GSK_VK_CHECK (vkAllocateCommandBuffers, gdk_vulkan_context_get_device (self->vulkan),
+                                              &(VkCommandBufferAllocateInfo) {
+                                                  .sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_ALLOCATE_INFO,
+                                                  .commandPool = self->vk_command_pool,
+                                                  .level = VK_COMMAND_BUFFER_LEVEL_PRIMARY,
+                                                  .commandBufferCount = 1,
+                                              },
+                                              &command_buffer);
+      g_ptr_array_add (self->buffers, command_buffer);
+    }
+  self->n_used_buffers++;
 
   GSK_VK_CHECK (vkBeginCommandBuffer, command_buffer,
                                       &(VkCommandBufferBeginInfo) {
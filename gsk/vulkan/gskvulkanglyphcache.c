@@ -4,7 +4,9 @@
 
 #include "gskvulkanimageprivate.h"
 #include "gskdebugprivate.h"
+#include "gskglyphrasterizerprivate.h"
 #include "gskprivate.h"
+#include "gskprofilerprivate.h"
 #include "gskrendererprivate.h"
 
 #include <graphene.h>
@@ -37,11 +39,18 @@ struct _GskVulkanGlyphCache {
 
   GdkVulkanContext *vulkan;
   GskRenderer *renderer;
+  GskGlyphRasterizer *rasterizer;
 
+  /* Ops for text nodes may be added from several threads, see
+   * gsk_vulkan_render_pass_add_children() */
+  GMutex lock;
   GHashTable *hash_table;
   GPtrArray *atlases;
 
   guint64 timestamp;
+
+  GQuark hits_counter;
+  GQuark misses_counter;
 };
 
 struct _GskVulkanGlyphCacheClass {
@@ -91,6 +100,7 @@ gsk_vulkan_glyph_cache_init (GskVulkanGlyphCache *cache)
   cache->hash_table = g_hash_table_new_full (glyph_cache_hash, glyph_cache_equal,
                                              glyph_cache_key_free, glyph_cache_value_free);
   cache->atlases = g_ptr_array_new_with_free_func (free_atlas);
+  g_mutex_init (&cache->lock);
 }
 
 static void
@@ -100,6 +110,8 @@ gsk_vulkan_glyph_cache_finalize (GObject *object)
 
   g_ptr_array_unref (cache->atlases);
   g_hash_table_unref (cache->hash_table);
+  g_clear_object (&cache->rasterizer);
+  g_mutex_clear (&cache->lock);
 
   G_OBJECT_CLASS (gsk_vulkan_glyph_cache_parent_class)->finalize (object);
 }
@@ -217,7 +229,7 @@ add_to_cache (GskVulkanGlyphCache  *cache,
 
   value->texture_index = i;
 
-  dirty = g_new (DirtyGlyph, 1);
+  dirty = g_new0 (DirtyGlyph, 1);
   dirty->key = key;
   dirty->value = value;
   atlas->dirty_glyphs = g_list_prepend (atlas->dirty_glyphs, dirty);
@@ -244,40 +256,19 @@ add_to_cache (GskVulkanGlyphCache  *cache,
 #endif
 }
 
-static void
-render_glyph (Atlas          *atlas,
-              DirtyGlyph     *glyph,
-              GskImageRegion *region)
+static gboolean
+render_glyph (GskVulkanGlyphCache *cache,
+              Atlas               *atlas,
+              DirtyGlyph          *glyph,
+              GskImageRegion      *region)
 {
   GlyphCacheKey *key = glyph->key;
   GskVulkanCachedGlyph *value = glyph->value;
   cairo_surface_t *surface;
-  cairo_t *cr;
-  PangoGlyphString glyphs;
-  PangoGlyphInfo gi;
-
-  surface = cairo_image_surface_create (CAIRO_FORMAT_ARGB32,
-                                        value->draw_width * key->scale / 1024,
-                                        value->draw_height * key->scale / 1024);
-  cairo_surface_set_device_scale (surface, key->scale / 1024.0, key->scale / 1024.0);
-
-  cr = cairo_create (surface);
-  cairo_set_source_rgba (cr, 1, 1, 1, 1);
-
-  gi.glyph = key->glyph;
-  gi.geometry.width = value->draw_width * 1024;
-  if (key->glyph & PANGO_GLYPH_UNKNOWN_FLAG)
-    gi.geometry.x_offset = 0;
-  else
-    gi.geometry.x_offset = - value->draw_x * 1024;
-  gi.geometry.y_offset = - value->draw_y * 1024;
-
-  glyphs.num_glyphs = 1;
-  glyphs.glyphs = &gi;
-
-  pango_cairo_show_glyph_string (cr, key->font, &glyphs);
 
-  cairo_destroy (cr);
+  surface = gsk_glyph_rasterizer_get_surface (cache->rasterizer, key->font, key->glyph, key->scale);
+  if (G_UNLIKELY (surface == NULL))
+    return FALSE;
 
   glyph->surface = surface;
 
@@ -287,6 +278,8 @@ render_glyph (Atlas          *atlas,
   region->stride = cairo_image_surface_get_stride (surface);
   region->x = (gsize)(value->tx * atlas->width);
   region->y = (gsize)(value->ty * atlas->height);
+
+  return TRUE;
 }
 
 static void
@@ -302,8 +295,12 @@ upload_dirty_glyphs (GskVulkanGlyphCache *cache,
   num_regions = g_list_length (atlas->dirty_glyphs);
   regions = alloca (sizeof (GskImageRegion) * num_regions);
 
-  for (l = atlas->dirty_glyphs, i = 0; l; l = l->next, i++)
-    render_glyph (atlas, (DirtyGlyph *)l->data, &regions[i]);
+  for (l = atlas->dirty_glyphs, i = 0; l; l = l->next)
+    {
+      if (render_glyph (cache, atlas, (DirtyGlyph *)l->data, &regions[i]))
+        i++;
+    }
+  num_regions = i;
 
   GSK_RENDERER_NOTE (cache->renderer, GLYPH_CACHE,
             g_message ("uploading %d glyphs to cache", num_regions));
@@ -323,8 +320,12 @@ gsk_vulkan_glyph_cache_new (GskRenderer      *renderer,
   cache = GSK_VULKAN_GLYPH_CACHE (g_object_new (GSK_TYPE_VULKAN_GLYPH_CACHE, NULL));
   cache->renderer = renderer;
   cache->vulkan = vulkan;
+  cache->rasterizer = g_object_ref (gsk_glyph_rasterizer_get_for_display (gsk_renderer_get_display (renderer)));
   g_ptr_array_add (cache->atlases, create_atlas (cache));
 
+  cache->hits_counter = g_quark_from_static_string ("glyph-cache-hits");
+  cache->misses_counter = g_quark_from_static_string ("glyph-cache-misses");
+
   return cache;
 }
 
@@ -342,8 +343,14 @@ gsk_vulkan_glyph_cache_lookup (GskVulkanGlyphCache *cache,
   lookup_key.glyph = glyph;
   lookup_key.scale = (guint)(scale * 1024);
 
+  g_mutex_lock (&cache->lock);
+
   value = g_hash_table_lookup (cache->hash_table, &lookup_key);
 
+  if (create)
+    gsk_profiler_counter_inc (gsk_renderer_get_profiler (cache->renderer),
+                              value ? cache->hits_counter : cache->misses_counter);
+
   if (value)
     {
       if (cache->timestamp - value->timestamp >= MAX_AGE)
@@ -363,8 +370,8 @@ gsk_vulkan_glyph_cache_lookup (GskVulkanGlyphCache *cache,
       key = g_new (GlyphCacheKey, 1);
       value = g_new0 (GskVulkanCachedGlyph, 1);
 
-      pango_font_get_glyph_extents (font, glyph, &ink_rect, NULL);
-      pango_extents_to_pixels (&ink_rect, NULL);
+      gsk_glyph_rasterizer_get_extents (cache->rasterizer, font, glyph,
+                                        (guint)(scale * 1024), &ink_rect);
 
       value->draw_x = ink_rect.x;
       value->draw_y = ink_rect.y;
@@ -382,6 +389,8 @@ gsk_vulkan_glyph_cache_lookup (GskVulkanGlyphCache *cache,
       g_hash_table_insert (cache->hash_table, key, value);
     }
 
+  g_mutex_unlock (&cache->lock);
+
   return value;
 }
 
@@ -8,6 +8,16 @@
 
 #include <string.h>
 
+/* Uploads are staged in a persistently mapped buffer that every uploader
+ * keeps across frames. As each GskVulkanRender has its own uploader and
+ * only resets it once its fence has signalled, the buffers of all frames
+ * in flight together form a ring. Uploads that are too big for it get a
+ * buffer of their own.
+ */
+#define STAGING_RING_MIN_SIZE (1024 * 1024)
+#define STAGING_RING_MAX_SIZE (16 * 1024 * 1024)
+#define STAGING_ALIGNMENT 16
+
 struct _GskVulkanUploader
 {
   GdkVulkanContext *vulkan;
@@ -22,6 +32,13 @@ struct _GskVulkanUploader
 
   GSList *staging_image_free_list;
   GSList *staging_buffer_free_list;
+
+  GskVulkanBuffer *staging_ring;
+  gsize staging_ring_size;
+  gsize staging_ring_used;
+
+  /* Pixel data uploaded since the last reset */
+  gsize upload_bytes;
 };
 
 struct _GskVulkanImage
@@ -68,6 +85,8 @@ gsk_vulkan_uploader_free (GskVulkanUploader *self)
 {
   gsk_vulkan_uploader_reset (self);
 
+  g_clear_pointer (&self->staging_ring, gsk_vulkan_buffer_free);
+
   g_array_unref (self->after_buffer_barriers);
   g_array_unref (self->before_buffer_barriers);
   g_array_unref (self->after_image_barriers);
@@ -192,6 +211,60 @@ gsk_vulkan_uploader_reset (GskVulkanUploader *self)
   self->staging_image_free_list = NULL;
   g_slist_free_full (self->staging_buffer_free_list, (GDestroyNotify) gsk_vulkan_buffer_free);
   self->staging_buffer_free_list = NULL;
+  self->staging_ring_used = 0;
+  self->upload_bytes = 0;
+}
+
+gsize
+gsk_vulkan_uploader_get_upload_bytes (GskVulkanUploader *self)
+{
+  return self->upload_bytes;
+}
+
+static guchar *
+gsk_vulkan_uploader_alloc_staging (GskVulkanUploader *self,
+                                   gsize              size,
+                                   VkBuffer          *buffer,
+                                   gsize             *offset)
+{
+  GskVulkanBuffer *staging;
+  gsize start;
+
+  if (size > STAGING_RING_MAX_SIZE / 2)
+    {
+      staging = gsk_vulkan_buffer_new_staging (self->vulkan, size);
+      self->staging_buffer_free_list = g_slist_prepend (self->staging_buffer_free_list, staging);
+
+      *buffer = gsk_vulkan_buffer_get_buffer (staging);
+      *offset = 0;
+      return gsk_vulkan_buffer_map (staging);
+    }
+
+  start = (self->staging_ring_used + STAGING_ALIGNMENT - 1) & ~(STAGING_ALIGNMENT - 1);
+
+  if (self->staging_ring == NULL || start + size > self->staging_ring_size)
+    {
+      gsize ring_size = MAX (self->staging_ring_size * 2, STAGING_RING_MIN_SIZE);
+
+      while (ring_size < size)
+        ring_size *= 2;
+      ring_size = MIN (ring_size, STAGING_RING_MAX_SIZE);
+
+      /* Copies recorded earlier this frame still read from the old one */
+      if (self->staging_ring)
+        self->staging_buffer_free_list = g_slist_prepend (self->staging_buffer_free_list, self->staging_ring);
+
+      self->staging_ring = gsk_vulkan_buffer_new_staging (self->vulkan, ring_size);
+      self->staging_ring_size = ring_size;
+      start = 0;
+    }
+
+  self->staging_ring_used = start + size;
+
+  *buffer = gsk_vulkan_buffer_get_buffer (self->staging_ring);
+  *offset = start;
+
+  return gsk_vulkan_buffer_map (self->staging_ring) + start;
 }
 
 static GskVulkanImage *
@@ -239,14 +312,13 @@ gsk_vulkan_image_new (GdkVulkanContext      *context,
                                 &requirements);
 
   self->memory = gsk_vulkan_memory_new (context,
-                                        requirements.memoryTypeBits,
-                                        memory,
-                                        requirements.size);
+                                        &requirements,
+                                        memory);
 
   GSK_VK_CHECK (vkBindImageMemory, gdk_vulkan_context_get_device (context),
                                    self->vk_image,
                                    gsk_vulkan_memory_get_device_memory (self->memory),
-                                   0);
+                                   gsk_vulkan_memory_get_offset (self->memory));
   return self;
 }
 
@@ -324,12 +396,12 @@ gsk_vulkan_image_new_from_data_via_staging_buffer (GskVulkanUploader *uploader,
                                                    gsize              stride)
 {
   GskVulkanImage *self;
-  GskVulkanBuffer *staging;
+  VkBuffer staging;
   gsize buffer_size = width * height * 4;
+  gsize buffer_offset;
   guchar *mem;
 
-  staging = gsk_vulkan_buffer_new_staging (uploader->vulkan, buffer_size);
-  mem = gsk_vulkan_buffer_map (staging);
+  mem = gsk_vulkan_uploader_alloc_staging (uploader, buffer_size, &staging, &buffer_offset);
 
   if (stride == width * 4)
     {
@@ -343,8 +415,6 @@ gsk_vulkan_image_new_from_data_via_staging_buffer (GskVulkanUploader *uploader,
         }
     }
 
-  gsk_vulkan_buffer_unmap (staging);
-
   gsk_vulkan_uploader_add_buffer_barrier (uploader,
                                           FALSE,
                                           &(VkBufferMemoryBarrier) {
@@ -353,8 +423,8 @@ gsk_vulkan_image_new_from_data_via_staging_buffer (GskVulkanUploader *uploader,
                                              .dstAccessMask = VK_ACCESS_TRANSFER_READ_BIT,
                                              .srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED,
                                              .dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED,
-                                             .buffer = gsk_vulkan_buffer_get_buffer(staging),
-                                             .offset = 0,
+                                             .buffer = staging,
+                                             .offset = buffer_offset,
                                              .size = buffer_size,
                                          });
 
@@ -375,13 +445,13 @@ gsk_vulkan_image_new_from_data_via_staging_buffer (GskVulkanUploader *uploader,
                                          VK_ACCESS_TRANSFER_WRITE_BIT);
 
   vkCmdCopyBufferToImage (gsk_vulkan_uploader_get_copy_buffer (uploader),
-                          gsk_vulkan_buffer_get_buffer (staging),
+                          staging,
                           self->vk_image,
                           VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL,
                           1,
                           (VkBufferImageCopy[1]) {
                                {
-                                   .bufferOffset = 0,
+                                   .bufferOffset = buffer_offset,
                                    .imageSubresource = {
                                        .aspectMask = VK_IMAGE_ASPECT_COLOR_BIT,
                                        .mipLevel = 0,
@@ -403,8 +473,6 @@ gsk_vulkan_image_new_from_data_via_staging_buffer (GskVulkanUploader *uploader,
                                          VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL,
                                          VK_ACCESS_SHADER_READ_BIT);
 
-  uploader->staging_buffer_free_list = g_slist_prepend (uploader->staging_buffer_free_list, staging);
-
   gsk_vulkan_image_ensure_view (self, VK_FORMAT_B8G8R8A8_UNORM);
 
   return self;
@@ -532,6 +600,8 @@ gsk_vulkan_image_new_from_data (GskVulkanUploader *uploader,
                                 gsize              height,
                                 gsize              stride)
 {
+  uploader->upload_bytes += width * height * 4;
+
   if (GSK_DEBUG_CHECK (VULKAN_STAGING_BUFFER))
     return gsk_vulkan_image_new_from_data_via_staging_buffer (uploader, data, width, height, stride);
   else if (GSK_DEBUG_CHECK (VULKAN_STAGING_IMAGE))
@@ -689,19 +759,21 @@ gsk_vulkan_image_upload_regions (GskVulkanImage    *self,
                                  guint              num_regions,
                                  GskImageRegion    *regions)
 {
-  GskVulkanBuffer *staging;
+  VkBuffer staging;
   guchar *mem;
   guchar *m;
   gsize size;
   gsize offset;
+  gsize buffer_offset;
   VkBufferImageCopy *bufferImageCopy;
 
   size = 0;
   for (int i = 0; i < num_regions; i++)
     size += regions[i].width * regions[i].height * 4;
 
-  staging = gsk_vulkan_buffer_new_staging (uploader->vulkan, size);
-  mem = gsk_vulkan_buffer_map (staging);
+  uploader->upload_bytes += size;
+
+  mem = gsk_vulkan_uploader_alloc_staging (uploader, size, &staging, &buffer_offset);
 
   bufferImageCopy = alloca (sizeof (VkBufferImageCopy) * num_regions);
   memset (bufferImageCopy, 0, sizeof (VkBufferImageCopy) * num_regions);
@@ -716,11 +788,11 @@ gsk_vulkan_image_upload_regions (GskVulkanImage    *self,
         }
       else
         {
-          for (gsize r = 0; r < regions[i].height; i++)
+          for (gsize r = 0; r < regions[i].height; r++)
             memcpy (m + r * regions[i].width * 4, regions[i].data + r * regions[i].stride, regions[i].width * 4);
         }
 
-      bufferImageCopy[i].bufferOffset = offset;
+      bufferImageCopy[i].bufferOffset = buffer_offset + offset;
       bufferImageCopy[i].imageSubresource.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
       bufferImageCopy[i].imageSubresource.mipLevel = 0;
       bufferImageCopy[i].imageSubresource.baseArrayLayer = 0;
@@ -735,8 +807,6 @@ gsk_vulkan_image_upload_regions (GskVulkanImage    *self,
       offset += regions[i].width * regions[i].height * 4;
     }
 
-  gsk_vulkan_buffer_unmap (staging);
-
   gsk_vulkan_uploader_add_image_barrier (uploader,
                                          FALSE,
                                          self,
@@ -744,7 +814,7 @@ gsk_vulkan_image_upload_regions (GskVulkanImage    *self,
                                          VK_ACCESS_TRANSFER_WRITE_BIT);
 
   vkCmdCopyBufferToImage (gsk_vulkan_uploader_get_copy_buffer (uploader),
-                          gsk_vulkan_buffer_get_buffer (staging),
+                          staging,
                           self->vk_image,
                           VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL,
                           num_regions,
@@ -756,8 +826,6 @@ gsk_vulkan_image_upload_regions (GskVulkanImage    *self,
                                          VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL,
                                          VK_ACCESS_SHADER_READ_BIT);
 
-  uploader->staging_buffer_free_list = g_slist_prepend (uploader->staging_buffer_free_list, staging);
-
   gsk_vulkan_image_ensure_view (self, VK_FORMAT_B8G8R8A8_UNORM);
 }
 
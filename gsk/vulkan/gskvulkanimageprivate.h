@@ -19,6 +19,7 @@ void                    gsk_vulkan_uploader_free                        (GskVulk
 
 void                    gsk_vulkan_uploader_reset                       (GskVulkanUploader      *self);
 void                    gsk_vulkan_uploader_upload                      (GskVulkanUploader      *self);
+gsize                   gsk_vulkan_uploader_get_upload_bytes            (GskVulkanUploader      *self);
 
 GskVulkanImage *        gsk_vulkan_image_new_for_swapchain              (GdkVulkanContext       *context,
                                                                          VkImage                 image,
@@ -0,0 +1,144 @@
+#include "config.h"
+
+#include "gskvulkanlayercacheprivate.h"
+
+#include <math.h>
+
+/* Layers are render nodes that were marked with a cache hint, rendered
+ * into an image of their own once, and then drawn from that image for
+ * as long as the same node gets rendered. This is what the GL renderer
+ * does with its GskGLLayerCache.
+ *
+ * Besides the node, the key is the modelview matrix the layer was
+ * rendered with. Moving the layer by whole pixels gives the same
+ * pixels, so only the linear part and the fractional part of the
+ * translation have to match.
+ *
+ * Renders that use a layer hold their own reference on its image, so
+ * a layer can be dropped while frames drawing it are still in flight.
+ */
+
+#define MAX_LAYER_AGE 60
+
+typedef struct
+{
+  GskRenderNode *node;
+  graphene_matrix_t mv;
+
+  GskVulkanImage *image;
+  guint age;
+} CacheItem;
+
+static void
+cache_item_free (gpointer data)
+{
+  CacheItem *item = data;
+
+  gsk_render_node_unref (item->node);
+  g_object_unref (item->image);
+  g_slice_free (CacheItem, item);
+}
+
+static gboolean
+same_pixels (const graphene_matrix_t *a,
+             const graphene_matrix_t *b)
+{
+  float ax, ay, bx, by;
+  guint row, col;
+
+  for (row = 0; row < 3; row++)
+    for (col = 0; col < 4; col++)
+      {
+        if (graphene_matrix_get_value (a, row, col) != graphene_matrix_get_value (b, row, col))
+          return FALSE;
+      }
+
+  if (graphene_matrix_get_value (a, 3, 2) != graphene_matrix_get_value (b, 3, 2) ||
+      graphene_matrix_get_value (a, 3, 3) != graphene_matrix_get_value (b, 3, 3))
+    return FALSE;
+
+  ax = graphene_matrix_get_x_translation (a);
+  ay = graphene_matrix_get_y_translation (a);
+  bx = graphene_matrix_get_x_translation (b);
+  by = graphene_matrix_get_y_translation (b);
+
+  return ax - floorf (ax) == bx - floorf (bx) &&
+         ay - floorf (ay) == by - floorf (by);
+}
+
+void
+gsk_vulkan_layer_cache_init (GskVulkanLayerCache *self)
+{
+  self->layers = g_hash_table_new_full (NULL, NULL, NULL, cache_item_free);
+}
+
+void
+gsk_vulkan_layer_cache_free (GskVulkanLayerCache *self)
+{
+  g_clear_pointer (&self->layers, g_hash_table_unref);
+}
+
+void
+gsk_vulkan_layer_cache_begin_frame (GskVulkanLayerCache *self)
+{
+  GHashTableIter iter;
+  CacheItem *item;
+
+  g_hash_table_iter_init (&iter, self->layers);
+  while (g_hash_table_iter_next (&iter, NULL, (gpointer *) &item))
+    {
+      item->age ++;
+
+      if (item->age > MAX_LAYER_AGE)
+        g_hash_table_iter_remove (&iter);
+    }
+}
+
+/* Returns the image of the layer for @node, without adding a reference,
+ * or %NULL if it needs to be rendered */
+GskVulkanImage *
+gsk_vulkan_layer_cache_get_image (GskVulkanLayerCache     *self,
+                                  GskRenderNode           *node,
+                                  const graphene_matrix_t *mv)
+{
+  CacheItem *item;
+
+  g_assert (self != NULL);
+  g_assert (node != NULL);
+
+  item = g_hash_table_lookup (self->layers, node);
+  if (item == NULL)
+    return NULL;
+
+  /* The layer was drawn for a different transform, and the node is
+   * unlikely to be drawn with the old one again */
+  if (!same_pixels (&item->mv, mv))
+    {
+      g_hash_table_remove (self->layers, node);
+      return NULL;
+    }
+
+  item->age = 0;
+
+  return item->image;
+}
+
+void
+gsk_vulkan_layer_cache_commit (GskVulkanLayerCache     *self,
+                               GskRenderNode           *node,
+                               const graphene_matrix_t *mv,
+                               GskVulkanImage          *image)
+{
+  CacheItem *item;
+
+  g_assert (self != NULL);
+  g_assert (node != NULL);
+  g_assert (image != NULL);
+
+  item = g_slice_new0 (CacheItem);
+  item->node = gsk_render_node_ref (node);
+  item->mv = *mv;
+  item->image = g_object_ref (image);
+
+  g_hash_table_replace (self->layers, node, item);
+}
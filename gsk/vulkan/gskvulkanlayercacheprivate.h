@@ -0,0 +1,29 @@
+#ifndef __GSK_VULKAN_LAYER_CACHE_PRIVATE_H__
+#define __GSK_VULKAN_LAYER_CACHE_PRIVATE_H__
+
+#include <graphene.h>
+#include "gskvulkanimageprivate.h"
+#include "gskrendernode.h"
+
+G_BEGIN_DECLS
+
+typedef struct
+{
+  GHashTable *layers;
+} GskVulkanLayerCache;
+
+
+void             gsk_vulkan_layer_cache_init        (GskVulkanLayerCache     *self);
+void             gsk_vulkan_layer_cache_free        (GskVulkanLayerCache     *self);
+void             gsk_vulkan_layer_cache_begin_frame (GskVulkanLayerCache     *self);
+GskVulkanImage * gsk_vulkan_layer_cache_get_image   (GskVulkanLayerCache     *self,
+                                                     GskRenderNode           *node,
+                                                     const graphene_matrix_t *mv);
+void             gsk_vulkan_layer_cache_commit      (GskVulkanLayerCache     *self,
+                                                     GskRenderNode           *node,
+                                                     const graphene_matrix_t *mv,
+                                                     GskVulkanImage          *image);
+
+G_END_DECLS
+
+#endif /* __GSK_VULKAN_LAYER_CACHE_PRIVATE_H__ */
@@ -3,52 +3,311 @@
 #include "gskvulkanpipelineprivate.h"
 #include "gskvulkanmemoryprivate.h"
 
-struct _GskVulkanMemory
-{
-  GdkVulkanContext *vulkan;
+/* We don't allocate device memory for every buffer and image, as drivers
+ * limit the number of allocations (sometimes to as few as 4096) and each
+ * of them has considerable overhead. Instead, we allocate blocks of
+ * BLOCK_SIZE and hand out ranges of them. Allocations that would take up
+ * a big part of a block get a block of their own.
+ *
+ * Host visible blocks are mapped once and stay mapped for their lifetime,
+ * since a VkDeviceMemory may only be mapped once at a time.
+ */
+
+#define BLOCK_SIZE (16 * 1024 * 1024)
+#define DEDICATED_SIZE (BLOCK_SIZE / 2)
 
+typedef struct _GskVulkanAllocator GskVulkanAllocator;
+typedef struct _GskVulkanMemoryBlock GskVulkanMemoryBlock;
+
+typedef struct {
+  gsize offset;
   gsize size;
+} FreeRange;
+
+struct _GskVulkanMemoryBlock
+{
+  GskVulkanAllocator *allocator;
 
+  uint32_t memory_type;
   VkDeviceMemory vk_memory;
+  gsize size;
+  gsize used;
+  guchar *map;
+
+  /* sorted by offset */
+  GArray *free_ranges;
 };
 
-GskVulkanMemory *
-gsk_vulkan_memory_new (GdkVulkanContext      *context,
-                       uint32_t               allowed_types,
-                       VkMemoryPropertyFlags  flags,
-                       gsize                  size)
+struct _GskVulkanAllocator
 {
+  GdkVulkanContext *vulkan;
+
   VkPhysicalDeviceMemoryProperties properties;
-  GskVulkanMemory *self;
+  VkDeviceSize granularity;
+
+  GPtrArray *blocks[VK_MAX_MEMORY_TYPES];
+};
+
+struct _GskVulkanMemory
+{
+  GdkVulkanContext *vulkan;
+
+  GskVulkanMemoryBlock *block;
+  gsize offset;
+  gsize size;
+};
+
+static void
+gsk_vulkan_memory_block_free (gpointer data)
+{
+  GskVulkanMemoryBlock *block = data;
+  VkDevice device = gdk_vulkan_context_get_device (block->allocator->vulkan);
+
+  if (block->map)
+    vkUnmapMemory (device, block->vk_memory);
+
+  vkFreeMemory (device, block->vk_memory, NULL);
+
+  g_array_unref (block->free_ranges);
+  g_slice_free (GskVulkanMemoryBlock, block);
+}
+
+static void
+gsk_vulkan_allocator_free (gpointer data)
+{
+  GskVulkanAllocator *self = data;
   uint32_t i;
 
-  self = g_slice_new0 (GskVulkanMemory);
+  /* Only reached when gsk_vulkan_memory_release_unused() wasn't called.
+   * The device is gone by then, and its memory with it. */
+  for (i = 0; i < VK_MAX_MEMORY_TYPES; i++)
+    {
+      guint j;
 
-  self->vulkan = g_object_ref (context);
-  self->size = size;
+      for (j = 0; j < self->blocks[i]->len; j++)
+        {
+          GskVulkanMemoryBlock *block = g_ptr_array_index (self->blocks[i], j);
+
+          g_array_unref (block->free_ranges);
+          g_slice_free (GskVulkanMemoryBlock, block);
+        }
+
+      g_ptr_array_set_free_func (self->blocks[i], NULL);
+      g_ptr_array_unref (self->blocks[i]);
+    }
+
+  g_slice_free (GskVulkanAllocator, self);
+}
+
+static GskVulkanAllocator *
+gsk_vulkan_allocator_get (GdkVulkanContext *context)
+{
+  GskVulkanAllocator *self;
+  VkPhysicalDeviceProperties device_properties;
+  uint32_t i;
+
+  self = g_object_get_data (G_OBJECT (context), "gsk-vulkan-allocator");
+  if (self)
+    return self;
+
+  self = g_slice_new0 (GskVulkanAllocator);
+  self->vulkan = context;
 
   vkGetPhysicalDeviceMemoryProperties (gdk_vulkan_context_get_physical_device (context),
-                                       &properties);
+                                       &self->properties);
+  vkGetPhysicalDeviceProperties (gdk_vulkan_context_get_physical_device (context),
+                                 &device_properties);
+  /* Buffers, linear and optimal images share blocks, so keep them apart */
+  self->granularity = device_properties.limits.bufferImageGranularity;
 
-  for (i = 0; i < properties.memoryTypeCount; i++)
-    {
-      if (!(allowed_types & (1 << i)))
-        continue;
+  for (i = 0; i < VK_MAX_MEMORY_TYPES; i++)
+    self->blocks[i] = g_ptr_array_new_with_free_func (gsk_vulkan_memory_block_free);
 
-      if ((properties.memoryTypes[i].propertyFlags & flags) == flags)
-        break;
-  }
+  g_object_set_data_full (G_OBJECT (context), "gsk-vulkan-allocator",
+                          self, gsk_vulkan_allocator_free);
 
-  g_assert (i < properties.memoryTypeCount);
+  return self;
+}
+
+static GskVulkanMemoryBlock *
+gsk_vulkan_allocator_add_block (GskVulkanAllocator *self,
+                                uint32_t            memory_type,
+                                gsize               size)
+{
+  GskVulkanMemoryBlock *block;
+  FreeRange range = { 0, size };
 
-  GSK_VK_CHECK (vkAllocateMemory, gdk_vulkan_context_get_device (context),
+  block = g_slice_new0 (GskVulkanMemoryBlock);
+  block->allocator = self;
+  block->memory_type = memory_type;
+  block->size = size;
+  block->free_ranges = g_array_new (FALSE, FALSE, sizeof (FreeRange));
+  g_array_append_val (block->free_ranges, range);
+
+  GSK_VK_CHECK (vkAllocateMemory, gdk_vulkan_context_get_device (self->vulkan),
                                   &(VkMemoryAllocateInfo) {
                                       .sType = VK_STRUCTURE_TYPE_MEMORY_ALLOCATE_INFO,
                                       .allocationSize = size,
-                                      .memoryTypeIndex = i
+                                      .memoryTypeIndex = memory_type
                                   },
                                   NULL,
-                                  &self->vk_memory);
+                                  &block->vk_memory);
+
+  g_ptr_array_add (self->blocks[memory_type], block);
+
+  return block;
+}
+
+static gboolean
+gsk_vulkan_memory_block_alloc (GskVulkanMemoryBlock *block,
+                               gsize                 size,
+                               gsize                 alignment,
+                               gsize                *out_offset)
+{
+  guint i;
+
+  if (block->size - block->used < size)
+    return FALSE;
+
+  for (i = 0; i < block->free_ranges->len; i++)
+    {
+      FreeRange *range = &g_array_index (block->free_ranges, FreeRange, i);
+      gsize start = (range->offset + alignment - 1) / alignment * alignment;
+      gsize end = range->offset + range->size;
+      FreeRange tail;
+
+      if (start + size > end)
+        continue;
+
+      tail.offset = start + size;
+      tail.size = end - tail.offset;
+
+      if (start > range->offset)
+        {
+          /* keep the padding in front free */
+          range->size = start - range->offset;
+          if (tail.size > 0)
+            g_array_insert_val (block->free_ranges, i + 1, tail);
+        }
+      else if (tail.size > 0)
+        {
+          *range = tail;
+        }
+      else
+        {
+          g_array_remove_index (block->free_ranges, i);
+        }
+
+      block->used += size;
+      *out_offset = start;
+      return TRUE;
+    }
+
+  return FALSE;
+}
+
+static void
+gsk_vulkan_memory_block_release (GskVulkanMemoryBlock *block,
+                                 gsize                 offset,
+                                 gsize                 size)
+{
+  FreeRange range = { offset, size };
+  FreeRange *prev, *next;
+  guint i;
+
+  for (i = 0; i < block->free_ranges->len; i++)
+    {
+      if (g_array_index (block->free_ranges, FreeRange, i).offset > offset)
+        break;
+    }
+
+  g_array_insert_val (block->free_ranges, i, range);
+
+  /* merge with the following range */
+  if (i + 1 < block->free_ranges->len)
+    {
+      FreeRange *cur = &g_array_index (block->free_ranges, FreeRange, i);
+
+      next = &g_array_index (block->free_ranges, FreeRange, i + 1);
+      if (cur->offset + cur->size == next->offset)
+        {
+          cur->size += next->size;
+          g_array_remove_index (block->free_ranges, i + 1);
+        }
+    }
+
+  /* merge with the preceding range */
+  if (i > 0)
+    {
+      FreeRange *cur = &g_array_index (block->free_ranges, FreeRange, i);
+
+      prev = &g_array_index (block->free_ranges, FreeRange, i - 1);
+      if (prev->offset + prev->size == cur->offset)
+        {
+          prev->size += cur->size;
+          g_array_remove_index (block->free_ranges, i);
+        }
+    }
+
+  block->used -= size;
+}
+
+GskVulkanMemory *
+gsk_vulkan_memory_new (GdkVulkanContext           *context,
+                       const VkMemoryRequirements *requirements,
+                       VkMemoryPropertyFlags       flags)
+{
+  GskVulkanAllocator *allocator;
+  GskVulkanMemoryBlock *block;
+  GskVulkanMemory *self;
+  gsize alignment;
+  uint32_t i, j;
+
+  allocator = gsk_vulkan_allocator_get (context);
+
+  for (i = 0; i < allocator->properties.memoryTypeCount; i++)
+    {
+      if (!(requirements->memoryTypeBits & (1 << i)))
+        continue;
+
+      if ((allocator->properties.memoryTypes[i].propertyFlags & flags) == flags)
+        break;
+  }
+
+  g_assert (i < allocator->properties.memoryTypeCount);
+
+  self = g_slice_new0 (GskVulkanMemory);
+
+  self->vulkan = g_object_ref (context);
+  self->size = requirements->size;
+
+  alignment = MAX (requirements->alignment, allocator->granularity);
+  alignment = MAX (alignment, 1);
+
+  if (requirements->size >= DEDICATED_SIZE)
+    {
+      block = gsk_vulkan_allocator_add_block (allocator, i, requirements->size);
+      gsk_vulkan_memory_block_alloc (block, requirements->size, 1, &self->offset);
+      self->block = block;
+
+      return self;
+    }
+
+  for (j = 0; j < allocator->blocks[i]->len; j++)
+    {
+      block = g_ptr_array_index (allocator->blocks[i], j);
+
+      if (gsk_vulkan_memory_block_alloc (block, requirements->size, alignment, &self->offset))
+        {
+          self->block = block;
+          return self;
+        }
+    }
+
+  block = gsk_vulkan_allocator_add_block (allocator, i, BLOCK_SIZE);
+  if (!gsk_vulkan_memory_block_alloc (block, requirements->size, alignment, &self->offset))
+    g_assert_not_reached ();
+  self->block = block;
 
   return self;
 }
@@ -56,40 +315,91 @@ gsk_vulkan_memory_new (GdkVulkanContext      *context,
 void
 gsk_vulkan_memory_free (GskVulkanMemory *self)
 {
-  vkFreeMemory (gdk_vulkan_context_get_device (self->vulkan),
-                self->vk_memory,
-                NULL);
+  GskVulkanMemoryBlock *block = self->block;
+  GPtrArray *blocks = block->allocator->blocks[block->memory_type];
+
+  gsk_vulkan_memory_block_release (block, self->offset, self->size);
+
+  /* Keep one empty block around, so we don't allocate and free
+   * device memory over and over again */
+  if (block->used == 0 &&
+      (block->size != BLOCK_SIZE || blocks->len > 1))
+    g_ptr_array_remove_fast (blocks, block);
 
   g_object_unref (self->vulkan);
 
   g_slice_free (GskVulkanMemory, self);
 }
 
+/**
+ * gsk_vulkan_memory_release_unused:
+ * @context: a #GdkVulkanContext
+ *
+ * Frees the blocks of device memory that were kept around for future
+ * allocations. This must be called while the device is still alive,
+ * and once all memory allocated from @context has been freed.
+ */
+void
+gsk_vulkan_memory_release_unused (GdkVulkanContext *context)
+{
+  GskVulkanAllocator *self;
+  uint32_t i;
+
+  self = g_object_get_data (G_OBJECT (context), "gsk-vulkan-allocator");
+  if (self == NULL)
+    return;
+
+  for (i = 0; i < VK_MAX_MEMORY_TYPES; i++)
+    {
+      guint j = 0;
+
+      while (j < self->blocks[i]->len)
+        {
+          GskVulkanMemoryBlock *block = g_ptr_array_index (self->blocks[i], j);
+
+          if (block->used == 0)
+            g_ptr_array_remove_index_fast (self->blocks[i], j);
+          else
+            j++;
+        }
+    }
+}
+
 VkDeviceMemory
 gsk_vulkan_memory_get_device_memory (GskVulkanMemory *self)
 {
-  return self->vk_memory;
+  return self->block->vk_memory;
+}
+
+gsize
+gsk_vulkan_memory_get_offset (GskVulkanMemory *self)
+{
+  return self->offset;
 }
 
 guchar *
 gsk_vulkan_memory_map (GskVulkanMemory *self)
 {
-  void *data;
+  GskVulkanMemoryBlock *block = self->block;
 
-  GSK_VK_CHECK (vkMapMemory, gdk_vulkan_context_get_device (self->vulkan),
-                             self->vk_memory,
-                             0,
-                             self->size,
-                             0,
-                             &data);
+  if (block->map == NULL)
+    {
+      void *data;
+
+      GSK_VK_CHECK (vkMapMemory, gdk_vulkan_context_get_device (self->vulkan),
+                                 block->vk_memory,
+                                 0,
+                                 block->size,
+                                 0,
+                                 &data);
+      block->map = data;
+    }
 
-  return data;
+  return block->map + self->offset;
 }
 
 void
 gsk_vulkan_memory_unmap (GskVulkanMemory *self)
 {
-  vkUnmapMemory (gdk_vulkan_context_get_device (self->vulkan),
-                 self->vk_memory);
+  /* Blocks stay mapped until they are freed */
 }
-
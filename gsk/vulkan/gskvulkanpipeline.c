@@ -5,7 +5,10 @@
 #include "gskvulkanpushconstantsprivate.h"
 #include "gskvulkanshaderprivate.h"
 
+#include "gskdiskcacheprivate.h"
+
 #include <graphene.h>
+#include <string.h>
 
 typedef struct _GskVulkanPipelinePrivate GskVulkanPipelinePrivate;
 
@@ -24,6 +27,151 @@ struct _GskVulkanPipelinePrivate
 
 G_DEFINE_TYPE_WITH_PRIVATE (GskVulkanPipeline, gsk_vulkan_pipeline, G_TYPE_OBJECT)
 
+/* Pipelines are created with a VkPipelineCache per context, which gets
+ * loaded from and written to disk, so we don't have to wait for the driver
+ * to compile all our shaders on every startup. The cache is keyed by the
+ * device and driver version; the driver also refuses data it can't use.
+ */
+
+typedef struct
+{
+  VkPipelineCache vk_cache;
+  char *key;
+  gsize loaded_size;
+} GskVulkanPipelineCache;
+
+/* The header all drivers put in front of VkPipelineCache data */
+typedef struct
+{
+  uint32_t length;
+  uint32_t version;
+  uint32_t vendor_id;
+  uint32_t device_id;
+  uint8_t uuid[VK_UUID_SIZE];
+} PipelineCacheHeader;
+
+static void
+gsk_vulkan_pipeline_cache_free (gpointer data)
+{
+  GskVulkanPipelineCache *cache = data;
+
+  /* Only reached when gsk_vulkan_pipeline_cache_save() wasn't called,
+   * by then the device and the VkPipelineCache are gone already */
+  g_free (cache->key);
+  g_slice_free (GskVulkanPipelineCache, cache);
+}
+
+static gboolean
+pipeline_cache_data_is_valid (GBytes                           *bytes,
+                              const VkPhysicalDeviceProperties *props)
+{
+  PipelineCacheHeader header;
+  gsize size;
+  const guchar *data;
+
+  data = g_bytes_get_data (bytes, &size);
+  if (size < sizeof (PipelineCacheHeader))
+    return FALSE;
+
+  memcpy (&header, data, sizeof (PipelineCacheHeader));
+
+  return header.version == VK_PIPELINE_CACHE_HEADER_VERSION_ONE &&
+         header.vendor_id == props->vendorID &&
+         header.device_id == props->deviceID &&
+         memcmp (header.uuid, props->pipelineCacheUUID, VK_UUID_SIZE) == 0;
+}
+
+static VkPipelineCache
+gsk_vulkan_pipeline_get_cache (GdkVulkanContext *context)
+{
+  GskVulkanPipelineCache *cache;
+  VkPhysicalDeviceProperties props;
+  GBytes *bytes;
+  char *uuid;
+
+  cache = g_object_get_data (G_OBJECT (context), "gsk-vulkan-pipeline-cache");
+  if (cache)
+    return cache->vk_cache;
+
+  cache = g_slice_new0 (GskVulkanPipelineCache);
+
+  vkGetPhysicalDeviceProperties (gdk_vulkan_context_get_physical_device (context), &props);
+  uuid = g_strdup_printf ("%02x%02x%02x%02x%02x%02x%02x%02x%02x%02x%02x%02x%02x%02x%02x%02x",
+                          props.pipelineCacheUUID[0], props.pipelineCacheUUID[1],
+                          props.pipelineCacheUUID[2], props.pipelineCacheUUID[3],
+                          props.pipelineCacheUUID[4], props.pipelineCacheUUID[5],
+                          props.pipelineCacheUUID[6], props.pipelineCacheUUID[7],
+                          props.pipelineCacheUUID[8], props.pipelineCacheUUID[9],
+                          props.pipelineCacheUUID[10], props.pipelineCacheUUID[11],
+                          props.pipelineCacheUUID[12], props.pipelineCacheUUID[13],
+                          props.pipelineCacheUUID[14], props.pipelineCacheUUID[15]);
+  cache->key = g_strdup_printf ("%04x:%04x:%u:%s",
+                                props.vendorID, props.deviceID, props.driverVersion, uuid);
+  g_free (uuid);
+
+  bytes = gsk_disk_cache_load ("vulkan", cache->key);
+  if (bytes && !pipeline_cache_data_is_valid (bytes, &props))
+    {
+      GSK_NOTE (VULKAN, g_message ("Ignoring incompatible pipeline cache"));
+      g_clear_pointer (&bytes, g_bytes_unref);
+    }
+  cache->loaded_size = bytes ? g_bytes_get_size (bytes) : 0;
+
+  GSK_VK_CHECK (vkCreatePipelineCache, gdk_vulkan_context_get_device (context),
+                                       &(VkPipelineCacheCreateInfo) {
+                                           .sType = VK_STRUCTURE_TYPE_PIPELINE_CACHE_CREATE_INFO,
+                                           .initialDataSize = bytes ? g_bytes_get_size (bytes) : 0,
+                                           .pInitialData = bytes ? g_bytes_get_data (bytes, NULL) : NULL
+                                       },
+                                       NULL,
+                                       &cache->vk_cache);
+
+  g_clear_pointer (&bytes, g_bytes_unref);
+
+  g_object_set_data_full (G_OBJECT (context), "gsk-vulkan-pipeline-cache",
+                          cache, gsk_vulkan_pipeline_cache_free);
+
+  return cache->vk_cache;
+}
+
+/**
+ * gsk_vulkan_pipeline_cache_save:
+ * @context: a #GdkVulkanContext
+ *
+ * Writes the pipeline cache of @context to disk if pipelines were added
+ * to it, and frees it. This must be called while the device is still
+ * alive, i.e. before the last reference to @context is dropped.
+ */
+void
+gsk_vulkan_pipeline_cache_save (GdkVulkanContext *context)
+{
+  GskVulkanPipelineCache *cache;
+  VkDevice device;
+  size_t size = 0;
+  guchar *data;
+
+  cache = g_object_steal_data (G_OBJECT (context), "gsk-vulkan-pipeline-cache");
+  if (cache == NULL)
+    return;
+
+  device = gdk_vulkan_context_get_device (context);
+
+  /* Pipelines only get added to the cache, so if the size didn't
+   * change, there's nothing new to write */
+  if (vkGetPipelineCacheData (device, cache->vk_cache, &size, NULL) == VK_SUCCESS &&
+      size > 0 && size != cache->loaded_size)
+    {
+      data = g_malloc (size);
+      if (GSK_VK_CHECK (vkGetPipelineCacheData, device, cache->vk_cache, &size, data) == VK_SUCCESS)
+        gsk_disk_cache_save ("vulkan", cache->key, data, size);
+      g_free (data);
+    }
+
+  vkDestroyPipelineCache (device, cache->vk_cache, NULL);
+
+  gsk_vulkan_pipeline_cache_free (cache);
+}
+
 static void
 gsk_vulkan_pipeline_finalize (GObject *gobject)
 {
@@ -96,7 +244,7 @@ gsk_vulkan_pipeline_new_full (GType                    pipeline_type,
   priv->fragment_shader = gsk_vulkan_shader_new_from_resource (context, GSK_VULKAN_SHADER_FRAGMENT, shader_name, NULL);
 
   GSK_VK_CHECK (vkCreateGraphicsPipelines, device,
-                                           VK_NULL_HANDLE,
+                                           gsk_vulkan_pipeline_get_cache (context),
                                            1,
                                            &(VkGraphicsPipelineCreateInfo) {
                                                .sType = VK_STRUCTURE_TYPE_GRAPHICS_PIPELINE_CREATE_INFO,
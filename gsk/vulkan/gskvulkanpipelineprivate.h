@@ -45,6 +45,8 @@ GskVulkanPipeline *     gsk_vulkan_pipeline_new_full                    (GType
                                                                          VkBlendFactor                   srcBlendFactor,
                                                                          VkBlendFactor                   dstBlendFactor);
 
+void                    gsk_vulkan_pipeline_cache_save                  (GdkVulkanContext               *context);
+
 VkPipeline              gsk_vulkan_pipeline_get_pipeline                (GskVulkanPipeline              *self);
 VkPipelineLayout        gsk_vulkan_pipeline_get_pipeline_layout         (GskVulkanPipeline              *self);
 
@@ -0,0 +1,212 @@
+#include "config.h"
+
+#include "gskvulkanprofilerprivate.h"
+#include "gskvulkanpipelineprivate.h"
+
+/* Measures the GPU time of a frame with timestamp queries, the Vulkan
+ * counterpart of GskGLProfiler.
+ *
+ * A frame is split into regions - one per render pass - that get a
+ * timestamp written before and after them. The results are read back
+ * with gsk_vulkan_profiler_collect() once the frame's fence has been
+ * signaled, so getting them never stalls the CPU.
+ */
+
+#define INITIAL_N_REGIONS 16
+
+struct _GskVulkanProfiler
+{
+  GdkVulkanContext *vulkan;
+
+  VkQueryPool query_pool;
+  guint n_allocated_regions;
+
+  /* Regions recorded since the last begin_frame() */
+  guint n_regions;
+  /* Times of the regions fetched by the last collect(), in nanoseconds */
+  GArray *region_times;
+
+  float timestamp_period;
+  guint64 timestamp_mask;
+  gboolean pending : 1;
+};
+
+static void
+gsk_vulkan_profiler_create_query_pool (GskVulkanProfiler *self,
+                                       guint              n_regions)
+{
+  VkDevice device = gdk_vulkan_context_get_device (self->vulkan);
+
+  if (self->query_pool != VK_NULL_HANDLE)
+    vkDestroyQueryPool (device, self->query_pool, NULL);
+
+  GSK_VK_CHECK (vkCreateQueryPool, device,
+                                   &(VkQueryPoolCreateInfo) {
+                                       .sType = VK_STRUCTURE_TYPE_QUERY_POOL_CREATE_INFO,
+                                       .queryType = VK_QUERY_TYPE_TIMESTAMP,
+                                       .queryCount = 2 * n_regions,
+                                   },
+                                   NULL,
+                                   &self->query_pool);
+
+  self->n_allocated_regions = n_regions;
+}
+
+GskVulkanProfiler *
+gsk_vulkan_profiler_new (GdkVulkanContext *context)
+{
+  GskVulkanProfiler *self;
+  VkPhysicalDevice physical_device;
+  VkPhysicalDeviceProperties properties;
+  VkQueueFamilyProperties *queue_families;
+  uint32_t n_queue_families, valid_bits;
+  uint32_t queue_family_index;
+
+  self = g_slice_new0 (GskVulkanProfiler);
+
+  self->vulkan = g_object_ref (context);
+  self->region_times = g_array_new (FALSE, FALSE, sizeof (gint64));
+
+  physical_device = gdk_vulkan_context_get_physical_device (context);
+  vkGetPhysicalDeviceProperties (physical_device, &properties);
+  self->timestamp_period = properties.limits.timestampPeriod;
+
+  queue_family_index = gdk_vulkan_context_get_queue_family_index (context);
+  vkGetPhysicalDeviceQueueFamilyProperties (physical_device, &n_queue_families, NULL);
+  queue_families = g_newa (VkQueueFamilyProperties, n_queue_families);
+  vkGetPhysicalDeviceQueueFamilyProperties (physical_device, &n_queue_families, queue_families);
+  valid_bits = queue_family_index < n_queue_families ? queue_families[queue_family_index].timestampValidBits : 0;
+
+  /* A queue without valid bits does not support timestamps at all */
+  if (valid_bits == 0 || self->timestamp_period <= 0)
+    return self;
+
+  self->timestamp_mask = valid_bits >= 64 ? G_MAXUINT64 : (G_GUINT64_CONSTANT (1) << valid_bits) - 1;
+
+  gsk_vulkan_profiler_create_query_pool (self, INITIAL_N_REGIONS);
+
+  return self;
+}
+
+void
+gsk_vulkan_profiler_free (GskVulkanProfiler *self)
+{
+  if (self->query_pool != VK_NULL_HANDLE)
+    vkDestroyQueryPool (gdk_vulkan_context_get_device (self->vulkan),
+                        self->query_pool,
+                        NULL);
+
+  g_array_unref (self->region_times);
+  g_object_unref (self->vulkan);
+
+  g_slice_free (GskVulkanProfiler, self);
+}
+
+gboolean
+gsk_vulkan_profiler_is_supported (GskVulkanProfiler *self)
+{
+  return self->query_pool != VK_NULL_HANDLE;
+}
+
+/* Must be recorded outside of a render pass, before any region of the
+ * frame. The GPU must be done with the previous frame. */
+void
+gsk_vulkan_profiler_begin_frame (GskVulkanProfiler *self,
+                                 VkCommandBuffer    command_buffer,
+                                 guint              n_regions)
+{
+  self->n_regions = 0;
+  self->pending = FALSE;
+
+  if (!gsk_vulkan_profiler_is_supported (self) || n_regions == 0)
+    return;
+
+  if (n_regions > self->n_allocated_regions)
+    gsk_vulkan_profiler_create_query_pool (self, MAX (n_regions, 2 * self->n_allocated_regions));
+
+  vkCmdResetQueryPool (command_buffer, self->query_pool, 0, 2 * n_regions);
+
+  self->n_regions = n_regions;
+  self->pending = TRUE;
+}
+
+void
+gsk_vulkan_profiler_begin_region (GskVulkanProfiler *self,
+                                  VkCommandBuffer    command_buffer,
+                                  guint              region)
+{
+  if (region >= self->n_regions)
+    return;
+
+  vkCmdWriteTimestamp (command_buffer,
+                       VK_PIPELINE_STAGE_TOP_OF_PIPE_BIT,
+                       self->query_pool,
+                       2 * region);
+}
+
+void
+gsk_vulkan_profiler_end_region (GskVulkanProfiler *self,
+                                VkCommandBuffer    command_buffer,
+                                guint              region)
+{
+  if (region >= self->n_regions)
+    return;
+
+  vkCmdWriteTimestamp (command_buffer,
+                       VK_PIPELINE_STAGE_BOTTOM_OF_PIPE_BIT,
+                       self->query_pool,
+                       2 * region + 1);
+}
+
+/* Fetches the results of the last frame and returns %TRUE if there
+ * were any. Only call this once the frame's fence has been signaled. */
+gboolean
+gsk_vulkan_profiler_collect (GskVulkanProfiler *self)
+{
+  guint64 *timestamps;
+  VkResult res;
+  guint i;
+
+  g_array_set_size (self->region_times, 0);
+
+  if (!self->pending)
+    return FALSE;
+
+  self->pending = FALSE;
+
+  timestamps = g_newa (guint64, 2 * self->n_regions);
+  res = vkGetQueryPoolResults (gdk_vulkan_context_get_device (self->vulkan),
+                               self->query_pool,
+                               0, 2 * self->n_regions,
+                               sizeof (guint64) * 2 * self->n_regions,
+                               timestamps,
+                               sizeof (guint64),
+                               VK_QUERY_RESULT_64_BIT);
+  if (res != VK_SUCCESS)
+    return FALSE;
+
+  for (i = 0; i < self->n_regions; i++)
+    {
+      guint64 ticks = (timestamps[2 * i + 1] - timestamps[2 * i]) & self->timestamp_mask;
+      gint64 time = ticks * self->timestamp_period;
+
+      g_array_append_val (self->region_times, time);
+    }
+
+  return TRUE;
+}
+
+guint
+gsk_vulkan_profiler_get_n_regions (GskVulkanProfiler *self)
+{
+  return self->region_times->len;
+}
+
+gint64
+gsk_vulkan_profiler_get_region_time (GskVulkanProfiler *self,
+                                     guint              region)
+{
+  g_return_val_if_fail (region < self->region_times->len, 0);
+
+  return g_array_index (self->region_times, gint64, region);
+}
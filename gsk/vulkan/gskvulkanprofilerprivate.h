@@ -0,0 +1,32 @@
+#ifndef __GSK_VULKAN_PROFILER_PRIVATE_H__
+#define __GSK_VULKAN_PROFILER_PRIVATE_H__
+
+#include <gdk/gdk.h>
+
+G_BEGIN_DECLS
+
+typedef struct _GskVulkanProfiler GskVulkanProfiler;
+
+GskVulkanProfiler *     gsk_vulkan_profiler_new                         (GdkVulkanContext       *context);
+void                    gsk_vulkan_profiler_free                        (GskVulkanProfiler      *self);
+
+gboolean                gsk_vulkan_profiler_is_supported                (GskVulkanProfiler      *self);
+
+void                    gsk_vulkan_profiler_begin_frame                 (GskVulkanProfiler      *self,
+                                                                         VkCommandBuffer         command_buffer,
+                                                                         guint                   n_regions);
+void                    gsk_vulkan_profiler_begin_region                (GskVulkanProfiler      *self,
+                                                                         VkCommandBuffer         command_buffer,
+                                                                         guint                   region);
+void                    gsk_vulkan_profiler_end_region                  (GskVulkanProfiler      *self,
+                                                                         VkCommandBuffer         command_buffer,
+                                                                         guint                   region);
+
+gboolean                gsk_vulkan_profiler_collect                     (GskVulkanProfiler      *self);
+guint                   gsk_vulkan_profiler_get_n_regions               (GskVulkanProfiler      *self);
+gint64                  gsk_vulkan_profiler_get_region_time             (GskVulkanProfiler      *self,
+                                                                         guint                   region);
+
+G_END_DECLS
+
+#endif /* __GSK_VULKAN_PROFILER_PRIVATE_H__ */
@@ -8,6 +8,7 @@
 #include "gskvulkanbufferprivate.h"
 #include "gskvulkancommandpoolprivate.h"
 #include "gskvulkanpipelineprivate.h"
+#include "gskvulkanprofilerprivate.h"
 #include "gskvulkanrenderpassprivate.h"
 
 #include "gskvulkanblendmodepipelineprivate.h"
@@ -26,6 +27,9 @@
 #define DESCRIPTOR_POOL_MAXSETS 128
 #define DESCRIPTOR_POOL_MAXSETS_INCREASE 128
 
+#define VERTEX_BUFFER_MIN_SIZE (64 * 1024)
+#define VERTEX_DATA_ALIGNMENT 16
+
 struct _GskVulkanRender
 {
   GskRenderer *renderer;
@@ -38,16 +42,22 @@ struct _GskVulkanRender
   GHashTable *framebuffers;
   GskVulkanCommandPool *command_pool;
   VkFence fence;
+  GskVulkanProfiler *gpu_profiler;
   VkRenderPass render_pass;
   VkDescriptorSetLayout descriptor_set_layout;
   VkPipelineLayout pipeline_layout[3]; /* indexed by number of textures */
   GskVulkanUploader *uploader;
 
   GHashTable *descriptor_set_indexes;
+  /* Descriptor sets are kept across frames, until their image is destroyed */
+  GHashTable *descriptor_set_cache;
   VkDescriptorPool descriptor_pool;
   uint32_t descriptor_pool_maxsets;
   VkDescriptorSet *descriptor_sets;
   gsize n_descriptor_sets;
+  /* Pipelines are created on first use, which may happen on any of the
+   * threads adding ops */
+  GMutex pipeline_lock;
   GskVulkanPipeline *pipelines[GSK_VULKAN_N_PIPELINES];
 
   GskVulkanImage *target;
@@ -58,8 +68,17 @@ struct _GskVulkanRender
   GList *render_passes;
   GSList *cleanup_images;
 
+  /* Vertex data of all render passes of a frame is packed into this buffer.
+   * It is only reused once our fence says the GPU is done with it. */
+  GskVulkanBuffer *vertex_buffer;
+  gsize vertex_buffer_size;
+  gsize vertex_buffer_used;
+  GSList *cleanup_buffers;
+
   GQuark render_pass_counter;
+  GQuark upload_bytes_counter;
   GQuark gpu_time_timer;
+  GQuark offscreen_gpu_time_timer;
 };
 
 static void
@@ -106,6 +125,26 @@ gsk_vulkan_render_setup (GskVulkanRender       *self,
 static guint desc_set_index_hash (gconstpointer v);
 static gboolean desc_set_index_equal (gconstpointer v1, gconstpointer v2);
 
+static void
+gsk_vulkan_render_create_descriptor_pool (GskVulkanRender *self)
+{
+  GSK_VK_CHECK (vkCreateDescriptorPool, gdk_vulkan_context_get_device (self->vulkan),
+                                        &(VkDescriptorPoolCreateInfo) {
+                                            .sType = VK_STRUCTURE_TYPE_DESCRIPTOR_POOL_CREATE_INFO,
+                                            .flags = VK_DESCRIPTOR_POOL_CREATE_FREE_DESCRIPTOR_SET_BIT,
+                                            .maxSets = self->descriptor_pool_maxsets,
+                                            .poolSizeCount = 1,
+                                            .pPoolSizes = (VkDescriptorPoolSize[1]) {
+                                                {
+                                                    .type = VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER,
+                                                    .descriptorCount = self->descriptor_pool_maxsets
+                                                }
+                                            }
+                                        },
+                                        NULL,
+                                        &self->descriptor_pool);
+}
+
 GskVulkanRender *
 gsk_vulkan_render_new (GskRenderer      *renderer,
                        GdkVulkanContext *context)
@@ -119,6 +158,8 @@ gsk_vulkan_render_new (GskRenderer      *renderer,
   self->renderer = renderer;
   self->framebuffers = g_hash_table_new (g_direct_hash, g_direct_equal);
   self->descriptor_set_indexes = g_hash_table_new_full (desc_set_index_hash, desc_set_index_equal, NULL, g_free);
+  self->descriptor_set_cache = g_hash_table_new_full (desc_set_index_hash, desc_set_index_equal, NULL, g_free);
+  g_mutex_init (&self->pipeline_lock);
 
   device = gdk_vulkan_context_get_device (self->vulkan);
 
@@ -132,20 +173,7 @@ gsk_vulkan_render_new (GskRenderer      *renderer,
                                &self->fence);
 
   self->descriptor_pool_maxsets = DESCRIPTOR_POOL_MAXSETS;
-  GSK_VK_CHECK (vkCreateDescriptorPool, device,
-                                        &(VkDescriptorPoolCreateInfo) {
-                                            .sType = VK_STRUCTURE_TYPE_DESCRIPTOR_POOL_CREATE_INFO,
-                                            .maxSets = self->descriptor_pool_maxsets,
-                                            .poolSizeCount = 1,
-                                            .pPoolSizes = (VkDescriptorPoolSize[1]) {
-                                                {
-                                                    .type = VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER,
-                                                    .descriptorCount = self->descriptor_pool_maxsets
-                                                }
-                                            }
-                                        },
-                                        NULL,
-                                        &self->descriptor_pool);
+  gsk_vulkan_render_create_descriptor_pool (self);
 
   GSK_VK_CHECK (vkCreateRenderPass, gdk_vulkan_context_get_device (self->vulkan),
                                     &(VkRenderPassCreateInfo) {
@@ -254,11 +282,12 @@ gsk_vulkan_render_new (GskRenderer      *renderer,
                                  &self->repeating_sampler);
 
   self->uploader = gsk_vulkan_uploader_new (self->vulkan, self->command_pool);
+  self->gpu_profiler = gsk_vulkan_profiler_new (self->vulkan);
 
-#ifdef G_ENABLE_DEBUG
   self->render_pass_counter = g_quark_from_static_string ("render-passes");
+  self->upload_bytes_counter = g_quark_from_static_string ("upload-bytes");
   self->gpu_time_timer = g_quark_from_static_string ("gpu-time");
-#endif
+  self->offscreen_gpu_time_timer = g_quark_from_static_string ("offscreen-gpu-time");
 
   return self;
 }
@@ -328,9 +357,7 @@ gsk_vulkan_render_add_render_pass (GskVulkanRender     *self,
 {
   self->render_passes = g_list_prepend (self->render_passes, pass);
 
-#ifdef G_ENABLE_DEBUG
   gsk_profiler_counter_inc (gsk_renderer_get_profiler (self->renderer), self->render_pass_counter);
-#endif
 }
 
 void
@@ -371,6 +398,10 @@ gsk_vulkan_render_upload (GskVulkanRender *self)
     }
 
   gsk_vulkan_uploader_upload (self->uploader);
+
+  gsk_profiler_counter_add (gsk_renderer_get_profiler (self->renderer),
+                            self->upload_bytes_counter,
+                            gsk_vulkan_uploader_get_upload_bytes (self->uploader));
 }
 
 GskVulkanPipeline *
@@ -422,11 +453,13 @@ gsk_vulkan_render_get_pipeline (GskVulkanRender       *self,
 
   g_return_val_if_fail (type < GSK_VULKAN_N_PIPELINES, NULL);
 
+  g_mutex_lock (&self->pipeline_lock);
   if (self->pipelines[type] == NULL)
     self->pipelines[type] = pipeline_info[type].create_func (self->vulkan,
                                                              self->pipeline_layout[pipeline_info[type].num_textures],
                                                              pipeline_info[type].name,
                                                              self->render_pass);
+  g_mutex_unlock (&self->pipeline_lock);
 
   return self->pipelines[type];
 }
@@ -441,15 +474,25 @@ gsk_vulkan_render_get_descriptor_set (GskVulkanRender *self,
 }
 
 typedef struct {
-  gsize index;
   GskVulkanImage *image;
   gboolean repeat;
+} DescriptorSetKey;
+
+typedef struct {
+  DescriptorSetKey key;
+  gsize index;
 } HashDescriptorSetIndexEntry;
 
+typedef struct {
+  DescriptorSetKey key;
+  GskVulkanRender *render;
+  VkDescriptorSet descriptor_set;
+} CachedDescriptorSet;
+
 static guint
 desc_set_index_hash (gconstpointer v)
 {
-  const HashDescriptorSetIndexEntry *e = v;
+  const DescriptorSetKey *e = v;
 
   return GPOINTER_TO_UINT (e->image) + e->repeat;
 }
@@ -457,18 +500,88 @@ desc_set_index_hash (gconstpointer v)
 static gboolean
 desc_set_index_equal (gconstpointer v1, gconstpointer v2)
 {
-  const HashDescriptorSetIndexEntry *e1 = v1;
-  const HashDescriptorSetIndexEntry *e2 = v2;
+  const DescriptorSetKey *e1 = v1;
+  const DescriptorSetKey *e2 = v2;
 
   return e1->image == e2->image && e1->repeat == e2->repeat;
 }
 
+static void
+gsk_vulkan_render_remove_descriptor_set_from_image (gpointer  data,
+                                                    GObject  *image)
+{
+  CachedDescriptorSet *cached = data;
+  GskVulkanRender *self = cached->render;
+
+  GSK_VK_CHECK (vkFreeDescriptorSets, gdk_vulkan_context_get_device (self->vulkan),
+                                      self->descriptor_pool,
+                                      1,
+                                      &cached->descriptor_set);
+
+  g_hash_table_remove (self->descriptor_set_cache, cached);
+}
+
+static void
+gsk_vulkan_render_clear_descriptor_set_cache (GskVulkanRender *self)
+{
+  GHashTableIter iter;
+  gpointer key;
+
+  g_hash_table_iter_init (&iter, self->descriptor_set_cache);
+  while (g_hash_table_iter_next (&iter, &key, NULL))
+    {
+      CachedDescriptorSet *cached = key;
+
+      g_object_weak_unref (G_OBJECT (cached->key.image),
+                           gsk_vulkan_render_remove_descriptor_set_from_image,
+                           cached);
+      g_hash_table_iter_remove (&iter);
+    }
+}
+
+guchar *
+gsk_vulkan_render_alloc_vertex_data (GskVulkanRender  *self,
+                                     gsize             n_bytes,
+                                     GskVulkanBuffer **buffer,
+                                     gsize            *offset)
+{
+  gsize start;
+
+  start = (self->vertex_buffer_used + VERTEX_DATA_ALIGNMENT - 1) & ~(VERTEX_DATA_ALIGNMENT - 1);
+
+  if (self->vertex_buffer == NULL || start + n_bytes > self->vertex_buffer_size)
+    {
+      gsize size = MAX (self->vertex_buffer_size, VERTEX_BUFFER_MIN_SIZE);
+
+      while (size < n_bytes)
+        size *= 2;
+
+      /* Earlier passes of this frame may still use the old buffer */
+      if (self->vertex_buffer)
+        {
+          self->cleanup_buffers = g_slist_prepend (self->cleanup_buffers, self->vertex_buffer);
+          size *= 2;
+        }
+
+      self->vertex_buffer = gsk_vulkan_buffer_new (self->vulkan, size);
+      self->vertex_buffer_size = size;
+      start = 0;
+    }
+
+  self->vertex_buffer_used = start + n_bytes;
+
+  *buffer = self->vertex_buffer;
+  *offset = start;
+
+  return gsk_vulkan_buffer_map (self->vertex_buffer);
+}
+
 gsize
 gsk_vulkan_render_reserve_descriptor_set (GskVulkanRender *self,
                                           GskVulkanImage  *source,
                                           gboolean         repeat)
 {
-  HashDescriptorSetIndexEntry lookup;
+  DescriptorSetKey lookup;
   HashDescriptorSetIndexEntry *entry;
 
   g_assert (source != NULL);
@@ -481,8 +594,7 @@ gsk_vulkan_render_reserve_descriptor_set (GskVulkanRender *self,
     return entry->index;
 
   entry = g_new (HashDescriptorSetIndexEntry, 1);
-  entry->image = source;
-  entry->repeat = repeat;
+  entry->key = lookup;
   entry->index = g_hash_table_size (self->descriptor_set_indexes);
   g_hash_table_add (self->descriptor_set_indexes, entry);
 
@@ -496,7 +608,7 @@ gsk_vulkan_render_prepare_descriptor_sets (GskVulkanRender *self)
   gpointer key;
   VkDevice device;
   GList *l;
-  guint i, needed_sets;
+  guint needed_sets, missing_sets;
 
   device = gdk_vulkan_context_get_device (self->vulkan);
 
@@ -509,81 +621,85 @@ gsk_vulkan_render_prepare_descriptor_sets (GskVulkanRender *self)
   needed_sets = g_hash_table_size (self->descriptor_set_indexes);
   if (needed_sets > self->n_descriptor_sets)
     {
+      self->n_descriptor_sets = needed_sets;
+      self->descriptor_sets = g_renew (VkDescriptorSet, self->descriptor_sets, needed_sets);
+    }
+
+  missing_sets = 0;
+  g_hash_table_iter_init (&iter, self->descriptor_set_indexes);
+  while (g_hash_table_iter_next (&iter, &key, NULL))
+    {
+      if (!g_hash_table_contains (self->descriptor_set_cache, key))
+        missing_sets++;
+    }
+
+  if (g_hash_table_size (self->descriptor_set_cache) + missing_sets > self->descriptor_pool_maxsets)
+    {
+      /* The pool is full. Throw away all cached sets and start over with a
+       * bigger pool. Nothing uses them, we waited for our fence already. */
       if (needed_sets > self->descriptor_pool_maxsets)
         {
           guint added_sets = needed_sets - self->descriptor_pool_maxsets;
           added_sets = added_sets + DESCRIPTOR_POOL_MAXSETS_INCREASE - 1;
           added_sets -= added_sets % DESCRIPTOR_POOL_MAXSETS_INCREASE;
-
-          vkDestroyDescriptorPool (device,
-                                   self->descriptor_pool,
-                                   NULL);
           self->descriptor_pool_maxsets += added_sets;
-          GSK_VK_CHECK (vkCreateDescriptorPool, device,
-                                                &(VkDescriptorPoolCreateInfo) {
-                                                    .sType = VK_STRUCTURE_TYPE_DESCRIPTOR_POOL_CREATE_INFO,
-                                                    .maxSets = self->descriptor_pool_maxsets,
-                                                    .poolSizeCount = 1,
-                                                    .pPoolSizes = (VkDescriptorPoolSize[1]) {
-                                                        {
-                                                            .type = VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER,
-                                                            .descriptorCount = self->descriptor_pool_maxsets
-                                                        }
-                                                    }
-                                                },
-                                                NULL,
-                                                &self->descriptor_pool);
-        }
-      else
-        {
-          GSK_VK_CHECK (vkResetDescriptorPool, device,
-                                               self->descriptor_pool,
-                                               0);
         }
 
-      self->n_descriptor_sets = needed_sets;
-      self->descriptor_sets = g_renew (VkDescriptorSet, self->descriptor_sets, needed_sets);
+      gsk_vulkan_render_clear_descriptor_set_cache (self);
+      vkDestroyDescriptorPool (device,
+                               self->descriptor_pool,
+                               NULL);
+      gsk_vulkan_render_create_descriptor_pool (self);
     }
 
-  VkDescriptorSetLayout *layouts = g_newa (VkDescriptorSetLayout, needed_sets);
-  for (i = 0; i < needed_sets; i++)
-    layouts[i] = self->descriptor_set_layout;
-
-  GSK_VK_CHECK (vkAllocateDescriptorSets, device,
-                                          &(VkDescriptorSetAllocateInfo) {
-                                              .sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_ALLOCATE_INFO,
-                                              .descriptorPool = self->descriptor_pool,
-                                              .descriptorSetCount = needed_sets,
-                                              .pSetLayouts = layouts
-                                          },
-                                          self->descriptor_sets);
-
   g_hash_table_iter_init (&iter, self->descriptor_set_indexes);
   while (g_hash_table_iter_next (&iter, &key, NULL))
     {
       HashDescriptorSetIndexEntry *entry = key;
-      GskVulkanImage *image = entry->image;
-      gsize id = entry->index;
-      gboolean repeat = entry->repeat;
-
-      vkUpdateDescriptorSets (device,
-                              1,
-                              (VkWriteDescriptorSet[1]) {
-                                  {
-                                      .sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET,
-                                      .dstSet = self->descriptor_sets[id],
-                                      .dstBinding = 0,
-                                      .dstArrayElement = 0,
-                                      .descriptorCount = 1,
-                                      .descriptorType = VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER,
-                                      .pImageInfo = &(VkDescriptorImageInfo) {
-                                          .sampler = repeat ? self->repeating_sampler : self->sampler,
-                                          .imageView = gsk_vulkan_image_get_image_view (image),
-                                          .imageLayout = VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL
+      CachedDescriptorSet *cached;
+      GskVulkanImage *image = entry->key.image;
+      gboolean repeat = entry->key.repeat;
+
+      cached = g_hash_table_lookup (self->descriptor_set_cache, &entry->key);
+      if (cached == NULL)
+        {
+          cached = g_new (CachedDescriptorSet, 1);
+          cached->key = entry->key;
+          cached->render = self;
+
+          GSK_VK_CHECK (vkAllocateDescriptorSets, device,
+                                                  &(VkDescriptorSetAllocateInfo) {
+                                                      .sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_ALLOCATE_INFO,
+                                                      .descriptorPool = self->descriptor_pool,
+                                                      .descriptorSetCount = 1,
+                                                      .pSetLayouts = &self->descriptor_set_layout
+                                                  },
+                                                  &cached->descriptor_set);
+
+          vkUpdateDescriptorSets (device,
+                                  1,
+                                  (VkWriteDescriptorSet[1]) {
+                                      {
+                                          .sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET,
+                                          .dstSet = cached->descriptor_set,
+                                          .dstBinding = 0,
+                                          .dstArrayElement = 0,
+                                          .descriptorCount = 1,
+                                          .descriptorType = VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER,
+                                          .pImageInfo = &(VkDescriptorImageInfo) {
+                                              .sampler = repeat ? self->repeating_sampler : self->sampler,
+                                              .imageView = gsk_vulkan_image_get_image_view (image),
+                                              .imageLayout = VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL
+                                          }
                                       }
-                                  }
-                              },
-                              0, NULL);
+                                  },
+                                  0, NULL);
+
+          g_hash_table_add (self->descriptor_set_cache, cached);
+          g_object_weak_ref (G_OBJECT (image), gsk_vulkan_render_remove_descriptor_set_from_image, cached);
+        }
+
+      self->descriptor_sets[entry->index] = cached->descriptor_set;
     }
 }
 
@@ -591,15 +707,17 @@ void
 gsk_vulkan_render_draw (GskVulkanRender *self)
 {
   GList *l;
+  guint region;
 
 #ifdef G_ENABLE_DEBUG
-  if (GSK_RENDERER_DEBUG_CHECK (self->renderer, SYNC))
+  if (GSK_RENDERER_DEBUG_CHECK (self->renderer, SYNC) &&
+      !gsk_vulkan_profiler_is_supported (self->gpu_profiler))
     gsk_profiler_timer_begin (gsk_renderer_get_profiler (self->renderer), self->gpu_time_timer);
 #endif
 
   gsk_vulkan_render_prepare_descriptor_sets (self);
 
-  for (l = self->render_passes; l; l = l->next)
+  for (l = self->render_passes, region = 0; l; l = l->next, region++)
     {
       GskVulkanRenderPass *pass = l->data;
       VkCommandBuffer command_buffer;
@@ -613,7 +731,14 @@ gsk_vulkan_render_draw (GskVulkanRender *self)
 
       command_buffer = gsk_vulkan_command_pool_get_buffer (self->command_pool);
 
+      if (region == 0)
+        gsk_vulkan_profiler_begin_frame (self->gpu_profiler,
+                                         command_buffer,
+                                         g_list_length (self->render_passes));
+
+      gsk_vulkan_profiler_begin_region (self->gpu_profiler, command_buffer, region);
       gsk_vulkan_render_pass_draw (pass, self, 3, self->pipeline_layout, command_buffer);
+      gsk_vulkan_profiler_end_region (self->gpu_profiler, command_buffer, region);
 
       gsk_vulkan_command_pool_submit_buffer (self->command_pool,
                                              command_buffer,
@@ -625,7 +750,8 @@ gsk_vulkan_render_draw (GskVulkanRender *self)
     }
 
 #ifdef G_ENABLE_DEBUG
-  if (GSK_RENDERER_DEBUG_CHECK (self->renderer, SYNC))
+  if (GSK_RENDERER_DEBUG_CHECK (self->renderer, SYNC) &&
+      !gsk_vulkan_profiler_is_supported (self->gpu_profiler))
     {
       GskProfiler *profiler;
       gint64 gpu_time;
@@ -651,6 +777,36 @@ gsk_vulkan_render_download_target (GskVulkanRender *self)
   return gsk_vulkan_image_download (self->target, self->uploader);
 }
 
+/* Reports the GPU times of the last frame drawn by this render. With
+ * several renders in flight, that is not the frame being drawn now. */
+static void
+gsk_vulkan_render_collect_gpu_times (GskVulkanRender *self)
+{
+  GskProfiler *profiler;
+  gint64 gpu_time, offscreen_gpu_time;
+  guint i, n_regions;
+
+  if (!gsk_vulkan_profiler_collect (self->gpu_profiler))
+    return;
+
+  /* The last render pass draws to the target, all others are offscreens */
+  n_regions = gsk_vulkan_profiler_get_n_regions (self->gpu_profiler);
+  gpu_time = 0;
+  offscreen_gpu_time = 0;
+  for (i = 0; i < n_regions; i++)
+    {
+      gint64 region_time = gsk_vulkan_profiler_get_region_time (self->gpu_profiler, i);
+
+      gpu_time += region_time;
+      if (i + 1 < n_regions)
+        offscreen_gpu_time += region_time;
+    }
+
+  profiler = gsk_renderer_get_profiler (self->renderer);
+  gsk_profiler_timer_set (profiler, self->gpu_time_timer, gpu_time);
+  gsk_profiler_timer_set (profiler, self->offscreen_gpu_time_timer, offscreen_gpu_time);
+}
+
 static void
 gsk_vulkan_render_cleanup (GskVulkanRender *self)
 {
@@ -667,19 +823,21 @@ gsk_vulkan_render_cleanup (GskVulkanRender *self)
                                1,
                                &self->fence);
 
+  gsk_vulkan_render_collect_gpu_times (self);
+
   gsk_vulkan_uploader_reset (self->uploader);
 
   gsk_vulkan_command_pool_reset (self->command_pool);
 
   g_hash_table_remove_all (self->descriptor_set_indexes);
-  GSK_VK_CHECK (vkResetDescriptorPool, device,
-                                       self->descriptor_pool,
-                                       0);
 
   g_list_free_full (self->render_passes, (GDestroyNotify) gsk_vulkan_render_pass_free);
   self->render_passes = NULL;
   g_slist_free_full (self->cleanup_images, g_object_unref);
   self->cleanup_images = NULL;
+  g_slist_free_full (self->cleanup_buffers, (GDestroyNotify) gsk_vulkan_buffer_free);
+  self->cleanup_buffers = NULL;
+  self->vertex_buffer_used = 0;
 
   g_clear_pointer (&self->clip, cairo_region_destroy);
   g_clear_object (&self->target);
@@ -711,10 +869,14 @@ gsk_vulkan_render_free (GskVulkanRender *self)
     }
   g_hash_table_unref (self->framebuffers);
 
+  g_clear_pointer (&self->vertex_buffer, gsk_vulkan_buffer_free);
+
   for (i = 0; i < GSK_VULKAN_N_PIPELINES; i++)
     g_clear_object (&self->pipelines[i]);
+  g_mutex_clear (&self->pipeline_lock);
 
   g_clear_pointer (&self->uploader, gsk_vulkan_uploader_free);
+  g_clear_pointer (&self->gpu_profiler, gsk_vulkan_profiler_free);
 
   for (i = 0; i < 3; i++)
     vkDestroyPipelineLayout (device,
@@ -725,6 +887,8 @@ gsk_vulkan_render_free (GskVulkanRender *self)
                        self->render_pass,
                        NULL);
 
+  gsk_vulkan_render_clear_descriptor_set_cache (self);
+  g_hash_table_unref (self->descriptor_set_cache);
   vkDestroyDescriptorPool (device,
                            self->descriptor_pool,
                            NULL);
@@ -8,14 +8,21 @@
 #include "gskrendernodeprivate.h"
 #include "gskvulkanbufferprivate.h"
 #include "gskvulkanimageprivate.h"
+#include "gskvulkanmemoryprivate.h"
 #include "gskvulkanpipelineprivate.h"
 #include "gskvulkanrenderprivate.h"
 #include "gskvulkanglyphcacheprivate.h"
+#include "gskvulkanlayercacheprivate.h"
 
+#include "gdk/gdkprofilerprivate.h"
 #include "gdk/gdktextureprivate.h"
 
 #include <graphene.h>
 
+/* We keep a render per frame in flight, so that we can record a new frame
+ * while the GPU is still busy with the previous ones. */
+#define MAX_FRAMES_IN_FLIGHT 3
+
 typedef struct _GskVulkanTextureData GskVulkanTextureData;
 
 struct _GskVulkanTextureData {
@@ -24,20 +31,6 @@ struct _GskVulkanTextureData {
   GskVulkanRenderer *renderer;
 };
 
-#ifdef G_ENABLE_DEBUG
-typedef struct {
-  GQuark frames;
-  GQuark render_passes;
-  GQuark fallback_pixels;
-  GQuark texture_pixels;
-} ProfileCounters;
-
-typedef struct {
-  GQuark cpu_time;
-  GQuark gpu_time;
-} ProfileTimers;
-#endif
-
 struct _GskVulkanRenderer
 {
   GskRenderer parent_instance;
@@ -47,16 +40,14 @@ struct _GskVulkanRenderer
   guint n_targets;
   GskVulkanImage **targets;
 
-  GskVulkanRender *render;
+  GskVulkanRender *renders[MAX_FRAMES_IN_FLIGHT];
+  guint current_render;
 
   GSList *textures;
 
   GskVulkanGlyphCache *glyph_cache;
 
-#ifdef G_ENABLE_DEBUG
-  ProfileCounters profile_counters;
-  ProfileTimers profile_timers;
-#endif
+  GskVulkanLayerCache layer_cache;
 };
 
 struct _GskVulkanRendererClass
@@ -125,9 +116,11 @@ gsk_vulkan_renderer_realize (GskRenderer  *renderer,
                     self);
   gsk_vulkan_renderer_update_images_cb (self->vulkan, self);
 
-  self->render = gsk_vulkan_render_new (renderer, self->vulkan);
+  self->renders[0] = gsk_vulkan_render_new (renderer, self->vulkan);
+  self->current_render = 0;
 
   self->glyph_cache = gsk_vulkan_glyph_cache_new (renderer, self->vulkan);
+  gsk_vulkan_layer_cache_init (&self->layer_cache);
 
   return TRUE;
 }
@@ -137,8 +130,10 @@ gsk_vulkan_renderer_unrealize (GskRenderer *renderer)
 {
   GskVulkanRenderer *self = GSK_VULKAN_RENDERER (renderer);
   GSList *l;
+  guint i;
 
   g_clear_object (&self->glyph_cache);
+  gsk_vulkan_layer_cache_free (&self->layer_cache);
 
   for (l = self->textures; l; l = l->next)
     {
@@ -149,13 +144,17 @@ gsk_vulkan_renderer_unrealize (GskRenderer *renderer)
     }
   g_clear_pointer (&self->textures, g_slist_free);
 
-  g_clear_pointer (&self->render, gsk_vulkan_render_free);
+  for (i = 0; i < MAX_FRAMES_IN_FLIGHT; i++)
+    g_clear_pointer (&self->renders[i], gsk_vulkan_render_free);
 
   gsk_vulkan_renderer_free_targets (self);
   g_signal_handlers_disconnect_by_func(self->vulkan,
                                        gsk_vulkan_renderer_update_images_cb,
                                        self);
 
+  gsk_vulkan_pipeline_cache_save (self->vulkan);
+  gsk_vulkan_memory_release_unused (self->vulkan);
+
   g_clear_object (&self->vulkan);
 }
 
@@ -168,18 +167,6 @@ gsk_vulkan_renderer_render_texture (GskRenderer           *renderer,
   GskVulkanRender *render;
   GskVulkanImage *image;
   GdkTexture *texture;
-#ifdef G_ENABLE_DEBUG
-  GskProfiler *profiler;
-  gint64 cpu_time;
-#endif
-
-#ifdef G_ENABLE_DEBUG
-  profiler = gsk_renderer_get_profiler (renderer);
-  gsk_profiler_counter_set (profiler, self->profile_counters.fallback_pixels, 0);
-  gsk_profiler_counter_set (profiler, self->profile_counters.texture_pixels, 0);
-  gsk_profiler_counter_set (profiler, self->profile_counters.render_passes, 0);
-  gsk_profiler_timer_begin (profiler, self->profile_timers.cpu_time);
-#endif
 
   render = gsk_vulkan_render_new (renderer, self->vulkan);
 
@@ -200,14 +187,42 @@ gsk_vulkan_renderer_render_texture (GskRenderer           *renderer,
   g_object_unref (image);
   gsk_vulkan_render_free (render);
 
-#ifdef G_ENABLE_DEBUG
-  cpu_time = gsk_profiler_timer_end (profiler, self->profile_timers.cpu_time);
-  gsk_profiler_timer_set (profiler, self->profile_timers.cpu_time, cpu_time);
+  return texture;
+}
 
-  gsk_profiler_push_samples (profiler);
-#endif
+/* Returns a render that the GPU is done with, starting with the one that
+ * was used least recently. If all of them are busy, we create another one,
+ * and only wait for the GPU if we have MAX_FRAMES_IN_FLIGHT renders already. */
+static GskVulkanRender *
+gsk_vulkan_renderer_get_render (GskVulkanRenderer *self)
+{
+  guint i, j;
 
-  return texture;
+  for (i = 1; i <= MAX_FRAMES_IN_FLIGHT; i++)
+    {
+      j = (self->current_render + i) % MAX_FRAMES_IN_FLIGHT;
+
+      if (self->renders[j] != NULL && !gsk_vulkan_render_is_busy (self->renders[j]))
+        goto out;
+    }
+
+  for (i = 1; i <= MAX_FRAMES_IN_FLIGHT; i++)
+    {
+      j = (self->current_render + i) % MAX_FRAMES_IN_FLIGHT;
+
+      if (self->renders[j] == NULL)
+        {
+          self->renders[j] = gsk_vulkan_render_new (GSK_RENDERER (self), self->vulkan);
+          goto out;
+        }
+    }
+
+  /* All busy, gsk_vulkan_render_reset() will wait for the oldest one */
+  j = (self->current_render + 1) % MAX_FRAMES_IN_FLIGHT;
+
+out:
+  self->current_render = j;
+  return self->renders[j];
 }
 
 static void
@@ -218,39 +233,26 @@ gsk_vulkan_renderer_render (GskRenderer          *renderer,
   GskVulkanRenderer *self = GSK_VULKAN_RENDERER (renderer);
   GskVulkanRender *render;
   const cairo_region_t *clip;
-#ifdef G_ENABLE_DEBUG
-  GskProfiler *profiler;
-  gint64 cpu_time;
-#endif
-
-#ifdef G_ENABLE_DEBUG
-  profiler = gsk_renderer_get_profiler (renderer);
-  gsk_profiler_counter_set (profiler, self->profile_counters.fallback_pixels, 0);
-  gsk_profiler_counter_set (profiler, self->profile_counters.texture_pixels, 0);
-  gsk_profiler_counter_set (profiler, self->profile_counters.render_passes, 0);
-  gsk_profiler_timer_begin (profiler, self->profile_timers.cpu_time);
-#endif
+  gint64 before;
 
   gdk_draw_context_begin_frame (GDK_DRAW_CONTEXT (self->vulkan), region);
-  render = self->render;
+  render = gsk_vulkan_renderer_get_render (self);
+  gsk_vulkan_layer_cache_begin_frame (&self->layer_cache);
 
   clip = gdk_draw_context_get_frame_region (GDK_DRAW_CONTEXT (self->vulkan));
   gsk_vulkan_render_reset (render, self->targets[gdk_vulkan_context_get_draw_index (self->vulkan)], NULL, clip);
 
+  before = gdk_profiler_current_time ();
   gsk_vulkan_render_add_node (render, root);
+  gdk_profiler_end_mark (before, "vulkan add nodes", NULL);
 
+  before = gdk_profiler_current_time ();
   gsk_vulkan_render_upload (render);
+  gdk_profiler_end_mark (before, "vulkan upload", NULL);
 
+  before = gdk_profiler_current_time ();
   gsk_vulkan_render_draw (render);
-
-#ifdef G_ENABLE_DEBUG
-  gsk_profiler_counter_inc (profiler, self->profile_counters.frames);
-
-  cpu_time = gsk_profiler_timer_end (profiler, self->profile_timers.cpu_time);
-  gsk_profiler_timer_set (profiler, self->profile_timers.cpu_time, cpu_time);
-
-  gsk_profiler_push_samples (profiler);
-#endif
+  gdk_profiler_end_mark (before, "vulkan draw", NULL);
 
   gdk_draw_context_end_frame (GDK_DRAW_CONTEXT (self->vulkan));
 }
@@ -269,22 +271,16 @@ gsk_vulkan_renderer_class_init (GskVulkanRendererClass *klass)
 static void
 gsk_vulkan_renderer_init (GskVulkanRenderer *self)
 {
-#ifdef G_ENABLE_DEBUG
   GskProfiler *profiler = gsk_renderer_get_profiler (GSK_RENDERER (self));
-#endif
 
   gsk_ensure_resources ();
 
-#ifdef G_ENABLE_DEBUG
-  self->profile_counters.frames = gsk_profiler_add_counter (profiler, "frames", "Frames", FALSE);
-  self->profile_counters.render_passes = gsk_profiler_add_counter (profiler, "render-passes", "Render passes", FALSE);
-  self->profile_counters.fallback_pixels = gsk_profiler_add_counter (profiler, "fallback-pixels", "Fallback pixels", TRUE);
-  self->profile_counters.texture_pixels = gsk_profiler_add_counter (profiler, "texture-pixels", "Texture pixels", TRUE);
+  /* The counters shared by all renderers are added by GskRenderer */
+  gsk_profiler_add_counter (profiler, "render-passes", "Render passes", TRUE);
+  gsk_profiler_add_counter (profiler, "fallback-pixels", "Fallback pixels", TRUE);
+  gsk_profiler_add_counter (profiler, "texture-pixels", "Texture pixels", TRUE);
 
-  self->profile_timers.cpu_time = gsk_profiler_add_timer (profiler, "cpu-time", "CPU time", FALSE, TRUE);
-  if (GSK_RENDERER_DEBUG_CHECK (GSK_RENDERER (self), SYNC))
-    self->profile_timers.gpu_time = gsk_profiler_add_timer (profiler, "gpu-time", "GPU time", FALSE, TRUE);
-#endif
+  gsk_profiler_add_timer (profiler, "offscreen-gpu-time", "Offscreen GPU time", FALSE, TRUE);
 }
 
 static void
@@ -364,3 +360,20 @@ gsk_vulkan_renderer_get_cached_glyph (GskVulkanRenderer *self,
 {
   return gsk_vulkan_glyph_cache_lookup (self->glyph_cache, FALSE, font, glyph, scale);
 }
+
+GskVulkanImage *
+gsk_vulkan_renderer_get_layer_image (GskVulkanRenderer       *self,
+                                     GskRenderNode           *node,
+                                     const graphene_matrix_t *mv)
+{
+  return gsk_vulkan_layer_cache_get_image (&self->layer_cache, node, mv);
+}
+
+void
+gsk_vulkan_renderer_add_layer_image (GskVulkanRenderer       *self,
+                                     GskRenderNode           *node,
+                                     const graphene_matrix_t *mv,
+                                     GskVulkanImage          *image)
+{
+  gsk_vulkan_layer_cache_commit (&self->layer_cache, node, mv, image);
+}
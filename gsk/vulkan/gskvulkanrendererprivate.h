@@ -56,6 +56,13 @@ GskVulkanCachedGlyph * gsk_vulkan_renderer_get_cached_glyph (GskVulkanRenderer *
                                                              PangoGlyph         glyph,
                                                              float              scale);
 
+GskVulkanImage *       gsk_vulkan_renderer_get_layer_image  (GskVulkanRenderer       *self,
+                                                             GskRenderNode           *node,
+                                                             const graphene_matrix_t *mv);
+void                   gsk_vulkan_renderer_add_layer_image  (GskVulkanRenderer       *self,
+                                                             GskRenderNode           *node,
+                                                             const graphene_matrix_t *mv,
+                                                             GskVulkanImage          *image);
 
 G_END_DECLS
 
@@ -52,6 +52,7 @@ typedef enum {
   GSK_VULKAN_OP_REPEAT,
   GSK_VULKAN_OP_CROSS_FADE,
   GSK_VULKAN_OP_BLEND_MODE,
+  GSK_VULKAN_OP_LAYER,
   /* GskVulkanOpText */
   GSK_VULKAN_OP_TEXT,
   GSK_VULKAN_OP_COLOR_TEXT,
@@ -112,6 +113,13 @@ struct _GskVulkanRenderPass
   GdkVulkanContext *vulkan;
 
   GArray *render_ops;
+  /* The node given to gsk_vulkan_render_pass_add(). When that is a layer,
+   * this pass renders it into its image, so it must not be drawn as a
+   * layer itself */
+  GskRenderNode *root;
+  /* This is a copy of another pass, collecting the ops for some children
+   * of a container on a worker thread */
+  gboolean is_chunk;
 
   GskVulkanImage *target;
   int scale_factor;
@@ -123,10 +131,15 @@ struct _GskVulkanRenderPass
   VkRenderPass render_pass;
   VkSemaphore signal_semaphore;
   GArray *wait_semaphores;
-  GskVulkanBuffer *vertex_data;
+  GskVulkanBuffer *vertex_data; /* owned by the GskVulkanRender */
+  /* The size of the vertex data of render_ops, counted as they are added */
+  gsize vertex_data_size;
 
   GQuark fallback_pixels;
   GQuark texture_pixels;
+  GQuark fallback_nodes;
+  GQuark offscreens;
+  GQuark draw_calls;
 };
 
 GskVulkanRenderPass *
@@ -204,11 +217,13 @@ gsk_vulkan_render_pass_new (GdkVulkanContext  *context,
   self->signal_semaphore = signal_semaphore;
   self->wait_semaphores = g_array_new (FALSE, FALSE, sizeof (VkSemaphore));
   self->vertex_data = NULL;
+  self->vertex_data_size = 0;
 
-#ifdef G_ENABLE_DEBUG
   self->fallback_pixels = g_quark_from_static_string ("fallback-pixels");
   self->texture_pixels = g_quark_from_static_string ("texture-pixels");
-#endif
+  self->fallback_nodes = g_quark_from_static_string ("fallback-nodes");
+  self->offscreens = g_quark_from_static_string ("offscreens");
+  self->draw_calls = g_quark_from_static_string ("draw-calls");
 
   return self;
 }
@@ -223,8 +238,6 @@ gsk_vulkan_render_pass_free (GskVulkanRenderPass *self)
   vkDestroyRenderPass (gdk_vulkan_context_get_device (self->vulkan),
                        self->render_pass,
                        NULL);
-  if (self->vertex_data)
-    gsk_vulkan_buffer_free (self->vertex_data);
   if (self->signal_semaphore != VK_NULL_HANDLE)
     vkDestroySemaphore (gdk_vulkan_context_get_device (self->vulkan),
                         self->signal_semaphore,
@@ -235,12 +248,17 @@ gsk_vulkan_render_pass_free (GskVulkanRenderPass *self)
   g_slice_free (GskVulkanRenderPass, self);
 }
 
+/* Fonts aren't safe to use from several threads at once */
+G_LOCK_DEFINE_STATIC (fonts);
+
 static gboolean
 font_has_color_glyphs (const PangoFont *font)
 {
   cairo_scaled_font_t *scaled_font;
   gboolean has_color = FALSE;
 
+  G_LOCK (fonts);
+
   scaled_font = pango_cairo_font_get_scaled_font ((PangoCairoFont *)font);
   if (cairo_scaled_font_get_type (scaled_font) == CAIRO_FONT_TYPE_FT)
     {
@@ -249,9 +267,99 @@ font_has_color_glyphs (const PangoFont *font)
       cairo_ft_scaled_font_unlock_face (scaled_font);
     }
 
+  G_UNLOCK (fonts);
+
   return has_color;
 }
 
+/* Adds @op and accounts for its vertex data, so that
+ * gsk_vulkan_render_pass_get_vertex_data() knows how much to allocate
+ * without another walk over the ops */
+static void
+gsk_vulkan_render_pass_append_op (GskVulkanRenderPass *self,
+                                  GskVulkanOp         *op)
+{
+  switch (op->type)
+    {
+    case GSK_VULKAN_OP_FALLBACK:
+    case GSK_VULKAN_OP_FALLBACK_CLIP:
+    case GSK_VULKAN_OP_FALLBACK_ROUNDED_CLIP:
+    case GSK_VULKAN_OP_TEXTURE:
+    case GSK_VULKAN_OP_REPEAT:
+    case GSK_VULKAN_OP_LAYER:
+      op->render.vertex_count = gsk_vulkan_texture_pipeline_count_vertex_data (GSK_VULKAN_TEXTURE_PIPELINE (op->render.pipeline));
+      self->vertex_data_size += op->render.vertex_count;
+      break;
+
+    case GSK_VULKAN_OP_TEXT:
+      op->text.vertex_count = gsk_vulkan_text_pipeline_count_vertex_data (GSK_VULKAN_TEXT_PIPELINE (op->text.pipeline),
+                                                                          op->text.num_glyphs);
+      self->vertex_data_size += op->text.vertex_count;
+      break;
+
+    case GSK_VULKAN_OP_COLOR_TEXT:
+      op->text.vertex_count = gsk_vulkan_color_text_pipeline_count_vertex_data (GSK_VULKAN_COLOR_TEXT_PIPELINE (op->render.pipeline),
+                                                                                op->text.num_glyphs);
+      self->vertex_data_size += op->text.vertex_count;
+      break;
+
+    case GSK_VULKAN_OP_COLOR:
+      op->render.vertex_count = gsk_vulkan_color_pipeline_count_vertex_data (GSK_VULKAN_COLOR_PIPELINE (op->render.pipeline));
+      self->vertex_data_size += op->render.vertex_count;
+      break;
+
+    case GSK_VULKAN_OP_LINEAR_GRADIENT:
+      op->render.vertex_count = gsk_vulkan_linear_gradient_pipeline_count_vertex_data (GSK_VULKAN_LINEAR_GRADIENT_PIPELINE (op->render.pipeline));
+      self->vertex_data_size += op->render.vertex_count;
+      break;
+
+    case GSK_VULKAN_OP_OPACITY:
+    case GSK_VULKAN_OP_COLOR_MATRIX:
+      op->render.vertex_count = gsk_vulkan_effect_pipeline_count_vertex_data (GSK_VULKAN_EFFECT_PIPELINE (op->render.pipeline));
+      self->vertex_data_size += op->render.vertex_count;
+      break;
+
+    case GSK_VULKAN_OP_BLUR:
+      op->render.vertex_count = gsk_vulkan_blur_pipeline_count_vertex_data (GSK_VULKAN_BLUR_PIPELINE (op->render.pipeline));
+      self->vertex_data_size += op->render.vertex_count;
+      break;
+
+    case GSK_VULKAN_OP_BORDER:
+      op->render.vertex_count = gsk_vulkan_border_pipeline_count_vertex_data (GSK_VULKAN_BORDER_PIPELINE (op->render.pipeline));
+      self->vertex_data_size += op->render.vertex_count;
+      break;
+
+    case GSK_VULKAN_OP_INSET_SHADOW:
+    case GSK_VULKAN_OP_OUTSET_SHADOW:
+      op->render.vertex_count = gsk_vulkan_box_shadow_pipeline_count_vertex_data (GSK_VULKAN_BOX_SHADOW_PIPELINE (op->render.pipeline));
+      self->vertex_data_size += op->render.vertex_count;
+      break;
+
+    case GSK_VULKAN_OP_CROSS_FADE:
+      op->render.vertex_count = gsk_vulkan_cross_fade_pipeline_count_vertex_data (GSK_VULKAN_CROSS_FADE_PIPELINE (op->render.pipeline));
+      self->vertex_data_size += op->render.vertex_count;
+      break;
+
+    case GSK_VULKAN_OP_BLEND_MODE:
+      op->render.vertex_count = gsk_vulkan_blend_mode_pipeline_count_vertex_data (GSK_VULKAN_BLEND_MODE_PIPELINE (op->render.pipeline));
+      self->vertex_data_size += op->render.vertex_count;
+      break;
+
+    case GSK_VULKAN_OP_PUSH_VERTEX_CONSTANTS:
+      break;
+
+    default:
+      g_assert_not_reached ();
+    }
+
+  g_array_append_val (self->render_ops, *op);
+}
+
+static void gsk_vulkan_render_pass_add_children (GskVulkanRenderPass          *self,
+                                                 GskVulkanRender              *render,
+                                                 const GskVulkanPushConstants *constants,
+                                                 GskRenderNode                *node);
+
 #define FALLBACK(...) G_STMT_START { \
   GSK_RENDERER_NOTE (gsk_vulkan_render_get_renderer (render), FALLBACK, g_message (__VA_ARGS__)); \
   goto fallback; \
@@ -269,6 +377,27 @@ gsk_vulkan_render_pass_add_node (GskVulkanRenderPass           *self,
   };
   GskVulkanPipelineType pipeline_type;
 
+  /* Nodes with a cache hint are drawn from an image that is kept
+   * around between frames, see gsk_vulkan_render_pass_get_layer() */
+  if (node->cache_hint && node != self->root)
+    {
+      if (gsk_vulkan_clip_contains_rect (&constants->clip, &node->bounds))
+        pipeline_type = GSK_VULKAN_PIPELINE_TEXTURE;
+      else if (constants->clip.type == GSK_VULKAN_CLIP_RECT)
+        pipeline_type = GSK_VULKAN_PIPELINE_TEXTURE_CLIP;
+      else
+        pipeline_type = GSK_VULKAN_PIPELINE_TEXTURE_CLIP_ROUNDED;
+      op.type = GSK_VULKAN_OP_LAYER;
+      op.render.pipeline = gsk_vulkan_render_get_pipeline (render, pipeline_type);
+      gsk_vulkan_render_pass_append_op (self, &op);
+      return;
+    }
+
+  /* The *_CLIP_ROUNDED pipelines handle elliptic corners, too, so they
+   * are used for both GSK_VULKAN_CLIP_ROUNDED_CIRCULAR and
+   * GSK_VULKAN_CLIP_ROUNDED. Shadows are the exception: the prebuilt
+   * shadow shaders don't do blurs yet, so blurred shadows and shadows
+   * under elliptic clips still use the fallback. */
   switch (gsk_render_node_get_node_type (node))
     {
     case GSK_NOT_A_RENDER_NODE:
@@ -283,13 +412,11 @@ gsk_vulkan_render_pass_add_node (GskVulkanRenderPass           *self,
         pipeline_type = GSK_VULKAN_PIPELINE_TEXTURE;
       else if (constants->clip.type == GSK_VULKAN_CLIP_RECT)
         pipeline_type = GSK_VULKAN_PIPELINE_TEXTURE_CLIP;
-      else if (constants->clip.type == GSK_VULKAN_CLIP_ROUNDED_CIRCULAR)
-        pipeline_type = GSK_VULKAN_PIPELINE_TEXTURE_CLIP_ROUNDED;
       else
-        FALLBACK ("Repeat nodes can't deal with clip type %u", constants->clip.type);
+        pipeline_type = GSK_VULKAN_PIPELINE_TEXTURE_CLIP_ROUNDED;
       op.type = GSK_VULKAN_OP_REPEAT;
       op.render.pipeline = gsk_vulkan_render_get_pipeline (render, pipeline_type);
-      g_array_append_val (self->render_ops, op);
+      gsk_vulkan_render_pass_append_op (self, &op);
       return;
 
     case GSK_BLEND_NODE:
@@ -297,13 +424,11 @@ gsk_vulkan_render_pass_add_node (GskVulkanRenderPass           *self,
         pipeline_type = GSK_VULKAN_PIPELINE_BLEND_MODE;
       else if (constants->clip.type == GSK_VULKAN_CLIP_RECT)
         pipeline_type = GSK_VULKAN_PIPELINE_BLEND_MODE_CLIP;
-      else if (constants->clip.type == GSK_VULKAN_CLIP_ROUNDED_CIRCULAR)
-        pipeline_type = GSK_VULKAN_PIPELINE_BLEND_MODE_CLIP_ROUNDED;
       else
-        FALLBACK ("Blend nodes can't deal with clip type %u", constants->clip.type);
+        pipeline_type = GSK_VULKAN_PIPELINE_BLEND_MODE_CLIP_ROUNDED;
       op.type = GSK_VULKAN_OP_BLEND_MODE;
       op.render.pipeline = gsk_vulkan_render_get_pipeline (render, pipeline_type);
-      g_array_append_val (self->render_ops, op);
+      gsk_vulkan_render_pass_append_op (self, &op);
        return;
 
     case GSK_CROSS_FADE_NODE:
@@ -311,13 +436,11 @@ gsk_vulkan_render_pass_add_node (GskVulkanRenderPass           *self,
         pipeline_type = GSK_VULKAN_PIPELINE_CROSS_FADE;
       else if (constants->clip.type == GSK_VULKAN_CLIP_RECT)
         pipeline_type = GSK_VULKAN_PIPELINE_CROSS_FADE_CLIP;
-      else if (constants->clip.type == GSK_VULKAN_CLIP_ROUNDED_CIRCULAR)
-        pipeline_type = GSK_VULKAN_PIPELINE_CROSS_FADE_CLIP_ROUNDED;
       else
-        FALLBACK ("Cross fade nodes can't deal with clip type %u", constants->clip.type);
+        pipeline_type = GSK_VULKAN_PIPELINE_CROSS_FADE_CLIP_ROUNDED;
       op.type = GSK_VULKAN_OP_CROSS_FADE;
       op.render.pipeline = gsk_vulkan_render_get_pipeline (render, pipeline_type);
-      g_array_append_val (self->render_ops, op);
+      gsk_vulkan_render_pass_append_op (self, &op);
       return;
 
     case GSK_INSET_SHADOW_NODE:
@@ -333,7 +456,7 @@ gsk_vulkan_render_pass_add_node (GskVulkanRenderPass           *self,
         FALLBACK ("Inset shadow nodes can't deal with clip type %u", constants->clip.type);
       op.type = GSK_VULKAN_OP_INSET_SHADOW;
       op.render.pipeline = gsk_vulkan_render_get_pipeline (render, pipeline_type);
-      g_array_append_val (self->render_ops, op);
+      gsk_vulkan_render_pass_append_op (self, &op);
       return;
 
     case GSK_OUTSET_SHADOW_NODE:
@@ -349,7 +472,7 @@ gsk_vulkan_render_pass_add_node (GskVulkanRenderPass           *self,
         FALLBACK ("Outset shadow nodes can't deal with clip type %u", constants->clip.type);
       op.type = GSK_VULKAN_OP_OUTSET_SHADOW;
       op.render.pipeline = gsk_vulkan_render_get_pipeline (render, pipeline_type);
-      g_array_append_val (self->render_ops, op);
+      gsk_vulkan_render_pass_append_op (self, &op);
       return;
 
     case GSK_CAIRO_NODE:
@@ -377,10 +500,8 @@ gsk_vulkan_render_pass_add_node (GskVulkanRenderPass           *self,
               pipeline_type = GSK_VULKAN_PIPELINE_COLOR_TEXT;
             else if (constants->clip.type == GSK_VULKAN_CLIP_RECT)
               pipeline_type = GSK_VULKAN_PIPELINE_COLOR_TEXT_CLIP;
-            else if (constants->clip.type == GSK_VULKAN_CLIP_ROUNDED_CIRCULAR)
-              pipeline_type = GSK_VULKAN_PIPELINE_COLOR_TEXT_CLIP_ROUNDED;
             else
-              FALLBACK ("Text nodes can't deal with clip type %u", constants->clip.type);
+              pipeline_type = GSK_VULKAN_PIPELINE_COLOR_TEXT_CLIP_ROUNDED;
             op.type = GSK_VULKAN_OP_COLOR_TEXT;
           }
         else
@@ -389,10 +510,8 @@ gsk_vulkan_render_pass_add_node (GskVulkanRenderPass           *self,
               pipeline_type = GSK_VULKAN_PIPELINE_TEXT;
             else if (constants->clip.type == GSK_VULKAN_CLIP_RECT)
               pipeline_type = GSK_VULKAN_PIPELINE_TEXT_CLIP;
-            else if (constants->clip.type == GSK_VULKAN_CLIP_ROUNDED_CIRCULAR)
-              pipeline_type = GSK_VULKAN_PIPELINE_TEXT_CLIP_ROUNDED;
             else
-              FALLBACK ("Text nodes can't deal with clip type %u", constants->clip.type);
+              pipeline_type = GSK_VULKAN_PIPELINE_TEXT_CLIP_ROUNDED;
             op.type = GSK_VULKAN_OP_TEXT;
           }
         op.text.pipeline = gsk_vulkan_render_get_pipeline (render, pipeline_type);
@@ -412,7 +531,7 @@ gsk_vulkan_render_pass_add_node (GskVulkanRenderPass           *self,
               {
                 op.text.num_glyphs = count;
 
-                g_array_append_val (self->render_ops, op);
+                gsk_vulkan_render_pass_append_op (self, &op);
 
                 count = 1;
                 op.text.start_glyph = i;
@@ -425,7 +544,7 @@ gsk_vulkan_render_pass_add_node (GskVulkanRenderPass           *self,
         if (op.text.texture_index != G_MAXUINT && count != 0)
           {
             op.text.num_glyphs = count;
-            g_array_append_val (self->render_ops, op);
+            gsk_vulkan_render_pass_append_op (self, &op);
           }
 
         return;
@@ -436,13 +555,11 @@ gsk_vulkan_render_pass_add_node (GskVulkanRenderPass           *self,
         pipeline_type = GSK_VULKAN_PIPELINE_TEXTURE;
       else if (constants->clip.type == GSK_VULKAN_CLIP_RECT)
         pipeline_type = GSK_VULKAN_PIPELINE_TEXTURE_CLIP;
-      else if (constants->clip.type == GSK_VULKAN_CLIP_ROUNDED_CIRCULAR)
-        pipeline_type = GSK_VULKAN_PIPELINE_TEXTURE_CLIP_ROUNDED;
       else
-        FALLBACK ("Texture nodes can't deal with clip type %u", constants->clip.type);
+        pipeline_type = GSK_VULKAN_PIPELINE_TEXTURE_CLIP_ROUNDED;
       op.type = GSK_VULKAN_OP_TEXTURE;
       op.render.pipeline = gsk_vulkan_render_get_pipeline (render, pipeline_type);
-      g_array_append_val (self->render_ops, op);
+      gsk_vulkan_render_pass_append_op (self, &op);
       return;
 
     case GSK_COLOR_NODE:
@@ -450,13 +567,11 @@ gsk_vulkan_render_pass_add_node (GskVulkanRenderPass           *self,
         pipeline_type = GSK_VULKAN_PIPELINE_COLOR;
       else if (constants->clip.type == GSK_VULKAN_CLIP_RECT)
         pipeline_type = GSK_VULKAN_PIPELINE_COLOR_CLIP;
-      else if (constants->clip.type == GSK_VULKAN_CLIP_ROUNDED_CIRCULAR)
-        pipeline_type = GSK_VULKAN_PIPELINE_COLOR_CLIP_ROUNDED;
       else
-        FALLBACK ("Color nodes can't deal with clip type %u", constants->clip.type);
+        pipeline_type = GSK_VULKAN_PIPELINE_COLOR_CLIP_ROUNDED;
       op.type = GSK_VULKAN_OP_COLOR;
       op.render.pipeline = gsk_vulkan_render_get_pipeline (render, pipeline_type);
-      g_array_append_val (self->render_ops, op);
+      gsk_vulkan_render_pass_append_op (self, &op);
       return;
 
     case GSK_LINEAR_GRADIENT_NODE:
@@ -469,13 +584,11 @@ gsk_vulkan_render_pass_add_node (GskVulkanRenderPass           *self,
         pipeline_type = GSK_VULKAN_PIPELINE_LINEAR_GRADIENT;
       else if (constants->clip.type == GSK_VULKAN_CLIP_RECT)
         pipeline_type = GSK_VULKAN_PIPELINE_LINEAR_GRADIENT_CLIP;
-      else if (constants->clip.type == GSK_VULKAN_CLIP_ROUNDED_CIRCULAR)
-        pipeline_type = GSK_VULKAN_PIPELINE_LINEAR_GRADIENT_CLIP_ROUNDED;
       else
-        FALLBACK ("Linear gradient nodes can't deal with clip type %u", constants->clip.type);
+        pipeline_type = GSK_VULKAN_PIPELINE_LINEAR_GRADIENT_CLIP_ROUNDED;
       op.type = GSK_VULKAN_OP_LINEAR_GRADIENT;
       op.render.pipeline = gsk_vulkan_render_get_pipeline (render, pipeline_type);
-      g_array_append_val (self->render_ops, op);
+      gsk_vulkan_render_pass_append_op (self, &op);
       return;
 
     case GSK_OPACITY_NODE:
@@ -483,13 +596,11 @@ gsk_vulkan_render_pass_add_node (GskVulkanRenderPass           *self,
         pipeline_type = GSK_VULKAN_PIPELINE_COLOR_MATRIX;
       else if (constants->clip.type == GSK_VULKAN_CLIP_RECT)
         pipeline_type = GSK_VULKAN_PIPELINE_COLOR_MATRIX_CLIP;
-      else if (constants->clip.type == GSK_VULKAN_CLIP_ROUNDED_CIRCULAR)
-        pipeline_type = GSK_VULKAN_PIPELINE_COLOR_MATRIX_CLIP_ROUNDED;
       else
-        FALLBACK ("Opacity nodes can't deal with clip type %u", constants->clip.type);
+        pipeline_type = GSK_VULKAN_PIPELINE_COLOR_MATRIX_CLIP_ROUNDED;
       op.type = GSK_VULKAN_OP_OPACITY;
       op.render.pipeline = gsk_vulkan_render_get_pipeline (render, pipeline_type);
-      g_array_append_val (self->render_ops, op);
+      gsk_vulkan_render_pass_append_op (self, &op);
       return;
 
     case GSK_BLUR_NODE:
@@ -497,13 +608,11 @@ gsk_vulkan_render_pass_add_node (GskVulkanRenderPass           *self,
         pipeline_type = GSK_VULKAN_PIPELINE_BLUR;
       else if (constants->clip.type == GSK_VULKAN_CLIP_RECT)
         pipeline_type = GSK_VULKAN_PIPELINE_BLUR_CLIP;
-      else if (constants->clip.type == GSK_VULKAN_CLIP_ROUNDED_CIRCULAR)
-        pipeline_type = GSK_VULKAN_PIPELINE_BLUR_CLIP_ROUNDED;
       else
-        FALLBACK ("Blur nodes can't deal with clip type %u", constants->clip.type);
+        pipeline_type = GSK_VULKAN_PIPELINE_BLUR_CLIP_ROUNDED;
       op.type = GSK_VULKAN_OP_BLUR;
       op.render.pipeline = gsk_vulkan_render_get_pipeline (render, pipeline_type);
-      g_array_append_val (self->render_ops, op);
+      gsk_vulkan_render_pass_append_op (self, &op);
       return;
 
     case GSK_COLOR_MATRIX_NODE:
@@ -511,13 +620,11 @@ gsk_vulkan_render_pass_add_node (GskVulkanRenderPass           *self,
         pipeline_type = GSK_VULKAN_PIPELINE_COLOR_MATRIX;
       else if (constants->clip.type == GSK_VULKAN_CLIP_RECT)
         pipeline_type = GSK_VULKAN_PIPELINE_COLOR_MATRIX_CLIP;
-      else if (constants->clip.type == GSK_VULKAN_CLIP_ROUNDED_CIRCULAR)
-        pipeline_type = GSK_VULKAN_PIPELINE_COLOR_MATRIX_CLIP_ROUNDED;
       else
-        FALLBACK ("Color matrix nodes can't deal with clip type %u", constants->clip.type);
+        pipeline_type = GSK_VULKAN_PIPELINE_COLOR_MATRIX_CLIP_ROUNDED;
       op.type = GSK_VULKAN_OP_COLOR_MATRIX;
       op.render.pipeline = gsk_vulkan_render_get_pipeline (render, pipeline_type);
-      g_array_append_val (self->render_ops, op);
+      gsk_vulkan_render_pass_append_op (self, &op);
       return;
 
     case GSK_BORDER_NODE:
@@ -525,24 +632,15 @@ gsk_vulkan_render_pass_add_node (GskVulkanRenderPass           *self,
         pipeline_type = GSK_VULKAN_PIPELINE_BORDER;
       else if (constants->clip.type == GSK_VULKAN_CLIP_RECT)
         pipeline_type = GSK_VULKAN_PIPELINE_BORDER_CLIP;
-      else if (constants->clip.type == GSK_VULKAN_CLIP_ROUNDED_CIRCULAR)
-        pipeline_type = GSK_VULKAN_PIPELINE_BORDER_CLIP_ROUNDED;
       else
-        FALLBACK ("Border nodes can't deal with clip type %u", constants->clip.type);
+        pipeline_type = GSK_VULKAN_PIPELINE_BORDER_CLIP_ROUNDED;
       op.type = GSK_VULKAN_OP_BORDER;
       op.render.pipeline = gsk_vulkan_render_get_pipeline (render, pipeline_type);
-      g_array_append_val (self->render_ops, op);
+      gsk_vulkan_render_pass_append_op (self, &op);
       return;
 
     case GSK_CONTAINER_NODE:
-      {
-        guint i;
-
-        for (i = 0; i < gsk_container_node_get_n_children (node); i++)
-          {
-            gsk_vulkan_render_pass_add_node (self, render, constants, gsk_container_node_get_child (node, i));
-          }
-      }
+      gsk_vulkan_render_pass_add_children (self, render, constants, node);
       return;
 
     case GSK_DEBUG_NODE:
@@ -580,12 +678,12 @@ gsk_vulkan_render_pass_add_node (GskVulkanRenderPass           *self,
         if (!gsk_vulkan_push_constants_transform (&op.constants.constants, constants, &transform, &child->bounds))
           FALLBACK ("Transform nodes can't deal with clip type %u", constants->clip.type);
         op.type = GSK_VULKAN_OP_PUSH_VERTEX_CONSTANTS;
-        g_array_append_val (self->render_ops, op);
+        gsk_vulkan_render_pass_append_op (self, &op);
 
         gsk_vulkan_render_pass_add_node (self, render, &op.constants.constants, child);
         gsk_vulkan_push_constants_init_copy (&op.constants.constants, constants);
         graphene_matrix_init_from_matrix (&self->mv, &mv);
-        g_array_append_val (self->render_ops, op);
+        gsk_vulkan_render_pass_append_op (self, &op);
       }
       return;
 
@@ -597,12 +695,12 @@ gsk_vulkan_render_pass_add_node (GskVulkanRenderPass           *self,
           return;
 
         op.type = GSK_VULKAN_OP_PUSH_VERTEX_CONSTANTS;
-        g_array_append_val (self->render_ops, op);
+        gsk_vulkan_render_pass_append_op (self, &op);
 
         gsk_vulkan_render_pass_add_node (self, render, &op.constants.constants, gsk_clip_node_get_child (node));
 
         gsk_vulkan_push_constants_init_copy (&op.constants.constants, constants);
-        g_array_append_val (self->render_ops, op);
+        gsk_vulkan_render_pass_append_op (self, &op);
       }
       return;
 
@@ -616,12 +714,12 @@ gsk_vulkan_render_pass_add_node (GskVulkanRenderPass           *self,
           return;
 
         op.type = GSK_VULKAN_OP_PUSH_VERTEX_CONSTANTS;
-        g_array_append_val (self->render_ops, op);
+        gsk_vulkan_render_pass_append_op (self, &op);
 
         gsk_vulkan_render_pass_add_node (self, render, &op.constants.constants, gsk_rounded_clip_node_get_child (node));
 
         gsk_vulkan_push_constants_init_copy (&op.constants.constants, constants);
-        g_array_append_val (self->render_ops, op);
+        gsk_vulkan_render_pass_append_op (self, &op);
       }
       return;
     }
@@ -650,10 +748,146 @@ fallback:
         return;
     }
   op.render.pipeline = gsk_vulkan_render_get_pipeline (render, GSK_VULKAN_PIPELINE_TEXTURE);
-  g_array_append_val (self->render_ops, op);
+  gsk_vulkan_render_pass_append_op (self, &op);
 }
 #undef FALLBACK
 
+/* Containers with at least this many children have them added by
+ * several threads, in chunks of PARALLEL_CHUNK_SIZE children */
+#define MIN_PARALLEL_CHILDREN 512
+#define PARALLEL_CHUNK_SIZE 128
+
+typedef struct {
+  GskVulkanRender *render;
+  const GskVulkanPushConstants *constants;
+  GskRenderNode *container;
+  GskVulkanRenderPass *chunks;
+  int n_chunks;
+  int next;
+  int n_workers;
+  GMutex mutex;
+  GCond cond;
+} GskVulkanAddChildrenJob;
+
+/* Adding ops only reads the node tree. The few caches it fills have
+ * their own locks, so this can run on any thread.
+ */
+static void
+gsk_vulkan_add_children_job_run (GskVulkanAddChildrenJob *job)
+{
+  int i;
+
+  while ((i = g_atomic_int_add (&job->next, 1)) < job->n_chunks)
+    {
+      GskVulkanRenderPass *chunk = &job->chunks[i];
+      guint j, end;
+
+      end = MIN ((i + 1) * PARALLEL_CHUNK_SIZE, gsk_container_node_get_n_children (job->container));
+      for (j = i * PARALLEL_CHUNK_SIZE; j < end; j++)
+        gsk_vulkan_render_pass_add_node (chunk, job->render, job->constants,
+                                         gsk_container_node_get_child (job->container, j));
+    }
+}
+
+static void
+gsk_vulkan_add_children_worker (gpointer data,
+                                gpointer user_data)
+{
+  GskVulkanAddChildrenJob *job = data;
+
+  gsk_vulkan_add_children_job_run (job);
+
+  g_mutex_lock (&job->mutex);
+  job->n_workers--;
+  if (job->n_workers == 0)
+    g_cond_signal (&job->cond);
+  g_mutex_unlock (&job->mutex);
+}
+
+/* Adds the ops for the children of the container @node. Big containers
+ * are split into chunks that get their ops from several threads, each
+ * into a copy of @self, and the ops are concatenated in order afterwards.
+ */
+static void
+gsk_vulkan_render_pass_add_children (GskVulkanRenderPass          *self,
+                                     GskVulkanRender              *render,
+                                     const GskVulkanPushConstants *constants,
+                                     GskRenderNode                *node)
+{
+  static GThreadPool *pool = NULL;
+  static int max_workers = 0;
+  GskVulkanAddChildrenJob job;
+  guint n_children;
+  int i;
+
+  n_children = gsk_container_node_get_n_children (node);
+
+  if (max_workers == 0)
+    max_workers = MIN (g_get_num_processors (), 8) - 1;
+
+  if (n_children < MIN_PARALLEL_CHILDREN || self->is_chunk || max_workers <= 0)
+    {
+      for (i = 0; i < n_children; i++)
+        gsk_vulkan_render_pass_add_node (self, render, constants, gsk_container_node_get_child (node, i));
+      return;
+    }
+
+  if (pool == NULL)
+    {
+      pool = g_thread_pool_new (gsk_vulkan_add_children_worker, NULL, max_workers, FALSE, NULL);
+      if (pool == NULL)
+        {
+          max_workers = -1;
+          for (i = 0; i < n_children; i++)
+            gsk_vulkan_render_pass_add_node (self, render, constants, gsk_container_node_get_child (node, i));
+          return;
+        }
+    }
+
+  job.render = render;
+  job.constants = constants;
+  job.container = node;
+  job.n_chunks = (n_children + PARALLEL_CHUNK_SIZE - 1) / PARALLEL_CHUNK_SIZE;
+  job.chunks = g_new (GskVulkanRenderPass, job.n_chunks);
+  job.next = 0;
+  job.n_workers = MIN (max_workers, job.n_chunks - 1);
+  g_mutex_init (&job.mutex);
+  g_cond_init (&job.cond);
+
+  for (i = 0; i < job.n_chunks; i++)
+    {
+      job.chunks[i] = *self;
+      job.chunks[i].render_ops = g_array_new (FALSE, FALSE, sizeof (GskVulkanOp));
+      job.chunks[i].vertex_data_size = 0;
+      job.chunks[i].is_chunk = TRUE;
+    }
+
+  for (i = 0; i < job.n_workers; i++)
+    g_thread_pool_push (pool, &job, NULL);
+
+  /* Help out instead of waiting */
+  gsk_vulkan_add_children_job_run (&job);
+
+  g_mutex_lock (&job.mutex);
+  while (job.n_workers > 0)
+    g_cond_wait (&job.cond, &job.mutex);
+  g_mutex_unlock (&job.mutex);
+
+  g_mutex_clear (&job.mutex);
+  g_cond_clear (&job.cond);
+
+  for (i = 0; i < job.n_chunks; i++)
+    {
+      GArray *ops = job.chunks[i].render_ops;
+
+      g_array_append_vals (self->render_ops, ops->data, ops->len);
+      self->vertex_data_size += job.chunks[i].vertex_data_size;
+      g_array_unref (ops);
+    }
+
+  g_free (job.chunks);
+}
+
 void
 gsk_vulkan_render_pass_add (GskVulkanRenderPass     *self,
                             GskVulkanRender         *render,
@@ -662,10 +896,12 @@ gsk_vulkan_render_pass_add (GskVulkanRenderPass     *self,
   GskVulkanOp op = { 0, };
   graphene_matrix_t mvp;
 
+  self->root = node;
+
   graphene_matrix_multiply (&self->mv, &self->p, &mvp);
   op.type = GSK_VULKAN_OP_PUSH_VERTEX_CONSTANTS;
   gsk_vulkan_push_constants_init (&op.constants.constants, &mvp, &self->viewport);
-  g_array_append_val (self->render_ops, op);
+  gsk_vulkan_render_pass_append_op (self, &op);
 
   gsk_vulkan_render_pass_add_node (self, render, &op.constants.constants, node);
 }
@@ -730,14 +966,13 @@ gsk_vulkan_render_pass_get_node_as_texture (GskVulkanRenderPass   *self,
                                                    view.size.width,
                                                    view.size.height);
 
-#ifdef G_ENABLE_DEBUG
         {
           GskProfiler *profiler = gsk_renderer_get_profiler (gsk_vulkan_render_get_renderer (render));
           gsk_profiler_counter_add (profiler,
                                     self->texture_pixels,
                                     view.size.width * view.size.height);
+          gsk_profiler_counter_inc (profiler, self->offscreens);
         }
-#endif
 
         vkCreateSemaphore (gdk_vulkan_context_get_device (self->vulkan),
                            &(VkSemaphoreCreateInfo) {
@@ -785,14 +1020,13 @@ gsk_vulkan_render_pass_get_node_as_texture (GskVulkanRenderPass   *self,
   GSK_RENDERER_NOTE (gsk_vulkan_render_get_renderer (render), FALLBACK, g_message ("Node as texture not implemented for this case. Using %gx%g fallback surface",
                                ceil (bounds->size.width),
                                ceil (bounds->size.height)));
-#ifdef G_ENABLE_DEBUG
   {
     GskProfiler *profiler = gsk_renderer_get_profiler (gsk_vulkan_render_get_renderer (render));
     gsk_profiler_counter_add (profiler,
                               self->fallback_pixels,
                               ceil (bounds->size.width) * ceil (bounds->size.height));
+    gsk_profiler_counter_inc (profiler, self->fallback_nodes);
   }
-#endif
 
   /* XXX: We could intersect bounds with clip bounds here */
   surface = cairo_image_surface_create (CAIRO_FORMAT_ARGB32,
@@ -823,6 +1057,42 @@ gsk_vulkan_render_pass_get_node_as_texture (GskVulkanRenderPass   *self,
   return result;
 }
 
+/* Returns the image of the layer for @node, rendering it first if it
+ * isn't cached from a previous frame. The image covers all of @node,
+ * so that it can be reused when the clip changes.
+ */
+static GskVulkanImage *
+gsk_vulkan_render_pass_get_layer (GskVulkanRenderPass *self,
+                                  GskVulkanRender     *render,
+                                  GskVulkanUploader   *uploader,
+                                  GskRenderNode       *node,
+                                  graphene_rect_t     *tex_rect)
+{
+  GskVulkanRenderer *renderer = GSK_VULKAN_RENDERER (gsk_vulkan_render_get_renderer (render));
+  GskVulkanImage *result;
+
+  result = gsk_vulkan_renderer_get_layer_image (renderer, node, &self->mv);
+  if (result)
+    {
+      g_object_ref (result);
+      gsk_vulkan_render_add_cleanup_image (render, result);
+      *tex_rect = GRAPHENE_RECT_INIT(0, 0, 1, 1);
+      return result;
+    }
+
+  result = gsk_vulkan_render_pass_get_node_as_texture (self,
+                                                       render,
+                                                       uploader,
+                                                       node,
+                                                       &node->bounds,
+                                                       NULL,
+                                                       tex_rect);
+  if (result)
+    gsk_vulkan_renderer_add_layer_image (renderer, node, &self->mv, result);
+
+  return result;
+}
+
 static void
 gsk_vulkan_render_pass_upload_fallback (GskVulkanRenderPass  *self,
                                         GskVulkanOpRender    *op,
@@ -842,14 +1112,13 @@ gsk_vulkan_render_pass_upload_fallback (GskVulkanRenderPass  *self,
                      node->node_class->type_name, node,
                      ceil (node->bounds.size.width),
                      ceil (node->bounds.size.height)));
-#ifdef G_ENABLE_DEBUG
   {
     GskProfiler *profiler = gsk_renderer_get_profiler (gsk_vulkan_render_get_renderer (render));
     gsk_profiler_counter_add (profiler,
                               self->fallback_pixels,
                               ceil (node->bounds.size.width) * ceil (node->bounds.size.height));
+    gsk_profiler_counter_inc (profiler, self->fallback_nodes);
   }
-#endif
 
   /* XXX: We could intersect bounds with clip bounds here */
   surface = cairo_image_surface_create (CAIRO_FORMAT_ARGB32,
@@ -934,6 +1203,14 @@ gsk_vulkan_render_pass_upload (GskVulkanRenderPass  *self,
           }
           break;
 
+        case GSK_VULKAN_OP_LAYER:
+          op->render.source = gsk_vulkan_render_pass_get_layer (self,
+                                                                render,
+                                                                uploader,
+                                                                op->render.node,
+                                                                &op->render.source_rect);
+          break;
+
         case GSK_VULKAN_OP_OPACITY:
           {
             GskRenderNode *child = gsk_opacity_node_get_child (op->render.node);
@@ -1077,94 +1354,6 @@ gsk_vulkan_render_pass_upload (GskVulkanRenderPass  *self,
     }
 }
 
-static gsize
-gsk_vulkan_render_pass_count_vertex_data (GskVulkanRenderPass *self)
-{
-  GskVulkanOp *op;
-  gsize n_bytes;
-  guint i;
-
-  n_bytes = 0;
-  for (i = 0; i < self->render_ops->len; i++)
-    {
-      op = &g_array_index (self->render_ops, GskVulkanOp, i);
-
-      switch (op->type)
-        {
-        case GSK_VULKAN_OP_FALLBACK:
-        case GSK_VULKAN_OP_FALLBACK_CLIP:
-        case GSK_VULKAN_OP_FALLBACK_ROUNDED_CLIP:
-        case GSK_VULKAN_OP_TEXTURE:
-        case GSK_VULKAN_OP_REPEAT:
-          op->render.vertex_count = gsk_vulkan_texture_pipeline_count_vertex_data (GSK_VULKAN_TEXTURE_PIPELINE (op->render.pipeline));
-          n_bytes += op->render.vertex_count;
-          break;
-
-        case GSK_VULKAN_OP_TEXT:
-          op->text.vertex_count = gsk_vulkan_text_pipeline_count_vertex_data (GSK_VULKAN_TEXT_PIPELINE (op->text.pipeline),
-                                                                              op->text.num_glyphs);
-          n_bytes += op->text.vertex_count;
-          break;
-
-        case GSK_VULKAN_OP_COLOR_TEXT:
-          op->text.vertex_count = gsk_vulkan_color_text_pipeline_count_vertex_data (GSK_VULKAN_COLOR_TEXT_PIPELINE (op->render.pipeline),
-                                                                                    op->text.num_glyphs);
-          n_bytes += op->text.vertex_count;
-          break;
-
-        case GSK_VULKAN_OP_COLOR:
-          op->render.vertex_count = gsk_vulkan_color_pipeline_count_vertex_data (GSK_VULKAN_COLOR_PIPELINE (op->render.pipeline));
-          n_bytes += op->render.vertex_count;
-          break;
-
-        case GSK_VULKAN_OP_LINEAR_GRADIENT:
-          op->render.vertex_count = gsk_vulkan_linear_gradient_pipeline_count_vertex_data (GSK_VULKAN_LINEAR_GRADIENT_PIPELINE (op->render.pipeline));
-          n_bytes += op->render.vertex_count;
-          break;
-
-        case GSK_VULKAN_OP_OPACITY:
-        case GSK_VULKAN_OP_COLOR_MATRIX:
-          op->render.vertex_count = gsk_vulkan_effect_pipeline_count_vertex_data (GSK_VULKAN_EFFECT_PIPELINE (op->render.pipeline));
-          n_bytes += op->render.vertex_count;
-          break;
-
-        case GSK_VULKAN_OP_BLUR:
-          op->render.vertex_count = gsk_vulkan_blur_pipeline_count_vertex_data (GSK_VULKAN_BLUR_PIPELINE (op->render.pipeline));
-          n_bytes += op->render.vertex_count;
-          break;
-
-        case GSK_VULKAN_OP_BORDER:
-          op->render.vertex_count = gsk_vulkan_border_pipeline_count_vertex_data (GSK_VULKAN_BORDER_PIPELINE (op->render.pipeline));
-          n_bytes += op->render.vertex_count;
-          break;
-
-        case GSK_VULKAN_OP_INSET_SHADOW:
-        case GSK_VULKAN_OP_OUTSET_SHADOW:
-          op->render.vertex_count = gsk_vulkan_box_shadow_pipeline_count_vertex_data (GSK_VULKAN_BOX_SHADOW_PIPELINE (op->render.pipeline));
-          n_bytes += op->render.vertex_count;
-          break;
-
-        case GSK_VULKAN_OP_CROSS_FADE:
-          op->render.vertex_count = gsk_vulkan_cross_fade_pipeline_count_vertex_data (GSK_VULKAN_CROSS_FADE_PIPELINE (op->render.pipeline));
-          n_bytes += op->render.vertex_count;
-          break;
-
-        case GSK_VULKAN_OP_BLEND_MODE:
-          op->render.vertex_count = gsk_vulkan_blend_mode_pipeline_count_vertex_data (GSK_VULKAN_BLEND_MODE_PIPELINE (op->render.pipeline));
-          n_bytes += op->render.vertex_count;
-          break;
-
-        default:
-          g_assert_not_reached ();
-
-        case GSK_VULKAN_OP_PUSH_VERTEX_CONSTANTS:
-          continue;
-        }
-    }
-
-  return n_bytes;
-}
-
 static gsize
 gsk_vulkan_render_pass_collect_vertex_data (GskVulkanRenderPass *self,
                                             GskVulkanRender     *render,
@@ -1187,6 +1376,7 @@ gsk_vulkan_render_pass_collect_vertex_data (GskVulkanRenderPass *self,
         case GSK_VULKAN_OP_FALLBACK_CLIP:
         case GSK_VULKAN_OP_FALLBACK_ROUNDED_CLIP:
         case GSK_VULKAN_OP_TEXTURE:
+        case GSK_VULKAN_OP_LAYER:
           {
             op->render.vertex_offset = offset + n_bytes;
             gsk_vulkan_texture_pipeline_collect_vertex_data (GSK_VULKAN_TEXTURE_PIPELINE (op->render.pipeline),
@@ -1409,14 +1599,12 @@ gsk_vulkan_render_pass_get_vertex_data (GskVulkanRenderPass *self,
 {
   if (self->vertex_data == NULL)
     {
-      gsize n_bytes;
+      gsize n_bytes, offset;
       guchar *data;
 
-      n_bytes = gsk_vulkan_render_pass_count_vertex_data (self);
-      self->vertex_data = gsk_vulkan_buffer_new (self->vulkan, n_bytes);
-      data = gsk_vulkan_buffer_map (self->vertex_data);
-      gsk_vulkan_render_pass_collect_vertex_data (self, render, data, 0, n_bytes);
-      gsk_vulkan_buffer_unmap (self->vertex_data);
+      n_bytes = self->vertex_data_size;
+      data = gsk_vulkan_render_alloc_vertex_data (render, n_bytes, &self->vertex_data, &offset);
+      gsk_vulkan_render_pass_collect_vertex_data (self, render, data, offset, offset + n_bytes);
     }
 
   return self->vertex_data;
@@ -1455,6 +1643,7 @@ gsk_vulkan_render_pass_reserve_descriptor_sets (GskVulkanRenderPass *self,
         case GSK_VULKAN_OP_FALLBACK_CLIP:
         case GSK_VULKAN_OP_FALLBACK_ROUNDED_CLIP:
         case GSK_VULKAN_OP_TEXTURE:
+        case GSK_VULKAN_OP_LAYER:
         case GSK_VULKAN_OP_OPACITY:
         case GSK_VULKAN_OP_BLUR:
         case GSK_VULKAN_OP_COLOR_MATRIX:
@@ -1495,7 +1684,8 @@ gsk_vulkan_render_pass_reserve_descriptor_sets (GskVulkanRenderPass *self,
     }
 }
 
-static void
+/* Returns the number of draw calls */
+static guint
 gsk_vulkan_render_pass_draw_rect (GskVulkanRenderPass     *self,
                                   GskVulkanRender         *render,
                                   guint                    layout_count,
@@ -1506,6 +1696,7 @@ gsk_vulkan_render_pass_draw_rect (GskVulkanRenderPass     *self,
   gsize current_draw_index = 0;
   GskVulkanOp *op;
   guint i, step;
+  guint n_draws = 0;
   GskVulkanBuffer *vertex_buffer;
 
   vertex_buffer = gsk_vulkan_render_pass_get_vertex_data (self, render);
@@ -1522,6 +1713,7 @@ gsk_vulkan_render_pass_draw_rect (GskVulkanRenderPass     *self,
         case GSK_VULKAN_OP_FALLBACK_ROUNDED_CLIP:
         case GSK_VULKAN_OP_TEXTURE:
         case GSK_VULKAN_OP_REPEAT:
+        case GSK_VULKAN_OP_LAYER:
           if (!op->render.source)
             continue;
           if (current_pipeline != op->render.pipeline)
@@ -1554,6 +1746,7 @@ gsk_vulkan_render_pass_draw_rect (GskVulkanRenderPass     *self,
           current_draw_index += gsk_vulkan_texture_pipeline_draw (GSK_VULKAN_TEXTURE_PIPELINE (current_pipeline),
                                                                   command_buffer,
                                                                   current_draw_index, 1);
+          n_draws++;
           break;
 
         case GSK_VULKAN_OP_TEXT:
@@ -1587,6 +1780,7 @@ gsk_vulkan_render_pass_draw_rect (GskVulkanRenderPass     *self,
           current_draw_index += gsk_vulkan_text_pipeline_draw (GSK_VULKAN_TEXT_PIPELINE (current_pipeline),
                                                                command_buffer,
                                                                current_draw_index, op->text.num_glyphs);
+          n_draws++;
           break;
 
         case GSK_VULKAN_OP_COLOR_TEXT:
@@ -1620,6 +1814,7 @@ gsk_vulkan_render_pass_draw_rect (GskVulkanRenderPass     *self,
           current_draw_index += gsk_vulkan_color_text_pipeline_draw (GSK_VULKAN_COLOR_TEXT_PIPELINE (current_pipeline),
                                                                      command_buffer,
                                                                      current_draw_index, op->text.num_glyphs);
+          n_draws++;
           break;
 
         case GSK_VULKAN_OP_OPACITY:
@@ -1656,6 +1851,7 @@ gsk_vulkan_render_pass_draw_rect (GskVulkanRenderPass     *self,
           current_draw_index += gsk_vulkan_effect_pipeline_draw (GSK_VULKAN_EFFECT_PIPELINE (current_pipeline),
                                                                  command_buffer,
                                                                  current_draw_index, 1);
+          n_draws++;
           break;
 
         case GSK_VULKAN_OP_BLUR:
@@ -1691,6 +1887,7 @@ gsk_vulkan_render_pass_draw_rect (GskVulkanRenderPass     *self,
           current_draw_index += gsk_vulkan_blur_pipeline_draw (GSK_VULKAN_BLUR_PIPELINE (current_pipeline),
                                                                command_buffer,
                                                                current_draw_index, 1);
+          n_draws++;
           break;
 
         case GSK_VULKAN_OP_COLOR:
@@ -1720,6 +1917,7 @@ gsk_vulkan_render_pass_draw_rect (GskVulkanRenderPass     *self,
           current_draw_index += gsk_vulkan_color_pipeline_draw (GSK_VULKAN_COLOR_PIPELINE (current_pipeline),
                                                                 command_buffer,
                                                                 current_draw_index, step);
+          n_draws++;
           break;
 
         case GSK_VULKAN_OP_LINEAR_GRADIENT:
@@ -1741,6 +1939,7 @@ gsk_vulkan_render_pass_draw_rect (GskVulkanRenderPass     *self,
           current_draw_index += gsk_vulkan_linear_gradient_pipeline_draw (GSK_VULKAN_LINEAR_GRADIENT_PIPELINE (current_pipeline),
                                                                           command_buffer,
                                                                           current_draw_index, 1);
+          n_draws++;
           break;
 
         case GSK_VULKAN_OP_BORDER:
@@ -1762,6 +1961,7 @@ gsk_vulkan_render_pass_draw_rect (GskVulkanRenderPass     *self,
           current_draw_index += gsk_vulkan_border_pipeline_draw (GSK_VULKAN_BORDER_PIPELINE (current_pipeline),
                                                                  command_buffer,
                                                                  current_draw_index, 1);
+          n_draws++;
           break;
 
         case GSK_VULKAN_OP_INSET_SHADOW:
@@ -1784,6 +1984,7 @@ gsk_vulkan_render_pass_draw_rect (GskVulkanRenderPass     *self,
           current_draw_index += gsk_vulkan_box_shadow_pipeline_draw (GSK_VULKAN_BOX_SHADOW_PIPELINE (current_pipeline),
                                                                      command_buffer,
                                                                      current_draw_index, 1);
+          n_draws++;
           break;
 
         case GSK_VULKAN_OP_PUSH_VERTEX_CONSTANTS:
@@ -1827,6 +2028,7 @@ gsk_vulkan_render_pass_draw_rect (GskVulkanRenderPass     *self,
           current_draw_index += gsk_vulkan_cross_fade_pipeline_draw (GSK_VULKAN_CROSS_FADE_PIPELINE (current_pipeline),
                                                                      command_buffer,
                                                                      current_draw_index, 1);
+          n_draws++;
           break;
 
         case GSK_VULKAN_OP_BLEND_MODE:
@@ -1863,6 +2065,7 @@ gsk_vulkan_render_pass_draw_rect (GskVulkanRenderPass     *self,
           current_draw_index += gsk_vulkan_blend_mode_pipeline_draw (GSK_VULKAN_BLEND_MODE_PIPELINE (current_pipeline),
                                                                      command_buffer,
                                                                      current_draw_index, 1);
+          n_draws++;
           break;
 
         default:
@@ -1870,6 +2073,8 @@ gsk_vulkan_render_pass_draw_rect (GskVulkanRenderPass     *self,
           break;
         }
     }
+
+  return n_draws;
 }
 
 void
@@ -1879,7 +2084,7 @@ gsk_vulkan_render_pass_draw (GskVulkanRenderPass     *self,
                              VkPipelineLayout        *pipeline_layout,
                              VkCommandBuffer          command_buffer)
 {
-  guint i;
+  guint i, n_draws = 0;
 
   vkCmdSetViewport (command_buffer,
                     0,
@@ -1923,8 +2128,12 @@ gsk_vulkan_render_pass_draw (GskVulkanRenderPass     *self,
                             },
                             VK_SUBPASS_CONTENTS_INLINE);
 
-      gsk_vulkan_render_pass_draw_rect (self, render, layout_count, pipeline_layout, command_buffer);
+      n_draws += gsk_vulkan_render_pass_draw_rect (self, render, layout_count, pipeline_layout, command_buffer);
 
       vkCmdEndRenderPass (command_buffer);
     }
+
+  gsk_profiler_counter_add (gsk_renderer_get_profiler (gsk_vulkan_render_get_renderer (render)),
+                            self->draw_calls,
+                            n_draws);
 }
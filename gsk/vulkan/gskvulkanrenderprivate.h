@@ -4,6 +4,7 @@
 #include <gdk/gdk.h>
 #include <gsk/gskrendernode.h>
 
+#include "gskvulkanbufferprivate.h"
 #include "gskvulkanimageprivate.h"
 #include "gskvulkanpipelineprivate.h"
 #include "gskvulkanrenderpassprivate.h"
@@ -82,6 +83,10 @@ VkDescriptorSet         gsk_vulkan_render_get_descriptor_set            (GskVulk
 gsize                   gsk_vulkan_render_reserve_descriptor_set        (GskVulkanRender        *self,
                                                                          GskVulkanImage         *source,
                                                                          gboolean                repeat);
+guchar *                gsk_vulkan_render_alloc_vertex_data             (GskVulkanRender        *self,
+                                                                         gsize                   n_bytes,
+                                                                         GskVulkanBuffer       **buffer,
+                                                                         gsize                  *offset);
 void                    gsk_vulkan_render_draw                          (GskVulkanRender        *self);
 
 void                    gsk_vulkan_render_submit                        (GskVulkanRender        *self);
@@ -108,6 +108,148 @@ _gtk_accessibility_override_atk_util (void)
   atk_class->get_toolkit_version = get_toolkit_version;
 }
 
+/* Pending notifications, emitted once per frame. Every emission
+ * becomes a D-Bus message in the AT bridge, and bulk changes like
+ * selecting all rows of a tree view would otherwise send the same
+ * signal thousands of times.
+ */
+typedef struct {
+  AtkObject *obj;
+  const gchar *signal_name;     /* NULL for state changes */
+  AtkStateType state;
+  gboolean first_value;
+  gboolean value;
+} PendingNotify;
+
+static GHashTable *pending_notifies = NULL;
+static GQueue pending_queue = G_QUEUE_INIT;
+static guint pending_source_id = 0;
+
+static guint
+pending_notify_hash (gconstpointer data)
+{
+  const PendingNotify *pending = data;
+
+  return g_direct_hash (pending->obj) ^
+         g_direct_hash (pending->signal_name) ^
+         pending->state;
+}
+
+static gboolean
+pending_notify_equal (gconstpointer a,
+                      gconstpointer b)
+{
+  const PendingNotify *pa = a;
+  const PendingNotify *pb = b;
+
+  return pa->obj == pb->obj &&
+         pa->signal_name == pb->signal_name &&
+         pa->state == pb->state;
+}
+
+static gboolean
+emit_pending_notifies (gpointer data)
+{
+  PendingNotify *pending;
+  GQueue queue;
+
+  /* Handlers may queue new notifications */
+  queue = pending_queue;
+  g_queue_init (&pending_queue);
+  g_hash_table_remove_all (pending_notifies);
+  pending_source_id = 0;
+
+  while ((pending = g_queue_pop_head (&queue)))
+    {
+      if (pending->signal_name)
+        g_signal_emit_by_name (pending->obj, pending->signal_name);
+      else if (pending->value == pending->first_value)
+        atk_object_notify_state_change (pending->obj, pending->state, pending->value);
+      /* else the state went back to what it was before */
+
+      g_object_unref (pending->obj);
+      g_slice_free (PendingNotify, pending);
+    }
+
+  return G_SOURCE_REMOVE;
+}
+
+static void
+queue_notify (AtkObject    *obj,
+              const gchar  *signal_name,
+              AtkStateType  state,
+              gboolean      value)
+{
+  PendingNotify lookup, *pending;
+
+  if (pending_notifies == NULL)
+    pending_notifies = g_hash_table_new (pending_notify_hash, pending_notify_equal);
+
+  lookup.obj = obj;
+  lookup.signal_name = signal_name;
+  lookup.state = state;
+
+  pending = g_hash_table_lookup (pending_notifies, &lookup);
+  if (pending)
+    {
+      pending->value = value;
+      return;
+    }
+
+  pending = g_slice_new0 (PendingNotify);
+  pending->obj = g_object_ref (obj);
+  pending->signal_name = signal_name;
+  pending->state = state;
+  pending->first_value = value;
+  pending->value = value;
+
+  g_hash_table_add (pending_notifies, pending);
+  g_queue_push_tail (&pending_queue, pending);
+
+  /* Run after the frame clock is done with layout and painting */
+  if (pending_source_id == 0)
+    {
+      pending_source_id = g_idle_add_full (GDK_PRIORITY_REDRAW + 10,
+                                           emit_pending_notifies,
+                                           NULL, NULL);
+      g_source_set_name_by_id (pending_source_id, "[gtk] emit_pending_notifies");
+    }
+}
+
+/*
+ * _gtk_accessibility_queue_signal:
+ * @obj: an #AtkObject
+ * @signal_name: an interned name of a signal without arguments,
+ *   like "visible-data-changed"
+ *
+ * Emits @signal_name on @obj once the current frame is done, only
+ * once no matter how often this is called until then.
+ */
+void
+_gtk_accessibility_queue_signal (AtkObject   *obj,
+                                 const gchar *signal_name)
+{
+  queue_notify (obj, g_intern_string (signal_name), 0, FALSE);
+}
+
+/*
+ * _gtk_accessibility_queue_state_change:
+ * @obj: an #AtkObject
+ * @state: the state that changed
+ * @value: the new value of @state
+ *
+ * Like atk_object_notify_state_change(), but only the final value
+ * is emitted if @state changes more than once during a frame, and
+ * nothing if it goes back to its previous value.
+ */
+void
+_gtk_accessibility_queue_state_change (AtkObject    *obj,
+                                       AtkStateType  state,
+                                       gboolean      value)
+{
+  queue_notify (obj, NULL, state, value);
+}
+
 static void
 atk_key_event_from_gdk_event_key (GdkEventKey       *key,
                                   AtkKeyEventStruct *event)
@@ -24,6 +24,12 @@ G_BEGIN_DECLS
 
 void _gtk_accessibility_override_atk_util (void);
 
+void _gtk_accessibility_queue_signal       (AtkObject    *obj,
+                                            const gchar  *signal_name);
+void _gtk_accessibility_queue_state_change (AtkObject    *obj,
+                                            AtkStateType  state,
+                                            gboolean      value);
+
 G_END_DECLS
 
 #endif /* __GTK_ACCESSIBILITY_UTIL_H__ */
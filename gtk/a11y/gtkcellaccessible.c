@@ -22,6 +22,7 @@
 #include "gtkcontainercellaccessible.h"
 #include "gtkcellaccessibleprivate.h"
 #include "gtkcellaccessibleparent.h"
+#include "gtkaccessibilityutil.h"
 
 struct _GtkCellAccessiblePrivate
 {
@@ -172,6 +173,21 @@ _gtk_cell_accessible_initialize (GtkCellAccessible *cell,
   cell->priv->parent = parent;
 }
 
+/* Bulk changes like selecting all rows of a tree view change the
+ * states of many cells at once, so coalesce those per frame. Focus
+ * changes are what screen readers announce first, don't delay them.
+ */
+static void
+notify_state_change (AtkObject    *object,
+                     AtkStateType  state,
+                     gboolean      value)
+{
+  if (state == ATK_STATE_FOCUSED || state == ATK_STATE_ACTIVE)
+    atk_object_notify_state_change (object, state, value);
+  else
+    _gtk_accessibility_queue_state_change (object, state, value);
+}
+
 gboolean
 _gtk_cell_accessible_add_state (GtkCellAccessible *cell,
                                 AtkStateType       state_type,
@@ -183,10 +199,10 @@ _gtk_cell_accessible_add_state (GtkCellAccessible *cell,
    */
   if (emit_signal)
     {
-      atk_object_notify_state_change (ATK_OBJECT (cell), state_type, TRUE);
+      notify_state_change (ATK_OBJECT (cell), state_type, TRUE);
       /* If state_type is ATK_STATE_VISIBLE, additional notification */
       if (state_type == ATK_STATE_VISIBLE)
-        g_signal_emit_by_name (cell, "visible-data-changed");
+        _gtk_accessibility_queue_signal (ATK_OBJECT (cell), "visible-data-changed");
     }
 
   /* If the parent is a flyweight container cell, propagate the state
@@ -209,10 +225,10 @@ _gtk_cell_accessible_remove_state (GtkCellAccessible *cell,
    */
   if (emit_signal)
     {
-      atk_object_notify_state_change (ATK_OBJECT (cell), state_type, FALSE);
+      notify_state_change (ATK_OBJECT (cell), state_type, FALSE);
       /* If state_type is ATK_STATE_VISIBLE, additional notification */
       if (state_type == ATK_STATE_VISIBLE)
-        g_signal_emit_by_name (cell, "visible-data-changed");
+        _gtk_accessibility_queue_signal (ATK_OBJECT (cell), "visible-data-changed");
     }
 
   /* If the parent is a flyweight container cell, propagate the state
@@ -492,13 +508,13 @@ _gtk_cell_accessible_state_changed (GtkCellAccessible    *cell,
   for (i = 0; i < G_N_ELEMENTS (state_map); i++)
     {
       if (added & state_map[i].renderer_state)
-        atk_object_notify_state_change (object,
-                                        state_map[i].atk_state,
-                                        !state_map[i].invert);
+        notify_state_change (object,
+                             state_map[i].atk_state,
+                             !state_map[i].invert);
       if (removed & state_map[i].renderer_state)
-        atk_object_notify_state_change (object,
-                                        state_map[i].atk_state,
-                                        state_map[i].invert);
+        notify_state_change (object,
+                             state_map[i].atk_state,
+                             state_map[i].invert);
     }
 }
 
@@ -19,6 +19,7 @@
 
 #include "gtkflowboxaccessibleprivate.h"
 
+#include "gtkaccessibilityutil.h"
 #include "gtk/gtkflowbox.h"
 
 static void atk_selection_interface_init (AtkSelectionIface *iface);
@@ -239,7 +240,7 @@ _gtk_flow_box_accessible_selection_changed (GtkWidget *box)
 {
   AtkObject *accessible;
   accessible = gtk_widget_get_accessible (box);
-  g_signal_emit_by_name (accessible, "selection-changed");
+  _gtk_accessibility_queue_signal (accessible, "selection-changed");
 }
 
 void
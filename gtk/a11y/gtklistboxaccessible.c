@@ -19,6 +19,7 @@
 
 #include "gtklistboxaccessibleprivate.h"
 
+#include "gtkaccessibilityutil.h"
 #include "gtk/gtklistbox.h"
 
 static void atk_selection_interface_init (AtkSelectionIface *iface);
@@ -233,7 +234,7 @@ _gtk_list_box_accessible_selection_changed (GtkListBox *box)
 {
   AtkObject *accessible;
   accessible = gtk_widget_get_accessible (GTK_WIDGET (box));
-  g_signal_emit_by_name (accessible, "selection-changed");
+  _gtk_accessibility_queue_signal (accessible, "selection-changed");
 }
 
 void
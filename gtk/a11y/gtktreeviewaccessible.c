@@ -34,10 +34,21 @@
 #include "gtktextcellaccessible.h"
 #include "gtkcellaccessibleparent.h"
 #include "gtkcellaccessibleprivate.h"
+#include "gtkaccessibilityutil.h"
+
+/* How many cells nobody but us holds a reference to are kept
+ * around, so walking a big table doesn't keep all of them alive */
+#define MAX_UNUSED_CELLS 256
+
+/* Don't emit children-changed for every cell of bulk changes,
+ * row-inserted and friends already describe them */
+#define MAX_CHILDREN_CHANGED 1024
 
 struct _GtkTreeViewAccessiblePrivate
 {
   GHashTable *cell_infos;
+  /* cell infos of cells only referenced by cell_infos, oldest first */
+  GQueue unused_cells;
 };
 
 typedef struct _GtkTreeViewAccessibleCellInfo  GtkTreeViewAccessibleCellInfo;
@@ -48,6 +59,8 @@ struct _GtkTreeViewAccessibleCellInfo
   GtkTreeRBNode *node;
   GtkTreeViewColumn *cell_col_ref;
   GtkTreeViewAccessible *view;
+  GList unused_link;
+  guint unused : 1;
 };
 
 /* Misc */
@@ -100,15 +113,53 @@ gtk_tree_view_accessible_get_data_quark (void)
   return quark;
 }
 
+static void cell_info_toggle_notify (gpointer  data,
+                                     GObject  *object,
+                                     gboolean  is_last_ref);
+
 static void
 cell_info_free (GtkTreeViewAccessibleCellInfo *cell_info)
 {
+  if (cell_info->unused)
+    g_queue_unlink (&cell_info->view->priv->unused_cells, &cell_info->unused_link);
+
   gtk_accessible_set_widget (GTK_ACCESSIBLE (cell_info->cell), NULL);
-  g_object_unref (cell_info->cell);
+  g_object_remove_toggle_ref (G_OBJECT (cell_info->cell), cell_info_toggle_notify, cell_info);
 
   g_free (cell_info);
 }
 
+/* We hold a toggle reference on every cell, so we know when assistive
+ * technologies drop theirs. Those cells can be recreated whenever they
+ * are asked for again, so only the most recently used ones are kept.
+ */
+static void
+cell_info_toggle_notify (gpointer  data,
+                         GObject  *object,
+                         gboolean  is_last_ref)
+{
+  GtkTreeViewAccessibleCellInfo *cell_info = data;
+  GtkTreeViewAccessiblePrivate *priv = cell_info->view->priv;
+
+  if (is_last_ref)
+    {
+      g_queue_push_tail_link (&priv->unused_cells, &cell_info->unused_link);
+      cell_info->unused = TRUE;
+
+      if (priv->unused_cells.length > MAX_UNUSED_CELLS)
+        {
+          GtkTreeViewAccessibleCellInfo *oldest = priv->unused_cells.head->data;
+
+          g_hash_table_remove (priv->cell_infos, oldest);
+        }
+    }
+  else if (cell_info->unused)
+    {
+      g_queue_unlink (&priv->unused_cells, &cell_info->unused_link);
+      cell_info->unused = FALSE;
+    }
+}
+
 static GtkTreePath *
 cell_info_get_path (GtkTreeViewAccessibleCellInfo *cell_info)
 {
@@ -427,6 +478,9 @@ create_cell (GtkTreeView           *treeview,
   set_cell_data (treeview, accessible, cell);
   _gtk_cell_accessible_update_cache (cell, FALSE);
 
+  /* Now only owned by the cell info */
+  g_object_unref (cell);
+
   return cell;
 }
 
@@ -1534,13 +1588,17 @@ cell_info_new (GtkTreeViewAccessible *accessible,
 {
   GtkTreeViewAccessibleCellInfo *cell_info;
 
-  cell_info = g_new (GtkTreeViewAccessibleCellInfo, 1);
+  cell_info = g_new0 (GtkTreeViewAccessibleCellInfo, 1);
 
   cell_info->tree = tree;
   cell_info->node = node;
   cell_info->cell_col_ref = tv_col;
   cell_info->cell = cell;
   cell_info->view = accessible;
+  cell_info->unused_link.data = cell_info;
+  cell_info->unused = FALSE;
+
+  g_object_add_toggle_ref (G_OBJECT (cell), cell_info_toggle_notify, cell_info);
 
   g_object_set_qdata (G_OBJECT (cell), 
                       gtk_tree_view_accessible_get_data_quark (),
@@ -1677,7 +1735,7 @@ _gtk_tree_view_accessible_add (GtkTreeView   *treeview,
   g_signal_emit_by_name (accessible, "row-inserted", row, n_rows);
 
   n_cols = get_n_columns (treeview);
-  if (n_cols)
+  if (n_cols && n_rows * n_cols <= MAX_CHILDREN_CHANGED)
     {
       for (i = (row + 1) * n_cols; i < (row + n_rows + 1) * n_cols; i++)
         {
@@ -1721,10 +1779,13 @@ _gtk_tree_view_accessible_remove (GtkTreeView   *treeview,
   n_cols = get_n_columns (treeview);
   if (n_cols)
     {
-      for (i = (n_rows + row + 1) * n_cols - 1; i >= (row + 1) * n_cols; i--)
+      if (n_rows * n_cols <= MAX_CHILDREN_CHANGED)
         {
-         /* Pass NULL as the child object, i.e. 4th argument */
-          g_signal_emit_by_name (accessible, "children-changed::remove", i, NULL, NULL);
+          for (i = (n_rows + row + 1) * n_cols - 1; i >= (row + 1) * n_cols; i--)
+            {
+             /* Pass NULL as the child object, i.e. 4th argument */
+              g_signal_emit_by_name (accessible, "children-changed::remove", i, NULL, NULL);
+            }
         }
 
       g_hash_table_iter_init (&iter, accessible->priv->cell_infos);
@@ -1761,7 +1822,7 @@ _gtk_tree_view_accessible_changed (GtkTreeView   *treeview,
       _gtk_cell_accessible_update_cache (cell, TRUE);
     }
 
-  g_signal_emit_by_name (accessible, "visible-data-changed");
+  _gtk_accessibility_queue_signal (ATK_OBJECT (accessible), "visible-data-changed");
 }
 
 /* NB: id is not checked, only columns < id are.
@@ -1800,6 +1861,9 @@ gtk_tree_view_accessible_do_add_column (GtkTreeViewAccessible *accessible,
   n_rows = get_n_rows (treeview);
   n_cols = get_n_columns (treeview);
 
+  if (n_rows > MAX_CHILDREN_CHANGED)
+    return;
+
   /* Generate children-changed signals */
   for (row = 0; row <= n_rows; row++)
     {
@@ -1855,6 +1919,9 @@ gtk_tree_view_accessible_do_remove_column (GtkTreeViewAccessible *accessible,
   n_rows = get_n_rows (treeview);
   n_cols = get_n_columns (treeview);
 
+  if (n_rows > MAX_CHILDREN_CHANGED)
+    return;
+
   /* Generate children-changed signals */
   for (row = 0; row <= n_rows; row++)
     {
@@ -2055,7 +2122,7 @@ _gtk_tree_view_accessible_add_state (GtkTreeView         *treeview,
     }
 
   if (state == GTK_CELL_RENDERER_SELECTED)
-    g_signal_emit_by_name (accessible, "selection-changed");
+    _gtk_accessibility_queue_signal (ATK_OBJECT (accessible), "selection-changed");
 }
 
 void
@@ -2112,5 +2179,5 @@ _gtk_tree_view_accessible_remove_state (GtkTreeView         *treeview,
     }
 
   if (state == GTK_CELL_RENDERER_SELECTED)
-    g_signal_emit_by_name (accessible, "selection-changed");
+    _gtk_accessibility_queue_signal (ATK_OBJECT (accessible), "selection-changed");
 }
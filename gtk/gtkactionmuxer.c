@@ -68,6 +68,11 @@ struct _GtkActionMuxer
   GHashTable *groups;
   GHashTable *primary_accels;
   GtkActionMuxer *parent;
+
+  /* full action name -> Group anywhere up the parent chain, or NULL;
+   * only valid while resolved_serial == groups_serial */
+  GHashTable *resolved;
+  guint resolved_serial;
 };
 
 G_DEFINE_TYPE_WITH_CODE (GtkActionMuxer, gtk_action_muxer, G_TYPE_OBJECT,
@@ -85,6 +90,12 @@ static GParamSpec *properties[NUM_PROPERTIES];
 
 guint accel_signal;
 
+/* Bumped whenever a group is inserted or removed or a parent changes
+ * in any muxer, which invalidates the resolved actions of all muxers.
+ * That only happens while setting things up, not while using them.
+ */
+static guint groups_serial = 1;
+
 typedef struct
 {
   GtkActionMuxer *muxer;
@@ -165,6 +176,41 @@ gtk_action_muxer_find_group (GtkActionMuxer  *muxer,
   return group;
 }
 
+/* Like gtk_action_muxer_find_group(), but also looks at the parents */
+static Group *
+gtk_action_muxer_resolve (GtkActionMuxer  *muxer,
+                          const gchar     *full_name,
+                          const gchar    **action_name)
+{
+  GtkActionMuxer *m;
+  gpointer value;
+  Group *group;
+
+  if (muxer->resolved_serial != groups_serial)
+    {
+      g_hash_table_remove_all (muxer->resolved);
+      muxer->resolved_serial = groups_serial;
+    }
+
+  if (g_hash_table_lookup_extended (muxer->resolved, full_name, NULL, &value))
+    {
+      group = value;
+    }
+  else
+    {
+      group = NULL;
+      for (m = muxer; m != NULL && group == NULL; m = m->parent)
+        group = gtk_action_muxer_find_group (m, full_name, NULL);
+
+      g_hash_table_insert (muxer->resolved, g_strdup (full_name), group);
+    }
+
+  if (group && action_name)
+    *action_name = strchr (full_name, '.') + 1;
+
+  return group;
+}
+
 static void
 gtk_action_muxer_action_enabled_changed (GtkActionMuxer *muxer,
                                          const gchar    *action_name,
@@ -383,17 +429,12 @@ gtk_action_muxer_query_action (GActionGroup        *action_group,
   Group *group;
   const gchar *unprefixed_name;
 
-  group = gtk_action_muxer_find_group (muxer, action_name, &unprefixed_name);
+  group = gtk_action_muxer_resolve (muxer, action_name, &unprefixed_name);
 
   if (group)
     return g_action_group_query_action (group->group, unprefixed_name, enabled,
                                         parameter_type, state_type, state_hint, state);
 
-  if (muxer->parent)
-    return g_action_group_query_action (G_ACTION_GROUP (muxer->parent), action_name,
-                                        enabled, parameter_type,
-                                        state_type, state_hint, state);
-
   return FALSE;
 }
 
@@ -406,12 +447,10 @@ gtk_action_muxer_activate_action (GActionGroup *action_group,
   Group *group;
   const gchar *unprefixed_name;
 
-  group = gtk_action_muxer_find_group (muxer, action_name, &unprefixed_name);
+  group = gtk_action_muxer_resolve (muxer, action_name, &unprefixed_name);
 
   if (group)
     g_action_group_activate_action (group->group, unprefixed_name, parameter);
-  else if (muxer->parent)
-    g_action_group_activate_action (G_ACTION_GROUP (muxer->parent), action_name, parameter);
 }
 
 static void
@@ -423,12 +462,10 @@ gtk_action_muxer_change_action_state (GActionGroup *action_group,
   Group *group;
   const gchar *unprefixed_name;
 
-  group = gtk_action_muxer_find_group (muxer, action_name, &unprefixed_name);
+  group = gtk_action_muxer_resolve (muxer, action_name, &unprefixed_name);
 
   if (group)
     g_action_group_change_action_state (group->group, unprefixed_name, state);
-  else if (muxer->parent)
-    g_action_group_change_action_state (G_ACTION_GROUP (muxer->parent), action_name, state);
 }
 
 static void
@@ -537,6 +574,7 @@ gtk_action_muxer_finalize (GObject *object)
   g_hash_table_unref (muxer->groups);
   if (muxer->primary_accels)
     g_hash_table_unref (muxer->primary_accels);
+  g_hash_table_unref (muxer->resolved);
 
   G_OBJECT_CLASS (gtk_action_muxer_parent_class)
     ->finalize (object);
@@ -556,6 +594,7 @@ gtk_action_muxer_dispose (GObject *object)
     g_signal_handlers_disconnect_by_func (muxer->parent, gtk_action_muxer_parent_primary_accel_changed, muxer);
 
     g_clear_object (&muxer->parent);
+    groups_serial++;
   }
 
   g_hash_table_remove_all (muxer->observed_actions);
@@ -607,6 +646,7 @@ gtk_action_muxer_init (GtkActionMuxer *muxer)
 {
   muxer->observed_actions = g_hash_table_new_full (g_str_hash, g_str_equal, NULL, gtk_action_muxer_free_action);
   muxer->groups = g_hash_table_new_full (g_str_hash, g_str_equal, NULL, gtk_action_muxer_free_group);
+  muxer->resolved = g_hash_table_new_full (g_str_hash, g_str_equal, g_free, NULL);
 }
 
 static void
@@ -683,6 +723,7 @@ gtk_action_muxer_insert (GtkActionMuxer *muxer,
   group->prefix = g_strdup (prefix);
 
   g_hash_table_insert (muxer->groups, group->prefix, group);
+  groups_serial++;
 
   actions = g_action_group_list_actions (group->group);
   for (i = 0; actions[i]; i++)
@@ -723,6 +764,7 @@ gtk_action_muxer_remove (GtkActionMuxer *muxer,
       gint i;
 
       g_hash_table_steal (muxer->groups, prefix);
+      groups_serial++;
 
       actions = g_action_group_list_actions (group->group);
       for (i = 0; actions[i]; i++)
@@ -837,6 +879,7 @@ gtk_action_muxer_set_parent (GtkActionMuxer *muxer,
     }
 
   muxer->parent = parent;
+  groups_serial++;
 
   if (muxer->parent != NULL)
     {
@@ -1120,6 +1120,8 @@ gtk_box_measure (GtkWidget      *widget,
   GtkBox *box = GTK_BOX (widget);
   GtkBoxPrivate *priv = gtk_box_get_instance_private (box);
 
+  gtk_widget_premeasure_children (widget);
+
   if (priv->orientation != orientation)
     gtk_box_compute_size_for_opposing_orientation (box, for_size, minimum, natural, minimum_baseline, natural_baseline);
   else
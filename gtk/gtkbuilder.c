@@ -65,6 +65,12 @@
  *
  * [RELAX NG Compact Syntax](https://git.gnome.org/browse/gtk+/tree/gtk/gtkbuilder.rnc)
  *
+ * UI definitions can also be given in a precompiled binary form,
+ * produced by `gtk4-builder-tool precompile`. GtkBuilder detects it
+ * automatically, and loads it faster than XML, since it doesn't need
+ * to be tokenized and unescaped. This is worthwhile for UI definitions
+ * that are loaded often, such as the templates of dialogs.
+ *
  * The toplevel element is <interface>. It optionally takes a “domain”
  * attribute, which will make the builder look for translated strings
  * using dgettext() in the domain specified. This can also be done by
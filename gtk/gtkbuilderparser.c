@@ -75,6 +75,38 @@ state_pop (ParserData *data)
 #define state_peek_info(data, st) ((st*)state_peek(data))
 #define state_pop_info(data, st) ((st*)state_pop(data))
 
+/* When replaying precompiled data, there is no markup
+ * parse context for most of the elements */
+static void
+get_position (ParserData *data,
+              gint       *line,
+              gint       *col)
+{
+  if (data->ctx)
+    {
+      g_markup_parse_context_get_position (data->ctx, line, col);
+      return;
+    }
+
+  if (line)
+    *line = data->line;
+  if (col)
+    *col = data->col;
+}
+
+static void
+prefix_error (ParserData  *data,
+              GError     **error)
+{
+  if (data->ctx)
+    {
+      _gtk_builder_prefix_error (data->builder, data->ctx, error);
+      return;
+    }
+
+  g_prefix_error (error, "%s:%d:%d ", data->filename, data->line, data->col);
+}
+
 static void
 error_missing_attribute (ParserData   *data,
                          const gchar  *tag,
@@ -83,7 +115,7 @@ error_missing_attribute (ParserData   *data,
 {
   gint line, col;
 
-  g_markup_parse_context_get_position (data->ctx, &line, &col);
+  get_position (data, &line, &col);
 
   g_set_error (error,
                GTK_BUILDER_ERROR,
@@ -100,7 +132,7 @@ error_invalid_tag (ParserData   *data,
 {
   gint line, col;
 
-  g_markup_parse_context_get_position (data->ctx, &line, &col);
+  get_position (data, &line, &col);
 
   if (expected)
     g_set_error (error,
@@ -123,7 +155,7 @@ error_unhandled_tag (ParserData   *data,
 {
   gint line, col;
 
-  g_markup_parse_context_get_position (data->ctx, &line, &col);
+  get_position (data, &line, &col);
   g_set_error (error,
                GTK_BUILDER_ERROR,
                GTK_BUILDER_ERROR_UNHANDLED_TAG,
@@ -203,7 +235,7 @@ parse_requires (ParserData   *data,
                                     G_MARKUP_COLLECT_STRING, "version", &version,
                                     G_MARKUP_COLLECT_INVALID))
     {
-      _gtk_builder_prefix_error (data->builder, data->ctx, error);
+      prefix_error (data, error);
       return;
     }
 
@@ -213,7 +245,7 @@ parse_requires (ParserData   *data,
                    GTK_BUILDER_ERROR,
                    GTK_BUILDER_ERROR_INVALID_VALUE,
                    "'version' attribute has malformed value '%s'", version);
-      _gtk_builder_prefix_error (data->builder, data->ctx, error);
+      prefix_error (data, error);
       return;
     }
   version_major = g_ascii_strtoll (split[0], NULL, 10);
@@ -244,12 +276,11 @@ is_requested_object (const gchar *object,
 }
 
 static void
-parse_object (GMarkupParseContext  *context,
-              ParserData           *data,
-              const gchar          *element_name,
-              const gchar         **names,
-              const gchar         **values,
-              GError              **error)
+parse_object (ParserData   *data,
+              const gchar  *element_name,
+              const gchar **names,
+              const gchar **values,
+              GError      **error)
 {
   ObjectInfo *object_info;
   ChildInfo* child_info;
@@ -281,7 +312,7 @@ parse_object (GMarkupParseContext  *context,
                                     G_MARKUP_COLLECT_STRING|G_MARKUP_COLLECT_OPTIONAL, "id", &object_id,
                                     G_MARKUP_COLLECT_INVALID))
     {
-      _gtk_builder_prefix_error (data->builder, data->ctx, error);
+      prefix_error (data, error);
       return;
     }
 
@@ -303,7 +334,7 @@ parse_object (GMarkupParseContext  *context,
                        GTK_BUILDER_ERROR,
                        GTK_BUILDER_ERROR_INVALID_TYPE_FUNCTION,
                        "Invalid type function '%s'", type_func);
-          _gtk_builder_prefix_error (data->builder, context, error);
+          prefix_error (data, error);
           return;
         }
     }
@@ -318,7 +349,7 @@ parse_object (GMarkupParseContext  *context,
                        GTK_BUILDER_ERROR,
                        GTK_BUILDER_ERROR_INVALID_VALUE,
                        "Invalid object type '%s'", object_class);
-          _gtk_builder_prefix_error (data->builder, context, error);
+          prefix_error (data, error);
           return;
        }
     }
@@ -368,21 +399,20 @@ parse_object (GMarkupParseContext  *context,
                    GTK_BUILDER_ERROR_DUPLICATE_ID,
                    "Duplicate object ID '%s' (previously on line %d)",
                    object_id, line);
-      _gtk_builder_prefix_error (data->builder, context, error);
+      prefix_error (data, error);
       return;
     }
 
-  g_markup_parse_context_get_position (context, &line, NULL);
+  get_position (data, &line, NULL);
   g_hash_table_insert (data->object_ids, g_strdup (object_id), GINT_TO_POINTER (line));
 }
 
 static void
-parse_template (GMarkupParseContext  *context,
-                ParserData           *data,
-                const gchar          *element_name,
-                const gchar         **names,
-                const gchar         **values,
-                GError              **error)
+parse_template (ParserData   *data,
+                const gchar  *element_name,
+                const gchar **names,
+                const gchar **values,
+                GError      **error)
 {
   ObjectInfo *object_info;
   const gchar *object_class = NULL;
@@ -398,7 +428,7 @@ parse_template (GMarkupParseContext  *context,
                                     G_MARKUP_COLLECT_STRING|G_MARKUP_COLLECT_OPTIONAL, "parent", &parent_class,
                                     G_MARKUP_COLLECT_INVALID))
     {
-      _gtk_builder_prefix_error (data->builder, data->ctx, error);
+      prefix_error (data, error);
       return;
     }
 
@@ -409,7 +439,7 @@ parse_template (GMarkupParseContext  *context,
                    GTK_BUILDER_ERROR_UNHANDLED_TAG,
                    "Not expecting to handle a template (class '%s', parent '%s')",
                    object_class, parent_class ? parent_class : "GtkWidget");
-      _gtk_builder_prefix_error (data->builder, context, error);
+      prefix_error (data, error);
       return;
     }
   else if (state_peek (data) != NULL)
@@ -426,7 +456,7 @@ parse_template (GMarkupParseContext  *context,
                    GTK_BUILDER_ERROR_TEMPLATE_MISMATCH,
                    "Parsed template definition for type '%s', expected type '%s'",
                    object_class, g_type_name (template_type));
-      _gtk_builder_prefix_error (data->builder, context, error);
+      prefix_error (data, error);
       return;
     }
 
@@ -440,7 +470,7 @@ parse_template (GMarkupParseContext  *context,
           g_set_error (error, GTK_BUILDER_ERROR,
                        GTK_BUILDER_ERROR_INVALID_VALUE,
                        "Invalid template parent type '%s'", parent_class);
-          _gtk_builder_prefix_error (data->builder, context, error);
+          prefix_error (data, error);
           return;
         }
       if (parent_type != expected_type)
@@ -449,7 +479,7 @@ parse_template (GMarkupParseContext  *context,
                        GTK_BUILDER_ERROR_TEMPLATE_MISMATCH,
                        "Template parent type '%s' does not match instance parent type '%s'.",
                        parent_class, g_type_name (expected_type));
-          _gtk_builder_prefix_error (data->builder, context, error);
+          prefix_error (data, error);
           return;
         }
     }
@@ -472,11 +502,11 @@ parse_template (GMarkupParseContext  *context,
                    GTK_BUILDER_ERROR_DUPLICATE_ID,
                    "Duplicate object ID '%s' (previously on line %d)",
                    object_class, line);
-      _gtk_builder_prefix_error (data->builder, context, error);
+      prefix_error (data, error);
       return;
     }
 
-  g_markup_parse_context_get_position (context, &line, NULL);
+  get_position (data, &line, NULL);
   g_hash_table_insert (data->object_ids, g_strdup (object_class), GINT_TO_POINTER (line));
 }
 
@@ -520,7 +550,7 @@ parse_child (ParserData   *data,
                                     G_MARKUP_COLLECT_STRING|G_MARKUP_COLLECT_OPTIONAL, "internal-child", &internal_child,
                                     G_MARKUP_COLLECT_INVALID))
     {
-      _gtk_builder_prefix_error (data->builder, data->ctx, error);
+      prefix_error (data, error);
       return;
     }
 
@@ -580,7 +610,7 @@ parse_property (ParserData   *data,
                                     G_MARKUP_COLLECT_STRING|G_MARKUP_COLLECT_OPTIONAL, "bind-flags", &bind_flags_str,
                                     G_MARKUP_COLLECT_INVALID))
     {
-      _gtk_builder_prefix_error (data->builder, data->ctx, error);
+      prefix_error (data, error);
       return;
     }
 
@@ -593,7 +623,7 @@ parse_property (ParserData   *data,
                    GTK_BUILDER_ERROR_INVALID_PROPERTY,
                    "Invalid property: %s.%s",
                    g_type_name (object_info->type), name);
-      _gtk_builder_prefix_error (data->builder, data->ctx, error);
+      prefix_error (data, error);
       return;
     }
 
@@ -601,12 +631,12 @@ parse_property (ParserData   *data,
     {
       if (!_gtk_builder_flags_from_string (G_TYPE_BINDING_FLAGS, NULL, bind_flags_str, &bind_flags, error))
         {
-          _gtk_builder_prefix_error (data->builder, data->ctx, error);
+          prefix_error (data, error);
           return;
         }
     }
 
-  g_markup_parse_context_get_position (data->ctx, &line, &col);
+  get_position (data, &line, &col);
 
   if (bind_source && bind_property)
     {
@@ -687,7 +717,7 @@ parse_signal (ParserData   *data,
                                     G_MARKUP_COLLECT_TRISTATE|G_MARKUP_COLLECT_OPTIONAL, "swapped", &swapped,
                                     G_MARKUP_COLLECT_INVALID))
     {
-      _gtk_builder_prefix_error (data->builder, data->ctx, error);
+      prefix_error (data, error);
       return;
     }
 
@@ -698,7 +728,7 @@ parse_signal (ParserData   *data,
                    GTK_BUILDER_ERROR_INVALID_SIGNAL,
                    "Invalid signal '%s' for type '%s'",
                    name, g_type_name (object_info->type));
-      _gtk_builder_prefix_error (data->builder, data->ctx, error);
+      prefix_error (data, error);
       return;
     }
 
@@ -757,7 +787,7 @@ parse_interface (ParserData   *data,
                                     G_MARKUP_COLLECT_STRING|G_MARKUP_COLLECT_OPTIONAL, "domain", &domain,
                                     G_MARKUP_COLLECT_INVALID))
     {
-      _gtk_builder_prefix_error (data->builder, data->ctx, error);
+      prefix_error (data, error);
       return;
     }
 
@@ -969,7 +999,7 @@ start_element (GMarkupParseContext  *context,
     }
 
   if (strcmp (element_name, "object") == 0)
-    parse_object (context, data, element_name, names, values, error);
+    parse_object (data, element_name, names, values, error);
   else if (data->requested_objects && !data->inside_requested_object)
     {
       /* If outside a requested object, simply ignore this tag */
@@ -981,7 +1011,7 @@ start_element (GMarkupParseContext  *context,
   else if (strcmp (element_name, "signal") == 0)
     parse_signal (data, element_name, names, values, error);
   else if (strcmp (element_name, "template") == 0)
-    parse_template (context, data, element_name, names, values, error);
+    parse_template (data, element_name, names, values, error);
   else if (strcmp (element_name, "requires") == 0)
     parse_requires (data, element_name, names, values, error);
   else if (strcmp (element_name, "interface") == 0)
@@ -1132,7 +1162,7 @@ end_element (GMarkupParseContext  *context,
                            req_info->library,
                            req_info->major, req_info->minor,
                            GTK_MAJOR_VERSION, GTK_MINOR_VERSION);
-              _gtk_builder_prefix_error (data->builder, context, error);
+              prefix_error (data, error);
            }
         }
       free_requires_info (req_info, NULL);
@@ -1153,7 +1183,7 @@ end_element (GMarkupParseContext  *context,
                    GTK_BUILDER_ERROR,
                    GTK_BUILDER_ERROR_UNHANDLED_TAG,
                    "Unhandled tag: <%s>", element_name);
-      _gtk_builder_prefix_error (data->builder, context, error);
+      prefix_error (data, error);
     }
 }
 
@@ -1187,7 +1217,7 @@ text (GMarkupParseContext  *context,
   info = state_peek_info (data, CommonInfo);
   g_assert (info != NULL);
 
-  if (strcmp (g_markup_parse_context_get_element (context), "property") == 0)
+  if (info->tag_type == TAG_PROPERTY)
     {
       PropertyInfo *prop_info = (PropertyInfo*)info;
 
@@ -1228,6 +1258,225 @@ static const GMarkupParser parser = {
   NULL,
 };
 
+typedef struct {
+  const gchar *buffer;
+  gsize length;
+  gsize pos;
+  const gchar **strings;
+  guint32 n_strings;
+} PrecompiledReader;
+
+static gboolean
+read_uint32 (PrecompiledReader *reader,
+             guint32           *value)
+{
+  guint32 v;
+
+  if (reader->length - reader->pos < sizeof (guint32))
+    return FALSE;
+
+  memcpy (&v, reader->buffer + reader->pos, sizeof (guint32));
+  reader->pos += sizeof (guint32);
+  *value = GUINT32_FROM_LE (v);
+
+  return TRUE;
+}
+
+static gboolean
+read_string (PrecompiledReader  *reader,
+             const gchar       **string)
+{
+  guint32 idx;
+
+  if (!read_uint32 (reader, &idx) || idx >= reader->n_strings)
+    return FALSE;
+
+  *string = reader->strings[idx];
+
+  return TRUE;
+}
+
+static gboolean
+read_string_table (PrecompiledReader *reader)
+{
+  guint32 version, n_strings, size, i;
+  const gchar *p, *end;
+
+  reader->pos = GTK_BUILDER_PRECOMPILED_MAGIC_LEN;
+
+  if (!read_uint32 (reader, &version) ||
+      version != GTK_BUILDER_PRECOMPILED_VERSION ||
+      !read_uint32 (reader, &n_strings) ||
+      !read_uint32 (reader, &size) ||
+      size > reader->length - reader->pos ||
+      n_strings > size)
+    return FALSE;
+
+  p = reader->buffer + reader->pos;
+  end = p + size;
+
+  reader->strings = g_new (const gchar *, n_strings);
+  reader->n_strings = n_strings;
+
+  for (i = 0; i < n_strings; i++)
+    {
+      reader->strings[i] = p;
+      p = memchr (p, '\0', end - p);
+      if (p == NULL)
+        return FALSE;
+      p++;
+    }
+
+  size = (size + 3) & ~3;
+  if (size > reader->length - reader->pos)
+    return FALSE;
+
+  reader->pos += size;
+
+  return TRUE;
+}
+
+/* Custom tags and menus are stored as markup, their parsers
+ * need a GMarkupParseContext */
+static void
+replay_markup (ParserData   *data,
+               const gchar  *markup,
+               GError      **error)
+{
+  data->ctx = g_markup_parse_context_new (&parser,
+                                          G_MARKUP_TREAT_CDATA_AS_TEXT,
+                                          data, NULL);
+
+  if (g_markup_parse_context_parse (data->ctx, markup, -1, error))
+    g_markup_parse_context_end_parse (data->ctx, error);
+
+  g_markup_parse_context_free (data->ctx);
+  data->ctx = NULL;
+}
+
+/* Feeds precompiled data to the same callbacks as the markup
+ * parser, without having to tokenize XML, unescape entities and
+ * skip whitespace and comments */
+static void
+replay_precompiled (ParserData   *data,
+                    const gchar  *buffer,
+                    gsize         length,
+                    GError      **error)
+{
+  PrecompiledReader reader = { buffer, length, 0, NULL, 0 };
+  GPtrArray *names, *values;
+  GError *tmp_error = NULL;
+
+  names = g_ptr_array_new ();
+  values = g_ptr_array_new ();
+
+  if (!read_string_table (&reader))
+    goto corrupt;
+
+  while (reader.pos < reader.length)
+    {
+      guint32 type, line, col, n_attributes, i;
+      const gchar *name, *value;
+
+      if (!read_uint32 (&reader, &type))
+        goto corrupt;
+
+      switch (type)
+        {
+        case GTK_BUILDER_RECORD_START_ELEMENT:
+          if (!read_string (&reader, &name) ||
+              !read_uint32 (&reader, &line) ||
+              !read_uint32 (&reader, &col) ||
+              !read_uint32 (&reader, &n_attributes) ||
+              n_attributes > (reader.length - reader.pos) / (2 * sizeof (guint32)))
+            goto corrupt;
+
+          g_ptr_array_set_size (names, 0);
+          g_ptr_array_set_size (values, 0);
+          for (i = 0; i < n_attributes; i++)
+            {
+              const gchar *attr_name, *attr_value;
+
+              if (!read_string (&reader, &attr_name) ||
+                  !read_string (&reader, &attr_value))
+                goto corrupt;
+
+              g_ptr_array_add (names, (gpointer) attr_name);
+              g_ptr_array_add (values, (gpointer) attr_value);
+            }
+          g_ptr_array_add (names, NULL);
+          g_ptr_array_add (values, NULL);
+
+          data->line = line;
+          data->col = col;
+          start_element (NULL, name,
+                         (const gchar **) names->pdata,
+                         (const gchar **) values->pdata,
+                         data, &tmp_error);
+          break;
+
+        case GTK_BUILDER_RECORD_END_ELEMENT:
+          if (!read_string (&reader, &name))
+            goto corrupt;
+
+          end_element (NULL, name, data, &tmp_error);
+          break;
+
+        case GTK_BUILDER_RECORD_TEXT:
+          if (!read_string (&reader, &value))
+            goto corrupt;
+
+          text (NULL, value, strlen (value), data, &tmp_error);
+          break;
+
+        case GTK_BUILDER_RECORD_MARKUP:
+          if (!read_string (&reader, &value) ||
+              !read_uint32 (&reader, &line) ||
+              !read_uint32 (&reader, &col))
+            goto corrupt;
+
+          data->line = line;
+          data->col = col;
+          replay_markup (data, value, &tmp_error);
+          break;
+
+        default:
+          goto corrupt;
+        }
+
+      if (tmp_error)
+        {
+          g_propagate_error (error, tmp_error);
+          goto out;
+        }
+    }
+
+  goto out;
+
+corrupt:
+  g_set_error (error,
+               GTK_BUILDER_ERROR,
+               GTK_BUILDER_ERROR_INVALID_VALUE,
+               "%s: Corrupt precompiled data",
+               data->filename);
+
+out:
+  g_ptr_array_unref (names);
+  g_ptr_array_unref (values);
+  g_free (reader.strings);
+}
+
+static gboolean
+is_precompiled (const gchar *buffer,
+                gsize        length)
+{
+  /* Precompiled data contains nul bytes, it can't be passed
+   * as a nul-terminated string */
+  return length != (gsize) -1 &&
+         length >= GTK_BUILDER_PRECOMPILED_MAGIC_LEN &&
+         memcmp (buffer, GTK_BUILDER_PRECOMPILED_MAGIC, GTK_BUILDER_PRECOMPILED_MAGIC_LEN) == 0;
+}
+
 void
 _gtk_builder_parser_parse_buffer (GtkBuilder   *builder,
                                   const gchar  *filename,
@@ -1265,12 +1514,26 @@ _gtk_builder_parser_parse_buffer (GtkBuilder   *builder,
       data.inside_requested_object = TRUE;
     }
 
-  data.ctx = g_markup_parse_context_new (&parser,
-                                          G_MARKUP_TREAT_CDATA_AS_TEXT,
-                                          &data, NULL);
+  if (is_precompiled (buffer, length))
+    {
+      GError *tmp_error = NULL;
 
-  if (!g_markup_parse_context_parse (data.ctx, buffer, length, error))
-    goto out;
+      replay_precompiled (&data, buffer, length, &tmp_error);
+      if (tmp_error)
+        {
+          g_propagate_error (error, tmp_error);
+          goto out;
+        }
+    }
+  else
+    {
+      data.ctx = g_markup_parse_context_new (&parser,
+                                              G_MARKUP_TREAT_CDATA_AS_TEXT,
+                                              &data, NULL);
+
+      if (!g_markup_parse_context_parse (data.ctx, buffer, length, error))
+        goto out;
+    }
 
   _gtk_builder_finish (builder);
   if (_gtk_builder_lookup_failed (builder, error))
@@ -1309,7 +1572,7 @@ _gtk_builder_parser_parse_buffer (GtkBuilder   *builder,
   g_slist_free (data.finalizers);
   g_free (data.domain);
   g_hash_table_destroy (data.object_ids);
-  g_markup_parse_context_free (data.ctx);
+  g_clear_pointer (&data.ctx, g_markup_parse_context_free);
 
   /* restore the original domain */
   gtk_builder_set_translation_domain (builder, domain);
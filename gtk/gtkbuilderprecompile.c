@@ -0,0 +1,382 @@
+/* gtkbuilderprecompile.c
+ * Copyright (C) 2018 Red Hat, Inc.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Library General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Library General Public License for more details.
+ *
+ * You should have received a copy of the GNU Library General Public
+ * License along with this library. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/* This file only uses public API, it is also built into
+ * gtk4-builder-tool for its precompile command.
+ */
+
+#include "config.h"
+
+#include <string.h>
+
+#include <gtk/gtk.h>
+#include "gtkbuilderprivate.h"
+
+typedef struct {
+  GtkBuilder *builder;
+  GHashTable *string_ids;
+  GString *strings;
+  guint n_strings;
+  GByteArray *records;
+  GPtrArray *classes;
+  gint markup_depth;
+  GString *markup;
+  gint markup_line;
+  gint markup_col;
+  GString *value;
+  gchar *property_class;
+  gchar *property_name;
+  gboolean canonicalize;
+} PrecompileData;
+
+/* The elements GtkBuilder handles itself. Everything else is
+ * handed to buildable or menu parsers and kept as markup.
+ */
+static const gchar *builder_elements[] = {
+  "interface",
+  "requires",
+  "object",
+  "template",
+  "child",
+  "property",
+  "signal",
+  "placeholder",
+  NULL
+};
+
+static guint32
+precompile_string (PrecompileData *data,
+                   const gchar    *string)
+{
+  gpointer id;
+
+  if (g_hash_table_lookup_extended (data->string_ids, string, NULL, &id))
+    return GPOINTER_TO_UINT (id);
+
+  g_string_append_len (data->strings, string, strlen (string) + 1);
+  g_hash_table_insert (data->string_ids, g_strdup (string), GUINT_TO_POINTER (data->n_strings));
+
+  return data->n_strings++;
+}
+
+static void
+precompile_uint32 (PrecompileData *data,
+                   guint32         value)
+{
+  value = GUINT32_TO_LE (value);
+  g_byte_array_append (data->records, (const guint8 *) &value, sizeof (value));
+}
+
+static void
+precompile_record (PrecompileData *data,
+                   guint32         type,
+                   const gchar    *string)
+{
+  precompile_uint32 (data, type);
+  precompile_uint32 (data, precompile_string (data, string));
+}
+
+/* Turn enum, flags and boolean values into numbers, which
+ * GtkBuilder parses without looking up names or nicks.
+ */
+static gchar *
+canonicalize_value (PrecompileData *data,
+                    const gchar    *class_name,
+                    const gchar    *property_name,
+                    const gchar    *string)
+{
+  GType type;
+  GObjectClass *class;
+  GParamSpec *pspec;
+  GValue value = G_VALUE_INIT;
+  gchar *result = NULL;
+
+  type = gtk_builder_get_type_from_name (data->builder, class_name);
+  if (!G_TYPE_IS_OBJECT (type))
+    return NULL;
+
+  class = g_type_class_ref (type);
+  pspec = g_object_class_find_property (class, property_name);
+  g_type_class_unref (class);
+
+  if (pspec == NULL ||
+      !(G_IS_PARAM_SPEC_BOOLEAN (pspec) ||
+        G_IS_PARAM_SPEC_ENUM (pspec) ||
+        G_IS_PARAM_SPEC_FLAGS (pspec)))
+    return NULL;
+
+  if (!gtk_builder_value_from_string_type (data->builder,
+                                           G_PARAM_SPEC_VALUE_TYPE (pspec),
+                                           string, &value, NULL))
+    return NULL;
+
+  if (G_VALUE_HOLDS_BOOLEAN (&value))
+    result = g_strdup (g_value_get_boolean (&value) ? "1" : "0");
+  else if (G_VALUE_HOLDS_ENUM (&value) && g_value_get_enum (&value) >= 0)
+    result = g_strdup_printf ("%d", g_value_get_enum (&value));
+  else if (G_VALUE_HOLDS_FLAGS (&value))
+    result = g_strdup_printf ("%u", g_value_get_flags (&value));
+
+  g_value_unset (&value);
+
+  return result;
+}
+
+static void
+precompile_start_element (GMarkupParseContext  *context,
+                          const gchar          *element_name,
+                          const gchar         **attribute_names,
+                          const gchar         **attribute_values,
+                          gpointer              user_data,
+                          GError              **error)
+{
+  PrecompileData *data = user_data;
+  gint line, col;
+  guint n_attributes, i;
+
+  if (data->markup_depth > 0 ||
+      !g_strv_contains (builder_elements, element_name))
+    {
+      if (data->markup_depth == 0)
+        {
+          g_markup_parse_context_get_position (context, &data->markup_line, &data->markup_col);
+          g_string_set_size (data->markup, 0);
+        }
+      data->markup_depth++;
+
+      g_string_append_printf (data->markup, "<%s", element_name);
+      for (i = 0; attribute_names[i]; i++)
+        {
+          gchar *escaped = g_markup_escape_text (attribute_values[i], -1);
+          g_string_append_printf (data->markup, " %s=\"%s\"", attribute_names[i], escaped);
+          g_free (escaped);
+        }
+      g_string_append_c (data->markup, '>');
+      return;
+    }
+
+  if (strcmp (element_name, "object") == 0 ||
+      strcmp (element_name, "template") == 0)
+    {
+      const gchar *class_name = NULL;
+
+      for (i = 0; attribute_names[i]; i++)
+        {
+          /* The template type is usually not known here, but
+           * its parent is */
+          if (strcmp (attribute_names[i], "class") == 0 && class_name == NULL)
+            class_name = attribute_values[i];
+          else if (strcmp (attribute_names[i], "parent") == 0)
+            class_name = attribute_values[i];
+        }
+
+      g_ptr_array_add (data->classes, g_strdup (class_name));
+    }
+  else if (strcmp (element_name, "property") == 0)
+    {
+      data->canonicalize = data->classes->len > 0;
+      for (i = 0; attribute_names[i]; i++)
+        {
+          if (strcmp (attribute_names[i], "name") == 0)
+            data->property_name = g_strdup (attribute_values[i]);
+          else if (strcmp (attribute_names[i], "comments") != 0)
+            data->canonicalize = FALSE;
+        }
+
+      if (data->canonicalize)
+        data->property_class = g_strdup (g_ptr_array_index (data->classes, data->classes->len - 1));
+
+      data->value = g_string_new ("");
+    }
+
+  n_attributes = 0;
+  for (i = 0; attribute_names[i]; i++)
+    {
+      /* Translator comments are only for the translators */
+      if (strcmp (element_name, "property") == 0 &&
+          strcmp (attribute_names[i], "comments") == 0)
+        continue;
+      n_attributes++;
+    }
+
+  g_markup_parse_context_get_position (context, &line, &col);
+
+  precompile_record (data, GTK_BUILDER_RECORD_START_ELEMENT, element_name);
+  precompile_uint32 (data, line);
+  precompile_uint32 (data, col);
+  precompile_uint32 (data, n_attributes);
+  for (i = 0; attribute_names[i]; i++)
+    {
+      if (strcmp (element_name, "property") == 0 &&
+          strcmp (attribute_names[i], "comments") == 0)
+        continue;
+      precompile_uint32 (data, precompile_string (data, attribute_names[i]));
+      precompile_uint32 (data, precompile_string (data, attribute_values[i]));
+    }
+}
+
+static void
+precompile_end_element (GMarkupParseContext  *context,
+                        const gchar          *element_name,
+                        gpointer              user_data,
+                        GError              **error)
+{
+  PrecompileData *data = user_data;
+
+  if (data->markup_depth > 0)
+    {
+      g_string_append_printf (data->markup, "</%s>", element_name);
+
+      data->markup_depth--;
+      if (data->markup_depth == 0)
+        {
+          precompile_record (data, GTK_BUILDER_RECORD_MARKUP, data->markup->str);
+          precompile_uint32 (data, data->markup_line);
+          precompile_uint32 (data, data->markup_col);
+        }
+      return;
+    }
+
+  if (strcmp (element_name, "object") == 0 ||
+      strcmp (element_name, "template") == 0)
+    {
+      g_ptr_array_remove_index (data->classes, data->classes->len - 1);
+    }
+  else if (strcmp (element_name, "property") == 0)
+    {
+      gchar *canonical = NULL;
+
+      if (data->canonicalize && data->property_class && data->property_name)
+        canonical = canonicalize_value (data, data->property_class, data->property_name, data->value->str);
+
+      if (canonical)
+        precompile_record (data, GTK_BUILDER_RECORD_TEXT, canonical);
+      else if (data->value->len > 0)
+        precompile_record (data, GTK_BUILDER_RECORD_TEXT, data->value->str);
+
+      g_free (canonical);
+      g_clear_pointer (&data->property_class, g_free);
+      g_clear_pointer (&data->property_name, g_free);
+      g_string_free (data->value, TRUE);
+      data->value = NULL;
+    }
+
+  precompile_record (data, GTK_BUILDER_RECORD_END_ELEMENT, element_name);
+}
+
+static void
+precompile_text (GMarkupParseContext  *context,
+                 const gchar          *text,
+                 gsize                 text_len,
+                 gpointer              user_data,
+                 GError              **error)
+{
+  PrecompileData *data = user_data;
+
+  if (data->markup_depth > 0)
+    {
+      gchar *escaped = g_markup_escape_text (text, text_len);
+      g_string_append (data->markup, escaped);
+      g_free (escaped);
+    }
+  else if (data->value)
+    g_string_append_len (data->value, text, text_len);
+
+  /* Text anywhere else is ignored by GtkBuilder */
+}
+
+static const GMarkupParser precompile_parser = {
+  precompile_start_element,
+  precompile_end_element,
+  precompile_text,
+  NULL,
+  NULL
+};
+
+/*< private >
+ * _gtk_builder_precompile:
+ * @builder: a #GtkBuilder, used to look up types
+ * @buffer: a UI definition in XML
+ * @length: the length of @buffer, or -1 if it is nul-terminated
+ * @error: return location for an error
+ *
+ * Converts a UI definition to the precompiled format that is
+ * described in gtkbuilderprivate.h.
+ *
+ * Returns: (nullable): the precompiled data, or %NULL if @buffer
+ *     could not be parsed
+ */
+GBytes *
+_gtk_builder_precompile (GtkBuilder   *builder,
+                         const gchar  *buffer,
+                         gssize        length,
+                         GError      **error)
+{
+  GMarkupParseContext *context;
+  PrecompileData data;
+  GString *result;
+  guint32 header[3];
+  gboolean ret;
+
+  memset (&data, 0, sizeof (PrecompileData));
+  data.builder = builder;
+  data.string_ids = g_hash_table_new_full (g_str_hash, g_str_equal, g_free, NULL);
+  data.strings = g_string_new (NULL);
+  data.records = g_byte_array_new ();
+  data.classes = g_ptr_array_new_with_free_func (g_free);
+  data.markup = g_string_new (NULL);
+
+  context = g_markup_parse_context_new (&precompile_parser,
+                                        G_MARKUP_TREAT_CDATA_AS_TEXT,
+                                        &data, NULL);
+
+  ret = g_markup_parse_context_parse (context, buffer, length, error) &&
+        g_markup_parse_context_end_parse (context, error);
+
+  g_markup_parse_context_free (context);
+
+  result = NULL;
+  if (ret)
+    {
+      header[0] = GUINT32_TO_LE (GTK_BUILDER_PRECOMPILED_VERSION);
+      header[1] = GUINT32_TO_LE (data.n_strings);
+      header[2] = GUINT32_TO_LE (data.strings->len);
+
+      result = g_string_new (NULL);
+      g_string_append_len (result, GTK_BUILDER_PRECOMPILED_MAGIC, GTK_BUILDER_PRECOMPILED_MAGIC_LEN);
+      g_string_append_len (result, (const gchar *) header, sizeof (header));
+      g_string_append_len (result, data.strings->str, data.strings->len);
+      while (result->len % 4 != 0)
+        g_string_append_c (result, '\0');
+      g_string_append_len (result, (const gchar *) data.records->data, data.records->len);
+    }
+
+  g_hash_table_unref (data.string_ids);
+  g_string_free (data.strings, TRUE);
+  g_byte_array_unref (data.records);
+  g_ptr_array_unref (data.classes);
+  g_string_free (data.markup, TRUE);
+  g_free (data.property_class);
+  g_free (data.property_name);
+  if (data.value)
+    g_string_free (data.value, TRUE);
+
+  if (result == NULL)
+    return NULL;
+
+  return g_string_free_to_bytes (result);
+}
@@ -105,6 +105,9 @@ typedef struct {
   SubParser *subparser;
   GMarkupParseContext *ctx;
   const gchar *filename;
+  /* the position when replaying precompiled data */
+  gint line;
+  gint col;
   GSList *finalizers;
   GSList *custom_finalizers;
 
@@ -120,6 +123,42 @@ typedef struct {
 
 typedef GType (*GTypeGetFunc) (void);
 
+/* Precompiled .ui data, as written by gtk-builder-tool precompile.
+ *
+ * The data starts with the magic, followed by the format version,
+ * the number of strings and the size of the string table. The
+ * string table holds all element names, attribute names, attribute
+ * values and texts, each nul-terminated, and is padded to a
+ * multiple of 4 bytes. It is followed by the records:
+ *
+ * GTK_BUILDER_RECORD_START_ELEMENT: name, line, col, n_attributes,
+ *     then n_attributes pairs of name and value
+ * GTK_BUILDER_RECORD_END_ELEMENT: name
+ * GTK_BUILDER_RECORD_TEXT: text
+ * GTK_BUILDER_RECORD_MARKUP: markup, line, col
+ *
+ * The record type and all fields are little-endian 32-bit numbers,
+ * strings are given by their index in the string table. MARKUP
+ * records hold a whole element, including its children, as XML.
+ * They are used for custom tags and menus, whose parsers need a
+ * GMarkupParseContext.
+ */
+#define GTK_BUILDER_PRECOMPILED_MAGIC "GBU\0"
+#define GTK_BUILDER_PRECOMPILED_MAGIC_LEN 4
+#define GTK_BUILDER_PRECOMPILED_VERSION 1
+
+enum {
+  GTK_BUILDER_RECORD_START_ELEMENT = 1,
+  GTK_BUILDER_RECORD_END_ELEMENT,
+  GTK_BUILDER_RECORD_TEXT,
+  GTK_BUILDER_RECORD_MARKUP
+};
+
+GBytes *  _gtk_builder_precompile (GtkBuilder   *builder,
+                                   const gchar  *buffer,
+                                   gssize        length,
+                                   GError      **error);
+
 /* Things only GtkBuilder should use */
 void _gtk_builder_parser_parse_buffer (GtkBuilder *builder,
                                        const gchar *filename,
@@ -3524,6 +3524,48 @@ gtk_cell_area_request_renderer (GtkCellArea        *area,
     }
 }
 
+static void
+get_attribute_columns (GtkCellRenderer *renderer,
+                       CellInfo        *info,
+                       gpointer         user_data)
+{
+  GArray *columns = user_data;
+  GSList *l;
+
+  for (l = info->attributes; l; l = l->next)
+    {
+      CellAttribute *attribute = l->data;
+
+      g_array_append_val (columns, attribute->column);
+    }
+}
+
+static gboolean
+cell_info_has_func (GtkCellRenderer *renderer,
+                    CellInfo        *info,
+                    gpointer         user_data)
+{
+  return info->func != NULL;
+}
+
+gboolean
+_gtk_cell_area_get_attribute_columns (GtkCellArea *area,
+                                      GArray      *columns)
+{
+  GtkCellAreaPrivate *priv;
+
+  g_return_val_if_fail (GTK_IS_CELL_AREA (area), FALSE);
+
+  priv = area->priv;
+
+  if (g_hash_table_find (priv->cell_info, (GHRFunc) cell_info_has_func, NULL))
+    return FALSE;
+
+  g_hash_table_foreach (priv->cell_info, (GHFunc) get_attribute_columns, columns);
+
+  return TRUE;
+}
+
 void
 _gtk_cell_area_set_cell_data_func_with_proxy (GtkCellArea           *area,
 					      GtkCellRenderer       *cell,
@@ -529,6 +529,12 @@ void                 _gtk_cell_area_set_cell_data_func_with_proxy  (GtkCellArea
 								    GDestroyNotify         destroy,
 								    gpointer               proxy);
 
+/* Appends the model columns the attributes of all cells are mapped to.
+ * Returns FALSE if a cell data function may set other properties.
+ */
+gboolean             _gtk_cell_area_get_attribute_columns          (GtkCellArea           *area,
+								    GArray                *columns);
+
 G_END_DECLS
 
 #endif /* __GTK_CELL_AREA_H__ */
@@ -178,10 +178,10 @@ static void           cell_info_free         (CellInfo              *info);
 static gint           cell_info_find         (CellInfo              *info,
                                               GtkCellRenderer       *renderer);
 
-static AllocatedCell *allocated_cell_new     (GtkCellRenderer       *renderer,
+static void           allocated_cell_append  (GArray                *cells,
+                                              GtkCellRenderer       *renderer,
                                               gint                   position,
                                               gint                   size);
-static void           allocated_cell_free    (AllocatedCell         *cell);
 static GList         *list_consecutive_cells (GtkCellAreaBox        *box);
 static gint           count_expand_groups    (GtkCellAreaBox        *box);
 static void           context_weak_notify    (GtkCellAreaBox        *box,
@@ -190,7 +190,7 @@ static void           reset_contexts         (GtkCellAreaBox        *box);
 static void           init_context_groups    (GtkCellAreaBox        *box);
 static void           init_context_group     (GtkCellAreaBox        *box,
                                               GtkCellAreaBoxContext *context);
-static GSList        *get_allocated_cells    (GtkCellAreaBox        *box,
+static GArray        *get_allocated_cells    (GtkCellAreaBox        *box,
                                               GtkCellAreaBoxContext *context,
                                               GtkWidget             *widget,
                                               gint                   width,
@@ -211,6 +211,11 @@ struct _GtkCellAreaBoxPrivate
 
   GSList          *contexts;
 
+  /* Changes whenever attributes are applied for a row, or the cells
+   * change, so that cached cell allocations are not used for another row
+   */
+  guint            row_stamp;
+
   GtkOrientation   orientation;
   gint             spacing;
 
@@ -411,24 +416,19 @@ cell_info_find (CellInfo        *info,
   return (info->renderer == renderer) ? 0 : -1;
 }
 
-static AllocatedCell *
-allocated_cell_new (GtkCellRenderer *renderer,
-                    gint             position,
-                    gint             size)
+static void
+allocated_cell_append (GArray          *cells,
+                       GtkCellRenderer *renderer,
+                       gint             position,
+                       gint             size)
 {
-  AllocatedCell *cell = g_slice_new (AllocatedCell);
+  AllocatedCell cell;
 
-  cell->renderer = renderer;
-  cell->position = position;
-  cell->size     = size;
+  cell.renderer = renderer;
+  cell.position = position;
+  cell.size     = size;
 
-  return cell;
-}
-
-static void
-allocated_cell_free (AllocatedCell *cell)
-{
-  g_slice_free (AllocatedCell, cell);
+  g_array_append_val (cells, cell);
 }
 
 static GList *
@@ -489,6 +489,8 @@ cell_groups_rebuild (GtkCellAreaBox *box)
   guint                  id = 0;
   gboolean               last_cell_fixed = FALSE;
 
+  priv->row_stamp++;
+
   cell_groups_clear (box);
 
   if (!priv->cells)
@@ -645,6 +647,8 @@ reset_contexts (GtkCellAreaBox *box)
   GtkCellAreaBoxPrivate *priv = box->priv;
   GSList                *l;
 
+  priv->row_stamp++;
+
   /* When the box layout changes, contexts need to
    * be reset and sizes for the box get requested again
    */
@@ -661,15 +665,15 @@ reset_contexts (GtkCellAreaBox *box)
  * is not done when each area gets a different size in the orientation
  * of the box.
  */
-static GSList *
+static void
 allocate_cells_manually (GtkCellAreaBox        *box,
                          GtkWidget             *widget,
                          gint                   width,
-                         gint                   height)
+                         gint                   height,
+                         GArray                *allocated_cells)
 {
   GtkCellAreaBoxPrivate    *priv = box->priv;
   GList                    *cells, *l;
-  GSList                   *allocated_cells = NULL;
   GtkRequestedSize         *sizes;
   gint                      i;
   gint                      nvisible = 0, nexpand = 0, group_expand;
@@ -678,7 +682,7 @@ allocate_cells_manually (GtkCellAreaBox        *box,
   gboolean                  rtl;
 
   if (!priv->cells)
-    return NULL;
+    return;
 
   /* For vertical oriented boxes, we just let the cell renderers
    * realign themselves for rtl
@@ -700,7 +704,7 @@ allocate_cells_manually (GtkCellAreaBox        *box,
   if (nvisible <= 0)
     {
       g_list_free (cells);
-      return NULL;
+      return;
     }
 
   if (priv->orientation == GTK_ORIENTATION_HORIZONTAL)
@@ -756,7 +760,6 @@ allocate_cells_manually (GtkCellAreaBox        *box,
   for (i = 0; i < nvisible; i++)
     {
       CellInfo      *info = sizes[i].data;
-      AllocatedCell *cell;
 
       if (info->expand)
         {
@@ -769,13 +772,11 @@ allocate_cells_manually (GtkCellAreaBox        *box,
         }
 
       if (rtl)
-        cell = allocated_cell_new (info->renderer,
-                                   full_size - (position + sizes[i].minimum_size),
-                                   sizes[i].minimum_size);
+        allocated_cell_append (allocated_cells, info->renderer,
+                               full_size - (position + sizes[i].minimum_size),
+                               sizes[i].minimum_size);
       else
-        cell = allocated_cell_new (info->renderer, position, sizes[i].minimum_size);
-
-      allocated_cells = g_slist_prepend (allocated_cells, cell);
+        allocated_cell_append (allocated_cells, info->renderer, position, sizes[i].minimum_size);
 
       position += sizes[i].minimum_size;
       position += priv->spacing;
@@ -783,36 +784,33 @@ allocate_cells_manually (GtkCellAreaBox        *box,
 
   g_free (sizes);
   g_list_free (cells);
-
-  /* Note it might not be important to reverse the list here at all,
-   * we have the correct positions, no need to allocate from left to right
-   */
-  return g_slist_reverse (allocated_cells);
 }
 
-/* Returns an allocation for each cell in the orientation of the box,
- * used in ->render()/->event() implementations to get a straight-forward
- * list of allocated cells to operate on.
+/* Computes an allocation for each cell in the orientation of the box,
+ * in the order the cells are laid out.
  */
-static GSList *
-get_allocated_cells (GtkCellAreaBox        *box,
-                     GtkCellAreaBoxContext *context,
-                     GtkWidget             *widget,
-                     gint                   width,
-                     gint                   height)
+static void
+compute_allocated_cells (GtkCellAreaBox        *box,
+                         GtkCellAreaBoxContext *context,
+                         GtkWidget             *widget,
+                         gint                   width,
+                         gint                   height,
+                         GArray                *allocated_cells)
 {
   GtkCellAreaBoxAllocation *group_allocs;
   GtkCellArea              *area = GTK_CELL_AREA (box);
   GtkCellAreaBoxPrivate    *priv = box->priv;
   GList                    *cell_list;
-  GSList                   *allocated_cells = NULL;
   gint                      i, j, n_allocs, position;
   gint                      for_size, full_size;
   gboolean                  rtl;
 
   group_allocs = _gtk_cell_area_box_context_get_orientation_allocs (context, &n_allocs);
   if (!group_allocs)
-    return allocate_cells_manually (box, widget, width, height);
+    {
+      allocate_cells_manually (box, widget, width, height, allocated_cells);
+      return;
+    }
 
   if (priv->orientation == GTK_ORIENTATION_HORIZONTAL)
     {
@@ -843,7 +841,6 @@ get_allocated_cells (GtkCellAreaBox        *box,
       if (group->n_cells == 1)
         {
           CellInfo      *info = group->cells->data;
-          AllocatedCell *cell;
 	  gint           cell_position, cell_size;
 
 	  if (!gtk_cell_renderer_get_visible (info->renderer))
@@ -870,15 +867,13 @@ get_allocated_cells (GtkCellAreaBox        *box,
 	    }
 
           if (rtl)
-            cell = allocated_cell_new (info->renderer,
-                                       full_size - (cell_position + cell_size), cell_size);
+            allocated_cell_append (allocated_cells, info->renderer,
+                                   full_size - (cell_position + cell_size), cell_size);
           else
-            cell = allocated_cell_new (info->renderer, cell_position, cell_size);
+            allocated_cell_append (allocated_cells, info->renderer, cell_position, cell_size);
 
 	  position += cell_size;
           position += priv->spacing;
-
-          allocated_cells = g_slist_prepend (allocated_cells, cell);
         }
       else
         {
@@ -950,7 +945,6 @@ get_allocated_cells (GtkCellAreaBox        *box,
           for (j = 0; j < visible_cells; j++)
             {
               CellInfo      *info = sizes[j].data;
-              AllocatedCell *cell;
 
               if (info->expand)
                 {
@@ -963,13 +957,11 @@ get_allocated_cells (GtkCellAreaBox        *box,
                 }
 
               if (rtl)
-                cell = allocated_cell_new (info->renderer,
-                                           full_size - (cell_position + sizes[j].minimum_size),
-                                           sizes[j].minimum_size);
+                allocated_cell_append (allocated_cells, info->renderer,
+                                       full_size - (cell_position + sizes[j].minimum_size),
+                                       sizes[j].minimum_size);
               else
-                cell = allocated_cell_new (info->renderer, cell_position, sizes[j].minimum_size);
-
-              allocated_cells = g_slist_prepend (allocated_cells, cell);
+                allocated_cell_append (allocated_cells, info->renderer, cell_position, sizes[j].minimum_size);
 
               cell_position += sizes[j].minimum_size;
               cell_position += priv->spacing;
@@ -982,11 +974,41 @@ get_allocated_cells (GtkCellAreaBox        *box,
     }
 
   g_free (group_allocs);
+}
 
-  /* Note it might not be important to reverse the list here at all,
-   * we have the correct positions, no need to allocate from left to right
-   */
-  return g_slist_reverse (allocated_cells);
+/* Returns an allocation for each cell in the orientation of the box,
+ * used in ->render()/->event() implementations to get a straight-forward
+ * list of allocated cells to operate on.
+ *
+ * Rendering, event handling and focus drawing of a row each ask for
+ * the same allocations, so they are kept in the context until the
+ * attributes of another row are applied or the sizes change.
+ */
+static GArray *
+get_allocated_cells (GtkCellAreaBox        *box,
+                     GtkCellAreaBoxContext *context,
+                     GtkWidget             *widget,
+                     gint                   width,
+                     gint                   height)
+{
+  GtkCellAreaBoxPrivate *priv = box->priv;
+  GArray                *allocated_cells;
+  gboolean               rtl;
+
+  rtl = gtk_widget_get_direction (widget) == GTK_TEXT_DIR_RTL;
+
+  allocated_cells = _gtk_cell_area_box_context_get_row_cells (context, widget, priv->row_stamp,
+                                                             width, height, rtl);
+  if (allocated_cells)
+    return allocated_cells;
+
+  allocated_cells = g_array_new (FALSE, FALSE, sizeof (AllocatedCell));
+  compute_allocated_cells (box, context, widget, width, height, allocated_cells);
+
+  _gtk_cell_area_box_context_set_row_cells (context, widget, priv->row_stamp,
+                                            width, height, rtl, allocated_cells);
+
+  return allocated_cells;
 }
 
 
@@ -1149,9 +1171,10 @@ gtk_cell_area_box_foreach_alloc (GtkCellArea          *area,
   GtkCellAreaBox        *box      = GTK_CELL_AREA_BOX (area);
   GtkCellAreaBoxPrivate *priv     = box->priv;
   GtkCellAreaBoxContext *box_context = GTK_CELL_AREA_BOX_CONTEXT (context);
-  GSList                *allocated_cells, *l;
+  GArray                *allocated_cells;
   GdkRectangle           cell_alloc, cell_background;
   gboolean               rtl;
+  guint                  i;
 
   rtl = (priv->orientation == GTK_ORIENTATION_HORIZONTAL &&
          gtk_widget_get_direction (widget) == GTK_TEXT_DIR_RTL);
@@ -1164,9 +1187,9 @@ gtk_cell_area_box_foreach_alloc (GtkCellArea          *area,
   allocated_cells = get_allocated_cells (box, box_context, widget,
                                          cell_area->width, cell_area->height);
 
-  for (l = allocated_cells; l; l = l->next)
+  for (i = 0; i < allocated_cells->len; i++)
     {
-      AllocatedCell *cell = l->data;
+      AllocatedCell *cell = &g_array_index (allocated_cells, AllocatedCell, i);
 
       if (priv->orientation == GTK_ORIENTATION_HORIZONTAL)
         {
@@ -1197,7 +1220,7 @@ gtk_cell_area_box_foreach_alloc (GtkCellArea          *area,
        * this can happen in the expander GtkTreeViewColumn where only the
        * deepest depth column receives the allocation... shallow columns
        * receive more width). */
-      if (!l->next)
+      if (i + 1 == allocated_cells->len)
         {
           if (rtl)
             {
@@ -1233,7 +1256,7 @@ gtk_cell_area_box_foreach_alloc (GtkCellArea          *area,
 
       if (priv->orientation == GTK_ORIENTATION_HORIZONTAL)
         {
-          if (l == allocated_cells)
+          if (i == 0)
             {
               /* Add the depth to the first cell */
               if (rtl)
@@ -1248,7 +1271,7 @@ gtk_cell_area_box_foreach_alloc (GtkCellArea          *area,
                 }
             }
 
-          if (l->next == NULL)
+          if (i + 1 == allocated_cells->len)
             {
               /* Grant this cell the remaining space */
               int remain = cell_background.x - background_area->x;
@@ -1264,13 +1287,13 @@ gtk_cell_area_box_foreach_alloc (GtkCellArea          *area,
         }
       else
         {
-          if (l == allocated_cells)
+          if (i == 0)
             {
               cell_background.height += cell_background.y - background_area->y;
               cell_background.y       = background_area->y;
             }
 
-          if (l->next == NULL)
+          if (i + 1 == allocated_cells->len)
               cell_background.height =
                 background_area->height - (cell_background.y - background_area->y);
 
@@ -1282,7 +1305,7 @@ gtk_cell_area_box_foreach_alloc (GtkCellArea          *area,
         break;
     }
 
-  g_slist_free_full (allocated_cells, (GDestroyNotify)allocated_cell_free);
+  g_array_unref (allocated_cells);
 }
 
 static void
@@ -1301,6 +1324,8 @@ gtk_cell_area_box_apply_attributes (GtkCellArea  *area,
     (gtk_cell_area_box_parent_class)->apply_attributes (area, tree_model, iter,
 							is_expander, is_expanded);
 
+  priv->row_stamp++;
+
   /* Update visible state for cell groups */
   for (i = 0; i < priv->groups->len; i++)
     {
@@ -1387,6 +1412,8 @@ gtk_cell_area_box_set_cell_property (GtkCellArea        *area,
       break;
     }
 
+  box->priv->row_stamp++;
+
   /* Groups need to be rebuilt */
   if (rebuild)
     cell_groups_rebuild (box);
@@ -29,6 +29,9 @@
 static void      _gtk_cell_area_box_context_finalize              (GObject               *object);
 
 /* GtkCellAreaContextClass */
+static void      _gtk_cell_area_box_context_allocate              (GtkCellAreaContext    *context,
+                                                                   gint                   width,
+                                                                   gint                   height);
 static void      _gtk_cell_area_box_context_reset                 (GtkCellAreaContext    *context);
 static void      _gtk_cell_area_box_context_get_preferred_height_for_width (GtkCellAreaContext *context,
                                                                            gint                width,
@@ -78,10 +81,29 @@ struct _GtkCellAreaBoxContextPrivate
 
   /* Whether each group is aligned */
   gboolean  *align;
+
+  /* Cell allocations of the last row, shared between rendering,
+   * event handling and focus drawing of the same row
+   */
+  GArray         *row_cells;
+  GtkWidget      *row_widget;
+  guint           row_stamp;
+  gint            row_width;
+  gint            row_height;
+  gboolean        row_rtl;
 };
 
 G_DEFINE_TYPE_WITH_PRIVATE (GtkCellAreaBoxContext, _gtk_cell_area_box_context, GTK_TYPE_CELL_AREA_CONTEXT)
 
+static void
+clear_row_cells (GtkCellAreaBoxContext *context)
+{
+  GtkCellAreaBoxContextPrivate *priv = context->priv;
+
+  g_clear_pointer (&priv->row_cells, g_array_unref);
+  priv->row_widget = NULL;
+}
+
 static void
 free_cache_array (GArray *array)
 {
@@ -188,6 +210,7 @@ _gtk_cell_area_box_context_class_init (GtkCellAreaBoxContextClass *class)
   /* GObjectClass */
   object_class->finalize = _gtk_cell_area_box_context_finalize;
 
+  context_class->allocate                       = _gtk_cell_area_box_context_allocate;
   context_class->reset                          = _gtk_cell_area_box_context_reset;
   context_class->get_preferred_height_for_width = _gtk_cell_area_box_context_get_preferred_height_for_width;
   context_class->get_preferred_width_for_height = _gtk_cell_area_box_context_get_preferred_width_for_height;
@@ -210,12 +233,29 @@ _gtk_cell_area_box_context_finalize (GObject *object)
   g_free (priv->expand);
   g_free (priv->align);
 
+  clear_row_cells (box_context);
+
   G_OBJECT_CLASS (_gtk_cell_area_box_context_parent_class)->finalize (object);
 }
 
 /*************************************************************
  *                    GtkCellAreaContextClass                *
  *************************************************************/
+static void
+_gtk_cell_area_box_context_allocate (GtkCellAreaContext *context,
+                                     gint                width,
+                                     gint                height)
+{
+  gint old_width, old_height;
+
+  gtk_cell_area_context_get_allocation (context, &old_width, &old_height);
+  if (width != old_width || height != old_height)
+    clear_row_cells (GTK_CELL_AREA_BOX_CONTEXT (context));
+
+  GTK_CELL_AREA_CONTEXT_CLASS
+    (_gtk_cell_area_box_context_parent_class)->allocate (context, width, height);
+}
+
 static void
 _gtk_cell_area_box_context_reset (GtkCellAreaContext *context)
 {
@@ -224,6 +264,8 @@ _gtk_cell_area_box_context_reset (GtkCellAreaContext *context)
   CachedSize                   *size;
   gint                          i;
 
+  clear_row_cells (box_context);
+
   for (i = 0; i < priv->base_widths->len; i++)
     {
       size = &g_array_index (priv->base_widths, CachedSize, i);
@@ -455,7 +497,10 @@ _gtk_cell_area_box_context_push_group_width (GtkCellAreaBoxContext *box_context,
     }
 
   if (grew)
-    _gtk_cell_area_box_context_sum (box_context, GTK_ORIENTATION_HORIZONTAL, -1, NULL, NULL);
+    {
+      clear_row_cells (box_context);
+      _gtk_cell_area_box_context_sum (box_context, GTK_ORIENTATION_HORIZONTAL, -1, NULL, NULL);
+    }
 }
 
 void
@@ -482,6 +527,9 @@ _gtk_cell_area_box_context_push_group_height_for_width  (GtkCellAreaBoxContext *
     }
 
   size = &g_array_index (group_array, CachedSize, group_idx);
+  if (minimum_height > size->min_size || natural_height > size->nat_size)
+    clear_row_cells (box_context);
+
   size->min_size = MAX (size->min_size, minimum_height);
   size->nat_size = MAX (size->nat_size, natural_height);
 }
@@ -514,7 +562,10 @@ _gtk_cell_area_box_context_push_group_height (GtkCellAreaBoxContext *box_context
     }
 
   if (grew)
-    _gtk_cell_area_box_context_sum (box_context, GTK_ORIENTATION_VERTICAL, -1, NULL, NULL);
+    {
+      clear_row_cells (box_context);
+      _gtk_cell_area_box_context_sum (box_context, GTK_ORIENTATION_VERTICAL, -1, NULL, NULL);
+    }
 }
 
 void
@@ -541,6 +592,9 @@ _gtk_cell_area_box_context_push_group_width_for_height (GtkCellAreaBoxContext *b
     }
 
   size = &g_array_index (group_array, CachedSize, group_idx);
+  if (minimum_width > size->min_size || natural_width > size->nat_size)
+    clear_row_cells (box_context);
+
   size->min_size = MAX (size->min_size, minimum_width);
   size->nat_size = MAX (size->nat_size, natural_width);
 }
@@ -852,3 +906,51 @@ _gtk_cell_area_box_context_get_orientation_allocs (GtkCellAreaBoxContext *contex
 
   return allocs;
 }
+
+/* Returns the cell allocations stored with
+ * _gtk_cell_area_box_context_set_row_cells() if they were computed for
+ * the same row (as told by @row_stamp), size and direction, or %NULL.
+ * Returns a new reference, the cache may be cleared while the caller
+ * still iterates over the cells.
+ */
+GArray *
+_gtk_cell_area_box_context_get_row_cells (GtkCellAreaBoxContext *context,
+                                         GtkWidget             *widget,
+                                         guint                  row_stamp,
+                                         gint                   width,
+                                         gint                   height,
+                                         gboolean               rtl)
+{
+  GtkCellAreaBoxContextPrivate *priv = context->priv;
+
+  if (priv->row_cells  == NULL ||
+      priv->row_widget != widget ||
+      priv->row_stamp  != row_stamp ||
+      priv->row_width  != width ||
+      priv->row_height != height ||
+      priv->row_rtl    != rtl)
+    return NULL;
+
+  return g_array_ref (priv->row_cells);
+}
+
+void
+_gtk_cell_area_box_context_set_row_cells (GtkCellAreaBoxContext *context,
+                                         GtkWidget             *widget,
+                                         guint                  row_stamp,
+                                         gint                   width,
+                                         gint                   height,
+                                         gboolean               rtl,
+                                         GArray                *cells)
+{
+  GtkCellAreaBoxContextPrivate *priv = context->priv;
+
+  clear_row_cells (context);
+
+  priv->row_cells      = g_array_ref (cells);
+  priv->row_widget     = widget;
+  priv->row_stamp      = row_stamp;
+  priv->row_width      = width;
+  priv->row_height     = height;
+  priv->row_rtl        = rtl;
+}
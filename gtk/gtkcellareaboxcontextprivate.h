@@ -132,6 +132,21 @@ GtkCellAreaBoxAllocation *
 _gtk_cell_area_box_context_get_orientation_allocs (GtkCellAreaBoxContext *context,
                                                   gint                  *n_allocs);
 
+/* Per-row cell allocations, shared between render and event handling */
+GArray *_gtk_cell_area_box_context_get_row_cells (GtkCellAreaBoxContext *context,
+                                                 GtkWidget             *widget,
+                                                 guint                  row_stamp,
+                                                 gint                   width,
+                                                 gint                   height,
+                                                 gboolean               rtl);
+void    _gtk_cell_area_box_context_set_row_cells (GtkCellAreaBoxContext *context,
+                                                 GtkWidget             *widget,
+                                                 guint                  row_stamp,
+                                                 gint                   width,
+                                                 gint                   height,
+                                                 gboolean               rtl,
+                                                 GArray                *cells);
+
 G_END_DECLS
 
 #endif /* __GTK_CELL_AREA_BOX_CONTEXT_H__ */
@@ -431,7 +431,12 @@ gtk_cell_renderer_pixbuf_get_size (GtkCellRenderer    *cell,
       pixbuf_height = gdk_paintable_get_intrinsic_height (paintable);
     }
   else
-    pixbuf_width = pixbuf_height = gtk_icon_helper_get_size (icon_helper); 
+    {
+      pixbuf_width = pixbuf_height = gtk_icon_helper_get_size (icon_helper);
+
+      /* Rows are usually measured some time before they are drawn */
+      gtk_icon_helper_prefetch (icon_helper);
+    }
 
   g_object_unref (icon_helper);
   gtk_style_context_restore (context);
@@ -23,6 +23,7 @@
 #include "gtkentry.h"
 #include "gtkintl.h"
 #include "gtkmarshalers.h"
+#include "gtkpango.h"
 #include "gtkprivate.h"
 #include "gtksizerequest.h"
 #include "gtksnapshot.h"
@@ -31,6 +32,7 @@
 #include "a11y/gtktextcellaccessible.h"
 
 #include <stdlib.h>
+#include <string.h>
 
 /**
  * SECTION:gtkcellrenderertext
@@ -159,6 +161,44 @@ static GParamSpec *text_cell_renderer_props [LAST_PROP];
 
 #define GTK_CELL_RENDERER_TEXT_PATH "gtk-cell-renderer-text-path"
 
+/* Number of shaped layouts kept around per renderer. A tree view asks
+ * the same renderer for every row of its column, so this needs to cover
+ * a screenful of rows with a couple of layouts each.
+ */
+#define LAYOUT_CACHE_SIZE 256
+
+typedef struct _LayoutCacheEntry LayoutCacheEntry;
+
+/* Everything create_layout() looks at, so that a cached layout is only
+ * reused when creating a new one would give the same result.
+ */
+struct _LayoutCacheEntry
+{
+  guint hash;
+
+  gchar                *text;
+  gchar                *markup;
+  PangoAttrList        *attrs;
+  PangoContext         *context;
+  guint                 context_serial;
+  PangoFontDescription *font;
+  PangoLanguage        *language;
+  GdkRGBA               foreground;
+  gdouble               font_scale;
+  PangoUnderline        underline_style;
+  PangoEllipsizeMode    ellipsize;
+  PangoWrapMode         wrap_mode;
+  PangoAlignment        align;
+  gint                  rise;
+  gint                  wrap_width;
+  gint                  area_width;
+  gint                  width;
+  guint                 state;
+
+  PangoLayout *layout;
+  GList        lru_link;
+};
+
 struct _GtkCellRendererTextPrivate
 {
   GtkWidget *entry;
@@ -174,8 +214,12 @@ struct _GtkCellRendererTextPrivate
   PangoWrapMode         wrap_mode;
 
   gchar *text;
+  gchar *markup;
   gchar *placeholder_text;
 
+  GHashTable *layout_cache;
+  GQueue      layout_lru;
+
   gdouble font_scale;
 
   gint rise;
@@ -651,8 +695,12 @@ gtk_cell_renderer_text_finalize (GObject *object)
   pango_font_description_free (priv->font);
 
   g_free (priv->text);
+  g_free (priv->markup);
   g_free (priv->placeholder_text);
 
+  if (priv->layout_cache)
+    g_hash_table_destroy (priv->layout_cache);
+
   if (priv->extra_attrs)
     pango_attr_list_unref (priv->extra_attrs);
 
@@ -1054,6 +1102,7 @@ gtk_cell_renderer_text_set_property (GObject      *object,
             pango_attr_list_unref (priv->extra_attrs);
           priv->extra_attrs = NULL;
           priv->markup_set = FALSE;
+          g_clear_pointer (&priv->markup, g_free);
         }
 
       priv->text = g_value_dup_string (value);
@@ -1067,6 +1116,9 @@ gtk_cell_renderer_text_set_property (GObject      *object,
       priv->extra_attrs = g_value_get_boxed (value);
       if (priv->extra_attrs)
         pango_attr_list_ref (priv->extra_attrs);
+
+      /* The attributes no longer match the markup they came from */
+      g_clear_pointer (&priv->markup, g_free);
       break;
     case PROP_MARKUP:
       {
@@ -1076,7 +1128,7 @@ gtk_cell_renderer_text_set_property (GObject      *object,
 	PangoAttrList *attrs = NULL;
 
 	str = g_value_get_string (value);
-	if (str && !pango_parse_markup (str, -1, 0, &attrs, &text, NULL, &error))
+	if (str && !_gtk_pango_parse_markup (str, 0, &attrs, &text, NULL, &error))
 	  {
 	    g_warning ("Failed to set text from markup due to error parsing markup: %s",
 		       error->message);
@@ -1092,6 +1144,9 @@ gtk_cell_renderer_text_set_property (GObject      *object,
 	priv->text = text;
 	priv->extra_attrs = attrs;
         priv->markup_set = TRUE;
+
+        g_free (priv->markup);
+        priv->markup = g_strdup (str);
       }
       break;
 
@@ -1425,10 +1480,10 @@ add_attr (PangoAttrList  *attr_list,
 }
 
 static PangoLayout*
-get_layout (GtkCellRendererText *celltext,
-            GtkWidget           *widget,
-            const GdkRectangle  *cell_area,
-            GtkCellRendererState flags)
+create_layout (GtkCellRendererText *celltext,
+               GtkWidget           *widget,
+               const GdkRectangle  *cell_area,
+               GtkCellRendererState flags)
 {
   GtkCellRendererTextPrivate *priv = celltext->priv;
   PangoAttrList *attr_list;
@@ -1589,6 +1644,229 @@ get_layout (GtkCellRendererText *celltext,
   return layout;
 }
 
+/* Layout cache
+ *
+ * Shaping text is by far the most expensive part of measuring and
+ * rendering a cell, and tree views ask for the same layouts over and
+ * over: once per size request, again for every snapshot, and again
+ * whenever the pointer moves across a row. So we keep the most recently
+ * used layouts, keyed by the state that went into creating them, and
+ * hand out references to those. Callers must not modify the layouts
+ * they get; they ask for a layout of a specific width instead.
+ */
+
+#define STATE_HAS_AREA (1 << 0)
+#define STATE_RTL      (1 << 1)
+#define STATE_WIDTH    (1 << 2)
+#define STATE_SHIFT    3
+
+static guint
+layout_cache_entry_hash (gconstpointer data)
+{
+  const LayoutCacheEntry *entry = data;
+
+  return entry->hash;
+}
+
+static gboolean
+layout_cache_entry_equal (gconstpointer a,
+                          gconstpointer b)
+{
+  const LayoutCacheEntry *ea = a;
+  const LayoutCacheEntry *eb = b;
+
+  return ea->hash == eb->hash &&
+         ea->context == eb->context &&
+         ea->context_serial == eb->context_serial &&
+         ea->state == eb->state &&
+         ea->area_width == eb->area_width &&
+         ea->width == eb->width &&
+         ea->wrap_width == eb->wrap_width &&
+         ea->wrap_mode == eb->wrap_mode &&
+         ea->ellipsize == eb->ellipsize &&
+         ea->align == eb->align &&
+         ea->underline_style == eb->underline_style &&
+         ea->rise == eb->rise &&
+         ea->font_scale == eb->font_scale &&
+         ea->language == eb->language &&
+         ea->attrs == eb->attrs &&
+         gdk_rgba_equal (&ea->foreground, &eb->foreground) &&
+         g_strcmp0 (ea->text, eb->text) == 0 &&
+         g_strcmp0 (ea->markup, eb->markup) == 0 &&
+         pango_font_description_equal (ea->font, eb->font);
+}
+
+static void
+layout_cache_entry_free (gpointer data)
+{
+  LayoutCacheEntry *entry = data;
+
+  g_free (entry->text);
+  g_free (entry->markup);
+  if (entry->attrs)
+    pango_attr_list_unref (entry->attrs);
+  pango_font_description_free (entry->font);
+  g_object_unref (entry->layout);
+
+  g_slice_free (LayoutCacheEntry, entry);
+}
+
+static void
+layout_cache_key_init (LayoutCacheEntry    *key,
+                       GtkCellRendererText *celltext,
+                       GtkWidget           *widget,
+                       const GdkRectangle  *cell_area,
+                       GtkCellRendererState flags,
+                       gboolean             width_set,
+                       gint                 width)
+{
+  GtkCellRendererTextPrivate *priv = celltext->priv;
+  gint xpad;
+
+  memset (key, 0, sizeof (LayoutCacheEntry));
+
+  key->text = priv->text;
+  key->markup = priv->markup;
+  key->attrs = priv->markup ? NULL : priv->extra_attrs;
+  key->context = gtk_widget_get_pango_context (widget);
+  key->context_serial = pango_context_get_serial (key->context);
+  key->font = priv->font;
+  key->font_scale = priv->scale_set ? priv->font_scale : 1.0;
+  key->underline_style = priv->underline_set ? priv->underline_style : PANGO_UNDERLINE_NONE;
+  key->rise = priv->rise_set ? priv->rise : 0;
+  key->language = priv->language_set ? priv->language : NULL;
+  key->ellipsize = priv->ellipsize_set ? priv->ellipsize : PANGO_ELLIPSIZE_NONE;
+  key->align = priv->align_set ? priv->align : PANGO_ALIGN_LEFT;
+  key->wrap_width = priv->wrap_width;
+  key->wrap_mode = priv->wrap_mode;
+  key->area_width = -1;
+  key->width = -1;
+
+  if (priv->single_paragraph)
+    key->state |= 1 << STATE_SHIFT;
+  if (priv->strikethrough_set && priv->strikethrough)
+    key->state |= 2 << STATE_SHIFT;
+
+  if (cell_area)
+    {
+      gtk_cell_renderer_get_padding (GTK_CELL_RENDERER (celltext), &xpad, NULL);
+      key->state |= STATE_HAS_AREA;
+      key->area_width = cell_area->width - xpad * 2;
+
+      if (priv->foreground_set && (flags & GTK_CELL_RENDERER_SELECTED) == 0)
+        key->foreground = priv->foreground;
+    }
+
+  if ((flags & GTK_CELL_RENDERER_PRELIT) == GTK_CELL_RENDERER_PRELIT)
+    key->state |= 4 << STATE_SHIFT;
+
+  if (!priv->align_set && gtk_widget_get_direction (widget) == GTK_TEXT_DIR_RTL)
+    key->state |= STATE_RTL;
+
+  /* Without a wrap width, create_layout() leaves the width unset
+   * already, so don't keep a second copy of the same layout.
+   */
+  if (width_set && !(width == -1 && priv->wrap_width == -1))
+    {
+      key->state |= STATE_WIDTH;
+      key->width = width;
+    }
+
+  key->hash = (key->text ? g_str_hash (key->text) : 0) ^
+              (key->markup ? g_str_hash (key->markup) : 0) ^
+              pango_font_description_hash (key->font) ^
+              GPOINTER_TO_UINT (key->context) ^
+              (key->state << 24) ^
+              ((guint) key->area_width << 12) ^
+              (guint) key->width;
+}
+
+static PangoLayout *
+lookup_layout (GtkCellRendererText *celltext,
+               GtkWidget           *widget,
+               const GdkRectangle  *cell_area,
+               GtkCellRendererState flags,
+               gboolean             width_set,
+               gint                 width)
+{
+  GtkCellRendererTextPrivate *priv = celltext->priv;
+  LayoutCacheEntry key, *entry;
+  PangoLayout *layout;
+
+  /* The placeholder depends on the style context's colors, which we
+   * cannot cheaply check, and is rare enough not to matter.
+   */
+  if (show_placeholder_text (celltext))
+    {
+      layout = create_layout (celltext, widget, cell_area, flags);
+      if (width_set)
+        pango_layout_set_width (layout, width);
+      return layout;
+    }
+
+  if (priv->layout_cache == NULL)
+    priv->layout_cache = g_hash_table_new_full (layout_cache_entry_hash,
+                                                layout_cache_entry_equal,
+                                                NULL,
+                                                layout_cache_entry_free);
+
+  layout_cache_key_init (&key, celltext, widget, cell_area, flags, width_set, width);
+
+  entry = g_hash_table_lookup (priv->layout_cache, &key);
+  if (entry)
+    {
+      g_queue_unlink (&priv->layout_lru, &entry->lru_link);
+      g_queue_push_head_link (&priv->layout_lru, &entry->lru_link);
+
+      return g_object_ref (entry->layout);
+    }
+
+  layout = create_layout (celltext, widget, cell_area, flags);
+  if (key.state & STATE_WIDTH)
+    pango_layout_set_width (layout, width);
+
+  entry = g_slice_new (LayoutCacheEntry);
+  *entry = key;
+  entry->text = g_strdup (key.text);
+  entry->markup = g_strdup (key.markup);
+  if (entry->attrs)
+    pango_attr_list_ref (entry->attrs);
+  entry->font = pango_font_description_copy (key.font);
+  entry->layout = g_object_ref (layout);
+  entry->lru_link.data = entry;
+
+  g_hash_table_add (priv->layout_cache, entry);
+  g_queue_push_head_link (&priv->layout_lru, &entry->lru_link);
+
+  if (priv->layout_lru.length > LAYOUT_CACHE_SIZE)
+    {
+      GList *last = g_queue_pop_tail_link (&priv->layout_lru);
+
+      g_hash_table_remove (priv->layout_cache, last->data);
+    }
+
+  return layout;
+}
+
+static PangoLayout *
+get_layout (GtkCellRendererText *celltext,
+            GtkWidget           *widget,
+            const GdkRectangle  *cell_area,
+            GtkCellRendererState flags)
+{
+  return lookup_layout (celltext, widget, cell_area, flags, FALSE, 0);
+}
+
+static PangoLayout *
+get_layout_for_width (GtkCellRendererText *celltext,
+                      GtkWidget           *widget,
+                      const GdkRectangle  *cell_area,
+                      GtkCellRendererState flags,
+                      gint                 width)
+{
+  return lookup_layout (celltext, widget, cell_area, flags, TRUE, width);
+}
+
 
 static void
 get_size (GtkCellRenderer    *cell,
@@ -1734,10 +2012,11 @@ gtk_cell_renderer_text_snapshot (GtkCellRenderer      *cell,
   gtk_cell_renderer_get_padding (cell, &xpad, &ypad);
 
   if (priv->ellipsize_set && priv->ellipsize != PANGO_ELLIPSIZE_NONE)
-    pango_layout_set_width (layout,
-			    (cell_area->width - x_offset - 2 * xpad) * PANGO_SCALE);
-  else if (priv->wrap_width == -1)
-    pango_layout_set_width (layout, -1);
+    {
+      g_object_unref (layout);
+      layout = get_layout_for_width (celltext, widget, cell_area, flags,
+                                     (cell_area->width - x_offset - 2 * xpad) * PANGO_SCALE);
+    }
 
   pango_layout_get_pixel_extents (layout, NULL, &rect);
   x_offset = x_offset - rect.x;
@@ -2006,10 +2285,8 @@ gtk_cell_renderer_text_get_preferred_width (GtkCellRenderer *cell,
 
   gtk_cell_renderer_get_padding (cell, &xpad, NULL);
 
-  layout = get_layout (celltext, widget, NULL, 0);
-
   /* Fetch the length of the complete unwrapped text */
-  pango_layout_set_width (layout, -1);
+  layout = get_layout_for_width (celltext, widget, NULL, 0, -1);
   pango_layout_get_extents (layout, NULL, &rect);
   text_width = rect.width;
 
@@ -2079,9 +2356,7 @@ gtk_cell_renderer_text_get_preferred_height_for_width (GtkCellRenderer *cell,
 
   gtk_cell_renderer_get_padding (cell, &xpad, &ypad);
 
-  layout = get_layout (celltext, widget, NULL, 0);
-
-  pango_layout_set_width (layout, (width - xpad * 2) * PANGO_SCALE);
+  layout = get_layout_for_width (celltext, widget, NULL, 0, (width - xpad * 2) * PANGO_SCALE);
   pango_layout_get_pixel_size (layout, NULL, &text_height);
 
   if (minimum_height)
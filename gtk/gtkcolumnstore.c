@@ -0,0 +1,1923 @@
+/* GTK - The GIMP Toolkit
+ * Copyright (C) 2018 Red Hat, Inc.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "config.h"
+
+#include "gtkcolumnstore.h"
+
+#include <string.h>
+#include <gobject/gvaluecollector.h>
+
+#include "gtktreedatalist.h"
+#include "gtkintl.h"
+
+/**
+ * SECTION:gtkcolumnstore
+ * @Short_description: A list model that stores its data by column
+ * @Title: GtkColumnStore
+ * @See_also: #GtkListStore, #GtkTreeModel
+ *
+ * #GtkColumnStore is a list model for use with a #GtkTreeView that offers
+ * the same data model as #GtkListStore, but stores the values of each
+ * column in a single contiguous array instead of keeping a linked list
+ * of values per row.
+ *
+ * Numbers are stored unboxed in arrays of their natural size, and equal
+ * strings are shared between all rows, so large tables with many columns
+ * need considerably less memory. Sorting by one of the columns with the
+ * default sort function compares the stored values directly, without
+ * going through #GValue. The gtk_column_store_get_int() family of
+ * functions gives the same direct access to applications.
+ *
+ * Unlike #GtkListStore, the iters of a #GtkColumnStore only stay valid
+ * as long as no rows are added, removed or reordered.
+ *
+ * GtkColumnStore supports the same column types as #GtkListStore.
+ */
+
+typedef struct _GtkColumnStoreColumn GtkColumnStoreColumn;
+typedef struct _InternedString InternedString;
+
+struct _GtkColumnStoreColumn
+{
+  GType type;
+  GType fundamental;
+  gsize element_size;
+  guchar *data; /* n_allocated * element_size bytes */
+};
+
+struct _InternedString
+{
+  guint ref_count;
+  gchar string[1];
+};
+
+struct _GtkColumnStore
+{
+  GObject parent_instance;
+
+  GtkColumnStoreColumn *columns;
+  gint n_columns;
+  guint n_rows;
+  guint n_allocated;
+  gint stamp;
+
+  /* gchar * => InternedString *, the key is owned by the value */
+  GHashTable *strings;
+
+  gint sort_column_id;
+  GtkSortType order;
+  GList *sort_list;
+  GtkTreeIterCompareFunc default_sort_func;
+  gpointer default_sort_data;
+  GDestroyNotify default_sort_destroy;
+};
+
+struct _GtkColumnStoreClass
+{
+  GObjectClass parent_class;
+};
+
+#define GTK_COLUMN_STORE_IS_SORTED(store) \
+  ((store)->sort_column_id != GTK_TREE_SORTABLE_UNSORTED_SORT_COLUMN_ID)
+
+#define CELL(column, row) ((gpointer) ((column)->data + (gsize) (row) * (column)->element_size))
+
+#define ROW(iter) GPOINTER_TO_UINT ((iter)->user_data)
+
+static void gtk_column_store_tree_model_init (GtkTreeModelIface    *iface);
+static void gtk_column_store_sortable_init   (GtkTreeSortableIface *iface);
+
+G_DEFINE_TYPE_WITH_CODE (GtkColumnStore, gtk_column_store, G_TYPE_OBJECT,
+                         G_IMPLEMENT_INTERFACE (GTK_TYPE_TREE_MODEL,
+                                                gtk_column_store_tree_model_init)
+                         G_IMPLEMENT_INTERFACE (GTK_TYPE_TREE_SORTABLE,
+                                                gtk_column_store_sortable_init))
+
+static gboolean
+iter_is_valid (GtkTreeIter    *iter,
+               GtkColumnStore *store)
+{
+  return iter != NULL &&
+         iter->stamp == store->stamp &&
+         ROW (iter) < store->n_rows;
+}
+
+static inline void
+set_iter (GtkColumnStore *store,
+          GtkTreeIter    *iter,
+          guint           row)
+{
+  iter->stamp = store->stamp;
+  iter->user_data = GUINT_TO_POINTER (row);
+}
+
+/* Strings */
+
+static const gchar *
+gtk_column_store_intern_string (GtkColumnStore *store,
+                                const gchar    *string)
+{
+  InternedString *interned;
+  gsize len;
+
+  if (string == NULL)
+    return NULL;
+
+  interned = g_hash_table_lookup (store->strings, string);
+  if (interned)
+    {
+      interned->ref_count++;
+      return interned->string;
+    }
+
+  len = strlen (string);
+  interned = g_malloc (G_STRUCT_OFFSET (InternedString, string) + len + 1);
+  interned->ref_count = 1;
+  memcpy (interned->string, string, len + 1);
+  g_hash_table_insert (store->strings, interned->string, interned);
+
+  return interned->string;
+}
+
+static void
+gtk_column_store_release_string (GtkColumnStore *store,
+                                 const gchar    *string)
+{
+  InternedString *interned;
+
+  if (string == NULL)
+    return;
+
+  interned = (InternedString *) (string - G_STRUCT_OFFSET (InternedString, string));
+  interned->ref_count--;
+  if (interned->ref_count == 0)
+    g_hash_table_remove (store->strings, string);
+}
+
+/* Cells */
+
+static inline GType
+get_fundamental_type (GType type)
+{
+  GType result;
+
+  result = G_TYPE_FUNDAMENTAL (type);
+
+  if (result == G_TYPE_INTERFACE)
+    {
+      if (g_type_is_a (type, G_TYPE_OBJECT))
+        result = G_TYPE_OBJECT;
+    }
+
+  return result;
+}
+
+static gsize
+get_element_size (GType fundamental)
+{
+  switch (fundamental)
+    {
+    case G_TYPE_CHAR:
+    case G_TYPE_UCHAR:
+      return 1;
+    case G_TYPE_BOOLEAN:
+    case G_TYPE_INT:
+    case G_TYPE_UINT:
+    case G_TYPE_ENUM:
+    case G_TYPE_FLAGS:
+      return sizeof (gint);
+    case G_TYPE_LONG:
+    case G_TYPE_ULONG:
+      return sizeof (glong);
+    case G_TYPE_INT64:
+    case G_TYPE_UINT64:
+      return sizeof (gint64);
+    case G_TYPE_FLOAT:
+      return sizeof (gfloat);
+    case G_TYPE_DOUBLE:
+      return sizeof (gdouble);
+    default:
+      return sizeof (gpointer);
+    }
+}
+
+static void
+gtk_column_store_clear_cell (GtkColumnStore       *store,
+                             GtkColumnStoreColumn *column,
+                             guint                 row)
+{
+  gpointer cell = CELL (column, row);
+  gpointer p = column->element_size == sizeof (gpointer) ? *(gpointer *) cell : NULL;
+
+  switch (column->fundamental)
+    {
+    case G_TYPE_STRING:
+      gtk_column_store_release_string (store, p);
+      break;
+    case G_TYPE_OBJECT:
+      if (p)
+        g_object_unref (p);
+      break;
+    case G_TYPE_BOXED:
+      if (p)
+        g_boxed_free (column->type, p);
+      break;
+    case G_TYPE_VARIANT:
+      if (p)
+        g_variant_unref (p);
+      break;
+    default:
+      break;
+    }
+
+  memset (cell, 0, column->element_size);
+}
+
+static void
+gtk_column_store_cell_to_value (GtkColumnStoreColumn *column,
+                                guint                 row,
+                                GValue               *value)
+{
+  gpointer cell = CELL (column, row);
+
+  g_value_init (value, column->type);
+
+  switch (column->fundamental)
+    {
+    case G_TYPE_BOOLEAN:
+      g_value_set_boolean (value, *(gint *) cell);
+      break;
+    case G_TYPE_CHAR:
+      g_value_set_schar (value, *(gint8 *) cell);
+      break;
+    case G_TYPE_UCHAR:
+      g_value_set_uchar (value, *(guint8 *) cell);
+      break;
+    case G_TYPE_INT:
+      g_value_set_int (value, *(gint *) cell);
+      break;
+    case G_TYPE_UINT:
+      g_value_set_uint (value, *(guint *) cell);
+      break;
+    case G_TYPE_LONG:
+      g_value_set_long (value, *(glong *) cell);
+      break;
+    case G_TYPE_ULONG:
+      g_value_set_ulong (value, *(gulong *) cell);
+      break;
+    case G_TYPE_INT64:
+      g_value_set_int64 (value, *(gint64 *) cell);
+      break;
+    case G_TYPE_UINT64:
+      g_value_set_uint64 (value, *(guint64 *) cell);
+      break;
+    case G_TYPE_ENUM:
+      g_value_set_enum (value, *(gint *) cell);
+      break;
+    case G_TYPE_FLAGS:
+      g_value_set_flags (value, *(guint *) cell);
+      break;
+    case G_TYPE_FLOAT:
+      g_value_set_float (value, *(gfloat *) cell);
+      break;
+    case G_TYPE_DOUBLE:
+      g_value_set_double (value, *(gdouble *) cell);
+      break;
+    case G_TYPE_STRING:
+      g_value_set_string (value, *(const gchar **) cell);
+      break;
+    case G_TYPE_POINTER:
+      g_value_set_pointer (value, *(gpointer *) cell);
+      break;
+    case G_TYPE_BOXED:
+      g_value_set_boxed (value, *(gpointer *) cell);
+      break;
+    case G_TYPE_VARIANT:
+      g_value_set_variant (value, *(gpointer *) cell);
+      break;
+    case G_TYPE_OBJECT:
+      g_value_set_object (value, *(gpointer *) cell);
+      break;
+    default:
+      g_warning ("%s: Unsupported type (%s) retrieved.", G_STRLOC, g_type_name (column->type));
+      break;
+    }
+}
+
+/* @value must hold the column's type */
+static void
+gtk_column_store_value_to_cell (GtkColumnStore       *store,
+                                GtkColumnStoreColumn *column,
+                                guint                 row,
+                                const GValue         *value)
+{
+  gpointer cell = CELL (column, row);
+  gpointer old;
+
+  switch (column->fundamental)
+    {
+    case G_TYPE_BOOLEAN:
+      *(gint *) cell = g_value_get_boolean (value);
+      break;
+    case G_TYPE_CHAR:
+      *(gint8 *) cell = g_value_get_schar (value);
+      break;
+    case G_TYPE_UCHAR:
+      *(guint8 *) cell = g_value_get_uchar (value);
+      break;
+    case G_TYPE_INT:
+      *(gint *) cell = g_value_get_int (value);
+      break;
+    case G_TYPE_UINT:
+      *(guint *) cell = g_value_get_uint (value);
+      break;
+    case G_TYPE_LONG:
+      *(glong *) cell = g_value_get_long (value);
+      break;
+    case G_TYPE_ULONG:
+      *(gulong *) cell = g_value_get_ulong (value);
+      break;
+    case G_TYPE_INT64:
+      *(gint64 *) cell = g_value_get_int64 (value);
+      break;
+    case G_TYPE_UINT64:
+      *(guint64 *) cell = g_value_get_uint64 (value);
+      break;
+    case G_TYPE_ENUM:
+      *(gint *) cell = g_value_get_enum (value);
+      break;
+    case G_TYPE_FLAGS:
+      *(guint *) cell = g_value_get_flags (value);
+      break;
+    case G_TYPE_FLOAT:
+      *(gfloat *) cell = g_value_get_float (value);
+      break;
+    case G_TYPE_DOUBLE:
+      *(gdouble *) cell = g_value_get_double (value);
+      break;
+    case G_TYPE_POINTER:
+      *(gpointer *) cell = g_value_get_pointer (value);
+      break;
+    case G_TYPE_STRING:
+      old = *(gpointer *) cell;
+      *(const gchar **) cell = gtk_column_store_intern_string (store, g_value_get_string (value));
+      gtk_column_store_release_string (store, old);
+      break;
+    case G_TYPE_OBJECT:
+      old = *(gpointer *) cell;
+      *(gpointer *) cell = g_value_dup_object (value);
+      if (old)
+        g_object_unref (old);
+      break;
+    case G_TYPE_BOXED:
+      old = *(gpointer *) cell;
+      *(gpointer *) cell = g_value_dup_boxed (value);
+      if (old)
+        g_boxed_free (column->type, old);
+      break;
+    case G_TYPE_VARIANT:
+      old = *(gpointer *) cell;
+      *(gpointer *) cell = g_value_dup_variant (value);
+      if (old)
+        g_variant_unref (old);
+      break;
+    default:
+      g_warning ("%s: Unsupported type (%s) stored.", G_STRLOC, g_type_name (column->type));
+      break;
+    }
+}
+
+#define COMPARE_CELLS(type) G_STMT_START{ \
+  type value_a = *(type *) CELL (column, a); \
+  type value_b = *(type *) CELL (column, b); \
+  return (value_a > value_b) - (value_a < value_b); \
+}G_STMT_END
+
+/* Does what _gtk_tree_data_list_compare_func() does, without the GValues */
+static gint
+gtk_column_store_compare_cells (GtkColumnStoreColumn *column,
+                                guint                 a,
+                                guint                 b)
+{
+  const gchar *str_a, *str_b;
+
+  switch (column->fundamental)
+    {
+    case G_TYPE_BOOLEAN:
+    case G_TYPE_INT:
+    case G_TYPE_ENUM:
+      COMPARE_CELLS (gint);
+    case G_TYPE_UINT:
+    case G_TYPE_FLAGS:
+      COMPARE_CELLS (guint);
+    case G_TYPE_CHAR:
+      COMPARE_CELLS (gint8);
+    case G_TYPE_UCHAR:
+      COMPARE_CELLS (guint8);
+    case G_TYPE_LONG:
+      COMPARE_CELLS (glong);
+    case G_TYPE_ULONG:
+      COMPARE_CELLS (gulong);
+    case G_TYPE_INT64:
+      COMPARE_CELLS (gint64);
+    case G_TYPE_UINT64:
+      COMPARE_CELLS (guint64);
+    case G_TYPE_FLOAT:
+      COMPARE_CELLS (gfloat);
+    case G_TYPE_DOUBLE:
+      COMPARE_CELLS (gdouble);
+    case G_TYPE_STRING:
+      str_a = *(const gchar **) CELL (column, a);
+      str_b = *(const gchar **) CELL (column, b);
+      if (str_a == str_b)
+        return 0;
+      return g_utf8_collate (str_a ? str_a : "", str_b ? str_b : "");
+    default:
+      g_assert_not_reached ();
+      return 0;
+    }
+}
+
+#undef COMPARE_CELLS
+
+static gboolean
+can_compare_cells (GtkColumnStoreColumn *column)
+{
+  switch (column->fundamental)
+    {
+    case G_TYPE_POINTER:
+    case G_TYPE_BOXED:
+    case G_TYPE_OBJECT:
+    case G_TYPE_VARIANT:
+      return FALSE;
+    default:
+      return TRUE;
+    }
+}
+
+/* Rows */
+
+static void
+gtk_column_store_insert_rows (GtkColumnStore *store,
+                              guint           position,
+                              guint           n_rows)
+{
+  gint i;
+
+  if (store->n_rows + n_rows > store->n_allocated)
+    {
+      store->n_allocated = MAX (MAX (16, store->n_allocated * 2), store->n_rows + n_rows);
+      for (i = 0; i < store->n_columns; i++)
+        {
+          GtkColumnStoreColumn *column = &store->columns[i];
+
+          column->data = g_realloc_n (column->data, store->n_allocated, column->element_size);
+        }
+    }
+
+  for (i = 0; i < store->n_columns; i++)
+    {
+      GtkColumnStoreColumn *column = &store->columns[i];
+
+      memmove (CELL (column, position + n_rows),
+               CELL (column, position),
+               (store->n_rows - position) * column->element_size);
+      memset (CELL (column, position), 0, n_rows * column->element_size);
+    }
+
+  store->n_rows += n_rows;
+  store->stamp++;
+}
+
+static void
+gtk_column_store_remove_row (GtkColumnStore *store,
+                             guint           row)
+{
+  gint i;
+
+  for (i = 0; i < store->n_columns; i++)
+    {
+      GtkColumnStoreColumn *column = &store->columns[i];
+
+      gtk_column_store_clear_cell (store, column, row);
+      memmove (CELL (column, row),
+               CELL (column, row + 1),
+               (store->n_rows - row - 1) * column->element_size);
+    }
+
+  store->n_rows--;
+  store->stamp++;
+}
+
+static void
+gtk_column_store_move_row (GtkColumnStore *store,
+                           guint           from,
+                           guint           to)
+{
+  guchar tmp[MAX (sizeof (gint64), sizeof (gpointer))];
+  gint i;
+
+  for (i = 0; i < store->n_columns; i++)
+    {
+      GtkColumnStoreColumn *column = &store->columns[i];
+
+      memcpy (tmp, CELL (column, from), column->element_size);
+      if (from < to)
+        memmove (CELL (column, from), CELL (column, from + 1), (to - from) * column->element_size);
+      else
+        memmove (CELL (column, to + 1), CELL (column, to), (from - to) * column->element_size);
+      memcpy (CELL (column, to), tmp, column->element_size);
+    }
+
+  store->stamp++;
+}
+
+/* Sorting */
+
+typedef struct
+{
+  GtkColumnStore *store;
+  /* set if the cells can be compared directly */
+  GtkColumnStoreColumn *column;
+  /* collation keys of a string column, indexed by row */
+  gchar **keys;
+  GtkTreeIterCompareFunc func;
+  gpointer data;
+} SortData;
+
+static void
+sort_data_init (SortData       *sort,
+                GtkColumnStore *store,
+                gboolean        use_keys)
+{
+  sort->store = store;
+  sort->column = NULL;
+  sort->keys = NULL;
+  sort->func = NULL;
+  sort->data = NULL;
+
+  if (store->sort_column_id != GTK_TREE_SORTABLE_DEFAULT_SORT_COLUMN_ID)
+    {
+      GtkTreeDataSortHeader *header;
+
+      header = _gtk_tree_data_list_get_header (store->sort_list, store->sort_column_id);
+      g_return_if_fail (header != NULL);
+      g_return_if_fail (header->func != NULL);
+
+      sort->func = header->func;
+      sort->data = header->data;
+
+      if (header->func == _gtk_tree_data_list_compare_func &&
+          header->data == GINT_TO_POINTER (store->sort_column_id) &&
+          can_compare_cells (&store->columns[store->sort_column_id]))
+        sort->column = &store->columns[store->sort_column_id];
+    }
+  else
+    {
+      g_return_if_fail (store->default_sort_func != NULL);
+
+      sort->func = store->default_sort_func;
+      sort->data = store->default_sort_data;
+    }
+
+  if (use_keys && sort->column && sort->column->fundamental == G_TYPE_STRING)
+    {
+      guint i;
+
+      sort->keys = g_new (gchar *, store->n_rows);
+      for (i = 0; i < store->n_rows; i++)
+        {
+          const gchar *str = *(const gchar **) CELL (sort->column, i);
+
+          sort->keys[i] = g_utf8_collate_key (str ? str : "", -1);
+        }
+    }
+}
+
+static void
+sort_data_clear (SortData *sort)
+{
+  guint i;
+
+  if (sort->keys == NULL)
+    return;
+
+  for (i = 0; i < sort->store->n_rows; i++)
+    g_free (sort->keys[i]);
+  g_clear_pointer (&sort->keys, g_free);
+}
+
+static gint
+gtk_column_store_compare_rows (SortData *sort,
+                               guint     a,
+                               guint     b)
+{
+  GtkColumnStore *store = sort->store;
+  gint retval;
+
+  if (sort->keys)
+    {
+      retval = strcmp (sort->keys[a], sort->keys[b]);
+    }
+  else if (sort->column)
+    {
+      retval = gtk_column_store_compare_cells (sort->column, a, b);
+    }
+  else if (sort->func)
+    {
+      GtkTreeIter iter_a, iter_b;
+
+      set_iter (store, &iter_a, a);
+      set_iter (store, &iter_b, b);
+      retval = sort->func (GTK_TREE_MODEL (store), &iter_a, &iter_b, sort->data);
+    }
+  else
+    {
+      retval = 0;
+    }
+
+  if (store->order == GTK_SORT_DESCENDING)
+    {
+      if (retval > 0)
+        retval = -1;
+      else if (retval < 0)
+        retval = 1;
+    }
+
+  return retval;
+}
+
+static gint
+gtk_column_store_qsort_func (gconstpointer a,
+                             gconstpointer b,
+                             gpointer      data)
+{
+  return gtk_column_store_compare_rows (data, *(const gint *) a, *(const gint *) b);
+}
+
+static void
+gtk_column_store_sort (GtkColumnStore *store)
+{
+  GtkTreePath *path;
+  SortData sort;
+  gint *new_order;
+  guchar *data;
+  guint i;
+  gint c;
+
+  if (!GTK_COLUMN_STORE_IS_SORTED (store) || store->n_rows <= 1)
+    return;
+
+  new_order = g_new (gint, store->n_rows);
+  for (i = 0; i < store->n_rows; i++)
+    new_order[i] = i;
+
+  /* Fetch every key only once, stored rows don't move while sorting */
+  sort_data_init (&sort, store, TRUE);
+  g_qsort_with_data (new_order, store->n_rows, sizeof (gint), gtk_column_store_qsort_func, &sort);
+  sort_data_clear (&sort);
+
+  for (c = 0; c < store->n_columns; c++)
+    {
+      GtkColumnStoreColumn *column = &store->columns[c];
+
+      data = g_malloc_n (store->n_allocated, column->element_size);
+      for (i = 0; i < store->n_rows; i++)
+        memcpy (data + i * column->element_size, CELL (column, new_order[i]), column->element_size);
+      g_free (column->data);
+      column->data = data;
+    }
+  store->stamp++;
+
+  path = gtk_tree_path_new ();
+  gtk_tree_model_rows_reordered (GTK_TREE_MODEL (store), path, NULL, new_order);
+  gtk_tree_path_free (path);
+  g_free (new_order);
+}
+
+/* Returns the position @row needs to be moved to for the store to be sorted */
+static guint
+gtk_column_store_find_sorted_position (GtkColumnStore *store,
+                                       guint           row)
+{
+  SortData sort;
+  guint start, end, mid, other;
+
+  sort_data_init (&sort, store, FALSE);
+
+  /* Positions in the list of all the other rows */
+  start = 0;
+  end = store->n_rows - 1;
+  while (start < end)
+    {
+      mid = (start + end) / 2;
+      other = mid < row ? mid : mid + 1;
+      if (gtk_column_store_compare_rows (&sort, row, other) < 0)
+        end = mid;
+      else
+        start = mid + 1;
+    }
+
+  return start;
+}
+
+static gboolean
+gtk_column_store_row_is_sorted (GtkColumnStore *store,
+                                guint           row)
+{
+  SortData sort;
+
+  sort_data_init (&sort, store, FALSE);
+
+  if (row > 0 && gtk_column_store_compare_rows (&sort, row - 1, row) > 0)
+    return FALSE;
+
+  if (row + 1 < store->n_rows && gtk_column_store_compare_rows (&sort, row, row + 1) > 0)
+    return FALSE;
+
+  return TRUE;
+}
+
+/* Moves the row at @iter to its sorted position without emitting signals
+ * and updates @iter. Returns the old position.
+ */
+static guint
+gtk_column_store_resort_row (GtkColumnStore *store,
+                             GtkTreeIter    *iter)
+{
+  guint from, to;
+
+  from = ROW (iter);
+  if (gtk_column_store_row_is_sorted (store, from))
+    return from;
+
+  to = gtk_column_store_find_sorted_position (store, from);
+  gtk_column_store_move_row (store, from, to);
+  set_iter (store, iter, to);
+
+  return from;
+}
+
+static void
+gtk_column_store_emit_row_moved (GtkColumnStore *store,
+                                 guint           from,
+                                 guint           to)
+{
+  GtkTreePath *path;
+  gint *new_order;
+  guint i;
+
+  new_order = g_new (gint, store->n_rows);
+  for (i = 0; i < store->n_rows; i++)
+    {
+      if (i == to)
+        new_order[i] = from;
+      else if (from < to && i >= from && i < to)
+        new_order[i] = i + 1;
+      else if (from > to && i > to && i <= from)
+        new_order[i] = i - 1;
+      else
+        new_order[i] = i;
+    }
+
+  path = gtk_tree_path_new ();
+  gtk_tree_model_rows_reordered (GTK_TREE_MODEL (store), path, NULL, new_order);
+  gtk_tree_path_free (path);
+  g_free (new_order);
+}
+
+/* GObject */
+
+static void
+gtk_column_store_finalize (GObject *object)
+{
+  GtkColumnStore *store = GTK_COLUMN_STORE (object);
+  guint row;
+  gint i;
+
+  for (i = 0; i < store->n_columns; i++)
+    {
+      GtkColumnStoreColumn *column = &store->columns[i];
+
+      for (row = 0; row < store->n_rows; row++)
+        gtk_column_store_clear_cell (store, column, row);
+      g_free (column->data);
+    }
+  g_free (store->columns);
+
+  g_hash_table_unref (store->strings);
+
+  _gtk_tree_data_list_header_free (store->sort_list);
+
+  if (store->default_sort_destroy)
+    {
+      GDestroyNotify d = store->default_sort_destroy;
+
+      store->default_sort_destroy = NULL;
+      d (store->default_sort_data);
+      store->default_sort_data = NULL;
+    }
+
+  G_OBJECT_CLASS (gtk_column_store_parent_class)->finalize (object);
+}
+
+static void
+gtk_column_store_class_init (GtkColumnStoreClass *class)
+{
+  GObjectClass *object_class = G_OBJECT_CLASS (class);
+
+  object_class->finalize = gtk_column_store_finalize;
+}
+
+static void
+gtk_column_store_init (GtkColumnStore *store)
+{
+  store->stamp = g_random_int ();
+  store->strings = g_hash_table_new_full (g_str_hash, g_str_equal, NULL, g_free);
+  store->sort_column_id = GTK_TREE_SORTABLE_UNSORTED_SORT_COLUMN_ID;
+  store->order = GTK_SORT_ASCENDING;
+}
+
+/* GtkTreeModel */
+
+static GtkTreeModelFlags
+gtk_column_store_get_flags (GtkTreeModel *tree_model)
+{
+  return GTK_TREE_MODEL_LIST_ONLY;
+}
+
+static gint
+gtk_column_store_get_n_columns (GtkTreeModel *tree_model)
+{
+  GtkColumnStore *store = GTK_COLUMN_STORE (tree_model);
+
+  return store->n_columns;
+}
+
+static GType
+gtk_column_store_get_column_type (GtkTreeModel *tree_model,
+                                  gint          index)
+{
+  GtkColumnStore *store = GTK_COLUMN_STORE (tree_model);
+
+  g_return_val_if_fail (index < store->n_columns, G_TYPE_INVALID);
+
+  return store->columns[index].type;
+}
+
+static gboolean
+gtk_column_store_get_iter (GtkTreeModel *tree_model,
+                           GtkTreeIter  *iter,
+                           GtkTreePath  *path)
+{
+  GtkColumnStore *store = GTK_COLUMN_STORE (tree_model);
+  gint i;
+
+  if (gtk_tree_path_get_depth (path) != 1)
+    {
+      iter->stamp = 0;
+      return FALSE;
+    }
+
+  i = gtk_tree_path_get_indices (path)[0];
+  if (i < 0 || i >= store->n_rows)
+    {
+      iter->stamp = 0;
+      return FALSE;
+    }
+
+  set_iter (store, iter, i);
+
+  return TRUE;
+}
+
+static GtkTreePath *
+gtk_column_store_get_path (GtkTreeModel *tree_model,
+                           GtkTreeIter  *iter)
+{
+  GtkColumnStore *store = GTK_COLUMN_STORE (tree_model);
+
+  g_return_val_if_fail (iter->stamp == store->stamp, NULL);
+
+  if (ROW (iter) >= store->n_rows)
+    return NULL;
+
+  return gtk_tree_path_new_from_indices (ROW (iter), -1);
+}
+
+static void
+gtk_column_store_get_value (GtkTreeModel *tree_model,
+                            GtkTreeIter  *iter,
+                            gint          column,
+                            GValue       *value)
+{
+  GtkColumnStore *store = GTK_COLUMN_STORE (tree_model);
+
+  g_return_if_fail (column < store->n_columns);
+  g_return_if_fail (iter_is_valid (iter, store));
+
+  gtk_column_store_cell_to_value (&store->columns[column], ROW (iter), value);
+}
+
+static gboolean
+gtk_column_store_iter_next (GtkTreeModel *tree_model,
+                            GtkTreeIter  *iter)
+{
+  GtkColumnStore *store = GTK_COLUMN_STORE (tree_model);
+
+  g_return_val_if_fail (iter->stamp == store->stamp, FALSE);
+
+  if (ROW (iter) + 1 >= store->n_rows)
+    {
+      iter->stamp = 0;
+      return FALSE;
+    }
+
+  set_iter (store, iter, ROW (iter) + 1);
+
+  return TRUE;
+}
+
+static gboolean
+gtk_column_store_iter_previous (GtkTreeModel *tree_model,
+                                GtkTreeIter  *iter)
+{
+  GtkColumnStore *store = GTK_COLUMN_STORE (tree_model);
+
+  g_return_val_if_fail (iter->stamp == store->stamp, FALSE);
+
+  if (ROW (iter) == 0)
+    {
+      iter->stamp = 0;
+      return FALSE;
+    }
+
+  set_iter (store, iter, ROW (iter) - 1);
+
+  return TRUE;
+}
+
+static gboolean
+gtk_column_store_iter_children (GtkTreeModel *tree_model,
+                                GtkTreeIter  *iter,
+                                GtkTreeIter  *parent)
+{
+  GtkColumnStore *store = GTK_COLUMN_STORE (tree_model);
+
+  /* this is a list, nodes have no children */
+  if (parent || store->n_rows == 0)
+    {
+      iter->stamp = 0;
+      return FALSE;
+    }
+
+  set_iter (store, iter, 0);
+
+  return TRUE;
+}
+
+static gboolean
+gtk_column_store_iter_has_child (GtkTreeModel *tree_model,
+                                 GtkTreeIter  *iter)
+{
+  return FALSE;
+}
+
+static gint
+gtk_column_store_iter_n_children (GtkTreeModel *tree_model,
+                                  GtkTreeIter  *iter)
+{
+  GtkColumnStore *store = GTK_COLUMN_STORE (tree_model);
+
+  if (iter == NULL)
+    return store->n_rows;
+
+  g_return_val_if_fail (store->stamp == iter->stamp, -1);
+
+  return 0;
+}
+
+static gboolean
+gtk_column_store_iter_nth_child (GtkTreeModel *tree_model,
+                                 GtkTreeIter  *iter,
+                                 GtkTreeIter  *parent,
+                                 gint          n)
+{
+  GtkColumnStore *store = GTK_COLUMN_STORE (tree_model);
+
+  if (parent || n < 0 || n >= store->n_rows)
+    {
+      iter->stamp = 0;
+      return FALSE;
+    }
+
+  set_iter (store, iter, n);
+
+  return TRUE;
+}
+
+static gboolean
+gtk_column_store_iter_parent (GtkTreeModel *tree_model,
+                              GtkTreeIter  *iter,
+                              GtkTreeIter  *child)
+{
+  iter->stamp = 0;
+  return FALSE;
+}
+
+static void
+gtk_column_store_tree_model_init (GtkTreeModelIface *iface)
+{
+  iface->get_flags = gtk_column_store_get_flags;
+  iface->get_n_columns = gtk_column_store_get_n_columns;
+  iface->get_column_type = gtk_column_store_get_column_type;
+  iface->get_iter = gtk_column_store_get_iter;
+  iface->get_path = gtk_column_store_get_path;
+  iface->get_value = gtk_column_store_get_value;
+  iface->iter_next = gtk_column_store_iter_next;
+  iface->iter_previous = gtk_column_store_iter_previous;
+  iface->iter_children = gtk_column_store_iter_children;
+  iface->iter_has_child = gtk_column_store_iter_has_child;
+  iface->iter_n_children = gtk_column_store_iter_n_children;
+  iface->iter_nth_child = gtk_column_store_iter_nth_child;
+  iface->iter_parent = gtk_column_store_iter_parent;
+}
+
+/* GtkTreeSortable */
+
+static gboolean
+gtk_column_store_get_sort_column_id (GtkTreeSortable *sortable,
+                                     gint            *sort_column_id,
+                                     GtkSortType     *order)
+{
+  GtkColumnStore *store = GTK_COLUMN_STORE (sortable);
+
+  if (sort_column_id)
+    *sort_column_id = store->sort_column_id;
+  if (order)
+    *order = store->order;
+
+  if (store->sort_column_id == GTK_TREE_SORTABLE_DEFAULT_SORT_COLUMN_ID ||
+      store->sort_column_id == GTK_TREE_SORTABLE_UNSORTED_SORT_COLUMN_ID)
+    return FALSE;
+
+  return TRUE;
+}
+
+static void
+gtk_column_store_set_sort_column_id (GtkTreeSortable *sortable,
+                                     gint             sort_column_id,
+                                     GtkSortType      order)
+{
+  GtkColumnStore *store = GTK_COLUMN_STORE (sortable);
+
+  if (store->sort_column_id == sort_column_id &&
+      store->order == order)
+    return;
+
+  if (sort_column_id != GTK_TREE_SORTABLE_UNSORTED_SORT_COLUMN_ID)
+    {
+      if (sort_column_id != GTK_TREE_SORTABLE_DEFAULT_SORT_COLUMN_ID)
+        {
+          GtkTreeDataSortHeader *header;
+
+          header = _gtk_tree_data_list_get_header (store->sort_list, sort_column_id);
+
+          /* We want to make sure that we have a function */
+          g_return_if_fail (header != NULL);
+          g_return_if_fail (header->func != NULL);
+        }
+      else
+        {
+          g_return_if_fail (store->default_sort_func != NULL);
+        }
+    }
+
+  store->sort_column_id = sort_column_id;
+  store->order = order;
+
+  gtk_tree_sortable_sort_column_changed (sortable);
+
+  gtk_column_store_sort (store);
+}
+
+static void
+gtk_column_store_set_sort_func (GtkTreeSortable        *sortable,
+                                gint                    sort_column_id,
+                                GtkTreeIterCompareFunc  func,
+                                gpointer                data,
+                                GDestroyNotify          destroy)
+{
+  GtkColumnStore *store = GTK_COLUMN_STORE (sortable);
+
+  store->sort_list = _gtk_tree_data_list_set_header (store->sort_list,
+                                                     sort_column_id,
+                                                     func, data, destroy);
+
+  if (store->sort_column_id == sort_column_id)
+    gtk_column_store_sort (store);
+}
+
+static void
+gtk_column_store_set_default_sort_func (GtkTreeSortable        *sortable,
+                                        GtkTreeIterCompareFunc  func,
+                                        gpointer                data,
+                                        GDestroyNotify          destroy)
+{
+  GtkColumnStore *store = GTK_COLUMN_STORE (sortable);
+
+  if (store->default_sort_destroy)
+    {
+      GDestroyNotify d = store->default_sort_destroy;
+
+      store->default_sort_destroy = NULL;
+      d (store->default_sort_data);
+    }
+
+  store->default_sort_func = func;
+  store->default_sort_data = data;
+  store->default_sort_destroy = destroy;
+
+  if (store->sort_column_id == GTK_TREE_SORTABLE_DEFAULT_SORT_COLUMN_ID)
+    gtk_column_store_sort (store);
+}
+
+static gboolean
+gtk_column_store_has_default_sort_func (GtkTreeSortable *sortable)
+{
+  GtkColumnStore *store = GTK_COLUMN_STORE (sortable);
+
+  return store->default_sort_func != NULL;
+}
+
+static void
+gtk_column_store_sortable_init (GtkTreeSortableIface *iface)
+{
+  iface->get_sort_column_id = gtk_column_store_get_sort_column_id;
+  iface->set_sort_column_id = gtk_column_store_set_sort_column_id;
+  iface->set_sort_func = gtk_column_store_set_sort_func;
+  iface->set_default_sort_func = gtk_column_store_set_default_sort_func;
+  iface->has_default_sort_func = gtk_column_store_has_default_sort_func;
+}
+
+/* Public API */
+
+static gboolean
+gtk_column_store_set_column_types (GtkColumnStore *store,
+                                   gint            n_columns,
+                                   GType          *types)
+{
+  gint i;
+
+  for (i = 0; i < n_columns; i++)
+    {
+      if (!_gtk_tree_data_list_check_type (types[i]))
+        {
+          g_warning ("%s: Invalid type %s", G_STRLOC, g_type_name (types[i]));
+          return FALSE;
+        }
+    }
+
+  store->n_columns = n_columns;
+  store->columns = g_new0 (GtkColumnStoreColumn, n_columns);
+  for (i = 0; i < n_columns; i++)
+    {
+      store->columns[i].type = types[i];
+      store->columns[i].fundamental = get_fundamental_type (types[i]);
+      store->columns[i].element_size = get_element_size (store->columns[i].fundamental);
+    }
+
+  store->sort_list = _gtk_tree_data_list_header_new (n_columns, types);
+
+  return TRUE;
+}
+
+/**
+ * gtk_column_store_new:
+ * @n_columns: number of columns in the column store
+ * @...: all #GType types for the columns, from first to last
+ *
+ * Creates a new column store with @n_columns columns, each of the
+ * types passed in. Only the types supported by #GtkListStore are
+ * supported.
+ *
+ * Returns: a new #GtkColumnStore
+ */
+GtkColumnStore *
+gtk_column_store_new (gint n_columns,
+                      ...)
+{
+  GtkColumnStore *retval;
+  GType *types;
+  va_list args;
+  gint i;
+
+  g_return_val_if_fail (n_columns > 0, NULL);
+
+  types = g_newa (GType, n_columns);
+
+  va_start (args, n_columns);
+  for (i = 0; i < n_columns; i++)
+    types[i] = va_arg (args, GType);
+  va_end (args);
+
+  retval = g_object_new (GTK_TYPE_COLUMN_STORE, NULL);
+  if (!gtk_column_store_set_column_types (retval, n_columns, types))
+    {
+      g_object_unref (retval);
+      return NULL;
+    }
+
+  return retval;
+}
+
+/**
+ * gtk_column_store_newv: (rename-to gtk_column_store_new)
+ * @n_columns: number of columns in the column store
+ * @types: (array length=n_columns): an array of #GType types for the columns, from first to last
+ *
+ * Non-vararg creation function.  Used primarily by language bindings.
+ *
+ * Returns: (transfer full): a new #GtkColumnStore
+ */
+GtkColumnStore *
+gtk_column_store_newv (gint   n_columns,
+                       GType *types)
+{
+  GtkColumnStore *retval;
+
+  g_return_val_if_fail (n_columns > 0, NULL);
+
+  retval = g_object_new (GTK_TYPE_COLUMN_STORE, NULL);
+  if (!gtk_column_store_set_column_types (retval, n_columns, types))
+    {
+      g_object_unref (retval);
+      return NULL;
+    }
+
+  return retval;
+}
+
+/* Returns TRUE if the value was set */
+static gboolean
+gtk_column_store_real_set_value (GtkColumnStore *store,
+                                 guint           row,
+                                 gint            column,
+                                 GValue         *value)
+{
+  GtkColumnStoreColumn *col;
+  GValue real_value = G_VALUE_INIT;
+
+  if (column < 0 || column >= store->n_columns)
+    {
+      g_warning ("%s: Invalid column number %d", G_STRLOC, column);
+      return FALSE;
+    }
+
+  col = &store->columns[column];
+
+  if (g_type_is_a (G_VALUE_TYPE (value), col->type))
+    {
+      gtk_column_store_value_to_cell (store, col, row, value);
+      return TRUE;
+    }
+
+  if (!g_value_type_transformable (G_VALUE_TYPE (value), col->type))
+    {
+      g_warning ("%s: Unable to convert from %s to %s",
+                 G_STRLOC,
+                 g_type_name (G_VALUE_TYPE (value)),
+                 g_type_name (col->type));
+      return FALSE;
+    }
+
+  g_value_init (&real_value, col->type);
+  if (!g_value_transform (value, &real_value))
+    {
+      g_warning ("%s: Unable to make conversion from %s to %s",
+                 G_STRLOC,
+                 g_type_name (G_VALUE_TYPE (value)),
+                 g_type_name (col->type));
+      g_value_unset (&real_value);
+      return FALSE;
+    }
+
+  gtk_column_store_value_to_cell (store, col, row, &real_value);
+  g_value_unset (&real_value);
+
+  return TRUE;
+}
+
+static gboolean
+gtk_column_store_set_vector_internal (GtkColumnStore *store,
+                                      guint           row,
+                                      gint           *columns,
+                                      GValue         *values,
+                                      gint            n_values)
+{
+  gboolean changed = FALSE;
+  gint i;
+
+  for (i = 0; i < n_values; i++)
+    changed |= gtk_column_store_real_set_value (store, row, columns[i], &values[i]);
+
+  return changed;
+}
+
+/* Emits the signals for a changed row, moving it if the store is sorted */
+static void
+gtk_column_store_row_changed (GtkColumnStore *store,
+                              GtkTreeIter    *iter)
+{
+  GtkTreePath *path;
+  guint old_row;
+
+  path = gtk_tree_path_new_from_indices (ROW (iter), -1);
+  gtk_tree_model_row_changed (GTK_TREE_MODEL (store), path, iter);
+  gtk_tree_path_free (path);
+
+  if (!GTK_COLUMN_STORE_IS_SORTED (store) || !iter_is_valid (iter, store))
+    return;
+
+  old_row = gtk_column_store_resort_row (store, iter);
+  if (old_row != ROW (iter))
+    gtk_column_store_emit_row_moved (store, old_row, ROW (iter));
+}
+
+/**
+ * gtk_column_store_set_value:
+ * @column_store: A #GtkColumnStore
+ * @iter: A valid #GtkTreeIter for the row being modified
+ * @column: column number to modify
+ * @value: new value for the cell
+ *
+ * Sets the data in the cell specified by @iter and @column.
+ * The type of @value must be convertible to the type of the
+ * column.
+ *
+ * If @column_store is sorted, the row may move and @iter is updated
+ * to point to its new position.
+ */
+void
+gtk_column_store_set_value (GtkColumnStore *column_store,
+                            GtkTreeIter    *iter,
+                            gint            column,
+                            GValue         *value)
+{
+  g_return_if_fail (GTK_IS_COLUMN_STORE (column_store));
+  g_return_if_fail (iter_is_valid (iter, column_store));
+  g_return_if_fail (G_IS_VALUE (value));
+
+  if (gtk_column_store_real_set_value (column_store, ROW (iter), column, value))
+    gtk_column_store_row_changed (column_store, iter);
+}
+
+/**
+ * gtk_column_store_set_valuesv: (rename-to gtk_column_store_set)
+ * @column_store: A #GtkColumnStore
+ * @iter: A valid #GtkTreeIter for the row being modified
+ * @columns: (array length=n_values): an array of column numbers
+ * @values: (array length=n_values): an array of GValues
+ * @n_values: the length of the @columns and @values arrays
+ *
+ * A variant of gtk_column_store_set_valist() which takes the columns
+ * and values as two arrays, instead of varargs.
+ */
+void
+gtk_column_store_set_valuesv (GtkColumnStore *column_store,
+                              GtkTreeIter    *iter,
+                              gint           *columns,
+                              GValue         *values,
+                              gint            n_values)
+{
+  g_return_if_fail (GTK_IS_COLUMN_STORE (column_store));
+  g_return_if_fail (iter_is_valid (iter, column_store));
+
+  if (gtk_column_store_set_vector_internal (column_store, ROW (iter), columns, values, n_values))
+    gtk_column_store_row_changed (column_store, iter);
+}
+
+/**
+ * gtk_column_store_set_valist:
+ * @column_store: A #GtkColumnStore
+ * @iter: A valid #GtkTreeIter for the row being modified
+ * @var_args: va_list of column/value pairs
+ *
+ * See gtk_column_store_set(); this version takes a va_list for use by
+ * language bindings.
+ */
+void
+gtk_column_store_set_valist (GtkColumnStore *column_store,
+                             GtkTreeIter    *iter,
+                             va_list         var_args)
+{
+  gboolean changed = FALSE;
+  gint column;
+
+  g_return_if_fail (GTK_IS_COLUMN_STORE (column_store));
+  g_return_if_fail (iter_is_valid (iter, column_store));
+
+  column = va_arg (var_args, gint);
+
+  while (column != -1)
+    {
+      GValue value = G_VALUE_INIT;
+      gchar *error = NULL;
+
+      if (column < 0 || column >= column_store->n_columns)
+        {
+          g_warning ("%s: Invalid column number %d added to iter (remember to end your list of columns with a -1)", G_STRLOC, column);
+          break;
+        }
+
+      G_VALUE_COLLECT_INIT (&value, column_store->columns[column].type,
+                            var_args, 0, &error);
+      if (error)
+        {
+          g_warning ("%s: %s", G_STRLOC, error);
+          g_free (error);
+
+          /* we purposely leak the value here, it might not be
+           * in a sane state if an error condition occoured
+           */
+          break;
+        }
+
+      changed |= gtk_column_store_real_set_value (column_store, ROW (iter), column, &value);
+
+      g_value_unset (&value);
+
+      column = va_arg (var_args, gint);
+    }
+
+  if (changed)
+    gtk_column_store_row_changed (column_store, iter);
+}
+
+/**
+ * gtk_column_store_set:
+ * @column_store: a #GtkColumnStore
+ * @iter: row iterator
+ * @...: pairs of column number and value, terminated with -1
+ *
+ * Sets the value of one or more cells in the row referenced by @iter.
+ * The variable argument list should contain integer column numbers,
+ * each column number followed by the value to be set.
+ * The list is terminated by a -1.
+ *
+ * The value will be referenced by the store if it is a %G_TYPE_OBJECT,
+ * and it will be copied if it is a %G_TYPE_BOXED. Strings are copied
+ * once and shared between all cells holding the same string.
+ */
+void
+gtk_column_store_set (GtkColumnStore *column_store,
+                      GtkTreeIter    *iter,
+                      ...)
+{
+  va_list var_args;
+
+  va_start (var_args, iter);
+  gtk_column_store_set_valist (column_store, iter, var_args);
+  va_end (var_args);
+}
+
+static void
+gtk_column_store_insert_row_internal (GtkColumnStore *store,
+                                      GtkTreeIter    *iter,
+                                      guint           row,
+                                      gint           *columns,
+                                      GValue         *values,
+                                      gint            n_values)
+{
+  GtkTreePath *path;
+
+  set_iter (store, iter, row);
+  gtk_column_store_set_vector_internal (store, row, columns, values, n_values);
+
+  /* Don't emit rows_reordered here */
+  if (GTK_COLUMN_STORE_IS_SORTED (store))
+    gtk_column_store_resort_row (store, iter);
+
+  path = gtk_tree_path_new_from_indices (ROW (iter), -1);
+  gtk_tree_model_row_inserted (GTK_TREE_MODEL (store), path, iter);
+  gtk_tree_path_free (path);
+}
+
+/**
+ * gtk_column_store_insert_with_valuesv:
+ * @column_store: A #GtkColumnStore
+ * @iter: (out) (allow-none): An unset #GtkTreeIter to set to the new row, or %NULL.
+ * @position: position to insert the new row, or -1 for last
+ * @columns: (array length=n_values): an array of column numbers
+ * @values: (array length=n_values): an array of GValues
+ * @n_values: the length of the @columns and @values arrays
+ *
+ * Creates a new row at @position, filled with the given values, and
+ * emits a single #GtkTreeModel::row-inserted signal for it. If
+ * @column_store is sorted, @position is ignored and the row is inserted
+ * at its sorted position.
+ */
+void
+gtk_column_store_insert_with_valuesv (GtkColumnStore *column_store,
+                                      GtkTreeIter    *iter,
+                                      gint            position,
+                                      gint           *columns,
+                                      GValue         *values,
+                                      gint            n_values)
+{
+  GtkTreeIter tmp_iter;
+
+  g_return_if_fail (GTK_IS_COLUMN_STORE (column_store));
+
+  if (!iter)
+    iter = &tmp_iter;
+
+  if (position < 0 || position > column_store->n_rows)
+    position = column_store->n_rows;
+
+  gtk_column_store_insert_rows (column_store, position, 1);
+  gtk_column_store_insert_row_internal (column_store, iter, position, columns, values, n_values);
+}
+
+/**
+ * gtk_column_store_insert:
+ * @column_store: A #GtkColumnStore
+ * @iter: (out): An unset #GtkTreeIter to set to the new row
+ * @position: position to insert the new row, or -1 for last
+ *
+ * Creates a new row at @position. The row will be empty after this
+ * function is called. To fill in values, you need to call
+ * gtk_column_store_set() or gtk_column_store_set_value(), or use
+ * gtk_column_store_insert_with_valuesv() instead.
+ */
+void
+gtk_column_store_insert (GtkColumnStore *column_store,
+                         GtkTreeIter    *iter,
+                         gint            position)
+{
+  g_return_if_fail (iter != NULL);
+
+  gtk_column_store_insert_with_valuesv (column_store, iter, position, NULL, NULL, 0);
+}
+
+/**
+ * gtk_column_store_append:
+ * @column_store: A #GtkColumnStore
+ * @iter: (out): An unset #GtkTreeIter to set to the appended row
+ *
+ * Appends a new row to @column_store. The row will be empty after this
+ * function is called.
+ */
+void
+gtk_column_store_append (GtkColumnStore *column_store,
+                         GtkTreeIter    *iter)
+{
+  gtk_column_store_insert (column_store, iter, -1);
+}
+
+/**
+ * gtk_column_store_insert_many_with_valuesv:
+ * @column_store: A #GtkColumnStore
+ * @position: position to insert the first new row, or -1 for last
+ * @n_rows: the number of rows to insert
+ * @columns: (array length=n_values): an array of column numbers
+ * @values: (array): an array of @n_rows * @n_values GValues, containing
+ *     the values of the first row, followed by those of the second row
+ *     and so on
+ * @n_values: the length of the @columns array
+ *
+ * Inserts @n_rows rows starting at @position and sets the values of
+ * each row to the corresponding @n_values entries of @values.
+ *
+ * The space for all rows is made in one step. A #GtkTreeModel::row-inserted
+ * signal is emitted for each row, in order. Handlers of these signals
+ * must not modify @column_store.
+ */
+void
+gtk_column_store_insert_many_with_valuesv (GtkColumnStore *column_store,
+                                           gint            position,
+                                           gint            n_rows,
+                                           gint           *columns,
+                                           GValue         *values,
+                                           gint            n_values)
+{
+  GtkTreeIter iter;
+  gint i;
+
+  g_return_if_fail (GTK_IS_COLUMN_STORE (column_store));
+  g_return_if_fail (n_rows >= 0);
+  g_return_if_fail (n_values >= 0);
+
+  if (n_rows == 0)
+    return;
+
+  if (position < 0 || position > column_store->n_rows ||
+      GTK_COLUMN_STORE_IS_SORTED (column_store))
+    position = column_store->n_rows;
+
+  gtk_column_store_insert_rows (column_store, column_store->n_rows, n_rows);
+
+  /* Rows are made visible one by one so that every row-inserted
+   * signal sees a store with exactly the rows announced so far.
+   * Until then they wait, zeroed, behind the last visible row.
+   */
+  column_store->n_rows -= n_rows;
+  for (i = 0; i < n_rows; i++)
+    {
+      guint row = position + i;
+
+      if (row != column_store->n_rows)
+        gtk_column_store_move_row (column_store, column_store->n_rows, row);
+      column_store->n_rows++;
+
+      gtk_column_store_insert_row_internal (column_store, &iter, row,
+                                            columns, values + i * n_values, n_values);
+    }
+}
+
+/**
+ * gtk_column_store_remove:
+ * @column_store: A #GtkColumnStore
+ * @iter: A valid #GtkTreeIter
+ *
+ * Removes the given row from the column store. After being removed,
+ * @iter is set to be the next valid row, or invalidated if it pointed
+ * to the last row in @column_store.
+ *
+ * Returns: %TRUE if @iter is valid, %FALSE if not.
+ */
+gboolean
+gtk_column_store_remove (GtkColumnStore *column_store,
+                         GtkTreeIter    *iter)
+{
+  GtkTreePath *path;
+  guint row;
+
+  g_return_val_if_fail (GTK_IS_COLUMN_STORE (column_store), FALSE);
+  g_return_val_if_fail (iter_is_valid (iter, column_store), FALSE);
+
+  row = ROW (iter);
+  gtk_column_store_remove_row (column_store, row);
+
+  path = gtk_tree_path_new_from_indices (row, -1);
+  gtk_tree_model_row_deleted (GTK_TREE_MODEL (column_store), path);
+  gtk_tree_path_free (path);
+
+  if (row < column_store->n_rows)
+    {
+      set_iter (column_store, iter, row);
+      return TRUE;
+    }
+
+  iter->stamp = 0;
+  return FALSE;
+}
+
+/**
+ * gtk_column_store_clear:
+ * @column_store: a #GtkColumnStore
+ *
+ * Removes all rows from the column store.
+ */
+void
+gtk_column_store_clear (GtkColumnStore *column_store)
+{
+  GtkTreePath *path;
+
+  g_return_if_fail (GTK_IS_COLUMN_STORE (column_store));
+
+  path = gtk_tree_path_new ();
+  while (column_store->n_rows > 0)
+    {
+      gtk_column_store_remove_row (column_store, column_store->n_rows - 1);
+
+      gtk_tree_path_append_index (path, column_store->n_rows);
+      gtk_tree_model_row_deleted (GTK_TREE_MODEL (column_store), path);
+      gtk_tree_path_up (path);
+    }
+  gtk_tree_path_free (path);
+}
+
+/**
+ * gtk_column_store_iter_is_valid:
+ * @column_store: A #GtkColumnStore.
+ * @iter: A #GtkTreeIter.
+ *
+ * Checks if the given iter is a valid iter for this #GtkColumnStore.
+ *
+ * Returns: %TRUE if the iter is valid, %FALSE if the iter is invalid.
+ */
+gboolean
+gtk_column_store_iter_is_valid (GtkColumnStore *column_store,
+                                GtkTreeIter    *iter)
+{
+  g_return_val_if_fail (GTK_IS_COLUMN_STORE (column_store), FALSE);
+  g_return_val_if_fail (iter != NULL, FALSE);
+
+  return iter_is_valid (iter, column_store);
+}
+
+static GtkColumnStoreColumn *
+gtk_column_store_get_cell_column (GtkColumnStore *column_store,
+                                  GtkTreeIter    *iter,
+                                  gint            column)
+{
+  g_return_val_if_fail (GTK_IS_COLUMN_STORE (column_store), NULL);
+  g_return_val_if_fail (iter_is_valid (iter, column_store), NULL);
+  g_return_val_if_fail (column >= 0 && column < column_store->n_columns, NULL);
+
+  return &column_store->columns[column];
+}
+
+/**
+ * gtk_column_store_get_int:
+ * @column_store: A #GtkColumnStore
+ * @iter: A valid #GtkTreeIter
+ * @column: the column to read
+ *
+ * Gets the value of a cell of a column holding booleans, characters,
+ * integers, enums or flags without going through a #GValue.
+ *
+ * Returns: the value of the cell
+ */
+gint
+gtk_column_store_get_int (GtkColumnStore *column_store,
+                          GtkTreeIter    *iter,
+                          gint            column)
+{
+  GtkColumnStoreColumn *col;
+
+  col = gtk_column_store_get_cell_column (column_store, iter, column);
+  if (col == NULL)
+    return 0;
+
+  switch (col->fundamental)
+    {
+    case G_TYPE_CHAR:
+      return *(gint8 *) CELL (col, ROW (iter));
+    case G_TYPE_UCHAR:
+      return *(guint8 *) CELL (col, ROW (iter));
+    case G_TYPE_BOOLEAN:
+    case G_TYPE_INT:
+    case G_TYPE_UINT:
+    case G_TYPE_ENUM:
+    case G_TYPE_FLAGS:
+      return *(gint *) CELL (col, ROW (iter));
+    default:
+      g_critical ("%s: Column %d of type %s does not hold integers", G_STRFUNC, column, g_type_name (col->type));
+      return 0;
+    }
+}
+
+/**
+ * gtk_column_store_get_int64:
+ * @column_store: A #GtkColumnStore
+ * @iter: A valid #GtkTreeIter
+ * @column: the column to read
+ *
+ * Gets the value of a cell of a column holding longs or 64-bit
+ * integers without going through a #GValue.
+ *
+ * Returns: the value of the cell
+ */
+gint64
+gtk_column_store_get_int64 (GtkColumnStore *column_store,
+                            GtkTreeIter    *iter,
+                            gint            column)
+{
+  GtkColumnStoreColumn *col;
+
+  col = gtk_column_store_get_cell_column (column_store, iter, column);
+  if (col == NULL)
+    return 0;
+
+  switch (col->fundamental)
+    {
+    case G_TYPE_LONG:
+      return *(glong *) CELL (col, ROW (iter));
+    case G_TYPE_ULONG:
+      return *(gulong *) CELL (col, ROW (iter));
+    case G_TYPE_INT64:
+    case G_TYPE_UINT64:
+      return *(gint64 *) CELL (col, ROW (iter));
+    default:
+      g_critical ("%s: Column %d of type %s does not hold 64-bit integers", G_STRFUNC, column, g_type_name (col->type));
+      return 0;
+    }
+}
+
+/**
+ * gtk_column_store_get_double:
+ * @column_store: A #GtkColumnStore
+ * @iter: A valid #GtkTreeIter
+ * @column: the column to read
+ *
+ * Gets the value of a cell of a column holding floats or doubles
+ * without going through a #GValue.
+ *
+ * Returns: the value of the cell
+ */
+gdouble
+gtk_column_store_get_double (GtkColumnStore *column_store,
+                             GtkTreeIter    *iter,
+                             gint            column)
+{
+  GtkColumnStoreColumn *col;
+
+  col = gtk_column_store_get_cell_column (column_store, iter, column);
+  if (col == NULL)
+    return 0;
+
+  switch (col->fundamental)
+    {
+    case G_TYPE_FLOAT:
+      return *(gfloat *) CELL (col, ROW (iter));
+    case G_TYPE_DOUBLE:
+      return *(gdouble *) CELL (col, ROW (iter));
+    default:
+      g_critical ("%s: Column %d of type %s does not hold floating point numbers", G_STRFUNC, column, g_type_name (col->type));
+      return 0;
+    }
+}
+
+/**
+ * gtk_column_store_get_string:
+ * @column_store: A #GtkColumnStore
+ * @iter: A valid #GtkTreeIter
+ * @column: the column to read
+ *
+ * Gets the string stored in a cell of a string column without
+ * copying it.
+ *
+ * Returns: (nullable) (transfer none): the string in the cell. It is
+ *     only valid until the cell is changed or its row is removed.
+ */
+const gchar *
+gtk_column_store_get_string (GtkColumnStore *column_store,
+                             GtkTreeIter    *iter,
+                             gint            column)
+{
+  GtkColumnStoreColumn *col;
+
+  col = gtk_column_store_get_cell_column (column_store, iter, column);
+  if (col == NULL)
+    return NULL;
+
+  if (col->fundamental != G_TYPE_STRING)
+    {
+      g_critical ("%s: Column %d of type %s does not hold strings", G_STRFUNC, column, g_type_name (col->type));
+      return NULL;
+    }
+
+  return *(const gchar **) CELL (col, ROW (iter));
+}
+
+/**
+ * gtk_column_store_get_pointer:
+ * @column_store: A #GtkColumnStore
+ * @iter: A valid #GtkTreeIter
+ * @column: the column to read
+ *
+ * Gets the pointer, object, boxed value or variant stored in a cell
+ * without taking a reference to it.
+ *
+ * Returns: (nullable) (transfer none): the contents of the cell
+ */
+gpointer
+gtk_column_store_get_pointer (GtkColumnStore *column_store,
+                              GtkTreeIter    *iter,
+                              gint            column)
+{
+  GtkColumnStoreColumn *col;
+
+  col = gtk_column_store_get_cell_column (column_store, iter, column);
+  if (col == NULL)
+    return NULL;
+
+  switch (col->fundamental)
+    {
+    case G_TYPE_POINTER:
+    case G_TYPE_BOXED:
+    case G_TYPE_OBJECT:
+    case G_TYPE_VARIANT:
+      return *(gpointer *) CELL (col, ROW (iter));
+    default:
+      g_critical ("%s: Column %d of type %s does not hold pointers", G_STRFUNC, column, g_type_name (col->type));
+      return NULL;
+    }
+}
@@ -0,0 +1,116 @@
+/* GTK - The GIMP Toolkit
+ * Copyright (C) 2018 Red Hat, Inc.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef __GTK_COLUMN_STORE_H__
+#define __GTK_COLUMN_STORE_H__
+
+#if !defined (__GTK_H_INSIDE__) && !defined (GTK_COMPILATION)
+#error "Only <gtk/gtk.h> can be included directly."
+#endif
+
+#include <gtk/gtktreemodel.h>
+#include <gtk/gtktreesortable.h>
+
+
+G_BEGIN_DECLS
+
+#define GTK_TYPE_COLUMN_STORE (gtk_column_store_get_type ())
+
+GDK_AVAILABLE_IN_ALL
+G_DECLARE_FINAL_TYPE (GtkColumnStore, gtk_column_store, GTK, COLUMN_STORE, GObject)
+
+GDK_AVAILABLE_IN_ALL
+GtkColumnStore *gtk_column_store_new                    (gint            n_columns,
+                                                         ...);
+GDK_AVAILABLE_IN_ALL
+GtkColumnStore *gtk_column_store_newv                   (gint            n_columns,
+                                                         GType          *types);
+
+GDK_AVAILABLE_IN_ALL
+void            gtk_column_store_set_value              (GtkColumnStore *column_store,
+                                                         GtkTreeIter    *iter,
+                                                         gint            column,
+                                                         GValue         *value);
+GDK_AVAILABLE_IN_ALL
+void            gtk_column_store_set                    (GtkColumnStore *column_store,
+                                                         GtkTreeIter    *iter,
+                                                         ...);
+GDK_AVAILABLE_IN_ALL
+void            gtk_column_store_set_valuesv            (GtkColumnStore *column_store,
+                                                         GtkTreeIter    *iter,
+                                                         gint           *columns,
+                                                         GValue         *values,
+                                                         gint            n_values);
+GDK_AVAILABLE_IN_ALL
+void            gtk_column_store_set_valist             (GtkColumnStore *column_store,
+                                                         GtkTreeIter    *iter,
+                                                         va_list         var_args);
+
+GDK_AVAILABLE_IN_ALL
+void            gtk_column_store_insert                 (GtkColumnStore *column_store,
+                                                         GtkTreeIter    *iter,
+                                                         gint            position);
+GDK_AVAILABLE_IN_ALL
+void            gtk_column_store_append                 (GtkColumnStore *column_store,
+                                                         GtkTreeIter    *iter);
+GDK_AVAILABLE_IN_ALL
+void            gtk_column_store_insert_with_valuesv    (GtkColumnStore *column_store,
+                                                         GtkTreeIter    *iter,
+                                                         gint            position,
+                                                         gint           *columns,
+                                                         GValue         *values,
+                                                         gint            n_values);
+GDK_AVAILABLE_IN_ALL
+void            gtk_column_store_insert_many_with_valuesv (GtkColumnStore *column_store,
+                                                           gint            position,
+                                                           gint            n_rows,
+                                                           gint           *columns,
+                                                           GValue         *values,
+                                                           gint            n_values);
+GDK_AVAILABLE_IN_ALL
+gboolean        gtk_column_store_remove                 (GtkColumnStore *column_store,
+                                                         GtkTreeIter    *iter);
+GDK_AVAILABLE_IN_ALL
+void            gtk_column_store_clear                  (GtkColumnStore *column_store);
+GDK_AVAILABLE_IN_ALL
+gboolean        gtk_column_store_iter_is_valid          (GtkColumnStore *column_store,
+                                                         GtkTreeIter    *iter);
+
+GDK_AVAILABLE_IN_ALL
+gint            gtk_column_store_get_int                (GtkColumnStore *column_store,
+                                                         GtkTreeIter    *iter,
+                                                         gint            column);
+GDK_AVAILABLE_IN_ALL
+gint64          gtk_column_store_get_int64              (GtkColumnStore *column_store,
+                                                         GtkTreeIter    *iter,
+                                                         gint            column);
+GDK_AVAILABLE_IN_ALL
+gdouble         gtk_column_store_get_double             (GtkColumnStore *column_store,
+                                                         GtkTreeIter    *iter,
+                                                         gint            column);
+GDK_AVAILABLE_IN_ALL
+const gchar *   gtk_column_store_get_string             (GtkColumnStore *column_store,
+                                                         GtkTreeIter    *iter,
+                                                         gint            column);
+GDK_AVAILABLE_IN_ALL
+gpointer        gtk_column_store_get_pointer            (GtkColumnStore *column_store,
+                                                         GtkTreeIter    *iter,
+                                                         gint            column);
+
+G_END_DECLS
+
+#endif /* __GTK_COLUMN_STORE_H__ */
@@ -44,6 +44,9 @@
 
 #include "a11y/gtkcontaineraccessibleprivate.h"
 
+#include "gdk/gdkframeclockprivate.h"
+#include "gdk/gdkprofilerprivate.h"
+
 #include <gobject/gobjectnotifyqueue.c>
 #include <gobject/gvaluecollector.h>
 #include <stdarg.h>
@@ -1373,6 +1376,15 @@ gtk_container_idle_sizer (GdkFrameClock *clock,
 			  GtkContainer  *container)
 {
   GtkContainerPrivate *priv = gtk_container_get_instance_private (container);
+#ifdef G_ENABLE_DEBUG
+  gint64 start_time = g_get_monotonic_time ();
+
+  if (GTK_DISPLAY_DEBUG_CHECK (gtk_widget_get_display (GTK_WIDGET (container)), LAYOUT))
+    gtk_widget_set_layout_profiling (TRUE);
+#endif
+
+  if (gtk_widget_get_layout_profiling ())
+    gtk_widget_set_layout_frame (gdk_frame_clock_get_frame_counter (clock));
 
   /* We validate the style contexts in a single loop before even trying
    * to handle resizes instead of doing validations inline.
@@ -1386,8 +1398,16 @@ gtk_container_idle_sizer (GdkFrameClock *clock,
    */
   if (priv->restyle_pending)
     {
+      GdkFrameTimings *timings;
+      gint64 before = g_get_monotonic_time ();
+
       priv->restyle_pending = FALSE;
       gtk_css_node_validate (gtk_widget_get_css_node (GTK_WIDGET (container)));
+
+      timings = gdk_frame_clock_get_current_timings (clock);
+      if (timings)
+        timings->style_duration += g_get_monotonic_time () - before;
+      gdk_profiler_end_mark (before * 1000, "style", G_OBJECT_TYPE_NAME (container));
     }
 
   /* we may be invoked with a container_resize_queue of NULL, because
@@ -1398,9 +1418,19 @@ gtk_container_idle_sizer (GdkFrameClock *clock,
    */
   if (gtk_widget_needs_allocate (GTK_WIDGET (container)))
     {
+      gint64 before = gdk_profiler_current_time ();
+
       gtk_container_check_resize (container);
+
+      gdk_profiler_end_mark (before, "size allocation", G_OBJECT_TYPE_NAME (container));
     }
 
+  GTK_DISPLAY_NOTE (gtk_widget_get_display (GTK_WIDGET (container)), LAYOUT,
+                    g_message ("Layout of %s %p in frame %" G_GINT64_FORMAT " took %.2f ms",
+                               G_OBJECT_TYPE_NAME (container), container,
+                               gdk_frame_clock_get_frame_counter (clock),
+                               (g_get_monotonic_time () - start_time) / 1000.0));
+
   if (!gtk_container_needs_idle_sizer (container))
     {
       gtk_container_stop_idle_sizer (container);
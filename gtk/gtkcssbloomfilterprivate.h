@@ -0,0 +1,103 @@
+/* GTK - The GIMP Toolkit
+ * Copyright (C) 2018 Red Hat, Inc.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef __GTK_CSS_BLOOM_FILTER_PRIVATE_H__
+#define __GTK_CSS_BLOOM_FILTER_PRIVATE_H__
+
+#include <glib.h>
+
+G_BEGIN_DECLS
+
+/* A counting bloom filter of the names, ids and style classes of the
+ * ancestors of a node, so that selectors like ".sidebar label" can be
+ * rejected without walking up the tree when there is no .sidebar.
+ *
+ * Items can be added and removed again while walking down the tree.
+ * A FALSE from gtk_css_bloom_filter_may_contain() is always right, a
+ * TRUE only most of the time.
+ */
+
+#define GTK_CSS_BLOOM_FILTER_BITS 12
+#define GTK_CSS_BLOOM_FILTER_SIZE (1 << GTK_CSS_BLOOM_FILTER_BITS)
+#define GTK_CSS_BLOOM_FILTER_MASK (GTK_CSS_BLOOM_FILTER_SIZE - 1)
+
+typedef enum {
+  GTK_CSS_BLOOM_NAME,
+  GTK_CSS_BLOOM_ID,
+  GTK_CSS_BLOOM_CLASS
+} GtkCssBloomKind;
+
+typedef struct _GtkCssBloomFilter GtkCssBloomFilter;
+
+struct _GtkCssBloomFilter
+{
+  guint8 counters[GTK_CSS_BLOOM_FILTER_SIZE];
+};
+
+static inline guint32
+gtk_css_bloom_filter_hash (GtkCssBloomKind kind,
+                           gsize           item)
+{
+  guint32 hash = (guint32) item ^ (guint32) ((guint64) item >> 32);
+
+  /* Names and ids are interned strings and classes are quarks, mix
+   * the bits so that nearby pointers and small numbers spread out */
+  hash = (hash ^ (kind + 1)) * 0x9E3779B1u;
+  return hash ^ (hash >> 15);
+}
+
+static inline void
+gtk_css_bloom_filter_add_hash (GtkCssBloomFilter *filter,
+                               guint32            hash)
+{
+  guint8 *c1 = &filter->counters[hash & GTK_CSS_BLOOM_FILTER_MASK];
+  guint8 *c2 = &filter->counters[(hash >> 16) & GTK_CSS_BLOOM_FILTER_MASK];
+
+  /* A saturated counter stays, so the filter only gets less precise */
+  if (*c1 < G_MAXUINT8)
+    (*c1)++;
+  if (*c2 < G_MAXUINT8)
+    (*c2)++;
+}
+
+static inline void
+gtk_css_bloom_filter_remove_hash (GtkCssBloomFilter *filter,
+                                  guint32            hash)
+{
+  guint8 *c1 = &filter->counters[hash & GTK_CSS_BLOOM_FILTER_MASK];
+  guint8 *c2 = &filter->counters[(hash >> 16) & GTK_CSS_BLOOM_FILTER_MASK];
+
+  if (*c1 < G_MAXUINT8)
+    (*c1)--;
+  if (*c2 < G_MAXUINT8)
+    (*c2)--;
+}
+
+static inline gboolean
+gtk_css_bloom_filter_may_contain (const GtkCssBloomFilter *filter,
+                                  GtkCssBloomKind          kind,
+                                  gsize                    item)
+{
+  guint32 hash = gtk_css_bloom_filter_hash (kind, item);
+
+  return filter->counters[hash & GTK_CSS_BLOOM_FILTER_MASK] != 0 &&
+         filter->counters[(hash >> 16) & GTK_CSS_BLOOM_FILTER_MASK] != 0;
+}
+
+G_END_DECLS
+
+#endif /* __GTK_CSS_BLOOM_FILTER_PRIVATE_H__ */
@@ -22,6 +22,7 @@
 #include "gtkcssimagepaintableprivate.h"
 
 #include "gtkprivate.h"
+#include "gtkrendernodepaintableprivate.h"
 
 G_DEFINE_TYPE (GtkCssImagePaintable, gtk_css_image_paintable, GTK_TYPE_CSS_IMAGE)
 
@@ -189,5 +190,11 @@ gtk_css_image_paintable_new (GdkPaintable *paintable,
   if (static_paintable)
     GTK_CSS_IMAGE_PAINTABLE (image)->static_paintable = g_object_ref (static_paintable);
 
+  /* CSS images tend to be drawn by many widgets */
+  if (GTK_IS_RENDER_NODE_PAINTABLE (paintable))
+    gtk_render_node_paintable_set_cached (GTK_RENDER_NODE_PAINTABLE (paintable), TRUE);
+  if (static_paintable && GTK_IS_RENDER_NODE_PAINTABLE (static_paintable))
+    gtk_render_node_paintable_set_cached (GTK_RENDER_NODE_PAINTABLE (static_paintable), TRUE);
+
   return image;
 }
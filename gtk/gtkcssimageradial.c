@@ -28,6 +28,23 @@
 #include "gtkcsspositionvalueprivate.h"
 #include "gtkcssrgbavalueprivate.h"
 #include "gtkcssprovider.h"
+#include "gtksnapshot.h"
+
+/* Radial gradients are drawn with Cairo. Keep the nodes of the most
+ * recently drawn gradients around, so that widgets with the same
+ * background share one node, and renderers only rasterize it once.
+ */
+#define RADIAL_CACHE_SIZE 32
+
+typedef struct {
+  GtkCssImage *image;
+  double width;
+  double height;
+  GskRenderNode *node;
+} RadialCacheEntry;
+
+/* most recently used first */
+static GQueue radial_cache = G_QUEUE_INIT;
 
 G_DEFINE_TYPE (GtkCssImageRadial, _gtk_css_image_radial, GTK_TYPE_CSS_IMAGE)
 
@@ -74,12 +91,11 @@ gtk_css_image_radial_get_start_end (GtkCssImageRadial *radial,
 }
 
 static void
-gtk_css_image_radial_snapshot (GtkCssImage *image,
-                               GtkSnapshot *snapshot,
-                               double       width,
-                               double       height)
+gtk_css_image_radial_draw (GtkCssImageRadial *radial,
+                           cairo_t           *cr,
+                           double             width,
+                           double             height)
 {
-  GtkCssImageRadial *radial = GTK_CSS_IMAGE_RADIAL (image);
   cairo_pattern_t *pattern;
   cairo_matrix_t matrix;
   double x, y;
@@ -88,10 +104,6 @@ gtk_css_image_radial_snapshot (GtkCssImage *image,
   double r1, r2, r3, r4, r;
   double offset;
   int i, last;
-  cairo_t *cr;
-
-  cr = gtk_snapshot_append_cairo (snapshot,
-                                  &GRAPHENE_RECT_INIT (0, 0, width, height));
 
   x = _gtk_css_position_value_get_x (radial->position, width);
   y = _gtk_css_position_value_get_y (radial->position, height);
@@ -229,8 +241,87 @@ gtk_css_image_radial_snapshot (GtkCssImage *image,
   cairo_fill (cr);
 
   cairo_pattern_destroy (pattern);
+}
+
+static void
+radial_cache_entry_free (RadialCacheEntry *entry)
+{
+  g_object_unref (entry->image);
+  gsk_render_node_unref (entry->node);
+  g_slice_free (RadialCacheEntry, entry);
+}
+
+static GskRenderNode *
+radial_cache_lookup (GtkCssImage *image,
+                     double       width,
+                     double       height)
+{
+  GList *l;
+
+  for (l = radial_cache.head; l; l = l->next)
+    {
+      RadialCacheEntry *entry = l->data;
+
+      if (entry->width == width &&
+          entry->height == height &&
+          (entry->image == image || _gtk_css_image_equal (entry->image, image)))
+        {
+          if (l != radial_cache.head)
+            {
+              g_queue_unlink (&radial_cache, l);
+              g_queue_push_head_link (&radial_cache, l);
+            }
+
+          return entry->node;
+        }
+    }
+
+  return NULL;
+}
+
+static void
+radial_cache_insert (GtkCssImage   *image,
+                     double         width,
+                     double         height,
+                     GskRenderNode *node)
+{
+  RadialCacheEntry *entry;
+
+  if (radial_cache.length >= RADIAL_CACHE_SIZE)
+    radial_cache_entry_free (g_queue_pop_tail (&radial_cache));
+
+  entry = g_slice_new (RadialCacheEntry);
+  entry->image = g_object_ref (image);
+  entry->width = width;
+  entry->height = height;
+  entry->node = gsk_render_node_ref (node);
+
+  g_queue_push_head (&radial_cache, entry);
+}
+
+static void
+gtk_css_image_radial_snapshot (GtkCssImage *image,
+                               GtkSnapshot *snapshot,
+                               double       width,
+                               double       height)
+{
+  GskRenderNode *node;
+  cairo_t *cr;
+
+  node = radial_cache_lookup (image, width, height);
+  if (node == NULL)
+    {
+      node = gsk_cairo_node_new (&GRAPHENE_RECT_INIT (0, 0, width, height));
+
+      cr = gsk_cairo_node_get_draw_context (node);
+      gtk_css_image_radial_draw (GTK_CSS_IMAGE_RADIAL (image), cr, width, height);
+      cairo_destroy (cr);
+
+      radial_cache_insert (image, width, height, node);
+      gsk_render_node_unref (node);
+    }
 
-  cairo_destroy (cr);
+  gtk_snapshot_append_node (snapshot, node);
 }
 
 static gboolean
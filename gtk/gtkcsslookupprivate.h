@@ -35,6 +35,7 @@ typedef struct {
 
 struct _GtkCssLookup {
   GtkBitmask        *missing;
+  guint              n_rules_tested;    /* selectors tested while matching, for profiling */
   GtkCssLookupValue  values[GTK_CSS_PROPERTY_N_PROPERTIES];
 };
 
@@ -325,6 +325,28 @@ _gtk_css_matcher_node_init (GtkCssMatcher *matcher,
 {
   matcher->node.klass = &GTK_CSS_MATCHER_NODE;
   matcher->node.node = node;
+  matcher->node.ancestors = NULL;
+}
+
+/* The filter must contain the names, ids and classes of all ancestors
+ * of the node, it is only used for matching descendant selectors.
+ * Only node matchers support this.
+ */
+void
+_gtk_css_matcher_set_ancestor_filter (GtkCssMatcher           *matcher,
+                                      const GtkCssBloomFilter *filter)
+{
+  if (matcher->klass == &GTK_CSS_MATCHER_NODE)
+    matcher->node.ancestors = filter;
+}
+
+const GtkCssBloomFilter *
+_gtk_css_matcher_get_ancestor_filter (const GtkCssMatcher *matcher)
+{
+  if (matcher->klass == &GTK_CSS_MATCHER_NODE)
+    return matcher->node.ancestors;
+
+  return NULL;
 }
 
 /* GTK_CSS_MATCHER_WIDGET_ANY */
@@ -20,6 +20,7 @@
 
 #include <gtk/gtkenums.h>
 #include <gtk/gtktypes.h>
+#include "gtk/gtkcssbloomfilterprivate.h"
 #include "gtk/gtkcsstypesprivate.h"
 
 G_BEGIN_DECLS
@@ -60,6 +61,8 @@ struct _GtkCssMatcherWidgetPath {
 struct _GtkCssMatcherNode {
   const GtkCssMatcherClass *klass;
   GtkCssNode               *node;
+  /* Filter of the ancestors' names, ids and classes or %NULL */
+  const GtkCssBloomFilter  *ancestors;
 };
 
 struct _GtkCssMatcherSuperset {
@@ -80,6 +83,10 @@ gboolean          _gtk_css_matcher_init           (GtkCssMatcher          *match
                                                    const GtkCssNodeDeclaration *decl) G_GNUC_WARN_UNUSED_RESULT;
 void              _gtk_css_matcher_node_init      (GtkCssMatcher          *matcher,
                                                    GtkCssNode             *node);
+void              _gtk_css_matcher_set_ancestor_filter (GtkCssMatcher     *matcher,
+                                                   const GtkCssBloomFilter *filter);
+const GtkCssBloomFilter *
+                  _gtk_css_matcher_get_ancestor_filter (const GtkCssMatcher *matcher);
 void              _gtk_css_matcher_any_init       (GtkCssMatcher          *matcher);
 void              _gtk_css_matcher_superset_init  (GtkCssMatcher          *matcher,
                                                    const GtkCssMatcher    *subset,
@@ -20,6 +20,8 @@
 #include "gtkcssnodeprivate.h"
 
 #include "gtkcssanimatedstyleprivate.h"
+#include "gtkcsslookupprivate.h"
+#include "gtkcsspathnodeprivate.h"
 #include "gtkcsssectionprivate.h"
 #include "gtkcssstylepropertyprivate.h"
 #include "gtkintl.h"
@@ -115,12 +117,63 @@ struct _GtkCssNodeStyleChange {
 static guint cssnode_signals[LAST_SIGNAL] = { 0 };
 static GParamSpec *cssnode_properties[NUM_PROPERTIES];
 
+/* Selector matching for the children of a node is done on worker
+ * threads before they are validated, see gtk_css_node_prematch_children().
+ * The results are looked up in gtk_css_node_create_style().
+ */
+typedef struct {
+  GtkCssNode *node;
+  GtkStyleProvider *provider;
+  GtkCssMatcher matcher;
+  gboolean has_matcher;
+  guint serial;
+  GtkCssLookup lookup;
+  GtkCssChange change;
+  gint64 match_time;
+} GtkCssPrematch;
+
+#define MIN_PREMATCH_CHILDREN 16
+
+static GHashTable *prematched;
+/* Changed whenever a node changes in a way that affects matching */
+static guint match_serial;
+
+/* While validating, the names, ids and classes of ancestor_filter_node
+ * and all its ancestors, for matching its children, see
+ * gtk_css_node_push_ancestor().
+ */
+static GtkCssBloomFilter *ancestor_filter;
+static GArray *ancestor_hashes;
+static GtkCssNode *ancestor_filter_node;
+static guint ancestor_filter_serial;
+
+static gboolean profiling;
+
+static GtkCssNodeProfile *
+gtk_css_node_get_profile_for_update (GtkCssNode *cssnode)
+{
+  if (!profiling)
+    return NULL;
+
+  if (cssnode->profile == NULL)
+    cssnode->profile = g_new0 (GtkCssNodeProfile, 1);
+
+  return cssnode->profile;
+}
+
 static GtkStyleProvider *
 gtk_css_node_get_style_provider_or_null (GtkCssNode *cssnode)
 {
   return GTK_CSS_NODE_GET_CLASS (cssnode)->get_style_provider (cssnode);
 }
 
+static gboolean
+gtk_css_node_needs_validation (GtkCssNode *node)
+{
+  return node->visible &&
+         (!node->lazy || node->style_requested);
+}
+
 static void
 gtk_css_node_set_invalid (GtkCssNode *node,
                           gboolean    invalid)
@@ -250,6 +303,7 @@ gtk_css_node_finalize (GObject *object)
   if (cssnode->style)
     g_object_unref (cssnode->style);
   gtk_css_node_declaration_unref (cssnode->decl);
+  g_free (cssnode->profile);
 
   G_OBJECT_CLASS (gtk_css_node_parent_class)->finalize (object);
 }
@@ -352,32 +406,161 @@ store_in_global_parent_cache (GtkCssNode                  *node,
                                                  style);
 }
 
+static guint
+gtk_css_node_push_ancestor (GtkCssNode *cssnode)
+{
+  const GtkCssNodeDeclaration *decl = cssnode->decl;
+  const GQuark *classes;
+  guint i, n_classes, n_hashes;
+  guint32 hash;
+
+  classes = gtk_css_node_declaration_get_classes (decl, &n_classes);
+
+  for (i = 0; i < n_classes; i++)
+    {
+      hash = gtk_css_bloom_filter_hash (GTK_CSS_BLOOM_CLASS, classes[i]);
+      g_array_append_val (ancestor_hashes, hash);
+    }
+  n_hashes = n_classes;
+
+  hash = gtk_css_bloom_filter_hash (GTK_CSS_BLOOM_NAME, GPOINTER_TO_SIZE (gtk_css_node_declaration_get_name (decl)));
+  g_array_append_val (ancestor_hashes, hash);
+  n_hashes++;
+
+  if (gtk_css_node_declaration_get_id (decl))
+    {
+      hash = gtk_css_bloom_filter_hash (GTK_CSS_BLOOM_ID, GPOINTER_TO_SIZE (gtk_css_node_declaration_get_id (decl)));
+      g_array_append_val (ancestor_hashes, hash);
+      n_hashes++;
+    }
+
+  /* We remember the hashes, so that we remove the right ones even if
+   * the node changes in the meantime */
+  for (i = ancestor_hashes->len - n_hashes; i < ancestor_hashes->len; i++)
+    gtk_css_bloom_filter_add_hash (ancestor_filter, g_array_index (ancestor_hashes, guint32, i));
+
+  return n_hashes;
+}
+
+static void
+gtk_css_node_pop_ancestor (guint n_hashes)
+{
+  guint i;
+
+  for (i = ancestor_hashes->len - n_hashes; i < ancestor_hashes->len; i++)
+    gtk_css_bloom_filter_remove_hash (ancestor_filter, g_array_index (ancestor_hashes, guint32, i));
+
+  g_array_set_size (ancestor_hashes, ancestor_hashes->len - n_hashes);
+}
+
+static void
+gtk_css_node_set_ancestor_filter (GtkCssNode    *cssnode,
+                                  GtkCssMatcher *matcher)
+{
+  if (ancestor_filter != NULL &&
+      ancestor_filter_node != NULL &&
+      ancestor_filter_node == cssnode->parent &&
+      ancestor_filter_serial == match_serial)
+    _gtk_css_matcher_set_ancestor_filter (matcher, ancestor_filter);
+}
+
 static GtkCssStyle *
 gtk_css_node_create_style (GtkCssNode *cssnode)
 {
   const GtkCssNodeDeclaration *decl;
   GtkCssMatcher matcher;
+  GtkStyleProvider *provider;
   GtkCssStyle *parent;
   GtkCssStyle *style;
+  GtkWidgetPath *path;
+  gboolean is_first, is_last;
+  GtkCssNodeProfile *profile;
+
+  GtkCssPrematch *prematch;
 
   decl = gtk_css_node_get_declaration (cssnode);
+  profile = gtk_css_node_get_profile_for_update (cssnode);
 
   style = lookup_in_global_parent_cache (cssnode, decl);
   if (style)
-    return g_object_ref (style);
+    {
+      if (profile)
+        profile->n_cache_hits++;
+      return g_object_ref (style);
+    }
 
   parent = cssnode->parent ? cssnode->parent->style : NULL;
+  provider = gtk_css_node_get_style_provider (cssnode);
+  is_first = gtk_css_node_is_first_child (cssnode);
+  is_last = gtk_css_node_is_last_child (cssnode);
+
+  /* Same declaration as a node somewhere else with the same parent style.
+   * Path nodes are matched by their widget path, so that must match, too.
+   * Legacy drawing code creates new ones for every cell it renders. */
+  if (GTK_IS_CSS_PATH_NODE (cssnode))
+    path = gtk_css_path_node_get_widget_path (GTK_CSS_PATH_NODE (cssnode));
+  else
+    path = NULL;
+  style = gtk_css_node_style_cache_lookup_shared (provider, parent, path, decl, is_first, is_last);
+  if (style)
+    {
+      if (profile)
+        profile->n_cache_hits++;
+      store_in_global_parent_cache (cssnode, decl, style);
+      return g_object_ref (style);
+    }
 
-  if (gtk_css_node_init_matcher (cssnode, &matcher))
-    style = gtk_css_static_style_new_compute (gtk_css_node_get_style_provider (cssnode),
-                                              &matcher,
-                                              parent);
+  if (profile)
+    profile->n_cache_misses++;
+
+  prematch = prematched ? g_hash_table_lookup (prematched, cssnode) : NULL;
+  if (prematch)
+    g_hash_table_remove (prematched, cssnode);
+
+  if (prematch &&
+      prematch->serial == match_serial &&
+      prematch->provider == provider)
+    {
+      if (profile)
+        {
+          profile->n_rules_tested += prematch->lookup.n_rules_tested;
+          profile->match_time += prematch->match_time;
+        }
+      style = gtk_css_static_style_new_resolve (prematch->provider,
+                                                &prematch->lookup,
+                                                prematch->change,
+                                                parent);
+    }
+  else if (gtk_css_node_init_matcher (cssnode, &matcher))
+    {
+      gtk_css_node_set_ancestor_filter (cssnode, &matcher);
+      if (profile)
+        {
+          GtkCssLookup lookup;
+          GtkCssChange change = GTK_CSS_CHANGE_ANY_SELF | GTK_CSS_CHANGE_ANY_SIBLING | GTK_CSS_CHANGE_ANY_PARENT;
+          gint64 before;
+
+          /* Do what gtk_css_static_style_new_compute() does, but time the matching */
+          _gtk_css_lookup_init (&lookup, NULL);
+          before = g_get_monotonic_time ();
+          gtk_style_provider_lookup (provider, &matcher, &lookup, &change);
+          profile->match_time += g_get_monotonic_time () - before;
+          profile->n_rules_tested += lookup.n_rules_tested;
+          style = gtk_css_static_style_new_resolve (provider, &lookup, change, parent);
+          _gtk_css_lookup_destroy (&lookup);
+        }
+      else
+        style = gtk_css_static_style_new_compute (provider,
+                                                  &matcher,
+                                                  parent);
+    }
   else
-    style = gtk_css_static_style_new_compute (gtk_css_node_get_style_provider (cssnode),
+    style = gtk_css_static_style_new_compute (provider,
                                               NULL,
                                               parent);
 
   store_in_global_parent_cache (cssnode, decl, style);
+  gtk_css_node_style_cache_insert_shared (provider, parent, path, (GtkCssNodeDeclaration *) decl, is_first, is_last, style);
 
   return style;
 }
@@ -405,6 +588,152 @@ gtk_css_style_needs_recreation (GtkCssStyle  *style,
     return FALSE;
 }
 
+typedef struct {
+  GtkCssPrematch *matches;
+  int n_matches;
+  int next;
+  int n_workers;
+  GMutex mutex;
+  GCond cond;
+} GtkCssPrematchJob;
+
+/* This only reads the node tree and the style providers, which don't
+ * change while we wait for the workers, so it is safe to run on any
+ * thread. Computing the values is not, it happens on the main thread.
+ */
+static void
+gtk_css_prematch_job_run (GtkCssPrematchJob *job)
+{
+  int i;
+
+  while ((i = g_atomic_int_add (&job->next, 1)) < job->n_matches)
+    {
+      GtkCssPrematch *prematch = &job->matches[i];
+      gint64 before = 0;
+
+      _gtk_css_lookup_init (&prematch->lookup, NULL);
+      prematch->change = GTK_CSS_CHANGE_ANY_SELF | GTK_CSS_CHANGE_ANY_SIBLING | GTK_CSS_CHANGE_ANY_PARENT;
+
+      if (profiling)
+        before = g_get_monotonic_time ();
+
+      if (prematch->has_matcher)
+        gtk_style_provider_lookup (prematch->provider,
+                                   &prematch->matcher,
+                                   &prematch->lookup,
+                                   &prematch->change);
+
+      prematch->match_time = profiling ? g_get_monotonic_time () - before : 0;
+    }
+}
+
+static void
+gtk_css_prematch_worker (gpointer data,
+                         gpointer user_data)
+{
+  GtkCssPrematchJob *job = data;
+
+  gtk_css_prematch_job_run (job);
+
+  g_mutex_lock (&job->mutex);
+  job->n_workers--;
+  if (job->n_workers == 0)
+    g_cond_signal (&job->cond);
+  g_mutex_unlock (&job->mutex);
+}
+
+static gboolean
+gtk_css_node_should_prematch (GtkCssNode *child)
+{
+  return gtk_css_node_needs_validation (child) &&
+         child->invalid &&
+         child->style_is_invalid &&
+         child->style != NULL &&
+         gtk_css_style_needs_recreation (child->style, child->pending_changes);
+}
+
+/* When many children of @cssnode need new styles, like after a theme
+ * change in a big list, match their selectors in parallel. Returns the
+ * results or %NULL if it wasn't worth it.
+ */
+static GtkCssPrematch *
+gtk_css_node_prematch_children (GtkCssNode *cssnode,
+                                guint      *n_matches)
+{
+  static GThreadPool *pool = NULL;
+  static int max_workers = 0;
+  GtkCssPrematchJob job;
+  GtkCssNode *child;
+  int i, n;
+
+  if (max_workers == 0)
+    max_workers = MIN (g_get_num_processors (), 8) - 1;
+  if (max_workers <= 0)
+    return NULL;
+
+  n = 0;
+  for (child = cssnode->first_child; child; child = child->next_sibling)
+    {
+      if (gtk_css_node_should_prematch (child))
+        n++;
+    }
+
+  if (n < MIN_PREMATCH_CHILDREN)
+    return NULL;
+
+  if (pool == NULL)
+    {
+      pool = g_thread_pool_new (gtk_css_prematch_worker, NULL, max_workers, FALSE, NULL);
+      if (pool == NULL)
+        {
+          max_workers = -1;
+          return NULL;
+        }
+    }
+
+  job.matches = g_new (GtkCssPrematch, n);
+  job.n_matches = n;
+  job.next = 0;
+  job.n_workers = MIN (max_workers, n / MIN_PREMATCH_CHILDREN);
+  g_mutex_init (&job.mutex);
+  g_cond_init (&job.cond);
+
+  i = 0;
+  for (child = cssnode->first_child; child; child = child->next_sibling)
+    {
+      GtkCssPrematch *prematch;
+
+      if (!gtk_css_node_should_prematch (child))
+        continue;
+
+      prematch = &job.matches[i++];
+      prematch->node = child;
+      prematch->provider = gtk_css_node_get_style_provider (child);
+      prematch->has_matcher = gtk_css_node_init_matcher (child, &prematch->matcher);
+      if (prematch->has_matcher)
+        gtk_css_node_set_ancestor_filter (child, &prematch->matcher);
+      prematch->serial = match_serial;
+    }
+
+  for (i = 0; i < job.n_workers; i++)
+    g_thread_pool_push (pool, &job, NULL);
+
+  /* Help out instead of waiting */
+  gtk_css_prematch_job_run (&job);
+
+  g_mutex_lock (&job.mutex);
+  while (job.n_workers > 0)
+    g_cond_wait (&job.cond, &job.mutex);
+  g_mutex_unlock (&job.mutex);
+
+  g_mutex_clear (&job.mutex);
+  g_cond_clear (&job.cond);
+
+  *n_matches = n;
+
+  return job.matches;
+}
+
 static GtkCssStyle *
 gtk_css_node_real_update_style (GtkCssNode   *cssnode,
                                 GtkCssChange  change,
@@ -984,6 +1313,11 @@ gtk_css_node_ensure_style (GtkCssNode *cssnode,
   if (cssnode->style_is_invalid)
     {
       GtkCssStyle *new_style;
+      GtkCssNodeProfile *profile;
+
+      profile = gtk_css_node_get_profile_for_update (cssnode);
+      if (profile)
+        profile->n_validations++;
 
       if (cssnode->previous_sibling)
         gtk_css_node_ensure_style (cssnode->previous_sibling, current_time);
@@ -1009,9 +1343,28 @@ gtk_css_node_ensure_style (GtkCssNode *cssnode,
   cssnode->style_is_invalid = FALSE;
 }
 
+/* Validation skipped the node so far, but its parents might think
+ * it is valid. Tell them it is not, so it gets validated from now on.
+ */
+static void
+gtk_css_node_requeue_validate (GtkCssNode *cssnode)
+{
+  if (!cssnode->invalid)
+    return;
+
+  cssnode->invalid = FALSE;
+  gtk_css_node_set_invalid (cssnode, TRUE);
+}
+
 GtkCssStyle *
 gtk_css_node_get_style (GtkCssNode *cssnode)
 {
+  if (G_UNLIKELY (cssnode->lazy && !cssnode->style_requested))
+    {
+      cssnode->style_requested = TRUE;
+      gtk_css_node_requeue_validate (cssnode);
+    }
+
   if (gtk_css_node_needs_new_style (cssnode))
     {
       gint64 timestamp = gtk_css_node_get_timestamp (cssnode);
@@ -1089,6 +1442,32 @@ gtk_css_node_get_visible (GtkCssNode *cssnode)
   return cssnode->visible;
 }
 
+/*
+ * gtk_css_node_set_lazy:
+ * @cssnode: a #GtkCssNode
+ * @lazy: %TRUE to not compute styles before they are needed
+ *
+ * Lazy nodes are skipped during validation until someone calls
+ * gtk_css_node_get_style() for them the first time. Use this for
+ * nodes that are only drawn sometimes, like selections or arrows.
+ *
+ * Until then, the node does not emit #GtkCssNode::style-changed.
+ * Nodes following it still see it for sibling matching, and
+ * computing their styles computes the node's style, too.
+ */
+void
+gtk_css_node_set_lazy (GtkCssNode *cssnode,
+                       gboolean    lazy)
+{
+  if (cssnode->lazy == lazy)
+    return;
+
+  cssnode->lazy = lazy;
+
+  if (!lazy && !cssnode->style_requested)
+    gtk_css_node_requeue_validate (cssnode);
+}
+
 void
 gtk_css_node_set_name (GtkCssNode              *cssnode,
                        /*interned*/ const char *name)
@@ -1249,22 +1628,41 @@ gtk_css_node_get_declaration (GtkCssNode *cssnode)
   return cssnode->decl;
 }
 
-void
-gtk_css_node_invalidate_style_provider (GtkCssNode *cssnode)
+static void
+gtk_css_node_invalidate_style_provider_for (GtkCssNode       *cssnode,
+                                            GtkStyleProvider *provider)
 {
+  GtkCssMatcher matcher;
   GtkCssNode *child;
 
-  gtk_css_node_invalidate (cssnode, GTK_CSS_CHANGE_SOURCE);
+  /* Providers that can tell which rules changed spare us restyling
+   * the nodes those rules can't match */
+  if (!gtk_css_node_init_matcher (cssnode, &matcher) ||
+      gtk_style_provider_may_have_changed (provider, &matcher))
+    {
+      /* Our parent's cache still has our old style */
+      if (cssnode->parent)
+        g_clear_pointer (&cssnode->parent->cache, gtk_css_node_style_cache_unref);
+
+      gtk_css_node_invalidate (cssnode, GTK_CSS_CHANGE_SOURCE);
+    }
 
   for (child = cssnode->first_child;
        child;
        child = child->next_sibling)
     {
       if (gtk_css_node_get_style_provider_or_null (child) == NULL)
-        gtk_css_node_invalidate_style_provider (child);
+        gtk_css_node_invalidate_style_provider_for (child, provider);
     }
 }
 
+void
+gtk_css_node_invalidate_style_provider (GtkCssNode *cssnode)
+{
+  gtk_css_node_invalidate_style_provider_for (cssnode,
+                                              gtk_css_node_get_style_provider (cssnode));
+}
+
 static void
 gtk_css_node_invalidate_timestamp (GtkCssNode *cssnode)
 {
@@ -1306,6 +1704,14 @@ gtk_css_node_invalidate (GtkCssNode   *cssnode,
   if (change == 0)
     return;
 
+  /* Changes we propagate to children and siblings have no self bits */
+  if (change & (GTK_CSS_CHANGE_ANY_SELF | GTK_CSS_CHANGE_SOURCE))
+    match_serial++;
+
+  /* The style provider changed, so styles we shared are stale */
+  if (change & GTK_CSS_CHANGE_SOURCE)
+    gtk_css_node_style_cache_clear_shared ();
+
   cssnode->pending_changes |= change;
 
   GTK_CSS_NODE_GET_CLASS (cssnode)->invalidate (cssnode);
@@ -1320,6 +1726,11 @@ gtk_css_node_validate_internal (GtkCssNode *cssnode,
                                 gint64      timestamp)
 {
   GtkCssNode *child;
+  GtkCssPrematch *matches;
+  GHashTable *saved_prematched = NULL;
+  GtkCssBloomFilter *saved_filter;
+  GtkCssNode *saved_filter_node;
+  guint i, n_matches = 0, n_hashes = 0;
 
   if (!cssnode->invalid)
     return;
@@ -1333,23 +1744,92 @@ gtk_css_node_validate_internal (GtkCssNode *cssnode,
 
   GTK_CSS_NODE_GET_CLASS (cssnode)->validate (cssnode);
 
+  /* Path nodes match their ancestors by widget path, which the filter
+   * knows nothing about */
+  saved_filter = ancestor_filter;
+  saved_filter_node = ancestor_filter_node;
+  if (GTK_IS_CSS_PATH_NODE (cssnode))
+    ancestor_filter = NULL;
+  if (ancestor_filter)
+    {
+      n_hashes = gtk_css_node_push_ancestor (cssnode);
+      ancestor_filter_node = cssnode;
+    }
+
+  matches = gtk_css_node_prematch_children (cssnode, &n_matches);
+  if (matches)
+    {
+      saved_prematched = prematched;
+      prematched = g_hash_table_new (NULL, NULL);
+      for (i = 0; i < n_matches; i++)
+        g_hash_table_insert (prematched, matches[i].node, &matches[i]);
+    }
+
   for (child = gtk_css_node_get_first_child (cssnode);
        child;
        child = gtk_css_node_get_next_sibling (child))
     {
-      if (child->visible)
+      if (gtk_css_node_needs_validation (child))
         gtk_css_node_validate_internal (child, timestamp);
     }
+
+  if (matches)
+    {
+      g_hash_table_unref (prematched);
+      prematched = saved_prematched;
+      for (i = 0; i < n_matches; i++)
+        _gtk_css_lookup_destroy (&matches[i].lookup);
+      g_free (matches);
+    }
+
+  if (ancestor_filter)
+    gtk_css_node_pop_ancestor (n_hashes);
+  ancestor_filter = saved_filter;
+  ancestor_filter_node = saved_filter_node;
 }
 
 void
 gtk_css_node_validate (GtkCssNode *cssnode)
 {
+  GtkCssBloomFilter *saved_filter;
+  GArray *saved_hashes;
+  GtkCssNode *saved_filter_node, *ancestor;
+  guint saved_filter_serial;
   gint64 timestamp;
 
   timestamp = gtk_css_node_get_timestamp (cssnode);
 
+  /* Validating can recurse into other node trees */
+  saved_filter = ancestor_filter;
+  saved_hashes = ancestor_hashes;
+  saved_filter_node = ancestor_filter_node;
+  saved_filter_serial = ancestor_filter_serial;
+
+  ancestor_filter = g_new0 (GtkCssBloomFilter, 1);
+  ancestor_hashes = g_array_new (FALSE, FALSE, sizeof (guint32));
+  ancestor_filter_node = cssnode->parent;
+  ancestor_filter_serial = match_serial;
+
+  for (ancestor = cssnode->parent; ancestor; ancestor = ancestor->parent)
+    {
+      if (GTK_IS_CSS_PATH_NODE (ancestor))
+        {
+          g_clear_pointer (&ancestor_filter, g_free);
+          break;
+        }
+
+      gtk_css_node_push_ancestor (ancestor);
+    }
+
   gtk_css_node_validate_internal (cssnode, timestamp);
+
+  g_free (ancestor_filter);
+  g_array_unref (ancestor_hashes);
+
+  ancestor_filter = saved_filter;
+  ancestor_hashes = saved_hashes;
+  ancestor_filter_node = saved_filter_node;
+  ancestor_filter_serial = saved_filter_serial;
 }
 
 gboolean
@@ -1420,3 +1900,32 @@ gtk_css_node_print (GtkCssNode                *cssnode,
         gtk_css_node_print (node, flags, string, indent + 2);
     }
 }
+
+/* While profiling, a GtkCssNodeProfile is collected for every node whose
+ * style gets validated. The inspector uses this to find the nodes that
+ * are expensive to style.
+ */
+void
+gtk_css_node_set_profiling (gboolean enabled)
+{
+  profiling = enabled;
+}
+
+/* Returns %NULL if nothing was collected for @cssnode */
+const GtkCssNodeProfile *
+gtk_css_node_get_profile (GtkCssNode *cssnode)
+{
+  return cssnode->profile;
+}
+
+/* Clears the profiles of @cssnode and all its descendants */
+void
+gtk_css_node_reset_profile (GtkCssNode *cssnode)
+{
+  GtkCssNode *child;
+
+  g_clear_pointer (&cssnode->profile, g_free);
+
+  for (child = cssnode->first_child; child; child = child->next_sibling)
+    gtk_css_node_reset_profile (child);
+}
@@ -34,6 +34,17 @@ G_BEGIN_DECLS
 #define GTK_CSS_NODE_GET_CLASS(obj) (G_TYPE_INSTANCE_GET_CLASS ((obj), GTK_TYPE_CSS_NODE, GtkCssNodeClass))
 
 typedef struct _GtkCssNodeClass         GtkCssNodeClass;
+typedef struct _GtkCssNodeProfile       GtkCssNodeProfile;
+
+/* Collected while profiling is enabled, see gtk_css_node_set_profiling() */
+struct _GtkCssNodeProfile
+{
+  guint                  n_validations;         /* times the style was recomputed */
+  guint                  n_cache_hits;          /* styles found in the parent's or the shared cache */
+  guint                  n_cache_misses;        /* styles that had to be looked up in the providers */
+  guint64                n_rules_tested;        /* selectors tested while matching */
+  gint64                 match_time;            /* time spent matching selectors, in microseconds */
+};
 
 struct _GtkCssNode
 {
@@ -50,8 +61,11 @@ struct _GtkCssNode
   GtkCssNodeStyleCache  *cache;                 /* cache for children to look up styles */
 
   GtkCssChange           pending_changes;       /* changes that accumulated since the style was last computed */
+  GtkCssNodeProfile     *profile;               /* only allocated while profiling */
 
   guint                  visible :1;            /* node will be skipped when validating or computing styles */
+  guint                  lazy :1;               /* validation skips the node until its style was asked for */
+  guint                  style_requested :1;    /* someone called gtk_css_node_get_style() */
   guint                  invalid :1;            /* node or a child needs to be validated (even if just for animation) */
   guint                  needs_propagation :1;  /* children have state changes that need to be propagated to their siblings */
   /* Two invariants hold for this variable:
@@ -115,6 +129,8 @@ GtkCssNode *            gtk_css_node_get_next_sibling   (GtkCssNode            *
 void                    gtk_css_node_set_visible        (GtkCssNode            *cssnode,
                                                          gboolean               visible);
 gboolean                gtk_css_node_get_visible        (GtkCssNode            *cssnode);
+void                    gtk_css_node_set_lazy           (GtkCssNode            *cssnode,
+                                                         gboolean               lazy);
 
 void                    gtk_css_node_set_name           (GtkCssNode            *cssnode,
                                                          /*interned*/const char*name);
@@ -165,6 +181,11 @@ void                    gtk_css_node_print              (GtkCssNode
                                                          GString                   *string,
                                                          guint                      indent);
 
+void                    gtk_css_node_set_profiling      (gboolean               enabled);
+const GtkCssNodeProfile *
+                        gtk_css_node_get_profile        (GtkCssNode            *cssnode);
+void                    gtk_css_node_reset_profile      (GtkCssNode            *cssnode);
+
 G_END_DECLS
 
 #endif /* __GTK_CSS_NODE_PRIVATE_H__ */
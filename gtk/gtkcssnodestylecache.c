@@ -21,6 +21,9 @@
 
 #include "gtkdebug.h"
 #include "gtkcssstaticstyleprivate.h"
+#include "gtkwidgetpathprivate.h"
+
+#include "gdk/gdkcachesprivate.h"
 
 struct _GtkCssNodeStyleCache {
   guint        ref_count;
@@ -28,6 +31,39 @@ struct _GtkCssNodeStyleCache {
   GHashTable  *children;
 };
 
+/* The shared cache finds styles for nodes with equal declarations
+ * below equal parent styles, no matter where they are in the tree.
+ * Path nodes, which are matched by their widget path, also need an
+ * equal path.
+ */
+#define MAX_SHARED_STYLES 4096
+
+typedef struct {
+  GtkStyleProvider      *provider;
+  GtkCssStyle           *parent;
+  GtkWidgetPath         *path;
+  GtkCssNodeDeclaration *decl;
+  guint                  flags;
+} GtkCssSharedStyleKey;
+
+typedef struct {
+  GtkCssSharedStyleKey key;
+  GtkCssStyle         *style;
+  GList                lru_link;
+} GtkCssSharedStyle;
+
+/* A rough estimate of the memory an entry keeps alive. Value groups
+ * are mostly shared between styles, so they aren't counted.
+ */
+#define SHARED_STYLE_SIZE (sizeof (GtkCssSharedStyle) + sizeof (GtkCssStaticStyle))
+
+static GHashTable *shared_styles;
+/* Most recently used first */
+static GQueue shared_lru = G_QUEUE_INIT;
+static guint shared_hits;
+static guint shared_misses;
+static GdkCache *shared_cache;
+
 #define UNPACK_DECLARATION(packed) ((GtkCssNodeDeclaration *) (GPOINTER_TO_SIZE (packed) & ~0x3))
 #define UNPACK_FLAGS(packed) (GPOINTER_TO_SIZE (packed) & 0x3)
 #define PACK(decl, first_child, last_child) GSIZE_TO_POINTER (GPOINTER_TO_SIZE (decl) | ((first_child) ? 0x2 : 0) | ((last_child) ? 0x1 : 0))
@@ -111,6 +147,19 @@ may_be_stored_in_cache (GtkCssStyle *style)
   return TRUE;
 }
 
+static gboolean
+may_be_shared (GtkCssStyle *style)
+{
+  if (!may_be_stored_in_cache (style))
+    return FALSE;
+
+  /* Nodes sharing a parent style can have different grandparents */
+  if (gtk_css_static_style_get_change (GTK_CSS_STATIC_STYLE (style)) & GTK_CSS_CHANGE_ANY_PARENT)
+    return FALSE;
+
+  return TRUE;
+}
+
 static guint
 gtk_css_node_style_cache_decl_hash (gconstpointer item)
 {
@@ -180,3 +229,178 @@ gtk_css_node_style_cache_lookup (GtkCssNodeStyleCache        *parent,
   return gtk_css_node_style_cache_ref (result);
 }
 
+static guint
+gtk_css_shared_style_key_hash (gconstpointer item)
+{
+  const GtkCssSharedStyleKey *key = item;
+
+  return (GPOINTER_TO_UINT (key->provider) ^
+          GPOINTER_TO_UINT (key->parent) ^
+          (key->path ? gtk_widget_path_hash (key->path) : 0) ^
+          gtk_css_node_declaration_hash (key->decl)) << 2 | key->flags;
+}
+
+static gboolean
+gtk_css_shared_style_key_equal (gconstpointer item1,
+                                gconstpointer item2)
+{
+  const GtkCssSharedStyleKey *key1 = item1;
+  const GtkCssSharedStyleKey *key2 = item2;
+
+  return key1->provider == key2->provider &&
+         key1->parent == key2->parent &&
+         key1->flags == key2->flags &&
+         gtk_css_node_declaration_equal (key1->decl, key2->decl) &&
+         (key1->path == NULL) == (key2->path == NULL) &&
+         (key1->path == NULL || gtk_widget_path_equal (key1->path, key2->path));
+}
+
+static void
+gtk_css_shared_style_free (gpointer data)
+{
+  GtkCssSharedStyle *shared = data;
+
+  g_queue_unlink (&shared_lru, &shared->lru_link);
+
+  g_object_unref (shared->key.provider);
+  g_clear_object (&shared->key.parent);
+  g_clear_pointer (&shared->key.path, gtk_widget_path_unref);
+  gtk_css_node_declaration_unref (shared->key.decl);
+  g_object_unref (shared->style);
+
+  g_slice_free (GtkCssSharedStyle, shared);
+}
+
+static void
+trim_shared (guint max_styles)
+{
+  while (g_hash_table_size (shared_styles) > max_styles)
+    {
+      GtkCssSharedStyle *oldest = g_queue_peek_tail (&shared_lru);
+
+      g_hash_table_remove (shared_styles, &oldest->key);
+    }
+}
+
+static void
+shared_cache_get_size (gpointer  data,
+                       gsize    *cpu_bytes,
+                       gsize    *gpu_bytes)
+{
+  *cpu_bytes = g_hash_table_size (shared_styles) * SHARED_STYLE_SIZE;
+  *gpu_bytes = 0;
+}
+
+static void
+shared_cache_trim (gpointer data,
+                   gsize    max_bytes)
+{
+  trim_shared (max_bytes / SHARED_STYLE_SIZE);
+}
+
+GtkCssStyle *
+gtk_css_node_style_cache_lookup_shared (GtkStyleProvider            *provider,
+                                        GtkCssStyle                 *parent,
+                                        const GtkWidgetPath         *path,
+                                        const GtkCssNodeDeclaration *decl,
+                                        gboolean                     is_first,
+                                        gboolean                     is_last)
+{
+  GtkCssSharedStyleKey key;
+  GtkCssSharedStyle *shared;
+
+  if (shared_styles == NULL)
+    return NULL;
+
+  key.provider = provider;
+  key.parent = parent;
+  key.path = (GtkWidgetPath *) path;
+  key.decl = (GtkCssNodeDeclaration *) decl;
+  key.flags = (is_first ? 0x2 : 0) | (is_last ? 0x1 : 0);
+
+  shared = g_hash_table_lookup (shared_styles, &key);
+  if (shared == NULL)
+    {
+      shared_misses++;
+      return NULL;
+    }
+
+  shared_hits++;
+
+  g_queue_unlink (&shared_lru, &shared->lru_link);
+  g_queue_push_head_link (&shared_lru, &shared->lru_link);
+
+  return shared->style;
+}
+
+void
+gtk_css_node_style_cache_insert_shared (GtkStyleProvider      *provider,
+                                        GtkCssStyle           *parent,
+                                        GtkWidgetPath         *path,
+                                        GtkCssNodeDeclaration *decl,
+                                        gboolean               is_first,
+                                        gboolean               is_last,
+                                        GtkCssStyle           *style)
+{
+  GtkCssSharedStyle *shared;
+  gsize budget;
+
+  if (!may_be_shared (style))
+    return;
+
+  if (shared_styles == NULL)
+    {
+      shared_styles = g_hash_table_new_full (gtk_css_shared_style_key_hash,
+                                             gtk_css_shared_style_key_equal,
+                                             NULL,
+                                             gtk_css_shared_style_free);
+      shared_cache = gdk_cache_register ("css-styles",
+                                         MAX_SHARED_STYLES * SHARED_STYLE_SIZE,
+                                         shared_cache_get_size,
+                                         shared_cache_trim,
+                                         NULL);
+    }
+
+  budget = gdk_cache_get_budget (shared_cache);
+  if (budget > 0)
+    trim_shared (MAX (budget / SHARED_STYLE_SIZE, 1) - 1);
+
+  shared = g_slice_new (GtkCssSharedStyle);
+  shared->key.provider = g_object_ref (provider);
+  shared->key.parent = parent ? g_object_ref (parent) : NULL;
+  shared->key.path = path ? gtk_widget_path_ref (path) : NULL;
+  shared->key.decl = gtk_css_node_declaration_ref (decl);
+  shared->key.flags = (is_first ? 0x2 : 0) | (is_last ? 0x1 : 0);
+  shared->style = g_object_ref (style);
+  shared->lru_link.data = shared;
+  shared->lru_link.prev = NULL;
+  shared->lru_link.next = NULL;
+
+  g_queue_push_head_link (&shared_lru, &shared->lru_link);
+  g_hash_table_replace (shared_styles, &shared->key, shared);
+}
+
+/* Call this when styles computed up to now may be wrong, like
+ * when a style provider changes.
+ */
+void
+gtk_css_node_style_cache_clear_shared (void)
+{
+  if (shared_styles == NULL || g_hash_table_size (shared_styles) == 0)
+    return;
+
+  g_hash_table_remove_all (shared_styles);
+}
+
+void
+gtk_css_node_style_cache_get_shared_stats (guint *hits,
+                                           guint *misses,
+                                           guint *n_styles)
+{
+  if (hits)
+    *hits = shared_hits;
+  if (misses)
+    *misses = shared_misses;
+  if (n_styles)
+    *n_styles = shared_styles ? g_hash_table_size (shared_styles) : 0;
+}
@@ -20,6 +20,8 @@
 #include <string.h>
 #include <stdlib.h>
 
+#include <glib/gstdio.h>
+
 #include <gdk-pixbuf/gdk-pixbuf.h>
 #include <cairo-gobject.h>
 
@@ -74,6 +76,10 @@
  *
  * In the same way, GTK+ tries to load a gtk-keys.css file for the current
  * key theme, as defined by #GtkSettings:gtk-key-theme-name.
+ *
+ * If a theme file has an up-to-date `.compiled` version next to it,
+ * as created by gtk4-compile-css, GTK+ loads that instead, which is
+ * faster. See gtk_css_provider_to_bytes().
  */
 
 
@@ -114,11 +120,20 @@ struct _GtkCssProviderPrivate
 
   GHashTable *symbolic_colors;
   GHashTable *keyframes;
+  /* Pairs of binding set names and entries, for compiling */
+  GPtrArray *bindings;
+  /* Paths of the files that were parsed, including imports, for compiling */
+  GPtrArray *sources;
 
   GArray *rulesets;
   GtkCssSelectorTree *tree;
   GResource *resource;
   gchar *path;
+
+  /* The rules that changed while we emit a reload */
+  GtkCssSelectorTree *changed_tree;
+  /* Keeps ruleset selectors around for diffing reloads */
+  guint keep_selectors : 1;
 };
 
 enum {
@@ -426,11 +441,10 @@ gtk_css_scanner_pop_section (GtkCssScanner *scanner,
 }
 
 static void
-gtk_css_provider_init (GtkCssProvider *css_provider)
+gtk_css_provider_init_contents (GtkCssProviderPrivate *priv)
 {
-  GtkCssProviderPrivate *priv = gtk_css_provider_get_instance_private (css_provider);
-
   priv->rulesets = g_array_new (FALSE, FALSE, sizeof (GtkCssRuleset));
+  priv->tree = NULL;
 
   priv->symbolic_colors = g_hash_table_new_full (g_str_hash, g_str_equal,
                                                  (GDestroyNotify) g_free,
@@ -440,6 +454,16 @@ gtk_css_provider_init (GtkCssProvider *css_provider)
                                            (GDestroyNotify) _gtk_css_keyframes_unref);
 }
 
+static void
+gtk_css_provider_init (GtkCssProvider *css_provider)
+{
+  GtkCssProviderPrivate *priv = gtk_css_provider_get_instance_private (css_provider);
+
+  gtk_css_provider_init_contents (priv);
+  priv->bindings = g_ptr_array_new_with_free_func (g_free);
+  priv->sources = g_ptr_array_new_with_free_func (g_free);
+}
+
 static void
 verify_tree_match_results (GtkCssProvider *provider,
 			   const GtkCssMatcher *matcher,
@@ -489,7 +513,7 @@ verify_tree_get_change_results (GtkCssProvider *provider,
     GPtrArray *tree_rules;
     int i;
 
-    tree_rules = _gtk_css_selector_tree_match_all (priv->tree, matcher);
+    tree_rules = _gtk_css_selector_tree_match_all (priv->tree, matcher, NULL);
     if (tree_rules)
       {
         verify_tree_match_results (provider, matcher, tree_rules);
@@ -566,7 +590,7 @@ gtk_css_style_provider_lookup (GtkStyleProvider    *provider,
   int i;
   GPtrArray *tree_rules;
 
-  tree_rules = _gtk_css_selector_tree_match_all (priv->tree, matcher);
+  tree_rules = _gtk_css_selector_tree_match_all (priv->tree, matcher, &lookup->n_rules_tested);
   if (tree_rules)
     {
       verify_tree_match_results (css_provider, matcher, tree_rules);
@@ -614,12 +638,31 @@ gtk_css_style_provider_lookup (GtkStyleProvider    *provider,
     }
 }
 
+static gboolean
+gtk_css_style_provider_may_have_changed (GtkStyleProvider    *provider,
+                                         const GtkCssMatcher *matcher)
+{
+  GtkCssProvider *css_provider = GTK_CSS_PROVIDER (provider);
+  GtkCssProviderPrivate *priv = gtk_css_provider_get_instance_private (css_provider);
+  GtkCssMatcher change_matcher;
+
+  if (priv->changed_tree == NULL)
+    return TRUE;
+
+  /* Same as the change computed in lookup: nodes that don't match
+   * the changed rules this way neither use them nor depend on them */
+  _gtk_css_matcher_superset_init (&change_matcher, matcher, GTK_CSS_CHANGE_NAME | GTK_CSS_CHANGE_CLASS);
+
+  return _gtk_css_selector_tree_may_match (priv->changed_tree, &change_matcher);
+}
+
 static void
 gtk_css_style_provider_iface_init (GtkStyleProviderInterface *iface)
 {
   iface->get_color = gtk_css_style_provider_get_color;
   iface->get_keyframes = gtk_css_style_provider_get_keyframes;
   iface->lookup = gtk_css_style_provider_lookup;
+  iface->may_have_changed = gtk_css_style_provider_may_have_changed;
   iface->emit_error = gtk_css_style_provider_emit_error;
 }
 
@@ -638,6 +681,8 @@ gtk_css_provider_finalize (GObject *object)
 
   g_hash_table_destroy (priv->symbolic_colors);
   g_hash_table_destroy (priv->keyframes);
+  g_ptr_array_unref (priv->bindings);
+  g_ptr_array_unref (priv->sources);
 
   if (priv->resource)
     {
@@ -766,13 +811,15 @@ gtk_css_provider_reset (GtkCssProvider *css_provider)
 
   g_hash_table_remove_all (priv->symbolic_colors);
   g_hash_table_remove_all (priv->keyframes);
+  g_ptr_array_set_size (priv->bindings, 0);
+  g_ptr_array_set_size (priv->sources, 0);
 
   for (i = 0; i < priv->rulesets->len; i++)
     gtk_css_ruleset_clear (&g_array_index (priv->rulesets, GtkCssRuleset, i));
   g_array_set_size (priv->rulesets, 0);
   _gtk_css_selector_tree_free (priv->tree);
   priv->tree = NULL;
-
+  priv->keep_selectors = FALSE;
 }
 
 static gboolean
@@ -901,6 +948,7 @@ parse_color_definition (GtkCssScanner *scanner)
 static gboolean
 parse_binding_set (GtkCssScanner *scanner)
 {
+  GtkCssProviderPrivate *priv = gtk_css_provider_get_instance_private (scanner->provider);
   GtkBindingSet *binding_set;
   char *name;
 
@@ -960,9 +1008,13 @@ parse_binding_set (GtkCssScanner *scanner)
                                           GTK_CSS_PROVIDER_ERROR,
                                           GTK_CSS_PROVIDER_ERROR_SYNTAX,
                                           "Failed to parse binding set.");
+          g_free (name);
+        }
+      else
+        {
+          g_ptr_array_add (priv->bindings, g_strdup (binding_set->set_name));
+          g_ptr_array_add (priv->bindings, name);
         }
-
-      g_free (name);
 
       if (!_gtk_css_parser_try (scanner->parser, ";", TRUE))
         {
@@ -1360,36 +1412,541 @@ gtk_css_provider_postprocess (GtkCssProvider *css_provider)
   _gtk_css_selector_tree_builder_free (builder);
 
 #ifndef VERIFY_TREE
-  for (i = 0; i < priv->rulesets->len; i++)
+  if (!priv->keep_selectors)
     {
-      GtkCssRuleset *ruleset;
+      for (i = 0; i < priv->rulesets->len; i++)
+        {
+          GtkCssRuleset *ruleset;
 
-      ruleset = &g_array_index (priv->rulesets, GtkCssRuleset, i);
+          ruleset = &g_array_index (priv->rulesets, GtkCssRuleset, i);
 
-      _gtk_css_selector_free (ruleset->selector);
-      ruleset->selector = NULL;
+          _gtk_css_selector_free (ruleset->selector);
+          ruleset->selector = NULL;
+        }
     }
 #endif
 }
 
+/* COMPILED STYLESHEETS
+ *
+ * gtk_css_provider_to_bytes() stores what parsing a stylesheet produced:
+ * the rulesets, their declarations with values printed in canonical
+ * form, the selector tree, named colors, keyframes and binding sets.
+ * Loading that only has to parse the individual values, the tree is
+ * used as is.
+ *
+ * The format deliberately depends on the GTK version and architecture
+ * that wrote it, it is meant to be regenerated when either changes.
+ * All numbers are 32bit in host byte order, strings are offsets into a
+ * pool of nul-terminated strings at the end of the file.
+ *
+ * Imports are inlined, so the file also lists every file that was parsed
+ * with its size and modification time. A compiled theme is only used if
+ * none of them changed, see _gtk_css_find_compiled().
+ */
+
+#define GTK_CSS_COMPILED_MAGIC "GtkCssC"
+#define GTK_CSS_COMPILED_FORMAT 2
+#define GTK_CSS_COMPILED_GTK_VERSION ((GTK_MAJOR_VERSION << 16) | (GTK_MINOR_VERSION << 8) | GTK_MICRO_VERSION)
+
+typedef struct {
+  char    magic[8];
+  guint32 format;
+  guint32 gtk_version;
+  guint32 pointer_size;
+  guint32 tree_node_size;
+  guint32 n_colors;         /* pairs of name and value */
+  guint32 n_keyframes;      /* pairs of name and keyframes */
+  guint32 n_bindings;       /* pairs of binding set name and entry */
+  guint32 n_rulesets;       /* pairs of first declaration and count */
+  guint32 n_declarations;   /* pairs of property name and value */
+  guint32 tree_size;
+  guint32 strings_size;
+  guint32 n_sources;        /* path, size and mtime, see SOURCE_REFS */
+} GtkCssCompiledHeader;
+
+/* The path and the 64bit size and mtime, low word first */
+#define SOURCE_REFS 5
+
+static gboolean
+gtk_css_compiled_is_compiled (const char *data,
+                              gsize       size)
+{
+  return size >= sizeof (GtkCssCompiledHeader) &&
+         memcmp (data, GTK_CSS_COMPILED_MAGIC, sizeof (GTK_CSS_COMPILED_MAGIC)) == 0;
+}
+
+static gboolean
+gtk_css_compiled_check_header (const char  *data,
+                               gsize        size,
+                               GError     **error)
+{
+  GtkCssCompiledHeader header;
+  guint64 expected;
+
+  if (!gtk_css_compiled_is_compiled (data, size))
+    {
+      g_set_error_literal (error, GTK_CSS_PROVIDER_ERROR, GTK_CSS_PROVIDER_ERROR_FAILED,
+                           "Not a compiled stylesheet");
+      return FALSE;
+    }
+
+  memcpy (&header, data, sizeof (GtkCssCompiledHeader));
+
+  if (header.format != GTK_CSS_COMPILED_FORMAT ||
+      header.gtk_version != GTK_CSS_COMPILED_GTK_VERSION ||
+      header.pointer_size != sizeof (gpointer) ||
+      header.tree_node_size != _gtk_css_selector_tree_get_node_size ())
+    {
+      g_set_error_literal (error, GTK_CSS_PROVIDER_ERROR, GTK_CSS_PROVIDER_ERROR_FAILED,
+                           "Stylesheet was compiled by a different version of GTK");
+      return FALSE;
+    }
+
+  expected = sizeof (GtkCssCompiledHeader) +
+             sizeof (guint32) * 2 * ((guint64) header.n_colors + header.n_keyframes + header.n_bindings +
+                                     header.n_rulesets + header.n_declarations) +
+             sizeof (guint32) * SOURCE_REFS * (guint64) header.n_sources +
+             header.tree_size +
+             header.strings_size;
+
+  if (expected != size)
+    {
+      g_set_error_literal (error, GTK_CSS_PROVIDER_ERROR, GTK_CSS_PROVIDER_ERROR_FAILED,
+                           "Compiled stylesheet is truncated");
+      return FALSE;
+    }
+
+  return TRUE;
+}
+
+typedef struct {
+  GtkCssProvider *provider;
+  GFile *file;
+  const guint32 *refs;
+  const char *strings;
+  gsize strings_size;
+} GtkCssCompiledLoader;
+
+static const char *
+gtk_css_compiled_loader_get_string (GtkCssCompiledLoader *loader,
+                                    guint                 i)
+{
+  guint32 offset = loader->refs[i];
+
+  if (offset >= loader->strings_size)
+    return NULL;
+
+  return loader->strings + offset;
+}
+
+static GtkCssScanner *
+gtk_css_compiled_loader_scan (GtkCssCompiledLoader *loader,
+                              const char           *text)
+{
+  return gtk_css_scanner_new (loader->provider, NULL, NULL, loader->file, text);
+}
+
+static gboolean
+gtk_css_compiled_loader_finish (GtkCssCompiledLoader *loader,
+                                GtkCssScanner        *scanner,
+                                gpointer              result)
+{
+  if (result != NULL && !_gtk_css_parser_is_eof (scanner->parser))
+    _gtk_css_parser_error (scanner->parser, "Junk at end of compiled value");
+
+  gtk_css_scanner_destroy (scanner);
+
+  return result != NULL;
+}
+
+static gboolean
+gtk_css_compiled_load_colors (GtkCssCompiledLoader *loader,
+                              guint                 n_colors)
+{
+  GtkCssProviderPrivate *priv = gtk_css_provider_get_instance_private (loader->provider);
+  guint i;
+
+  for (i = 0; i < n_colors; i++)
+    {
+      const char *name, *text;
+      GtkCssScanner *scanner;
+      GtkCssValue *color;
+
+      name = gtk_css_compiled_loader_get_string (loader, 2 * i);
+      text = gtk_css_compiled_loader_get_string (loader, 2 * i + 1);
+      if (name == NULL || text == NULL)
+        return FALSE;
+
+      scanner = gtk_css_compiled_loader_scan (loader, text);
+      color = _gtk_css_color_value_parse (scanner->parser);
+      if (gtk_css_compiled_loader_finish (loader, scanner, color))
+        g_hash_table_insert (priv->symbolic_colors, g_strdup (name), color);
+      else if (color)
+        _gtk_css_value_unref (color);
+    }
+
+  loader->refs += 2 * n_colors;
+
+  return TRUE;
+}
+
+static gboolean
+gtk_css_compiled_load_keyframes (GtkCssCompiledLoader *loader,
+                                 guint                 n_keyframes)
+{
+  GtkCssProviderPrivate *priv = gtk_css_provider_get_instance_private (loader->provider);
+  guint i;
+
+  for (i = 0; i < n_keyframes; i++)
+    {
+      const char *name, *text;
+      GtkCssScanner *scanner;
+      GtkCssKeyframes *keyframes;
+
+      name = gtk_css_compiled_loader_get_string (loader, 2 * i);
+      text = gtk_css_compiled_loader_get_string (loader, 2 * i + 1);
+      if (name == NULL || text == NULL)
+        return FALSE;
+
+      scanner = gtk_css_compiled_loader_scan (loader, text);
+      /* Keyframes are stored with their closing bracket */
+      keyframes = _gtk_css_keyframes_parse (scanner->parser);
+      if (keyframes)
+        _gtk_css_parser_try (scanner->parser, "}", TRUE);
+      if (gtk_css_compiled_loader_finish (loader, scanner, keyframes))
+        g_hash_table_insert (priv->keyframes, g_strdup (name), keyframes);
+      else if (keyframes)
+        _gtk_css_keyframes_unref (keyframes);
+    }
+
+  loader->refs += 2 * n_keyframes;
+
+  return TRUE;
+}
+
+static gboolean
+gtk_css_compiled_load_bindings (GtkCssCompiledLoader *loader,
+                                guint                 n_bindings)
+{
+  GtkCssProviderPrivate *priv = gtk_css_provider_get_instance_private (loader->provider);
+  guint i;
+
+  for (i = 0; i < n_bindings; i++)
+    {
+      GtkBindingSet *binding_set;
+      const char *name, *entry;
+
+      name = gtk_css_compiled_loader_get_string (loader, 2 * i);
+      entry = gtk_css_compiled_loader_get_string (loader, 2 * i + 1);
+      if (name == NULL || entry == NULL)
+        return FALSE;
+
+      binding_set = gtk_binding_set_find (name);
+      if (!binding_set)
+        {
+          binding_set = gtk_binding_set_new (name);
+          binding_set->parsed = TRUE;
+        }
+
+      if (gtk_binding_entry_add_signal_from_string (binding_set, entry) != G_TOKEN_NONE)
+        {
+          gtk_css_provider_error_literal (loader->provider,
+                                          NULL,
+                                          GTK_CSS_PROVIDER_ERROR,
+                                          GTK_CSS_PROVIDER_ERROR_SYNTAX,
+                                          "Failed to parse binding set.");
+          continue;
+        }
+
+      g_ptr_array_add (priv->bindings, g_strdup (name));
+      g_ptr_array_add (priv->bindings, g_strdup (entry));
+    }
+
+  loader->refs += 2 * n_bindings;
+
+  return TRUE;
+}
+
+static gboolean
+gtk_css_compiled_load_styles (GtkCssCompiledLoader *loader,
+                              GtkCssRuleset        *ruleset,
+                              const guint32        *declarations)
+{
+  guint i;
+
+  ruleset->styles = g_new (PropertyValue, ruleset->n_styles);
+  ruleset->owns_styles = TRUE;
+
+  for (i = 0; i < ruleset->n_styles; )
+    {
+      GtkStyleProperty *property;
+      GtkCssScanner *scanner;
+      GtkCssValue *value;
+      guint32 name, text;
+
+      name = declarations[2 * i];
+      text = declarations[2 * i + 1];
+      if (name >= loader->strings_size || text >= loader->strings_size)
+        break;
+
+      property = _gtk_style_property_lookup (loader->strings + name);
+      if (!GTK_IS_CSS_STYLE_PROPERTY (property))
+        break;
+
+      scanner = gtk_css_compiled_loader_scan (loader, loader->strings + text);
+      value = _gtk_style_property_parse_value (property, scanner->parser);
+      if (!gtk_css_compiled_loader_finish (loader, scanner, value))
+        {
+          if (value)
+            _gtk_css_value_unref (value);
+          /* Keep going like the parser does for invalid declarations */
+          declarations += 2;
+          ruleset->n_styles--;
+          continue;
+        }
+
+      ruleset->styles[i].property = GTK_CSS_STYLE_PROPERTY (property);
+      ruleset->styles[i].value = value;
+      ruleset->styles[i].section = NULL;
+      i++;
+    }
+
+  if (i < ruleset->n_styles)
+    {
+      /* Only keep what we initialized, so the ruleset can be cleared */
+      ruleset->n_styles = i;
+      return FALSE;
+    }
+
+  return TRUE;
+}
+
+static gboolean
+gtk_css_compiled_load_rulesets (GtkCssCompiledLoader *loader,
+                                guint                 n_rulesets,
+                                guint                 n_declarations)
+{
+  GtkCssProviderPrivate *priv = gtk_css_provider_get_instance_private (loader->provider);
+  const guint32 *rulesets, *declarations;
+  GHashTable *shared;
+  gboolean result = FALSE;
+  guint i, j;
+
+  rulesets = loader->refs;
+  declarations = loader->refs + 2 * n_rulesets;
+
+  /* Copies made for selector lists share their styles */
+  shared = g_hash_table_new (NULL, NULL);
+
+  g_array_set_size (priv->rulesets, n_rulesets);
+  memset (priv->rulesets->data, 0, n_rulesets * sizeof (GtkCssRuleset));
+
+  for (i = 0; i < n_rulesets; i++)
+    {
+      GtkCssRuleset *ruleset, *owner;
+      guint32 first, n;
+
+      ruleset = &g_array_index (priv->rulesets, GtkCssRuleset, i);
+      first = rulesets[2 * i];
+      n = rulesets[2 * i + 1];
+
+      if (n == 0)
+        continue;
+
+      if (first >= n_declarations || n > n_declarations - first)
+        goto out;
+
+      owner = g_hash_table_lookup (shared, GUINT_TO_POINTER (first + 1));
+      if (owner == NULL)
+        {
+          ruleset->n_styles = n;
+          if (!gtk_css_compiled_load_styles (loader, ruleset, declarations + 2 * first))
+            goto out;
+          g_hash_table_insert (shared, GUINT_TO_POINTER (first + 1), ruleset);
+        }
+      else
+        {
+          ruleset->styles = owner->styles;
+          ruleset->n_styles = owner->n_styles;
+        }
+
+      ruleset->set_styles = _gtk_bitmask_new ();
+      for (j = 0; j < ruleset->n_styles; j++)
+        ruleset->set_styles = _gtk_bitmask_set (ruleset->set_styles,
+                                                _gtk_css_style_property_get_id (ruleset->styles[j].property),
+                                                TRUE);
+    }
+
+  loader->refs += 2 * (n_rulesets + n_declarations);
+  result = TRUE;
+
+out:
+  g_hash_table_unref (shared);
+
+  return result;
+}
+
+static gboolean
+gtk_css_compiled_load_tree (GtkCssCompiledLoader *loader,
+                            const guint8         *data,
+                            gsize                 size)
+{
+  GtkCssProviderPrivate *priv = gtk_css_provider_get_instance_private (loader->provider);
+  GtkCssSelectorTree **selector_matches;
+  gpointer *matches;
+  gboolean result;
+  guint i, n;
+
+  n = priv->rulesets->len;
+  matches = g_new (gpointer, n);
+  selector_matches = g_new (GtkCssSelectorTree *, n);
+
+  for (i = 0; i < n; i++)
+    matches[i] = &g_array_index (priv->rulesets, GtkCssRuleset, i);
+
+  result = _gtk_css_selector_tree_deserialize (data, size,
+                                               loader->strings, loader->strings_size,
+                                               matches, selector_matches, n,
+                                               &priv->tree);
+  if (result)
+    {
+      for (i = 0; i < n; i++)
+        g_array_index (priv->rulesets, GtkCssRuleset, i).selector_match = selector_matches[i];
+    }
+
+  g_free (matches);
+  g_free (selector_matches);
+
+  return result;
+}
+
+/* Returns %FALSE if @data is not a compiled stylesheet */
+static gboolean
+gtk_css_provider_load_compiled (GtkCssProvider *css_provider,
+                                GFile          *file,
+                                const char     *data,
+                                gsize           size)
+{
+  GtkCssCompiledHeader header;
+  GtkCssCompiledLoader loader;
+  GError *error = NULL;
+  const guint8 *tree;
+  guint32 *refs;
+
+  if (!gtk_css_compiled_is_compiled (data, size))
+    return FALSE;
+
+  if (!gtk_css_compiled_check_header (data, size, &error))
+    {
+      gtk_css_provider_take_error (css_provider, NULL, error);
+      return TRUE;
+    }
+
+  memcpy (&header, data, sizeof (GtkCssCompiledHeader));
+
+  /* The string refs are copied so they are aligned */
+  refs = g_memdup (data + sizeof (GtkCssCompiledHeader),
+                   size - sizeof (GtkCssCompiledHeader) - header.tree_size - header.strings_size);
+
+  loader.provider = css_provider;
+  loader.file = file;
+  loader.refs = refs;
+  loader.strings = data + size - header.strings_size;
+  loader.strings_size = header.strings_size;
+  tree = (const guint8 *) loader.strings - header.tree_size;
+
+  if (header.strings_size == 0 || loader.strings[header.strings_size - 1] != '\0' ||
+      !gtk_css_compiled_load_colors (&loader, header.n_colors) ||
+      !gtk_css_compiled_load_keyframes (&loader, header.n_keyframes) ||
+      !gtk_css_compiled_load_bindings (&loader, header.n_bindings) ||
+      !gtk_css_compiled_load_rulesets (&loader, header.n_rulesets, header.n_declarations) ||
+      !gtk_css_compiled_load_tree (&loader, tree, header.tree_size))
+    {
+      gtk_css_provider_reset (css_provider);
+      gtk_css_provider_error_literal (css_provider,
+                                      NULL,
+                                      GTK_CSS_PROVIDER_ERROR,
+                                      GTK_CSS_PROVIDER_ERROR_FAILED,
+                                      "Compiled stylesheet is corrupt");
+    }
+
+  g_free (refs);
+
+  return TRUE;
+}
+
+/* Compiled stylesheets are mapped instead of being read */
+static gboolean
+gtk_css_provider_load_mapped (GtkCssProvider *css_provider,
+                              GFile          *file)
+{
+  GMappedFile *mapped;
+  gboolean result;
+  char *path;
+
+  path = g_file_get_path (file);
+  if (path == NULL)
+    return FALSE;
+
+  mapped = g_mapped_file_new (path, FALSE, NULL);
+  g_free (path);
+  if (mapped == NULL)
+    return FALSE;
+
+  result = gtk_css_provider_load_compiled (css_provider,
+                                           file,
+                                           g_mapped_file_get_contents (mapped),
+                                           g_mapped_file_get_length (mapped));
+
+  g_mapped_file_unref (mapped);
+
+  return result;
+}
+
 static void
 gtk_css_provider_load_internal (GtkCssProvider *css_provider,
                                 GtkCssScanner  *parent,
                                 GFile          *file,
                                 const char     *text)
 {
+  GtkCssProviderPrivate *priv = gtk_css_provider_get_instance_private (css_provider);
   GtkCssScanner *scanner;
   GBytes *bytes;
 
   if (text == NULL)
     {
       GError *load_error = NULL;
+      char *path;
+      gsize size;
+
+      if (parent == NULL && gtk_css_provider_load_mapped (css_provider, file))
+        return;
 
       bytes = g_file_load_bytes (file, NULL, NULL, &load_error);
 
       if (bytes)
         {
-          text = g_bytes_get_data (bytes, NULL);
+          text = g_bytes_get_data (bytes, &size);
+
+          if (gtk_css_compiled_is_compiled (text, size))
+            {
+              if (parent == NULL)
+                gtk_css_provider_load_compiled (css_provider, file, text, size);
+              else
+                gtk_css_provider_error_literal (css_provider,
+                                                parent,
+                                                GTK_CSS_PROVIDER_ERROR,
+                                                GTK_CSS_PROVIDER_ERROR_IMPORT,
+                                                "Compiled stylesheets can not be imported");
+
+              g_bytes_unref (bytes);
+              return;
+            }
+
+          path = g_file_get_path (file);
+          if (path)
+            g_ptr_array_add (priv->sources, path);
         }
       else
         {
@@ -1446,6 +2003,219 @@ gtk_css_provider_load_internal (GtkCssProvider *css_provider,
     g_bytes_unref (bytes);
 }
 
+/* INCREMENTAL RELOADING
+ *
+ * Apps that reload their CSS from data, for example to change colors,
+ * mostly keep the same rules. So instead of restyling every node, we
+ * compare the rulesets before and after the reload and only restyle
+ * the nodes that may be matched by the rules that changed. Changes to
+ * named colors and keyframes can affect rules in other providers too,
+ * so those still restyle everything.
+ */
+
+static gboolean
+gtk_css_ruleset_equal (const GtkCssRuleset *a,
+                       const GtkCssRuleset *b)
+{
+  guint i, j;
+
+  if (a->n_styles != b->n_styles)
+    return FALSE;
+
+  for (i = 0; i < a->n_styles; i++)
+    {
+      for (j = 0; j < b->n_styles; j++)
+        {
+          if (a->styles[i].property == b->styles[j].property)
+            break;
+        }
+
+      if (j == b->n_styles ||
+          !_gtk_css_value_equal (a->styles[i].value, b->styles[j].value))
+        return FALSE;
+    }
+
+  return TRUE;
+}
+
+static gboolean
+gtk_css_provider_colors_equal (GHashTable *a,
+                               GHashTable *b)
+{
+  GHashTableIter iter;
+  gpointer name, color;
+  GtkCssValue *other;
+
+  if (g_hash_table_size (a) != g_hash_table_size (b))
+    return FALSE;
+
+  g_hash_table_iter_init (&iter, a);
+  while (g_hash_table_iter_next (&iter, &name, &color))
+    {
+      other = g_hash_table_lookup (b, name);
+      if (other == NULL || !_gtk_css_value_equal (color, other))
+        return FALSE;
+    }
+
+  return TRUE;
+}
+
+static gboolean
+gtk_css_provider_keyframes_equal (GHashTable *a,
+                                  GHashTable *b)
+{
+  GHashTableIter iter;
+  gpointer name, keyframes;
+  GtkCssKeyframes *other;
+  GString *str, *other_str;
+  gboolean result;
+
+  if (g_hash_table_size (a) != g_hash_table_size (b))
+    return FALSE;
+
+  str = g_string_new (NULL);
+  other_str = g_string_new (NULL);
+  result = TRUE;
+
+  g_hash_table_iter_init (&iter, a);
+  while (result && g_hash_table_iter_next (&iter, &name, &keyframes))
+    {
+      other = g_hash_table_lookup (b, name);
+      if (other == NULL)
+        {
+          result = FALSE;
+          break;
+        }
+
+      g_string_truncate (str, 0);
+      g_string_truncate (other_str, 0);
+      _gtk_css_keyframes_print (keyframes, str);
+      _gtk_css_keyframes_print (other, other_str);
+      result = g_string_equal (str, other_str);
+    }
+
+  g_string_free (str, TRUE);
+  g_string_free (other_str, TRUE);
+
+  return result;
+}
+
+/* Returns a tree of the selectors of all rulesets that were added,
+ * removed or changed, or %NULL if nothing changed or @changed_all
+ * got set. */
+static GtkCssSelectorTree *
+gtk_css_provider_diff (GtkCssProvider *css_provider,
+                       GArray         *old_rulesets,
+                       GHashTable     *old_colors,
+                       GHashTable     *old_keyframes,
+                       gboolean       *changed_all)
+{
+  GtkCssProviderPrivate *priv = gtk_css_provider_get_instance_private (css_provider);
+  GtkCssSelectorTreeBuilder *builder;
+  GtkCssSelectorTree *tree;
+  guint i, j, n_changed;
+
+  *changed_all = !gtk_css_provider_colors_equal (old_colors, priv->symbolic_colors) ||
+                 !gtk_css_provider_keyframes_equal (old_keyframes, priv->keyframes);
+  if (*changed_all)
+    return NULL;
+
+  builder = _gtk_css_selector_tree_builder_new ();
+  n_changed = 0;
+
+  /* Both arrays are sorted by selector, and rulesets with the same
+   * selector stay in the order they were parsed in. */
+  i = j = 0;
+  while (i < old_rulesets->len || j < priv->rulesets->len)
+    {
+      GtkCssRuleset *old = NULL, *new = NULL;
+      int compare;
+
+      if (i < old_rulesets->len)
+        old = &g_array_index (old_rulesets, GtkCssRuleset, i);
+      if (j < priv->rulesets->len)
+        new = &g_array_index (priv->rulesets, GtkCssRuleset, j);
+
+      if (old && new)
+        compare = _gtk_css_selector_compare (old->selector, new->selector);
+      else
+        compare = old ? -1 : 1;
+
+      if (compare == 0)
+        {
+          if (!gtk_css_ruleset_equal (old, new))
+            {
+              _gtk_css_selector_tree_builder_add (builder, new->selector, NULL, new);
+              n_changed++;
+            }
+          i++;
+          j++;
+        }
+      else if (compare < 0)
+        {
+          _gtk_css_selector_tree_builder_add (builder, old->selector, NULL, old);
+          n_changed++;
+          i++;
+        }
+      else
+        {
+          _gtk_css_selector_tree_builder_add (builder, new->selector, NULL, new);
+          n_changed++;
+          j++;
+        }
+    }
+
+  if (n_changed > 0)
+    tree = _gtk_css_selector_tree_builder_build (builder);
+  else
+    tree = NULL;
+  _gtk_css_selector_tree_builder_free (builder);
+
+  return tree;
+}
+
+static void
+gtk_css_provider_reload_from_data (GtkCssProvider *css_provider,
+                                   const char     *data)
+{
+  GtkCssProviderPrivate *priv = gtk_css_provider_get_instance_private (css_provider);
+  GArray *old_rulesets;
+  GtkCssSelectorTree *old_tree;
+  GHashTable *old_colors, *old_keyframes;
+  gboolean changed_all;
+  guint i;
+
+  old_rulesets = priv->rulesets;
+  old_tree = priv->tree;
+  old_colors = priv->symbolic_colors;
+  old_keyframes = priv->keyframes;
+
+  gtk_css_provider_init_contents (priv);
+  g_ptr_array_set_size (priv->bindings, 0);
+  g_ptr_array_set_size (priv->sources, 0);
+
+  gtk_css_provider_load_internal (css_provider, NULL, NULL, data);
+
+  priv->changed_tree = gtk_css_provider_diff (css_provider,
+                                              old_rulesets,
+                                              old_colors,
+                                              old_keyframes,
+                                              &changed_all);
+
+  if (changed_all || priv->changed_tree)
+    gtk_style_provider_changed (GTK_STYLE_PROVIDER (css_provider));
+
+  _gtk_css_selector_tree_free (priv->changed_tree);
+  priv->changed_tree = NULL;
+
+  for (i = 0; i < old_rulesets->len; i++)
+    gtk_css_ruleset_clear (&g_array_index (old_rulesets, GtkCssRuleset, i));
+  g_array_free (old_rulesets, TRUE);
+  _gtk_css_selector_tree_free (old_tree);
+  g_hash_table_destroy (old_colors);
+  g_hash_table_destroy (old_keyframes);
+}
+
 /**
  * gtk_css_provider_load_from_data:
  * @css_provider: a #GtkCssProvider
@@ -1456,12 +2226,16 @@ gtk_css_provider_load_internal (GtkCssProvider *css_provider,
  *
  * Loads @data into @css_provider, and by doing so clears any previously loaded
  * information.
+ *
+ * When @css_provider was loaded from data before, only the widgets
+ * affected by the rules that differ are restyled.
  **/
 void
 gtk_css_provider_load_from_data (GtkCssProvider  *css_provider,
                                  const gchar     *data,
                                  gssize           length)
 {
+  GtkCssProviderPrivate *priv = gtk_css_provider_get_instance_private (css_provider);
   char *free_data;
 
   g_return_if_fail (GTK_IS_CSS_PROVIDER (css_provider));
@@ -1478,13 +2252,21 @@ gtk_css_provider_load_from_data (GtkCssProvider  *css_provider,
       data = free_data;
     }
 
-  gtk_css_provider_reset (css_provider);
+  if (priv->keep_selectors)
+    {
+      gtk_css_provider_reload_from_data (css_provider, data);
+    }
+  else
+    {
+      gtk_css_provider_reset (css_provider);
+      priv->keep_selectors = TRUE;
 
-  gtk_css_provider_load_internal (css_provider, NULL, NULL, data);
+      gtk_css_provider_load_internal (css_provider, NULL, NULL, data);
 
-  g_free (free_data);
+      gtk_style_provider_changed (GTK_STYLE_PROVIDER (css_provider));
+    }
 
-  gtk_style_provider_changed (GTK_STYLE_PROVIDER (css_provider));
+  g_free (free_data);
 }
 
 /**
@@ -1685,6 +2467,96 @@ _gtk_css_find_theme (const gchar *name,
   return path;
 }
 
+/* Whether the files the compiled stylesheet in @data was made from are
+ * unchanged. Modification times only have a resolution of a second, so
+ * files that were changed in the same second as the compiled stylesheet
+ * count as changed.
+ */
+static gboolean
+gtk_css_compiled_check_sources (const char *data,
+                                gsize       size,
+                                time_t      compiled_mtime)
+{
+  GtkCssCompiledHeader header;
+  const char *refs, *strings;
+  guint i;
+
+  memcpy (&header, data, sizeof (GtkCssCompiledHeader));
+
+  if (header.n_sources == 0 ||
+      header.strings_size == 0 ||
+      data[size - 1] != '\0')
+    return FALSE;
+
+  refs = data + sizeof (GtkCssCompiledHeader) +
+         sizeof (guint32) * 2 * ((gsize) header.n_colors + header.n_keyframes + header.n_bindings +
+                                 header.n_rulesets + header.n_declarations);
+  strings = data + size - header.strings_size;
+
+  for (i = 0; i < header.n_sources; i++)
+    {
+      guint32 source[SOURCE_REFS];
+      GStatBuf st;
+      guint64 source_size, source_mtime;
+
+      /* The refs are not necessarily aligned */
+      memcpy (source, refs + sizeof (guint32) * SOURCE_REFS * i, sizeof (source));
+      if (source[0] >= header.strings_size)
+        return FALSE;
+
+      source_size = source[1] | ((guint64) source[2] << 32);
+      source_mtime = source[3] | ((guint64) source[4] << 32);
+
+      if (g_stat (strings + source[0], &st) != 0 ||
+          (guint64) st.st_size != source_size ||
+          (guint64) st.st_mtime != source_mtime ||
+          st.st_mtime >= compiled_mtime)
+        return FALSE;
+    }
+
+  return TRUE;
+}
+
+/* Returns the compiled version of the stylesheet at @path,
+ * if there is an up-to-date one we can load */
+static gchar *
+_gtk_css_find_compiled (const gchar *path)
+{
+  GStatBuf source, compiled;
+  GMappedFile *mapped;
+  gchar *result;
+
+  result = g_strconcat (path, ".compiled", NULL);
+
+  if (g_stat (result, &compiled) != 0 ||
+      g_stat (path, &source) != 0 ||
+      compiled.st_mtime <= source.st_mtime)
+    goto fail;
+
+  mapped = g_mapped_file_new (result, FALSE, NULL);
+  if (mapped == NULL)
+    goto fail;
+
+  if (!gtk_css_compiled_check_header (g_mapped_file_get_contents (mapped),
+                                      g_mapped_file_get_length (mapped),
+                                      NULL) ||
+      !gtk_css_compiled_check_sources (g_mapped_file_get_contents (mapped),
+                                       g_mapped_file_get_length (mapped),
+                                       compiled.st_mtime))
+    {
+      g_mapped_file_unref (mapped);
+      goto fail;
+    }
+
+  g_mapped_file_unref (mapped);
+
+  return result;
+
+fail:
+  g_free (result);
+  return NULL;
+}
+
 /**
  * _gtk_css_provider_load_named:
  * @provider: a #GtkCssProvider
@@ -1731,7 +2603,7 @@ _gtk_css_provider_load_named (GtkCssProvider *provider,
   if (path)
     {
       GtkCssProviderPrivate *priv = gtk_css_provider_get_instance_private (provider);
-      char *dir, *resource_file;
+      char *dir, *resource_file, *compiled;
       GResource *resource;
 
       dir = g_path_get_dirname (path);
@@ -1742,7 +2614,14 @@ _gtk_css_provider_load_named (GtkCssProvider *provider,
       if (resource != NULL)
         g_resources_register (resource);
 
-      gtk_css_provider_load_from_path (provider, path);
+      compiled = _gtk_css_find_compiled (path);
+      if (compiled)
+        {
+          gtk_css_provider_load_from_path (provider, compiled);
+          g_free (compiled);
+        }
+      else
+        gtk_css_provider_load_from_path (provider, path);
 
       /* Only set this after load, as load_from_path will clear it */
       priv->resource = resource;
@@ -1945,3 +2824,223 @@ gtk_css_provider_to_string (GtkCssProvider *provider)
   return g_string_free (str, FALSE);
 }
 
+
+typedef struct {
+  GByteArray *strings;
+  GHashTable *string_refs;
+  GArray *refs;
+  GtkCssRuleset *rulesets;
+} GtkCssCompiler;
+
+static guint32
+gtk_css_compiler_add_string (const char *string,
+                             gpointer    data)
+{
+  GtkCssCompiler *compiler = data;
+  gpointer ref;
+
+  if (g_hash_table_lookup_extended (compiler->string_refs, string, NULL, &ref))
+    return GPOINTER_TO_UINT (ref);
+
+  ref = GUINT_TO_POINTER (compiler->strings->len);
+  g_byte_array_append (compiler->strings, (const guint8 *) string, strlen (string) + 1);
+  g_hash_table_insert (compiler->string_refs, g_strdup (string), ref);
+
+  return GPOINTER_TO_UINT (ref);
+}
+
+static guint32
+gtk_css_compiler_get_ruleset_index (gpointer match,
+                                    gpointer data)
+{
+  GtkCssCompiler *compiler = data;
+
+  return (GtkCssRuleset *) match - compiler->rulesets;
+}
+
+static void
+gtk_css_compiler_add_ref (GtkCssCompiler *compiler,
+                          guint32         ref)
+{
+  g_array_append_val (compiler->refs, ref);
+}
+
+static void
+gtk_css_compiler_add_pair (GtkCssCompiler *compiler,
+                           const char     *name,
+                           GString        *value)
+{
+  gtk_css_compiler_add_ref (compiler, gtk_css_compiler_add_string (name, compiler));
+  gtk_css_compiler_add_ref (compiler, gtk_css_compiler_add_string (value->str, compiler));
+  g_string_set_size (value, 0);
+}
+
+/**
+ * gtk_css_provider_to_bytes:
+ * @provider: the provider to compile
+ *
+ * Converts the @provider into a compiled stylesheet.
+ *
+ * Loading the result with gtk_css_provider_load_from_file() or
+ * gtk_css_provider_load_from_path() creates a duplicate of @provider
+ * much faster than loading the CSS it was created from, as the file
+ * is mapped into memory and does not need to be parsed as a whole.
+ *
+ * Compiled stylesheets can only be loaded by the same version of GTK
+ * on the same architecture. They do not keep the location of
+ * declarations in the CSS, so they are not useful with the inspector.
+ *
+ * Themes can ship a compiled `gtk.css.compiled` next to their
+ * `gtk.css`, it will be used instead as long as none of the CSS files
+ * it was created from, including imported ones, changed since. The
+ * gtk4-compile-css tool creates such files.
+ *
+ * Returns: (transfer full): the compiled stylesheet
+ */
+GBytes *
+gtk_css_provider_to_bytes (GtkCssProvider *provider)
+{
+  GtkCssProviderPrivate *priv = gtk_css_provider_get_instance_private (provider);
+  GtkCssCompiledHeader header = { { 0, }, };
+  GtkCssCompiler compiler;
+  GHashTable *shared;
+  GByteArray *result;
+  GArray *declarations;
+  GList *keys, *walk;
+  GString *value;
+  guint8 *tree;
+  gsize tree_size;
+  guint i, j;
+
+  g_return_val_if_fail (GTK_IS_CSS_PROVIDER (provider), NULL);
+
+  compiler.strings = g_byte_array_new ();
+  compiler.string_refs = g_hash_table_new_full (g_str_hash, g_str_equal, g_free, NULL);
+  compiler.refs = g_array_new (FALSE, FALSE, sizeof (guint32));
+  compiler.rulesets = (GtkCssRuleset *) priv->rulesets->data;
+  value = g_string_new (NULL);
+
+  /* Sorted, so the output is identical for identical styles */
+  keys = g_list_sort (g_hash_table_get_keys (priv->symbolic_colors), (GCompareFunc) strcmp);
+  for (walk = keys; walk; walk = walk->next)
+    {
+      _gtk_css_value_print (g_hash_table_lookup (priv->symbolic_colors, walk->data), value);
+      gtk_css_compiler_add_pair (&compiler, walk->data, value);
+    }
+  header.n_colors = g_list_length (keys);
+  g_list_free (keys);
+
+  keys = g_list_sort (g_hash_table_get_keys (priv->keyframes), (GCompareFunc) strcmp);
+  for (walk = keys; walk; walk = walk->next)
+    {
+      _gtk_css_keyframes_print (g_hash_table_lookup (priv->keyframes, walk->data), value);
+      g_string_append (value, "}");
+      gtk_css_compiler_add_pair (&compiler, walk->data, value);
+    }
+  header.n_keyframes = g_list_length (keys);
+  g_list_free (keys);
+
+  for (i = 0; i < priv->bindings->len; i += 2)
+    {
+      g_string_append (value, g_ptr_array_index (priv->bindings, i + 1));
+      gtk_css_compiler_add_pair (&compiler, g_ptr_array_index (priv->bindings, i), value);
+    }
+  header.n_bindings = priv->bindings->len / 2;
+
+  /* Rulesets refer to ranges of declarations, which are shared between
+   * the copies made for selector lists */
+  declarations = g_array_new (FALSE, FALSE, sizeof (guint32));
+  shared = g_hash_table_new (NULL, NULL);
+  for (i = 0; i < priv->rulesets->len; i++)
+    {
+      GtkCssRuleset *ruleset = &g_array_index (priv->rulesets, GtkCssRuleset, i);
+      gpointer first;
+
+      if (ruleset->styles == NULL)
+        {
+          gtk_css_compiler_add_ref (&compiler, 0);
+          gtk_css_compiler_add_ref (&compiler, 0);
+          continue;
+        }
+
+      if (!g_hash_table_lookup_extended (shared, ruleset->styles, NULL, &first))
+        {
+          first = GUINT_TO_POINTER (declarations->len / 2);
+          g_hash_table_insert (shared, ruleset->styles, first);
+
+          for (j = 0; j < ruleset->n_styles; j++)
+            {
+              PropertyValue *prop = &ruleset->styles[j];
+              guint32 ref;
+
+              ref = gtk_css_compiler_add_string (_gtk_style_property_get_name (GTK_STYLE_PROPERTY (prop->property)), &compiler);
+              g_array_append_val (declarations, ref);
+              _gtk_css_value_print (prop->value, value);
+              ref = gtk_css_compiler_add_string (value->str, &compiler);
+              g_array_append_val (declarations, ref);
+              g_string_set_size (value, 0);
+            }
+        }
+
+      gtk_css_compiler_add_ref (&compiler, GPOINTER_TO_UINT (first));
+      gtk_css_compiler_add_ref (&compiler, ruleset->n_styles);
+    }
+  header.n_rulesets = priv->rulesets->len;
+  header.n_declarations = declarations->len / 2;
+  g_array_append_vals (compiler.refs, declarations->data, declarations->len);
+  g_array_unref (declarations);
+  g_hash_table_unref (shared);
+
+  for (i = 0; i < priv->sources->len; i++)
+    {
+      const char *path = g_ptr_array_index (priv->sources, i);
+      GStatBuf st;
+      guint64 size = 0, mtime = 0;
+
+      /* A file that is gone now makes the result stale right away */
+      if (g_stat (path, &st) == 0)
+        {
+          size = st.st_size;
+          mtime = st.st_mtime;
+        }
+
+      gtk_css_compiler_add_ref (&compiler, gtk_css_compiler_add_string (path, &compiler));
+      gtk_css_compiler_add_ref (&compiler, size & 0xffffffff);
+      gtk_css_compiler_add_ref (&compiler, size >> 32);
+      gtk_css_compiler_add_ref (&compiler, mtime & 0xffffffff);
+      gtk_css_compiler_add_ref (&compiler, mtime >> 32);
+    }
+  header.n_sources = priv->sources->len;
+
+  tree = _gtk_css_selector_tree_serialize (priv->tree,
+                                           &tree_size,
+                                           gtk_css_compiler_add_string,
+                                           gtk_css_compiler_get_ruleset_index,
+                                           &compiler);
+
+  /* Make sure the pool isn't empty */
+  gtk_css_compiler_add_string ("", &compiler);
+
+  memcpy (header.magic, GTK_CSS_COMPILED_MAGIC, sizeof (GTK_CSS_COMPILED_MAGIC));
+  header.format = GTK_CSS_COMPILED_FORMAT;
+  header.gtk_version = GTK_CSS_COMPILED_GTK_VERSION;
+  header.pointer_size = sizeof (gpointer);
+  header.tree_node_size = _gtk_css_selector_tree_get_node_size ();
+  header.tree_size = tree_size;
+  header.strings_size = compiler.strings->len;
+
+  result = g_byte_array_new ();
+  g_byte_array_append (result, (const guint8 *) &header, sizeof (header));
+  g_byte_array_append (result, (const guint8 *) compiler.refs->data, compiler.refs->len * sizeof (guint32));
+  if (tree)
+    g_byte_array_append (result, tree, tree_size);
+  g_byte_array_append (result, compiler.strings->data, compiler.strings->len);
+
+  g_free (tree);
+  g_string_free (value, TRUE);
+  g_array_unref (compiler.refs);
+  g_hash_table_unref (compiler.string_refs);
+  g_byte_array_unref (compiler.strings);
+
+  return g_byte_array_free_to_bytes (result);
+}
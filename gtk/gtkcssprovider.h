@@ -92,6 +92,8 @@ GtkCssProvider * gtk_css_provider_new (void);
 
 GDK_AVAILABLE_IN_ALL
 char *           gtk_css_provider_to_string      (GtkCssProvider  *provider);
+GDK_AVAILABLE_IN_ALL
+GBytes *         gtk_css_provider_to_bytes       (GtkCssProvider  *provider);
 
 GDK_AVAILABLE_IN_ALL
 void             gtk_css_provider_load_from_data (GtkCssProvider  *css_provider,
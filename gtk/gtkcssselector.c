@@ -1476,6 +1476,82 @@ gtk_css_selectors_skip_initial_selector (GtkCssSelector *selector, const GtkCssS
   return (GtkCssSelector *)gtk_css_selector_previous (selector);
 }
 
+typedef struct {
+  GPtrArray *matches;
+  const GtkCssBloomFilter *ancestors;
+  guint n_tested;
+} GtkCssTreeMatch;
+
+/* Whether the selector right before a descendant combinator can match
+ * any ancestor at all */
+static gboolean
+gtk_css_selector_tree_may_match_ancestor (const GtkCssSelectorTree *tree,
+                                          const GtkCssBloomFilter  *ancestors)
+{
+  const GtkCssSelector *selector = &tree->selector;
+
+  if (selector->class == &GTK_CSS_SELECTOR_NAME)
+    return gtk_css_bloom_filter_may_contain (ancestors, GTK_CSS_BLOOM_NAME, GPOINTER_TO_SIZE (selector->name.name));
+  else if (selector->class == &GTK_CSS_SELECTOR_CLASS)
+    return gtk_css_bloom_filter_may_contain (ancestors, GTK_CSS_BLOOM_CLASS, selector->style_class.style_class);
+  else if (selector->class == &GTK_CSS_SELECTOR_ID)
+    return gtk_css_bloom_filter_may_contain (ancestors, GTK_CSS_BLOOM_ID, GPOINTER_TO_SIZE (selector->id.name));
+
+  return TRUE;
+}
+
+static gboolean gtk_css_selector_tree_match_foreach (const GtkCssSelector *selector,
+                                                     const GtkCssMatcher  *matcher,
+                                                     gpointer              res);
+
+/* Does what gtk_css_selector_descendant_foreach_matcher() does, but
+ * skips the branches that the ancestor filter rules out, and doesn't
+ * walk up the tree at all if all of them are ruled out.
+ */
+static void
+gtk_css_selector_tree_match_descendant (const GtkCssSelectorTree *tree,
+                                        const GtkCssMatcher      *matcher,
+                                        GtkCssTreeMatch          *match)
+{
+  const GtkCssSelectorTree *prev;
+  GtkCssMatcher ancestor;
+  gboolean may_match = FALSE;
+
+  for (prev = gtk_css_selector_tree_get_previous (tree);
+       prev != NULL;
+       prev = gtk_css_selector_tree_get_sibling (prev))
+    {
+      if (gtk_css_selector_tree_may_match_ancestor (prev, match->ancestors))
+        {
+          may_match = TRUE;
+          break;
+        }
+    }
+
+  if (!may_match)
+    return;
+
+  while (_gtk_css_matcher_get_parent (&ancestor, matcher))
+    {
+      matcher = &ancestor;
+
+      gtk_css_selector_tree_found_match (tree, &match->matches);
+
+      for (prev = gtk_css_selector_tree_get_previous (tree);
+           prev != NULL;
+           prev = gtk_css_selector_tree_get_sibling (prev))
+        {
+          if (gtk_css_selector_tree_may_match_ancestor (prev, match->ancestors))
+            gtk_css_selector_foreach (&prev->selector, matcher, gtk_css_selector_tree_match_foreach, match);
+        }
+
+      /* any matchers are dangerous here, as we may loop forever, but
+	 we can terminate now as all possible matches have already been added */
+      if (_gtk_css_matcher_matches_any (matcher))
+	break;
+    }
+}
+
 static gboolean
 gtk_css_selector_tree_match_foreach (const GtkCssSelector *selector,
                                      const GtkCssMatcher  *matcher,
@@ -1483,31 +1559,47 @@ gtk_css_selector_tree_match_foreach (const GtkCssSelector *selector,
 {
   const GtkCssSelectorTree *tree = (const GtkCssSelectorTree *) selector;
   const GtkCssSelectorTree *prev;
+  GtkCssTreeMatch *match = res;
+
+  match->n_tested++;
 
   if (!gtk_css_selector_match (selector, matcher))
     return FALSE;
 
-  gtk_css_selector_tree_found_match (tree, res);
+  gtk_css_selector_tree_found_match (tree, &match->matches);
 
   for (prev = gtk_css_selector_tree_get_previous (tree);
        prev != NULL;
        prev = gtk_css_selector_tree_get_sibling (prev))
-    gtk_css_selector_foreach (&prev->selector, matcher, gtk_css_selector_tree_match_foreach, res);
+    {
+      if (match->ancestors && prev->selector.class == &GTK_CSS_SELECTOR_DESCENDANT)
+        gtk_css_selector_tree_match_descendant (prev, matcher, match);
+      else
+        gtk_css_selector_foreach (&prev->selector, matcher, gtk_css_selector_tree_match_foreach, res);
+    }
 
   return FALSE;
 }
 
 GPtrArray *
 _gtk_css_selector_tree_match_all (const GtkCssSelectorTree *tree,
-				  const GtkCssMatcher *matcher)
+				  const GtkCssMatcher *matcher,
+                                  guint               *n_tested)
 {
-  GPtrArray *array = NULL;
+  GtkCssTreeMatch match;
+
+  match.matches = NULL;
+  match.ancestors = _gtk_css_matcher_get_ancestor_filter (matcher);
+  match.n_tested = 0;
 
   for (; tree != NULL;
        tree = gtk_css_selector_tree_get_sibling (tree))
-    gtk_css_selector_foreach (&tree->selector, matcher, gtk_css_selector_tree_match_foreach, &array);
+    gtk_css_selector_foreach (&tree->selector, matcher, gtk_css_selector_tree_match_foreach, &match);
+
+  if (n_tested)
+    *n_tested += match.n_tested;
 
-  return array;
+  return match.matches;
 }
 
 /* When checking for changes via the tree we need to know if a rule further
@@ -1578,6 +1670,23 @@ _gtk_css_selector_tree_get_change_all (const GtkCssSelectorTree *tree,
   return change & ~GTK_CSS_CHANGE_RESERVED_BIT;
 }
 
+/* Like _gtk_css_selector_tree_get_change_all(), but only tells if there
+ * is any match at all, which a match on * alone doesn't show in the
+ * change. */
+gboolean
+_gtk_css_selector_tree_may_match (const GtkCssSelectorTree *tree,
+                                  const GtkCssMatcher      *matcher)
+{
+  for (; tree != NULL;
+       tree = gtk_css_selector_tree_get_sibling (tree))
+    {
+      if (gtk_css_selector_tree_get_change (tree, matcher))
+        return TRUE;
+    }
+
+  return FALSE;
+}
+
 #ifdef PRINT_TREE
 static void
 _gtk_css_selector_tree_print (const GtkCssSelectorTree *tree, GString *str, char *prefix)
@@ -1903,3 +2012,369 @@ _gtk_css_selector_tree_builder_build (GtkCssSelectorTreeBuilder *builder)
 
   return tree;
 }
+
+/* SERIALIZATION */
+
+/* The classes in the order they are numbered in serialized trees.
+ * Only ever append to this list.
+ */
+static const GtkCssSelectorClass *serialized_classes[] = {
+  &GTK_CSS_SELECTOR_DESCENDANT,
+  &GTK_CSS_SELECTOR_CHILD,
+  &GTK_CSS_SELECTOR_SIBLING,
+  &GTK_CSS_SELECTOR_ADJACENT,
+  &GTK_CSS_SELECTOR_ANY,
+  &GTK_CSS_SELECTOR_NOT_ANY,
+  &GTK_CSS_SELECTOR_NAME,
+  &GTK_CSS_SELECTOR_NOT_NAME,
+  &GTK_CSS_SELECTOR_CLASS,
+  &GTK_CSS_SELECTOR_NOT_CLASS,
+  &GTK_CSS_SELECTOR_ID,
+  &GTK_CSS_SELECTOR_NOT_ID,
+  &GTK_CSS_SELECTOR_PSEUDOCLASS_STATE,
+  &GTK_CSS_SELECTOR_NOT_PSEUDOCLASS_STATE,
+  &GTK_CSS_SELECTOR_PSEUDOCLASS_POSITION,
+  &GTK_CSS_SELECTOR_NOT_PSEUDOCLASS_POSITION
+};
+
+/* Nothing sane nests selectors this deep */
+#define MAX_SERIALIZED_DEPTH 1024
+
+static guint
+gtk_css_selector_class_get_serialized_index (const GtkCssSelectorClass *class)
+{
+  guint i;
+
+  for (i = 0; i < G_N_ELEMENTS (serialized_classes); i++)
+    {
+      if (serialized_classes[i] == class)
+        return i;
+    }
+
+  g_assert_not_reached ();
+  return 0;
+}
+
+static gsize
+gtk_css_selector_tree_get_size (const GtkCssSelectorTree *tree,
+                                const guint8             *data)
+{
+  gsize size = 0;
+
+  for (; tree != NULL; tree = gtk_css_selector_tree_get_sibling (tree))
+    {
+      gpointer *matches;
+      gsize end;
+
+      end = (const guint8 *) tree - data + sizeof (GtkCssSelectorTree);
+      size = MAX (size, end);
+
+      matches = gtk_css_selector_tree_get_matches (tree);
+      if (matches)
+        {
+          while (*matches)
+            matches++;
+          end = (guint8 *) (matches + 1) - data;
+          size = MAX (size, end);
+        }
+
+      end = gtk_css_selector_tree_get_size (gtk_css_selector_tree_get_previous (tree), data);
+      size = MAX (size, end);
+    }
+
+  return size;
+}
+
+static void
+gtk_css_selector_tree_serialize_node (const GtkCssSelectorTree      *tree,
+                                      guint8                        *out,
+                                      const guint8                  *data,
+                                      GtkCssSelectorTreeStringFunc   string_func,
+                                      GtkCssSelectorTreeMatchFunc    match_func,
+                                      gpointer                       user_data)
+{
+  for (; tree != NULL; tree = gtk_css_selector_tree_get_sibling (tree))
+    {
+      GtkCssSelectorTree *copy;
+      const GtkCssSelectorClass *class;
+      gpointer *matches, *copy_matches;
+      guint i;
+
+      copy = (GtkCssSelectorTree *) (out + ((const guint8 *) tree - data));
+      class = tree->selector.class;
+
+      if (class == &GTK_CSS_SELECTOR_NAME || class == &GTK_CSS_SELECTOR_NOT_NAME)
+        copy->selector.name.name = GUINT_TO_POINTER (string_func (tree->selector.name.name, user_data));
+      else if (class == &GTK_CSS_SELECTOR_ID || class == &GTK_CSS_SELECTOR_NOT_ID)
+        copy->selector.id.name = GUINT_TO_POINTER (string_func (tree->selector.id.name, user_data));
+      else if (class == &GTK_CSS_SELECTOR_CLASS || class == &GTK_CSS_SELECTOR_NOT_CLASS)
+        copy->selector.style_class.style_class = string_func (g_quark_to_string (tree->selector.style_class.style_class), user_data);
+
+      copy->selector.class = GUINT_TO_POINTER (gtk_css_selector_class_get_serialized_index (class));
+
+      matches = gtk_css_selector_tree_get_matches (tree);
+      if (matches)
+        {
+          copy_matches = (gpointer *) (out + ((guint8 *) matches - data));
+          for (i = 0; matches[i] != NULL; i++)
+            copy_matches[i] = GUINT_TO_POINTER (match_func (matches[i], user_data) + 1);
+        }
+
+      gtk_css_selector_tree_serialize_node (gtk_css_selector_tree_get_previous (tree),
+                                            out, data,
+                                            string_func, match_func, user_data);
+    }
+}
+
+gsize
+_gtk_css_selector_tree_get_node_size (void)
+{
+  return sizeof (GtkCssSelectorTree);
+}
+
+/**
+ * _gtk_css_selector_tree_serialize:
+ * @tree: (nullable): the tree to serialize
+ * @size: (out): return location for the size of the result
+ * @string_func: returns a reference for the strings in @tree
+ * @match_func: returns the index of the matches of @tree
+ * @user_data: data to pass to @string_func and @match_func
+ *
+ * Copies @tree into a block of memory that does not contain pointers,
+ * so it can be stored in a file and read with
+ * _gtk_css_selector_tree_deserialize() by the same version of GTK.
+ *
+ * Returns: the serialized tree or %NULL if @tree is empty
+ */
+guint8 *
+_gtk_css_selector_tree_serialize (const GtkCssSelectorTree     *tree,
+                                  gsize                        *size,
+                                  GtkCssSelectorTreeStringFunc  string_func,
+                                  GtkCssSelectorTreeMatchFunc   match_func,
+                                  gpointer                      user_data)
+{
+  guint8 *out;
+
+  if (tree == NULL)
+    {
+      *size = 0;
+      return NULL;
+    }
+
+  *size = gtk_css_selector_tree_get_size (tree, (const guint8 *) tree);
+  out = g_memdup (tree, *size);
+
+  gtk_css_selector_tree_serialize_node (tree, out, (const guint8 *) tree,
+                                        string_func, match_func, user_data);
+
+  return out;
+}
+
+typedef struct {
+  guint8 *data;
+  gsize size;
+  const char *strings;
+  gsize strings_size;
+  gpointer *matches;
+  GtkCssSelectorTree **selector_matches;
+  guint n_matches;
+} GtkCssSelectorTreeLoader;
+
+static gboolean
+gtk_css_selector_tree_load_string (GtkCssSelectorTreeLoader  *loader,
+                                   gpointer                   ref,
+                                   const char               **string)
+{
+  gsize offset = GPOINTER_TO_SIZE (ref);
+
+  if (offset >= loader->strings_size)
+    return FALSE;
+
+  *string = loader->strings + offset;
+  return TRUE;
+}
+
+static gboolean
+gtk_css_selector_tree_load_offset (GtkCssSelectorTreeLoader *loader,
+                                   gsize                     pos,
+                                   gint32                    offset,
+                                   gsize                     length,
+                                   gsize                    *result)
+{
+  if (offset <= 0 || offset == GTK_CSS_SELECTOR_TREE_EMPTY_OFFSET)
+    return FALSE;
+
+  if (pos + offset > loader->size ||
+      loader->size - (pos + offset) < length ||
+      (pos + offset) % sizeof (gpointer) != 0)
+    return FALSE;
+
+  *result = pos + offset;
+  return TRUE;
+}
+
+/* Offsets to previous nodes, siblings and matches always point forward,
+ * so checking that makes sure corrupted data can't make us loop. */
+static gboolean
+gtk_css_selector_tree_load_node (GtkCssSelectorTreeLoader *loader,
+                                 gsize                     pos,
+                                 gssize                    parent_pos,
+                                 guint                     depth)
+{
+  while (TRUE)
+    {
+      GtkCssSelectorTree *tree;
+      const GtkCssSelectorClass *class;
+      const char *string;
+      gsize index, next;
+
+      if (depth > MAX_SERIALIZED_DEPTH)
+        return FALSE;
+
+      tree = (GtkCssSelectorTree *) (loader->data + pos);
+
+      if (parent_pos < 0)
+        {
+          if (tree->parent_offset != GTK_CSS_SELECTOR_TREE_EMPTY_OFFSET)
+            return FALSE;
+        }
+      else if (tree->parent_offset == GTK_CSS_SELECTOR_TREE_EMPTY_OFFSET ||
+               (gssize) pos + tree->parent_offset != parent_pos)
+        return FALSE;
+
+      index = GPOINTER_TO_SIZE (tree->selector.class);
+      if (index >= G_N_ELEMENTS (serialized_classes))
+        return FALSE;
+      class = serialized_classes[index];
+      tree->selector.class = class;
+
+      if (class == &GTK_CSS_SELECTOR_NAME || class == &GTK_CSS_SELECTOR_NOT_NAME)
+        {
+          if (!gtk_css_selector_tree_load_string (loader, (gpointer) tree->selector.name.name, &string))
+            return FALSE;
+          tree->selector.name.name = g_intern_string (string);
+        }
+      else if (class == &GTK_CSS_SELECTOR_ID || class == &GTK_CSS_SELECTOR_NOT_ID)
+        {
+          if (!gtk_css_selector_tree_load_string (loader, (gpointer) tree->selector.id.name, &string))
+            return FALSE;
+          tree->selector.id.name = g_intern_string (string);
+        }
+      else if (class == &GTK_CSS_SELECTOR_CLASS || class == &GTK_CSS_SELECTOR_NOT_CLASS)
+        {
+          if (!gtk_css_selector_tree_load_string (loader, GUINT_TO_POINTER (tree->selector.style_class.style_class), &string))
+            return FALSE;
+          tree->selector.style_class.style_class = g_quark_from_string (string);
+        }
+
+      if (tree->matches_offset != GTK_CSS_SELECTOR_TREE_EMPTY_OFFSET)
+        {
+          gpointer *matches;
+          gsize i;
+
+          if (!gtk_css_selector_tree_load_offset (loader, pos, tree->matches_offset, sizeof (gpointer), &next))
+            return FALSE;
+
+          matches = (gpointer *) (loader->data + next);
+          for (i = 0; ; i++)
+            {
+              if (i >= (loader->size - next) / sizeof (gpointer))
+                return FALSE;
+              if (matches[i] == NULL)
+                break;
+
+              index = GPOINTER_TO_SIZE (matches[i]) - 1;
+              if (index >= loader->n_matches ||
+                  loader->selector_matches[index] != NULL)
+                return FALSE;
+
+              matches[i] = loader->matches[index];
+              loader->selector_matches[index] = tree;
+            }
+        }
+
+      if (tree->previous_offset != GTK_CSS_SELECTOR_TREE_EMPTY_OFFSET)
+        {
+          if (!gtk_css_selector_tree_load_offset (loader, pos, tree->previous_offset, sizeof (GtkCssSelectorTree), &next) ||
+              !gtk_css_selector_tree_load_node (loader, next, pos, depth + 1))
+            return FALSE;
+        }
+
+      if (tree->sibling_offset == GTK_CSS_SELECTOR_TREE_EMPTY_OFFSET)
+        return TRUE;
+
+      if (!gtk_css_selector_tree_load_offset (loader, pos, tree->sibling_offset, sizeof (GtkCssSelectorTree), &next))
+        return FALSE;
+
+      pos = next;
+    }
+}
+
+/**
+ * _gtk_css_selector_tree_deserialize:
+ * @data: data returned from _gtk_css_selector_tree_serialize()
+ * @size: size of @data
+ * @strings: the strings referenced in @data, the last one must be
+ *     nul-terminated
+ * @strings_size: size of @strings
+ * @matches: the matches, in the order given by the match_func
+ * @selector_matches: (out caller-allocates): the tree nodes matching
+ *     each of @matches
+ * @n_matches: the number of @matches
+ * @tree: (out): return location for the tree
+ *
+ * Loads a tree saved with _gtk_css_selector_tree_serialize(),
+ * checking that @data is valid.
+ *
+ * Returns: %FALSE if @data is corrupt
+ */
+gboolean
+_gtk_css_selector_tree_deserialize (const guint8         *data,
+                                    gsize                 size,
+                                    const char           *strings,
+                                    gsize                 strings_size,
+                                    gpointer             *matches,
+                                    GtkCssSelectorTree  **selector_matches,
+                                    guint                 n_matches,
+                                    GtkCssSelectorTree  **tree)
+{
+  GtkCssSelectorTreeLoader loader;
+  guint i;
+
+  memset (selector_matches, 0, n_matches * sizeof (GtkCssSelectorTree *));
+
+  if (size == 0)
+    {
+      *tree = NULL;
+      return n_matches == 0;
+    }
+
+  if (size < sizeof (GtkCssSelectorTree) ||
+      strings_size == 0 ||
+      strings[strings_size - 1] != '\0')
+    return FALSE;
+
+  loader.data = g_memdup (data, size);
+  loader.size = size;
+  loader.strings = strings;
+  loader.strings_size = strings_size;
+  loader.matches = matches;
+  loader.selector_matches = selector_matches;
+  loader.n_matches = n_matches;
+
+  if (!gtk_css_selector_tree_load_node (&loader, 0, -1, 0))
+    goto fail;
+
+  for (i = 0; i < n_matches; i++)
+    {
+      if (selector_matches[i] == NULL)
+        goto fail;
+    }
+
+  *tree = (GtkCssSelectorTree *) loader.data;
+  return TRUE;
+
+fail:
+  g_free (loader.data);
+  return FALSE;
+}
@@ -42,13 +42,36 @@ int               _gtk_css_selector_compare         (const GtkCssSelector   *a,
 
 void         _gtk_css_selector_tree_free             (GtkCssSelectorTree       *tree);
 GPtrArray *  _gtk_css_selector_tree_match_all        (const GtkCssSelectorTree *tree,
-						      const GtkCssMatcher      *matcher);
+						      const GtkCssMatcher      *matcher,
+                                                      guint                    *n_tested);
 GtkCssChange _gtk_css_selector_tree_get_change_all   (const GtkCssSelectorTree *tree,
 						      const GtkCssMatcher *matcher);
+gboolean     _gtk_css_selector_tree_may_match        (const GtkCssSelectorTree *tree,
+						      const GtkCssMatcher      *matcher);
 void         _gtk_css_selector_tree_match_print      (const GtkCssSelectorTree *tree,
 						      GString                  *str);
 
 
+typedef guint32 (* GtkCssSelectorTreeStringFunc) (const char *string,
+                                                  gpointer    user_data);
+typedef guint32 (* GtkCssSelectorTreeMatchFunc)  (gpointer    match,
+                                                  gpointer    user_data);
+
+gsize        _gtk_css_selector_tree_get_node_size    (void);
+guint8 *     _gtk_css_selector_tree_serialize        (const GtkCssSelectorTree     *tree,
+                                                      gsize                        *size,
+                                                      GtkCssSelectorTreeStringFunc  string_func,
+                                                      GtkCssSelectorTreeMatchFunc   match_func,
+                                                      gpointer                      user_data);
+gboolean     _gtk_css_selector_tree_deserialize      (const guint8                 *data,
+                                                      gsize                         size,
+                                                      const char                   *strings,
+                                                      gsize                         strings_size,
+                                                      gpointer                     *matches,
+                                                      GtkCssSelectorTree          **selector_matches,
+                                                      guint                         n_matches,
+                                                      GtkCssSelectorTree          **tree);
+
 GtkCssSelectorTreeBuilder *_gtk_css_selector_tree_builder_new   (void);
 void                       _gtk_css_selector_tree_builder_add   (GtkCssSelectorTreeBuilder *builder,
 								 GtkCssSelector            *selectors,
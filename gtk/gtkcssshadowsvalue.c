@@ -88,11 +88,23 @@ gtk_css_value_shadows_compute (GtkCssValue      *value,
     }
 
   if (result != NULL)
-    return result;
+    return gtk_css_value_intern (result);
   else
     return _gtk_css_value_ref (value);
 }
 
+static guint
+gtk_css_value_shadows_hash (const GtkCssValue *value)
+{
+  guint i, hash;
+
+  hash = value->len;
+  for (i = 0; i < value->len; i++)
+    hash = hash * 31 + gtk_css_value_hash (value->values[i]);
+
+  return hash;
+}
+
 static gboolean
 gtk_css_value_shadows_equal (const GtkCssValue *value1,
                              const GtkCssValue *value2)
@@ -206,7 +218,8 @@ static const GtkCssValueClass GTK_CSS_VALUE_SHADOWS = {
   gtk_css_value_shadows_transition,
   NULL,
   NULL,
-  gtk_css_value_shadows_print
+  gtk_css_value_shadows_print,
+  gtk_css_value_shadows_hash
 };
 
 static GtkCssValue none_singleton = { &GTK_CSS_VALUE_SHADOWS, 1, 0, { NULL } };
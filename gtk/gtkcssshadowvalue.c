@@ -94,7 +94,7 @@ gtk_css_value_shadow_compute (GtkCssValue      *shadow,
       return _gtk_css_value_ref (shadow);
     }
 
-  return gtk_css_shadow_value_new (hoffset, voffset, radius, spread, shadow->inset, color);
+  return gtk_css_value_intern (gtk_css_shadow_value_new (hoffset, voffset, radius, spread, shadow->inset, color));
 }
 
 static gboolean
@@ -109,6 +109,20 @@ gtk_css_value_shadow_equal (const GtkCssValue *shadow1,
       && _gtk_css_value_equal (shadow1->color, shadow2->color);
 }
 
+static guint
+gtk_css_value_shadow_hash (const GtkCssValue *shadow)
+{
+  guint hash;
+
+  hash = gtk_css_value_hash (shadow->hoffset);
+  hash = hash * 31 + gtk_css_value_hash (shadow->voffset);
+  hash = hash * 31 + gtk_css_value_hash (shadow->radius);
+  hash = hash * 31 + gtk_css_value_hash (shadow->spread);
+  hash = hash * 31 + gtk_css_value_hash (shadow->color);
+
+  return hash ^ shadow->inset;
+}
+
 static GtkCssValue *
 gtk_css_value_shadow_transition (GtkCssValue *start,
                                  GtkCssValue *end,
@@ -161,7 +175,8 @@ static const GtkCssValueClass GTK_CSS_VALUE_SHADOW = {
   gtk_css_value_shadow_transition,
   NULL,
   NULL,
-  gtk_css_value_shadow_print
+  gtk_css_value_shadow_print,
+  gtk_css_value_shadow_hash
 };
 
 static GtkCssValue *
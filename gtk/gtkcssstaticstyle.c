@@ -39,6 +39,223 @@
 #include "gtkstylepropertyprivate.h"
 #include "gtkstyleproviderprivate.h"
 
+struct _GtkCssValues
+{
+  int ref_count;
+  GtkCssValue *values[1];
+};
+
+typedef struct
+{
+  const guint *properties;
+  guint n_properties;
+  guint inherited : 1; /* all properties are inherited */
+} GtkCssValueGroupInfo;
+
+static const guint core_props[] = {
+  GTK_CSS_PROPERTY_COLOR,
+  GTK_CSS_PROPERTY_DPI,
+  GTK_CSS_PROPERTY_FONT_SIZE,
+  GTK_CSS_PROPERTY_ICON_THEME,
+  GTK_CSS_PROPERTY_ICON_PALETTE
+};
+
+static const guint font_props[] = {
+  GTK_CSS_PROPERTY_FONT_FAMILY,
+  GTK_CSS_PROPERTY_FONT_STYLE,
+  GTK_CSS_PROPERTY_FONT_WEIGHT,
+  GTK_CSS_PROPERTY_FONT_STRETCH,
+  GTK_CSS_PROPERTY_LETTER_SPACING,
+  GTK_CSS_PROPERTY_TEXT_SHADOW,
+  GTK_CSS_PROPERTY_CARET_COLOR,
+  GTK_CSS_PROPERTY_SECONDARY_CARET_COLOR,
+  GTK_CSS_PROPERTY_FONT_FEATURE_SETTINGS,
+  GTK_CSS_PROPERTY_FONT_VARIATION_SETTINGS
+};
+
+static const guint icon_props[] = {
+  GTK_CSS_PROPERTY_ICON_SIZE,
+  GTK_CSS_PROPERTY_ICON_SHADOW,
+  GTK_CSS_PROPERTY_ICON_STYLE
+};
+
+static const guint text_decoration_props[] = {
+  GTK_CSS_PROPERTY_TEXT_DECORATION_LINE,
+  GTK_CSS_PROPERTY_TEXT_DECORATION_COLOR,
+  GTK_CSS_PROPERTY_TEXT_DECORATION_STYLE,
+  GTK_CSS_PROPERTY_FONT_KERNING,
+  GTK_CSS_PROPERTY_FONT_VARIANT_LIGATURES,
+  GTK_CSS_PROPERTY_FONT_VARIANT_POSITION,
+  GTK_CSS_PROPERTY_FONT_VARIANT_CAPS,
+  GTK_CSS_PROPERTY_FONT_VARIANT_NUMERIC,
+  GTK_CSS_PROPERTY_FONT_VARIANT_ALTERNATES,
+  GTK_CSS_PROPERTY_FONT_VARIANT_EAST_ASIAN
+};
+
+static const guint background_props[] = {
+  GTK_CSS_PROPERTY_BACKGROUND_COLOR,
+  GTK_CSS_PROPERTY_BOX_SHADOW,
+  GTK_CSS_PROPERTY_BACKGROUND_CLIP,
+  GTK_CSS_PROPERTY_BACKGROUND_ORIGIN,
+  GTK_CSS_PROPERTY_BACKGROUND_SIZE,
+  GTK_CSS_PROPERTY_BACKGROUND_POSITION,
+  GTK_CSS_PROPERTY_BACKGROUND_REPEAT,
+  GTK_CSS_PROPERTY_BACKGROUND_IMAGE,
+  GTK_CSS_PROPERTY_BACKGROUND_BLEND_MODE
+};
+
+static const guint size_props[] = {
+  GTK_CSS_PROPERTY_MARGIN_TOP,
+  GTK_CSS_PROPERTY_MARGIN_LEFT,
+  GTK_CSS_PROPERTY_MARGIN_BOTTOM,
+  GTK_CSS_PROPERTY_MARGIN_RIGHT,
+  GTK_CSS_PROPERTY_PADDING_TOP,
+  GTK_CSS_PROPERTY_PADDING_LEFT,
+  GTK_CSS_PROPERTY_PADDING_BOTTOM,
+  GTK_CSS_PROPERTY_PADDING_RIGHT,
+  GTK_CSS_PROPERTY_BORDER_SPACING,
+  GTK_CSS_PROPERTY_MIN_WIDTH,
+  GTK_CSS_PROPERTY_MIN_HEIGHT
+};
+
+static const guint border_props[] = {
+  GTK_CSS_PROPERTY_BORDER_TOP_STYLE,
+  GTK_CSS_PROPERTY_BORDER_TOP_WIDTH,
+  GTK_CSS_PROPERTY_BORDER_LEFT_STYLE,
+  GTK_CSS_PROPERTY_BORDER_LEFT_WIDTH,
+  GTK_CSS_PROPERTY_BORDER_BOTTOM_STYLE,
+  GTK_CSS_PROPERTY_BORDER_BOTTOM_WIDTH,
+  GTK_CSS_PROPERTY_BORDER_RIGHT_STYLE,
+  GTK_CSS_PROPERTY_BORDER_RIGHT_WIDTH,
+  GTK_CSS_PROPERTY_BORDER_TOP_LEFT_RADIUS,
+  GTK_CSS_PROPERTY_BORDER_TOP_RIGHT_RADIUS,
+  GTK_CSS_PROPERTY_BORDER_BOTTOM_RIGHT_RADIUS,
+  GTK_CSS_PROPERTY_BORDER_BOTTOM_LEFT_RADIUS,
+  GTK_CSS_PROPERTY_BORDER_TOP_COLOR,
+  GTK_CSS_PROPERTY_BORDER_RIGHT_COLOR,
+  GTK_CSS_PROPERTY_BORDER_BOTTOM_COLOR,
+  GTK_CSS_PROPERTY_BORDER_LEFT_COLOR,
+  GTK_CSS_PROPERTY_BORDER_IMAGE_SOURCE,
+  GTK_CSS_PROPERTY_BORDER_IMAGE_REPEAT,
+  GTK_CSS_PROPERTY_BORDER_IMAGE_SLICE,
+  GTK_CSS_PROPERTY_BORDER_IMAGE_WIDTH
+};
+
+static const guint outline_props[] = {
+  GTK_CSS_PROPERTY_OUTLINE_STYLE,
+  GTK_CSS_PROPERTY_OUTLINE_WIDTH,
+  GTK_CSS_PROPERTY_OUTLINE_OFFSET,
+  GTK_CSS_PROPERTY_OUTLINE_TOP_LEFT_RADIUS,
+  GTK_CSS_PROPERTY_OUTLINE_TOP_RIGHT_RADIUS,
+  GTK_CSS_PROPERTY_OUTLINE_BOTTOM_RIGHT_RADIUS,
+  GTK_CSS_PROPERTY_OUTLINE_BOTTOM_LEFT_RADIUS,
+  GTK_CSS_PROPERTY_OUTLINE_COLOR
+};
+
+static const guint animation_props[] = {
+  GTK_CSS_PROPERTY_TRANSITION_PROPERTY,
+  GTK_CSS_PROPERTY_TRANSITION_DURATION,
+  GTK_CSS_PROPERTY_TRANSITION_TIMING_FUNCTION,
+  GTK_CSS_PROPERTY_TRANSITION_DELAY,
+  GTK_CSS_PROPERTY_ANIMATION_NAME,
+  GTK_CSS_PROPERTY_ANIMATION_DURATION,
+  GTK_CSS_PROPERTY_ANIMATION_TIMING_FUNCTION,
+  GTK_CSS_PROPERTY_ANIMATION_ITERATION_COUNT,
+  GTK_CSS_PROPERTY_ANIMATION_DIRECTION,
+  GTK_CSS_PROPERTY_ANIMATION_PLAY_STATE,
+  GTK_CSS_PROPERTY_ANIMATION_DELAY,
+  GTK_CSS_PROPERTY_ANIMATION_FILL_MODE
+};
+
+static const guint other_props[] = {
+  GTK_CSS_PROPERTY_ICON_SOURCE,
+  GTK_CSS_PROPERTY_ICON_TRANSFORM,
+  GTK_CSS_PROPERTY_ICON_FILTER,
+  GTK_CSS_PROPERTY_OPACITY,
+  GTK_CSS_PROPERTY_FILTER,
+  GTK_CSS_PROPERTY_GTK_KEY_BINDINGS
+};
+
+#define GROUP(props, inherited) { props, G_N_ELEMENTS (props), inherited }
+
+static const GtkCssValueGroupInfo value_groups[GTK_CSS_N_VALUE_GROUPS] = {
+  [GTK_CSS_CORE_VALUES]            = GROUP (core_props, TRUE),
+  [GTK_CSS_FONT_VALUES]            = GROUP (font_props, TRUE),
+  [GTK_CSS_ICON_VALUES]            = GROUP (icon_props, TRUE),
+  [GTK_CSS_TEXT_DECORATION_VALUES] = GROUP (text_decoration_props, FALSE),
+  [GTK_CSS_BACKGROUND_VALUES]      = GROUP (background_props, FALSE),
+  [GTK_CSS_SIZE_VALUES]            = GROUP (size_props, FALSE),
+  [GTK_CSS_BORDER_VALUES]          = GROUP (border_props, FALSE),
+  [GTK_CSS_OUTLINE_VALUES]         = GROUP (outline_props, FALSE),
+  [GTK_CSS_ANIMATION_VALUES]       = GROUP (animation_props, FALSE),
+  [GTK_CSS_OTHER_VALUES]           = GROUP (other_props, FALSE),
+};
+
+#undef GROUP
+
+/* Where to find each property, filled in class_init */
+static guint8 property_group[GTK_CSS_PROPERTY_N_PROPERTIES];
+static guint8 property_index[GTK_CSS_PROPERTY_N_PROPERTIES];
+
+static GtkCssValues *
+gtk_css_values_new (GtkCssValueGroup group)
+{
+  GtkCssValues *values;
+
+  values = g_malloc0 (sizeof (GtkCssValues) +
+                      (value_groups[group].n_properties - 1) * sizeof (GtkCssValue *));
+  values->ref_count = 1;
+
+  return values;
+}
+
+static GtkCssValues *
+gtk_css_values_ref (GtkCssValues *values)
+{
+  values->ref_count++;
+
+  return values;
+}
+
+static void
+gtk_css_values_unref (GtkCssValues     *values,
+                      GtkCssValueGroup  group)
+{
+  guint i;
+
+  values->ref_count--;
+  if (values->ref_count > 0)
+    return;
+
+  for (i = 0; i < value_groups[group].n_properties; i++)
+    {
+      if (values->values[i])
+        _gtk_css_value_unref (values->values[i]);
+    }
+
+  g_free (values);
+}
+
+static gboolean
+gtk_css_values_equal (const GtkCssValues *values1,
+                      const GtkCssValues *values2,
+                      GtkCssValueGroup    group)
+{
+  guint i;
+
+  if (values1 == values2)
+    return TRUE;
+
+  for (i = 0; i < value_groups[group].n_properties; i++)
+    {
+      if (values1->values[i] == NULL || values2->values[i] == NULL ||
+          !_gtk_css_value_equal (values1->values[i], values2->values[i]))
+        return FALSE;
+    }
+
+  return TRUE;
+}
+
 G_DEFINE_TYPE (GtkCssStaticStyle, gtk_css_static_style, GTK_TYPE_CSS_STYLE)
 
 static GtkCssValue *
@@ -47,8 +264,12 @@ gtk_css_static_style_get_value (GtkCssStyle *style,
 {
   /* This is called a lot, so we avoid a dynamic type check here */
   GtkCssStaticStyle *sstyle = (GtkCssStaticStyle *) style;
+  GtkCssValues *values = sstyle->groups[property_group[id]];
+
+  if (values == NULL)
+    return NULL;
 
-  return sstyle->values[id];
+  return values->values[property_index[id]];
 }
 
 static GtkCssSection *
@@ -70,10 +291,13 @@ gtk_css_static_style_dispose (GObject *object)
   GtkCssStaticStyle *style = GTK_CSS_STATIC_STYLE (object);
   guint i;
 
-  for (i = 0; i < GTK_CSS_PROPERTY_N_PROPERTIES; i++)
+  for (i = 0; i < GTK_CSS_N_VALUE_GROUPS; i++)
     {
-      if (style->values[i])
-        _gtk_css_value_unref (style->values[i]);
+      if (style->groups[i])
+        {
+          gtk_css_values_unref (style->groups[i], i);
+          style->groups[i] = NULL;
+        }
     }
   if (style->sections)
     {
@@ -89,6 +313,20 @@ gtk_css_static_style_class_init (GtkCssStaticStyleClass *klass)
 {
   GObjectClass *object_class = G_OBJECT_CLASS (klass);
   GtkCssStyleClass *style_class = GTK_CSS_STYLE_CLASS (klass);
+  guint i, j, n = 0;
+
+  for (i = 0; i < GTK_CSS_N_VALUE_GROUPS; i++)
+    {
+      for (j = 0; j < value_groups[i].n_properties; j++)
+        {
+          property_group[value_groups[i].properties[j]] = i;
+          property_index[value_groups[i].properties[j]] = j;
+          n++;
+        }
+    }
+
+  /* Every property needs to be in exactly one group */
+  g_assert (n == GTK_CSS_PROPERTY_N_PROPERTIES);
 
   object_class->dispose = gtk_css_static_style_dispose;
 
@@ -114,9 +352,33 @@ gtk_css_static_style_set_value (GtkCssStaticStyle *style,
                                 GtkCssValue       *value,
                                 GtkCssSection     *section)
 {
-  if (style->values[id])
-    _gtk_css_value_unref (style->values[id]);
-  style->values[id] = _gtk_css_value_ref (value);
+  GtkCssValueGroup group = property_group[id];
+  GtkCssValues *values = style->groups[group];
+  guint index = property_index[id];
+
+  if (values == NULL)
+    {
+      values = style->groups[group] = gtk_css_values_new (group);
+    }
+  else if (values->ref_count > 1)
+    {
+      /* Copy on write */
+      GtkCssValues *copy = gtk_css_values_new (group);
+      guint i;
+
+      for (i = 0; i < value_groups[group].n_properties; i++)
+        {
+          if (values->values[i])
+            copy->values[i] = _gtk_css_value_ref (values->values[i]);
+        }
+
+      gtk_css_values_unref (values, group);
+      values = style->groups[group] = copy;
+    }
+
+  if (values->values[index])
+    _gtk_css_value_unref (values->values[index]);
+  values->values[index] = _gtk_css_value_ref (value);
 
   if (style->sections && style->sections->len > id && g_ptr_array_index (style->sections, id))
     {
@@ -166,12 +428,102 @@ gtk_css_static_style_get_default (void)
   return default_style;
 }
 
+static gboolean
+lookup_sets_group (const GtkCssLookup *lookup,
+                   GtkCssValueGroup    group)
+{
+  guint i;
+
+  for (i = 0; i < value_groups[group].n_properties; i++)
+    {
+      if (lookup->values[value_groups[group].properties[i]].value)
+        return TRUE;
+    }
+
+  return FALSE;
+}
+
+/* Replaces freshly computed values by an equal group from the parent
+ * or the default style, so that only one copy is kept around.
+ */
+static void
+gtk_css_static_style_share_group (GtkCssStaticStyle *style,
+                                  GtkCssStaticStyle *other,
+                                  GtkCssValueGroup   group)
+{
+  if (other == NULL || other == style ||
+      other->groups[group] == NULL || style->groups[group] == NULL)
+    return;
+
+  if (!gtk_css_values_equal (style->groups[group], other->groups[group], group))
+    return;
+
+  gtk_css_values_unref (style->groups[group], group);
+  style->groups[group] = gtk_css_values_ref (other->groups[group]);
+}
+
+/* Computes a style from the result of a lookup done by the caller,
+ * so that the matching can happen elsewhere, like on another thread.
+ * The lookup must still be destroyed by the caller.
+ */
+GtkCssStyle *
+gtk_css_static_style_new_resolve (GtkStyleProvider *provider,
+                                  GtkCssLookup     *lookup,
+                                  GtkCssChange      change,
+                                  GtkCssStyle      *parent)
+{
+  GtkCssStaticStyle *result;
+  GtkCssStaticStyle *static_parent;
+  guint32 untouched = 0;
+  guint i, j;
+
+  result = g_object_new (GTK_TYPE_CSS_STATIC_STYLE, NULL);
+
+  result->change = change;
+
+  static_parent = GTK_IS_CSS_STATIC_STYLE (parent) ? GTK_CSS_STATIC_STYLE (parent) : NULL;
+
+  for (i = 0; i < GTK_CSS_N_VALUE_GROUPS; i++)
+    {
+      if (lookup_sets_group (lookup, i))
+        continue;
+
+      untouched |= 1 << i;
+
+      /* Inheriting every value gives the parent's values, so don't
+       * even compute them */
+      if (value_groups[i].inherited && static_parent && static_parent->groups[i])
+        {
+          result->groups[i] = gtk_css_values_ref (static_parent->groups[i]);
+          for (j = 0; j < value_groups[i].n_properties; j++)
+            lookup->missing = _gtk_bitmask_set (lookup->missing, value_groups[i].properties[j], FALSE);
+        }
+    }
+
+  _gtk_css_lookup_resolve (lookup,
+                           provider,
+                           result,
+                           parent);
+
+  for (i = 0; i < GTK_CSS_N_VALUE_GROUPS; i++)
+    {
+      if ((untouched & (1 << i)) == 0)
+        continue;
+
+      gtk_css_static_style_share_group (result, static_parent, i);
+      if (default_style)
+        gtk_css_static_style_share_group (result, GTK_CSS_STATIC_STYLE (default_style), i);
+    }
+
+  return GTK_CSS_STYLE (result);
+}
+
 GtkCssStyle *
 gtk_css_static_style_new_compute (GtkStyleProvider    *provider,
                                   const GtkCssMatcher *matcher,
                                   GtkCssStyle         *parent)
 {
-  GtkCssStaticStyle *result;
+  GtkCssStyle *result;
   GtkCssLookup lookup;
   GtkCssChange change = GTK_CSS_CHANGE_ANY_SELF | GTK_CSS_CHANGE_ANY_SIBLING | GTK_CSS_CHANGE_ANY_PARENT;
 
@@ -183,18 +535,11 @@ gtk_css_static_style_new_compute (GtkStyleProvider    *provider,
                                &lookup,
                                &change);
 
-  result = g_object_new (GTK_TYPE_CSS_STATIC_STYLE, NULL);
-
-  result->change = change;
-
-  _gtk_css_lookup_resolve (&lookup,
-                           provider,
-                           result,
-                           parent);
+  result = gtk_css_static_style_new_resolve (provider, &lookup, change, parent);
 
   _gtk_css_lookup_destroy (&lookup);
 
-  return GTK_CSS_STYLE (result);
+  return result;
 }
 
 void
@@ -34,12 +34,35 @@ G_BEGIN_DECLS
 
 typedef struct _GtkCssStaticStyle           GtkCssStaticStyle;
 typedef struct _GtkCssStaticStyleClass      GtkCssStaticStyleClass;
+typedef struct _GtkCssValues                GtkCssValues;
+
+/* gtkcsslookupprivate.h includes this header */
+struct _GtkCssLookup;
+
+/* The computed values are stored in refcounted groups of related
+ * properties. Styles share a group with their parent or the default
+ * style when the values are the same, which is the common case.
+ */
+typedef enum {
+  GTK_CSS_CORE_VALUES,
+  GTK_CSS_FONT_VALUES,
+  GTK_CSS_ICON_VALUES,
+  GTK_CSS_TEXT_DECORATION_VALUES,
+  GTK_CSS_BACKGROUND_VALUES,
+  GTK_CSS_SIZE_VALUES,
+  GTK_CSS_BORDER_VALUES,
+  GTK_CSS_OUTLINE_VALUES,
+  GTK_CSS_ANIMATION_VALUES,
+  GTK_CSS_OTHER_VALUES,
+  /* add more */
+  GTK_CSS_N_VALUE_GROUPS
+} GtkCssValueGroup;
 
 struct _GtkCssStaticStyle
 {
   GtkCssStyle parent;
 
-  GtkCssValue           *values[GTK_CSS_PROPERTY_N_PROPERTIES]; /* the values */
+  GtkCssValues          *groups[GTK_CSS_N_VALUE_GROUPS]; /* the values */
   GPtrArray             *sections;             /* sections the values are defined in */
 
   GtkCssChange           change;               /* change as returned by value lookup */
@@ -56,6 +79,10 @@ GtkCssStyle *           gtk_css_static_style_get_default        (void);
 GtkCssStyle *           gtk_css_static_style_new_compute        (GtkStyleProvider       *provider,
                                                                  const GtkCssMatcher    *matcher,
                                                                  GtkCssStyle            *parent);
+GtkCssStyle *           gtk_css_static_style_new_resolve        (GtkStyleProvider       *provider,
+                                                                 struct _GtkCssLookup   *lookup,
+                                                                 GtkCssChange            change,
+                                                                 GtkCssStyle            *parent);
 
 void                    gtk_css_static_style_compute_value      (GtkCssStaticStyle      *style,
                                                                  GtkStyleProvider       *provider,
@@ -19,8 +19,60 @@
 
 #include "gtkcssstylechangeprivate.h"
 
+#include "gtkcssanimatedstyleprivate.h"
 #include "gtkcssstylepropertyprivate.h"
 
+static void
+gtk_css_style_change_compare_value (GtkCssStyleChange *change,
+                                    guint              id)
+{
+  if (!_gtk_css_value_equal (gtk_css_style_get_value (change->old_style, id),
+                             gtk_css_style_get_value (change->new_style, id)))
+    {
+      change->affects |= _gtk_css_style_property_get_affects (_gtk_css_style_property_lookup_by_id (id));
+      change->changes = _gtk_bitmask_set (change->changes, id, TRUE);
+    }
+}
+
+static GtkCssStyle *
+get_base_style (GtkCssStyle  *style,
+                GPtrArray   **animated_values)
+{
+  if (GTK_IS_CSS_ANIMATED_STYLE (style))
+    {
+      *animated_values = GTK_CSS_ANIMATED_STYLE (style)->animated_values;
+      return GTK_CSS_ANIMATED_STYLE (style)->style;
+    }
+
+  *animated_values = NULL;
+  return style;
+}
+
+/* When animations advance, start or end on top of the same style,
+ * only the animated values can differ. That is what happens every
+ * frame for every animating node, so we can skip all the others. */
+static void
+gtk_css_style_change_compare_animated (GtkCssStyleChange *change)
+{
+  GPtrArray *old_values, *new_values;
+  guint id, n_old, n_new;
+
+  if (get_base_style (change->old_style, &old_values) != get_base_style (change->new_style, &new_values))
+    return;
+
+  n_old = old_values ? old_values->len : 0;
+  n_new = new_values ? new_values->len : 0;
+
+  for (id = 0; id < MAX (n_old, n_new); id++)
+    {
+      if ((id < n_old && g_ptr_array_index (old_values, id)) ||
+          (id < n_new && g_ptr_array_index (new_values, id)))
+        gtk_css_style_change_compare_value (change, id);
+    }
+
+  change->n_compared = GTK_CSS_PROPERTY_N_PROPERTIES;
+}
+
 void
 gtk_css_style_change_init (GtkCssStyleChange *change,
                            GtkCssStyle       *old_style,
@@ -37,6 +89,8 @@ gtk_css_style_change_init (GtkCssStyleChange *change,
   /* Make sure we don't do extra work if old and new are equal. */
   if (old_style == new_style)
     change->n_compared = GTK_CSS_PROPERTY_N_PROPERTIES;
+  else
+    gtk_css_style_change_compare_animated (change);
 }
 
 void
@@ -65,12 +119,7 @@ gtk_css_style_compare_next_value (GtkCssStyleChange *change)
   if (change->n_compared == GTK_CSS_PROPERTY_N_PROPERTIES)
     return FALSE;
 
-  if (!_gtk_css_value_equal (gtk_css_style_get_value (change->old_style, change->n_compared),
-                             gtk_css_style_get_value (change->new_style, change->n_compared)))
-    {
-      change->affects |= _gtk_css_style_property_get_affects (_gtk_css_style_property_lookup_by_id (change->n_compared));
-      change->changes = _gtk_bitmask_set (change->changes, change->n_compared, TRUE);
-    }
+  gtk_css_style_change_compare_value (change, change->n_compared);
 
   change->n_compared++;
 
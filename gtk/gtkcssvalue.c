@@ -29,6 +29,9 @@ struct _GtkCssValue {
 
 G_DEFINE_BOXED_TYPE (GtkCssValue, _gtk_css_value, _gtk_css_value_ref, _gtk_css_value_unref)
 
+/* Interned values, they don't hold a reference */
+static GHashTable *interned_values;
+
 GtkCssValue *
 _gtk_css_value_alloc (const GtkCssValueClass *klass,
                       gsize                   size)
@@ -63,9 +66,77 @@ gtk_css_value_unref (GtkCssValue *value)
   if (value->ref_count > 0)
     return;
 
+  if (value->class->hash && interned_values)
+    {
+      gpointer interned;
+
+      /* An equal value may be interned instead of this one */
+      if (g_hash_table_lookup_extended (interned_values, value, &interned, NULL) &&
+          interned == value)
+        g_hash_table_remove (interned_values, value);
+    }
+
   value->class->free (value);
 }
 
+static guint
+gtk_css_value_hash_func (gconstpointer value)
+{
+  return gtk_css_value_hash (value);
+}
+
+static gboolean
+gtk_css_value_equal_func (gconstpointer value1,
+                          gconstpointer value2)
+{
+  return _gtk_css_value_equal (value1, value2);
+}
+
+/**
+ * gtk_css_value_intern:
+ * @value: (transfer full): the value to intern
+ *
+ * Replaces @value with an equal value that is already in use, so that
+ * equal values share one instance and usually compare equal by pointer.
+ * This only works for values whose class implements the hash vfunc,
+ * other values are returned unchanged.
+ *
+ * Returns: (transfer full): @value or an equal value
+ **/
+GtkCssValue *
+gtk_css_value_intern (GtkCssValue *value)
+{
+  GtkCssValue *interned;
+
+  gtk_internal_return_val_if_fail (value != NULL, NULL);
+
+  if (value->class->hash == NULL)
+    return value;
+
+  if (G_UNLIKELY (interned_values == NULL))
+    interned_values = g_hash_table_new (gtk_css_value_hash_func, gtk_css_value_equal_func);
+
+  interned = g_hash_table_lookup (interned_values, value);
+  if (interned == value)
+    return value;
+
+  if (interned)
+    {
+      _gtk_css_value_ref (interned);
+      _gtk_css_value_unref (value);
+      return interned;
+    }
+
+  /* Values that aren't equal to themselves, like NaN, could never
+   * be found again */
+  if (!value->class->equal (value, value))
+    return value;
+
+  g_hash_table_add (interned_values, value);
+
+  return value;
+}
+
 /**
  * _gtk_css_value_compute:
  * @value: the value to compute from
@@ -107,6 +178,18 @@ _gtk_css_value_equal (const GtkCssValue *value1,
   return value1->class->equal (value1, value2);
 }
 
+/* Classes without a hash vfunc hash all their values the same */
+guint
+gtk_css_value_hash (const GtkCssValue *value)
+{
+  gtk_internal_return_val_if_fail (value != NULL, 0);
+
+  if (value->class->hash == NULL)
+    return GPOINTER_TO_UINT (value->class);
+
+  return value->class->hash (value);
+}
+
 gboolean
 _gtk_css_value_equal0 (const GtkCssValue *value1,
                        const GtkCssValue *value2)
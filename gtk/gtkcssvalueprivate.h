@@ -56,6 +56,8 @@ struct _GtkCssValueClass {
                                                        gint64                      monotonic_time);
   void          (* print)                             (const GtkCssValue          *value,
                                                        GString                    *string);
+  /* Values of classes that implement this get interned, see gtk_css_value_intern() */
+  guint         (* hash)                              (const GtkCssValue          *value);
 };
 
 GType        _gtk_css_value_get_type                  (void) G_GNUC_CONST;
@@ -78,6 +80,8 @@ gboolean     _gtk_css_value_equal                     (const GtkCssValue
                                                        const GtkCssValue          *value2);
 gboolean     _gtk_css_value_equal0                    (const GtkCssValue          *value1,
                                                        const GtkCssValue          *value2);
+guint           gtk_css_value_hash                    (const GtkCssValue          *value);
+GtkCssValue *   gtk_css_value_intern                  (GtkCssValue                *value);
 GtkCssValue *_gtk_css_value_transition                (GtkCssValue                *start,
                                                        GtkCssValue                *end,
                                                        guint                       property_id,
@@ -39,12 +39,20 @@ struct _GtkDrawingAreaPrivate {
   GtkDrawingAreaDrawFunc draw_func;
   gpointer draw_func_target;
   GDestroyNotify draw_func_target_destroy_notify;
+
+  /* The last drawn contents, when retained */
+  GskRenderNode *contents;
+  int contents_width;
+  int contents_height;
+
+  guint retained : 1;
 };
 
 enum {
   PROP_0,
   PROP_CONTENT_WIDTH,
   PROP_CONTENT_HEIGHT,
+  PROP_RETAINED,
   LAST_PROP
 };
 
@@ -156,6 +164,10 @@ gtk_drawing_area_set_property (GObject      *gobject,
       gtk_drawing_area_set_content_height (self, g_value_get_int (value));
       break;
 
+    case PROP_RETAINED:
+      gtk_drawing_area_set_retained (self, g_value_get_boolean (value));
+      break;
+
     default:
       G_OBJECT_WARN_INVALID_PROPERTY_ID (gobject, prop_id, pspec);
     }
@@ -180,6 +192,10 @@ gtk_drawing_area_get_property (GObject    *gobject,
       g_value_set_int (value, priv->content_height);
       break;
 
+    case PROP_RETAINED:
+      g_value_set_boolean (value, priv->retained);
+      break;
+
     default:
       G_OBJECT_WARN_INVALID_PROPERTY_ID (gobject, prop_id, pspec);
     }
@@ -198,6 +214,8 @@ gtk_drawing_area_dispose (GObject *object)
   priv->draw_func_target = NULL;
   priv->draw_func_target_destroy_notify = NULL;
 
+  g_clear_pointer (&priv->contents, gsk_render_node_unref);
+
   G_OBJECT_CLASS (gtk_drawing_area_parent_class)->dispose (object);
 }
 
@@ -238,6 +256,29 @@ gtk_drawing_area_snapshot (GtkWidget   *widget,
   width = gtk_widget_get_width (widget);
   height = gtk_widget_get_height (widget);
 
+  if (priv->retained)
+    {
+      if (priv->contents == NULL ||
+          priv->contents_width != width ||
+          priv->contents_height != height)
+        {
+          g_clear_pointer (&priv->contents, gsk_render_node_unref);
+
+          priv->contents = gsk_cairo_node_new (&GRAPHENE_RECT_INIT (0, 0, width, height));
+          priv->contents_width = width;
+          priv->contents_height = height;
+
+          cr = gsk_cairo_node_get_draw_context (priv->contents);
+          priv->draw_func (self,
+                           cr,
+                           width, height,
+                           priv->draw_func_target);
+          cairo_destroy (cr);
+        }
+
+      gtk_snapshot_append_node (snapshot, priv->contents);
+      return;
+    }
 
   cr = gtk_snapshot_append_cairo (snapshot,
                                   &GRAPHENE_RECT_INIT (
@@ -288,6 +329,19 @@ gtk_drawing_area_class_init (GtkDrawingAreaClass *class)
                       0, G_MAXINT, 0,
                       GTK_PARAM_READWRITE|G_PARAM_EXPLICIT_NOTIFY);
 
+  /**
+   * GtkDrawingArea:retained
+   *
+   * Whether the contents are kept between redraws. See
+   * gtk_drawing_area_set_retained() for details.
+   */
+  props[PROP_RETAINED] =
+    g_param_spec_boolean ("retained",
+                          P_("Retained"),
+                          P_("Whether the drawn contents are kept until they are invalidated"),
+                          FALSE,
+                          GTK_PARAM_READWRITE|G_PARAM_EXPLICIT_NOTIFY);
+
   g_object_class_install_properties (gobject_class, LAST_PROP, props);
 
   gtk_widget_class_set_accessible_role (widget_class, ATK_ROLE_DRAWING_AREA);
@@ -430,6 +484,8 @@ gtk_drawing_area_get_content_height (GtkDrawingArea *self)
  *
  * If what you are drawing does change, call gtk_widget_queue_draw() on the
  * drawing area. This will cause a redraw and will call @draw_func again.
+ * For a retained drawing area, call gtk_drawing_area_invalidate_contents()
+ * instead.
  */
 void
 gtk_drawing_area_set_draw_func (GtkDrawingArea         *self,
@@ -448,6 +504,81 @@ gtk_drawing_area_set_draw_func (GtkDrawingArea         *self,
   priv->draw_func_target = user_data;
   priv->draw_func_target_destroy_notify = destroy;
 
+  gtk_drawing_area_invalidate_contents (self);
+}
+
+/**
+ * gtk_drawing_area_set_retained:
+ * @self: a #GtkDrawingArea
+ * @retained: whether to keep the drawn contents
+ *
+ * Sets whether the drawing area keeps what its draw function drew.
+ *
+ * A retained drawing area only calls its draw function when its size
+ * changed or gtk_drawing_area_invalidate_contents() was called. Other
+ * redraws, for example because the state of the drawing area or one
+ * of its parents changed, reuse the previous contents. This is useful
+ * when the draw function is expensive, like for plots and charts.
+ *
+ * The draw function of a retained drawing area should not depend on
+ * anything but the application's data, or the drawing area must be
+ * invalidated when that changes, too.
+ **/
+void
+gtk_drawing_area_set_retained (GtkDrawingArea *self,
+                               gboolean        retained)
+{
+  GtkDrawingAreaPrivate *priv = gtk_drawing_area_get_instance_private (self);
+
+  g_return_if_fail (GTK_IS_DRAWING_AREA (self));
+
+  retained = !!retained;
+
+  if (priv->retained == retained)
+    return;
+
+  priv->retained = retained;
+
+  gtk_drawing_area_invalidate_contents (self);
+  g_object_notify_by_pspec (G_OBJECT (self), props[PROP_RETAINED]);
+}
+
+/**
+ * gtk_drawing_area_get_retained:
+ * @self: a #GtkDrawingArea
+ *
+ * Returns whether the drawing area keeps its contents, see
+ * gtk_drawing_area_set_retained().
+ *
+ * Returns: %TRUE if the drawing area is retained
+ **/
+gboolean
+gtk_drawing_area_get_retained (GtkDrawingArea *self)
+{
+  GtkDrawingAreaPrivate *priv = gtk_drawing_area_get_instance_private (self);
+
+  g_return_val_if_fail (GTK_IS_DRAWING_AREA (self), FALSE);
+
+  return priv->retained;
+}
+
+/**
+ * gtk_drawing_area_invalidate_contents:
+ * @self: a #GtkDrawingArea
+ *
+ * Drops the contents kept by a retained drawing area and queues a
+ * redraw, so the draw function is called again. For drawing areas
+ * that are not retained, this is the same as gtk_widget_queue_draw().
+ **/
+void
+gtk_drawing_area_invalidate_contents (GtkDrawingArea *self)
+{
+  GtkDrawingAreaPrivate *priv = gtk_drawing_area_get_instance_private (self);
+
+  g_return_if_fail (GTK_IS_DRAWING_AREA (self));
+
+  g_clear_pointer (&priv->contents, gsk_render_node_unref);
+
   gtk_widget_queue_draw (GTK_WIDGET (self));
 }
 
@@ -104,6 +104,14 @@ void            gtk_drawing_area_set_draw_func          (GtkDrawingArea
                                                          gpointer                user_data,
                                                          GDestroyNotify          destroy);
 
+GDK_AVAILABLE_IN_ALL
+void            gtk_drawing_area_set_retained           (GtkDrawingArea         *self,
+                                                         gboolean                retained);
+GDK_AVAILABLE_IN_ALL
+gboolean        gtk_drawing_area_get_retained           (GtkDrawingArea         *self);
+GDK_AVAILABLE_IN_ALL
+void            gtk_drawing_area_invalidate_contents    (GtkDrawingArea         *self);
+
 G_END_DECLS
 
 #endif /* __GTK_DRAWING_AREA_H__ */
@@ -67,6 +67,9 @@ struct _GtkEmojiChooser
   EmojiSection flags;
 
   GVariant *data;
+  GtkWidget *box;
+  GVariantIter *iter;
+  guint populate_idle;
 
   GSettings *settings;
 };
@@ -84,12 +87,27 @@ static int signals[LAST_SIGNAL];
 
 G_DEFINE_TYPE (GtkEmojiChooser, gtk_emoji_chooser, GTK_TYPE_POPOVER)
 
+static void
+gtk_emoji_chooser_dispose (GObject *object)
+{
+  GtkEmojiChooser *chooser = GTK_EMOJI_CHOOSER (object);
+
+  if (chooser->populate_idle)
+    {
+      g_source_remove (chooser->populate_idle);
+      chooser->populate_idle = 0;
+    }
+
+  G_OBJECT_CLASS (gtk_emoji_chooser_parent_class)->dispose (object);
+}
+
 static void
 gtk_emoji_chooser_finalize (GObject *object)
 {
   GtkEmojiChooser *chooser = GTK_EMOJI_CHOOSER (object);
 
-  g_variant_unref (chooser->data);
+  g_clear_pointer (&chooser->data, g_variant_unref);
+  g_clear_pointer (&chooser->iter, g_variant_iter_free);
   g_object_unref (chooser->settings);
 
   G_OBJECT_CLASS (gtk_emoji_chooser_parent_class)->finalize (object);
@@ -396,47 +414,77 @@ add_emoji (GtkWidget    *box,
   gtk_flow_box_insert (GTK_FLOW_BOX (box), child, prepend ? 0 : -1);
 }
 
-static void
-populate_emoji_chooser (GtkEmojiChooser *chooser)
+static void update_headings (GtkEmojiChooser *chooser);
+
+/* Shaping thousands of emoji takes a while, so they are added a few
+ * milliseconds at a time, in the order the sections are shown in */
+#define POPULATE_TIME_SLICE (8 * G_TIME_SPAN_MILLISECOND)
+
+static gboolean
+populate_emoji_chooser (gpointer data)
 {
-  GBytes *bytes = NULL;
-  GVariantIter iter;
+  GtkEmojiChooser *chooser = data;
   GVariant *item;
-  GtkWidget *box;
+  gint64 start;
 
-  bytes = g_resources_lookup_data ("/org/gtk/libgtk/emoji/emoji.data", 0, NULL);
-  chooser->data = g_variant_ref_sink (g_variant_new_from_bytes (G_VARIANT_TYPE ("a(auss)"), bytes, TRUE));
+  start = g_get_monotonic_time ();
 
-  g_variant_iter_init (&iter, chooser->data);
-  box = chooser->people.box;
-  while ((item = g_variant_iter_next_value (&iter)))
+  if (chooser->data == NULL)
+    {
+      GBytes *bytes;
+
+      bytes = g_resources_lookup_data ("/org/gtk/libgtk/emoji/emoji.data", 0, NULL);
+      chooser->data = g_variant_ref_sink (g_variant_new_from_bytes (G_VARIANT_TYPE ("a(auss)"), bytes, TRUE));
+      g_bytes_unref (bytes);
+    }
+
+  if (chooser->iter == NULL)
+    {
+      chooser->iter = g_variant_iter_new (chooser->data);
+      chooser->box = chooser->people.box;
+    }
+
+  while ((item = g_variant_iter_next_value (chooser->iter)))
     {
       const char *name;
 
       g_variant_get_child (item, 1, "&s", &name);
 
       if (strcmp (name, chooser->body.first) == 0)
-        box = chooser->body.box;
+        chooser->box = chooser->body.box;
       else if (strcmp (name, chooser->nature.first) == 0)
-        box = chooser->nature.box;
+        chooser->box = chooser->nature.box;
       else if (strcmp (name, chooser->food.first) == 0)
-        box = chooser->food.box;
+        chooser->box = chooser->food.box;
       else if (strcmp (name, chooser->travel.first) == 0)
-        box = chooser->travel.box;
+        chooser->box = chooser->travel.box;
       else if (strcmp (name, chooser->activities.first) == 0)
-        box = chooser->activities.box;
+        chooser->box = chooser->activities.box;
       else if (strcmp (name, chooser->objects.first) == 0)
-        box = chooser->objects.box;
+        chooser->box = chooser->objects.box;
       else if (strcmp (name, chooser->symbols.first) == 0)
-        box = chooser->symbols.box;
+        chooser->box = chooser->symbols.box;
       else if (strcmp (name, chooser->flags.first) == 0)
-        box = chooser->flags.box;
+        chooser->box = chooser->flags.box;
 
-      add_emoji (box, FALSE, item, 0, chooser);
+      add_emoji (chooser->box, FALSE, item, 0, chooser);
       g_variant_unref (item);
+
+      if (g_get_monotonic_time () - start > POPULATE_TIME_SLICE)
+        goto out;
     }
 
-  g_bytes_unref (bytes);
+  g_clear_pointer (&chooser->iter, g_variant_iter_free);
+  chooser->box = NULL;
+  chooser->populate_idle = 0;
+
+out:
+  /* The new emoji went through the search filter, which may have
+   * found the first matches in a section */
+  if (gtk_entry_get_text (GTK_ENTRY (chooser->search_entry))[0] != 0)
+    update_headings (chooser);
+
+  return chooser->populate_idle != 0 ? G_SOURCE_CONTINUE : G_SOURCE_REMOVE;
 }
 
 static void
@@ -644,9 +692,11 @@ gtk_emoji_chooser_init (GtkEmojiChooser *chooser)
   setup_section (chooser, &chooser->symbols, "ATM sign", "emoji-symbols-symbolic");
   setup_section (chooser, &chooser->flags, "chequered flag", "emoji-flags-symbolic");
 
-  populate_emoji_chooser (chooser);
   populate_recent_section (chooser);
 
+  chooser->populate_idle = g_idle_add (populate_emoji_chooser, chooser);
+  g_source_set_name_by_id (chooser->populate_idle, "[gtk] populate_emoji_chooser");
+
   /* We scroll to the top on show, so check the right button for the 1st time */
   gtk_widget_set_state_flags (chooser->recent.button, GTK_STATE_FLAG_CHECKED, FALSE);
 }
@@ -671,6 +721,7 @@ gtk_emoji_chooser_class_init (GtkEmojiChooserClass *klass)
   GObjectClass *object_class = G_OBJECT_CLASS (klass);
   GtkWidgetClass *widget_class = GTK_WIDGET_CLASS (klass);
 
+  object_class->dispose = gtk_emoji_chooser_dispose;
   object_class->finalize = gtk_emoji_chooser_finalize;
   widget_class->show = gtk_emoji_chooser_show;
 
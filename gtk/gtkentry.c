@@ -555,6 +555,7 @@ static PangoLayout *gtk_entry_ensure_layout            (GtkEntry       *entry,
                                                         gboolean        include_preedit);
 static void         gtk_entry_reset_layout             (GtkEntry       *entry);
 static void         gtk_entry_recompute                (GtkEntry       *entry);
+static void         gtk_entry_recompute_cursor         (GtkEntry       *entry);
 static gint         gtk_entry_find_position            (GtkEntry       *entry,
 							gint            x);
 static void         gtk_entry_get_cursor_locations     (GtkEntry       *entry,
@@ -2573,6 +2574,7 @@ gtk_entry_init (GtkEntry *entry)
       priv->undershoot_node[i] = gtk_css_node_new ();
       gtk_css_node_set_name (priv->undershoot_node[i], I_("undershoot"));
       gtk_css_node_add_class (priv->undershoot_node[i], g_quark_from_static_string (i == 0 ? GTK_STYLE_CLASS_LEFT : GTK_STYLE_CLASS_RIGHT));
+      gtk_css_node_set_lazy (priv->undershoot_node[i], TRUE);
       gtk_css_node_set_parent (priv->undershoot_node[i], widget_node);
       gtk_css_node_set_state (priv->undershoot_node[i], gtk_css_node_get_state (widget_node) & ~GTK_STATE_FLAG_DROP_ACTIVE);
       g_object_unref (priv->undershoot_node[i]);
@@ -4389,10 +4391,14 @@ static void
 gtk_entry_style_updated (GtkWidget *widget)
 {
   GtkEntry *entry = GTK_ENTRY (widget);
+  GtkCssStyleChange *change;
 
   GTK_WIDGET_CLASS (gtk_entry_parent_class)->style_updated (widget);
 
-  gtk_entry_update_cached_style_values (entry);
+  /* The invisible char depends on the font only */
+  change = gtk_style_context_get_change (gtk_widget_get_style_context (widget));
+  if (change == NULL || gtk_css_style_change_affects (change, GTK_CSS_AFFECTS_TEXT_SIZE))
+    gtk_entry_update_cached_style_values (entry);
 }
 
 /* GtkCellEditable method implementations
@@ -4550,8 +4556,9 @@ buffer_inserted_text (GtkEntryBuffer *buffer,
   if (selection_bound > position)
     selection_bound += n_chars;
 
+  gtk_entry_reset_layout (entry);
   gtk_entry_set_positions (entry, current_pos, selection_bound);
-  gtk_entry_recompute (entry);
+  gtk_entry_recompute_cursor (entry);
 
   /* Calculate the password hint if it needs to be displayed. */
   if (n_chars == 1 && !priv->visible)
@@ -4601,8 +4608,9 @@ buffer_deleted_text (GtkEntryBuffer *buffer,
   if (selection_bound > position)
     selection_bound -= MIN (selection_bound, end_pos) - position;
 
+  gtk_entry_reset_layout (entry);
   gtk_entry_set_positions (entry, current_pos, selection_bound);
-  gtk_entry_recompute (entry);
+  gtk_entry_recompute_cursor (entry);
 
   /* We might have deleted the selection */
   gtk_entry_update_primary_selection (entry);
@@ -5356,7 +5364,11 @@ gtk_entry_set_positions (GtkEntry *entry,
 
   if (changed)
     {
-      gtk_entry_recompute (entry);
+      /* The preedit string is part of the layout at the cursor */
+      if (priv->preedit_length > 0)
+        gtk_entry_recompute (entry);
+      else
+        gtk_entry_recompute_cursor (entry);
     }
 }
 
@@ -5401,13 +5413,16 @@ update_im_cursor_location (GtkEntry *entry)
   gtk_im_context_set_cursor_location (priv->im_context, &area);
 }
 
+/* Updates everything that depends on the cursor and selection, but
+ * keeps the cached layout. Shaping long text is by far the most
+ * expensive part, so moving the cursor should not redo it.
+ */
 static void
-gtk_entry_recompute (GtkEntry *entry)
+gtk_entry_recompute_cursor (GtkEntry *entry)
 {
   GtkEntryPrivate *priv = gtk_entry_get_instance_private (entry);
   GtkTextHandleMode handle_mode;
 
-  gtk_entry_reset_layout (entry);
   gtk_entry_check_cursor_blink (entry);
 
   gtk_entry_adjust_scroll (entry);
@@ -5425,6 +5440,13 @@ gtk_entry_recompute (GtkEntry *entry)
   gtk_widget_queue_draw (GTK_WIDGET (entry));
 }
 
+static void
+gtk_entry_recompute (GtkEntry *entry)
+{
+  gtk_entry_reset_layout (entry);
+  gtk_entry_recompute_cursor (entry);
+}
+
 static PangoLayout *
 gtk_entry_create_layout (GtkEntry *entry,
 			 gboolean  include_preedit)
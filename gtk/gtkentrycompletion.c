@@ -94,6 +94,7 @@
 
 #define PAGE_STEP 14
 #define COMPLETION_TIMEOUT 100
+#define ROW_KEYS_SLICE_USEC 5000
 
 /* signals */
 enum
@@ -141,6 +142,8 @@ static void     gtk_entry_completion_dispose             (GObject      *object);
 static gboolean gtk_entry_completion_visible_func        (GtkTreeModel       *model,
                                                           GtkTreeIter        *iter,
                                                           gpointer            data);
+static void     gtk_entry_completion_reset_row_keys      (GtkEntryCompletion *completion);
+static void     gtk_entry_completion_clear_row_keys      (GtkEntryCompletion *completion);
 static void     gtk_entry_completion_list_activated      (GtkTreeView        *treeview,
                                                           GtkTreePath        *path,
                                                           GtkTreeViewColumn  *column,
@@ -637,6 +640,7 @@ gtk_entry_completion_set_property (GObject      *object,
 
       case PROP_TEXT_COLUMN:
         priv->text_column = g_value_get_int (value);
+        gtk_entry_completion_reset_row_keys (completion);
         break;
 
       case PROP_INLINE_COMPLETION:
@@ -748,6 +752,8 @@ gtk_entry_completion_finalize (GObject *object)
   g_free (priv->case_normalized_key);
   g_free (priv->completion_prefix);
 
+  gtk_entry_completion_clear_row_keys (completion);
+
   if (priv->match_notify)
     (* priv->match_notify) (priv->match_data);
 
@@ -760,6 +766,16 @@ gtk_entry_completion_dispose (GObject *object)
   GtkEntryCompletion *completion = GTK_ENTRY_COMPLETION (object);
   GtkEntryCompletionPrivate *priv = completion->priv;
 
+  if (priv->filter_model)
+    {
+      g_signal_handlers_disconnect_by_func (gtk_tree_model_filter_get_model (priv->filter_model),
+                                            gtk_entry_completion_reset_row_keys,
+                                            completion);
+      /* owned by the tree view */
+      priv->filter_model = NULL;
+    }
+  gtk_entry_completion_clear_row_keys (completion);
+
   if (priv->tree_view)
     {
       gtk_widget_destroy (priv->tree_view);
@@ -813,6 +829,36 @@ gtk_entry_completion_get_area (GtkCellLayout *cell_layout)
   return priv->cell_area;
 }
 
+/* The normalized and casefolded text of the row, as the default
+ * match function compares it with the key
+ */
+static gchar *
+gtk_entry_completion_get_row_key (GtkEntryCompletion *completion,
+                                  GtkTreeModel       *model,
+                                  GtkTreeIter        *iter)
+{
+  gchar *item = NULL;
+  gchar *normalized_string;
+  gchar *case_normalized_string = NULL;
+
+  gtk_tree_model_get (model, iter,
+                      completion->priv->text_column, &item,
+                      -1);
+
+  if (item != NULL)
+    {
+      normalized_string = g_utf8_normalize (item, -1, G_NORMALIZE_ALL);
+
+      if (normalized_string != NULL)
+        case_normalized_string = g_utf8_casefold (normalized_string, -1);
+
+      g_free (normalized_string);
+    }
+  g_free (item);
+
+  return case_normalized_string;
+}
+
 /* all those callbacks */
 static gboolean
 gtk_entry_completion_default_completion_func (GtkEntryCompletion *completion,
@@ -820,8 +866,6 @@ gtk_entry_completion_default_completion_func (GtkEntryCompletion *completion,
                                               GtkTreeIter        *iter,
                                               gpointer            user_data)
 {
-  gchar *item = NULL;
-  gchar *normalized_string;
   gchar *case_normalized_string;
 
   gboolean ret = FALSE;
@@ -833,28 +877,193 @@ gtk_entry_completion_default_completion_func (GtkEntryCompletion *completion,
   g_return_val_if_fail (gtk_tree_model_get_column_type (model, completion->priv->text_column) == G_TYPE_STRING,
                         FALSE);
 
-  gtk_tree_model_get (model, iter,
-                      completion->priv->text_column, &item,
-                      -1);
+  case_normalized_string = gtk_entry_completion_get_row_key (completion, model, iter);
+  if (case_normalized_string != NULL)
+    {
+      if (!strncmp (key, case_normalized_string, strlen (key)))
+        ret = TRUE;
 
-  if (item != NULL)
+      g_free (case_normalized_string);
+    }
+
+  return ret;
+}
+
+/* Incremental matching
+ *
+ * With the default match function, the completion keeps the normalized
+ * and casefolded text of every row of a list model around, so typing
+ * doesn't fetch and normalize the text of every row on each keystroke.
+ * The row keys are built in time slices when the model or the text
+ * column change. When the key only got longer since the last
+ * completion, only the rows that matched before are looked at again.
+ */
+static void
+gtk_entry_completion_clear_matches (GtkEntryCompletion *completion)
+{
+  GtkEntryCompletionPrivate *priv = completion->priv;
+
+  g_clear_pointer (&priv->matches, g_array_unref);
+  g_clear_pointer (&priv->matches_key, g_free);
+}
+
+static void
+gtk_entry_completion_clear_row_keys (GtkEntryCompletion *completion)
+{
+  GtkEntryCompletionPrivate *priv = completion->priv;
+
+  gtk_entry_completion_clear_matches (completion);
+  g_clear_pointer (&priv->row_keys, g_ptr_array_unref);
+
+  if (priv->row_keys_idle)
     {
-      normalized_string = g_utf8_normalize (item, -1, G_NORMALIZE_ALL);
+      g_source_remove (priv->row_keys_idle);
+      priv->row_keys_idle = 0;
+    }
+}
 
-      if (normalized_string != NULL)
+static gboolean
+gtk_entry_completion_build_row_keys (gpointer data)
+{
+  GtkEntryCompletion *completion = data;
+  GtkEntryCompletionPrivate *priv = completion->priv;
+  GtkTreeModel *model;
+  GtkTreeIter iter;
+  gint64 end_time;
+  gboolean valid;
+
+  model = gtk_tree_model_filter_get_model (priv->filter_model);
+  end_time = g_get_monotonic_time () + ROW_KEYS_SLICE_USEC;
+
+  valid = gtk_tree_model_iter_nth_child (model, &iter, NULL, priv->row_keys->len);
+  while (valid)
+    {
+      g_ptr_array_add (priv->row_keys,
+                       gtk_entry_completion_get_row_key (completion, model, &iter));
+
+      valid = gtk_tree_model_iter_next (model, &iter);
+
+      if (valid && priv->row_keys->len % 256 == 0 &&
+          g_get_monotonic_time () > end_time)
+        return G_SOURCE_CONTINUE;
+    }
+
+  priv->row_keys_idle = 0;
+
+  return G_SOURCE_REMOVE;
+}
+
+/* Called when the model, its rows or the way rows are matched change */
+static void
+gtk_entry_completion_reset_row_keys (GtkEntryCompletion *completion)
+{
+  GtkEntryCompletionPrivate *priv = completion->priv;
+  GtkTreeModel *model;
+
+  gtk_entry_completion_clear_matches (completion);
+
+  model = priv->filter_model ? gtk_tree_model_filter_get_model (priv->filter_model) : NULL;
+
+  if (model == NULL ||
+      priv->match_func != NULL ||
+      priv->text_column < 0 ||
+      priv->text_column >= gtk_tree_model_get_n_columns (model) ||
+      gtk_tree_model_get_column_type (model, priv->text_column) != G_TYPE_STRING ||
+      (gtk_tree_model_get_flags (model) & GTK_TREE_MODEL_LIST_ONLY) == 0)
+    {
+      gtk_entry_completion_clear_row_keys (completion);
+      return;
+    }
+
+  if (priv->row_keys)
+    g_ptr_array_set_size (priv->row_keys, 0);
+  else
+    priv->row_keys = g_ptr_array_new_with_free_func (g_free);
+
+  if (priv->row_keys_idle == 0)
+    {
+      priv->row_keys_idle = g_idle_add_full (G_PRIORITY_LOW,
+                                             gtk_entry_completion_build_row_keys,
+                                             completion, NULL);
+      g_source_set_name_by_id (priv->row_keys_idle, "[gtk+] gtk_entry_completion_build_row_keys");
+    }
+}
+
+/* Finds the rows matching the current key, if the row keys are ready */
+static void
+gtk_entry_completion_update_matches (GtkEntryCompletion *completion)
+{
+  GtkEntryCompletionPrivate *priv = completion->priv;
+  const gchar *key = priv->case_normalized_key;
+  gsize key_len = strlen (key);
+  GArray *matches;
+  guint i;
+
+  if (priv->row_keys == NULL || priv->row_keys_idle != 0)
+    {
+      gtk_entry_completion_clear_matches (completion);
+      return;
+    }
+
+  matches = g_array_new (FALSE, FALSE, sizeof (guint));
+
+  if (priv->matches_key && g_str_has_prefix (key, priv->matches_key))
+    {
+      /* The key got longer, so only rows that matched before can match */
+      for (i = 0; i < priv->matches->len; i++)
         {
-          case_normalized_string = g_utf8_casefold (normalized_string, -1);
+          guint row = g_array_index (priv->matches, guint, i);
+          const gchar *row_key = g_ptr_array_index (priv->row_keys, row);
 
-          if (!strncmp (key, case_normalized_string, strlen (key)))
-            ret = TRUE;
+          if (strncmp (key, row_key, key_len) == 0)
+            g_array_append_val (matches, row);
+        }
+    }
+  else
+    {
+      for (i = 0; i < priv->row_keys->len; i++)
+        {
+          const gchar *row_key = g_ptr_array_index (priv->row_keys, i);
 
-          g_free (case_normalized_string);
+          if (row_key != NULL && strncmp (key, row_key, key_len) == 0)
+            g_array_append_val (matches, i);
         }
-      g_free (normalized_string);
     }
-  g_free (item);
 
-  return ret;
+  gtk_entry_completion_clear_matches (completion);
+  priv->matches = matches;
+  priv->matches_key = g_strdup (key);
+}
+
+static gboolean
+gtk_entry_completion_row_matches (GtkEntryCompletion *completion,
+                                  GtkTreeModel       *model,
+                                  GtkTreeIter        *iter)
+{
+  GArray *matches = completion->priv->matches;
+  GtkTreePath *path;
+  guint row, lo, hi;
+
+  path = gtk_tree_model_get_path (model, iter);
+  row = gtk_tree_path_get_indices (path)[0];
+  gtk_tree_path_free (path);
+
+  lo = 0;
+  hi = matches->len;
+  while (lo < hi)
+    {
+      guint mid = lo + (hi - lo) / 2;
+      guint match = g_array_index (matches, guint, mid);
+
+      if (match == row)
+        return TRUE;
+      else if (match < row)
+        lo = mid + 1;
+      else
+        hi = mid;
+    }
+
+  return FALSE;
 }
 
 static gboolean
@@ -869,6 +1078,9 @@ gtk_entry_completion_visible_func (GtkTreeModel *model,
   if (!completion->priv->case_normalized_key)
     return ret;
 
+  if (completion->priv->matches_key)
+    return gtk_entry_completion_row_matches (completion, model, iter);
+
   if (completion->priv->match_func)
     ret = (* completion->priv->match_func) (completion,
                                             completion->priv->case_normalized_key,
@@ -1044,15 +1256,33 @@ gtk_entry_completion_set_model (GtkEntryCompletion *completion,
   g_return_if_fail (GTK_IS_ENTRY_COMPLETION (completion));
   g_return_if_fail (model == NULL || GTK_IS_TREE_MODEL (model));
 
+  if (completion->priv->filter_model)
+    g_signal_handlers_disconnect_by_func (gtk_tree_model_filter_get_model (completion->priv->filter_model),
+                                          gtk_entry_completion_reset_row_keys,
+                                          completion);
+
   if (!model)
     {
       gtk_tree_view_set_model (GTK_TREE_VIEW (completion->priv->tree_view),
                                NULL);
       _gtk_entry_completion_popdown (completion);
       completion->priv->filter_model = NULL;
+      gtk_entry_completion_clear_row_keys (completion);
       return;
     }
 
+  /* Connect before the filter model does, so that the row keys are
+   * reset before it asks whether changed rows are visible
+   */
+  g_signal_connect_swapped (model, "row-changed",
+                            G_CALLBACK (gtk_entry_completion_reset_row_keys), completion);
+  g_signal_connect_swapped (model, "row-inserted",
+                            G_CALLBACK (gtk_entry_completion_reset_row_keys), completion);
+  g_signal_connect_swapped (model, "row-deleted",
+                            G_CALLBACK (gtk_entry_completion_reset_row_keys), completion);
+  g_signal_connect_swapped (model, "rows-reordered",
+                            G_CALLBACK (gtk_entry_completion_reset_row_keys), completion);
+
   /* code will unref the old filter model (if any) */
   completion->priv->filter_model =
     GTK_TREE_MODEL_FILTER (gtk_tree_model_filter_new (model, NULL));
@@ -1065,6 +1295,8 @@ gtk_entry_completion_set_model (GtkEntryCompletion *completion,
                            GTK_TREE_MODEL (completion->priv->filter_model));
   g_object_unref (completion->priv->filter_model);
 
+  gtk_entry_completion_reset_row_keys (completion);
+
   g_object_notify_by_pspec (G_OBJECT (completion), entry_completion_props[PROP_MODEL]);
 
   if (gtk_widget_get_visible (completion->priv->popup_window))
@@ -1117,6 +1349,8 @@ gtk_entry_completion_set_match_func (GtkEntryCompletion          *completion,
   completion->priv->match_func = func;
   completion->priv->match_data = func_data;
   completion->priv->match_notify = func_notify;
+
+  gtk_entry_completion_reset_row_keys (completion);
 }
 
 /**
@@ -1188,6 +1422,7 @@ gtk_entry_completion_complete (GtkEntryCompletion *completion)
   completion->priv->case_normalized_key = g_utf8_casefold (tmp, -1);
   g_free (tmp);
 
+  gtk_entry_completion_update_matches (completion);
   gtk_tree_model_filter_refilter (completion->priv->filter_model);
 
   if (!gtk_tree_model_get_iter_first (GTK_TREE_MODEL (completion->priv->filter_model), &iter))
@@ -1321,6 +1556,7 @@ gtk_entry_completion_set_text_column (GtkEntryCompletion *completion,
     return;
 
   completion->priv->text_column = column;
+  gtk_entry_completion_reset_row_keys (completion);
 
   cell = gtk_cell_renderer_text_new ();
   gtk_cell_layout_pack_start (GTK_CELL_LAYOUT (completion),
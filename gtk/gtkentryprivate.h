@@ -48,6 +48,15 @@ struct _GtkEntryCompletionPrivate
 
   gchar *case_normalized_key;
 
+  /* For the default match function on list models: the normalized and
+   * casefolded text of each row, built in time slices, and the sorted
+   * indexes of the rows matching matches_key
+   */
+  GPtrArray *row_keys;
+  guint      row_keys_idle;
+  GArray    *matches;
+  gchar     *matches_key;
+
   GtkEventController *entry_key_controller;
 
   /* only used by GtkEntry when attached: */
@@ -294,6 +294,9 @@ gtk_event_controller_set_propagation_phase (GtkEventController  *controller,
 
   priv->phase = phase;
 
+  if (priv->widget)
+    gtk_widget_invalidate_controller_phases (priv->widget);
+
   if (phase == GTK_PHASE_NONE)
     gtk_event_controller_reset (controller);
 
@@ -254,6 +254,7 @@ struct _GtkFileChooserWidgetPrivate {
 
   GtkFileSystemModel *browse_files_model;
   char *browse_files_last_selected_name;
+  GHashTable *thumbnail_jobs;
 
   GtkWidget *places_sidebar;
   GtkWidget *places_view;
@@ -402,6 +403,7 @@ enum {
   MODEL_COL_IS_FOLDER,
   MODEL_COL_IS_SENSITIVE,
   MODEL_COL_ICON,
+  MODEL_COL_THUMBNAIL,
   MODEL_COL_SIZE_TEXT,
   MODEL_COL_DATE_TEXT,
   MODEL_COL_TIME_TEXT,
@@ -421,6 +423,7 @@ enum {
         G_TYPE_BOOLEAN,           /* MODEL_COL_IS_FOLDER */     \
         G_TYPE_BOOLEAN,           /* MODEL_COL_IS_SENSITIVE */  \
         G_TYPE_ICON,              /* MODEL_COL_ICON */          \
+        GDK_TYPE_TEXTURE,         /* MODEL_COL_THUMBNAIL */     \
         G_TYPE_STRING,            /* MODEL_COL_SIZE_TEXT */     \
         G_TYPE_STRING,            /* MODEL_COL_DATE_TEXT */     \
         G_TYPE_STRING,            /* MODEL_COL_TIME_TEXT */     \
@@ -593,6 +596,8 @@ static void     recent_stop_loading          (GtkFileChooserWidget *impl);
 static void     recent_clear_model           (GtkFileChooserWidget *impl,
                                               gboolean               remove_from_treeview);
 static gboolean recent_should_respond        (GtkFileChooserWidget *impl);
+static void     cancel_thumbnail_jobs        (GtkFileChooserWidget *impl);
+
 static void     set_file_system_backend      (GtkFileChooserWidget *impl);
 static void     unset_file_system_backend    (GtkFileChooserWidget *impl);
 
@@ -702,6 +707,7 @@ gtk_file_chooser_widget_finalize (GObject *object)
   search_clear_model (impl, FALSE);
   recent_clear_model (impl, FALSE);
   g_clear_object (&impl->priv->model_for_search);
+  g_hash_table_unref (priv->thumbnail_jobs);
 
   /* stopping the load above should have cleared this */
   g_assert (priv->load_timeout_id == 0);
@@ -3493,6 +3499,7 @@ cancel_all_operations (GtkFileChooserWidget *impl)
       priv->file_exists_get_info_cancellable = NULL;
     }
 
+  cancel_thumbnail_jobs (impl);
   search_stop_searching (impl, TRUE);
   recent_stop_loading (impl);
 }
@@ -4588,6 +4595,7 @@ stop_loading_and_clear_list_model (GtkFileChooserWidget *impl,
   GtkFileChooserWidgetPrivate *priv = impl->priv;
 
   load_remove_timer (impl, LOAD_EMPTY);
+  cancel_thumbnail_jobs (impl);
 
   g_set_object (&priv->browse_files_model, NULL);
 
@@ -4765,6 +4773,236 @@ file_system_model_got_thumbnail (GObject      *object,
   g_object_unref (queried);
 }
 
+/* Returns whether the row for @file in @model is shown in the file list,
+ * or is adjacent to the shown rows.
+ */
+static gboolean
+file_is_in_visible_range (GtkFileChooserWidget *impl,
+                          GtkFileSystemModel   *model,
+                          GFile                *file)
+{
+  GtkFileChooserWidgetPrivate *priv = impl->priv;
+  GtkTreeModel *tree_model;
+  GtkTreePath *start, *end;
+  GtkTreeIter iter;
+  gboolean visible;
+
+  if (priv->browse_files_tree_view == NULL)
+    return FALSE;
+
+  tree_model = gtk_tree_view_get_model (GTK_TREE_VIEW (priv->browse_files_tree_view));
+  if (tree_model != GTK_TREE_MODEL (model))
+    return FALSE;
+
+  if (!_gtk_file_system_model_get_iter_for_file (model, &iter, file))
+    return FALSE;
+
+  if (gtk_tree_view_get_visible_range (GTK_TREE_VIEW (priv->browse_files_tree_view), &start, &end))
+    {
+      GtkTreePath *path;
+
+      gtk_tree_path_prev (start);
+      gtk_tree_path_next (end);
+      path = gtk_tree_model_get_path (tree_model, &iter);
+      visible = gtk_tree_path_compare (start, path) != 1 &&
+                gtk_tree_path_compare (path, end) != 1;
+      gtk_tree_path_free (path);
+      gtk_tree_path_free (start);
+      gtk_tree_path_free (end);
+    }
+  else
+    visible = TRUE;
+
+  return visible;
+}
+
+/* Thumbnails are decoded on a shared pool of worker threads. Jobs that
+ * were queued last are run first, since they belong to the rows that
+ * just became visible, and jobs for rows that are scrolled away are
+ * cancelled. The result is handed back to the model as a texture, so
+ * nothing has to be decoded while drawing.
+ */
+typedef struct {
+  GtkFileChooserWidget *impl;   /* only valid if not cancelled */
+  GtkFileSystemModel *model;
+  GFile *file;
+  char *path;
+  int size;
+  guint serial;
+  GCancellable *cancellable;
+  GdkTexture *texture;
+} ThumbnailJob;
+
+static void
+thumbnail_job_free (ThumbnailJob *job)
+{
+  g_object_unref (job->model);
+  g_object_unref (job->file);
+  g_free (job->path);
+  g_object_unref (job->cancellable);
+  g_clear_object (&job->texture);
+  g_slice_free (ThumbnailJob, job);
+}
+
+static gboolean
+thumbnail_job_done (gpointer data)
+{
+  ThumbnailJob *job = data;
+  GFileInfo *info;
+  GtkTreeIter iter;
+
+  if (g_cancellable_is_cancelled (job->cancellable))
+    goto out;
+
+  if (g_hash_table_lookup (job->impl->priv->thumbnail_jobs, job->file) == job)
+    g_hash_table_remove (job->impl->priv->thumbnail_jobs, job->file);
+
+  /* file was deleted */
+  if (!_gtk_file_system_model_get_iter_for_file (job->model, &iter, job->file))
+    goto out;
+
+  info = g_file_info_dup (_gtk_file_system_model_get_info (job->model, &iter));
+  g_file_info_remove_attribute (info, "filechooser::thumbnail-queued");
+  if (job->texture)
+    g_file_info_set_attribute_object (info, "filechooser::thumbnail", G_OBJECT (job->texture));
+  else
+    g_file_info_set_attribute_boolean (info, "filechooser::thumbnail-failed", TRUE);
+
+  _gtk_file_system_model_update_file (job->model, job->file, info);
+  g_object_unref (info);
+
+out:
+  thumbnail_job_free (job);
+
+  return G_SOURCE_REMOVE;
+}
+
+static void
+thumbnail_job_run (gpointer data,
+                   gpointer user_data)
+{
+  ThumbnailJob *job = data;
+  guint id;
+
+  if (!g_cancellable_is_cancelled (job->cancellable))
+    {
+      GdkPixbuf *pixbuf;
+
+      pixbuf = gdk_pixbuf_new_from_file_at_size (job->path, job->size, job->size, NULL);
+      if (pixbuf)
+        {
+          job->texture = gdk_texture_new_for_pixbuf (pixbuf);
+          g_object_unref (pixbuf);
+        }
+    }
+
+  id = g_idle_add (thumbnail_job_done, job);
+  g_source_set_name_by_id (id, "[gtk] thumbnail_job_done");
+}
+
+static gint
+thumbnail_job_compare (gconstpointer a,
+                       gconstpointer b,
+                       gpointer      user_data)
+{
+  const ThumbnailJob *job_a = a;
+  const ThumbnailJob *job_b = b;
+
+  /* newest first */
+  if (job_a->serial == job_b->serial)
+    return 0;
+  return job_a->serial > job_b->serial ? -1 : 1;
+}
+
+static void
+cancel_thumbnail_job (ThumbnailJob *job)
+{
+  GtkTreeIter iter;
+
+  /* Allow the row to queue it again when it gets shown */
+  if (_gtk_file_system_model_get_iter_for_file (job->model, &iter, job->file))
+    {
+      GFileInfo *info = _gtk_file_system_model_get_info (job->model, &iter);
+      g_file_info_remove_attribute (info, "filechooser::thumbnail-queued");
+    }
+
+  g_cancellable_cancel (job->cancellable);
+}
+
+static void
+queue_thumbnail_job (GtkFileChooserWidget *impl,
+                     GtkFileSystemModel   *model,
+                     GFile                *file,
+                     GFileInfo            *info)
+{
+  static GThreadPool *pool = NULL;
+  static guint serial = 0;
+  ThumbnailJob *job, *old;
+
+  if (pool == NULL)
+    {
+      pool = g_thread_pool_new (thumbnail_job_run, NULL,
+                                MAX (MIN (g_get_num_processors (), 8) - 1, 1),
+                                FALSE, NULL);
+      g_thread_pool_set_sort_function (pool, thumbnail_job_compare, NULL);
+    }
+
+  job = g_slice_new0 (ThumbnailJob);
+  job->impl = impl;
+  job->model = g_object_ref (model);
+  job->file = g_object_ref (file);
+  job->path = g_strdup (g_file_info_get_attribute_byte_string (info, G_FILE_ATTRIBUTE_THUMBNAIL_PATH));
+  job->size = ICON_SIZE * gtk_widget_get_scale_factor (GTK_WIDGET (impl));
+  job->serial = ++serial;
+  job->cancellable = g_cancellable_new ();
+
+  /* The same file can be shown by another model, e.g. in search mode */
+  old = g_hash_table_lookup (impl->priv->thumbnail_jobs, file);
+  if (old)
+    cancel_thumbnail_job (old);
+
+  g_file_info_set_attribute_boolean (info, "filechooser::thumbnail-queued", TRUE);
+  g_hash_table_replace (impl->priv->thumbnail_jobs, job->file, job);
+
+  g_thread_pool_push (pool, job, NULL);
+}
+
+static void
+cancel_thumbnail_jobs (GtkFileChooserWidget *impl)
+{
+  GtkFileChooserWidgetPrivate *priv = impl->priv;
+  GHashTableIter iter;
+  gpointer value;
+
+  g_hash_table_iter_init (&iter, priv->thumbnail_jobs);
+  while (g_hash_table_iter_next (&iter, NULL, &value))
+    {
+      cancel_thumbnail_job (value);
+      g_hash_table_iter_remove (&iter);
+    }
+}
+
+static void
+browse_files_scrolled_cb (GtkAdjustment        *adjustment,
+                          GtkFileChooserWidget *impl)
+{
+  GtkFileChooserWidgetPrivate *priv = impl->priv;
+  GHashTableIter iter;
+  gpointer value;
+
+  g_hash_table_iter_init (&iter, priv->thumbnail_jobs);
+  while (g_hash_table_iter_next (&iter, NULL, &value))
+    {
+      ThumbnailJob *job = value;
+
+      if (file_is_in_visible_range (impl, job->model, job->file))
+        continue;
+
+      cancel_thumbnail_job (job);
+      g_hash_table_iter_remove (&iter);
+    }
+}
+
 static gboolean
 file_system_model_set (GtkFileSystemModel *model,
                        GFile              *file,
@@ -4829,60 +5067,50 @@ file_system_model_set (GtkFileSystemModel *model,
         {
           if (g_file_info_has_attribute (info, G_FILE_ATTRIBUTE_STANDARD_ICON))
             {
-              g_value_take_object (value, _gtk_file_info_get_icon (info, ICON_SIZE, gtk_widget_get_scale_factor (GTK_WIDGET (impl))));
+              /* Thumbnails are decoded in the background, see MODEL_COL_THUMBNAIL */
+              g_value_take_object (value, _gtk_file_info_get_themed_icon (info));
             }
           else
             {
-              GtkTreeModel *tree_model;
-              GtkTreePath *start, *end;
-              GtkTreeIter iter;
-              gboolean visible;
-
-              if (priv->browse_files_tree_view == NULL ||
-                  g_file_info_has_attribute (info, "filechooser::queried"))
+              if (g_file_info_has_attribute (info, "filechooser::queried") ||
+                  !file_is_in_visible_range (impl, model, file))
                 return FALSE;
 
-              tree_model = gtk_tree_view_get_model (GTK_TREE_VIEW (priv->browse_files_tree_view));
-              if (tree_model != GTK_TREE_MODEL (model))
-                return FALSE;
-
-              if (!_gtk_file_system_model_get_iter_for_file (model, &iter, file))
-                g_assert_not_reached ();
-
-              if (gtk_tree_view_get_visible_range (GTK_TREE_VIEW (priv->browse_files_tree_view), &start, &end))
-                {
-                  GtkTreePath *path;
-
-                  gtk_tree_path_prev (start);
-                  gtk_tree_path_next (end);
-                  path = gtk_tree_model_get_path (tree_model, &iter);
-                  visible = gtk_tree_path_compare (start, path) != 1 &&
-                            gtk_tree_path_compare (path, end) != 1;
-                  gtk_tree_path_free (path);
-                  gtk_tree_path_free (start);
-                  gtk_tree_path_free (end);
-                }
-              else
-                visible = TRUE;
-              if (visible)
-                {
-                  g_file_info_set_attribute_boolean (info, "filechooser::queried", TRUE);
-                  g_file_query_info_async (file,
-                                           G_FILE_ATTRIBUTE_THUMBNAIL_PATH ","
-                                           G_FILE_ATTRIBUTE_THUMBNAILING_FAILED ","
-                                           G_FILE_ATTRIBUTE_STANDARD_ICON,
-                                           G_FILE_QUERY_INFO_NONE,
-                                           G_PRIORITY_DEFAULT,
-                                           _gtk_file_system_model_get_cancellable (model),
-                                           file_system_model_got_thumbnail,
-                                           model);
-                }
+              g_file_info_set_attribute_boolean (info, "filechooser::queried", TRUE);
+              g_file_query_info_async (file,
+                                       G_FILE_ATTRIBUTE_THUMBNAIL_PATH ","
+                                       G_FILE_ATTRIBUTE_THUMBNAILING_FAILED ","
+                                       G_FILE_ATTRIBUTE_STANDARD_ICON,
+                                       G_FILE_QUERY_INFO_NONE,
+                                       G_PRIORITY_DEFAULT,
+                                       _gtk_file_system_model_get_cancellable (model),
+                                       file_system_model_got_thumbnail,
+                                       model);
               return FALSE;
             }
         }
       else
         g_value_set_boxed (value, NULL);
       break;
+    case MODEL_COL_THUMBNAIL:
+      if (info == NULL)
+        g_value_set_object (value, NULL);
+      else if (g_file_info_has_attribute (info, "filechooser::thumbnail"))
+        g_value_set_object (value, g_file_info_get_attribute_object (info, "filechooser::thumbnail"));
+      else if (g_file_info_get_attribute_byte_string (info, G_FILE_ATTRIBUTE_THUMBNAIL_PATH) == NULL ||
+               g_file_info_has_attribute (info, "filechooser::thumbnail-failed"))
+        g_value_set_object (value, NULL);
+      else
+        {
+          /* Not cached, so we get asked again once the thumbnail is loaded
+           * or the row is scrolled back into view.
+           */
+          if (!g_file_info_has_attribute (info, "filechooser::thumbnail-queued") &&
+              file_is_in_visible_range (impl, model, file))
+            queue_thumbnail_job (impl, model, file, info);
+          return FALSE;
+        }
+      break;
     case MODEL_COL_SIZE:
       g_value_set_int64 (value, info ? g_file_info_get_size (info) : 0);
       break;
@@ -7745,16 +7973,41 @@ path_bar_clicked (GtkPathBar           *path_bar,
     g_object_set (impl, "show-hidden", TRUE, NULL);
 }
 
+static void
+icon_cell_data_func (GtkTreeViewColumn *tree_column,
+                     GtkCellRenderer   *cell,
+                     GtkTreeModel      *tree_model,
+                     GtkTreeIter       *iter,
+                     gpointer           data)
+{
+  GdkTexture *texture;
+  GIcon *icon;
+  gboolean sensitive;
+
+  gtk_tree_model_get (tree_model, iter,
+                      MODEL_COL_THUMBNAIL, &texture,
+                      MODEL_COL_ICON, &icon,
+                      MODEL_COL_IS_SENSITIVE, &sensitive,
+                      -1);
+
+  if (texture)
+    g_object_set (cell, "texture", texture, "sensitive", sensitive, NULL);
+  else
+    g_object_set (cell, "gicon", icon, "sensitive", sensitive, NULL);
+
+  g_clear_object (&texture);
+  g_clear_object (&icon);
+}
+
 static void
 update_cell_renderer_attributes (GtkFileChooserWidget *impl)
 {
   GtkFileChooserWidgetPrivate *priv = impl->priv;
 
-  gtk_tree_view_column_set_attributes (priv->list_name_column,
-                                       priv->list_pixbuf_renderer,
-                                       "gicon", MODEL_COL_ICON,
-                                       "sensitive", MODEL_COL_IS_SENSITIVE,
-                                       NULL);
+  gtk_tree_view_column_set_cell_data_func (priv->list_name_column,
+                                           priv->list_pixbuf_renderer,
+                                           icon_cell_data_func,
+                                           impl, NULL);
   gtk_tree_view_column_set_attributes (priv->list_name_column,
                                        priv->list_name_renderer,
                                        "text", MODEL_COL_NAME,
@@ -8442,6 +8695,8 @@ post_process_ui (GtkFileChooserWidget *impl)
   g_object_set_data (G_OBJECT (impl->priv->browse_files_tree_view), I_("GtkFileChooserWidget"), impl);
 
   /* Setup file list treeview */
+  g_signal_connect (gtk_scrollable_get_vadjustment (GTK_SCROLLABLE (impl->priv->browse_files_tree_view)),
+                    "value-changed", G_CALLBACK (browse_files_scrolled_cb), impl);
   selection = gtk_tree_view_get_selection (GTK_TREE_VIEW (impl->priv->browse_files_tree_view));
   gtk_tree_selection_set_select_function (selection,
                                           list_select_func,
@@ -8546,6 +8801,7 @@ gtk_file_chooser_widget_init (GtkFileChooserWidget *impl)
   priv->recent_manager = gtk_recent_manager_get_default ();
   priv->create_folders = TRUE;
   priv->auto_selecting_first_row = FALSE;
+  priv->thumbnail_jobs = g_hash_table_new (g_file_hash, (GEqualFunc) g_file_equal);
 
   /* Ensure GTK+ private types used by the template
    * definition before calling gtk_widget_init_template()
@@ -755,7 +755,6 @@ _gtk_file_info_get_icon (GFileInfo *info,
 			 int        icon_size,
                          int        scale)
 {
-  GIcon *icon;
   GdkPixbuf *pixbuf;
   const gchar *thumbnail_path;
 
@@ -771,6 +770,15 @@ _gtk_file_info_get_icon (GFileInfo *info,
         return G_ICON (pixbuf);
     }
 
+  return _gtk_file_info_get_themed_icon (info);
+}
+
+/* Like _gtk_file_info_get_icon(), but never loads the thumbnail */
+GIcon *
+_gtk_file_info_get_themed_icon (GFileInfo *info)
+{
+  GIcon *icon;
+
   icon = g_file_info_get_icon (info);
   if (icon)
     return g_object_ref (icon);
@@ -103,6 +103,7 @@ void                  _gtk_file_system_volume_unref            (GtkFileSystemVol
 GIcon *               _gtk_file_info_get_icon    (GFileInfo *info,
                                                   int        icon_size,
                                                   int        scale);
+GIcon *               _gtk_file_info_get_themed_icon (GFileInfo *info);
 
 gboolean	_gtk_file_info_consider_as_directory (GFileInfo *info);
 
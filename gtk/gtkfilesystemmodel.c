@@ -89,22 +89,13 @@
  *   following paragraph.  Variables/fields that represent visible rows are called “row”, or “r_*”, or simply
  *   “r”.
  *
- * Each FileModelNode has a node->row field which is the number of visible rows in the treeview, *before and
- * including* that node.  This means that node->row is 1-based, instead of 0-based --- this makes some code
- * simpler, believe it or not :)  This also means that when the calling GtkTreeView gives us a GtkTreePath, we
- * turn the 0-based treepath into a 1-based row for our purposes.  If a node is not visible, it will have the
- * same row number as its closest preceding visible node.
+ * To map between rows and indexes, the model keeps a Fenwick tree (a binary indexed tree) over the node->visible
+ * fields in model->rank.  It can count the visible nodes before an index, and find the index of the n-th visible node,
+ * in O(log n).  Whenever a node changes its visibility, the tree is updated in O(log n), and appending a node extends
+ * it in O(log n) as well.  Removing nodes or reordering the array invalidates the tree by setting model->n_rank to
+ * G_MAXUINT; it gets rebuilt in O(n) on the next lookup.  See node_rank_sum() and node_rank_find().
  *
- * We try to compute the node->row fields lazily.  A node is said to be “valid” if its node->row is accurate.
- * For this, the model keeps a model->n_nodes_valid field which is the count of valid nodes starting from the
- * beginning of the model->files array.  When a node changes its information, or when a node gets deleted, that
- * node and the following ones get invalidated by simply setting model->n_nodes_valid to the array index of the
- * node.  If the model happens to need a node’s row number and that node is in the model->files array after
- * model->n_nodes_valid, then the nodes get re-validated up to the sought node.  See node_validate_rows() for
- * this logic.
- *
- * You never access a node->row directly.  Instead, call node_get_tree_row().  That function will validate the nodes
- * up to the sought one if the node is not valid yet, and it will return a proper 0-based row.
+ * You never access model->rank directly.  Instead, call node_get_tree_row() to get the 0-based row of a node.
  *
  * Sorting
  * -------
@@ -115,6 +106,12 @@
  * freeze_updates()) during the intial population process.  When the model is
  * frozen, sorting will not happen.  The model will sort itself when the freeze
  * count goes back to zero, via corresponding calls to thaw_updates().
+ *
+ * Files that are added while the model is frozen are appended to the end of the
+ * array.  As long as nothing else requires a full sort, thawing only sorts those
+ * new files and merges them into the already sorted part.  Files that are added
+ * or changed while the model is not frozen are moved to their position with a
+ * binary search, see gtk_file_system_model_sort_node().
  */
 
 /*** DEFINES ***/
@@ -135,9 +132,7 @@ struct _FileModelNode
   GFile *               file;           /* file represented by this node or NULL for editable */
   GFileInfo *           info;           /* info for this file or NULL if unknown */
 
-  guint                 row;            /* if valid (see model->n_valid_indexes), visible nodes before and including
-					 * this one - see the "Structure" comment above.
-					 */
+  guint                 row;            /* scratch space used while sorting */
 
   guint                 visible :1;     /* if the file is currently visible */
   guint                 filtered_out :1;/* if the file is currently filtered out (i.e. it didn't pass the filters) */
@@ -158,7 +153,9 @@ struct _GtkFileSystemModel
   GCancellable *        cancellable;    /* cancellable in use for all operations - cancelled on dispose */
   GArray *              files;          /* array of FileModelNode containing all our files */
   gsize                 node_size;	/* Size of a FileModelNode structure once its ->values field has n_columns */
-  guint                 n_nodes_valid;  /* count of valid nodes (i.e. those whose node->row is accurate) */
+  guint *               rank;           /* Fenwick tree of visible nodes - see the "Structure" comment above */
+  guint                 rank_size;      /* allocated size of rank */
+  guint                 n_rank;         /* number of nodes covered by rank, or G_MAXUINT if invalid */
   GHashTable *          file_lookup;    /* mapping of GFile => array index in model->files
 					 * This hash table doesn't always have the same number of entries as the files array;
 					 * it can get cleared completely when we resort.
@@ -239,53 +236,135 @@ static void remove_file (GtkFileSystemModel *model,
 /* Get an index within the model->files array of nodes, given a FileModelNode* */
 #define node_index(_model, _node) (((gchar *) (_node) - (_model)->files->data) / (_model)->node_size)
 
-/* @up_to_index: smallest model->files array index that will be valid after this call
- * @up_to_row: smallest node->row that will be valid after this call
- *
- * If you want to validate up to an index or up to a row, specify the index or
- * the row you want and specify G_MAXUINT for the other argument.  Pass
- * G_MAXUINT for both arguments for “validate everything”.
- */
+#define LOWBIT(i) ((i) & (~(i) + 1))
+
 static void
-node_validate_rows (GtkFileSystemModel *model, guint up_to_index, guint up_to_row)
+node_rank_invalidate (GtkFileSystemModel *model)
 {
-  guint i, row;
+  model->n_rank = G_MAXUINT;
+}
 
-  if (model->files->len == 0)
+static void
+node_rank_ensure_size (GtkFileSystemModel *model, guint n)
+{
+  if (model->rank_size >= n + 1)
     return;
 
-  up_to_index = MIN (up_to_index, model->files->len - 1);
+  model->rank_size = MAX (n + 1, 2 * model->rank_size);
+  model->rank = g_renew (guint, model->rank, model->rank_size);
+}
 
-  i = model->n_nodes_valid;
-  if (i != 0)
-    row = get_node (model, i - 1)->row;
-  else
-    row = 0;
+static void
+node_rank_rebuild (GtkFileSystemModel *model)
+{
+  guint i, j, n;
+
+  n = model->files->len;
+  node_rank_ensure_size (model, n);
+  memset (model->rank, 0, sizeof (guint) * (n + 1));
 
-  while (i <= up_to_index && row <= up_to_row)
+  for (i = 1; i <= n; i++)
     {
-      FileModelNode *node = get_node (model, i);
-      if (node->visible)
-        row++;
-      node->row = row;
-      i++;
+      if (get_node (model, i - 1)->visible)
+        model->rank[i]++;
+
+      j = i + LOWBIT (i);
+      if (j <= n)
+        model->rank[j] += model->rank[i];
     }
-  model->n_nodes_valid = i;
+
+  model->n_rank = n;
 }
 
 static guint
-node_get_tree_row (GtkFileSystemModel *model, guint index)
+node_rank_prefix (GtkFileSystemModel *model, guint n)
+{
+  guint sum = 0;
+
+  for (; n > 0; n -= LOWBIT (n))
+    sum += model->rank[n];
+
+  return sum;
+}
+
+/* Returns the number of visible nodes with an index smaller than @n */
+static guint
+node_rank_sum (GtkFileSystemModel *model, guint n)
+{
+  if (model->n_rank != model->files->len)
+    node_rank_rebuild (model);
+
+  return node_rank_prefix (model, n);
+}
+
+/* Returns the index of the visible node at @row, or G_MAXUINT */
+static guint
+node_rank_find (GtkFileSystemModel *model, guint row)
+{
+  guint pos, step, remaining;
+
+  if (model->n_rank != model->files->len)
+    node_rank_rebuild (model);
+
+  for (step = 1; step * 2 <= model->n_rank; step *= 2)
+    ;
+
+  /* Find the longest prefix that has at most @row visible nodes;
+   * the node right after it is the one we look for.
+   */
+  pos = 0;
+  remaining = row + 1;
+  for (; step > 0; step /= 2)
+    {
+      if (pos + step <= model->n_rank && model->rank[pos + step] < remaining)
+        {
+          pos += step;
+          remaining -= model->rank[pos];
+        }
+    }
+
+  if (pos >= model->n_rank)
+    return G_MAXUINT;
+
+  return pos;
+}
+
+static void
+node_rank_update (GtkFileSystemModel *model, guint id, int delta)
 {
-  if (model->n_nodes_valid <= index)
-    node_validate_rows (model, index, G_MAXUINT);
+  guint i;
+
+  if (model->n_rank != model->files->len)
+    return;
+
+  for (i = id + 1; i <= model->n_rank; i += LOWBIT (i))
+    model->rank[i] += delta;
+}
+
+/* Call after appending an invisible node to model->files */
+static void
+node_rank_append (GtkFileSystemModel *model)
+{
+  guint n = model->files->len;
+
+  if (model->n_rank != n - 1)
+    {
+      node_rank_invalidate (model);
+      return;
+    }
 
-  return get_node (model, index)->row - 1;
+  node_rank_ensure_size (model, n);
+  model->rank[n] = node_rank_prefix (model, n - 1) - node_rank_prefix (model, n - LOWBIT (n));
+  model->n_rank = n;
 }
 
-static void 
-node_invalidate_index (GtkFileSystemModel *model, guint id)
+/* Returns the 0-based row of the node at @index. Invisible nodes
+ * get the row of the closest visible node before them.
+ */
+static guint
+node_get_tree_row (GtkFileSystemModel *model, guint index)
 {
-  model->n_nodes_valid = MIN (model->n_nodes_valid, id);
+  return node_rank_sum (model, index + 1) - 1;
 }
 
 static GtkTreePath *
@@ -355,7 +434,7 @@ node_set_visible_and_filtered_out (GtkFileSystemModel *model, guint id, gboolean
   if (visible)
     {
       node->visible = TRUE;
-      node_invalidate_index (model, id);
+      node_rank_update (model, id, 1);
       emit_row_inserted_for_node (model, id);
     }
   else
@@ -366,7 +445,7 @@ node_set_visible_and_filtered_out (GtkFileSystemModel *model, guint id, gboolean
       g_assert (row < model->files->len);
 
       node->visible = FALSE;
-      node_invalidate_index (model, id);
+      node_rank_update (model, id, -1);
       emit_row_deleted_for_row (model, row);
     }
 }
@@ -509,14 +588,6 @@ gtk_file_system_model_get_column_type (GtkTreeModel *tree_model,
   return model->column_types[i];
 }
 
-static int
-compare_indices (gconstpointer key, gconstpointer _node)
-{
-  const FileModelNode *node = _node;
-
-  return GPOINTER_TO_UINT (key) - node->row;
-}
-
 static gboolean
 gtk_file_system_model_iter_nth_child (GtkTreeModel *tree_model,
 				      GtkTreeIter  *iter,
@@ -524,49 +595,16 @@ gtk_file_system_model_iter_nth_child (GtkTreeModel *tree_model,
 				      gint          n)
 {
   GtkFileSystemModel *model = GTK_FILE_SYSTEM_MODEL (tree_model);
-  char *node;
   guint id;
-  guint row_to_find;
 
   g_return_val_if_fail (n >= 0, FALSE);
 
   if (parent != NULL)
     return FALSE;
 
-  row_to_find = n + 1; /* plus one as our node->row numbers are 1-based; see the "Structure" comment at the beginning */
-
-  if (model->n_nodes_valid > 0 &&
-      get_node (model, model->n_nodes_valid - 1)->row >= row_to_find)
-    {
-      /* Fast path - the nodes are valid up to the sought one.
-       *
-       * First, find a node with the sought row number...*/
-
-      node = bsearch (GUINT_TO_POINTER (row_to_find), 
-                      model->files->data,
-                      model->n_nodes_valid,
-                      model->node_size,
-                      compare_indices);
-      if (node == NULL)
-        return FALSE;
-
-      /* ... Second, back up until we find the first visible node with that row number */
-
-      id = node_index (model, node);
-      while (!get_node (model, id)->visible)
-        id--;
-
-      g_assert (get_node (model, id)->row == row_to_find);
-    }
-  else
-    {
-      /* Slow path - the nodes need to be validated up to the sought one */
-
-      node_validate_rows (model, G_MAXUINT, n); /* note that this is really "n", not row_to_find - see node_validate_rows() */
-      id = model->n_nodes_valid - 1;
-      if (model->n_nodes_valid == 0 || get_node (model, id)->row != row_to_find)
-        return FALSE;
-    }
+  id = node_rank_find (model, n);
+  if (id == G_MAXUINT)
+    return FALSE;
 
   ITER_INIT_FROM_INDEX (model, iter, id);
   return TRUE;
@@ -668,7 +706,7 @@ gtk_file_system_model_iter_n_children (GtkTreeModel *tree_model,
   if (iter)
     return 0;
 
-  return node_get_tree_row (model, model->files->len - 1) + 1;
+  return node_rank_sum (model, model->files->len);
 }
 
 static gboolean
@@ -783,16 +821,24 @@ gtk_file_system_model_sort (GtkFileSystemModel *model)
       guint i;
       guint r, n_visible_rows;
 
-      node_validate_rows (model, G_MAXUINT, G_MAXUINT);
-      n_visible_rows = node_get_tree_row (model, model->files->len - 1) + 1;
-      model->n_nodes_valid = 0;
+      /* Remember the old rows, 1-based, so we can compute the new order */
+      r = 0;
+      for (i = 0; i < model->files->len; i++)
+        {
+          FileModelNode *node = get_node (model, i);
+          if (node->visible)
+            r++;
+          node->row = r;
+        }
+      n_visible_rows = r;
+
+      node_rank_invalidate (model);
       g_hash_table_remove_all (model->file_lookup);
       g_qsort_with_data (get_node (model, 1), /* start at index 1; don't sort the editable row */
                          model->files->len - 1,
                          model->node_size,
                          compare_array_element,
                          &data);
-      g_assert (model->n_nodes_valid == 0);
       g_assert (g_hash_table_size (model->file_lookup) == 0);
       if (n_visible_rows)
         {
@@ -803,14 +849,10 @@ gtk_file_system_model_sort (GtkFileSystemModel *model)
             {
               FileModelNode *node = get_node (model, i);
               if (!node->visible)
-                {
-                  node->row = r;
-                  continue;
-                }
+                continue;
 
               new_order[r] = node->row - 1;
               r++;
-              node->row = r;
             }
           g_assert (r == n_visible_rows);
           path = gtk_tree_path_new ();
@@ -826,11 +868,170 @@ gtk_file_system_model_sort (GtkFileSystemModel *model)
   model->sort_on_thaw = FALSE;
 }
 
+/* Sorts the nodes that were added while the model was frozen, which are
+ * at the end of the array, and merges them into the sorted nodes before
+ * them. The new nodes are not visible yet, so the visible rows keep their
+ * order and no signals need to be emitted.
+ */
 static void
-gtk_file_system_model_sort_node (GtkFileSystemModel *model, guint node)
+gtk_file_system_model_merge_added (GtkFileSystemModel *model)
 {
-  /* FIXME: improve */
-  gtk_file_system_model_sort (model);
+  SortData data;
+  guint first, start, i, j, n, lo, hi;
+  gchar *merged, *out;
+
+  if (!sort_data_init (&data, model))
+    return;
+
+  n = model->files->len;
+  for (first = n; first > 1 && get_node (model, first - 1)->frozen_add; first--)
+    ;
+
+  if (first == n)
+    return;
+
+  g_qsort_with_data (get_node (model, first),
+                     n - first,
+                     model->node_size,
+                     compare_array_element,
+                     &data);
+
+  /* Nodes before the first one that sorts after the smallest new node
+   * stay where they are.
+   */
+  lo = 1;
+  hi = first;
+  while (lo < hi)
+    {
+      guint mid = (lo + hi) / 2;
+
+      if (compare_array_element (get_node (model, mid), get_node (model, first), &data) <= 0)
+        lo = mid + 1;
+      else
+        hi = mid;
+    }
+  start = lo;
+
+  if (start < first)
+    {
+      merged = g_malloc ((n - start) * model->node_size);
+      out = merged;
+      i = start;
+      j = first;
+      while (i < first || j < n)
+        {
+          guint next;
+
+          if (j >= n ||
+              (i < first &&
+               compare_array_element (get_node (model, i), get_node (model, j), &data) <= 0))
+            next = i++;
+          else
+            next = j++;
+
+          memcpy (out, get_node (model, next), model->node_size);
+          out += model->node_size;
+        }
+
+      memcpy (get_node (model, start), merged, (n - start) * model->node_size);
+      g_free (merged);
+    }
+
+  node_rank_invalidate (model);
+  g_hash_table_remove_all (model->file_lookup);
+}
+
+/* Moves the node at @id to its sorted position, assuming all other nodes
+ * are sorted, and returns its new index.
+ */
+static guint
+gtk_file_system_model_sort_node (GtkFileSystemModel *model, guint id)
+{
+  SortData data;
+  FileModelNode *node;
+  gpointer tmp;
+  guint lo, hi, pos;
+  guint old_row, new_row, n_visible_rows;
+  gboolean was_visible;
+
+  if (model->frozen)
+    {
+      /* Added nodes get merged in when thawing */
+      if (!get_node (model, id)->frozen_add)
+        model->sort_on_thaw = TRUE;
+      return id;
+    }
+
+  if (!sort_data_init (&data, model))
+    return id;
+
+  node = get_node (model, id);
+
+  if ((id <= 1 || compare_array_element (get_node (model, id - 1), node, &data) <= 0) &&
+      (id + 1 >= model->files->len || compare_array_element (node, get_node (model, id + 1), &data) <= 0))
+    return id;
+
+  /* Binary search among the other nodes, as if @node had been removed */
+  lo = 1;
+  hi = model->files->len - 1;
+  while (lo < hi)
+    {
+      guint mid = (lo + hi) / 2;
+      guint other = mid < id ? mid : mid + 1;
+
+      if (compare_array_element (get_node (model, other), node, &data) <= 0)
+        lo = mid + 1;
+      else
+        hi = mid;
+    }
+  pos = lo;
+
+  was_visible = node->visible;
+  old_row = node_get_tree_row (model, id);
+  n_visible_rows = node_rank_sum (model, model->files->len);
+
+  tmp = g_alloca (model->node_size);
+  memcpy (tmp, node, model->node_size);
+  if (pos < id)
+    memmove (get_node (model, pos + 1), get_node (model, pos), (id - pos) * model->node_size);
+  else
+    memmove (get_node (model, id), get_node (model, id + 1), (pos - id) * model->node_size);
+  memcpy (get_node (model, pos), tmp, model->node_size);
+
+  node_rank_invalidate (model);
+  g_hash_table_remove_all (model->file_lookup);
+
+  if (was_visible)
+    {
+      new_row = node_get_tree_row (model, pos);
+
+      if (new_row != old_row)
+        {
+          GtkTreePath *path;
+          int *new_order;
+          guint r;
+
+          new_order = g_new (int, n_visible_rows);
+          for (r = 0; r < n_visible_rows; r++)
+            {
+              if (r == new_row)
+                new_order[r] = old_row;
+              else if (new_row < old_row && r > new_row && r <= old_row)
+                new_order[r] = r - 1;
+              else if (new_row > old_row && r >= old_row && r < new_row)
+                new_order[r] = r + 1;
+              else
+                new_order[r] = r;
+            }
+
+          path = gtk_tree_path_new ();
+          gtk_tree_model_rows_reordered (GTK_TREE_MODEL (model), path, NULL, new_order);
+          gtk_tree_path_free (path);
+          g_free (new_order);
+        }
+    }
+
+  return pos;
 }
 
 static gboolean
@@ -1058,6 +1259,7 @@ gtk_file_system_model_finalize (GObject *object)
 	  g_value_unset (&node->values[v]);
     }
   g_array_free (model->files, TRUE);
+  g_free (model->rank);
 
   g_object_unref (model->cancellable);
   g_free (model->attributes);
@@ -1108,6 +1310,7 @@ _gtk_file_system_model_init (GtkFileSystemModel *model)
 
   model->file_lookup = g_hash_table_new (g_file_hash, (GEqualFunc) g_file_equal);
   model->cancellable = g_cancellable_new ();
+  model->n_rank = G_MAXUINT;
 }
 
 /*** API ***/
@@ -1838,6 +2041,7 @@ add_file (GtkFileSystemModel *model,
 	  GFileInfo          *info)
 {
   FileModelNode *node;
+  guint id;
   
   g_return_if_fail (GTK_IS_FILE_SYSTEM_MODEL (model));
   g_return_if_fail (G_IS_FILE (file));
@@ -1851,11 +2055,15 @@ add_file (GtkFileSystemModel *model,
 
   g_array_append_vals (model->files, node, 1);
   g_slice_free1 (model->node_size, node);
+  node_rank_append (model);
 
-  if (!model->frozen)
-    node_compute_visibility_and_filters (model, model->files->len -1);
+  /* Find the place of the node before it becomes visible,
+   * so that it gets inserted in the right row.
+   */
+  id = gtk_file_system_model_sort_node (model, model->files->len - 1);
 
-  gtk_file_system_model_sort_node (model, model->files->len -1);
+  if (!model->frozen)
+    node_compute_visibility_and_filters (model, id);
 }
 
 /**
@@ -1887,7 +2095,7 @@ remove_file (GtkFileSystemModel *model,
   was_visible = node->visible;
   row = node_get_tree_row (model, id);
 
-  node_invalidate_index (model, id);
+  node_rank_invalidate (model);
 
   g_hash_table_remove (model->file_lookup, file);
   g_object_unref (node->file);
@@ -2039,6 +2247,8 @@ thaw_updates (GtkFileSystemModel *model)
     gtk_file_system_model_refilter_all (model);
   if (model->sort_on_thaw)
     gtk_file_system_model_sort (model);
+  else if (stuff_added)
+    gtk_file_system_model_merge_added (model);
   if (stuff_added)
     {
       guint i;
@@ -35,13 +35,30 @@
  * listmodel.
  * It hides some elements from the other model according to
  * criteria given by a #GtkFilterListModelFilterFunc.
+ *
+ * Filtering large models can take a long time. To avoid blocking the
+ * main loop, #GtkFilterListModel can filter incrementally, see
+ * gtk_filter_list_model_set_incremental().
  */
 
+/* Time spent filtering per main loop iteration when filtering
+ * incrementally, in microseconds */
+#define FILTER_TIME_SLICE 2000
+/* Number of items filtered between checks of the time */
+#define FILTER_STEPS_PER_CHECK 64
+/* Number of items filtered at once with a thread-safe filter */
+#define FILTER_BATCH_SIZE 4096
+/* Minimum number of items per thread for a thread-safe filter */
+#define FILTER_ITEMS_PER_WORKER 512
+
 enum {
   PROP_0,
   PROP_HAS_FILTER,
+  PROP_INCREMENTAL,
   PROP_ITEM_TYPE,
   PROP_MODEL,
+  PROP_PENDING,
+  PROP_THREAD_SAFE,
   NUM_PROPERTIES
 };
 
@@ -70,6 +87,11 @@ struct _GtkFilterListModel
   GDestroyNotify user_destroy;
 
   GtkRbTree *items; /* NULL if filter_func == NULL */
+
+  guint incremental : 1;
+  guint thread_safe : 1;
+  guint pending_position; /* first item not filtered yet while filter_cb is set */
+  guint filter_cb; /* idle source of the incremental filter */
 };
 
 struct _GtkFilterListModelClass
@@ -237,6 +259,123 @@ gtk_filter_list_model_run_filter (GtkFilterListModel *self,
   return visible;
 }
 
+typedef struct {
+  GtkFilterListModelFilterFunc filter_func;
+  gpointer user_data;
+  gpointer *items;
+  guint8 *visible;
+  int n_items;
+  int next;
+  int n_workers;
+  GMutex mutex;
+  GCond cond;
+} GtkFilterJob;
+
+/* The filter function was declared thread-safe and the main thread
+ * keeps the items alive, so this can run on any thread.
+ */
+static void
+gtk_filter_job_run (GtkFilterJob *job)
+{
+  int i, end;
+
+  while ((i = g_atomic_int_add (&job->next, FILTER_STEPS_PER_CHECK)) < job->n_items)
+    {
+      end = MIN (i + FILTER_STEPS_PER_CHECK, job->n_items);
+      for (; i < end; i++)
+        job->visible[i] = job->filter_func (job->items[i], job->user_data) ? 1 : 0;
+    }
+}
+
+static void
+gtk_filter_job_worker (gpointer data,
+                       gpointer user_data)
+{
+  GtkFilterJob *job = data;
+
+  gtk_filter_job_run (job);
+
+  g_mutex_lock (&job->mutex);
+  job->n_workers--;
+  if (job->n_workers == 0)
+    g_cond_signal (&job->cond);
+  g_mutex_unlock (&job->mutex);
+}
+
+/* Runs the filter on up to FILTER_BATCH_SIZE of the @n_items items
+ * starting at @position, spread over a thread pool if there are enough
+ * of them. Returns the number of results stored in @visible.
+ */
+static guint
+gtk_filter_list_model_run_filter_parallel (GtkFilterListModel *self,
+                                           guint               position,
+                                           guint               n_items,
+                                           gpointer           *items,
+                                           guint8             *visible)
+{
+  static GThreadPool *pool = NULL;
+  static int max_workers = 0;
+  GtkFilterJob job;
+  guint i, n;
+  int w;
+
+  n = MIN (n_items, FILTER_BATCH_SIZE);
+
+  /* GListModel isn't thread-safe, so get the items here */
+  for (i = 0; i < n; i++)
+    items[i] = g_list_model_get_item (self->model, position + i);
+
+  job.filter_func = self->filter_func;
+  job.user_data = self->user_data;
+  job.items = items;
+  job.visible = visible;
+  job.n_items = n;
+  job.next = 0;
+  job.n_workers = 0;
+
+  if (max_workers == 0)
+    max_workers = MIN (g_get_num_processors (), 8) - 1;
+
+  if (max_workers > 0 && pool == NULL)
+    {
+      pool = g_thread_pool_new (gtk_filter_job_worker, NULL, max_workers, FALSE, NULL);
+      if (pool == NULL)
+        max_workers = -1;
+    }
+
+  if (max_workers > 0)
+    job.n_workers = MIN (max_workers, n / FILTER_ITEMS_PER_WORKER);
+
+  if (job.n_workers > 0)
+    {
+      g_mutex_init (&job.mutex);
+      g_cond_init (&job.cond);
+
+      for (w = 0; w < job.n_workers; w++)
+        g_thread_pool_push (pool, &job, NULL);
+
+      /* Help out instead of waiting */
+      gtk_filter_job_run (&job);
+
+      g_mutex_lock (&job.mutex);
+      while (job.n_workers > 0)
+        g_cond_wait (&job.cond, &job.mutex);
+      g_mutex_unlock (&job.mutex);
+
+      g_mutex_clear (&job.mutex);
+      g_cond_clear (&job.cond);
+    }
+  else
+    {
+      gtk_filter_job_run (&job);
+    }
+
+  for (i = 0; i < n; i++)
+    g_object_unref (items[i]);
+
+  return n;
+}
+
 static guint
 gtk_filter_list_model_add_items (GtkFilterListModel *self,
                                  FilterNode         *after,
@@ -244,21 +383,190 @@ gtk_filter_list_model_add_items (GtkFilterListModel *self,
                                  guint               n_items)
 {
   FilterNode *node;
-  guint i, n_visible;
+  guint i, j, n_batch, n_visible;
 
   n_visible = 0;
-  
+  node = gtk_rb_tree_insert_many_before (self->items, after, n_items);
+
+  if (self->thread_safe && n_items >= 2 * FILTER_ITEMS_PER_WORKER)
+    {
+      gpointer *batch_items = g_new (gpointer, FILTER_BATCH_SIZE);
+      guint8 *batch = g_new (guint8, FILTER_BATCH_SIZE);
+
+      for (i = 0; i < n_items; i += n_batch)
+        {
+          n_batch = gtk_filter_list_model_run_filter_parallel (self, position + i, n_items - i, batch_items, batch);
+          for (j = 0; j < n_batch; j++)
+            {
+              node->visible = batch[j];
+              if (node->visible)
+                n_visible++;
+              gtk_rb_tree_node_mark_dirty (node);
+              node = gtk_rb_tree_node_get_next (node);
+            }
+        }
+
+      g_free (batch_items);
+      g_free (batch);
+
+      return n_visible;
+    }
+
   for (i = 0; i < n_items; i++)
     {
-      node = gtk_rb_tree_insert_before (self->items, after);
       node->visible = gtk_filter_list_model_run_filter (self, position + i);
       if (node->visible)
         n_visible++;
+      gtk_rb_tree_node_mark_dirty (node);
+      node = gtk_rb_tree_node_get_next (node);
     }
 
   return n_visible;
 }
 
+/* Filters the items from *@position on, until done or until @end_time
+ * has passed, 0 means never. Updates @position to the first item that
+ * has not been filtered.
+ */
+static void
+gtk_filter_list_model_filter_from (GtkFilterListModel *self,
+                                   guint              *position,
+                                   gint64              end_time)
+{
+  FilterNode *node;
+  guint i, j, n_batch, filter_start, first_change, last_change;
+  guint n_is_visible, n_was_visible;
+  gpointer *batch_items = NULL;
+  guint8 *batch = NULL;
+  gboolean visible;
+
+  i = *position;
+  node = gtk_filter_list_model_get_nth (self->items, i, &filter_start);
+
+  if (node != NULL && self->thread_safe)
+    {
+      batch_items = g_new (gpointer, FILTER_BATCH_SIZE);
+      batch = g_new (guint8, FILTER_BATCH_SIZE);
+    }
+
+  first_change = G_MAXUINT;
+  last_change = 0;
+  n_is_visible = 0;
+  n_was_visible = 0;
+  while (node != NULL)
+    {
+      if (batch)
+        n_batch = gtk_filter_list_model_run_filter_parallel (self, i,
+                                                             g_list_model_get_n_items (self->model) - i,
+                                                             batch_items, batch);
+      else
+        n_batch = FILTER_STEPS_PER_CHECK;
+
+      for (j = 0; j < n_batch && node != NULL; j++)
+        {
+          if (batch)
+            visible = batch[j];
+          else
+            visible = gtk_filter_list_model_run_filter (self, i);
+
+          if (visible == node->visible)
+            {
+              if (visible)
+                {
+                  n_is_visible++;
+                  n_was_visible++;
+                }
+            }
+          else
+            {
+              node->visible = visible;
+              gtk_rb_tree_node_mark_dirty (node);
+              first_change = MIN (n_is_visible, first_change);
+              if (visible)
+                n_is_visible++;
+              else
+                n_was_visible++;
+              last_change = MAX (n_is_visible, last_change);
+            }
+
+          node = gtk_rb_tree_node_get_next (node);
+          i++;
+        }
+
+      if (end_time != 0 && g_get_monotonic_time () >= end_time)
+        break;
+    }
+
+  g_free (batch_items);
+  g_free (batch);
+
+  *position = i;
+
+  if (first_change <= last_change)
+    {
+      g_list_model_items_changed (G_LIST_MODEL (self),
+                                  filter_start + first_change,
+                                  last_change - first_change + n_was_visible - n_is_visible,
+                                  last_change - first_change);
+    }
+}
+
+static void
+gtk_filter_list_model_stop_filtering (GtkFilterListModel *self)
+{
+  if (self->filter_cb == 0)
+    return;
+
+  g_source_remove (self->filter_cb);
+  self->filter_cb = 0;
+
+  g_object_notify_by_pspec (G_OBJECT (self), properties[PROP_PENDING]);
+}
+
+static gboolean
+gtk_filter_list_model_filter_cb (gpointer data)
+{
+  GtkFilterListModel *self = data;
+  guint filter_cb = self->filter_cb;
+
+  gtk_filter_list_model_filter_from (self,
+                                     &self->pending_position,
+                                     g_get_monotonic_time () + FILTER_TIME_SLICE);
+
+  /* stopped from an items-changed handler */
+  if (self->filter_cb != filter_cb)
+    return G_SOURCE_REMOVE;
+
+  if (self->pending_position >= g_list_model_get_n_items (self->model))
+    {
+      self->filter_cb = 0;
+      g_object_notify_by_pspec (G_OBJECT (self), properties[PROP_PENDING]);
+      return G_SOURCE_REMOVE;
+    }
+
+  g_object_notify_by_pspec (G_OBJECT (self), properties[PROP_PENDING]);
+
+  return G_SOURCE_CONTINUE;
+}
+
+/* Items that haven't been filtered yet keep their visibility */
+static void
+gtk_filter_list_model_start_filtering (GtkFilterListModel *self,
+                                       guint               position)
+{
+  if (self->filter_cb && self->pending_position <= position)
+    return;
+
+  self->pending_position = position;
+  if (self->filter_cb == 0)
+    {
+      self->filter_cb = g_idle_add (gtk_filter_list_model_filter_cb, self);
+      g_source_set_name_by_id (self->filter_cb, "[gtk] gtk_filter_list_model_filter_cb");
+    }
+
+  g_object_notify_by_pspec (G_OBJECT (self), properties[PROP_PENDING]);
+}
+
 static void
 gtk_filter_list_model_items_changed_cb (GListModel         *model,
                                         guint               position,
@@ -278,17 +586,30 @@ gtk_filter_list_model_items_changed_cb (GListModel         *model,
   node = gtk_filter_list_model_get_nth (self->items, position, &filter_position);
 
   filter_removed = 0;
-  for (i = 0; i < removed; i++)
+  if (removed)
     {
-      FilterNode *next = gtk_rb_tree_node_get_next (node);
-      if (node->visible)
-        filter_removed++;
-      gtk_rb_tree_remove (self->items, node);
-      node = next;
+      FilterNode *first = node;
+
+      for (i = 0; i < removed; i++)
+        {
+          if (node->visible)
+            filter_removed++;
+          node = gtk_rb_tree_node_get_next (node);
+        }
+      gtk_rb_tree_remove_many (self->items, first, removed);
     }
 
   filter_added = gtk_filter_list_model_add_items (self, node, position, added);
 
+  /* The new items were filtered, the ones after them might not be */
+  if (self->filter_cb && position < self->pending_position)
+    {
+      if (position + removed <= self->pending_position)
+        self->pending_position = self->pending_position - removed + added;
+      else
+        self->pending_position = position + added;
+    }
+
   if (filter_removed > 0 || filter_added > 0)
     g_list_model_items_changed (G_LIST_MODEL (self), filter_position, filter_removed, filter_added);
 }
@@ -303,10 +624,18 @@ gtk_filter_list_model_set_property (GObject      *object,
 
   switch (prop_id)
     {
+    case PROP_INCREMENTAL:
+      gtk_filter_list_model_set_incremental (self, g_value_get_boolean (value));
+      break;
+
     case PROP_ITEM_TYPE:
       self->item_type = g_value_get_gtype (value);
       break;
 
+    case PROP_THREAD_SAFE:
+      gtk_filter_list_model_set_thread_safe (self, g_value_get_boolean (value));
+      break;
+
     case PROP_MODEL:
       gtk_filter_list_model_set_model (self, g_value_get_object (value));
       break;
@@ -331,6 +660,18 @@ gtk_filter_list_model_get_property (GObject     *object,
       g_value_set_boolean (value, self->items != NULL);
       break;
 
+    case PROP_INCREMENTAL:
+      g_value_set_boolean (value, self->incremental);
+      break;
+
+    case PROP_PENDING:
+      g_value_set_uint (value, gtk_filter_list_model_get_pending (self));
+      break;
+
+    case PROP_THREAD_SAFE:
+      g_value_set_boolean (value, self->thread_safe);
+      break;
+
     case PROP_ITEM_TYPE:
       g_value_set_gtype (value, self->item_type);
       break;
@@ -351,6 +692,7 @@ gtk_filter_list_model_clear_model (GtkFilterListModel *self)
   if (self->model == NULL)
     return;
 
+  gtk_filter_list_model_stop_filtering (self);
   g_signal_handlers_disconnect_by_func (self->model, gtk_filter_list_model_items_changed_cb, self);
   g_clear_object (&self->model);
   if (self->items)
@@ -394,6 +736,18 @@ gtk_filter_list_model_class_init (GtkFilterListModelClass *class)
                             FALSE,
                             GTK_PARAM_READABLE | G_PARAM_EXPLICIT_NOTIFY);
 
+  /**
+   * GtkFilterListModel:incremental:
+   *
+   * If the model should filter items incrementally
+   */
+  properties[PROP_INCREMENTAL] =
+      g_param_spec_boolean ("incremental",
+                            P_("Incremental"),
+                            P_("Filter items incrementally"),
+                            FALSE,
+                            GTK_PARAM_READWRITE | G_PARAM_EXPLICIT_NOTIFY);
+
   /**
    * GtkFilterListModel:item-type:
    *
@@ -418,6 +772,31 @@ gtk_filter_list_model_class_init (GtkFilterListModelClass *class)
                            G_TYPE_LIST_MODEL,
                            GTK_PARAM_READWRITE | G_PARAM_CONSTRUCT_ONLY | G_PARAM_EXPLICIT_NOTIFY);
 
+  /**
+   * GtkFilterListModel:pending:
+   *
+   * Number of items not yet filtered, see
+   * gtk_filter_list_model_get_pending()
+   */
+  properties[PROP_PENDING] =
+      g_param_spec_uint ("pending",
+                         P_("Pending"),
+                         P_("Number of items not yet filtered"),
+                         0, G_MAXUINT, 0,
+                         GTK_PARAM_READABLE | G_PARAM_EXPLICIT_NOTIFY);
+
+  /**
+   * GtkFilterListModel:thread-safe:
+   *
+   * If the filter function may be called from other threads
+   */
+  properties[PROP_THREAD_SAFE] =
+      g_param_spec_boolean ("thread-safe",
+                            P_("Thread safe"),
+                            P_("If the filter function may be called from other threads"),
+                            FALSE,
+                            GTK_PARAM_READWRITE | G_PARAM_EXPLICIT_NOTIFY);
+
   g_object_class_install_properties (gobject_class, NUM_PROPERTIES, properties);
 }
 
@@ -543,6 +922,7 @@ gtk_filter_list_model_set_filter_func (GtkFilterListModel           *self,
   
   if (!will_be_filtered)
     {
+      gtk_filter_list_model_stop_filtering (self);
       g_clear_pointer (&self->items, gtk_rb_tree_unref);
     }
   else if (!was_filtered)
@@ -555,11 +935,14 @@ gtk_filter_list_model_set_filter_func (GtkFilterListModel           *self,
                                      NULL, NULL);
       if (self->model)
         {
+          FilterNode *node;
+
           n_items = g_list_model_get_n_items (self->model);
+          node = gtk_rb_tree_insert_many_before (self->items, NULL, n_items);
           for (i = 0; i < n_items; i++)
             {
-              FilterNode *node = gtk_rb_tree_insert_before (self->items, NULL);
               node->visible = TRUE;
+              node = gtk_rb_tree_node_get_next (node);
             }
         }
     }
@@ -603,7 +986,23 @@ gtk_filter_list_model_set_model (GtkFilterListModel *self,
     {
       self->model = g_object_ref (model);
       g_signal_connect (model, "items-changed", G_CALLBACK (gtk_filter_list_model_items_changed_cb), self);
-      if (self->items)
+      if (self->items && self->incremental)
+        {
+          FilterNode *node;
+          guint i;
+
+          /* Show everything until it has been filtered */
+          added = g_list_model_get_n_items (model);
+          node = gtk_rb_tree_insert_many_before (self->items, NULL, added);
+          for (i = 0; i < added; i++)
+            {
+              node->visible = TRUE;
+              node = gtk_rb_tree_node_get_next (node);
+            }
+          if (added > 0)
+            gtk_filter_list_model_start_filtering (self, 0);
+        }
+      else if (self->items)
         added = gtk_filter_list_model_add_items (self, NULL, 0, g_list_model_get_n_items (model));
       else
         added = g_list_model_get_n_items (model);
@@ -657,55 +1056,153 @@ gtk_filter_list_model_has_filter (GtkFilterListModel *self)
  *
  * Calling this function is necessary when data used by the filter
  * function has changed.
+ *
+ * If the model filters incrementally, items keep their current
+ * visibility until they have been filtered again.
  **/
 void
 gtk_filter_list_model_refilter (GtkFilterListModel *self)
 {
-  FilterNode *node;
-  guint i, first_change, last_change;
-  guint n_is_visible, n_was_visible;
-  gboolean visible;
+  guint position;
 
   g_return_if_fail (GTK_IS_FILTER_LIST_MODEL (self));
-  
+
   if (self->items == NULL || self->model == NULL)
     return;
 
-  first_change = G_MAXUINT;
-  last_change = 0;
-  n_is_visible = 0;
-  n_was_visible = 0;
-  for (i = 0, node = gtk_rb_tree_get_first (self->items);
-       node != NULL;
-       i++, node = gtk_rb_tree_node_get_next (node))
+  if (self->incremental)
     {
-      visible = gtk_filter_list_model_run_filter (self, i);
-      if (visible == node->visible)
-        {
-          if (visible)
-            {
-              n_is_visible++;
-              n_was_visible++;
-            }
-          continue;
-        }
-
-      node->visible = visible;
-      gtk_rb_tree_node_mark_dirty (node);
-      first_change = MIN (n_is_visible, first_change);
-      if (visible)
-        n_is_visible++;
-      else
-        n_was_visible++;
-      last_change = MAX (n_is_visible, last_change);
+      if (g_list_model_get_n_items (self->model) > 0)
+        gtk_filter_list_model_start_filtering (self, 0);
+      return;
     }
 
-  if (first_change <= last_change)
+  position = 0;
+  gtk_filter_list_model_filter_from (self, &position, 0);
+}
+
+/**
+ * gtk_filter_list_model_set_incremental:
+ * @self: a #GtkFilterListModel
+ * @incremental: %TRUE to filter incrementally
+ *
+ * Sets the filter model to do incremental filtering.
+ *
+ * When incremental filtering is enabled, the filter list model will
+ * not run the filter over all items immediately, but will instead
+ * filter a chunk of items at a time whenever the main loop is idle,
+ * so that the application stays responsive. A #GListModel::items-changed
+ * signal is emitted for every chunk. Items that have not been filtered
+ * yet keep their previous visibility. The #GtkFilterListModel:pending
+ * property can be used to show progress.
+ *
+ * By default, incremental filtering is disabled.
+ **/
+void
+gtk_filter_list_model_set_incremental (GtkFilterListModel *self,
+                                       gboolean            incremental)
+{
+  g_return_if_fail (GTK_IS_FILTER_LIST_MODEL (self));
+
+  if (self->incremental == incremental)
+    return;
+
+  self->incremental = incremental;
+
+  if (!incremental && self->filter_cb)
     {
-      g_list_model_items_changed (G_LIST_MODEL (self),
-                                  first_change,
-                                  last_change - first_change + n_was_visible - n_is_visible,
-                                  last_change - first_change);
+      guint position = self->pending_position;
+
+      gtk_filter_list_model_stop_filtering (self);
+      gtk_filter_list_model_filter_from (self, &position, 0);
     }
+
+  g_object_notify_by_pspec (G_OBJECT (self), properties[PROP_INCREMENTAL]);
 }
 
+/**
+ * gtk_filter_list_model_get_incremental:
+ * @self: a #GtkFilterListModel
+ *
+ * Returns whether incremental filtering was enabled via
+ * gtk_filter_list_model_set_incremental().
+ *
+ * Returns: %TRUE if incremental filtering is enabled
+ **/
+gboolean
+gtk_filter_list_model_get_incremental (GtkFilterListModel *self)
+{
+  g_return_val_if_fail (GTK_IS_FILTER_LIST_MODEL (self), FALSE);
+
+  return self->incremental;
+}
+
+/**
+ * gtk_filter_list_model_get_pending:
+ * @self: a #GtkFilterListModel
+ *
+ * Returns the number of items that have not been filtered yet.
+ *
+ * Returns: the number of items left to filter or 0 if the model is
+ *   not filtering
+ **/
+guint
+gtk_filter_list_model_get_pending (GtkFilterListModel *self)
+{
+  g_return_val_if_fail (GTK_IS_FILTER_LIST_MODEL (self), 0);
+
+  if (self->filter_cb == 0)
+    return 0;
+
+  return g_list_model_get_n_items (self->model) - self->pending_position;
+}
+
+/**
+ * gtk_filter_list_model_set_thread_safe:
+ * @self: a #GtkFilterListModel
+ * @thread_safe: %TRUE if the filter function is thread-safe
+ *
+ * Declares whether the filter function of @self is thread-safe.
+ *
+ * If it is, the model will run it on many items in parallel using
+ * a pool of worker threads, which makes filtering large models a lot
+ * faster. The filter function will then be called from threads other
+ * than the main thread, possibly at the same time. It must not use
+ * GTK or modify the items, which is the case for functions like
+ * matching a string property against a search term.
+ *
+ * The results are always merged into the model on the main thread,
+ * so signals are only emitted there.
+ *
+ * By default, filter functions are not assumed to be thread-safe.
+ **/
+void
+gtk_filter_list_model_set_thread_safe (GtkFilterListModel *self,
+                                       gboolean            thread_safe)
+{
+  g_return_if_fail (GTK_IS_FILTER_LIST_MODEL (self));
+
+  if (self->thread_safe == thread_safe)
+    return;
+
+  self->thread_safe = thread_safe;
+
+  g_object_notify_by_pspec (G_OBJECT (self), properties[PROP_THREAD_SAFE]);
+}
+
+/**
+ * gtk_filter_list_model_get_thread_safe:
+ * @self: a #GtkFilterListModel
+ *
+ * Returns whether the filter function was declared thread-safe via
+ * gtk_filter_list_model_set_thread_safe().
+ *
+ * Returns: %TRUE if the filter function is thread-safe
+ **/
+gboolean
+gtk_filter_list_model_get_thread_safe (GtkFilterListModel *self)
+{
+  g_return_val_if_fail (GTK_IS_FILTER_LIST_MODEL (self), FALSE);
+
+  return self->thread_safe;
+}
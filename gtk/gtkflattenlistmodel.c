@@ -287,9 +287,9 @@ gtk_flatten_list_model_add_items (GtkFlattenListModel *self,
   guint added, i;
 
   added = 0;
+  node = gtk_rb_tree_insert_many_before (self->items, after, n);
   for (i = 0; i < n; i++)
     {
-      node = gtk_rb_tree_insert_before (self->items, after);
       node->model = g_list_model_get_item (self->model, position + i);
       g_warn_if_fail (g_type_is_a (g_list_model_get_item_type (node->model), self->item_type));
       g_signal_connect (node->model,
@@ -298,6 +298,8 @@ gtk_flatten_list_model_add_items (GtkFlattenListModel *self,
                         node);
       node->list = self;
       added +=g_list_model_get_n_items (node->model);
+      gtk_rb_tree_node_mark_dirty (node);
+      node = gtk_rb_tree_node_get_next (node);
     }
 
   return added;
@@ -364,12 +366,16 @@ gtk_flatten_list_model_model_items_changed_cb (GListModel          *model,
   node = gtk_flatten_list_model_get_nth_model (self->items, position, &real_position);
 
   real_removed = 0;
-  for (i = 0; i < removed; i++)
+  if (removed)
     {
-      FlattenNode *next = gtk_rb_tree_node_get_next (node);
-      real_removed += g_list_model_get_n_items (node->model);
-      gtk_rb_tree_remove (self->items, node);
-      node = next;
+      FlattenNode *first = node;
+
+      for (i = 0; i < removed; i++)
+        {
+          real_removed += g_list_model_get_n_items (node->model);
+          node = gtk_rb_tree_node_get_next (node);
+        }
+      gtk_rb_tree_remove_many (self->items, first, removed);
     }
 
   real_added = gtk_flatten_list_model_add_items (self, node, position, added);
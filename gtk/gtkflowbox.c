@@ -100,6 +100,8 @@
 #include "a11y/gtkflowboxaccessibleprivate.h"
 #include "a11y/gtkflowboxchildaccessible.h"
 
+#include <string.h>
+
 /* Forward declarations and utilities {{{1 */
 
 static void gtk_flow_box_update_cursor       (GtkFlowBox      *box,
@@ -621,6 +623,21 @@ struct _GtkFlowBoxPrivate {
 
   GSequence        *children;
 
+  /* The last line fitted by fit_aligned_item_requests(), reused as long
+   * as the visible children measure the same and the constraints match */
+  struct {
+    GtkRequestedSize *child_sizes;
+    gint              n_children;
+    GtkOrientation    orientation;
+    GtkAlign          item_align;
+    gint              avail_size;
+    gint              item_spacing;
+    gint              items_per_line;
+    gint              initial_line_length;
+    gint              line_length;
+    GtkRequestedSize *item_sizes;
+  } line_cache;
+
   GtkFlowBoxFilterFunc filter_func;
   gpointer             filter_data;
   GDestroyNotify       filter_destroy;
@@ -1209,29 +1226,23 @@ get_largest_size_for_line_in_opposing_orientation (GtkFlowBox       *box,
 }
 
 /* fit_aligned_item_requests() helper */
-static gint
-gather_aligned_item_requests (GtkFlowBox       *box,
-                              GtkOrientation    orientation,
-                              gint              line_length,
-                              gint              item_spacing,
-                              gint              n_children,
-                              GtkRequestedSize *item_sizes)
+static GtkRequestedSize *
+measure_visible_children (GtkFlowBox     *box,
+                          GtkOrientation  orientation,
+                          gint            n_children)
 {
+  GtkRequestedSize *child_sizes;
   GSequenceIter *iter;
   gint i;
-  gint extra_items, natural_line_size = 0;
 
-  extra_items = n_children % line_length;
+  child_sizes = g_new0 (GtkRequestedSize, n_children);
 
   i = 0;
   for (iter = g_sequence_get_begin_iter (BOX_PRIV (box)->children);
-       !g_sequence_iter_is_end (iter);
+       !g_sequence_iter_is_end (iter) && i < n_children;
        iter = g_sequence_iter_next (iter))
     {
       GtkWidget *child;
-      GtkAlign item_align;
-      gint child_min, child_nat;
-      gint position;
 
       child = g_sequence_get (iter);
 
@@ -1239,21 +1250,45 @@ gather_aligned_item_requests (GtkFlowBox       *box,
         continue;
 
       gtk_widget_measure (child, orientation, -1,
-                          &child_min, &child_nat,
+                          &child_sizes[i].minimum_size, &child_sizes[i].natural_size,
                           NULL, NULL);
+      child_sizes[i].data = child;
+
+      i++;
+    }
+
+  return child_sizes;
+}
+
+/* fit_aligned_item_requests() helper */
+static gint
+gather_aligned_item_requests (GtkFlowBox             *box,
+                              const GtkRequestedSize *child_sizes,
+                              gint                    line_length,
+                              gint                    item_spacing,
+                              gint                    n_children,
+                              GtkRequestedSize       *item_sizes)
+{
+  GtkAlign item_align;
+  gint i;
+  gint extra_items, natural_line_size = 0;
+
+  extra_items = n_children % line_length;
+  item_align = ORIENTATION_ALIGN (box);
+
+  for (i = 0; i < n_children; i++)
+    {
+      gint position;
 
       /* Get the index and push it over for the last line when spreading to the end */
       position = i % line_length;
 
-      item_align = ORIENTATION_ALIGN (box);
       if (item_align == GTK_ALIGN_END && i >= n_children - extra_items)
         position += line_length - extra_items;
 
       /* Round up the size of every column/row */
-      item_sizes[position].minimum_size = MAX (item_sizes[position].minimum_size, child_min);
-      item_sizes[position].natural_size = MAX (item_sizes[position].natural_size, child_nat);
-
-      i++;
+      item_sizes[position].minimum_size = MAX (item_sizes[position].minimum_size, child_sizes[i].minimum_size);
+      item_sizes[position].natural_size = MAX (item_sizes[position].natural_size, child_sizes[i].natural_size);
     }
 
   for (i = 0; i < line_length; i++)
@@ -1273,14 +1308,39 @@ fit_aligned_item_requests (GtkFlowBox     *box,
                            gint            items_per_line,
                            gint            n_children)
 {
-  GtkRequestedSize *sizes, *try_sizes;
+  GtkFlowBoxPrivate *priv = BOX_PRIV (box);
+  GtkRequestedSize *child_sizes, *sizes, *try_sizes;
   gint try_line_size, try_length;
+  gint initial_line_length = *line_length;
+
+  /* Measure every child once, the line lengths we try below only
+   * differ in how the sizes are gathered into columns/rows */
+  child_sizes = measure_visible_children (box, orientation, n_children);
+
+  /* Nothing changed since the last allocation or measure, so the
+   * same line fits again */
+  if (priv->line_cache.child_sizes != NULL &&
+      priv->line_cache.n_children == n_children &&
+      priv->line_cache.orientation == orientation &&
+      priv->line_cache.item_align == ORIENTATION_ALIGN (box) &&
+      priv->line_cache.avail_size == avail_size &&
+      priv->line_cache.item_spacing == item_spacing &&
+      priv->line_cache.items_per_line == items_per_line &&
+      priv->line_cache.initial_line_length == initial_line_length &&
+      memcmp (priv->line_cache.child_sizes, child_sizes, n_children * sizeof (GtkRequestedSize)) == 0)
+    {
+      g_free (child_sizes);
+
+      *line_length = priv->line_cache.line_length;
+      return g_memdup (priv->line_cache.item_sizes,
+                       priv->line_cache.line_length * sizeof (GtkRequestedSize));
+    }
 
   sizes = g_new0 (GtkRequestedSize, *line_length);
 
   /* get the sizes for the initial guess */
   try_line_size = gather_aligned_item_requests (box,
-                                                orientation,
+                                                child_sizes,
                                                 *line_length,
                                                 item_spacing,
                                                 n_children,
@@ -1294,7 +1354,7 @@ fit_aligned_item_requests (GtkFlowBox     *box,
     {
       try_sizes = g_new0 (GtkRequestedSize, try_length);
       try_line_size = gather_aligned_item_requests (box,
-                                                    orientation,
+                                                    child_sizes,
                                                     try_length,
                                                     item_spacing,
                                                     n_children,
@@ -1316,6 +1376,19 @@ fit_aligned_item_requests (GtkFlowBox     *box,
         }
     }
 
+  g_free (priv->line_cache.child_sizes);
+  g_free (priv->line_cache.item_sizes);
+  priv->line_cache.child_sizes = child_sizes;
+  priv->line_cache.n_children = n_children;
+  priv->line_cache.orientation = orientation;
+  priv->line_cache.item_align = ORIENTATION_ALIGN (box);
+  priv->line_cache.avail_size = avail_size;
+  priv->line_cache.item_spacing = item_spacing;
+  priv->line_cache.items_per_line = items_per_line;
+  priv->line_cache.initial_line_length = initial_line_length;
+  priv->line_cache.line_length = *line_length;
+  priv->line_cache.item_sizes = g_memdup (sizes, *line_length * sizeof (GtkRequestedSize));
+
   return sizes;
 }
 
@@ -3344,6 +3417,8 @@ gtk_flow_box_finalize (GObject *obj)
     priv->sort_destroy (priv->sort_data);
 
   g_sequence_free (priv->children);
+  g_free (priv->line_cache.child_sizes);
+  g_free (priv->line_cache.item_sizes);
   g_clear_object (&priv->hadjustment);
   g_clear_object (&priv->vadjustment);
 
@@ -3696,6 +3771,7 @@ gtk_flow_box_init (GtkFlowBox *box)
   GtkGesture *gesture;
 
   gtk_widget_set_has_surface (GTK_WIDGET (box), FALSE);
+  gtk_widget_set_use_pick_index (GTK_WIDGET (box), TRUE);
 
   priv->orientation = GTK_ORIENTATION_HORIZONTAL;
   priv->selection_mode = GTK_SELECTION_SINGLE;
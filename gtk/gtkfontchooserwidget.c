@@ -108,6 +108,17 @@ struct _GtkFontChooserWidgetPrivate
   GtkTreeModel *model;
   GtkTreeModel *filter_model;
 
+  /* families that still need to be added to the model */
+  PangoFontFamily **pending_families;
+  int               n_pending_families;
+  int               next_pending_family;
+  guint             load_fonts_id;
+
+  /* in pango units */
+  int               preview_height;
+  /* GtkDelayedFontDescriptions with preview attributes, most recently used first */
+  GQueue            preview_cache;
+
   GtkWidget       *preview;
   GtkWidget       *preview2;
   GtkWidget       *font_name_label;
@@ -197,6 +208,8 @@ static void     gtk_font_chooser_widget_set_show_preview_entry (GtkFontChooserWi
                                                                 gboolean              show_preview_entry);
 
 static void     gtk_font_chooser_widget_set_cell_size          (GtkFontChooserWidget *fontchooser);
+static void     gtk_font_chooser_widget_stop_loading           (GtkFontChooserWidget *fontchooser);
+static void     gtk_font_chooser_widget_clear_preview_cache    (GtkFontChooserWidget *fontchooser);
 static void     gtk_font_chooser_widget_load_fonts             (GtkFontChooserWidget *fontchooser,
                                                                 gboolean              force);
 static void     gtk_font_chooser_widget_populate_features      (GtkFontChooserWidget *fontchooser);
@@ -228,6 +241,7 @@ typedef struct _GtkDelayedFontDescription GtkDelayedFontDescription;
 struct _GtkDelayedFontDescription {
   PangoFontFace        *face;
   PangoFontDescription *desc;
+  PangoAttrList        *preview_attrs;
   guint                 ref_count;
 };
 
@@ -264,6 +278,8 @@ gtk_delayed_font_description_unref (GtkDelayedFontDescription *desc)
   g_object_unref (desc->face);
   if (desc->desc)
     pango_font_description_free (desc->desc);
+  if (desc->preview_attrs)
+    pango_attr_list_unref (desc->preview_attrs);
 
   g_slice_free (GtkDelayedFontDescription, desc);
 }
@@ -608,7 +624,9 @@ rows_changed_cb (GtkFontChooserWidget *fontchooser)
   GtkFontChooserWidgetPrivate *priv = fontchooser->priv;
   const char *page;
 
-  if (gtk_tree_model_iter_n_children (priv->filter_model, NULL) == 0)
+  /* Matching fonts may still be loaded */
+  if (gtk_tree_model_iter_n_children (priv->filter_model, NULL) == 0 &&
+      priv->next_pending_family >= priv->n_pending_families)
     page = "empty";
   else
     page = "list";
@@ -670,6 +688,9 @@ gtk_font_chooser_widget_dispose (GObject *object)
   GtkFontChooserWidget *self = GTK_FONT_CHOOSER_WIDGET (object);
   GtkFontChooserWidgetPrivate *priv = gtk_font_chooser_widget_get_instance_private (self);
 
+  gtk_font_chooser_widget_stop_loading (self);
+  gtk_font_chooser_widget_clear_preview_cache (self);
+
   g_clear_pointer (&priv->stack, gtk_widget_unparent);
 
   G_OBJECT_CLASS (gtk_font_chooser_widget_parent_class)->dispose (object);
@@ -904,50 +925,30 @@ cmp_families (const void *a,
   return g_utf8_collate (a_name, b_name);
 }
 
+/* Listing the faces of thousands of families takes a while, so the
+ * model is filled a few families at a time while the dialog is already
+ * up. Families that are needed earlier, like the one of the selected
+ * font, are added right away by gtk_font_chooser_widget_find_font().
+ */
+#define FAMILIES_PER_CHUNK 100
+
 static void
-gtk_font_chooser_widget_load_fonts (GtkFontChooserWidget *fontchooser,
-                                    gboolean              force)
+gtk_font_chooser_widget_add_families (GtkFontChooserWidget *fontchooser,
+                                      int                   end)
 {
   GtkFontChooserWidgetPrivate *priv = fontchooser->priv;
-  GtkListStore *list_store;
-  gint n_families, i;
-  PangoFontFamily **families;
-  guint fontconfig_timestamp;
-  gboolean need_reload;
-  PangoFontMap *font_map;
-
-  g_object_get (gtk_widget_get_settings (GTK_WIDGET (fontchooser)),
-                "gtk-fontconfig-timestamp", &fontconfig_timestamp,
-                NULL);
-
-  /* The fontconfig timestamp is only set on systems with fontconfig; every
-   * other platform will set it to 0. For those systems, we fall back to
-   * reloading the fonts every time.
-   */
-  need_reload = fontconfig_timestamp == 0 ||
-                fontconfig_timestamp != priv->last_fontconfig_timestamp;
-
-  priv->last_fontconfig_timestamp = fontconfig_timestamp;
+  GtkListStore *list_store = GTK_LIST_STORE (priv->model);
+  PangoFontFamily **families = priv->pending_families;
+  int i;
 
-  if (!need_reload && !force)
+  if (priv->next_pending_family >= end)
     return;
 
-  list_store = GTK_LIST_STORE (priv->model);
-
-  if (priv->font_map)
-    font_map = priv->font_map;
-  else
-    font_map = pango_cairo_font_map_get_default ();
-  pango_font_map_list_families (font_map, &families, &n_families);
-
-  qsort (families, n_families, sizeof (PangoFontFamily *), cmp_families);
-
   g_signal_handlers_block_by_func (priv->family_face_list, cursor_changed_cb, fontchooser);
   g_signal_handlers_block_by_func (priv->filter_model, rows_changed_cb, fontchooser);
-  gtk_list_store_clear (list_store);
 
   /* Iterate over families and faces */
-  for (i = 0; i < n_families; i++)
+  for (i = priv->next_pending_family; i < end; i++)
     {
       GtkTreeIter     iter;
       PangoFontFace **faces;
@@ -988,12 +989,108 @@ gtk_font_chooser_widget_load_fonts (GtkFontChooserWidget *fontchooser,
       g_free (faces);
     }
 
-  g_free (families);
+  priv->next_pending_family = end;
 
   rows_changed_cb (fontchooser);
 
   g_signal_handlers_unblock_by_func (priv->filter_model, rows_changed_cb, fontchooser);
   g_signal_handlers_unblock_by_func (priv->family_face_list, cursor_changed_cb, fontchooser);
+}
+
+static void
+gtk_font_chooser_widget_stop_loading (GtkFontChooserWidget *fontchooser)
+{
+  GtkFontChooserWidgetPrivate *priv = fontchooser->priv;
+
+  if (priv->load_fonts_id)
+    {
+      g_source_remove (priv->load_fonts_id);
+      priv->load_fonts_id = 0;
+    }
+
+  g_clear_pointer (&priv->pending_families, g_free);
+  priv->n_pending_families = 0;
+  priv->next_pending_family = 0;
+}
+
+static gboolean
+load_fonts_cb (gpointer data)
+{
+  GtkFontChooserWidget *fontchooser = data;
+  GtkFontChooserWidgetPrivate *priv = fontchooser->priv;
+
+  gtk_font_chooser_widget_add_families (fontchooser,
+                                        MIN (priv->next_pending_family + FAMILIES_PER_CHUNK,
+                                             priv->n_pending_families));
+
+  if (priv->next_pending_family < priv->n_pending_families)
+    return G_SOURCE_CONTINUE;
+
+  priv->load_fonts_id = 0;
+  gtk_font_chooser_widget_stop_loading (fontchooser);
+
+  return G_SOURCE_REMOVE;
+}
+
+static void
+gtk_font_chooser_widget_load_fonts (GtkFontChooserWidget *fontchooser,
+                                    gboolean              force)
+{
+  GtkFontChooserWidgetPrivate *priv = fontchooser->priv;
+  gint n_families;
+  PangoFontFamily **families;
+  guint fontconfig_timestamp;
+  gboolean need_reload;
+  PangoFontMap *font_map;
+
+  g_object_get (gtk_widget_get_settings (GTK_WIDGET (fontchooser)),
+                "gtk-fontconfig-timestamp", &fontconfig_timestamp,
+                NULL);
+
+  /* The fontconfig timestamp is only set on systems with fontconfig; every
+   * other platform will set it to 0. For those systems, we fall back to
+   * reloading the fonts every time.
+   */
+  need_reload = fontconfig_timestamp == 0 ||
+                fontconfig_timestamp != priv->last_fontconfig_timestamp;
+
+  priv->last_fontconfig_timestamp = fontconfig_timestamp;
+
+  if (!need_reload && !force)
+    return;
+
+  if (priv->font_map)
+    font_map = priv->font_map;
+  else
+    font_map = pango_cairo_font_map_get_default ();
+  pango_font_map_list_families (font_map, &families, &n_families);
+
+  qsort (families, n_families, sizeof (PangoFontFamily *), cmp_families);
+
+  gtk_font_chooser_widget_stop_loading (fontchooser);
+  gtk_font_chooser_widget_clear_preview_cache (fontchooser);
+
+  g_signal_handlers_block_by_func (priv->family_face_list, cursor_changed_cb, fontchooser);
+  g_signal_handlers_block_by_func (priv->filter_model, rows_changed_cb, fontchooser);
+  gtk_list_store_clear (GTK_LIST_STORE (priv->model));
+  g_signal_handlers_unblock_by_func (priv->filter_model, rows_changed_cb, fontchooser);
+  g_signal_handlers_unblock_by_func (priv->family_face_list, cursor_changed_cb, fontchooser);
+
+  priv->pending_families = families;
+  priv->n_pending_families = n_families;
+  priv->next_pending_family = 0;
+
+  gtk_font_chooser_widget_add_families (fontchooser, MIN (FAMILIES_PER_CHUNK, n_families));
+
+  if (priv->next_pending_family < n_families)
+    {
+      priv->load_fonts_id = g_idle_add (load_fonts_cb, fontchooser);
+      g_source_set_name_by_id (priv->load_fonts_id, "[gtk] load_fonts_cb");
+    }
+  else
+    {
+      gtk_font_chooser_widget_stop_loading (fontchooser);
+    }
 
   /* now make sure the font list looks right */
   if (!gtk_font_chooser_widget_find_font (fontchooser, priv->font_desc, &priv->font_iter))
@@ -1099,12 +1196,60 @@ gtk_font_chooser_widget_get_preview_attributes (GtkFontChooserWidget       *font
       pango_attr_list_insert (attrs, attribute);
     }
 
-  attribute = pango_attr_size_new_absolute (gtk_font_chooser_widget_get_preview_text_height (fontchooser));
+  attribute = pango_attr_size_new_absolute (fontchooser->priv->preview_height);
   pango_attr_list_insert (attrs, attribute);
 
   return attrs;
 }
 
+/* Only the visible rows are drawn, so only keep the attributes of about
+ * as many faces as fit on a large screen */
+#define MAX_CACHED_PREVIEWS 128
+
+static PangoAttrList *
+gtk_font_chooser_widget_get_cached_preview_attributes (GtkFontChooserWidget      *fontchooser,
+                                                       GtkDelayedFontDescription *desc)
+{
+  GtkFontChooserWidgetPrivate *priv = fontchooser->priv;
+
+  if (desc->preview_attrs)
+    {
+      GList *link = g_queue_find (&priv->preview_cache, desc);
+
+      g_queue_unlink (&priv->preview_cache, link);
+      g_queue_push_head_link (&priv->preview_cache, link);
+
+      return desc->preview_attrs;
+    }
+
+  desc->preview_attrs = gtk_font_chooser_widget_get_preview_attributes (fontchooser,
+                                                                        gtk_delayed_font_description_get (desc));
+  g_queue_push_head (&priv->preview_cache, gtk_delayed_font_description_ref (desc));
+
+  if (priv->preview_cache.length > MAX_CACHED_PREVIEWS)
+    {
+      GtkDelayedFontDescription *old = g_queue_pop_tail (&priv->preview_cache);
+
+      g_clear_pointer (&old->preview_attrs, pango_attr_list_unref);
+      gtk_delayed_font_description_unref (old);
+    }
+
+  return desc->preview_attrs;
+}
+
+static void
+gtk_font_chooser_widget_clear_preview_cache (GtkFontChooserWidget *fontchooser)
+{
+  GtkFontChooserWidgetPrivate *priv = fontchooser->priv;
+  GtkDelayedFontDescription *desc;
+
+  while ((desc = g_queue_pop_head (&priv->preview_cache)))
+    {
+      g_clear_pointer (&desc->preview_attrs, pango_attr_list_unref);
+      gtk_delayed_font_description_unref (desc);
+    }
+}
+
 static void
 gtk_font_chooser_widget_cell_data_func (GtkTreeViewColumn *column,
                                         GtkCellRenderer   *cell,
@@ -1122,8 +1267,7 @@ gtk_font_chooser_widget_cell_data_func (GtkTreeViewColumn *column,
                       FONT_DESC_COLUMN, &desc,
                       -1);
 
-  attrs = gtk_font_chooser_widget_get_preview_attributes (fontchooser,
-                                                          gtk_delayed_font_description_get (desc));
+  attrs = gtk_font_chooser_widget_get_cached_preview_attributes (fontchooser, desc);
 
   g_object_set (cell,
                 "xpad", 20,
@@ -1133,7 +1277,6 @@ gtk_font_chooser_widget_cell_data_func (GtkTreeViewColumn *column,
                 NULL);
 
   gtk_delayed_font_description_unref (desc);
-  pango_attr_list_unref (attrs);
   g_free (preview_title);
 }
 
@@ -1146,6 +1289,10 @@ gtk_font_chooser_widget_set_cell_size (GtkFontChooserWidget *fontchooser)
 
   gtk_cell_renderer_set_fixed_size (priv->family_face_cell, -1, -1);
 
+  /* The cached previews are for the old size */
+  priv->preview_height = gtk_font_chooser_widget_get_preview_text_height (fontchooser);
+  gtk_font_chooser_widget_clear_preview_cache (fontchooser);
+
   attrs = gtk_font_chooser_widget_get_preview_attributes (fontchooser, NULL);
   
   g_object_set (priv->family_face_cell,
@@ -1206,10 +1353,22 @@ gtk_font_chooser_widget_find_font (GtkFontChooserWidget        *fontchooser,
 {
   GtkFontChooserWidgetPrivate *priv = fontchooser->priv;
   gboolean valid;
+  int i;
 
   if (pango_font_description_get_family (font_desc) == NULL)
     return FALSE;
 
+  /* Don't wait for the family to be loaded */
+  for (i = priv->next_pending_family; i < priv->n_pending_families; i++)
+    {
+      if (my_pango_font_family_equal (pango_font_description_get_family (font_desc),
+                                      pango_font_family_get_name (priv->pending_families[i])))
+        {
+          gtk_font_chooser_widget_add_families (fontchooser, i + 1);
+          break;
+        }
+    }
+
   for (valid = gtk_tree_model_get_iter_first (priv->model, iter);
        valid;
        valid = gtk_tree_model_iter_next (priv->model, iter))
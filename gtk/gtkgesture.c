@@ -124,6 +124,8 @@
 #include "gtkmain.h"
 #include "gtkintl.h"
 
+#include <string.h>
+
 typedef struct _GtkGesturePrivate GtkGesturePrivate;
 typedef struct _PointData PointData;
 
@@ -152,11 +154,18 @@ struct _PointData
 
   guint press_handled : 1;
   guint state : 2;
+  guint embedded : 1;
+  guint in_use : 1;
 };
 
+/* Storage for this many points is kept in the gesture, so the common
+ * case of one or two fingers doesn't allocate for every touch */
+#define N_EMBEDDED_POINTS 2
+
 struct _GtkGesturePrivate
 {
   GHashTable *points;
+  PointData embedded_points[N_EMBEDDED_POINTS];
   GdkEventSequence *last_sequence;
   GdkDevice *device;
   GList *group_link;
@@ -465,6 +474,31 @@ gtk_gesture_get_group_state (GtkGesture       *gesture,
   return state;
 }
 
+static PointData *
+point_data_new (GtkGesture *gesture)
+{
+  GtkGesturePrivate *priv = gtk_gesture_get_instance_private (gesture);
+  PointData *data;
+  guint i;
+
+  for (i = 0; i < N_EMBEDDED_POINTS; i++)
+    {
+      data = &priv->embedded_points[i];
+
+      if (!data->in_use)
+        {
+          data->embedded = TRUE;
+          data->in_use = TRUE;
+          return data;
+        }
+    }
+
+  data = g_new0 (PointData, 1);
+  data->in_use = TRUE;
+
+  return data;
+}
+
 static gboolean
 _gtk_gesture_update_point (GtkGesture     *gesture,
                            const GdkEvent *event,
@@ -520,7 +554,7 @@ _gtk_gesture_update_point (GtkGesture     *gesture,
           priv->touchpad = touchpad;
         }
 
-      data = g_new0 (PointData, 1);
+      data = point_data_new (gesture);
       g_hash_table_insert (priv->points, sequence, data);
 
       group_state = gtk_gesture_get_group_state (gesture, sequence);
@@ -900,7 +934,10 @@ free_point_data (gpointer data)
   if (point->event)
     g_object_unref (point->event);
 
-  g_free (point);
+  if (point->embedded)
+    memset (point, 0, sizeof (PointData));
+  else
+    g_free (point);
 }
 
 static void
@@ -25,6 +25,14 @@
  *
  * #GtkGestureStylus is a #GtkGesture implementation specific to stylus
  * input. The provided signals just provide the basic information
+ *
+ * Drawing applications that want every position reported by the
+ * device can enable #GtkGestureStylus:collect-samples. The gesture
+ * then keeps all positions of the current stroke, including the ones
+ * that GTK+ merged into a single motion event, in a buffer that can
+ * be read with gtk_gesture_stylus_peek_samples() once per frame, for
+ * example from a tick callback, instead of handling each position in
+ * a signal handler.
  */
 
 #include "config.h"
@@ -46,6 +54,112 @@ enum {
 
 static guint signals[N_SIGNALS] = { 0, };
 
+enum {
+  PROP_COLLECT_SAMPLES = 1,
+  LAST_PROP
+};
+
+static GParamSpec *properties[LAST_PROP] = { NULL, };
+
+static void
+gtk_gesture_stylus_get_property (GObject    *object,
+                                 guint       prop_id,
+                                 GValue     *value,
+                                 GParamSpec *pspec)
+{
+  GtkGestureStylus *gesture = GTK_GESTURE_STYLUS (object);
+
+  switch (prop_id)
+    {
+    case PROP_COLLECT_SAMPLES:
+      g_value_set_boolean (value, gesture->collect_samples);
+      break;
+    default:
+      G_OBJECT_WARN_INVALID_PROPERTY_ID (object, prop_id, pspec);
+    }
+}
+
+static void
+gtk_gesture_stylus_set_property (GObject      *object,
+                                 guint         prop_id,
+                                 const GValue *value,
+                                 GParamSpec   *pspec)
+{
+  switch (prop_id)
+    {
+    case PROP_COLLECT_SAMPLES:
+      gtk_gesture_stylus_set_collect_samples (GTK_GESTURE_STYLUS (object),
+                                              g_value_get_boolean (value));
+      break;
+    default:
+      G_OBJECT_WARN_INVALID_PROPERTY_ID (object, prop_id, pspec);
+    }
+}
+
+static void
+gtk_gesture_stylus_finalize (GObject *object)
+{
+  GtkGestureStylus *gesture = GTK_GESTURE_STYLUS (object);
+
+  g_array_unref (gesture->samples);
+
+  G_OBJECT_CLASS (gtk_gesture_stylus_parent_class)->finalize (object);
+}
+
+static void
+gtk_gesture_stylus_collect_samples (GtkGestureStylus *gesture,
+                                    const GdkEvent   *event,
+                                    gdouble           x,
+                                    gdouble           y)
+{
+  GtkGestureStylusSample *sample;
+  GList *history, *l;
+  guint n;
+
+  history = gdk_event_get_motion_history (event);
+  if (history)
+    {
+      GtkWidget *event_widget, *widget;
+
+      event_widget = gtk_get_event_widget (event);
+      widget = gtk_event_controller_get_widget (GTK_EVENT_CONTROLLER (gesture));
+
+      n = gesture->samples->len;
+      g_array_set_size (gesture->samples, n + g_list_length (history));
+      sample = &g_array_index (gesture->samples, GtkGestureStylusSample, n);
+
+      for (l = history; l; l = l->next, sample++)
+        {
+          GdkTimeCoord *time_coord = l->data;
+
+          gtk_widget_translate_coordinatesf (event_widget, widget,
+                                             time_coord->axes[GDK_AXIS_X],
+                                             time_coord->axes[GDK_AXIS_Y],
+                                             &sample->x, &sample->y);
+          sample->time = time_coord->time;
+          sample->pressure = time_coord->axes[GDK_AXIS_PRESSURE];
+          sample->xtilt = time_coord->axes[GDK_AXIS_XTILT];
+          sample->ytilt = time_coord->axes[GDK_AXIS_YTILT];
+        }
+
+      g_list_free (history);
+    }
+
+  g_array_set_size (gesture->samples, gesture->samples->len + 1);
+  sample = &g_array_index (gesture->samples, GtkGestureStylusSample,
+                           gesture->samples->len - 1);
+
+  sample->time = gdk_event_get_time (event);
+  sample->x = x;
+  sample->y = y;
+  if (!gdk_event_get_axis (event, GDK_AXIS_PRESSURE, &sample->pressure))
+    sample->pressure = 1;
+  if (!gdk_event_get_axis (event, GDK_AXIS_XTILT, &sample->xtilt))
+    sample->xtilt = 0;
+  if (!gdk_event_get_axis (event, GDK_AXIS_YTILT, &sample->ytilt))
+    sample->ytilt = 0;
+}
+
 static gboolean
 gtk_gesture_stylus_handle_event (GtkEventController *controller,
                                  const GdkEvent     *event)
@@ -81,6 +195,9 @@ gtk_gesture_stylus_handle_event (GtkEventController *controller,
       return FALSE;
     }
 
+  if (GTK_GESTURE_STYLUS (controller)->collect_samples && n_signal != PROXIMITY)
+    gtk_gesture_stylus_collect_samples (GTK_GESTURE_STYLUS (controller), event, x, y);
+
   g_signal_emit (controller, signals[n_signal], 0, x, y);
 
   return TRUE;
@@ -89,11 +206,31 @@ gtk_gesture_stylus_handle_event (GtkEventController *controller,
 static void
 gtk_gesture_stylus_class_init (GtkGestureStylusClass *klass)
 {
+  GObjectClass *object_class = G_OBJECT_CLASS (klass);
   GtkEventControllerClass *event_controller_class;
 
+  object_class->get_property = gtk_gesture_stylus_get_property;
+  object_class->set_property = gtk_gesture_stylus_set_property;
+  object_class->finalize = gtk_gesture_stylus_finalize;
+
   event_controller_class = GTK_EVENT_CONTROLLER_CLASS (klass);
   event_controller_class->handle_event = gtk_gesture_stylus_handle_event;
 
+  /**
+   * GtkGestureStylus:collect-samples:
+   *
+   * Whether the gesture keeps all positions of the stylus while it
+   * is in contact, for reading them with gtk_gesture_stylus_peek_samples().
+   */
+  properties[PROP_COLLECT_SAMPLES] =
+      g_param_spec_boolean ("collect-samples",
+                            P_("Collect samples"),
+                            P_("Whether to keep all stylus positions"),
+                            FALSE,
+                            GTK_PARAM_READWRITE|G_PARAM_EXPLICIT_NOTIFY);
+
+  g_object_class_install_properties (object_class, LAST_PROP, properties);
+
   signals[PROXIMITY] =
     g_signal_new (I_("proximity"),
                   G_TYPE_FROM_CLASS (klass),
@@ -127,6 +264,7 @@ gtk_gesture_stylus_class_init (GtkGestureStylusClass *klass)
 static void
 gtk_gesture_stylus_init (GtkGestureStylus *gesture)
 {
+  gesture->samples = g_array_new (FALSE, FALSE, sizeof (GtkGestureStylusSample));
 }
 
 /**
@@ -322,3 +460,97 @@ gtk_gesture_stylus_get_device_tool (GtkGestureStylus *gesture)
 
   return gdk_event_get_device_tool (event);
 }
+
+/**
+ * gtk_gesture_stylus_set_collect_samples:
+ * @gesture: a #GtkGestureStylus
+ * @collect_samples: whether to collect samples
+ *
+ * Sets whether @gesture keeps all positions reported by the stylus
+ * while it is in contact, including the ones that were merged into
+ * a single motion event, together with their pressure and tilt.
+ *
+ * The collected samples can be read with gtk_gesture_stylus_peek_samples()
+ * and must be cleared with gtk_gesture_stylus_clear_samples() once they
+ * have been used. Disabling collection clears the samples.
+ **/
+void
+gtk_gesture_stylus_set_collect_samples (GtkGestureStylus *gesture,
+                                        gboolean          collect_samples)
+{
+  g_return_if_fail (GTK_IS_GESTURE_STYLUS (gesture));
+
+  collect_samples = collect_samples != FALSE;
+
+  if (gesture->collect_samples == collect_samples)
+    return;
+
+  gesture->collect_samples = collect_samples;
+  if (!collect_samples)
+    gtk_gesture_stylus_clear_samples (gesture);
+
+  g_object_notify_by_pspec (G_OBJECT (gesture), properties[PROP_COLLECT_SAMPLES]);
+}
+
+/**
+ * gtk_gesture_stylus_get_collect_samples:
+ * @gesture: a #GtkGestureStylus
+ *
+ * Returns whether @gesture collects samples.
+ * See gtk_gesture_stylus_set_collect_samples().
+ *
+ * Returns: %TRUE if @gesture collects samples
+ **/
+gboolean
+gtk_gesture_stylus_get_collect_samples (GtkGestureStylus *gesture)
+{
+  g_return_val_if_fail (GTK_IS_GESTURE_STYLUS (gesture), FALSE);
+
+  return gesture->collect_samples;
+}
+
+/**
+ * gtk_gesture_stylus_peek_samples:
+ * @gesture: a #GtkGestureStylus
+ * @n_samples: (out): return location for the number of samples
+ *
+ * Returns the samples collected since the last call to
+ * gtk_gesture_stylus_clear_samples(), in chronological order.
+ *
+ * The returned array is owned by @gesture and is only valid
+ * until the next event is handled by @gesture, so it is typically
+ * consumed in one go, for example once per frame from a tick
+ * callback, followed by gtk_gesture_stylus_clear_samples().
+ *
+ * Returns: (array length=n_samples) (transfer none) (nullable): the
+ *   collected samples
+ **/
+const GtkGestureStylusSample *
+gtk_gesture_stylus_peek_samples (GtkGestureStylus *gesture,
+                                 guint            *n_samples)
+{
+  g_return_val_if_fail (GTK_IS_GESTURE_STYLUS (gesture), NULL);
+  g_return_val_if_fail (n_samples != NULL, NULL);
+
+  *n_samples = gesture->samples->len;
+  if (gesture->samples->len == 0)
+    return NULL;
+
+  return (const GtkGestureStylusSample *) gesture->samples->data;
+}
+
+/**
+ * gtk_gesture_stylus_clear_samples:
+ * @gesture: a #GtkGestureStylus
+ *
+ * Discards the samples collected by @gesture. The memory used for
+ * them is kept around, so collecting samples at a steady rate does
+ * not allocate memory.
+ **/
+void
+gtk_gesture_stylus_clear_samples (GtkGestureStylus *gesture)
+{
+  g_return_if_fail (GTK_IS_GESTURE_STYLUS (gesture));
+
+  g_array_set_size (gesture->samples, 0);
+}
@@ -36,6 +36,29 @@ G_BEGIN_DECLS
 
 typedef struct _GtkGestureStylus GtkGestureStylus;
 typedef struct _GtkGestureStylusClass GtkGestureStylusClass;
+typedef struct _GtkGestureStylusSample GtkGestureStylusSample;
+
+/**
+ * GtkGestureStylusSample:
+ * @time: the timestamp of the sample
+ * @x: the X coordinate, relative to the widget of the gesture
+ * @y: the Y coordinate, relative to the widget of the gesture
+ * @pressure: the pressure, between 0 and 1
+ * @xtilt: the tilt in the X direction, between -1 and 1
+ * @ytilt: the tilt in the Y direction, between -1 and 1
+ *
+ * A single stylus position, as collected by #GtkGestureStylus
+ * when #GtkGestureStylus:collect-samples is enabled.
+ */
+struct _GtkGestureStylusSample
+{
+  guint32 time;
+  gdouble x;
+  gdouble y;
+  gdouble pressure;
+  gdouble xtilt;
+  gdouble ytilt;
+};
 
 GDK_AVAILABLE_IN_ALL
 GType             gtk_gesture_stylus_get_type (void) G_GNUC_CONST;
@@ -58,6 +81,18 @@ gboolean          gtk_gesture_stylus_get_backlog (GtkGestureStylus  *gesture,
 GDK_AVAILABLE_IN_ALL
 GdkDeviceTool *   gtk_gesture_stylus_get_device_tool (GtkGestureStylus *gesture);
 
+GDK_AVAILABLE_IN_ALL
+void              gtk_gesture_stylus_set_collect_samples (GtkGestureStylus *gesture,
+                                                          gboolean          collect_samples);
+GDK_AVAILABLE_IN_ALL
+gboolean          gtk_gesture_stylus_get_collect_samples (GtkGestureStylus *gesture);
+GDK_AVAILABLE_IN_ALL
+const GtkGestureStylusSample *
+                  gtk_gesture_stylus_peek_samples        (GtkGestureStylus *gesture,
+                                                          guint            *n_samples);
+GDK_AVAILABLE_IN_ALL
+void              gtk_gesture_stylus_clear_samples       (GtkGestureStylus *gesture);
+
 G_END_DECLS
 
 #endif /* __GTK_GESTURE_STYLUS_H__ */
@@ -25,6 +25,9 @@
 struct _GtkGestureStylus
 {
   GtkGestureSingle parent_instance;
+
+  GArray *samples; /* GtkGestureStylusSample */
+  guint collect_samples : 1;
 };
 
 struct _GtkGestureStylusClass
@@ -50,8 +50,8 @@ typedef struct _EventData EventData;
 struct _EventData
 {
   guint32 evtime;
-  int x;
-  int y;
+  gdouble x;
+  gdouble y;
 };
 
 struct _GtkGestureSwipePrivate
@@ -155,9 +155,11 @@ _gtk_gesture_swipe_calculate_velocity (GtkGestureSwipe *gesture,
 {
   GtkGestureSwipePrivate *priv;
   GdkEventSequence *sequence;
-  guint32 evtime, diff_time;
-  EventData *start, *end;
-  gdouble diff_x, diff_y;
+  guint32 evtime;
+  EventData *start, *data;
+  gdouble mean_t, mean_x, mean_y;
+  gdouble var_t, cov_x, cov_y, t;
+  guint i, n;
 
   priv = gtk_gesture_swipe_get_instance_private (gesture);
   *velocity_x = *velocity_y = 0;
@@ -166,22 +168,44 @@ _gtk_gesture_swipe_calculate_velocity (GtkGestureSwipe *gesture,
   _gtk_gesture_get_last_update_time (GTK_GESTURE (gesture), sequence, &evtime);
   _gtk_gesture_swipe_clear_backlog (gesture, evtime);
 
-  if (priv->events->len == 0)
+  n = priv->events->len;
+  if (n < 2)
     return;
 
+  /* Fit a line through all the recent samples instead of only looking
+   * at the first and last one, so a single jittery event doesn't throw
+   * off the result much */
   start = &g_array_index (priv->events, EventData, 0);
-  end = &g_array_index (priv->events, EventData, priv->events->len - 1);
+  mean_t = mean_x = mean_y = 0;
+
+  for (i = 0; i < n; i++)
+    {
+      data = &g_array_index (priv->events, EventData, i);
+      mean_t += data->evtime - start->evtime;
+      mean_x += data->x;
+      mean_y += data->y;
+    }
 
-  diff_time = end->evtime - start->evtime;
-  diff_x = end->x - start->x;
-  diff_y = end->y - start->y;
+  mean_t /= n;
+  mean_x /= n;
+  mean_y /= n;
+  var_t = cov_x = cov_y = 0;
+
+  for (i = 0; i < n; i++)
+    {
+      data = &g_array_index (priv->events, EventData, i);
+      t = (data->evtime - start->evtime) - mean_t;
+      var_t += t * t;
+      cov_x += t * (data->x - mean_x);
+      cov_y += t * (data->y - mean_y);
+    }
 
-  if (diff_time == 0)
+  if (var_t == 0)
     return;
 
   /* Velocity in pixels/sec */
-  *velocity_x = diff_x * 1000 / diff_time;
-  *velocity_y = diff_y * 1000 / diff_time;
+  *velocity_x = cov_x * 1000 / var_t;
+  *velocity_y = cov_y * 1000 / var_t;
 }
 
 static void
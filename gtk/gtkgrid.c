@@ -22,6 +22,8 @@
 
 #include "gtkgrid.h"
 
+#include "gtkcssnodeprivate.h"
+#include "gtklayoutitemprivate.h"
 #include "gtkorientableprivate.h"
 #include "gtksizerequest.h"
 #include "gtkwidgetprivate.h"
@@ -84,6 +86,13 @@ static const GtkGridRowProperties gtk_grid_row_properties_default = {
 struct _GtkGridChild
 {
   GtkGridChildAttach attach[2];
+
+  /* Exactly one of these is set */
+  GtkWidget *widget;
+  GtkLayoutItem *item;
+
+  /* Only used for layout items */
+  GtkAllocation allocation;
 };
 
 #define CHILD_LEFT(child)    ((child)->attach[GTK_ORIENTATION_HORIZONTAL].pos)
@@ -104,6 +113,9 @@ struct _GtkGridPrivate
 {
   GList *row_properties;
 
+  GPtrArray *items;
+  GHashTable *item_nodes;
+
   GtkOrientation orientation;
   gint baseline_row;
 
@@ -146,6 +158,7 @@ struct _GtkGridLines
 struct _GtkGridRequest
 {
   GtkGrid *grid;
+  GPtrArray *children;
   GtkGridLines lines[2];
 };
 
@@ -285,6 +298,103 @@ get_grid_child (GtkWidget *widget)
   return (GtkGridChild *) g_object_get_qdata (G_OBJECT (widget), child_data_quark);
 }
 
+/* Returns the widget and layout item children of @grid,
+ * for code that doesn't care about the difference.
+ */
+static GPtrArray *
+gtk_grid_collect_children (GtkGrid *grid)
+{
+  GtkGridPrivate *priv = gtk_grid_get_instance_private (grid);
+  GPtrArray *children;
+  GtkWidget *child;
+  guint i;
+
+  children = g_ptr_array_new ();
+
+  for (child = gtk_widget_get_first_child (GTK_WIDGET (grid));
+       child != NULL;
+       child = gtk_widget_get_next_sibling (child))
+    g_ptr_array_add (children, get_grid_child (child));
+
+  if (priv->items)
+    {
+      for (i = 0; i < priv->items->len; i++)
+        g_ptr_array_add (children, g_ptr_array_index (priv->items, i));
+    }
+
+  return children;
+}
+
+static gboolean
+gtk_grid_has_children (GtkGrid *grid)
+{
+  GtkGridPrivate *priv = gtk_grid_get_instance_private (grid);
+
+  return gtk_widget_get_first_child (GTK_WIDGET (grid)) != NULL ||
+         (priv->items != NULL && priv->items->len > 0);
+}
+
+static gboolean
+grid_child_get_visible (GtkGridChild *grid_child)
+{
+  if (grid_child->widget)
+    return _gtk_widget_get_visible (grid_child->widget);
+
+  return TRUE;
+}
+
+static gboolean
+grid_child_compute_expand (GtkGridChild   *grid_child,
+                           GtkOrientation  orientation)
+{
+  if (grid_child->widget)
+    return gtk_widget_compute_expand (grid_child->widget, orientation);
+
+  return FALSE;
+}
+
+static void
+item_node_free (gpointer data)
+{
+  GtkCssNode *node = data;
+
+  gtk_css_node_set_parent (node, NULL);
+  g_object_unref (node);
+}
+
+/* All layout items with the same style class share one
+ * CSS node, so that massive amounts of items don't cost
+ * a style lookup each.
+ */
+static GtkCssNode *
+get_item_node (GtkGrid       *grid,
+               GtkLayoutItem *item)
+{
+  GtkGridPrivate *priv = gtk_grid_get_instance_private (grid);
+  GtkCssNode *widget_node;
+  GtkCssNode *node;
+
+  if (priv->item_nodes == NULL)
+    priv->item_nodes = g_hash_table_new_full (NULL, NULL, NULL, item_node_free);
+
+  node = g_hash_table_lookup (priv->item_nodes, GUINT_TO_POINTER (item->style_class));
+  if (node)
+    return node;
+
+  widget_node = gtk_widget_get_css_node (GTK_WIDGET (grid));
+
+  node = gtk_css_node_new ();
+  gtk_css_node_set_name (node, I_("item"));
+  if (item->style_class)
+    gtk_css_node_add_class (node, item->style_class);
+  gtk_css_node_set_parent (node, widget_node);
+  gtk_css_node_set_state (node, gtk_css_node_get_state (widget_node));
+
+  g_hash_table_insert (priv->item_nodes, GUINT_TO_POINTER (item->style_class), node);
+
+  return node;
+}
+
 static void
 gtk_grid_get_child_property (GtkContainer *container,
                              GtkWidget    *child,
@@ -380,6 +490,22 @@ gtk_grid_finalize (GObject *object)
 
   g_list_free_full (priv->row_properties, (GDestroyNotify)gtk_grid_row_properties_free);
 
+  if (priv->items)
+    {
+      guint i;
+
+      for (i = 0; i < priv->items->len; i++)
+        {
+          GtkGridChild *grid_child = g_ptr_array_index (priv->items, i);
+
+          gtk_layout_item_set_host (grid_child->item, NULL);
+          gtk_layout_item_unref (grid_child->item);
+        }
+      g_ptr_array_unref (priv->items);
+    }
+
+  g_clear_pointer (&priv->item_nodes, g_hash_table_unref);
+
   G_OBJECT_CLASS (gtk_grid_parent_class)->finalize (object);
 }
 
@@ -398,6 +524,8 @@ grid_attach (GtkGrid   *grid,
   CHILD_TOP (child) = top;
   CHILD_WIDTH (child) = width;
   CHILD_HEIGHT (child) = height;
+  child->widget = widget;
+  child->item = NULL;
 
   g_object_set_qdata_full (G_OBJECT (widget), child_data_quark, child, g_free);
 
@@ -420,7 +548,8 @@ find_attach_position (GtkGrid         *grid,
 {
   GtkGridChildAttach *attach;
   GtkGridChildAttach *opposite;
-  GtkWidget *child;
+  GPtrArray *children;
+  guint c;
   gint pos;
   gboolean hit;
 
@@ -431,11 +560,11 @@ find_attach_position (GtkGrid         *grid,
 
   hit = FALSE;
 
-  for (child = gtk_widget_get_first_child (GTK_WIDGET (grid));
-       child != NULL;
-       child = gtk_widget_get_next_sibling (child))
+  children = gtk_grid_collect_children (grid);
+
+  for (c = 0; c < children->len; c++)
     {
-      GtkGridChild *grid_child = get_grid_child (child);
+      GtkGridChild *grid_child = g_ptr_array_index (children, c);
 
       attach = &grid_child->attach[orientation];
       opposite = &grid_child->attach[1 - orientation];
@@ -452,6 +581,8 @@ find_attach_position (GtkGrid         *grid,
         }
      }
 
+  g_ptr_array_unref (children);
+
   if (!hit)
     pos = 0;
 
@@ -530,18 +661,16 @@ get_spacing (GtkGrid        *grid,
 static void
 gtk_grid_request_count_lines (GtkGridRequest *request)
 {
-  GtkWidget *child;
+  guint c;
   gint min[2];
   gint max[2];
 
   min[0] = min[1] = G_MAXINT;
   max[0] = max[1] = G_MININT;
 
-  for (child = gtk_widget_get_first_child (GTK_WIDGET (request->grid));
-       child != NULL;
-       child = gtk_widget_get_next_sibling (child))
+  for (c = 0; c < request->children->len; c++)
     {
-      GtkGridChild *grid_child = get_grid_child (child);
+      GtkGridChild *grid_child = g_ptr_array_index (request->children, c);
       GtkGridChildAttach *attach = grid_child->attach;
 
       min[0] = MIN (min[0], attach[0].pos);
@@ -563,7 +692,7 @@ static void
 gtk_grid_request_init (GtkGridRequest *request,
                        GtkOrientation  orientation)
 {
-  GtkWidget *child;
+  guint c;
   GtkGridChildAttach *attach;
   GtkGridLines *lines;
   gint i;
@@ -583,14 +712,12 @@ gtk_grid_request_init (GtkGridRequest *request,
     }
 
 
-  for (child = gtk_widget_get_first_child (GTK_WIDGET (request->grid));
-       child != NULL;
-       child = gtk_widget_get_next_sibling (child))
+  for (c = 0; c < request->children->len; c++)
     {
-      GtkGridChild *grid_child = get_grid_child (child);
+      GtkGridChild *grid_child = g_ptr_array_index (request->children, c);
 
       attach = &grid_child->attach[orientation];
-      if (attach->span == 1 && gtk_widget_compute_expand (child, orientation))
+      if (attach->span == 1 && grid_child_compute_expand (grid_child, orientation))
         lines->lines[attach->pos - lines->min].expand = TRUE;
     }
 }
@@ -623,7 +750,6 @@ compute_allocation_for_child (GtkGridRequest *request,
 
 static void
 compute_request_for_child (GtkGridRequest *request,
-                           GtkWidget      *child,
                            GtkGridChild   *grid_child,
                            GtkOrientation  orientation,
                            gboolean        contextual,
@@ -632,18 +758,21 @@ compute_request_for_child (GtkGridRequest *request,
 			   gint           *minimum_baseline,
                            gint           *natural_baseline)
 {
+  gint size;
+
   if (minimum_baseline)
     *minimum_baseline = -1;
   if (natural_baseline)
     *natural_baseline = -1;
 
   if (contextual)
-    {
-      gint size;
-
-      size = compute_allocation_for_child (request, grid_child, 1 - orientation);
+    size = compute_allocation_for_child (request, grid_child, 1 - orientation);
+  else
+    size = -1;
 
-      gtk_widget_measure (child,
+  if (grid_child->widget)
+    {
+      gtk_widget_measure (grid_child->widget,
                           orientation,
                           size,
                           minimum, natural,
@@ -651,11 +780,15 @@ compute_request_for_child (GtkGridRequest *request,
     }
   else
     {
-      gtk_widget_measure (child,
-                          orientation,
-                          -1,
-                          minimum, natural,
-                          minimum_baseline, natural_baseline);
+      GtkStyleContext *context;
+
+      /* Layout items don't have baselines */
+      context = gtk_widget_get_style_context (GTK_WIDGET (request->grid));
+      gtk_style_context_save_to_node (context, get_item_node (request->grid, grid_child->item));
+      gtk_layout_item_measure (grid_child->item, context,
+                               orientation, size,
+                               minimum, natural);
+      gtk_style_context_restore (context);
     }
 }
 
@@ -668,7 +801,7 @@ gtk_grid_request_non_spanning (GtkGridRequest *request,
                                GtkOrientation  orientation,
                                gboolean        contextual)
 {
-  GtkWidget *child;
+  guint c;
   GtkGridChildAttach *attach;
   GtkGridLines *lines;
   GtkGridLine *line;
@@ -679,20 +812,18 @@ gtk_grid_request_non_spanning (GtkGridRequest *request,
 
   lines = &request->lines[orientation];
 
-  for (child = gtk_widget_get_first_child (GTK_WIDGET (request->grid));
-       child != NULL;
-       child = gtk_widget_get_next_sibling (child))
+  for (c = 0; c < request->children->len; c++)
     {
-      GtkGridChild *grid_child = get_grid_child (child);
+      GtkGridChild *grid_child = g_ptr_array_index (request->children, c);
 
-      if (!_gtk_widget_get_visible (child))
+      if (!grid_child_get_visible (grid_child))
         continue;
 
       attach = &grid_child->attach[orientation];
       if (attach->span != 1)
         continue;
 
-      compute_request_for_child (request, child, grid_child, orientation, contextual, &minimum, &natural, &minimum_baseline, &natural_baseline);
+      compute_request_for_child (request, grid_child, orientation, contextual, &minimum, &natural, &minimum_baseline, &natural_baseline);
 
       line = &lines->lines[attach->pos - lines->min];
 
@@ -795,7 +926,7 @@ gtk_grid_request_spanning (GtkGridRequest *request,
                            gboolean        contextual)
 {
   GtkGridPrivate *priv = gtk_grid_get_instance_private (request->grid);
-  GtkWidget *child;
+  guint c;
   GtkGridChildAttach *attach;
   GtkGridLineData *linedata;
   GtkGridLines *lines;
@@ -816,13 +947,11 @@ gtk_grid_request_spanning (GtkGridRequest *request,
   lines = &request->lines[orientation];
   spacing = get_spacing (request->grid, orientation);
 
-  for (child = gtk_widget_get_first_child (GTK_WIDGET (request->grid));
-       child != NULL;
-       child = gtk_widget_get_next_sibling (child))
+  for (c = 0; c < request->children->len; c++)
     {
-      GtkGridChild *grid_child = get_grid_child (child);
+      GtkGridChild *grid_child = g_ptr_array_index (request->children, c);
 
-      if (!_gtk_widget_get_visible (child))
+      if (!grid_child_get_visible (grid_child))
         continue;
 
       attach = &grid_child->attach[orientation];
@@ -830,7 +959,7 @@ gtk_grid_request_spanning (GtkGridRequest *request,
         continue;
 
       /* We ignore baselines for spanning children */
-      compute_request_for_child (request, child, grid_child, orientation, contextual, &minimum, &natural, NULL, NULL);
+      compute_request_for_child (request, grid_child, orientation, contextual, &minimum, &natural, NULL, NULL);
 
       span_minimum = (attach->span - 1) * spacing;
       span_natural = (attach->span - 1) * spacing;
@@ -935,7 +1064,7 @@ gtk_grid_request_compute_expand (GtkGridRequest *request,
                                  gint           *nonempty_lines,
                                  gint           *expand_lines)
 {
-  GtkWidget *child;
+  guint c;
   GtkGridChildAttach *attach;
   gint i;
   GtkGridLines *lines;
@@ -956,13 +1085,11 @@ gtk_grid_request_compute_expand (GtkGridRequest *request,
       lines->lines[i].empty = TRUE;
     }
 
-  for (child = gtk_widget_get_first_child (GTK_WIDGET (request->grid));
-       child != NULL;
-       child = gtk_widget_get_next_sibling (child))
+  for (c = 0; c < request->children->len; c++)
     {
-      GtkGridChild *grid_child = get_grid_child (child);
+      GtkGridChild *grid_child = g_ptr_array_index (request->children, c);
 
-      if (!_gtk_widget_get_visible (child))
+      if (!grid_child_get_visible (grid_child))
         continue;
 
       attach = &grid_child->attach[orientation];
@@ -974,17 +1101,15 @@ gtk_grid_request_compute_expand (GtkGridRequest *request,
 
       line = &lines->lines[attach->pos - lines->min];
       line->empty = FALSE;
-      if (gtk_widget_compute_expand (child, orientation))
+      if (grid_child_compute_expand (grid_child, orientation))
         line->expand = TRUE;
     }
 
-  for (child = gtk_widget_get_first_child (GTK_WIDGET (request->grid));
-       child != NULL;
-       child = gtk_widget_get_next_sibling (child))
+  for (c = 0; c < request->children->len; c++)
     {
-      GtkGridChild *grid_child = get_grid_child (child);
+      GtkGridChild *grid_child = g_ptr_array_index (request->children, c);
 
-      if (!_gtk_widget_get_visible (child))
+      if (!grid_child_get_visible (grid_child))
         continue;
 
       attach = &grid_child->attach[orientation];
@@ -1005,7 +1130,7 @@ gtk_grid_request_compute_expand (GtkGridRequest *request,
           line->empty = FALSE;
         }
 
-      if (!has_expand && gtk_widget_compute_expand (child, orientation))
+      if (!has_expand && grid_child_compute_expand (grid_child, orientation))
         {
           for (i = 0; i < attach->span; i++)
             {
@@ -1409,10 +1534,11 @@ gtk_grid_get_size (GtkGrid        *grid,
   if (natural_baseline)
     *natural_baseline = -1;
 
-  if (gtk_widget_get_first_child (GTK_WIDGET (grid)) == NULL)
+  if (!gtk_grid_has_children (grid))
     return;
 
   request.grid = grid;
+  request.children = gtk_grid_collect_children (grid);
   gtk_grid_request_count_lines (&request);
   lines = &request.lines[orientation];
   lines->lines = g_newa (GtkGridLine, lines->max - lines->min);
@@ -1421,6 +1547,8 @@ gtk_grid_get_size (GtkGrid        *grid,
   gtk_grid_request_run (&request, orientation, FALSE);
   gtk_grid_request_sum (&request, orientation, minimum, natural,
 			minimum_baseline, natural_baseline);
+
+  g_ptr_array_unref (request.children);
 }
 
 static void
@@ -1445,10 +1573,11 @@ gtk_grid_get_size_for_size (GtkGrid        *grid,
   if (natural_baseline)
     *natural_baseline = -1;
 
-  if (gtk_widget_get_first_child (GTK_WIDGET (grid)) == NULL)
+  if (!gtk_grid_has_children (grid))
     return;
 
   request.grid = grid;
+  request.children = gtk_grid_collect_children (grid);
   gtk_grid_request_count_lines (&request);
   lines = &request.lines[0];
   lines->lines = g_newa (GtkGridLine, lines->max - lines->min);
@@ -1463,6 +1592,8 @@ gtk_grid_get_size_for_size (GtkGrid        *grid,
 
   gtk_grid_request_run (&request, orientation, TRUE);
   gtk_grid_request_sum (&request, orientation, minimum, natural, minimum_baseline, natural_baseline);
+
+  g_ptr_array_unref (request.children);
 }
 
 static void
@@ -1476,6 +1607,8 @@ gtk_grid_measure (GtkWidget     *widget,
 {
   GtkGrid *grid = GTK_GRID (widget);
 
+  gtk_widget_premeasure_children (widget);
+
   if ((orientation == GTK_ORIENTATION_HORIZONTAL &&
        gtk_widget_get_request_mode (widget) == GTK_SIZE_REQUEST_WIDTH_FOR_HEIGHT) ||
       (orientation == GTK_ORIENTATION_VERTICAL &&
@@ -1488,7 +1621,6 @@ gtk_grid_measure (GtkWidget     *widget,
 static void
 allocate_child (GtkGridRequest *request,
                 GtkOrientation  orientation,
-                GtkWidget      *child,
                 GtkGridChild   *grid_child,
                 gint           *position,
                 gint           *size,
@@ -1503,7 +1635,9 @@ allocate_child (GtkGridRequest *request,
   attach = &grid_child->attach[orientation];
 
   *position = lines->lines[attach->pos - lines->min].position;
-  if (attach->span == 1 && gtk_widget_get_valign (child) == GTK_ALIGN_BASELINE)
+  if (attach->span == 1 &&
+      grid_child->widget != NULL &&
+      gtk_widget_get_valign (grid_child->widget) == GTK_ALIGN_BASELINE)
     *baseline = lines->lines[attach->pos - lines->min].allocated_baseline;
   else
     *baseline = -1;
@@ -1521,22 +1655,20 @@ gtk_grid_request_allocate_children (GtkGridRequest *request,
                                     int             grid_width,
                                     int             grid_height)
 {
-  GtkWidget *child;
+  guint c;
   GtkAllocation child_allocation;
   gint x, y, width, height, baseline, ignore;
 
 
-  for (child = gtk_widget_get_first_child (GTK_WIDGET (request->grid));
-       child != NULL;
-       child = gtk_widget_get_next_sibling (child))
+  for (c = 0; c < request->children->len; c++)
     {
-      GtkGridChild *grid_child = get_grid_child (child);
+      GtkGridChild *grid_child = g_ptr_array_index (request->children, c);
 
-      if (!_gtk_widget_get_visible (child))
+      if (!grid_child_get_visible (grid_child))
         continue;
 
-      allocate_child (request, GTK_ORIENTATION_HORIZONTAL, child, grid_child, &x, &width, &ignore);
-      allocate_child (request, GTK_ORIENTATION_VERTICAL, child, grid_child, &y, &height, &baseline);
+      allocate_child (request, GTK_ORIENTATION_HORIZONTAL, grid_child, &x, &width, &ignore);
+      allocate_child (request, GTK_ORIENTATION_VERTICAL, grid_child, &y, &height, &baseline);
 
       child_allocation.x = x;
       child_allocation.y = y;
@@ -1546,7 +1678,10 @@ gtk_grid_request_allocate_children (GtkGridRequest *request,
       if (_gtk_widget_get_direction (GTK_WIDGET (request->grid)) == GTK_TEXT_DIR_RTL)
         child_allocation.x = grid_width - child_allocation.x - child_allocation.width;
 
-      gtk_widget_size_allocate (child, &child_allocation, baseline);
+      if (grid_child->widget)
+        gtk_widget_size_allocate (grid_child->widget, &child_allocation, baseline);
+      else
+        grid_child->allocation = child_allocation;
     }
 }
 
@@ -1563,10 +1698,11 @@ gtk_grid_size_allocate (GtkWidget *widget,
   GtkGridLines *lines;
   GtkOrientation orientation;
 
-  if (gtk_widget_get_first_child (widget) == NULL)
+  if (!gtk_grid_has_children (grid))
     return;
 
   request.grid = grid;
+  request.children = gtk_grid_collect_children (grid);
 
   gtk_grid_request_count_lines (&request);
   lines = &request.lines[0];
@@ -1591,6 +1727,78 @@ gtk_grid_size_allocate (GtkWidget *widget,
   gtk_grid_request_position (&request, 1);
 
   gtk_grid_request_allocate_children (&request, width, height);
+
+  g_ptr_array_unref (request.children);
+}
+
+static void
+gtk_grid_snapshot (GtkWidget   *widget,
+                   GtkSnapshot *snapshot)
+{
+  GtkGrid *grid = GTK_GRID (widget);
+  GtkGridPrivate *priv = gtk_grid_get_instance_private (grid);
+
+  if (priv->items && priv->items->len > 0)
+    {
+      GtkStyleContext *context;
+      GtkCssNode *saved_node = NULL;
+      guint i;
+
+      context = gtk_widget_get_style_context (widget);
+
+      for (i = 0; i < priv->items->len; i++)
+        {
+          GtkGridChild *grid_child = g_ptr_array_index (priv->items, i);
+          GtkCssNode *node;
+
+          if (grid_child->allocation.width <= 0 || grid_child->allocation.height <= 0)
+            continue;
+
+          /* Only switch style when the shared node changes */
+          node = get_item_node (grid, grid_child->item);
+          if (node != saved_node)
+            {
+              if (saved_node)
+                gtk_style_context_restore (context);
+              gtk_style_context_save_to_node (context, node);
+              saved_node = node;
+            }
+
+          gtk_layout_item_snapshot (grid_child->item, context, snapshot,
+                                    grid_child->allocation.x,
+                                    grid_child->allocation.y,
+                                    grid_child->allocation.width,
+                                    grid_child->allocation.height);
+        }
+
+      if (saved_node)
+        gtk_style_context_restore (context);
+    }
+
+  GTK_WIDGET_CLASS (gtk_grid_parent_class)->snapshot (widget, snapshot);
+}
+
+static void
+gtk_grid_state_flags_changed (GtkWidget     *widget,
+                              GtkStateFlags  previous_state)
+{
+  GtkGrid *grid = GTK_GRID (widget);
+  GtkGridPrivate *priv = gtk_grid_get_instance_private (grid);
+
+  if (priv->item_nodes)
+    {
+      GtkStateFlags state;
+      GHashTableIter iter;
+      gpointer node;
+
+      state = gtk_css_node_get_state (gtk_widget_get_css_node (widget));
+
+      g_hash_table_iter_init (&iter, priv->item_nodes);
+      while (g_hash_table_iter_next (&iter, NULL, &node))
+        gtk_css_node_set_state (node, state);
+    }
+
+  GTK_WIDGET_CLASS (gtk_grid_parent_class)->state_flags_changed (widget, previous_state);
 }
 
 static void
@@ -1606,6 +1814,8 @@ gtk_grid_class_init (GtkGridClass *class)
 
   widget_class->size_allocate = gtk_grid_size_allocate;
   widget_class->measure = gtk_grid_measure;
+  widget_class->snapshot = gtk_grid_snapshot;
+  widget_class->state_flags_changed = gtk_grid_state_flags_changed;
 
   container_class->add = gtk_grid_add;
   container_class->remove = gtk_grid_remove;
@@ -1847,6 +2057,133 @@ gtk_grid_attach_next_to (GtkGrid         *grid,
   grid_attach (grid, child, left, top, width, height);
 }
 
+/**
+ * gtk_grid_attach_item:
+ * @grid: a #GtkGrid
+ * @item: the #GtkLayoutItem to add
+ * @left: the column number to attach the left side of @item to
+ * @top: the row number to attach the top side of @item to
+ * @width: the number of columns that @item will span
+ * @height: the number of rows that @item will span
+ *
+ * Adds a layout item to the grid. Layout items take part in
+ * the grid layout like child widgets, but are much cheaper to
+ * create, measure and draw. See #GtkLayoutItem.
+ *
+ * Layout items are always visible, never expand and are not
+ * baseline aligned. A layout item can only be added to a single
+ * container at a time.
+ */
+void
+gtk_grid_attach_item (GtkGrid       *grid,
+                      GtkLayoutItem *item,
+                      gint           left,
+                      gint           top,
+                      gint           width,
+                      gint           height)
+{
+  GtkGridPrivate *priv = gtk_grid_get_instance_private (grid);
+  GtkGridChild *child;
+
+  g_return_if_fail (GTK_IS_GRID (grid));
+  g_return_if_fail (item != NULL);
+  g_return_if_fail (gtk_layout_item_get_host (item) == NULL);
+  g_return_if_fail (width > 0);
+  g_return_if_fail (height > 0);
+
+  child = g_new0 (GtkGridChild, 1);
+  CHILD_LEFT (child) = left;
+  CHILD_TOP (child) = top;
+  CHILD_WIDTH (child) = width;
+  CHILD_HEIGHT (child) = height;
+  child->item = gtk_layout_item_ref (item);
+
+  if (priv->items == NULL)
+    priv->items = g_ptr_array_new_with_free_func (g_free);
+  g_ptr_array_add (priv->items, child);
+
+  gtk_layout_item_set_host (item, GTK_WIDGET (grid));
+
+  gtk_widget_queue_resize (GTK_WIDGET (grid));
+}
+
+/**
+ * gtk_grid_remove_item:
+ * @grid: a #GtkGrid
+ * @item: a #GtkLayoutItem that was added with gtk_grid_attach_item()
+ *
+ * Removes a layout item from the grid.
+ */
+void
+gtk_grid_remove_item (GtkGrid       *grid,
+                      GtkLayoutItem *item)
+{
+  GtkGridPrivate *priv = gtk_grid_get_instance_private (grid);
+  guint i;
+
+  g_return_if_fail (GTK_IS_GRID (grid));
+  g_return_if_fail (item != NULL);
+  g_return_if_fail (gtk_layout_item_get_host (item) == GTK_WIDGET (grid));
+
+  for (i = 0; i < priv->items->len; i++)
+    {
+      GtkGridChild *grid_child = g_ptr_array_index (priv->items, i);
+
+      if (grid_child->item == item)
+        {
+          gtk_layout_item_set_host (item, NULL);
+          g_ptr_array_remove_index (priv->items, i);
+          gtk_layout_item_unref (item);
+          break;
+        }
+    }
+
+  gtk_widget_queue_resize (GTK_WIDGET (grid));
+}
+
+/* Moves and resizes layout items for a row or column that
+ * is inserted or removed at @position. This mirrors what
+ * gtk_grid_insert_row() and friends do for child widgets.
+ */
+static void
+gtk_grid_update_items (GtkGrid        *grid,
+                       GtkOrientation  orientation,
+                       gint            position,
+                       gboolean        insert)
+{
+  GtkGridPrivate *priv = gtk_grid_get_instance_private (grid);
+  guint i;
+
+  if (priv->items == NULL)
+    return;
+
+  for (i = priv->items->len; i > 0; i--)
+    {
+      GtkGridChild *grid_child = g_ptr_array_index (priv->items, i - 1);
+      GtkGridChildAttach *attach = &grid_child->attach[orientation];
+
+      if (insert)
+        {
+          if (attach->pos >= position)
+            attach->pos += 1;
+          else if (attach->pos + attach->span > position)
+            attach->span += 1;
+        }
+      else
+        {
+          if (attach->pos <= position && attach->pos + attach->span > position)
+            attach->span -= 1;
+          if (attach->pos > position)
+            attach->pos -= 1;
+
+          if (attach->span <= 0)
+            gtk_grid_remove_item (grid, grid_child->item);
+        }
+    }
+
+  gtk_widget_queue_resize (GTK_WIDGET (grid));
+}
+
 /**
  * gtk_grid_get_child_at:
  * @grid: a #GtkGrid
@@ -1937,6 +2274,8 @@ gtk_grid_insert_row (GtkGrid *grid,
       if (prop->row >= position)
 	prop->row += 1;
     }
+
+  gtk_grid_update_items (grid, GTK_ORIENTATION_VERTICAL, position, TRUE);
 }
 
 /**
@@ -1983,6 +2322,8 @@ gtk_grid_remove_row (GtkGrid *grid,
                                  NULL);
       child = next;
     }
+
+  gtk_grid_update_items (grid, GTK_ORIENTATION_VERTICAL, position, FALSE);
 }
 
 /**
@@ -2029,6 +2370,8 @@ gtk_grid_insert_column (GtkGrid *grid,
                                                child_properties[CHILD_PROP_WIDTH]);
         }
     }
+
+  gtk_grid_update_items (grid, GTK_ORIENTATION_HORIZONTAL, position, TRUE);
 }
 
 /**
@@ -2076,6 +2419,8 @@ gtk_grid_remove_column (GtkGrid *grid,
 
       child = next;
     }
+
+  gtk_grid_update_items (grid, GTK_ORIENTATION_HORIZONTAL, position, FALSE);
 }
 
 /**
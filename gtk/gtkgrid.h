@@ -25,6 +25,7 @@
 #endif
 
 #include <gtk/gtkcontainer.h>
+#include <gtk/gtklayoutitem.h>
 
 
 G_BEGIN_DECLS
@@ -85,6 +86,16 @@ void       gtk_grid_attach_next_to         (GtkGrid         *grid,
                                             gint             width,
                                             gint             height);
 GDK_AVAILABLE_IN_ALL
+void       gtk_grid_attach_item            (GtkGrid         *grid,
+                                            GtkLayoutItem   *item,
+                                            gint             left,
+                                            gint             top,
+                                            gint             width,
+                                            gint             height);
+GDK_AVAILABLE_IN_ALL
+void       gtk_grid_remove_item            (GtkGrid         *grid,
+                                            GtkLayoutItem   *item);
+GDK_AVAILABLE_IN_ALL
 GtkWidget *gtk_grid_get_child_at           (GtkGrid         *grid,
                                             gint             left,
                                             gint             top);
@@ -0,0 +1,750 @@
+/* GTK - The GIMP Toolkit
+ * Copyright (C) 2018 Red Hat, Inc.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "config.h"
+
+#include "gtkgridview.h"
+
+#include "gtkadjustment.h"
+#include "gtkintl.h"
+#include "gtklistitemfactoryprivate.h"
+#include "gtklistitemmanagerprivate.h"
+#include "gtkprivate.h"
+#include "gtkscrollable.h"
+#include "gtksnapshot.h"
+#include "gtkwidgetprivate.h"
+
+/**
+ * SECTION:gtkgridview
+ * @title: GtkGridView
+ * @short_description: A widget for displaying grids
+ * @see_also: #GListModel, #GtkListItem, #GtkListView
+ *
+ * GtkGridView is a widget to present a view into a large dynamic list
+ * of items as a grid, like a gallery of thumbnails.
+ *
+ * Like #GtkListView, it only creates #GtkListItem widgets for the
+ * items that are visible and reuses them when scrolling, so unlike
+ * #GtkFlowBox or #GtkIconView, the cost of displaying a model does not
+ * depend on the number of items in it.
+ *
+ * All cells of the grid have the same size. It is the largest size of
+ * the items that are currently displayed. The number of columns is the
+ * number of cells that fit into the width of the grid view, limited by
+ * the #GtkGridView:min-columns and #GtkGridView:max-columns properties.
+ *
+ * GtkGridView implements #GtkScrollable and is meant to be put into a
+ * #GtkScrolledWindow.
+ *
+ * # CSS nodes
+ *
+ * GtkGridView has a single CSS node with name gridview. Each list item
+ * uses a single CSS node with name child.
+ */
+
+/* Extra space above and below the visible area that is filled with
+ * list items, as a fraction of the page size */
+#define GTK_GRID_VIEW_EXTRA_PAGE 0.5
+
+#define DEFAULT_MAX_COLUMNS 7
+
+struct _GtkGridView
+{
+  GtkWidget parent_instance;
+
+  GtkListItemManager *item_manager;
+  GtkAdjustment *adjustment[2];
+  GtkScrollablePolicy scroll_policy[2];
+
+  guint min_columns;
+  guint max_columns;
+
+  /* cell size to use if no items have been measured */
+  int fallback_cell_width;
+  int fallback_cell_height;
+};
+
+struct _GtkGridViewClass
+{
+  GtkWidgetClass parent_class;
+};
+
+enum
+{
+  PROP_0,
+  PROP_HADJUSTMENT,
+  PROP_HSCROLL_POLICY,
+  PROP_VADJUSTMENT,
+  PROP_VSCROLL_POLICY,
+  PROP_MAX_COLUMNS,
+  PROP_MIN_COLUMNS,
+  PROP_MODEL,
+
+  N_PROPS
+};
+
+G_DEFINE_TYPE_WITH_CODE (GtkGridView, gtk_grid_view, GTK_TYPE_WIDGET,
+                         G_IMPLEMENT_INTERFACE (GTK_TYPE_SCROLLABLE, NULL))
+
+static GParamSpec *properties[N_PROPS] = { NULL, };
+
+/* Measures the cells that have widgets. The size of the grid cells is
+ * the largest size among them.
+ */
+static gboolean
+gtk_grid_view_measure_cells (GtkGridView    *self,
+                             GtkOrientation  orientation,
+                             int             for_size,
+                             int            *minimum,
+                             int            *natural)
+{
+  GtkListItemManagerItem *item;
+  int min, nat, child_min, child_nat;
+  gboolean measured = FALSE;
+
+  min = 0;
+  nat = 0;
+
+  for (item = gtk_list_item_manager_get_first (self->item_manager);
+       item != NULL;
+       item = gtk_rb_tree_node_get_next (item))
+    {
+      if (item->widget == NULL)
+        continue;
+
+      gtk_widget_measure (item->widget,
+                          orientation,
+                          for_size,
+                          &child_min, &child_nat,
+                          NULL, NULL);
+      min = MAX (min, child_min);
+      nat = MAX (nat, child_nat);
+      measured = TRUE;
+    }
+
+  if (!measured)
+    {
+      if (orientation == GTK_ORIENTATION_HORIZONTAL)
+        min = nat = self->fallback_cell_width;
+      else
+        min = nat = self->fallback_cell_height;
+    }
+
+  *minimum = min;
+  *natural = nat;
+
+  return measured;
+}
+
+static guint
+gtk_grid_view_compute_n_columns (GtkGridView *self,
+                                 int          for_width,
+                                 int          cell_width)
+{
+  guint n_columns;
+
+  if (for_width < 0)
+    return self->max_columns;
+
+  if (cell_width > 0)
+    n_columns = for_width / cell_width;
+  else
+    n_columns = self->max_columns;
+
+  return CLAMP (n_columns, self->min_columns, self->max_columns);
+}
+
+static guint
+gtk_grid_view_get_n_rows (GtkGridView *self,
+                          guint        n_columns)
+{
+  guint n_items = gtk_list_item_manager_get_n_items (self->item_manager);
+
+  return (n_items + n_columns - 1) / n_columns;
+}
+
+static void
+gtk_grid_view_measure (GtkWidget      *widget,
+                       GtkOrientation  orientation,
+                       int             for_size,
+                       int            *minimum,
+                       int            *natural,
+                       int            *minimum_baseline,
+                       int            *natural_baseline)
+{
+  GtkGridView *self = GTK_GRID_VIEW (widget);
+  int cell_min, cell_nat;
+
+  if (orientation == GTK_ORIENTATION_HORIZONTAL)
+    {
+      gtk_grid_view_measure_cells (self, GTK_ORIENTATION_HORIZONTAL, -1, &cell_min, &cell_nat);
+
+      *minimum = self->min_columns * cell_min;
+      *natural = self->max_columns * cell_nat;
+    }
+  else
+    {
+      guint n_columns, n_rows;
+      int cell_width;
+
+      gtk_grid_view_measure_cells (self, GTK_ORIENTATION_HORIZONTAL, -1, &cell_min, &cell_nat);
+      n_columns = gtk_grid_view_compute_n_columns (self, for_size, cell_nat);
+      if (for_size >= 0)
+        cell_width = MAX (cell_min, for_size / n_columns);
+      else
+        cell_width = cell_nat;
+
+      gtk_grid_view_measure_cells (self, GTK_ORIENTATION_VERTICAL, cell_width, &cell_min, &cell_nat);
+      n_rows = gtk_grid_view_get_n_rows (self, n_columns);
+
+      *minimum = n_rows * cell_min;
+      *natural = n_rows * cell_nat;
+    }
+}
+
+static void
+gtk_grid_view_update_adjustment (GtkGridView    *self,
+                                 GtkOrientation  orientation,
+                                 int             size,
+                                 int             page_size)
+{
+  gtk_adjustment_configure (self->adjustment[orientation],
+                            gtk_adjustment_get_value (self->adjustment[orientation]),
+                            0,
+                            MAX (size, page_size),
+                            page_size * 0.1,
+                            page_size * 0.9,
+                            page_size);
+}
+
+static void
+gtk_grid_view_size_allocate (GtkWidget *widget,
+                             int        width,
+                             int        height,
+                             int        baseline)
+{
+  GtkGridView *self = GTK_GRID_VIEW (widget);
+  GtkListItemManagerItem *item;
+  int min, nat, cell_width, cell_height, extra, x, y;
+  guint n_items, n_columns, n_rows, first_row, last_row, start, end, pos;
+
+  g_object_freeze_notify (G_OBJECT (self->adjustment[GTK_ORIENTATION_HORIZONTAL]));
+  g_object_freeze_notify (G_OBJECT (self->adjustment[GTK_ORIENTATION_VERTICAL]));
+
+  n_items = gtk_list_item_manager_get_n_items (self->item_manager);
+
+  /* Make sure there is an item to get the cell size from */
+  if (!gtk_grid_view_measure_cells (self, GTK_ORIENTATION_HORIZONTAL, -1, &min, &nat) &&
+      n_items > 0 && self->fallback_cell_height == 0)
+    {
+      gtk_list_item_manager_set_visible_range (self->item_manager, 0, 1);
+      gtk_grid_view_measure_cells (self, GTK_ORIENTATION_HORIZONTAL, -1, &min, &nat);
+    }
+
+  n_columns = gtk_grid_view_compute_n_columns (self, width, nat);
+  cell_width = MAX (min, width / n_columns);
+  gtk_grid_view_update_adjustment (self, GTK_ORIENTATION_HORIZONTAL, n_columns * cell_width, width);
+
+  gtk_grid_view_measure_cells (self, GTK_ORIENTATION_VERTICAL, cell_width, &min, &cell_height);
+  cell_height = MAX (cell_height, 1);
+  n_rows = gtk_grid_view_get_n_rows (self, n_columns);
+  gtk_grid_view_update_adjustment (self, GTK_ORIENTATION_VERTICAL, n_rows * cell_height, height);
+
+  /* Only the visible rows need widgets */
+  y = gtk_adjustment_get_value (self->adjustment[GTK_ORIENTATION_VERTICAL]);
+  extra = height * GTK_GRID_VIEW_EXTRA_PAGE;
+  first_row = MAX (0, y - extra) / cell_height;
+  last_row = MAX (0, y + height + extra) / cell_height;
+  start = MIN (first_row * n_columns, n_items);
+  end = MIN ((last_row + 1) * n_columns, n_items);
+  gtk_list_item_manager_set_visible_range (self->item_manager, start, end - start);
+
+  /* The new items may be larger */
+  if (gtk_grid_view_measure_cells (self, GTK_ORIENTATION_HORIZONTAL, -1, &min, &nat))
+    {
+      n_columns = gtk_grid_view_compute_n_columns (self, width, nat);
+      cell_width = MAX (min, width / n_columns);
+      gtk_grid_view_measure_cells (self, GTK_ORIENTATION_VERTICAL, cell_width, &min, &cell_height);
+      cell_height = MAX (cell_height, 1);
+      self->fallback_cell_width = nat;
+      self->fallback_cell_height = cell_height;
+    }
+  n_rows = gtk_grid_view_get_n_rows (self, n_columns);
+  gtk_grid_view_update_adjustment (self, GTK_ORIENTATION_HORIZONTAL, n_columns * cell_width, width);
+  gtk_grid_view_update_adjustment (self, GTK_ORIENTATION_VERTICAL, n_rows * cell_height, height);
+
+  /* Allocate the cells */
+  x = - gtk_adjustment_get_value (self->adjustment[GTK_ORIENTATION_HORIZONTAL]);
+  y = - gtk_adjustment_get_value (self->adjustment[GTK_ORIENTATION_VERTICAL]);
+  pos = start;
+  for (item = gtk_list_item_manager_get_nth (self->item_manager, start, NULL);
+       item != NULL && item->widget != NULL;
+       item = gtk_rb_tree_node_get_next (item))
+    {
+      gtk_widget_size_allocate (item->widget,
+                                &(GtkAllocation) {
+                                  x + (pos % n_columns) * cell_width,
+                                  y + (pos / n_columns) * cell_height,
+                                  cell_width, cell_height
+                                }, -1);
+      pos++;
+    }
+
+  g_object_thaw_notify (G_OBJECT (self->adjustment[GTK_ORIENTATION_HORIZONTAL]));
+  g_object_thaw_notify (G_OBJECT (self->adjustment[GTK_ORIENTATION_VERTICAL]));
+}
+
+static void
+gtk_grid_view_snapshot (GtkWidget   *widget,
+                        GtkSnapshot *snapshot)
+{
+  gtk_snapshot_push_clip (snapshot,
+                          &GRAPHENE_RECT_INIT (
+                            0, 0,
+                            gtk_widget_get_width (widget),
+                            gtk_widget_get_height (widget)));
+
+  GTK_WIDGET_CLASS (gtk_grid_view_parent_class)->snapshot (widget, snapshot);
+
+  gtk_snapshot_pop (snapshot);
+}
+
+static void
+gtk_grid_view_adjustment_value_changed_cb (GtkAdjustment *adjustment,
+                                           GtkGridView   *self)
+{
+  gtk_widget_queue_allocate (GTK_WIDGET (self));
+}
+
+static void
+gtk_grid_view_clear_adjustment (GtkGridView    *self,
+                                GtkOrientation  orientation)
+{
+  if (self->adjustment[orientation] == NULL)
+    return;
+
+  g_signal_handlers_disconnect_by_func (self->adjustment[orientation],
+                                        gtk_grid_view_adjustment_value_changed_cb,
+                                        self);
+  g_clear_object (&self->adjustment[orientation]);
+}
+
+static void
+gtk_grid_view_set_adjustment (GtkGridView    *self,
+                              GtkOrientation  orientation,
+                              GtkAdjustment  *adjustment)
+{
+  if (self->adjustment[orientation] == adjustment && adjustment != NULL)
+    return;
+
+  if (adjustment == NULL)
+    adjustment = gtk_adjustment_new (0.0, 0.0, 0.0, 0.0, 0.0, 0.0);
+  g_object_ref_sink (adjustment);
+
+  gtk_grid_view_clear_adjustment (self, orientation);
+
+  self->adjustment[orientation] = adjustment;
+
+  g_signal_connect (adjustment, "value-changed",
+                    G_CALLBACK (gtk_grid_view_adjustment_value_changed_cb),
+                    self);
+
+  gtk_widget_queue_allocate (GTK_WIDGET (self));
+}
+
+static void
+gtk_grid_view_set_scroll_policy (GtkGridView         *self,
+                                 GtkOrientation       orientation,
+                                 GtkScrollablePolicy  scroll_policy)
+{
+  if (self->scroll_policy[orientation] == scroll_policy)
+    return;
+
+  self->scroll_policy[orientation] = scroll_policy;
+  gtk_widget_queue_resize (GTK_WIDGET (self));
+  g_object_notify (G_OBJECT (self),
+                   orientation == GTK_ORIENTATION_HORIZONTAL ? "hscroll-policy" : "vscroll-policy");
+}
+
+static void
+gtk_grid_view_get_property (GObject    *object,
+                            guint       property_id,
+                            GValue     *value,
+                            GParamSpec *pspec)
+{
+  GtkGridView *self = GTK_GRID_VIEW (object);
+
+  switch (property_id)
+    {
+    case PROP_HADJUSTMENT:
+      g_value_set_object (value, self->adjustment[GTK_ORIENTATION_HORIZONTAL]);
+      break;
+
+    case PROP_HSCROLL_POLICY:
+      g_value_set_enum (value, self->scroll_policy[GTK_ORIENTATION_HORIZONTAL]);
+      break;
+
+    case PROP_VADJUSTMENT:
+      g_value_set_object (value, self->adjustment[GTK_ORIENTATION_VERTICAL]);
+      break;
+
+    case PROP_VSCROLL_POLICY:
+      g_value_set_enum (value, self->scroll_policy[GTK_ORIENTATION_VERTICAL]);
+      break;
+
+    case PROP_MAX_COLUMNS:
+      g_value_set_uint (value, self->max_columns);
+      break;
+
+    case PROP_MIN_COLUMNS:
+      g_value_set_uint (value, self->min_columns);
+      break;
+
+    case PROP_MODEL:
+      g_value_set_object (value, gtk_list_item_manager_get_model (self->item_manager));
+      break;
+
+    default:
+      G_OBJECT_WARN_INVALID_PROPERTY_ID (object, property_id, pspec);
+      break;
+    }
+}
+
+static void
+gtk_grid_view_set_property (GObject      *object,
+                            guint         property_id,
+                            const GValue *value,
+                            GParamSpec   *pspec)
+{
+  GtkGridView *self = GTK_GRID_VIEW (object);
+
+  switch (property_id)
+    {
+    case PROP_HADJUSTMENT:
+      gtk_grid_view_set_adjustment (self, GTK_ORIENTATION_HORIZONTAL, g_value_get_object (value));
+      break;
+
+    case PROP_HSCROLL_POLICY:
+      gtk_grid_view_set_scroll_policy (self, GTK_ORIENTATION_HORIZONTAL, g_value_get_enum (value));
+      break;
+
+    case PROP_VADJUSTMENT:
+      gtk_grid_view_set_adjustment (self, GTK_ORIENTATION_VERTICAL, g_value_get_object (value));
+      break;
+
+    case PROP_VSCROLL_POLICY:
+      gtk_grid_view_set_scroll_policy (self, GTK_ORIENTATION_VERTICAL, g_value_get_enum (value));
+      break;
+
+    case PROP_MAX_COLUMNS:
+      gtk_grid_view_set_max_columns (self, g_value_get_uint (value));
+      break;
+
+    case PROP_MIN_COLUMNS:
+      gtk_grid_view_set_min_columns (self, g_value_get_uint (value));
+      break;
+
+    case PROP_MODEL:
+      gtk_grid_view_set_model (self, g_value_get_object (value));
+      break;
+
+    default:
+      G_OBJECT_WARN_INVALID_PROPERTY_ID (object, property_id, pspec);
+      break;
+    }
+}
+
+static void
+gtk_grid_view_dispose (GObject *object)
+{
+  GtkGridView *self = GTK_GRID_VIEW (object);
+
+  /* This removes the list items */
+  gtk_list_item_manager_set_model (self->item_manager, NULL);
+  gtk_list_item_manager_set_factory (self->item_manager, NULL);
+
+  gtk_grid_view_clear_adjustment (self, GTK_ORIENTATION_HORIZONTAL);
+  gtk_grid_view_clear_adjustment (self, GTK_ORIENTATION_VERTICAL);
+
+  G_OBJECT_CLASS (gtk_grid_view_parent_class)->dispose (object);
+}
+
+static void
+gtk_grid_view_finalize (GObject *object)
+{
+  GtkGridView *self = GTK_GRID_VIEW (object);
+
+  g_object_unref (self->item_manager);
+
+  G_OBJECT_CLASS (gtk_grid_view_parent_class)->finalize (object);
+}
+
+static void
+gtk_grid_view_class_init (GtkGridViewClass *klass)
+{
+  GtkWidgetClass *widget_class = GTK_WIDGET_CLASS (klass);
+  GObjectClass *gobject_class = G_OBJECT_CLASS (klass);
+
+  widget_class->measure = gtk_grid_view_measure;
+  widget_class->size_allocate = gtk_grid_view_size_allocate;
+  widget_class->snapshot = gtk_grid_view_snapshot;
+
+  gobject_class->dispose = gtk_grid_view_dispose;
+  gobject_class->finalize = gtk_grid_view_finalize;
+  gobject_class->get_property = gtk_grid_view_get_property;
+  gobject_class->set_property = gtk_grid_view_set_property;
+
+  /* GtkScrollable implementation */
+  g_object_class_override_property (gobject_class, PROP_HADJUSTMENT, "hadjustment");
+  g_object_class_override_property (gobject_class, PROP_HSCROLL_POLICY, "hscroll-policy");
+  g_object_class_override_property (gobject_class, PROP_VADJUSTMENT, "vadjustment");
+  g_object_class_override_property (gobject_class, PROP_VSCROLL_POLICY, "vscroll-policy");
+
+  /**
+   * GtkGridView:max-columns:
+   *
+   * Maximum number of columns per row
+   *
+   * If this number is smaller than GtkGridView:min-columns, that value
+   * is used instead.
+   */
+  properties[PROP_MAX_COLUMNS] =
+    g_param_spec_uint ("max-columns",
+                       P_("Max columns"),
+                       P_("Maximum number of columns per row"),
+                       1, G_MAXUINT, DEFAULT_MAX_COLUMNS,
+                       GTK_PARAM_READWRITE | G_PARAM_EXPLICIT_NOTIFY);
+
+  /**
+   * GtkGridView:min-columns:
+   *
+   * Minimum number of columns per row
+   */
+  properties[PROP_MIN_COLUMNS] =
+    g_param_spec_uint ("min-columns",
+                       P_("Min columns"),
+                       P_("Minimum number of columns per row"),
+                       1, G_MAXUINT, 1,
+                       GTK_PARAM_READWRITE | G_PARAM_EXPLICIT_NOTIFY);
+
+  /**
+   * GtkGridView:model:
+   *
+   * Model for the items displayed
+   */
+  properties[PROP_MODEL] =
+    g_param_spec_object ("model",
+                         P_("Model"),
+                         P_("Model for the items displayed"),
+                         G_TYPE_LIST_MODEL,
+                         GTK_PARAM_READWRITE | G_PARAM_EXPLICIT_NOTIFY);
+
+  g_object_class_install_property (gobject_class, PROP_MAX_COLUMNS, properties[PROP_MAX_COLUMNS]);
+  g_object_class_install_property (gobject_class, PROP_MIN_COLUMNS, properties[PROP_MIN_COLUMNS]);
+  g_object_class_install_property (gobject_class, PROP_MODEL, properties[PROP_MODEL]);
+
+  gtk_widget_class_set_accessible_role (widget_class, ATK_ROLE_LAYERED_PANE);
+  gtk_widget_class_set_css_name (widget_class, I_("gridview"));
+}
+
+static void
+gtk_grid_view_init (GtkGridView *self)
+{
+  self->item_manager = gtk_list_item_manager_new (GTK_WIDGET (self),
+                                                  "child",
+                                                  GtkListItemManagerItem,
+                                                  GtkListItemManagerItemAugment,
+                                                  gtk_list_item_manager_augment_node);
+  self->min_columns = 1;
+  self->max_columns = DEFAULT_MAX_COLUMNS;
+
+  gtk_widget_set_has_surface (GTK_WIDGET (self), FALSE);
+
+  gtk_grid_view_set_adjustment (self, GTK_ORIENTATION_HORIZONTAL, NULL);
+  gtk_grid_view_set_adjustment (self, GTK_ORIENTATION_VERTICAL, NULL);
+}
+
+/**
+ * gtk_grid_view_new:
+ *
+ * Creates a new empty #GtkGridView.
+ *
+ * You most likely want to call gtk_grid_view_set_functions() to
+ * set up the way items are displayed and gtk_grid_view_set_model()
+ * to set a model.
+ *
+ * Returns: a new #GtkGridView
+ **/
+GtkWidget *
+gtk_grid_view_new (void)
+{
+  return g_object_new (GTK_TYPE_GRID_VIEW, NULL);
+}
+
+/**
+ * gtk_grid_view_get_model:
+ * @self: a #GtkGridView
+ *
+ * Gets the model that's currently used to read the items displayed.
+ *
+ * Returns: (nullable) (transfer none): The model in use
+ **/
+GListModel *
+gtk_grid_view_get_model (GtkGridView *self)
+{
+  g_return_val_if_fail (GTK_IS_GRID_VIEW (self), NULL);
+
+  return gtk_list_item_manager_get_model (self->item_manager);
+}
+
+/**
+ * gtk_grid_view_set_model:
+ * @self: a #GtkGridView
+ * @model: (allow-none) (transfer none): the model to use or %NULL for none
+ *
+ * Sets the #GListModel to use.
+ **/
+void
+gtk_grid_view_set_model (GtkGridView *self,
+                         GListModel  *model)
+{
+  g_return_if_fail (GTK_IS_GRID_VIEW (self));
+  g_return_if_fail (model == NULL || G_IS_LIST_MODEL (model));
+
+  if (gtk_list_item_manager_get_model (self->item_manager) == model)
+    return;
+
+  gtk_list_item_manager_set_model (self->item_manager, model);
+
+  g_object_notify_by_pspec (G_OBJECT (self), properties[PROP_MODEL]);
+}
+
+/**
+ * gtk_grid_view_set_functions:
+ * @self: a #GtkGridView
+ * @setup_func: (nullable): function to set up list items
+ * @bind_func: (nullable): function to bind items to list items
+ * @user_data: (closure): user data to pass to the functions
+ * @user_destroy: destroy notifier for @user_data
+ *
+ * Sets the functions used to create and update the #GtkListItem
+ * widgets that display the items of the model. See
+ * gtk_list_view_set_functions() for details.
+ **/
+void
+gtk_grid_view_set_functions (GtkGridView          *self,
+                             GtkListItemSetupFunc  setup_func,
+                             GtkListItemBindFunc   bind_func,
+                             gpointer              user_data,
+                             GDestroyNotify        user_destroy)
+{
+  GtkListItemFactory *factory;
+
+  g_return_if_fail (GTK_IS_GRID_VIEW (self));
+  g_return_if_fail (setup_func || bind_func);
+  g_return_if_fail (user_data != NULL || user_destroy == NULL);
+
+  factory = gtk_list_item_factory_new (setup_func, bind_func, user_data, user_destroy);
+  gtk_list_item_manager_set_factory (self->item_manager, factory);
+  g_object_unref (factory);
+}
+
+/**
+ * gtk_grid_view_get_max_columns:
+ * @self: a #GtkGridView
+ *
+ * Gets the maximum number of columns that the grid will use.
+ *
+ * Returns: The maximum number of columns
+ **/
+guint
+gtk_grid_view_get_max_columns (GtkGridView *self)
+{
+  g_return_val_if_fail (GTK_IS_GRID_VIEW (self), DEFAULT_MAX_COLUMNS);
+
+  return self->max_columns;
+}
+
+/**
+ * gtk_grid_view_set_max_columns:
+ * @self: a #GtkGridView
+ * @max_columns: The maximum number of columns
+ *
+ * Sets the maximum number of columns to use. This number must be at least 1.
+ *
+ * If @max_columns is smaller than the minimum set via
+ * gtk_grid_view_set_min_columns(), that value is used instead.
+ **/
+void
+gtk_grid_view_set_max_columns (GtkGridView *self,
+                               guint        max_columns)
+{
+  g_return_if_fail (GTK_IS_GRID_VIEW (self));
+  g_return_if_fail (max_columns > 0);
+
+  if (self->max_columns == max_columns)
+    return;
+
+  self->max_columns = max_columns;
+
+  gtk_widget_queue_resize (GTK_WIDGET (self));
+
+  g_object_notify_by_pspec (G_OBJECT (self), properties[PROP_MAX_COLUMNS]);
+}
+
+/**
+ * gtk_grid_view_get_min_columns:
+ * @self: a #GtkGridView
+ *
+ * Gets the minimum number of columns that the grid will use.
+ *
+ * Returns: The minimum number of columns
+ **/
+guint
+gtk_grid_view_get_min_columns (GtkGridView *self)
+{
+  g_return_val_if_fail (GTK_IS_GRID_VIEW (self), 1);
+
+  return self->min_columns;
+}
+
+/**
+ * gtk_grid_view_set_min_columns:
+ * @self: a #GtkGridView
+ * @min_columns: The minimum number of columns
+ *
+ * Sets the minimum number of columns to use. This number must be at least 1.
+ *
+ * If @min_columns is larger than the maximum set via
+ * gtk_grid_view_set_max_columns(), that value is ignored.
+ **/
+void
+gtk_grid_view_set_min_columns (GtkGridView *self,
+                               guint        min_columns)
+{
+  g_return_if_fail (GTK_IS_GRID_VIEW (self));
+  g_return_if_fail (min_columns > 0);
+
+  if (self->min_columns == min_columns)
+    return;
+
+  self->min_columns = min_columns;
+
+  gtk_widget_queue_resize (GTK_WIDGET (self));
+
+  g_object_notify_by_pspec (G_OBJECT (self), properties[PROP_MIN_COLUMNS]);
+}
@@ -22,6 +22,7 @@
 #include "gtkiconcachevalidatorprivate.h"
 
 #include <glib/gstdio.h>
+#include <gio/gio.h>
 #include <gdk-pixbuf/gdk-pixdata.h>
 
 #ifdef HAVE_UNISTD_H
@@ -34,6 +35,11 @@
 #include <sys/types.h>
 #include <sys/stat.h>
 #include <string.h>
+#ifdef G_OS_WIN32
+#include <sys/utime.h>
+#else
+#include <utime.h>
+#endif
 
 
 #ifndef _O_BINARY
@@ -161,6 +167,368 @@ gtk_icon_cache_new_for_path (const gchar *path)
   return cache;
 }
 
+static guint
+icon_name_hash (gconstpointer key)
+{
+  const signed char *p = key;
+  guint32 h = *p;
+
+  if (h)
+    for (p += 1; *p != '\0'; p++)
+      h = (h << 5) - h + *p;
+
+  return h;
+}
+
+/* Themes without an icon-theme.cache get an index of the same format
+ * in the user's cache directory, written by the first process that
+ * scans them. It has no image data, so it holds little more than what
+ * each process would otherwise collect in its own hash tables, but the
+ * pages are shared between all processes mapping it.
+ */
+static gchar *
+get_index_filename (const gchar *path)
+{
+  gchar *checksum, *basename, *filename;
+
+  checksum = g_compute_checksum_for_string (G_CHECKSUM_SHA1, path, -1);
+  basename = g_strconcat (checksum, ".cache", NULL);
+  filename = g_build_filename (g_get_user_cache_dir (), "gtk-4.0", "icon-theme-indexes", basename, NULL);
+  g_free (basename);
+  g_free (checksum);
+
+  return filename;
+}
+
+static gboolean
+is_newer_than (GStatBuf    *st,
+               const gchar *path)
+{
+  GStatBuf path_st;
+
+  if (g_stat (path, &path_st) < 0)
+    return FALSE;
+
+  return st->st_mtime >= path_st.st_mtime;
+}
+
+/* Returns the index written by gtk_icon_cache_write_index() for @path,
+ * or %NULL if there is none or any of the directories in it changed
+ * since it was written.
+ */
+GtkIconCache *
+gtk_icon_cache_new_for_index (const gchar *path)
+{
+  GtkIconCache *cache = NULL;
+  GMappedFile *map = NULL;
+  gchar *filename, *index_theme;
+  const gchar *buffer;
+  GStatBuf st;
+  guint32 dir_list_offset, n_dirs, i;
+  gsize length;
+
+  filename = get_index_filename (path);
+
+  if (g_stat (filename, &st) < 0 || !is_newer_than (&st, path))
+    goto done;
+
+  index_theme = g_build_filename (path, "index.theme", NULL);
+  if (g_file_test (index_theme, G_FILE_TEST_EXISTS) && !is_newer_than (&st, index_theme))
+    {
+      g_free (index_theme);
+      goto done;
+    }
+  g_free (index_theme);
+
+  map = g_mapped_file_new (filename, FALSE, NULL);
+  if (!map)
+    goto done;
+
+  buffer = g_mapped_file_get_contents (map);
+  length = g_mapped_file_get_length (map);
+  if (length < 12)
+    goto done;
+
+  dir_list_offset = GET_UINT32 (buffer, 8);
+  if (dir_list_offset > length - 4)
+    goto done;
+
+  n_dirs = GET_UINT32 (buffer, dir_list_offset);
+  if (n_dirs > (length - dir_list_offset - 4) / 4)
+    goto done;
+
+  for (i = 0; i < n_dirs; i++)
+    {
+      guint32 name_offset = GET_UINT32 (buffer, dir_list_offset + 4 + 4 * i);
+      gchar *dir;
+      gboolean newer;
+
+      if (name_offset >= length || memchr (buffer + name_offset, '\0', length - name_offset) == NULL)
+        goto done;
+
+      dir = g_build_filename (path, buffer + name_offset, NULL);
+      newer = is_newer_than (&st, dir);
+      g_free (dir);
+
+      if (!newer)
+        {
+          GTK_NOTE (ICONTHEME, g_message ("icon theme index for %s outdated", path));
+          goto done;
+        }
+    }
+
+#ifdef G_ENABLE_DEBUG
+  if (GTK_DEBUG_CHECK (ICONTHEME))
+    {
+      CacheInfo info;
+
+      info.cache = (gchar *) buffer;
+      info.cache_size = length;
+      info.n_directories = 0;
+      info.flags = CHECK_OFFSETS|CHECK_STRINGS;
+
+      if (!gtk_icon_cache_validate (&info))
+        {
+          g_warning ("Icon theme index '%s' is invalid", filename);
+          goto done;
+        }
+    }
+#endif
+
+  GTK_NOTE (ICONTHEME, g_message ("found icon theme index for %s", path));
+
+  cache = g_new0 (GtkIconCache, 1);
+  cache->ref_count = 1;
+  cache->map = g_mapped_file_ref (map);
+  cache->buffer = g_mapped_file_get_contents (map);
+
+ done:
+  if (map)
+    g_mapped_file_unref (map);
+  g_free (filename);
+
+  return cache;
+}
+
+static void
+append_uint16 (GByteArray *data,
+               guint16     value)
+{
+  value = GUINT16_TO_BE (value);
+  g_byte_array_append (data, (guint8 *) &value, 2);
+}
+
+static void
+append_uint32 (GByteArray *data,
+               guint32     value)
+{
+  value = GUINT32_TO_BE (value);
+  g_byte_array_append (data, (guint8 *) &value, 4);
+}
+
+static void
+set_uint32 (GByteArray *data,
+            guint32     offset,
+            guint32     value)
+{
+  value = GUINT32_TO_BE (value);
+  memcpy (data->data + offset, &value, 4);
+}
+
+/* Strings are padded so everything after them stays aligned */
+static guint32
+append_string (GByteArray  *data,
+               const gchar *string)
+{
+  static const guint8 padding[4] = { 0, };
+  guint32 offset = data->len;
+
+  g_byte_array_append (data, (const guint8 *) string, strlen (string) + 1);
+  g_byte_array_append (data, padding, (4 - data->len % 4) % 4);
+
+  return offset;
+}
+
+typedef struct {
+  gchar *filename;
+  GBytes *bytes;
+  gint64 mtime;
+} IndexWrite;
+
+static void
+index_write_free (IndexWrite *write)
+{
+  g_free (write->filename);
+  g_bytes_unref (write->bytes);
+  g_slice_free (IndexWrite, write);
+}
+
+static void
+write_index_thread (GTask        *task,
+                    gpointer      source_object,
+                    gpointer      task_data,
+                    GCancellable *cancellable)
+{
+  IndexWrite *write = task_data;
+  struct utimbuf times;
+  gchar *dirname;
+  gsize size;
+  const gchar *contents;
+
+  dirname = g_path_get_dirname (write->filename);
+  g_mkdir_with_parents (dirname, 0700);
+  g_free (dirname);
+
+  contents = g_bytes_get_data (write->bytes, &size);
+  if (!g_file_set_contents (write->filename, contents, size, NULL))
+    return;
+
+  /* Directories changed after they were read make the index outdated */
+  times.actime = write->mtime;
+  times.modtime = write->mtime;
+  g_utime (write->filename, &times);
+}
+
+/* Writes an index for @path, whose @directories (relative to @path)
+ * contain the icons in the corresponding hash tables of @icons, which
+ * map icon names to icon cache flags. @mtime is the newest modification
+ * time of the directories when they were read.
+ *
+ * The index is written in a thread, later processes will pick it up
+ * with gtk_icon_cache_new_for_index().
+ */
+void
+gtk_icon_cache_write_index (const gchar *path,
+                            GPtrArray   *directories,
+                            GPtrArray   *icons,
+                            gint64       mtime)
+{
+  GHashTable *images;
+  GHashTableIter iter;
+  GByteArray *data;
+  GPtrArray **buckets;
+  IndexWrite *write;
+  GTask *task;
+  gpointer key, value;
+  guint32 n_buckets, hash_offset, dir_list_offset;
+  guint i, j, k;
+
+  g_return_if_fail (directories->len == icons->len);
+
+  if (directories->len > G_MAXUINT16)
+    return;
+
+  /* icon name -> GArray of (directory index << 16 | flags) */
+  images = g_hash_table_new_full (g_str_hash, g_str_equal, NULL, (GDestroyNotify) g_array_unref);
+  for (i = 0; i < icons->len; i++)
+    {
+      g_hash_table_iter_init (&iter, g_ptr_array_index (icons, i));
+      while (g_hash_table_iter_next (&iter, &key, &value))
+        {
+          GArray *list = g_hash_table_lookup (images, key);
+          guint32 image = (i << 16) | (GPOINTER_TO_UINT (value) & 0xffff);
+
+          if (list == NULL)
+            {
+              list = g_array_new (FALSE, FALSE, sizeof (guint32));
+              g_hash_table_insert (images, key, list);
+            }
+          g_array_append_val (list, image);
+        }
+    }
+
+  n_buckets = g_spaced_primes_closest (g_hash_table_size (images));
+  buckets = g_new0 (GPtrArray *, n_buckets);
+  g_hash_table_iter_init (&iter, images);
+  while (g_hash_table_iter_next (&iter, &key, NULL))
+    {
+      guint hash = icon_name_hash (key) % n_buckets;
+
+      if (buckets[hash] == NULL)
+        buckets[hash] = g_ptr_array_new ();
+      g_ptr_array_add (buckets[hash], key);
+    }
+
+  data = g_byte_array_new ();
+
+  /* Header, major version 1, minor version 0 */
+  append_uint16 (data, 1);
+  append_uint16 (data, 0);
+  append_uint32 (data, 0);
+  append_uint32 (data, 0);
+
+  hash_offset = data->len;
+  append_uint32 (data, n_buckets);
+  for (i = 0; i < n_buckets; i++)
+    append_uint32 (data, 0xffffffff);
+
+  for (i = 0; i < n_buckets; i++)
+    {
+      guint32 link_offset = hash_offset + 4 + 4 * i;
+
+      if (buckets[i] == NULL)
+        continue;
+
+      for (j = 0; j < buckets[i]->len; j++)
+        {
+          const gchar *name = g_ptr_array_index (buckets[i], j);
+          GArray *list = g_hash_table_lookup (images, name);
+          guint32 icon_offset = data->len;
+
+          set_uint32 (data, link_offset, icon_offset);
+          link_offset = icon_offset;
+
+          /* chain, name, image list */
+          append_uint32 (data, 0xffffffff);
+          append_uint32 (data, 0);
+          append_uint32 (data, 0);
+
+          set_uint32 (data, icon_offset + 4, append_string (data, name));
+
+          set_uint32 (data, icon_offset + 8, data->len);
+          append_uint32 (data, list->len);
+          for (k = 0; k < list->len; k++)
+            {
+              guint32 image = g_array_index (list, guint32, k);
+
+              append_uint16 (data, image >> 16);
+              append_uint16 (data, image & 0xffff);
+              /* no image data */
+              append_uint32 (data, 0);
+            }
+        }
+
+      g_ptr_array_unref (buckets[i]);
+    }
+  g_free (buckets);
+
+  dir_list_offset = data->len;
+  append_uint32 (data, directories->len);
+  for (i = 0; i < directories->len; i++)
+    append_uint32 (data, 0);
+  for (i = 0; i < directories->len; i++)
+    set_uint32 (data, dir_list_offset + 4 + 4 * i,
+                append_string (data, g_ptr_array_index (directories, i)));
+
+  set_uint32 (data, 4, hash_offset);
+  set_uint32 (data, 8, dir_list_offset);
+
+  g_hash_table_unref (images);
+
+  write = g_slice_new (IndexWrite);
+  write->filename = get_index_filename (path);
+  write->bytes = g_byte_array_free_to_bytes (data);
+  write->mtime = mtime;
+
+  GTK_NOTE (ICONTHEME, g_message ("writing icon theme index for %s to %s", path, write->filename));
+
+  task = g_task_new (NULL, NULL, NULL, NULL);
+  g_task_set_source_tag (task, gtk_icon_cache_write_index);
+  g_task_set_task_data (task, write, (GDestroyNotify) index_write_free);
+  g_task_run_in_thread (task, write_index_thread);
+  g_object_unref (task);
+}
+
 GtkIconCache *
 gtk_icon_cache_new (const gchar *data)
 {
@@ -204,19 +572,6 @@ gtk_icon_cache_get_directory_index (GtkIconCache *cache,
   return get_directory_index (cache, directory);
 }
 
-static guint
-icon_name_hash (gconstpointer key)
-{
-  const signed char *p = key;
-  guint32 h = *p;
-
-  if (h)
-    for (p += 1; *p != '\0'; p++)
-      h = (h << 5) - h + *p;
-
-  return h;
-}
-
 static gint
 find_image_offset (GtkIconCache *cache,
 		   const gchar  *icon_name,
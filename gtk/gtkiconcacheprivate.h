@@ -25,6 +25,11 @@ typedef struct _GtkIconCache GtkIconCache;
 
 GtkIconCache *gtk_icon_cache_new                        (const gchar  *data);
 GtkIconCache *gtk_icon_cache_new_for_path               (const gchar  *path);
+GtkIconCache *gtk_icon_cache_new_for_index              (const gchar  *path);
+void          gtk_icon_cache_write_index                (const gchar  *path,
+                                                         GPtrArray    *directories,
+                                                         GPtrArray    *icons,
+                                                         gint64        mtime);
 gint          gtk_icon_cache_get_directory_index        (GtkIconCache *cache,
                                                          const gchar  *directory);
 gboolean      gtk_icon_cache_has_icon                   (GtkIconCache *cache,
@@ -136,6 +136,27 @@ ensure_paintable_for_gicon (GtkIconHelper    *self,
   return paintable;
 }
 
+static GIcon *
+gtk_icon_helper_ref_gicon (GtkIconHelper *self)
+{
+  switch (gtk_image_definition_get_storage_type (self->def))
+    {
+    case GTK_IMAGE_ICON_NAME:
+      if (self->use_fallback)
+        return g_themed_icon_new_with_default_fallbacks (gtk_image_definition_get_icon_name (self->def));
+      else
+        return g_themed_icon_new (gtk_image_definition_get_icon_name (self->def));
+
+    case GTK_IMAGE_GICON:
+      return g_object_ref (gtk_image_definition_get_gicon (self->def));
+
+    case GTK_IMAGE_PAINTABLE:
+    case GTK_IMAGE_EMPTY:
+    default:
+      return NULL;
+    }
+}
+
 static GdkPaintable *
 gtk_icon_helper_load_paintable (GtkIconHelper   *self,
                                 gboolean        *out_symbolic)
@@ -152,10 +173,8 @@ gtk_icon_helper_load_paintable (GtkIconHelper   *self,
       break;
 
     case GTK_IMAGE_ICON_NAME:
-      if (self->use_fallback)
-        gicon = g_themed_icon_new_with_default_fallbacks (gtk_image_definition_get_icon_name (self->def));
-      else
-        gicon = g_themed_icon_new (gtk_image_definition_get_icon_name (self->def));
+    case GTK_IMAGE_GICON:
+      gicon = gtk_icon_helper_ref_gicon (self);
       paintable = ensure_paintable_for_gicon (self,
                                               gtk_css_node_get_style (self->node),
                                               gtk_widget_get_direction (self->owner),
@@ -165,15 +184,6 @@ gtk_icon_helper_load_paintable (GtkIconHelper   *self,
       g_object_unref (gicon);
       break;
 
-    case GTK_IMAGE_GICON:
-      paintable = ensure_paintable_for_gicon (self, 
-                                              gtk_css_node_get_style (self->node),
-                                              gtk_widget_get_direction (self->owner),
-                                              gtk_widget_get_scale_factor (self->owner),
-                                              gtk_image_definition_get_gicon (self->def),
-                                              &symbolic);
-      break;
-
     case GTK_IMAGE_EMPTY:
     default:
       paintable = NULL;
@@ -198,6 +208,42 @@ gtk_icon_helper_ensure_paintable (GtkIconHelper *self)
   self->texture_is_symbolic = symbolic;
 }
 
+/**
+ * gtk_icon_helper_prefetch:
+ * @self: a #GtkIconHelper
+ *
+ * Asks the icon theme to load the icon of @self in the background,
+ * for helpers that are measured well before they get drawn, like
+ * those of cell renderers for rows that aren't visible yet.
+ */
+void
+gtk_icon_helper_prefetch (GtkIconHelper *self)
+{
+  GtkCssStyle *style;
+  GtkIconTheme *icon_theme;
+  GIcon *gicon;
+
+  if (self->paintable)
+    return;
+
+  gicon = gtk_icon_helper_ref_gicon (self);
+  if (gicon == NULL)
+    return;
+
+  style = gtk_css_node_get_style (self->node);
+  icon_theme = gtk_css_icon_theme_value_get_icon_theme
+    (gtk_css_style_get_value (style, GTK_CSS_PROPERTY_ICON_THEME));
+
+  gtk_icon_theme_prefetch_icon (icon_theme,
+                                gicon,
+                                gtk_icon_helper_get_size (self),
+                                gtk_widget_get_scale_factor (self->owner),
+                                get_icon_lookup_flags (self, style,
+                                                       gtk_widget_get_direction (self->owner)));
+
+  g_object_unref (gicon);
+}
+
 static void
 gtk_icon_helper_paintable_snapshot (GdkPaintable *paintable,
                                     GdkSnapshot  *snapshot,
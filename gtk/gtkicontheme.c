@@ -50,6 +50,8 @@
 #include "gtkprivate.h"
 #include "gdkpixbufutilsprivate.h"
 
+#include "gdk/gdkcachesprivate.h"
+
 /* this is in case round() is not provided by the compiler, 
  * such as in the case of C89 compilers, like MSVC
  */
@@ -123,7 +125,8 @@ typedef enum
   ICON_SUFFIX_SYMBOLIC_PNG = 1 << 4
 } IconSuffix;
 
-#define INFO_CACHE_LRU_SIZE 32
+#define INFO_CACHE_LRU_SIZE 128
+#define INFO_CACHE_LRU_MAX_BYTES (4 * 1024 * 1024)
 #if 0
 #define DEBUG_CACHE(args) g_print args
 #else
@@ -134,6 +137,7 @@ struct _GtkIconThemePrivate
 {
   GHashTable *info_cache;
   GList *info_cache_lru;
+  GdkCache *info_cache_entry;
 
   gchar *current_theme;
   gchar **search_path;
@@ -159,7 +163,19 @@ struct _GtkIconThemePrivate
   glong last_stat_time;
   GList *dir_mtimes;
 
+  /* Directories without an icon cache, collected while loading
+   * themes so they can be scanned together. See scan_directories().
+   */
+  GPtrArray *unscanned_dirs;
+
   gulong theme_changed_idle;
+
+  /* Icons queued with gtk_icon_theme_prefetch_icon() */
+  GPtrArray *prefetch_icons;
+  gint prefetch_size;
+  gint prefetch_scale;
+  GtkIconLookupFlags prefetch_flags;
+  guint prefetch_idle;
 };
 
 typedef struct {
@@ -230,9 +246,6 @@ struct _GtkIconInfo
   gdouble scale;
 
   SymbolicPixbufCache *symbolic_pixbuf_cache;
-
-  gint symbolic_width;
-  gint symbolic_height;
 };
 
 typedef struct
@@ -265,6 +278,8 @@ typedef struct
   GtkIconCache *cache;
   
   GHashTable *icons;
+  /* of the directory when it was scanned */
+  time_t mtime;
 } IconThemeDir;
 
 typedef struct
@@ -280,6 +295,7 @@ typedef struct
   time_t mtime;
   GtkIconCache *cache;
   gboolean exists;
+  gboolean index_checked;
 } IconThemeDirMtime;
 
 static void         gtk_icon_theme_finalize   (GObject          *object);
@@ -302,6 +318,7 @@ static void         theme_subdir_load         (GtkIconTheme     *icon_theme,
                                                IconTheme        *theme,
                                                GKeyFile         *theme_file,
                                                gchar            *subdir);
+static void         scan_directories          (GtkIconTheme     *icon_theme);
 static void         do_theme_change           (GtkIconTheme     *icon_theme);
 static void         blow_themes               (GtkIconTheme     *icon_themes);
 static gboolean     rescan_themes             (GtkIconTheme     *icon_themes);
@@ -312,6 +329,11 @@ static GtkIconInfo *icon_info_new             (IconThemeDirType  type,
                                                gint              dir_size,
                                                gint              dir_scale);
 static IconSuffix   suffix_from_name          (const gchar      *name);
+static void         lru_cache_get_size        (gpointer          data,
+                                               gsize            *cpu_bytes,
+                                               gsize            *gpu_bytes);
+static void         lru_cache_trim            (gpointer          data,
+                                               gsize             max_bytes);
 static void         remove_from_lru_cache     (GtkIconTheme     *icon_theme,
                                                GtkIconInfo      *icon_info);
 static gboolean     icon_info_ensure_scale_and_pixbuf (GtkIconInfo* icon_info);
@@ -660,6 +682,10 @@ gtk_icon_theme_init (GtkIconTheme *icon_theme)
 
   priv->info_cache = g_hash_table_new_full (icon_info_key_hash, icon_info_key_equal, NULL,
                                             (GDestroyNotify)icon_info_uncached);
+  priv->info_cache_entry = gdk_cache_register ("icons", INFO_CACHE_LRU_MAX_BYTES,
+                                               lru_cache_get_size,
+                                               lru_cache_trim,
+                                               icon_theme);
 
   priv->custom_theme = FALSE;
 
@@ -711,7 +737,7 @@ theme_changed_idle (gpointer user_data)
   g_signal_emit (icon_theme, signal_changed, 0);
 
   if (priv->display && priv->is_display_singleton)
-    gtk_style_context_reset_widgets (priv->display);
+    gtk_settings_queue_reset_widgets (gtk_settings_get_for_display (priv->display));
 
   priv->theme_changed_idle = 0;
 
@@ -778,12 +804,17 @@ gtk_icon_theme_finalize (GObject *object)
   icon_theme = GTK_ICON_THEME (object);
   priv = icon_theme->priv;
 
+  g_clear_pointer (&priv->info_cache_entry, gdk_cache_unregister);
   g_hash_table_destroy (priv->info_cache);
   g_assert (priv->info_cache_lru == NULL);
 
   if (priv->theme_changed_idle)
     g_source_remove (priv->theme_changed_idle);
 
+  if (priv->prefetch_idle)
+    g_source_remove (priv->prefetch_idle);
+  g_clear_pointer (&priv->prefetch_icons, g_ptr_array_unref);
+
   unset_display (icon_theme);
 
   g_free (priv->current_theme);
@@ -1079,6 +1110,7 @@ insert_theme (GtkIconTheme *icon_theme,
                                NULL);
       dir_mtime = g_slice_new (IconThemeDirMtime);
       dir_mtime->cache = NULL;
+      dir_mtime->index_checked = FALSE;
       dir_mtime->dir = path;
       if (g_stat (path, &stat_buf) == 0 && S_ISDIR (stat_buf.st_mode)) {
         dir_mtime->mtime = stat_buf.st_mtime;
@@ -1292,6 +1324,8 @@ load_themes (GtkIconTheme *icon_theme)
   
   priv = icon_theme->priv;
 
+  priv->unscanned_dirs = g_ptr_array_new ();
+
   if (priv->current_theme)
     insert_theme (icon_theme, priv->current_theme);
 
@@ -1305,6 +1339,8 @@ load_themes (GtkIconTheme *icon_theme)
   insert_theme (icon_theme, FALLBACK_ICON_THEME);
   priv->themes = g_list_reverse (priv->themes);
 
+  scan_directories (icon_theme);
+
 
   priv->unthemed_icons = g_hash_table_new_full (g_str_hash, g_str_equal,
                                                 g_free, (GDestroyNotify)free_unthemed_icon);
@@ -1320,6 +1356,7 @@ load_themes (GtkIconTheme *icon_theme)
       dir_mtime->mtime = 0;
       dir_mtime->exists = FALSE;
       dir_mtime->cache = NULL;
+      dir_mtime->index_checked = FALSE;
 
       if (g_stat (dir, &stat_buf) != 0 || !S_ISDIR (stat_buf.st_mode))
         continue;
@@ -1420,18 +1457,62 @@ ensure_valid_themes (GtkIconTheme *icon_theme)
  * we remove it from the list, and when the proxy
  * pixmap is released we put it on the list.
  */
+static gsize
+icon_info_get_pixel_bytes (GtkIconInfo *icon_info)
+{
+  if (icon_info->pixbuf == NULL)
+    return 0;
+
+  return gdk_pixbuf_get_byte_length (icon_info->pixbuf);
+}
+
 static void
-ensure_lru_cache_space (GtkIconTheme *icon_theme)
+lru_cache_get_size (gpointer  data,
+                    gsize    *cpu_bytes,
+                    gsize    *gpu_bytes)
 {
-  GtkIconThemePrivate *priv = icon_theme->priv;
+  GtkIconTheme *icon_theme = data;
   GList *l;
 
-  /* Remove last item if LRU full */
-  l = g_list_nth (priv->info_cache_lru, INFO_CACHE_LRU_SIZE - 1);
-  if (l)
+  *cpu_bytes = 0;
+  *gpu_bytes = 0;
+
+  for (l = icon_theme->priv->info_cache_lru; l; l = l->next)
+    *cpu_bytes += icon_info_get_pixel_bytes (l->data);
+}
+
+/* Removes the items from the LRU that don't fit in @max_items and
+ * @max_bytes anymore after @n_items and @n_bytes are taken, oldest
+ * first. A @max_bytes of 0 means there is no limit on the bytes.
+ */
+static void
+trim_lru_cache (GtkIconTheme *icon_theme,
+                guint         n_items,
+                gsize         n_bytes,
+                guint         max_items,
+                gsize         max_bytes)
+{
+  GtkIconThemePrivate *priv = icon_theme->priv;
+  GList *l, *next;
+
+  /* Find the first item that doesn't fit in the LRU anymore,
+   * either by count or by the memory used for pixels.
+   */
+  for (l = priv->info_cache_lru; l; l = l->next)
+    {
+      n_items++;
+      n_bytes += icon_info_get_pixel_bytes (l->data);
+      if (n_items > max_items || (max_bytes > 0 && n_bytes > max_bytes))
+        break;
+    }
+
+  /* Remove it and everything older */
+  for (; l; l = next)
     {
       GtkIconInfo *icon_info = l->data;
 
+      next = l->next;
+
       DEBUG_CACHE (("removing (due to out of space) %p (%s %d 0x%x) from LRU cache (cache size %d)\n",
                     icon_info,
                     g_strjoinv (",", icon_info->key.icon_names),
@@ -1443,6 +1524,28 @@ ensure_lru_cache_space (GtkIconTheme *icon_theme)
     }
 }
 
+static void
+lru_cache_trim (gpointer data,
+                gsize    max_bytes)
+{
+  GtkIconTheme *icon_theme = data;
+
+  if (max_bytes == 0)
+    trim_lru_cache (icon_theme, 0, 0, 0, 0);
+  else
+    trim_lru_cache (icon_theme, 0, 0, INFO_CACHE_LRU_SIZE, max_bytes);
+}
+
+static void
+ensure_lru_cache_space (GtkIconTheme *icon_theme,
+                        GtkIconInfo  *new_info)
+{
+  trim_lru_cache (icon_theme,
+                  1, icon_info_get_pixel_bytes (new_info),
+                  INFO_CACHE_LRU_SIZE,
+                  gdk_cache_get_budget (icon_theme->priv->info_cache_entry));
+}
+
 static void
 add_to_lru_cache (GtkIconTheme *icon_theme,
                   GtkIconInfo  *icon_info)
@@ -1457,7 +1560,7 @@ add_to_lru_cache (GtkIconTheme *icon_theme,
 
   g_assert (g_list_find (priv->info_cache_lru, icon_info) == NULL);
 
-  ensure_lru_cache_space (icon_theme);
+  ensure_lru_cache_space (icon_theme, icon_info);
   /* prepend new info to LRU */
   priv->info_cache_lru = g_list_prepend (priv->info_cache_lru,
                                          g_object_ref (icon_info));
@@ -3009,10 +3112,14 @@ scan_directory (GtkIconThemePrivate *icon_theme,
 {
   GDir *gdir;
   const gchar *name;
+  GStatBuf stat_buf;
 
   GTK_DISPLAY_NOTE (icon_theme->display, ICONTHEME,
                     g_message ("scanning directory %s", full_dir));
 
+  if (g_stat (full_dir, &stat_buf) == 0)
+    dir->mtime = stat_buf.st_mtime;
+
   gdir = g_dir_open (full_dir, 0, NULL);
 
   if (gdir == NULL)
@@ -3041,6 +3148,179 @@ scan_directory (GtkIconThemePrivate *icon_theme,
   return g_hash_table_size (dir->icons) > 0;
 }
 
+static void
+scan_directory_thread (gpointer data,
+                       gpointer user_data)
+{
+  IconThemeDir *dir = data;
+
+  scan_directory (user_data, dir, dir->dir);
+}
+
+/* Writes an index for each theme directory whose subdirectories were
+ * all scanned, so other processes can map it instead of scanning them
+ * again. See gtk_icon_cache_new_for_index().
+ */
+static void
+write_theme_indexes (GPtrArray *scanned)
+{
+  GHashTable *bases;
+  GHashTableIter iter;
+  GPtrArray *dirs;
+  gchar *base;
+  guint i;
+
+  bases = g_hash_table_new_full (g_str_hash, g_str_equal,
+                                 g_free, (GDestroyNotify) g_ptr_array_unref);
+
+  for (i = 0; i < scanned->len; i++)
+    {
+      IconThemeDir *dir = g_ptr_array_index (scanned, i);
+
+      base = g_strndup (dir->dir, strlen (dir->dir) - strlen (dir->subdir) - 1);
+      dirs = g_hash_table_lookup (bases, base);
+      if (dirs == NULL)
+        {
+          dirs = g_ptr_array_new ();
+          g_hash_table_insert (bases, base, dirs);
+        }
+      else
+        g_free (base);
+
+      g_ptr_array_add (dirs, dir);
+    }
+
+  g_hash_table_iter_init (&iter, bases);
+  while (g_hash_table_iter_next (&iter, (gpointer *) &base, (gpointer *) &dirs))
+    {
+      GPtrArray *subdirs, *icons;
+      GStatBuf stat_buf;
+      gchar *index_theme;
+      gint64 mtime = 0;
+      gboolean complete = TRUE;
+
+      /* The index must not be older than the theme itself */
+      if (g_stat (base, &stat_buf) == 0)
+        mtime = stat_buf.st_mtime;
+      index_theme = g_build_filename (base, "index.theme", NULL);
+      if (g_stat (index_theme, &stat_buf) == 0)
+        mtime = MAX (mtime, stat_buf.st_mtime);
+      g_free (index_theme);
+
+      subdirs = g_ptr_array_new ();
+      icons = g_ptr_array_new_with_free_func ((GDestroyNotify) g_hash_table_unref);
+
+      for (i = 0; i < dirs->len; i++)
+        {
+          IconThemeDir *dir = g_ptr_array_index (dirs, i);
+          GHashTable *flags;
+          GHashTableIter icon_iter;
+          gpointer key, value;
+
+          /* An unreadable directory can't be described in the index */
+          if (dir->icons == NULL)
+            {
+              complete = FALSE;
+              break;
+            }
+
+          if (g_ptr_array_find_with_equal_func (subdirs, dir->subdir, g_str_equal, NULL))
+            continue;
+
+          /* The cache format only knows the last suffix of a file, so
+           * foo-symbolic.symbolic.png is foo-symbolic.symbolic there */
+          flags = g_hash_table_new_full (g_str_hash, g_str_equal, g_free, NULL);
+          g_hash_table_iter_init (&icon_iter, dir->icons);
+          while (g_hash_table_iter_next (&icon_iter, &key, &value))
+            {
+              IconSuffix suffix = GPOINTER_TO_UINT (value);
+
+              if (suffix & ICON_SUFFIX_SYMBOLIC_PNG)
+                g_hash_table_insert (flags,
+                                     g_strconcat (key, ".symbolic", NULL),
+                                     GUINT_TO_POINTER (ICON_SUFFIX_PNG));
+
+              suffix &= ~ICON_SUFFIX_SYMBOLIC_PNG;
+              if (suffix != ICON_SUFFIX_NONE)
+                g_hash_table_insert (flags, g_strdup (key), GUINT_TO_POINTER (suffix));
+            }
+
+          g_ptr_array_add (subdirs, dir->subdir);
+          g_ptr_array_add (icons, flags);
+          mtime = MAX (mtime, dir->mtime);
+        }
+
+      if (complete && subdirs->len > 0)
+        gtk_icon_cache_write_index (base, subdirs, icons, mtime);
+
+      g_ptr_array_unref (subdirs);
+      g_ptr_array_unref (icons);
+    }
+
+  g_hash_table_unref (bases);
+}
+
+/* Below this many directories, starting threads costs more than it saves */
+#define MIN_PARALLEL_SCANS 8
+
+/* Reads all directories collected in priv->unscanned_dirs, spread over
+ * a few threads when there are many of them, and drops the ones that
+ * turned out to have no icons. Themes without an up-to-date
+ * icon-theme.cache otherwise stall the first lookup for as long as
+ * it takes to read each of their directories one after the other.
+ */
+static void
+scan_directories (GtkIconTheme *icon_theme)
+{
+  GtkIconThemePrivate *priv = icon_theme->priv;
+  GPtrArray *unscanned = priv->unscanned_dirs;
+  GList *l, *d, *next;
+  guint i;
+
+  priv->unscanned_dirs = NULL;
+
+  if (unscanned->len >= MIN_PARALLEL_SCANS)
+    {
+      GThreadPool *pool;
+
+      pool = g_thread_pool_new (scan_directory_thread, priv,
+                                MIN (g_get_num_processors (), unscanned->len),
+                                FALSE, NULL);
+      for (i = 0; i < unscanned->len; i++)
+        g_thread_pool_push (pool, g_ptr_array_index (unscanned, i), NULL);
+
+      /* Waits for all directories to be scanned */
+      g_thread_pool_free (pool, FALSE, TRUE);
+    }
+  else
+    {
+      for (i = 0; i < unscanned->len; i++)
+        scan_directory_thread (g_ptr_array_index (unscanned, i), priv);
+    }
+
+  write_theme_indexes (unscanned);
+  g_ptr_array_free (unscanned, TRUE);
+
+  for (l = priv->themes; l; l = l->next)
+    {
+      IconTheme *theme = l->data;
+
+      for (d = theme->dirs; d; d = next)
+        {
+          IconThemeDir *dir = d->data;
+
+          next = d->next;
+
+          if (dir->cache == NULL && !dir->is_resource &&
+              (dir->icons == NULL || g_hash_table_size (dir->icons) == 0))
+            {
+              theme->dirs = g_list_delete_link (theme->dirs, d);
+              theme_dir_destroy (dir);
+            }
+        }
+    }
+}
+
 static gboolean
 scan_resources (GtkIconThemePrivate  *icon_theme,
                 IconThemeDir         *dir,
@@ -3167,6 +3447,12 @@ theme_subdir_load (GtkIconTheme *icon_theme,
             {
               /* This will return NULL if the cache doesn't exist or is outdated */
               dir_mtime->cache = gtk_icon_cache_new_for_path (dir_mtime->dir);
+
+              if (dir_mtime->cache == NULL && !dir_mtime->index_checked)
+                {
+                  dir_mtime->cache = gtk_icon_cache_new_for_index (dir_mtime->dir);
+                  dir_mtime->index_checked = TRUE;
+                }
             }
 
           dir = g_new0 (IconThemeDir, 1);
@@ -3191,7 +3477,14 @@ theme_subdir_load (GtkIconTheme *icon_theme,
             {
               dir->cache = NULL;
               dir->subdir_index = -1;
-              has_icons = scan_directory (icon_theme->priv, dir, full_dir);
+              if (icon_theme->priv->unscanned_dirs)
+                {
+                  /* Scanned later, see scan_directories() */
+                  g_ptr_array_add (icon_theme->priv->unscanned_dirs, dir);
+                  has_icons = TRUE;
+                }
+              else
+                has_icons = scan_directory (icon_theme->priv, dir, full_dir);
             }
 
           if (has_icons)
@@ -3295,8 +3588,6 @@ icon_info_dup (GtkIconInfo *icon_info)
   dup->is_resource = icon_info->is_resource;
   dup->min_size = icon_info->min_size;
   dup->max_size = icon_info->max_size;
-  dup->symbolic_width = icon_info->symbolic_width;
-  dup->symbolic_height = icon_info->symbolic_height;
 
   return dup;
 }
@@ -3751,6 +4042,13 @@ gtk_icon_info_load_texture (GtkIconInfo *icon_info)
       icon_info->texture = gdk_texture_new_for_pixbuf (pixbuf);
       g_object_unref (pixbuf);
 
+      /* Keep the info, and with it its entry in the info cache, alive
+       * for as long as anybody uses the texture. That way all lookups
+       * of the same icon, size and scale share one texture and one
+       * upload, no matter how much the LRU churns in the meantime.
+       */
+      g_object_set_data_full (G_OBJECT (icon_info->texture), "gtk-icon-info",
+                              g_object_ref (icon_info), g_object_unref);
       g_object_add_weak_pointer (G_OBJECT (icon_info->texture), (void **)&icon_info->texture);
     }
 
@@ -3866,6 +4164,258 @@ gtk_icon_info_load_icon_finish (GtkIconInfo   *icon_info,
   return gtk_icon_info_load_icon (icon_info, error);
 }
 
+typedef struct {
+  GPtrArray *infos;
+  guint n_pending;
+} LoadTexturesData;
+
+static void
+object_unref0 (gpointer data)
+{
+  if (data)
+    g_object_unref (data);
+}
+
+static void
+load_textures_data_free (gpointer data)
+{
+  LoadTexturesData *load_data = data;
+
+  g_ptr_array_unref (load_data->infos);
+  g_slice_free (LoadTexturesData, load_data);
+}
+
+static void
+load_textures_complete (GTask *task)
+{
+  LoadTexturesData *data = g_task_get_task_data (task);
+  GPtrArray *textures;
+  guint i;
+
+  if (g_task_return_error_if_cancelled (task))
+    return;
+
+  textures = g_ptr_array_new_full (data->infos->len, object_unref0);
+
+  for (i = 0; i < data->infos->len; i++)
+    {
+      GtkIconInfo *icon_info = g_ptr_array_index (data->infos, i);
+
+      /* All loads have finished, so this doesn't block */
+      if (icon_info && icon_info->pixbuf)
+        g_ptr_array_add (textures, gtk_icon_info_load_texture (icon_info));
+      else
+        g_ptr_array_add (textures, NULL);
+    }
+
+  g_task_return_pointer (task, textures, (GDestroyNotify) g_ptr_array_unref);
+}
+
+static void
+load_textures_icon_loaded (GObject      *source,
+                           GAsyncResult *result,
+                           gpointer      user_data)
+{
+  GTask *task = user_data;
+  LoadTexturesData *data = g_task_get_task_data (task);
+  GdkPixbuf *pixbuf;
+
+  /* Copies the result of the thread back into the icon info */
+  pixbuf = gtk_icon_info_load_icon_finish (GTK_ICON_INFO (source), result, NULL);
+  g_clear_object (&pixbuf);
+
+  data->n_pending--;
+  if (data->n_pending == 0)
+    load_textures_complete (task);
+
+  g_object_unref (task);
+}
+
+/*
+ * gtk_icon_theme_load_textures_async:
+ * @icon_theme: a #GtkIconTheme
+ * @icons: (array length=n_icons): the icons to load
+ * @n_icons: the number of icons in @icons
+ * @size: desired icon size
+ * @scale: the desired scale
+ * @flags: flags modifying the behavior of the icon lookup
+ * @cancellable: (allow-none): optional #GCancellable object
+ * @callback: (scope async): a #GAsyncReadyCallback to call when all
+ *     icons are loaded
+ * @user_data: (closure): the data to pass to callback function
+ *
+ * Looks up and loads a number of icons at once. Icons that are looked
+ * up more than once are only loaded once, and icons that aren't loaded
+ * yet are loaded on worker threads in parallel.
+ *
+ * Use gtk_icon_theme_load_textures_finish() to get the textures.
+ */
+void
+gtk_icon_theme_load_textures_async (GtkIconTheme        *icon_theme,
+                                    GIcon              **icons,
+                                    guint                n_icons,
+                                    gint                 size,
+                                    gint                 scale,
+                                    GtkIconLookupFlags   flags,
+                                    GCancellable        *cancellable,
+                                    GAsyncReadyCallback  callback,
+                                    gpointer             user_data)
+{
+  LoadTexturesData *data;
+  GHashTable *seen;
+  GTask *task;
+  guint i;
+
+  g_return_if_fail (GTK_IS_ICON_THEME (icon_theme));
+  g_return_if_fail (icons != NULL || n_icons == 0);
+
+  task = g_task_new (icon_theme, cancellable, callback, user_data);
+  g_task_set_source_tag (task, gtk_icon_theme_load_textures_async);
+
+  data = g_slice_new0 (LoadTexturesData);
+  data->infos = g_ptr_array_new_full (n_icons, object_unref0);
+  g_task_set_task_data (task, data, load_textures_data_free);
+
+  /* Don't complete before all loads are started */
+  data->n_pending = 1;
+
+  seen = g_hash_table_new (NULL, NULL);
+
+  for (i = 0; i < n_icons; i++)
+    {
+      GtkIconInfo *icon_info;
+
+      icon_info = gtk_icon_theme_lookup_by_gicon_for_scale (icon_theme, icons[i],
+                                                            size, scale, flags);
+      g_ptr_array_add (data->infos, icon_info);
+
+      /* Identical lookups return the same cached info */
+      if (icon_info == NULL || !g_hash_table_add (seen, icon_info))
+        continue;
+
+      if (!icon_info_get_pixbuf_ready (icon_info))
+        {
+          data->n_pending++;
+          gtk_icon_info_load_icon_async (icon_info, cancellable,
+                                         load_textures_icon_loaded,
+                                         g_object_ref (task));
+        }
+    }
+
+  g_hash_table_unref (seen);
+
+  data->n_pending--;
+  if (data->n_pending == 0)
+    load_textures_complete (task);
+
+  g_object_unref (task);
+}
+
+/*
+ * gtk_icon_theme_load_textures_finish:
+ * @icon_theme: a #GtkIconTheme
+ * @result: a #GAsyncResult
+ * @error: (allow-none): location to store error information on failure,
+ *     or %NULL.
+ *
+ * Finishes a load started with gtk_icon_theme_load_textures_async().
+ *
+ * Returns: (transfer full) (element-type GdkTexture): an array with a
+ *   texture for each of the icons, in the same order, with %NULL for
+ *   icons that could not be found or loaded
+ */
+GPtrArray *
+gtk_icon_theme_load_textures_finish (GtkIconTheme  *icon_theme,
+                                     GAsyncResult  *result,
+                                     GError       **error)
+{
+  g_return_val_if_fail (g_task_is_valid (result, icon_theme), NULL);
+
+  return g_task_propagate_pointer (G_TASK (result), error);
+}
+
+static void
+flush_prefetch (GtkIconTheme *icon_theme)
+{
+  GtkIconThemePrivate *priv = icon_theme->priv;
+  GPtrArray *icons = priv->prefetch_icons;
+
+  if (icons == NULL)
+    return;
+
+  priv->prefetch_icons = NULL;
+
+  gtk_icon_theme_load_textures_async (icon_theme,
+                                      (GIcon **) icons->pdata, icons->len,
+                                      priv->prefetch_size,
+                                      priv->prefetch_scale,
+                                      priv->prefetch_flags,
+                                      NULL, NULL, NULL);
+
+  g_ptr_array_unref (icons);
+}
+
+static gboolean
+prefetch_idle (gpointer user_data)
+{
+  GtkIconTheme *icon_theme = user_data;
+
+  icon_theme->priv->prefetch_idle = 0;
+  flush_prefetch (icon_theme);
+
+  return G_SOURCE_REMOVE;
+}
+
+/*
+ * gtk_icon_theme_prefetch_icon:
+ * @icon_theme: a #GtkIconTheme
+ * @icon: the icon to load
+ * @size: desired icon size
+ * @scale: the desired scale
+ * @flags: flags modifying the behavior of the icon lookup
+ *
+ * Lets @icon_theme know that @icon is likely to be needed soon,
+ * e.g. for a row that was just measured but isn't drawn yet.
+ * Icons prefetched in a row are loaded together from an idle,
+ * see gtk_icon_theme_load_textures_async().
+ */
+void
+gtk_icon_theme_prefetch_icon (GtkIconTheme       *icon_theme,
+                              GIcon              *icon,
+                              gint                size,
+                              gint                scale,
+                              GtkIconLookupFlags  flags)
+{
+  GtkIconThemePrivate *priv;
+
+  g_return_if_fail (GTK_IS_ICON_THEME (icon_theme));
+  g_return_if_fail (G_IS_ICON (icon));
+
+  priv = icon_theme->priv;
+
+  if (priv->prefetch_icons &&
+      (priv->prefetch_size != size ||
+       priv->prefetch_scale != scale ||
+       priv->prefetch_flags != flags))
+    flush_prefetch (icon_theme);
+
+  if (priv->prefetch_icons == NULL)
+    {
+      priv->prefetch_icons = g_ptr_array_new_with_free_func (g_object_unref);
+      priv->prefetch_size = size;
+      priv->prefetch_scale = scale;
+      priv->prefetch_flags = flags;
+    }
+
+  g_ptr_array_add (priv->prefetch_icons, g_object_ref (icon));
+
+  if (priv->prefetch_idle == 0)
+    {
+      priv->prefetch_idle = g_idle_add (prefetch_idle, icon_theme);
+      g_source_set_name_by_id (priv->prefetch_idle, "[gtk] prefetch_idle");
+    }
+}
+
 static void
 proxy_symbolic_pixbuf_destroy (guchar   *pixels,
                                gpointer  data)
@@ -3916,21 +4466,6 @@ symbolic_cache_get_proxy (SymbolicPixbufCache *symbolic_cache,
   return symbolic_cache->proxy_pixbuf;
 }
 
-#define MAX_RGB_STRING_LENGTH (3 + 1 + ((3 + 1) * 3) + 1 + 1)
-static inline void
-rgba_to_string_noalpha (const GdkRGBA *rgba,
-                        char          *buff)
-{
-  /* gdk_rgba_to_string inlined in here for the alpha == 1 case,
-   * and g_strdup_printf replaced with g_snprintf */
-  g_snprintf (buff,
-              MAX_RGB_STRING_LENGTH,
-              "rgb(%d,%d,%d)",
-              (int)(0.5 + CLAMP (rgba->red, 0., 1.) * 255.),
-              (int)(0.5 + CLAMP (rgba->green, 0., 1.) * 255.),
-              (int)(0.5 + CLAMP (rgba->blue, 0., 1.) * 255.));
-}
-
 static void
 rgba_to_pixel(const GdkRGBA  *rgba,
 	      guint8 pixel[4])
@@ -4025,13 +4560,18 @@ gtk_icon_theme_color_symbolic_pixbuf (GdkPixbuf     *symbolic,
   return colored;
 }
 
+/* Symbolic SVGs are rendered once into the same color-keyed mask
+ * format as .symbolic.png files (see gtk_make_symbolic_pixbuf_from_file()),
+ * so each new color combination only needs a pass over the pixels
+ * instead of rendering the SVG again.
+ */
 static GdkPixbuf *
-gtk_icon_info_load_symbolic_png (GtkIconInfo    *icon_info,
-                                 const GdkRGBA  *fg,
-                                 const GdkRGBA  *success_color,
-                                 const GdkRGBA  *warning_color,
-                                 const GdkRGBA  *error_color,
-                                 GError        **error)
+gtk_icon_info_color_symbolic (GtkIconInfo    *icon_info,
+                              const GdkRGBA  *fg,
+                              const GdkRGBA  *success_color,
+                              const GdkRGBA  *warning_color,
+                              const GdkRGBA  *error_color,
+                              GError        **error)
 {
   GdkRGBA fg_default = { 0.7450980392156863, 0.7450980392156863, 0.7450980392156863, 1.0};
   GdkRGBA success_default = { 0.3046921492332342,0.6015716792553597, 0.023437857633325704, 1.0};
@@ -4063,133 +4603,6 @@ gtk_icon_info_load_symbolic_png (GtkIconInfo    *icon_info,
                                                error_color ? error_color : &error_default);
 }
 
-static GdkPixbuf *
-gtk_icon_info_load_symbolic_svg (GtkIconInfo    *icon_info,
-                                 const GdkRGBA  *fg,
-                                 const GdkRGBA  *success_color,
-                                 const GdkRGBA  *warning_color,
-                                 const GdkRGBA  *error_color,
-                                 GError        **error)
-{
-  GInputStream *stream;
-  GdkPixbuf *pixbuf;
-  char css_fg[MAX_RGB_STRING_LENGTH];
-  char css_warning[MAX_RGB_STRING_LENGTH] = "rgb(245,121,62)";
-  char css_success[MAX_RGB_STRING_LENGTH] = "rgb(78,154,6)";
-  char css_error[MAX_RGB_STRING_LENGTH] = "rgb(204,0,0)";
-  gchar *data;
-  gchar *width;
-  gchar *height;
-  gchar *file_data, *escaped_file_data;
-  gsize file_len;
-  gint symbolic_size;
-  double alpha;
-  gchar alphastr[G_ASCII_DTOSTR_BUF_SIZE];
-
-  alpha = fg->alpha;
-
-  rgba_to_string_noalpha (fg, css_fg);
-
-  if (warning_color)
-    rgba_to_string_noalpha (warning_color, css_warning);
-
-  if (error_color)
-    rgba_to_string_noalpha (error_color, css_error);
-
-  if (success_color)
-    rgba_to_string_noalpha (success_color, css_success);
-
-  if (!g_file_load_contents (icon_info->icon_file, NULL, &file_data, &file_len, NULL, error))
-    return NULL;
-
-  if (!icon_info_ensure_scale_and_pixbuf (icon_info))
-    {
-      g_propagate_error (error, icon_info->load_error);
-      icon_info->load_error = NULL;
-      g_free (file_data);
-      return NULL;
-    }
-
-  if (icon_info->symbolic_width == 0 ||
-      icon_info->symbolic_height == 0)
-    {
-      /* Fetch size from the original icon */
-      stream = g_memory_input_stream_new_from_data (file_data, file_len, NULL);
-      pixbuf = gdk_pixbuf_new_from_stream (stream, NULL, error);
-      g_object_unref (stream);
-
-      if (!pixbuf)
-        {
-          g_free (file_data);
-          return NULL;
-        }
-
-      icon_info->symbolic_width = gdk_pixbuf_get_width (pixbuf);
-      icon_info->symbolic_height = gdk_pixbuf_get_height (pixbuf);
-      g_object_unref (pixbuf);
-    }
-
-  symbolic_size = MAX (icon_info->symbolic_width, icon_info->symbolic_height);
-
-  GTK_NOTE (ICONTHEME,
-  if (icon_info->dir_type == ICON_THEME_DIR_UNTHEMED)
-    g_message ("Symbolic icon %s is not in an icon theme directory",
-               icon_info->key.icon_names ? icon_info->key.icon_names[0] : icon_info->filename);
-  else if (icon_info->dir_size * icon_info->dir_scale != symbolic_size)
-    g_message ("Symbolic icon %s of size %d is in an icon theme directory of size %d",
-               icon_info->key.icon_names ? icon_info->key.icon_names[0] : icon_info->filename,
-               symbolic_size,
-               icon_info->dir_size * icon_info->dir_scale)
-  );
-
-  width = g_strdup_printf ("%d", icon_info->symbolic_width);
-  height = g_strdup_printf ("%d", icon_info->symbolic_height);
-
-  escaped_file_data = g_base64_encode ((guchar *) file_data, file_len);
-  g_free (file_data);
-
-  g_ascii_dtostr (alphastr, G_ASCII_DTOSTR_BUF_SIZE, CLAMP (alpha, 0, 1));
-
-  data = g_strconcat ("<?xml version=\"1.0\" encoding=\"UTF-8\" standalone=\"no\"?>\n"
-                      "<svg version=\"1.1\"\n"
-                      "     xmlns=\"http://www.w3.org/2000/svg\"\n"
-                      "     xmlns:xi=\"http://www.w3.org/2001/XInclude\"\n"
-                      "     width=\"", width, "\"\n"
-                      "     height=\"", height, "\">\n"
-                      "  <style type=\"text/css\">\n"
-                      "    rect,path,ellipse,circle,polygon {\n"
-                      "      fill: ", css_fg," !important;\n"
-                      "    }\n"
-                      "    .warning {\n"
-                      "      fill: ", css_warning, " !important;\n"
-                      "    }\n"
-                      "    .error {\n"
-                      "      fill: ", css_error ," !important;\n"
-                      "    }\n"
-                      "    .success {\n"
-                      "      fill: ", css_success, " !important;\n"
-                      "    }\n"
-                      "  </style>\n"
-                      "  <g opacity=\"", alphastr, "\" ><xi:include href=\"data:text/xml;base64,", escaped_file_data, "\"/></g>\n"
-                      "</svg>",
-                      NULL);
-  g_free (escaped_file_data);
-  g_free (width);
-  g_free (height);
-
-  stream = g_memory_input_stream_new_from_data (data, -1, g_free);
-  pixbuf = gdk_pixbuf_new_from_stream_at_scale (stream,
-                                                gdk_pixbuf_get_width (icon_info->pixbuf),
-                                                gdk_pixbuf_get_height (icon_info->pixbuf),
-                                                TRUE,
-                                                NULL,
-                                                error);
-  g_object_unref (stream);
-
-  return pixbuf;
-}
-
-
 static GdkPixbuf *
 gtk_icon_info_load_symbolic_internal (GtkIconInfo    *icon_info,
 				      const GdkRGBA  *fg,
@@ -4201,7 +4614,6 @@ gtk_icon_info_load_symbolic_internal (GtkIconInfo    *icon_info,
 {
   GdkPixbuf *pixbuf;
   SymbolicPixbufCache *symbolic_cache;
-  char *icon_uri;
 
   if (use_cache)
     {
@@ -4216,13 +4628,7 @@ gtk_icon_info_load_symbolic_internal (GtkIconInfo    *icon_info,
    */
   g_return_val_if_fail (fg != NULL, NULL);
 
-  icon_uri = g_file_get_uri (icon_info->icon_file);
-  if (g_str_has_suffix (icon_uri, ".symbolic.png"))
-    pixbuf = gtk_icon_info_load_symbolic_png (icon_info, fg, success_color, warning_color, error_color, error);
-  else
-    pixbuf = gtk_icon_info_load_symbolic_svg (icon_info, fg, success_color, warning_color, error_color, error);
-
-  g_free (icon_uri);
+  pixbuf = gtk_icon_info_color_symbolic (icon_info, fg, success_color, warning_color, error_color, error);
 
   if (pixbuf != NULL)
     {
@@ -27,4 +27,22 @@ void        gtk_icon_theme_lookup_symbolic_colors       (GtkCssStyle    *style,
                                                          GdkRGBA        *warning_out,
                                                          GdkRGBA        *error_out);
 
+void        gtk_icon_theme_load_textures_async          (GtkIconTheme        *icon_theme,
+                                                         GIcon              **icons,
+                                                         guint                n_icons,
+                                                         gint                 size,
+                                                         gint                 scale,
+                                                         GtkIconLookupFlags   flags,
+                                                         GCancellable        *cancellable,
+                                                         GAsyncReadyCallback  callback,
+                                                         gpointer             user_data);
+GPtrArray * gtk_icon_theme_load_textures_finish         (GtkIconTheme        *icon_theme,
+                                                         GAsyncResult        *result,
+                                                         GError             **error);
+void        gtk_icon_theme_prefetch_icon                (GtkIconTheme        *icon_theme,
+                                                         GIcon               *icon,
+                                                         gint                 size,
+                                                         gint                 scale,
+                                                         GtkIconLookupFlags   flags);
+
 #endif /* __GTK_ICON_THEME_PRIVATE_H__ */
@@ -83,6 +83,17 @@
 
 #define SCROLL_EDGE_SIZE 15
 
+typedef struct _GtkIconViewRow GtkIconViewRow;
+struct _GtkIconViewRow
+{
+  /* the link of the first item in the row */
+  GList *items;
+
+  /* the cells, without item padding */
+  gint y;
+  gint height;
+};
+
 typedef struct _GtkIconViewChild GtkIconViewChild;
 struct _GtkIconViewChild
 {
@@ -159,6 +170,7 @@ static void             gtk_icon_view_size_allocate             (GtkWidget
                                                                  int                 baseline);
 static void             gtk_icon_view_snapshot                  (GtkWidget          *widget,
                                                                  GtkSnapshot        *snapshot);
+static void             gtk_icon_view_style_updated             (GtkWidget          *widget);
 static void             gtk_icon_view_motion                    (GtkEventController *controller,
                                                                  double              x,
                                                                  double              y,
@@ -233,6 +245,7 @@ static gboolean             gtk_icon_view_unselect_all_internal          (GtkIco
 static void                 gtk_icon_view_update_rubberband              (GtkIconView            *icon_view);
 static void                 gtk_icon_view_item_invalidate_size           (GtkIconViewItem        *item);
 static void                 gtk_icon_view_invalidate_sizes               (GtkIconView            *icon_view);
+static void                 gtk_icon_view_clear_item_sizes               (GtkIconView            *icon_view);
 static void                 gtk_icon_view_add_move_binding               (GtkBindingSet          *binding_set,
 									  guint                   keyval,
 									  guint                   modmask,
@@ -357,6 +370,7 @@ gtk_icon_view_class_init (GtkIconViewClass *klass)
   widget_class->measure = gtk_icon_view_measure;
   widget_class->size_allocate = gtk_icon_view_size_allocate;
   widget_class->snapshot = gtk_icon_view_snapshot;
+  widget_class->style_updated = gtk_icon_view_style_updated;
   widget_class->drag_begin = gtk_icon_view_drag_begin;
   widget_class->drag_end = gtk_icon_view_drag_end;
   widget_class->drag_data_get = gtk_icon_view_drag_data_get;
@@ -952,6 +966,7 @@ gtk_icon_view_init (GtkIconView *icon_view)
 
   icon_view->priv->row_contexts = 
     g_ptr_array_new_with_free_func ((GDestroyNotify)g_object_unref);
+  icon_view->priv->rows = g_array_new (FALSE, FALSE, sizeof (GtkIconViewRow));
 
   gtk_style_context_add_class (gtk_widget_get_style_context (GTK_WIDGET (icon_view)),
                                GTK_STYLE_CLASS_VIEW);
@@ -1009,6 +1024,9 @@ gtk_icon_view_dispose (GObject *object)
       priv->row_contexts = NULL;
     }
 
+  g_clear_pointer (&priv->rows, g_array_unref);
+  gtk_icon_view_clear_item_sizes (icon_view);
+
   if (priv->cell_area)
     {
       gtk_cell_area_stop_editing (icon_view->priv->cell_area, TRUE);
@@ -1384,22 +1402,40 @@ gtk_icon_view_is_empty (GtkIconView *icon_view)
   return icon_view->priv->items == NULL;
 }
 
-static void
-gtk_icon_view_get_preferred_item_size (GtkIconView    *icon_view,
-                                       GtkOrientation  orientation,
-                                       gint            for_size,
-                                       gint           *minimum,
-                                       gint           *natural)
+/* Measuring all items is the expensive part of size requests, so the
+ * contexts with the sizes of all items are kept: one per orientation
+ * for the sizes without a size in the other orientation, and one for
+ * the last other size asked for. Items that are added or changed are
+ * measured into them, so item sizes only grow until something drops
+ * the contexts with gtk_icon_view_clear_item_sizes().
+ */
+static GtkCellAreaContext *
+gtk_icon_view_get_item_size_context (GtkIconView    *icon_view,
+                                     GtkOrientation  orientation,
+                                     gint            for_size)
 {
   GtkIconViewPrivate *priv = icon_view->priv;
-  GtkCellAreaContext *context;
+  GtkCellAreaContext **context;
   GList *items;
 
-  g_assert (!gtk_icon_view_is_empty (icon_view));
+  if (for_size > 0)
+    {
+      context = &priv->item_size_contexts[2];
+      if (*context &&
+          (priv->item_size_orientation != orientation ||
+           priv->item_size_for_size != for_size))
+        g_clear_object (context);
+
+      priv->item_size_orientation = orientation;
+      priv->item_size_for_size = for_size;
+    }
+  else
+    context = &priv->item_size_contexts[orientation];
 
-  context = gtk_cell_area_create_context (priv->cell_area);
+  if (*context)
+    return *context;
 
-  for_size -= 2 * priv->item_padding;
+  *context = gtk_cell_area_create_context (priv->cell_area);
 
   if (for_size > 0)
     {
@@ -1409,7 +1445,7 @@ gtk_icon_view_get_preferred_item_size (GtkIconView    *icon_view,
           GtkIconViewItem *item = items->data;
 
           _gtk_icon_view_set_cell_data (icon_view, item);
-          cell_area_get_preferred_size (icon_view, context, 1 - orientation, -1, NULL, NULL);
+          cell_area_get_preferred_size (icon_view, *context, 1 - orientation, -1, NULL, NULL);
         }
     }
 
@@ -1420,8 +1456,98 @@ gtk_icon_view_get_preferred_item_size (GtkIconView    *icon_view,
       _gtk_icon_view_set_cell_data (icon_view, item);
       if (items == priv->items)
         adjust_wrap_width (icon_view);
-      cell_area_get_preferred_size (icon_view, context, orientation, for_size, NULL, NULL);
+      cell_area_get_preferred_size (icon_view, *context, orientation, for_size, NULL, NULL);
+    }
+
+  return *context;
+}
+
+static void
+gtk_icon_view_clear_item_sizes (GtkIconView *icon_view)
+{
+  GtkIconViewPrivate *priv = icon_view->priv;
+  guint i;
+
+  for (i = 0; i < G_N_ELEMENTS (priv->item_size_contexts); i++)
+    g_clear_object (&priv->item_size_contexts[i]);
+}
+
+static void
+get_context_size (GtkCellAreaContext *context,
+                  GtkOrientation      orientation,
+                  gint               *minimum,
+                  gint               *natural)
+{
+  if (orientation == GTK_ORIENTATION_HORIZONTAL)
+    gtk_cell_area_context_get_preferred_width (context, minimum, natural);
+  else
+    gtk_cell_area_context_get_preferred_height (context, minimum, natural);
+}
+
+/* Measures @item into the kept item size contexts */
+static void
+gtk_icon_view_add_item_size (GtkIconView     *icon_view,
+                             GtkIconViewItem *item)
+{
+  GtkIconViewPrivate *priv = icon_view->priv;
+  GtkCellAreaContext *context;
+  GtkOrientation orientation;
+  gint min, nat, new_min, new_nat;
+
+  /* The wrap width is guessed from the first item */
+  if (item->index == 0)
+    {
+      gtk_icon_view_clear_item_sizes (icon_view);
+      return;
+    }
+
+  if (priv->item_size_contexts[0] == NULL &&
+      priv->item_size_contexts[1] == NULL &&
+      priv->item_size_contexts[2] == NULL)
+    return;
+
+  _gtk_icon_view_set_cell_data (icon_view, item);
+
+  if (priv->item_size_contexts[GTK_ORIENTATION_HORIZONTAL])
+    cell_area_get_preferred_size (icon_view, priv->item_size_contexts[GTK_ORIENTATION_HORIZONTAL],
+                                  GTK_ORIENTATION_HORIZONTAL, -1, NULL, NULL);
+  if (priv->item_size_contexts[GTK_ORIENTATION_VERTICAL])
+    cell_area_get_preferred_size (icon_view, priv->item_size_contexts[GTK_ORIENTATION_VERTICAL],
+                                  GTK_ORIENTATION_VERTICAL, -1, NULL, NULL);
+
+  context = priv->item_size_contexts[2];
+  if (context)
+    {
+      orientation = priv->item_size_orientation;
+
+      /* The other items were measured for the old size in the
+       * other orientation */
+      get_context_size (context, 1 - orientation, &min, &nat);
+      cell_area_get_preferred_size (icon_view, context, 1 - orientation, -1, NULL, NULL);
+      get_context_size (context, 1 - orientation, &new_min, &new_nat);
+
+      if (min != new_min || nat != new_nat)
+        g_clear_object (&priv->item_size_contexts[2]);
+      else
+        cell_area_get_preferred_size (icon_view, context, orientation, priv->item_size_for_size, NULL, NULL);
     }
+}
+
+static void
+gtk_icon_view_get_preferred_item_size (GtkIconView    *icon_view,
+                                       GtkOrientation  orientation,
+                                       gint            for_size,
+                                       gint           *minimum,
+                                       gint           *natural)
+{
+  GtkIconViewPrivate *priv = icon_view->priv;
+  GtkCellAreaContext *context;
+
+  g_assert (!gtk_icon_view_is_empty (icon_view));
+
+  for_size -= 2 * priv->item_padding;
+
+  context = gtk_icon_view_get_item_size_context (icon_view, orientation, for_size);
 
   if (orientation == GTK_ORIENTATION_HORIZONTAL)
     {
@@ -1456,8 +1582,6 @@ gtk_icon_view_get_preferred_item_size (GtkIconView    *icon_view,
     *minimum = MAX (1, *minimum + 2 * priv->item_padding);
   if (natural)
     *natural = MAX (1, *natural + 2 * priv->item_padding);
-
-  g_object_unref (context);
 }
 
 static void
@@ -1660,7 +1784,9 @@ gtk_icon_view_snapshot (GtkWidget   *widget,
                         GtkSnapshot *snapshot)
 {
   GtkIconView *icon_view;
+  GArray *rows;
   GList *icons;
+  guint i, first_row, last_row;
   GtkTreePath *path;
   gint dest_index;
   GtkIconViewDropPosition dest_pos;
@@ -1670,6 +1796,7 @@ gtk_icon_view_snapshot (GtkWidget   *widget,
   double offset_x, offset_y;
 
   icon_view = GTK_ICON_VIEW (widget);
+  rows = icon_view->priv->rows;
 
   context = gtk_widget_get_style_context (widget);
 
@@ -1696,26 +1823,44 @@ gtk_icon_view_snapshot (GtkWidget   *widget,
   else
     dest_index = -1;
 
-  for (icons = icon_view->priv->items; icons; icons = icons->next)
+  /* Find the first visible row, rows are sorted by position */
+  first_row = 0;
+  last_row = rows->len;
+  while (first_row < last_row)
     {
-      GtkIconViewItem *item = icons->data;
-      graphene_rect_t area;
+      guint mid = (first_row + last_row) / 2;
+      const GtkIconViewRow *row = &g_array_index (rows, GtkIconViewRow, mid);
+
+      if (row->y + row->height <= offset_y)
+        first_row = mid + 1;
+      else
+        last_row = mid;
+    }
+
+  for (i = first_row; i < rows->len; i++)
+    {
+      const GtkIconViewRow *row = &g_array_index (rows, GtkIconViewRow, i);
+      gint col;
 
-      graphene_rect_init (&area,
-                          item->cell_area.x - icon_view->priv->item_padding,
-                          item->cell_area.y - icon_view->priv->item_padding,
-                          item->cell_area.width  + icon_view->priv->item_padding * 2,
-                          item->cell_area.height + icon_view->priv->item_padding * 2);
+      if (row->y >= offset_y + height)
+        break;
 
-      if (gdk_rectangle_intersect (&item->cell_area,
-                                   &(GdkRectangle) { offset_x, offset_y, width, height }, NULL))
+      for (icons = row->items, col = 0;
+           icons && col < icon_view->priv->layout_columns;
+           icons = icons->next, col++)
         {
-          gtk_icon_view_snapshot_item (icon_view, snapshot, item,
-                                       item->cell_area.x, item->cell_area.y,
-                                       icon_view->priv->draw_focus);
+          GtkIconViewItem *item = icons->data;
 
-          if (dest_index == item->index)
-            dest_item = item;
+          if (gdk_rectangle_intersect (&item->cell_area,
+                                       &(GdkRectangle) { offset_x, offset_y, width, height }, NULL))
+            {
+              gtk_icon_view_snapshot_item (icon_view, snapshot, item,
+                                           item->cell_area.x, item->cell_area.y,
+                                           icon_view->priv->draw_focus);
+
+              if (dest_index == item->index)
+                dest_item = item;
+            }
         }
     }
 
@@ -1770,6 +1915,22 @@ gtk_icon_view_snapshot (GtkWidget   *widget,
   GTK_WIDGET_CLASS (gtk_icon_view_parent_class)->snapshot (widget, snapshot);
 }
 
+static void
+gtk_icon_view_style_updated (GtkWidget *widget)
+{
+  GtkStyleContext *style_context;
+  GtkCssStyleChange *change;
+
+  GTK_WIDGET_CLASS (gtk_icon_view_parent_class)->style_updated (widget);
+
+  style_context = gtk_widget_get_style_context (widget);
+  change = gtk_style_context_get_change (style_context);
+
+  /* Rows are only laid out again as needed, see gtk_icon_view_layout() */
+  if (change == NULL || gtk_css_style_change_affects (change, GTK_CSS_AFFECTS_SIZE))
+    gtk_icon_view_invalidate_sizes (GTK_ICON_VIEW (widget));
+}
+
 static gboolean
 rubberband_scroll_timeout (gpointer data)
 {
@@ -2735,47 +2896,56 @@ compare_sizes (gconstpointer p1,
        - GPOINTER_TO_INT (((const GtkRequestedSize *) p2)->data);
 }
 
-static void
-gtk_icon_view_layout (GtkIconView *icon_view)
+/* Lays out the rows from @first_row on, keeping the rows before. Returns
+ * %FALSE if that is not possible because the new rows change the cell
+ * widths all rows share or the height left for distributing over all
+ * rows, and everything needs to be laid out.
+ */
+static gboolean
+gtk_icon_view_layout_rows (GtkIconView *icon_view,
+                           gint         first_row,
+                           gint         n_columns,
+                           gint         item_width,
+                           gboolean     rtl)
 {
   GtkIconViewPrivate *priv = icon_view->priv;
   GtkWidget *widget = GTK_WIDGET (icon_view);
-  GList *items;
-  gint item_width; /* this doesn't include item_padding */
-  gint n_columns, n_rows, n_items;
-  gint col, row;
+  GList *items, *first_items;
+  gint n_rows, n_items;
+  gint col, row, y;
+  gint min_width, nat_width, old_min_width, old_nat_width;
   GtkRequestedSize *sizes;
-  gboolean rtl;
-  int width, height;
-
-  if (gtk_icon_view_is_empty (icon_view))
-    return;
+  int height;
 
-  rtl = gtk_widget_get_direction (GTK_WIDGET (icon_view)) == GTK_TEXT_DIR_RTL;
   n_items = gtk_icon_view_get_n_items (icon_view);
-
-  width = gtk_widget_get_width (widget);
+  n_rows = (n_items + n_columns - 1) / n_columns;
   height = gtk_widget_get_height (widget);
 
-  gtk_icon_view_compute_n_items_for_size (icon_view, 
-                                          GTK_ORIENTATION_HORIZONTAL,
-                                          width,
-                                          NULL, NULL,
-                                          &n_columns, &item_width);
-  n_rows = (n_items + n_columns - 1) / n_columns;
+  /* Clear the per row contexts */
+  g_array_set_size (priv->rows, first_row);
+  g_ptr_array_set_size (priv->row_contexts, first_row);
 
-  priv->width = n_columns * (item_width + 2 * priv->item_padding + priv->column_spacing) - priv->column_spacing;
-  priv->width += 2 * priv->margin;
-  priv->width = MAX (priv->width, width);
+  if (first_row == 0)
+    {
+      gtk_cell_area_context_reset (priv->cell_area_context);
+      first_items = priv->items;
+      y = priv->margin;
+    }
+  else
+    {
+      const GtkIconViewRow *last_row = &g_array_index (priv->rows, GtkIconViewRow, first_row - 1);
 
-  /* Clear the per row contexts */
-  g_ptr_array_set_size (icon_view->priv->row_contexts, 0);
+      first_items = g_list_nth (last_row->items, n_columns);
+      y = last_row->y + last_row->height + priv->item_padding + priv->row_spacing;
+    }
+
+  gtk_cell_area_context_get_preferred_width (priv->cell_area_context,
+                                             &old_min_width, &old_nat_width);
 
-  gtk_cell_area_context_reset (priv->cell_area_context);
   /* because layouting is complicated. We designed an API
    * that is O(N²) and nonsensical.
    * And we're proud of it. */
-  for (items = priv->items; items; items = items->next)
+  for (items = first_items; items; items = items->next)
     {
       _gtk_icon_view_set_cell_data (icon_view, items->data);
       gtk_cell_area_get_preferred_width (priv->cell_area,
@@ -2784,12 +2954,20 @@ gtk_icon_view_layout (GtkIconView *icon_view)
                                          NULL, NULL);
     }
 
-  sizes = g_newa (GtkRequestedSize, n_rows);
-  items = priv->items;
-  priv->height = priv->margin;
+  if (first_row > 0)
+    {
+      gtk_cell_area_context_get_preferred_width (priv->cell_area_context,
+                                                 &min_width, &nat_width);
+      if (min_width != old_min_width || nat_width != old_nat_width)
+        return FALSE;
+    }
+
+  sizes = g_newa (GtkRequestedSize, n_rows - first_row);
+  items = first_items;
+  priv->height = y;
 
   /* Collect the heights for all rows */
-  for (row = 0; row < n_rows; row++)
+  for (row = first_row; row < n_rows; row++)
     {
       GtkCellAreaContext *context = gtk_cell_area_copy_context (priv->cell_area, priv->cell_area_context);
       g_ptr_array_add (priv->row_contexts, context);
@@ -2806,35 +2984,49 @@ gtk_icon_view_layout (GtkIconView *icon_view)
                                                         NULL, NULL);
         }
       
-      sizes[row].data = GINT_TO_POINTER (row);
+      sizes[row - first_row].data = GINT_TO_POINTER (row);
       gtk_cell_area_context_get_preferred_height_for_width (context,
                                                             item_width,
-                                                            &sizes[row].minimum_size,
-                                                            &sizes[row].natural_size);
-      priv->height += sizes[row].minimum_size + 2 * priv->item_padding + priv->row_spacing;
+                                                            &sizes[row - first_row].minimum_size,
+                                                            &sizes[row - first_row].natural_size);
+      priv->height += sizes[row - first_row].minimum_size + 2 * priv->item_padding + priv->row_spacing;
     }
 
   priv->height -= priv->row_spacing;
   priv->height += priv->margin;
-  priv->height = MIN (priv->height, height);
 
-  gtk_distribute_natural_allocation (height - priv->height,
-                                     n_rows,
-                                     sizes);
+  if (first_row == 0)
+    {
+      priv->height = MIN (priv->height, height);
+      priv->layout_distributed = priv->height < height;
+
+      gtk_distribute_natural_allocation (height - priv->height,
+                                         n_rows,
+                                         sizes);
+
+      g_qsort_with_data (sizes, n_rows, sizeof (GtkRequestedSize), compare_sizes, NULL);
+    }
+  else if (priv->height < height)
+    return FALSE;
 
   /* Actually allocate the rows */
-  g_qsort_with_data (sizes, n_rows, sizeof (GtkRequestedSize), compare_sizes, NULL);
-  
-  items = priv->items;
-  priv->height = priv->margin;
+  items = first_items;
+  priv->height = y;
 
-  for (row = 0; row < n_rows; row++)
+  for (row = first_row; row < n_rows; row++)
     {
       GtkCellAreaContext *context = g_ptr_array_index (priv->row_contexts, row);
-      gtk_cell_area_context_allocate (context, item_width, sizes[row].minimum_size);
+      GtkIconViewRow icon_view_row;
+
+      gtk_cell_area_context_allocate (context, item_width, sizes[row - first_row].minimum_size);
 
       priv->height += priv->item_padding;
 
+      icon_view_row.items = items;
+      icon_view_row.y = priv->height;
+      icon_view_row.height = sizes[row - first_row].minimum_size;
+      g_array_append_val (priv->rows, icon_view_row);
+
       for (col = 0; col < n_columns && items; col++, items = items->next)
         {
           GtkIconViewItem *item = items->data;
@@ -2842,7 +3034,7 @@ gtk_icon_view_layout (GtkIconView *icon_view)
           item->cell_area.x = priv->margin + (col * 2 + 1) * priv->item_padding + col * (priv->column_spacing + item_width);
           item->cell_area.width = item_width;
           item->cell_area.y = priv->height;
-          item->cell_area.height = sizes[row].minimum_size;
+          item->cell_area.height = sizes[row - first_row].minimum_size;
           item->row = row;
           item->col = col;
           if (rtl)
@@ -2852,12 +3044,89 @@ gtk_icon_view_layout (GtkIconView *icon_view)
             }
         }
 
-      priv->height += sizes[row].minimum_size + priv->item_padding + priv->row_spacing;
+      priv->height += sizes[row - first_row].minimum_size + priv->item_padding + priv->row_spacing;
     }
 
   priv->height -= priv->row_spacing;
   priv->height += priv->margin;
   priv->height = MAX (priv->height, height);
+
+  return TRUE;
+}
+
+/* Only the rows from the first changed item on are laid out again when
+ * items are added, removed or changed, see gtk_icon_view_invalidate_rows().
+ * Anything that changes the size of all items drops all rows with
+ * gtk_icon_view_invalidate_sizes().
+ */
+static void
+gtk_icon_view_layout (GtkIconView *icon_view)
+{
+  GtkIconViewPrivate *priv = icon_view->priv;
+  GtkWidget *widget = GTK_WIDGET (icon_view);
+  gint item_width; /* this doesn't include item_padding */
+  gint n_columns, n_rows, n_items;
+  gint first_row;
+  gboolean rtl;
+  int width;
+
+  if (gtk_icon_view_is_empty (icon_view))
+    {
+      g_array_set_size (priv->rows, 0);
+      return;
+    }
+
+  rtl = gtk_widget_get_direction (GTK_WIDGET (icon_view)) == GTK_TEXT_DIR_RTL;
+  n_items = gtk_icon_view_get_n_items (icon_view);
+
+  width = gtk_widget_get_width (widget);
+
+  gtk_icon_view_compute_n_items_for_size (icon_view, 
+                                          GTK_ORIENTATION_HORIZONTAL,
+                                          width,
+                                          NULL, NULL,
+                                          &n_columns, &item_width);
+  n_rows = (n_items + n_columns - 1) / n_columns;
+
+  priv->width = n_columns * (item_width + 2 * priv->item_padding + priv->column_spacing) - priv->column_spacing;
+  priv->width += 2 * priv->margin;
+  priv->width = MAX (priv->width, width);
+
+  if (n_columns == priv->layout_columns &&
+      item_width == priv->layout_item_width &&
+      priv->width == priv->layout_width &&
+      rtl == priv->layout_rtl &&
+      !priv->layout_distributed)
+    first_row = MIN (priv->rows->len, n_rows);
+  else
+    first_row = 0;
+
+  if (!gtk_icon_view_layout_rows (icon_view, first_row, n_columns, item_width, rtl))
+    gtk_icon_view_layout_rows (icon_view, 0, n_columns, item_width, rtl);
+
+  priv->layout_columns = n_columns;
+  priv->layout_item_width = item_width;
+  priv->layout_width = priv->width;
+  priv->layout_rtl = rtl;
+}
+
+/* Items from @index on were added, removed or changed */
+static void
+gtk_icon_view_invalidate_rows (GtkIconView *icon_view,
+                               gint         index)
+{
+  GtkIconViewPrivate *priv = icon_view->priv;
+  guint row;
+
+  if (priv->layout_columns <= 0)
+    row = 0;
+  else
+    row = index / priv->layout_columns;
+
+  if (row < priv->rows->len)
+    g_array_set_size (priv->rows, row);
+
+  gtk_widget_queue_resize (GTK_WIDGET (icon_view));
 }
 
 static void
@@ -2866,6 +3135,8 @@ gtk_icon_view_invalidate_sizes (GtkIconView *icon_view)
   /* Clear all item sizes */
   g_list_foreach (icon_view->priv->items,
 		  (GFunc)gtk_icon_view_item_invalidate_size, NULL);
+  gtk_icon_view_clear_item_sizes (icon_view);
+  g_array_set_size (icon_view->priv->rows, 0);
 
   /* Re-layout the items */
   gtk_widget_queue_resize (GTK_WIDGET (icon_view));
@@ -3203,6 +3474,8 @@ gtk_icon_view_row_changed (GtkTreeModel *model,
                            gpointer      data)
 {
   GtkIconView *icon_view = GTK_ICON_VIEW (data);
+  GtkIconViewItem *item;
+  gint index;
 
   /* ignore changes in branches */
   if (gtk_tree_path_get_depth (path) > 1)
@@ -3215,15 +3488,16 @@ gtk_icon_view_row_changed (GtkTreeModel *model,
   if (icon_view->priv->cell_area)
     gtk_cell_area_stop_editing (icon_view->priv->cell_area, TRUE);
 
-  /* Here we can use a "grow-only" strategy for optimization
-   * and only invalidate a single item and queue a relayout
-   * instead of invalidating the whole thing.
-   *
-   * For now GtkIconView still cant deal with huge models
-   * so just invalidate the whole thing when the model
-   * changes.
+  /* We use a "grow-only" strategy for optimization: the item
+   * is measured into the item sizes, and only the rows from
+   * the item on are laid out again.
    */
-  gtk_icon_view_invalidate_sizes (icon_view);
+  index = gtk_tree_path_get_indices (path)[0];
+  item = g_list_nth_data (icon_view->priv->items, index);
+  if (item)
+    gtk_icon_view_add_item_size (icon_view, item);
+
+  gtk_icon_view_invalidate_rows (icon_view, index);
 
   verify_items (icon_view);
 }
@@ -3261,14 +3535,15 @@ gtk_icon_view_row_inserted (GtkTreeModel *model,
   list = g_list_nth (icon_view->priv->items, index + 1);
   for (; list; list = list->next)
     {
-      item = list->data;
+      GtkIconViewItem *next = list->data;
 
-      item->index++;
+      next->index++;
     }
     
   verify_items (icon_view);
 
-  gtk_widget_queue_resize (GTK_WIDGET (icon_view));
+  gtk_icon_view_add_item_size (icon_view, item);
+  gtk_icon_view_invalidate_rows (icon_view, index);
 }
 
 static void
@@ -3322,8 +3597,13 @@ gtk_icon_view_row_deleted (GtkTreeModel *model,
   icon_view->priv->items = g_list_delete_link (icon_view->priv->items, list);
 
   verify_items (icon_view);  
-  
-  gtk_widget_queue_resize (GTK_WIDGET (icon_view));
+
+  /* Item sizes only grow, except for the first item, which
+   * the wrap width is guessed from */
+  if (index == 0)
+    gtk_icon_view_clear_item_sizes (icon_view);
+
+  gtk_icon_view_invalidate_rows (icon_view, index);
 
   if (emit)
     g_signal_emit (icon_view, icon_view_signals[SELECTION_CHANGED], 0);
@@ -3371,7 +3651,8 @@ gtk_icon_view_rows_reordered (GtkTreeModel *model,
   g_list_free (icon_view->priv->items);
   icon_view->priv->items = items;
 
-  gtk_widget_queue_resize (GTK_WIDGET (icon_view));
+  gtk_icon_view_clear_item_sizes (icon_view);
+  gtk_icon_view_invalidate_rows (icon_view, 0);
 
   verify_items (icon_view);  
 }
@@ -4734,6 +5015,8 @@ gtk_icon_view_set_model (GtkIconView *icon_view,
       
       g_list_free_full (icon_view->priv->items, (GDestroyNotify) gtk_icon_view_item_free);
       icon_view->priv->items = NULL;
+      g_array_set_size (icon_view->priv->rows, 0);
+      gtk_icon_view_clear_item_sizes (icon_view);
       icon_view->priv->anchor_item = NULL;
       icon_view->priv->cursor_item = NULL;
       icon_view->priv->last_single_clicked = NULL;
@@ -48,6 +48,20 @@ struct _GtkIconViewPrivate
 
   GPtrArray          *row_contexts;
 
+  /* GtkIconViewRow, for the rows that are laid out */
+  GArray             *rows;
+
+  /* Contexts with the sizes of all items, see
+   * gtk_icon_view_get_item_size_context() */
+  GtkCellAreaContext *item_size_contexts[3];
+  GtkOrientation      item_size_orientation;
+  gint                item_size_for_size;
+
+  /* What the rows were laid out for, see gtk_icon_view_layout() */
+  gint layout_columns;
+  gint layout_item_width;
+  gint layout_width;
+
   gint width, height;
   double mouse_x;
   double mouse_y;
@@ -134,6 +148,8 @@ struct _GtkIconViewPrivate
 
   guint doing_rubberband : 1;
 
+  guint layout_rtl : 1;
+  guint layout_distributed : 1;
 };
 
 void                 _gtk_icon_view_set_cell_data                  (GtkIconView            *icon_view,
@@ -64,6 +64,11 @@
  * gdk_texture_new_from_file(), then create the #GtkImage with
  * gtk_image_new_from_paintable().
  *
+ * Decoding a large image file can take a noticeable amount of time. If
+ * #GtkImage:load-async is set, gtk_image_set_from_file() only remembers the
+ * file, and the image is decoded in a worker thread once the #GtkImage is
+ * mapped. The image stays empty until the load finishes.
+ *
  * Sometimes an application will want to avoid depending on external data
  * files, such as image files. See the documentation of #GResource for details.
  * In this case, the #GtkImage:resource, gtk_image_new_from_resource() and
@@ -86,11 +91,17 @@ typedef struct
 
   char *filename;
   char *resource_path;
+
+  GCancellable *load_cancellable;
+  int load_scale;
+  guint load_async : 1;
 } GtkImagePrivate;
 
 static void gtk_image_snapshot             (GtkWidget    *widget,
                                             GtkSnapshot  *snapshot);
 static void gtk_image_unrealize            (GtkWidget    *widget);
+static void gtk_image_map                  (GtkWidget    *widget);
+static void gtk_image_unmap                (GtkWidget    *widget);
 static void gtk_image_measure (GtkWidget      *widget,
                                GtkOrientation  orientation,
                                int            for_size,
@@ -123,6 +134,7 @@ enum
   PROP_GICON,
   PROP_RESOURCE,
   PROP_USE_FALLBACK,
+  PROP_LOAD_ASYNC,
   NUM_PROPERTIES
 };
 
@@ -146,6 +158,8 @@ gtk_image_class_init (GtkImageClass *class)
   widget_class->snapshot = gtk_image_snapshot;
   widget_class->measure = gtk_image_measure;
   widget_class->unrealize = gtk_image_unrealize;
+  widget_class->map = gtk_image_map;
+  widget_class->unmap = gtk_image_unmap;
   widget_class->style_updated = gtk_image_style_updated;
 
   image_props[PROP_PAINTABLE] =
@@ -247,6 +261,23 @@ gtk_image_class_init (GtkImageClass *class)
                             FALSE,
                             GTK_PARAM_READWRITE|G_PARAM_EXPLICIT_NOTIFY);
 
+  /**
+   * GtkImage:load-async:
+   *
+   * Whether files set with gtk_image_set_from_file() are decoded in
+   * a worker thread instead of blocking the main loop.
+   *
+   * The load starts when the image is mapped and is cancelled when it
+   * gets unmapped before finishing. If #GtkImage:pixel-size is set, the
+   * file is decoded at that size.
+   */
+  image_props[PROP_LOAD_ASYNC] =
+      g_param_spec_boolean ("load-async",
+                            P_("Load async"),
+                            P_("Whether to load files in a worker thread"),
+                            FALSE,
+                            GTK_PARAM_READWRITE|G_PARAM_EXPLICIT_NOTIFY);
+
   g_object_class_install_properties (gobject_class, NUM_PROPERTIES, image_props);
 
   gtk_widget_class_set_accessible_type (widget_class, GTK_TYPE_IMAGE_ACCESSIBLE);
@@ -318,6 +349,9 @@ gtk_image_set_property (GObject      *object,
       if (_gtk_icon_helper_set_use_fallback (priv->icon_helper, g_value_get_boolean (value)))
         g_object_notify_by_pspec (object, pspec);
       break;
+    case PROP_LOAD_ASYNC:
+      gtk_image_set_load_async (image, g_value_get_boolean (value));
+      break;
 
     default:
       G_OBJECT_WARN_INVALID_PROPERTY_ID (object, prop_id, pspec);
@@ -360,6 +394,9 @@ gtk_image_get_property (GObject     *object,
     case PROP_USE_FALLBACK:
       g_value_set_boolean (value, _gtk_icon_helper_get_use_fallback (priv->icon_helper));
       break;
+    case PROP_LOAD_ASYNC:
+      g_value_set_boolean (value, priv->load_async);
+      break;
     case PROP_STORAGE_TYPE:
       g_value_set_enum (value, _gtk_icon_helper_get_storage_type (priv->icon_helper));
       break;
@@ -632,6 +669,98 @@ load_scalable_with_loader (GtkImage    *image,
   return animation;
 }
 
+static void
+gtk_image_load_file_done (GObject      *source,
+                          GAsyncResult *result,
+                          gpointer      data)
+{
+  GtkImage *image = data;
+  GtkImagePrivate *priv = gtk_image_get_instance_private (image);
+  GError *error = NULL;
+  GdkTexture *texture;
+  char *filename;
+
+  texture = gdk_texture_new_from_file_finish (result, &error);
+  if (g_error_matches (error, G_IO_ERROR, G_IO_ERROR_CANCELLED))
+    {
+      g_error_free (error);
+      g_object_unref (image);
+      return;
+    }
+
+  g_clear_error (&error);
+  g_clear_object (&priv->load_cancellable);
+
+  /* Keep the filename, setting the result would clear it */
+  filename = priv->filename;
+  priv->filename = NULL;
+
+  g_object_freeze_notify (G_OBJECT (image));
+
+  if (texture == NULL)
+    {
+      gtk_image_set_from_icon_name (image, "image-missing");
+    }
+  else
+    {
+      GdkPaintable *scaler;
+
+      scaler = gtk_scaler_new (GDK_PAINTABLE (texture), priv->load_scale);
+      gtk_image_set_from_paintable (image, scaler);
+      g_object_unref (scaler);
+      g_object_unref (texture);
+    }
+
+  priv->filename = filename;
+
+  g_object_thaw_notify (G_OBJECT (image));
+  g_object_unref (image);
+}
+
+static void
+gtk_image_load_file_async (GtkImage *image)
+{
+  GtkImagePrivate *priv = gtk_image_get_instance_private (image);
+  int pixel_size, size;
+  GFile *file;
+
+  g_assert (priv->filename != NULL);
+  g_assert (priv->load_cancellable == NULL);
+
+  pixel_size = _gtk_icon_helper_get_pixel_size (priv->icon_helper);
+  if (pixel_size > 0)
+    {
+      priv->load_scale = gtk_widget_get_scale_factor (GTK_WIDGET (image));
+      size = pixel_size * priv->load_scale;
+    }
+  else
+    {
+      priv->load_scale = 1;
+      size = -1;
+    }
+
+  priv->load_cancellable = g_cancellable_new ();
+  file = g_file_new_for_path (priv->filename);
+  gdk_texture_new_from_file_async (file,
+                                   size, size,
+                                   priv->load_cancellable,
+                                   gtk_image_load_file_done,
+                                   g_object_ref (image));
+  g_object_unref (file);
+}
+
+static void
+gtk_image_cancel_load (GtkImage *image)
+{
+  GtkImagePrivate *priv = gtk_image_get_instance_private (image);
+
+  if (priv->load_cancellable == NULL)
+    return;
+
+  g_cancellable_cancel (priv->load_cancellable);
+  g_clear_object (&priv->load_cancellable);
+}
+
 /**
  * gtk_image_set_from_file:
  * @image: a #GtkImage
@@ -662,6 +791,18 @@ gtk_image_set_from_file   (GtkImage    *image,
       return;
     }
 
+  if (priv->load_async)
+    {
+      priv->filename = g_strdup (filename);
+      g_object_notify_by_pspec (G_OBJECT (image), image_props[PROP_FILE]);
+
+      if (gtk_widget_get_mapped (GTK_WIDGET (image)))
+        gtk_image_load_file_async (image);
+
+      g_object_thaw_notify (G_OBJECT (image));
+      return;
+    }
+
   anim = load_scalable_with_loader (image, filename, NULL, &scale_factor);
 
   if (anim == NULL)
@@ -1060,6 +1201,28 @@ gtk_image_unrealize (GtkWidget *widget)
   GTK_WIDGET_CLASS (gtk_image_parent_class)->unrealize (widget);
 }
 
+static void
+gtk_image_map (GtkWidget *widget)
+{
+  GtkImage *image = GTK_IMAGE (widget);
+  GtkImagePrivate *priv = gtk_image_get_instance_private (image);
+
+  GTK_WIDGET_CLASS (gtk_image_parent_class)->map (widget);
+
+  if (priv->filename != NULL &&
+      priv->load_cancellable == NULL &&
+      gtk_image_get_storage_type (image) == GTK_IMAGE_EMPTY)
+    gtk_image_load_file_async (image);
+}
+
+static void
+gtk_image_unmap (GtkWidget *widget)
+{
+  gtk_image_cancel_load (GTK_IMAGE (widget));
+
+  GTK_WIDGET_CLASS (gtk_image_parent_class)->unmap (widget);
+}
+
 static float
 gtk_image_get_baseline_align (GtkImage *image)
 {
@@ -1197,6 +1360,8 @@ gtk_image_clear (GtkImage *image)
   g_object_freeze_notify (G_OBJECT (image));
   storage_type = gtk_image_get_storage_type (image);
 
+  gtk_image_cancel_load (image);
+
   if (storage_type != GTK_IMAGE_EMPTY)
     g_object_notify_by_pspec (G_OBJECT (image), image_props[PROP_STORAGE_TYPE]);
 
@@ -1275,7 +1440,8 @@ gtk_image_style_updated (GtkWidget *widget)
 
   GTK_WIDGET_CLASS (gtk_image_parent_class)->style_updated (widget);
 
-  priv->baseline_align = 0.0;
+  if (change == NULL || gtk_css_style_change_affects (change, GTK_CSS_AFFECTS_TEXT_SIZE))
+    priv->baseline_align = 0.0;
 }
 
 /**
@@ -1371,3 +1537,48 @@ gtk_image_get_image_size (GtkImage *image,
 
   *width = *height = gtk_icon_helper_get_size (priv->icon_helper);
 }
+
+/**
+ * gtk_image_set_load_async:
+ * @image: a #GtkImage
+ * @load_async: whether to load files in a worker thread
+ *
+ * Sets whether files set with gtk_image_set_from_file() are decoded
+ * in a worker thread. See #GtkImage:load-async.
+ *
+ * This only affects files that are set after this call.
+ */
+void
+gtk_image_set_load_async (GtkImage *image,
+                          gboolean  load_async)
+{
+  GtkImagePrivate *priv = gtk_image_get_instance_private (image);
+
+  g_return_if_fail (GTK_IS_IMAGE (image));
+
+  load_async = !!load_async;
+  if (priv->load_async == load_async)
+    return;
+
+  priv->load_async = load_async;
+  g_object_notify_by_pspec (G_OBJECT (image), image_props[PROP_LOAD_ASYNC]);
+}
+
+/**
+ * gtk_image_get_load_async:
+ * @image: a #GtkImage
+ *
+ * Returns whether files are loaded in a worker thread.
+ * See gtk_image_set_load_async().
+ *
+ * Returns: %TRUE if files are loaded asynchronously
+ */
+gboolean
+gtk_image_get_load_async (GtkImage *image)
+{
+  GtkImagePrivate *priv = gtk_image_get_instance_private (image);
+
+  g_return_val_if_fail (GTK_IS_IMAGE (image), FALSE);
+
+  return priv->load_async;
+}
@@ -155,6 +155,12 @@ gint       gtk_image_get_pixel_size (GtkImage             *image);
 GDK_AVAILABLE_IN_ALL
 GtkIconSize gtk_image_get_icon_size (GtkImage             *image);
 
+GDK_AVAILABLE_IN_ALL
+void       gtk_image_set_load_async (GtkImage             *image,
+                                     gboolean              load_async);
+GDK_AVAILABLE_IN_ALL
+gboolean   gtk_image_get_load_async (GtkImage             *image);
+
 G_END_DECLS
 
 #endif /* __GTK_IMAGE_H__ */
@@ -250,9 +250,12 @@
  * the #GtkLabel::activate-link signal and the gtk_label_get_current_uri() function.
  */
 
+typedef struct _GtkLabelSizeCache GtkLabelSizeCache;
+
 struct _GtkLabelPrivate
 {
   GtkLabelSelectionInfo *select_info;
+  GtkLabelSizeCache *size_cache;
   GtkWidget *mnemonic_widget;
   GtkWindow *mnemonic_window;
 
@@ -277,14 +280,47 @@ struct _GtkLabelPrivate
   guint    in_click           : 1;
   guint    pattern_set        : 1;
   guint    track_links        : 1;
+  guint    layout_shared      : 1;
 
   guint    mnemonic_keyval;
+  guint    layout_context_serial;
 
   gint     width_chars;
   gint     max_width_chars;
   gint     lines;
 };
 
+/* Sizes measured with the current layout, so that measuring again, e.g.
+ * after gtk_widget_queue_resize() on a parent, doesn't need Pango to
+ * shape the text again. The preferred sizes are shared by both
+ * orientations. Heights for widths are kept for a few ranges of widths
+ * that lay out the text the same way.
+ */
+#define N_CACHED_HEIGHTS 4
+
+typedef struct
+{
+  /* In Pango units, inclusive */
+  int min_width;
+  int max_width;
+
+  int height;
+  int baseline;
+} GtkLabelCachedHeight;
+
+struct _GtkLabelSizeCache
+{
+  PangoRectangle smallest;
+  PangoRectangle widest;
+  int smallest_baseline;
+  int widest_baseline;
+  guint have_preferred_size : 1;
+
+  GtkLabelCachedHeight heights[N_CACHED_HEIGHTS];
+  guint n_heights;
+  guint next_height;
+};
+
 /* Notes about the handling of links:
  *
  * Links share the GtkLabelSelectionInfo struct with selectable labels.
@@ -463,6 +499,7 @@ static void gtk_label_ensure_select_info  (GtkLabel *label);
 static void gtk_label_clear_select_info   (GtkLabel *label);
 static void gtk_label_update_cursor       (GtkLabel *label);
 static void gtk_label_clear_layout        (GtkLabel *label);
+static void gtk_label_clear_size_cache    (GtkLabel *label);
 static void gtk_label_ensure_layout       (GtkLabel *label);
 static void gtk_label_select_region_index (GtkLabel *label,
                                            gint      anchor_index,
@@ -2485,6 +2522,14 @@ parse_uri_markup (GtkLabel     *label,
   gsize length;
   UriParserData pdata;
 
+  /* Without links there is nothing to do here */
+  if (strstr (str, "<a") == NULL)
+    {
+      *new_str = g_strdup (str);
+      *links = NULL;
+      return TRUE;
+    }
+
   length = strlen (str);
   p = str;
   end = str + length;
@@ -2612,13 +2657,12 @@ gtk_label_set_markup_internal (GtkLabel    *label,
     }
 
   /* Extract the text to display */
-  if (!pango_parse_markup (str_for_display,
-                           -1,
-                           with_uline ? '_' : 0,
-                           &attrs,
-                           &text,
-                           NULL,
-                           &error))
+  if (!_gtk_pango_parse_markup (str_for_display,
+                                with_uline ? '_' : 0,
+                                &attrs,
+                                &text,
+                                NULL,
+                                &error))
     {
       g_warning ("Failed to set text '%s' from markup due to error parsing markup: %s",
                  str_for_display, error->message);
@@ -2629,13 +2673,12 @@ gtk_label_set_markup_internal (GtkLabel    *label,
     }
 
   /* Extract the accelerator character */
-  if (with_uline && !pango_parse_markup (str_for_accel,
-					 -1,
-					 '_',
-					 NULL,
-					 NULL,
-					 &accel_char,
-					 &error))
+  if (with_uline && !_gtk_pango_parse_markup (str_for_accel,
+                                              '_',
+                                              NULL,
+                                              NULL,
+                                              &accel_char,
+                                              &error))
     {
       g_warning ("Failed to set text from markup due to error parsing markup: %s",
                  error->message);
@@ -2987,6 +3030,7 @@ gtk_label_set_width_chars (GtkLabel *label,
   if (priv->width_chars != n_chars)
     {
       priv->width_chars = n_chars;
+      gtk_label_clear_size_cache (label);
       g_object_notify_by_pspec (G_OBJECT (label), label_props[PROP_WIDTH_CHARS]);
       gtk_widget_queue_resize (GTK_WIDGET (label));
     }
@@ -3029,6 +3073,7 @@ gtk_label_set_max_width_chars (GtkLabel *label,
   if (priv->max_width_chars != n_chars)
     {
       priv->max_width_chars = n_chars;
+      gtk_label_clear_size_cache (label);
 
       g_object_notify_by_pspec (G_OBJECT (label), label_props[PROP_MAX_WIDTH_CHARS]);
       gtk_widget_queue_resize (GTK_WIDGET (label));
@@ -3128,6 +3173,7 @@ gtk_label_set_line_wrap_mode (GtkLabel *label,
   if (priv->wrap_mode != wrap_mode)
     {
       priv->wrap_mode = wrap_mode;
+      gtk_label_clear_layout (label);
       g_object_notify_by_pspec (G_OBJECT (label), label_props[PROP_WRAP_MODE]);
 
       gtk_widget_queue_resize (GTK_WIDGET (label));
@@ -3182,16 +3228,37 @@ gtk_label_finalize (GObject *object)
 
   gtk_label_clear_links (label);
   g_free (priv->select_info);
+  g_free (priv->size_cache);
 
   G_OBJECT_CLASS (gtk_label_parent_class)->finalize (object);
 }
 
+static void
+gtk_label_clear_size_cache (GtkLabel *label)
+{
+  GtkLabelPrivate *priv = gtk_label_get_instance_private (label);
+
+  g_clear_pointer (&priv->size_cache, g_free);
+}
+
 static void
 gtk_label_clear_layout (GtkLabel *label)
 {
   GtkLabelPrivate *priv = gtk_label_get_instance_private (label);
 
   g_clear_object (&priv->layout);
+  gtk_label_clear_size_cache (label);
+}
+
+static GtkLabelSizeCache *
+gtk_label_get_size_cache (GtkLabel *label)
+{
+  GtkLabelPrivate *priv = gtk_label_get_instance_private (label);
+
+  if (priv->size_cache == NULL)
+    priv->size_cache = g_new0 (GtkLabelSizeCache, 1);
+
+  return priv->size_cache;
 }
 
 /**
@@ -3239,7 +3306,7 @@ gtk_label_get_measuring_layout (GtkLabel *   label,
    * because we don't need it to be properly setup at that point.
    * This way we can make use of caching upon the label's creation.
    */
-  if (gtk_widget_get_width (GTK_WIDGET (label)) <= 1)
+  if (gtk_widget_get_width (GTK_WIDGET (label)) <= 1 && !priv->layout_shared)
     {
       g_object_ref (priv->layout);
       pango_layout_set_width (priv->layout, width);
@@ -3265,8 +3332,8 @@ gtk_label_get_measuring_layout (GtkLabel *   label,
   return copy;
 }
 
-static void
-gtk_label_update_layout_attributes (GtkLabel *label)
+static PangoAttrList *
+gtk_label_compute_layout_attributes (GtkLabel *label)
 {
   GtkLabelPrivate *priv = gtk_label_get_instance_private (label);
   GtkWidget *widget = GTK_WIDGET (label);
@@ -3274,9 +3341,6 @@ gtk_label_update_layout_attributes (GtkLabel *label)
   PangoAttrList *attrs;
   PangoAttrList *style_attrs;
 
-  if (priv->layout == NULL)
-    return;
-
   context = gtk_widget_get_style_context (widget);
 
   if (priv->select_info && priv->select_info->links)
@@ -3319,29 +3383,62 @@ gtk_label_update_layout_attributes (GtkLabel *label)
   attrs = _gtk_pango_attr_list_merge (attrs, priv->markup_attrs);
   attrs = _gtk_pango_attr_list_merge (attrs, priv->attrs);
 
+  if (style_attrs)
+    pango_attr_list_unref (style_attrs);
+
+  return attrs;
+}
+
+static void
+gtk_label_update_layout_attributes (GtkLabel *label)
+{
+  GtkLabelPrivate *priv = gtk_label_get_instance_private (label);
+  PangoAttrList *attrs;
+
+  if (priv->layout == NULL)
+    return;
+
+  /* A shared layout can't take attributes; let
+   * gtk_label_ensure_layout() decide again.
+   */
+  if (priv->layout_shared)
+    {
+      gtk_label_clear_layout (label);
+      return;
+    }
+
+  attrs = gtk_label_compute_layout_attributes (label);
   pango_layout_set_attributes (priv->layout, attrs);
+  gtk_label_clear_size_cache (label);
 
   if (attrs)
     pango_attr_list_unref (attrs);
-  if (style_attrs)
-    pango_attr_list_unref (style_attrs);
 }
 
 static void
 gtk_label_ensure_layout (GtkLabel *label)
 {
   GtkLabelPrivate *priv = gtk_label_get_instance_private (label);
+  PangoContext *context;
+  PangoAttrList *attrs;
   PangoAlignment align;
   gboolean rtl;
 
+  context = gtk_widget_get_pango_context (GTK_WIDGET (label));
+
   if (priv->layout)
-    return;
+    {
+      /* Shared layouts don't follow changes to the widget's context */
+      if (!priv->layout_shared ||
+          priv->layout_context_serial == pango_context_get_serial (context))
+        return;
+
+      gtk_label_clear_layout (label);
+    }
 
   align = PANGO_ALIGN_LEFT; /* Quiet gcc */
   rtl = _gtk_widget_get_direction (GTK_WIDGET (label)) == GTK_TEXT_DIR_RTL;
-  priv->layout = gtk_widget_create_pango_layout (GTK_WIDGET (label), priv->text);
-
-  gtk_label_update_layout_attributes (label);
+  attrs = gtk_label_compute_layout_attributes (label);
 
   switch (priv->jtype)
     {
@@ -3356,12 +3453,40 @@ gtk_label_ensure_layout (GtkLabel *label)
       break;
     case GTK_JUSTIFY_FILL:
       align = rtl ? PANGO_ALIGN_RIGHT : PANGO_ALIGN_LEFT;
-      pango_layout_set_justify (priv->layout, TRUE);
       break;
     default:
       g_assert_not_reached();
     }
 
+  /* Plain text that is never wrapped or ellipsized lays out the
+   * same in every label using the same font, so share it.
+   */
+  if (attrs == NULL &&
+      priv->jtype != GTK_JUSTIFY_FILL &&
+      !priv->ellipsize && !priv->wrap && priv->lines <= 0)
+    {
+      priv->layout = _gtk_pango_get_shared_layout (context, priv->text, align,
+                                                   priv->single_line_mode);
+      if (priv->layout)
+        {
+          priv->layout_shared = TRUE;
+          priv->layout_context_serial = pango_context_get_serial (context);
+          return;
+        }
+    }
+
+  priv->layout_shared = FALSE;
+  priv->layout = gtk_widget_create_pango_layout (GTK_WIDGET (label), priv->text);
+
+  if (attrs)
+    {
+      pango_layout_set_attributes (priv->layout, attrs);
+      pango_attr_list_unref (attrs);
+    }
+
+  if (priv->jtype == GTK_JUSTIFY_FILL)
+    pango_layout_set_justify (priv->layout, TRUE);
+
   pango_layout_set_alignment (priv->layout, align);
   pango_layout_set_ellipsize (priv->layout, priv->ellipsize);
   pango_layout_set_wrap (priv->layout, priv->wrap_mode);
@@ -3394,21 +3519,70 @@ get_height_for_width (GtkLabel *label,
                       gint     *minimum_baseline,
                       gint     *natural_baseline)
 {
+  GtkLabelPrivate *priv = gtk_label_get_instance_private (label);
+  GtkLabelSizeCache *cache;
+  GtkLabelCachedHeight *cached;
   PangoLayout *layout;
+  PangoRectangle logical;
   gint text_height, baseline;
+  guint i;
+
+  width *= PANGO_SCALE;
 
-  layout = gtk_label_get_measuring_layout (label, NULL, width * PANGO_SCALE);
+  cache = priv->size_cache;
+  for (i = 0; cache && i < cache->n_heights; i++)
+    {
+      cached = &cache->heights[i];
+
+      if (cached->min_width <= width && width <= cached->max_width)
+        {
+          text_height = cached->height;
+          baseline = cached->baseline;
+          goto out;
+        }
+    }
+
+  layout = gtk_label_get_measuring_layout (label, NULL, width);
 
   pango_layout_get_pixel_size (layout, NULL, &text_height);
+  baseline = pango_layout_get_baseline (layout) / PANGO_SCALE;
+
+  /* Measuring may have created the layout, and with it a new cache */
+  cache = gtk_label_get_size_cache (label);
+  if (cache->n_heights < N_CACHED_HEIGHTS)
+    cached = &cache->heights[cache->n_heights++];
+  else
+    {
+      cached = &cache->heights[cache->next_height];
+      cache->next_height = (cache->next_height + 1) % N_CACHED_HEIGHTS;
+    }
+
+  /* Narrowing the width down to the widest line doesn't break any line
+   * differently, and if no line was broken, widening doesn't either.
+   * Ellipsizing depends on the exact width.
+   */
+
+  if (pango_layout_is_ellipsized (layout))
+    {
+      cached->min_width = width;
+      cached->max_width = width;
+    }
+  else
+    {
+      pango_layout_get_extents (layout, NULL, &logical);
+      cached->min_width = MIN (logical.width, width);
+      cached->max_width = pango_layout_is_wrapped (layout) ? width : G_MAXINT;
+    }
+  cached->height = text_height;
+  cached->baseline = baseline;
 
+  g_object_unref (layout);
+
+out:
   *minimum_height = text_height;
   *natural_height = text_height;
-
-  baseline = pango_layout_get_baseline (layout) / PANGO_SCALE;
   *minimum_baseline = baseline;
   *natural_baseline = baseline;
-
-  g_object_unref (layout);
 }
 
 static gint
@@ -3430,14 +3604,21 @@ get_char_pixels (GtkWidget   *label,
   return MAX (char_width, digit_width);;
 }
 
+typedef PangoLayout * (* GtkLabelLayoutFunc) (gpointer     data,
+                                               PangoLayout *existing_layout,
+                                               int          width);
+
 static void
-gtk_label_get_preferred_layout_size (GtkLabel *label,
-                                     PangoRectangle *smallest,
-                                     PangoRectangle *widest,
-                                     int *smallest_baseline,
-                                     int *widest_baseline)
+gtk_label_compute_preferred_layout_size (GtkLabelLayoutFunc get_layout,
+                                         gpointer           data,
+                                         gboolean           ellipsize_or_wrap,
+                                         int                width_chars,
+                                         int                max_width_chars,
+                                         PangoRectangle    *smallest,
+                                         PangoRectangle    *widest,
+                                         int               *smallest_baseline,
+                                         int               *widest_baseline)
 {
-  GtkLabelPrivate *priv = gtk_label_get_instance_private (label);
   PangoLayout *layout;
   gint char_pixels;
 
@@ -3458,39 +3639,39 @@ gtk_label_get_preferred_layout_size (GtkLabel *label,
    */
 
   /* Start off with the pixel extents of an as-wide-as-possible layout */
-  layout = gtk_label_get_measuring_layout (label, NULL, -1);
+  layout = get_layout (data, NULL, -1);
 
-  if (priv->width_chars > -1 || priv->max_width_chars > -1)
-    char_pixels = get_char_pixels (GTK_WIDGET (label), layout);
+  if (width_chars > -1 || max_width_chars > -1)
+    char_pixels = get_char_pixels (NULL, layout);
   else
     char_pixels = 0;
 
   pango_layout_get_extents (layout, NULL, widest);
-  widest->width = MAX (widest->width, char_pixels * priv->width_chars);
+  widest->width = MAX (widest->width, char_pixels * width_chars);
   widest->x = widest->y = 0;
   *widest_baseline = pango_layout_get_baseline (layout) / PANGO_SCALE;
 
-  if (priv->ellipsize || priv->wrap)
+  if (ellipsize_or_wrap)
     {
       /* a layout with width 0 will be as small as humanly possible */
-      layout = gtk_label_get_measuring_layout (label,
-                                               layout,
-                                               priv->width_chars > -1 ? char_pixels * priv->width_chars
-                                                                      : 0);
+      layout = get_layout (data,
+                           layout,
+                           width_chars > -1 ? char_pixels * width_chars
+                                            : 0);
 
       pango_layout_get_extents (layout, NULL, smallest);
-      smallest->width = MAX (smallest->width, char_pixels * priv->width_chars);
+      smallest->width = MAX (smallest->width, char_pixels * width_chars);
       smallest->x = smallest->y = 0;
 
       *smallest_baseline = pango_layout_get_baseline (layout) / PANGO_SCALE;
 
-      if (priv->max_width_chars > -1 && widest->width > char_pixels * priv->max_width_chars)
+      if (max_width_chars > -1 && widest->width > char_pixels * max_width_chars)
         {
-          layout = gtk_label_get_measuring_layout (label,
-                                                   layout,
-                                                   MAX (smallest->width, char_pixels * priv->max_width_chars));
+          layout = get_layout (data,
+                               layout,
+                               MAX (smallest->width, char_pixels * max_width_chars));
           pango_layout_get_extents (layout, NULL, widest);
-          widest->width = MAX (widest->width, char_pixels * priv->width_chars);
+          widest->width = MAX (widest->width, char_pixels * width_chars);
           widest->x = widest->y = 0;
 
           *widest_baseline = pango_layout_get_baseline (layout) / PANGO_SCALE;
@@ -3511,6 +3692,301 @@ gtk_label_get_preferred_layout_size (GtkLabel *label,
   g_object_unref (layout);
 }
 
+static void
+gtk_label_get_preferred_layout_size (GtkLabel *label,
+                                     PangoRectangle *smallest,
+                                     PangoRectangle *widest,
+                                     int *smallest_baseline,
+                                     int *widest_baseline)
+{
+  GtkLabelPrivate *priv = gtk_label_get_instance_private (label);
+  GtkLabelSizeCache *cache;
+
+  cache = priv->size_cache;
+  if (cache && cache->have_preferred_size)
+    {
+      *smallest = cache->smallest;
+      *widest = cache->widest;
+      *smallest_baseline = cache->smallest_baseline;
+      *widest_baseline = cache->widest_baseline;
+      return;
+    }
+
+  gtk_label_compute_preferred_layout_size ((GtkLabelLayoutFunc) gtk_label_get_measuring_layout,
+                                           label,
+                                           priv->ellipsize || priv->wrap,
+                                           priv->width_chars,
+                                           priv->max_width_chars,
+                                           smallest, widest,
+                                           smallest_baseline, widest_baseline);
+
+  /* Measuring may have created the layout, and with it a new cache */
+  cache = gtk_label_get_size_cache (label);
+  cache->smallest = *smallest;
+  cache->widest = *widest;
+  cache->smallest_baseline = *smallest_baseline;
+  cache->widest_baseline = *widest_baseline;
+  cache->have_preferred_size = TRUE;
+}
+
+/* Parallel measuring
+ *
+ * Pango contexts and font maps must not be shared between threads,
+ * so every worker thread uses its own default font map and a context
+ * with the same settings as the label's. Only the preferred size is
+ * computed there; the label still shapes its own layout when it is
+ * drawn.
+ */
+typedef struct {
+  GMutex lock;
+  GCond cond;
+  guint n_pending;
+} GtkLabelPremeasureBatch;
+
+typedef struct {
+  GtkLabel *label;
+  GtkLabelPremeasureBatch *batch;
+
+  /* Copied from the label's layout and context */
+  char *text;
+  PangoAttrList *attrs;
+  PangoAlignment alignment;
+  gboolean justify;
+  PangoEllipsizeMode ellipsize;
+  PangoWrapMode wrap_mode;
+  gboolean single_paragraph;
+  int height;
+  PangoFontDescription *font_desc;
+  PangoLanguage *language;
+  PangoDirection base_dir;
+  PangoGravity base_gravity;
+  PangoGravityHint gravity_hint;
+  PangoMatrix matrix;
+  gboolean has_matrix;
+  double resolution;
+  cairo_font_options_t *font_options;
+  gboolean ellipsize_or_wrap;
+  int width_chars;
+  int max_width_chars;
+
+  PangoLayout *layout;
+
+  /* Results */
+  PangoRectangle smallest;
+  PangoRectangle widest;
+  int smallest_baseline;
+  int widest_baseline;
+} GtkLabelPremeasure;
+
+static GThreadPool *premeasure_pool;
+
+static PangoLayout *
+gtk_label_premeasure_get_layout (gpointer     data,
+                                 PangoLayout *existing_layout,
+                                 int          width)
+{
+  GtkLabelPremeasure *job = data;
+
+  pango_layout_set_width (job->layout, width);
+
+  if (existing_layout == NULL)
+    g_object_ref (job->layout);
+
+  return job->layout;
+}
+
+static void
+gtk_label_premeasure_run (GtkLabelPremeasure *job)
+{
+  PangoContext *context;
+
+  context = pango_font_map_create_context (pango_cairo_font_map_get_default ());
+  pango_context_set_font_description (context, job->font_desc);
+  pango_context_set_language (context, job->language);
+  pango_context_set_base_dir (context, job->base_dir);
+  pango_context_set_base_gravity (context, job->base_gravity);
+  pango_context_set_gravity_hint (context, job->gravity_hint);
+  pango_context_set_matrix (context, job->has_matrix ? &job->matrix : NULL);
+  pango_cairo_context_set_resolution (context, job->resolution);
+  pango_cairo_context_set_font_options (context, job->font_options);
+
+  job->layout = pango_layout_new (context);
+  pango_layout_set_text (job->layout, job->text, -1);
+  pango_layout_set_attributes (job->layout, job->attrs);
+  pango_layout_set_alignment (job->layout, job->alignment);
+  pango_layout_set_justify (job->layout, job->justify);
+  pango_layout_set_ellipsize (job->layout, job->ellipsize);
+  pango_layout_set_wrap (job->layout, job->wrap_mode);
+  pango_layout_set_single_paragraph_mode (job->layout, job->single_paragraph);
+  pango_layout_set_height (job->layout, job->height);
+
+  gtk_label_compute_preferred_layout_size (gtk_label_premeasure_get_layout,
+                                           job,
+                                           job->ellipsize_or_wrap,
+                                           job->width_chars,
+                                           job->max_width_chars,
+                                           &job->smallest, &job->widest,
+                                           &job->smallest_baseline, &job->widest_baseline);
+
+  g_clear_object (&job->layout);
+  g_object_unref (context);
+}
+
+static void
+gtk_label_premeasure_thread (gpointer data,
+                             gpointer user_data)
+{
+  GtkLabelPremeasure *job = data;
+  GtkLabelPremeasureBatch *batch = job->batch;
+
+  gtk_label_premeasure_run (job);
+
+  g_mutex_lock (&batch->lock);
+  if (--batch->n_pending == 0)
+    g_cond_signal (&batch->cond);
+  g_mutex_unlock (&batch->lock);
+}
+
+static GtkLabelPremeasure *
+gtk_label_premeasure_new (GtkLabel *label)
+{
+  GtkLabelPrivate *priv = gtk_label_get_instance_private (label);
+  GtkLabelPremeasure *job;
+  PangoContext *context;
+  PangoAttrList *attrs;
+  const PangoMatrix *matrix;
+  const cairo_font_options_t *font_options;
+
+  if (priv->size_cache && priv->size_cache->have_preferred_size)
+    return NULL;
+
+  gtk_label_ensure_layout (label);
+
+  context = pango_layout_get_context (priv->layout);
+
+  /* Other font maps may not have per-thread instances */
+  if (pango_context_get_font_map (context) != pango_cairo_font_map_get_default ())
+    return NULL;
+
+  job = g_slice_new0 (GtkLabelPremeasure);
+  job->label = g_object_ref (label);
+
+  job->text = g_strdup (pango_layout_get_text (priv->layout));
+  attrs = pango_layout_get_attributes (priv->layout);
+  job->attrs = attrs ? pango_attr_list_copy (attrs) : NULL;
+  job->alignment = pango_layout_get_alignment (priv->layout);
+  job->justify = pango_layout_get_justify (priv->layout);
+  job->ellipsize = pango_layout_get_ellipsize (priv->layout);
+  job->wrap_mode = pango_layout_get_wrap (priv->layout);
+  job->single_paragraph = pango_layout_get_single_paragraph_mode (priv->layout);
+  job->height = pango_layout_get_height (priv->layout);
+
+  job->font_desc = pango_font_description_copy (pango_context_get_font_description (context));
+  job->language = pango_context_get_language (context);
+  job->base_dir = pango_context_get_base_dir (context);
+  job->base_gravity = pango_context_get_base_gravity (context);
+  job->gravity_hint = pango_context_get_gravity_hint (context);
+  matrix = pango_context_get_matrix (context);
+  if (matrix)
+    {
+      job->matrix = *matrix;
+      job->has_matrix = TRUE;
+    }
+  job->resolution = pango_cairo_context_get_resolution (context);
+  font_options = pango_cairo_context_get_font_options (context);
+  job->font_options = font_options ? cairo_font_options_copy (font_options) : NULL;
+
+  job->ellipsize_or_wrap = priv->ellipsize || priv->wrap;
+  job->width_chars = priv->width_chars;
+  job->max_width_chars = priv->max_width_chars;
+
+  return job;
+}
+
+static void
+gtk_label_premeasure_finish (GtkLabelPremeasure *job)
+{
+  GtkLabelSizeCache *cache;
+
+  cache = gtk_label_get_size_cache (job->label);
+  cache->smallest = job->smallest;
+  cache->widest = job->widest;
+  cache->smallest_baseline = job->smallest_baseline;
+  cache->widest_baseline = job->widest_baseline;
+  cache->have_preferred_size = TRUE;
+
+  g_object_unref (job->label);
+  g_free (job->text);
+  if (job->attrs)
+    pango_attr_list_unref (job->attrs);
+  pango_font_description_free (job->font_desc);
+  if (job->font_options)
+    cairo_font_options_destroy (job->font_options);
+  g_slice_free (GtkLabelPremeasure, job);
+}
+
+/*
+ * _gtk_label_premeasure:
+ * @labels: (element-type GtkLabel): labels that are about to be measured
+ *
+ * Computes the preferred sizes of @labels on a pool of worker
+ * threads and stores them in the labels' size caches, so the
+ * following gtk_widget_measure() calls don't need to shape text.
+ * Labels that already know their size are skipped.
+ */
+void
+_gtk_label_premeasure (GPtrArray *labels)
+{
+  GtkLabelPremeasureBatch batch;
+  GPtrArray *jobs;
+  guint i;
+
+  jobs = g_ptr_array_sized_new (labels->len);
+  for (i = 0; i < labels->len; i++)
+    {
+      GtkLabelPremeasure *job = gtk_label_premeasure_new (g_ptr_array_index (labels, i));
+
+      if (job)
+        g_ptr_array_add (jobs, job);
+    }
+
+  if (jobs->len == 0)
+    {
+      g_ptr_array_unref (jobs);
+      return;
+    }
+
+  g_mutex_init (&batch.lock);
+  g_cond_init (&batch.cond);
+  batch.n_pending = jobs->len;
+
+  if (premeasure_pool == NULL)
+    premeasure_pool = g_thread_pool_new (gtk_label_premeasure_thread, NULL,
+                                         g_get_num_processors (), FALSE, NULL);
+
+  g_mutex_lock (&batch.lock);
+
+  for (i = 0; i < jobs->len; i++)
+    {
+      GtkLabelPremeasure *job = g_ptr_array_index (jobs, i);
+
+      job->batch = &batch;
+      g_thread_pool_push (premeasure_pool, job, NULL);
+    }
+
+  while (batch.n_pending > 0)
+    g_cond_wait (&batch.cond, &batch.lock);
+
+  g_mutex_unlock (&batch.lock);
+
+  for (i = 0; i < jobs->len; i++)
+    gtk_label_premeasure_finish (g_ptr_array_index (jobs, i));
+
+  g_ptr_array_unref (jobs);
+  g_mutex_clear (&batch.lock);
+  g_cond_clear (&batch.cond);
+}
+
 static void
 gtk_label_get_preferred_size (GtkWidget      *widget,
                               GtkOrientation  orientation,
@@ -3573,11 +4049,7 @@ gtk_label_measure (GtkWidget      *widget,
   GtkLabelPrivate *priv = gtk_label_get_instance_private (label);
 
   if (orientation == GTK_ORIENTATION_VERTICAL && for_size != -1 && priv->wrap)
-    {
-      gtk_label_clear_layout (label);
-
-      get_height_for_width (label, for_size, minimum, natural, minimum_baseline, natural_baseline);
-    }
+    get_height_for_width (label, for_size, minimum, natural, minimum_baseline, natural_baseline);
   else
     gtk_label_get_preferred_size (widget, orientation, minimum, natural, minimum_baseline, natural_baseline);
 }
@@ -3649,6 +4121,37 @@ get_layout_location (GtkLabel  *label,
     *yp = y;
 }
 
+/* Whether setting @width on @layout would leave its text laid out the
+ * same way, so that resizing doesn't need to shape it again. This is
+ * what happens to most ellipsizing labels while a window is resized,
+ * as long as their text fits.
+ */
+static gboolean
+layout_width_is_equivalent (PangoLayout *layout,
+                            int          width)
+{
+  PangoLayoutLine *line;
+  PangoRectangle logical;
+
+  if (pango_layout_get_width (layout) == width)
+    return TRUE;
+
+  if (pango_layout_is_ellipsized (layout) ||
+      pango_layout_get_line_count (layout) != 1)
+    return FALSE;
+
+  /* Otherwise the position of the line depends on the width */
+  line = pango_layout_get_line_readonly (layout, 0);
+  if (pango_layout_get_alignment (layout) != PANGO_ALIGN_LEFT ||
+      pango_layout_get_justify (layout) ||
+      line->resolved_dir != PANGO_DIRECTION_LTR)
+    return FALSE;
+
+  pango_layout_get_extents (layout, NULL, &logical);
+
+  return width == -1 || logical.width <= width;
+}
+
 static void
 gtk_label_size_allocate (GtkWidget *widget,
                          int        width,
@@ -3661,8 +4164,11 @@ gtk_label_size_allocate (GtkWidget *widget,
   if (priv->layout)
     {
       if (priv->ellipsize || priv->wrap)
-        pango_layout_set_width (priv->layout, width * PANGO_SCALE);
-      else
+        {
+          if (!layout_width_is_equivalent (priv->layout, width * PANGO_SCALE))
+            pango_layout_set_width (priv->layout, width * PANGO_SCALE);
+        }
+      else if (!priv->layout_shared)
         pango_layout_set_width (priv->layout, -1);
     }
 }
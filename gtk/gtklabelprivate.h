@@ -44,6 +44,8 @@ gboolean     _gtk_label_get_link_visited (GtkLabel *label,
                                           gint      idx);
 gboolean     _gtk_label_get_link_focused (GtkLabel *label,
                                           gint      idx);
+
+void         _gtk_label_premeasure      (GPtrArray *labels);
                              
 G_END_DECLS
 
@@ -0,0 +1,321 @@
+/* GTK - The GIMP Toolkit
+ * Copyright (C) 2018 Red Hat, Inc.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "config.h"
+
+#include "gtklayoutitemprivate.h"
+
+#include "gtksnapshot.h"
+#include "gtkstylecontext.h"
+#include "gtkwidget.h"
+
+/**
+ * SECTION:gtklayoutitem
+ * @Short_description: Lightweight content for layout containers
+ * @Title: GtkLayoutItem
+ * @See_also: #GtkGrid
+ *
+ * A GtkLayoutItem is a piece of static content that can be placed
+ * in a container like a widget, without the cost of being one.
+ *
+ * Layout items have no signals, no event controllers, no accessibility
+ * object and no CSS node of their own. All items in a container that
+ * share a style class share a single CSS node, which is used for their
+ * margin, border, padding, background and frame. Everything else is
+ * done by the measure and snapshot functions passed to
+ * gtk_layout_item_new().
+ *
+ * This makes layout items suitable for displaying large amounts of
+ * non-interactive content, such as the cells of a big table of
+ * numbers, where creating one widget per cell would dominate the
+ * time spent on style, measuring and allocating.
+ *
+ * Layout items are added to a container with gtk_grid_attach_item().
+ * When the content changes, call gtk_layout_item_queue_resize() or
+ * gtk_layout_item_queue_draw() to have the container update.
+ */
+
+G_DEFINE_BOXED_TYPE (GtkLayoutItem, gtk_layout_item,
+                     gtk_layout_item_ref,
+                     gtk_layout_item_unref)
+
+/**
+ * gtk_layout_item_new:
+ * @measure_func: function to measure the content of the item
+ * @snapshot_func: function to draw the content of the item
+ * @user_data: (closure): data to pass to @measure_func and @snapshot_func
+ * @destroy: (nullable): function to free @user_data when the item
+ *     is freed
+ *
+ * Creates a new layout item.
+ *
+ * Returns: (transfer full): a new #GtkLayoutItem
+ */
+GtkLayoutItem *
+gtk_layout_item_new (GtkLayoutItemMeasureFunc  measure_func,
+                     GtkLayoutItemSnapshotFunc snapshot_func,
+                     gpointer                  user_data,
+                     GDestroyNotify            destroy)
+{
+  GtkLayoutItem *item;
+
+  g_return_val_if_fail (measure_func != NULL, NULL);
+  g_return_val_if_fail (snapshot_func != NULL, NULL);
+
+  item = g_slice_new0 (GtkLayoutItem);
+
+  item->ref_count = 1;
+  item->measure_func = measure_func;
+  item->snapshot_func = snapshot_func;
+  item->user_data = user_data;
+  item->destroy = destroy;
+
+  return item;
+}
+
+/**
+ * gtk_layout_item_ref:
+ * @item: a #GtkLayoutItem
+ *
+ * Increments the reference count on @item.
+ *
+ * Returns: @item itself.
+ */
+GtkLayoutItem *
+gtk_layout_item_ref (GtkLayoutItem *item)
+{
+  g_return_val_if_fail (item != NULL, NULL);
+
+  item->ref_count += 1;
+
+  return item;
+}
+
+/**
+ * gtk_layout_item_unref:
+ * @item: a #GtkLayoutItem
+ *
+ * Decrements the reference count on @item, freeing the
+ * item if the reference count reaches 0.
+ */
+void
+gtk_layout_item_unref (GtkLayoutItem *item)
+{
+  g_return_if_fail (item != NULL);
+
+  item->ref_count -= 1;
+  if (item->ref_count > 0)
+    return;
+
+  g_warn_if_fail (item->host == NULL);
+
+  if (item->destroy)
+    item->destroy (item->user_data);
+
+  g_slice_free (GtkLayoutItem, item);
+}
+
+/**
+ * gtk_layout_item_set_style_class:
+ * @item: a #GtkLayoutItem
+ * @style_class: (nullable): the style class to use
+ *
+ * Sets the style class of @item. The container gives all items
+ * with the same style class a shared CSS node with name item
+ * and this style class, so it can be used to select the items
+ * from CSS.
+ */
+void
+gtk_layout_item_set_style_class (GtkLayoutItem *item,
+                                 const char    *style_class)
+{
+  GQuark style_quark;
+
+  g_return_if_fail (item != NULL);
+
+  style_quark = style_class ? g_quark_from_string (style_class) : 0;
+  if (item->style_class == style_quark)
+    return;
+
+  item->style_class = style_quark;
+
+  gtk_layout_item_queue_resize (item);
+}
+
+/**
+ * gtk_layout_item_get_style_class:
+ * @item: a #GtkLayoutItem
+ *
+ * Gets the style class set with gtk_layout_item_set_style_class().
+ *
+ * Returns: (nullable): the style class of @item
+ */
+const char *
+gtk_layout_item_get_style_class (GtkLayoutItem *item)
+{
+  g_return_val_if_fail (item != NULL, NULL);
+
+  return g_quark_to_string (item->style_class);
+}
+
+/**
+ * gtk_layout_item_get_host:
+ * @item: a #GtkLayoutItem
+ *
+ * Gets the container that @item has been added to.
+ *
+ * Returns: (nullable) (transfer none): the container of @item
+ */
+GtkWidget *
+gtk_layout_item_get_host (GtkLayoutItem *item)
+{
+  g_return_val_if_fail (item != NULL, NULL);
+
+  return item->host;
+}
+
+/**
+ * gtk_layout_item_queue_resize:
+ * @item: a #GtkLayoutItem
+ *
+ * Tells the container of @item that the size of its content
+ * has changed.
+ */
+void
+gtk_layout_item_queue_resize (GtkLayoutItem *item)
+{
+  g_return_if_fail (item != NULL);
+
+  if (item->host)
+    gtk_widget_queue_resize (item->host);
+}
+
+/**
+ * gtk_layout_item_queue_draw:
+ * @item: a #GtkLayoutItem
+ *
+ * Tells the container of @item that its content needs
+ * to be redrawn.
+ */
+void
+gtk_layout_item_queue_draw (GtkLayoutItem *item)
+{
+  g_return_if_fail (item != NULL);
+
+  if (item->host)
+    gtk_widget_queue_draw (item->host);
+}
+
+void
+gtk_layout_item_set_host (GtkLayoutItem *item,
+                          GtkWidget     *host)
+{
+  g_return_if_fail (host == NULL || item->host == NULL);
+
+  item->host = host;
+}
+
+static void
+get_box (GtkStyleContext *context,
+         GtkBorder       *box)
+{
+  GtkBorder margin, border, padding;
+
+  gtk_style_context_get_margin (context, &margin);
+  gtk_style_context_get_border (context, &border);
+  gtk_style_context_get_padding (context, &padding);
+
+  box->left = margin.left + border.left + padding.left;
+  box->right = margin.right + border.right + padding.right;
+  box->top = margin.top + border.top + padding.top;
+  box->bottom = margin.bottom + border.bottom + padding.bottom;
+}
+
+void
+gtk_layout_item_measure (GtkLayoutItem   *item,
+                         GtkStyleContext *context,
+                         GtkOrientation   orientation,
+                         int              for_size,
+                         int             *minimum,
+                         int             *natural)
+{
+  GtkBorder box;
+  int extra, opposite_extra;
+
+  get_box (context, &box);
+
+  if (orientation == GTK_ORIENTATION_HORIZONTAL)
+    {
+      extra = box.left + box.right;
+      opposite_extra = box.top + box.bottom;
+    }
+  else
+    {
+      extra = box.top + box.bottom;
+      opposite_extra = box.left + box.right;
+    }
+
+  if (for_size > -1)
+    for_size = MAX (0, for_size - opposite_extra);
+
+  *minimum = 0;
+  *natural = 0;
+  item->measure_func (item, context, orientation, for_size,
+                      minimum, natural, item->user_data);
+
+  *minimum += extra;
+  *natural += extra;
+}
+
+void
+gtk_layout_item_snapshot (GtkLayoutItem   *item,
+                          GtkStyleContext *context,
+                          GtkSnapshot     *snapshot,
+                          int              x,
+                          int              y,
+                          int              width,
+                          int              height)
+{
+  GtkBorder margin, border, padding;
+
+  gtk_style_context_get_margin (context, &margin);
+  gtk_style_context_get_border (context, &border);
+  gtk_style_context_get_padding (context, &padding);
+
+  x += margin.left;
+  y += margin.top;
+  width -= margin.left + margin.right;
+  height -= margin.top + margin.bottom;
+
+  if (width <= 0 || height <= 0)
+    return;
+
+  gtk_snapshot_render_background (snapshot, context, x, y, width, height);
+  gtk_snapshot_render_frame (snapshot, context, x, y, width, height);
+
+  x += border.left + padding.left;
+  y += border.top + padding.top;
+  width -= border.left + border.right + padding.left + padding.right;
+  height -= border.top + border.bottom + padding.top + padding.bottom;
+
+  if (width <= 0 || height <= 0)
+    return;
+
+  gtk_snapshot_offset (snapshot, x, y);
+  item->snapshot_func (item, context, snapshot, width, height, item->user_data);
+  gtk_snapshot_offset (snapshot, -x, -y);
+}
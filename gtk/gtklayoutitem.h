@@ -0,0 +1,106 @@
+/* GTK - The GIMP Toolkit
+ * Copyright (C) 2018 Red Hat, Inc.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef __GTK_LAYOUT_ITEM_H__
+#define __GTK_LAYOUT_ITEM_H__
+
+#if !defined (__GTK_H_INSIDE__) && !defined (GTK_COMPILATION)
+#error "Only <gtk/gtk.h> can be included directly."
+#endif
+
+#include <gtk/gtkenums.h>
+#include <gtk/gtktypes.h>
+
+G_BEGIN_DECLS
+
+#define GTK_TYPE_LAYOUT_ITEM (gtk_layout_item_get_type ())
+
+typedef struct _GtkLayoutItem GtkLayoutItem;
+
+/**
+ * GtkLayoutItemMeasureFunc:
+ * @item: the #GtkLayoutItem being measured
+ * @context: a #GtkStyleContext set up for the item's CSS node
+ * @orientation: the orientation to measure
+ * @for_size: size for the opposite of @orientation, or -1
+ * @minimum: (out): location to store the minimum size
+ * @natural: (out): location to store the natural size
+ * @user_data: the data passed to gtk_layout_item_new()
+ *
+ * Measures the content of @item, not including its CSS margin,
+ * border and padding. See gtk_widget_measure().
+ */
+typedef void (* GtkLayoutItemMeasureFunc)  (GtkLayoutItem   *item,
+                                            GtkStyleContext *context,
+                                            GtkOrientation   orientation,
+                                            int              for_size,
+                                            int             *minimum,
+                                            int             *natural,
+                                            gpointer         user_data);
+
+/**
+ * GtkLayoutItemSnapshotFunc:
+ * @item: the #GtkLayoutItem being drawn
+ * @context: a #GtkStyleContext set up for the item's CSS node
+ * @snapshot: the #GtkSnapshot to append to, with the origin at
+ *     the item's content box
+ * @width: the width of the content box
+ * @height: the height of the content box
+ * @user_data: the data passed to gtk_layout_item_new()
+ *
+ * Draws the content of @item. The CSS background and frame have
+ * already been drawn by the container when this is called.
+ */
+typedef void (* GtkLayoutItemSnapshotFunc) (GtkLayoutItem   *item,
+                                            GtkStyleContext *context,
+                                            GtkSnapshot     *snapshot,
+                                            int              width,
+                                            int              height,
+                                            gpointer         user_data);
+
+GDK_AVAILABLE_IN_ALL
+GType           gtk_layout_item_get_type        (void) G_GNUC_CONST;
+
+GDK_AVAILABLE_IN_ALL
+GtkLayoutItem * gtk_layout_item_new             (GtkLayoutItemMeasureFunc   measure_func,
+                                                 GtkLayoutItemSnapshotFunc  snapshot_func,
+                                                 gpointer                   user_data,
+                                                 GDestroyNotify             destroy);
+GDK_AVAILABLE_IN_ALL
+GtkLayoutItem * gtk_layout_item_ref             (GtkLayoutItem             *item);
+GDK_AVAILABLE_IN_ALL
+void            gtk_layout_item_unref           (GtkLayoutItem             *item);
+
+GDK_AVAILABLE_IN_ALL
+void            gtk_layout_item_set_style_class (GtkLayoutItem             *item,
+                                                 const char                *style_class);
+GDK_AVAILABLE_IN_ALL
+const char *    gtk_layout_item_get_style_class (GtkLayoutItem             *item);
+
+GDK_AVAILABLE_IN_ALL
+GtkWidget *     gtk_layout_item_get_host        (GtkLayoutItem             *item);
+
+GDK_AVAILABLE_IN_ALL
+void            gtk_layout_item_queue_resize    (GtkLayoutItem             *item);
+GDK_AVAILABLE_IN_ALL
+void            gtk_layout_item_queue_draw      (GtkLayoutItem             *item);
+
+G_DEFINE_AUTOPTR_CLEANUP_FUNC(GtkLayoutItem, gtk_layout_item_unref)
+
+G_END_DECLS
+
+#endif /* __GTK_LAYOUT_ITEM_H__ */
@@ -0,0 +1,60 @@
+/* GTK - The GIMP Toolkit
+ * Copyright (C) 2018 Red Hat, Inc.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef __GTK_LAYOUT_ITEM_PRIVATE_H__
+#define __GTK_LAYOUT_ITEM_PRIVATE_H__
+
+#include "gtklayoutitem.h"
+
+G_BEGIN_DECLS
+
+struct _GtkLayoutItem
+{
+  guint ref_count;
+
+  GtkLayoutItemMeasureFunc measure_func;
+  GtkLayoutItemSnapshotFunc snapshot_func;
+  gpointer user_data;
+  GDestroyNotify destroy;
+
+  GQuark style_class;
+
+  /* not a reference */
+  GtkWidget *host;
+};
+
+void            gtk_layout_item_set_host        (GtkLayoutItem   *item,
+                                                 GtkWidget       *host);
+
+/* @context must be saved to the item's CSS node by the host */
+void            gtk_layout_item_measure         (GtkLayoutItem   *item,
+                                                 GtkStyleContext *context,
+                                                 GtkOrientation   orientation,
+                                                 int              for_size,
+                                                 int             *minimum,
+                                                 int             *natural);
+void            gtk_layout_item_snapshot        (GtkLayoutItem   *item,
+                                                 GtkStyleContext *context,
+                                                 GtkSnapshot     *snapshot,
+                                                 int              x,
+                                                 int              y,
+                                                 int              width,
+                                                 int              height);
+
+G_END_DECLS
+
+#endif /* __GTK_LAYOUT_ITEM_PRIVATE_H__ */
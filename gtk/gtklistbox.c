@@ -123,6 +123,13 @@ typedef struct
   GtkListBoxCreateWidgetFunc create_widget_func;
   gpointer create_widget_func_data;
   GDestroyNotify create_widget_func_data_destroy;
+
+  /* Lazy rows */
+  gboolean lazy_rows;
+  guint lazy_rows_idle_id;
+  int lazy_height_sum;
+  int n_lazy_heights;
+  int lazy_estimate;
 } GtkListBoxPrivate;
 
 typedef struct
@@ -130,12 +137,16 @@ typedef struct
   GSequenceIter *iter;
   GtkWidget *header;
   GtkActionHelper *action_helper;
+  GObject *item;
   gint y;
   gint height;
-  guint visible     :1;
-  guint selected    :1;
-  guint activatable :1;
-  guint selectable  :1;
+  guint visible       :1;
+  guint selected      :1;
+  guint activatable   :1;
+  guint selectable    :1;
+  guint lazy          :1;
+  guint lazy_bound    :1;
+  guint lazy_measured :1;
 } GtkListBoxRowPrivate;
 
 enum {
@@ -160,6 +171,7 @@ enum {
   PROP_SELECTION_MODE,
   PROP_ACTIVATE_ON_SINGLE_CLICK,
   PROP_ACCEPT_UNPAIRED_RELEASE,
+  PROP_LAZY_ROWS,
   LAST_PROPERTY
 };
 
@@ -192,12 +204,12 @@ G_DEFINE_TYPE_WITH_CODE (GtkListBoxRow, gtk_list_box_row, GTK_TYPE_BIN,
                          G_ADD_PRIVATE (GtkListBoxRow)
                          G_IMPLEMENT_INTERFACE (GTK_TYPE_ACTIONABLE, gtk_list_box_row_actionable_iface_init))
 
-static void                 gtk_list_box_apply_filter_all             (GtkListBox          *box);
+static gboolean             gtk_list_box_apply_filter_all             (GtkListBox          *box);
 static void                 gtk_list_box_update_header                (GtkListBox          *box,
                                                                        GSequenceIter       *iter);
 static GSequenceIter *      gtk_list_box_get_next_visible             (GtkListBox          *box,
                                                                        GSequenceIter       *iter);
-static void                 gtk_list_box_apply_filter                 (GtkListBox          *box,
+static gboolean             gtk_list_box_apply_filter                 (GtkListBox          *box,
                                                                        GtkListBoxRow       *row);
 static void                 gtk_list_box_add_move_binding             (GtkBindingSet       *binding_set,
                                                                        guint                keyval,
@@ -277,6 +289,7 @@ static void gtk_list_box_update_row_styles (GtkListBox    *box);
 static void gtk_list_box_update_row_style  (GtkListBox    *box,
                                             GtkListBoxRow *row);
 
+static void                 gtk_list_box_queue_update_lazy_rows         (GtkListBox          *box);
 static void                 gtk_list_box_bound_model_changed            (GListModel          *list,
                                                                          guint                position,
                                                                          guint                removed,
@@ -332,6 +345,9 @@ gtk_list_box_get_property (GObject    *obj,
     case PROP_ACCEPT_UNPAIRED_RELEASE:
       g_value_set_boolean (value, priv->accept_unpaired_release);
       break;
+    case PROP_LAZY_ROWS:
+      g_value_set_boolean (value, priv->lazy_rows);
+      break;
     default:
       G_OBJECT_WARN_INVALID_PROPERTY_ID (obj, property_id, pspec);
       break;
@@ -357,6 +373,9 @@ gtk_list_box_set_property (GObject      *obj,
     case PROP_ACCEPT_UNPAIRED_RELEASE:
       gtk_list_box_set_accept_unpaired_release (box, g_value_get_boolean (value));
       break;
+    case PROP_LAZY_ROWS:
+      gtk_list_box_set_lazy_rows (box, g_value_get_boolean (value));
+      break;
     default:
       G_OBJECT_WARN_INVALID_PROPERTY_ID (obj, property_id, pspec);
       break;
@@ -375,6 +394,11 @@ gtk_list_box_finalize (GObject *obj)
   if (priv->update_header_func_target_destroy_notify != NULL)
     priv->update_header_func_target_destroy_notify (priv->update_header_func_target);
 
+  if (priv->lazy_rows_idle_id)
+    g_source_remove (priv->lazy_rows_idle_id);
+
+  if (priv->adjustment)
+    g_signal_handlers_disconnect_by_func (priv->adjustment, gtk_list_box_queue_update_lazy_rows, obj);
   g_clear_object (&priv->adjustment);
   g_clear_object (&priv->drag_highlighted_row);
 
@@ -446,6 +470,21 @@ gtk_list_box_class_init (GtkListBoxClass *klass)
                           FALSE,
                           G_PARAM_READWRITE | G_PARAM_EXPLICIT_NOTIFY);
 
+  /**
+   * GtkListBox:lazy-rows:
+   *
+   * Whether rows for a bound model are only created when they
+   * get close to the visible part of the list.
+   *
+   * See gtk_list_box_set_lazy_rows().
+   */
+  properties[PROP_LAZY_ROWS] =
+    g_param_spec_boolean ("lazy-rows",
+                          P_("Lazy rows"),
+                          P_("Whether to create row widgets only when they are needed"),
+                          FALSE,
+                          G_PARAM_READWRITE | G_PARAM_EXPLICIT_NOTIFY);
+
   g_object_class_install_properties (object_class, LAST_PROPERTY, properties);
 
   /**
@@ -612,6 +651,7 @@ gtk_list_box_init (GtkListBox *box)
   GtkGesture *gesture;
 
   gtk_widget_set_has_surface (widget, FALSE);
+  gtk_widget_set_use_pick_index (widget, TRUE);
   priv->selection_mode = GTK_SELECTION_SINGLE;
   priv->activate_single_click = TRUE;
 
@@ -955,10 +995,19 @@ gtk_list_box_set_adjustment (GtkListBox    *box,
   g_return_if_fail (adjustment == NULL || GTK_IS_ADJUSTMENT (adjustment));
 
   if (adjustment)
-    g_object_ref_sink (adjustment);
+    {
+      g_object_ref_sink (adjustment);
+      g_signal_connect_swapped (adjustment, "value-changed",
+                                G_CALLBACK (gtk_list_box_queue_update_lazy_rows), box);
+    }
   if (priv->adjustment)
-    g_object_unref (priv->adjustment);
+    {
+      g_signal_handlers_disconnect_by_func (priv->adjustment, gtk_list_box_queue_update_lazy_rows, box);
+      g_object_unref (priv->adjustment);
+    }
   priv->adjustment = adjustment;
+
+  gtk_list_box_queue_update_lazy_rows (box);
 }
 
 /**
@@ -1174,9 +1223,11 @@ gtk_list_box_invalidate_filter (GtkListBox *box)
 {
   g_return_if_fail (GTK_IS_LIST_BOX (box));
 
-  gtk_list_box_apply_filter_all (box);
-  gtk_list_box_invalidate_headers (box);
-  gtk_widget_queue_resize (GTK_WIDGET (box));
+  /* Headers of the rows next to the changed ones have been updated
+   * already, and nothing needs to be reallocated if no row changed.
+   */
+  if (gtk_list_box_apply_filter_all (box))
+    gtk_widget_queue_resize (GTK_WIDGET (box));
 }
 
 static gint
@@ -1210,6 +1261,53 @@ gtk_list_box_css_node_foreach (gpointer data,
   *previous = row;
 }
 
+static gboolean
+gtk_list_box_is_sorted (GtkListBox *box)
+{
+  GSequenceIter *iter, *next;
+
+  iter = g_sequence_get_begin_iter (BOX_PRIV (box)->children);
+  if (g_sequence_iter_is_end (iter))
+    return TRUE;
+
+  for (next = g_sequence_iter_next (iter);
+       !g_sequence_iter_is_end (next);
+       iter = next, next = g_sequence_iter_next (next))
+    {
+      if (do_sort (g_sequence_get (iter), g_sequence_get (next), box) > 0)
+        return FALSE;
+    }
+
+  return TRUE;
+}
+
+/* Checks whether @row is still in order with its neighbours,
+ * so that a change that doesn't affect sorting costs two compares.
+ */
+static gboolean
+gtk_list_box_row_is_sorted (GtkListBox    *box,
+                            GtkListBoxRow *row)
+{
+  GSequenceIter *iter = ROW_PRIV (row)->iter;
+  GSequenceIter *prev, *next;
+
+  if (!g_sequence_iter_is_begin (iter))
+    {
+      prev = g_sequence_iter_prev (iter);
+      if (do_sort (g_sequence_get (prev), row, box) > 0)
+        return FALSE;
+    }
+
+  next = g_sequence_iter_next (iter);
+  if (!g_sequence_iter_is_end (next))
+    {
+      if (do_sort (row, g_sequence_get (next), box) > 0)
+        return FALSE;
+    }
+
+  return TRUE;
+}
+
 /**
  * gtk_list_box_invalidate_sort:
  * @box: a #GtkListBox
@@ -1229,6 +1327,9 @@ gtk_list_box_invalidate_sort (GtkListBox *box)
   if (priv->sort_func == NULL)
     return;
 
+  if (gtk_list_box_is_sorted (box))
+    return;
+
   g_sequence_sort (priv->children, (GCompareDataFunc)do_sort, box);
   g_sequence_foreach (priv->children, gtk_list_box_css_node_foreach, &previous);
 
@@ -1320,14 +1421,28 @@ gtk_list_box_got_row_changed (GtkListBox    *box,
   g_return_if_fail (GTK_IS_LIST_BOX_ROW (row));
 
   prev_next = gtk_list_box_get_next_visible (box, row_priv->iter);
-  if (priv->sort_func != NULL)
+  if (priv->sort_func != NULL &&
+      !gtk_list_box_row_is_sorted (box, row))
     {
+      GSequenceIter *prev;
+      GtkCssNode *row_node;
+
       g_sequence_sort_changed (row_priv->iter,
                                (GCompareDataFunc)do_sort,
                                box);
+
+      row_node = gtk_widget_get_css_node (GTK_WIDGET (row));
+      prev = g_sequence_iter_prev (row_priv->iter);
+      gtk_css_node_insert_after (gtk_css_node_get_parent (row_node),
+                                 row_node,
+                                 prev != row_priv->iter
+                                 ? gtk_widget_get_css_node (g_sequence_get (prev))
+                                 : NULL);
+
       gtk_widget_queue_resize (GTK_WIDGET (box));
     }
-  gtk_list_box_apply_filter (box, row);
+  if (gtk_list_box_apply_filter (box, row))
+    gtk_widget_queue_resize (GTK_WIDGET (box));
   if (gtk_widget_get_visible (GTK_WIDGET (box)))
     {
       next = gtk_list_box_get_next_visible (box, row_priv->iter);
@@ -2032,35 +2147,59 @@ update_row_is_visible (GtkListBox    *box,
     list_box_add_visible_rows (box, 1);
 }
 
-static void
+/* Returns whether the visibility of @row changed */
+static gboolean
 gtk_list_box_apply_filter (GtkListBox    *box,
                            GtkListBoxRow *row)
 {
   GtkListBoxPrivate *priv = BOX_PRIV (box);
   gboolean do_show;
+  gboolean was_visible;
 
   do_show = TRUE;
   if (priv->filter_func != NULL)
     do_show = priv->filter_func (row, priv->filter_func_target);
 
+  was_visible = ROW_PRIV (row)->visible;
+
   gtk_widget_set_child_visible (GTK_WIDGET (row), do_show);
 
   update_row_is_visible (box, row);
+
+  return was_visible != ROW_PRIV (row)->visible;
 }
 
-static void
+/* Returns whether the visibility of any row changed. Only the
+ * headers next to rows that changed visibility get updated.
+ */
+static gboolean
 gtk_list_box_apply_filter_all (GtkListBox *box)
 {
   GtkListBoxRow *row;
   GSequenceIter *iter;
+  gboolean update_headers;
+  gboolean changed = FALSE;
+
+  update_headers = gtk_widget_get_visible (GTK_WIDGET (box));
 
   for (iter = g_sequence_get_begin_iter (BOX_PRIV (box)->children);
        !g_sequence_iter_is_end (iter);
        iter = g_sequence_iter_next (iter))
     {
       row = g_sequence_get (iter);
-      gtk_list_box_apply_filter (box, row);
+      if (!gtk_list_box_apply_filter (box, row))
+        continue;
+
+      changed = TRUE;
+
+      if (update_headers)
+        {
+          gtk_list_box_update_header (box, iter);
+          gtk_list_box_update_header (box, gtk_list_box_get_next_visible (box, iter));
+        }
     }
+
+  return changed;
 }
 
 static GtkListBoxRow *
@@ -2574,7 +2713,17 @@ gtk_list_box_size_allocate (GtkWidget *widget,
       ROW_PRIV (row)->height = child_allocation.height;
       gtk_widget_size_allocate (GTK_WIDGET (row), &child_allocation, -1);
       child_allocation.y += child_min;
+
+      if (ROW_PRIV (row)->lazy_bound && !ROW_PRIV (row)->lazy_measured)
+        {
+          priv->lazy_height_sum += child_min;
+          priv->n_lazy_heights++;
+          ROW_PRIV (row)->lazy_measured = TRUE;
+        }
     }
+
+  if (priv->lazy_rows && priv->bound_model)
+    gtk_list_box_queue_update_lazy_rows (GTK_LIST_BOX (widget));
 }
 
 /**
@@ -3344,6 +3493,7 @@ static void
 gtk_list_box_row_finalize (GObject *obj)
 {
   g_clear_object (&ROW_PRIV (GTK_LIST_BOX_ROW (obj))->header);
+  g_clear_object (&ROW_PRIV (GTK_LIST_BOX_ROW (obj))->item);
 
   G_OBJECT_CLASS (gtk_list_box_row_parent_class)->finalize (obj);
 }
@@ -3477,6 +3627,238 @@ gtk_list_box_buildable_interface_init (GtkBuildableIface *iface)
   iface->add_child = gtk_list_box_buildable_add_child;
 }
 
+/* Lazy rows
+ *
+ * With lazy rows, binding a model only creates empty rows that carry
+ * their item and request an estimated height. The widgets returned by
+ * the create_widget_func are added to those rows once they come close
+ * to the visible part of the scrolled window, and removed again after
+ * they have scrolled far away. The rows themselves stay, so selection,
+ * cursor and keyboard navigation keep working on the full list.
+ */
+
+#define LAZY_ROW_DEFAULT_HEIGHT 32
+
+static int
+gtk_list_box_get_lazy_estimate (GtkListBox *box)
+{
+  GtkListBoxPrivate *priv = BOX_PRIV (box);
+
+  if (priv->n_lazy_heights == 0)
+    return LAZY_ROW_DEFAULT_HEIGHT;
+
+  return MAX (1, priv->lazy_height_sum / priv->n_lazy_heights);
+}
+
+static void
+gtk_list_box_bind_lazy_row (GtkListBox    *box,
+                            GtkListBoxRow *row)
+{
+  GtkListBoxPrivate *priv = BOX_PRIV (box);
+  GtkWidget *widget;
+
+  widget = priv->create_widget_func (ROW_PRIV (row)->item, priv->create_widget_func_data);
+  if (g_object_is_floating (widget))
+    g_object_ref_sink (widget);
+
+  ROW_PRIV (row)->lazy_bound = TRUE;
+  ROW_PRIV (row)->lazy_measured = FALSE;
+
+  if (GTK_IS_LIST_BOX_ROW (widget))
+    {
+      g_warning ("GtkListBox with lazy rows needs a create_widget_func that does not return rows");
+      g_object_unref (widget);
+      return;
+    }
+
+  gtk_widget_set_size_request (GTK_WIDGET (row), -1, -1);
+  gtk_widget_show (widget);
+  gtk_container_add (GTK_CONTAINER (row), widget);
+  g_object_unref (widget);
+}
+
+static void
+gtk_list_box_unbind_lazy_row (GtkListBox    *box,
+                              GtkListBoxRow *row)
+{
+  GtkWidget *child;
+
+  /* Keep the space the row took while it was bound */
+  gtk_widget_set_size_request (GTK_WIDGET (row), -1, ROW_PRIV (row)->height);
+
+  child = gtk_bin_get_child (GTK_BIN (row));
+  if (child)
+    gtk_container_remove (GTK_CONTAINER (row), child);
+
+  ROW_PRIV (row)->lazy_bound = FALSE;
+}
+
+static gboolean
+gtk_list_box_lazy_row_is_busy (GtkListBox    *box,
+                               GtkListBoxRow *row)
+{
+  GtkListBoxPrivate *priv = BOX_PRIV (box);
+
+  return ROW_PRIV (row)->selected ||
+         row == priv->cursor_row ||
+         row == priv->active_row ||
+         row == priv->drag_highlighted_row ||
+         gtk_widget_get_focus_child (GTK_WIDGET (row)) != NULL;
+}
+
+static gboolean
+gtk_list_box_update_lazy_rows (gpointer data)
+{
+  GtkListBox *box = data;
+  GtkListBoxPrivate *priv = BOX_PRIV (box);
+  GSequenceIter *iter;
+  int bind_start, bind_end;
+  int keep_start, keep_end;
+  int estimate;
+
+  priv->lazy_rows_idle_id = 0;
+
+  if (!priv->lazy_rows || !priv->bound_model)
+    return G_SOURCE_REMOVE;
+
+  if (priv->adjustment)
+    {
+      double value = gtk_adjustment_get_value (priv->adjustment);
+      double page_size = gtk_adjustment_get_page_size (priv->adjustment);
+
+      /* Bind half a page ahead so that scrolling does not show empty
+       * rows, and only unbind rows that are two pages away so that
+       * scrolling back and forth does not recreate them.
+       */
+      bind_start = value - page_size / 2;
+      bind_end = value + page_size * 3 / 2;
+      keep_start = value - page_size * 2;
+      keep_end = value + page_size * 3;
+    }
+  else
+    {
+      /* Without a scrolled window, every row is visible */
+      bind_start = keep_start = G_MININT;
+      bind_end = keep_end = G_MAXINT;
+    }
+
+  estimate = gtk_list_box_get_lazy_estimate (box);
+
+  for (iter = g_sequence_get_begin_iter (priv->children);
+       !g_sequence_iter_is_end (iter);
+       iter = g_sequence_iter_next (iter))
+    {
+      GtkListBoxRow *row = g_sequence_get (iter);
+      GtkListBoxRowPrivate *row_priv = ROW_PRIV (row);
+      int y, height;
+
+      if (!row_priv->lazy || !row_is_visible (row))
+        continue;
+
+      y = row_priv->y;
+      height = row_priv->height;
+
+      if (row_priv->lazy_bound)
+        {
+          if ((y + height < keep_start || y > keep_end) &&
+              !gtk_list_box_lazy_row_is_busy (box, row))
+            gtk_list_box_unbind_lazy_row (box, row);
+        }
+      else if (y + height >= bind_start && y <= bind_end)
+        {
+          gtk_list_box_bind_lazy_row (box, row);
+        }
+      else if (!row_priv->lazy_measured && height != estimate)
+        {
+          /* Rows that were never bound follow the estimate */
+          gtk_widget_set_size_request (GTK_WIDGET (row), -1, estimate);
+        }
+    }
+
+  return G_SOURCE_REMOVE;
+}
+
+static void
+gtk_list_box_queue_update_lazy_rows (GtkListBox *box)
+{
+  GtkListBoxPrivate *priv = BOX_PRIV (box);
+
+  if (!priv->lazy_rows || !priv->bound_model || priv->lazy_rows_idle_id != 0)
+    return;
+
+  priv->lazy_rows_idle_id = g_idle_add (gtk_list_box_update_lazy_rows, box);
+  g_source_set_name_by_id (priv->lazy_rows_idle_id, "[gtk] gtk_list_box_update_lazy_rows");
+}
+
+/**
+ * gtk_list_box_set_lazy_rows:
+ * @box: a #GtkListBox
+ * @lazy_rows: %TRUE to create row widgets only when needed
+ *
+ * Sets whether the rows for a model that is bound with
+ * gtk_list_box_bind_model() are created lazily.
+ *
+ * With lazy rows, @box starts out with empty rows of an estimated
+ * height and only calls the create_widget_func for items whose rows
+ * come close to the visible part of an enclosing #GtkScrolledWindow.
+ * The widgets of rows that have been scrolled far away are destroyed
+ * again. This keeps the number of widgets proportional to the visible
+ * part of the list, which makes binding large models cheap.
+ *
+ * The create_widget_func must not return #GtkListBoxRows when lazy
+ * rows are used, since the rows are created by @box. Note that
+ * gtk_bin_get_child() returns %NULL for rows that are not currently
+ * bound.
+ */
+void
+gtk_list_box_set_lazy_rows (GtkListBox *box,
+                            gboolean    lazy_rows)
+{
+  GtkListBoxPrivate *priv = BOX_PRIV (box);
+
+  g_return_if_fail (GTK_IS_LIST_BOX (box));
+
+  lazy_rows = lazy_rows != FALSE;
+
+  if (priv->lazy_rows == lazy_rows)
+    return;
+
+  priv->lazy_rows = lazy_rows;
+
+  if (priv->lazy_rows_idle_id)
+    {
+      g_source_remove (priv->lazy_rows_idle_id);
+      priv->lazy_rows_idle_id = 0;
+    }
+
+  /* Recreate the rows in the new mode */
+  if (priv->bound_model)
+    {
+      guint n_items = g_list_model_get_n_items (priv->bound_model);
+
+      gtk_list_box_bound_model_changed (priv->bound_model, 0, n_items, n_items, box);
+    }
+
+  g_object_notify_by_pspec (G_OBJECT (box), properties[PROP_LAZY_ROWS]);
+}
+
+/**
+ * gtk_list_box_get_lazy_rows:
+ * @box: a #GtkListBox
+ *
+ * Returns whether rows for a bound model are created lazily.
+ * See gtk_list_box_set_lazy_rows().
+ *
+ * Returns: %TRUE if rows are created lazily
+ */
+gboolean
+gtk_list_box_get_lazy_rows (GtkListBox *box)
+{
+  g_return_val_if_fail (GTK_IS_LIST_BOX (box), FALSE);
+
+  return BOX_PRIV (box)->lazy_rows;
+}
+
 static void
 gtk_list_box_bound_model_changed (GListModel *list,
                                   guint       position,
@@ -3502,6 +3884,18 @@ gtk_list_box_bound_model_changed (GListModel *list,
       GtkWidget *widget;
 
       item = g_list_model_get_item (list, position + i);
+
+      if (priv->lazy_rows)
+        {
+          widget = gtk_list_box_row_new ();
+          ROW_PRIV (widget)->item = item;
+          ROW_PRIV (widget)->lazy = TRUE;
+          gtk_widget_set_size_request (widget, -1, gtk_list_box_get_lazy_estimate (box));
+          gtk_widget_show (widget);
+          gtk_list_box_insert (box, widget, position + i);
+          continue;
+        }
+
       widget = priv->create_widget_func (item, priv->create_widget_func_data);
 
       /* We allow the create_widget_func to either return a full
@@ -3520,6 +3914,9 @@ gtk_list_box_bound_model_changed (GListModel *list,
       g_object_unref (widget);
       g_object_unref (item);
     }
+
+  if (priv->lazy_rows && added > 0)
+    gtk_list_box_queue_update_lazy_rows (box);
 }
 
 static void
@@ -3557,6 +3954,8 @@ gtk_list_box_check_model_compat (GtkListBox *box)
  * Note that using a model is incompatible with the filtering and sorting
  * functionality in GtkListBox. When using a model, filtering and sorting
  * should be implemented by the model.
+ *
+ * For large models, see gtk_list_box_set_lazy_rows().
  */
 void
 gtk_list_box_bind_model (GtkListBox                 *box,
@@ -3581,6 +3980,12 @@ gtk_list_box_bind_model (GtkListBox                 *box,
       g_clear_object (&priv->bound_model);
     }
 
+  if (priv->lazy_rows_idle_id)
+    {
+      g_source_remove (priv->lazy_rows_idle_id);
+      priv->lazy_rows_idle_id = 0;
+    }
+
   iter = g_sequence_get_begin_iter (priv->children);
   while (!g_sequence_iter_is_end (iter))
     {
@@ -299,6 +299,11 @@ void           gtk_list_box_bind_model                   (GtkListBox
                                                           GtkListBoxCreateWidgetFunc    create_widget_func,
                                                           gpointer                      user_data,
                                                           GDestroyNotify                user_data_free_func);
+GDK_AVAILABLE_IN_ALL
+void           gtk_list_box_set_lazy_rows                (GtkListBox                    *box,
+                                                          gboolean                       lazy_rows);
+GDK_AVAILABLE_IN_ALL
+gboolean       gtk_list_box_get_lazy_rows                (GtkListBox                    *box);
 
 G_DEFINE_AUTOPTR_CLEANUP_FUNC(GtkListBox, g_object_unref)
 G_DEFINE_AUTOPTR_CLEANUP_FUNC(GtkListBoxRow, g_object_unref)
@@ -0,0 +1,598 @@
+/* GTK - The GIMP Toolkit
+ * Copyright (C) 2018 Red Hat, Inc.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "config.h"
+
+#include "gtklistitemmanagerprivate.h"
+
+#include "gtklistitemprivate.h"
+
+/* GtkListItemManager keeps track of the list items of list widgets like
+ * GtkListView. It only creates list items for the range of the model
+ * the widget tells it is visible and reuses those list items for other
+ * items of the model when that range changes.
+ *
+ * The items of the model are kept in a GtkRbTree. Nodes with a widget
+ * represent a single item, all other items are kept in runs of items
+ * without widgets, so the tree stays small even for huge models.
+ * Widgets add their own data, like the size of the items, to the nodes
+ * and augments, see gtk_list_item_manager_new().
+ */
+
+struct _GtkListItemManager
+{
+  GObject parent_instance;
+
+  GtkWidget *widget; /* not owned */
+  const char *item_css_name;
+  GtkRbTree *items;
+  GListModel *model;
+  GtkListItemFactory *factory;
+
+  /* List items that don't display an item anymore. They are still
+   * children of widget, so that they can be reused. */
+  GPtrArray *spare;
+};
+
+struct _GtkListItemManagerClass
+{
+  GObjectClass parent_class;
+};
+
+G_DEFINE_TYPE (GtkListItemManager, gtk_list_item_manager, G_TYPE_OBJECT)
+
+void
+gtk_list_item_manager_augment_node (GtkRbTree *tree,
+                                    gpointer   node_augment,
+                                    gpointer   node,
+                                    gpointer   left,
+                                    gpointer   right)
+{
+  GtkListItemManagerItem *item = node;
+  GtkListItemManagerItemAugment *aug = node_augment;
+
+  aug->n_items = item->n_items;
+
+  if (left)
+    {
+      GtkListItemManagerItemAugment *left_aug = gtk_rb_tree_get_augment (tree, left);
+
+      aug->n_items += left_aug->n_items;
+    }
+
+  if (right)
+    {
+      GtkListItemManagerItemAugment *right_aug = gtk_rb_tree_get_augment (tree, right);
+
+      aug->n_items += right_aug->n_items;
+    }
+}
+
+gpointer
+gtk_list_item_manager_get_root (GtkListItemManager *self)
+{
+  return gtk_rb_tree_get_root (self->items);
+}
+
+gpointer
+gtk_list_item_manager_get_first (GtkListItemManager *self)
+{
+  return gtk_rb_tree_get_first (self->items);
+}
+
+gpointer
+gtk_list_item_manager_get_item_augment (GtkListItemManager *self,
+                                        gpointer            item)
+{
+  return gtk_rb_tree_get_augment (self->items, item);
+}
+
+/* Returns the node containing the item at @position and sets @offset
+ * to the position of that item inside the node, or returns %NULL if
+ * @position is out of range.
+ */
+gpointer
+gtk_list_item_manager_get_nth (GtkListItemManager *self,
+                               guint               position,
+                               guint              *offset)
+{
+  GtkListItemManagerItem *item, *tmp;
+
+  item = gtk_rb_tree_get_root (self->items);
+
+  while (item)
+    {
+      tmp = gtk_rb_tree_node_get_left (item);
+      if (tmp)
+        {
+          GtkListItemManagerItemAugment *aug = gtk_rb_tree_get_augment (self->items, tmp);
+          if (position < aug->n_items)
+            {
+              item = tmp;
+              continue;
+            }
+          position -= aug->n_items;
+        }
+
+      if (position < item->n_items)
+        break;
+      position -= item->n_items;
+
+      item = gtk_rb_tree_node_get_right (item);
+    }
+
+  if (offset)
+    *offset = item ? position : 0;
+
+  return item;
+}
+
+/* Returns the position of the first item in @item */
+guint
+gtk_list_item_manager_get_item_position (GtkListItemManager *self,
+                                         gpointer            item)
+{
+  GtkListItemManagerItem *parent, *left;
+  guint pos;
+
+  left = gtk_rb_tree_node_get_left (item);
+  if (left)
+    {
+      GtkListItemManagerItemAugment *aug = gtk_rb_tree_get_augment (self->items, left);
+      pos = aug->n_items;
+    }
+  else
+    {
+      pos = 0;
+    }
+
+  for (parent = gtk_rb_tree_node_get_parent (item);
+       parent != NULL;
+       parent = gtk_rb_tree_node_get_parent (item))
+    {
+      if (gtk_rb_tree_node_get_right (parent) == item)
+        {
+          left = gtk_rb_tree_node_get_left (parent);
+          if (left)
+            {
+              GtkListItemManagerItemAugment *aug = gtk_rb_tree_get_augment (self->items, left);
+              pos += aug->n_items;
+            }
+          pos += parent->n_items;
+        }
+
+      item = parent;
+    }
+
+  return pos;
+}
+
+guint
+gtk_list_item_manager_get_n_items (GtkListItemManager *self)
+{
+  if (self->model == NULL)
+    return 0;
+
+  return g_list_model_get_n_items (self->model);
+}
+
+static void
+gtk_list_item_manager_release_widget (GtkListItemManager     *self,
+                                      GtkListItemManagerItem *item)
+{
+  g_ptr_array_add (self->spare, item->widget);
+  item->widget = NULL;
+  gtk_rb_tree_node_mark_dirty (item);
+}
+
+static void
+gtk_list_item_manager_release_all (GtkListItemManager *self)
+{
+  GtkListItemManagerItem *item;
+
+  for (item = gtk_rb_tree_get_first (self->items);
+       item != NULL;
+       item = gtk_rb_tree_node_get_next (item))
+    {
+      if (item->widget)
+        gtk_list_item_manager_release_widget (self, item);
+    }
+}
+
+static void
+gtk_list_item_manager_clear_spare (GtkListItemManager *self)
+{
+  guint i;
+
+  for (i = 0; i < self->spare->len; i++)
+    {
+      GtkWidget *widget = g_ptr_array_index (self->spare, i);
+
+      gtk_list_item_factory_unbind (self->factory, GTK_LIST_ITEM (widget));
+      gtk_widget_unparent (widget);
+    }
+
+  g_ptr_array_set_size (self->spare, 0);
+}
+
+/* Gets a list item for the item at @position. Prefers list items that
+ * display that item already, then ones that can be rebound and only
+ * creates new ones if there are none left.
+ */
+static GtkWidget *
+gtk_list_item_manager_acquire_widget (GtkListItemManager *self,
+                                      guint               position,
+                                      GtkWidget          *prev_sibling)
+{
+  GtkWidget *result = NULL;
+  gpointer object;
+  guint i;
+
+  object = g_list_model_get_item (self->model, position);
+
+  for (i = 0; i < self->spare->len; i++)
+    {
+      GtkListItem *list_item = g_ptr_array_index (self->spare, i);
+
+      if (gtk_list_item_get_item (list_item) == object)
+        {
+          result = g_ptr_array_remove_index_fast (self->spare, i);
+          gtk_list_item_factory_update (self->factory, list_item, position);
+          break;
+        }
+    }
+
+  if (result == NULL)
+    {
+      if (self->spare->len > 0)
+        result = g_ptr_array_remove_index_fast (self->spare, self->spare->len - 1);
+      else
+        result = GTK_WIDGET (gtk_list_item_factory_create (self->factory, self->item_css_name));
+
+      gtk_list_item_factory_bind (self->factory, GTK_LIST_ITEM (result), position, object);
+    }
+
+  gtk_widget_insert_after (result, self->widget, prev_sibling);
+
+  g_object_unref (object);
+
+  return result;
+}
+
+/* Joins neighbouring runs of items without widgets */
+static void
+gtk_list_item_manager_merge_runs (GtkListItemManager *self)
+{
+  GtkListItemManagerItem *item, *next;
+
+  item = gtk_rb_tree_get_first (self->items);
+  while (item)
+    {
+      next = gtk_rb_tree_node_get_next (item);
+      if (next == NULL)
+        break;
+
+      if (item->widget == NULL && next->widget == NULL)
+        {
+          item->n_items += next->n_items;
+          gtk_rb_tree_node_mark_dirty (item);
+          gtk_rb_tree_remove (self->items, next);
+        }
+      else
+        {
+          item = next;
+        }
+    }
+}
+
+/**
+ * gtk_list_item_manager_set_visible_range:
+ * @self: a #GtkListItemManager
+ * @position: first item that needs a widget
+ * @n_items: number of items that need a widget
+ *
+ * Makes sure that exactly the items from @position to
+ * @position + @n_items - 1 have widgets and that these widgets are
+ * children of the list widget in the order of the items. Widgets that
+ * are not needed anymore are reused or destroyed.
+ */
+void
+gtk_list_item_manager_set_visible_range (GtkListItemManager *self,
+                                         guint               position,
+                                         guint               n_items)
+{
+  GtkListItemManagerItem *item;
+  GtkWidget *prev_sibling;
+  guint pos, offset, end, n;
+
+  n = gtk_list_item_manager_get_n_items (self);
+  if (self->factory == NULL || position >= n)
+    position = end = n;
+  else
+    end = position + MIN (n_items, n - position);
+
+  pos = 0;
+  for (item = gtk_rb_tree_get_first (self->items);
+       item != NULL;
+       item = gtk_rb_tree_node_get_next (item))
+    {
+      if (item->widget && (pos < position || pos >= end))
+        gtk_list_item_manager_release_widget (self, item);
+      pos += item->n_items;
+    }
+
+  gtk_list_item_manager_merge_runs (self);
+
+  prev_sibling = NULL;
+  item = gtk_list_item_manager_get_nth (self, position, &offset);
+  for (pos = position; pos < end; pos++)
+    {
+      if (item->widget == NULL)
+        {
+          if (offset > 0)
+            {
+              GtkListItemManagerItem *before = gtk_rb_tree_insert_before (self->items, item);
+              before->n_items = offset;
+              item->n_items -= offset;
+              offset = 0;
+            }
+          if (item->n_items > 1)
+            {
+              GtkListItemManagerItem *after = gtk_rb_tree_insert_after (self->items, item);
+              after->n_items = item->n_items - 1;
+              item->n_items = 1;
+            }
+
+          item->widget = gtk_list_item_manager_acquire_widget (self, pos, prev_sibling);
+          gtk_rb_tree_node_mark_dirty (item);
+        }
+      else
+        {
+          gtk_list_item_factory_update (self->factory, GTK_LIST_ITEM (item->widget), pos);
+          gtk_widget_insert_after (item->widget, self->widget, prev_sibling);
+        }
+
+      prev_sibling = item->widget;
+      item = gtk_rb_tree_node_get_next (item);
+    }
+
+  gtk_list_item_manager_clear_spare (self);
+}
+
+static void
+gtk_list_item_manager_items_changed_cb (GListModel         *model,
+                                        guint               position,
+                                        guint               removed,
+                                        guint               added,
+                                        GtkListItemManager *self)
+{
+  GtkListItemManagerItem *item, *next;
+  guint offset, n;
+
+  item = gtk_list_item_manager_get_nth (self, position, &offset);
+  while (removed > 0)
+    {
+      next = gtk_rb_tree_node_get_next (item);
+
+      if (item->widget)
+        gtk_list_item_manager_release_widget (self, item);
+
+      n = MIN (removed, item->n_items - offset);
+      item->n_items -= n;
+      removed -= n;
+
+      if (item->n_items == 0)
+        gtk_rb_tree_remove (self->items, item);
+      else
+        gtk_rb_tree_node_mark_dirty (item);
+
+      item = next;
+      offset = 0;
+    }
+
+  if (added > 0)
+    {
+      item = gtk_list_item_manager_get_nth (self, position, &offset);
+      if (item == NULL || item->widget != NULL)
+        {
+          GtkListItemManagerItem *prev;
+
+          prev = item ? gtk_rb_tree_node_get_previous (item) : gtk_rb_tree_get_last (self->items);
+          if (prev && prev->widget == NULL)
+            {
+              item = prev;
+            }
+          else
+            {
+              item = gtk_rb_tree_insert_before (self->items, item);
+              item->n_items = 0;
+            }
+        }
+
+      item->n_items += added;
+      gtk_rb_tree_node_mark_dirty (item);
+    }
+
+  gtk_widget_queue_resize (self->widget);
+}
+
+static void
+gtk_list_item_manager_clear_model (GtkListItemManager *self)
+{
+  if (self->model == NULL)
+    return;
+
+  g_signal_handlers_disconnect_by_func (self->model, gtk_list_item_manager_items_changed_cb, self);
+  g_clear_object (&self->model);
+
+  gtk_list_item_manager_release_all (self);
+  gtk_rb_tree_remove_all (self->items);
+}
+
+static void
+gtk_list_item_manager_dispose (GObject *object)
+{
+  GtkListItemManager *self = GTK_LIST_ITEM_MANAGER (object);
+
+  gtk_list_item_manager_clear_model (self);
+  if (self->factory)
+    gtk_list_item_manager_clear_spare (self);
+  g_clear_object (&self->factory);
+
+  G_OBJECT_CLASS (gtk_list_item_manager_parent_class)->dispose (object);
+}
+
+static void
+gtk_list_item_manager_finalize (GObject *object)
+{
+  GtkListItemManager *self = GTK_LIST_ITEM_MANAGER (object);
+
+  gtk_rb_tree_unref (self->items);
+  g_ptr_array_unref (self->spare);
+
+  G_OBJECT_CLASS (gtk_list_item_manager_parent_class)->finalize (object);
+}
+
+static void
+gtk_list_item_manager_class_init (GtkListItemManagerClass *klass)
+{
+  GObjectClass *object_class = G_OBJECT_CLASS (klass);
+
+  object_class->dispose = gtk_list_item_manager_dispose;
+  object_class->finalize = gtk_list_item_manager_finalize;
+}
+
+static void
+gtk_list_item_manager_init (GtkListItemManager *self)
+{
+  self->spare = g_ptr_array_new ();
+}
+
+/**
+ * gtk_list_item_manager_new_for_size:
+ * @widget: the list widget the list items are added to
+ * @item_css_name: CSS name of the list items
+ * @element_size: size of the nodes, must start with a #GtkListItemManagerItem
+ * @augment_size: size of the augments, must start with a
+ *     #GtkListItemManagerItemAugment
+ * @augment_func: the function for the augments, it must call
+ *     gtk_list_item_manager_augment_node()
+ *
+ * Creates a new list item manager for @widget.
+ *
+ * Returns: a new #GtkListItemManager
+ */
+GtkListItemManager *
+gtk_list_item_manager_new_for_size (GtkWidget            *widget,
+                                    const char           *item_css_name,
+                                    gsize                 element_size,
+                                    gsize                 augment_size,
+                                    GtkRbTreeAugmentFunc  augment_func)
+{
+  GtkListItemManager *self;
+
+  g_return_val_if_fail (GTK_IS_WIDGET (widget), NULL);
+  g_return_val_if_fail (element_size >= sizeof (GtkListItemManagerItem), NULL);
+  g_return_val_if_fail (augment_size >= sizeof (GtkListItemManagerItemAugment), NULL);
+
+  self = g_object_new (GTK_TYPE_LIST_ITEM_MANAGER, NULL);
+
+  self->widget = widget;
+  self->item_css_name = g_intern_string (item_css_name);
+  self->items = gtk_rb_tree_new_for_size (element_size,
+                                          augment_size,
+                                          augment_func,
+                                          NULL, NULL);
+
+  return self;
+}
+
+void
+gtk_list_item_manager_set_factory (GtkListItemManager *self,
+                                   GtkListItemFactory *factory)
+{
+  g_return_if_fail (GTK_IS_LIST_ITEM_MANAGER (self));
+  g_return_if_fail (factory == NULL || GTK_IS_LIST_ITEM_FACTORY (factory));
+
+  if (self->factory == factory)
+    return;
+
+  /* The list items were set up by the old factory */
+  if (self->factory)
+    {
+      gtk_list_item_manager_release_all (self);
+      gtk_list_item_manager_clear_spare (self);
+    }
+
+  g_set_object (&self->factory, factory);
+
+  gtk_widget_queue_resize (self->widget);
+}
+
+GtkListItemFactory *
+gtk_list_item_manager_get_factory (GtkListItemManager *self)
+{
+  g_return_val_if_fail (GTK_IS_LIST_ITEM_MANAGER (self), NULL);
+
+  return self->factory;
+}
+
+void
+gtk_list_item_manager_set_model (GtkListItemManager *self,
+                                 GListModel         *model)
+{
+  g_return_if_fail (GTK_IS_LIST_ITEM_MANAGER (self));
+  g_return_if_fail (model == NULL || G_IS_LIST_MODEL (model));
+
+  if (self->model == model)
+    return;
+
+  /* The list items stay around to be reused for the new model */
+  gtk_list_item_manager_clear_model (self);
+
+  if (model)
+    {
+      guint n_items;
+
+      self->model = g_object_ref (model);
+      g_signal_connect (model,
+                        "items-changed",
+                        G_CALLBACK (gtk_list_item_manager_items_changed_cb),
+                        self);
+
+      n_items = g_list_model_get_n_items (model);
+      if (n_items > 0)
+        {
+          GtkListItemManagerItem *item = gtk_rb_tree_insert_before (self->items, NULL);
+          item->n_items = n_items;
+        }
+    }
+  else if (self->factory)
+    {
+      gtk_list_item_manager_clear_spare (self);
+    }
+
+  gtk_widget_queue_resize (self->widget);
+}
+
+GListModel *
+gtk_list_item_manager_get_model (GtkListItemManager *self)
+{
+  g_return_val_if_fail (GTK_IS_LIST_ITEM_MANAGER (self), NULL);
+
+  return self->model;
+}
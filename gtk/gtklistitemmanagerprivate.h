@@ -0,0 +1,87 @@
+/* GTK - The GIMP Toolkit
+ * Copyright (C) 2018 Red Hat, Inc.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef __GTK_LIST_ITEM_MANAGER_PRIVATE_H__
+#define __GTK_LIST_ITEM_MANAGER_PRIVATE_H__
+
+#include "gtklistitemfactoryprivate.h"
+#include "gtkrbtreeprivate.h"
+#include "gtkwidget.h"
+
+G_BEGIN_DECLS
+
+#define GTK_TYPE_LIST_ITEM_MANAGER (gtk_list_item_manager_get_type ())
+
+G_DECLARE_FINAL_TYPE (GtkListItemManager, gtk_list_item_manager, GTK, LIST_ITEM_MANAGER, GObject)
+
+typedef struct _GtkListItemManagerItem GtkListItemManagerItem;
+typedef struct _GtkListItemManagerItemAugment GtkListItemManagerItemAugment;
+
+/* Every node of the tree is either a single item displayed by
+ * @widget or a run of @n_items items without widgets.
+ * Widgets embed this as the first member of their own node struct.
+ */
+struct _GtkListItemManagerItem
+{
+  GtkWidget *widget;
+  guint n_items;
+};
+
+struct _GtkListItemManagerItemAugment
+{
+  guint n_items;
+};
+
+GtkListItemManager *    gtk_list_item_manager_new_for_size      (GtkWidget              *widget,
+                                                                 const char             *item_css_name,
+                                                                 gsize                   element_size,
+                                                                 gsize                   augment_size,
+                                                                 GtkRbTreeAugmentFunc    augment_func);
+#define gtk_list_item_manager_new(widget, item_css_name, type, augment_type, augment_func) \
+  gtk_list_item_manager_new_for_size (widget, item_css_name, sizeof (type), sizeof (augment_type), (augment_func))
+
+void                    gtk_list_item_manager_augment_node      (GtkRbTree              *tree,
+                                                                 gpointer                node_augment,
+                                                                 gpointer                node,
+                                                                 gpointer                left,
+                                                                 gpointer                right);
+
+gpointer                gtk_list_item_manager_get_root          (GtkListItemManager     *self);
+gpointer                gtk_list_item_manager_get_first         (GtkListItemManager     *self);
+gpointer                gtk_list_item_manager_get_nth           (GtkListItemManager     *self,
+                                                                 guint                   position,
+                                                                 guint                  *offset);
+guint                   gtk_list_item_manager_get_item_position (GtkListItemManager     *self,
+                                                                 gpointer                item);
+gpointer                gtk_list_item_manager_get_item_augment  (GtkListItemManager     *self,
+                                                                 gpointer                item);
+
+void                    gtk_list_item_manager_set_factory       (GtkListItemManager     *self,
+                                                                 GtkListItemFactory     *factory);
+GtkListItemFactory *    gtk_list_item_manager_get_factory       (GtkListItemManager     *self);
+void                    gtk_list_item_manager_set_model         (GtkListItemManager     *self,
+                                                                 GListModel             *model);
+GListModel *            gtk_list_item_manager_get_model         (GtkListItemManager     *self);
+guint                   gtk_list_item_manager_get_n_items       (GtkListItemManager     *self);
+
+void                    gtk_list_item_manager_set_visible_range (GtkListItemManager     *self,
+                                                                 guint                   position,
+                                                                 guint                   n_items);
+
+G_END_DECLS
+
+#endif /* __GTK_LIST_ITEM_MANAGER_PRIVATE_H__ */
@@ -27,6 +27,7 @@
 #include "gtkintl.h"
 #include "gtkbuildable.h"
 #include "gtkbuilderprivate.h"
+#include "gtktreeprivate.h"
 
 
 /**
@@ -2307,6 +2308,118 @@ gtk_list_store_insert_with_valuesv (GtkListStore *list_store,
   gtk_tree_path_free (path);
 }
 
+/**
+ * gtk_list_store_insert_many_with_valuesv:
+ * @list_store: A #GtkListStore
+ * @position: position to insert the first new row, or -1 for last
+ * @n_rows: the number of rows to insert
+ * @columns: (array length=n_values): an array of column numbers
+ * @values: (array): an array of @n_rows * @n_values GValues, containing
+ *     the values of the first row, followed by those of the second row
+ *     and so on
+ * @n_values: the length of the @columns array
+ *
+ * Inserts @n_rows rows starting at @position and sets the values of
+ * each row to the corresponding @n_values entries of @values.
+ *
+ * This has the same effect as calling gtk_list_store_insert_with_valuesv()
+ * for every row, but it avoids looking up the insertion point and the
+ * path of every new row, which makes loading large amounts of data
+ * considerably faster. To replace the contents of @list_store, call
+ * gtk_list_store_clear() first.
+ *
+ * If @list_store is not sorted and only views like #GtkTreeView are
+ * connected to it, they are told about all new rows in one step.
+ * Otherwise a #GtkTreeModel::row-inserted signal is emitted for each
+ * row, in order. Handlers of these signals must not modify @list_store.
+ */
+void
+gtk_list_store_insert_many_with_valuesv (GtkListStore *list_store,
+                                         gint          position,
+                                         gint          n_rows,
+                                         gint         *columns,
+                                         GValue       *values,
+                                         gint          n_values)
+{
+  GtkListStorePrivate *priv;
+  GtkTreePath *path;
+  GSequence *seq;
+  GSequenceIter *ptr;
+  GtkTreeIter iter, first = { 0, };
+  gint length, i;
+  gboolean changed = FALSE;
+  gboolean maybe_need_sort = FALSE;
+  gboolean sorted, at_once;
+
+  g_return_if_fail (GTK_IS_LIST_STORE (list_store));
+  g_return_if_fail (n_rows >= 0);
+  g_return_if_fail (n_values >= 0);
+
+  if (n_rows == 0)
+    return;
+
+  priv = list_store->priv;
+
+  priv->columns_dirty = TRUE;
+
+  seq = priv->seq;
+
+  length = g_sequence_get_length (seq);
+  if (position > length || position < 0)
+    position = length;
+
+  sorted = GTK_LIST_STORE_IS_SORTED (list_store);
+
+  /* Rows of a sorted store are announced where they end up, one by one */
+  at_once = !sorted && _gtk_tree_model_can_insert_rows_at_once (GTK_TREE_MODEL (list_store));
+
+  /* All rows go in front of the row that is at @position now */
+  ptr = g_sequence_get_iter_at_pos (seq, position);
+  path = gtk_tree_path_new_from_indices (position, -1);
+
+  for (i = 0; i < n_rows; i++)
+    {
+      iter.stamp = priv->stamp;
+      iter.user_data = g_sequence_insert_before (ptr, NULL);
+
+      priv->length++;
+
+      gtk_list_store_set_vector_internal (list_store, &iter,
+                                          &changed, &maybe_need_sort,
+                                          columns, values + i * n_values, n_values);
+
+      if (at_once)
+        {
+          if (i == 0)
+            first = iter;
+          continue;
+        }
+
+      if (maybe_need_sort && sorted)
+        {
+          GtkTreePath *sorted_path;
+
+          g_sequence_sort_changed_iter (iter.user_data,
+                                        gtk_list_store_compare_func,
+                                        list_store);
+
+          sorted_path = gtk_list_store_get_path (GTK_TREE_MODEL (list_store), &iter);
+          gtk_tree_model_row_inserted (GTK_TREE_MODEL (list_store), sorted_path, &iter);
+          gtk_tree_path_free (sorted_path);
+        }
+      else
+        {
+          gtk_tree_model_row_inserted (GTK_TREE_MODEL (list_store), path, &iter);
+          gtk_tree_path_next (path);
+        }
+    }
+
+  if (at_once)
+    _gtk_tree_model_rows_inserted (GTK_TREE_MODEL (list_store), path, &first, n_rows);
+
+  gtk_tree_path_free (path);
+}
+
 /* GtkBuildable custom tag implementation
  *
  * <columns>
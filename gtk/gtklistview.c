@@ -0,0 +1,800 @@
+/* GTK - The GIMP Toolkit
+ * Copyright (C) 2018 Red Hat, Inc.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "config.h"
+
+#include "gtklistview.h"
+
+#include "gtkadjustment.h"
+#include "gtkintl.h"
+#include "gtklistitemfactoryprivate.h"
+#include "gtklistitemmanagerprivate.h"
+#include "gtkprivate.h"
+#include "gtkscrollable.h"
+#include "gtksnapshot.h"
+#include "gtkwidgetprivate.h"
+
+/**
+ * SECTION:gtklistview
+ * @title: GtkListView
+ * @short_description: A widget for displaying lists
+ * @see_also: #GListModel, #GtkListItem
+ *
+ * GtkListView is a widget to present a view into a large dynamic list
+ * of items.
+ *
+ * Unlike #GtkListBox, it does not create a widget for every item of its
+ * model. It only creates #GtkListItem widgets for the items that are
+ * visible and a few around them, and reuses them for other items when
+ * the list is scrolled. The widgets are created and updated with the
+ * functions passed to gtk_list_view_set_functions().
+ *
+ * The size of items that have not been displayed yet is estimated from
+ * the ones that have been, so finding the items for a scroll position
+ * takes logarithmic time, no matter how many items the model contains.
+ *
+ * GtkListView implements #GtkScrollable and is meant to be put into a
+ * #GtkScrolledWindow.
+ *
+ * # CSS nodes
+ *
+ * GtkListView has a single CSS node with name listview. Each list item
+ * uses a single CSS node with name row.
+ */
+
+/* Extra space above and below the visible area that is filled with
+ * list items, as a fraction of the page size, so that scrolling a bit
+ * doesn't need to bind new items right away. */
+#define GTK_LIST_VIEW_EXTRA_PAGE 0.5
+
+typedef struct _ListRow ListRow;
+typedef struct _ListRowAugment ListRowAugment;
+
+struct _GtkListView
+{
+  GtkWidget parent_instance;
+
+  GtkListItemManager *item_manager;
+  GtkAdjustment *adjustment[2];
+  GtkScrollablePolicy scroll_policy[2];
+
+  /* row height to use if no rows have been measured */
+  int fallback_row_height;
+};
+
+struct _GtkListViewClass
+{
+  GtkWidgetClass parent_class;
+};
+
+struct _ListRow
+{
+  GtkListItemManagerItem parent;
+  int height; /* only valid while the row has a widget */
+};
+
+struct _ListRowAugment
+{
+  GtkListItemManagerItemAugment parent;
+  int height; /* sum of heights of rows with widgets */
+  guint n_unknown; /* number of rows without widgets */
+};
+
+enum
+{
+  PROP_0,
+  PROP_HADJUSTMENT,
+  PROP_HSCROLL_POLICY,
+  PROP_VADJUSTMENT,
+  PROP_VSCROLL_POLICY,
+  PROP_MODEL,
+
+  N_PROPS
+};
+
+G_DEFINE_TYPE_WITH_CODE (GtkListView, gtk_list_view, GTK_TYPE_WIDGET,
+                         G_IMPLEMENT_INTERFACE (GTK_TYPE_SCROLLABLE, NULL))
+
+static GParamSpec *properties[N_PROPS] = { NULL, };
+
+static void
+list_row_augment (GtkRbTree *tree,
+                  gpointer   node_augment,
+                  gpointer   node,
+                  gpointer   left,
+                  gpointer   right)
+{
+  ListRow *row = node;
+  ListRowAugment *aug = node_augment;
+
+  gtk_list_item_manager_augment_node (tree, node_augment, node, left, right);
+
+  if (row->parent.widget)
+    {
+      aug->height = row->height;
+      aug->n_unknown = 0;
+    }
+  else
+    {
+      aug->height = 0;
+      aug->n_unknown = row->parent.n_items;
+    }
+
+  if (left)
+    {
+      ListRowAugment *left_aug = gtk_rb_tree_get_augment (tree, left);
+
+      aug->height += left_aug->height;
+      aug->n_unknown += left_aug->n_unknown;
+    }
+
+  if (right)
+    {
+      ListRowAugment *right_aug = gtk_rb_tree_get_augment (tree, right);
+
+      aug->height += right_aug->height;
+      aug->n_unknown += right_aug->n_unknown;
+    }
+}
+
+/* The height of rows without widgets: the average height of the rows
+ * that have widgets */
+static int
+gtk_list_view_get_estimated_row_height (GtkListView *self)
+{
+  ListRow *root;
+  ListRowAugment *aug;
+  guint n_known;
+
+  root = gtk_list_item_manager_get_root (self->item_manager);
+  if (root == NULL)
+    return self->fallback_row_height;
+
+  aug = gtk_list_item_manager_get_item_augment (self->item_manager, root);
+  n_known = aug->parent.n_items - aug->n_unknown;
+  if (n_known == 0)
+    return self->fallback_row_height;
+
+  return MAX (1, aug->height / n_known);
+}
+
+static int
+list_row_augment_get_height (ListRowAugment *aug,
+                             int             row_height)
+{
+  return aug->height + aug->n_unknown * row_height;
+}
+
+static int
+list_row_get_height (ListRow *row,
+                     int      row_height)
+{
+  if (row->parent.widget)
+    return row->height;
+  else
+    return row->parent.n_items * row_height;
+}
+
+static int
+gtk_list_view_get_list_height (GtkListView *self,
+                               int          row_height)
+{
+  ListRow *root;
+
+  root = gtk_list_item_manager_get_root (self->item_manager);
+  if (root == NULL)
+    return 0;
+
+  return list_row_augment_get_height (gtk_list_item_manager_get_item_augment (self->item_manager, root),
+                                      row_height);
+}
+
+/* Returns the position of the item at @y, clamped to the items
+ * of the list */
+static guint
+gtk_list_view_get_position_at_y (GtkListView *self,
+                                 int          y,
+                                 int          row_height)
+{
+  ListRow *row, *tmp;
+  guint pos;
+
+  if (y < 0)
+    return 0;
+
+  pos = 0;
+  row = gtk_list_item_manager_get_root (self->item_manager);
+  while (row)
+    {
+      int height;
+
+      tmp = gtk_rb_tree_node_get_left (row);
+      if (tmp)
+        {
+          ListRowAugment *aug = gtk_list_item_manager_get_item_augment (self->item_manager, tmp);
+          height = list_row_augment_get_height (aug, row_height);
+          if (y < height)
+            {
+              row = tmp;
+              continue;
+            }
+          y -= height;
+          pos += aug->parent.n_items;
+        }
+
+      height = list_row_get_height (row, row_height);
+      if (y < height)
+        {
+          if (row->parent.widget == NULL)
+            pos += y / row_height;
+          return pos;
+        }
+      y -= height;
+      pos += row->parent.n_items;
+
+      row = gtk_rb_tree_node_get_right (row);
+    }
+
+  return pos > 0 ? pos - 1 : 0;
+}
+
+static int
+gtk_list_view_get_row_y (GtkListView *self,
+                         ListRow     *row,
+                         int          row_height)
+{
+  ListRow *parent, *left;
+  int y;
+
+  left = gtk_rb_tree_node_get_left (row);
+  if (left)
+    y = list_row_augment_get_height (gtk_list_item_manager_get_item_augment (self->item_manager, left), row_height);
+  else
+    y = 0;
+
+  for (parent = gtk_rb_tree_node_get_parent (row);
+       parent != NULL;
+       parent = gtk_rb_tree_node_get_parent (row))
+    {
+      if (gtk_rb_tree_node_get_right (parent) == row)
+        {
+          left = gtk_rb_tree_node_get_left (parent);
+          if (left)
+            y += list_row_augment_get_height (gtk_list_item_manager_get_item_augment (self->item_manager, left), row_height);
+          y += list_row_get_height (parent, row_height);
+        }
+
+      row = parent;
+    }
+
+  return y;
+}
+
+/* Measures the rows that have widgets for the given width */
+static void
+gtk_list_view_update_row_heights (GtkListView *self,
+                                  int          width)
+{
+  ListRow *row;
+  int height;
+
+  for (row = gtk_list_item_manager_get_first (self->item_manager);
+       row != NULL;
+       row = gtk_rb_tree_node_get_next (row))
+    {
+      if (row->parent.widget == NULL)
+        continue;
+
+      gtk_widget_measure (row->parent.widget,
+                          GTK_ORIENTATION_VERTICAL,
+                          width,
+                          NULL, &height,
+                          NULL, NULL);
+      if (row->height != height)
+        {
+          row->height = height;
+          gtk_rb_tree_node_mark_dirty (row);
+        }
+    }
+}
+
+static void
+gtk_list_view_measure_across (GtkWidget *widget,
+                              int       *minimum,
+                              int       *natural)
+{
+  GtkListView *self = GTK_LIST_VIEW (widget);
+  ListRow *row;
+  int min, nat, child_min, child_nat;
+
+  min = 0;
+  nat = 0;
+
+  for (row = gtk_list_item_manager_get_first (self->item_manager);
+       row != NULL;
+       row = gtk_rb_tree_node_get_next (row))
+    {
+      if (row->parent.widget == NULL)
+        continue;
+
+      gtk_widget_measure (row->parent.widget,
+                          GTK_ORIENTATION_HORIZONTAL,
+                          -1,
+                          &child_min, &child_nat,
+                          NULL, NULL);
+      min = MAX (min, child_min);
+      nat = MAX (nat, child_nat);
+    }
+
+  *minimum = min;
+  *natural = nat;
+}
+
+static void
+gtk_list_view_measure_list (GtkWidget *widget,
+                            int        for_width,
+                            int       *minimum,
+                            int       *natural)
+{
+  GtkListView *self = GTK_LIST_VIEW (widget);
+  ListRow *row;
+  ListRowAugment *aug;
+  int min, nat, child_min, child_nat, row_height;
+
+  row = gtk_list_item_manager_get_root (self->item_manager);
+  if (row == NULL)
+    {
+      *minimum = 0;
+      *natural = 0;
+      return;
+    }
+
+  min = 0;
+  nat = 0;
+
+  for (row = gtk_list_item_manager_get_first (self->item_manager);
+       row != NULL;
+       row = gtk_rb_tree_node_get_next (row))
+    {
+      if (row->parent.widget == NULL)
+        continue;
+
+      gtk_widget_measure (row->parent.widget,
+                          GTK_ORIENTATION_VERTICAL,
+                          for_width,
+                          &child_min, &child_nat,
+                          NULL, NULL);
+      min += child_min;
+      nat += child_nat;
+    }
+
+  row_height = gtk_list_view_get_estimated_row_height (self);
+  aug = gtk_list_item_manager_get_item_augment (self->item_manager,
+                                                gtk_list_item_manager_get_root (self->item_manager));
+
+  *minimum = min + aug->n_unknown * row_height;
+  *natural = nat + aug->n_unknown * row_height;
+}
+
+static void
+gtk_list_view_measure (GtkWidget      *widget,
+                       GtkOrientation  orientation,
+                       int             for_size,
+                       int            *minimum,
+                       int            *natural,
+                       int            *minimum_baseline,
+                       int            *natural_baseline)
+{
+  if (orientation == GTK_ORIENTATION_HORIZONTAL)
+    gtk_list_view_measure_across (widget, minimum, natural);
+  else
+    gtk_list_view_measure_list (widget, for_size, minimum, natural);
+}
+
+static void
+gtk_list_view_update_adjustment (GtkListView    *self,
+                                 GtkOrientation  orientation,
+                                 int             size,
+                                 int             page_size)
+{
+  gtk_adjustment_configure (self->adjustment[orientation],
+                            gtk_adjustment_get_value (self->adjustment[orientation]),
+                            0,
+                            MAX (size, page_size),
+                            page_size * 0.1,
+                            page_size * 0.9,
+                            page_size);
+}
+
+static void
+gtk_list_view_size_allocate (GtkWidget *widget,
+                             int        width,
+                             int        height,
+                             int        baseline)
+{
+  GtkListView *self = GTK_LIST_VIEW (widget);
+  ListRow *row;
+  int min, nat, row_width, row_height, extra, x, y;
+  guint start, end;
+
+  g_object_freeze_notify (G_OBJECT (self->adjustment[GTK_ORIENTATION_HORIZONTAL]));
+  g_object_freeze_notify (G_OBJECT (self->adjustment[GTK_ORIENTATION_VERTICAL]));
+
+  /* Make sure there is a row to estimate the size of the others from */
+  if (gtk_list_item_manager_get_n_items (self->item_manager) > 0 &&
+      gtk_list_view_get_estimated_row_height (self) == 0)
+    gtk_list_item_manager_set_visible_range (self->item_manager, 0, 1);
+
+  gtk_list_view_measure_across (widget, &min, &nat);
+  if (self->scroll_policy[GTK_ORIENTATION_HORIZONTAL] == GTK_SCROLL_MINIMUM)
+    row_width = MAX (min, width);
+  else
+    row_width = MAX (nat, width);
+  gtk_list_view_update_adjustment (self, GTK_ORIENTATION_HORIZONTAL, row_width, width);
+
+  /* Find the rows that are visible */
+  gtk_list_view_update_row_heights (self, row_width);
+  row_height = gtk_list_view_get_estimated_row_height (self);
+  gtk_list_view_update_adjustment (self,
+                                   GTK_ORIENTATION_VERTICAL,
+                                   gtk_list_view_get_list_height (self, row_height),
+                                   height);
+
+  y = gtk_adjustment_get_value (self->adjustment[GTK_ORIENTATION_VERTICAL]);
+  extra = height * GTK_LIST_VIEW_EXTRA_PAGE;
+  start = gtk_list_view_get_position_at_y (self, y - extra, row_height);
+  end = gtk_list_view_get_position_at_y (self, y + height + extra, row_height) + 1;
+  gtk_list_item_manager_set_visible_range (self->item_manager, start, end - start);
+
+  /* The new rows change the estimate */
+  gtk_list_view_update_row_heights (self, row_width);
+  row_height = gtk_list_view_get_estimated_row_height (self);
+  if (row_height > 0)
+    self->fallback_row_height = row_height;
+  gtk_list_view_update_adjustment (self,
+                                   GTK_ORIENTATION_VERTICAL,
+                                   gtk_list_view_get_list_height (self, row_height),
+                                   height);
+
+  /* Allocate the rows */
+  x = - gtk_adjustment_get_value (self->adjustment[GTK_ORIENTATION_HORIZONTAL]);
+  row = gtk_list_item_manager_get_nth (self->item_manager, start, NULL);
+  if (row)
+    y = gtk_list_view_get_row_y (self, row, row_height)
+        - gtk_adjustment_get_value (self->adjustment[GTK_ORIENTATION_VERTICAL]);
+  for (; row != NULL && row->parent.widget != NULL; row = gtk_rb_tree_node_get_next (row))
+    {
+      gtk_widget_size_allocate (row->parent.widget,
+                                &(GtkAllocation) {
+                                  x, y,
+                                  row_width, row->height
+                                }, -1);
+      y += row->height;
+    }
+
+  g_object_thaw_notify (G_OBJECT (self->adjustment[GTK_ORIENTATION_HORIZONTAL]));
+  g_object_thaw_notify (G_OBJECT (self->adjustment[GTK_ORIENTATION_VERTICAL]));
+}
+
+static void
+gtk_list_view_snapshot (GtkWidget   *widget,
+                        GtkSnapshot *snapshot)
+{
+  gtk_snapshot_push_clip (snapshot,
+                          &GRAPHENE_RECT_INIT (
+                            0, 0,
+                            gtk_widget_get_width (widget),
+                            gtk_widget_get_height (widget)));
+
+  GTK_WIDGET_CLASS (gtk_list_view_parent_class)->snapshot (widget, snapshot);
+
+  gtk_snapshot_pop (snapshot);
+}
+
+static void
+gtk_list_view_adjustment_value_changed_cb (GtkAdjustment *adjustment,
+                                           GtkListView   *self)
+{
+  gtk_widget_queue_allocate (GTK_WIDGET (self));
+}
+
+static void
+gtk_list_view_clear_adjustment (GtkListView    *self,
+                                GtkOrientation  orientation)
+{
+  if (self->adjustment[orientation] == NULL)
+    return;
+
+  g_signal_handlers_disconnect_by_func (self->adjustment[orientation],
+                                        gtk_list_view_adjustment_value_changed_cb,
+                                        self);
+  g_clear_object (&self->adjustment[orientation]);
+}
+
+static void
+gtk_list_view_set_adjustment (GtkListView    *self,
+                              GtkOrientation  orientation,
+                              GtkAdjustment  *adjustment)
+{
+  if (self->adjustment[orientation] == adjustment && adjustment != NULL)
+    return;
+
+  if (adjustment == NULL)
+    adjustment = gtk_adjustment_new (0.0, 0.0, 0.0, 0.0, 0.0, 0.0);
+  g_object_ref_sink (adjustment);
+
+  gtk_list_view_clear_adjustment (self, orientation);
+
+  self->adjustment[orientation] = adjustment;
+
+  g_signal_connect (adjustment, "value-changed",
+                    G_CALLBACK (gtk_list_view_adjustment_value_changed_cb),
+                    self);
+
+  gtk_widget_queue_allocate (GTK_WIDGET (self));
+}
+
+static void
+gtk_list_view_set_scroll_policy (GtkListView         *self,
+                                 GtkOrientation       orientation,
+                                 GtkScrollablePolicy  scroll_policy)
+{
+  if (self->scroll_policy[orientation] == scroll_policy)
+    return;
+
+  self->scroll_policy[orientation] = scroll_policy;
+  gtk_widget_queue_resize (GTK_WIDGET (self));
+  g_object_notify (G_OBJECT (self),
+                   orientation == GTK_ORIENTATION_HORIZONTAL ? "hscroll-policy" : "vscroll-policy");
+}
+
+static void
+gtk_list_view_get_property (GObject    *object,
+                            guint       property_id,
+                            GValue     *value,
+                            GParamSpec *pspec)
+{
+  GtkListView *self = GTK_LIST_VIEW (object);
+
+  switch (property_id)
+    {
+    case PROP_HADJUSTMENT:
+      g_value_set_object (value, self->adjustment[GTK_ORIENTATION_HORIZONTAL]);
+      break;
+
+    case PROP_HSCROLL_POLICY:
+      g_value_set_enum (value, self->scroll_policy[GTK_ORIENTATION_HORIZONTAL]);
+      break;
+
+    case PROP_MODEL:
+      g_value_set_object (value, gtk_list_item_manager_get_model (self->item_manager));
+      break;
+
+    case PROP_VADJUSTMENT:
+      g_value_set_object (value, self->adjustment[GTK_ORIENTATION_VERTICAL]);
+      break;
+
+    case PROP_VSCROLL_POLICY:
+      g_value_set_enum (value, self->scroll_policy[GTK_ORIENTATION_VERTICAL]);
+      break;
+
+    default:
+      G_OBJECT_WARN_INVALID_PROPERTY_ID (object, property_id, pspec);
+      break;
+    }
+}
+
+static void
+gtk_list_view_set_property (GObject      *object,
+                            guint         property_id,
+                            const GValue *value,
+                            GParamSpec   *pspec)
+{
+  GtkListView *self = GTK_LIST_VIEW (object);
+
+  switch (property_id)
+    {
+    case PROP_HADJUSTMENT:
+      gtk_list_view_set_adjustment (self, GTK_ORIENTATION_HORIZONTAL, g_value_get_object (value));
+      break;
+
+    case PROP_HSCROLL_POLICY:
+      gtk_list_view_set_scroll_policy (self, GTK_ORIENTATION_HORIZONTAL, g_value_get_enum (value));
+      break;
+
+    case PROP_MODEL:
+      gtk_list_view_set_model (self, g_value_get_object (value));
+      break;
+
+    case PROP_VADJUSTMENT:
+      gtk_list_view_set_adjustment (self, GTK_ORIENTATION_VERTICAL, g_value_get_object (value));
+      break;
+
+    case PROP_VSCROLL_POLICY:
+      gtk_list_view_set_scroll_policy (self, GTK_ORIENTATION_VERTICAL, g_value_get_enum (value));
+      break;
+
+    default:
+      G_OBJECT_WARN_INVALID_PROPERTY_ID (object, property_id, pspec);
+      break;
+    }
+}
+
+static void
+gtk_list_view_dispose (GObject *object)
+{
+  GtkListView *self = GTK_LIST_VIEW (object);
+
+  /* This removes the list items */
+  gtk_list_item_manager_set_model (self->item_manager, NULL);
+  gtk_list_item_manager_set_factory (self->item_manager, NULL);
+
+  gtk_list_view_clear_adjustment (self, GTK_ORIENTATION_HORIZONTAL);
+  gtk_list_view_clear_adjustment (self, GTK_ORIENTATION_VERTICAL);
+
+  G_OBJECT_CLASS (gtk_list_view_parent_class)->dispose (object);
+}
+
+static void
+gtk_list_view_finalize (GObject *object)
+{
+  GtkListView *self = GTK_LIST_VIEW (object);
+
+  g_object_unref (self->item_manager);
+
+  G_OBJECT_CLASS (gtk_list_view_parent_class)->finalize (object);
+}
+
+static void
+gtk_list_view_class_init (GtkListViewClass *klass)
+{
+  GtkWidgetClass *widget_class = GTK_WIDGET_CLASS (klass);
+  GObjectClass *gobject_class = G_OBJECT_CLASS (klass);
+
+  widget_class->measure = gtk_list_view_measure;
+  widget_class->size_allocate = gtk_list_view_size_allocate;
+  widget_class->snapshot = gtk_list_view_snapshot;
+
+  gobject_class->dispose = gtk_list_view_dispose;
+  gobject_class->finalize = gtk_list_view_finalize;
+  gobject_class->get_property = gtk_list_view_get_property;
+  gobject_class->set_property = gtk_list_view_set_property;
+
+  /* GtkScrollable implementation */
+  g_object_class_override_property (gobject_class, PROP_HADJUSTMENT, "hadjustment");
+  g_object_class_override_property (gobject_class, PROP_HSCROLL_POLICY, "hscroll-policy");
+  g_object_class_override_property (gobject_class, PROP_VADJUSTMENT, "vadjustment");
+  g_object_class_override_property (gobject_class, PROP_VSCROLL_POLICY, "vscroll-policy");
+
+  /**
+   * GtkListView:model:
+   *
+   * Model for the items displayed
+   */
+  properties[PROP_MODEL] =
+    g_param_spec_object ("model",
+                         P_("Model"),
+                         P_("Model for the items displayed"),
+                         G_TYPE_LIST_MODEL,
+                         GTK_PARAM_READWRITE | G_PARAM_EXPLICIT_NOTIFY);
+
+  g_object_class_install_property (gobject_class, PROP_MODEL, properties[PROP_MODEL]);
+
+  gtk_widget_class_set_accessible_role (widget_class, ATK_ROLE_LIST);
+  gtk_widget_class_set_css_name (widget_class, I_("listview"));
+}
+
+static void
+gtk_list_view_init (GtkListView *self)
+{
+  self->item_manager = gtk_list_item_manager_new (GTK_WIDGET (self), "row", ListRow, ListRowAugment, list_row_augment);
+
+  gtk_widget_set_has_surface (GTK_WIDGET (self), FALSE);
+
+  gtk_list_view_set_adjustment (self, GTK_ORIENTATION_HORIZONTAL, NULL);
+  gtk_list_view_set_adjustment (self, GTK_ORIENTATION_VERTICAL, NULL);
+}
+
+/**
+ * gtk_list_view_new:
+ *
+ * Creates a new empty #GtkListView.
+ *
+ * You most likely want to call gtk_list_view_set_functions() to
+ * set up the way items are displayed and gtk_list_view_set_model()
+ * to set a model.
+ *
+ * Returns: a new #GtkListView
+ **/
+GtkWidget *
+gtk_list_view_new (void)
+{
+  return g_object_new (GTK_TYPE_LIST_VIEW, NULL);
+}
+
+/**
+ * gtk_list_view_get_model:
+ * @self: a #GtkListView
+ *
+ * Gets the model that's currently used to read the items displayed.
+ *
+ * Returns: (nullable) (transfer none): The model in use
+ **/
+GListModel *
+gtk_list_view_get_model (GtkListView *self)
+{
+  g_return_val_if_fail (GTK_IS_LIST_VIEW (self), NULL);
+
+  return gtk_list_item_manager_get_model (self->item_manager);
+}
+
+/**
+ * gtk_list_view_set_model:
+ * @self: a #GtkListView
+ * @model: (allow-none) (transfer none): the model to use or %NULL for none
+ *
+ * Sets the #GListModel to use.
+ **/
+void
+gtk_list_view_set_model (GtkListView *self,
+                         GListModel  *model)
+{
+  g_return_if_fail (GTK_IS_LIST_VIEW (self));
+  g_return_if_fail (model == NULL || G_IS_LIST_MODEL (model));
+
+  if (gtk_list_item_manager_get_model (self->item_manager) == model)
+    return;
+
+  gtk_list_item_manager_set_model (self->item_manager, model);
+
+  g_object_notify_by_pspec (G_OBJECT (self), properties[PROP_MODEL]);
+}
+
+/**
+ * gtk_list_view_set_functions:
+ * @self: a #GtkListView
+ * @setup_func: (nullable): function to set up list items
+ * @bind_func: (nullable): function to bind items to list items
+ * @user_data: (closure): user data to pass to the functions
+ * @user_destroy: destroy notifier for @user_data
+ *
+ * Sets the functions used to create and update the #GtkListItem
+ * widgets that display the items of the model.
+ *
+ * @setup_func is called once for every list item that is created and
+ * should add the widgets displaying the items to it. @bind_func is
+ * called whenever a list item is used for a different item and should
+ * update these widgets. Only as many list items as are needed to fill
+ * the visible area are created.
+ **/
+void
+gtk_list_view_set_functions (GtkListView          *self,
+                             GtkListItemSetupFunc  setup_func,
+                             GtkListItemBindFunc   bind_func,
+                             gpointer              user_data,
+                             GDestroyNotify        user_destroy)
+{
+  GtkListItemFactory *factory;
+
+  g_return_if_fail (GTK_IS_LIST_VIEW (self));
+  g_return_if_fail (setup_func || bind_func);
+  g_return_if_fail (user_data != NULL || user_destroy == NULL);
+
+  factory = gtk_list_item_factory_new (setup_func, bind_func, user_data, user_destroy);
+  gtk_list_item_manager_set_factory (self->item_manager, factory);
+  g_object_unref (factory);
+}
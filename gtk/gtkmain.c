@@ -104,6 +104,10 @@
 #include <unistd.h>
 #endif
 #include <sys/types.h>          /* For uid_t, gid_t */
+#ifdef HAVE_POSIX_FADVISE
+#include <fcntl.h>
+#include <glib/gstdio.h>
+#endif
 
 #ifdef G_OS_WIN32
 #define STRICT
@@ -134,6 +138,10 @@
 
 #include "a11y/gtkaccessibility.h"
 
+#ifdef HAVE_PANGOFT
+#include <pango/pangofc-fontmap.h>
+#endif
+
 static GtkWindowGroup *gtk_main_get_window_group (GtkWidget   *widget);
 
 static guint gtk_main_loop_level = 0;
@@ -636,10 +644,128 @@ gettext_initialization (void)
 #endif
 }
 
+/* Pulls a file into the page cache, so that mapping or reading it
+ * later does not have to wait for the disk */
+static void
+prefetch_file (const char *path)
+{
+#ifdef HAVE_POSIX_FADVISE
+  int fd;
+
+  fd = g_open (path, O_RDONLY, 0);
+  if (fd < 0)
+    return;
+
+  posix_fadvise (fd, 0, 0, POSIX_FADV_WILLNEED);
+
+  close (fd);
+#else
+  GMappedFile *file;
+  const char *contents;
+  gsize i, length;
+  /* volatile, or the compiler drops the loop */
+  volatile guint sum = 0;
+
+  file = g_mapped_file_new (path, FALSE, NULL);
+  if (file == NULL)
+    return;
+
+  contents = g_mapped_file_get_contents (file);
+  length = g_mapped_file_get_length (file);
+  for (i = 0; i < length; i += 4096)
+    sum += contents[i];
+
+  g_mapped_file_unref (file);
+#endif
+}
+
+static gpointer
+prefetch_thread (gpointer data)
+{
+  char **icon_themes = data;
+  const char * const *system_dirs;
+  GPtrArray *bases;
+  guint i, j;
+
+#ifdef HAVE_PANGOFT
+  /* Loads the configuration and the font caches, which is what makes
+   * laying out the first text so slow */
+  FcInit ();
+#endif
+
+  /* Reads loaders.cache */
+  g_slist_free (gdk_pixbuf_get_formats ());
+
+  bases = g_ptr_array_new_with_free_func (g_free);
+  g_ptr_array_add (bases, g_build_filename (g_get_user_data_dir (), "icons", NULL));
+  g_ptr_array_add (bases, g_build_filename (g_get_home_dir (), ".icons", NULL));
+  system_dirs = g_get_system_data_dirs ();
+  for (i = 0; system_dirs[i]; i++)
+    g_ptr_array_add (bases, g_build_filename (system_dirs[i], "icons", NULL));
+
+  for (i = 0; i < bases->len; i++)
+    {
+      for (j = 0; icon_themes[j]; j++)
+        {
+          char *path;
+
+          path = g_build_filename (g_ptr_array_index (bases, i), icon_themes[j], "index.theme", NULL);
+          prefetch_file (path);
+          g_free (path);
+
+          path = g_build_filename (g_ptr_array_index (bases, i), icon_themes[j], "icon-theme.cache", NULL);
+          prefetch_file (path);
+          g_free (path);
+        }
+    }
+
+  g_ptr_array_unref (bases);
+  g_strfreev (icon_themes);
+
+  return NULL;
+}
+
+/* The first window needs fonts, image loaders and icons, and getting
+ * those ready is mostly spent waiting for the disk. Have a thread do
+ * that while the application is still busy creating its widgets. It
+ * only fills caches that are shared with the main thread, so there is
+ * nothing to wait for: whatever it didn't get to in time, the main
+ * thread does like it always did.
+ */
+static void
+start_prefetch (GdkDisplay *display)
+{
+  static gboolean started = FALSE;
+  GtkSettings *settings;
+  char **icon_themes;
+  char *icon_theme_name;
+  GThread *thread;
+
+  /* The caches are process-wide, once is enough */
+  if (started)
+    return;
+  started = TRUE;
+
+  settings = gtk_settings_get_for_display (display);
+  g_object_get (settings, "gtk-icon-theme-name", &icon_theme_name, NULL);
+
+  icon_themes = g_new0 (char *, 3);
+  icon_themes[0] = g_strdup ("hicolor");
+  icon_themes[1] = icon_theme_name;
+
+  thread = g_thread_try_new ("gtk-prefetch", prefetch_thread, icon_themes, NULL);
+  if (thread)
+    g_thread_unref (thread);
+  else
+    g_strfreev (icon_themes);
+}
+
 static void
 default_display_notify_cb (GdkDisplayManager *dm)
 {
   debug_flags[0].display = gdk_display_get_default ();
+  if (debug_flags[0].display)
+    start_prefetch (debug_flags[0].display);
 #ifdef G_OS_UNIX
   gtk_print_backends_init ();
 #endif
@@ -2449,25 +2575,23 @@ propagate_event_down (GtkWidget *widget,
                       GtkWidget *topmost)
 {
   gint handled_event = FALSE;
-  GList *widgets = NULL;
-  GList *l;
-
-  widgets = g_list_prepend (widgets, g_object_ref (widget));
-  while (widget && widget != topmost)
-    {
-      widget = gtk_widget_get_parent (widget);
-      if (!widget)
-        break;
+  GtkWidget **widgets;
+  GtkWidget *w;
+  int i, n_widgets;
 
-      widgets = g_list_prepend (widgets, g_object_ref (widget));
+  /* Collect the chain from topmost to widget on the stack, this
+   * runs for every event that gets to propagate */
+  n_widgets = 1;
+  for (w = widget; w != topmost && _gtk_widget_get_parent (w); w = _gtk_widget_get_parent (w))
+    n_widgets++;
 
-      if (widget == topmost)
-        break;
-    }
+  widgets = g_newa (GtkWidget *, n_widgets);
+  for (i = n_widgets - 1, w = widget; i >= 0; i--, w = _gtk_widget_get_parent (w))
+    widgets[i] = g_object_ref (w);
 
-  for (l = widgets; l && !handled_event; l = l->next)
+  for (i = 0; i < n_widgets && !handled_event; i++)
     {
-      widget = (GtkWidget *)l->data;
+      widget = widgets[i];
 
       if (!gtk_widget_is_sensitive (widget))
         {
@@ -2482,7 +2606,9 @@ propagate_event_down (GtkWidget *widget,
       else
         handled_event = _gtk_widget_captured_event (widget, event);
     }
-  g_list_free_full (widgets, (GDestroyNotify)g_object_unref);
+
+  for (i = 0; i < n_widgets; i++)
+    g_object_unref (widgets[i]);
 
   return handled_event;
 }
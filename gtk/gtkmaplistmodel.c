@@ -39,13 +39,22 @@
  *
  * #GtkMapListModel will attempt to discard the mapped objects as soon as they are no
  * longer needed and recreate them if necessary.
+ *
+ * If creating mapped objects is expensive, gtk_map_list_model_set_cache_size()
+ * can be used to keep the most recently requested objects alive even when
+ * nobody else references them anymore. In that case,
+ * gtk_map_list_model_set_prefetch() allows mapping the items surrounding a
+ * requested position ahead of time and gtk_map_list_model_set_batch_map_func()
+ * allows mapping all these items with a single call.
  */
 
 enum {
   PROP_0,
+  PROP_CACHE_SIZE,
   PROP_HAS_MAP,
   PROP_ITEM_TYPE,
   PROP_MODEL,
+  PROP_PREFETCH,
   NUM_PROPERTIES
 };
 
@@ -56,6 +65,7 @@ struct _MapNode
 {
   guint n_items;
   gpointer item; /* can only be set when n_items == 1 */
+  GList lru_link; /* data is set while the node holds a reference to item */
 };
 
 struct _MapAugment
@@ -72,8 +82,14 @@ struct _GtkMapListModel
   GtkMapListModelMapFunc map_func;
   gpointer user_data;
   GDestroyNotify user_destroy;
+  GtkMapListModelBatchMapFunc batch_map_func;
 
   GtkRbTree *items; /* NULL if map_func == NULL */
+
+  /* Nodes keeping their item alive, most recently used first */
+  GQueue lru;
+  guint cache_size;
+  guint prefetch;
 };
 
 struct _GtkMapListModelClass
@@ -142,26 +158,69 @@ gtk_map_list_model_get_n_items (GListModel *list)
   return g_list_model_get_n_items (self->model);
 }
 
-static gpointer
-gtk_map_list_model_get_item (GListModel *list,
-                             guint       position)
+static void
+gtk_map_list_model_uncache_node (GtkMapListModel *self,
+                                 MapNode         *node)
 {
-  GtkMapListModel *self = GTK_MAP_LIST_MODEL (list);
-  MapNode *node;
-  guint offset;
+  if (node->lru_link.data == NULL)
+    return;
 
-  if (self->model == NULL)
-    return NULL;
+  g_queue_unlink (&self->lru, &node->lru_link);
+  node->lru_link.data = NULL;
+  /* This may clear node->item via the weak pointer */
+  g_object_unref (node->item);
+}
 
-  if (self->items == NULL)
-    return g_list_model_get_item (self->model, position);
+static void
+gtk_map_list_model_trim_cache (GtkMapListModel *self,
+                               guint            cache_size)
+{
+  while (self->lru.length > cache_size)
+    gtk_map_list_model_uncache_node (self, self->lru.tail->data);
+}
 
-  node = gtk_map_list_model_get_nth (self->items, position, &offset);
-  if (node == NULL)
-    return NULL;
+static void
+gtk_map_list_model_clear_cache (GtkMapListModel *self)
+{
+  gtk_map_list_model_trim_cache (self, 0);
+}
 
-  if (node->item)
-    return g_object_ref (node->item);
+static void
+gtk_map_list_model_cache_node (GtkMapListModel *self,
+                               MapNode         *node)
+{
+  if (self->cache_size == 0)
+    return;
+
+  if (node->lru_link.data)
+    {
+      if (self->lru.head == &node->lru_link)
+        return;
+
+      g_queue_unlink (&self->lru, &node->lru_link);
+    }
+  else
+    {
+      g_object_ref (node->item);
+      node->lru_link.data = node;
+    }
+
+  g_queue_push_head_link (&self->lru, &node->lru_link);
+
+  gtk_map_list_model_trim_cache (self, self->cache_size);
+}
+
+/* Splits the run containing @position so that it gets its own node */
+static MapNode *
+gtk_map_list_model_get_single_node (GtkMapListModel *self,
+                                    guint            position)
+{
+  MapNode *node;
+  guint offset;
+
+  node = gtk_map_list_model_get_nth (self->items, position, &offset);
+  if (node == NULL || node->item)
+    return node;
 
   if (offset != position)
     {
@@ -179,15 +238,118 @@ gtk_map_list_model_get_item (GListModel *list,
       gtk_rb_tree_node_mark_dirty (node);
     }
 
-  node->item = self->map_func (g_list_model_get_item (self->model, position), self->user_data);
+  return node;
+}
+
+static void
+gtk_map_list_model_set_node_item (GtkMapListModel *self,
+                                  MapNode         *node,
+                                  gpointer         item)
+{
+  node->item = item;
   if (!G_TYPE_CHECK_INSTANCE_TYPE (node->item, self->item_type))
     {
       g_critical ("Map function returned a %s, but it is not a subtype of the model's type %s",
                   G_OBJECT_TYPE_NAME (node->item), g_type_name (self->item_type));
     }
   g_object_add_weak_pointer (node->item, &node->item);
+}
+
+/* Maps the item at @position and, if the cache can keep them, the
+ * unmapped items in the prefetch window around it.
+ */
+static gpointer
+gtk_map_list_model_map_items (GtkMapListModel *self,
+                              guint            position)
+{
+  MapNode *requested, *node;
+  MapNode **nodes;
+  gpointer *items;
+  guint start, end, i, n;
+
+  if (self->cache_size > 0)
+    {
+      start = position - MIN (position, self->prefetch);
+      end = MIN ((guint64) position + self->prefetch + 1, g_list_model_get_n_items (self->model));
+    }
+  else
+    {
+      start = position;
+      end = position + 1;
+    }
+
+  nodes = g_new (MapNode *, end - start);
+  items = g_new (gpointer, end - start);
+  requested = NULL;
+  n = 0;
+
+  for (i = start; i < end; i++)
+    {
+      node = gtk_map_list_model_get_single_node (self, i);
+      if (i == position)
+        requested = node;
+      else if (node->item)
+        continue;
+
+      nodes[n] = node;
+      items[n] = g_list_model_get_item (self->model, i);
+      n++;
+    }
+
+  if (n > 1 && self->batch_map_func)
+    {
+      self->batch_map_func (items, n, self->user_data);
+    }
+  else
+    {
+      for (i = 0; i < n; i++)
+        items[i] = self->map_func (items[i], self->user_data);
+    }
+
+  for (i = 0; i < n; i++)
+    gtk_map_list_model_set_node_item (self, nodes[i], items[i]);
+
+  /* Cache the requested item last so it becomes the most recently used one */
+  for (i = 0; i < n; i++)
+    {
+      if (nodes[i] == requested)
+        continue;
+
+      gtk_map_list_model_cache_node (self, nodes[i]);
+      g_object_unref (items[i]);
+    }
+  gtk_map_list_model_cache_node (self, requested);
+
+  g_free (nodes);
+  g_free (items);
 
-  return node->item;
+  return requested->item;
+}
+
+static gpointer
+gtk_map_list_model_get_item (GListModel *list,
+                             guint       position)
+{
+  GtkMapListModel *self = GTK_MAP_LIST_MODEL (list);
+  MapNode *node;
+
+  if (self->model == NULL)
+    return NULL;
+
+  if (self->items == NULL)
+    return g_list_model_get_item (self->model, position);
+
+  node = gtk_map_list_model_get_nth (self->items, position, NULL);
+  if (node == NULL)
+    return NULL;
+
+  if (node->item)
+    {
+      gtk_map_list_model_cache_node (self, node);
+      return g_object_ref (node->item);
+    }
+
+  return gtk_map_list_model_map_items (self, position);
 }
 
 static void
@@ -209,7 +371,7 @@ gtk_map_list_model_items_changed_cb (GListModel      *model,
                                      GtkMapListModel *self)
 {
   MapNode *node;
-  guint start, end;
+  guint start, end, remaining;
 
   if (self->items == NULL)
     {
@@ -220,22 +382,24 @@ gtk_map_list_model_items_changed_cb (GListModel      *model,
   node = gtk_map_list_model_get_nth (self->items, position, &start);
   g_assert (start <= position);
 
-  while (removed > 0)
+  remaining = removed;
+  while (remaining > 0)
     {
       end = start + node->n_items;
-      if (start == position && end <= position + removed)
+      if (start == position && end <= position + remaining)
         {
           MapNode *next = gtk_rb_tree_node_get_next (node);
-          removed -= node->n_items;
+          remaining -= node->n_items;
+          gtk_map_list_model_uncache_node (self, node);
           gtk_rb_tree_remove (self->items, node);
           node = next;
         }
       else
         {
-          if (end >= position + removed)
+          if (end >= position + remaining)
             {
-              node->n_items -= removed;
-              removed = 0;
+              node->n_items -= remaining;
+              remaining = 0;
               gtk_rb_tree_node_mark_dirty (node);
             }
           else if (start < position)
@@ -243,7 +407,7 @@ gtk_map_list_model_items_changed_cb (GListModel      *model,
               guint overlap = node->n_items - (position - start);
               node->n_items -= overlap;
               gtk_rb_tree_node_mark_dirty (node);
-              removed -= overlap;
+              remaining -= overlap;
               start = position;
               node = gtk_rb_tree_node_get_next (node);
             }
@@ -255,7 +419,7 @@ gtk_map_list_model_items_changed_cb (GListModel      *model,
       if (node == NULL)
         node = gtk_rb_tree_insert_before (self->items, NULL);
       else if (node->item)
-        node = gtk_rb_tree_insert_after (self->items, node);
+        node = gtk_rb_tree_insert_before (self->items, node);
 
       node->n_items += added;
       gtk_rb_tree_node_mark_dirty (node);
@@ -274,6 +438,10 @@ gtk_map_list_model_set_property (GObject      *object,
 
   switch (prop_id)
     {
+    case PROP_CACHE_SIZE:
+      gtk_map_list_model_set_cache_size (self, g_value_get_uint (value));
+      break;
+
     case PROP_ITEM_TYPE:
       self->item_type = g_value_get_gtype (value);
       break;
@@ -282,6 +450,10 @@ gtk_map_list_model_set_property (GObject      *object,
       gtk_map_list_model_set_model (self, g_value_get_object (value));
       break;
 
+    case PROP_PREFETCH:
+      gtk_map_list_model_set_prefetch (self, g_value_get_uint (value));
+      break;
+
     default:
       G_OBJECT_WARN_INVALID_PROPERTY_ID (object, prop_id, pspec);
       break;
@@ -298,6 +470,10 @@ gtk_map_list_model_get_property (GObject     *object,
 
   switch (prop_id)
     {
+    case PROP_CACHE_SIZE:
+      g_value_set_uint (value, self->cache_size);
+      break;
+
     case PROP_HAS_MAP:
       g_value_set_boolean (value, self->items != NULL);
       break;
@@ -310,6 +486,10 @@ gtk_map_list_model_get_property (GObject     *object,
       g_value_set_object (value, self->model);
       break;
 
+    case PROP_PREFETCH:
+      g_value_set_uint (value, self->prefetch);
+      break;
+
     default:
       G_OBJECT_WARN_INVALID_PROPERTY_ID (object, prop_id, pspec);
       break;
@@ -337,6 +517,8 @@ gtk_map_list_model_dispose (GObject *object)
   self->map_func = NULL;
   self->user_data = NULL;
   self->user_destroy = NULL;
+  self->batch_map_func = NULL;
+  gtk_map_list_model_clear_cache (self);
   g_clear_pointer (&self->items, gtk_rb_tree_unref);
 
   G_OBJECT_CLASS (gtk_map_list_model_parent_class)->dispose (object);
@@ -351,6 +533,18 @@ gtk_map_list_model_class_init (GtkMapListModelClass *class)
   gobject_class->get_property = gtk_map_list_model_get_property;
   gobject_class->dispose = gtk_map_list_model_dispose;
 
+  /**
+   * GtkMapListModel:cache-size:
+   *
+   * Number of recently used mapped items to keep alive
+   */
+  properties[PROP_CACHE_SIZE] =
+      g_param_spec_uint ("cache-size",
+                         P_("Cache size"),
+                         P_("Number of recently used mapped items to keep alive"),
+                         0, G_MAXUINT, 0,
+                         GTK_PARAM_READWRITE | G_PARAM_EXPLICIT_NOTIFY);
+
   /**
    * GtkMapListModel:has-map:
    *
@@ -387,12 +581,25 @@ gtk_map_list_model_class_init (GtkMapListModelClass *class)
                            G_TYPE_LIST_MODEL,
                            GTK_PARAM_READWRITE | G_PARAM_CONSTRUCT_ONLY | G_PARAM_EXPLICIT_NOTIFY);
 
+  /**
+   * GtkMapListModel:prefetch:
+   *
+   * Number of items on each side of a requested item to map ahead of time
+   */
+  properties[PROP_PREFETCH] =
+      g_param_spec_uint ("prefetch",
+                         P_("Prefetch"),
+                         P_("Number of items on each side of a requested item to map ahead of time"),
+                         0, G_MAXUINT, 0,
+                         GTK_PARAM_READWRITE | G_PARAM_EXPLICIT_NOTIFY);
+
   g_object_class_install_properties (gobject_class, NUM_PROPERTIES, properties);
 }
 
 static void
 gtk_map_list_model_init (GtkMapListModel *self)
 {
+  g_queue_init (&self->lru);
 }
 
 
@@ -467,6 +674,8 @@ gtk_map_list_model_clear_node (gpointer _node)
 static void
 gtk_map_list_model_init_items (GtkMapListModel *self)
 {
+  gtk_map_list_model_clear_cache (self);
+
   if (self->map_func && self->model)
     {
       guint n_items;
@@ -540,6 +749,7 @@ gtk_map_list_model_set_map_func (GtkMapListModel        *self,
   self->map_func = map_func;
   self->user_data = user_data;
   self->user_destroy = user_destroy;
+  self->batch_map_func = NULL;
   
   gtk_map_list_model_init_items (self);
 
@@ -630,3 +840,114 @@ gtk_map_list_model_has_map (GtkMapListModel *self)
 
   return self->map_func != NULL;
 }
+
+/**
+ * gtk_map_list_model_set_batch_map_func:
+ * @self: a #GtkMapListModel
+ * @batch_map_func: (allow-none): function to map multiple items at once
+ *     or %NULL to always use the map function
+ *
+ * Sets a function that maps multiple items with a single call. It will be
+ * used instead of the map function whenever @self maps more than one item
+ * at a time, which happens when a prefetch window has been set with
+ * gtk_map_list_model_set_prefetch().
+ *
+ * @batch_map_func gets passed the user data of the current map function.
+ * Setting a new map function with gtk_map_list_model_set_map_func() unsets
+ * the batch map function, so it needs to be set again afterwards.
+ **/
+void
+gtk_map_list_model_set_batch_map_func (GtkMapListModel             *self,
+                                       GtkMapListModelBatchMapFunc  batch_map_func)
+{
+  g_return_if_fail (GTK_IS_MAP_LIST_MODEL (self));
+  g_return_if_fail (batch_map_func == NULL || self->map_func != NULL);
+
+  self->batch_map_func = batch_map_func;
+}
+
+/**
+ * gtk_map_list_model_set_cache_size:
+ * @self: a #GtkMapListModel
+ * @cache_size: the number of mapped items to keep alive
+ *
+ * Sets the number of mapped items that @self keeps alive after they
+ * have been requested, even if nobody else holds a reference to them.
+ * When more items are mapped, the least recently used ones are released
+ * first.
+ *
+ * The default is 0, which means mapped items are released as soon as
+ * they are no longer in use.
+ **/
+void
+gtk_map_list_model_set_cache_size (GtkMapListModel *self,
+                                   guint            cache_size)
+{
+  g_return_if_fail (GTK_IS_MAP_LIST_MODEL (self));
+
+  if (self->cache_size == cache_size)
+    return;
+
+  self->cache_size = cache_size;
+  gtk_map_list_model_trim_cache (self, cache_size);
+
+  g_object_notify_by_pspec (G_OBJECT (self), properties[PROP_CACHE_SIZE]);
+}
+
+/**
+ * gtk_map_list_model_get_cache_size:
+ * @self: a #GtkMapListModel
+ *
+ * Gets the value set via gtk_map_list_model_set_cache_size().
+ *
+ * Returns: the number of mapped items kept alive
+ **/
+guint
+gtk_map_list_model_get_cache_size (GtkMapListModel *self)
+{
+  g_return_val_if_fail (GTK_IS_MAP_LIST_MODEL (self), 0);
+
+  return self->cache_size;
+}
+
+/**
+ * gtk_map_list_model_set_prefetch:
+ * @self: a #GtkMapListModel
+ * @prefetch: number of items to map on each side of a requested item
+ *
+ * Sets how many items before and after a requested item are mapped
+ * along with it when it needs to be mapped.
+ *
+ * Prefetched items are only kept in the cache, so this has no effect
+ * unless a cache size has been set with gtk_map_list_model_set_cache_size().
+ * The cache should be able to hold at least 2 * @prefetch + 1 items.
+ **/
+void
+gtk_map_list_model_set_prefetch (GtkMapListModel *self,
+                                 guint            prefetch)
+{
+  g_return_if_fail (GTK_IS_MAP_LIST_MODEL (self));
+
+  if (self->prefetch == prefetch)
+    return;
+
+  self->prefetch = prefetch;
+
+  g_object_notify_by_pspec (G_OBJECT (self), properties[PROP_PREFETCH]);
+}
+
+/**
+ * gtk_map_list_model_get_prefetch:
+ * @self: a #GtkMapListModel
+ *
+ * Gets the value set via gtk_map_list_model_set_prefetch().
+ *
+ * Returns: the number of items prefetched on each side
+ **/
+guint
+gtk_map_list_model_get_prefetch (GtkMapListModel *self)
+{
+  g_return_val_if_fail (GTK_IS_MAP_LIST_MODEL (self), 0);
+
+  return self->prefetch;
+}
@@ -52,6 +52,18 @@ G_DECLARE_FINAL_TYPE (GtkMapListModel, gtk_map_list_model, GTK, MAP_LIST_MODEL,
  */
 typedef gpointer (* GtkMapListModelMapFunc) (gpointer item, gpointer user_data);
 
+/**
+ * GtkMapListModelBatchMapFunc:
+ * @items: (array length=n_items) (transfer full): The items to map
+ * @n_items: number of items in @items
+ * @user_data: user data
+ *
+ * User function that is called to map multiple items of the original model
+ * at once. It must replace every item in @items with the item to map it to,
+ * following the same rules as #GtkMapListModelMapFunc.
+ */
+typedef void (* GtkMapListModelBatchMapFunc) (gpointer *items, guint n_items, gpointer user_data);
+
 GDK_AVAILABLE_IN_ALL
 GtkMapListModel *       gtk_map_list_model_new                  (GType                   item_type,
                                                                  GListModel             *model,
@@ -65,12 +77,25 @@ void                    gtk_map_list_model_set_map_func         (GtkMapListModel
                                                                  gpointer                user_data,
                                                                  GDestroyNotify          user_destroy);
 GDK_AVAILABLE_IN_ALL
+void                    gtk_map_list_model_set_batch_map_func   (GtkMapListModel        *self,
+                                                                 GtkMapListModelBatchMapFunc batch_map_func);
+GDK_AVAILABLE_IN_ALL
 void                    gtk_map_list_model_set_model            (GtkMapListModel        *self,
                                                                  GListModel             *model);
 GDK_AVAILABLE_IN_ALL
 GListModel *            gtk_map_list_model_get_model            (GtkMapListModel        *self);
 GDK_AVAILABLE_IN_ALL
 gboolean                gtk_map_list_model_has_map              (GtkMapListModel        *self);
+GDK_AVAILABLE_IN_ALL
+void                    gtk_map_list_model_set_cache_size       (GtkMapListModel        *self,
+                                                                 guint                   cache_size);
+GDK_AVAILABLE_IN_ALL
+guint                   gtk_map_list_model_get_cache_size       (GtkMapListModel        *self);
+GDK_AVAILABLE_IN_ALL
+void                    gtk_map_list_model_set_prefetch         (GtkMapListModel        *self,
+                                                                 guint                   prefetch);
+GDK_AVAILABLE_IN_ALL
+guint                   gtk_map_list_model_get_prefetch         (GtkMapListModel        *self);
 
 G_END_DECLS
 
@@ -27,6 +27,8 @@
 #include <pango/pangocairo.h>
 #include "gtkintl.h"
 
+#include <string.h>
+
 static AtkAttributeSet *
 add_attribute (AtkAttributeSet  *attributes,
                AtkTextAttribute  attr,
@@ -1075,3 +1077,348 @@ _gtk_pango_attr_list_merge (PangoAttrList *into,
 
   return into;
 }
+
+/* Process-wide cache of shaped layouts for short strings
+ * without attributes. Many widgets in a typical UI show the
+ * same few strings with the same font, and shaping them once
+ * per widget is wasted work. Layouts handed out from here are
+ * shared and must not be modified.
+ */
+#define SHARED_LAYOUT_CACHE_SIZE 512
+#define SHARED_LAYOUT_MAX_LENGTH 256
+
+typedef struct {
+  PangoContext *context;
+  guint n_entries;
+} SharedContext;
+
+typedef struct {
+  SharedContext *context;
+  char *text;
+  PangoAlignment alignment;
+  gboolean single_paragraph;
+  guint hash;
+  PangoLayout *layout;
+  GList lru_link;
+} SharedLayout;
+
+static GList *shared_contexts;
+static GHashTable *shared_layouts;
+static GQueue shared_layout_lru;
+
+static gboolean
+contexts_equal (PangoContext *a,
+                PangoContext *b)
+{
+  const PangoMatrix *ma, *mb;
+  const cairo_font_options_t *oa, *ob;
+
+  if (pango_context_get_font_map (a) != pango_context_get_font_map (b) ||
+      pango_context_get_language (a) != pango_context_get_language (b) ||
+      pango_context_get_base_dir (a) != pango_context_get_base_dir (b) ||
+      pango_context_get_base_gravity (a) != pango_context_get_base_gravity (b) ||
+      pango_context_get_gravity_hint (a) != pango_context_get_gravity_hint (b) ||
+      pango_cairo_context_get_resolution (a) != pango_cairo_context_get_resolution (b))
+    return FALSE;
+
+  if (!pango_font_description_equal (pango_context_get_font_description (a),
+                                     pango_context_get_font_description (b)))
+    return FALSE;
+
+  ma = pango_context_get_matrix (a);
+  mb = pango_context_get_matrix (b);
+  if ((ma == NULL) != (mb == NULL) ||
+      (ma && memcmp (ma, mb, sizeof (PangoMatrix)) != 0))
+    return FALSE;
+
+  oa = pango_cairo_context_get_font_options (a);
+  ob = pango_cairo_context_get_font_options (b);
+  if ((oa == NULL) != (ob == NULL) ||
+      (oa && !cairo_font_options_equal (oa, ob)))
+    return FALSE;
+
+  return TRUE;
+}
+
+static SharedContext *
+shared_context_lookup (PangoContext *context)
+{
+  SharedContext *shared;
+  PangoContext *copy;
+  GList *l;
+
+  for (l = shared_contexts; l; l = l->next)
+    {
+      shared = l->data;
+      if (contexts_equal (shared->context, context))
+        return shared;
+    }
+
+  copy = pango_font_map_create_context (pango_context_get_font_map (context));
+  pango_context_set_font_description (copy, pango_context_get_font_description (context));
+  pango_context_set_language (copy, pango_context_get_language (context));
+  pango_context_set_base_dir (copy, pango_context_get_base_dir (context));
+  pango_context_set_base_gravity (copy, pango_context_get_base_gravity (context));
+  pango_context_set_gravity_hint (copy, pango_context_get_gravity_hint (context));
+  pango_context_set_matrix (copy, pango_context_get_matrix (context));
+  pango_cairo_context_set_resolution (copy, pango_cairo_context_get_resolution (context));
+  pango_cairo_context_set_font_options (copy, pango_cairo_context_get_font_options (context));
+
+  shared = g_new0 (SharedContext, 1);
+  shared->context = copy;
+  shared_contexts = g_list_prepend (shared_contexts, shared);
+
+  return shared;
+}
+
+static guint
+shared_layout_hash (gconstpointer data)
+{
+  const SharedLayout *entry = data;
+
+  return entry->hash;
+}
+
+static gboolean
+shared_layout_equal (gconstpointer a,
+                     gconstpointer b)
+{
+  const SharedLayout *ea = a;
+  const SharedLayout *eb = b;
+
+  return ea->hash == eb->hash &&
+         ea->context == eb->context &&
+         ea->alignment == eb->alignment &&
+         ea->single_paragraph == eb->single_paragraph &&
+         strcmp (ea->text, eb->text) == 0;
+}
+
+static void
+shared_layout_free (gpointer data)
+{
+  SharedLayout *entry = data;
+  SharedContext *shared = entry->context;
+
+  g_object_unref (entry->layout);
+  g_free (entry->text);
+  g_slice_free (SharedLayout, entry);
+
+  if (--shared->n_entries == 0)
+    {
+      shared_contexts = g_list_remove (shared_contexts, shared);
+      g_object_unref (shared->context);
+      g_free (shared);
+    }
+}
+
+/*
+ * _gtk_pango_get_shared_layout:
+ * @context: the #PangoContext the layout would be created for
+ * @text: the text to lay out
+ * @alignment: the alignment of the layout
+ * @single_paragraph: whether to use single paragraph mode
+ *
+ * Looks up a layout for @text with no attributes and no width
+ * in a process-wide cache, shaping it on a miss. The layout is
+ * created for a private context with the same settings as
+ * @context, so it must be looked up again when @context changes.
+ *
+ * The returned layout is shared and must be treated as read-only.
+ *
+ * Returns: (nullable): a new reference to the layout, or %NULL if
+ *   @text is too long to be worth caching
+ */
+PangoLayout *
+_gtk_pango_get_shared_layout (PangoContext   *context,
+                              const char     *text,
+                              PangoAlignment  alignment,
+                              gboolean        single_paragraph)
+{
+  SharedLayout key, *entry;
+  SharedContext *shared;
+
+  if (text == NULL)
+    text = "";
+
+  if (strlen (text) > SHARED_LAYOUT_MAX_LENGTH)
+    return NULL;
+
+  if (shared_layouts == NULL)
+    shared_layouts = g_hash_table_new_full (shared_layout_hash, shared_layout_equal,
+                                            shared_layout_free, NULL);
+
+  shared = shared_context_lookup (context);
+
+  key.context = shared;
+  key.text = (char *) text;
+  key.alignment = alignment;
+  key.single_paragraph = single_paragraph;
+  key.hash = g_str_hash (text) ^ (alignment << 1) ^ single_paragraph ^ GPOINTER_TO_UINT (shared);
+
+  entry = g_hash_table_lookup (shared_layouts, &key);
+  if (entry)
+    {
+      g_queue_unlink (&shared_layout_lru, &entry->lru_link);
+      g_queue_push_head_link (&shared_layout_lru, &entry->lru_link);
+      return g_object_ref (entry->layout);
+    }
+
+  entry = g_slice_new0 (SharedLayout);
+  entry->context = shared;
+  entry->text = g_strdup (text);
+  entry->alignment = alignment;
+  entry->single_paragraph = single_paragraph;
+  entry->hash = key.hash;
+  entry->layout = pango_layout_new (shared->context);
+  entry->lru_link.data = entry;
+  pango_layout_set_text (entry->layout, text, -1);
+  pango_layout_set_alignment (entry->layout, alignment);
+  pango_layout_set_single_paragraph_mode (entry->layout, single_paragraph);
+  shared->n_entries++;
+
+  g_hash_table_add (shared_layouts, entry);
+  g_queue_push_head_link (&shared_layout_lru, &entry->lru_link);
+
+  if (shared_layout_lru.length > SHARED_LAYOUT_CACHE_SIZE)
+    {
+      GList *last = g_queue_pop_tail_link (&shared_layout_lru);
+      g_hash_table_remove (shared_layouts, last->data);
+    }
+
+  return g_object_ref (entry->layout);
+}
+
+/* Process-wide cache of parsed markup. Labels and cell renderers
+ * showing frequently updated values, like counters, are often set
+ * to the same few markup strings over and over again.
+ */
+#define PARSED_MARKUP_CACHE_SIZE 256
+#define PARSED_MARKUP_MAX_LENGTH 1024
+
+typedef struct {
+  char *markup;
+  gunichar accel_marker;
+  guint hash;
+  char *text;
+  PangoAttrList *attrs;
+  gunichar accel_char;
+  GList lru_link;
+} ParsedMarkup;
+
+static GHashTable *parsed_markups;
+static GQueue parsed_markup_lru;
+
+static guint
+parsed_markup_hash (gconstpointer data)
+{
+  const ParsedMarkup *entry = data;
+
+  return entry->hash;
+}
+
+static gboolean
+parsed_markup_equal (gconstpointer a,
+                     gconstpointer b)
+{
+  const ParsedMarkup *ea = a;
+  const ParsedMarkup *eb = b;
+
+  return ea->hash == eb->hash &&
+         ea->accel_marker == eb->accel_marker &&
+         strcmp (ea->markup, eb->markup) == 0;
+}
+
+static void
+parsed_markup_free (gpointer data)
+{
+  ParsedMarkup *entry = data;
+
+  g_free (entry->markup);
+  g_free (entry->text);
+  pango_attr_list_unref (entry->attrs);
+  g_slice_free (ParsedMarkup, entry);
+}
+
+/*
+ * _gtk_pango_parse_markup:
+ * @markup: nul-terminated markup to parse
+ * @accel_marker: character that precedes an accelerator, or 0 for none
+ * @attrs: (out) (optional): return location for the attributes
+ * @text: (out) (optional): return location for the text with tags stripped
+ * @accel_char: (out) (optional): return location for the accelerator char
+ * @error: return location for errors
+ *
+ * Like pango_parse_markup(), but the results for recently parsed
+ * strings are taken from a process-wide cache.
+ *
+ * The returned attribute list is shared and must not be modified.
+ *
+ * Returns: %FALSE if @error is set, otherwise %TRUE
+ */
+gboolean
+_gtk_pango_parse_markup (const char     *markup,
+                         gunichar        accel_marker,
+                         PangoAttrList **attrs,
+                         char          **text,
+                         gunichar       *accel_char,
+                         GError        **error)
+{
+  ParsedMarkup key, *entry;
+
+  if (strlen (markup) > PARSED_MARKUP_MAX_LENGTH)
+    return pango_parse_markup (markup, -1, accel_marker, attrs, text, accel_char, error);
+
+  if (parsed_markups == NULL)
+    parsed_markups = g_hash_table_new_full (parsed_markup_hash, parsed_markup_equal,
+                                            parsed_markup_free, NULL);
+
+  key.markup = (char *) markup;
+  key.accel_marker = accel_marker;
+  key.hash = g_str_hash (markup) ^ accel_marker;
+
+  entry = g_hash_table_lookup (parsed_markups, &key);
+  if (entry)
+    {
+      g_queue_unlink (&parsed_markup_lru, &entry->lru_link);
+      g_queue_push_head_link (&parsed_markup_lru, &entry->lru_link);
+    }
+  else
+    {
+      PangoAttrList *parsed_attrs;
+      char *parsed_text;
+      gunichar parsed_accel_char;
+
+      /* Errors are not cached, they are rare and need to be reported */
+      if (!pango_parse_markup (markup, -1, accel_marker,
+                               &parsed_attrs, &parsed_text, &parsed_accel_char,
+                               error))
+        return FALSE;
+
+      entry = g_slice_new0 (ParsedMarkup);
+      entry->markup = g_strdup (markup);
+      entry->accel_marker = accel_marker;
+      entry->hash = key.hash;
+      entry->text = parsed_text;
+      entry->attrs = parsed_attrs;
+      entry->accel_char = parsed_accel_char;
+      entry->lru_link.data = entry;
+
+      g_hash_table_add (parsed_markups, entry);
+      g_queue_push_head_link (&parsed_markup_lru, &entry->lru_link);
+
+      if (parsed_markup_lru.length > PARSED_MARKUP_CACHE_SIZE)
+        {
+          GList *last = g_queue_pop_tail_link (&parsed_markup_lru);
+          g_hash_table_remove (parsed_markups, last->data);
+        }
+    }
+
+  if (attrs)
+    *attrs = pango_attr_list_ref (entry->attrs);
+  if (text)
+    *text = g_strdup (entry->text);
+  if (accel_char)
+    *accel_char = entry->accel_char;
+
+  return TRUE;
+}
@@ -59,6 +59,18 @@ gchar *_gtk_pango_get_text_after  (PangoLayout     *layout,
 PangoAttrList *_gtk_pango_attr_list_merge (PangoAttrList *into,
                                            PangoAttrList *from);
 
+PangoLayout   *_gtk_pango_get_shared_layout (PangoContext   *context,
+                                             const char     *text,
+                                             PangoAlignment  alignment,
+                                             gboolean        single_paragraph);
+
+gboolean       _gtk_pango_parse_markup      (const char     *markup,
+                                             gunichar        accel_marker,
+                                             PangoAttrList **attrs,
+                                             char          **text,
+                                             gunichar       *accel_char,
+                                             GError        **error);
+
 G_END_DECLS
 
 #endif /* __GTK_PANGO_H__ */
@@ -0,0 +1,214 @@
+/* GTK - The GIMP Toolkit
+ * Copyright (C) 2018 Red Hat, Inc.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "config.h"
+
+#include "gtkpickindexprivate.h"
+
+#include "gtkwidgetprivate.h"
+
+/* A uniform grid over the children's allocations. Each cell lists the
+ * children overlapping it in sibling order, so a pick only has to look
+ * at the few children in the cell below the point instead of all of
+ * them.
+ *
+ * The grid is thrown away whenever a child is added, removed, moved or
+ * resized, and rebuilt on the next pick. Containers with many children
+ * reallocate all of them at once anyway, so updating cells one child
+ * at a time would not save anything.
+ */
+
+struct _GtkPickIndex
+{
+  gboolean valid;
+
+  GPtrArray *children;
+  /* n_columns * n_rows GArrays of child indexes, or NULL when empty */
+  GPtrArray *cells;
+
+  int x;
+  int y;
+  int cell_width;
+  int cell_height;
+  int n_columns;
+  int n_rows;
+};
+
+GtkPickIndex *
+gtk_pick_index_new (void)
+{
+  GtkPickIndex *index;
+
+  index = g_slice_new0 (GtkPickIndex);
+  index->children = g_ptr_array_new ();
+  index->cells = g_ptr_array_new_with_free_func ((GDestroyNotify) g_array_unref);
+
+  return index;
+}
+
+void
+gtk_pick_index_free (GtkPickIndex *index)
+{
+  g_ptr_array_unref (index->children);
+  g_ptr_array_unref (index->cells);
+
+  g_slice_free (GtkPickIndex, index);
+}
+
+void
+gtk_pick_index_invalidate (GtkPickIndex *index)
+{
+  index->valid = FALSE;
+}
+
+static void
+gtk_pick_index_rebuild (GtkPickIndex *index,
+                        GtkWidget    *widget)
+{
+  GtkWidget *child;
+  GtkAllocation alloc;
+  int x1, y1, x2, y2;
+  gint64 total_width, total_height;
+  guint i, n;
+  int col, row;
+
+  g_ptr_array_set_size (index->children, 0);
+  g_ptr_array_set_size (index->cells, 0);
+  index->n_columns = index->n_rows = 0;
+  index->valid = TRUE;
+
+  x1 = y1 = G_MAXINT;
+  x2 = y2 = G_MININT;
+  total_width = total_height = 0;
+
+  for (child = _gtk_widget_get_first_child (widget);
+       child != NULL;
+       child = _gtk_widget_get_next_sibling (child))
+    {
+      g_ptr_array_add (index->children, child);
+
+      _gtk_widget_get_allocation (child, &alloc);
+      if (alloc.width <= 0 || alloc.height <= 0)
+        continue;
+
+      x1 = MIN (x1, alloc.x);
+      y1 = MIN (y1, alloc.y);
+      x2 = MAX (x2, alloc.x + alloc.width);
+      y2 = MAX (y2, alloc.y + alloc.height);
+      total_width += alloc.width;
+      total_height += alloc.height;
+    }
+
+  n = index->children->len;
+  if (x1 >= x2 || y1 >= y2)
+    return;
+
+  /* Cells the size of an average child, but not many more cells
+   * than children if the children vary a lot in size */
+  index->x = x1;
+  index->y = y1;
+  index->cell_width = MAX (1, total_width / n);
+  index->cell_height = MAX (1, total_height / n);
+
+  while (TRUE)
+    {
+      index->n_columns = (x2 - x1 + index->cell_width - 1) / index->cell_width;
+      index->n_rows = (y2 - y1 + index->cell_height - 1) / index->cell_height;
+
+      if ((gint64) index->n_columns * index->n_rows <= 4 * (gint64) n + 16)
+        break;
+
+      index->cell_width *= 2;
+      index->cell_height *= 2;
+    }
+
+  g_ptr_array_set_size (index->cells, index->n_columns * index->n_rows);
+
+  for (i = 0; i < n; i++)
+    {
+      _gtk_widget_get_allocation (g_ptr_array_index (index->children, i), &alloc);
+      if (alloc.width <= 0 || alloc.height <= 0)
+        continue;
+
+      for (row = (alloc.y - y1) / index->cell_height;
+           row <= (alloc.y + alloc.height - 1 - y1) / index->cell_height;
+           row++)
+        {
+          for (col = (alloc.x - x1) / index->cell_width;
+               col <= (alloc.x + alloc.width - 1 - x1) / index->cell_width;
+               col++)
+            {
+              GArray *cell = g_ptr_array_index (index->cells, row * index->n_columns + col);
+
+              if (cell == NULL)
+                {
+                  cell = g_array_new (FALSE, FALSE, sizeof (guint));
+                  index->cells->pdata[row * index->n_columns + col] = cell;
+                }
+
+              g_array_append_val (cell, i);
+            }
+        }
+    }
+}
+
+/* Does what the default GtkWidget::pick does with the children of
+ * @widget, for @x and @y in @widget's coordinates. Children must not
+ * pick anything outside of their allocation.
+ */
+GtkWidget *
+gtk_pick_index_pick_child (GtkPickIndex *index,
+                           GtkWidget    *widget,
+                           double        x,
+                           double        y)
+{
+  GArray *cell;
+  int col, row;
+  guint i;
+
+  if (!index->valid)
+    gtk_pick_index_rebuild (index, widget);
+
+  if (index->n_columns == 0 ||
+      x < index->x || y < index->y)
+    return NULL;
+
+  col = (x - index->x) / index->cell_width;
+  row = (y - index->y) / index->cell_height;
+  if (col >= index->n_columns || row >= index->n_rows)
+    return NULL;
+
+  cell = g_ptr_array_index (index->cells, row * index->n_columns + col);
+  if (cell == NULL)
+    return NULL;
+
+  /* Children later in the list are on top */
+  for (i = cell->len; i > 0; i--)
+    {
+      GtkWidget *child = g_ptr_array_index (index->children, g_array_index (cell, guint, i - 1));
+      GtkWidget *picked;
+      int dx, dy;
+
+      gtk_widget_get_origin_relative_to_parent (child, &dx, &dy);
+
+      picked = gtk_widget_pick (child, x - dx, y - dy);
+      if (picked)
+        return picked;
+    }
+
+  return NULL;
+}
@@ -0,0 +1,39 @@
+/* GTK - The GIMP Toolkit
+ * Copyright (C) 2018 Red Hat, Inc.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef __GTK_PICK_INDEX_PRIVATE_H__
+#define __GTK_PICK_INDEX_PRIVATE_H__
+
+#include "gtkwidget.h"
+
+G_BEGIN_DECLS
+
+typedef struct _GtkPickIndex GtkPickIndex;
+
+GtkPickIndex *  gtk_pick_index_new              (void);
+void            gtk_pick_index_free             (GtkPickIndex   *index);
+
+void            gtk_pick_index_invalidate       (GtkPickIndex   *index);
+
+GtkWidget *     gtk_pick_index_pick_child       (GtkPickIndex   *index,
+                                                 GtkWidget      *widget,
+                                                 double          x,
+                                                 double          y);
+
+G_END_DECLS
+
+#endif /* __GTK_PICK_INDEX_PRIVATE_H__ */
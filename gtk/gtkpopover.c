@@ -269,7 +269,7 @@ node_style_changed_cb (GtkCssNode        *node,
 {
   if (gtk_css_style_change_affects (change, GTK_CSS_AFFECTS_SIZE))
     gtk_widget_queue_resize (widget);
-  else
+  else if (gtk_css_style_change_affects (change, GTK_CSS_AFFECTS_REDRAW))
     gtk_widget_queue_draw (widget);
 }
 
@@ -364,6 +364,7 @@ gtk_popover_init (GtkPopover *popover)
 
   priv->arrow_node = gtk_css_node_new ();
   gtk_css_node_set_name (priv->arrow_node, I_("arrow"));
+  gtk_css_node_set_lazy (priv->arrow_node, TRUE);
   gtk_css_node_set_parent (priv->arrow_node, gtk_widget_get_css_node (widget));
   gtk_css_node_set_state (priv->arrow_node,
                           gtk_css_node_get_state (gtk_widget_get_css_node (widget)));
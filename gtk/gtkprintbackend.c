@@ -27,6 +27,7 @@
 #include "gtkmarshalers.h"
 #include "gtkprivate.h"
 #include "gtkprintbackend.h"
+#include "gtkprinter-private.h"
 
 
 static void gtk_print_backend_dispose      (GObject      *object);
@@ -44,6 +45,7 @@ struct _GtkPrintBackendPrivate
   GHashTable *printers;
   guint printer_list_requested : 1;
   guint printer_list_done : 1;
+  guint supports_streaming : 1;
   GtkPrintBackendStatus status;
   char **auth_info_required;
   char **auth_info;
@@ -475,6 +477,34 @@ gtk_print_backend_set_list_done (GtkPrintBackend *backend)
     }
 }
 
+/*
+ * gtk_print_backend_set_supports_streaming:
+ * @backend: a #GtkPrintBackend
+ * @supports_streaming: whether print_stream() can be called before
+ *   the data is complete
+ *
+ * Declares that the backend's print_stream() implementation reads
+ * @data_io without blocking the main loop, so that a #GtkPrintJob can
+ * hand it the read end of a pipe while the pages are still being
+ * rendered. The backend must read until the end of the data, even
+ * after an error, since the writer blocks when the pipe is full.
+ */
+void
+gtk_print_backend_set_supports_streaming (GtkPrintBackend *backend,
+                                          gboolean         supports_streaming)
+{
+  g_return_if_fail (GTK_IS_PRINT_BACKEND (backend));
+
+  backend->priv->supports_streaming = supports_streaming;
+}
+
+gboolean
+gtk_print_backend_get_supports_streaming (GtkPrintBackend *backend)
+{
+  g_return_val_if_fail (GTK_IS_PRINT_BACKEND (backend), FALSE);
+
+  return backend->priv->supports_streaming;
+}
 
 /**
  * gtk_print_backend_get_printer_list:
@@ -185,6 +185,9 @@ void        gtk_print_backend_remove_printer       (GtkPrintBackend         *pri
 						    GtkPrinter              *printer);
 GDK_AVAILABLE_IN_ALL
 void        gtk_print_backend_set_list_done        (GtkPrintBackend         *backend);
+GDK_AVAILABLE_IN_ALL
+void        gtk_print_backend_set_supports_streaming (GtkPrintBackend       *backend,
+                                                      gboolean               supports_streaming);
 
 
 /* Backend-only functions for GtkPrinter */
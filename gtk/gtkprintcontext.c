@@ -539,6 +539,70 @@ _gtk_print_context_set_hard_margins (GtkPrintContext *context,
   context->has_hard_margins   = TRUE;
 }
 
+/*
+ * _gtk_print_context_new_for_page:
+ * @context: the #GtkPrintContext of a print operation
+ * @page_setup: the page setup of the page
+ *
+ * Creates a context that draws a page of the same operation into a
+ * recording surface, with the same resolution, units and margins as
+ * @context, so that it can be drawn in another thread and painted
+ * onto @context later with _gtk_print_context_paint_page().
+ *
+ * Returns: a new #GtkPrintContext
+ */
+GtkPrintContext *
+_gtk_print_context_new_for_page (GtkPrintContext *context,
+                                 GtkPageSetup    *page_setup)
+{
+  GtkPrintContext *page_context;
+  cairo_surface_t *recording;
+  cairo_t *cr;
+
+  page_context = _gtk_print_context_new (context->op);
+  _gtk_print_context_set_page_setup (page_context, page_setup);
+
+  page_context->has_hard_margins = context->has_hard_margins;
+  page_context->hard_margin_top = context->hard_margin_top;
+  page_context->hard_margin_bottom = context->hard_margin_bottom;
+  page_context->hard_margin_left = context->hard_margin_left;
+  page_context->hard_margin_right = context->hard_margin_right;
+
+  recording = cairo_recording_surface_create (CAIRO_CONTENT_COLOR_ALPHA, NULL);
+  cr = cairo_create (recording);
+  gtk_print_context_set_cairo_context (page_context, cr,
+                                       context->surface_dpi_x,
+                                       context->surface_dpi_y);
+  cairo_destroy (cr);
+  cairo_surface_destroy (recording);
+
+  return page_context;
+}
+
+/*
+ * _gtk_print_context_paint_page:
+ * @context: a #GtkPrintContext
+ * @page_context: a context from _gtk_print_context_new_for_page()
+ *
+ * Paints what was drawn on @page_context at the current position
+ * of @context's cairo context.
+ */
+void
+_gtk_print_context_paint_page (GtkPrintContext *context,
+                               GtkPrintContext *page_context)
+{
+  cairo_save (context->cr);
+
+  /* The recording has the unit scale applied already */
+  cairo_scale (context->cr,
+               1.0 / context->pixels_per_unit_x,
+               1.0 / context->pixels_per_unit_y);
+  cairo_set_source_surface (context->cr, cairo_get_target (page_context->cr), 0, 0);
+  cairo_paint (context->cr);
+
+  cairo_restore (context->cr);
+}
+
 /**
  * gtk_print_context_get_pango_fontmap:
  * @context: a #GtkPrintContext
@@ -49,6 +49,14 @@ GHashTable *         _gtk_printer_get_custom_widgets        (GtkPrinter
 GDK_AVAILABLE_IN_ALL
 void gtk_print_job_set_status (GtkPrintJob   *job,
 			       GtkPrintStatus status);
+void gtk_print_job_set_streaming (GtkPrintJob *job,
+                                  gboolean     streaming);
+void gtk_print_job_cancel_stream (GtkPrintJob *job);
+GDK_AVAILABLE_IN_ALL
+GCancellable *gtk_print_job_get_cancellable (GtkPrintJob *job);
+
+/* GtkPrintBackend private methods: */
+gboolean gtk_print_backend_get_supports_streaming (GtkPrintBackend *backend);
 
 G_END_DECLS
 #endif /* __GTK_PRINT_OPERATION_PRIVATE_H__ */
@@ -44,6 +44,7 @@
 #include <sys/stat.h>
 
 #include <glib/gstdio.h>
+#include <glib-unix.h>
 #include "gtkintl.h"
 #include "gtkprivate.h"
 
@@ -63,6 +64,15 @@ struct _GtkPrintJobPrivate
   GIOChannel *spool_io;
   cairo_surface_t *surface;
 
+  /* When streaming, spool_io is the write end of a pipe and the
+   * backend is already reading stream_io, the other end */
+  GIOChannel *stream_io;
+  GCancellable *cancellable;
+  GError *stream_error;
+  GtkPrintJobCompleteFunc send_callback;
+  gpointer send_user_data;
+  GDestroyNotify send_dnotify;
+
   GtkPrintStatus status;
   GtkPrintBackend *backend;
   GtkPrinter *printer;
@@ -85,6 +95,9 @@ struct _GtkPrintJobPrivate
   guint rotate_to_orientation : 1;
   guint collate               : 1;
   guint reverse               : 1;
+  guint streaming             : 1;
+  guint stream_done           : 1;
+  guint sent                  : 1;
 };
 
 static void     gtk_print_job_finalize     (GObject               *object);
@@ -262,6 +275,10 @@ gtk_print_job_finalize (GObject *object)
       priv->spool_io = NULL;
     }
 
+  g_clear_pointer (&priv->stream_io, g_io_channel_unref);
+  g_clear_object (&priv->cancellable);
+  g_clear_error (&priv->stream_error);
+
   if (priv->printer)
     g_object_unref (priv->printer);
 
@@ -463,6 +480,118 @@ gtk_print_job_set_source_fd (GtkPrintJob  *job,
   return TRUE;
 }
 
+static void
+gtk_print_job_complete_send (GtkPrintJob *job)
+{
+  GtkPrintJobPrivate *priv = job->priv;
+
+  if (priv->send_callback)
+    priv->send_callback (job, priv->send_user_data, priv->stream_error);
+
+  if (priv->send_dnotify)
+    priv->send_dnotify (priv->send_user_data);
+
+  priv->send_callback = NULL;
+  priv->send_user_data = NULL;
+  priv->send_dnotify = NULL;
+}
+
+static void
+stream_complete_cb (GtkPrintJob  *job,
+                    gpointer      user_data,
+                    const GError *error)
+{
+  GtkPrintJobPrivate *priv = job->priv;
+
+  priv->stream_done = TRUE;
+  if (error)
+    priv->stream_error = g_error_copy (error);
+
+  if (priv->sent)
+    gtk_print_job_complete_send (job);
+}
+
+static gboolean
+gtk_print_job_open_stream (GtkPrintJob  *job,
+                           GError      **error)
+{
+  GtkPrintJobPrivate *priv = job->priv;
+  gint fds[2];
+
+  if (!g_unix_open_pipe (fds, FD_CLOEXEC, error))
+    return FALSE;
+
+  priv->stream_io = g_io_channel_unix_new (fds[0]);
+  g_io_channel_set_close_on_unref (priv->stream_io, TRUE);
+  g_io_channel_set_encoding (priv->stream_io, NULL, NULL);
+
+  priv->spool_io = g_io_channel_unix_new (fds[1]);
+  g_io_channel_set_close_on_unref (priv->spool_io, TRUE);
+  g_io_channel_set_encoding (priv->spool_io, NULL, NULL);
+
+  priv->cancellable = g_cancellable_new ();
+
+  GTK_NOTE (PRINTING,
+            g_print ("Streaming print job to the backend while rendering\n"));
+
+  gtk_print_backend_print_stream (priv->backend, job,
+                                  priv->stream_io,
+                                  stream_complete_cb, NULL, NULL);
+
+  return TRUE;
+}
+
+/*
+ * gtk_print_job_set_streaming:
+ * @job: a #GtkPrintJob
+ * @streaming: whether to stream
+ *
+ * Lets gtk_print_job_get_surface() hand the data to backends that
+ * support it while it is being written, instead of spooling it to a
+ * file first. Pages then arrive at the printer as they are rendered,
+ * and the pipe in between keeps the renderer from getting far ahead.
+ *
+ * The backend holds on to a streaming job until its data ends, so
+ * the caller must either send the job with gtk_print_job_send() or
+ * drop it with gtk_print_job_cancel_stream().
+ */
+void
+gtk_print_job_set_streaming (GtkPrintJob *job,
+                             gboolean     streaming)
+{
+  g_return_if_fail (GTK_IS_PRINT_JOB (job));
+  g_return_if_fail (job->priv->spool_io == NULL);
+
+  job->priv->streaming = streaming;
+}
+
+void
+gtk_print_job_cancel_stream (GtkPrintJob *job)
+{
+  GtkPrintJobPrivate *priv = job->priv;
+
+  if (priv->stream_io == NULL || priv->sent)
+    return;
+
+  g_cancellable_cancel (priv->cancellable);
+  g_io_channel_shutdown (priv->spool_io, FALSE, NULL);
+}
+
+/*
+ * gtk_print_job_get_cancellable:
+ * @job: a #GtkPrintJob
+ *
+ * Returns: (nullable) (transfer none): a cancellable that is triggered
+ *   when a streaming job is dropped before it was sent
+ */
+GCancellable *
+gtk_print_job_get_cancellable (GtkPrintJob *job)
+{
+  g_return_val_if_fail (GTK_IS_PRINT_JOB (job), NULL);
+
+  return job->priv->cancellable;
+}
+
 /**
  * gtk_print_job_get_surface:
  * @job: a #GtkPrintJob
@@ -494,6 +623,15 @@ gtk_print_job_get_surface (GtkPrintJob  *job,
     return priv->surface;
  
   g_return_val_if_fail (priv->spool_io == NULL, NULL);
+
+  if (priv->streaming &&
+      gtk_print_backend_get_supports_streaming (priv->backend))
+    {
+      if (!gtk_print_job_open_stream (job, error))
+        return NULL;
+
+      goto create_surface;
+    }
  
   fd = g_file_open_tmp ("gtkprint_XXXXXX", 
 			 &filename, 
@@ -514,10 +652,6 @@ gtk_print_job_get_surface (GtkPrintJob  *job,
 #endif /* G_ENABLE_DEBUG */
   g_unlink (filename);
   g_free (filename);
-
-  paper_size = gtk_page_setup_get_paper_size (priv->page_setup);
-  width = gtk_paper_size_get_width (paper_size, GTK_UNIT_POINTS);
-  height = gtk_paper_size_get_height (paper_size, GTK_UNIT_POINTS);
  
   priv->spool_io = g_io_channel_unix_new (fd);
   g_io_channel_set_close_on_unref (priv->spool_io, TRUE);
@@ -531,6 +665,11 @@ gtk_print_job_get_surface (GtkPrintJob  *job,
       return NULL;
     }
 
+create_surface:
+  paper_size = gtk_page_setup_get_paper_size (priv->page_setup);
+  width = gtk_paper_size_get_width (paper_size, GTK_UNIT_POINTS);
+  height = gtk_paper_size_get_height (paper_size, GTK_UNIT_POINTS);
+
   priv->surface = _gtk_printer_create_cairo_surface (priv->printer,
 						     priv->settings,
 						     width, height,
@@ -693,6 +832,28 @@ gtk_print_job_send (GtkPrintJob             *job,
 
   priv = job->priv;
   g_return_if_fail (priv->spool_io != NULL);
+
+  if (priv->stream_io != NULL)
+    {
+      g_return_if_fail (!priv->sent);
+
+      priv->sent = TRUE;
+      priv->send_callback = callback;
+      priv->send_user_data = user_data;
+      priv->send_dnotify = dnotify;
+
+      if (!priv->stream_done)
+        gtk_print_job_set_status (job, GTK_PRINT_STATUS_SENDING_DATA);
+
+      /* Closing our end is what tells the backend the data is complete */
+      g_io_channel_shutdown (priv->spool_io, TRUE, NULL);
+
+      /* The backend may have given up early */
+      if (priv->stream_done)
+        gtk_print_job_complete_send (job);
+
+      return;
+    }
   
   gtk_print_job_set_status (job, GTK_PRINT_STATUS_SENDING_DATA);
   
@@ -55,9 +55,19 @@ struct _GtkPrintOperationPrivate
   guint support_selection  : 1;
   guint has_selection      : 1;
   guint embed_page_setup   : 1;
+  guint threaded_drawing   : 1;
 
   GtkPageDrawingState      page_drawing_state;
 
+  /* With threaded drawing, the pages are drawn into recordings by
+   * draw_pool while earlier ones are printed; drawn_pages maps page
+   * numbers to ThreadedPages, which draw_lock protects */
+  GThreadPool *draw_pool;
+  GHashTable *drawn_pages;
+  GMutex draw_lock;
+  GCond draw_cond;
+  gint draw_cancelled;
+
   guint print_pages_idle_id;
   guint show_progress_timeout_id;
 
@@ -144,6 +154,10 @@ void             _gtk_print_context_set_hard_margins                (GtkPrintCon
 								     gdouble            bottom,
 								     gdouble            left,
 								     gdouble            right);
+GtkPrintContext *_gtk_print_context_new_for_page                    (GtkPrintContext   *context,
+								     GtkPageSetup      *page_setup);
+void             _gtk_print_context_paint_page                      (GtkPrintContext   *context,
+								     GtkPrintContext   *page_context);
 
 G_END_DECLS
 
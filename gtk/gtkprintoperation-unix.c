@@ -40,6 +40,7 @@
 #include "gtkpagesetupunixdialog.h"
 #include "gtkprintbackend.h"
 #include "gtkprinter.h"
+#include "gtkprinter-private.h"
 #include "gtkprintjob.h"
 #include "gtklabel.h"
 #include "gtkintl.h"
@@ -372,7 +373,11 @@ unix_end_run (GtkPrintOperation *op,
   cairo_surface_finish (op_unix->surface);
   
   if (cancelled)
-    return;
+    {
+      if (op_unix->job != NULL)
+        gtk_print_job_cancel_stream (op_unix->job);
+      return;
+    }
 
   if (wait)
     op_unix->loop = g_main_loop_new (NULL, FALSE);
@@ -568,6 +573,7 @@ finish_print (PrintResponseData *rdata,
 	  job = gtk_print_job_new (priv->job_name, printer, settings, page_setup);
           op_unix->job = job;
           gtk_print_job_set_track_print_status (job, priv->track_print_status);
+          gtk_print_job_set_streaming (job, TRUE);
 	  
 	  op_unix->surface = gtk_print_job_get_surface (job, &priv->error);
 	  if (op_unix->surface == NULL) 
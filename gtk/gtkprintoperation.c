@@ -141,7 +141,8 @@ enum
   PROP_EMBED_PAGE_SETUP,
   PROP_HAS_SELECTION,
   PROP_SUPPORT_SELECTION,
-  PROP_N_PAGES_TO_PRINT
+  PROP_N_PAGES_TO_PRINT,
+  PROP_THREADED_DRAWING
 };
 
 static guint signals[LAST_SIGNAL] = { 0 };
@@ -155,6 +156,7 @@ static void          common_render_page      (GtkPrintOperation             *op,
 static void          increment_page_sequence (PrintPagesData *data);
 static void          prepare_data            (PrintPagesData *data);
 static void          clamp_page_ranges       (PrintPagesData *data);
+static void          clear_threaded_pages    (GtkPrintOperation             *op);
 
 
 G_DEFINE_TYPE_WITH_CODE (GtkPrintOperation, gtk_print_operation, G_TYPE_OBJECT,
@@ -213,6 +215,10 @@ gtk_print_operation_finalize (GObject *object)
 
   if (priv->error)
     g_error_free (priv->error);
+
+  clear_threaded_pages (print_operation);
+  g_mutex_clear (&priv->draw_lock);
+  g_cond_clear (&priv->draw_cond);
   
   G_OBJECT_CLASS (gtk_print_operation_parent_class)->finalize (object);
 }
@@ -241,9 +247,13 @@ gtk_print_operation_init (GtkPrintOperation *operation)
   priv->support_selection = FALSE;
   priv->has_selection = FALSE;
   priv->embed_page_setup = FALSE;
+  priv->threaded_drawing = FALSE;
 
   priv->page_drawing_state = GTK_PAGE_DRAWING_STATE_READY;
 
+  g_mutex_init (&priv->draw_lock);
+  g_cond_init (&priv->draw_cond);
+
   priv->rloop = NULL;
   priv->unit = GTK_UNIT_NONE;
 
@@ -278,6 +288,8 @@ preview_iface_end_preview (GtkPrintOperationPreview *preview)
 
   g_signal_emit (op, signals[END_PRINT], 0, op->priv->print_context);
 
+  clear_threaded_pages (op);
+
   if (op->priv->rloop)
     g_main_loop_quit (op->priv->rloop);
   
@@ -418,6 +430,9 @@ gtk_print_operation_set_property (GObject      *object,
     case PROP_EMBED_PAGE_SETUP:
       gtk_print_operation_set_embed_page_setup (op, g_value_get_boolean (value));
       break;
+    case PROP_THREADED_DRAWING:
+      gtk_print_operation_set_threaded_drawing (op, g_value_get_boolean (value));
+      break;
     case PROP_HAS_SELECTION:
       gtk_print_operation_set_has_selection (op, g_value_get_boolean (value));
       break;
@@ -486,6 +501,9 @@ gtk_print_operation_get_property (GObject    *object,
     case PROP_EMBED_PAGE_SETUP:
       g_value_set_boolean (value, priv->embed_page_setup);
       break;
+    case PROP_THREADED_DRAWING:
+      g_value_set_boolean (value, priv->threaded_drawing);
+      break;
     case PROP_HAS_SELECTION:
       g_value_set_boolean (value, priv->has_selection);
       break;
@@ -1368,6 +1386,21 @@ gtk_print_operation_class_init (GtkPrintOperationClass *class)
 							 P_("TRUE if page setup combos are embedded in GtkPrintUnixDialog"),
 							 FALSE,
 							 GTK_PARAM_READWRITE|G_PARAM_EXPLICIT_NOTIFY));
+
+  /**
+   * GtkPrintOperation:threaded-drawing:
+   *
+   * If %TRUE, the #GtkPrintOperation::draw-page signal is emitted in
+   * worker threads, for several pages at once, and the results are
+   * printed in order. See gtk_print_operation_set_threaded_drawing().
+   */
+  g_object_class_install_property (gobject_class,
+				   PROP_THREADED_DRAWING,
+				   g_param_spec_boolean ("threaded-drawing",
+							 P_("Threaded Drawing"),
+							 P_("TRUE if pages are drawn in worker threads"),
+							 FALSE,
+							 GTK_PARAM_READWRITE|G_PARAM_EXPLICIT_NOTIFY));
   /**
    * GtkPrintOperation:n-pages-to-print:
    *
@@ -2246,6 +2279,8 @@ print_pages_idle_done (gpointer user_data)
 
   if (!data->is_preview)
     {
+      clear_threaded_pages (data->op);
+
       GtkPrintOperationResult result;
 
       if (priv->error)
@@ -2353,6 +2388,58 @@ gtk_print_operation_get_embed_page_setup (GtkPrintOperation *op)
   return op->priv->embed_page_setup;
 }
 
+/**
+ * gtk_print_operation_set_threaded_drawing:
+ * @op: a #GtkPrintOperation
+ * @threaded_drawing: %TRUE to draw pages in worker threads
+ *
+ * Lets @op draw several pages at the same time, using all processors.
+ *
+ * Once the operation is paginated, #GtkPrintOperation::request-page-setup
+ * is emitted for every page, then #GtkPrintOperation::draw-page is
+ * emitted from worker threads, each time with a separate #GtkPrintContext
+ * whose cairo context records the drawing. The recordings are printed,
+ * or shown in the preview, in page order on the main thread.
+ *
+ * Only enable this if your ::draw-page handler is thread-safe: it
+ * must only use the context it is given and data that does not change
+ * during the operation, and must not touch widgets. Deferred drawing
+ * with gtk_print_operation_set_defer_drawing() is not available then.
+ **/
+void
+gtk_print_operation_set_threaded_drawing (GtkPrintOperation *op,
+                                          gboolean           threaded_drawing)
+{
+  GtkPrintOperationPrivate *priv;
+
+  g_return_if_fail (GTK_IS_PRINT_OPERATION (op));
+
+  priv = op->priv;
+
+  threaded_drawing = threaded_drawing != FALSE;
+  if (priv->threaded_drawing != threaded_drawing)
+    {
+      priv->threaded_drawing = threaded_drawing;
+      g_object_notify (G_OBJECT (op), "threaded-drawing");
+    }
+}
+
+/**
+ * gtk_print_operation_get_threaded_drawing:
+ * @op: a #GtkPrintOperation
+ *
+ * Gets the value of #GtkPrintOperation:threaded-drawing property.
+ *
+ * Returns: whether pages are drawn in worker threads
+ */
+gboolean
+gtk_print_operation_get_threaded_drawing (GtkPrintOperation *op)
+{
+  g_return_val_if_fail (GTK_IS_PRINT_OPERATION (op), FALSE);
+
+  return op->priv->threaded_drawing;
+}
+
 /**
  * gtk_print_operation_draw_page_finish:
  * @op: a #GtkPrintOperation
@@ -2387,6 +2474,96 @@ gtk_print_operation_draw_page_finish (GtkPrintOperation *op)
   priv->page_drawing_state = GTK_PAGE_DRAWING_STATE_READY;
 }
 
+typedef struct
+{
+  gint page_nr;
+  GtkPrintContext *context;
+  gboolean done;
+} ThreadedPage;
+
+static void
+threaded_page_free (gpointer data)
+{
+  ThreadedPage *page = data;
+
+  g_object_unref (page->context);
+  g_slice_free (ThreadedPage, page);
+}
+
+static void
+draw_page_thread (gpointer data,
+                  gpointer user_data)
+{
+  ThreadedPage *page = data;
+  GtkPrintOperation *op = user_data;
+  GtkPrintOperationPrivate *priv = op->priv;
+
+  if (!g_atomic_int_get (&priv->draw_cancelled))
+    g_signal_emit (op, signals[DRAW_PAGE], 0, page->context, page->page_nr);
+
+  g_mutex_lock (&priv->draw_lock);
+  page->done = TRUE;
+  g_cond_broadcast (&priv->draw_cond);
+  g_mutex_unlock (&priv->draw_lock);
+}
+
+static void
+clear_threaded_pages (GtkPrintOperation *op)
+{
+  GtkPrintOperationPrivate *priv = op->priv;
+
+  if (priv->draw_pool)
+    {
+      /* Drop the pages that haven't started, and wait for the others */
+      g_atomic_int_set (&priv->draw_cancelled, TRUE);
+      g_thread_pool_free (priv->draw_pool, TRUE, TRUE);
+      priv->draw_pool = NULL;
+    }
+
+  g_clear_pointer (&priv->drawn_pages, g_hash_table_unref);
+  g_atomic_int_set (&priv->draw_cancelled, FALSE);
+}
+
+static void
+queue_threaded_pages (PrintPagesData *data)
+{
+  GtkPrintOperation *op = data->op;
+  GtkPrintOperationPrivate *priv = op->priv;
+  gint i;
+
+  clear_threaded_pages (op);
+
+  priv->drawn_pages = g_hash_table_new_full (NULL, NULL, NULL, threaded_page_free);
+  priv->draw_pool = g_thread_pool_new (draw_page_thread, op,
+                                       g_get_num_processors (), FALSE,
+                                       NULL);
+
+  /* The pool runs pages in the order they are queued, so queue
+   * them in the order they will be printed */
+  for (i = 0; i < priv->nr_of_pages_to_print; i++)
+    {
+      ThreadedPage *page;
+      GtkPageSetup *page_setup;
+      gint page_nr;
+
+      page_nr = data->pages[priv->manual_reverse ? priv->nr_of_pages_to_print - 1 - i : i];
+      if (g_hash_table_contains (priv->drawn_pages, GINT_TO_POINTER (page_nr)))
+        continue;
+
+      page_setup = create_page_setup (op);
+      g_signal_emit (op, signals[REQUEST_PAGE_SETUP], 0,
+                     priv->print_context, page_nr, page_setup);
+
+      page = g_slice_new0 (ThreadedPage);
+      page->page_nr = page_nr;
+      page->context = _gtk_print_context_new_for_page (priv->print_context, page_setup);
+      g_object_unref (page_setup);
+
+      g_hash_table_insert (priv->drawn_pages, GINT_TO_POINTER (page_nr), page);
+      g_thread_pool_push (priv->draw_pool, page, NULL);
+    }
+}
+
 static void
 common_render_page (GtkPrintOperation *op,
 		    gint               page_nr)
@@ -2394,14 +2571,25 @@ common_render_page (GtkPrintOperation *op,
   GtkPrintOperationPrivate *priv = op->priv;
   GtkPageSetup *page_setup;
   GtkPrintContext *print_context;
+  ThreadedPage *threaded_page = NULL;
   cairo_t *cr;
 
   print_context = priv->print_context;
-  
-  page_setup = create_page_setup (op);
-  
-  g_signal_emit (op, signals[REQUEST_PAGE_SETUP], 0, 
-		 print_context, page_nr, page_setup);
+
+  if (priv->drawn_pages)
+    threaded_page = g_hash_table_lookup (priv->drawn_pages, GINT_TO_POINTER (page_nr));
+
+  if (threaded_page)
+    {
+      page_setup = g_object_ref (gtk_print_context_get_page_setup (threaded_page->context));
+    }
+  else
+    {
+      page_setup = create_page_setup (op);
+
+      g_signal_emit (op, signals[REQUEST_PAGE_SETUP], 0,
+                     print_context, page_nr, page_setup);
+    }
   
   _gtk_print_context_set_page_setup (print_context, page_setup);
   
@@ -2605,6 +2793,18 @@ common_render_page (GtkPrintOperation *op,
         }
     }
   
+  if (threaded_page)
+    {
+      g_mutex_lock (&priv->draw_lock);
+      while (!threaded_page->done)
+        g_cond_wait (&priv->draw_cond, &priv->draw_lock);
+      g_mutex_unlock (&priv->draw_lock);
+
+      _gtk_print_context_paint_page (print_context, threaded_page->context);
+      gtk_print_operation_draw_page_finish (op);
+      return;
+    }
+
   priv->page_drawing_state = GTK_PAGE_DRAWING_STATE_DRAWING;
 
   g_signal_emit (op, signals[DRAW_PAGE], 0, 
@@ -2777,6 +2977,8 @@ prepare_data (PrintPagesData *data)
         data->last_position = priv->nr_of_pages_to_print - 1;
     }
 
+  if (priv->threaded_drawing)
+    queue_threaded_pages (data);
 
   _gtk_print_operation_set_status (data->op, 
                                    GTK_PRINT_STATUS_GENERATING_DATA, 
@@ -3188,6 +3390,7 @@ gtk_print_operation_cancel (GtkPrintOperation *op)
   g_return_if_fail (GTK_IS_PRINT_OPERATION (op));
   
   op->priv->cancelled = TRUE;
+  g_atomic_int_set (&op->priv->draw_cancelled, TRUE);
 }
 
 /**
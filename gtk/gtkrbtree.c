@@ -21,6 +21,8 @@
 
 #include "gtkdebug.h"
 
+#include <string.h>
+
 /* Define the following to print adds and removals to stdout.
  * The format of the printout will be suitable for addition as a new test to
  * testsuite/gtk/rbtree-crash.c
@@ -30,7 +32,21 @@
  */
 #undef DUMP_MODIFICATION
 
+/* Bulk operations touching at least 1/REBUILD_FACTOR of the tree rebuild
+ * it from scratch in O(n) instead of doing O(log n) work per node */
+#define REBUILD_FACTOR 8
+
+/* Nodes are allocated from chunks owned by the tree. The chunk size
+ * doubles from MIN_CHUNK_NODES up to MAX_CHUNK_NODES nodes. */
+#define MIN_CHUNK_NODES 4
+#define MAX_CHUNK_NODES 1024
+
+/* Nodes and trees are aligned to this, so that the lowest bits of
+ * pointers to them can be used as flags */
+#define NODE_ALIGNMENT 8
+
 typedef struct _GtkRbNode GtkRbNode;
+typedef struct _GtkRbChunk GtkRbChunk;
 
 struct _GtkRbTree
 {
@@ -43,24 +59,38 @@ struct _GtkRbTree
   GDestroyNotify clear_augment_func;
 
   GtkRbNode *root;
+  gsize n_nodes;
+
+  gsize node_size;
+  GtkRbChunk *chunks; /* most recently allocated first */
+  gsize chunk_used; /* number of nodes handed out from the first chunk */
+  GtkRbNode *free_nodes; /* linked via their left pointer */
 };
 
-struct _GtkRbNode
+struct _GtkRbChunk
 {
-  guint red :1;
-  guint dirty :1;
+  GtkRbChunk *next;
+  gsize n_nodes;
+  /* nodes follow here */
+};
 
+struct _GtkRbNode
+{
   GtkRbNode *left;
   GtkRbNode *right;
-  /* The difference between tree and parent here is that we OR the tree with 1 and because
-   * pointers are always multiples of 4, we can know if we've stored a parent or the tree here */
-  union {
-    gpointer parent_or_tree;
-    GtkRbNode *parent;
-    GtkRbTree *tree;
-  };
+  /* The parent node or for the root node the tree, ORed with the
+   * NODE_* flags below */
+  gsize parent_and_flags;
 };
 
+#define NODE_ROOT  1
+#define NODE_RED   2
+#define NODE_DIRTY 4
+#define NODE_FLAGS (NODE_ROOT | NODE_RED | NODE_DIRTY)
+
+G_STATIC_ASSERT (NODE_FLAGS < NODE_ALIGNMENT);
+G_STATIC_ASSERT (sizeof (GtkRbChunk) % NODE_ALIGNMENT == 0);
+
 #define NODE_FROM_POINTER(ptr) ((GtkRbNode *) ((ptr) ? (((guchar *) (ptr)) - sizeof (GtkRbNode)) : NULL))
 #define NODE_TO_POINTER(node) ((gpointer) ((node) ? (((guchar *) (node)) + sizeof (GtkRbNode)) : NULL))
 #define NODE_TO_AUG_POINTER(tree, node) ((gpointer) ((node) ? (((guchar *) (node)) + sizeof (GtkRbNode) + (tree)->element_size) : NULL))
@@ -68,7 +98,7 @@ struct _GtkRbNode
 static inline gboolean
 is_root (GtkRbNode *node)
 {
-  return GPOINTER_TO_SIZE (node->parent_or_tree) & 1 ? TRUE : FALSE;
+  return node->parent_and_flags & NODE_ROOT ? TRUE : FALSE;
 }
 
 static inline GtkRbNode *
@@ -77,7 +107,7 @@ parent (GtkRbNode *node)
   if (is_root (node))
     return NULL;
   else
-    return node->parent;
+    return GSIZE_TO_POINTER (node->parent_and_flags & ~NODE_FLAGS);
 }
 
 static GtkRbTree *
@@ -86,7 +116,7 @@ tree (GtkRbNode *node)
   while (!is_root (node))
     node = parent (node);
 
-  return GSIZE_TO_POINTER (GPOINTER_TO_SIZE (node->tree) & ~1);
+  return GSIZE_TO_POINTER (node->parent_and_flags & ~NODE_FLAGS);
 }
 
 static void
@@ -94,22 +124,23 @@ set_parent (GtkRbTree *tree,
             GtkRbNode *node,
             GtkRbNode *new_parent)
 {
+  gsize flags = node->parent_and_flags & (NODE_RED | NODE_DIRTY);
 
   if (new_parent != NULL)
     {
-      node->parent = new_parent;
+      node->parent_and_flags = GPOINTER_TO_SIZE (new_parent) | flags;
     }
   else
     {
-      node->tree = GSIZE_TO_POINTER (GPOINTER_TO_SIZE (tree) | 1);
+      node->parent_and_flags = GPOINTER_TO_SIZE (tree) | NODE_ROOT | flags;
       tree->root = node;
     }
 }
 
-static inline gsize
-gtk_rb_node_get_size (GtkRbTree *tree)
+static inline gboolean
+is_dirty (GtkRbNode *node)
 {
-  return sizeof (GtkRbNode) + tree->element_size + tree->augment_size;
+  return node->parent_and_flags & NODE_DIRTY ? TRUE : FALSE;
 }
 
 static GtkRbNode *
@@ -117,49 +148,100 @@ gtk_rb_node_new (GtkRbTree *tree)
 {
   GtkRbNode *result;
 
-  result = g_slice_alloc0 (gtk_rb_node_get_size (tree));
+  if (tree->free_nodes)
+    {
+      result = tree->free_nodes;
+      tree->free_nodes = result->left;
+    }
+  else
+    {
+      if (tree->chunks == NULL || tree->chunk_used == tree->chunks->n_nodes)
+        {
+          GtkRbChunk *chunk;
+          gsize n_nodes;
+
+          if (tree->chunks)
+            n_nodes = MIN (2 * tree->chunks->n_nodes, MAX_CHUNK_NODES);
+          else
+            n_nodes = MIN_CHUNK_NODES;
+
+          chunk = g_malloc (sizeof (GtkRbChunk) + n_nodes * tree->node_size);
+          chunk->next = tree->chunks;
+          chunk->n_nodes = n_nodes;
+          tree->chunks = chunk;
+          tree->chunk_used = 0;
+        }
+
+      result = (GtkRbNode *) ((guchar *) (tree->chunks + 1) + tree->chunk_used * tree->node_size);
+      tree->chunk_used++;
+    }
 
-  result->red = TRUE;
-  result->dirty = TRUE;
+  memset (result, 0, tree->node_size);
+  result->parent_and_flags = NODE_RED | NODE_DIRTY;
 
   return result;
 }
 
 static void
-gtk_rb_node_free (GtkRbTree *tree,
-                  GtkRbNode *node)
+gtk_rb_node_clear (GtkRbTree *tree,
+                   GtkRbNode *node)
 {
   if (tree->clear_func)
     tree->clear_func (NODE_TO_POINTER (node));
   if (tree->clear_augment_func)
     tree->clear_augment_func (NODE_TO_AUG_POINTER (tree, node));
+}
 
-  g_slice_free1 (gtk_rb_node_get_size (tree), node);
+static void
+gtk_rb_node_free (GtkRbTree *tree,
+                  GtkRbNode *node)
+{
+  gtk_rb_node_clear (tree, node);
+
+  node->left = tree->free_nodes;
+  tree->free_nodes = node;
 }
 
 static void
-gtk_rb_node_free_deep (GtkRbTree *tree,
-                       GtkRbNode *node)
+gtk_rb_node_clear_deep (GtkRbTree *tree,
+                        GtkRbNode *node)
 {
   GtkRbNode *right = node->right;
 
   if (node->left)
-    gtk_rb_node_free_deep (tree, node->left);
+    gtk_rb_node_clear_deep (tree, node->left);
 
-  gtk_rb_node_free (tree, node);
+  gtk_rb_node_clear (tree, node);
 
   if (right)
-    gtk_rb_node_free_deep (tree, right);
+    gtk_rb_node_clear_deep (tree, right);
+}
+
+/* Frees all nodes at once, they must have been cleared */
+static void
+gtk_rb_tree_free_chunks (GtkRbTree *tree)
+{
+  GtkRbChunk *chunk, *next;
+
+  for (chunk = tree->chunks; chunk; chunk = next)
+    {
+      next = chunk->next;
+      g_free (chunk);
+    }
+
+  tree->chunks = NULL;
+  tree->chunk_used = 0;
+  tree->free_nodes = NULL;
 }
 
 static void
 gtk_rb_node_mark_dirty (GtkRbNode *node,
                         gboolean   mark_parent)
 {
-  if (node->dirty)
+  if (is_dirty (node))
     return;
-  
-  node->dirty = TRUE;
+
+  node->parent_and_flags |= NODE_DIRTY;
 
   if (mark_parent && parent (node))
     gtk_rb_node_mark_dirty (parent (node), TRUE);
@@ -169,10 +251,10 @@ static void
 gtk_rb_node_clean (GtkRbTree *tree,
                    GtkRbNode *node)
 {
-  if (!node->dirty)
+  if (!is_dirty (node))
     return;
 
-  node->dirty = FALSE;
+  node->parent_and_flags &= ~NODE_DIRTY;
   if (tree->augment_func)
     tree->augment_func (tree,
                         NODE_TO_AUG_POINTER (tree, node),
@@ -320,7 +402,7 @@ is_red (GtkRbNode *node_or_null)
   if (node_or_null == NULL)
     return FALSE;
   else
-    return node_or_null->red;
+    return node_or_null->parent_and_flags & NODE_RED ? TRUE : FALSE;
 }
 
 static inline gboolean
@@ -335,7 +417,7 @@ set_black (GtkRbNode *node_or_null)
   if (node_or_null == NULL)
     return;
 
-  node_or_null->red = FALSE;
+  node_or_null->parent_and_flags &= ~NODE_RED;
 }
 
 static void
@@ -344,7 +426,7 @@ set_red (GtkRbNode *node_or_null)
   if (node_or_null == NULL)
     return;
 
-  node_or_null->red = TRUE;
+  node_or_null->parent_and_flags |= NODE_RED;
 }
 
 static void
@@ -457,7 +539,10 @@ gtk_rb_tree_remove_node_fixup (GtkRbTree *tree,
 		  gtk_rb_node_rotate_right (tree, w);
 		  w = p->right;
 		}
-	      w->red = p->red;
+	      if (is_red (p))
+	        set_red (w);
+	      else
+	        set_black (w);
 	      set_black (p);
               set_black (w->right);
 	      gtk_rb_node_rotate_left (tree, p);
@@ -488,7 +573,10 @@ gtk_rb_tree_remove_node_fixup (GtkRbTree *tree,
 		  gtk_rb_node_rotate_left (tree, w);
 		  w = p->left;
 		}
-	      w->red = p->red;
+	      if (is_red (p))
+	        set_red (w);
+	      else
+	        set_black (w);
 	      set_black (p);
 	      set_black (w->left);
 	      gtk_rb_node_rotate_right (tree, p);
@@ -502,6 +590,63 @@ gtk_rb_tree_remove_node_fixup (GtkRbTree *tree,
   set_black (node);
 }
 
+/* Links @nodes into a balanced tree. The depths of the leaves differ by
+ * at most one, so coloring the nodes on the deepest level red and all
+ * others black gives a valid red-black tree. */
+static GtkRbNode *
+gtk_rb_node_build (GtkRbNode **nodes,
+                   gsize       n_nodes,
+                   guint       depth,
+                   guint       red_depth)
+{
+  GtkRbNode *node;
+  gsize mid;
+
+  if (n_nodes == 0)
+    return NULL;
+
+  mid = n_nodes / 2;
+  node = nodes[mid];
+  node->parent_and_flags = NODE_DIRTY | (depth == red_depth ? NODE_RED : 0);
+
+  node->left = gtk_rb_node_build (nodes, mid, depth + 1, red_depth);
+  if (node->left)
+    set_parent (NULL, node->left, node);
+  node->right = gtk_rb_node_build (nodes + mid + 1, n_nodes - mid - 1, depth + 1, red_depth);
+  if (node->right)
+    set_parent (NULL, node->right, node);
+
+  return node;
+}
+
+/* Replaces the tree's contents with @nodes in O(n) */
+static void
+gtk_rb_tree_rebuild (GtkRbTree  *tree,
+                     GtkRbNode **nodes,
+                     gsize       n_nodes)
+{
+  GtkRbNode *root;
+
+  tree->n_nodes = n_nodes;
+
+  if (n_nodes == 0)
+    {
+      tree->root = NULL;
+      return;
+    }
+
+  root = gtk_rb_node_build (nodes, n_nodes, 0, g_bit_storage (n_nodes) - 1);
+  set_parent (tree, root, NULL);
+  set_black (root);
+}
+
+static gboolean
+gtk_rb_tree_should_rebuild (GtkRbTree *tree,
+                            gsize      n_changed)
+{
+  return n_changed * REBUILD_FACTOR >= tree->n_nodes;
+}
+
 GtkRbTree *
 gtk_rb_tree_new_for_size (gsize                element_size,
                           gsize                augment_size,
@@ -514,11 +659,15 @@ gtk_rb_tree_new_for_size (gsize                element_size,
   tree = g_slice_new0 (GtkRbTree);
   tree->ref_count = 1;
 
+  g_assert (GPOINTER_TO_SIZE (tree) % NODE_ALIGNMENT == 0);
+
   tree->element_size = element_size;
   tree->augment_size = augment_size;
   tree->augment_func = augment_func;
   tree->clear_func = clear_func;
   tree->clear_augment_func = clear_augment_func;
+  tree->node_size = sizeof (GtkRbNode) + element_size + augment_size;
+  tree->node_size = (tree->node_size + NODE_ALIGNMENT - 1) & ~(gsize) (NODE_ALIGNMENT - 1);
 
   return tree;
 }
@@ -539,8 +688,9 @@ gtk_rb_tree_unref (GtkRbTree *tree)
     return;
 
   if (tree->root)
-    gtk_rb_node_free_deep (tree, tree->root);
-    
+    gtk_rb_node_clear_deep (tree, tree->root);
+  gtk_rb_tree_free_chunks (tree);
+
   g_slice_free (GtkRbTree, tree);
 }
 
@@ -637,7 +787,8 @@ gtk_rb_tree_insert_before (GtkRbTree *tree,
       g_assert (node == NULL);
 
       result = gtk_rb_node_new (tree);
-      tree->root = result;
+      set_parent (tree, result, NULL);
+      tree->n_nodes++;
     }
   else if (node == NULL)
     {
@@ -653,6 +804,7 @@ gtk_rb_tree_insert_before (GtkRbTree *tree,
 
       /* setup new node */
       result = gtk_rb_node_new (tree);
+      tree->n_nodes++;
 
       if (current->left)
         {
@@ -689,6 +841,7 @@ gtk_rb_tree_insert_after (GtkRbTree *tree,
 
   /* setup new node */
   result = gtk_rb_node_new (tree);
+  tree->n_nodes++;
 
   if (current->right)
     {
@@ -760,8 +913,10 @@ gtk_rb_tree_remove (GtkRbTree *tree,
   if (y != real_node)
     {
       /* Move the node over */
-      if (is_red (real_node) != is_red (y))
-	y->red = !y->red;
+      if (is_red (real_node))
+	set_red (y);
+      else
+	set_black (y);
 
       y->left = real_node->left;
       if (y->left)
@@ -782,6 +937,7 @@ gtk_rb_tree_remove (GtkRbTree *tree,
       gtk_rb_node_mark_dirty (y, TRUE);
     }
 
+  tree->n_nodes--;
   gtk_rb_node_free (tree, real_node);
 }
 
@@ -793,8 +949,124 @@ gtk_rb_tree_remove_all (GtkRbTree *tree)
 #endif /* DUMP_MODIFICATION */
 
   if (tree->root)
-    gtk_rb_node_free_deep (tree, tree->root);
+    gtk_rb_node_clear_deep (tree, tree->root);
+  gtk_rb_tree_free_chunks (tree);
 
   tree->root = NULL;
+  tree->n_nodes = 0;
 }
 
+
+/* Inserts @n_nodes new nodes before @node, or appends them if @node is
+ * %NULL, and returns the first one. Equivalent to, but for many nodes
+ * faster than calling gtk_rb_tree_insert_before() @n_nodes times.
+ */
+gpointer
+gtk_rb_tree_insert_many_before (GtkRbTree *tree,
+                                gpointer   node,
+                                gsize      n_nodes)
+{
+  GtkRbNode **nodes, *current, *before, *result;
+  gsize i, n, first;
+
+  if (n_nodes == 0)
+    return NULL;
+
+  if (!gtk_rb_tree_should_rebuild (tree, n_nodes))
+    {
+      gpointer first_node, last_node;
+
+      first_node = last_node = gtk_rb_tree_insert_before (tree, node);
+      for (i = 1; i < n_nodes; i++)
+        last_node = gtk_rb_tree_insert_after (tree, last_node);
+
+      return first_node;
+    }
+
+  before = NODE_FROM_POINTER (node);
+  nodes = g_new (GtkRbNode *, tree->n_nodes + n_nodes);
+  n = 0;
+
+  current = tree->root ? gtk_rb_node_get_first (tree->root) : NULL;
+  for (; current != before; current = gtk_rb_node_get_next (current))
+    nodes[n++] = current;
+
+#ifdef DUMP_MODIFICATION
+  for (i = 0; i < n_nodes; i++)
+    g_print ("add (tree, %" G_GSIZE_FORMAT "); /* 0x%p */\n", n + i, tree);
+#endif /* DUMP_MODIFICATION */
+
+  first = n;
+  for (i = 0; i < n_nodes; i++)
+    nodes[n++] = gtk_rb_node_new (tree);
+
+  for (; current != NULL; current = gtk_rb_node_get_next (current))
+    nodes[n++] = current;
+
+  gtk_rb_tree_rebuild (tree, nodes, n);
+  result = nodes[first];
+
+  g_free (nodes);
+
+  return NODE_TO_POINTER (result);
+}
+
+/* Removes @node and the @n_nodes - 1 nodes following it */
+void
+gtk_rb_tree_remove_many (GtkRbTree *tree,
+                         gpointer   node,
+                         gsize      n_nodes)
+{
+  GtkRbNode **nodes, **removed, *current, *first;
+  gsize i, n;
+
+  if (n_nodes == 0)
+    return;
+
+  if (!gtk_rb_tree_should_rebuild (tree, n_nodes))
+    {
+      for (i = 0; i < n_nodes; i++)
+        {
+          gpointer next = gtk_rb_tree_node_get_next (node);
+          gtk_rb_tree_remove (tree, node);
+          node = next;
+        }
+
+      return;
+    }
+
+  first = NODE_FROM_POINTER (node);
+  g_assert (n_nodes <= tree->n_nodes);
+  nodes = g_new (GtkRbNode *, tree->n_nodes);
+  removed = g_new (GtkRbNode *, n_nodes);
+  n = 0;
+
+  for (current = gtk_rb_node_get_first (tree->root);
+       current != first;
+       current = gtk_rb_node_get_next (current))
+    nodes[n++] = current;
+
+#ifdef DUMP_MODIFICATION
+  for (i = 0; i < n_nodes; i++)
+    g_print ("delete (tree, %" G_GSIZE_FORMAT "); /* 0x%p */\n", n, tree);
+#endif /* DUMP_MODIFICATION */
+
+  for (i = 0; i < n_nodes; i++)
+    {
+      g_assert (current != NULL);
+      removed[i] = current;
+      current = gtk_rb_node_get_next (current);
+    }
+
+  for (; current != NULL; current = gtk_rb_node_get_next (current))
+    nodes[n++] = current;
+
+  gtk_rb_tree_rebuild (tree, nodes, n);
+
+  /* free the nodes only after the tree is consistent again */
+  for (i = 0; i < n_nodes; i++)
+    gtk_rb_node_free (tree, removed[i]);
+
+  g_free (removed);
+  g_free (nodes);
+}
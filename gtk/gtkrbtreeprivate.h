@@ -64,8 +64,14 @@ gpointer             gtk_rb_tree_insert_before          (GtkRbTree
                                                          gpointer                 node);
 gpointer             gtk_rb_tree_insert_after           (GtkRbTree               *tree,
                                                          gpointer                 node);
+gpointer             gtk_rb_tree_insert_many_before     (GtkRbTree               *tree,
+                                                         gpointer                 node,
+                                                         gsize                    n_nodes);
 void                 gtk_rb_tree_remove                 (GtkRbTree               *tree,
                                                          gpointer                 node);
+void                 gtk_rb_tree_remove_many            (GtkRbTree               *tree,
+                                                         gpointer                 node,
+                                                         gsize                    n_nodes);
 void                 gtk_rb_tree_remove_all             (GtkRbTree               *tree);
 
 
@@ -23,12 +23,19 @@
 
 #include "gtksnapshot.h"
 
+#include "gsk/gskrendernodeprivate.h"
+
 struct _GtkRenderNodePaintable
 {
   GObject parent_instance;
 
   GskRenderNode *node;
   graphene_rect_t bounds;
+
+  /* node clipped to bounds with a cache hint, appended by every
+   * snapshot so renderers can draw all of them from one texture */
+  GskRenderNode *cached_node;
+  guint cached : 1;
 };
 
 struct _GtkRenderNodePaintableClass
@@ -66,12 +73,25 @@ gtk_render_node_paintable_paintable_snapshot (GdkPaintable *paintable,
 
   gtk_snapshot_offset (snapshot, -self->bounds.origin.x, -self->bounds.origin.y);
 
-  gtk_snapshot_push_clip (snapshot, &self->bounds);
+  if (self->cached)
+    {
+      if (self->cached_node == NULL)
+        {
+          self->cached_node = gsk_clip_node_new (self->node, &self->bounds);
+          gsk_render_node_set_cache_hint (self->cached_node, TRUE);
+        }
+
+      gtk_snapshot_append_node (snapshot, self->cached_node);
+    }
+  else
+    {
+      gtk_snapshot_push_clip (snapshot, &self->bounds);
 
-  gtk_snapshot_append_node (snapshot, self->node);
-  //gtk_snapshot_append_color (snapshot, &(GdkRGBA) { 1, 0, 0, 1 }, &self->bounds);
+      gtk_snapshot_append_node (snapshot, self->node);
+      //gtk_snapshot_append_color (snapshot, &(GdkRGBA) { 1, 0, 0, 1 }, &self->bounds);
 
-  gtk_snapshot_pop (snapshot);
+      gtk_snapshot_pop (snapshot);
+    }
 
   gtk_snapshot_offset (snapshot, self->bounds.origin.x, self->bounds.origin.y);
 
@@ -120,6 +140,7 @@ gtk_render_node_paintable_dispose (GObject *object)
   GtkRenderNodePaintable *self = GTK_RENDER_NODE_PAINTABLE (object);
 
   g_clear_pointer (&self->node, gsk_render_node_unref);
+  g_clear_pointer (&self->cached_node, gsk_render_node_unref);
 
   G_OBJECT_CLASS (gtk_render_node_paintable_parent_class)->dispose (object);
 }
@@ -161,3 +182,18 @@ gtk_render_node_paintable_get_render_node (GtkRenderNodePaintable *self)
 
   return self->node;
 }
+
+/* Makes renderers draw @self from a texture that is rendered once per
+ * scale and shared by all places @self is drawn in. Use it for
+ * paintables that are drawn many times, like CSS images.
+ */
+void
+gtk_render_node_paintable_set_cached (GtkRenderNodePaintable *self,
+                                      gboolean                cached)
+{
+  g_return_if_fail (GTK_IS_RENDER_NODE_PAINTABLE (self));
+
+  self->cached = cached != FALSE;
+  if (!self->cached)
+    g_clear_pointer (&self->cached_node, gsk_render_node_unref);
+}
@@ -32,6 +32,8 @@ GdkPaintable *  gtk_render_node_paintable_new   (GskRenderNode         *node,
                                                  const graphene_rect_t *bounds);
 
 GskRenderNode * gtk_render_node_paintable_get_render_node       (GtkRenderNodePaintable *self);
+void            gtk_render_node_paintable_set_cached            (GtkRenderNodePaintable *self,
+                                                                 gboolean                cached);
 
 G_END_DECLS
 
@@ -329,6 +329,7 @@ static void     gtk_scrolled_window_add                (GtkContainer      *conta
                                                         GtkWidget         *widget);
 static void     gtk_scrolled_window_remove             (GtkContainer      *container,
                                                         GtkWidget         *widget);
+static void     gtk_scrolled_window_update_relayout_boundary (GtkScrolledWindow *scrolled_window);
 static gboolean gtk_scrolled_window_scroll_child       (GtkScrolledWindow *scrolled_window,
                                                         GtkScrollType      scroll,
                                                         gboolean           horizontal);
@@ -1961,6 +1962,7 @@ gtk_scrolled_window_init (GtkScrolledWindow *scrolled_window)
       priv->overshoot_node[i] = gtk_css_node_new ();
       gtk_css_node_set_name (priv->overshoot_node[i], I_("overshoot"));
       gtk_css_node_add_class (priv->overshoot_node[i], classes[i]);
+      gtk_css_node_set_lazy (priv->overshoot_node[i], TRUE);
       gtk_css_node_set_parent (priv->overshoot_node[i], widget_node);
       gtk_css_node_set_state (priv->overshoot_node[i], gtk_css_node_get_state (widget_node));
       g_object_unref (priv->overshoot_node[i]);
@@ -1968,6 +1970,7 @@ gtk_scrolled_window_init (GtkScrolledWindow *scrolled_window)
       priv->undershoot_node[i] = gtk_css_node_new ();
       gtk_css_node_set_name (priv->undershoot_node[i], I_("undershoot"));
       gtk_css_node_add_class (priv->undershoot_node[i], classes[i]);
+      gtk_css_node_set_lazy (priv->undershoot_node[i], TRUE);
       gtk_css_node_set_parent (priv->undershoot_node[i], widget_node);
       gtk_css_node_set_state (priv->undershoot_node[i], gtk_css_node_get_state (widget_node));
       g_object_unref (priv->undershoot_node[i]);
@@ -2281,6 +2284,7 @@ gtk_scrolled_window_set_policy (GtkScrolledWindow *scrolled_window,
       priv->hscrollbar_policy = hscrollbar_policy;
       priv->vscrollbar_policy = vscrollbar_policy;
 
+      gtk_scrolled_window_update_relayout_boundary (scrolled_window);
       gtk_widget_queue_resize (GTK_WIDGET (scrolled_window));
 
       g_object_notify_by_pspec (object, properties[PROP_HSCROLLBAR_POLICY]);
@@ -3459,6 +3463,30 @@ gtk_scrolled_window_adjustment_value_changed (GtkAdjustment *adjustment,
     priv->unclamped_vadj_value = gtk_adjustment_get_value (adjustment);
 }
 
+/* The size request only depends on the child when a scrollbar is
+ * disabled, natural sizes are propagated or the child has a border
+ * outside of the scrolled area. Otherwise changes in the child don't
+ * need to be propagated any further than us.
+ */
+static void
+gtk_scrolled_window_update_relayout_boundary (GtkScrolledWindow *scrolled_window)
+{
+  GtkScrolledWindowPrivate *priv = gtk_scrolled_window_get_instance_private (scrolled_window);
+  GtkWidget *child;
+  GtkBorder border;
+
+  child = gtk_bin_get_child (GTK_BIN (scrolled_window));
+  if (child == NULL)
+    return;
+
+  gtk_widget_set_parent_is_relayout_boundary (child,
+                                              priv->hscrollbar_policy != GTK_POLICY_NEVER &&
+                                              priv->vscrollbar_policy != GTK_POLICY_NEVER &&
+                                              !priv->propagate_natural_width &&
+                                              !priv->propagate_natural_height &&
+                                              !gtk_scrollable_get_border (GTK_SCROLLABLE (child), &border));
+}
+
 static void
 gtk_scrolled_window_add (GtkContainer *container,
                          GtkWidget    *child)
@@ -3504,6 +3532,8 @@ gtk_scrolled_window_add (GtkContainer *container,
   gtk_widget_insert_after (scrollable_child, GTK_WIDGET (bin), NULL);
 
   g_object_set (scrollable_child, "hadjustment", hadj, "vadjustment", vadj, NULL);
+
+  gtk_scrolled_window_update_relayout_boundary (scrolled_window);
 }
 
 static void
@@ -4098,6 +4128,7 @@ gtk_scrolled_window_set_propagate_natural_width (GtkScrolledWindow *scrolled_win
   if (priv->propagate_natural_width != propagate)
     {
       priv->propagate_natural_width = propagate;
+      gtk_scrolled_window_update_relayout_boundary (scrolled_window);
       g_object_notify_by_pspec (G_OBJECT (scrolled_window), properties [PROP_PROPAGATE_NATURAL_WIDTH]);
       gtk_widget_queue_resize (GTK_WIDGET (scrolled_window));
     }
@@ -4143,6 +4174,7 @@ gtk_scrolled_window_set_propagate_natural_height (GtkScrolledWindow *scrolled_wi
   if (priv->propagate_natural_height != propagate)
     {
       priv->propagate_natural_height = propagate;
+      gtk_scrolled_window_update_relayout_boundary (scrolled_window);
       g_object_notify_by_pspec (G_OBJECT (scrolled_window), properties [PROP_PROPAGATE_NATURAL_HEIGHT]);
       gtk_widget_queue_resize (GTK_WIDGET (scrolled_window));
     }
@@ -50,6 +50,10 @@ struct _GtkSearchEnginePrivate {
   gboolean recursive;
   GHashTable *hits;
 
+  /* Hits that have not been reported yet, owned by @hits */
+  GList *pending_hits;
+  guint flush_id;
+
   GtkQuery *query;
 };
 
@@ -65,6 +69,57 @@ static guint signals[LAST_SIGNAL];
 
 G_DEFINE_TYPE_WITH_PRIVATE (GtkSearchEngine, _gtk_search_engine, G_TYPE_OBJECT);
 
+/* Hits from the engines are collected and reported at most this often,
+ * in milliseconds, so that a fast search causes one model update per
+ * interval instead of one per directory.
+ */
+#define HITS_FLUSH_INTERVAL 100
+
+static void
+flush_hits (GtkSearchEngine *engine)
+{
+  GList *hits;
+
+  if (engine->priv->flush_id)
+    {
+      g_source_remove (engine->priv->flush_id);
+      engine->priv->flush_id = 0;
+    }
+
+  if (engine->priv->pending_hits == NULL)
+    return;
+
+  hits = g_list_reverse (engine->priv->pending_hits);
+  engine->priv->pending_hits = NULL;
+
+  _gtk_search_engine_hits_added (engine, hits);
+  g_list_free (hits);
+}
+
+static gboolean
+flush_hits_timeout (gpointer data)
+{
+  GtkSearchEngine *engine = data;
+
+  engine->priv->flush_id = 0;
+  flush_hits (engine);
+
+  return G_SOURCE_REMOVE;
+}
+
+static void
+clear_hits (GtkSearchEngine *engine)
+{
+  if (engine->priv->flush_id)
+    {
+      g_source_remove (engine->priv->flush_id);
+      engine->priv->flush_id = 0;
+    }
+
+  g_clear_pointer (&engine->priv->pending_hits, g_list_free);
+  g_hash_table_remove_all (engine->priv->hits);
+}
+
 static void
 set_query (GtkSearchEngine *engine,
            GtkQuery        *query)
@@ -84,7 +139,7 @@ set_query (GtkSearchEngine *engine,
 static void
 start (GtkSearchEngine *engine)
 {
-  g_hash_table_remove_all (engine->priv->hits);
+  clear_hits (engine);
 
   if (engine->priv->native)
     {
@@ -133,7 +188,7 @@ stop (GtkSearchEngine *engine)
 
   engine->priv->running = FALSE;
 
-  g_hash_table_remove_all (engine->priv->hits);
+  clear_hits (engine);
 }
 
 static void
@@ -150,6 +205,7 @@ finalize (GObject *object)
   g_clear_object (&engine->priv->model);
   g_free (engine->priv->model_error);
 
+  clear_hits (engine);
   g_clear_pointer (&engine->priv->hits, g_hash_table_unref);
 
   g_clear_object (&engine->priv->query);
@@ -206,33 +262,65 @@ _gtk_search_engine_init (GtkSearchEngine *engine)
   engine->priv->recursive = TRUE;
 }
 
+static void update_status (GtkSearchEngine *engine);
+
+static void
+stop_engines (GtkSearchEngine *composite)
+{
+  if (composite->priv->native && composite->priv->native_running)
+    {
+      _gtk_search_engine_stop (composite->priv->native);
+      composite->priv->native_running = FALSE;
+    }
+
+  if (composite->priv->simple && composite->priv->simple_running)
+    {
+      _gtk_search_engine_stop (composite->priv->simple);
+      composite->priv->simple_running = FALSE;
+    }
+
+  if (composite->priv->model && composite->priv->model_running)
+    {
+      _gtk_search_engine_stop (composite->priv->model);
+      composite->priv->model_running = FALSE;
+    }
+}
+
 static void
 hits_added (GtkSearchEngine *engine,
             GList           *hits,
             gpointer         data)
 {
   GtkSearchEngine *composite = GTK_SEARCH_ENGINE (data);
-  GList *added, *l;
+  GList *l;
   GtkSearchHit *hit;
 
-  added = NULL;
-
   for (l = hits; l; l = l->next)
     {
       hit = l->data;
 
+      if (g_hash_table_size (composite->priv->hits) >= GTK_SEARCH_ENGINE_MAX_HITS)
+        {
+          /* Nobody is going to look through more hits, so stop
+           * searching instead of wasting time on them.
+           */
+          stop_engines (composite);
+          update_status (composite);
+          return;
+        }
+
       if (!g_hash_table_contains (composite->priv->hits, hit))
         {
           hit = _gtk_search_hit_dup (hit);
           g_hash_table_add (composite->priv->hits, hit);
-          added = g_list_prepend (added, hit);
+          composite->priv->pending_hits = g_list_prepend (composite->priv->pending_hits, hit);
         }
     }
 
-  if (added)
+  if (composite->priv->pending_hits && composite->priv->flush_id == 0)
     {
-      _gtk_search_engine_hits_added (composite, added);
-      g_list_free (added);
+      composite->priv->flush_id = g_timeout_add (HITS_FLUSH_INTERVAL, flush_hits_timeout, composite);
+      g_source_set_name_by_id (composite->priv->flush_id, "[gtk+] flush_hits_timeout");
     }
 }
 
@@ -249,6 +337,8 @@ update_status (GtkSearchEngine *engine)
 
       if (!running)
         {
+          flush_hits (engine);
+
           if (engine->priv->native_error)
             _gtk_search_engine_error (engine, engine->priv->native_error);
           else if (engine->priv->simple_error)
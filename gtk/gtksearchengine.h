@@ -40,6 +40,11 @@ typedef struct _GtkSearchEngineClass GtkSearchEngineClass;
 typedef struct _GtkSearchEnginePrivate GtkSearchEnginePrivate;
 typedef struct _GtkSearchHit GtkSearchHit;
 
+/* The number of hits that are kept for display. Searches stop
+ * once they have found this many.
+ */
+#define GTK_SEARCH_ENGINE_MAX_HITS 10000
+
 struct _GtkSearchHit
 {
   GFile *file;
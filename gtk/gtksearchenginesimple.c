@@ -31,7 +31,13 @@
 
 #include <string.h>
 
-#define BATCH_SIZE 500
+/* Hits are sent to the main thread when this many have been found,
+ * or when the last batch is older than BATCH_INTERVAL microseconds,
+ * whichever comes first. This keeps the main thread from being
+ * flooded with tiny batches when crawling large trees.
+ */
+#define BATCH_SIZE 1000
+#define BATCH_INTERVAL (100 * 1000)
 
 typedef struct
 {
@@ -41,6 +47,8 @@ typedef struct
   GQueue *directories;
 
   gint n_processed_files;
+  gint n_hits;
+  gint64 batch_time;
   GList *hits;
 
   GtkQuery *query;
@@ -113,6 +121,7 @@ search_thread_data_new (GtkSearchEngineSimple *engine,
   queue_if_local (data, gtk_query_get_location (query));
 
   data->cancellable = g_cancellable_new ();
+  data->batch_time = g_get_monotonic_time ();
 
   return data;
 }
@@ -171,6 +180,8 @@ send_batch (SearchThreadData *data)
   Batch *batch;
 
   data->n_processed_files = 0;
+  data->n_hits = 0;
+  data->batch_time = g_get_monotonic_time ();
 
   if (data->hits)
     {
@@ -253,10 +264,14 @@ visit_directory (GFile *dir, SearchThreadData *data)
           hit->file = g_object_ref (child);
           hit->info = g_object_ref (info);
           data->hits = g_list_prepend (data->hits, hit);
+          data->n_hits++;
         }
 
+      /* Only look at the clock every so often */
       data->n_processed_files++;
-      if (data->n_processed_files > BATCH_SIZE)
+      if (data->n_hits >= BATCH_SIZE ||
+          (data->n_processed_files % 128 == 0 &&
+           g_get_monotonic_time () - data->batch_time >= BATCH_INTERVAL))
         send_batch (data);
 
       if (data->recursive &&
@@ -399,6 +399,8 @@ gtk_search_engine_tracker_start (GtkSearchEngine *engine)
   g_string_append (sparql, "} ORDER BY DESC(nie:url(?urn)) DESC(nfo:fileName(?urn))");
 #endif /* FTS_MATCHING */
 
+  g_string_append_printf (sparql, " LIMIT %d", GTK_SEARCH_ENGINE_MAX_HITS);
+
   tracker->query_pending = TRUE;
 
   g_debug ("SearchEngineTracker: query: %s", sparql->str);
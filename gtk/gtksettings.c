@@ -125,6 +125,12 @@ struct _GtkSettingsPrivate
   gboolean font_size_absolute;
   gchar *font_family;
   cairo_font_options_t *font_options;
+
+  /* Restyling is deferred so that settings changing together,
+   * like a new theme, icon theme and font, only do it once */
+  guint style_changes_id;
+  guint invalidate_style_pending : 1;
+  guint reset_widgets_pending    : 1;
 };
 
 struct _GtkSettingsValuePrivate
@@ -1048,6 +1054,9 @@ gtk_settings_finalize (GObject *object)
 
   g_free (priv->font_family);
 
+  if (priv->style_changes_id)
+    g_source_remove (priv->style_changes_id);
+
   G_OBJECT_CLASS (gtk_settings_parent_class)->finalize (object);
 }
 
@@ -1278,6 +1287,62 @@ settings_update_font_values (GtkSettings *settings)
     pango_font_description_free (desc);
 }
 
+static gboolean
+settings_apply_style_changes (gpointer data)
+{
+  GtkSettings *settings = data;
+  GtkSettingsPrivate *priv = settings->priv;
+
+  priv->style_changes_id = 0;
+
+  if (priv->invalidate_style_pending)
+    settings_invalidate_style (settings);
+
+  if (priv->reset_widgets_pending)
+    gtk_style_context_reset_widgets (priv->display);
+
+  priv->invalidate_style_pending = FALSE;
+  priv->reset_widgets_pending = FALSE;
+
+  return G_SOURCE_REMOVE;
+}
+
+static void
+settings_queue_style_changes (GtkSettings *settings,
+                              gboolean     invalidate_style,
+                              gboolean     reset_widgets)
+{
+  GtkSettingsPrivate *priv = settings->priv;
+
+  if (invalidate_style)
+    priv->invalidate_style_pending = TRUE;
+  if (reset_widgets)
+    priv->reset_widgets_pending = TRUE;
+
+  /* Before the next frame is laid out, but after the icon theme's
+   * change notification, which queues a reset here too */
+  if (priv->style_changes_id == 0)
+    {
+      priv->style_changes_id = g_idle_add_full (GTK_PRIORITY_RESIZE - 1,
+                                                settings_apply_style_changes,
+                                                settings, NULL);
+      g_source_set_name_by_id (priv->style_changes_id, "[gtk] settings_apply_style_changes");
+    }
+}
+
+/*
+ * gtk_settings_queue_reset_widgets:
+ * @settings: a #GtkSettings
+ *
+ * Restyles all widgets on the display of @settings, together with
+ * the other changes made to @settings in this main loop iteration.
+ */
+void
+gtk_settings_queue_reset_widgets (GtkSettings *settings)
+{
+  settings_queue_style_changes (settings, FALSE, TRUE);
+}
+
 static void
 gtk_settings_notify (GObject    *object,
                      GParamSpec *pspec)
@@ -1297,8 +1362,7 @@ gtk_settings_notify (GObject    *object,
       break;
     case PROP_FONT_NAME:
       settings_update_font_values (settings);
-      settings_invalidate_style (settings);
-      gtk_style_context_reset_widgets (priv->display);
+      settings_queue_style_changes (settings, TRUE, TRUE);
       break;
     case PROP_KEY_THEME_NAME:
       settings_update_key_theme (settings);
@@ -1312,21 +1376,21 @@ gtk_settings_notify (GObject    *object,
        * widgets with gtk_widget_style_set(), and also causes more
        * recomputation than necessary.
        */
-      gtk_style_context_reset_widgets (priv->display);
+      settings_queue_style_changes (settings, FALSE, TRUE);
       break;
     case PROP_XFT_ANTIALIAS:
     case PROP_XFT_HINTING:
     case PROP_XFT_HINTSTYLE:
     case PROP_XFT_RGBA:
       settings_update_font_options (settings);
-      gtk_style_context_reset_widgets (priv->display);
+      settings_queue_style_changes (settings, FALSE, TRUE);
       break;
     case PROP_FONTCONFIG_TIMESTAMP:
       if (settings_update_fontconfig (settings))
-        gtk_style_context_reset_widgets (priv->display);
+        settings_queue_style_changes (settings, FALSE, TRUE);
       break;
     case PROP_ENABLE_ANIMATIONS:
-      gtk_style_context_reset_widgets (priv->display);
+      settings_queue_style_changes (settings, FALSE, TRUE);
       break;
     case PROP_CURSOR_THEME_NAME:
     case PROP_CURSOR_THEME_SIZE:
@@ -59,6 +59,8 @@ const gchar *gtk_settings_get_font_family    (GtkSettings *settings);
 gint         gtk_settings_get_font_size      (GtkSettings *settings);
 gboolean     gtk_settings_get_font_size_is_absolute (GtkSettings *settings);
 
+void         gtk_settings_queue_reset_widgets (GtkSettings *settings);
+
 G_END_DECLS
 
 #endif /* __GTK_SETTINGS_PRIVATE_H__ */
@@ -24,6 +24,7 @@
 #include "gtksizerequest.h"
 
 #include "gtkdebug.h"
+#include "gtklabelprivate.h"
 #include "gtkintl.h"
 #include "gtkprivate.h"
 #include "gtksizegroup-private.h"
@@ -33,6 +34,12 @@
 #include "gtkcssnumbervalueprivate.h"
 
 
+#ifdef G_ENABLE_DEBUG
+/* Totals for the GTK_DEBUG=size-request output */
+static guint size_request_cache_hits = 0;
+static guint size_request_cache_misses = 0;
+#endif
+
 #ifdef G_ENABLE_CONSISTENCY_CHECKS
 static GQuark recursion_check_quark = 0;
 
@@ -136,6 +143,10 @@ gtk_widget_query_size_for_orientation (GtkWidget        *widget,
   gint min_baseline = -1;
   gint nat_baseline = -1;
   gboolean found_in_cache;
+  gint64 start_time = 0;
+
+  if (G_UNLIKELY (gtk_widget_get_layout_profiling ()))
+    start_time = g_get_monotonic_time ();
 
   gtk_widget_ensure_resize (widget);
 
@@ -160,6 +171,13 @@ gtk_widget_query_size_for_orientation (GtkWidget        *widget,
                                                    &min_baseline,
                                                    &nat_baseline);
 
+#ifdef G_ENABLE_DEBUG
+  if (found_in_cache)
+    size_request_cache_hits++;
+  else
+    size_request_cache_misses++;
+#endif
+
   if (!found_in_cache)
     {
       GtkWidgetClass *widget_class;
@@ -368,6 +386,9 @@ gtk_widget_query_size_for_orientation (GtkWidget        *widget,
 
   g_assert (min_size <= nat_size);
 
+  if (G_UNLIKELY (start_time != 0))
+    gtk_widget_add_layout_stats (widget, FALSE, g_get_monotonic_time () - start_time);
+
   GTK_DISPLAY_NOTE (_gtk_widget_get_display (widget), SIZE_REQUEST, {
             GString *s;
 
@@ -383,13 +404,63 @@ gtk_widget_query_size_for_orientation (GtkWidget        *widget,
                 g_string_append_printf (s, ", baseline %d/%d",
                                         min_baseline, nat_baseline);
               }
-	    g_string_append_printf (s, " (hit cache: %s)\n",
-		                    found_in_cache ? "yes" : "no");
+	    g_string_append_printf (s, " (hit cache: %s, %u hits, %u misses)\n",
+		                    found_in_cache ? "yes" : "no",
+                                    size_request_cache_hits,
+                                    size_request_cache_misses);
             g_message ("%s", s->str);
             g_string_free (s, TRUE);
 	    });
 }
 
+/* Below this, handing the work to other threads costs more than it saves */
+#define PREMEASURE_MIN_CHILDREN 8
+
+static gboolean
+premeasure_enabled (void)
+{
+  static int enabled = -1;
+
+  if (enabled == -1)
+    enabled = g_strcmp0 (g_getenv ("GTK_PARALLEL_MEASURE"), "1") == 0;
+
+  return enabled;
+}
+
+/*
+ * gtk_widget_premeasure_children:
+ * @widget: a #GtkWidget
+ *
+ * Containers call this before measuring their children one by one.
+ * If parallel measuring is enabled with GTK_PARALLEL_MEASURE=1, the
+ * text of all visible child labels gets measured on worker threads
+ * first, so the sequential pass only hits their caches.
+ */
+void
+gtk_widget_premeasure_children (GtkWidget *widget)
+{
+  GPtrArray *labels;
+  GtkWidget *child;
+
+  if (!premeasure_enabled ())
+    return;
+
+  labels = g_ptr_array_new ();
+
+  for (child = _gtk_widget_get_first_child (widget);
+       child != NULL;
+       child = _gtk_widget_get_next_sibling (child))
+    {
+      if (GTK_IS_LABEL (child) && _gtk_widget_get_visible (child))
+        g_ptr_array_add (labels, child);
+    }
+
+  if (labels->len >= PREMEASURE_MIN_CHILDREN)
+    _gtk_label_premeasure (labels);
+
+  g_ptr_array_unref (labels);
+}
+
 /**
  * gtk_widget_measure:
  * @widget: A #GtkWidget instance
@@ -31,42 +31,77 @@ _gtk_size_request_cache_init (SizeRequestCache *cache)
   memset (cache, 0, sizeof (SizeRequestCache));
 }
 
-static void
-free_sizes_x (SizeRequestX **sizes)
+/* Makes room for a new entry at the front of @requests. The cache
+ * grows until it holds GTK_SIZE_REQUEST_MAX_CACHED_SIZES entries,
+ * after that the least recently used entry is dropped. */
+static gpointer
+request_cache_insert (gpointer  *requests,
+                      guint8    *n_requests,
+                      guint8    *n_allocated,
+                      gsize      element_size)
 {
-  gint i;
+  guint n = *n_requests;
+
+  if (n == *n_allocated)
+    {
+      if (n < GTK_SIZE_REQUEST_MAX_CACHED_SIZES)
+        {
+          if (n == 0)
+            *n_allocated = GTK_SIZE_REQUEST_CACHED_SIZES;
+          else
+            *n_allocated = MIN (n * 2, GTK_SIZE_REQUEST_MAX_CACHED_SIZES);
+
+          *requests = g_realloc (*requests, element_size * *n_allocated);
+        }
+      else
+        n--;
+    }
 
-  for (i = 0; i < GTK_SIZE_REQUEST_CACHED_SIZES && sizes[i] != NULL; i++)
-    g_slice_free (SizeRequestX, sizes[i]);
+  memmove ((guchar *) *requests + element_size, *requests, element_size * n);
+  *n_requests = n + 1;
 
-  g_slice_free1 (sizeof (SizeRequestY *) * GTK_SIZE_REQUEST_CACHED_SIZES, sizes);
+  return *requests;
 }
 
+/* Moves entry @index to the front, so it is dropped last */
 static void
-free_sizes_y (SizeRequestY **sizes)
+request_cache_promote (gpointer requests,
+                       guint    index,
+                       gsize    element_size)
 {
-  gint i;
+  guchar tmp[MAX (sizeof (SizeRequestX), sizeof (SizeRequestY))];
 
-  for (i = 0; i < GTK_SIZE_REQUEST_CACHED_SIZES && sizes[i] != NULL; i++)
-    g_slice_free (SizeRequestY, sizes[i]);
+  if (index == 0)
+    return;
 
-  g_slice_free1 (sizeof (SizeRequestY *) * GTK_SIZE_REQUEST_CACHED_SIZES, sizes);
+  memcpy (tmp, (guchar *) requests + index * element_size, element_size);
+  memmove ((guchar *) requests + element_size, requests, index * element_size);
+  memcpy (requests, tmp, element_size);
 }
 
 void
 _gtk_size_request_cache_free (SizeRequestCache *cache)
 {
-  if (cache->requests_x)
-    free_sizes_x (cache->requests_x);
-  if (cache->requests_y)
-    free_sizes_y (cache->requests_y);
+  g_free (cache->requests_x);
+  g_free (cache->requests_y);
 }
 
+/* Keeps the allocated entries around, widgets that needed a
+ * large cache once are likely to need it again */
 void
 _gtk_size_request_cache_clear (SizeRequestCache *cache)
 {
-  _gtk_size_request_cache_free (cache);
+  SizeRequestX *requests_x = cache->requests_x;
+  SizeRequestY *requests_y = cache->requests_y;
+  guint8 n_allocated_x = cache->flags[GTK_ORIENTATION_HORIZONTAL].n_allocated_requests;
+  guint8 n_allocated_y = cache->flags[GTK_ORIENTATION_VERTICAL].n_allocated_requests;
+
   _gtk_size_request_cache_init (cache);
+
+  cache->requests_x = requests_x;
+  cache->requests_y = requests_y;
+  cache->flags[GTK_ORIENTATION_HORIZONTAL].n_allocated_requests = n_allocated_x;
+  cache->flags[GTK_ORIENTATION_VERTICAL].n_allocated_requests = n_allocated_y;
 }
 
 void
@@ -115,41 +150,27 @@ _gtk_size_request_cache_commit (SizeRequestCache *cache,
 
   if (orientation == GTK_ORIENTATION_HORIZONTAL)
     {
-      SizeRequestX **cached_sizes = cache->requests_x;
-      SizeRequestX  *cached_size;
+      SizeRequestX *cached_sizes = cache->requests_x;
+      SizeRequestX *cached_size;
 
       for (i = 0; i < n_sizes; i++)
 	{
-	  if (cached_sizes[i]->cached_size.minimum_size == minimum_size &&
-	      cached_sizes[i]->cached_size.natural_size == natural_size)
+	  if (cached_sizes[i].cached_size.minimum_size == minimum_size &&
+	      cached_sizes[i].cached_size.natural_size == natural_size)
 	    {
-	      cached_sizes[i]->lower_for_size = MIN (cached_sizes[i]->lower_for_size, for_size);
-	      cached_sizes[i]->upper_for_size = MAX (cached_sizes[i]->upper_for_size, for_size);
+	      cached_sizes[i].lower_for_size = MIN (cached_sizes[i].lower_for_size, for_size);
+	      cached_sizes[i].upper_for_size = MAX (cached_sizes[i].upper_for_size, for_size);
+              request_cache_promote (cached_sizes, i, sizeof (SizeRequestX));
 	      return;
 	    }
 	}
 
-      /* If not found, pull a new size from the cache, the returned size cache
-       * will immediately be used to cache the new computed size so we go ahead
-       * and increment the last_cached_request right away */
-      if (n_sizes < GTK_SIZE_REQUEST_CACHED_SIZES)
-	{
-	  cache->flags[orientation].n_cached_requests++;
-	  cache->flags[orientation].last_cached_request = cache->flags[orientation].n_cached_requests - 1;
-	}
-      else
-	{
-	  if (++cache->flags[orientation].last_cached_request == GTK_SIZE_REQUEST_CACHED_SIZES)
-	    cache->flags[orientation].last_cached_request = 0;
-	}
-
-      if (cache->requests_x == NULL)
-	cache->requests_x = g_slice_alloc0 (sizeof (SizeRequestX *) * GTK_SIZE_REQUEST_CACHED_SIZES);
-
-      if (cache->requests_x[cache->flags[orientation].last_cached_request] == NULL)
-	cache->requests_x[cache->flags[orientation].last_cached_request] = g_slice_new (SizeRequestX);
-
-      cached_size = cache->requests_x[cache->flags[orientation].last_cached_request];
+      /* If not found, put the new size in front of the cache, dropping
+       * the least recently used one if the cache can't grow anymore */
+      cached_size = request_cache_insert ((gpointer *) &cache->requests_x,
+                                          &cache->flags[orientation].n_cached_requests,
+                                          &cache->flags[orientation].n_allocated_requests,
+                                          sizeof (SizeRequestX));
       cached_size->lower_for_size = for_size;
       cached_size->upper_for_size = for_size;
       cached_size->cached_size.minimum_size = minimum_size;
@@ -157,43 +178,29 @@ _gtk_size_request_cache_commit (SizeRequestCache *cache,
     }
   else
     {
-      SizeRequestY **cached_sizes = cache->requests_y;
-      SizeRequestY  *cached_size;
+      SizeRequestY *cached_sizes = cache->requests_y;
+      SizeRequestY *cached_size;
 
       for (i = 0; i < n_sizes; i++)
 	{
-	  if (cached_sizes[i]->cached_size.minimum_size == minimum_size &&
-	      cached_sizes[i]->cached_size.natural_size == natural_size &&
-	      cached_sizes[i]->cached_size.minimum_baseline == minimum_baseline &&
-	      cached_sizes[i]->cached_size.natural_baseline == natural_baseline)
+	  if (cached_sizes[i].cached_size.minimum_size == minimum_size &&
+	      cached_sizes[i].cached_size.natural_size == natural_size &&
+	      cached_sizes[i].cached_size.minimum_baseline == minimum_baseline &&
+	      cached_sizes[i].cached_size.natural_baseline == natural_baseline)
 	    {
-	      cached_sizes[i]->lower_for_size = MIN (cached_sizes[i]->lower_for_size, for_size);
-	      cached_sizes[i]->upper_for_size = MAX (cached_sizes[i]->upper_for_size, for_size);
+	      cached_sizes[i].lower_for_size = MIN (cached_sizes[i].lower_for_size, for_size);
+	      cached_sizes[i].upper_for_size = MAX (cached_sizes[i].upper_for_size, for_size);
+              request_cache_promote (cached_sizes, i, sizeof (SizeRequestY));
 	      return;
 	    }
 	}
 
-      /* If not found, pull a new size from the cache, the returned size cache
-       * will immediately be used to cache the new computed size so we go ahead
-       * and increment the last_cached_request right away */
-      if (n_sizes < GTK_SIZE_REQUEST_CACHED_SIZES)
-	{
-	  cache->flags[orientation].n_cached_requests++;
-	  cache->flags[orientation].last_cached_request = cache->flags[orientation].n_cached_requests - 1;
-	}
-      else
-	{
-	  if (++cache->flags[orientation].last_cached_request == GTK_SIZE_REQUEST_CACHED_SIZES)
-	    cache->flags[orientation].last_cached_request = 0;
-	}
-
-      if (cache->requests_y == NULL)
-	cache->requests_y = g_slice_alloc0 (sizeof (SizeRequestY *) * GTK_SIZE_REQUEST_CACHED_SIZES);
-
-      if (cache->requests_y[cache->flags[orientation].last_cached_request] == NULL)
-	cache->requests_y[cache->flags[orientation].last_cached_request] = g_slice_new (SizeRequestY);
-
-      cached_size = cache->requests_y[cache->flags[orientation].last_cached_request];
+      /* If not found, put the new size in front of the cache, dropping
+       * the least recently used one if the cache can't grow anymore */
+      cached_size = request_cache_insert ((gpointer *) &cache->requests_y,
+                                          &cache->flags[orientation].n_cached_requests,
+                                          &cache->flags[orientation].n_allocated_requests,
+                                          sizeof (SizeRequestY));
       cached_size->lower_for_size = for_size;
       cached_size->upper_for_size = for_size;
       cached_size->cached_size.minimum_size = minimum_size;
@@ -209,7 +216,7 @@ _gtk_size_request_cache_commit (SizeRequestCache *cache,
  * the Clutter toolkit but has evolved for other GTK+ requirements.
  */
 gboolean
-_gtk_size_request_cache_lookup (const SizeRequestCache *cache,
+_gtk_size_request_cache_lookup (SizeRequestCache       *cache,
                                 GtkOrientation          orientation,
                                 int                     for_size,
                                 int                    *minimum,
@@ -239,12 +246,15 @@ _gtk_size_request_cache_lookup (const SizeRequestCache *cache,
 	  /* Search for an already cached size */
           for (i = 0, p = cache->flags[GTK_ORIENTATION_HORIZONTAL].n_cached_requests; i < p; i++)
             {
-              const SizeRequestX *cur = cache->requests_x[i];
+              SizeRequestX *cur = &cache->requests_x[i];
 
 	      if (cur->lower_for_size <= for_size &&
 		  cur->upper_for_size >= for_size)
 		{
-                  const CachedSizeX *result = &cur->cached_size;
+                  const CachedSizeX *result;
+
+                  request_cache_promote (cache->requests_x, i, sizeof (SizeRequestX));
+                  result = &cache->requests_x[0].cached_size;
 
                   *minimum = result->minimum_size;
                   *natural = result->natural_size;
@@ -278,12 +288,15 @@ _gtk_size_request_cache_lookup (const SizeRequestCache *cache,
 	  /* Search for an already cached size */
           for (i = 0, p = cache->flags[GTK_ORIENTATION_VERTICAL].n_cached_requests; i < p; i++)
             {
-              const SizeRequestY *cur = cache->requests_y[i];
+              SizeRequestY *cur = &cache->requests_y[i];
 
 	      if (cur->lower_for_size <= for_size &&
 		  cur->upper_for_size >= for_size)
 		{
-                  const CachedSizeY *result = &cur->cached_size;
+                  const CachedSizeY *result;
+
+                  request_cache_promote (cache->requests_y, i, sizeof (SizeRequestY));
+                  result = &cache->requests_y[0].cached_size;
 
                   *minimum = result->minimum_size;
                   *natural = result->natural_size;
@@ -35,8 +35,16 @@ G_BEGIN_DECLS
  * for a said widget to have, if a label can
  * only wrap to 3 lines, only 3 caches will
  * ever be allocated for it.
+ *
+ * Caches start out with room for
+ * GTK_SIZE_REQUEST_CACHED_SIZES entries and
+ * grow up to GTK_SIZE_REQUEST_MAX_CACHED_SIZES
+ * for widgets that get measured for many sizes,
+ * like wrapping labels in a flow box. Entries
+ * are kept in most recently used order.
  */
-#define GTK_SIZE_REQUEST_CACHED_SIZES   (5)
+#define GTK_SIZE_REQUEST_CACHED_SIZES     (5)
+#define GTK_SIZE_REQUEST_MAX_CACHED_SIZES (40)
 
 typedef struct {
   gint minimum_size;
@@ -65,8 +73,8 @@ typedef struct
 } SizeRequestY;
 
 typedef struct {
-  SizeRequestX **requests_x;
-  SizeRequestY **requests_y;
+  SizeRequestX *requests_x;
+  SizeRequestY *requests_y;
 
   CachedSizeX  cached_size_x;
   CachedSizeY  cached_size_y;
@@ -74,8 +82,8 @@ typedef struct {
   GtkSizeRequestMode request_mode   : 3;
   guint       request_mode_valid    : 1;
   struct {
-    guint       n_cached_requests   : 3;
-    guint       last_cached_request : 3;
+    guint8      n_cached_requests;
+    guint8      n_allocated_requests;
     guint       cached_size_valid   : 1;
   }           flags[2];
 } SizeRequestCache;
@@ -91,7 +99,7 @@ void            _gtk_size_request_cache_commit                  (SizeRequestCach
                                                                  int                     natural_size,
                                                                  int                     minimum_baseline,
                                                                  int                     natural_baseline);
-gboolean        _gtk_size_request_cache_lookup                  (const SizeRequestCache *cache,
+gboolean        _gtk_size_request_cache_lookup                  (SizeRequestCache       *cache,
                                                                  GtkOrientation          orientation,
                                                                  int                     for_size,
                                                                  int                    *minimum,
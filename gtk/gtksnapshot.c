@@ -395,6 +395,14 @@ gtk_snapshot_collect_opacity (GtkSnapshot      *snapshot,
       gsk_render_node_unref (node);
       opacity_node = NULL;
     }
+  else if (gsk_render_node_get_node_type (node) == GSK_OPACITY_NODE)
+    {
+      /* Nested opacities, like from nested widgets with CSS opacity,
+       * would each need an offscreen */
+      opacity_node = gsk_opacity_node_new (gsk_opacity_node_get_child (node),
+                                           gsk_opacity_node_get_opacity (node) * state->data.opacity.opacity);
+      gsk_render_node_unref (node);
+    }
   else
     {
       opacity_node = gsk_opacity_node_new (node, state->data.opacity.opacity);
@@ -497,6 +505,26 @@ gtk_snapshot_collect_color_matrix (GtkSnapshot      *snapshot,
 
       gsk_render_node_unref (child);
     }
+  else if (gsk_render_node_get_node_type (node) == GSK_OPACITY_NODE)
+    {
+      /* The opacity is a color matrix that scales alpha. It is applied
+       * first, so it scales the factors of the input alpha. The other
+       * way around doesn't work, the color matrix clamps its results.
+       */
+      float opacity = gsk_opacity_node_get_opacity (node);
+      graphene_matrix_t mat;
+
+      graphene_matrix_init_from_float (&mat, (float[16]) { 1, 0, 0, 0,
+                                                           0, 1, 0, 0,
+                                                           0, 0, 1, 0,
+                                                           0, 0, 0, opacity });
+      graphene_matrix_multiply (&mat, &state->data.color_matrix.matrix, &mat);
+
+      color_matrix_node = gsk_color_matrix_node_new (gsk_opacity_node_get_child (node),
+                                                     &mat,
+                                                     &state->data.color_matrix.offset);
+      gsk_render_node_unref (node);
+    }
   else
     {
       color_matrix_node = gsk_color_matrix_node_new (node,
@@ -24,6 +24,8 @@
 #include "gtkintl.h"
 #include "gtkprivate.h"
 
+#include <string.h>
+
 /**
  * SECTION:gtksortlistmodel
  * @title: GtkSortListModel
@@ -38,16 +40,50 @@
  * If you run into performance issues with #GtkSortListModel, it
  * is strongly recommended that you write your own sorting list
  * model.
+ *
+ * Sorting large models can take a long time. To avoid blocking the
+ * main loop, #GtkSortListModel can sort incrementally, see
+ * gtk_sort_list_model_set_incremental().
  */
 
+/* Time spent sorting per main loop iteration when sorting incrementally,
+ * in microseconds */
+#define SORT_TIME_SLICE 2000
+/* Number of steps between checks of the time */
+#define SORT_STEPS_PER_CHECK 256
+
 enum {
   PROP_0,
   PROP_HAS_SORT,
+  PROP_INCREMENTAL,
   PROP_ITEM_TYPE,
   PROP_MODEL,
+  PROP_PENDING,
   NUM_PROPERTIES
 };
 
+typedef struct
+{
+  gpointer item;
+  guint position; /* in the unsorted model */
+} SortEntry;
+
+/* A bottom-up merge sort over a flat array, that can be stopped after
+ * any step and resumed later.
+ */
+typedef struct
+{
+  SortEntry *entries;
+  SortEntry *buffer; /* where the current pass merges to */
+  guint n_items;
+  guint n_collected; /* items fetched from the model so far */
+  guint width; /* length of the sorted runs merged in this pass */
+  guint start; /* start of the two runs being merged */
+  guint left; /* next entry of the first run */
+  guint right; /* next entry of the second run */
+  guint out; /* next entry in buffer */
+} SortState;
+
 struct _GtkSortListModel
 {
   GObject parent_instance;
@@ -58,8 +94,12 @@ struct _GtkSortListModel
   gpointer user_data;
   GDestroyNotify user_destroy;
 
-  GSequence *sorted; /* NULL if sort_func == NULL */
-  GSequence *unsorted; /* NULL if sort_func == NULL */
+  GArray *sorted; /* the items in sorted order, NULL if sort_func == NULL */
+  GArray *unsorted; /* the same items in the order of model, NULL if sort_func == NULL */
+
+  guint incremental : 1;
+  SortState *sort_state; /* NULL unless sorting incrementally */
+  guint sort_cb; /* idle source of the incremental sort */
 };
 
 struct _GtkSortListModelClass
@@ -69,6 +109,135 @@ struct _GtkSortListModelClass
 
 static GParamSpec *properties[NUM_PROPERTIES] = { NULL, };
 
+static SortState *
+sort_state_new (GListModel *model)
+{
+  SortState *state;
+
+  state = g_slice_new0 (SortState);
+  state->n_items = g_list_model_get_n_items (model);
+  state->entries = g_new (SortEntry, state->n_items);
+  state->buffer = g_new (SortEntry, state->n_items);
+  state->width = 1;
+
+  return state;
+}
+
+static void
+sort_state_free (SortState *state)
+{
+  guint i;
+
+  for (i = 0; i < state->n_collected; i++)
+    g_object_unref (state->entries[i].item);
+
+  g_free (state->entries);
+  g_free (state->buffer);
+  g_slice_free (SortState, state);
+}
+
+static void
+sort_state_start_merge (SortState *state)
+{
+  state->left = state->start;
+  state->right = state->start + MIN (state->width, state->n_items - state->start);
+  state->out = state->start;
+}
+
+/* Sorts until done or until @end_time has passed, 0 means never.
+ * Returns TRUE when done */
+static gboolean
+sort_state_run (SortState        *state,
+                GListModel       *model,
+                GCompareDataFunc  sort_func,
+                gpointer          user_data,
+                gint64            end_time)
+{
+  guint steps = 0;
+
+#define CHECK_TIME() G_STMT_START{ \
+  if (end_time != 0 && \
+      ++steps % SORT_STEPS_PER_CHECK == 0 && \
+      g_get_monotonic_time () >= end_time) \
+    return FALSE; \
+}G_STMT_END
+
+  while (state->n_collected < state->n_items)
+    {
+      state->entries[state->n_collected].item = g_list_model_get_item (model, state->n_collected);
+      state->entries[state->n_collected].position = state->n_collected;
+      state->n_collected++;
+      CHECK_TIME ();
+    }
+
+  while (state->width < state->n_items)
+    {
+      guint mid, end;
+
+      mid = state->start + MIN (state->width, state->n_items - state->start);
+      end = mid + MIN (state->width, state->n_items - mid);
+
+      while (state->left < mid && state->right < end)
+        {
+          /* take from the first run when equal, so the sort is stable */
+          if (sort_func (state->entries[state->right].item, state->entries[state->left].item, user_data) < 0)
+            state->buffer[state->out++] = state->entries[state->right++];
+          else
+            state->buffer[state->out++] = state->entries[state->left++];
+          CHECK_TIME ();
+        }
+
+      memcpy (&state->buffer[state->out], &state->entries[state->left], (mid - state->left) * sizeof (SortEntry));
+      state->out += mid - state->left;
+      memcpy (&state->buffer[state->out], &state->entries[state->right], (end - state->right) * sizeof (SortEntry));
+
+      state->start = end;
+      if (state->start >= state->n_items)
+        {
+          SortEntry *tmp = state->entries;
+          state->entries = state->buffer;
+          state->buffer = tmp;
+          state->start = 0;
+          if (state->width > state->n_items / 2)
+            state->width = state->n_items;
+          else
+            state->width *= 2;
+        }
+
+      sort_state_start_merge (state);
+    }
+
+#undef CHECK_TIME
+
+  return TRUE;
+}
+
+/* The number of items a linear algorithm would still need to process,
+ * counting fetching the items as one pass over them. This is never 0,
+ * so 0 can mean that sorting is done */
+static guint
+sort_state_get_pending (SortState *state)
+{
+  guint64 done;
+  guint n_passes, pass;
+
+  if (state->n_items <= 1)
+    return 1;
+
+  n_passes = g_bit_storage (state->n_items - 1) + 1;
+
+  done = state->n_collected;
+  if (state->n_collected == state->n_items && state->width < state->n_items)
+    {
+      pass = g_bit_storage (state->width);
+      done += (guint64) (pass - 1) * state->n_items + state->out;
+    }
+  else if (state->width >= state->n_items)
+    done = (guint64) n_passes * state->n_items;
+
+  return MAX (((guint64) n_passes * state->n_items - done) / n_passes, 1);
+}
+
 static GType
 gtk_sort_list_model_get_item_type (GListModel *list)
 {
@@ -86,7 +255,7 @@ gtk_sort_list_model_get_n_items (GListModel *list)
     return 0;
 
   if (self->sorted)
-    return g_sequence_get_length (self->sorted);
+    return self->sorted->len;
 
   return g_list_model_get_n_items (self->model);
 }
@@ -96,7 +265,6 @@ gtk_sort_list_model_get_item (GListModel *list,
                               guint       position)
 {
   GtkSortListModel *self = GTK_SORT_LIST_MODEL (list);
-  GSequenceIter *iter;
 
   if (self->model == NULL)
     return NULL;
@@ -104,11 +272,10 @@ gtk_sort_list_model_get_item (GListModel *list,
   if (self->unsorted == NULL)
     return g_list_model_get_item (self->model, position);
 
-  iter = g_sequence_get_iter_at_pos (self->sorted, position);
-  if (g_sequence_iter_is_end (iter))
-      return NULL;
+  if (position >= self->sorted->len)
+    return NULL;
 
-  return g_object_ref (g_sequence_get (iter));
+  return g_object_ref (g_array_index (self->sorted, gpointer, position));
 }
 
 static void
@@ -122,6 +289,88 @@ gtk_sort_list_model_model_init (GListModelInterface *iface)
 G_DEFINE_TYPE_WITH_CODE (GtkSortListModel, gtk_sort_list_model, G_TYPE_OBJECT,
                          G_IMPLEMENT_INTERFACE (G_TYPE_LIST_MODEL, gtk_sort_list_model_model_init))
 
+static void
+clear_item (gpointer data)
+{
+  g_object_unref (*(gpointer *) data);
+}
+
+static GArray *
+item_array_new (guint     reserved_size,
+                gboolean  owns_items)
+{
+  GArray *array;
+
+  array = g_array_sized_new (FALSE, FALSE, sizeof (gpointer), reserved_size);
+  if (owns_items)
+    g_array_set_clear_func (array, clear_item);
+
+  return array;
+}
+
+/* The first position in sorted where an item sorts after @item,
+ * so that equal items keep the order they were added in. */
+static guint
+gtk_sort_list_model_find_insert_position (GtkSortListModel *self,
+                                          gpointer          item)
+{
+  guint start, end, mid;
+
+  start = 0;
+  end = self->sorted->len;
+
+  while (start < end)
+    {
+      mid = start + (end - start) / 2;
+      if (self->sort_func (g_array_index (self->sorted, gpointer, mid), item, self->user_data) > 0)
+        end = mid;
+      else
+        start = mid + 1;
+    }
+
+  return start;
+}
+
+static guint
+gtk_sort_list_model_find_item (GtkSortListModel *self,
+                               gpointer          item)
+{
+  guint start, end, mid, i;
+
+  /* Find the range of items comparing equal to @item */
+  start = 0;
+  end = self->sorted->len;
+  while (start < end)
+    {
+      mid = start + (end - start) / 2;
+      if (self->sort_func (g_array_index (self->sorted, gpointer, mid), item, self->user_data) < 0)
+        start = mid + 1;
+      else
+        end = mid;
+    }
+
+  for (i = start; i < self->sorted->len; i++)
+    {
+      gpointer other = g_array_index (self->sorted, gpointer, i);
+
+      if (other == item)
+        return i;
+      if (self->sort_func (other, item, self->user_data) != 0)
+        break;
+    }
+
+  /* The data the sort function looks at changed without a resort,
+   * so the binary search is no good */
+  for (i = 0; i < self->sorted->len; i++)
+    {
+      if (g_array_index (self->sorted, gpointer, i) == item)
+        return i;
+    }
+
+  g_assert_not_reached ();
+  return 0;
+}
+
 static void
 gtk_sort_list_model_remove_items (GtkSortListModel *self,
                                   guint             position,
@@ -129,30 +378,21 @@ gtk_sort_list_model_remove_items (GtkSortListModel *self,
                                   guint            *unmodified_start,
                                   guint            *unmodified_end)
 {
-  GSequenceIter *unsorted_iter;
   guint i, pos, start, end, length_before;
 
-  start = end = length_before = g_sequence_get_length (self->sorted);
-  unsorted_iter = g_sequence_get_iter_at_pos (self->unsorted, position);
+  start = end = length_before = self->sorted->len;
 
   for (i = 0; i < n_items ; i++)
     {
-      GSequenceIter *sorted_iter;
-      GSequenceIter *next;
-
-      next = g_sequence_iter_next (unsorted_iter);
-
-      sorted_iter = g_sequence_get (unsorted_iter);
-      pos = g_sequence_iter_get_position (sorted_iter);
+      pos = gtk_sort_list_model_find_item (self, g_array_index (self->unsorted, gpointer, position + i));
       start = MIN (start, pos);
       end = MIN (end, length_before - i - 1 - pos);
 
-      g_sequence_remove (sorted_iter);
-      g_sequence_remove (unsorted_iter);
-
-      unsorted_iter = next;
+      g_array_remove_index (self->sorted, pos);
     }
 
+  g_array_remove_range (self->unsorted, position, n_items);
+
   *unmodified_start = start;
   *unmodified_end = end;
 }
@@ -164,29 +404,131 @@ gtk_sort_list_model_add_items (GtkSortListModel *self,
                                guint            *unmodified_start,
                                guint            *unmodified_end)
 {
-  GSequenceIter *unsorted_iter, *sorted_iter;
+  gpointer *items;
   guint i, pos, start, end, length_before;
 
-  unsorted_iter = g_sequence_get_iter_at_pos (self->unsorted, position);
-  start = end = length_before = g_sequence_get_length (self->sorted);
+  start = end = length_before = self->sorted->len;
+  items = g_new (gpointer, n_items);
 
   for (i = 0; i < n_items; i++)
     {
-      gpointer item = g_list_model_get_item (self->model, position + i);
-      sorted_iter = g_sequence_insert_sorted (self->sorted, item, self->sort_func, self->user_data);
-      g_sequence_insert_before (unsorted_iter, sorted_iter);
-      if (unmodified_start != NULL || unmodified_end != NULL)
-        {
-          pos = g_sequence_iter_get_position (sorted_iter);
-          start = MIN (start, pos);
-          end = MIN (end, length_before + i - pos);
-        }
+      items[i] = g_list_model_get_item (self->model, position + i);
+      pos = gtk_sort_list_model_find_insert_position (self, items[i]);
+      g_array_insert_val (self->sorted, pos, items[i]);
+      start = MIN (start, pos);
+      end = MIN (end, length_before + i - pos);
+    }
+
+  g_array_insert_vals (self->unsorted, position, items, n_items);
+  g_free (items);
+
+  *unmodified_start = start;
+  *unmodified_end = end;
+}
+
+/* Replaces the arrays with the result of a finished sort */
+static void
+gtk_sort_list_model_take_sort_state (GtkSortListModel *self,
+                                     SortState        *state)
+{
+  guint i;
+
+  g_clear_pointer (&self->unsorted, g_array_unref);
+  g_clear_pointer (&self->sorted, g_array_unref);
+
+  self->sorted = item_array_new (state->n_items, TRUE);
+  self->unsorted = item_array_new (state->n_items, FALSE);
+  g_array_set_size (self->unsorted, state->n_items);
+
+  for (i = 0; i < state->n_items; i++)
+    {
+      g_array_append_val (self->sorted, state->entries[i].item);
+      g_array_index (self->unsorted, gpointer, state->entries[i].position) = state->entries[i].item;
+    }
+
+  /* the arrays own the items now */
+  state->n_collected = 0;
+  sort_state_free (state);
+}
+
+static void
+gtk_sort_list_model_stop_sorting (GtkSortListModel *self)
+{
+  if (self->sort_state == NULL)
+    return;
+
+  if (self->sort_cb)
+    {
+      g_source_remove (self->sort_cb);
+      self->sort_cb = 0;
+    }
+  g_clear_pointer (&self->sort_state, sort_state_free);
+
+  g_object_notify_by_pspec (G_OBJECT (self), properties[PROP_PENDING]);
+}
+
+static void
+gtk_sort_list_model_finish_sorting (GtkSortListModel *self)
+{
+  SortState *state;
+  guint n_items;
+
+  state = self->sort_state;
+  self->sort_state = NULL;
+  if (self->sort_cb)
+    {
+      g_source_remove (self->sort_cb);
+      self->sort_cb = 0;
+    }
+
+  sort_state_run (state, self->model, self->sort_func, self->user_data, 0);
+
+  n_items = state->n_items;
+  gtk_sort_list_model_take_sort_state (self, state);
+
+  if (n_items > 1)
+    g_list_model_items_changed (G_LIST_MODEL (self), 0, n_items, n_items);
+
+  g_object_notify_by_pspec (G_OBJECT (self), properties[PROP_PENDING]);
+}
+
+static gboolean
+gtk_sort_list_model_sort_cb (gpointer data)
+{
+  GtkSortListModel *self = data;
+
+  if (!sort_state_run (self->sort_state,
+                       self->model,
+                       self->sort_func,
+                       self->user_data,
+                       g_get_monotonic_time () + SORT_TIME_SLICE))
+    {
+      g_object_notify_by_pspec (G_OBJECT (self), properties[PROP_PENDING]);
+      return G_SOURCE_CONTINUE;
+    }
+
+  self->sort_cb = 0;
+  gtk_sort_list_model_finish_sorting (self);
+
+  return G_SOURCE_REMOVE;
+}
+
+/* Until the sort is done, the model keeps its current order */
+static void
+gtk_sort_list_model_start_sorting (GtkSortListModel *self)
+{
+  if (self->sort_state)
+    {
+      if (self->sort_cb)
+        g_source_remove (self->sort_cb);
+      sort_state_free (self->sort_state);
     }
 
-  if (unmodified_start)
-    *unmodified_start = start;
-  if (unmodified_end)
-    *unmodified_end = end;
+  self->sort_state = sort_state_new (self->model);
+  self->sort_cb = g_idle_add (gtk_sort_list_model_sort_cb, self);
+  g_source_set_name_by_id (self->sort_cb, "[gtk] gtk_sort_list_model_sort_cb");
+
+  g_object_notify_by_pspec (G_OBJECT (self), properties[PROP_PENDING]);
 }
 
 static void
@@ -201,6 +543,10 @@ gtk_sort_list_model_items_changed_cb (GListModel       *model,
   if (removed == 0 && added == 0)
     return;
 
+  /* The sort works on a copy of the model, so start over */
+  if (self->sort_state)
+    gtk_sort_list_model_start_sorting (self);
+
   if (self->sorted == NULL)
     {
       g_list_model_items_changed (G_LIST_MODEL (self), position, removed, added);
@@ -212,7 +558,7 @@ gtk_sort_list_model_items_changed_cb (GListModel       *model,
   start = MIN (start, start2);
   end = MIN (end, end2);
 
-  n_items = g_sequence_get_length (self->sorted) - start - end;
+  n_items = self->sorted->len - start - end;
   g_list_model_items_changed (G_LIST_MODEL (self), start, n_items - added + removed, n_items);
 }
 
@@ -226,6 +572,10 @@ gtk_sort_list_model_set_property (GObject      *object,
 
   switch (prop_id)
     {
+    case PROP_INCREMENTAL:
+      gtk_sort_list_model_set_incremental (self, g_value_get_boolean (value));
+      break;
+
     case PROP_ITEM_TYPE:
       self->item_type = g_value_get_gtype (value);
       break;
@@ -254,6 +604,10 @@ gtk_sort_list_model_get_property (GObject     *object,
       g_value_set_boolean (value, self->sort_func != NULL);
       break;
 
+    case PROP_INCREMENTAL:
+      g_value_set_boolean (value, self->incremental);
+      break;
+
     case PROP_ITEM_TYPE:
       g_value_set_gtype (value, self->item_type);
       break;
@@ -262,6 +616,10 @@ gtk_sort_list_model_get_property (GObject     *object,
       g_value_set_object (value, self->model);
       break;
 
+    case PROP_PENDING:
+      g_value_set_uint (value, gtk_sort_list_model_get_pending (self));
+      break;
+
     default:
       G_OBJECT_WARN_INVALID_PROPERTY_ID (object, prop_id, pspec);
       break;
@@ -274,10 +632,11 @@ gtk_sort_list_model_clear_model (GtkSortListModel *self)
   if (self->model == NULL)
     return;
 
+  gtk_sort_list_model_stop_sorting (self);
   g_signal_handlers_disconnect_by_func (self->model, gtk_sort_list_model_items_changed_cb, self);
   g_clear_object (&self->model);
-  g_clear_pointer (&self->sorted, g_sequence_free);
-  g_clear_pointer (&self->unsorted, g_sequence_free);
+  g_clear_pointer (&self->sorted, g_array_unref);
+  g_clear_pointer (&self->unsorted, g_array_unref);
 }
 
 static void
@@ -316,6 +675,18 @@ gtk_sort_list_model_class_init (GtkSortListModelClass *class)
                             FALSE,
                             GTK_PARAM_READABLE | G_PARAM_EXPLICIT_NOTIFY);
 
+  /**
+   * GtkSortListModel:incremental:
+   *
+   * If the model should sort items incrementally
+   */
+  properties[PROP_INCREMENTAL] =
+      g_param_spec_boolean ("incremental",
+                            P_("Incremental"),
+                            P_("Sort items incrementally"),
+                            FALSE,
+                            GTK_PARAM_READWRITE | G_PARAM_EXPLICIT_NOTIFY);
+
   /**
    * GtkSortListModel:item-type:
    *
@@ -340,6 +711,19 @@ gtk_sort_list_model_class_init (GtkSortListModelClass *class)
                            G_TYPE_LIST_MODEL,
                            GTK_PARAM_READWRITE | G_PARAM_CONSTRUCT_ONLY | G_PARAM_EXPLICIT_NOTIFY);
 
+  /**
+   * GtkSortListModel:pending:
+   *
+   * Estimate of the number of items left to sort, see
+   * gtk_sort_list_model_get_pending()
+   */
+  properties[PROP_PENDING] =
+      g_param_spec_uint ("pending",
+                         P_("Pending"),
+                         P_("Estimate of the number of items left to sort"),
+                         0, G_MAXUINT, 0,
+                         GTK_PARAM_READABLE | G_PARAM_EXPLICIT_NOTIFY);
+
   g_object_class_install_properties (gobject_class, NUM_PROPERTIES, properties);
 }
 
@@ -402,15 +786,22 @@ gtk_sort_list_model_new_for_type (GType item_type)
 }
 
 static void
-gtk_sort_list_model_create_sequences (GtkSortListModel *self)
+gtk_sort_list_model_create_items (GtkSortListModel *self)
 {
+  SortState *state;
+
   if (!self->sort_func || self->model == NULL)
     return;
 
-  self->sorted = g_sequence_new (g_object_unref);
-  self->unsorted = g_sequence_new (NULL);
+  if (self->incremental)
+    {
+      gtk_sort_list_model_start_sorting (self);
+      return;
+    }
 
-  gtk_sort_list_model_add_items (self, 0, g_list_model_get_n_items (self->model), NULL, NULL);
+  state = sort_state_new (self->model);
+  sort_state_run (state, self->model, self->sort_func, self->user_data, 0);
+  gtk_sort_list_model_take_sort_state (self, state);
 }
 
 /**
@@ -442,17 +833,27 @@ gtk_sort_list_model_set_sort_func (GtkSortListModel *self,
   if (self->user_destroy)
     self->user_destroy (self->user_data);
 
-  g_clear_pointer (&self->unsorted, g_sequence_free);
-  g_clear_pointer (&self->sorted, g_sequence_free);
+  gtk_sort_list_model_stop_sorting (self);
   self->sort_func = sort_func;
   self->user_data = user_data;
   self->user_destroy = user_destroy;
-  
-    gtk_sort_list_model_create_sequences (self);
-    
-  n_items = g_list_model_get_n_items (G_LIST_MODEL (self));
-  if (n_items > 1)
-    g_list_model_items_changed (G_LIST_MODEL (self), 0, n_items, n_items);
+
+  if (sort_func && self->incremental && self->model)
+    {
+      /* keep the current order until the new one is known */
+      gtk_sort_list_model_start_sorting (self);
+    }
+  else
+    {
+      g_clear_pointer (&self->unsorted, g_array_unref);
+      g_clear_pointer (&self->sorted, g_array_unref);
+
+      gtk_sort_list_model_create_items (self);
+
+      n_items = g_list_model_get_n_items (G_LIST_MODEL (self));
+      if (n_items > 1)
+        g_list_model_items_changed (G_LIST_MODEL (self), 0, n_items, n_items);
+    }
 
   g_object_notify_by_pspec (G_OBJECT (self), properties[PROP_HAS_SORT]);
 }
@@ -490,7 +891,7 @@ gtk_sort_list_model_set_model (GtkSortListModel *self,
       g_signal_connect (model, "items-changed", G_CALLBACK (gtk_sort_list_model_items_changed_cb), self);
       added = g_list_model_get_n_items (model);
 
-      gtk_sort_list_model_create_sequences (self);
+      gtk_sort_list_model_create_items (self);
     }
   else
     added = 0;
@@ -533,6 +934,16 @@ gtk_sort_list_model_has_sort (GtkSortListModel *self)
   return self->sort_func != NULL;
 }
 
+static int
+compare_items (gconstpointer a,
+               gconstpointer b,
+               gpointer      data)
+{
+  GtkSortListModel *self = data;
+
+  return self->sort_func (*(gpointer *) a, *(gpointer *) b, self->user_data);
+}
+
 /**
  * gtk_sort_list_model_resort:
  * @self: a #GtkSortListModel
@@ -541,6 +952,9 @@ gtk_sort_list_model_has_sort (GtkSortListModel *self)
  *
  * Calling this function is necessary when data used by the sort
  * function has changed.
+ *
+ * If the model sorts incrementally, the items keep their current
+ * order until sorting is done.
  **/
 void
 gtk_sort_list_model_resort (GtkSortListModel *self)
@@ -548,16 +962,100 @@ gtk_sort_list_model_resort (GtkSortListModel *self)
   guint n_items;
 
   g_return_if_fail (GTK_IS_SORT_LIST_MODEL (self));
-  
-  if (self->sorted == NULL)
+
+  if (self->sort_func == NULL || self->model == NULL)
     return;
 
   n_items = g_list_model_get_n_items (self->model);
   if (n_items <= 1)
     return;
 
-  g_sequence_sort (self->sorted, self->sort_func, self->user_data);
+  if (self->incremental)
+    {
+      gtk_sort_list_model_start_sorting (self);
+      return;
+    }
+
+  g_array_sort_with_data (self->sorted, compare_items, self);
 
   g_list_model_items_changed (G_LIST_MODEL (self), 0, n_items, n_items);
 }
 
+/**
+ * gtk_sort_list_model_set_incremental:
+ * @self: a #GtkSortListModel
+ * @incremental: %TRUE to sort incrementally
+ *
+ * Sets the sort model to do an incremental sort.
+ *
+ * When incremental sorting is enabled, the sort list model will not do
+ * a complete sort immediately, but will instead sort a bit at a time
+ * whenever the main loop is idle, so that the application stays
+ * responsive. Until sorting is done, the items keep their previous
+ * order. When it is done, a single #GListModel::items-changed signal
+ * is emitted. The #GtkSortListModel:pending property can be used to
+ * show progress.
+ *
+ * Changes to the model being sorted restart an ongoing sort.
+ *
+ * By default, incremental sorting is disabled.
+ **/
+void
+gtk_sort_list_model_set_incremental (GtkSortListModel *self,
+                                     gboolean          incremental)
+{
+  g_return_if_fail (GTK_IS_SORT_LIST_MODEL (self));
+
+  if (self->incremental == incremental)
+    return;
+
+  self->incremental = incremental;
+
+  if (!incremental && self->sort_state)
+    gtk_sort_list_model_finish_sorting (self);
+
+  g_object_notify_by_pspec (G_OBJECT (self), properties[PROP_INCREMENTAL]);
+}
+
+/**
+ * gtk_sort_list_model_get_incremental:
+ * @self: a #GtkSortListModel
+ *
+ * Returns whether incremental sorting was enabled via
+ * gtk_sort_list_model_set_incremental().
+ *
+ * Returns: %TRUE if incremental sorting is enabled
+ **/
+gboolean
+gtk_sort_list_model_get_incremental (GtkSortListModel *self)
+{
+  g_return_val_if_fail (GTK_IS_SORT_LIST_MODEL (self), FALSE);
+
+  return self->incremental;
+}
+
+/**
+ * gtk_sort_list_model_get_pending:
+ * @self: a #GtkSortListModel
+ *
+ * Estimates the progress of an ongoing incremental sort.
+ *
+ * The estimate is the number of items that would still need to be
+ * sorted if sorting was a linear algorithm. So it is not related to
+ * how many items are already in their correct place. It goes down
+ * from the number of items to 0 while sorting.
+ *
+ * Returns: the estimated number of items left to sort or 0 if
+ *   the model is not sorting
+ **/
+guint
+gtk_sort_list_model_get_pending (GtkSortListModel *self)
+{
+  g_return_val_if_fail (GTK_IS_SORT_LIST_MODEL (self), 0);
+
+  if (self->sort_state == NULL)
+    return 0;
+
+  return sort_state_get_pending (self->sort_state);
+}
+
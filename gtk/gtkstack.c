@@ -153,6 +153,10 @@ typedef struct {
 
   GtkStackTransitionType active_transition_type;
 
+  /* the incoming child, if we turned on its cache-rendering
+   * for the duration of the transition */
+  GtkWidget *cached_child;
+
 } GtkStackPrivate;
 
 static GParamSpec *stack_props[LAST_PROP] = { NULL, };
@@ -763,6 +767,32 @@ get_bin_window_y (GtkStack *stack)
   return y;
 }
 
+/* During a transition, the children only move or fade, so let the
+ * renderer keep the incoming one as a texture instead of drawing
+ * the whole page again every frame. If the page changes anyway,
+ * the renderer just updates its texture.
+ */
+static void
+gtk_stack_cache_child (GtkStack  *stack,
+                       GtkWidget *child)
+{
+  GtkStackPrivate *priv = gtk_stack_get_instance_private (stack);
+
+  if (priv->cached_child == child)
+    return;
+
+  if (priv->cached_child)
+    gtk_widget_set_cache_rendering (priv->cached_child, FALSE);
+
+  priv->cached_child = NULL;
+
+  if (child && !gtk_widget_get_cache_rendering (child))
+    {
+      gtk_widget_set_cache_rendering (child, TRUE);
+      priv->cached_child = child;
+    }
+}
+
 static void
 gtk_stack_progress_updated (GtkStack *stack)
 {
@@ -778,6 +808,7 @@ gtk_stack_progress_updated (GtkStack *stack)
   if (gtk_progress_tracker_get_state (&priv->tracker) == GTK_PROGRESS_STATE_AFTER)
     {
       g_clear_pointer (&priv->last_visible_node, gsk_render_node_unref);
+      gtk_stack_cache_child (stack, NULL);
 
       if (priv->last_visible_child != NULL)
         {
@@ -904,6 +935,7 @@ gtk_stack_start_transition (GtkStack               *stack,
     {
       priv->active_transition_type = effective_transition_type (stack, transition_type);
       priv->first_frame_skipped = FALSE;
+      gtk_stack_cache_child (stack, priv->visible_child ? priv->visible_child->widget : NULL);
       gtk_stack_schedule_ticks (stack);
       gtk_progress_tracker_start (&priv->tracker,
                                   priv->transition_duration * 1000,
@@ -1195,6 +1227,9 @@ gtk_stack_remove (GtkContainer *container,
   if (priv->last_visible_child == child_info)
     priv->last_visible_child = NULL;
 
+  if (priv->cached_child == child)
+    gtk_stack_cache_child (stack, NULL);
+
   gtk_widget_unparent (child);
 
   g_free (child_info->name);
@@ -1945,12 +1980,21 @@ gtk_stack_snapshot (GtkWidget   *widget,
               priv->last_visible_child != NULL)
             {
               GtkSnapshot *last_visible_snapshot;
+              GskRenderNode *node;
 
               gtk_widget_get_allocation (priv->last_visible_child->widget,
                                          &priv->last_visible_surface_allocation);
               last_visible_snapshot = gtk_snapshot_new ();
               gtk_widget_snapshot (priv->last_visible_child->widget, last_visible_snapshot);
-              priv->last_visible_node = gtk_snapshot_free_to_node (last_visible_snapshot);
+              node = gtk_snapshot_free_to_node (last_visible_snapshot);
+              if (node)
+                {
+                  /* It's drawn unchanged for the whole transition. Wrap it,
+                   * the node may be the one the child keeps for itself */
+                  priv->last_visible_node = gsk_container_node_new (&node, 1);
+                  gsk_render_node_set_cache_hint (priv->last_visible_node, TRUE);
+                  gsk_render_node_unref (node);
+                }
             }
 
           gtk_snapshot_push_clip (snapshot,
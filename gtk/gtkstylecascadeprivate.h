@@ -40,6 +40,9 @@ struct _GtkStyleCascade
   GtkStyleCascade *parent;
   GArray *providers;
   int scale;
+
+  /* The provider whose change we are forwarding */
+  GtkStyleProvider *changed_provider;
 };
 
 struct _GtkStyleCascadeClass
@@ -29,6 +29,7 @@
 #include "gtkcssimagevalueprivate.h"
 #include "gtkcssnodedeclarationprivate.h"
 #include "gtkcssnodeprivate.h"
+#include "gtkcssnodestylecacheprivate.h"
 #include "gtkcssnumbervalueprivate.h"
 #include "gtkcsspathnodeprivate.h"
 #include "gtkcssrgbavalueprivate.h"
@@ -553,6 +554,9 @@ gtk_style_context_reset_widgets (GdkDisplay *display)
 {
   GList *list, *toplevels;
 
+  /* Settings the styles were computed with changed */
+  gtk_css_node_style_cache_clear_shared ();
+
   toplevels = gtk_window_list_toplevels ();
   g_list_foreach (toplevels, (GFunc) g_object_ref, NULL);
 
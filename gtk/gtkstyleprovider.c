@@ -123,6 +123,34 @@ gtk_style_provider_changed (GtkStyleProvider *provider)
   g_signal_emit (provider, signals[CHANGED], 0);
 }
 
+/*
+ * gtk_style_provider_may_have_changed:
+ * @provider: a #GtkStyleProvider
+ * @matcher: the matcher of a node
+ *
+ * While @provider emits the changed signal, tells if the change may
+ * affect the style of the node matched by @matcher. Nodes the change
+ * can't affect don't need to be restyled.
+ *
+ * Returns: %FALSE if the node's style is known to be unaffected
+ */
+gboolean
+gtk_style_provider_may_have_changed (GtkStyleProvider    *provider,
+                                     const GtkCssMatcher *matcher)
+{
+  GtkStyleProviderInterface *iface;
+
+  gtk_internal_return_val_if_fail (GTK_IS_STYLE_PROVIDER (provider), TRUE);
+  gtk_internal_return_val_if_fail (matcher != NULL, TRUE);
+
+  iface = GTK_STYLE_PROVIDER_GET_INTERFACE (provider);
+
+  if (!iface->may_have_changed)
+    return TRUE;
+
+  return iface->may_have_changed (provider, matcher);
+}
+
 GtkSettings *
 gtk_style_provider_get_settings (GtkStyleProvider *provider)
 {
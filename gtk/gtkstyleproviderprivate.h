@@ -45,6 +45,8 @@ struct _GtkStyleProviderInterface
                                                  const GtkCssMatcher     *matcher,
                                                  GtkCssLookup            *lookup,
                                                  GtkCssChange            *out_change);
+  gboolean              (* may_have_changed)    (GtkStyleProvider *provider,
+                                                 const GtkCssMatcher     *matcher);
   void                  (* emit_error)          (GtkStyleProvider *provider,
                                                  GtkCssSection           *section,
                                                  const GError            *error);
@@ -64,6 +66,8 @@ void                    gtk_style_provider_lookup                (GtkStyleProvid
                                                                   GtkCssChange            *out_change);
 
 void                    gtk_style_provider_changed               (GtkStyleProvider *provider);
+gboolean                gtk_style_provider_may_have_changed      (GtkStyleProvider *provider,
+                                                                  const GtkCssMatcher     *matcher);
 
 void                    gtk_style_provider_emit_error            (GtkStyleProvider *provider,
                                                                   GtkCssSection           *section,
@@ -1118,6 +1118,7 @@ _gtk_text_btree_insert (GtkTextIter *iter,
   int char_count_delta;                /* change to number of chars */
   GtkTextBTree *tree;
   gint start_byte_index;
+  gint end_byte_index;
   GtkTextLine *start_line;
 
   g_return_if_fail (text != NULL);
@@ -1132,6 +1133,7 @@ _gtk_text_btree_insert (GtkTextIter *iter,
   
   start_line = line;
   start_byte_index = gtk_text_iter_get_line_index (iter);
+  end_byte_index = start_byte_index;
 
   /* Get our insertion segment split. Note this assumes line allows
    * char insertions, which isn't true of the "last" line. But iter
@@ -1180,6 +1182,7 @@ _gtk_text_btree_insert (GtkTextIter *iter,
       seg = _gtk_char_segment_new (&text[sol], chunk_len);
 
       char_count_delta += seg->char_count;
+      end_byte_index += chunk_len;
 
       if (cur_seg == NULL)
         {
@@ -1212,6 +1215,7 @@ _gtk_text_btree_insert (GtkTextIter *iter,
       seg->next = NULL;
       line = newline;
       cur_seg = NULL;
+      end_byte_index = 0;
       line_count_delta++;
     }
 
@@ -1239,12 +1243,10 @@ _gtk_text_btree_insert (GtkTextIter *iter,
                                       &start,
                                       start_line,
                                       start_byte_index);
-    end = start;
-
-    /* We could almost certainly be more efficient here
-       by saving the information from the insertion loop
-       above. FIXME */
-    gtk_text_iter_forward_chars (&end, char_count_delta);
+    _gtk_text_btree_get_iter_at_line (tree,
+                                      &end,
+                                      line,
+                                      end_byte_index);
 
     DV (g_print ("invalidating due to inserting some text (%s)\n", G_STRLOC));
     _gtk_text_btree_invalidate_region (tree, &start, &end, FALSE);
@@ -3620,6 +3622,7 @@ _gtk_text_line_data_new (GtkTextLayout *layout,
   line_data->top_ink = 0;
   line_data->bottom_ink = 0;
   line_data->valid = FALSE;
+  line_data->estimated = FALSE;
 
   return line_data;
 }
@@ -5446,7 +5449,7 @@ _gtk_text_btree_validate_line (GtkTextBTree     *tree,
   g_return_if_fail (view != NULL);
   
   ld = _gtk_text_line_get_data (line, view_id);
-  if (!ld || !ld->valid)
+  if (!ld || !ld->valid || ld->estimated)
     {
       ld = gtk_text_layout_wrap (view->layout, line, ld);
       
@@ -5748,12 +5751,24 @@ gtk_text_btree_rebalance (GtkTextBTree *tree,
        * then split off all but the first MIN_CHILDREN into a separate
        * GtkTextBTreeNode following the original one.  Then repeat until the
        * GtkTextBTreeNode has a decent size.
+       *
+       * A large insertion leaves many more children than that, and
+       * building the tree out of minimal nodes would make it deeper than
+       * needed, so keep the nodes half way between minimal and full
+       * while there are enough children left over.
        */
 
       if (node->num_children > MAX_CHILDREN)
         {
           while (1)
             {
+              int keep;
+
+              if (node->num_children > 2 * MAX_CHILDREN)
+                keep = (MIN_CHILDREN + MAX_CHILDREN) / 2;
+              else
+                keep = MIN_CHILDREN;
+
               /*
                * If the GtkTextBTreeNode being split is the root
                * GtkTextBTreeNode, then make a new root GtkTextBTreeNode above
@@ -5777,10 +5792,10 @@ gtk_text_btree_rebalance (GtkTextBTree *tree,
               node->next = new_node;
               new_node->summary = NULL;
               new_node->level = node->level;
-              new_node->num_children = node->num_children - MIN_CHILDREN;
+              new_node->num_children = node->num_children - keep;
               if (node->level == 0)
                 {
-                  for (i = MIN_CHILDREN-1,
+                  for (i = keep-1,
                          line = node->children.line;
                        i > 0; i--, line = line->next)
                     {
@@ -5791,7 +5806,7 @@ gtk_text_btree_rebalance (GtkTextBTree *tree,
                 }
               else
                 {
-                  for (i = MIN_CHILDREN-1,
+                  for (i = keep-1,
                          child = node->children.node;
                        i > 0; i--, child = child->next)
                     {
@@ -223,7 +223,9 @@ struct _GtkTextLineData {
   gint top_ink : 16;
   gint bottom_ink : 16;
   signed int width : 24;
-  guint valid : 8;		/* Actually a boolean */
+  guint valid : 1;
+  /* width and height are guessed, see gtk_text_layout_validate_offscreen() */
+  guint estimated : 1;
 };
 
 /*
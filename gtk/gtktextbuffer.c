@@ -33,6 +33,7 @@
 #include "gtktextbuffer.h"
 #include "gtktextbufferprivate.h"
 #include "gtktextbtree.h"
+#include "gtktexthistoryprivate.h"
 #include "gtktextiterprivate.h"
 #include "gtktexttagprivate.h"
 #include "gtkprivate.h"
@@ -62,11 +63,16 @@ struct _GtkTextBufferPrivate
 
   GtkTextLogAttrCache *log_attr_cache;
 
+  GtkTextHistory *history;
+  guint max_undo_bytes;
+
   guint user_action_count;
 
   /* Whether the buffer has been modified since last save */
   guint modified : 1;
   guint has_selection : 1;
+  guint can_undo : 1;
+  guint can_redo : 1;
 };
 
 typedef struct _ClipboardRequest ClipboardRequest;
@@ -108,11 +114,18 @@ enum {
   PROP_CURSOR_POSITION,
   PROP_COPY_TARGET_LIST,
   PROP_PASTE_TARGET_LIST,
+  PROP_ENABLE_UNDO,
+  PROP_MAX_UNDO_BYTES,
+  PROP_CAN_UNDO,
+  PROP_CAN_REDO,
   LAST_PROP
 };
 
 static void gtk_text_buffer_finalize   (GObject            *object);
 
+static void update_undo_state (GtkTextBuffer *buffer);
+static void clear_history     (GtkTextBuffer *buffer);
+
 static void gtk_text_buffer_real_insert_text           (GtkTextBuffer     *buffer,
                                                         GtkTextIter       *iter,
                                                         const gchar       *text,
@@ -480,6 +493,58 @@ gtk_text_buffer_class_init (GtkTextBufferClass *klass)
                           GDK_TYPE_CONTENT_FORMATS,
                           GTK_PARAM_READABLE);
 
+  /**
+   * GtkTextBuffer:enable-undo:
+   *
+   * Whether the buffer records changes, so that they can be undone
+   * with gtk_text_buffer_undo().
+   */
+  text_buffer_props[PROP_ENABLE_UNDO] =
+      g_param_spec_boolean ("enable-undo",
+                            P_("Enable undo"),
+                            P_("Whether changes to the buffer can be undone"),
+                            FALSE,
+                            GTK_PARAM_READWRITE | G_PARAM_EXPLICIT_NOTIFY);
+
+  /**
+   * GtkTextBuffer:max-undo-bytes:
+   *
+   * The maximum amount of memory, in bytes, used to record changes
+   * for undo. When the limit is exceeded, the oldest changes are
+   * dropped. 0 means no limit.
+   */
+  text_buffer_props[PROP_MAX_UNDO_BYTES] =
+      g_param_spec_uint ("max-undo-bytes",
+                         P_("Maximum undo bytes"),
+                         P_("Maximum memory used to record changes for undo, or 0 for no limit"),
+                         0, G_MAXUINT,
+                         0,
+                         GTK_PARAM_READWRITE | G_PARAM_EXPLICIT_NOTIFY);
+
+  /**
+   * GtkTextBuffer:can-undo:
+   *
+   * Whether there is a recorded change that can be undone.
+   */
+  text_buffer_props[PROP_CAN_UNDO] =
+      g_param_spec_boolean ("can-undo",
+                            P_("Can undo"),
+                            P_("Whether there is a change that can be undone"),
+                            FALSE,
+                            GTK_PARAM_READABLE);
+
+  /**
+   * GtkTextBuffer:can-redo:
+   *
+   * Whether there is an undone change that can be redone.
+   */
+  text_buffer_props[PROP_CAN_REDO] =
+      g_param_spec_boolean ("can-redo",
+                            P_("Can redo"),
+                            P_("Whether there is an undone change that can be redone"),
+                            FALSE,
+                            GTK_PARAM_READABLE);
+
   g_object_class_install_properties (object_class, LAST_PROP, text_buffer_props);
 
   /**
@@ -900,6 +965,14 @@ gtk_text_buffer_set_property (GObject         *object,
 				g_value_get_string (value), -1);
       break;
 
+    case PROP_ENABLE_UNDO:
+      gtk_text_buffer_set_enable_undo (text_buffer, g_value_get_boolean (value));
+      break;
+
+    case PROP_MAX_UNDO_BYTES:
+      gtk_text_buffer_set_max_undo_bytes (text_buffer, g_value_get_uint (value));
+      break;
+
     default:
       G_OBJECT_WARN_INVALID_PROPERTY_ID (object, prop_id, pspec);
       break;
@@ -946,6 +1019,22 @@ gtk_text_buffer_get_property (GObject         *object,
       g_value_set_int (value, gtk_text_iter_get_offset (&iter));
       break;
 
+    case PROP_ENABLE_UNDO:
+      g_value_set_boolean (value, text_buffer->priv->history != NULL);
+      break;
+
+    case PROP_MAX_UNDO_BYTES:
+      g_value_set_uint (value, text_buffer->priv->max_undo_bytes);
+      break;
+
+    case PROP_CAN_UNDO:
+      g_value_set_boolean (value, text_buffer->priv->can_undo);
+      break;
+
+    case PROP_CAN_REDO:
+      g_value_set_boolean (value, text_buffer->priv->can_redo);
+      break;
+
     default:
       G_OBJECT_WARN_INVALID_PROPERTY_ID (object, prop_id, pspec);
       break;
@@ -981,6 +1070,12 @@ gtk_text_buffer_finalize (GObject *object)
 
   remove_all_selection_clipboards (buffer);
 
+  if (priv->history)
+    {
+      _gtk_text_history_free (priv->history);
+      priv->history = NULL;
+    }
+
   if (priv->tag_table)
     {
       _gtk_text_tag_table_remove_buffer (priv->tag_table, buffer);
@@ -1081,11 +1176,25 @@ gtk_text_buffer_real_insert_text (GtkTextBuffer *buffer,
                                   const gchar   *text,
                                   gint           len)
 {
+  GtkTextBufferPrivate *priv;
+  guint offset = 0;
+
   g_return_if_fail (GTK_IS_TEXT_BUFFER (buffer));
   g_return_if_fail (iter != NULL);
-  
+
+  priv = buffer->priv;
+
+  if (priv->history)
+    offset = gtk_text_iter_get_offset (iter);
+
   _gtk_text_btree_insert (iter, text, len);
 
+  if (priv->history)
+    {
+      _gtk_text_history_text_inserted (priv->history, offset, text, len);
+      update_undo_state (buffer);
+    }
+
   g_signal_emit (buffer, signals[CHANGED], 0);
   g_object_notify_by_pspec (G_OBJECT (buffer), text_buffer_props[PROP_CURSOR_POSITION]);
 }
@@ -1792,14 +1901,40 @@ gtk_text_buffer_real_delete_range (GtkTextBuffer *buffer,
                                    GtkTextIter   *start,
                                    GtkTextIter   *end)
 {
+  GtkTextBufferPrivate *priv;
   gboolean has_selection;
+  gchar *text = NULL;
+  guint begin = 0, finish = 0;
 
   g_return_if_fail (GTK_IS_TEXT_BUFFER (buffer));
   g_return_if_fail (start != NULL);
   g_return_if_fail (end != NULL);
 
+  priv = buffer->priv;
+
+  if (priv->history)
+    {
+      begin = gtk_text_iter_get_offset (start);
+      finish = gtk_text_iter_get_offset (end);
+      text = gtk_text_iter_get_text (start, end);
+    }
+
   _gtk_text_btree_delete (start, end);
 
+  if (priv->history)
+    {
+      /* Images and child anchors are not part of the text, and
+       * can't be restored, so such a deletion can't be undone.
+       */
+      if ((guint) g_utf8_strlen (text, -1) == finish - begin)
+        _gtk_text_history_text_deleted (priv->history, begin, finish, text);
+      else
+        clear_history (buffer);
+
+      update_undo_state (buffer);
+      g_free (text);
+    }
+
   /* may have deleted the selection... */
   update_selection_clipboards (buffer);
 
@@ -2090,6 +2225,12 @@ gtk_text_buffer_real_insert_texture (GtkTextBuffer *buffer,
 { 
   _gtk_text_btree_insert_texture (iter, texture);
 
+  if (buffer->priv->history)
+    {
+      clear_history (buffer);
+      update_undo_state (buffer);
+    }
+
   g_signal_emit (buffer, signals[CHANGED], 0);
 }
 
@@ -2133,6 +2274,12 @@ gtk_text_buffer_real_insert_anchor (GtkTextBuffer      *buffer,
 {
   _gtk_text_btree_insert_child_anchor (iter, anchor);
 
+  if (buffer->priv->history)
+    {
+      clear_history (buffer);
+      update_undo_state (buffer);
+    }
+
   g_signal_emit (buffer, signals[CHANGED], 0);
 }
 
@@ -3285,6 +3432,10 @@ gtk_text_buffer_set_modified (GtkTextBuffer *buffer,
   else
     {
       buffer->priv->modified = fixed_setting;
+
+      if (!fixed_setting && buffer->priv->history)
+        _gtk_text_history_modified_cleared (buffer->priv->history);
+
       g_signal_emit (buffer, signals[MODIFIED_CHANGED], 0);
     }
 }
@@ -4010,6 +4161,9 @@ gtk_text_buffer_begin_user_action (GtkTextBuffer *buffer)
   
   if (buffer->priv->user_action_count == 1)
     {
+      if (buffer->priv->history)
+        _gtk_text_history_begin_user_action (buffer->priv->history);
+
       /* Outermost nested user action begin emits the signal */
       g_signal_emit (buffer, signals[BEGIN_USER_ACTION], 0);
     }
@@ -4032,11 +4186,258 @@ gtk_text_buffer_end_user_action (GtkTextBuffer *buffer)
   
   if (buffer->priv->user_action_count == 0)
     {
+      if (buffer->priv->history)
+        {
+          _gtk_text_history_end_user_action (buffer->priv->history);
+          update_undo_state (buffer);
+        }
+
       /* Ended the outermost-nested user action end, so emit the signal */
       g_signal_emit (buffer, signals[END_USER_ACTION], 0);
     }
 }
 
+/*
+ * Undo
+ */
+
+static void
+update_undo_state (GtkTextBuffer *buffer)
+{
+  GtkTextBufferPrivate *priv = buffer->priv;
+  gboolean can_undo = FALSE, can_redo = FALSE;
+
+  if (priv->history)
+    {
+      can_undo = _gtk_text_history_get_can_undo (priv->history);
+      can_redo = _gtk_text_history_get_can_redo (priv->history);
+    }
+
+  if (priv->can_undo != can_undo)
+    {
+      priv->can_undo = can_undo;
+      g_object_notify_by_pspec (G_OBJECT (buffer), text_buffer_props[PROP_CAN_UNDO]);
+    }
+
+  if (priv->can_redo != can_redo)
+    {
+      priv->can_redo = can_redo;
+      g_object_notify_by_pspec (G_OBJECT (buffer), text_buffer_props[PROP_CAN_REDO]);
+    }
+}
+
+static void
+clear_history (GtkTextBuffer *buffer)
+{
+  GtkTextBufferPrivate *priv = buffer->priv;
+
+  _gtk_text_history_clear (priv->history);
+
+  if (!priv->modified)
+    _gtk_text_history_modified_cleared (priv->history);
+}
+
+/**
+ * gtk_text_buffer_set_enable_undo:
+ * @buffer: a #GtkTextBuffer
+ * @enable_undo: whether to record changes for undo
+ *
+ * Sets whether @buffer records changes so that they can be undone
+ * with gtk_text_buffer_undo() and redone with gtk_text_buffer_redo().
+ *
+ * Changes are recorded as the inserted or deleted text together
+ * with its position, so the memory used grows with the amount of
+ * text that was changed rather than with the size of the buffer.
+ * All changes made inside a user action (see
+ * gtk_text_buffer_begin_user_action()) are undone in one step, and
+ * consecutive single character insertions or deletions are merged
+ * into one step per word. Tags are not recorded, and inserting or
+ * deleting images or child anchors drops all recorded changes.
+ *
+ * Disabling undo drops all recorded changes.
+ */
+void
+gtk_text_buffer_set_enable_undo (GtkTextBuffer *buffer,
+                                 gboolean       enable_undo)
+{
+  GtkTextBufferPrivate *priv;
+
+  g_return_if_fail (GTK_IS_TEXT_BUFFER (buffer));
+
+  priv = buffer->priv;
+  enable_undo = enable_undo != FALSE;
+
+  if (enable_undo == (priv->history != NULL))
+    return;
+
+  if (enable_undo)
+    {
+      priv->history = _gtk_text_history_new (buffer);
+      _gtk_text_history_set_max_bytes (priv->history, priv->max_undo_bytes);
+      if (!priv->modified)
+        _gtk_text_history_modified_cleared (priv->history);
+    }
+  else
+    {
+      _gtk_text_history_free (priv->history);
+      priv->history = NULL;
+    }
+
+  update_undo_state (buffer);
+
+  g_object_notify_by_pspec (G_OBJECT (buffer), text_buffer_props[PROP_ENABLE_UNDO]);
+}
+
+/**
+ * gtk_text_buffer_get_enable_undo:
+ * @buffer: a #GtkTextBuffer
+ *
+ * Gets whether @buffer records changes for undo.
+ * See gtk_text_buffer_set_enable_undo().
+ *
+ * Returns: %TRUE if changes can be undone
+ */
+gboolean
+gtk_text_buffer_get_enable_undo (GtkTextBuffer *buffer)
+{
+  g_return_val_if_fail (GTK_IS_TEXT_BUFFER (buffer), FALSE);
+
+  return buffer->priv->history != NULL;
+}
+
+/**
+ * gtk_text_buffer_set_max_undo_bytes:
+ * @buffer: a #GtkTextBuffer
+ * @max_undo_bytes: the maximum memory to use for undo, or 0
+ *
+ * Sets the maximum amount of memory, in bytes, that @buffer uses
+ * to record changes for undo. When the limit is exceeded, the oldest
+ * changes are dropped until the recorded changes fit again.
+ *
+ * A limit of 0 means that no changes are ever dropped.
+ */
+void
+gtk_text_buffer_set_max_undo_bytes (GtkTextBuffer *buffer,
+                                    guint          max_undo_bytes)
+{
+  GtkTextBufferPrivate *priv;
+
+  g_return_if_fail (GTK_IS_TEXT_BUFFER (buffer));
+
+  priv = buffer->priv;
+
+  if (priv->max_undo_bytes == max_undo_bytes)
+    return;
+
+  priv->max_undo_bytes = max_undo_bytes;
+
+  if (priv->history)
+    {
+      _gtk_text_history_set_max_bytes (priv->history, max_undo_bytes);
+      update_undo_state (buffer);
+    }
+
+  g_object_notify_by_pspec (G_OBJECT (buffer), text_buffer_props[PROP_MAX_UNDO_BYTES]);
+}
+
+/**
+ * gtk_text_buffer_get_max_undo_bytes:
+ * @buffer: a #GtkTextBuffer
+ *
+ * Gets the maximum amount of memory used to record changes for undo.
+ * See gtk_text_buffer_set_max_undo_bytes().
+ *
+ * Returns: the limit in bytes, or 0 if there is no limit
+ */
+guint
+gtk_text_buffer_get_max_undo_bytes (GtkTextBuffer *buffer)
+{
+  g_return_val_if_fail (GTK_IS_TEXT_BUFFER (buffer), 0);
+
+  return buffer->priv->max_undo_bytes;
+}
+
+/**
+ * gtk_text_buffer_get_can_undo:
+ * @buffer: a #GtkTextBuffer
+ *
+ * Gets whether there is a recorded change that gtk_text_buffer_undo()
+ * can undo.
+ *
+ * Returns: %TRUE if there is a change to undo
+ */
+gboolean
+gtk_text_buffer_get_can_undo (GtkTextBuffer *buffer)
+{
+  g_return_val_if_fail (GTK_IS_TEXT_BUFFER (buffer), FALSE);
+
+  return buffer->priv->can_undo;
+}
+
+/**
+ * gtk_text_buffer_get_can_redo:
+ * @buffer: a #GtkTextBuffer
+ *
+ * Gets whether there is an undone change that gtk_text_buffer_redo()
+ * can redo.
+ *
+ * Returns: %TRUE if there is a change to redo
+ */
+gboolean
+gtk_text_buffer_get_can_redo (GtkTextBuffer *buffer)
+{
+  g_return_val_if_fail (GTK_IS_TEXT_BUFFER (buffer), FALSE);
+
+  return buffer->priv->can_redo;
+}
+
+/**
+ * gtk_text_buffer_undo:
+ * @buffer: a #GtkTextBuffer
+ *
+ * Undoes the last recorded change, and places the cursor where
+ * the change happened. Does nothing if there is no change to undo,
+ * see gtk_text_buffer_get_can_undo(), or inside a user action.
+ *
+ * If the buffer returns to the state it was in when it was last
+ * marked as unmodified with gtk_text_buffer_set_modified(), it is
+ * marked as unmodified again.
+ */
+void
+gtk_text_buffer_undo (GtkTextBuffer *buffer)
+{
+  g_return_if_fail (GTK_IS_TEXT_BUFFER (buffer));
+
+  if (!buffer->priv->can_undo)
+    return;
+
+  _gtk_text_history_undo (buffer->priv->history);
+  update_undo_state (buffer);
+}
+
+/**
+ * gtk_text_buffer_redo:
+ * @buffer: a #GtkTextBuffer
+ *
+ * Redoes the last change undone with gtk_text_buffer_undo(). Does
+ * nothing if there is no change to redo, see
+ * gtk_text_buffer_get_can_redo(), or inside a user action.
+ *
+ * Redoable changes are dropped when the buffer is changed in any
+ * other way.
+ */
+void
+gtk_text_buffer_redo (GtkTextBuffer *buffer)
+{
+  g_return_if_fail (GTK_IS_TEXT_BUFFER (buffer));
+
+  if (!buffer->priv->can_redo)
+    return;
+
+  _gtk_text_history_redo (buffer->priv->history);
+  update_undo_state (buffer);
+}
+
 /*
  * Logical attribute cache
  */
@@ -457,6 +457,25 @@ void            gtk_text_buffer_begin_user_action       (GtkTextBuffer *buffer);
 GDK_AVAILABLE_IN_ALL
 void            gtk_text_buffer_end_user_action         (GtkTextBuffer *buffer);
 
+GDK_AVAILABLE_IN_ALL
+void            gtk_text_buffer_set_enable_undo         (GtkTextBuffer *buffer,
+                                                         gboolean       enable_undo);
+GDK_AVAILABLE_IN_ALL
+gboolean        gtk_text_buffer_get_enable_undo         (GtkTextBuffer *buffer);
+GDK_AVAILABLE_IN_ALL
+void            gtk_text_buffer_set_max_undo_bytes      (GtkTextBuffer *buffer,
+                                                         guint          max_undo_bytes);
+GDK_AVAILABLE_IN_ALL
+guint           gtk_text_buffer_get_max_undo_bytes      (GtkTextBuffer *buffer);
+GDK_AVAILABLE_IN_ALL
+gboolean        gtk_text_buffer_get_can_undo            (GtkTextBuffer *buffer);
+GDK_AVAILABLE_IN_ALL
+gboolean        gtk_text_buffer_get_can_redo            (GtkTextBuffer *buffer);
+GDK_AVAILABLE_IN_ALL
+void            gtk_text_buffer_undo                    (GtkTextBuffer *buffer);
+GDK_AVAILABLE_IN_ALL
+void            gtk_text_buffer_redo                    (GtkTextBuffer *buffer);
+
 
 G_END_DECLS
 
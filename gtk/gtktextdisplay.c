@@ -74,6 +74,9 @@
  */
 
 #include "config.h"
+
+#include <string.h>
+
 #include "gtktextdisplayprivate.h"
 #include "gtktextviewprivate.h"
 #include "gtkwidgetprivate.h"
@@ -481,26 +484,17 @@ text_renderer_set_state (GtkTextRenderer *text_renderer,
 
 static void
 text_renderer_begin (GtkTextRenderer *text_renderer,
-                     GtkWidget       *widget,
-                     cairo_t         *cr)
+                     GtkWidget       *widget)
 {
   GtkStyleContext *context;
-  GdkRGBA color;
   GtkCssNode *text_node;
 
   text_renderer->widget = widget;
-  text_renderer->cr = cr;
 
   context = gtk_widget_get_style_context (widget);
 
   text_node = gtk_text_view_get_text_node ((GtkTextView *)widget);
   gtk_style_context_save_to_node (context, text_node);
-
-  gtk_style_context_get_color (context, &color);
-
-  cairo_save (cr);
-
-  gdk_cairo_set_source_rgba (cr, &color);
 }
 
 /* Returns a GSList of (referenced) widgets encountered while drawing.
@@ -510,14 +504,11 @@ text_renderer_end (GtkTextRenderer *text_renderer)
 {
   GtkStyleContext *context;
 
-  cairo_restore (text_renderer->cr);
-
   context = gtk_widget_get_style_context (text_renderer->widget);
 
   gtk_style_context_restore (context);
 
   text_renderer->widget = NULL;
-  text_renderer->cr = NULL;
 
   if (text_renderer->error_color)
     {
@@ -811,6 +802,91 @@ get_text_renderer (void)
   return text_renderer;
 }
 
+/* The cached render nodes of the line displays only depend on the
+ * style through these colors, everything else is in the displays.
+ */
+static void
+update_render_colors (GtkTextLayout *layout,
+                      GtkWidget     *widget)
+{
+  GtkStyleContext *context;
+  GdkRGBA colors[3];
+  int i;
+
+  context = gtk_widget_get_style_context (widget);
+
+  gtk_style_context_save_to_node (context, gtk_text_view_get_text_node ((GtkTextView *)widget));
+  gtk_style_context_get_color (context, &colors[0]);
+  gtk_style_context_restore (context);
+
+  gtk_style_context_save_to_node (context, gtk_text_view_get_selection_node ((GtkTextView *)widget));
+G_GNUC_BEGIN_IGNORE_DEPRECATIONS
+  gtk_style_context_get_background_color (context, &colors[1]);
+G_GNUC_END_IGNORE_DEPRECATIONS
+  gtk_style_context_get_color (context, &colors[2]);
+  gtk_style_context_restore (context);
+
+  for (i = 0; i < G_N_ELEMENTS (colors); i++)
+    {
+      if (!gdk_rgba_equal (&colors[i], &layout->render_colors[i]))
+        {
+          memcpy (layout->render_colors, colors, sizeof (colors));
+          layout->render_stamp++;
+          break;
+        }
+    }
+}
+
+static GskRenderNode *
+get_line_node (GtkTextLayout      *layout,
+               GtkTextRenderer    *text_renderer,
+               GtkTextLineDisplay *line_display,
+               const GdkRectangle *clip,
+               int                 selection_start_index,
+               int                 selection_end_index)
+{
+  GskRenderNode *node;
+  cairo_t *cr;
+
+  if (line_display->node &&
+      line_display->node_x == clip->x &&
+      line_display->node_width == clip->width &&
+      line_display->node_selection_start == selection_start_index &&
+      line_display->node_selection_end == selection_end_index &&
+      line_display->node_stamp == layout->render_stamp)
+    return gsk_render_node_ref (line_display->node);
+
+  node = gsk_cairo_node_new (&GRAPHENE_RECT_INIT (clip->x, 0, clip->width, line_display->height));
+
+  cr = gsk_cairo_node_get_draw_context (node);
+  gdk_cairo_set_source_rgba (cr, &layout->render_colors[0]);
+
+  text_renderer->cr = cr;
+  render_para (text_renderer, line_display,
+               selection_start_index, selection_end_index);
+  text_renderer->cr = NULL;
+
+  cairo_destroy (cr);
+
+  /* The block cursor is drawn as part of the line, and changes
+   * with the focus, so lines that have it are not cached.
+   */
+  if (!line_display->has_block_cursor)
+    {
+      if (line_display->node)
+        gsk_render_node_unref (line_display->node);
+
+      line_display->node = gsk_render_node_ref (node);
+      line_display->node_x = clip->x;
+      line_display->node_width = clip->width;
+      line_display->node_selection_start = selection_start_index;
+      line_display->node_selection_end = selection_end_index;
+      line_display->node_stamp = layout->render_stamp;
+    }
+
+  return node;
+}
+
 void
 gtk_text_layout_snapshot (GtkTextLayout      *layout,
                           GtkWidget          *widget,
@@ -824,7 +900,6 @@ gtk_text_layout_snapshot (GtkTextLayout      *layout,
   gboolean have_selection;
   GSList *line_list;
   GSList *tmp_list;
-  cairo_t *cr;
 
   g_return_if_fail (GTK_IS_TEXT_LAYOUT (layout));
   g_return_if_fail (layout->default_style != NULL);
@@ -838,13 +913,10 @@ gtk_text_layout_snapshot (GtkTextLayout      *layout,
   if (line_list == NULL)
     return; /* nothing on the screen */
 
-  cr = gtk_snapshot_append_cairo (snapshot,
-                                  &GRAPHENE_RECT_INIT(clip->x, clip->y, clip->width, clip->height));
-  text_renderer = get_text_renderer ();
-  text_renderer_begin (text_renderer, widget, cr);
+  update_render_colors (layout, widget);
 
-  /* text_renderer_begin/end does cairo_save/restore */
-  cairo_translate (cr, 0, offset_y);
+  text_renderer = get_text_renderer ();
+  text_renderer_begin (text_renderer, widget);
 
   gtk_text_layout_wrap_loop_start (layout);
 
@@ -852,6 +924,10 @@ gtk_text_layout_snapshot (GtkTextLayout      *layout,
                                                          &selection_start,
                                                          &selection_end);
 
+  /* Every line is its own render node, which is kept with the line
+   * display, so that lines that didn't change are not rendered
+   * again, e.g. when scrolling or when the cursor blinks.
+   */
   tmp_list = line_list;
   while (tmp_list != NULL)
     {
@@ -865,6 +941,8 @@ gtk_text_layout_snapshot (GtkTextLayout      *layout,
 
       if (line_display->height > 0)
         {
+          GskRenderNode *node;
+
           g_assert (line_display->layout != NULL);
           
           if (have_selection)
@@ -895,16 +973,24 @@ gtk_text_layout_snapshot (GtkTextLayout      *layout,
                 }
             }
 
-          render_para (text_renderer, line_display,
-                       selection_start_index, selection_end_index);
+          gtk_snapshot_offset (snapshot, 0, offset_y);
+
+          node = get_line_node (layout, text_renderer, line_display, clip,
+                                selection_start_index, selection_end_index);
+          gtk_snapshot_append_node (snapshot, node);
+          gsk_render_node_unref (node);
 
           /* We paint the cursors last, because they overlap another chunk
            * and need to appear on top.
            */
           if (line_display->cursors != NULL)
             {
+              cairo_t *cr;
               int i;
 
+              cr = gtk_snapshot_append_cairo (snapshot,
+                                              &GRAPHENE_RECT_INIT (clip->x, 0, clip->width, line_display->height));
+
               for (i = 0; i < line_display->cursors->len; i++)
                 {
                   int index;
@@ -916,10 +1002,14 @@ gtk_text_layout_snapshot (GtkTextLayout      *layout,
                                                line_display->x_offset, line_display->top_margin,
                                                line_display->layout, index, dir);
                 }
+
+              cairo_destroy (cr);
             }
+
+          gtk_snapshot_offset (snapshot, 0, -offset_y);
         } /* line_display->height > 0 */
 
-      cairo_translate (cr, 0, line_display->height);
+      offset_y += line_display->height;
       gtk_text_layout_free_line_display (layout, line_display);
       
       tmp_list = tmp_list->next;
@@ -929,6 +1019,4 @@ gtk_text_layout_snapshot (GtkTextLayout      *layout,
   text_renderer_end (text_renderer);
 
   g_slist_free (line_list);
-
-  cairo_destroy (cr);
 }
@@ -0,0 +1,582 @@
+/* GTK - The GIMP Toolkit
+ * Copyright (C) 2019 Red Hat, Inc.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "config.h"
+
+#include <string.h>
+
+#include "gtktexthistoryprivate.h"
+
+#include "gtktextbufferprivate.h"
+#include "gtktextbtree.h"
+
+/* The history stores changes as deltas: an insertion or deletion is
+ * kept as the character offsets it applies to plus the affected text,
+ * never as a copy of the buffer. Changes made inside a user action
+ * are grouped so that they are undone together, and runs of typing
+ * or deleting single characters are merged into one step, broken up
+ * at word boundaries.
+ *
+ * Every action accounts for its own size, so the history can be kept
+ * below a byte limit by dropping the oldest actions first.
+ */
+
+typedef enum {
+  ACTION_INSERT,
+  ACTION_DELETE,
+  ACTION_GROUP
+} ActionKind;
+
+typedef struct _Action Action;
+
+struct _Action
+{
+  GList link;
+
+  ActionKind kind;
+
+  /* Character offsets of the affected range, for inserts and deletes */
+  guint begin;
+  guint end;
+
+  /* Bytes accounted for this action, including all children */
+  gsize n_bytes;
+
+  GString *text;
+  GQueue children;
+};
+
+struct _GtkTextHistory
+{
+  GtkTextBuffer *buffer;
+
+  /* Most recent action first */
+  GQueue undo_queue;
+  GQueue redo_queue;
+
+  /* The user action currently being recorded */
+  Action *group;
+
+  /* The top of the undo queue when the buffer was last marked as
+   * unmodified, only meaningful if @saved_valid is set.
+   */
+  Action *saved;
+
+  gsize n_bytes;
+  guint max_bytes;
+
+  /* Chars changed stamp of the btree after the last recorded change,
+   * used to notice edits that bypassed the history.
+   */
+  guint stamp;
+
+  guint applying : 1;
+  guint saved_valid : 1;
+};
+
+static guint
+get_stamp (GtkTextHistory *history)
+{
+  return _gtk_text_btree_get_chars_changed_stamp (_gtk_text_buffer_get_btree (history->buffer));
+}
+
+static Action *
+action_new (ActionKind kind)
+{
+  Action *action;
+
+  action = g_slice_new0 (Action);
+  action->link.data = action;
+  action->kind = kind;
+  action->n_bytes = sizeof (Action);
+
+  return action;
+}
+
+static void
+action_free (GtkTextHistory *history,
+             Action         *action)
+{
+  Action *child;
+
+  if (history->saved == action)
+    history->saved_valid = FALSE;
+
+  while ((child = g_queue_peek_head (&action->children)))
+    {
+      g_queue_unlink (&action->children, &child->link);
+      action_free (history, child);
+    }
+
+  if (action->text)
+    g_string_free (action->text, TRUE);
+
+  g_slice_free (Action, action);
+}
+
+static Action *
+action_new_text (ActionKind   kind,
+                 guint        begin,
+                 guint        end,
+                 const gchar *text,
+                 gsize        len)
+{
+  Action *action;
+
+  action = action_new (kind);
+  action->begin = begin;
+  action->end = end;
+  action->text = g_string_new_len (text, len);
+  action->n_bytes += len;
+
+  return action;
+}
+
+static void
+clear_queue (GtkTextHistory *history,
+             GQueue         *queue)
+{
+  Action *action;
+
+  while ((action = g_queue_peek_head (queue)))
+    {
+      g_queue_unlink (queue, &action->link);
+      history->n_bytes -= action->n_bytes;
+      action_free (history, action);
+    }
+}
+
+static void
+trim (GtkTextHistory *history)
+{
+  if (history->max_bytes == 0)
+    return;
+
+  while (history->n_bytes > history->max_bytes)
+    {
+      GQueue *queue;
+      Action *action;
+
+      if (history->undo_queue.length > 0)
+        queue = &history->undo_queue;
+      else if (history->redo_queue.length > 0)
+        queue = &history->redo_queue;
+      else
+        break;
+
+      /* Once the oldest change is gone, the state the history
+       * reaches when undoing everything is no longer the saved one.
+       */
+      if (queue == &history->undo_queue && history->saved == NULL)
+        history->saved_valid = FALSE;
+
+      action = g_queue_peek_tail (queue);
+      g_queue_unlink (queue, &action->link);
+      history->n_bytes -= action->n_bytes;
+      action_free (history, action);
+    }
+}
+
+static gunichar
+first_char (Action *action)
+{
+  return g_utf8_get_char (action->text->str);
+}
+
+static gunichar
+last_char (Action *action)
+{
+  return g_utf8_get_char (g_utf8_prev_char (action->text->str + action->text->len));
+}
+
+/* Starting a new word after whitespace starts a new undo step */
+static gboolean
+is_word_break (gunichar before,
+               gunichar after)
+{
+  return g_unichar_isspace (before) && !g_unichar_isspace (after);
+}
+
+static gboolean
+try_merge (GtkTextHistory *history,
+           Action         *action)
+{
+  Action *prev;
+
+  prev = g_queue_peek_head (&history->undo_queue);
+
+  if (prev == NULL ||
+      prev->kind != action->kind ||
+      prev->kind == ACTION_GROUP ||
+      action->end - action->begin != 1)
+    return FALSE;
+
+  /* Changes made after saving must stay separately undoable */
+  if (history->saved_valid && history->saved == prev)
+    return FALSE;
+
+  if (action->kind == ACTION_INSERT)
+    {
+      if (action->begin != prev->end ||
+          is_word_break (last_char (prev), first_char (action)))
+        return FALSE;
+
+      g_string_append_len (prev->text, action->text->str, action->text->len);
+      prev->end = action->end;
+    }
+  else if (action->begin == prev->begin)
+    {
+      /* Delete key */
+      if (is_word_break (last_char (prev), first_char (action)))
+        return FALSE;
+
+      g_string_append_len (prev->text, action->text->str, action->text->len);
+      prev->end += 1;
+    }
+  else if (action->end == prev->begin)
+    {
+      /* Backspace */
+      if (is_word_break (last_char (action), first_char (prev)))
+        return FALSE;
+
+      g_string_prepend_len (prev->text, action->text->str, action->text->len);
+      prev->begin = action->begin;
+    }
+  else
+    return FALSE;
+
+  prev->n_bytes += action->text->len;
+  history->n_bytes += action->text->len;
+  action_free (history, action);
+
+  return TRUE;
+}
+
+static void
+push_top (GtkTextHistory *history,
+          Action         *action)
+{
+  if (!try_merge (history, action))
+    {
+      g_queue_push_head_link (&history->undo_queue, &action->link);
+      history->n_bytes += action->n_bytes;
+    }
+
+  trim (history);
+}
+
+static void
+record (GtkTextHistory *history,
+        Action         *action)
+{
+  clear_queue (history, &history->redo_queue);
+
+  if (history->group)
+    {
+      g_queue_push_tail_link (&history->group->children, &action->link);
+      history->group->n_bytes += action->n_bytes;
+    }
+  else
+    push_top (history, action);
+
+  history->stamp = get_stamp (history);
+}
+
+GtkTextHistory *
+_gtk_text_history_new (GtkTextBuffer *buffer)
+{
+  GtkTextHistory *history;
+
+  history = g_slice_new0 (GtkTextHistory);
+  history->buffer = buffer;
+  history->stamp = get_stamp (history);
+
+  return history;
+}
+
+void
+_gtk_text_history_free (GtkTextHistory *history)
+{
+  _gtk_text_history_clear (history);
+
+  if (history->group)
+    action_free (history, history->group);
+
+  g_slice_free (GtkTextHistory, history);
+}
+
+void
+_gtk_text_history_begin_user_action (GtkTextHistory *history)
+{
+  if (history->applying)
+    return;
+
+  g_return_if_fail (history->group == NULL);
+
+  history->group = action_new (ACTION_GROUP);
+}
+
+void
+_gtk_text_history_end_user_action (GtkTextHistory *history)
+{
+  Action *group;
+
+  if (history->applying)
+    return;
+
+  group = history->group;
+  history->group = NULL;
+
+  if (group == NULL)
+    return;
+
+  if (group->children.length == 1)
+    {
+      /* A lone change doesn't need the group, and can be merged
+       * with the previous one, which is how typing gets coalesced.
+       */
+      Action *child = g_queue_peek_head (&group->children);
+
+      g_queue_unlink (&group->children, &child->link);
+      push_top (history, child);
+      action_free (history, group);
+    }
+  else if (group->children.length > 1)
+    push_top (history, group);
+  else
+    action_free (history, group);
+}
+
+void
+_gtk_text_history_text_inserted (GtkTextHistory *history,
+                                 guint           offset,
+                                 const gchar    *text,
+                                 gint            len)
+{
+  if (history->applying)
+    return;
+
+  if (len < 0)
+    len = strlen (text);
+
+  record (history, action_new_text (ACTION_INSERT,
+                                    offset,
+                                    offset + g_utf8_strlen (text, len),
+                                    text, len));
+}
+
+void
+_gtk_text_history_text_deleted (GtkTextHistory *history,
+                                guint           begin,
+                                guint           end,
+                                const gchar    *text)
+{
+  if (history->applying)
+    return;
+
+  record (history, action_new_text (ACTION_DELETE, begin, end, text, strlen (text)));
+}
+
+/* Drops all recorded changes, for changes that can't be undone */
+void
+_gtk_text_history_clear (GtkTextHistory *history)
+{
+  clear_queue (history, &history->undo_queue);
+  clear_queue (history, &history->redo_queue);
+
+  if (history->group)
+    {
+      action_free (history, history->group);
+      history->group = action_new (ACTION_GROUP);
+    }
+
+  history->saved_valid = FALSE;
+  history->stamp = get_stamp (history);
+}
+
+void
+_gtk_text_history_modified_cleared (GtkTextHistory *history)
+{
+  history->saved = g_queue_peek_head (&history->undo_queue);
+  history->saved_valid = TRUE;
+}
+
+gboolean
+_gtk_text_history_get_can_undo (GtkTextHistory *history)
+{
+  return history->undo_queue.length > 0;
+}
+
+gboolean
+_gtk_text_history_get_can_redo (GtkTextHistory *history)
+{
+  return history->redo_queue.length > 0;
+}
+
+static void
+apply_insert (GtkTextHistory *history,
+              Action         *action,
+              guint          *cursor)
+{
+  GtkTextIter iter;
+
+  gtk_text_buffer_get_iter_at_offset (history->buffer, &iter, action->begin);
+  gtk_text_buffer_insert (history->buffer, &iter, action->text->str, action->text->len);
+  *cursor = action->end;
+}
+
+static void
+apply_delete (GtkTextHistory *history,
+              Action         *action,
+              guint          *cursor)
+{
+  GtkTextIter start, end;
+
+  gtk_text_buffer_get_iter_at_offset (history->buffer, &start, action->begin);
+  gtk_text_buffer_get_iter_at_offset (history->buffer, &end, action->end);
+  gtk_text_buffer_delete (history->buffer, &start, &end);
+  *cursor = action->begin;
+}
+
+static void
+action_undo (GtkTextHistory *history,
+             Action         *action,
+             guint          *cursor)
+{
+  GList *l;
+
+  switch (action->kind)
+    {
+    case ACTION_INSERT:
+      apply_delete (history, action, cursor);
+      break;
+
+    case ACTION_DELETE:
+      apply_insert (history, action, cursor);
+      break;
+
+    case ACTION_GROUP:
+      for (l = action->children.tail; l; l = l->prev)
+        action_undo (history, l->data, cursor);
+      break;
+
+    default:
+      g_assert_not_reached ();
+    }
+}
+
+static void
+action_redo (GtkTextHistory *history,
+             Action         *action,
+             guint          *cursor)
+{
+  GList *l;
+
+  switch (action->kind)
+    {
+    case ACTION_INSERT:
+      apply_insert (history, action, cursor);
+      break;
+
+    case ACTION_DELETE:
+      apply_delete (history, action, cursor);
+      break;
+
+    case ACTION_GROUP:
+      for (l = action->children.head; l; l = l->next)
+        action_redo (history, l->data, cursor);
+      break;
+
+    default:
+      g_assert_not_reached ();
+    }
+}
+
+static void
+replay (GtkTextHistory *history,
+        gboolean        undo)
+{
+  GQueue *from, *to;
+  Action *action;
+  GtkTextIter iter;
+  guint cursor = 0;
+
+  from = undo ? &history->undo_queue : &history->redo_queue;
+  to = undo ? &history->redo_queue : &history->undo_queue;
+
+  if (history->group || from->length == 0)
+    return;
+
+  /* If the buffer was changed behind our back, the offsets we
+   * recorded can't be trusted anymore.
+   */
+  if (history->stamp != get_stamp (history))
+    {
+      _gtk_text_history_clear (history);
+      return;
+    }
+
+  action = g_queue_peek_head (from);
+  g_queue_unlink (from, &action->link);
+
+  history->applying = TRUE;
+
+  gtk_text_buffer_begin_user_action (history->buffer);
+  if (undo)
+    action_undo (history, action, &cursor);
+  else
+    action_redo (history, action, &cursor);
+  gtk_text_buffer_end_user_action (history->buffer);
+
+  gtk_text_buffer_get_iter_at_offset (history->buffer, &iter, cursor);
+  gtk_text_buffer_place_cursor (history->buffer, &iter);
+
+  g_queue_push_head_link (to, &action->link);
+
+  if (history->saved_valid &&
+      history->saved == g_queue_peek_head (&history->undo_queue))
+    gtk_text_buffer_set_modified (history->buffer, FALSE);
+
+  history->applying = FALSE;
+  history->stamp = get_stamp (history);
+}
+
+void
+_gtk_text_history_undo (GtkTextHistory *history)
+{
+  replay (history, TRUE);
+}
+
+void
+_gtk_text_history_redo (GtkTextHistory *history)
+{
+  replay (history, FALSE);
+}
+
+guint
+_gtk_text_history_get_max_bytes (GtkTextHistory *history)
+{
+  return history->max_bytes;
+}
+
+void
+_gtk_text_history_set_max_bytes (GtkTextHistory *history,
+                                 guint           max_bytes)
+{
+  history->max_bytes = max_bytes;
+  trim (history);
+}
@@ -4759,6 +4759,62 @@ lines_match (const GtkTextIter *start,
   return lines_match (&next, lines, visible_only, slice, case_insensitive, NULL, match_end);
 }
 
+/* Returns whether @line can contain a match starting with @byte.
+ * This lets searches skip lines without copying, case folding and
+ * normalizing their text. It only looks at the raw segments, so it
+ * may return %TRUE for lines that don't match, but never %FALSE for
+ * lines that do.
+ */
+static gboolean
+line_may_contain_byte (GtkTextLine *line,
+                       guchar       byte,
+                       gboolean     slice,
+                       gboolean     case_insensitive)
+{
+  GtkTextLineSegment *seg;
+  guchar other = byte;
+
+  if (case_insensitive)
+    {
+      /* Folding and normalizing non-ASCII text can produce
+       * just about anything, so only ASCII bytes are handled.
+       */
+      if (byte >= 0x80)
+        return TRUE;
+
+      other = g_ascii_toupper (byte);
+    }
+
+  for (seg = line->segments; seg != NULL; seg = seg->next)
+    {
+      if (seg->type == &gtk_text_char_type)
+        {
+          if (memchr (seg->body.chars, byte, seg->byte_count) != NULL)
+            return TRUE;
+
+          if (case_insensitive)
+            {
+              gint i;
+
+              for (i = 0; i < seg->byte_count; i++)
+                {
+                  guchar c = seg->body.chars[i];
+
+                  if (c == other || c >= 0x80)
+                    return TRUE;
+                }
+            }
+        }
+      else if (slice && seg->byte_count > 0)
+        {
+          /* Paintables and child anchors show up as U+FFFC */
+          return TRUE;
+        }
+    }
+
+  return FALSE;
+}
+
 /* strsplit() that retains the delimiter as part of the string. */
 static gchar **
 strbreakup (const char *string,
@@ -4925,6 +4981,11 @@ gtk_text_iter_forward_search (const GtkTextIter *iter,
       if (limit &&
           gtk_text_iter_compare (&search, limit) >= 0)
         break;
+
+      if (!line_may_contain_byte (_gtk_text_iter_get_text_line (&search),
+                                  (guchar) lines[0][0],
+                                  slice, case_insensitive))
+        continue;
       
       if (lines_match (&search, (const gchar**)lines,
                        visible_only, slice, case_insensitive, &match, &end))
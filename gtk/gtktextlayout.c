@@ -126,6 +126,7 @@ static void gtk_text_layout_emit_changed           (GtkTextLayout     *layout,
 						    gint               new_height);
 
 static void gtk_text_layout_invalidate_all (GtkTextLayout *layout);
+static void display_cache_clear            (GtkTextLayout *layout);
 
 static PangoAttribute *gtk_text_attr_appearance_new (const GtkTextAppearance *appearance);
 
@@ -169,6 +170,13 @@ enum {
 
 #define PIXEL_BOUND(d) (((d) + PANGO_SCALE - 1) / PANGO_SCALE)
 
+/* Line displays we keep at least, and in addition to the lines of a redraw */
+#define DISPLAY_CACHE_MIN_SIZE 16
+#define DISPLAY_CACHE_OVERSCAN 32
+
+/* Lines longer than this are not shaped by gtk_text_layout_validate_offscreen() */
+#define ESTIMATE_LINE_BYTES 10000
+
 static guint signals[LAST_SIGNAL] = { 0 };
 
 PangoAttrType gtk_text_attr_appearance_type = 0;
@@ -193,12 +201,7 @@ gtk_text_layout_dispose (GObject *object)
   g_clear_object (&layout->ltr_context);
   g_clear_object (&layout->rtl_context);
 
-  if (layout->one_display_cache)
-    {
-      GtkTextLineDisplay *tmp_display = layout->one_display_cache;
-      layout->one_display_cache = NULL;
-      gtk_text_layout_free_line_display (layout, tmp_display);
-    }
+  display_cache_clear (layout);
 
   if (layout->preedit_attrs != NULL)
     {
@@ -217,6 +220,7 @@ gtk_text_layout_finalize (GObject *object)
   layout = GTK_TEXT_LAYOUT (object);
 
   g_free (layout->preedit_string);
+  g_hash_table_unref (layout->display_cache);
 
   G_OBJECT_CLASS (gtk_text_layout_parent_class)->finalize (object);
 }
@@ -277,6 +281,9 @@ static void
 gtk_text_layout_init (GtkTextLayout *text_layout)
 {
   text_layout->cursor_visible = TRUE;
+  text_layout->display_cache = g_hash_table_new (NULL, NULL);
+  g_queue_init (&text_layout->display_lru);
+  text_layout->display_cache_size = DISPLAY_CACHE_MIN_SIZE;
 }
 
 GtkTextLayout*
@@ -295,6 +302,43 @@ free_style_cache (GtkTextLayout *text_layout)
     }
 }
 
+static void
+display_cache_remove (GtkTextLayout      *layout,
+                      GtkTextLineDisplay *display)
+{
+  g_hash_table_remove (layout->display_cache, display->line);
+  g_queue_unlink (&layout->display_lru, &display->lru_link);
+}
+
+static void
+display_cache_insert (GtkTextLayout      *layout,
+                      GtkTextLineDisplay *display)
+{
+  while (layout->display_lru.length >= layout->display_cache_size)
+    {
+      GtkTextLineDisplay *old = layout->display_lru.tail->data;
+
+      display_cache_remove (layout, old);
+      gtk_text_layout_free_line_display (layout, old);
+    }
+
+  display->lru_link.data = display;
+  g_hash_table_insert (layout->display_cache, display->line, display);
+  g_queue_push_head_link (&layout->display_lru, &display->lru_link);
+}
+
+static void
+display_cache_clear (GtkTextLayout *layout)
+{
+  while (layout->display_lru.head)
+    {
+      GtkTextLineDisplay *display = layout->display_lru.head->data;
+
+      display_cache_remove (layout, display);
+      gtk_text_layout_free_line_display (layout, display);
+    }
+}
+
 /**
  * gtk_text_layout_set_buffer:
  * @buffer: (allow-none):
@@ -635,15 +679,20 @@ text_layout_changed (GtkTextLayout *layout,
                      gint           new_height,
                      gboolean       cursors_only)
 {
-  /* Check if the range intersects our cached line display,
-   * and invalidate the cached line if so.
+  GList *l, *next;
+
+  /* Check if the range intersects our cached line displays,
+   * and invalidate the cached lines if so.
    */
-  if (layout->one_display_cache)
+  for (l = layout->display_lru.head; l != NULL; l = next)
     {
-      GtkTextLine *line = layout->one_display_cache->line;
+      GtkTextLineDisplay *display = l->data;
+      GtkTextLine *line = display->line;
       gint cache_y = _gtk_text_btree_find_line_top (_gtk_text_buffer_get_btree (layout->buffer),
 						    line, layout);
-      gint cache_height = layout->one_display_cache->height;
+      gint cache_height = display->height;
+
+      next = l->next;
 
       if (cache_y + cache_height > y && cache_y < y + old_height)
 	gtk_text_layout_invalidate_cache (layout, line, cursors_only);
@@ -759,9 +808,29 @@ gtk_text_layout_get_lines (GtkTextLayout *layout,
 
   retval = g_slist_reverse (retval);
 
+  /* This is what gets drawn, so make sure we can keep it around */
+  layout->display_cache_size = MAX (DISPLAY_CACHE_MIN_SIZE,
+                                    g_slist_length (retval) + DISPLAY_CACHE_OVERSCAN);
+
   return retval;
 }
 
+/* Tags that only mark text, e.g. for syntax or spell checking, without
+ * setting any properties don't change the style, so their toggles can
+ * be skipped when building line displays.
+ */
+static gboolean
+tag_affects_style (GtkTextTag *tag)
+{
+  GtkTextTagPrivate *priv = tag->priv;
+
+  return _gtk_text_tag_affects_size (tag) ||
+         _gtk_text_tag_affects_nonsize_appearance (tag) ||
+         priv->values->direction != GTK_TEXT_DIR_NONE ||
+         priv->language_set ||
+         priv->editable_set;
+}
+
 static void
 invalidate_cached_style (GtkTextLayout *layout)
 {
@@ -808,6 +877,8 @@ gtk_text_layout_invalidate_all (GtkTextLayout *layout)
   if (layout->buffer == NULL)
     return;
 
+  display_cache_clear (layout);
+
   gtk_text_buffer_get_bounds (layout->buffer, &start, &end);
 
   gtk_text_layout_invalidate (layout, &start, &end);
@@ -818,10 +889,11 @@ gtk_text_layout_invalidate_cache (GtkTextLayout *layout,
                                   GtkTextLine   *line,
 				  gboolean       cursors_only)
 {
-  if (layout->one_display_cache && line == layout->one_display_cache->line)
-    {
-      GtkTextLineDisplay *display = layout->one_display_cache;
+  GtkTextLineDisplay *display;
 
+  display = g_hash_table_lookup (layout->display_cache, line);
+  if (display)
+    {
       if (cursors_only)
 	{
           if (display->cursors)
@@ -832,7 +904,7 @@ gtk_text_layout_invalidate_cache (GtkTextLayout *layout,
 	}
       else
 	{
-	  layout->one_display_cache = NULL;
+	  display_cache_remove (layout, display);
 	  gtk_text_layout_free_line_display (layout, display);
 	}
     }
@@ -865,16 +937,39 @@ gtk_text_layout_invalidate_cursor_line (GtkTextLayout *layout,
     }
 }
 
+static void
+invalidate_neutral_line_display (GtkTextLayout *layout,
+                                 GtkTextLine   *line)
+{
+  GtkTextLineDisplay *display;
+
+  display = g_hash_table_lookup (layout->display_cache, line);
+  if (display && display->line->dir_strong == PANGO_DIRECTION_NEUTRAL)
+    gtk_text_layout_invalidate_cache (layout, line, FALSE);
+}
+
 static void
 gtk_text_layout_update_cursor_line(GtkTextLayout *layout)
 {
   GtkTextLayoutPrivate *priv = GTK_TEXT_LAYOUT_GET_PRIVATE (layout);
   GtkTextIter iter;
+  GtkTextLine *line;
 
   gtk_text_buffer_get_iter_at_mark (layout->buffer, &iter,
                                     gtk_text_buffer_get_insert (layout->buffer));
 
-  priv->cursor_line = _gtk_text_iter_get_text_line (&iter);
+  line = _gtk_text_iter_get_text_line (&iter);
+  if (line == priv->cursor_line)
+    return;
+
+  /* Lines without strong direction take the keyboard direction
+   * while they have the cursor, so drop their cached displays.
+   * The old cursor line may be gone, so only look it up.
+   */
+  invalidate_neutral_line_display (layout, priv->cursor_line);
+  invalidate_neutral_line_display (layout, line);
+
+  priv->cursor_line = line;
 }
 
 static void
@@ -926,13 +1021,23 @@ gtk_text_layout_real_invalidate_cursors (GtkTextLayout     *layout,
 					 const GtkTextIter *start,
 					 const GtkTextIter *end)
 {
-  /* Check if the range intersects our cached line display,
-   * and invalidate the cached line if so.
+  GList *l;
+
+  if (gtk_text_iter_compare (start, end) > 0)
+    {
+      const GtkTextIter *tmp = start;
+      start = end;
+      end = tmp;
+    }
+
+  /* Check if the range intersects our cached line displays,
+   * and invalidate the cached lines if so.
    */
-  if (layout->one_display_cache)
+  for (l = layout->display_lru.head; l != NULL; l = l->next)
     {
+      GtkTextLineDisplay *display = l->data;
       GtkTextIter line_start, line_end;
-      GtkTextLine *line = layout->one_display_cache->line;
+      GtkTextLine *line = display->line;
 
       gtk_text_layout_get_iter_at_line (layout, &line_start, line, 0);
 
@@ -940,13 +1045,6 @@ gtk_text_layout_real_invalidate_cursors (GtkTextLayout     *layout,
       if (!gtk_text_iter_ends_line (&line_end))
 	gtk_text_iter_forward_to_line_end (&line_end);
 
-      if (gtk_text_iter_compare (start, end) > 0)
-	{
-	  const GtkTextIter *tmp = start;
-	  start = end;
-	  end = tmp;
-	}
-
       if (gtk_text_iter_compare (&line_start, end) <= 0 &&
 	  gtk_text_iter_compare (start, &line_end) <= 0)
 	{
@@ -1036,7 +1134,7 @@ gtk_text_layout_validate_yrange (GtkTextLayout *layout,
   while (line && seen < -y0)
     {
       GtkTextLineData *line_data = _gtk_text_line_get_data (line, layout);
-      if (!line_data || !line_data->valid)
+      if (!line_data || !line_data->valid || line_data->estimated)
         {
           gint old_height, new_height;
           gint top_ink, bottom_ink;
@@ -1077,7 +1175,7 @@ gtk_text_layout_validate_yrange (GtkTextLayout *layout,
   while (line && seen < y1)
     {
       GtkTextLineData *line_data = _gtk_text_line_get_data (line, layout);
-      if (!line_data || !line_data->valid)
+      if (!line_data || !line_data->valid || line_data->estimated)
         {
           gint old_height, new_height;
           gint top_ink, bottom_ink;
@@ -1159,6 +1257,67 @@ gtk_text_layout_validate (GtkTextLayout *layout,
     }
 }
 
+/**
+ * gtk_text_layout_validate_offscreen:
+ * @layout: a #GtkTextLayout
+ * @max_pixels: the maximum number of pixels to validate
+ *
+ * Like gtk_text_layout_validate(), for lines that are not shown. Lines
+ * longer than ESTIMATE_LINE_BYTES are not shaped, their size is guessed
+ * from the font metrics instead, so a single huge paragraph can't block
+ * the main loop for long. gtk_text_layout_validate_yrange() lays them
+ * out for real once they are scrolled into view.
+ **/
+void
+gtk_text_layout_validate_offscreen (GtkTextLayout *layout,
+                                    gint           max_pixels)
+{
+  g_return_if_fail (GTK_IS_TEXT_LAYOUT (layout));
+
+  layout->estimate_long_lines = TRUE;
+  gtk_text_layout_validate (layout, max_pixels);
+  layout->estimate_long_lines = FALSE;
+}
+
+static void
+gtk_text_layout_estimate_line (GtkTextLayout   *layout,
+                               GtkTextLine     *line,
+                               GtkTextLineData *line_data)
+{
+  GtkTextAttributes *style = layout->default_style;
+  PangoFontMetrics *metrics;
+  gint64 text_width, n_rows;
+  int char_width, row_height, available;
+
+  metrics = pango_context_get_metrics (layout->ltr_context, style->font, style->language);
+  char_width = MAX (1, PANGO_PIXELS (pango_font_metrics_get_approximate_char_width (metrics)));
+  row_height = MAX (1, PANGO_PIXELS (pango_font_metrics_get_ascent (metrics) +
+                                     pango_font_metrics_get_descent (metrics)));
+  pango_font_metrics_unref (metrics);
+
+  text_width = (gint64) _gtk_text_line_char_count (line) * char_width;
+  available = MAX (1, layout->screen_width - style->left_margin - style->right_margin -
+                      layout->left_padding - layout->right_padding);
+
+  if (style->wrap_mode != GTK_WRAP_NONE && text_width > available)
+    {
+      n_rows = (text_width + available - 1) / available;
+      text_width = available;
+    }
+  else
+    n_rows = 1;
+
+  /* width is a 24 bit field */
+  line_data->width = MIN (text_width + style->left_margin + style->right_margin, (1 << 23) - 1);
+  line_data->height = MIN (n_rows * row_height + (n_rows - 1) * style->pixels_inside_wrap +
+                           style->pixels_above_lines + style->pixels_below_lines,
+                           G_MAXINT / 2);
+  line_data->top_ink = 0;
+  line_data->bottom_ink = 0;
+  line_data->valid = TRUE;
+  line_data->estimated = TRUE;
+}
+
 static GtkTextLineData*
 gtk_text_layout_real_wrap (GtkTextLayout   *layout,
                            GtkTextLine     *line,
@@ -1177,10 +1336,18 @@ gtk_text_layout_real_wrap (GtkTextLayout   *layout,
       _gtk_text_line_add_data (line, line_data);
     }
 
+  if (layout->estimate_long_lines &&
+      _gtk_text_line_byte_count (line) > ESTIMATE_LINE_BYTES)
+    {
+      gtk_text_layout_estimate_line (layout, line, line_data);
+      return line_data;
+    }
+
   display = gtk_text_layout_get_line_display (layout, line, TRUE);
   line_data->width = display->width;
   line_data->height = display->height;
   line_data->valid = TRUE;
+  line_data->estimated = FALSE;
   pango_layout_get_pixel_extents (display->layout, &ink_rect, &logical_rect);
   line_data->top_ink = MAX (0, logical_rect.x - ink_rect.x);
   line_data->bottom_ink = MAX (0, logical_rect.x + logical_rect.width - ink_rect.x - ink_rect.width);
@@ -1295,6 +1462,12 @@ totally_invisible_line (GtkTextLayout *layout,
 
       else if (seg->type == &gtk_text_toggle_on_type)
         {
+          if (!tag_affects_style (seg->body.toggle.info->tag))
+            {
+              seg = seg->next;
+              continue;
+            }
+
           invalidate_cached_style (layout);
 
           /* Bail out if an elision-unsetting tag begins */
@@ -1304,6 +1477,12 @@ totally_invisible_line (GtkTextLayout *layout,
         }
       else if (seg->type == &gtk_text_toggle_off_type)
         {
+          if (!tag_affects_style (seg->body.toggle.info->tag))
+            {
+              seg = seg->next;
+              continue;
+            }
+
           invalidate_cached_style (layout);
 
           /* Bail out if an elision-setting tag ends */
@@ -2268,24 +2447,25 @@ gtk_text_layout_get_line_display (GtkTextLayout *layout,
   
   g_return_val_if_fail (line != NULL, NULL);
 
-  if (layout->one_display_cache)
+  display = g_hash_table_lookup (layout->display_cache, line);
+  if (display)
     {
-      if (line == layout->one_display_cache->line &&
-          (size_only || !layout->one_display_cache->size_only))
+      if (size_only || !display->size_only)
 	{
 	  if (!size_only)
-            update_text_display_cursors (layout, line, layout->one_display_cache);
-	  return layout->one_display_cache;
+            update_text_display_cursors (layout, line, display);
+          g_queue_unlink (&layout->display_lru, &display->lru_link);
+          g_queue_push_head_link (&layout->display_lru, &display->lru_link);
+	  return display;
 	}
       else
         {
-          GtkTextLineDisplay *tmp_display = layout->one_display_cache;
-          layout->one_display_cache = NULL;
-          gtk_text_layout_free_line_display (layout, tmp_display);
+          display_cache_remove (layout, display);
+          gtk_text_layout_free_line_display (layout, display);
         }
     }
 
-  DV (g_print ("creating one line display cache (%s)\n", G_STRLOC));
+  DV (g_print ("creating line display (%s)\n", G_STRLOC));
 
   display = g_slice_new0 (GtkTextLineDisplay);
 
@@ -2459,6 +2639,15 @@ gtk_text_layout_get_line_display (GtkTextLayout *layout,
         }
 
       /* Toggles */
+      else if ((seg->type == &gtk_text_toggle_on_type ||
+                seg->type == &gtk_text_toggle_off_type) &&
+               !tag_affects_style (seg->body.toggle.info->tag))
+        {
+          /* Doesn't change the style, so keep the cached one. The tag
+           * may stay in or out of @tags, since it has no effect there.
+           */
+        }
+
       else if (seg->type == &gtk_text_toggle_on_type ||
                seg->type == &gtk_text_toggle_off_type)
         {
@@ -2607,7 +2796,12 @@ gtk_text_layout_get_line_display (GtkTextLayout *layout,
   if (tags != NULL)
     g_ptr_array_free (tags, TRUE);
 
-  layout->one_display_cache = display;
+  /* Sizing runs over every line of the buffer when validating, so only
+   * keep full displays. Lines without line data may go away without us
+   * being told, so don't keep those either.
+   */
+  if (!size_only && _gtk_text_line_get_data (line, layout) != NULL)
+    display_cache_insert (layout, display);
 
   if (saw_widget)
     allocate_child_widgets (layout, display);
@@ -2619,7 +2813,7 @@ void
 gtk_text_layout_free_line_display (GtkTextLayout      *layout,
                                    GtkTextLineDisplay *display)
 {
-  if (display != layout->one_display_cache)
+  if (g_hash_table_lookup (layout->display_cache, display->line) != display)
     {
       if (display->layout)
         g_object_unref (display->layout);
@@ -2630,6 +2824,9 @@ gtk_text_layout_free_line_display (GtkTextLayout      *layout,
       if (display->pg_bg_rgba)
         gdk_rgba_free (display->pg_bg_rgba);
 
+      if (display->node)
+        gsk_render_node_unref (display->node);
+
       g_slice_free (GtkTextLineDisplay, display);
     }
 }
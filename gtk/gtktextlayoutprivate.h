@@ -138,10 +138,21 @@ struct _GtkTextLayout
    * over long runs with the same style. */
   GtkTextAttributes *one_style_cache;
 
-  /* A cache of one line display. Getting the same line
-   * many times in a row is the most common case.
+  /* A cache of line displays, keyed by line, with the most recently
+   * used first in display_lru. Redrawing the visible lines is the most
+   * common case, so it holds the lines of the last redraw plus some
+   * overscan; see gtk_text_layout_get_lines().
    */
-  GtkTextLineDisplay *one_display_cache;
+  GHashTable *display_cache;
+  GQueue display_lru;
+  guint display_cache_size;
+
+  /* The colors the cached render nodes of the line displays were
+   * drawn with: text, selection background and selection text.
+   * render_stamp changes whenever they do; see gtktextdisplay.c.
+   */
+  GdkRGBA render_colors[3];
+  guint render_stamp;
 
   /* Whether we are allowed to wrap right now */
   gint wrap_loop_count;
@@ -167,6 +178,9 @@ struct _GtkTextLayout
   gint preedit_cursor;
 
   guint overwrite_mode : 1;
+
+  /* Whether wrapping may guess the size of long lines instead */
+  guint estimate_long_lines : 1;
 };
 
 struct _GtkTextLayoutClass
@@ -247,6 +261,18 @@ struct _GtkTextLineDisplay
   guint size_only : 1;
 
   GdkRGBA *pg_bg_rgba;
+
+  GList lru_link;       /* in layout->display_lru, if cached */
+
+  /* The rendering of the line without the insertion cursors, and
+   * the state it was rendered for.
+   */
+  GskRenderNode *node;
+  gint node_x;
+  gint node_width;
+  gint node_selection_start;
+  gint node_selection_end;
+  guint node_stamp;
 };
 
 #ifdef GTK_COMPILATION
@@ -367,6 +393,9 @@ void     gtk_text_layout_validate_yrange (GtkTextLayout *layout,
 GDK_AVAILABLE_IN_ALL
 void     gtk_text_layout_validate        (GtkTextLayout *layout,
                                           gint           max_pixels);
+GDK_AVAILABLE_IN_ALL
+void     gtk_text_layout_validate_offscreen (GtkTextLayout *layout,
+                                             gint           max_pixels);
 
 /* This function should return the passed-in line data,
  * OR remove the existing line data from the line, and
@@ -144,6 +144,11 @@
 #define SCREEN_HEIGHT(widget) text_window_get_height (GTK_TEXT_VIEW (widget)->priv->text_window)
 
 #define SPACE_FOR_CURSOR 1
+
+/* How long one run of incremental_validate_callback() may take, in µs.
+ * This leaves most of a frame to redrawing.
+ */
+#define INCREMENTAL_VALIDATE_TIME 8000
 #define CURSOR_ASPECT_RATIO (0.04)
 
 typedef struct _GtkTextWindow GtkTextWindow;
@@ -4286,10 +4291,19 @@ incremental_validate_callback (gpointer data)
 {
   GtkTextView *text_view = data;
   gboolean result = TRUE;
+  gint64 start;
 
   DV(g_print(G_STRLOC"\n"));
-  
-  gtk_text_layout_validate (text_view->priv->layout, 2000);
+
+  /* Validate in chunks until the time slice is used up, so large
+   * buffers don't pay for an idle dispatch and an adjustment update
+   * every 2000 pixels.
+   */
+  start = g_get_monotonic_time ();
+  do
+    gtk_text_layout_validate_offscreen (text_view->priv->layout, 2000);
+  while (!gtk_text_layout_is_valid (text_view->priv->layout) &&
+         g_get_monotonic_time () - start < INCREMENTAL_VALIDATE_TIME);
 
   gtk_text_view_update_adjustments (text_view);
   
@@ -8872,7 +8886,7 @@ node_style_changed_cb (GtkCssNode        *node,
 {
   if (gtk_css_style_change_affects (change, GTK_CSS_AFFECTS_SIZE))
     gtk_widget_queue_resize (widget);
-  else
+  else if (gtk_css_style_change_affects (change, GTK_CSS_AFFECTS_REDRAW | GTK_CSS_AFFECTS_TEXT))
     gtk_widget_queue_draw (widget);
 }
 
@@ -53,6 +53,7 @@
 #include "gtkradiotoolbutton.h"
 #include "gtkseparatormenuitem.h"
 #include "gtkseparatortoolitem.h"
+#include "gtkstylecontextprivate.h"
 #include "gtktoolshell.h"
 #include "gtktypebuiltins.h"
 #include "gtkwidgetpath.h"
@@ -1495,10 +1496,13 @@ gtk_toolbar_style_updated (GtkWidget *widget)
 {
   GtkToolbar *toolbar = GTK_TOOLBAR (widget);
   GtkToolbarPrivate *priv = toolbar->priv;
+  GtkCssStyleChange *change;
 
   GTK_WIDGET_CLASS (gtk_toolbar_parent_class)->style_updated (widget);
 
-  priv->max_homogeneous_pixels = -1;
+  change = gtk_style_context_get_change (gtk_widget_get_style_context (widget));
+  if (change == NULL || gtk_css_style_change_affects (change, GTK_CSS_AFFECTS_TEXT_SIZE))
+    priv->max_homogeneous_pixels = -1;
 }
 
 static GList *
@@ -33,13 +33,23 @@
  *
  * #GtkTreeListModel is a #GListModel implementation that can expand rows
  * by creating new child list models on demand.
+ *
+ * When expanding large trees via #GtkTreeListModel:autoexpand, the model
+ * can defer creating the child models, see
+ * gtk_tree_list_model_set_incremental().
  */
 
+/* Maximum time to spend per main loop iteration when expanding rows
+ * incrementally, in microseconds */
+#define EXPAND_TIME_SLICE 2000
+
 enum {
   PROP_0,
   PROP_AUTOEXPAND,
+  PROP_INCREMENTAL,
   PROP_MODEL,
   PROP_PASSTHROUGH,
+  PROP_PENDING,
   NUM_PROPERTIES
 };
 
@@ -58,12 +68,15 @@ struct _TreeNode
 
   guint empty : 1;
   guint is_root : 1;
+  guint autoexpand_pending : 1; /* waiting to be expanded incrementally */
+  guint prioritized : 1; /* in the list of rows to expand first */
 };
 
 struct _TreeAugment
 {
   guint n_items;
   guint n_local;
+  guint n_pending; /* rows waiting to be autoexpanded, including in child trees */
 };
 
 struct _GtkTreeListModel
@@ -78,6 +91,10 @@ struct _GtkTreeListModel
 
   guint autoexpand : 1;
   guint passthrough : 1;
+  guint incremental : 1;
+
+  guint expand_cb; /* idle source of the incremental expansion */
+  GQueue priority_rows; /* rows that were queried while pending */
 };
 
 struct _GtkTreeListModelClass
@@ -99,6 +116,18 @@ struct _GtkTreeListRowClass
 
 static GParamSpec *properties[NUM_PROPERTIES] = { NULL, };
 
+enum {
+  ROW_PROP_0,
+  ROW_PROP_CHILDREN,
+  ROW_PROP_DEPTH,
+  ROW_PROP_EXPANDABLE,
+  ROW_PROP_EXPANDED,
+  ROW_PROP_ITEM,
+  NUM_ROW_PROPERTIES
+};
+
+static GParamSpec *row_properties[NUM_ROW_PROPERTIES] = { NULL, };
+
 static GtkTreeListModel *
 tree_node_get_tree_list_model (TreeNode *node)
 {
@@ -162,6 +191,67 @@ tree_node_get_n_children (TreeNode *node)
   return child_aug->n_items;
 }
 
+static guint
+tree_node_get_n_pending (TreeNode *node)
+{
+  TreeAugment *child_aug;
+  TreeNode *child_node;
+
+  if (node->children == NULL)
+    return 0;
+
+  child_node = gtk_rb_tree_get_root (node->children);
+  if (child_node == NULL)
+    return 0;
+
+  child_aug = gtk_rb_tree_get_augment (node->children, child_node);
+
+  return child_aug->n_pending;
+}
+
+/* Finds the first row below @node in tree order that is waiting to be
+ * autoexpanded */
+static TreeNode *
+tree_node_find_pending (TreeNode *node)
+{
+  GtkRbTree *tree;
+  TreeNode *child, *tmp;
+
+  if (tree_node_get_n_pending (node) == 0)
+    return NULL;
+
+  tree = node->children;
+  child = gtk_rb_tree_get_root (tree);
+
+  while (child)
+    {
+      tmp = gtk_rb_tree_node_get_left (child);
+      if (tmp)
+        {
+          TreeAugment *aug = gtk_rb_tree_get_augment (tree, tmp);
+          if (aug->n_pending > 0)
+            {
+              child = tmp;
+              continue;
+            }
+        }
+
+      if (child->autoexpand_pending)
+        return child;
+
+      if (tree_node_get_n_pending (child) > 0)
+        {
+          tree = child->children;
+          child = gtk_rb_tree_get_root (tree);
+          continue;
+        }
+
+      child = gtk_rb_tree_node_get_right (child);
+    }
+
+  g_return_val_if_reached (NULL);
+}
+
 static guint
 tree_node_get_local_position (GtkRbTree *tree,
                               TreeNode  *node)
@@ -362,6 +452,9 @@ tree_node_get_row (TreeNode *node)
 static guint
 gtk_tree_list_model_expand_node (GtkTreeListModel *self,
                                  TreeNode         *node);
+static guint
+gtk_tree_list_model_autoexpand_node (GtkTreeListModel *self,
+                                     TreeNode         *node);
 
 static void
 gtk_tree_list_model_items_changed_cb (GListModel *model,
@@ -371,7 +464,7 @@ gtk_tree_list_model_items_changed_cb (GListModel *model,
                                       TreeNode   *node)
 {
   GtkTreeListModel *self;
-  TreeNode *child;
+  TreeNode *child, *tmp;
   guint i, tree_position, tree_removed, tree_added, n_local;
 
   self = tree_node_get_tree_list_model (node);
@@ -390,8 +483,6 @@ gtk_tree_list_model_items_changed_cb (GListModel *model,
 
   if (removed)
     {
-      TreeNode *tmp;
-
       g_assert (child != NULL);
       if (position + removed < n_local)
         {
@@ -403,12 +494,10 @@ gtk_tree_list_model_items_changed_cb (GListModel *model,
           tree_removed = tree_node_get_position (node) + tree_node_get_n_children (node) + 1 - tree_position;
         }
 
+      tmp = child;
       for (i = 0; i < removed; i++)
-        {
-          tmp = child;
-          child = gtk_rb_tree_node_get_next (child);
-          gtk_rb_tree_remove (node->children, tmp);
-        }
+        child = gtk_rb_tree_node_get_next (child);
+      gtk_rb_tree_remove_many (node->children, tmp, removed);
     }
   else
     {
@@ -416,16 +505,19 @@ gtk_tree_list_model_items_changed_cb (GListModel *model,
     }
 
   tree_added = added;
-  for (i = 0; i < added; i++)
+  if (added)
     {
-      child = gtk_rb_tree_insert_before (node->children, child);
-      child->parent = node;
+      TreeNode *last = child;
+
+      child = gtk_rb_tree_insert_many_before (node->children, last, added);
+      for (tmp = child; tmp != last; tmp = gtk_rb_tree_node_get_next (tmp))
+        tmp->parent = node;
     }
   if (self->autoexpand)
     {
       for (i = 0; i < added; i++)
         {
-          tree_added += gtk_tree_list_model_expand_node (self, child);
+          tree_added += gtk_tree_list_model_autoexpand_node (self, child);
           child = gtk_rb_tree_node_get_next (child);
         }
     }
@@ -471,18 +563,22 @@ gtk_tree_list_model_augment (GtkRbTree *tree,
   aug->n_items = 1;
   aug->n_items += tree_node_get_n_children (_node);
   aug->n_local = 1;
+  aug->n_pending = ((TreeNode *) _node)->autoexpand_pending;
+  aug->n_pending += tree_node_get_n_pending (_node);
 
   if (left)
     {
       TreeAugment *left_aug = gtk_rb_tree_get_augment (tree, left);
       aug->n_items += left_aug->n_items;
       aug->n_local += left_aug->n_local;
+      aug->n_pending += left_aug->n_pending;
     }
   if (right)
     {
       TreeAugment *right_aug = gtk_rb_tree_get_augment (tree, right);
       aug->n_items += right_aug->n_items;
       aug->n_local += right_aug->n_local;
+      aug->n_pending += right_aug->n_pending;
     }
 }
 
@@ -506,13 +602,13 @@ gtk_tree_list_model_init_node (GtkTreeListModel *list,
                                     NULL);
 
   n = g_list_model_get_n_items (model);
-  node = NULL;
+  node = gtk_rb_tree_insert_many_before (self->children, NULL, n);
   for (i = 0; i < n; i++)
     {
-      node = gtk_rb_tree_insert_after (self->children, node);
       node->parent = self;
       if (list->autoexpand)
-        gtk_tree_list_model_expand_node (list, node);
+        gtk_tree_list_model_autoexpand_node (list, node);
+      node = gtk_rb_tree_node_get_next (node);
     }
 }
 
@@ -550,6 +646,165 @@ gtk_tree_list_model_expand_node (GtkTreeListModel *self,
   return tree_node_get_n_children (node);
 }
 
+static void
+gtk_tree_list_model_expand_pending_node (GtkTreeListModel *self,
+                                         TreeNode         *node)
+{
+  guint n_items;
+
+  node->autoexpand_pending = FALSE;
+  tree_node_mark_dirty (node);
+
+  n_items = gtk_tree_list_model_expand_node (self, node);
+  if (n_items > 0)
+    g_list_model_items_changed (G_LIST_MODEL (self), tree_node_get_position (node) + 1, 0, n_items);
+
+  if (node->row && node->children)
+    {
+      g_object_notify_by_pspec (G_OBJECT (node->row), row_properties[ROW_PROP_EXPANDED]);
+      g_object_notify_by_pspec (G_OBJECT (node->row), row_properties[ROW_PROP_CHILDREN]);
+    }
+}
+
+static TreeNode *
+gtk_tree_list_model_next_pending_node (GtkTreeListModel *self)
+{
+  GtkTreeListRow *row;
+
+  while ((row = g_queue_pop_head (&self->priority_rows)))
+    {
+      TreeNode *node = row->node;
+
+      g_object_unref (row);
+      if (node == NULL)
+        continue;
+
+      node->prioritized = FALSE;
+      if (node->autoexpand_pending)
+        return node;
+    }
+
+  return tree_node_find_pending (&self->root_node);
+}
+
+static void
+gtk_tree_list_model_stop_expanding (GtkTreeListModel *self)
+{
+  GtkTreeListRow *row;
+
+  while ((row = g_queue_pop_head (&self->priority_rows)))
+    {
+      if (row->node)
+        row->node->prioritized = FALSE;
+      g_object_unref (row);
+    }
+
+  if (self->expand_cb == 0)
+    return;
+
+  g_source_remove (self->expand_cb);
+  self->expand_cb = 0;
+}
+
+static gboolean
+gtk_tree_list_model_expand_cb (gpointer data)
+{
+  GtkTreeListModel *self = data;
+  guint expand_cb = self->expand_cb;
+  gint64 end_time;
+  TreeNode *node;
+
+  end_time = g_get_monotonic_time () + EXPAND_TIME_SLICE;
+
+  do
+    {
+      node = gtk_tree_list_model_next_pending_node (self);
+      if (node == NULL)
+        break;
+
+      gtk_tree_list_model_expand_pending_node (self, node);
+
+      /* stopped from an items-changed handler */
+      if (self->expand_cb != expand_cb)
+        return G_SOURCE_REMOVE;
+    }
+  while (g_get_monotonic_time () < end_time);
+
+  g_object_notify_by_pspec (G_OBJECT (self), properties[PROP_PENDING]);
+
+  if (node == NULL)
+    {
+      self->expand_cb = 0;
+      return G_SOURCE_REMOVE;
+    }
+
+  return G_SOURCE_CONTINUE;
+}
+
+/* Expands a row that was added while autoexpand is set. In incremental
+ * mode, the child model is created later from an idle handler instead,
+ * so that expanding a huge tree doesn't block.
+ */
+static guint
+gtk_tree_list_model_autoexpand_node (GtkTreeListModel *self,
+                                     TreeNode         *node)
+{
+  if (!self->incremental)
+    return gtk_tree_list_model_expand_node (self, node);
+
+  if (node->empty || node->model != NULL)
+    return 0;
+
+  node->autoexpand_pending = TRUE;
+  gtk_rb_tree_node_mark_dirty (node);
+
+  if (self->expand_cb == 0)
+    {
+      self->expand_cb = g_idle_add (gtk_tree_list_model_expand_cb, self);
+      g_source_set_name_by_id (self->expand_cb, "[gtk] gtk_tree_list_model_expand_cb");
+    }
+
+  return 0;
+}
+
+/* Rows that are looked at are likely visible, so expand them before the
+ * rest of the tree */
+static void
+gtk_tree_list_model_prioritize_node (GtkTreeListModel *self,
+                                     TreeNode         *node)
+{
+  if (!node->autoexpand_pending || node->prioritized)
+    return;
+
+  node->prioritized = TRUE;
+  g_queue_push_tail (&self->priority_rows, tree_node_get_row (node));
+}
+
+/* Cancels or finishes all pending expansions */
+static void
+gtk_tree_list_model_finish_pending (GtkTreeListModel *self,
+                                    gboolean          expand)
+{
+  TreeNode *node;
+
+  gtk_tree_list_model_stop_expanding (self);
+
+  while ((node = tree_node_find_pending (&self->root_node)))
+    {
+      if (expand)
+        {
+          gtk_tree_list_model_expand_pending_node (self, node);
+        }
+      else
+        {
+          node->autoexpand_pending = FALSE;
+          tree_node_mark_dirty (node);
+        }
+    }
+
+  g_object_notify_by_pspec (G_OBJECT (self), properties[PROP_PENDING]);
+}
+
 static guint
 gtk_tree_list_model_collapse_node (GtkTreeListModel *self,
                                    TreeNode         *node)
@@ -600,6 +855,8 @@ gtk_tree_list_model_get_item (GListModel *list,
   if (node == NULL)
     return NULL;
 
+  gtk_tree_list_model_prioritize_node (self, node);
+
   if (self->passthrough)
     {
       return tree_node_get_item (node);
@@ -635,6 +892,10 @@ gtk_tree_list_model_set_property (GObject      *object,
       gtk_tree_list_model_set_autoexpand (self, g_value_get_boolean (value));
       break;
 
+    case PROP_INCREMENTAL:
+      gtk_tree_list_model_set_incremental (self, g_value_get_boolean (value));
+      break;
+
     case PROP_PASSTHROUGH:
       self->passthrough = g_value_get_boolean (value);
       break;
@@ -659,6 +920,10 @@ gtk_tree_list_model_get_property (GObject     *object,
       g_value_set_boolean (value, self->autoexpand);
       break;
 
+    case PROP_INCREMENTAL:
+      g_value_set_boolean (value, self->incremental);
+      break;
+
     case PROP_MODEL:
       g_value_set_object (value, self->root_node.model);
       break;
@@ -667,6 +932,10 @@ gtk_tree_list_model_get_property (GObject     *object,
       g_value_set_boolean (value, self->passthrough);
       break;
 
+    case PROP_PENDING:
+      g_value_set_uint (value, gtk_tree_list_model_get_pending (self));
+      break;
+
     default:
       G_OBJECT_WARN_INVALID_PROPERTY_ID (object, prop_id, pspec);
       break;
@@ -678,6 +947,7 @@ gtk_tree_list_model_finalize (GObject *object)
 {
   GtkTreeListModel *self = GTK_TREE_LIST_MODEL (object);
 
+  gtk_tree_list_model_stop_expanding (self);
   gtk_tree_list_model_clear_node (&self->root_node);
   if (self->user_destroy)
     self->user_destroy (self->user_data);
@@ -706,6 +976,18 @@ gtk_tree_list_model_class_init (GtkTreeListModelClass *class)
                             FALSE,
                             GTK_PARAM_READWRITE | G_PARAM_EXPLICIT_NOTIFY);
 
+  /**
+   * GtkTreeListModel:incremental:
+   *
+   * If autoexpanded rows should be expanded incrementally
+   */
+  properties[PROP_INCREMENTAL] =
+      g_param_spec_boolean ("incremental",
+                            P_("Incremental"),
+                            P_("Expand rows incrementally"),
+                            FALSE,
+                            GTK_PARAM_READWRITE | G_PARAM_EXPLICIT_NOTIFY);
+
   /**
    * GtkTreeListModel:model:
    *
@@ -732,6 +1014,19 @@ gtk_tree_list_model_class_init (GtkTreeListModelClass *class)
                             FALSE,
                             GTK_PARAM_READWRITE | G_PARAM_CONSTRUCT_ONLY | G_PARAM_EXPLICIT_NOTIFY);
 
+  /**
+   * GtkTreeListModel:pending:
+   *
+   * Number of rows waiting to be expanded, see
+   * gtk_tree_list_model_get_pending()
+   */
+  properties[PROP_PENDING] =
+      g_param_spec_uint ("pending",
+                         P_("Pending"),
+                         P_("Number of rows waiting to be expanded"),
+                         0, G_MAXUINT, 0,
+                         GTK_PARAM_READABLE | G_PARAM_EXPLICIT_NOTIFY);
+
   g_object_class_install_properties (gobject_class, NUM_PROPERTIES, properties);
 }
 
@@ -842,6 +1137,9 @@ gtk_tree_list_model_set_autoexpand (GtkTreeListModel *self,
 
   self->autoexpand = autoexpand;
 
+  if (!autoexpand && self->expand_cb)
+    gtk_tree_list_model_finish_pending (self, FALSE);
+
   g_object_notify_by_pspec (G_OBJECT (self), properties[PROP_AUTOEXPAND]);
 }
 
@@ -863,6 +1161,79 @@ gtk_tree_list_model_get_autoexpand (GtkTreeListModel *self)
   return self->autoexpand;
 }
 
+/**
+ * gtk_tree_list_model_set_incremental:
+ * @self: a #GtkTreeListModel
+ * @incremental: %TRUE to expand rows incrementally
+ *
+ * Sets the model to expand rows incrementally when
+ * #GtkTreeListModel:autoexpand is set.
+ *
+ * Normally, autoexpanding a row immediately creates the models for all
+ * its children, their children and so on, which for large trees can
+ * take a long time and a lot of memory. When incremental expansion is
+ * enabled, rows are instead expanded a few at a time whenever the main
+ * loop is idle. Rows that are queried via g_list_model_get_item() or
+ * gtk_tree_list_model_get_row() while they are waiting get expanded
+ * first, so that the rows that are displayed get expanded quickly.
+ * A #GListModel::items-changed signal is emitted for every expanded row.
+ *
+ * The #GtkTreeListModel:pending property can be used to show progress.
+ *
+ * By default, incremental expansion is disabled.
+ **/
+void
+gtk_tree_list_model_set_incremental (GtkTreeListModel *self,
+                                     gboolean          incremental)
+{
+  g_return_if_fail (GTK_IS_TREE_LIST_MODEL (self));
+
+  if (self->incremental == incremental)
+    return;
+
+  self->incremental = incremental;
+
+  if (!incremental && self->expand_cb)
+    gtk_tree_list_model_finish_pending (self, TRUE);
+
+  g_object_notify_by_pspec (G_OBJECT (self), properties[PROP_INCREMENTAL]);
+}
+
+/**
+ * gtk_tree_list_model_get_incremental:
+ * @self: a #GtkTreeListModel
+ *
+ * Returns whether incremental expansion was enabled via
+ * gtk_tree_list_model_set_incremental().
+ *
+ * Returns: %TRUE if incremental expansion is enabled
+ **/
+gboolean
+gtk_tree_list_model_get_incremental (GtkTreeListModel *self)
+{
+  g_return_val_if_fail (GTK_IS_TREE_LIST_MODEL (self), FALSE);
+
+  return self->incremental;
+}
+
+/**
+ * gtk_tree_list_model_get_pending:
+ * @self: a #GtkTreeListModel
+ *
+ * Returns the number of rows that are waiting to be expanded
+ * incrementally. Expanding those rows may add more pending rows.
+ *
+ * Returns: the number of rows left to expand or 0 if the model
+ *   is not expanding rows
+ **/
+guint
+gtk_tree_list_model_get_pending (GtkTreeListModel *self)
+{
+  g_return_val_if_fail (GTK_IS_TREE_LIST_MODEL (self), 0);
+
+  return tree_node_get_n_pending (&self->root_node);
+}
+
 /**
  * gtk_tree_list_model_get_row:
  * @self: a #GtkTreeListModel
@@ -897,6 +1268,8 @@ gtk_tree_list_model_get_row (GtkTreeListModel *self,
   if (node == NULL)
     return NULL;
 
+  gtk_tree_list_model_prioritize_node (self, node);
+
   return tree_node_get_row (node);
 }
 
@@ -932,18 +1305,6 @@ gtk_tree_list_model_get_child_row (GtkTreeListModel *self,
 
 /***   ROW   ***/
 
-enum {
-  ROW_PROP_0,
-  ROW_PROP_CHILDREN,
-  ROW_PROP_DEPTH,
-  ROW_PROP_EXPANDABLE,
-  ROW_PROP_EXPANDED,
-  ROW_PROP_ITEM,
-  NUM_ROW_PROPERTIES
-};
-
-static GParamSpec *row_properties[NUM_ROW_PROPERTIES] = { NULL, };
-
 G_DEFINE_TYPE (GtkTreeListRow, gtk_tree_list_row, G_TYPE_OBJECT)
 
 static void
@@ -1185,6 +1546,12 @@ gtk_tree_list_row_set_expanded (GtkTreeListRow *self,
   if (self->node == NULL)
     return;
 
+  if (self->node->autoexpand_pending)
+    {
+      self->node->autoexpand_pending = FALSE;
+      tree_node_mark_dirty (self->node);
+    }
+
   was_expanded = self->node->children != NULL;
   if (was_expanded == expanded)
     return;
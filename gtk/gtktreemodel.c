@@ -240,6 +240,14 @@
     }G_STMT_END
 
 #define ROW_REF_DATA_STRING "gtk-tree-row-refs"
+#define ROWS_INSERTED_DATA_STRING "gtk-tree-rows-inserted-handlers"
+
+typedef struct
+{
+  gulong row_inserted_id;
+  GtkTreeModelRowsInsertedFunc func;
+  gpointer data;
+} RowsInsertedHandler;
 
 enum {
   ROW_CHANGED,
@@ -1845,6 +1853,159 @@ gtk_tree_model_row_inserted (GtkTreeModel *tree_model,
   g_signal_emit (tree_model, tree_model_signals[ROW_INSERTED], 0, path, iter);
 }
 
+/*
+ * _gtk_tree_model_add_rows_inserted_handler:
+ * @tree_model: a #GtkTreeModel
+ * @row_inserted_id: the id of the #GtkTreeModel::row-inserted handler
+ *     that @func stands in for
+ * @func: function to call for a block of rows inserted at once
+ * @data: data for @func
+ *
+ * Lets the handler @row_inserted_id learn about rows that are inserted
+ * with _gtk_tree_model_rows_inserted() all at once instead of one by
+ * one. The handler must stay connected while @func is registered.
+ */
+void
+_gtk_tree_model_add_rows_inserted_handler (GtkTreeModel                 *tree_model,
+                                           gulong                        row_inserted_id,
+                                           GtkTreeModelRowsInsertedFunc  func,
+                                           gpointer                      data)
+{
+  RowsInsertedHandler handler = { row_inserted_id, func, data };
+  GArray *handlers;
+
+  handlers = g_object_get_data (G_OBJECT (tree_model), ROWS_INSERTED_DATA_STRING);
+  if (handlers == NULL)
+    {
+      handlers = g_array_new (FALSE, FALSE, sizeof (RowsInsertedHandler));
+      g_object_set_data_full (G_OBJECT (tree_model),
+                              I_(ROWS_INSERTED_DATA_STRING),
+                              handlers, (GDestroyNotify) g_array_unref);
+    }
+
+  g_array_append_val (handlers, handler);
+}
+
+void
+_gtk_tree_model_remove_rows_inserted_handler (GtkTreeModel *tree_model,
+                                              gpointer      data)
+{
+  GArray *handlers;
+  guint i;
+
+  handlers = g_object_get_data (G_OBJECT (tree_model), ROWS_INSERTED_DATA_STRING);
+  if (handlers == NULL)
+    return;
+
+  for (i = 0; i < handlers->len; i++)
+    {
+      if (g_array_index (handlers, RowsInsertedHandler, i).data == data)
+        {
+          g_array_remove_index (handlers, i);
+          return;
+        }
+    }
+}
+
+/*
+ * _gtk_tree_model_can_insert_rows_at_once:
+ * @tree_model: a #GtkTreeModel
+ *
+ * Checks whether every #GtkTreeModel::row-inserted handler of
+ * @tree_model has registered a function with
+ * _gtk_tree_model_add_rows_inserted_handler(). Only then can a block
+ * of rows be announced with _gtk_tree_model_rows_inserted(), all other
+ * handlers expect one signal per row and the model to contain only the
+ * rows they were told about.
+ *
+ * Returns: %TRUE if _gtk_tree_model_rows_inserted() can be used
+ */
+gboolean
+_gtk_tree_model_can_insert_rows_at_once (GtkTreeModel *tree_model)
+{
+  GArray *handlers;
+  gboolean pending;
+  guint i;
+
+  /* The default handler runs for every row */
+  if (GTK_TREE_MODEL_GET_IFACE (tree_model)->row_inserted)
+    return FALSE;
+
+  handlers = g_object_get_data (G_OBJECT (tree_model), ROWS_INSERTED_DATA_STRING);
+  if (handlers)
+    {
+      for (i = 0; i < handlers->len; i++)
+        g_signal_handler_block (tree_model, g_array_index (handlers, RowsInsertedHandler, i).row_inserted_id);
+    }
+
+  pending = g_signal_has_handler_pending (tree_model, tree_model_signals[ROW_INSERTED], 0, FALSE);
+
+  if (handlers)
+    {
+      for (i = 0; i < handlers->len; i++)
+        g_signal_handler_unblock (tree_model, g_array_index (handlers, RowsInsertedHandler, i).row_inserted_id);
+    }
+
+  return !pending;
+}
+
+/*
+ * _gtk_tree_model_rows_inserted:
+ * @tree_model: a #GtkTreeModel
+ * @path: the path of the first new row
+ * @iter: the first new row
+ * @n_rows: the number of new rows, they are siblings following @iter
+ *
+ * Announces @n_rows rows that were inserted at once, in place of one
+ * #GtkTreeModel::row-inserted signal per row. This may only be used if
+ * _gtk_tree_model_can_insert_rows_at_once() returned %TRUE before the
+ * rows were inserted.
+ */
+void
+_gtk_tree_model_rows_inserted (GtkTreeModel *tree_model,
+                               GtkTreePath  *path,
+                               GtkTreeIter  *iter,
+                               gint          n_rows)
+{
+  RowRefList *refs;
+  GArray *handlers;
+  guint i;
+
+  g_return_if_fail (GTK_IS_TREE_MODEL (tree_model));
+  g_return_if_fail (path != NULL);
+  g_return_if_fail (iter != NULL);
+  g_return_if_fail (n_rows > 0);
+
+  /* Row references are updated first, like in row_inserted_marshal() */
+  refs = g_object_get_data (G_OBJECT (tree_model), ROW_REF_DATA_STRING);
+  if (refs)
+    {
+      GtkTreePath *row_path = gtk_tree_path_copy (path);
+      GtkTreeIter row_iter = *iter;
+      gint n;
+
+      for (n = 0; n < n_rows; n++)
+        {
+          gtk_tree_row_ref_inserted (refs, row_path, &row_iter);
+          gtk_tree_path_next (row_path);
+          gtk_tree_model_iter_next (tree_model, &row_iter);
+        }
+
+      gtk_tree_path_free (row_path);
+    }
+
+  handlers = g_object_get_data (G_OBJECT (tree_model), ROWS_INSERTED_DATA_STRING);
+  if (handlers == NULL)
+    return;
+
+  for (i = 0; i < handlers->len; i++)
+    {
+      RowsInsertedHandler *handler = &g_array_index (handlers, RowsInsertedHandler, i);
+
+      handler->func (tree_model, path, iter, n_rows, handler->data);
+    }
+}
+
 /**
  * gtk_tree_model_row_has_child_toggled:
  * @tree_model: a #GtkTreeModel
@@ -245,6 +245,9 @@ struct _SortData
   GtkTreePath *parent_path;
   gint *parent_path_indices;
   gint parent_path_depth;
+
+  /* child iters indexed by offset, if fetched in advance */
+  GtkTreeIter *iters;
 };
 
 /* Properties */
@@ -658,6 +661,7 @@ fill_sort_data (SortData         *data,
   GtkTreeModelSortPrivate *priv = tree_model_sort->priv;
 
   data->tree_model_sort = tree_model_sort;
+  data->iters = NULL;
 
   if (priv->sort_column_id != GTK_TREE_SORTABLE_DEFAULT_SORT_COLUMN_ID)
     {
@@ -1831,6 +1835,11 @@ gtk_tree_model_sort_compare_func (gconstpointer a,
       iter_a = sa->iter;
       iter_b = sb->iter;
     }
+  else if (data->iters)
+    {
+      iter_a = data->iters[sa->offset];
+      iter_b = data->iters[sb->offset];
+    }
   else
     {
       data->parent_path_indices [data->parent_path_depth-1] = sa->offset;
@@ -1884,6 +1893,472 @@ gtk_tree_model_sort_offset_compare_func (gconstpointer a,
   return retval;
 }
 
+/* Sorting a level with the default sort function of a column fetches
+ * every value once into an array of keys and sorts that, instead of
+ * getting two values from the child model for every comparison.
+ *
+ * The keys don't refer to the child model anymore, so large levels
+ * are sorted in parallel: runs of SORT_KEYS_PER_WORKER keys are sorted
+ * on a thread pool and then merged pairwise, one round at a time.
+ */
+#define SORT_KEYS_PER_WORKER 4096
+
+typedef enum {
+  SORT_KEY_INT,
+  SORT_KEY_UINT,
+  SORT_KEY_DOUBLE,
+  SORT_KEY_STRING
+} SortKeyType;
+
+typedef struct
+{
+  SortElt *elt;
+  union {
+    gint64 v_int;
+    guint64 v_uint;
+    gdouble v_double;
+    gchar *v_string; /* the string until turned into a collation key */
+  } data;
+} SortKey;
+
+typedef struct
+{
+  SortKey *keys;
+  SortKey *tmp;
+  guint n_keys;
+  SortKeyType type;
+  gboolean descending;
+
+  /* The current round: sorting runs if run_length is 0, merging
+   * pairs of runs of run_length keys from keys into tmp otherwise
+   */
+  guint run_length;
+  int n_tasks;
+  int next;
+
+  int n_workers;
+  GMutex mutex;
+  GCond cond;
+} SortKeysJob;
+
+static inline gint
+sort_key_compare (const SortKey *a,
+                  const SortKey *b,
+                  SortKeyType    type)
+{
+  switch (type)
+    {
+    case SORT_KEY_INT:
+      return (a->data.v_int > b->data.v_int) - (a->data.v_int < b->data.v_int);
+    case SORT_KEY_UINT:
+      return (a->data.v_uint > b->data.v_uint) - (a->data.v_uint < b->data.v_uint);
+    case SORT_KEY_DOUBLE:
+      /* same result as _gtk_tree_data_list_compare_func() */
+      if (a->data.v_double < b->data.v_double)
+        return -1;
+      else if (a->data.v_double == b->data.v_double)
+        return 0;
+      else
+        return 1;
+    case SORT_KEY_STRING:
+      return strcmp (a->data.v_string, b->data.v_string);
+    default:
+      g_assert_not_reached ();
+      return 0;
+    }
+}
+
+static gint
+sort_key_qsort_func (gconstpointer a,
+                     gconstpointer b,
+                     gpointer      user_data)
+{
+  SortKeysJob *job = user_data;
+  gint retval;
+
+  retval = sort_key_compare (a, b, job->type);
+
+  return job->descending ? -retval : retval;
+}
+
+static void
+sort_keys_job_sort_run (SortKeysJob *job,
+                        guint        start)
+{
+  guint i, end;
+
+  end = MIN (start + SORT_KEYS_PER_WORKER, job->n_keys);
+
+  if (job->type == SORT_KEY_STRING)
+    {
+      for (i = start; i < end; i++)
+        {
+          gchar *str = job->keys[i].data.v_string;
+
+          job->keys[i].data.v_string = g_utf8_collate_key (str ? str : "", -1);
+          g_free (str);
+        }
+    }
+
+  g_qsort_with_data (job->keys + start, end - start, sizeof (SortKey), sort_key_qsort_func, job);
+}
+
+static void
+sort_keys_job_merge_runs (SortKeysJob *job,
+                          guint        start)
+{
+  SortKey *out = job->tmp + start;
+  guint a, a_end, b, b_end;
+
+  a = start;
+  a_end = MIN (start + job->run_length, job->n_keys);
+  b = a_end;
+  b_end = MIN (a_end + job->run_length, job->n_keys);
+
+  /* Taking from the first run on ties keeps the sort stable */
+  while (a < a_end && b < b_end)
+    {
+      if (sort_key_qsort_func (&job->keys[b], &job->keys[a], job) < 0)
+        *out++ = job->keys[b++];
+      else
+        *out++ = job->keys[a++];
+    }
+
+  memcpy (out, job->keys + a, (a_end - a) * sizeof (SortKey));
+  out += a_end - a;
+  memcpy (out, job->keys + b, (b_end - b) * sizeof (SortKey));
+}
+
+/* Only touches the keys, so this can run on any thread */
+static void
+sort_keys_job_run (SortKeysJob *job)
+{
+  int task;
+
+  while ((task = g_atomic_int_add (&job->next, 1)) < job->n_tasks)
+    {
+      if (job->run_length == 0)
+        sort_keys_job_sort_run (job, task * SORT_KEYS_PER_WORKER);
+      else
+        sort_keys_job_merge_runs (job, task * 2 * job->run_length);
+    }
+}
+
+static void
+sort_keys_job_worker (gpointer data,
+                      gpointer user_data)
+{
+  SortKeysJob *job = data;
+
+  sort_keys_job_run (job);
+
+  g_mutex_lock (&job->mutex);
+  job->n_workers--;
+  if (job->n_workers == 0)
+    g_cond_signal (&job->cond);
+  g_mutex_unlock (&job->mutex);
+}
+
+static void
+sort_keys_job_run_round (SortKeysJob *job,
+                         GThreadPool *pool,
+                         int          max_workers)
+{
+  int w;
+
+  job->next = 0;
+  job->n_workers = pool ? MIN (max_workers, job->n_tasks - 1) : 0;
+
+  if (job->n_workers <= 0)
+    {
+      sort_keys_job_run (job);
+      return;
+    }
+
+  for (w = 0; w < job->n_workers; w++)
+    g_thread_pool_push (pool, job, NULL);
+
+  /* Help out instead of waiting */
+  sort_keys_job_run (job);
+
+  g_mutex_lock (&job->mutex);
+  while (job->n_workers > 0)
+    g_cond_wait (&job->cond, &job->mutex);
+  g_mutex_unlock (&job->mutex);
+}
+
+/* Sorts @keys stably. String keys are replaced by their collation keys. */
+static void
+sort_keys (SortKey     *keys,
+           guint        n_keys,
+           SortKeyType  type,
+           gboolean     descending)
+{
+  static GThreadPool *pool = NULL;
+  static int max_workers = 0;
+  SortKeysJob job;
+  SortKey *swap;
+
+  job.keys = keys;
+  job.tmp = NULL;
+  job.n_keys = n_keys;
+  job.type = type;
+  job.descending = descending;
+  job.run_length = 0;
+  job.n_tasks = (n_keys + SORT_KEYS_PER_WORKER - 1) / SORT_KEYS_PER_WORKER;
+
+  if (job.n_tasks == 1)
+    {
+      sort_keys_job_run_round (&job, NULL, 0);
+      return;
+    }
+
+  if (max_workers == 0)
+    max_workers = MIN (g_get_num_processors (), 8) - 1;
+
+  if (max_workers > 0 && pool == NULL)
+    {
+      pool = g_thread_pool_new (sort_keys_job_worker, NULL, max_workers, FALSE, NULL);
+      if (pool == NULL)
+        max_workers = -1;
+    }
+
+  g_mutex_init (&job.mutex);
+  g_cond_init (&job.cond);
+
+  sort_keys_job_run_round (&job, pool, max_workers);
+
+  job.tmp = g_new (SortKey, n_keys);
+  for (job.run_length = SORT_KEYS_PER_WORKER;
+       job.run_length < n_keys;
+       job.run_length *= 2)
+    {
+      job.n_tasks = (n_keys + 2 * job.run_length - 1) / (2 * job.run_length);
+      sort_keys_job_run_round (&job, pool, max_workers);
+
+      swap = job.keys;
+      job.keys = job.tmp;
+      job.tmp = swap;
+    }
+
+  if (job.keys != keys)
+    {
+      memcpy (keys, job.keys, n_keys * sizeof (SortKey));
+      g_free (job.keys);
+    }
+  else
+    {
+      g_free (job.tmp);
+    }
+
+  g_mutex_clear (&job.mutex);
+  g_cond_clear (&job.cond);
+}
+
+static gboolean
+get_sort_key_type (GType        type,
+                   SortKeyType *key_type)
+{
+  switch (G_TYPE_FUNDAMENTAL (type))
+    {
+    case G_TYPE_BOOLEAN:
+    case G_TYPE_CHAR:
+    case G_TYPE_INT:
+    case G_TYPE_LONG:
+    case G_TYPE_INT64:
+    case G_TYPE_ENUM:
+      *key_type = SORT_KEY_INT;
+      return TRUE;
+    case G_TYPE_UCHAR:
+    case G_TYPE_UINT:
+    case G_TYPE_ULONG:
+    case G_TYPE_UINT64:
+    case G_TYPE_FLAGS:
+      *key_type = SORT_KEY_UINT;
+      return TRUE;
+    case G_TYPE_FLOAT:
+    case G_TYPE_DOUBLE:
+      *key_type = SORT_KEY_DOUBLE;
+      return TRUE;
+    case G_TYPE_STRING:
+      *key_type = SORT_KEY_STRING;
+      return TRUE;
+    default:
+      return FALSE;
+    }
+}
+
+static void
+get_sort_key (SortKey      *key,
+              const GValue *value)
+{
+  switch (G_TYPE_FUNDAMENTAL (G_VALUE_TYPE (value)))
+    {
+    case G_TYPE_BOOLEAN:
+      key->data.v_int = g_value_get_boolean (value);
+      break;
+    case G_TYPE_CHAR:
+      key->data.v_int = g_value_get_schar (value);
+      break;
+    case G_TYPE_INT:
+      key->data.v_int = g_value_get_int (value);
+      break;
+    case G_TYPE_LONG:
+      key->data.v_int = g_value_get_long (value);
+      break;
+    case G_TYPE_INT64:
+      key->data.v_int = g_value_get_int64 (value);
+      break;
+    case G_TYPE_ENUM:
+      key->data.v_int = g_value_get_enum (value);
+      break;
+    case G_TYPE_UCHAR:
+      key->data.v_uint = g_value_get_uchar (value);
+      break;
+    case G_TYPE_UINT:
+      key->data.v_uint = g_value_get_uint (value);
+      break;
+    case G_TYPE_ULONG:
+      key->data.v_uint = g_value_get_ulong (value);
+      break;
+    case G_TYPE_UINT64:
+      key->data.v_uint = g_value_get_uint64 (value);
+      break;
+    case G_TYPE_FLAGS:
+      key->data.v_uint = g_value_get_flags (value);
+      break;
+    case G_TYPE_FLOAT:
+      key->data.v_double = g_value_get_float (value);
+      break;
+    case G_TYPE_DOUBLE:
+      key->data.v_double = g_value_get_double (value);
+      break;
+    case G_TYPE_STRING:
+      key->data.v_string = g_value_dup_string (value);
+      break;
+    default:
+      g_assert_not_reached ();
+      break;
+    }
+}
+
+/* Returns the child iters of all elements of @level indexed by offset,
+ * or %NULL if the elements cache them already.
+ */
+static GtkTreeIter *
+gtk_tree_model_sort_get_child_iters (GtkTreeModelSort *tree_model_sort,
+                                     SortLevel        *level,
+                                     SortData         *data)
+{
+  GtkTreeModelSortPrivate *priv = tree_model_sort->priv;
+  GtkTreeIter *iters;
+  gint i, n;
+
+  if (GTK_TREE_MODEL_SORT_CACHE_CHILD_ITERS (tree_model_sort))
+    return NULL;
+
+  n = g_sequence_get_length (level->seq);
+  iters = g_new (GtkTreeIter, n);
+
+  data->parent_path_indices [data->parent_path_depth-1] = 0;
+  if (!gtk_tree_model_get_iter (priv->child_model, &iters[0], data->parent_path))
+    {
+      g_free (iters);
+      return NULL;
+    }
+
+  for (i = 1; i < n; i++)
+    {
+      iters[i] = iters[i - 1];
+      if (!gtk_tree_model_iter_next (priv->child_model, &iters[i]))
+        {
+          g_free (iters);
+          return NULL;
+        }
+    }
+
+  return iters;
+}
+
+/* Sorts by comparing keys if the sort function is the default one
+ * of a column that holds simple values.
+ */
+static gboolean
+gtk_tree_model_sort_sort_level_by_keys (GtkTreeModelSort *tree_model_sort,
+                                        SortLevel        *level,
+                                        SortData         *data)
+{
+  GtkTreeModelSortPrivate *priv = tree_model_sort->priv;
+  GSequenceIter *siter, *end_siter;
+  SortKeyType key_type;
+  SortKey *keys;
+  gint i, n;
+
+  if (priv->sort_column_id == GTK_TREE_SORTABLE_DEFAULT_SORT_COLUMN_ID ||
+      data->sort_func != _gtk_tree_data_list_compare_func ||
+      data->sort_data != GINT_TO_POINTER (priv->sort_column_id))
+    return FALSE;
+
+  if (!get_sort_key_type (gtk_tree_model_get_column_type (priv->child_model, priv->sort_column_id),
+                          &key_type))
+    return FALSE;
+
+  n = g_sequence_get_length (level->seq);
+  keys = g_new (SortKey, n);
+
+  i = 0;
+  end_siter = g_sequence_get_end_iter (level->seq);
+  for (siter = g_sequence_get_begin_iter (level->seq);
+       siter != end_siter;
+       siter = g_sequence_iter_next (siter))
+    {
+      SortElt *elt = g_sequence_get (siter);
+      GValue value = G_VALUE_INIT;
+
+      keys[i].elt = elt;
+      gtk_tree_model_get_value (priv->child_model,
+                                data->iters ? &data->iters[elt->offset] : &elt->iter,
+                                priv->sort_column_id, &value);
+      get_sort_key (&keys[i], &value);
+      g_value_unset (&value);
+      i++;
+    }
+
+  sort_keys (keys, n, key_type, priv->order == GTK_SORT_DESCENDING);
+
+  /* Moving every element to the end leaves them in order */
+  for (i = 0; i < n; i++)
+    {
+      g_sequence_move (keys[i].elt->siter, end_siter);
+      if (key_type == SORT_KEY_STRING)
+        g_free (keys[i].data.v_string);
+    }
+
+  g_free (keys);
+
+  return TRUE;
+}
+
+static void
+gtk_tree_model_sort_sort_level_elts (GtkTreeModelSort *tree_model_sort,
+                                     SortLevel        *level,
+                                     SortData         *data)
+{
+  if (g_sequence_get_length (level->seq) < 2)
+    return;
+
+  /* Walking the child level once is a lot cheaper than looking up
+   * two paths for every comparison
+   */
+  data->iters = gtk_tree_model_sort_get_child_iters (tree_model_sort, level, data);
+
+  if ((!GTK_TREE_MODEL_SORT_CACHE_CHILD_ITERS (tree_model_sort) && data->iters == NULL) ||
+      !gtk_tree_model_sort_sort_level_by_keys (tree_model_sort, level, data))
+    g_sequence_sort (level->seq, gtk_tree_model_sort_compare_func, data);
+
+  g_clear_pointer (&data->iters, g_free);
+}
+
 static void
 gtk_tree_model_sort_sort_level (GtkTreeModelSort *tree_model_sort,
 				SortLevel        *level,
@@ -1933,7 +2408,7 @@ gtk_tree_model_sort_sort_level (GtkTreeModelSort *tree_model_sort,
     g_sequence_sort (level->seq, gtk_tree_model_sort_offset_compare_func,
                      &data);
   else
-    g_sequence_sort (level->seq, gtk_tree_model_sort_compare_func, &data);
+    gtk_tree_model_sort_sort_level_elts (tree_model_sort, level, &data);
 
   free_sort_data (&data);
 
@@ -34,7 +34,25 @@ typedef enum
 }
 GtkTreeSelectMode;
 
+typedef void (* GtkTreeModelRowsInsertedFunc) (GtkTreeModel *tree_model,
+                                               GtkTreePath  *path,
+                                               GtkTreeIter  *iter,
+                                               gint          n_rows,
+                                               gpointer      data);
+
 /* functions that shouldn't be exported */
+void         _gtk_tree_model_add_rows_inserted_handler    (GtkTreeModel                 *tree_model,
+                                                           gulong                        row_inserted_id,
+                                                           GtkTreeModelRowsInsertedFunc  func,
+                                                           gpointer                      data);
+void         _gtk_tree_model_remove_rows_inserted_handler (GtkTreeModel                 *tree_model,
+                                                           gpointer                      data);
+gboolean     _gtk_tree_model_can_insert_rows_at_once      (GtkTreeModel                 *tree_model);
+void         _gtk_tree_model_rows_inserted                (GtkTreeModel                 *tree_model,
+                                                           GtkTreePath                  *path,
+                                                           GtkTreeIter                  *iter,
+                                                           gint                          n_rows);
+
 void         _gtk_tree_selection_internal_select_node (GtkTreeSelection  *selection,
 						       GtkTreeRBNode     *node,
 						       GtkTreeRBTree     *tree,
@@ -77,6 +95,7 @@ GtkTreeRBTree *    _gtk_tree_view_get_rbtree          (GtkTreeView
 GtkTreeViewColumn *_gtk_tree_view_get_focus_column    (GtkTreeView                 *tree_view);
 void               _gtk_tree_view_set_focus_column    (GtkTreeView                 *tree_view,
 						       GtkTreeViewColumn           *column);
+void               _gtk_tree_view_queue_draw_row_state (GtkTreeView                *tree_view);
 
 GtkTreeSelection* _gtk_tree_selection_new                (void);
 GtkTreeSelection* _gtk_tree_selection_new_with_tree_view (GtkTreeView      *tree_view);
@@ -26,6 +26,7 @@
 #include "gtkbuilderprivate.h"
 #include "gtkdebug.h"
 #include "gtkintl.h"
+#include "gtktreeprivate.h"
 
 
 /**
@@ -1648,6 +1649,155 @@ gtk_tree_store_insert_with_valuesv (GtkTreeStore *tree_store,
   validate_tree ((GtkTreeStore *)tree_store);
 }
 
+/**
+ * gtk_tree_store_insert_many_with_valuesv:
+ * @tree_store: A #GtkTreeStore
+ * @parent: (allow-none): A valid #GtkTreeIter, or %NULL
+ * @position: position to insert the first new row, or -1 for last
+ * @n_rows: the number of rows to insert
+ * @columns: (array length=n_values): an array of column numbers
+ * @values: (array): an array of @n_rows * @n_values GValues, containing
+ *     the values of the first row, followed by those of the second row
+ *     and so on
+ * @n_values: the length of the @columns array
+ *
+ * Inserts @n_rows children of @parent starting at @position and sets
+ * the values of each row to the corresponding @n_values entries of
+ * @values.
+ *
+ * This has the same effect as calling gtk_tree_store_insert_with_valuesv()
+ * for every row, but it looks up the insertion point and the path of the
+ * first row only, so loading large numbers of children takes linear
+ * instead of quadratic time.
+ *
+ * If @tree_store is not sorted and only views like #GtkTreeView are
+ * connected to it, they are told about all new rows in one step.
+ * Otherwise a #GtkTreeModel::row-inserted signal is emitted for each
+ * row, in order. Handlers of these signals must not modify @tree_store.
+ */
+void
+gtk_tree_store_insert_many_with_valuesv (GtkTreeStore *tree_store,
+                                         GtkTreeIter  *parent,
+                                         gint          position,
+                                         gint          n_rows,
+                                         gint         *columns,
+                                         GValue       *values,
+                                         gint          n_values)
+{
+  GtkTreeStorePrivate *priv = tree_store->priv;
+  GtkTreePath *path;
+  GNode *parent_node;
+  GNode *sibling;
+  GNode *new_node, *prev_node;
+  GtkTreeIter iter, first = { 0, };
+  gboolean changed = FALSE;
+  gboolean maybe_need_sort = FALSE;
+  gboolean had_children, at_once;
+  gint i;
+
+  g_return_if_fail (GTK_IS_TREE_STORE (tree_store));
+  g_return_if_fail (n_rows >= 0);
+  g_return_if_fail (n_values >= 0);
+
+  if (parent)
+    g_return_if_fail (VALID_ITER (parent, tree_store));
+
+  if (n_rows == 0)
+    return;
+
+  if (parent)
+    parent_node = parent->user_data;
+  else
+    parent_node = priv->root;
+
+  priv->columns_dirty = TRUE;
+
+  had_children = parent_node->children != NULL;
+  sibling = position < 0 ? NULL : g_node_nth_child (parent_node, position);
+
+  /* Rows of a sorted store are announced where they end up, one by one */
+  at_once = !GTK_TREE_STORE_IS_SORTED (tree_store) &&
+            _gtk_tree_model_can_insert_rows_at_once (GTK_TREE_MODEL (tree_store));
+
+  prev_node = NULL;
+  path = NULL;
+
+  for (i = 0; i < n_rows; i++)
+    {
+      new_node = g_node_new (NULL);
+
+      /* Only the first row needs to walk the list of children */
+      if (prev_node)
+        g_node_insert_after (parent_node, prev_node, new_node);
+      else
+        g_node_insert_before (parent_node, sibling, new_node);
+      prev_node = new_node;
+
+      iter.stamp = priv->stamp;
+      iter.user_data = new_node;
+
+      gtk_tree_store_set_vector_internal (tree_store, &iter,
+                                          &changed, &maybe_need_sort,
+                                          columns, values + i * n_values, n_values);
+
+      if (at_once)
+        {
+          if (i == 0)
+            first = iter;
+          continue;
+        }
+
+      if (maybe_need_sort && GTK_TREE_STORE_IS_SORTED (tree_store))
+        {
+          GtkTreePath *sorted_path;
+
+          gtk_tree_store_sort_iter_changed (tree_store, &iter, priv->sort_column_id, FALSE);
+
+          sorted_path = gtk_tree_store_get_path (GTK_TREE_MODEL (tree_store), &iter);
+          gtk_tree_model_row_inserted (GTK_TREE_MODEL (tree_store), sorted_path, &iter);
+          gtk_tree_path_free (sorted_path);
+        }
+      else
+        {
+          if (path == NULL)
+            path = gtk_tree_store_get_path (GTK_TREE_MODEL (tree_store), &iter);
+          else
+            gtk_tree_path_next (path);
+
+          gtk_tree_model_row_inserted (GTK_TREE_MODEL (tree_store), path, &iter);
+        }
+
+      if (i == 0 && parent_node != priv->root && !had_children)
+        {
+          GtkTreePath *parent_path;
+
+          parent_path = gtk_tree_store_get_path (GTK_TREE_MODEL (tree_store), parent);
+          gtk_tree_model_row_has_child_toggled (GTK_TREE_MODEL (tree_store), parent_path, parent);
+          gtk_tree_path_free (parent_path);
+        }
+    }
+
+  if (at_once)
+    {
+      path = gtk_tree_store_get_path (GTK_TREE_MODEL (tree_store), &first);
+      _gtk_tree_model_rows_inserted (GTK_TREE_MODEL (tree_store), path, &first, n_rows);
+
+      if (parent_node != priv->root && !had_children)
+        {
+          GtkTreePath *parent_path;
+
+          parent_path = gtk_tree_store_get_path (GTK_TREE_MODEL (tree_store), parent);
+          gtk_tree_model_row_has_child_toggled (GTK_TREE_MODEL (tree_store), parent_path, parent);
+          gtk_tree_path_free (parent_path);
+        }
+    }
+
+  if (path)
+    gtk_tree_path_free (path);
+
+  validate_tree ((GtkTreeStore *)tree_store);
+}
+
 /**
  * gtk_tree_store_prepend:
  * @tree_store: A #GtkTreeStore
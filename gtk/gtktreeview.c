@@ -292,6 +292,20 @@ struct _GtkTreeViewChild
 };
 
 
+/* The nodes of the cells of a row, so rows that didn't change are not
+ * drawn again when only the selection or prelight of other rows did */
+typedef struct _GtkTreeViewRowCache GtkTreeViewRowCache;
+struct _GtkTreeViewRowCache
+{
+  GskRenderNode *node;
+  gint y;               /* where @node was drawn */
+  gint x_offset;
+  gint width;
+  gint height;
+  guint state;          /* see gtk_tree_view_get_row_cache_state() */
+  GtkStateFlags widget_state;
+};
+
 typedef struct _TreeViewDragInfo TreeViewDragInfo;
 struct _TreeViewDragInfo
 {
@@ -455,6 +469,17 @@ struct _GtkTreeViewPrivate
   gpointer row_separator_data;
   GDestroyNotify row_separator_destroy;
 
+  /* Row height estimates */
+  GtkTreeViewRowHeightFunc row_height_func;
+  gpointer row_height_data;
+  GDestroyNotify row_height_destroy;
+  GHashTable *row_height_cache; /* content hash => height */
+  GHashTable *row_cache; /* GtkTreeRBNode => GtkTreeViewRowCache */
+  GArray *row_height_columns;
+  gint64 measured_height_sum;
+  guint n_measured_rows;
+  gint estimated_row_height;
+
   /* Gestures */
   GtkGesture *multipress_gesture;
   GtkGesture *drag_gesture; /* Rubberbanding, row DnD */
@@ -470,6 +495,7 @@ struct _GtkTreeViewPrivate
 
   guint fixed_height_mode : 1;
   guint fixed_height_check : 1;
+  guint estimate_row_heights : 1;
 
   guint activate_on_single_click : 1;
   guint reorderable : 1;
@@ -519,6 +545,9 @@ struct _GtkTreeViewPrivate
   guint draw_keyfocus : 1;
   guint model_setup : 1;
   guint in_column_drag : 1;
+
+  /* only row flags changed since the last snapshot */
+  guint row_cache_usable : 1;
 };
 
 
@@ -563,6 +592,7 @@ enum {
   PROP_ENABLE_TREE_LINES,
   PROP_TOOLTIP_COLUMN,
   PROP_ACTIVATE_ON_SINGLE_CLICK,
+  PROP_ESTIMATE_ROW_HEIGHTS,
   LAST_PROP,
   /* overridden */
   PROP_HADJUSTMENT = LAST_PROP,
@@ -672,6 +702,11 @@ static void gtk_tree_view_row_changed                     (GtkTreeModel    *mode
 							   GtkTreePath     *path,
 							   GtkTreeIter     *iter,
 							   gpointer         data);
+static void gtk_tree_view_rows_inserted                   (GtkTreeModel    *model,
+							   GtkTreePath     *path,
+							   GtkTreeIter     *iter,
+							   gint             n_rows,
+							   gpointer         data);
 static void gtk_tree_view_row_inserted                    (GtkTreeModel    *model,
 							   GtkTreePath     *path,
 							   GtkTreeIter     *iter,
@@ -1179,6 +1214,22 @@ gtk_tree_view_class_init (GtkTreeViewClass *class)
                             FALSE,
                             GTK_PARAM_READWRITE|G_PARAM_EXPLICIT_NOTIFY);
 
+  /**
+   * GtkTreeView:estimate-row-heights:
+   *
+   * Setting the ::estimate-row-heights property to %TRUE makes
+   * #GtkTreeView only measure the rows around the visible area and
+   * use estimated heights for all other rows.
+   * Please see gtk_tree_view_set_estimate_row_heights() for more
+   * information on this option.
+   */
+  tree_view_props[PROP_ESTIMATE_ROW_HEIGHTS] =
+      g_param_spec_boolean ("estimate-row-heights",
+                            P_("Estimate Row Heights"),
+                            P_("Speeds up GtkTreeView by only measuring rows near the visible area"),
+                            FALSE,
+                            GTK_PARAM_READWRITE|G_PARAM_EXPLICIT_NOTIFY);
+
   g_object_class_install_properties (o_class, LAST_PROP, tree_view_props);
 
   /* Signals */
@@ -1676,6 +1727,7 @@ gtk_tree_view_init (GtkTreeView *tree_view)
   priv->fixed_height = -1;
   priv->fixed_height_mode = FALSE;
   priv->fixed_height_check = 0;
+  priv->estimated_row_height = -1;
   priv->selection = _gtk_tree_selection_new_with_tree_view (tree_view);
   priv->enable_search = TRUE;
   priv->search_column = -1;
@@ -1878,6 +1930,9 @@ gtk_tree_view_set_property (GObject         *object,
     case PROP_ACTIVATE_ON_SINGLE_CLICK:
       gtk_tree_view_set_activate_on_single_click (tree_view, g_value_get_boolean (value));
       break;
+    case PROP_ESTIMATE_ROW_HEIGHTS:
+      gtk_tree_view_set_estimate_row_heights (tree_view, g_value_get_boolean (value));
+      break;
     default:
       G_OBJECT_WARN_INVALID_PROPERTY_ID (object, prop_id, pspec);
       break;
@@ -1959,6 +2014,9 @@ gtk_tree_view_get_property (GObject    *object,
     case PROP_ACTIVATE_ON_SINGLE_CLICK:
       g_value_set_boolean (value, tree_view->priv->activate_on_single_click);
       break;
+    case PROP_ESTIMATE_ROW_HEIGHTS:
+      g_value_set_boolean (value, tree_view->priv->estimate_row_heights);
+      break;
     default:
       G_OBJECT_WARN_INVALID_PROPERTY_ID (object, prop_id, pspec);
       break;
@@ -1968,6 +2026,12 @@ gtk_tree_view_get_property (GObject    *object,
 static void
 gtk_tree_view_finalize (GObject *object)
 {
+  GtkTreeView *tree_view = GTK_TREE_VIEW (object);
+
+  g_clear_pointer (&tree_view->priv->row_height_cache, g_hash_table_unref);
+  g_clear_pointer (&tree_view->priv->row_height_columns, g_array_unref);
+  g_clear_pointer (&tree_view->priv->row_cache, g_hash_table_unref);
+
   G_OBJECT_CLASS (gtk_tree_view_parent_class)->finalize (object);
 }
 
@@ -2010,9 +2074,51 @@ gtk_tree_view_buildable_get_internal_child (GtkBuildable      *buildable,
 /* GtkWidget Methods
  */
 
+static void
+gtk_tree_view_row_cache_free (gpointer data)
+{
+  GtkTreeViewRowCache *cache = data;
+
+  gsk_render_node_unref (cache->node);
+  g_slice_free (GtkTreeViewRowCache, cache);
+}
+
+/* Must be called before rows are added, removed or moved, the
+ * cache uses the nodes as keys and draws tree lines from their
+ * siblings. */
+static void
+gtk_tree_view_clear_row_cache (GtkTreeView *tree_view)
+{
+  if (tree_view->priv->row_cache)
+    g_hash_table_remove_all (tree_view->priv->row_cache);
+}
+
+/**
+ * _gtk_tree_view_queue_draw_row_state:
+ * @tree_view: a #GtkTreeView
+ *
+ * Like gtk_widget_queue_draw(), for when only the selected or
+ * prelit state of rows changed. Rows that did not change are then
+ * drawn from their cached nodes.
+ */
+void
+_gtk_tree_view_queue_draw_row_state (GtkTreeView *tree_view)
+{
+  GtkWidget *widget = GTK_WIDGET (tree_view);
+
+  /* If a redraw is already pending, it was queued by someone who
+   * might have changed what the cells show */
+  if (_gtk_widget_get_mapped (widget) &&
+      !_gtk_widget_get_draw_needed (widget))
+    tree_view->priv->row_cache_usable = TRUE;
+
+  gtk_widget_queue_draw (widget);
+}
+
 static void
 gtk_tree_view_free_rbtree (GtkTreeView *tree_view)
 {
+  gtk_tree_view_clear_row_cache (tree_view);
   gtk_tree_rbtree_free (tree_view->priv->tree);
 
   tree_view->priv->tree = NULL;
@@ -2139,6 +2245,13 @@ gtk_tree_view_destroy (GtkWidget *widget)
       tree_view->priv->row_separator_destroy (tree_view->priv->row_separator_data);
       tree_view->priv->row_separator_data = NULL;
     }
+
+  if (tree_view->priv->row_height_destroy && tree_view->priv->row_height_data)
+    {
+      tree_view->priv->row_height_destroy (tree_view->priv->row_height_data);
+      tree_view->priv->row_height_data = NULL;
+    }
+  tree_view->priv->row_height_func = NULL;
   
   gtk_tree_view_set_model (tree_view, NULL);
 
@@ -2553,6 +2666,8 @@ gtk_tree_view_size_allocate (GtkWidget *widget,
   GList *tmp_list;
   double page_size;
 
+  gtk_tree_view_clear_row_cache (tree_view);
+
   /* We size-allocate the columns first because the width of the
    * tree view (used in updating the adjustments below) might change.
    */
@@ -3427,7 +3542,7 @@ do_prelight (GtkTreeView   *tree_view,
 	      else
                 tree_view->priv->arrow_prelit = FALSE;
 
-	      gtk_widget_queue_draw (GTK_WIDGET (tree_view));
+	      _gtk_tree_view_queue_draw_row_state (tree_view);
 	    }
 	}
 
@@ -3446,10 +3561,10 @@ do_prelight (GtkTreeView   *tree_view,
 	{
           tree_view->priv->arrow_prelit = FALSE;
 	  
-	  gtk_widget_queue_draw (GTK_WIDGET (tree_view));
+	  _gtk_tree_view_queue_draw_row_state (tree_view);
 	}
 
-      gtk_widget_queue_draw (GTK_WIDGET (tree_view));
+      _gtk_tree_view_queue_draw_row_state (tree_view);
     }
 
 
@@ -3470,12 +3585,12 @@ do_prelight (GtkTreeView   *tree_view,
     {
       tree_view->priv->arrow_prelit = TRUE;
 
-      gtk_widget_queue_draw (GTK_WIDGET (tree_view));
+      _gtk_tree_view_queue_draw_row_state (tree_view);
     }
 
   GTK_TREE_RBNODE_SET_FLAG (node, GTK_TREE_RBNODE_IS_PRELIT);
 
-  gtk_widget_queue_draw (GTK_WIDGET (tree_view));
+  _gtk_tree_view_queue_draw_row_state (tree_view);
 
   if (tree_view->priv->hover_expand)
     {
@@ -4307,6 +4422,98 @@ gtk_tree_view_snapshot_grid_lines (GtkTreeView *tree_view,
  * KEEP IN SYNC WITH gtk_tree_view_create_row_drag_icon()!
  * FIXME: It’s not...
  */
+enum {
+  ROW_CACHE_EXPANDED     = 1 << 16,
+  ROW_CACHE_ARROW_PRELIT = 1 << 17,
+  ROW_CACHE_TOP_LINE     = 1 << 18,
+  ROW_CACHE_BOTTOM_LINE  = 1 << 19
+};
+
+/* Everything about a row besides its cells and position that
+ * changes how it is drawn, as long as the rows stay the same */
+static guint
+gtk_tree_view_get_row_cache_state (GtkTreeView   *tree_view,
+                                   GtkTreeRBNode *node,
+                                   gboolean       top_line,
+                                   gboolean       bottom_line)
+{
+  guint state;
+
+  state = node->flags & (GTK_TREE_RBNODE_IS_PARENT |
+                         GTK_TREE_RBNODE_IS_SELECTED |
+                         GTK_TREE_RBNODE_IS_PRELIT);
+
+  if (node->children)
+    state |= ROW_CACHE_EXPANDED;
+  if (node == tree_view->priv->prelight_node && tree_view->priv->arrow_prelit)
+    state |= ROW_CACHE_ARROW_PRELIT;
+  if (top_line)
+    state |= ROW_CACHE_TOP_LINE;
+  if (bottom_line)
+    state |= ROW_CACHE_BOTTOM_LINE;
+
+  return state;
+}
+
+static gboolean
+gtk_tree_view_snapshot_cached_row (GtkTreeView   *tree_view,
+                                   GtkSnapshot   *snapshot,
+                                   GtkTreeRBNode *node,
+                                   gint           y,
+                                   gint           x_offset,
+                                   gint           width,
+                                   gint           height,
+                                   guint          state)
+{
+  GtkTreeViewRowCache *cache;
+
+  if (tree_view->priv->row_cache == NULL)
+    return FALSE;
+
+  cache = g_hash_table_lookup (tree_view->priv->row_cache, node);
+  if (cache == NULL ||
+      cache->x_offset != x_offset ||
+      cache->width != width ||
+      cache->height != height ||
+      cache->state != state ||
+      cache->widget_state != gtk_widget_get_state_flags (GTK_WIDGET (tree_view)))
+    return FALSE;
+
+  gtk_snapshot_offset (snapshot, 0, y - cache->y);
+  gtk_snapshot_append_node (snapshot, cache->node);
+  gtk_snapshot_offset (snapshot, 0, cache->y - y);
+
+  return TRUE;
+}
+
+static void
+gtk_tree_view_cache_row (GtkTreeView   *tree_view,
+                         GtkTreeRBNode *node,
+                         GskRenderNode *row_node,
+                         gint           y,
+                         gint           x_offset,
+                         gint           width,
+                         gint           height,
+                         guint          state)
+{
+  GtkTreeViewRowCache *cache;
+
+  if (tree_view->priv->row_cache == NULL)
+    tree_view->priv->row_cache = g_hash_table_new_full (NULL, NULL, NULL,
+                                                        gtk_tree_view_row_cache_free);
+
+  cache = g_slice_new (GtkTreeViewRowCache);
+  cache->node = gsk_render_node_ref (row_node);
+  cache->y = y;
+  cache->x_offset = x_offset;
+  cache->width = width;
+  cache->height = height;
+  cache->state = state;
+  cache->widget_state = gtk_widget_get_state_flags (GTK_WIDGET (tree_view));
+
+  g_hash_table_insert (tree_view->priv->row_cache, node, cache);
+}
+
 static void
 gtk_tree_view_bin_snapshot (GtkWidget   *widget,
 			    GtkSnapshot *snapshot)
@@ -4340,10 +4547,18 @@ gtk_tree_view_bin_snapshot (GtkWidget   *widget,
   gboolean draw_vgrid_lines, draw_hgrid_lines;
   GtkStyleContext *context;
   gboolean parity;
+  GtkSnapshot *row_snapshot;
+  GskRenderNode *row_node;
+  guint row_state;
 
   rtl = (_gtk_widget_get_direction (widget) == GTK_TEXT_DIR_RTL);
   context = gtk_widget_get_style_context (widget);
 
+  /* Cached rows are only valid if nothing but row flags changed */
+  if (!priv->row_cache_usable)
+    gtk_tree_view_clear_row_cache (tree_view);
+  priv->row_cache_usable = FALSE;
+
   if (tree_view->priv->tree == NULL)
     return;
 
@@ -4447,6 +4662,21 @@ gtk_tree_view_bin_snapshot (GtkWidget   *widget,
       if (GTK_TREE_RBNODE_FLAG_SET (node, GTK_TREE_RBNODE_IS_SELECTED))
         flags |= GTK_CELL_RENDERER_SELECTED;
 
+      row_state = gtk_tree_view_get_row_cache_state (tree_view, node,
+                                                     background_area.y >= clip.y,
+                                                     background_area.y + max_height < clip.y + clip.height);
+      has_can_focus_cell = FALSE;
+
+      /* The focus of the cursor row depends on more than the row,
+       * so it is always drawn again */
+      if (node != tree_view->priv->cursor_node &&
+          gtk_tree_view_snapshot_cached_row (tree_view, snapshot, node,
+                                             background_area.y, x_scroll_offset,
+                                             bin_window_width, max_height, row_state))
+        goto row_drawn;
+
+      row_snapshot = gtk_snapshot_new ();
+
       /* we *need* to set cell data on all cells before the call
        * to _has_can_focus_cell, else _has_can_focus_cell() does not
        * return a correct value.
@@ -4570,14 +4800,14 @@ gtk_tree_view_bin_snapshot (GtkWidget   *widget,
             draw_focus = FALSE;
 
 	  /* Draw background */
-          gtk_snapshot_render_background (snapshot, context,
+          gtk_snapshot_render_background (row_snapshot, context,
                                           background_area.x,
                                           background_area.y,
                                           background_area.width,
                                           background_area.height);
 
           /* Draw frame */
-          gtk_snapshot_render_frame (snapshot, context,
+          gtk_snapshot_render_frame (row_snapshot, context,
                                      background_area.x,
                                      background_area.y,
                                      background_area.width,
@@ -4604,7 +4834,7 @@ gtk_tree_view_bin_snapshot (GtkWidget   *widget,
                   gtk_style_context_add_class (context, GTK_STYLE_CLASS_SEPARATOR);
 
                   gtk_style_context_get_color (context, &color);
-                  gtk_snapshot_append_color (snapshot,
+                  gtk_snapshot_append_color (row_snapshot,
                                              &color, 
                                              &GRAPHENE_RECT_INIT(
                                                  cell_area.x,
@@ -4618,7 +4848,7 @@ gtk_tree_view_bin_snapshot (GtkWidget   *widget,
 	      else
                 {
                   gtk_tree_view_column_cell_snapshot (column,
-                                                      snapshot,
+                                                      row_snapshot,
                                                       &background_area,
                                                       &cell_area,
                                                       flags,
@@ -4629,7 +4859,7 @@ gtk_tree_view_bin_snapshot (GtkWidget   *widget,
 		  && (node->flags & GTK_TREE_RBNODE_IS_PARENT) == GTK_TREE_RBNODE_IS_PARENT)
 		{
 		  gtk_tree_view_snapshot_arrow (GTK_TREE_VIEW (widget),
-                                                snapshot,
+                                                row_snapshot,
                                                 tree,
                                                 node);
 		}
@@ -4644,7 +4874,7 @@ gtk_tree_view_bin_snapshot (GtkWidget   *widget,
                   gtk_style_context_add_class (context, GTK_STYLE_CLASS_SEPARATOR);
 
                   gtk_style_context_get_color (context, &color);
-                  gtk_snapshot_append_color (snapshot,
+                  gtk_snapshot_append_color (row_snapshot,
                                              &color, 
                                              &GRAPHENE_RECT_INIT(
                                                  cell_area.x,
@@ -4657,7 +4887,7 @@ gtk_tree_view_bin_snapshot (GtkWidget   *widget,
                 }
 	      else
 		gtk_tree_view_column_cell_snapshot (column,
-                                                    snapshot,
+                                                    row_snapshot,
                                                     &background_area,
                                                     &cell_area,
                                                     flags,
@@ -4667,14 +4897,14 @@ gtk_tree_view_bin_snapshot (GtkWidget   *widget,
 	  if (draw_hgrid_lines)
 	    {
 	      if (background_area.y >= clip.y)
-                gtk_tree_view_snapshot_line (tree_view, snapshot,
+                gtk_tree_view_snapshot_line (tree_view, row_snapshot,
                                              GTK_TREE_VIEW_GRID_LINE,
                                              background_area.x, background_area.y,
                                              background_area.x + background_area.width,
                                              background_area.y);
 
 	      if (background_area.y + max_height < clip.y + clip.height)
-                gtk_tree_view_snapshot_line (tree_view, snapshot,
+                gtk_tree_view_snapshot_line (tree_view, row_snapshot,
                                              GTK_TREE_VIEW_GRID_LINE,
                                              background_area.x, background_area.y + max_height,
                                              background_area.x + background_area.width,
@@ -4696,7 +4926,7 @@ gtk_tree_view_bin_snapshot (GtkWidget   *widget,
 	      if ((node->flags & GTK_TREE_RBNODE_IS_PARENT) == GTK_TREE_RBNODE_IS_PARENT
 		  && depth > 1)
 	        {
-                  gtk_tree_view_snapshot_line (tree_view, snapshot,
+                  gtk_tree_view_snapshot_line (tree_view, row_snapshot,
                                                GTK_TREE_VIEW_TREE_LINE,
                                                x + expander_size * (depth - 1.5) * mult,
                                                y1,
@@ -4705,7 +4935,7 @@ gtk_tree_view_bin_snapshot (GtkWidget   *widget,
 	        }
 	      else if (depth > 1)
 	        {
-                  gtk_tree_view_snapshot_line (tree_view, snapshot,
+                  gtk_tree_view_snapshot_line (tree_view, row_snapshot,
                                                GTK_TREE_VIEW_TREE_LINE,
                                                x + expander_size * (depth - 1.5) * mult,
                                                y1,
@@ -4720,14 +4950,14 @@ gtk_tree_view_bin_snapshot (GtkWidget   *widget,
 		  GtkTreeRBTree *tmp_tree;
 
 	          if (!gtk_tree_rbtree_next (tree, node))
-                    gtk_tree_view_snapshot_line (tree_view, snapshot,
+                    gtk_tree_view_snapshot_line (tree_view, row_snapshot,
                                                  GTK_TREE_VIEW_TREE_LINE,
                                                  x + expander_size * (depth - 1.5) * mult,
                                                  y0,
                                                  x + expander_size * (depth - 1.5) * mult,
                                                  y1);
 		  else
-                    gtk_tree_view_snapshot_line (tree_view, snapshot,
+                    gtk_tree_view_snapshot_line (tree_view, row_snapshot,
                                                  GTK_TREE_VIEW_TREE_LINE,
                                                  x + expander_size * (depth - 1.5) * mult,
                                                  y0,
@@ -4740,7 +4970,7 @@ gtk_tree_view_bin_snapshot (GtkWidget   *widget,
 		  for (i = depth - 2; i > 0; i--)
 		    {
 	              if (gtk_tree_rbtree_next (tmp_tree, tmp_node))
-                        gtk_tree_view_snapshot_line (tree_view, snapshot,
+                        gtk_tree_view_snapshot_line (tree_view, row_snapshot,
                                                      GTK_TREE_VIEW_TREE_LINE,
                                                      x + expander_size * (i - 0.5) * mult,
                                                      y0,
@@ -4757,6 +4987,26 @@ gtk_tree_view_bin_snapshot (GtkWidget   *widget,
 	  cell_offset += gtk_tree_view_column_get_width (column);
 	}
 
+      row_node = gtk_snapshot_free_to_node (row_snapshot);
+      if (node == tree_view->priv->cursor_node)
+        {
+          if (tree_view->priv->row_cache)
+            g_hash_table_remove (tree_view->priv->row_cache, node);
+        }
+      else if (row_node)
+        {
+          gtk_tree_view_cache_row (tree_view, node, row_node,
+                                   background_area.y, x_scroll_offset,
+                                   bin_window_width, max_height, row_state);
+        }
+
+      if (row_node)
+        {
+          gtk_snapshot_append_node (snapshot, row_node);
+          gsk_render_node_unref (row_node);
+        }
+
+row_drawn:
       if (node == drag_highlight)
         {
           /* Draw indicator for the drop
@@ -5527,6 +5777,158 @@ get_separator_height (GtkTreeView *tree_view)
   return min_size;
 }
 
+/* Row height estimates
+ *
+ * With estimate-row-heights, rows that have not been measured yet get
+ * the height returned by the row height function, the average height
+ * of all rows measured so far or, before any row was measured, the
+ * height the columns request without cell data.
+ *
+ * Rows whose cells show the same values as an already measured row
+ * get its height from a cache, without measuring them again.
+ */
+#define ROW_HEIGHT_CACHE_SIZE 4096
+
+static void
+gtk_tree_view_reset_row_height_estimates (GtkTreeView *tree_view)
+{
+  GtkTreeViewPrivate *priv = tree_view->priv;
+
+  priv->measured_height_sum = 0;
+  priv->n_measured_rows = 0;
+  priv->estimated_row_height = -1;
+
+  if (priv->row_height_cache)
+    g_hash_table_remove_all (priv->row_height_cache);
+}
+
+static gint
+gtk_tree_view_get_estimated_row_height (GtkTreeView *tree_view,
+                                        GtkTreeIter *iter)
+{
+  GtkTreeViewPrivate *priv = tree_view->priv;
+  GList *list;
+
+  if (priv->row_height_func && iter)
+    {
+      gint height = priv->row_height_func (priv->model, iter, priv->row_height_data);
+
+      if (height >= 0)
+        return height;
+    }
+
+  if (priv->n_measured_rows > 0)
+    return priv->measured_height_sum / priv->n_measured_rows;
+
+  if (priv->estimated_row_height < 0)
+    {
+      gint height = gtk_tree_view_get_expander_size (tree_view);
+
+      for (list = priv->columns; list; list = list->next)
+        {
+          GtkTreeViewColumn *column = list->data;
+          gint row_height;
+
+          if (!gtk_tree_view_column_get_visible (column))
+            continue;
+
+          gtk_tree_view_column_cell_get_size (column, NULL, NULL, NULL, NULL, &row_height);
+          height = MAX (height, row_height);
+        }
+
+      priv->estimated_row_height = height;
+    }
+
+  return priv->estimated_row_height;
+}
+
+static inline guint64
+hash_bytes (guint64       hash,
+            gconstpointer data,
+            gsize         len)
+{
+  const guchar *p = data;
+  gsize i;
+
+  /* FNV-1a */
+  for (i = 0; i < len; i++)
+    hash = (hash ^ p[i]) * G_GUINT64_CONSTANT (1099511628211);
+
+  return hash;
+}
+
+static guint64
+hash_value (guint64       hash,
+            const GValue *value)
+{
+  if (G_VALUE_HOLDS_STRING (value))
+    {
+      const gchar *str = g_value_get_string (value);
+
+      if (str)
+        return hash_bytes (hash, str, strlen (str) + 1);
+    }
+
+  /* Values start out zeroed, so the unused parts of the data don't
+   * matter. Objects and boxed types are compared by identity.
+   */
+  return hash_bytes (hash, &value->data[0], sizeof (value->data[0]));
+}
+
+/* Hashes everything that goes into the height of the row.
+ * Returns FALSE if that isn't known.
+ */
+static gboolean
+gtk_tree_view_get_row_content_hash (GtkTreeView   *tree_view,
+                                    GtkTreeIter   *iter,
+                                    GtkTreeRBNode *node,
+                                    gint           depth,
+                                    gboolean       is_separator,
+                                    guint64       *result)
+{
+  GtkTreeViewPrivate *priv = tree_view->priv;
+  GArray *columns;
+  GList *list;
+  guint64 hash;
+  guint flags, i;
+
+  if (priv->row_height_columns == NULL)
+    priv->row_height_columns = g_array_new (FALSE, FALSE, sizeof (gint));
+  columns = priv->row_height_columns;
+  g_array_set_size (columns, 0);
+
+  for (list = priv->columns; list; list = list->next)
+    {
+      GtkTreeViewColumn *column = list->data;
+
+      if (!gtk_tree_view_column_get_visible (column))
+        continue;
+
+      if (!_gtk_cell_area_get_attribute_columns (gtk_cell_layout_get_area (GTK_CELL_LAYOUT (column)),
+                                                 columns))
+        return FALSE;
+    }
+
+  flags = (depth << 3) |
+          (is_separator ? 1 : 0) |
+          (GTK_TREE_RBNODE_FLAG_SET (node, GTK_TREE_RBNODE_IS_PARENT) ? 2 : 0) |
+          (node->children ? 4 : 0);
+  hash = hash_bytes (G_GUINT64_CONSTANT (14695981039346656037), &flags, sizeof (flags));
+
+  for (i = 0; i < columns->len; i++)
+    {
+      GValue value = G_VALUE_INIT;
+
+      gtk_tree_model_get_value (priv->model, iter, g_array_index (columns, gint, i), &value);
+      hash = hash_value (hash, &value);
+      g_value_unset (&value);
+    }
+
+  *result = hash;
+
+  return TRUE;
+}
+
 /* Returns TRUE if it updated the size
  */
 static gboolean
@@ -5546,6 +5948,8 @@ validate_row (GtkTreeView   *tree_view,
   gboolean draw_vgrid_lines, draw_hgrid_lines;
   gint expander_size;
   int separator_height;
+  gboolean use_cache = FALSE;
+  guint64 hash = 0;
 
   /* double check the row needs validating */
   if (! GTK_TREE_RBNODE_FLAG_SET (node, GTK_TREE_RBNODE_INVALID) &&
@@ -5554,6 +5958,25 @@ validate_row (GtkTreeView   *tree_view,
 
   is_separator = row_is_separator (tree_view, iter, NULL);
 
+  if (tree_view->priv->estimate_row_heights &&
+      GTK_TREE_RBNODE_FLAG_SET (node, GTK_TREE_RBNODE_INVALID))
+    {
+      gpointer cached;
+
+      use_cache = gtk_tree_view_get_row_content_hash (tree_view, iter, node, depth,
+                                                      is_separator, &hash);
+
+      /* The columns are as wide as they were when measuring a row
+       * with the same content, so only the height can change
+       */
+      if (use_cache && tree_view->priv->row_height_cache &&
+          g_hash_table_lookup_extended (tree_view->priv->row_height_cache, &hash, NULL, &cached))
+        {
+          height = GPOINTER_TO_INT (cached);
+          goto done;
+        }
+    }
+
   draw_vgrid_lines =
     tree_view->priv->grid_lines == GTK_TREE_VIEW_GRID_LINES_VERTICAL
     || tree_view->priv->grid_lines == GTK_TREE_VIEW_GRID_LINES_BOTH;
@@ -5646,6 +6069,26 @@ validate_row (GtkTreeView   *tree_view,
   if (draw_hgrid_lines)
     height += _TREE_VIEW_GRID_LINE_WIDTH;
 
+  if (use_cache)
+    {
+      if (tree_view->priv->row_height_cache == NULL)
+        tree_view->priv->row_height_cache = g_hash_table_new_full (g_int64_hash, g_int64_equal,
+                                                                   g_free, NULL);
+      else if (g_hash_table_size (tree_view->priv->row_height_cache) >= ROW_HEIGHT_CACHE_SIZE)
+        g_hash_table_remove_all (tree_view->priv->row_height_cache);
+
+      g_hash_table_insert (tree_view->priv->row_height_cache,
+                           g_memdup (&hash, sizeof (guint64)),
+                           GINT_TO_POINTER (height));
+    }
+
+ done:
+  if (!is_separator)
+    {
+      tree_view->priv->measured_height_sum += height;
+      tree_view->priv->n_measured_rows++;
+    }
+
   if (height != GTK_TREE_RBNODE_GET_HEIGHT (node))
     {
       retval = TRUE;
@@ -5816,6 +6259,17 @@ validate_visible_area (GtkTreeView *tree_view)
 	}
       area_above = 0;
       area_below = total_height - gtk_tree_view_get_row_height (tree_view, node);
+
+      /* Measure a page above and below the visible area as well, so that
+       * scrolling a bit doesn't show rows with estimated heights
+       */
+      if (tree_view->priv->estimate_row_heights)
+        {
+          gint page_size = gtk_adjustment_get_page_size (tree_view->priv->vadjustment);
+
+          area_above += page_size;
+          area_below += page_size;
+        }
     }
 
   above_path = gtk_tree_path_copy (path);
@@ -6098,6 +6552,12 @@ do_validate_rows (GtkTreeView *tree_view, gboolean queue_resize)
       return FALSE;
     }
 
+  /* Rows near the visible area are measured by validate_visible_area(),
+   * all others keep their estimated height
+   */
+  if (tree_view->priv->estimate_row_heights)
+    return FALSE;
+
   timer = g_timer_new ();
   g_timer_start (timer);
 
@@ -6511,6 +6971,7 @@ _gtk_tree_view_install_mark_rows_col_dirty (GtkTreeView *tree_view,
 					    gboolean     install_handler)
 {
   tree_view->priv->mark_rows_col_dirty = TRUE;
+  gtk_tree_view_reset_row_height_estimates (tree_view);
 
   if (install_handler)
     install_presize_handler (tree_view);
@@ -7701,6 +8162,108 @@ gtk_tree_view_get_fixed_height_mode (GtkTreeView *tree_view)
   return tree_view->priv->fixed_height_mode;
 }
 
+/**
+ * gtk_tree_view_set_estimate_row_heights:
+ * @tree_view: a #GtkTreeView
+ * @estimate: %TRUE to estimate the heights of rows
+ *
+ * Enables or disables the estimation of row heights for @tree_view.
+ *
+ * Normally, #GtkTreeView measures all rows of the model in the
+ * background after it is shown, which takes a long time for big
+ * models. With row height estimation, only the rows within a page of
+ * the visible area are measured, and all other rows get an estimated
+ * height until they are scrolled into view. The estimate is provided
+ * by the function set with gtk_tree_view_set_row_height_func() or
+ * is the average height of the rows measured so far.
+ *
+ * As rows far away from the visible area are not measured, the width
+ * of autosized columns only accounts for the rows that have been
+ * shown.
+ *
+ * This option has no effect if fixed height mode is turned on.
+ **/
+void
+gtk_tree_view_set_estimate_row_heights (GtkTreeView *tree_view,
+                                        gboolean     estimate)
+{
+  GtkTreeViewPrivate *priv;
+
+  g_return_if_fail (GTK_IS_TREE_VIEW (tree_view));
+
+  priv = tree_view->priv;
+  estimate = estimate != FALSE;
+
+  if (estimate == priv->estimate_row_heights)
+    return;
+
+  priv->estimate_row_heights = estimate;
+
+  if (estimate)
+    gtk_tree_rbtree_set_fixed_height (priv->tree,
+                                      gtk_tree_view_get_estimated_row_height (tree_view, NULL),
+                                      FALSE);
+
+  /* measure the visible rows, or all of them */
+  install_presize_handler (tree_view);
+
+  g_object_notify_by_pspec (G_OBJECT (tree_view), tree_view_props[PROP_ESTIMATE_ROW_HEIGHTS]);
+}
+
+/**
+ * gtk_tree_view_get_estimate_row_heights:
+ * @tree_view: a #GtkTreeView
+ *
+ * Returns whether row heights are estimated for @tree_view.
+ * See gtk_tree_view_set_estimate_row_heights().
+ *
+ * Returns: %TRUE if @tree_view estimates row heights
+ **/
+gboolean
+gtk_tree_view_get_estimate_row_heights (GtkTreeView *tree_view)
+{
+  g_return_val_if_fail (GTK_IS_TREE_VIEW (tree_view), FALSE);
+
+  return tree_view->priv->estimate_row_heights;
+}
+
+/**
+ * gtk_tree_view_set_row_height_func:
+ * @tree_view: a #GtkTreeView
+ * @func: (allow-none): a #GtkTreeViewRowHeightFunc
+ * @data: (allow-none): user data to pass to @func, or %NULL
+ * @destroy: (allow-none): destroy notifier for @data, or %NULL
+ *
+ * Sets the function used to estimate the height of rows that have not
+ * been measured yet if the view estimates row heights, see
+ * gtk_tree_view_set_estimate_row_heights(). It is called for the rows
+ * added to the view after it has been set.
+ *
+ * The function is called a lot and must be fast. Applications showing
+ * text of varying length can, for example, compute the number of lines
+ * of each row ahead of time, off the main thread, with a #PangoLayout
+ * of their own and look up the result here.
+ **/
+void
+gtk_tree_view_set_row_height_func (GtkTreeView              *tree_view,
+                                   GtkTreeViewRowHeightFunc  func,
+                                   gpointer                  data,
+                                   GDestroyNotify            destroy)
+{
+  GtkTreeViewPrivate *priv;
+
+  g_return_if_fail (GTK_IS_TREE_VIEW (tree_view));
+
+  priv = tree_view->priv;
+
+  if (priv->row_height_destroy)
+    priv->row_height_destroy (priv->row_height_data);
+
+  priv->row_height_func = func;
+  priv->row_height_data = data;
+  priv->row_height_destroy = destroy;
+}
+
 /* Returns TRUE if the focus is within the headers, after the focus operation is
  * done
  */
@@ -7984,6 +8547,8 @@ gtk_tree_view_style_updated (GtkWidget *widget)
 
   GTK_WIDGET_CLASS (gtk_tree_view_parent_class)->style_updated (widget);
 
+  gtk_tree_view_clear_row_cache (tree_view);
+
   if (gtk_widget_get_realized (widget))
     {
       gtk_tree_view_set_grid_lines (tree_view, priv->grid_lines);
@@ -8002,6 +8567,7 @@ gtk_tree_view_style_updated (GtkWidget *widget)
 	}
 
       priv->fixed_height = -1;
+      gtk_tree_view_reset_row_height_estimates (tree_view);
       gtk_tree_rbtree_mark_invalid (priv->tree);
     }
 
@@ -8182,6 +8748,9 @@ gtk_tree_view_row_changed (GtkTreeModel *model,
   if (tree == NULL)
     goto done;
 
+  if (tree_view->priv->row_cache)
+    g_hash_table_remove (tree_view->priv->row_cache, node);
+
   _gtk_tree_view_accessible_changed (tree_view, tree, node);
 
   if (tree_view->priv->fixed_height_mode
@@ -8234,6 +8803,8 @@ gtk_tree_view_row_inserted (GtkTreeModel *model,
 
   g_return_if_fail (path != NULL || iter != NULL);
 
+  gtk_tree_view_clear_row_cache (tree_view);
+
   if (tree_view->priv->fixed_height_mode
       && tree_view->priv->fixed_height >= 0)
     height = tree_view->priv->fixed_height;
@@ -8311,6 +8882,11 @@ gtk_tree_view_row_inserted (GtkTreeModel *model,
       tmpnode = gtk_tree_rbtree_insert_after (tree, tmpnode, height, FALSE);
     }
 
+  /* The row stays invalid, but doesn't make the view jump when measured */
+  if (height == 0 && tree_view->priv->estimate_row_heights)
+    gtk_tree_rbtree_node_set_height (tree, tmpnode,
+                                     gtk_tree_view_get_estimated_row_height (tree_view, iter));
+
   _gtk_tree_view_accessible_add (tree_view, tree, tmpnode);
 
  done:
@@ -8330,6 +8906,63 @@ gtk_tree_view_row_inserted (GtkTreeModel *model,
     gtk_tree_path_free (path);
 }
 
+/* Handles a block of rows that the model inserted at once, see
+ * _gtk_tree_model_rows_inserted(). The first row finds its place in
+ * the tree like any other, the others are added right after it.
+ */
+static void
+gtk_tree_view_rows_inserted (GtkTreeModel *model,
+                             GtkTreePath  *path,
+                             GtkTreeIter  *iter,
+                             gint          n_rows,
+                             gpointer      data)
+{
+  GtkTreeView *tree_view = (GtkTreeView *) data;
+  GtkTreeRBTree *tree;
+  GtkTreeRBNode *node;
+  GtkTreePath *row_path;
+  GtkTreeIter row_iter;
+  gint height;
+  gint i;
+
+  gtk_tree_view_row_inserted (model, path, iter, data);
+
+  /* Nothing to do if the rows are not shown */
+  if (_gtk_tree_view_find_node (tree_view, path, &tree, &node) || node == NULL)
+    return;
+
+  if (tree_view->priv->fixed_height_mode
+      && tree_view->priv->fixed_height >= 0)
+    height = tree_view->priv->fixed_height;
+  else
+    height = 0;
+
+  row_path = gtk_tree_path_copy (path);
+  row_iter = *iter;
+
+  for (i = 1; i < n_rows; i++)
+    {
+      gtk_tree_path_next (row_path);
+      if (!gtk_tree_model_iter_next (model, &row_iter))
+        break;
+
+      gtk_tree_row_reference_inserted (G_OBJECT (data), row_path);
+
+      gtk_tree_model_ref_node (model, &row_iter);
+      node = gtk_tree_rbtree_insert_after (tree, node, height, FALSE);
+
+      if (height > 0)
+        gtk_tree_rbtree_node_mark_valid (tree, node);
+      else if (tree_view->priv->estimate_row_heights)
+        gtk_tree_rbtree_node_set_height (tree, node,
+                                         gtk_tree_view_get_estimated_row_height (tree_view, &row_iter));
+
+      _gtk_tree_view_accessible_add (tree_view, tree, node);
+    }
+
+  gtk_tree_path_free (row_path);
+}
+
 static void
 gtk_tree_view_row_has_child_toggled (GtkTreeModel *model,
 				     GtkTreePath  *path,
@@ -8439,6 +9072,8 @@ gtk_tree_view_row_deleted (GtkTreeModel *model,
 
   gtk_tree_row_reference_deleted (G_OBJECT (data), path);
 
+  gtk_tree_view_clear_row_cache (tree_view);
+
   if (_gtk_tree_view_find_node (tree_view, path, &tree, &node))
     return;
 
@@ -8566,6 +9201,8 @@ gtk_tree_view_rows_reordered (GtkTreeModel *model,
   if (len < 2)
     return;
 
+  gtk_tree_view_clear_row_cache (tree_view);
+
   gtk_tree_row_reference_reordered (G_OBJECT (data),
 				    parent,
 				    iter,
@@ -8735,6 +9372,11 @@ gtk_tree_view_build_tree (GtkTreeView   *tree_view,
 	      gtk_tree_rbtree_node_mark_valid (tree, temp);
 	    }
         }
+      else if (tree_view->priv->estimate_row_heights)
+        {
+          gtk_tree_rbtree_node_set_height (tree, temp,
+                                           gtk_tree_view_get_estimated_row_height (tree_view, iter));
+        }
 
       if (tree_view->priv->is_list)
         continue;
@@ -10381,6 +11023,9 @@ gtk_tree_view_adjustment_changed (GtkAdjustment *adjustment,
           if (!tree_view->priv->in_top_row_to_dy)
             gtk_tree_view_dy_to_top_row (tree_view);
 
+          /* Measure the rows that scrolled into view */
+          if (tree_view->priv->estimate_row_heights)
+            install_presize_handler (tree_view);
         }
     }
 
@@ -10478,6 +11123,7 @@ gtk_tree_view_set_model (GtkTreeView  *tree_view,
       g_signal_handlers_disconnect_by_func (tree_view->priv->model,
 					    gtk_tree_view_row_changed,
 					    tree_view);
+      _gtk_tree_model_remove_rows_inserted_handler (tree_view->priv->model, tree_view);
       g_signal_handlers_disconnect_by_func (tree_view->priv->model,
 					    gtk_tree_view_row_inserted,
 					    tree_view);
@@ -10514,6 +11160,7 @@ gtk_tree_view_set_model (GtkTreeView  *tree_view,
       tree_view->priv->search_column = -1;
       tree_view->priv->fixed_height_check = 0;
       tree_view->priv->fixed_height = -1;
+      gtk_tree_view_reset_row_height_estimates (tree_view);
       tree_view->priv->dy = tree_view->priv->top_row_dy = 0;
     }
 
@@ -10545,10 +11192,13 @@ gtk_tree_view_set_model (GtkTreeView  *tree_view,
 			"row-changed",
 			G_CALLBACK (gtk_tree_view_row_changed),
 			tree_view);
-      g_signal_connect (tree_view->priv->model,
-			"row-inserted",
-			G_CALLBACK (gtk_tree_view_row_inserted),
-			tree_view);
+      _gtk_tree_model_add_rows_inserted_handler (tree_view->priv->model,
+                                                 g_signal_connect (tree_view->priv->model,
+                                                                   "row-inserted",
+                                                                   G_CALLBACK (gtk_tree_view_row_inserted),
+                                                                   tree_view),
+                                                 gtk_tree_view_rows_inserted,
+                                                 tree_view);
       g_signal_connect (tree_view->priv->model,
 			"row-has-child-toggled",
 			G_CALLBACK (gtk_tree_view_row_has_child_toggled),
@@ -11639,6 +12289,8 @@ gtk_tree_view_real_expand_row (GtkTreeView   *tree_view,
   if (node->children && !open_all)
     return FALSE;
 
+  gtk_tree_view_clear_row_cache (tree_view);
+
   if (! GTK_TREE_RBNODE_FLAG_SET (node, GTK_TREE_RBNODE_IS_PARENT))
     return FALSE;
 
@@ -11768,6 +12420,8 @@ gtk_tree_view_real_collapse_row (GtkTreeView   *tree_view,
 
   if (node->children == NULL)
     return FALSE;
+
+  gtk_tree_view_clear_row_cache (tree_view);
   gtk_tree_model_get_iter (tree_view->priv->model, &iter, path);
 
   g_signal_emit (tree_view, tree_view_signals[TEST_COLLAPSE_ROW], 0, &iter, path, &collapse);
@@ -14609,6 +15263,7 @@ gtk_tree_view_set_row_separator_func (GtkTreeView                 *tree_view,
   tree_view->priv->row_separator_destroy = destroy;
 
   /* Have the tree recalculate heights */
+  gtk_tree_view_reset_row_height_estimates (tree_view);
   gtk_tree_rbtree_mark_invalid (tree_view->priv->tree);
   gtk_widget_queue_resize (GTK_WIDGET (tree_view));
 }
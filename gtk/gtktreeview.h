@@ -196,6 +196,22 @@ typedef gboolean (*GtkTreeViewSearchEqualFunc) (GtkTreeModel            *model,
 typedef gboolean (*GtkTreeViewRowSeparatorFunc) (GtkTreeModel      *model,
 						 GtkTreeIter       *iter,
 						 gpointer           data);
+
+/**
+ * GtkTreeViewRowHeightFunc:
+ * @model: the #GtkTreeModel
+ * @iter: a #GtkTreeIter pointing at a row in @model
+ * @data: (closure): user data
+ *
+ * Function type for estimating the height of the row pointed to by @iter
+ * before it has been measured. See gtk_tree_view_set_row_height_func().
+ *
+ * Returns: the estimated height of the row, or -1 to use the estimate
+ *     of the tree view
+ */
+typedef gint     (*GtkTreeViewRowHeightFunc)    (GtkTreeModel      *model,
+						 GtkTreeIter       *iter,
+						 gpointer           data);
 typedef void     (*GtkTreeViewSearchPositionFunc) (GtkTreeView  *tree_view,
 						   GtkWidget    *search_dialog,
 						   gpointer      user_data);
@@ -489,6 +505,16 @@ void     gtk_tree_view_set_fixed_height_mode (GtkTreeView          *tree_view,
 GDK_AVAILABLE_IN_ALL
 gboolean gtk_tree_view_get_fixed_height_mode (GtkTreeView          *tree_view);
 GDK_AVAILABLE_IN_ALL
+void     gtk_tree_view_set_estimate_row_heights (GtkTreeView       *tree_view,
+                                                 gboolean           estimate);
+GDK_AVAILABLE_IN_ALL
+gboolean gtk_tree_view_get_estimate_row_heights (GtkTreeView       *tree_view);
+GDK_AVAILABLE_IN_ALL
+void     gtk_tree_view_set_row_height_func   (GtkTreeView              *tree_view,
+                                              GtkTreeViewRowHeightFunc  func,
+                                              gpointer                  data,
+                                              GDestroyNotify            destroy);
+GDK_AVAILABLE_IN_ALL
 void     gtk_tree_view_set_hover_selection   (GtkTreeView          *tree_view,
 					      gboolean              hover);
 GDK_AVAILABLE_IN_ALL
@@ -73,6 +73,8 @@ struct _GtkViewportPrivate
    * driving the scrollable adjustment values */
   guint hscroll_policy : 1;
   guint vscroll_policy : 1;
+
+  guint in_size_allocate : 1;
 };
 
 enum {
@@ -521,6 +523,21 @@ gtk_viewport_snapshot (GtkWidget   *widget,
   gtk_snapshot_pop (snapshot);
 }
 
+static void
+gtk_viewport_allocate_child (GtkViewport *viewport,
+                             GtkWidget   *child)
+{
+  GtkViewportPrivate *priv = gtk_viewport_get_instance_private (viewport);
+  GtkAllocation child_allocation;
+
+  child_allocation.x = - gtk_adjustment_get_value (priv->hadjustment);
+  child_allocation.y = - gtk_adjustment_get_value (priv->vadjustment);
+  child_allocation.width = gtk_adjustment_get_upper (priv->hadjustment);
+  child_allocation.height = gtk_adjustment_get_upper (priv->vadjustment);
+
+  gtk_widget_size_allocate (child, &child_allocation, -1);
+}
+
 static void
 gtk_viewport_size_allocate (GtkWidget *widget,
                             int        width,
@@ -533,6 +550,7 @@ gtk_viewport_size_allocate (GtkWidget *widget,
   GtkAdjustment *vadjustment = priv->vadjustment;
   GtkWidget *child;
 
+  priv->in_size_allocate = TRUE;
   g_object_freeze_notify (G_OBJECT (hadjustment));
   g_object_freeze_notify (G_OBJECT (vadjustment));
 
@@ -541,24 +559,36 @@ gtk_viewport_size_allocate (GtkWidget *widget,
 
   child = gtk_bin_get_child (GTK_BIN (widget));
   if (child && gtk_widget_get_visible (child))
-    {
-      GtkAllocation child_allocation;
-
-      child_allocation.x = - gtk_adjustment_get_value (hadjustment);
-      child_allocation.y = - gtk_adjustment_get_value (vadjustment);
-      child_allocation.width = gtk_adjustment_get_upper (hadjustment);
-      child_allocation.height = gtk_adjustment_get_upper (vadjustment);
-
-      gtk_widget_size_allocate (child, &child_allocation, -1);
-    }
+    gtk_viewport_allocate_child (viewport, child);
 
   g_object_thaw_notify (G_OBJECT (hadjustment));
   g_object_thaw_notify (G_OBJECT (vadjustment));
+  priv->in_size_allocate = FALSE;
 }
 
 static void
 gtk_viewport_adjustment_value_changed (GtkAdjustment *adjustment,
                                        gpointer       data)
 {
-  gtk_widget_queue_allocate (GTK_WIDGET (data));
+  GtkViewport *viewport = data;
+  GtkViewportPrivate *priv = gtk_viewport_get_instance_private (viewport);
+  GtkWidget *widget = GTK_WIDGET (viewport);
+  GtkWidget *child;
+
+  if (priv->in_size_allocate)
+    return;
+
+  child = gtk_bin_get_child (GTK_BIN (viewport));
+
+  /* Scrolling only changes the child's position. If nothing else needs
+   * a relayout, move the child right away instead of going through a
+   * full allocation of the viewport. As the child's size stays the same,
+   * it is not allocated again and its render node is reused, so only
+   * our own node with the new offset needs to be recreated. */
+  if (child && gtk_widget_get_visible (child) &&
+      gtk_widget_get_mapped (widget) &&
+      !gtk_widget_needs_allocate (widget))
+    gtk_viewport_allocate_child (viewport, child);
+  else
+    gtk_widget_queue_allocate (widget);
 }
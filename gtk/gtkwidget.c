@@ -72,8 +72,11 @@
 #include "inspector/window.h"
 
 #include "gdk/gdkeventsprivate.h"
+#include "gdk/gdkframeclockprivate.h"
+#include "gdk/gdkprofilerprivate.h"
 #include "gsk/gskdebugprivate.h"
 #include "gsk/gskrendererprivate.h"
+#include "gsk/gskrendernodeprivate.h"
 
 #include <cairo-gobject.h>
 #include <gobject/gobjectnotifyqueue.c>
@@ -447,6 +450,7 @@ typedef struct {
 
 typedef struct {
   GBytes               *data;
+  GBytes               *precompiled;
   GSList               *children;
   GSList               *callbacks;
   GtkBuilderConnectFunc connect_func;
@@ -535,6 +539,7 @@ enum {
   PROP_EXPAND,
   PROP_SCALE_FACTOR,
   PROP_CSS_NAME,
+  PROP_CACHE_RENDERING,
   NUM_PROPERTIES
 };
 
@@ -672,6 +677,12 @@ static void gtk_widget_update_input_shape (GtkWidget *widget);
 static gboolean gtk_widget_class_get_visible_by_default (GtkWidgetClass *widget_class);
 static void _gtk_widget_propagate_hierarchy_changed (GtkWidget *widget,
                                                      GtkWidget *previous_toplevel);
+static void gtk_widget_clear_render_node (GtkWidget *widget);
+static void gtk_widget_damage_render_node (GtkWidget *widget);
+static void gtk_widget_clear_child_render_nodes (GtkWidget *widget);
+static void gtk_widget_invalidate_pick_index (GtkWidget *widget);
+static gboolean gtk_widget_ensure_render_node (GtkWidget   *widget,
+                                               GtkSnapshot *snapshot);
 
 
 /* --- variables --- */
@@ -694,6 +705,17 @@ static GQuark           quark_widget_path = 0;
 static GQuark           quark_action_muxer = 0;
 static GQuark           quark_font_options = 0;
 static GQuark           quark_font_map = 0;
+static GQuark           quark_layout_stats = 0;
+static GQuark           quark_invalidations = 0;
+
+static gboolean         layout_profiling = FALSE;
+static gint64           layout_frame = 0;
+
+#define N_FRAME_STATS 256
+
+static gboolean         frame_profiling = FALSE;
+static GtkFrameStats    frame_stats[N_FRAME_STATS];
+static guint            n_frame_stats = 0;
 
 GParamSpecPool         *_gtk_widget_child_property_pool = NULL;
 GObjectNotifyContext   *_gtk_widget_child_property_notify_context = NULL;
@@ -805,21 +827,33 @@ gtk_widget_real_pick (GtkWidget *widget,
                       gdouble    x,
                       gdouble    y)
 {
+  GtkWidgetPrivate *priv = gtk_widget_get_instance_private (widget);
   GtkWidget *child;
 
-  for (child = _gtk_widget_get_last_child (widget);
-       child;
-       child = _gtk_widget_get_prev_sibling (child))
+  if (priv->pick_index)
     {
       GtkWidget *picked;
-      int dx, dy;
 
-      gtk_widget_get_origin_relative_to_parent (child, &dx, &dy);
-
-      picked = gtk_widget_pick (child, x - dx, y - dy);
+      picked = gtk_pick_index_pick_child (priv->pick_index, widget, x, y);
       if (picked)
         return picked;
     }
+  else
+    {
+      for (child = _gtk_widget_get_last_child (widget);
+           child;
+           child = _gtk_widget_get_prev_sibling (child))
+        {
+          GtkWidget *picked;
+          int dx, dy;
+
+          gtk_widget_get_origin_relative_to_parent (child, &dx, &dy);
+
+          picked = gtk_widget_pick (child, x - dx, y - dy);
+          if (picked)
+            return picked;
+        }
+    }
 
   if (!gtk_widget_contains (widget, x, y))
     return NULL;
@@ -873,6 +907,8 @@ gtk_widget_class_init (GtkWidgetClass *klass)
   quark_action_muxer = g_quark_from_static_string ("gtk-widget-action-muxer");
   quark_font_options = g_quark_from_static_string ("gtk-widget-font-options");
   quark_font_map = g_quark_from_static_string ("gtk-widget-font-map");
+  quark_layout_stats = g_quark_from_static_string ("gtk-widget-layout-stats");
+  quark_invalidations = g_quark_from_static_string ("gtk-widget-invalidations");
 
   _gtk_widget_child_property_pool = g_param_spec_pool_new (TRUE);
   cpn_context.quark_notify_queue = g_quark_from_static_string ("GtkWidget-child-property-notify-queue");
@@ -1328,6 +1364,21 @@ gtk_widget_class_init (GtkWidgetClass *klass)
                            NULL,
                            GTK_PARAM_READWRITE | G_PARAM_CONSTRUCT_ONLY);
 
+  /**
+   * GtkWidget:cache-rendering:
+   *
+   * Whether renderers should keep the rendering of the widget around
+   * as a texture.
+   *
+   * See gtk_widget_set_cache_rendering().
+   */
+  widget_props[PROP_CACHE_RENDERING] =
+      g_param_spec_boolean ("cache-rendering",
+                            P_("Cache rendering"),
+                            P_("Whether the rendering of the widget should be cached"),
+                            FALSE,
+                            GTK_PARAM_READWRITE|G_PARAM_EXPLICIT_NOTIFY);
+
   g_object_class_install_properties (gobject_class, NUM_PROPERTIES, widget_props);
 
   /**
@@ -2211,6 +2262,9 @@ gtk_widget_set_property (GObject         *object,
     case PROP_FOCUS_ON_CLICK:
       gtk_widget_set_focus_on_click (widget, g_value_get_boolean (value));
       break;
+    case PROP_CACHE_RENDERING:
+      gtk_widget_set_cache_rendering (widget, g_value_get_boolean (value));
+      break;
     case PROP_CAN_DEFAULT:
       gtk_widget_set_can_default (widget, g_value_get_boolean (value));
       break;
@@ -2462,6 +2516,9 @@ gtk_widget_get_property (GObject         *object,
     case PROP_CSS_NAME:
       g_value_set_string (value, gtk_css_node_get_name (priv->cssnode));
       break;
+    case PROP_CACHE_RENDERING:
+      g_value_set_boolean (value, gtk_widget_get_cache_rendering (widget));
+      break;
     default:
       G_OBJECT_WARN_INVALID_PROPERTY_ID (object, prop_id, pspec);
       break;
@@ -3012,6 +3069,9 @@ gtk_widget_unparent (GtkWidget *widget)
   if (gtk_widget_get_focus_child (priv->parent) == widget)
     gtk_widget_set_focus_child (priv->parent, NULL);
 
+  /* Don't keep pointers to a child that may go away */
+  gtk_widget_clear_child_render_nodes (priv->parent);
+
   if (_gtk_widget_is_drawable (priv->parent))
     gtk_widget_queue_draw (priv->parent);
 
@@ -3023,6 +3083,7 @@ gtk_widget_unparent (GtkWidget *widget)
    */
   priv->allocation.width = 0;
   priv->allocation.height = 0;
+  priv->parent_is_relayout_boundary = FALSE;
 
   if (_gtk_widget_get_realized (widget))
     gtk_widget_unrealize (widget);
@@ -3054,6 +3115,8 @@ gtk_widget_unparent (GtkWidget *widget)
         priv->prev_sibling->priv->next_sibling = priv->next_sibling;
       if (priv->next_sibling)
         priv->next_sibling->priv->prev_sibling = priv->prev_sibling;
+
+      gtk_widget_invalidate_pick_index (old_parent);
     }
   old_prev_sibling = priv->prev_sibling;
   priv->parent = NULL;
@@ -3384,6 +3447,145 @@ gtk_widget_unmap (GtkWidget *widget)
     }
 }
 
+/* Tick callbacks of all widgets sharing a frame clock are run
+ * from a single ::update handler, instead of connecting each
+ * widget to the signal. With many animating widgets this avoids
+ * the cost of a signal emission per widget per frame.
+ */
+typedef struct _GtkTickDispatcher GtkTickDispatcher;
+
+struct _GtkTickDispatcher
+{
+  GPtrArray *widgets; /* not refs, NULL slots while dispatching */
+  guint n_widgets;
+  gulong update_id;
+  guint dispatching : 1;
+  guint needs_compact : 1;
+};
+
+static GQuark quark_tick_dispatcher;
+
+static void gtk_widget_run_tick_callbacks (GtkWidget     *widget,
+                                           GdkFrameClock *frame_clock);
+
+static void
+gtk_tick_dispatcher_free (gpointer data)
+{
+  GtkTickDispatcher *dispatcher = data;
+
+  g_ptr_array_unref (dispatcher->widgets);
+  g_slice_free (GtkTickDispatcher, dispatcher);
+}
+
+static void
+gtk_tick_dispatcher_compact (GtkTickDispatcher *dispatcher)
+{
+  guint i;
+
+  for (i = dispatcher->widgets->len; i > 0; i--)
+    {
+      if (g_ptr_array_index (dispatcher->widgets, i - 1) == NULL)
+        g_ptr_array_remove_index_fast (dispatcher->widgets, i - 1);
+    }
+
+  dispatcher->needs_compact = FALSE;
+}
+
+static void
+gtk_tick_dispatcher_update (GdkFrameClock     *frame_clock,
+                            GtkTickDispatcher *dispatcher)
+{
+  guint i, n;
+
+  /* Like with signal handlers, widgets that start ticking
+   * during the dispatch are not run until the next frame.
+   */
+  n = dispatcher->widgets->len;
+  dispatcher->dispatching = TRUE;
+
+  for (i = 0; i < n; i++)
+    {
+      GtkWidget *widget = g_ptr_array_index (dispatcher->widgets, i);
+
+      if (widget == NULL)
+        continue;
+
+      g_object_ref (widget);
+      gtk_widget_run_tick_callbacks (widget, frame_clock);
+      g_object_unref (widget);
+    }
+
+  dispatcher->dispatching = FALSE;
+
+  if (dispatcher->needs_compact)
+    gtk_tick_dispatcher_compact (dispatcher);
+}
+
+static void
+gtk_tick_dispatcher_add (GdkFrameClock *frame_clock,
+                         GtkWidget     *widget)
+{
+  GtkTickDispatcher *dispatcher;
+
+  if (G_UNLIKELY (quark_tick_dispatcher == 0))
+    quark_tick_dispatcher = g_quark_from_static_string ("gtk-tick-dispatcher");
+
+  dispatcher = g_object_get_qdata (G_OBJECT (frame_clock), quark_tick_dispatcher);
+  if (dispatcher == NULL)
+    {
+      dispatcher = g_slice_new0 (GtkTickDispatcher);
+      dispatcher->widgets = g_ptr_array_new ();
+      g_object_set_qdata_full (G_OBJECT (frame_clock), quark_tick_dispatcher,
+                               dispatcher, gtk_tick_dispatcher_free);
+    }
+
+  if (dispatcher->n_widgets == 0)
+    {
+      dispatcher->update_id = g_signal_connect (frame_clock, "update",
+                                                G_CALLBACK (gtk_tick_dispatcher_update),
+                                                dispatcher);
+      gdk_frame_clock_begin_updating (frame_clock);
+    }
+
+  g_ptr_array_add (dispatcher->widgets, widget);
+  dispatcher->n_widgets++;
+}
+
+static void
+gtk_tick_dispatcher_remove (GdkFrameClock *frame_clock,
+                            GtkWidget     *widget)
+{
+  GtkTickDispatcher *dispatcher;
+  guint i;
+
+  dispatcher = g_object_get_qdata (G_OBJECT (frame_clock), quark_tick_dispatcher);
+  g_return_if_fail (dispatcher != NULL);
+
+  for (i = 0; i < dispatcher->widgets->len; i++)
+    {
+      if (g_ptr_array_index (dispatcher->widgets, i) != widget)
+        continue;
+
+      if (dispatcher->dispatching)
+        {
+          g_ptr_array_index (dispatcher->widgets, i) = NULL;
+          dispatcher->needs_compact = TRUE;
+        }
+      else
+        g_ptr_array_remove_index_fast (dispatcher->widgets, i);
+
+      dispatcher->n_widgets--;
+      break;
+    }
+
+  if (dispatcher->n_widgets == 0 && dispatcher->update_id != 0)
+    {
+      g_signal_handler_disconnect (frame_clock, dispatcher->update_id);
+      dispatcher->update_id = 0;
+      gdk_frame_clock_end_updating (frame_clock);
+    }
+}
+
 typedef struct _GtkTickCallbackInfo GtkTickCallbackInfo;
 
 struct _GtkTickCallbackInfo
@@ -3420,12 +3622,10 @@ unref_tick_callback_info (GtkWidget           *widget,
       g_slice_free (GtkTickCallbackInfo, info);
     }
 
-  if (priv->tick_callbacks == NULL && priv->clock_tick_id)
+  if (priv->tick_callbacks == NULL && priv->clock_tick_registered)
     {
-      GdkFrameClock *frame_clock = gtk_widget_get_frame_clock (widget);
-      g_signal_handler_disconnect (frame_clock, priv->clock_tick_id);
-      priv->clock_tick_id = 0;
-      gdk_frame_clock_end_updating (frame_clock);
+      gtk_tick_dispatcher_remove (gtk_widget_get_frame_clock (widget), widget);
+      priv->clock_tick_registered = FALSE;
     }
 }
 
@@ -3456,14 +3656,12 @@ destroy_tick_callbacks (GtkWidget *widget)
 }
 
 static void
-gtk_widget_on_frame_clock_update (GdkFrameClock *frame_clock,
-                                  GtkWidget     *widget)
+gtk_widget_run_tick_callbacks (GtkWidget     *widget,
+                               GdkFrameClock *frame_clock)
 {
   GtkWidgetPrivate *priv = gtk_widget_get_instance_private (widget);
   GList *l;
 
-  g_object_ref (widget);
-
   for (l = priv->tick_callbacks; l;)
     {
       GtkTickCallbackInfo *info = l->data;
@@ -3484,8 +3682,6 @@ gtk_widget_on_frame_clock_update (GdkFrameClock *frame_clock,
       unref_tick_callback_info (widget, info, l);
       l = next;
     }
-
-  g_object_unref (widget);
 }
 
 static guint tick_callback_id;
@@ -3534,16 +3730,14 @@ gtk_widget_add_tick_callback (GtkWidget       *widget,
 
   g_return_val_if_fail (GTK_IS_WIDGET (widget), 0);
 
-  if (priv->realized && !priv->clock_tick_id)
+  if (priv->realized && !priv->clock_tick_registered)
     {
       frame_clock = gtk_widget_get_frame_clock (widget);
 
       if (frame_clock)
         {
-          priv->clock_tick_id = g_signal_connect (frame_clock, "update",
-                                                  G_CALLBACK (gtk_widget_on_frame_clock_update),
-                                                  widget);
-          gdk_frame_clock_begin_updating (frame_clock);
+          gtk_tick_dispatcher_add (frame_clock, widget);
+          priv->clock_tick_registered = TRUE;
         }
     }
 
@@ -3608,12 +3802,10 @@ gtk_widget_connect_frame_clock (GtkWidget *widget)
 
   frame_clock = gtk_widget_get_frame_clock (widget);
 
-  if (priv->tick_callbacks != NULL && !priv->clock_tick_id)
+  if (priv->tick_callbacks != NULL && !priv->clock_tick_registered)
     {
-      priv->clock_tick_id = g_signal_connect (frame_clock, "update",
-                                              G_CALLBACK (gtk_widget_on_frame_clock_update),
-                                              widget);
-      gdk_frame_clock_begin_updating (frame_clock);
+      gtk_tick_dispatcher_add (frame_clock, widget);
+      priv->clock_tick_registered = TRUE;
     }
 
   gtk_css_node_invalidate_frame_clock (priv->cssnode, FALSE);
@@ -3629,15 +3821,10 @@ gtk_widget_disconnect_frame_clock (GtkWidget *widget)
 
   gtk_css_node_invalidate_frame_clock (priv->cssnode, FALSE);
 
-  if (priv->clock_tick_id)
+  if (priv->clock_tick_registered)
     {
-      GdkFrameClock *frame_clock;
-
-      frame_clock = gtk_widget_get_frame_clock (widget);
-
-      g_signal_handler_disconnect (frame_clock, priv->clock_tick_id);
-      priv->clock_tick_id = 0;
-      gdk_frame_clock_end_updating (frame_clock);
+      gtk_tick_dispatcher_remove (gtk_widget_get_frame_clock (widget), widget);
+      priv->clock_tick_registered = FALSE;
     }
 }
 
@@ -3771,10 +3958,19 @@ static void
 gtk_widget_update_paintables (GtkWidget *widget)
 {
   GtkWidgetPrivate *priv = gtk_widget_get_instance_private (widget);
+  GdkPaintable *image;
   GSList *l;
 
+  if (priv->paintables == NULL)
+    return;
+
+  /* All paintables observing the widget share one image */
+  image = gtk_widget_paintable_snapshot_widget (widget);
+
   for (l = priv->paintables; l; l = l->next)
-    gtk_widget_paintable_update_image (l->data);
+    gtk_widget_paintable_update_image (l->data, image);
+
+  g_object_unref (image);
 }
 
 static void
@@ -3797,6 +3993,23 @@ gtk_widget_pop_paintables (GtkWidget *widget)
     gtk_widget_paintable_pop_snapshot_count (l->data);
 }
 
+static void
+gtk_widget_clear_child_render_nodes (GtkWidget *widget)
+{
+  GtkWidgetPrivate *priv = gtk_widget_get_instance_private (widget);
+
+  g_clear_pointer (&priv->child_render_nodes, g_array_unref);
+}
+
+static void
+gtk_widget_clear_render_node (GtkWidget *widget)
+{
+  GtkWidgetPrivate *priv = gtk_widget_get_instance_private (widget);
+
+  g_clear_pointer (&priv->render_node, gsk_render_node_unref);
+  gtk_widget_clear_child_render_nodes (widget);
+}
+
 /**
  * gtk_widget_queue_draw:
  * @widget: a #GtkWidget
@@ -3808,21 +4021,40 @@ gtk_widget_pop_paintables (GtkWidget *widget)
 void
 gtk_widget_queue_draw (GtkWidget *widget)
 {
+  GtkWidget *start = widget;
+  GtkWidgetPrivate *priv;
+
   g_return_if_fail (GTK_IS_WIDGET (widget));
 
   /* Just return if the widget isn't mapped */
   if (!_gtk_widget_get_mapped (widget))
     return;
 
+  priv = gtk_widget_get_instance_private (widget);
+  if (priv->draw_needed)
+    return;
+
+  if (G_UNLIKELY (frame_profiling))
+    gtk_widget_add_invalidation (widget, FALSE);
+
+  priv->draw_needed = TRUE;
+  gtk_widget_damage_render_node (widget);
+  gtk_widget_clear_render_node (widget);
+
+  /* Ancestors keep their render nodes, they only need to swap in
+   * the new nodes of the children that changed. */
   for (; widget; widget = _gtk_widget_get_parent (widget))
     {
-      GtkWidgetPrivate *priv = gtk_widget_get_instance_private (widget);
+      priv = gtk_widget_get_instance_private (widget);
 
-      if (priv->draw_needed)
-        break;
+      if (widget != start)
+        {
+          if (priv->draw_needed || priv->child_draw_needed)
+            break;
+
+          priv->child_draw_needed = TRUE;
+        }
 
-      priv->draw_needed = TRUE;
-      g_clear_pointer (&priv->render_node, gsk_render_node_unref);
       if (_gtk_widget_get_has_surface (widget) &&
           _gtk_widget_get_realized (widget))
         gdk_surface_queue_expose (gtk_widget_get_surface (widget));
@@ -3895,7 +4127,14 @@ gtk_widget_queue_resize_internal (GtkWidget *widget)
     {
       GtkWidget *parent = _gtk_widget_get_parent (widget);
       if (parent)
-        gtk_widget_queue_resize_internal (parent);
+        {
+          /* The parent keeps its size, it only needs to give us a new
+           * allocation, so don't make everything above remeasure. */
+          if (priv->parent_is_relayout_boundary)
+            gtk_widget_set_alloc_needed (parent);
+          else
+            gtk_widget_queue_resize_internal (parent);
+        }
     }
 }
 
@@ -3919,6 +4158,9 @@ gtk_widget_queue_resize (GtkWidget *widget)
 {
   g_return_if_fail (GTK_IS_WIDGET (widget));
 
+  if (G_UNLIKELY (frame_profiling))
+    gtk_widget_add_invalidation (widget, TRUE);
+
   if (_gtk_widget_get_realized (widget))
     gtk_widget_queue_draw (widget);
 
@@ -3937,6 +4179,9 @@ gtk_widget_queue_resize_no_redraw (GtkWidget *widget)
 {
   g_return_if_fail (GTK_IS_WIDGET (widget));
 
+  if (G_UNLIKELY (frame_profiling))
+    gtk_widget_add_invalidation (widget, TRUE);
+
   gtk_widget_queue_resize_internal (widget);
 }
 
@@ -4068,11 +4313,15 @@ gtk_widget_size_allocate (GtkWidget           *widget,
   GtkCssStyle *style;
   GtkBorder margin, border, padding;
   GdkDisplay *display;
+  gint64 start_time = 0;
 
   g_return_if_fail (GTK_IS_WIDGET (widget));
   g_return_if_fail (baseline >= -1);
   g_return_if_fail (allocation != NULL);
 
+  if (G_UNLIKELY (layout_profiling))
+    start_time = g_get_monotonic_time ();
+
   gtk_widget_push_verify_invariants (widget);
 
   if (!priv->visible && !_gtk_widget_is_toplevel (widget))
@@ -4116,6 +4365,36 @@ gtk_widget_size_allocate (GtkWidget           *widget,
     }
 #endif /* G_ENABLE_DEBUG */
 
+  /* A pure move, like when scrolling. Everything that was measured and
+   * allocated for the old size is still valid, only the offset changes,
+   * and the render node can be reused at the new position.
+   */
+  if (!priv->alloc_needed && !priv->resize_needed &&
+      !_gtk_widget_get_has_surface (widget) &&
+      allocation->width == priv->allocated_size.width &&
+      allocation->height == priv->allocated_size.height &&
+      baseline == priv->allocated_size_baseline)
+    {
+      int dx = allocation->x - priv->allocated_size.x;
+      int dy = allocation->y - priv->allocated_size.y;
+
+      priv->allocated_size = *allocation;
+
+      if (dx != 0 || dy != 0)
+        {
+          priv->allocation.x += dx;
+          priv->allocation.y += dy;
+
+          gtk_widget_invalidate_pick_index (priv->parent);
+
+          /* The parent's node has our position baked in */
+          if (priv->parent)
+            gtk_widget_queue_draw (priv->parent);
+        }
+
+      goto out;
+    }
+
   alloc_needed = priv->alloc_needed;
   /* Preserve request/allocate ordering */
   priv->alloc_needed = FALSE;
@@ -4283,14 +4562,21 @@ gtk_widget_size_allocate (GtkWidget           *widget,
 check_clip:
   if (size_changed || baseline_changed)
     gtk_widget_queue_draw (widget);
-  else if (position_changed && priv->parent)
-    gtk_widget_queue_draw (priv->parent);
+  /* The parent's node has our position and size baked in */
+  if ((position_changed || size_changed) && priv->parent)
+    {
+      gtk_widget_queue_draw (priv->parent);
+      gtk_widget_invalidate_pick_index (priv->parent);
+    }
 
 out:
   if (priv->alloc_needed_on_child)
     gtk_widget_ensure_allocate (widget);
 
   gtk_widget_pop_verify_invariants (widget);
+
+  if (G_UNLIKELY (start_time != 0))
+    gtk_widget_add_layout_stats (widget, TRUE, g_get_monotonic_time () - start_time);
 }
 
 /**
@@ -5032,6 +5318,71 @@ _gtk_widget_set_captured_event_handler (GtkWidget               *widget,
   g_object_set_data (G_OBJECT (widget), I_("captured-event-handler"), callback);
 }
 
+void
+gtk_widget_invalidate_controller_phases (GtkWidget *widget)
+{
+  GtkWidgetPrivate *priv = gtk_widget_get_instance_private (widget);
+
+  priv->controller_phases_valid = FALSE;
+}
+
+static void
+gtk_widget_invalidate_pick_index (GtkWidget *widget)
+{
+  if (widget && widget->priv->pick_index)
+    gtk_pick_index_invalidate (widget->priv->pick_index);
+}
+
+/*
+ * gtk_widget_set_use_pick_index:
+ * @widget: a #GtkWidget
+ * @use_pick_index: whether to use a pick index
+ *
+ * Makes the default pick implementation look up children in a
+ * spatial index instead of trying all of them in turn. This is
+ * only correct if none of the children of @widget can pick
+ * anything outside of their allocation, so it is meant for
+ * containers with many children in a simple layout.
+ */
+void
+gtk_widget_set_use_pick_index (GtkWidget *widget,
+                               gboolean   use_pick_index)
+{
+  GtkWidgetPrivate *priv = gtk_widget_get_instance_private (widget);
+
+  if (use_pick_index == (priv->pick_index != NULL))
+    return;
+
+  if (use_pick_index)
+    priv->pick_index = gtk_pick_index_new ();
+  else
+    g_clear_pointer (&priv->pick_index, gtk_pick_index_free);
+}
+
+/* Tells if any controller wants to see events in @phase, without
+ * walking the list of controllers for every widget and event */
+static gboolean
+gtk_widget_has_controllers_for_phase (GtkWidget           *widget,
+                                      GtkPropagationPhase  phase)
+{
+  GtkWidgetPrivate *priv = gtk_widget_get_instance_private (widget);
+
+  if (!priv->controller_phases_valid)
+    {
+      GList *l;
+
+      priv->controller_phases = 0;
+      for (l = priv->event_controllers; l; l = l->next)
+        {
+          if (l->data)
+            priv->controller_phases |= 1 << gtk_event_controller_get_propagation_phase (l->data);
+        }
+      priv->controller_phases_valid = TRUE;
+    }
+
+  return (priv->controller_phases & (1 << phase)) != 0;
+}
+
 static gboolean
 _gtk_widget_run_controllers (GtkWidget           *widget,
                              const GdkEvent      *event,
@@ -5100,12 +5451,16 @@ _gtk_widget_captured_event (GtkWidget      *widget,
   if (!event_surface_is_still_viewable (event))
     return TRUE;
 
+  /* Most widgets along the way don't capture, spare them the copy */
+  handler = g_object_get_data (G_OBJECT (widget), I_("captured-event-handler"));
+  if (!handler && !gtk_widget_has_controllers_for_phase (widget, GTK_PHASE_CAPTURE))
+    return FALSE;
+
   event_copy = gdk_event_copy (event);
   translate_event_coordinates (event_copy, widget);
 
   return_val = _gtk_widget_run_controllers (widget, event_copy, GTK_PHASE_CAPTURE);
 
-  handler = g_object_get_data (G_OBJECT (widget), I_("captured-event-handler"));
   if (!handler)
     goto out;
 
@@ -5195,16 +5550,20 @@ gtk_widget_event_internal (GtkWidget      *widget,
   if (!event_surface_is_still_viewable (event))
     return TRUE;
 
-  event_copy = gdk_event_copy (event);
+  if (gtk_widget_has_controllers_for_phase (widget, GTK_PHASE_TARGET) ||
+      gtk_widget_has_controllers_for_phase (widget, GTK_PHASE_BUBBLE))
+    {
+      event_copy = gdk_event_copy (event);
 
-  translate_event_coordinates (event_copy, widget);
+      translate_event_coordinates (event_copy, widget);
 
-  if (widget == gtk_get_event_target (event_copy))
-    return_val |= _gtk_widget_run_controllers (widget, event_copy, GTK_PHASE_TARGET);
+      if (widget == gtk_get_event_target (event_copy))
+        return_val |= _gtk_widget_run_controllers (widget, event_copy, GTK_PHASE_TARGET);
 
-  if (return_val == FALSE)
-    return_val |= _gtk_widget_run_controllers (widget, event_copy, GTK_PHASE_BUBBLE);
-  g_object_unref (event_copy);
+      if (return_val == FALSE)
+        return_val |= _gtk_widget_run_controllers (widget, event_copy, GTK_PHASE_BUBBLE);
+      g_object_unref (event_copy);
+    }
 
   if (return_val == FALSE &&
       (event->any.type == GDK_KEY_PRESS ||
@@ -5703,6 +6062,58 @@ gtk_widget_get_focus_on_click (GtkWidget *widget)
   return priv->focus_on_click;
 }
 
+/**
+ * gtk_widget_set_cache_rendering:
+ * @widget: a #GtkWidget
+ * @cache_rendering: whether the rendering of @widget should be cached
+ *
+ * Sets whether renderers should keep the rendering of the widget, including
+ * its children, around as a texture and draw that for as long as the widget
+ * doesn’t change, instead of drawing its contents again every frame.
+ *
+ * This is useful for complex parts of the user interface that rarely
+ * change, but it costs video memory and makes every change to the widget
+ * or its children more expensive. Renderers are free to ignore it.
+ **/
+void
+gtk_widget_set_cache_rendering (GtkWidget *widget,
+                                gboolean   cache_rendering)
+{
+  GtkWidgetPrivate *priv = gtk_widget_get_instance_private (widget);
+
+  g_return_if_fail (GTK_IS_WIDGET (widget));
+
+  cache_rendering = cache_rendering != FALSE;
+
+  if (priv->cache_rendering != cache_rendering)
+    {
+      priv->cache_rendering = cache_rendering;
+
+      gtk_widget_queue_draw (widget);
+
+      g_object_notify_by_pspec (G_OBJECT (widget), widget_props[PROP_CACHE_RENDERING]);
+    }
+}
+
+/**
+ * gtk_widget_get_cache_rendering:
+ * @widget: a #GtkWidget
+ *
+ * Returns whether the rendering of the widget is cached.
+ * See gtk_widget_set_cache_rendering().
+ *
+ * Returns: %TRUE if the rendering of @widget is cached
+ **/
+gboolean
+gtk_widget_get_cache_rendering (GtkWidget *widget)
+{
+  GtkWidgetPrivate *priv = gtk_widget_get_instance_private (widget);
+
+  g_return_val_if_fail (GTK_IS_WIDGET (widget), FALSE);
+
+  return priv->cache_rendering;
+}
+
 
 /**
  * gtk_widget_set_can_default:
@@ -6493,6 +6904,7 @@ gtk_widget_reposition_after (GtkWidget *widget,
   gtk_widget_push_verify_invariants (widget);
 
   priv->parent = parent;
+  gtk_widget_invalidate_pick_index (parent);
 
   if (previous_sibling)
     {
@@ -8365,6 +8777,10 @@ gtk_widget_finalize (GObject *object)
 
   _gtk_size_request_cache_free (&priv->requests);
 
+  g_clear_pointer (&priv->pick_index, gtk_pick_index_free);
+
+  gtk_widget_clear_render_node (widget);
+
   l = priv->event_controllers;
   while (l)
     {
@@ -11767,6 +12183,272 @@ gtk_widget_ensure_allocate (GtkWidget *widget)
     }
 }
 
+/*
+ * gtk_widget_set_layout_profiling:
+ * @enabled: whether to collect layout statistics
+ *
+ * Turns on collecting the number of measure and allocate calls
+ * and the time spent in them for each widget, see
+ * gtk_widget_peek_layout_stats(). This is used by the inspector
+ * and GTK_DEBUG=layout.
+ */
+void
+gtk_widget_set_layout_profiling (gboolean enabled)
+{
+  layout_profiling = enabled;
+}
+
+gboolean
+gtk_widget_get_layout_profiling (void)
+{
+  return layout_profiling;
+}
+
+/* Called when a layout phase starts, statistics of
+ * earlier frames get reset when they are next updated. */
+void
+gtk_widget_set_layout_frame (gint64 frame)
+{
+  layout_frame = frame;
+}
+
+void
+gtk_widget_add_layout_stats (GtkWidget *widget,
+                             gboolean   allocate,
+                             gint64     time)
+{
+  GtkWidgetLayoutStats *stats;
+
+  stats = g_object_get_qdata (G_OBJECT (widget), quark_layout_stats);
+  if (stats == NULL)
+    {
+      stats = g_new0 (GtkWidgetLayoutStats, 1);
+      stats->frame = layout_frame;
+      g_object_set_qdata_full (G_OBJECT (widget), quark_layout_stats, stats, g_free);
+    }
+  else if (stats->frame != layout_frame)
+    {
+      memset (stats, 0, sizeof (GtkWidgetLayoutStats));
+      stats->frame = layout_frame;
+    }
+
+  if (allocate)
+    {
+      stats->n_allocate++;
+      stats->allocate_time += time;
+    }
+  else
+    {
+      stats->n_measure++;
+      stats->measure_time += time;
+    }
+}
+
+/*
+ * gtk_widget_peek_layout_stats:
+ * @widget: a #GtkWidget
+ *
+ * Returns: (nullable): the layout statistics of the last frame
+ *     @widget was measured or allocated in while profiling
+ *     was enabled
+ */
+const GtkWidgetLayoutStats *
+gtk_widget_peek_layout_stats (GtkWidget *widget)
+{
+  return g_object_get_qdata (G_OBJECT (widget), quark_layout_stats);
+}
+
+/* Counts of queued draws and resizes in whole seconds of
+ * monotonic time, for the current and the previous second */
+typedef struct {
+  gint64 second;
+  guint  n_draws;
+  guint  n_resizes;
+  guint  prev_n_draws;
+  guint  prev_n_resizes;
+} GtkWidgetInvalidations;
+
+/*
+ * gtk_widget_set_frame_profiling:
+ * @enabled: whether to collect frame statistics
+ *
+ * Turns on collecting the time spent in each phase and the renderer
+ * statistics for the frames of all toplevels, see
+ * gtk_widget_get_frame_stats(), and counting the draws and resizes
+ * widgets queue, see gtk_widget_get_invalidations(). This is used
+ * by the inspector.
+ */
+void
+gtk_widget_set_frame_profiling (gboolean enabled)
+{
+  frame_profiling = enabled;
+}
+
+static void
+gtk_widget_add_frame_stats (GtkWidget   *widget,
+                            GskRenderer *renderer,
+                            gint64       snapshot_time)
+{
+  GtkFrameStats *stats;
+  GdkFrameClock *frame_clock;
+  GdkFrameTimings *timings;
+  GVariant *statistics;
+
+  stats = &frame_stats[n_frame_stats % N_FRAME_STATS];
+  memset (stats, 0, sizeof (GtkFrameStats));
+
+  stats->toplevel = widget;
+  stats->time = g_get_monotonic_time ();
+  stats->snapshot = snapshot_time;
+
+  frame_clock = gtk_widget_get_frame_clock (widget);
+  timings = frame_clock ? gdk_frame_clock_get_current_timings (frame_clock) : NULL;
+  if (timings)
+    {
+      stats->frame = timings->frame_counter;
+      stats->events = timings->events_duration;
+      stats->update = timings->update_duration;
+      stats->style = timings->style_duration;
+      stats->layout = MAX (0, timings->layout_duration - timings->style_duration);
+    }
+
+  statistics = gsk_renderer_get_statistics (renderer);
+  g_variant_lookup (statistics, "cpu-time", "x", &stats->render);
+  g_variant_lookup (statistics, "gpu-time", "x", &stats->gpu);
+  g_variant_lookup (statistics, "upload-bytes", "x", &stats->upload_bytes);
+  g_variant_lookup (statistics, "fallback-nodes", "x", &stats->fallback_nodes);
+  g_variant_lookup (statistics, "offscreens", "x", &stats->offscreens);
+  g_variant_unref (statistics);
+
+  /* the renderer measures in ns */
+  stats->render /= 1000;
+  stats->gpu /= 1000;
+
+  n_frame_stats++;
+}
+
+/*
+ * gtk_widget_get_frame_stats:
+ * @stats: (out caller-allocates): an array to fill
+ * @n_stats: the size of @stats
+ *
+ * Copies the statistics of up to @n_stats of the last frames drawn
+ * while frame profiling was enabled, oldest first.
+ *
+ * Returns: the number of frames copied to @stats
+ */
+guint
+gtk_widget_get_frame_stats (GtkFrameStats *stats,
+                            guint          n_stats)
+{
+  guint i, n;
+
+  n = MIN (MIN (n_stats, N_FRAME_STATS), n_frame_stats);
+
+  for (i = 0; i < n; i++)
+    stats[i] = frame_stats[(n_frame_stats - n + i) % N_FRAME_STATS];
+
+  return n;
+}
+
+static void
+gtk_widget_add_invalidation (GtkWidget *widget,
+                             gboolean   resize)
+{
+  GtkWidgetInvalidations *inv;
+  gint64 second;
+
+  second = g_get_monotonic_time () / G_USEC_PER_SEC;
+
+  inv = g_object_get_qdata (G_OBJECT (widget), quark_invalidations);
+  if (inv == NULL)
+    {
+      inv = g_new0 (GtkWidgetInvalidations, 1);
+      inv->second = second;
+      g_object_set_qdata_full (G_OBJECT (widget), quark_invalidations, inv, g_free);
+    }
+  else if (inv->second != second)
+    {
+      if (inv->second == second - 1)
+        {
+          inv->prev_n_draws = inv->n_draws;
+          inv->prev_n_resizes = inv->n_resizes;
+        }
+      else
+        {
+          inv->prev_n_draws = 0;
+          inv->prev_n_resizes = 0;
+        }
+      inv->n_draws = 0;
+      inv->n_resizes = 0;
+      inv->second = second;
+    }
+
+  if (resize)
+    inv->n_resizes++;
+  else
+    inv->n_draws++;
+}
+
+/*
+ * gtk_widget_get_invalidations:
+ * @widget: a #GtkWidget
+ * @n_draws: (out): return location for the number of queued draws
+ * @n_resizes: (out): return location for the number of queued resizes
+ *
+ * Gets how often @widget queued a draw or a resize in the last
+ * complete second while frame profiling was enabled.
+ */
+void
+gtk_widget_get_invalidations (GtkWidget *widget,
+                              guint     *n_draws,
+                              guint     *n_resizes)
+{
+  GtkWidgetInvalidations *inv;
+  gint64 second;
+
+  *n_draws = 0;
+  *n_resizes = 0;
+
+  inv = g_object_get_qdata (G_OBJECT (widget), quark_invalidations);
+  if (inv == NULL)
+    return;
+
+  second = g_get_monotonic_time () / G_USEC_PER_SEC;
+  if (inv->second == second)
+    {
+      *n_draws = inv->prev_n_draws;
+      *n_resizes = inv->prev_n_resizes;
+    }
+  else if (inv->second == second - 1)
+    {
+      *n_draws = inv->n_draws;
+      *n_resizes = inv->n_resizes;
+    }
+}
+
+/*
+ * gtk_widget_set_parent_is_relayout_boundary:
+ * @widget: a #GtkWidget
+ * @boundary: whether the size request of @widget's parent is
+ *     independent of @widget's
+ *
+ * Containers whose size doesn't depend on a child's size, like a
+ * scrolled window with scrollbars, use this so that resizes queued
+ * in the child only reallocate the container instead of remeasuring
+ * all its ancestors.
+ *
+ * The flag is reset when @widget is unparented.
+ */
+void
+gtk_widget_set_parent_is_relayout_boundary (GtkWidget *widget,
+                                            gboolean   boundary)
+{
+  GtkWidgetPrivate *priv = gtk_widget_get_instance_private (widget);
+
+  priv->parent_is_relayout_boundary = !!boundary;
+}
+
 void
 gtk_widget_ensure_resize (GtkWidget *widget)
 {
@@ -12232,6 +12914,7 @@ template_data_free (GtkWidgetTemplate *template_data)
   if (template_data)
     {
       g_bytes_unref (template_data->data);
+      g_clear_pointer (&template_data->precompiled, g_bytes_unref);
       g_slist_free_full (template_data->children, (GDestroyNotify)template_child_class_free);
       g_slist_free_full (template_data->callbacks, (GDestroyNotify)callback_symbol_free);
 
@@ -12370,13 +13053,27 @@ gtk_widget_init_template (GtkWidget *widget)
       gtk_builder_add_callback_symbol (builder, callback->callback_name, callback->callback_symbol);
     }
 
+  /* Parse the XML only for the first instance, and replay the
+   * result for all the others. If the template can't be parsed,
+   * we keep using the XML to get the error below.
+   */
+  if (template->precompiled == NULL)
+    {
+      template->precompiled = _gtk_builder_precompile (builder,
+                                                       g_bytes_get_data (template->data, NULL),
+                                                       g_bytes_get_size (template->data),
+                                                       NULL);
+      if (template->precompiled == NULL)
+        template->precompiled = g_bytes_ref (template->data);
+    }
+
   /* This will build the template XML as children to the widget instance, also it
    * will validate that the template is created for the correct GType and assert that
    * there is no infinite recursion.
    */
   if (!gtk_builder_extend_with_template  (builder, widget, class_type,
-					  (const gchar *)g_bytes_get_data (template->data, NULL),
-					  g_bytes_get_size (template->data),
+					  (const gchar *)g_bytes_get_data (template->precompiled, NULL),
+					  g_bytes_get_size (template->precompiled),
 					  &error))
     {
       g_critical ("Error building template class '%s' for an instance of type '%s': %s",
@@ -12756,6 +13453,7 @@ gtk_widget_add_controller (GtkWidget          *widget,
   GTK_EVENT_CONTROLLER_GET_CLASS (controller)->set_widget (controller, widget);
 
   priv->event_controllers = g_list_prepend (priv->event_controllers, controller);
+  priv->controller_phases_valid = FALSE;
 
   if (priv->controller_observer)
     gtk_list_list_model_item_added_at (priv->controller_observer, 0);
@@ -12788,6 +13486,7 @@ gtk_widget_remove_controller (GtkWidget          *widget,
   list = g_list_find (priv->event_controllers, controller);
   before = list->prev;
   priv->event_controllers = g_list_delete_link (priv->event_controllers, list);
+  priv->controller_phases_valid = FALSE;
   g_object_unref (controller);
 
   if (priv->controller_observer)
@@ -12844,6 +13543,22 @@ gtk_widget_reset_controllers (GtkWidget *widget)
     }
 }
 
+typedef struct {
+  GtkWidget *child;
+  GskRenderNode *node; /* owned by the parent's render node */
+} GtkWidgetChildNode;
+
+/* The widget whose render node is currently being created, and the
+ * array its children's nodes are recorded into */
+static GtkWidget *snapshot_recorder = NULL;
+static GArray *snapshot_recorder_nodes = NULL;
+
+/* The widget gtk_widget_render() is drawing and the area that changed
+ * in the frame, as far as widgets know it */
+static GtkWidget *render_root = NULL;
+static cairo_region_t *render_damage = NULL;
+static gboolean render_damage_exact = FALSE;
+
 static inline void
 gtk_widget_maybe_add_debug_render_nodes (GtkWidget             *widget,
                                          GtkSnapshot           *snapshot)
@@ -12975,32 +13690,252 @@ gtk_widget_create_render_node (GtkWidget   *widget,
   return gtk_snapshot_free_to_node (snapshot);
 }
 
-void
-gtk_widget_snapshot (GtkWidget   *widget,
-                     GtkSnapshot *snapshot)
+/* Computes where @widget's render node ends up in the node of the
+ * widget that draws its surface. */
+static gboolean
+gtk_widget_get_render_offset (GtkWidget  *widget,
+                              GtkWidget **root,
+                              int        *x,
+                              int        *y)
+{
+  *x = *y = 0;
+
+  while (!_gtk_widget_get_has_surface (widget))
+    {
+      GtkWidgetPrivate *priv = gtk_widget_get_instance_private (widget);
+      GtkWidgetPrivate *parent_priv;
+      GtkBorder margin, border, padding;
+      GtkCssStyle *style;
+
+      if (priv->parent == NULL)
+        return FALSE;
+
+      /* Children are drawn relative to the parent's content box */
+      parent_priv = gtk_widget_get_instance_private (priv->parent);
+      style = gtk_css_node_get_style (parent_priv->cssnode);
+      get_box_margin (style, &margin);
+      get_box_border (style, &border);
+      get_box_padding (style, &padding);
+
+      *x += priv->allocation.x + margin.left + border.left + padding.left;
+      *y += priv->allocation.y + margin.top + border.top + padding.top;
+
+      widget = priv->parent;
+    }
+
+  *root = widget;
+
+  return TRUE;
+}
+
+static void
+gtk_widget_get_render_node_damage (GskRenderNode         *node,
+                                   int                    x,
+                                   int                    y,
+                                   cairo_rectangle_int_t *rect)
+{
+  graphene_rect_t bounds;
+
+  gsk_render_node_get_bounds (node, &bounds);
+
+  rect->x = floorf (bounds.origin.x) + x;
+  rect->y = floorf (bounds.origin.y) + y;
+  rect->width = ceilf (bounds.origin.x + bounds.size.width) + x - rect->x;
+  rect->height = ceilf (bounds.origin.y + bounds.size.height) + y - rect->y;
+}
+
+/* Adds the area @widget covered in the last frame to the update area of
+ * its surface, so the renderer doesn't have to find it by diffing. */
+static void
+gtk_widget_damage_render_node (GtkWidget *widget)
 {
   GtkWidgetPrivate *priv = gtk_widget_get_instance_private (widget);
+  cairo_rectangle_int_t rect;
+  GtkWidget *root;
+  int x, y;
 
-  if (!_gtk_widget_is_drawable (widget))
+  if (priv->render_node == NULL)
     return;
 
+  if (!gtk_widget_get_render_offset (widget, &root, &x, &y))
+    return;
+
+  if (!_gtk_widget_get_realized (root))
+    return;
+
+  gtk_widget_get_render_node_damage (priv->render_node, x, y, &rect);
+  gdk_surface_invalidate_rect (gtk_widget_get_surface (root), &rect);
+}
+
+/* Adds the area of a newly created render node to the damage of the
+ * frame that gtk_widget_render() is currently drawing. */
+static void
+gtk_widget_add_render_damage (GtkWidget     *widget,
+                              GskRenderNode *node)
+{
+  cairo_rectangle_int_t rect;
+  GtkWidget *root;
+  int x, y;
+
+  if (render_damage == NULL || node == NULL)
+    return;
+
+  if (!gtk_widget_get_render_offset (widget, &root, &x, &y) ||
+      root != render_root)
+    {
+      render_damage_exact = FALSE;
+      return;
+    }
+
+  gtk_widget_get_render_node_damage (node, x, y, &rect);
+  cairo_region_union_rectangle (render_damage, &rect);
+}
+
+/* Called from gtk_widget_snapshot() when only children of @widget need
+ * to be drawn again. Swaps their new render nodes into our existing
+ * one instead of calling our snapshot() again, which would also ask
+ * every unchanged sibling for its node. Returns %FALSE if that isn't
+ * possible and @widget needs to be drawn again from scratch.
+ */
+static gboolean
+gtk_widget_update_child_render_nodes (GtkWidget   *widget,
+                                      GtkSnapshot *snapshot)
+{
+  GtkWidgetPrivate *priv = gtk_widget_get_instance_private (widget);
+  GHashTable *replacements;
+  GskRenderNode *render_node;
+  GtkWidget *child;
+  guint i, n_changed, n_replaced;
+
+  if (priv->render_node == NULL || priv->child_render_nodes == NULL)
+    return FALSE;
+
+  /* Every child that changed must have been drawn by us last time */
+  for (child = _gtk_widget_get_first_child (widget);
+       child != NULL;
+       child = _gtk_widget_get_next_sibling (child))
+    {
+      GtkWidgetPrivate *child_priv = gtk_widget_get_instance_private (child);
+
+      if (!child_priv->draw_needed && !child_priv->child_draw_needed)
+        continue;
+
+      for (i = 0; i < priv->child_render_nodes->len; i++)
+        {
+          if (g_array_index (priv->child_render_nodes, GtkWidgetChildNode, i).child == child)
+            break;
+        }
+
+      if (i == priv->child_render_nodes->len)
+        return FALSE;
+    }
+
+  replacements = g_hash_table_new (NULL, NULL);
+  n_changed = 0;
+
+  for (i = 0; i < priv->child_render_nodes->len; i++)
+    {
+      GtkWidgetChildNode *entry = &g_array_index (priv->child_render_nodes, GtkWidgetChildNode, i);
+      GtkWidgetPrivate *child_priv = gtk_widget_get_instance_private (entry->child);
+
+      if (g_hash_table_contains (replacements, entry->node))
+        continue;
+
+      if (!gtk_widget_ensure_render_node (entry->child, snapshot) ||
+          child_priv->render_node == NULL)
+        {
+          g_hash_table_unref (replacements);
+          return FALSE;
+        }
+
+      g_hash_table_insert (replacements, entry->node, child_priv->render_node);
+      if (child_priv->render_node != entry->node)
+        n_changed++;
+    }
+
+  if (n_changed == 0)
+    {
+      g_hash_table_unref (replacements);
+      return TRUE;
+    }
+
+  render_node = gsk_render_node_replace_nodes (priv->render_node, replacements, &n_replaced);
+  /* GtkSnapshot may have unwrapped a child's node while building ours */
+  if (n_replaced != n_changed)
+    {
+      gsk_render_node_unref (render_node);
+      g_hash_table_unref (replacements);
+      return FALSE;
+    }
+
+  for (i = 0; i < priv->child_render_nodes->len; i++)
+    {
+      GtkWidgetChildNode *entry = &g_array_index (priv->child_render_nodes, GtkWidgetChildNode, i);
+
+      entry->node = g_hash_table_lookup (replacements, entry->node);
+    }
+  g_hash_table_unref (replacements);
+
+  if (priv->cache_rendering)
+    gsk_render_node_set_cache_hint (render_node, TRUE);
+
+  gsk_render_node_unref (priv->render_node);
+  priv->render_node = render_node;
+
+  gtk_widget_update_paintables (widget);
+
+  return TRUE;
+}
+
+static gboolean
+gtk_widget_ensure_render_node (GtkWidget   *widget,
+                               GtkSnapshot *snapshot)
+{
+  GtkWidgetPrivate *priv = gtk_widget_get_instance_private (widget);
+
+  if (!_gtk_widget_is_drawable (widget))
+    return FALSE;
+
   if (_gtk_widget_get_alloc_needed (widget))
     {
       g_warning ("Trying to snapshot %s %p without a current allocation", G_OBJECT_TYPE_NAME (widget), widget);
-      return;
+      return FALSE;
+    }
+
+  if (!priv->draw_needed && priv->child_draw_needed)
+    {
+      if (!gtk_widget_update_child_render_nodes (widget, snapshot))
+        priv->draw_needed = TRUE;
     }
 
   if (priv->draw_needed)
     {
       GskRenderNode *render_node;
+      GtkWidget *old_recorder;
+      GArray *old_recorder_nodes;
+      GArray *child_render_nodes;
 
       gtk_widget_push_paintables (widget);
 
+      child_render_nodes = g_array_new (FALSE, FALSE, sizeof (GtkWidgetChildNode));
+      old_recorder = snapshot_recorder;
+      old_recorder_nodes = snapshot_recorder_nodes;
+      snapshot_recorder = widget;
+      snapshot_recorder_nodes = child_render_nodes;
+
       render_node = gtk_widget_create_render_node (widget, snapshot);
+
+      snapshot_recorder = old_recorder;
+      snapshot_recorder_nodes = old_recorder_nodes;
+
+      if (render_node && priv->cache_rendering)
+        gsk_render_node_set_cache_hint (render_node, TRUE);
       /* This can happen when nested drawing happens and a widget contains itself
        * or when we replace a clipped area */
-      g_clear_pointer (&priv->render_node, gsk_render_node_unref);
+      gtk_widget_clear_render_node (widget);
       priv->render_node = render_node;
+      priv->child_render_nodes = child_render_nodes;
+      gtk_widget_add_render_damage (widget, render_node);
 
       priv->draw_needed = FALSE;
 
@@ -13008,8 +13943,31 @@ gtk_widget_snapshot (GtkWidget   *widget,
       gtk_widget_update_paintables (widget);
     }
 
+  priv->child_draw_needed = FALSE;
+
+  return TRUE;
+}
+
+void
+gtk_widget_snapshot (GtkWidget   *widget,
+                     GtkSnapshot *snapshot)
+{
+  GtkWidgetPrivate *priv = gtk_widget_get_instance_private (widget);
+
+  if (!gtk_widget_ensure_render_node (widget, snapshot))
+    return;
+
   if (priv->render_node)
-    gtk_snapshot_append_node (snapshot, priv->render_node);
+    {
+      if (snapshot_recorder != NULL && priv->parent == snapshot_recorder)
+        {
+          GtkWidgetChildNode entry = { widget, priv->render_node };
+
+          g_array_append_val (snapshot_recorder_nodes, entry);
+        }
+
+      gtk_snapshot_append_node (snapshot, priv->render_node);
+    }
 }
 
 void
@@ -13019,7 +13977,10 @@ gtk_widget_render (GtkWidget            *widget,
 {
   GtkSnapshot *snapshot;
   GskRenderer *renderer;
-  GskRenderNode *root;
+  GskRenderNode *root, *prepared;
+  cairo_region_t *damage;
+  gboolean damage_exact;
+  gint64 before, snapshot_time;
 
   /* We only render double buffered on native windows */
   if (!gdk_surface_has_native (surface))
@@ -13029,22 +13990,45 @@ gtk_widget_render (GtkWidget            *widget,
   if (renderer == NULL)
     return;
 
+  /* The update area contains the old areas of all widgets that were
+   * queued for drawing, the new ones get added while snapshotting. */
+  damage = cairo_region_copy (region);
+  render_root = widget;
+  render_damage = damage;
+  render_damage_exact = TRUE;
+
+  before = g_get_monotonic_time ();
   snapshot = gtk_snapshot_new ();
   gtk_widget_snapshot (widget, snapshot);
   root = gtk_snapshot_free_to_node (snapshot);
+  gdk_profiler_end_mark (before * 1000, "snapshot", G_OBJECT_TYPE_NAME (widget));
+  snapshot_time = g_get_monotonic_time () - before;
+
+  damage_exact = render_damage_exact;
+  render_root = NULL;
+  render_damage = NULL;
 
   if (root != NULL)
     {
-      root = gtk_inspector_prepare_render (widget,
-                                           renderer,
-                                           surface,
-                                           region,
-                                           root);
+      prepared = gtk_inspector_prepare_render (widget,
+                                               renderer,
+                                               surface,
+                                               region,
+                                               root);
 
-      gsk_renderer_render (renderer, root, region);
+      /* The inspector may draw on top, which widgets don't know about */
+      if (damage_exact && prepared == root)
+        gsk_renderer_render_damage (renderer, prepared, damage);
+      else
+        gsk_renderer_render (renderer, prepared, damage);
+
+      if (G_UNLIKELY (frame_profiling))
+        gtk_widget_add_frame_stats (widget, renderer, snapshot_time);
 
-      gsk_render_node_unref (root);
+      gsk_render_node_unref (prepared);
     }
+
+  cairo_region_destroy (damage);
 }
 
 static void
@@ -484,6 +484,11 @@ void       gtk_widget_set_focus_on_click  (GtkWidget           *widget,
                                            gboolean             focus_on_click);
 GDK_AVAILABLE_IN_ALL
 gboolean   gtk_widget_get_focus_on_click  (GtkWidget           *widget);
+GDK_AVAILABLE_IN_ALL
+void       gtk_widget_set_cache_rendering (GtkWidget           *widget,
+                                           gboolean             cache_rendering);
+GDK_AVAILABLE_IN_ALL
+gboolean   gtk_widget_get_cache_rendering (GtkWidget           *widget);
 
 GDK_AVAILABLE_IN_ALL
 void       gtk_widget_set_can_default     (GtkWidget           *widget,
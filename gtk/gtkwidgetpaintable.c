@@ -259,20 +259,42 @@ gtk_widget_paintable_new (GtkWidget *widget)
                        NULL);
 }
 
-static GdkPaintable *
-gtk_widget_paintable_snapshot_widget (GtkWidgetPaintable *self)
+/* Creates the image of @widget's current render node. The image is
+ * shared by all the paintables observing @widget.
+ */
+GdkPaintable *
+gtk_widget_paintable_snapshot_widget (GtkWidget *widget)
 {
   graphene_rect_t bounds;
 
-  if (self->widget == NULL)
+  if (widget == NULL)
     return gdk_paintable_new_empty (0, 0);
 
-  gtk_widget_compute_bounds (self->widget, self->widget, &bounds);
+  gtk_widget_compute_bounds (widget, widget, &bounds);
 
-  if (self->widget->priv->render_node == NULL)
+  if (widget->priv->render_node == NULL)
     return gdk_paintable_new_empty (bounds.size.width, bounds.size.height);
   
-  return gtk_render_node_paintable_new (self->widget->priv->render_node, &bounds);
+  return gtk_render_node_paintable_new (widget->priv->render_node, &bounds);
+}
+
+static gboolean
+gtk_widget_paintable_images_equal (GdkPaintable *image1,
+                                   GdkPaintable *image2)
+{
+  if (image1 == image2)
+    return TRUE;
+
+  if (gdk_paintable_get_intrinsic_width (image1) != gdk_paintable_get_intrinsic_width (image2) ||
+      gdk_paintable_get_intrinsic_height (image1) != gdk_paintable_get_intrinsic_height (image2))
+    return FALSE;
+
+  if (GTK_IS_RENDER_NODE_PAINTABLE (image1) && GTK_IS_RENDER_NODE_PAINTABLE (image2))
+    return gtk_render_node_paintable_get_render_node (GTK_RENDER_NODE_PAINTABLE (image1)) ==
+           gtk_render_node_paintable_get_render_node (GTK_RENDER_NODE_PAINTABLE (image2));
+
+  /* both empty */
+  return !GTK_IS_RENDER_NODE_PAINTABLE (image1) && !GTK_IS_RENDER_NODE_PAINTABLE (image2);
 }
 
 /**
@@ -328,7 +350,7 @@ gtk_widget_paintable_set_widget (GtkWidgetPaintable *self,
     }
 
   g_object_unref (self->current_image);
-  self->current_image = gtk_widget_paintable_snapshot_widget (self);
+  self->current_image = gtk_widget_paintable_snapshot_widget (widget);
   g_clear_object (&self->pending_image);
   if (self->pending_update_cb)
     {
@@ -371,10 +393,16 @@ gtk_widget_paintable_update_func (gpointer data)
   return G_SOURCE_REMOVE;
 }
 
+/* @image is the result of gtk_widget_paintable_snapshot_widget() */
 void
-gtk_widget_paintable_update_image (GtkWidgetPaintable *self)
+gtk_widget_paintable_update_image (GtkWidgetPaintable *self,
+                                   GdkPaintable       *image)
 {
-  GdkPaintable *pending_image;
+  /* Allocating a widget without drawing it changes nothing, so
+   * don't make the consumers redraw */
+  if (gtk_widget_paintable_images_equal (self->pending_image ? self->pending_image : self->current_image,
+                                         image))
+    return;
 
   if (self->pending_update_cb == 0)
     {
@@ -384,9 +412,7 @@ gtk_widget_paintable_update_image (GtkWidgetPaintable *self)
                                                  NULL);
     }
 
-  pending_image = gtk_widget_paintable_snapshot_widget (self);
-  g_set_object (&self->pending_image, pending_image);
-  g_object_unref (pending_image);
+  g_set_object (&self->pending_image, image);
 }
 
 void
@@ -23,7 +23,9 @@
 #include "gtkwidgetpaintable.h"
 
 
-void            gtk_widget_paintable_update_image               (GtkWidgetPaintable     *self);
+GdkPaintable *  gtk_widget_paintable_snapshot_widget            (GtkWidget              *widget);
+void            gtk_widget_paintable_update_image               (GtkWidgetPaintable     *self,
+                                                                 GdkPaintable           *image);
 
 void            gtk_widget_paintable_push_snapshot_count        (GtkWidgetPaintable     *self);
 void            gtk_widget_paintable_pop_snapshot_count         (GtkWidgetPaintable     *self);
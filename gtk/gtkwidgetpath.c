@@ -329,6 +329,59 @@ gtk_widget_path_to_string (const GtkWidgetPath *path)
   return g_string_free (string, FALSE);
 }
 
+/* Compares everything style matching looks at, unlike
+ * gtk_widget_path_to_string(), which is meant for humans */
+guint
+gtk_widget_path_hash (const GtkWidgetPath *path)
+{
+  guint i, hash;
+
+  hash = path->elems->len;
+
+  for (i = 0; i < path->elems->len; i++)
+    {
+      GtkPathElement *elem = &g_array_index (path->elems, GtkPathElement, i);
+
+      hash = hash * 31 + gtk_css_node_declaration_hash (elem->decl);
+      if (elem->siblings)
+        hash = hash * 31 + elem->sibling_index + gtk_widget_path_hash (elem->siblings);
+    }
+
+  return hash;
+}
+
+gboolean
+gtk_widget_path_equal (const GtkWidgetPath *path1,
+                       const GtkWidgetPath *path2)
+{
+  guint i;
+
+  if (path1 == path2)
+    return TRUE;
+
+  if (path1->elems->len != path2->elems->len)
+    return FALSE;
+
+  for (i = 0; i < path1->elems->len; i++)
+    {
+      GtkPathElement *elem1 = &g_array_index (path1->elems, GtkPathElement, i);
+      GtkPathElement *elem2 = &g_array_index (path2->elems, GtkPathElement, i);
+
+      if (!gtk_css_node_declaration_equal (elem1->decl, elem2->decl))
+        return FALSE;
+
+      if ((elem1->siblings == NULL) != (elem2->siblings == NULL))
+        return FALSE;
+
+      if (elem1->siblings &&
+          (elem1->sibling_index != elem2->sibling_index ||
+           !gtk_widget_path_equal (elem1->siblings, elem2->siblings)))
+        return FALSE;
+    }
+
+  return TRUE;
+}
+
 /**
  * gtk_widget_path_prepend_type:
  * @path: a #GtkWidgetPath
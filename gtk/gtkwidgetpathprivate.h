@@ -26,6 +26,10 @@ void gtk_widget_path_iter_add_qclass (GtkWidgetPath *path,
                                       gint           pos,
                                       GQuark         qname);
 
+guint    gtk_widget_path_hash  (const GtkWidgetPath *path);
+gboolean gtk_widget_path_equal (const GtkWidgetPath *path1,
+                                const GtkWidgetPath *path2);
+
 G_END_DECLS
 
 #endif /* __GTK_WIDGET_PATH_PRIVATE_H__ */
@@ -32,6 +32,7 @@
 #include "gtkcsstypesprivate.h"
 #include "gtkeventcontroller.h"
 #include "gtklistlistmodelprivate.h"
+#include "gtkpickindexprivate.h"
 #include "gtksizerequestcacheprivate.h"
 #include "gtkwindowprivate.h"
 #include "gtkinvisible.h"
@@ -74,14 +75,22 @@ struct _GtkWidgetPrivate
   guint child_visible         : 1;
   guint multidevice           : 1;
   guint pass_through          : 1;
+  guint cache_rendering       : 1;
+
+  /* 1 << GtkPropagationPhase for the phases event_controllers
+   * has controllers for, only valid if controller_phases_valid */
+  guint controller_phases       : 4;
+  guint controller_phases_valid : 1;
 
   /* Queue-resize related flags */
   guint resize_needed         : 1; /* queue_resize() has been called but no get_preferred_size() yet */
   guint alloc_needed          : 1; /* this widget needs a size_allocate() call */
   guint alloc_needed_on_child : 1; /* 0 or more children - or this widget - need a size_allocate() call */
+  guint parent_is_relayout_boundary : 1; /* our size request can't change the parent's */
 
   /* Queue-draw related flags */
   guint draw_needed           : 1;
+  guint child_draw_needed     : 1; /* only descendants need to be drawn again */
   /* Expand-related flags */
   guint need_compute_expand   : 1; /* Need to recompute computed_[hv]_expand */
   guint computed_hexpand      : 1; /* computed results (composite of child flags) */
@@ -112,7 +121,7 @@ struct _GtkWidgetPrivate
   GtkBorder margin;
 
   /* Animations and other things to update on clock ticks */
-  guint clock_tick_id;
+  guint clock_tick_registered : 1; /* in the tick dispatcher of the frame clock */
   GList *tick_callbacks;
 
   /* The widget's name. If the widget does not have a name
@@ -148,6 +157,9 @@ struct _GtkWidgetPrivate
 
   /* The render node we draw or %NULL if not yet created.*/
   GskRenderNode *render_node;
+  /* The render nodes of our children that were drawn into render_node,
+   * so they can be swapped out without calling our snapshot() again */
+  GArray *child_render_nodes;
 
   GSList *paintables;
 
@@ -174,6 +186,9 @@ struct _GtkWidgetPrivate
 
   GtkWidget *focus_child;
 
+  /* only set for containers that opted in, see gtk_widget_set_use_pick_index() */
+  GtkPickIndex *pick_index;
+
   /* Pointer cursor */
   GdkCursor *cursor;
 };
@@ -191,6 +206,53 @@ gboolean     _gtk_widget_get_alloc_needed   (GtkWidget *widget);
 gboolean     gtk_widget_needs_allocate      (GtkWidget *widget);
 void         gtk_widget_ensure_resize       (GtkWidget *widget);
 void         gtk_widget_ensure_allocate     (GtkWidget *widget);
+void         gtk_widget_invalidate_controller_phases (GtkWidget *widget);
+void         gtk_widget_set_use_pick_index  (GtkWidget *widget,
+                                             gboolean   use_pick_index);
+typedef struct {
+  gint64 frame;            /* frame counter of the frame these belong to */
+  guint  n_measure;        /* gtk_widget_measure() calls, cached or not */
+  gint64 measure_time;     /* in µs, including children */
+  guint  n_allocate;
+  gint64 allocate_time;    /* in µs, including children */
+} GtkWidgetLayoutStats;
+
+void         gtk_widget_premeasure_children  (GtkWidget *widget);
+
+void         gtk_widget_set_layout_profiling (gboolean enabled);
+gboolean     gtk_widget_get_layout_profiling (void);
+void         gtk_widget_set_layout_frame     (gint64    frame);
+void         gtk_widget_add_layout_stats     (GtkWidget *widget,
+                                              gboolean   allocate,
+                                              gint64     time);
+const GtkWidgetLayoutStats *
+             gtk_widget_peek_layout_stats    (GtkWidget *widget);
+
+typedef struct {
+  gconstpointer toplevel;  /* only for comparing, it may be gone */
+  gint64 frame;            /* frame counter */
+  gint64 time;             /* monotonic time when it was drawn */
+  gint64 events;           /* all durations in µs */
+  gint64 update;
+  gint64 style;
+  gint64 layout;           /* without style */
+  gint64 snapshot;
+  gint64 render;           /* CPU time of the renderer */
+  gint64 gpu;              /* may be of an earlier frame */
+  gint64 upload_bytes;
+  gint64 fallback_nodes;
+  gint64 offscreens;
+} GtkFrameStats;
+
+void         gtk_widget_set_frame_profiling  (gboolean enabled);
+guint        gtk_widget_get_frame_stats      (GtkFrameStats *stats,
+                                              guint          n_stats);
+void         gtk_widget_get_invalidations    (GtkWidget     *widget,
+                                              guint         *n_draws,
+                                              guint         *n_resizes);
+
+void         gtk_widget_set_parent_is_relayout_boundary (GtkWidget *widget,
+                                                         gboolean   boundary);
 void          _gtk_widget_scale_changed     (GtkWidget *widget);
 
 
@@ -363,6 +425,12 @@ _gtk_widget_get_mapped (GtkWidget *widget)
   return widget->priv->mapped;
 }
 
+static inline gboolean
+_gtk_widget_get_draw_needed (GtkWidget *widget)
+{
+  return widget->priv->draw_needed;
+}
+
 static inline gboolean
 _gtk_widget_is_drawable (GtkWidget *widget)
 {
@@ -211,6 +211,10 @@ typedef struct
 
   guint    keys_changed_handler;
 
+  /* The mnemonics' entries in the key hash by keyval, so that adding
+   * or removing a mnemonic doesn't have to rebuild all of it */
+  GHashTable *mnemonic_key_entries;
+
   guint32  initial_timestamp;
 
   guint16  configure_request_count;
@@ -274,6 +278,7 @@ typedef struct
 
   guint    hide_on_close             : 1;
   guint    in_emit_close_request     : 1;
+  guint    rebuild_key_hash          : 1;
 
   GdkSurfaceTypeHint type_hint;
 
@@ -506,8 +511,22 @@ static void     update_window_buttons                 (GtkWindow    *window);
 static void     get_shadow_width                      (GtkWindow    *window,
                                                        GtkBorder    *shadow_width);
 
+typedef struct _GtkWindowKeyEntry GtkWindowKeyEntry;
+
+struct _GtkWindowKeyEntry
+{
+  guint keyval;
+  guint modifiers;
+  guint is_mnemonic : 1;
+};
+
 static GtkKeyHash *gtk_window_get_key_hash        (GtkWindow   *window);
 static void        gtk_window_free_key_hash       (GtkWindow   *window);
+static void        add_to_key_hash                (GtkWindow      *window,
+                                                   guint           keyval,
+                                                   GdkModifierType modifiers,
+                                                   gboolean        is_mnemonic,
+                                                   gpointer        data);
 #ifdef GDK_WINDOWING_X11
 static void        gtk_window_on_theme_variant_changed (GtkSettings *settings,
                                                         GParamSpec  *pspec,
@@ -1651,7 +1670,7 @@ node_style_changed_cb (GtkCssNode        *node,
 {
   if (gtk_css_style_change_affects (change, GTK_CSS_AFFECTS_SIZE))
     gtk_widget_queue_resize (widget);
-  else
+  else if (gtk_css_style_change_affects (change, GTK_CSS_AFFECTS_REDRAW))
     gtk_widget_queue_draw (widget);
 }
 
@@ -2912,8 +2931,8 @@ handle_keys_changed (gpointer data)
   return FALSE;
 }
 
-void
-_gtk_window_notify_keys_changed (GtkWindow *window)
+static void
+gtk_window_schedule_keys_changed (GtkWindow *window)
 {
   GtkWindowPrivate *priv = gtk_window_get_instance_private (window);
 
@@ -2924,6 +2943,15 @@ _gtk_window_notify_keys_changed (GtkWindow *window)
     }
 }
 
+void
+_gtk_window_notify_keys_changed (GtkWindow *window)
+{
+  GtkWindowPrivate *priv = gtk_window_get_instance_private (window);
+
+  priv->rebuild_key_hash = TRUE;
+  gtk_window_schedule_keys_changed (window);
+}
+
 /**
  * gtk_window_add_accel_group:
  * @window: window to attach accelerator group to
@@ -2980,6 +3008,38 @@ gtk_window_get_mnemonic_hash (GtkWindow *window,
   return priv->mnemonic_hash;
 }
 
+static void
+gtk_window_mnemonic_changed (GtkWindow *window,
+                             guint      keyval)
+{
+  GtkWindowPrivate *priv = gtk_window_get_instance_private (window);
+  GtkKeyHash *key_hash;
+
+  key_hash = g_object_get_qdata (G_OBJECT (window), quark_gtk_window_key_hash);
+
+  if (key_hash != NULL && !priv->rebuild_key_hash)
+    {
+      GtkWindowKeyEntry *entry = NULL;
+      gboolean has_targets;
+
+      if (priv->mnemonic_key_entries)
+        entry = g_hash_table_lookup (priv->mnemonic_key_entries, GUINT_TO_POINTER (keyval));
+      has_targets = _gtk_mnemonic_hash_lookup (priv->mnemonic_hash, keyval) != NULL;
+
+      if (has_targets && entry == NULL)
+        {
+          add_to_key_hash (window, keyval, priv->mnemonic_modifier, TRUE, key_hash);
+        }
+      else if (!has_targets && entry != NULL)
+        {
+          g_hash_table_remove (priv->mnemonic_key_entries, GUINT_TO_POINTER (keyval));
+          _gtk_key_hash_remove_entry (key_hash, entry);
+        }
+    }
+
+  gtk_window_schedule_keys_changed (window);
+}
+
 /**
  * gtk_window_add_mnemonic:
  * @window: a #GtkWindow
@@ -2998,7 +3058,7 @@ gtk_window_add_mnemonic (GtkWindow *window,
 
   _gtk_mnemonic_hash_add (gtk_window_get_mnemonic_hash (window, TRUE),
 			  keyval, target);
-  _gtk_window_notify_keys_changed (window);
+  gtk_window_mnemonic_changed (window, keyval);
 }
 
 /**
@@ -3019,7 +3079,7 @@ gtk_window_remove_mnemonic (GtkWindow *window,
   
   _gtk_mnemonic_hash_remove (gtk_window_get_mnemonic_hash (window, TRUE),
 			     keyval, target);
-  _gtk_window_notify_keys_changed (window);
+  gtk_window_mnemonic_changed (window, keyval);
 }
 
 /**
@@ -10117,19 +10177,16 @@ _gtk_window_keys_foreach (GtkWindow                *window,
 static void
 gtk_window_keys_changed (GtkWindow *window)
 {
+  GtkWindowPrivate *priv = gtk_window_get_instance_private (window);
+
+  /* Mnemonic changes have been applied already */
+  if (!priv->rebuild_key_hash)
+    return;
+
   gtk_window_free_key_hash (window);
   gtk_window_get_key_hash (window);
 }
 
-typedef struct _GtkWindowKeyEntry GtkWindowKeyEntry;
-
-struct _GtkWindowKeyEntry
-{
-  guint keyval;
-  guint modifiers;
-  guint is_mnemonic : 1;
-};
-
 static void 
 window_key_entry_destroy (gpointer data)
 {
@@ -10143,6 +10200,7 @@ add_to_key_hash (GtkWindow      *window,
 		 gboolean        is_mnemonic,
 		 gpointer        data)
 {
+  GtkWindowPrivate *priv = gtk_window_get_instance_private (window);
   GtkKeyHash *key_hash = data;
 
   GtkWindowKeyEntry *entry = g_slice_new (GtkWindowKeyEntry);
@@ -10151,6 +10209,13 @@ add_to_key_hash (GtkWindow      *window,
   entry->modifiers = modifiers;
   entry->is_mnemonic = is_mnemonic;
 
+  if (is_mnemonic)
+    {
+      if (priv->mnemonic_key_entries == NULL)
+        priv->mnemonic_key_entries = g_hash_table_new (NULL, NULL);
+      g_hash_table_insert (priv->mnemonic_key_entries, GUINT_TO_POINTER (keyval), entry);
+    }
+
   /* GtkAccelGroup stores lowercased accelerators. To deal
    * with this, if <Shift> was specified, uppercase.
    */
@@ -10178,6 +10243,7 @@ gtk_window_get_key_hash (GtkWindow *window)
 				(GDestroyNotify)window_key_entry_destroy);
   _gtk_window_keys_foreach (window, add_to_key_hash, key_hash);
   g_object_set_qdata (G_OBJECT (window), quark_gtk_window_key_hash, key_hash);
+  priv->rebuild_key_hash = FALSE;
 
   return key_hash;
 }
@@ -10185,7 +10251,11 @@ gtk_window_get_key_hash (GtkWindow *window)
 static void
 gtk_window_free_key_hash (GtkWindow *window)
 {
+  GtkWindowPrivate *priv = gtk_window_get_instance_private (window);
   GtkKeyHash *key_hash = g_object_get_qdata (G_OBJECT (window), quark_gtk_window_key_hash);
+
+  g_clear_pointer (&priv->mnemonic_key_entries, g_hash_table_unref);
+
   if (key_hash)
     {
       _gtk_key_hash_free (key_hash);
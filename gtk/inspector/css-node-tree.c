@@ -28,6 +28,7 @@
 
 #include "gtktreemodelcssnode.h"
 #include "gtktreeview.h"
+#include "gtkbutton.h"
 #include "gtklabel.h"
 #include "gtkpopover.h"
 #include "gtk/gtkwidgetprivate.h"
@@ -62,6 +63,19 @@ enum
   COLUMN_PROP_LOCATION
 };
 
+enum
+{
+  COLUMN_HOT_NAME,
+  COLUMN_HOT_CLASSES,
+  COLUMN_HOT_VALIDATIONS,
+  COLUMN_HOT_CACHE_HITS,
+  COLUMN_HOT_CACHE_MISSES,
+  COLUMN_HOT_RULES_TESTED,
+  COLUMN_HOT_MATCH_TIME_TEXT,
+  COLUMN_HOT_MATCH_TIME,
+  COLUMN_HOT_NODE
+};
+
 enum
 {
   PROP_0,
@@ -81,6 +95,7 @@ struct _GtkInspectorCssNodeTreePrivate
   GtkWidget *prop_tree;
   GtkTreeViewColumn *prop_name_column;
   GHashTable *prop_iters;
+  GtkListStore *hot_model;
   GtkCssNode *node;
 };
 
@@ -149,6 +164,112 @@ static void
 gtk_inspector_css_node_tree_set_node (GtkInspectorCssNodeTree *cnt,
                                       GtkCssNode              *node);
 
+static void
+select_node (GtkInspectorCssNodeTree *cnt,
+             GtkCssNode              *node)
+{
+  GtkInspectorCssNodeTreePrivate *priv = cnt->priv;
+  GtkTreePath *path;
+  GtkTreeIter iter;
+
+  gtk_tree_model_css_node_get_iter_from_node (GTK_TREE_MODEL_CSS_NODE (priv->node_model), &iter, node);
+  path = gtk_tree_model_get_path (priv->node_model, &iter);
+
+  gtk_tree_view_expand_to_path (GTK_TREE_VIEW (priv->node_tree), path);
+  gtk_tree_view_set_cursor (GTK_TREE_VIEW (priv->node_tree), path, NULL, FALSE);
+  gtk_tree_view_scroll_to_cell (GTK_TREE_VIEW (priv->node_tree), path, NULL, TRUE, 0.5, 0.0);
+
+  gtk_tree_path_free (path);
+}
+
+static void
+add_hot_nodes (GtkInspectorCssNodeTree *cnt,
+               GtkCssNode              *node)
+{
+  const GtkCssNodeProfile *profile;
+  GtkCssNode *child;
+
+  profile = gtk_css_node_get_profile (node);
+  if (profile)
+    {
+      char **classes;
+      char *classes_text;
+      char *time_text;
+
+      classes = gtk_css_node_get_classes (node);
+      classes_text = g_strjoinv (" ", classes);
+      time_text = g_strdup_printf ("%.2f ms", profile->match_time / 1000.0);
+
+      gtk_list_store_insert_with_values (cnt->priv->hot_model, NULL, -1,
+                                         COLUMN_HOT_NAME, gtk_css_node_get_name (node),
+                                         COLUMN_HOT_CLASSES, classes_text,
+                                         COLUMN_HOT_VALIDATIONS, profile->n_validations,
+                                         COLUMN_HOT_CACHE_HITS, profile->n_cache_hits,
+                                         COLUMN_HOT_CACHE_MISSES, profile->n_cache_misses,
+                                         COLUMN_HOT_RULES_TESTED, profile->n_rules_tested,
+                                         COLUMN_HOT_MATCH_TIME_TEXT, time_text,
+                                         COLUMN_HOT_MATCH_TIME, profile->match_time,
+                                         COLUMN_HOT_NODE, node,
+                                         -1);
+
+      g_free (time_text);
+      g_free (classes_text);
+      g_strfreev (classes);
+    }
+
+  for (child = gtk_css_node_get_first_child (node);
+       child;
+       child = gtk_css_node_get_next_sibling (child))
+    add_hot_nodes (cnt, child);
+}
+
+static void
+refresh_hot_nodes (GtkButton               *button,
+                   GtkInspectorCssNodeTree *cnt)
+{
+  GtkCssNode *root;
+
+  gtk_list_store_clear (cnt->priv->hot_model);
+
+  root = gtk_tree_model_css_node_get_root_node (GTK_TREE_MODEL_CSS_NODE (cnt->priv->node_model));
+  if (root)
+    add_hot_nodes (cnt, root);
+}
+
+static void
+reset_hot_nodes (GtkButton               *button,
+                 GtkInspectorCssNodeTree *cnt)
+{
+  GtkCssNode *root;
+
+  root = gtk_tree_model_css_node_get_root_node (GTK_TREE_MODEL_CSS_NODE (cnt->priv->node_model));
+  if (root)
+    gtk_css_node_reset_profile (root);
+
+  gtk_list_store_clear (cnt->priv->hot_model);
+}
+
+static void
+hot_node_activated (GtkTreeView             *tv,
+                    GtkTreePath             *path,
+                    GtkTreeViewColumn       *col,
+                    GtkInspectorCssNodeTree *cnt)
+{
+  GtkTreeIter iter;
+  GtkCssNode *node, *root;
+
+  gtk_tree_model_get_iter (GTK_TREE_MODEL (cnt->priv->hot_model), &iter, path);
+  gtk_tree_model_get (GTK_TREE_MODEL (cnt->priv->hot_model), &iter, COLUMN_HOT_NODE, &node, -1);
+
+  /* The node may have been removed from the tree since the last refresh */
+  for (root = node; gtk_css_node_get_parent (root); root = gtk_css_node_get_parent (root))
+    ;
+  if (root == gtk_tree_model_css_node_get_root_node (GTK_TREE_MODEL_CSS_NODE (cnt->priv->node_model)))
+    select_node (cnt, node);
+
+  g_object_unref (node);
+}
+
 static void
 selection_changed (GtkTreeSelection *selection, GtkInspectorCssNodeTree *cnt)
 {
@@ -246,6 +367,7 @@ gtk_inspector_css_node_tree_class_init (GtkInspectorCssNodeTreeClass *klass)
   GtkWidgetClass *widget_class = GTK_WIDGET_CLASS (klass);
 
   ensure_css_sections ();
+  gtk_css_node_set_profiling (TRUE);
 
   object_class->set_property = gtk_inspector_css_node_tree_set_property;
   object_class->get_property = gtk_inspector_css_node_tree_get_property;
@@ -268,9 +390,13 @@ gtk_inspector_css_node_tree_class_init (GtkInspectorCssNodeTreeClass *klass)
   gtk_widget_class_bind_template_child_private (widget_class, GtkInspectorCssNodeTree, prop_name_column);
   gtk_widget_class_bind_template_child_private (widget_class, GtkInspectorCssNodeTree, prop_model);
   gtk_widget_class_bind_template_child_private (widget_class, GtkInspectorCssNodeTree, prop_name_column);
+  gtk_widget_class_bind_template_child_private (widget_class, GtkInspectorCssNodeTree, hot_model);
 
   gtk_widget_class_bind_template_callback (widget_class, row_activated);
   gtk_widget_class_bind_template_callback (widget_class, selection_changed);
+  gtk_widget_class_bind_template_callback (widget_class, refresh_hot_nodes);
+  gtk_widget_class_bind_template_callback (widget_class, reset_hot_nodes);
+  gtk_widget_class_bind_template_callback (widget_class, hot_node_activated);
 }
 
 static int
@@ -386,6 +512,11 @@ gtk_inspector_css_node_tree_init (GtkInspectorCssNodeTree *cnt)
                                         COLUMN_PROP_NAME,
                                         GTK_SORT_ASCENDING);
 
+  /* Most expensive nodes first */
+  gtk_tree_sortable_set_sort_column_id (GTK_TREE_SORTABLE (cnt->priv->hot_model),
+                                        COLUMN_HOT_MATCH_TIME,
+                                        GTK_SORT_DESCENDING);
+
   priv->prop_iters = g_hash_table_new_full (g_str_hash, g_str_equal,
                                             NULL, (GDestroyNotify) gtk_tree_iter_free);
 
@@ -410,8 +541,6 @@ gtk_inspector_css_node_tree_set_object (GtkInspectorCssNodeTree *cnt,
 {
   GtkInspectorCssNodeTreePrivate *priv;
   GtkCssNode *node, *root;
-  GtkTreePath *path;
-  GtkTreeIter iter;
 
   g_return_if_fail (GTK_INSPECTOR_IS_CSS_NODE_TREE (cnt));
 
@@ -429,16 +558,12 @@ gtk_inspector_css_node_tree_set_object (GtkInspectorCssNodeTree *cnt,
   while (gtk_css_node_get_parent (root))
     root = gtk_css_node_get_parent (root);
 
-  gtk_tree_model_css_node_set_root_node (GTK_TREE_MODEL_CSS_NODE (priv->node_model), root);
+  if (root != gtk_tree_model_css_node_get_root_node (GTK_TREE_MODEL_CSS_NODE (priv->node_model)))
+    gtk_list_store_clear (priv->hot_model);
 
-  gtk_tree_model_css_node_get_iter_from_node (GTK_TREE_MODEL_CSS_NODE (priv->node_model), &iter, node);
-  path = gtk_tree_model_get_path (priv->node_model, &iter);
-
-  gtk_tree_view_expand_to_path (GTK_TREE_VIEW (priv->node_tree), path);
-  gtk_tree_view_set_cursor (GTK_TREE_VIEW (priv->node_tree), path, NULL, FALSE);
-  gtk_tree_view_scroll_to_cell (GTK_TREE_VIEW (priv->node_tree), path, NULL, TRUE, 0.5, 0.0);
+  gtk_tree_model_css_node_set_root_node (GTK_TREE_MODEL_CSS_NODE (priv->node_model), root);
 
-  gtk_tree_path_free (path);
+  select_node (cnt, node);
 }
 
 static void
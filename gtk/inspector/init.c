@@ -32,12 +32,14 @@
 #include "data-list.h"
 #include "general.h"
 #include "graphdata.h"
+#include "layout-stats.h"
 #include "logs.h"
 #include "magnifier.h"
 #include "menu.h"
 #include "misc-info.h"
 #include "object-hierarchy.h"
 #include "object-tree.h"
+#include "performance.h"
 #include "prop-list.h"
 #include "recorder.h"
 #include "resource-list.h"
@@ -68,6 +70,7 @@ gtk_inspector_init (void)
   g_type_ensure (GTK_TYPE_INSPECTOR_CSS_NODE_TREE);
   g_type_ensure (GTK_TYPE_INSPECTOR_DATA_LIST);
   g_type_ensure (GTK_TYPE_INSPECTOR_GENERAL);
+  g_type_ensure (GTK_TYPE_INSPECTOR_LAYOUT_STATS);
   g_type_ensure (GTK_TYPE_INSPECTOR_LOGS);
   g_type_ensure (GTK_TYPE_MAGNIFIER);
   g_type_ensure (GTK_TYPE_INSPECTOR_MAGNIFIER);
@@ -75,6 +78,7 @@ gtk_inspector_init (void)
   g_type_ensure (GTK_TYPE_INSPECTOR_MISC_INFO);
   g_type_ensure (GTK_TYPE_INSPECTOR_OBJECT_HIERARCHY);
   g_type_ensure (GTK_TYPE_INSPECTOR_OBJECT_TREE);
+  g_type_ensure (GTK_TYPE_INSPECTOR_PERFORMANCE);
   g_type_ensure (GTK_TYPE_INSPECTOR_PROP_LIST);
   g_type_ensure (GTK_TYPE_INSPECTOR_RECORDER);
   g_type_ensure (GTK_TYPE_INSPECTOR_RESOURCE_LIST);
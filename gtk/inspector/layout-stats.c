@@ -0,0 +1,293 @@
+/*
+ * Copyright (c) 2018 Red Hat, Inc.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "config.h"
+#include <glib/gi18n-lib.h>
+
+#include "layout-stats.h"
+
+#include "gtkcellrenderertext.h"
+#include "gtkliststore.h"
+#include "gtkscrolledwindow.h"
+#include "gtktogglebutton.h"
+#include "gtktreeview.h"
+#include "gtkwidgetprivate.h"
+#include "gtkwindow.h"
+
+enum
+{
+  PROP_0,
+  PROP_BUTTON
+};
+
+enum
+{
+  COLUMN_WIDGET,
+  COLUMN_FRAME,
+  COLUMN_N_MEASURE,
+  COLUMN_MEASURE_TIME,
+  COLUMN_N_ALLOCATE,
+  COLUMN_ALLOCATE_TIME,
+  N_COLUMNS
+};
+
+struct _GtkInspectorLayoutStatsPrivate
+{
+  GtkWidget *button;
+  GtkListStore *model;
+  GtkWidget *view;
+  guint update_source_id;
+};
+
+G_DEFINE_TYPE_WITH_PRIVATE (GtkInspectorLayoutStats, gtk_inspector_layout_stats, GTK_TYPE_BOX)
+
+static void
+add_widget_stats (GtkInspectorLayoutStats *sl,
+                  GtkWidget               *widget)
+{
+  const GtkWidgetLayoutStats *stats;
+  GtkWidget *child;
+
+  stats = gtk_widget_peek_layout_stats (widget);
+  if (stats)
+    {
+      char *name;
+
+      name = g_strdup_printf ("%s %p", G_OBJECT_TYPE_NAME (widget), widget);
+      gtk_list_store_insert_with_values (sl->priv->model, NULL, -1,
+                                         COLUMN_WIDGET, name,
+                                         COLUMN_FRAME, stats->frame,
+                                         COLUMN_N_MEASURE, stats->n_measure,
+                                         COLUMN_MEASURE_TIME, stats->measure_time / 1000.0,
+                                         COLUMN_N_ALLOCATE, stats->n_allocate,
+                                         COLUMN_ALLOCATE_TIME, stats->allocate_time / 1000.0,
+                                         -1);
+      g_free (name);
+    }
+
+  for (child = gtk_widget_get_first_child (widget);
+       child != NULL;
+       child = gtk_widget_get_next_sibling (child))
+    add_widget_stats (sl, child);
+}
+
+static gboolean
+update_layout_stats (gpointer data)
+{
+  GtkInspectorLayoutStats *sl = data;
+  GList *toplevels, *l;
+
+  gtk_list_store_clear (sl->priv->model);
+
+  toplevels = gtk_window_list_toplevels ();
+  for (l = toplevels; l; l = l->next)
+    {
+      GtkWidget *toplevel = l->data;
+
+      if (toplevel == gtk_widget_get_toplevel (GTK_WIDGET (sl))) /* skip the inspector */
+        continue;
+
+      add_widget_stats (sl, toplevel);
+    }
+  g_list_free (toplevels);
+
+  return G_SOURCE_CONTINUE;
+}
+
+static void
+toggle_record (GtkToggleButton         *button,
+               GtkInspectorLayoutStats *sl)
+{
+  if (gtk_toggle_button_get_active (button) == (sl->priv->update_source_id != 0))
+    return;
+
+  if (gtk_toggle_button_get_active (button))
+    {
+      gtk_widget_set_layout_profiling (TRUE);
+      sl->priv->update_source_id = g_timeout_add_seconds (1, update_layout_stats, sl);
+      update_layout_stats (sl);
+    }
+  else
+    {
+      gtk_widget_set_layout_profiling (FALSE);
+      g_source_remove (sl->priv->update_source_id);
+      sl->priv->update_source_id = 0;
+    }
+}
+
+static void
+cell_data_time (GtkTreeViewColumn *column,
+                GtkCellRenderer   *cell,
+                GtkTreeModel      *model,
+                GtkTreeIter       *iter,
+                gpointer           data)
+{
+  double time;
+  char *text;
+
+  gtk_tree_model_get (model, iter, GPOINTER_TO_INT (data), &time, -1);
+
+  text = g_strdup_printf ("%.2f ms", time);
+  g_object_set (cell, "text", text, NULL);
+  g_free (text);
+}
+
+static void
+add_column (GtkInspectorLayoutStats *sl,
+            const char              *title,
+            int                      column_id)
+{
+  GtkTreeViewColumn *column;
+  GtkCellRenderer *renderer;
+
+  renderer = gtk_cell_renderer_text_new ();
+  g_object_set (renderer, "scale", 0.8, NULL);
+
+  column = gtk_tree_view_column_new ();
+  gtk_tree_view_column_set_title (column, title);
+  gtk_tree_view_column_set_sort_column_id (column, column_id);
+  gtk_tree_view_column_pack_start (column, renderer, TRUE);
+
+  if (column_id == COLUMN_MEASURE_TIME || column_id == COLUMN_ALLOCATE_TIME)
+    gtk_tree_view_column_set_cell_data_func (column, renderer,
+                                             cell_data_time,
+                                             GINT_TO_POINTER (column_id), NULL);
+  else
+    gtk_tree_view_column_add_attribute (column, renderer, "text", column_id);
+
+  gtk_tree_view_append_column (GTK_TREE_VIEW (sl->priv->view), column);
+}
+
+static void
+gtk_inspector_layout_stats_init (GtkInspectorLayoutStats *sl)
+{
+  GtkWidget *sw;
+
+  sl->priv = gtk_inspector_layout_stats_get_instance_private (sl);
+
+  gtk_orientable_set_orientation (GTK_ORIENTABLE (sl), GTK_ORIENTATION_VERTICAL);
+
+  sl->priv->model = gtk_list_store_new (N_COLUMNS,
+                                        G_TYPE_STRING,
+                                        G_TYPE_INT64,
+                                        G_TYPE_UINT,
+                                        G_TYPE_DOUBLE,
+                                        G_TYPE_UINT,
+                                        G_TYPE_DOUBLE);
+  gtk_tree_sortable_set_sort_column_id (GTK_TREE_SORTABLE (sl->priv->model),
+                                        COLUMN_ALLOCATE_TIME,
+                                        GTK_SORT_DESCENDING);
+
+  sl->priv->view = gtk_tree_view_new_with_model (GTK_TREE_MODEL (sl->priv->model));
+  gtk_tree_view_set_search_column (GTK_TREE_VIEW (sl->priv->view), COLUMN_WIDGET);
+
+  add_column (sl, _("Widget"), COLUMN_WIDGET);
+  add_column (sl, _("Frame"), COLUMN_FRAME);
+  add_column (sl, _("Measures"), COLUMN_N_MEASURE);
+  add_column (sl, _("Measure Time"), COLUMN_MEASURE_TIME);
+  add_column (sl, _("Allocations"), COLUMN_N_ALLOCATE);
+  add_column (sl, _("Allocation Time"), COLUMN_ALLOCATE_TIME);
+
+  sw = gtk_scrolled_window_new (NULL, NULL);
+  gtk_widget_set_vexpand (sw, TRUE);
+  gtk_container_add (GTK_CONTAINER (sw), sl->priv->view);
+  gtk_container_add (GTK_CONTAINER (sl), sw);
+}
+
+static void
+constructed (GObject *object)
+{
+  GtkInspectorLayoutStats *sl = GTK_INSPECTOR_LAYOUT_STATS (object);
+
+  G_OBJECT_CLASS (gtk_inspector_layout_stats_parent_class)->constructed (object);
+
+  g_signal_connect (sl->priv->button, "toggled",
+                    G_CALLBACK (toggle_record), sl);
+}
+
+static void
+finalize (GObject *object)
+{
+  GtkInspectorLayoutStats *sl = GTK_INSPECTOR_LAYOUT_STATS (object);
+
+  if (sl->priv->update_source_id)
+    {
+      g_source_remove (sl->priv->update_source_id);
+      gtk_widget_set_layout_profiling (FALSE);
+    }
+
+  g_object_unref (sl->priv->model);
+
+  G_OBJECT_CLASS (gtk_inspector_layout_stats_parent_class)->finalize (object);
+}
+
+static void
+get_property (GObject    *object,
+              guint       param_id,
+              GValue     *value,
+              GParamSpec *pspec)
+{
+  GtkInspectorLayoutStats *sl = GTK_INSPECTOR_LAYOUT_STATS (object);
+
+  switch (param_id)
+    {
+    case PROP_BUTTON:
+      g_value_set_object (value, sl->priv->button);
+      break;
+
+    default:
+      G_OBJECT_WARN_INVALID_PROPERTY_ID (object, param_id, pspec);
+      break;
+    }
+}
+
+static void
+set_property (GObject      *object,
+              guint         param_id,
+              const GValue *value,
+              GParamSpec   *pspec)
+{
+  GtkInspectorLayoutStats *sl = GTK_INSPECTOR_LAYOUT_STATS (object);
+
+  switch (param_id)
+    {
+    case PROP_BUTTON:
+      sl->priv->button = g_value_get_object (value);
+      break;
+
+    default:
+      G_OBJECT_WARN_INVALID_PROPERTY_ID (object, param_id, pspec);
+      break;
+    }
+}
+
+static void
+gtk_inspector_layout_stats_class_init (GtkInspectorLayoutStatsClass *klass)
+{
+  GObjectClass *object_class = G_OBJECT_CLASS (klass);
+
+  object_class->get_property = get_property;
+  object_class->set_property = set_property;
+  object_class->constructed = constructed;
+  object_class->finalize = finalize;
+
+  g_object_class_install_property (object_class, PROP_BUTTON,
+      g_param_spec_object ("button", NULL, NULL,
+                           GTK_TYPE_WIDGET, G_PARAM_READWRITE | G_PARAM_CONSTRUCT_ONLY));
+}
+
+// vim: set et sw=2 ts=2:
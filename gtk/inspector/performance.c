@@ -0,0 +1,571 @@
+/*
+ * Copyright (c) 2018 Red Hat, Inc.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "config.h"
+#include <glib/gi18n-lib.h>
+
+#include "performance.h"
+
+#include "gtkcellrenderertext.h"
+#include "gtkdrawingarea.h"
+#include "gtkgrid.h"
+#include "gtklabel.h"
+#include "gtkliststore.h"
+#include "gtkscrolledwindow.h"
+#include "gtktogglebutton.h"
+#include "gtktreeview.h"
+#include "gtkwidgetprivate.h"
+#include "gtkwindow.h"
+
+#include "gdk/gdkcachesprivate.h"
+
+/* frames shown in the graph */
+#define N_FRAMES 120
+/* the graph shows at least this many µs */
+#define MIN_GRAPH_TIME (G_USEC_PER_SEC / 30)
+#define FRAME_BUDGET (G_USEC_PER_SEC / 60)
+
+enum
+{
+  PROP_0,
+  PROP_BUTTON
+};
+
+enum
+{
+  COLUMN_WIDGET,
+  COLUMN_N_DRAWS,
+  COLUMN_N_RESIZES,
+  N_COLUMNS
+};
+
+enum
+{
+  CACHE_COLUMN_NAME,
+  CACHE_COLUMN_N_CACHES,
+  CACHE_COLUMN_CPU,
+  CACHE_COLUMN_GPU,
+  CACHE_COLUMN_BUDGET,
+  N_CACHE_COLUMNS
+};
+
+enum
+{
+  PHASE_EVENTS,
+  PHASE_UPDATE,
+  PHASE_STYLE,
+  PHASE_LAYOUT,
+  PHASE_SNAPSHOT,
+  PHASE_RENDER,
+  PHASE_GPU,
+  N_PHASES
+};
+
+static const struct {
+  const char *name;
+  const char *color;
+} phases[N_PHASES] = {
+  { N_("Events"),   "#3465a4" },
+  { N_("Update"),   "#75507b" },
+  { N_("Style"),    "#c17d11" },
+  { N_("Layout"),   "#f57900" },
+  { N_("Snapshot"), "#73d216" },
+  { N_("Render"),   "#cc0000" },
+  { N_("GPU"),      "#555753" },
+};
+
+struct _GtkInspectorPerformancePrivate
+{
+  GtkWidget *button;
+  GtkWidget *graph;
+  GtkWidget *fps_label;
+  GtkWidget *uploads_label;
+  GtkWidget *fallbacks_label;
+  GtkWidget *offscreens_label;
+  GtkListStore *model;
+  GtkWidget *view;
+  GtkListStore *cache_model;
+  GtkWidget *cache_view;
+  guint update_source_id;
+  guint update_count;
+
+  GtkFrameStats frames[N_FRAMES];
+  guint n_frames;
+};
+
+G_DEFINE_TYPE_WITH_PRIVATE (GtkInspectorPerformance, gtk_inspector_performance, GTK_TYPE_BOX)
+
+static gint64
+get_phase_time (const GtkFrameStats *stats,
+                int                  phase)
+{
+  switch (phase)
+    {
+    case PHASE_EVENTS:
+      return stats->events;
+    case PHASE_UPDATE:
+      return stats->update;
+    case PHASE_STYLE:
+      return stats->style;
+    case PHASE_LAYOUT:
+      return stats->layout;
+    case PHASE_SNAPSHOT:
+      return stats->snapshot;
+    case PHASE_RENDER:
+      return stats->render;
+    case PHASE_GPU:
+      return stats->gpu;
+    default:
+      g_assert_not_reached ();
+      return 0;
+    }
+}
+
+static void
+draw_graph (GtkDrawingArea *area,
+            cairo_t        *cr,
+            int             width,
+            int             height,
+            gpointer        data)
+{
+  GtkInspectorPerformance *pl = data;
+  double bar_width, y, scale;
+  gint64 max_time;
+  GdkRGBA color;
+  guint i;
+  int phase;
+
+  max_time = MIN_GRAPH_TIME;
+  for (i = 0; i < pl->priv->n_frames; i++)
+    {
+      gint64 total = 0;
+
+      for (phase = 0; phase < N_PHASES; phase++)
+        total += get_phase_time (&pl->priv->frames[i], phase);
+
+      max_time = MAX (max_time, total);
+    }
+
+  scale = (double) height / max_time;
+  bar_width = (double) width / N_FRAMES;
+
+  /* newest frame on the right */
+  for (i = 0; i < pl->priv->n_frames; i++)
+    {
+      double x = width - (pl->priv->n_frames - i) * bar_width;
+
+      y = height;
+      for (phase = 0; phase < N_PHASES; phase++)
+        {
+          double h = get_phase_time (&pl->priv->frames[i], phase) * scale;
+
+          gdk_rgba_parse (&color, phases[phase].color);
+          gdk_cairo_set_source_rgba (cr, &color);
+          cairo_rectangle (cr, x, y - h, MAX (1, bar_width - 1), h);
+          cairo_fill (cr);
+          y -= h;
+        }
+    }
+
+  /* what fits into a frame at 60 Hz */
+  y = height - FRAME_BUDGET * scale;
+  cairo_set_source_rgba (cr, 0, 0, 0, 0.5);
+  cairo_set_line_width (cr, 1);
+  cairo_move_to (cr, 0, floor (y) + 0.5);
+  cairo_line_to (cr, width, floor (y) + 0.5);
+  cairo_stroke (cr);
+}
+
+static void
+add_widget_invalidations (GtkInspectorPerformance *pl,
+                          GtkWidget               *widget)
+{
+  GtkWidget *child;
+  guint n_draws, n_resizes;
+
+  gtk_widget_get_invalidations (widget, &n_draws, &n_resizes);
+  if (n_draws > 0 || n_resizes > 0)
+    {
+      char *name;
+
+      name = g_strdup_printf ("%s %p", G_OBJECT_TYPE_NAME (widget), widget);
+      gtk_list_store_insert_with_values (pl->priv->model, NULL, -1,
+                                         COLUMN_WIDGET, name,
+                                         COLUMN_N_DRAWS, n_draws,
+                                         COLUMN_N_RESIZES, n_resizes,
+                                         -1);
+      g_free (name);
+    }
+
+  for (child = gtk_widget_get_first_child (widget);
+       child != NULL;
+       child = gtk_widget_get_next_sibling (child))
+    add_widget_invalidations (pl, child);
+}
+
+static void
+update_invalidations (GtkInspectorPerformance *pl)
+{
+  GList *toplevels, *l;
+
+  gtk_list_store_clear (pl->priv->model);
+
+  toplevels = gtk_window_list_toplevels ();
+  for (l = toplevels; l; l = l->next)
+    {
+      GtkWidget *toplevel = l->data;
+
+      if (toplevel == gtk_widget_get_toplevel (GTK_WIDGET (pl))) /* skip the inspector */
+        continue;
+
+      add_widget_invalidations (pl, toplevel);
+    }
+  g_list_free (toplevels);
+}
+
+static void
+update_caches (GtkInspectorPerformance *pl)
+{
+  GArray *infos;
+  guint i;
+
+  gtk_list_store_clear (pl->priv->cache_model);
+
+  infos = gdk_cache_get_info ();
+  for (i = 0; i < infos->len; i++)
+    {
+      const GdkCacheInfo *info = &g_array_index (infos, GdkCacheInfo, i);
+      char *cpu, *gpu, *budget;
+
+      cpu = g_format_size (info->cpu_bytes);
+      gpu = g_format_size (info->gpu_bytes);
+      budget = info->budget ? g_format_size (info->budget) : g_strdup (C_("cache budget", "None"));
+
+      gtk_list_store_insert_with_values (pl->priv->cache_model, NULL, -1,
+                                         CACHE_COLUMN_NAME, info->name,
+                                         CACHE_COLUMN_N_CACHES, info->n_caches,
+                                         CACHE_COLUMN_CPU, cpu,
+                                         CACHE_COLUMN_GPU, gpu,
+                                         CACHE_COLUMN_BUDGET, budget,
+                                         -1);
+      g_free (cpu);
+      g_free (gpu);
+      g_free (budget);
+    }
+  g_array_unref (infos);
+}
+
+static void
+update_counters (GtkInspectorPerformance *pl)
+{
+  gint64 now, uploads, fallbacks, offscreens;
+  guint i, n;
+  char *text;
+
+  now = g_get_monotonic_time ();
+  uploads = fallbacks = offscreens = 0;
+  n = 0;
+
+  for (i = 0; i < pl->priv->n_frames; i++)
+    {
+      const GtkFrameStats *stats = &pl->priv->frames[i];
+
+      if (now - stats->time > G_USEC_PER_SEC)
+        continue;
+
+      uploads += stats->upload_bytes;
+      fallbacks += stats->fallback_nodes;
+      offscreens += stats->offscreens;
+      n++;
+    }
+
+  text = g_strdup_printf ("%u", n);
+  gtk_label_set_label (GTK_LABEL (pl->priv->fps_label), text);
+  g_free (text);
+
+  text = g_format_size (uploads);
+  gtk_label_set_label (GTK_LABEL (pl->priv->uploads_label), text);
+  g_free (text);
+
+  text = g_strdup_printf ("%" G_GINT64_FORMAT, fallbacks);
+  gtk_label_set_label (GTK_LABEL (pl->priv->fallbacks_label), text);
+  g_free (text);
+
+  text = g_strdup_printf ("%" G_GINT64_FORMAT, offscreens);
+  gtk_label_set_label (GTK_LABEL (pl->priv->offscreens_label), text);
+  g_free (text);
+}
+
+static gboolean
+update_performance (gpointer data)
+{
+  GtkInspectorPerformance *pl = data;
+  GtkFrameStats stats[N_FRAMES];
+  gconstpointer inspector;
+  guint i, n;
+
+  inspector = gtk_widget_get_toplevel (GTK_WIDGET (pl));
+
+  /* The inspector draws as well, leave its frames out */
+  n = gtk_widget_get_frame_stats (stats, N_FRAMES);
+  pl->priv->n_frames = 0;
+  for (i = 0; i < n; i++)
+    {
+      if (stats[i].toplevel != inspector)
+        pl->priv->frames[pl->priv->n_frames++] = stats[i];
+    }
+
+  gtk_widget_queue_draw (pl->priv->graph);
+
+  /* the counters and the table are per second */
+  if (pl->priv->update_count++ % 4 == 0)
+    {
+      update_counters (pl);
+      update_invalidations (pl);
+      update_caches (pl);
+    }
+
+  return G_SOURCE_CONTINUE;
+}
+
+static void
+toggle_record (GtkToggleButton         *button,
+               GtkInspectorPerformance *pl)
+{
+  if (gtk_toggle_button_get_active (button) == (pl->priv->update_source_id != 0))
+    return;
+
+  if (gtk_toggle_button_get_active (button))
+    {
+      gtk_widget_set_frame_profiling (TRUE);
+      pl->priv->update_count = 0;
+      pl->priv->update_source_id = g_timeout_add (250, update_performance, pl);
+      update_performance (pl);
+    }
+  else
+    {
+      gtk_widget_set_frame_profiling (FALSE);
+      g_source_remove (pl->priv->update_source_id);
+      pl->priv->update_source_id = 0;
+    }
+}
+
+static GtkWidget *
+add_counter (GtkInspectorPerformance *pl,
+             GtkWidget               *grid,
+             int                      row,
+             const char              *title)
+{
+  GtkWidget *label;
+
+  label = gtk_label_new (title);
+  gtk_label_set_xalign (GTK_LABEL (label), 0.0);
+  gtk_grid_attach (GTK_GRID (grid), label, 0, row, 1, 1);
+
+  label = gtk_label_new ("—");
+  gtk_label_set_xalign (GTK_LABEL (label), 1.0);
+  gtk_grid_attach (GTK_GRID (grid), label, 1, row, 1, 1);
+
+  return label;
+}
+
+static void
+add_column (GtkWidget  *view,
+            const char *title,
+            int         column_id,
+            gboolean    sortable)
+{
+  GtkTreeViewColumn *column;
+  GtkCellRenderer *renderer;
+
+  renderer = gtk_cell_renderer_text_new ();
+  g_object_set (renderer, "scale", 0.8, NULL);
+
+  column = gtk_tree_view_column_new ();
+  gtk_tree_view_column_set_title (column, title);
+  if (sortable)
+    gtk_tree_view_column_set_sort_column_id (column, column_id);
+  gtk_tree_view_column_pack_start (column, renderer, TRUE);
+  gtk_tree_view_column_add_attribute (column, renderer, "text", column_id);
+
+  gtk_tree_view_append_column (GTK_TREE_VIEW (view), column);
+}
+
+static void
+gtk_inspector_performance_init (GtkInspectorPerformance *pl)
+{
+  GtkWidget *legend, *grid, *sw, *label;
+  int phase;
+
+  pl->priv = gtk_inspector_performance_get_instance_private (pl);
+
+  gtk_orientable_set_orientation (GTK_ORIENTABLE (pl), GTK_ORIENTATION_VERTICAL);
+  gtk_box_set_spacing (GTK_BOX (pl), 10);
+
+  pl->priv->graph = gtk_drawing_area_new ();
+  gtk_drawing_area_set_content_height (GTK_DRAWING_AREA (pl->priv->graph), 150);
+  gtk_drawing_area_set_draw_func (GTK_DRAWING_AREA (pl->priv->graph), draw_graph, pl, NULL);
+  gtk_container_add (GTK_CONTAINER (pl), pl->priv->graph);
+
+  legend = gtk_box_new (GTK_ORIENTATION_HORIZONTAL, 20);
+  gtk_widget_set_halign (legend, GTK_ALIGN_CENTER);
+  for (phase = 0; phase < N_PHASES; phase++)
+    {
+      char *markup;
+
+      markup = g_markup_printf_escaped ("<span foreground=\"%s\">■</span> %s",
+                                        phases[phase].color,
+                                        _(phases[phase].name));
+      label = gtk_label_new (NULL);
+      gtk_label_set_markup (GTK_LABEL (label), markup);
+      gtk_container_add (GTK_CONTAINER (legend), label);
+      g_free (markup);
+    }
+  gtk_container_add (GTK_CONTAINER (pl), legend);
+
+  grid = gtk_grid_new ();
+  gtk_grid_set_column_spacing (GTK_GRID (grid), 40);
+  gtk_grid_set_row_spacing (GTK_GRID (grid), 6);
+  gtk_widget_set_halign (grid, GTK_ALIGN_CENTER);
+  pl->priv->fps_label = add_counter (pl, grid, 0, _("Frames in the last second"));
+  pl->priv->uploads_label = add_counter (pl, grid, 1, _("Texture uploads"));
+  pl->priv->fallbacks_label = add_counter (pl, grid, 2, _("Fallback nodes"));
+  pl->priv->offscreens_label = add_counter (pl, grid, 3, _("Offscreens"));
+  gtk_container_add (GTK_CONTAINER (pl), grid);
+
+  pl->priv->model = gtk_list_store_new (N_COLUMNS,
+                                        G_TYPE_STRING,
+                                        G_TYPE_UINT,
+                                        G_TYPE_UINT);
+  gtk_tree_sortable_set_sort_column_id (GTK_TREE_SORTABLE (pl->priv->model),
+                                        COLUMN_N_DRAWS,
+                                        GTK_SORT_DESCENDING);
+
+  pl->priv->view = gtk_tree_view_new_with_model (GTK_TREE_MODEL (pl->priv->model));
+  gtk_tree_view_set_search_column (GTK_TREE_VIEW (pl->priv->view), COLUMN_WIDGET);
+
+  add_column (pl->priv->view, _("Widget"), COLUMN_WIDGET, TRUE);
+  add_column (pl->priv->view, _("Queued Draws"), COLUMN_N_DRAWS, TRUE);
+  add_column (pl->priv->view, _("Queued Resizes"), COLUMN_N_RESIZES, TRUE);
+
+  sw = gtk_scrolled_window_new (NULL, NULL);
+  gtk_widget_set_vexpand (sw, TRUE);
+  gtk_container_add (GTK_CONTAINER (sw), pl->priv->view);
+  gtk_container_add (GTK_CONTAINER (pl), sw);
+
+  pl->priv->cache_model = gtk_list_store_new (N_CACHE_COLUMNS,
+                                              G_TYPE_STRING,
+                                              G_TYPE_UINT,
+                                              G_TYPE_STRING,
+                                              G_TYPE_STRING,
+                                              G_TYPE_STRING);
+
+  pl->priv->cache_view = gtk_tree_view_new_with_model (GTK_TREE_MODEL (pl->priv->cache_model));
+
+  add_column (pl->priv->cache_view, _("Cache"), CACHE_COLUMN_NAME, FALSE);
+  add_column (pl->priv->cache_view, _("Instances"), CACHE_COLUMN_N_CACHES, FALSE);
+  add_column (pl->priv->cache_view, _("CPU Memory"), CACHE_COLUMN_CPU, FALSE);
+  add_column (pl->priv->cache_view, _("GPU Memory"), CACHE_COLUMN_GPU, FALSE);
+  add_column (pl->priv->cache_view, _("Budget"), CACHE_COLUMN_BUDGET, FALSE);
+
+  gtk_container_add (GTK_CONTAINER (pl), pl->priv->cache_view);
+}
+
+static void
+constructed (GObject *object)
+{
+  GtkInspectorPerformance *pl = GTK_INSPECTOR_PERFORMANCE (object);
+
+  G_OBJECT_CLASS (gtk_inspector_performance_parent_class)->constructed (object);
+
+  g_signal_connect (pl->priv->button, "toggled",
+                    G_CALLBACK (toggle_record), pl);
+}
+
+static void
+finalize (GObject *object)
+{
+  GtkInspectorPerformance *pl = GTK_INSPECTOR_PERFORMANCE (object);
+
+  if (pl->priv->update_source_id)
+    {
+      g_source_remove (pl->priv->update_source_id);
+      gtk_widget_set_frame_profiling (FALSE);
+    }
+
+  g_object_unref (pl->priv->model);
+  g_object_unref (pl->priv->cache_model);
+
+  G_OBJECT_CLASS (gtk_inspector_performance_parent_class)->finalize (object);
+}
+
+static void
+get_property (GObject    *object,
+              guint       param_id,
+              GValue     *value,
+              GParamSpec *pspec)
+{
+  GtkInspectorPerformance *pl = GTK_INSPECTOR_PERFORMANCE (object);
+
+  switch (param_id)
+    {
+    case PROP_BUTTON:
+      g_value_set_object (value, pl->priv->button);
+      break;
+
+    default:
+      G_OBJECT_WARN_INVALID_PROPERTY_ID (object, param_id, pspec);
+      break;
+    }
+}
+
+static void
+set_property (GObject      *object,
+              guint         param_id,
+              const GValue *value,
+              GParamSpec   *pspec)
+{
+  GtkInspectorPerformance *pl = GTK_INSPECTOR_PERFORMANCE (object);
+
+  switch (param_id)
+    {
+    case PROP_BUTTON:
+      pl->priv->button = g_value_get_object (value);
+      break;
+
+    default:
+      G_OBJECT_WARN_INVALID_PROPERTY_ID (object, param_id, pspec);
+      break;
+    }
+}
+
+static void
+gtk_inspector_performance_class_init (GtkInspectorPerformanceClass *klass)
+{
+  GObjectClass *object_class = G_OBJECT_CLASS (klass);
+
+  object_class->get_property = get_property;
+  object_class->set_property = set_property;
+  object_class->constructed = constructed;
+  object_class->finalize = finalize;
+
+  g_object_class_install_property (object_class, PROP_BUTTON,
+      g_param_spec_object ("button", NULL, NULL,
+                           GTK_TYPE_WIDGET, G_PARAM_READWRITE | G_PARAM_CONSTRUCT_ONLY));
+}
+
+// vim: set et sw=2 ts=2:
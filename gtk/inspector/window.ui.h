@@ -2,6 +2,8 @@ N_("Select an Object");
 N_("Show Details");
 N_("Show all Objects");
 N_("Collect Statistics");
+N_("Collect Layout Statistics");
+N_("Collect Frame Statistics");
 N_("Show Details");
 N_("Show all Resources");
 N_("Miscellaneous");
@@ -22,6 +24,8 @@ N_("Gestures");
 N_("Magnifier");
 N_("Objects");
 N_("Statistics");
+N_("Layout");
+N_("Performance");
 N_("Resources");
 N_("CSS");
 N_("Visual");
@@ -0,0 +1,126 @@
+/* compilecss.c
+ * Copyright (C) 2018 Red Hat, Inc.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Library General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Library General Public License for more details.
+ *
+ * You should have received a copy of the GNU Library General Public
+ * License along with this library. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "config.h"
+
+#include <glib.h>
+#include <glib/gi18n.h>
+#include <gtk/gtk.h>
+
+#include <locale.h>
+
+static gchar *output = NULL;
+
+static GOptionEntry args[] = {
+  { "output", 'o', 0, G_OPTION_ARG_FILENAME, &output, N_("Write to this file instead of FILE.compiled"), N_("FILE") },
+  { NULL }
+};
+
+static void
+parsing_error_cb (GtkCssProvider *provider,
+                  GtkCssSection  *section,
+                  const GError   *error,
+                  gpointer        user_data)
+{
+  gboolean *failed = user_data;
+  GFile *file;
+  char *path;
+
+  file = section ? gtk_css_section_get_file (section) : NULL;
+  path = file ? g_file_get_parse_name (file) : g_strdup ("<data>");
+
+  g_printerr ("%s:%u:%u: %s\n",
+              path,
+              section ? gtk_css_section_get_start_line (section) + 1 : 0,
+              section ? gtk_css_section_get_start_position (section) : 0,
+              error->message);
+
+  g_free (path);
+
+  if (!g_error_matches (error, GTK_CSS_PROVIDER_ERROR, GTK_CSS_PROVIDER_ERROR_DEPRECATED))
+    *failed = TRUE;
+}
+
+int
+main (int argc, char **argv)
+{
+  GOptionContext *context;
+  GtkCssProvider *provider;
+  GError *error = NULL;
+  gboolean failed = FALSE;
+  GBytes *bytes;
+  char *path;
+
+  setlocale (LC_ALL, "");
+
+#ifdef ENABLE_NLS
+  bindtextdomain (GETTEXT_PACKAGE, GTK_LOCALEDIR);
+#ifdef HAVE_BIND_TEXTDOMAIN_CODESET
+  bind_textdomain_codeset (GETTEXT_PACKAGE, "UTF-8");
+#endif
+#endif
+
+  g_set_prgname ("gtk4-compile-css");
+
+  context = g_option_context_new ("FILE");
+  g_option_context_set_summary (context, _("Compile a CSS file so GTK can load it faster."));
+  g_option_context_add_main_entries (context, args, GETTEXT_PACKAGE);
+
+  if (!g_option_context_parse (context, &argc, &argv, &error))
+    {
+      g_printerr ("%s\n", error->message);
+      return 1;
+    }
+
+  if (argc != 2)
+    {
+      g_printerr ("%s\n", g_option_context_get_help (context, FALSE, NULL));
+      return 1;
+    }
+
+  gtk_init ();
+
+  provider = gtk_css_provider_new ();
+  g_signal_connect (provider, "parsing-error", G_CALLBACK (parsing_error_cb), &failed);
+  gtk_css_provider_load_from_path (provider, argv[1]);
+
+  if (failed)
+    return 1;
+
+  bytes = gtk_css_provider_to_bytes (provider);
+
+  if (output)
+    path = g_strdup (output);
+  else
+    path = g_strconcat (argv[1], ".compiled", NULL);
+
+  if (!g_file_set_contents (path,
+                            g_bytes_get_data (bytes, NULL),
+                            g_bytes_get_size (bytes),
+                            &error))
+    {
+      g_printerr (_("Can't save file %s: %s\n"), path, error->message);
+      return 1;
+    }
+
+  g_free (path);
+  g_bytes_unref (bytes);
+  g_object_unref (provider);
+  g_option_context_free (context);
+
+  return 0;
+}
@@ -1048,6 +1048,85 @@ do_preview (int          *argc,
   g_free (css);
 }
 
+static void
+do_precompile (int          *argc,
+               const char ***argv)
+{
+  GtkBuilder *builder;
+  gchar *buffer;
+  gsize length;
+  GBytes *bytes;
+  gchar *output = NULL;
+  char **filenames = NULL;
+  GOptionContext *ctx;
+  const GOptionEntry entries[] = {
+    { "output", 0, 0, G_OPTION_ARG_FILENAME, &output, NULL, NULL },
+    { G_OPTION_REMAINING, 0, 0, G_OPTION_ARG_FILENAME_ARRAY, &filenames, NULL, NULL },
+    { NULL, }
+  };
+  GError *error = NULL;
+
+  ctx = g_option_context_new (NULL);
+  g_option_context_set_help_enabled (ctx, FALSE);
+  g_option_context_add_main_entries (ctx, entries, NULL);
+
+  if (!g_option_context_parse (ctx, argc, (char ***)argv, &error))
+    {
+      g_printerr ("%s\n", error->message);
+      g_error_free (error);
+      exit (1);
+    }
+
+  g_option_context_free (ctx);
+
+  if (filenames == NULL)
+    {
+      g_printerr ("No .ui file specified\n");
+      exit (1);
+    }
+
+  if (g_strv_length (filenames) > 1)
+    {
+      g_printerr ("Can only precompile a single .ui file\n");
+      exit (1);
+    }
+
+  if (!g_file_get_contents (filenames[0], &buffer, &length, &error))
+    {
+      g_printerr (_("Can’t load file: %s\n"), error->message);
+      exit (1);
+    }
+
+  builder = gtk_builder_new ();
+  bytes = _gtk_builder_precompile (builder, buffer, length, &error);
+  g_object_unref (builder);
+
+  if (bytes == NULL)
+    {
+      g_printerr (_("Can’t parse file: %s\n"), error->message);
+      exit (1);
+    }
+
+  if (output)
+    {
+      if (!g_file_set_contents (output,
+                                g_bytes_get_data (bytes, NULL),
+                                g_bytes_get_size (bytes),
+                                &error))
+        {
+          g_printerr (_("Can’t save file: %s\n"), error->message);
+          exit (1);
+        }
+    }
+  else
+    fwrite (g_bytes_get_data (bytes, NULL), 1, g_bytes_get_size (bytes), stdout);
+
+  g_bytes_unref (bytes);
+  g_free (buffer);
+  g_free (output);
+  g_strfreev (filenames);
+}
+
 static void
 usage (void)
 {
@@ -1059,6 +1138,7 @@ usage (void)
              "  simplify [OPTIONS] Simplify the file\n"
              "  enumerate          List all named objects\n"
              "  preview [OPTIONS]  Preview the file\n"
+             "  precompile         Write the file in binary form\n"
              "\n"
              "Simplify Options:\n"
              "  --replace          Replace the file\n"
@@ -1067,6 +1147,9 @@ usage (void)
              "  --id=ID            Preview only the named object\n"
              "  --css=FILE         Use style from CSS file\n"
              "\n"
+             "Precompile Options:\n"
+             "  --output=FILE      Write to FILE instead of stdout\n"
+             "\n"
              "Perform various tasks on GtkBuilder .ui files.\n"));
   exit (1);
 }
@@ -1097,6 +1180,8 @@ main (int argc, const char *argv[])
     do_enumerate (argv[1]);
   else if (strcmp (argv[0], "preview") == 0)
     do_preview (&argc, &argv);
+  else if (strcmp (argv[0], "precompile") == 0)
+    do_precompile (&argc, &argv);
   else
     usage ();
 
@@ -27,6 +27,7 @@
 
 #include <libavcodec/avcodec.h>
 #include <libavformat/avformat.h>
+#include <libavutil/hwcontext.h>
 #include <libavutil/pixdesc.h>
 #include <libswscale/swscale.h>
 
@@ -34,7 +35,8 @@ typedef struct _GtkVideoFrameFFMpeg GtkVideoFrameFFMpeg;
 
 struct _GtkVideoFrameFFMpeg
 {
-  GdkTexture *texture;
+  AVFrame *frame;
+  GdkTexture *texture; /* created on demand, frames that are skipped never get one */
   gint64 timestamp;
 };
 
@@ -51,12 +53,20 @@ struct _GtkFfMediaFile
   struct SwsContext *sws_ctx;
   enum AVPixelFormat sws_pix_fmt;
   GdkMemoryFormat memory_format;
+  AVBufferRef *hw_device_ctx;
+  enum AVPixelFormat hw_pix_fmt;
 
   GtkVideoFrameFFMpeg current_frame;
   GtkVideoFrameFFMpeg next_frame;
 
   gint64 start_time; /* monotonic time when we displayed the last frame */
   guint next_frame_cb; /* Source ID of next frame callback */
+
+  GdkSurface *surface; /* first surface we were realized on */
+  guint surface_realize_count;
+  GdkFrameClock *frame_clock;
+  gulong update_handler;
+  guint updating : 1;
 };
 
 struct _GtkFfMediaFileClass
@@ -66,16 +76,19 @@ struct _GtkFfMediaFileClass
 
 static void
 gtk_video_frame_ffmpeg_init (GtkVideoFrameFFMpeg *frame,
-                             GdkTexture          *texture,
+                             AVFrame             *av_frame,
                              gint64               timestamp)
 {
-  frame->texture = texture;
+  frame->frame = av_frame;
+  frame->texture = NULL;
   frame->timestamp = timestamp;
 }
 
 static void
 gtk_video_frame_ffmpeg_clear (GtkVideoFrameFFMpeg *frame)
 {
+  if (frame->frame)
+    av_frame_free (&frame->frame);
   g_clear_object (&frame->texture);
   frame->timestamp = 0;
 }
@@ -83,7 +96,7 @@ gtk_video_frame_ffmpeg_clear (GtkVideoFrameFFMpeg *frame)
 static gboolean
 gtk_video_frame_ffmpeg_is_empty (GtkVideoFrameFFMpeg *frame)
 {
-  return frame->texture == NULL;
+  return frame->frame == NULL;
 }
 
 static void
@@ -91,10 +104,15 @@ gtk_video_frame_ffmpeg_move (GtkVideoFrameFFMpeg *dest,
                              GtkVideoFrameFFMpeg *src)
 {
   *dest = *src;
+  src->frame = NULL;
   src->texture = NULL;
   src->timestamp = 0;
 }
 
+static GdkTexture *
+gtk_ff_media_file_get_texture (GtkFfMediaFile      *video,
+                               GtkVideoFrameFFMpeg *frame);
+
 static void
 gtk_ff_media_file_paintable_snapshot (GdkPaintable *paintable,
                                       GdkSnapshot  *snapshot,
@@ -105,7 +123,10 @@ gtk_ff_media_file_paintable_snapshot (GdkPaintable *paintable,
 
   if (!gtk_video_frame_ffmpeg_is_empty (&video->current_frame))
     {
-      gdk_paintable_snapshot (GDK_PAINTABLE (video->current_frame.texture), snapshot, width, height);
+      GdkTexture *texture = gtk_ff_media_file_get_texture (video, &video->current_frame);
+
+      if (texture)
+        gdk_paintable_snapshot (GDK_PAINTABLE (texture), snapshot, width, height);
     }
 }
 
@@ -113,8 +134,14 @@ static GdkPaintable *
 gtk_ff_media_file_paintable_get_current_image (GdkPaintable *paintable)
 {
   GtkFfMediaFile *video = GTK_FF_MEDIA_FILE (paintable);
+  GdkTexture *texture;
 
   if (gtk_video_frame_ffmpeg_is_empty (&video->current_frame))
+    texture = NULL;
+  else
+    texture = gtk_ff_media_file_get_texture (video, &video->current_frame);
+
+  if (texture == NULL)
     {
       if (video->codec_ctx)
         return gdk_paintable_new_empty (video->codec_ctx->width, video->codec_ctx->height);
@@ -122,7 +149,7 @@ gtk_ff_media_file_paintable_get_current_image (GdkPaintable *paintable)
         return gdk_paintable_new_empty (0, 0);
     }
 
-  return GDK_PAINTABLE (g_object_ref (video->current_frame.texture));
+  return GDK_PAINTABLE (g_object_ref (texture));
 }
 
 static int
@@ -267,12 +294,9 @@ static gboolean
 gtk_ff_media_file_decode_frame (GtkFfMediaFile      *video,
                                 GtkVideoFrameFFMpeg *result)
 {
-  GdkTexture *texture;
   AVPacket packet;
   AVFrame *frame;
   int errnum;
-  GBytes *bytes;
-  guchar *data;
 
   frame = av_frame_alloc ();
 
@@ -309,6 +333,44 @@ gtk_ff_media_file_decode_frame (GtkFfMediaFile      *video,
       return FALSE;
     }
 
+  gtk_video_frame_ffmpeg_init (result,
+                               frame,
+                               av_rescale_q (frame->best_effort_timestamp,
+                                             video->format_ctx->streams[video->stream_id]->time_base,
+                                             (AVRational) { 1, G_USEC_PER_SEC }));
+
+  return TRUE;
+}
+
+/* Converting a frame to RGB is the expensive part of decoding, so it is
+ * only done for frames that actually get drawn. */
+static GdkTexture *
+gtk_ff_media_file_get_texture (GtkFfMediaFile      *video,
+                               GtkVideoFrameFFMpeg *result)
+{
+  AVFrame *frame = result->frame;
+  AVFrame *sw_frame = NULL;
+  GBytes *bytes;
+  guchar *data;
+  int errnum;
+
+  if (result->texture)
+    return result->texture;
+
+  if (video->hw_device_ctx != NULL && frame->format == video->hw_pix_fmt)
+    {
+      /* Hardware frames stay on the GPU until they are drawn */
+      sw_frame = av_frame_alloc ();
+      errnum = av_hwframe_transfer_data (sw_frame, frame, 0);
+      if (errnum < 0)
+        {
+          gtk_ff_media_file_set_ffmpeg_error (video, errnum);
+          av_frame_free (&sw_frame);
+          return NULL;
+        }
+      frame = sw_frame;
+    }
+
   data = g_try_malloc0 (video->codec_ctx->width * video->codec_ctx->height * 4);
   if (data == NULL)
     {
@@ -316,8 +378,9 @@ gtk_ff_media_file_decode_frame (GtkFfMediaFile      *video,
                               G_IO_ERROR,
                               G_IO_ERROR_FAILED,
                               _("Not enough memory"));
-      av_frame_free (&frame);
-      return FALSE;
+      if (sw_frame)
+        av_frame_free (&sw_frame);
+      return NULL;
     }
 
   if (video->sws_ctx == NULL ||
@@ -354,24 +417,19 @@ gtk_ff_media_file_decode_frame (GtkFfMediaFile      *video,
             0, video->codec_ctx->height,
             (uint8_t *[1]) { data }, (int[1]) { video->codec_ctx->width * 4 });
 
+  if (sw_frame)
+    av_frame_free (&sw_frame);
+
   bytes = g_bytes_new_take (data, video->codec_ctx->width * video->codec_ctx->height * 4);
-  texture = gdk_memory_texture_new (video->codec_ctx->width,
-                                    video->codec_ctx->height,
-                                    video->memory_format,
-                                    bytes,
-                                    video->codec_ctx->width * 4);
+  result->texture = gdk_memory_texture_new (video->codec_ctx->width,
+                                            video->codec_ctx->height,
+                                            video->memory_format,
+                                            bytes,
+                                            video->codec_ctx->width * 4);
 
   g_bytes_unref (bytes);
 
-  gtk_video_frame_ffmpeg_init (result,
-                               texture,
-                               av_rescale_q (frame->best_effort_timestamp,
-                                             video->format_ctx->streams[video->stream_id]->time_base,
-                                             (AVRational) { 1, G_USEC_PER_SEC }));
-
-  av_frame_free (&frame);
-
-  return TRUE;
+  return result->texture;
 }
 
 static int64_t
@@ -472,6 +530,66 @@ gtk_ff_media_file_create_io_context (GtkFfMediaFile *video)
   return result;
 }
 
+#if LIBAVCODEC_VERSION_INT >= AV_VERSION_INT (58, 18, 100)
+static enum AVPixelFormat
+gtk_ff_media_file_get_format_cb (AVCodecContext           *codec_ctx,
+                                 const enum AVPixelFormat *pix_fmts)
+{
+  GtkFfMediaFile *video = codec_ctx->opaque;
+  const enum AVPixelFormat *p;
+
+  for (p = pix_fmts; *p != AV_PIX_FMT_NONE; p++)
+    {
+      if (*p == video->hw_pix_fmt)
+        return *p;
+    }
+
+  /* The stream can't be decoded in hardware, fall back to software */
+  return avcodec_default_get_format (codec_ctx, pix_fmts);
+}
+
+static void
+gtk_ff_media_file_setup_hwaccel (GtkFfMediaFile *video,
+                                 AVCodec        *codec)
+{
+  static const enum AVHWDeviceType device_types[] = {
+    AV_HWDEVICE_TYPE_VAAPI,
+    AV_HWDEVICE_TYPE_VDPAU
+  };
+  const char *env;
+  guint i;
+  int j;
+
+  env = g_getenv ("GTK_FFMPEG_HWACCEL");
+  if (env != NULL && g_str_equal (env, "0"))
+    return;
+
+  for (i = 0; i < G_N_ELEMENTS (device_types); i++)
+    {
+      for (j = 0; ; j++)
+        {
+          const AVCodecHWConfig *config = avcodec_get_hw_config (codec, j);
+
+          if (config == NULL)
+            break;
+
+          if ((config->methods & AV_CODEC_HW_CONFIG_METHOD_HW_DEVICE_CTX) == 0 ||
+              config->device_type != device_types[i])
+            continue;
+
+          if (av_hwdevice_ctx_create (&video->hw_device_ctx, device_types[i], NULL, NULL, 0) < 0)
+            break;
+
+          video->hw_pix_fmt = config->pix_fmt;
+          video->codec_ctx->hw_device_ctx = av_buffer_ref (video->hw_device_ctx);
+          video->codec_ctx->opaque = video;
+          video->codec_ctx->get_format = gtk_ff_media_file_get_format_cb;
+          return;
+        }
+    }
+}
+#endif
+
 static gboolean gtk_ff_media_file_play (GtkMediaStream *stream);
 
 static void
@@ -542,6 +660,9 @@ gtk_ff_media_file_open (GtkMediaFile *file)
       gtk_ff_media_file_set_ffmpeg_error (video, errnum);
       return;
     }
+#if LIBAVCODEC_VERSION_INT >= AV_VERSION_INT (58, 18, 100)
+  gtk_ff_media_file_setup_hwaccel (video, codec);
+#endif
   errnum = avcodec_open2 (video->codec_ctx, codec, &stream->metadata);
   if (errnum < 0)
     {
@@ -575,6 +696,8 @@ gtk_ff_media_file_close (GtkMediaFile *file)
 
   g_clear_pointer (&video->sws_ctx, sws_freeContext);
   g_clear_pointer (&video->codec_ctx, avcodec_close);
+  av_buffer_unref (&video->hw_device_ctx);
+  video->hw_pix_fmt = AV_PIX_FMT_NONE;
   avformat_close_input (&video->format_ctx);
   video->stream_id = -1;
   gtk_video_frame_ffmpeg_clear (&video->next_frame);
@@ -592,6 +715,17 @@ gtk_ff_media_file_queue_frame (GtkFfMediaFile *video)
   gint64 time, frame_time;
   guint delay;
 
+  if (video->frame_clock)
+    {
+      /* Frames are picked in the frame clock's update phase */
+      if (!video->updating)
+        {
+          gdk_frame_clock_begin_updating (video->frame_clock);
+          video->updating = TRUE;
+        }
+      return;
+    }
+
   time = g_get_monotonic_time ();
   frame_time = video->start_time + video->next_frame.timestamp;
   delay = time > frame_time ? 0 : (frame_time - time) / 1000;
@@ -616,20 +750,18 @@ gtk_ff_media_file_restart (GtkFfMediaFile *video)
   return TRUE;
 }
 
+/* Makes the next frame the current one. Returns FALSE if the
+ * stream has ended. */
 static gboolean
-gtk_ff_media_file_next_frame_cb (gpointer data)
+gtk_ff_media_file_advance (GtkFfMediaFile *video)
 {
-  GtkFfMediaFile *video = data;
-
-  video->next_frame_cb = 0;
-
   if (gtk_video_frame_ffmpeg_is_empty (&video->next_frame))
     {
       if (!gtk_media_stream_get_loop (GTK_MEDIA_STREAM (video)) ||
           !gtk_ff_media_file_restart (video))
         {
           gtk_media_stream_ended (GTK_MEDIA_STREAM (video));
-          return G_SOURCE_REMOVE;
+          return FALSE;
         }
 
       video->start_time += video->current_frame.timestamp - video->next_frame.timestamp;
@@ -639,18 +771,84 @@ gtk_ff_media_file_next_frame_cb (gpointer data)
   gtk_video_frame_ffmpeg_move (&video->current_frame,
                                &video->next_frame);
 
+  /* ignore failure here, we'll handle the empty frame case above
+   * the next time we're called. */
+  gtk_ff_media_file_decode_frame (video, &video->next_frame);
+
+  return TRUE;
+}
+
+static gboolean
+gtk_ff_media_file_next_frame_cb (gpointer data)
+{
+  GtkFfMediaFile *video = data;
+
+  video->next_frame_cb = 0;
+
+  if (!gtk_ff_media_file_advance (video))
+    return G_SOURCE_REMOVE;
+
   gtk_media_stream_update (GTK_MEDIA_STREAM (video),
                            video->current_frame.timestamp);
   gdk_paintable_invalidate_contents (GDK_PAINTABLE (video));
 
-  /* ignore failure here, we'll handle the empty frame case above
-   * the next time we're called. */
-  gtk_ff_media_file_decode_frame (video, &video->next_frame);
   gtk_ff_media_file_queue_frame (video);
 
   return G_SOURCE_REMOVE;
 }
 
+static void
+gtk_ff_media_file_stop_updating (GtkFfMediaFile *video)
+{
+  if (!video->updating)
+    return;
+
+  gdk_frame_clock_end_updating (video->frame_clock);
+  video->updating = FALSE;
+}
+
+static void
+gtk_ff_media_file_frame_clock_update (GdkFrameClock  *frame_clock,
+                                      GtkFfMediaFile *video)
+{
+  gint64 frame_time, presentation_time, refresh_interval;
+  gboolean advanced = FALSE;
+
+  if (!video->updating)
+    return;
+
+  /* Show the last frame that is due when this frame is expected to hit
+   * the screen. Frames due before that would never be seen, so they are
+   * dropped without converting them. */
+  frame_time = gdk_frame_clock_get_frame_time (frame_clock);
+  gdk_frame_clock_get_refresh_info (frame_clock,
+                                    frame_time,
+                                    &refresh_interval,
+                                    &presentation_time);
+  if (presentation_time == 0)
+    presentation_time = frame_time + refresh_interval;
+
+  while (gtk_video_frame_ffmpeg_is_empty (&video->next_frame)
+         ? !advanced
+         : video->start_time + video->next_frame.timestamp <= presentation_time)
+    {
+      if (!gtk_ff_media_file_advance (video))
+        {
+          gtk_ff_media_file_stop_updating (video);
+          break;
+        }
+
+      advanced = TRUE;
+    }
+
+  if (advanced)
+    {
+      gtk_media_stream_update (GTK_MEDIA_STREAM (video),
+                               video->current_frame.timestamp);
+      gdk_paintable_invalidate_contents (GDK_PAINTABLE (video));
+    }
+}
+
 static gboolean
 gtk_ff_media_file_play (GtkMediaStream *stream)
 {
@@ -694,10 +892,70 @@ gtk_ff_media_file_pause (GtkMediaStream *stream)
       g_source_remove (video->next_frame_cb);
       video->next_frame_cb = 0;
     }
+  gtk_ff_media_file_stop_updating (video);
 
   video->start_time = 0;
 }
 
+static void
+gtk_ff_media_file_realize (GtkMediaStream *stream,
+                           GdkSurface     *surface)
+{
+  GtkFfMediaFile *video = GTK_FF_MEDIA_FILE (stream);
+  gboolean playing;
+
+  if (video->surface != NULL)
+    {
+      if (video->surface == surface)
+        video->surface_realize_count++;
+      return;
+    }
+
+  /* Switch from timeouts to the frame clock */
+  playing = video->next_frame_cb != 0;
+  if (playing)
+    {
+      g_source_remove (video->next_frame_cb);
+      video->next_frame_cb = 0;
+    }
+
+  video->surface = surface;
+  video->surface_realize_count = 1;
+  video->frame_clock = g_object_ref (gdk_surface_get_frame_clock (surface));
+  video->update_handler = g_signal_connect (video->frame_clock, "update",
+                                            G_CALLBACK (gtk_ff_media_file_frame_clock_update),
+                                            video);
+
+  if (playing)
+    gtk_ff_media_file_queue_frame (video);
+}
+
+static void
+gtk_ff_media_file_unrealize (GtkMediaStream *stream,
+                             GdkSurface     *surface)
+{
+  GtkFfMediaFile *video = GTK_FF_MEDIA_FILE (stream);
+  gboolean playing;
+
+  if (video->surface != surface)
+    return;
+
+  video->surface_realize_count--;
+  if (video->surface_realize_count > 0)
+    return;
+
+  playing = video->updating;
+  gtk_ff_media_file_stop_updating (video);
+
+  g_signal_handler_disconnect (video->frame_clock, video->update_handler);
+  video->update_handler = 0;
+  g_clear_object (&video->frame_clock);
+  video->surface = NULL;
+
+  if (playing)
+    gtk_ff_media_file_queue_frame (video);
+}
+
 static void
 gtk_ff_media_file_seek (GtkMediaStream *stream,
                         gint64          timestamp)
@@ -756,6 +1014,8 @@ gtk_ff_media_file_class_init (GtkFfMediaFileClass *klass)
   stream_class->play = gtk_ff_media_file_play;
   stream_class->pause = gtk_ff_media_file_pause;
   stream_class->seek = gtk_ff_media_file_seek;
+  stream_class->realize = gtk_ff_media_file_realize;
+  stream_class->unrealize = gtk_ff_media_file_unrealize;
 
   gobject_class->dispose = gtk_ff_media_file_dispose;
 }
@@ -764,6 +1024,7 @@ static void
 gtk_ff_media_file_init (GtkFfMediaFile *video)
 {
   video->stream_id = -1;
+  video->hw_pix_fmt = AV_PIX_FMT_NONE;
 }
 
 
@@ -88,6 +88,20 @@ gtk_gst_sink_set_caps (GstBaseSink * bsink, GstCaps * caps)
   return TRUE;
 }
 
+static gboolean
+gtk_gst_sink_propose_allocation (GstBaseSink *bsink,
+                                 GstQuery    *query)
+{
+  /* Let upstream hand us buffers with padded or offset planes, as
+   * decoders and dma-buf importers produce, instead of making it copy
+   * them into tightly packed ones. gst_video_frame_map() will read
+   * the layout from the meta.
+   */
+  gst_query_add_allocation_meta (query, GST_VIDEO_META_API_TYPE, NULL);
+
+  return TRUE;
+}
+
 static GdkMemoryFormat
 gtk_gst_memory_format_from_video (GstVideoFormat format)
 {
@@ -111,28 +125,44 @@ gtk_gst_memory_format_from_video (GstVideoFormat format)
   }
 }
 
+static void
+video_frame_free (GstVideoFrame *frame)
+{
+  gst_video_frame_unmap (frame);
+  g_slice_free (GstVideoFrame, frame);
+}
+
 static GdkTexture *
 gtk_gst_sink_texture_from_buffer (GtkGstSink *self,
                                   GstBuffer  *buffer)
 {
-  GstVideoFrame frame;
+  GstVideoFrame *frame;
   GdkTexture *texture;
   GBytes *bytes;
 
-  if (!gst_video_frame_map (&frame, &self->v_info, buffer, GST_MAP_READ))
-    return NULL;
+  frame = g_slice_new (GstVideoFrame);
 
-  bytes = g_bytes_new_with_free_func (frame.data[0],
-                                      frame.info.width * frame.info.stride[0],
-                                      (GDestroyNotify) gst_buffer_unref,
-                                      gst_buffer_ref (buffer));
-  texture = gdk_memory_texture_new (frame.info.width,
-                                    frame.info.height,
-                                    gtk_gst_memory_format_from_video (GST_VIDEO_FRAME_FORMAT (&frame)),
+  if (!gst_video_frame_map (frame, &self->v_info, buffer, GST_MAP_READ))
+    {
+      g_slice_free (GstVideoFrame, frame);
+      return NULL;
+    }
+
+  /* The texture uses the mapped memory in place, so the frame stays
+   * mapped, and the buffer alive, for as long as the texture needs it.
+   * Unmapping right away would be wrong for memory that isn't plain
+   * system memory, like dma-bufs that are only mmap()ed while mapped.
+   */
+  bytes = g_bytes_new_with_free_func (GST_VIDEO_FRAME_PLANE_DATA (frame, 0),
+                                      GST_VIDEO_FRAME_HEIGHT (frame) * GST_VIDEO_FRAME_PLANE_STRIDE (frame, 0),
+                                      (GDestroyNotify) video_frame_free,
+                                      frame);
+  texture = gdk_memory_texture_new (GST_VIDEO_FRAME_WIDTH (frame),
+                                    GST_VIDEO_FRAME_HEIGHT (frame),
+                                    gtk_gst_memory_format_from_video (GST_VIDEO_FRAME_FORMAT (frame)),
                                     bytes,
-                                    frame.info.stride[0]);
+                                    GST_VIDEO_FRAME_PLANE_STRIDE (frame, 0));
   g_bytes_unref (bytes);
-  gst_video_frame_unmap (&frame);
 
   return texture;
 }
@@ -227,6 +257,7 @@ gtk_gst_sink_class_init (GtkGstSinkClass * klass)
   gobject_class->dispose = gtk_gst_sink_dispose;
 
   gstbasesink_class->set_caps = gtk_gst_sink_set_caps;
+  gstbasesink_class->propose_allocation = gtk_gst_sink_propose_allocation;
   gstbasesink_class->get_times = gtk_gst_sink_get_times;
 
   gstvideosink_class->show_frame = gtk_gst_sink_show_frame;
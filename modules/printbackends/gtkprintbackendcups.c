@@ -42,6 +42,7 @@
 #include <cairo-ps.h>
 
 #include <glib/gstdio.h>
+#include <utime.h>
 #include <glib/gi18n-lib.h>
 #include <gmodule.h>
 
@@ -150,6 +151,8 @@ struct _GtkPrintBackendCups
   guint            avahi_service_browser_subscription_ids[2];
   gchar           *avahi_service_browser_paths[2];
   GCancellable    *avahi_cancellable;
+  /* services being resolved or resolved, as "name\ttype\tdomain" */
+  GHashTable      *avahi_services;
 #endif
   gboolean      secrets_service_available;
   guint         secrets_service_watch_id;
@@ -844,6 +847,7 @@ gtk_print_backend_cups_init (GtkPrintBackendCups *backend_cups)
   backend_cups->dbus_connection = NULL;
   backend_cups->avahi_default_printer = NULL;
   backend_cups->avahi_service_browser_subscription_id = 0;
+  backend_cups->avahi_services = g_hash_table_new_full (g_str_hash, g_str_equal, g_free, NULL);
   for (i = 0; i < 2; i++)
     {
       backend_cups->avahi_service_browser_paths[i] = NULL;
@@ -888,6 +892,7 @@ gtk_print_backend_cups_finalize (GObject *object)
 #ifdef HAVE_CUPS_API_1_6
   g_clear_object (&backend_cups->avahi_cancellable);
   g_clear_pointer (&backend_cups->avahi_default_printer, g_free);
+  g_clear_pointer (&backend_cups->avahi_services, g_hash_table_unref);
   g_clear_object (&backend_cups->dbus_connection);
 #endif
 
@@ -1886,7 +1891,8 @@ static const char * const printer_attrs[] =
     "multiple-document-handling-supported",
     "copies-supported",
     "number-up-supported",
-    "device-uri"
+    "device-uri",
+    "printer-config-change-time"
   };
 
 /* Attributes we're interested in for printers without PPD */
@@ -1984,6 +1990,7 @@ typedef struct
   gchar    *output_bin_default;
   GList    *output_bin_supported;
   gchar    *original_device_uri;
+  gint      config_change_time;
 } PrinterSetupInfo;
 
 static void
@@ -2189,6 +2196,10 @@ cups_printer_handle_attribute (GtkPrintBackendCups *cups_backend,
     {
       info->default_number_up = ippGetInteger (attr, 0);
     }
+  else if (strcmp (ippGetName (attr), "printer-config-change-time") == 0)
+    {
+      info->config_change_time = ippGetInteger (attr, 0);
+    }
   else if (g_strcmp0 (ippGetName (attr), "ipp-versions-supported") == 0)
     {
       guchar server_ipp_version_major;
@@ -3022,11 +3033,18 @@ avahi_txt_get_key_value_pair (const gchar  *entry,
   return FALSE;
 }
 
+typedef struct
+{
+  GtkPrintBackendCups *backend;
+  gchar               *service;
+} AvahiResolveData;
+
 static void
 avahi_service_resolver_cb (GObject      *source_object,
                            GAsyncResult *res,
                            gpointer      user_data)
 {
+  AvahiResolveData        *resolve = user_data;
   AvahiConnectionTestData *data;
   GtkPrintBackendCups     *backend;
   const gchar             *name;
@@ -3058,7 +3076,7 @@ avahi_service_resolver_cb (GObject      *source_object,
                                           &error);
   if (output)
     {
-      backend = GTK_PRINT_BACKEND_CUPS (user_data);
+      backend = resolve->backend;
 
       g_variant_get (output, "(ii&s&s&s&si&sq@aayu)",
                      &interface,
@@ -3177,9 +3195,17 @@ avahi_service_resolver_cb (GObject      *source_object,
   else
     {
       if (!g_error_matches (error, G_IO_ERROR, G_IO_ERROR_CANCELLED))
-        g_warning ("%s", error->message);
+        {
+          g_warning ("%s", error->message);
+
+          /* Let another announcement of it try again */
+          g_hash_table_remove (resolve->backend->avahi_services, resolve->service);
+        }
       g_error_free (error);
     }
+
+  g_free (resolve->service);
+  g_free (resolve);
 }
 
 static void
@@ -3212,6 +3238,23 @@ avahi_service_browser_signal_handler (GDBusConnection *connection,
       if (g_strcmp0 (type, "_ipp._tcp") == 0 ||
           g_strcmp0 (type, "_ipps._tcp") == 0)
         {
+          AvahiResolveData *resolve;
+          gchar *service;
+
+          /* The same printer is announced once per interface and
+           * protocol, but one of them is enough */
+          service = g_strjoin ("\t", name, type, domain, NULL);
+          if (g_hash_table_contains (backend->avahi_services, service))
+            {
+              g_free (service);
+              return;
+            }
+          g_hash_table_add (backend->avahi_services, service);
+
+          resolve = g_new0 (AvahiResolveData, 1);
+          resolve->backend = backend;
+          resolve->service = g_strdup (service);
+
           g_dbus_connection_call (backend->dbus_connection,
                                   AVAHI_BUS,
                                   "/",
@@ -3230,7 +3273,7 @@ avahi_service_browser_signal_handler (GDBusConnection *connection,
                                   -1,
                                   backend->avahi_cancellable,
                                   avahi_service_resolver_cb,
-                                  user_data);
+                                  resolve);
         }
     }
   else if (g_strcmp0 (signal_name, "ItemRemove") == 0)
@@ -3249,6 +3292,11 @@ avahi_service_browser_signal_handler (GDBusConnection *connection,
           GtkPrinterCups *printer;
           GList          *list;
           GList          *iter;
+          gchar          *service;
+
+          service = g_strjoin ("\t", name, type, domain, NULL);
+          g_hash_table_remove (backend->avahi_services, service);
+          g_free (service);
 
           list = gtk_print_backend_get_printer_list (GTK_PRINT_BACKEND (backend));
           for (iter = list; iter; iter = iter->next)
@@ -3582,6 +3630,7 @@ cups_request_printer_list_cb (GtkPrintBackendCups *cups_backend,
         }
 
       GTK_PRINTER_CUPS (printer)->state = info->state;
+      GTK_PRINTER_CUPS (printer)->config_change_time = info->config_change_time;
       GTK_PRINTER_CUPS (printer)->ipp_version_major = info->ipp_version_major;
       GTK_PRINTER_CUPS (printer)->ipp_version_minor = info->ipp_version_minor;
       GTK_PRINTER_CUPS (printer)->supports_copies = info->supports_copies;
@@ -3749,6 +3798,108 @@ typedef struct {
   http_t *http;
 } GetPPDData;
 
+/* Downloaded PPDs are kept in the user's cache directory, named after
+ * the printer URI. The file's modification time is set to the printer's
+ * printer-config-change-time, which CUPS bumps whenever the PPD or the
+ * queue's configuration changes, so a mismatch means it is stale.
+ */
+static gchar *
+ppd_cache_get_filename (GtkPrinterCups *printer)
+{
+  gchar *checksum;
+  gchar *basename;
+  gchar *filename;
+
+  if (printer->printer_uri == NULL ||
+      printer->config_change_time <= 0)
+    return NULL;
+
+#ifdef HAVE_CUPS_API_1_6
+  /* These get their details over IPP, not from the PPD */
+  if (printer->avahi_browsed)
+    return NULL;
+#endif
+
+  checksum = g_compute_checksum_for_string (G_CHECKSUM_SHA1, printer->printer_uri, -1);
+  basename = g_strconcat (checksum, ".ppd", NULL);
+  filename = g_build_filename (g_get_user_cache_dir (), "gtk-4.0", "cups-ppds", basename, NULL);
+  g_free (basename);
+  g_free (checksum);
+
+  return filename;
+}
+
+static gboolean
+ppd_cache_load (GtkPrinterCups *printer)
+{
+  GStatBuf st;
+  gchar *filename;
+
+  filename = ppd_cache_get_filename (printer);
+  if (filename == NULL)
+    return FALSE;
+
+  if (g_stat (filename, &st) != 0 ||
+      st.st_mtime != printer->config_change_time ||
+      st.st_size == 0)
+    {
+      g_free (filename);
+      return FALSE;
+    }
+
+  printer->ppd_file = ppdOpenFile (filename);
+  if (printer->ppd_file == NULL)
+    {
+      g_unlink (filename);
+      g_free (filename);
+      return FALSE;
+    }
+
+  GTK_NOTE (PRINTING,
+            g_print ("CUPS Backend: Using cached PPD %s for %s\n", filename, printer->printer_uri));
+
+  ppdLocalize (printer->ppd_file);
+  ppdMarkDefaults (printer->ppd_file);
+
+  g_free (filename);
+
+  return TRUE;
+}
+
+static void
+ppd_cache_save (GtkPrinterCups *printer,
+                GIOChannel     *ppd_io)
+{
+  struct utimbuf times;
+  gchar *filename;
+  gchar *dirname;
+  gchar *contents;
+  gsize length;
+
+  filename = ppd_cache_get_filename (printer);
+  if (filename == NULL)
+    return;
+
+  g_io_channel_seek_position (ppd_io, 0, G_SEEK_SET, NULL);
+  if (g_io_channel_read_to_end (ppd_io, &contents, &length, NULL) != G_IO_STATUS_NORMAL)
+    {
+      g_free (filename);
+      return;
+    }
+
+  dirname = g_path_get_dirname (filename);
+  g_mkdir_with_parents (dirname, 0700);
+
+  times.actime = times.modtime = printer->config_change_time;
+  if (length > 0 &&
+      g_file_set_contents (filename, contents, length, NULL))
+    g_utime (filename, &times);
+
+  g_free (dirname);
+  g_free (contents);
+  g_free (filename);
+}
+
 static void
 get_ppd_data_free (GetPPDData *data)
 {
@@ -3802,6 +3953,9 @@ cups_request_ppd_cb (GtkPrintBackendCups *print_backend,
       data->printer->ppd_file = ppdOpenFd (dup (g_io_channel_unix_get_fd (data->ppd_io)));
       ppdLocalize (data->printer->ppd_file);
       ppdMarkDefaults (data->printer->ppd_file);
+
+      if (data->printer->ppd_file)
+        ppd_cache_save (data->printer, data->ppd_io);
     }
 
 #ifdef HAVE_CUPS_API_1_6
@@ -4253,6 +4407,13 @@ cups_printer_request_details (GtkPrinter *printer)
   if (!cups_printer->reading_ppd &&
       gtk_printer_cups_get_ppd (cups_printer) == NULL)
     {
+      if (ppd_cache_load (cups_printer))
+        {
+          gtk_printer_set_has_details (printer, TRUE);
+          g_signal_emit_by_name (printer, "details-acquired", TRUE);
+          return;
+        }
+
       if (cups_printer->remote
 #ifdef HAVE_CUPS_API_1_6
           && !cups_printer->avahi_browsed
@@ -358,7 +358,8 @@ typedef struct {
   GtkPrintBackend *backend;
   GtkPrintJobCompleteFunc callback;
   GtkPrintJob *job;
-  GFileOutputStream *target_io_stream;
+  GIOChannel *data_io;
+  gchar *uri;
   gpointer user_data;
   GDestroyNotify dnotify;
 } _PrintStreamData;
@@ -373,9 +374,6 @@ file_print_cb (GtkPrintBackendFile *print_backend,
   _PrintStreamData *ps = (_PrintStreamData *) user_data;
   GtkRecentManager *recent_manager;
 
-  if (ps->target_io_stream != NULL)
-    (void)g_output_stream_close (G_OUTPUT_STREAM (ps->target_io_stream), NULL, NULL);
-
   if (ps->callback)
     ps->callback (ps->job, ps->user_data, error);
 
@@ -387,68 +385,112 @@ file_print_cb (GtkPrintBackendFile *print_backend,
                               ? GTK_PRINT_STATUS_FINISHED_ABORTED
                               : GTK_PRINT_STATUS_FINISHED);
 
-  recent_manager = gtk_recent_manager_get_default ();
-  uri = output_file_from_settings (gtk_print_job_get_settings (ps->job), NULL);
-  gtk_recent_manager_add_item (recent_manager, uri);
-  g_free (uri);
+  if (error == NULL)
+    {
+      recent_manager = gtk_recent_manager_get_default ();
+      uri = output_file_from_settings (gtk_print_job_get_settings (ps->job), NULL);
+      gtk_recent_manager_add_item (recent_manager, uri);
+      g_free (uri);
+    }
 
   if (ps->job)
     g_object_unref (ps->job);
 
+  if (ps->data_io)
+    g_io_channel_unref (ps->data_io);
+
+  g_free (ps->uri);
   g_free (ps);
 }
 
-static gboolean
-file_write (GIOChannel   *source,
-            GIOCondition  con,
-            gpointer      user_data)
+/* Runs in a thread, since data_io may be a pipe that the job is still
+ * writing the pages into; it would block the main loop if we didn't
+ * keep up with it.
+ */
+static void
+file_write_thread (GTask        *task,
+                   gpointer      source_object,
+                   gpointer      task_data,
+                   GCancellable *cancellable)
 {
+  _PrintStreamData *ps = task_data;
   gchar buf[_STREAM_MAX_CHUNK_SIZE];
-  gsize bytes_read;
-  GError *error;
+  GFileOutputStream *target_io_stream = NULL;
+  GFile *file;
   GIOStatus read_status;
-  _PrintStreamData *ps = (_PrintStreamData *) user_data;
-
-  error = NULL;
-
-  read_status =
-    g_io_channel_read_chars (source,
-                             buf,
-                             _STREAM_MAX_CHUNK_SIZE,
-                             &bytes_read,
-                             &error);
+  gsize bytes_read;
+  GError *error = NULL;
 
-  if (read_status != G_IO_STATUS_ERROR)
+  if (ps->uri != NULL)
     {
-      gsize bytes_written;
-
-      g_output_stream_write_all (G_OUTPUT_STREAM (ps->target_io_stream),
-                                 buf,
-                                 bytes_read,
-                                 &bytes_written,
-                                 NULL,
-                                 &error);
+      file = g_file_new_for_uri (ps->uri);
+      target_io_stream = g_file_replace (file, NULL, FALSE, G_FILE_CREATE_NONE, cancellable, &error);
+      g_object_unref (file);
+    }
+  else
+    {
+      error = g_error_new_literal (G_IO_ERROR, G_IO_ERROR_INVALID_FILENAME,
+                                   _("No output file was set"));
     }
 
-  if (error != NULL || read_status == G_IO_STATUS_EOF)
+  while (TRUE)
     {
-      file_print_cb (GTK_PRINT_BACKEND_FILE (ps->backend), error, user_data);
+      read_status = g_io_channel_read_chars (ps->data_io,
+                                             buf,
+                                             _STREAM_MAX_CHUNK_SIZE,
+                                             &bytes_read,
+                                             error ? NULL : &error);
+
+      if (read_status == G_IO_STATUS_EOF ||
+          read_status == G_IO_STATUS_ERROR)
+        break;
 
-      if (error != NULL)
+      /* After an error, keep reading until the end anyway, the
+       * writer would block forever on a full pipe otherwise */
+      if (error == NULL)
         {
           GTK_NOTE (PRINTING,
-                    g_print ("FILE Backend: %s\n", error->message));
-
-          g_error_free (error);
+                    g_print ("FILE Backend: Writting %"G_GSIZE_FORMAT" byte chunk to target file\n", bytes_read));
+
+          g_output_stream_write_all (G_OUTPUT_STREAM (target_io_stream),
+                                     buf,
+                                     bytes_read,
+                                     NULL,
+                                     cancellable,
+                                     &error);
         }
+    }
+
+  /* Closing with a cancelled cancellable keeps the previous file */
+  if (target_io_stream != NULL)
+    {
+      g_output_stream_close (G_OUTPUT_STREAM (target_io_stream), cancellable, error ? NULL : &error);
+      g_object_unref (target_io_stream);
+    }
+
+  if (error != NULL)
+    g_task_return_error (task, error);
+  else
+    g_task_return_boolean (task, TRUE);
+}
 
-      return FALSE;
+static void
+file_write_done (GObject      *source_object,
+                 GAsyncResult *result,
+                 gpointer      user_data)
+{
+  _PrintStreamData *ps = user_data;
+  GError *error = NULL;
+
+  if (!g_task_propagate_boolean (G_TASK (result), &error))
+    {
+      GTK_NOTE (PRINTING,
+                g_print ("FILE Backend: %s\n", error->message));
     }
 
-  GTK_NOTE (PRINTING,
-            g_print ("FILE Backend: Writting %"G_GSIZE_FORMAT" byte chunk to target file\n", bytes_read));
+  file_print_cb (GTK_PRINT_BACKEND_FILE (source_object), error, ps);
 
-  return TRUE;
+  g_clear_error (&error);
 }
 
 static void
@@ -459,11 +501,9 @@ gtk_print_backend_file_print_stream (GtkPrintBackend        *print_backend,
 				     gpointer                user_data,
 				     GDestroyNotify          dnotify)
 {
-  GError *internal_error = NULL;
   _PrintStreamData *ps;
   GtkPrintSettings *settings;
-  gchar *uri;
-  GFile *file = NULL;
+  GTask *task;
 
   settings = gtk_print_job_get_settings (job);
 
@@ -473,33 +513,13 @@ gtk_print_backend_file_print_stream (GtkPrintBackend        *print_backend,
   ps->dnotify = dnotify;
   ps->job = g_object_ref (job);
   ps->backend = print_backend;
+  ps->data_io = g_io_channel_ref (data_io);
+  ps->uri = output_file_from_settings (settings, NULL);
 
-  internal_error = NULL;
-  uri = output_file_from_settings (settings, NULL);
-
-  if (uri == NULL)
-    goto error;
-
-  file = g_file_new_for_uri (uri);
-  ps->target_io_stream = g_file_replace (file, NULL, FALSE, G_FILE_CREATE_NONE, NULL, &internal_error);
-
-  g_object_unref (file);
-  g_free (uri);
-
-error:
-  if (internal_error != NULL)
-    {
-      file_print_cb (GTK_PRINT_BACKEND_FILE (print_backend),
-                     internal_error, ps);
-
-      g_error_free (internal_error);
-      return;
-    }
-
-  g_io_add_watch (data_io, 
-                  G_IO_IN | G_IO_PRI | G_IO_ERR | G_IO_HUP,
-                  (GIOFunc) file_write,
-                  ps);
+  task = g_task_new (print_backend, gtk_print_job_get_cancellable (job), file_write_done, ps);
+  g_task_set_task_data (task, ps, NULL);
+  g_task_run_in_thread (task, file_write_thread);
+  g_object_unref (task);
 }
 
 static void
@@ -521,6 +541,7 @@ gtk_print_backend_file_init (GtkPrintBackendFile *backend)
   gtk_print_backend_add_printer (GTK_PRINT_BACKEND (backend), printer);
   g_object_unref (printer);
 
+  gtk_print_backend_set_supports_streaming (GTK_PRINT_BACKEND (backend), TRUE);
   gtk_print_backend_set_list_done (GTK_PRINT_BACKEND (backend));
 }
 
@@ -107,6 +107,7 @@ gtk_printer_cups_init (GtkPrinterCups *printer)
   printer->port = 0;
   printer->ppd_name = NULL;
   printer->ppd_file = NULL;
+  printer->config_change_time = 0;
   printer->default_cover_before = NULL;
   printer->default_cover_after = NULL;
   printer->remote = FALSE;
@@ -58,6 +58,8 @@ struct _GtkPrinterCups
   gboolean reading_ppd;
   gchar      *ppd_name;
   ppd_file_t *ppd_file;
+  /* printer-config-change-time, 0 if unknown */
+  gint        config_change_time;
 
   gchar    *media_default;
   GList    *media_supported;
@@ -0,0 +1,227 @@
+/* -*- mode: C; c-basic-offset: 2; indent-tabs-mode: nil; -*- */
+
+/* Renders node files with several renderers and compares them:
+ *
+ *  first:   wall clock time of the first run, which fills the
+ *           glyph, texture and shadow caches
+ *  wall:    wall clock time of the other runs
+ *  cpu:     the renderer's CPU time for building and submitting
+ *           the frame
+ *  gpu:     the GPU time, if the renderer can measure it
+ *  draws:   draw calls
+ *  uploads: bytes uploaded to textures
+ *
+ * All but the first column are means over the runs after the first
+ * one. Times are in milliseconds. Use rendernode-create-tests to
+ * create large synthetic node files.
+ */
+
+#include <gtk/gtk.h>
+
+static char **renderers = NULL;
+static int runs = 10;
+static gboolean machine_readable = FALSE;
+
+static GOptionEntry options[] = {
+  { "renderer", 'R', 0, G_OPTION_ARG_STRING_ARRAY, &renderers, "Renderer to compare, can be given multiple times", "cairo|opengl|vulkan" },
+  { "runs", 'r', 0, G_OPTION_ARG_INT, &runs, "Render each file N times", "N" },
+  { "machine-readable", 0, 0, G_OPTION_ARG_NONE, &machine_readable, "Print results in columns", NULL },
+  { NULL }
+};
+
+static const struct {
+  const char *name;
+  const char *type_name;
+} known_renderers[] = {
+  { "cairo", "GskCairoRenderer" },
+  { "opengl", "GskGLRenderer" },
+  { "vulkan", "GskVulkanRenderer" },
+};
+
+static const char *default_renderers[] = { "cairo", "opengl", "vulkan", NULL };
+
+static gint64
+get_statistic (GVariant   *statistics,
+               const char *name)
+{
+  gint64 value;
+
+  if (!g_variant_lookup (statistics, name, "x", &value))
+    return 0;
+
+  return value;
+}
+
+/* Returns a renderer of the given kind, or NULL if it is not available.
+ * gsk_renderer_new_for_surface() picks the renderer named on the
+ * display first, like the inspector does, and falls back to others
+ * if that one can't be realized.
+ */
+static GskRenderer *
+create_renderer (GdkSurface *surface,
+                 const char *name)
+{
+  GdkDisplay *display = gdk_surface_get_display (surface);
+  GskRenderer *renderer;
+  guint i;
+
+  g_object_set_data_full (G_OBJECT (display), "gsk-renderer", g_strdup (name), g_free);
+  renderer = gsk_renderer_new_for_surface (surface);
+  g_object_set_data (G_OBJECT (display), "gsk-renderer", NULL);
+
+  for (i = 0; i < G_N_ELEMENTS (known_renderers); i++)
+    {
+      if (g_ascii_strcasecmp (known_renderers[i].name, name) == 0 &&
+          g_strcmp0 (known_renderers[i].type_name, G_OBJECT_TYPE_NAME (renderer)) == 0)
+        return renderer;
+    }
+
+  gsk_renderer_unrealize (renderer);
+  g_object_unref (renderer);
+
+  return NULL;
+}
+
+static void
+benchmark_renderer (GskRenderNode *node,
+                    const char    *filename,
+                    const char    *name)
+{
+  GdkSurface *surface;
+  GskRenderer *renderer;
+  GdkTexture *texture;
+  GVariant *statistics;
+  gint64 start, first;
+  gint64 wall = 0, cpu = 0, gpu = 0, draws = 0, uploads = 0;
+  int n, run;
+
+  surface = gdk_surface_new_toplevel (gdk_display_get_default (), 10, 10);
+  renderer = create_renderer (surface, name);
+  if (renderer == NULL)
+    {
+      if (machine_readable)
+        g_print ("%s\t%s\tunavailable\n", filename, name);
+      else
+        g_print ("  %-8s unavailable\n", name);
+      g_object_unref (surface);
+      return;
+    }
+
+  start = g_get_monotonic_time ();
+  texture = gsk_renderer_render_texture (renderer, node, NULL);
+  first = g_get_monotonic_time () - start;
+  g_object_unref (texture);
+
+  for (run = 1; run < runs; run++)
+    {
+      start = g_get_monotonic_time ();
+      texture = gsk_renderer_render_texture (renderer, node, NULL);
+      wall += g_get_monotonic_time () - start;
+      g_object_unref (texture);
+
+      statistics = gsk_renderer_get_statistics (renderer);
+      cpu += get_statistic (statistics, "cpu-time");
+      gpu += get_statistic (statistics, "gpu-time");
+      draws += get_statistic (statistics, "draw-calls");
+      uploads += get_statistic (statistics, "upload-bytes");
+      g_variant_unref (statistics);
+    }
+
+  n = MAX (runs - 1, 1);
+
+  if (machine_readable)
+    g_print ("%s\t%s\t%g\t%g\t%g\t%g\t%" G_GINT64_FORMAT "\t%" G_GINT64_FORMAT "\n",
+             filename, name,
+             first / 1000.,
+             wall / 1000. / n,
+             cpu / 1000000. / n,
+             gpu / 1000000. / n,
+             draws / n,
+             uploads / n);
+  else
+    g_print ("  %-8s first %8.3f  wall %8.3f  cpu %8.3f  gpu %8.3f  draws %6" G_GINT64_FORMAT "  uploads %10" G_GINT64_FORMAT "\n",
+             name,
+             first / 1000.,
+             wall / 1000. / n,
+             cpu / 1000000. / n,
+             gpu / 1000000. / n,
+             draws / n,
+             uploads / n);
+
+  gsk_renderer_unrealize (renderer);
+  g_object_unref (renderer);
+  g_object_unref (surface);
+}
+
+int
+main (int argc, char **argv)
+{
+  GOptionContext *context;
+  GskRenderNode *node;
+  GError *error = NULL;
+  GBytes *bytes;
+  char *contents;
+  gsize len;
+  int i, j;
+
+  context = g_option_context_new ("NODE-FILE…");
+  g_option_context_add_main_entries (context, options, NULL);
+  if (!g_option_context_parse (context, &argc, &argv, &error))
+    {
+      g_printerr ("Option parsing failed: %s\n", error->message);
+      return 1;
+    }
+
+  if (argc < 2)
+    {
+      g_printerr ("Usage: %s [OPTIONS] NODE-FILE…\n", argv[0]);
+      return 1;
+    }
+
+  if (runs < 2)
+    {
+      g_printerr ("Number of runs given with -r/--runs must be at least 2 and not %d.\n", runs);
+      return 1;
+    }
+
+  if (renderers == NULL)
+    renderers = g_strdupv ((char **) default_renderers);
+
+  gtk_init ();
+
+  if (machine_readable)
+    g_print ("file\trenderer\tfirst\twall\tcpu\tgpu\tdraws\tuploads\n");
+
+  for (i = 1; i < argc; i++)
+    {
+      if (!g_file_get_contents (argv[i], &contents, &len, &error))
+        {
+          g_printerr ("Could not open node file: %s\n", error->message);
+          g_clear_error (&error);
+          continue;
+        }
+
+      bytes = g_bytes_new_take (contents, len);
+      node = gsk_render_node_deserialize (bytes, &error);
+      g_bytes_unref (bytes);
+      if (node == NULL)
+        {
+          g_printerr ("Invalid node file %s: %s\n", argv[i], error->message);
+          g_clear_error (&error);
+          continue;
+        }
+
+      if (!machine_readable)
+        g_print ("%s:\n", argv[i]);
+
+      for (j = 0; renderers[j]; j++)
+        benchmark_renderer (node, argv[i], renderers[j]);
+
+      gsk_render_node_unref (node);
+    }
+
+  g_strfreev (renderers);
+  g_option_context_free (context);
+
+  return 0;
+}
@@ -225,6 +225,53 @@ clipped_colors (guint n)
   return container;
 }
 
+#define CLIP_DEPTH 8
+GskRenderNode *
+nested_clips (guint n)
+{
+  GskRenderNode **nodes = g_new (GskRenderNode *, n);
+  GskRenderNode *container;
+  GskRoundedRect rounded;
+  graphene_rect_t bounds;
+  GdkRGBA color;
+  guint i, j;
+
+  for (i = 0; i < n; i++)
+    {
+      bounds.size.width = g_random_int_range (20, 100);
+      bounds.origin.x = g_random_int_range (0, 1000 - bounds.size.width);
+      bounds.size.height = g_random_int_range (20, 100);
+      bounds.origin.y = g_random_int_range (0, 1000 - bounds.size.height);
+      hsv_to_rgb (&color, g_random_double (), g_random_double_range (0.15, 0.4), g_random_double_range (0.6, 0.85));
+      nodes[i] = gsk_color_node_new (&color, &bounds);
+
+      /* Alternate rectangular and rounded clips, each a bit smaller */
+      for (j = 0; j < CLIP_DEPTH; j++)
+        {
+          GskRenderNode *child = nodes[i];
+
+          graphene_rect_inset (&bounds, bounds.size.width / 32, bounds.size.height / 32);
+          if (j % 2)
+            {
+              gsk_rounded_rect_init_from_rect (&rounded, &bounds, MIN (bounds.size.width, bounds.size.height) / 4);
+              nodes[i] = gsk_rounded_clip_node_new (child, &rounded);
+            }
+          else
+            nodes[i] = gsk_clip_node_new (child, &bounds);
+
+          gsk_render_node_unref (child);
+        }
+    }
+
+  container = gsk_container_node_new (nodes, n);
+
+  for (i = 0; i < n; i++)
+    gsk_render_node_unref (nodes[i]);
+  g_free (nodes);
+
+  return container;
+}
+
 static int
 compare_color_stops (gconstpointer a,
                      gconstpointer b,
@@ -530,6 +577,7 @@ main (int argc, char **argv)
     { "cairo.node", cairo_node },
     { "colors.node", colors },
     { "clipped-colors.node", clipped_colors },
+    { "nested-clips.node", nested_clips },
     { "rounded-borders.node", rounded_borders },
     { "rounded-backgrounds.node", rounded_backgrounds },
     { "linear-gradient.node", linear_gradient },
@@ -113,8 +113,7 @@ main (int argc, char **argv)
 {
   GtkWidget *window;
   GtkWidget *nodeview;
-  char *contents;
-  gsize len;
+  GMappedFile *mapped_file;
   GBytes *bytes;
   graphene_rect_t node_bounds;
   GOptionContext *option_context;
@@ -144,14 +143,16 @@ main (int argc, char **argv)
 
   gtk_window_set_decorated (GTK_WINDOW (window), FALSE);
 
-  g_file_get_contents (argv[1], &contents, &len, &error);
+  mapped_file = g_mapped_file_new (argv[1], FALSE, &error);
   if (error)
     {
       g_warning ("%s", error->message);
       return -1;
     }
 
-  bytes = g_bytes_new_take (contents, len);
+  /* Textures reference the mapped data, which stays around as long as they do */
+  bytes = g_mapped_file_get_bytes (mapped_file);
+  g_mapped_file_unref (mapped_file);
   GTK_NODE_VIEW (nodeview)->node = gsk_render_node_deserialize (bytes, &error);
   g_bytes_unref (bytes);
 
@@ -0,0 +1,259 @@
+/* -*- mode: C; c-basic-offset: 2; indent-tabs-mode: nil; -*- */
+
+/* Measures how long it takes until an application is usable:
+ *
+ *  init:        gtk_init()
+ *  theme:       parsing the default theme into a new provider
+ *  builder:     creating the widgets from the UI file
+ *  layout:      the first layout phase of the window is done
+ *  paint:       the first frame is drawn
+ *  presented:   the first frame is on screen, according to the
+ *               frame timings, or the paint time if those don't
+ *               have presentation times
+ *  interactive: the main loop is idle after the first frame, so
+ *               input would be handled
+ *
+ * All times are in milliseconds since the program started. Each run
+ * measures one startup, use a loop in the shell to collect more.
+ */
+
+#include <gtk/gtk.h>
+
+/* Stub definition of MyTextView which is used in the
+ * widget-factory.ui file. We just need this so the
+ * test keeps working
+ */
+typedef struct
+{
+  GtkTextView tv;
+} MyTextView;
+
+typedef GtkTextViewClass MyTextViewClass;
+
+G_DEFINE_TYPE (MyTextView, my_text_view, GTK_TYPE_TEXT_VIEW)
+
+static void
+my_text_view_init (MyTextView *tv) {}
+
+static void
+my_text_view_class_init (MyTextViewClass *tv_class) {}
+
+typedef enum {
+  STAGE_INIT,
+  STAGE_THEME,
+  STAGE_BUILDER,
+  STAGE_LAYOUT,
+  STAGE_PAINT,
+  STAGE_PRESENTED,
+  STAGE_INTERACTIVE,
+  N_STAGES
+} Stage;
+
+static const char *stage_names[N_STAGES] = {
+  "init",
+  "theme",
+  "builder",
+  "layout",
+  "paint",
+  "presented",
+  "interactive"
+};
+
+static gint64 start_time;
+static gint64 stage_times[N_STAGES];
+static gint64 first_frame = -1;
+
+static char *ui_file = NULL;
+static char *object_id = NULL;
+static gboolean machine_readable = FALSE;
+
+static GOptionEntry options[] = {
+  { "ui", 'u', 0, G_OPTION_ARG_FILENAME, &ui_file, "UI file to load", "FILE" },
+  { "object", 'o', 0, G_OPTION_ARG_STRING, &object_id, "Object to show from the UI file", "ID" },
+  { "machine-readable", 0, 0, G_OPTION_ARG_NONE, &machine_readable, "Print results in columns", NULL },
+  { NULL }
+};
+
+static void
+record_stage (Stage  stage,
+              gint64 time)
+{
+  if (stage_times[stage] == 0)
+    stage_times[stage] = time;
+}
+
+static void
+print_results (void)
+{
+  int i;
+
+  for (i = 0; i < N_STAGES; i++)
+    {
+      double ms = (stage_times[i] - start_time) / 1000.;
+
+      if (machine_readable)
+        g_print ("%g%s", ms, i + 1 < N_STAGES ? "\t" : "\n");
+      else
+        g_print ("%s: %g\n", stage_names[i], ms);
+    }
+}
+
+static gboolean
+interactive_cb (gpointer data)
+{
+  GtkWidget *window = data;
+
+  record_stage (STAGE_INTERACTIVE, g_get_monotonic_time ());
+
+  print_results ();
+  gtk_widget_destroy (window);
+
+  return G_SOURCE_REMOVE;
+}
+
+static void
+layout_cb (GdkFrameClock *frame_clock,
+           gpointer       data)
+{
+  record_stage (STAGE_LAYOUT, g_get_monotonic_time ());
+}
+
+static void
+after_paint_cb (GdkFrameClock *frame_clock,
+                gpointer       data)
+{
+  GdkFrameTimings *timings;
+  gint64 presentation_time;
+
+  if (first_frame < 0)
+    {
+      record_stage (STAGE_PAINT, g_get_monotonic_time ());
+      first_frame = gdk_frame_clock_get_frame_counter (frame_clock);
+    }
+
+  if (stage_times[STAGE_PRESENTED] != 0)
+    return;
+
+  timings = gdk_frame_clock_get_timings (frame_clock, first_frame);
+  if (timings == NULL || !gdk_frame_timings_get_complete (timings))
+    return;
+
+  presentation_time = gdk_frame_timings_get_presentation_time (timings);
+  if (presentation_time == 0)
+    presentation_time = stage_times[STAGE_PAINT];
+
+  record_stage (STAGE_PRESENTED, presentation_time);
+
+  g_idle_add_full (G_PRIORITY_LOW, interactive_cb, data, NULL);
+}
+
+/* Keeps frames coming until the timings of the first one are complete */
+static gboolean
+tick_cb (GtkWidget     *widget,
+         GdkFrameClock *frame_clock,
+         gpointer       data)
+{
+  return stage_times[STAGE_PRESENTED] == 0;
+}
+
+int
+main (int argc, char **argv)
+{
+  GtkCssProvider *provider;
+  GtkBuilder *builder;
+  GtkWidget *window;
+  GObject *object;
+  GdkFrameClock *frame_clock;
+  GOptionContext *context;
+  GError *error = NULL;
+
+  start_time = g_get_monotonic_time ();
+
+  context = g_option_context_new (NULL);
+  g_option_context_add_main_entries (context, options, NULL);
+
+  if (!g_option_context_parse (context, &argc, &argv, &error))
+    {
+      g_printerr ("Option parsing failed: %s\n", error->message);
+      return 1;
+    }
+
+  if (ui_file == NULL)
+    {
+      ui_file = g_build_filename (GTK_SRCDIR, "..", "demos", "widget-factory", "widget-factory.ui", NULL);
+      if (object_id == NULL)
+        object_id = g_strdup ("box1");
+    }
+
+  gtk_init ();
+  record_stage (STAGE_INIT, g_get_monotonic_time ());
+
+  provider = gtk_css_provider_new ();
+  gtk_css_provider_load_named (provider, "Adwaita", NULL);
+  record_stage (STAGE_THEME, g_get_monotonic_time ());
+  g_object_unref (provider);
+
+  g_type_ensure (my_text_view_get_type ());
+  builder = gtk_builder_new ();
+  if (!gtk_builder_add_from_file (builder, ui_file, &error))
+    g_error ("Failed to create widgets: %s", error->message);
+  record_stage (STAGE_BUILDER, g_get_monotonic_time ());
+
+  if (object_id)
+    {
+      object = gtk_builder_get_object (builder, object_id);
+      if (object == NULL)
+        g_error ("No object with id '%s' in %s", object_id, ui_file);
+    }
+  else
+    {
+      GSList *objects, *l;
+
+      object = NULL;
+      objects = gtk_builder_get_objects (builder);
+      for (l = objects; l; l = l->next)
+        {
+          if (GTK_IS_WINDOW (l->data))
+            {
+              object = l->data;
+              break;
+            }
+        }
+      g_slist_free (objects);
+
+      if (object == NULL)
+        g_error ("No window in %s, use --object", ui_file);
+    }
+
+  if (GTK_IS_WINDOW (object))
+    {
+      window = g_object_ref (GTK_WIDGET (object));
+    }
+  else
+    {
+      GtkWidget *content = GTK_WIDGET (object);
+
+      window = g_object_ref (gtk_window_new (GTK_WINDOW_TOPLEVEL));
+      g_object_ref (content);
+      if (gtk_widget_get_parent (content))
+        gtk_container_remove (GTK_CONTAINER (gtk_widget_get_parent (content)), content);
+      gtk_container_add (GTK_CONTAINER (window), content);
+      g_object_unref (content);
+    }
+  g_object_unref (builder);
+
+  gtk_widget_realize (window);
+  frame_clock = gtk_widget_get_frame_clock (window);
+  g_signal_connect_after (frame_clock, "layout", G_CALLBACK (layout_cb), NULL);
+  g_signal_connect_after (frame_clock, "after-paint", G_CALLBACK (after_paint_cb), window);
+  gtk_widget_add_tick_callback (window, tick_cb, NULL, NULL);
+
+  g_signal_connect (window, "destroy",
+                    G_CALLBACK (gtk_main_quit), NULL);
+  gtk_widget_show (window);
+  gtk_main ();
+
+  g_object_unref (window);
+
+  return 0;
+}
@@ -0,0 +1,116 @@
+#include <stdlib.h>
+#include <gtk/gtk.h>
+
+static void
+setup_widget (GtkListItem *list_item,
+              gpointer     unused)
+{
+  GtkWidget *box, *child;
+
+  box = gtk_box_new (GTK_ORIENTATION_VERTICAL, 4);
+  gtk_container_add (GTK_CONTAINER (list_item), box);
+
+  child = gtk_image_new ();
+  gtk_image_set_icon_size (GTK_IMAGE (child), GTK_ICON_SIZE_LARGE);
+  gtk_container_add (GTK_CONTAINER (box), child);
+  g_object_set_data (G_OBJECT (list_item), "icon", child);
+
+  child = gtk_label_new (NULL);
+  gtk_label_set_ellipsize (GTK_LABEL (child), PANGO_ELLIPSIZE_MIDDLE);
+  gtk_label_set_width_chars (GTK_LABEL (child), 12);
+  gtk_label_set_max_width_chars (GTK_LABEL (child), 12);
+  gtk_container_add (GTK_CONTAINER (box), child);
+  g_object_set_data (G_OBJECT (list_item), "name", child);
+}
+
+static void
+bind_widget (GtkListItem *list_item,
+             gpointer     unused)
+{
+  GtkWidget *child;
+  GThemedIcon *icon;
+
+  icon = gtk_list_item_get_item (list_item);
+  if (icon == NULL)
+    return;
+
+  child = g_object_get_data (G_OBJECT (list_item), "icon");
+  gtk_image_set_from_gicon (GTK_IMAGE (child), G_ICON (icon));
+
+  child = g_object_get_data (G_OBJECT (list_item), "name");
+  gtk_label_set_label (GTK_LABEL (child), g_themed_icon_get_names (icon)[0]);
+}
+
+static GListModel *
+create_icon_model (guint n_copies)
+{
+  GListStore *store;
+  GList *icons, *l;
+  guint i;
+
+  store = g_list_store_new (G_TYPE_THEMED_ICON);
+  icons = gtk_icon_theme_list_icons (gtk_icon_theme_get_default (), NULL);
+  icons = g_list_sort (icons, (GCompareFunc) g_strcmp0);
+
+  for (i = 0; i < n_copies; i++)
+    {
+      for (l = icons; l; l = l->next)
+        {
+          GIcon *icon = g_themed_icon_new (l->data);
+          g_list_store_append (store, icon);
+          g_object_unref (icon);
+        }
+    }
+
+  g_list_free_full (icons, g_free);
+
+  return G_LIST_MODEL (store);
+}
+
+int
+main (int argc, char *argv[])
+{
+  GtkWidget *win, *vbox, *sw, *gridview, *statusbar;
+  GListModel *model;
+  char *text;
+
+  gtk_init ();
+
+  win = gtk_window_new (GTK_WINDOW_TOPLEVEL);
+  gtk_window_set_default_size (GTK_WINDOW (win), 600, 400);
+  g_signal_connect (win, "destroy", G_CALLBACK (gtk_main_quit), win);
+
+  vbox = gtk_box_new (GTK_ORIENTATION_VERTICAL, 0);
+  gtk_container_add (GTK_CONTAINER (win), vbox);
+
+  sw = gtk_scrolled_window_new (NULL, NULL);
+  gtk_widget_set_vexpand (sw, TRUE);
+  gtk_container_add (GTK_CONTAINER (vbox), sw);
+
+  gridview = gtk_grid_view_new ();
+  gtk_grid_view_set_max_columns (GTK_GRID_VIEW (gridview), 12);
+  gtk_grid_view_set_functions (GTK_GRID_VIEW (gridview),
+                               setup_widget,
+                               bind_widget,
+                               NULL, NULL);
+  gtk_container_add (GTK_CONTAINER (sw), gridview);
+
+  /* Repeat the icons to get a model large enough to show that only
+   * the visible items are created */
+  model = create_icon_model (argc > 1 ? MAX (1, atoi (argv[1])) : 20);
+  gtk_grid_view_set_model (GTK_GRID_VIEW (gridview), model);
+
+  statusbar = gtk_statusbar_new ();
+  text = g_strdup_printf ("%u items", g_list_model_get_n_items (model));
+  gtk_statusbar_push (GTK_STATUSBAR (statusbar), 0, text);
+  g_free (text);
+  gtk_container_add (GTK_CONTAINER (vbox), statusbar);
+
+  g_object_unref (model);
+
+  gtk_widget_show (win);
+
+  gtk_main ();
+
+  return 0;
+}
@@ -0,0 +1,532 @@
+/* -*- mode: C; c-basic-offset: 2; indent-tabs-mode: nil; -*- */
+
+/* Replays a script of input against a UI file and reports how long
+ * the phases of each frame took, as JSON:
+ *
+ *  scroll: scrolls the first scrolled window from top to bottom
+ *  resize: grows and shrinks the window
+ *  hover:  moves the pointer diagonally across the window
+ *  type:   inserts text into the first editable, one character per frame
+ *
+ * Each step takes the same number of frames and changes the UI by the
+ * same amount in each of them, no matter how long the frames take.
+ * Frame times advance by exactly one refresh interval per frame (see
+ * GDK_DEBUG=fixed-frame-time), so animations started by the input are
+ * reproducible as well.
+ *
+ * The style validation of a frame is part of its layout phase. The
+ * paint phase includes both taking the snapshot and rendering it.
+ *
+ * It still needs a display, use e.g. GDK_BACKEND=broadway or a virtual
+ * X server to run it without one.
+ */
+
+#include <gtk/gtk.h>
+
+#include <stdlib.h>
+#include <string.h>
+
+#include "variable.h"
+
+/* Stub definition of MyTextView which is used in the
+ * widget-factory.ui file. We just need this so the
+ * test keeps working
+ */
+typedef struct
+{
+  GtkTextView tv;
+} MyTextView;
+
+typedef GtkTextViewClass MyTextViewClass;
+
+G_DEFINE_TYPE (MyTextView, my_text_view, GTK_TYPE_TEXT_VIEW)
+
+static void
+my_text_view_init (MyTextView *tv) {}
+
+static void
+my_text_view_class_init (MyTextViewClass *tv_class) {}
+
+typedef enum {
+  PHASE_EVENTS,
+  PHASE_UPDATE,
+  PHASE_LAYOUT,
+  PHASE_PAINT,
+  N_PHASES
+} Phase;
+
+static const char *phase_names[N_PHASES] = {
+  "events",
+  "update",
+  "layout",
+  "paint"
+};
+
+typedef struct _Step Step;
+
+struct _Step
+{
+  const char *name;
+  gboolean (* prepare) (Step *step);
+  void (* frame) (Step *step, int frame);
+
+  GtkWidget *target;
+  int width;
+  int height;
+
+  Variable phases[N_PHASES];
+  gint64 max[N_PHASES];
+  int n_frames;
+};
+
+static char *ui_file = NULL;
+static char *object_id = NULL;
+static char *output_file = NULL;
+static char **step_names = NULL;
+static int frames_per_step = 120;
+
+static GOptionEntry options[] = {
+  { "ui", 'u', 0, G_OPTION_ARG_FILENAME, &ui_file, "UI file to load", "FILE" },
+  { "object", 'o', 0, G_OPTION_ARG_STRING, &object_id, "Object to show from the UI file", "ID" },
+  { "step", 's', 0, G_OPTION_ARG_STRING_ARRAY, &step_names, "Step to run, can be given multiple times", "scroll|resize|hover|type" },
+  { "frames", 'f', 0, G_OPTION_ARG_INT, &frames_per_step, "Frames per step", "N" },
+  { "output", 0, 0, G_OPTION_ARG_FILENAME, &output_file, "Write the results to FILE instead of stdout", "FILE" },
+  { NULL }
+};
+
+static GtkWidget *window;
+static GPtrArray *steps;
+static guint current_step;
+static int current_frame;
+static gint64 last_frame_counter = -1;
+
+static GtkWidget *
+find_widget (GtkWidget *widget,
+             GType      type)
+{
+  GtkWidget *child, *found;
+
+  if (g_type_is_a (G_OBJECT_TYPE (widget), type) &&
+      gtk_widget_get_mapped (widget))
+    return widget;
+
+  for (child = gtk_widget_get_first_child (widget);
+       child != NULL;
+       child = gtk_widget_get_next_sibling (child))
+    {
+      found = find_widget (child, type);
+      if (found)
+        return found;
+    }
+
+  return NULL;
+}
+
+static gboolean
+scroll_prepare (Step *step)
+{
+  step->target = find_widget (window, GTK_TYPE_SCROLLED_WINDOW);
+
+  return step->target != NULL;
+}
+
+static void
+scroll_frame (Step *step,
+              int   frame)
+{
+  GtkAdjustment *adjustment;
+  double lower, upper;
+
+  adjustment = gtk_scrolled_window_get_vadjustment (GTK_SCROLLED_WINDOW (step->target));
+  lower = gtk_adjustment_get_lower (adjustment);
+  upper = gtk_adjustment_get_upper (adjustment) - gtk_adjustment_get_page_size (adjustment);
+
+  gtk_adjustment_set_value (adjustment, lower + (upper - lower) * frame / (frames_per_step - 1));
+}
+
+static gboolean
+resize_prepare (Step *step)
+{
+  gtk_window_get_size (GTK_WINDOW (window), &step->width, &step->height);
+
+  return TRUE;
+}
+
+/* Grows the window by half its size and back */
+static void
+resize_frame (Step *step,
+              int   frame)
+{
+  double t = 1.0 - ABS (2.0 * frame / (frames_per_step - 1) - 1.0);
+
+  gtk_window_resize (GTK_WINDOW (window),
+                     step->width * (1.0 + t / 2),
+                     step->height * (1.0 + t / 2));
+}
+
+static gboolean
+hover_prepare (Step *step)
+{
+  step->width = gtk_widget_get_width (window);
+  step->height = gtk_widget_get_height (window);
+
+  return TRUE;
+}
+
+static void
+hover_frame (Step *step,
+             int   frame)
+{
+  GdkDevice *device;
+  GdkEvent *event;
+
+  device = gdk_seat_get_pointer (gdk_display_get_default_seat (gtk_widget_get_display (window)));
+
+  event = gdk_event_new (GDK_MOTION_NOTIFY);
+  event->any.surface = g_object_ref (gtk_widget_get_surface (window));
+  event->motion.time = GDK_CURRENT_TIME;
+  event->motion.x = (double) step->width * frame / (frames_per_step - 1);
+  event->motion.y = (double) step->height * frame / (frames_per_step - 1);
+  gdk_event_set_device (event, device);
+
+  gtk_main_do_event (event);
+
+  g_object_unref (event);
+}
+
+static gboolean
+type_prepare (Step *step)
+{
+  step->target = find_widget (window, GTK_TYPE_EDITABLE);
+  if (step->target == NULL)
+    return FALSE;
+
+  gtk_widget_grab_focus (step->target);
+
+  return TRUE;
+}
+
+/* Text is inserted directly rather than through key events, which
+ * would depend on the keymap */
+static void
+type_frame (Step *step,
+            int   frame)
+{
+  static const char text[] = "The quick brown fox jumps over the lazy dog. ";
+  int position = -1;
+
+  gtk_editable_insert_text (GTK_EDITABLE (step->target),
+                            &text[frame % (sizeof (text) - 1)], 1,
+                            &position);
+}
+
+static Step known_steps[] = {
+  { "scroll", scroll_prepare, scroll_frame },
+  { "resize", resize_prepare, resize_frame },
+  { "hover", hover_prepare, hover_frame },
+  { "type", type_prepare, type_frame },
+};
+
+static void
+append_json_string (GString    *s,
+                    const char *string)
+{
+  const char *p;
+
+  g_string_append_c (s, '"');
+  for (p = string; *p; p++)
+    {
+      if (*p == '"' || *p == '\\')
+        g_string_append_c (s, '\\');
+      g_string_append_c (s, *p);
+    }
+  g_string_append_c (s, '"');
+}
+
+/* JSON wants a decimal point, whatever the locale */
+static void
+append_json_number (GString *s,
+                    double   value)
+{
+  char buf[G_ASCII_DTOSTR_BUF_SIZE];
+
+  g_string_append (s, g_ascii_formatd (buf, sizeof (buf), "%g", value));
+}
+
+static void
+print_results (void)
+{
+  GString *s;
+  guint i, j;
+
+  s = g_string_new ("{\n");
+  g_string_append (s, "  \"ui\": ");
+  append_json_string (s, ui_file);
+  g_string_append (s, ",\n  \"object\": ");
+  append_json_string (s, object_id ? object_id : "");
+  g_string_append (s, ",\n");
+  g_string_append_printf (s, "  \"frames-per-step\": %d,\n", frames_per_step);
+  g_string_append (s, "  \"steps\": [");
+
+  for (i = 0; i < steps->len; i++)
+    {
+      Step *step = g_ptr_array_index (steps, i);
+
+      g_string_append_printf (s, "%s\n    {\n", i > 0 ? "," : "");
+      g_string_append_printf (s, "      \"name\": \"%s\",\n", step->name);
+      g_string_append_printf (s, "      \"frames\": %d,\n", step->n_frames);
+      g_string_append (s, "      \"phases\": {");
+
+      for (j = 0; j < N_PHASES; j++)
+        {
+          double mean = 0, deviation = 0;
+
+          if (step->phases[j].weight != 0)
+            {
+              mean = variable_mean (&step->phases[j]);
+              deviation = variable_standard_deviation (&step->phases[j]);
+            }
+
+          /* times in milliseconds */
+          g_string_append_printf (s, "%s\n        \"%s\": { \"mean\": ", j > 0 ? "," : "", phase_names[j]);
+          append_json_number (s, mean / 1000.);
+          g_string_append (s, ", \"deviation\": ");
+          append_json_number (s, deviation / 1000.);
+          g_string_append (s, ", \"max\": ");
+          append_json_number (s, step->max[j] / 1000.);
+          g_string_append (s, " }");
+        }
+
+      g_string_append (s, "\n      }\n    }");
+    }
+
+  g_string_append (s, "\n  ]\n}\n");
+
+  if (output_file)
+    {
+      GError *error = NULL;
+
+      if (!g_file_set_contents (output_file, s->str, s->len, &error))
+        {
+          g_printerr ("Could not write results: %s\n", error->message);
+          g_error_free (error);
+        }
+    }
+  else
+    g_print ("%s", s->str);
+
+  g_string_free (s, TRUE);
+}
+
+static void
+record_phase (Step   *step,
+              Phase   phase,
+              gint64  duration)
+{
+  variable_add (&step->phases[phase], duration);
+  step->max[phase] = MAX (step->max[phase], duration);
+}
+
+/* The durations of a frame are known once it has been painted, before
+ * the compositor has presented it */
+static void
+after_paint_cb (GdkFrameClock *frame_clock,
+                gpointer       data)
+{
+  GdkFrameTimings *timings;
+  Step *step;
+
+  if (current_step >= steps->len || current_frame == 0)
+    return;
+
+  timings = gdk_frame_clock_get_current_timings (frame_clock);
+  if (timings == NULL ||
+      gdk_frame_timings_get_frame_counter (timings) == last_frame_counter)
+    return;
+
+  last_frame_counter = gdk_frame_timings_get_frame_counter (timings);
+
+  step = g_ptr_array_index (steps, current_step);
+  record_phase (step, PHASE_EVENTS, gdk_frame_timings_get_events_duration (timings));
+  record_phase (step, PHASE_UPDATE, gdk_frame_timings_get_update_duration (timings));
+  record_phase (step, PHASE_LAYOUT, gdk_frame_timings_get_layout_duration (timings));
+  record_phase (step, PHASE_PAINT, gdk_frame_timings_get_paint_duration (timings));
+  step->n_frames++;
+}
+
+static gboolean
+tick_cb (GtkWidget     *widget,
+         GdkFrameClock *frame_clock,
+         gpointer       data)
+{
+  Step *step;
+
+  while (current_step < steps->len)
+    {
+      step = g_ptr_array_index (steps, current_step);
+
+      if (current_frame == frames_per_step)
+        {
+          current_step++;
+          current_frame = 0;
+          continue;
+        }
+
+      if (current_frame == 0 && !step->prepare (step))
+        {
+          g_printerr ("Skipping step %s, nothing to %s in the UI\n", step->name, step->name);
+          current_step++;
+          continue;
+        }
+
+      step->frame (step, current_frame);
+      current_frame++;
+      gtk_widget_queue_draw (window);
+
+      return G_SOURCE_CONTINUE;
+    }
+
+  print_results ();
+  gtk_widget_destroy (window);
+
+  return G_SOURCE_REMOVE;
+}
+
+static void
+add_step (const char *name)
+{
+  guint i;
+
+  for (i = 0; i < G_N_ELEMENTS (known_steps); i++)
+    {
+      if (strcmp (known_steps[i].name, name) == 0)
+        {
+          g_ptr_array_add (steps, &known_steps[i]);
+          return;
+        }
+    }
+
+  g_printerr ("Unknown step \"%s\"\n", name);
+  exit (1);
+}
+
+int
+main (int argc, char **argv)
+{
+  GtkBuilder *builder;
+  GObject *object;
+  GdkFrameClock *frame_clock;
+  GOptionContext *context;
+  GError *error = NULL;
+  const char *debug;
+  char *new_debug;
+  guint i;
+
+  context = g_option_context_new (NULL);
+  g_option_context_add_main_entries (context, options, NULL);
+
+  if (!g_option_context_parse (context, &argc, &argv, &error))
+    {
+      g_printerr ("Option parsing failed: %s\n", error->message);
+      return 1;
+    }
+
+  if (frames_per_step < 2)
+    {
+      g_printerr ("Number of frames given with -f/--frames must be at least 2 and not %d.\n", frames_per_step);
+      return 1;
+    }
+
+  if (ui_file == NULL)
+    {
+      ui_file = g_build_filename (GTK_SRCDIR, "..", "demos", "widget-factory", "widget-factory.ui", NULL);
+      if (object_id == NULL)
+        object_id = g_strdup ("box1");
+    }
+
+  steps = g_ptr_array_new ();
+  if (step_names)
+    {
+      for (i = 0; step_names[i]; i++)
+        add_step (step_names[i]);
+    }
+  else
+    {
+      for (i = 0; i < G_N_ELEMENTS (known_steps); i++)
+        g_ptr_array_add (steps, &known_steps[i]);
+    }
+
+  /* Must be set before GDK reads it */
+  debug = g_getenv ("GDK_DEBUG");
+  if (debug && *debug)
+    new_debug = g_strconcat (debug, ",fixed-frame-time", NULL);
+  else
+    new_debug = g_strdup ("fixed-frame-time");
+  g_setenv ("GDK_DEBUG", new_debug, TRUE);
+  g_free (new_debug);
+
+  gtk_init ();
+
+  g_type_ensure (my_text_view_get_type ());
+  builder = gtk_builder_new ();
+  if (!gtk_builder_add_from_file (builder, ui_file, &error))
+    g_error ("Failed to create widgets: %s", error->message);
+
+  if (object_id)
+    {
+      object = gtk_builder_get_object (builder, object_id);
+      if (object == NULL)
+        g_error ("No object with id '%s' in %s", object_id, ui_file);
+    }
+  else
+    {
+      GSList *objects, *l;
+
+      object = NULL;
+      objects = gtk_builder_get_objects (builder);
+      for (l = objects; l; l = l->next)
+        {
+          if (GTK_IS_WINDOW (l->data))
+            {
+              object = l->data;
+              break;
+            }
+        }
+      g_slist_free (objects);
+
+      if (object == NULL)
+        g_error ("No window in %s, use --object", ui_file);
+    }
+
+  if (GTK_IS_WINDOW (object))
+    {
+      window = g_object_ref (GTK_WIDGET (object));
+    }
+  else
+    {
+      GtkWidget *content = GTK_WIDGET (object);
+
+      window = g_object_ref (gtk_window_new (GTK_WINDOW_TOPLEVEL));
+      g_object_ref (content);
+      if (gtk_widget_get_parent (content))
+        gtk_container_remove (GTK_CONTAINER (gtk_widget_get_parent (content)), content);
+      gtk_container_add (GTK_CONTAINER (window), content);
+      g_object_unref (content);
+    }
+  g_object_unref (builder);
+
+  gtk_widget_realize (window);
+  frame_clock = gtk_widget_get_frame_clock (window);
+  g_signal_connect_after (frame_clock, "after-paint", G_CALLBACK (after_paint_cb), NULL);
+  gtk_widget_add_tick_callback (window, tick_cb, NULL, NULL);
+
+  g_signal_connect (window, "destroy",
+                    G_CALLBACK (gtk_main_quit), NULL);
+  gtk_widget_show (window);
+  gtk_main ();
+
+  g_object_unref (window);
+  g_ptr_array_unref (steps);
+
+  return 0;
+}
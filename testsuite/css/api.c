@@ -33,6 +33,64 @@ gtk_css_provider_load_data_not_null_terminated (void)
   g_object_unref (p);
 }
 
+static void
+assert_color (GtkStyleContext *context,
+              const char      *expected)
+{
+  GdkRGBA color, expected_color;
+
+  gtk_style_context_get_color (context, &color);
+  g_assert_true (gdk_rgba_parse (&expected_color, expected));
+  g_assert_true (gdk_rgba_equal (&color, &expected_color));
+}
+
+static void
+gtk_css_provider_load_data_reload (void)
+{
+  GtkCssProvider *p;
+  GtkWidget *label;
+  GtkStyleContext *context;
+
+  p = gtk_css_provider_new ();
+  label = gtk_label_new ("reload");
+  g_object_ref_sink (label);
+  context = gtk_widget_get_style_context (label);
+  gtk_style_context_add_provider (context, GTK_STYLE_PROVIDER (p),
+                                  GTK_STYLE_PROVIDER_PRIORITY_USER);
+
+  gtk_css_provider_load_from_data (p, "label { color: red; }", -1);
+  assert_color (context, "red");
+
+  /* changed value */
+  gtk_css_provider_load_from_data (p, "label { color: blue; }", -1);
+  assert_color (context, "blue");
+
+  /* unrelated rules added */
+  gtk_css_provider_load_from_data (p, "label { color: blue; } button { color: green; }", -1);
+  assert_color (context, "blue");
+
+  /* new rule that applies after a class change */
+  gtk_css_provider_load_from_data (p, "label { color: blue; } .foo { color: green; }", -1);
+  assert_color (context, "blue");
+  gtk_style_context_add_class (context, "foo");
+  assert_color (context, "green");
+  gtk_style_context_remove_class (context, "foo");
+
+  /* changed named color */
+  gtk_css_provider_load_from_data (p, "@define-color c yellow; label { color: @c; }", -1);
+  assert_color (context, "yellow");
+  gtk_css_provider_load_from_data (p, "@define-color c black; label { color: @c; }", -1);
+  assert_color (context, "black");
+
+  /* removed rule */
+  gtk_css_provider_load_from_data (p, "@define-color c black; label { color: @c; } label { color: red; }", -1);
+  assert_color (context, "red");
+  gtk_css_provider_load_from_data (p, "@define-color c black; label { color: @c; }", -1);
+  assert_color (context, "black");
+
+  g_object_unref (label);
+  g_object_unref (p);
+}
 
 int
 main (int argc, char *argv[])
@@ -41,6 +99,8 @@ main (int argc, char *argv[])
 
   g_test_add_func ("/gtk_css_provider_load_data/not_null_terminated",
       gtk_css_provider_load_data_not_null_terminated);
+  g_test_add_func ("/gtk_css_provider_load_data/reload",
+      gtk_css_provider_load_data_reload);
 
   return g_test_run ();
 }
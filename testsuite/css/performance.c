@@ -0,0 +1,122 @@
+/*
+ * Copyright (C) 2018 Red Hat Inc.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Library General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Library General Public License for more details.
+ *
+ * You should have received a copy of the GNU Library General Public
+ * License along with this library. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <gtk/gtk.h>
+
+#define N_RULES 2000
+#define DEPTH 12
+#define N_LABELS 20
+#define N_RUNS 50
+
+static GtkCssProvider *
+create_provider (void)
+{
+  GtkCssProvider *provider;
+  GString *s;
+  int i;
+
+  s = g_string_new ("");
+
+  /* Descendant selectors that mostly don't match, as found in themes */
+  for (i = 0; i < N_RULES; i++)
+    g_string_append_printf (s, ".rule%d box label { color: red; }\n", i);
+  g_string_append (s, ".toggled box label { color: blue; }\n");
+
+  provider = gtk_css_provider_new ();
+  gtk_css_provider_load_from_data (provider, s->str, s->len);
+  g_string_free (s, TRUE);
+
+  return provider;
+}
+
+static GtkWidget *
+create_tree (void)
+{
+  GtkWidget *window, *parent, *box;
+  int i, j;
+
+  window = gtk_window_new (GTK_WINDOW_TOPLEVEL);
+  parent = window;
+
+  for (i = 0; i < DEPTH; i++)
+    {
+      box = gtk_box_new (GTK_ORIENTATION_VERTICAL, 0);
+      gtk_container_add (GTK_CONTAINER (parent), box);
+
+      for (j = 0; j < N_LABELS; j++)
+        gtk_container_add (GTK_CONTAINER (box), gtk_label_new ("Label"));
+
+      parent = box;
+    }
+
+  return window;
+}
+
+static void
+test_performance_descendants (void)
+{
+  GtkCssProvider *provider;
+  GtkStyleContext *context;
+  GtkWidget *window;
+  gdouble elapsed;
+  int i;
+
+  provider = create_provider ();
+  gtk_style_context_add_provider_for_display (gdk_display_get_default (),
+                                              GTK_STYLE_PROVIDER (provider),
+                                              GTK_STYLE_PROVIDER_PRIORITY_APPLICATION);
+
+  window = create_tree ();
+  context = gtk_widget_get_style_context (window);
+  gtk_widget_show (window);
+  gtk_widget_hide (window);
+
+  g_test_timer_start ();
+
+  for (i = 0; i < N_RUNS; i++)
+    {
+      if (i % 2)
+        gtk_style_context_remove_class (context, "toggled");
+      else
+        gtk_style_context_add_class (context, "toggled");
+
+      /* Showing a toplevel validates its styles right away */
+      gtk_widget_show (window);
+      gtk_widget_hide (window);
+    }
+
+  elapsed = g_test_timer_elapsed ();
+  g_test_minimized_result (elapsed, "descendant selectors: %gsec", elapsed);
+
+  gtk_widget_destroy (window);
+  gtk_style_context_remove_provider_for_display (gdk_display_get_default (),
+                                                 GTK_STYLE_PROVIDER (provider));
+  g_object_unref (provider);
+}
+
+int
+main (int argc, char *argv[])
+{
+  gtk_test_init (&argc, &argv, NULL);
+
+  if (!g_test_perf ())
+    return 0;
+
+  g_test_add_func ("/css/performance/descendants", test_performance_descendants);
+
+  return g_test_run ();
+}
@@ -2,7 +2,7 @@
 #include <gdk/gdk.h>
 
 /* maximum bytes per pixel */
-#define MAX_BPP 4
+#define MAX_BPP 8
 
 typedef enum {
   BLUE,
@@ -33,6 +33,12 @@ typedef struct _TestData {
 } TestData;
 
 #define RGBA(a, b, c, d) { 0x ## a, 0x ## b, 0x ## c, 0x ## d }
+#if G_BYTE_ORDER == G_LITTLE_ENDIAN
+#define U16(x) (0x ## x & 0xFF), (0x ## x >> 8)
+#else
+#define U16(x) (0x ## x >> 8), (0x ## x & 0xFF)
+#endif
+#define RGBA16(a, b, c, d) { U16(a), U16(b), U16(c), U16(d) }
 
 static MemoryData tests[GDK_MEMORY_N_FORMATS] = {
   { 4, FALSE, { RGBA(FF,00,00,FF), RGBA(00,FF,00,FF), RGBA(00,00,FF,FF), RGBA(00,00,00,00), RGBA(66,22,44,AA) } },
@@ -43,6 +49,8 @@ static MemoryData tests[GDK_MEMORY_N_FORMATS] = {
   { 4, FALSE, { RGBA(FF,FF,00,00), RGBA(FF,00,FF,00), RGBA(FF,00,00,FF), RGBA(00,00,00,00), RGBA(AA,99,33,66) } },
   { 3, TRUE,  { RGBA(00,00,FF,00), RGBA(00,FF,00,00), RGBA(FF,00,00,00), RGBA(00,00,00,00), RGBA(44,22,66,00) } },
   { 3, TRUE,  { RGBA(FF,00,00,00), RGBA(00,FF,00,00), RGBA(00,00,FF,00), RGBA(00,00,00,00), RGBA(66,22,44,00) } },
+  { 8, FALSE, { RGBA16(0000,0000,FFFF,FFFF), RGBA16(0000,FFFF,0000,FFFF), RGBA16(FFFF,0000,0000,FFFF), RGBA16(0000,0000,0000,0000), RGBA16(4444,2222,6666,AAAA) } },
+  { 8, FALSE, { RGBA16(0000,0000,3C00,3C00), RGBA16(0000,3C00,0000,3C00), RGBA16(3C00,0000,0000,3C00), RGBA16(0000,0000,0000,0000), RGBA16(3444,3044,3666,3955) } },
 };
 
 static void
@@ -699,6 +699,15 @@ load_node_file (GFile *file, gboolean generate)
       return;
     }
 
+  /* Render what survives a round trip through the serializer, so
+   * the reference images cover the current format, too */
+  bytes = gsk_render_node_serialize (node);
+  gsk_render_node_unref (node);
+  node = gsk_render_node_deserialize (bytes, &error);
+  g_bytes_unref (bytes);
+  g_assert_no_error (error);
+  g_assert (node != NULL);
+
   window = gdk_surface_new_toplevel (gdk_display_get_default(), 10 , 10);
   renderer = gsk_renderer_new_for_surface (window);
   texture = gsk_renderer_render_texture (renderer, node, NULL);
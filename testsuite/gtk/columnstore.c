@@ -0,0 +1,230 @@
+/* GtkColumnStore tests.
+ *
+ * Copyright (C) 2018, Red Hat, Inc.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <locale.h>
+
+#include <gtk/gtk.h>
+
+enum {
+  COLUMN_INT,
+  COLUMN_STRING,
+  COLUMN_DOUBLE,
+  N_COLUMNS
+};
+
+static GtkColumnStore *
+new_store (void)
+{
+  return gtk_column_store_new (N_COLUMNS, G_TYPE_INT, G_TYPE_STRING, G_TYPE_DOUBLE);
+}
+
+static char *
+model_to_string (GtkColumnStore *store)
+{
+  GString *string = g_string_new (NULL);
+  GtkTreeIter iter;
+  gboolean valid;
+
+  for (valid = gtk_tree_model_get_iter_first (GTK_TREE_MODEL (store), &iter);
+       valid;
+       valid = gtk_tree_model_iter_next (GTK_TREE_MODEL (store), &iter))
+    {
+      if (string->len > 0)
+        g_string_append (string, " ");
+      g_string_append_printf (string, "%d", gtk_column_store_get_int (store, &iter, COLUMN_INT));
+    }
+
+  return g_string_free (string, FALSE);
+}
+
+#define assert_model(store, expected) G_STMT_START{ \
+  char *s = model_to_string (store); \
+  if (!g_str_equal (s, expected)) \
+     g_assertion_message_cmpstr (G_LOG_DOMAIN, __FILE__, __LINE__, G_STRFUNC, \
+         #store " == " #expected, s, "==", expected); \
+  g_free (s); \
+}G_STMT_END
+
+static void
+append_row (GtkColumnStore *store,
+            gint            i,
+            const gchar    *str)
+{
+  GtkTreeIter iter;
+
+  gtk_column_store_append (store, &iter);
+  gtk_column_store_set (store, &iter,
+                        COLUMN_INT, i,
+                        COLUMN_STRING, str,
+                        COLUMN_DOUBLE, i / 2.0,
+                        -1);
+}
+
+static void
+test_get_set (void)
+{
+  GtkColumnStore *store;
+  GtkTreeIter iter;
+  gchar *str;
+  gint i;
+
+  store = new_store ();
+  for (i = 0; i < 100; i++)
+    append_row (store, i, "foo");
+
+  g_assert_cmpint (gtk_tree_model_iter_n_children (GTK_TREE_MODEL (store), NULL), ==, 100);
+
+  g_assert_true (gtk_tree_model_iter_nth_child (GTK_TREE_MODEL (store), &iter, NULL, 42));
+  g_assert_cmpint (gtk_column_store_get_int (store, &iter, COLUMN_INT), ==, 42);
+  g_assert_cmpfloat (gtk_column_store_get_double (store, &iter, COLUMN_DOUBLE), ==, 21.0);
+  g_assert_cmpstr (gtk_column_store_get_string (store, &iter, COLUMN_STRING), ==, "foo");
+
+  gtk_column_store_set (store, &iter, COLUMN_STRING, "bar", -1);
+  gtk_tree_model_get (GTK_TREE_MODEL (store), &iter, COLUMN_STRING, &str, -1);
+  g_assert_cmpstr (str, ==, "bar");
+  g_free (str);
+
+  g_object_unref (store);
+}
+
+static void
+test_shared_strings (void)
+{
+  GtkColumnStore *store;
+  GtkTreeIter a, b;
+  gchar *str;
+
+  store = new_store ();
+  str = g_strdup ("shared");
+  append_row (store, 0, str);
+  append_row (store, 1, str);
+  g_free (str);
+
+  gtk_tree_model_iter_nth_child (GTK_TREE_MODEL (store), &a, NULL, 0);
+  gtk_tree_model_iter_nth_child (GTK_TREE_MODEL (store), &b, NULL, 1);
+  g_assert_true (gtk_column_store_get_string (store, &a, COLUMN_STRING) ==
+                 gtk_column_store_get_string (store, &b, COLUMN_STRING));
+
+  /* Dropping one user must keep the string alive for the other */
+  gtk_column_store_remove (store, &a);
+  gtk_tree_model_get_iter_first (GTK_TREE_MODEL (store), &b);
+  g_assert_cmpstr (gtk_column_store_get_string (store, &b, COLUMN_STRING), ==, "shared");
+
+  gtk_column_store_set (store, &b, COLUMN_STRING, NULL, -1);
+  g_assert_null (gtk_column_store_get_string (store, &b, COLUMN_STRING));
+
+  g_object_unref (store);
+}
+
+static void
+test_remove (void)
+{
+  GtkColumnStore *store;
+  GtkTreeIter iter;
+  gint i;
+
+  store = new_store ();
+  for (i = 0; i < 5; i++)
+    append_row (store, i, NULL);
+
+  gtk_tree_model_iter_nth_child (GTK_TREE_MODEL (store), &iter, NULL, 1);
+  g_assert_true (gtk_column_store_remove (store, &iter));
+  g_assert_cmpint (gtk_column_store_get_int (store, &iter, COLUMN_INT), ==, 2);
+  assert_model (store, "0 2 3 4");
+
+  gtk_tree_model_iter_nth_child (GTK_TREE_MODEL (store), &iter, NULL, 3);
+  g_assert_false (gtk_column_store_remove (store, &iter));
+  assert_model (store, "0 2 3");
+
+  gtk_column_store_clear (store);
+  assert_model (store, "");
+
+  g_object_unref (store);
+}
+
+static void
+test_sort (void)
+{
+  GtkColumnStore *store;
+  GtkTreeIter iter;
+  const gchar *words[] = { "d", "b", "e", "a", "c" };
+  gint i;
+
+  store = new_store ();
+  for (i = 0; i < G_N_ELEMENTS (words); i++)
+    append_row (store, i, words[i]);
+
+  gtk_tree_sortable_set_sort_column_id (GTK_TREE_SORTABLE (store), COLUMN_STRING, GTK_SORT_ASCENDING);
+  assert_model (store, "3 1 4 0 2");
+
+  gtk_tree_sortable_set_sort_column_id (GTK_TREE_SORTABLE (store), COLUMN_INT, GTK_SORT_DESCENDING);
+  assert_model (store, "4 3 2 1 0");
+
+  /* rows move to their sorted position on insert and change */
+  append_row (store, 7, NULL);
+  assert_model (store, "7 4 3 2 1 0");
+
+  gtk_tree_model_iter_nth_child (GTK_TREE_MODEL (store), &iter, NULL, 0);
+  gtk_column_store_set (store, &iter, COLUMN_INT, -1, -1);
+  g_assert_cmpint (gtk_column_store_get_int (store, &iter, COLUMN_INT), ==, -1);
+  assert_model (store, "4 3 2 1 0 -1");
+
+  g_object_unref (store);
+}
+
+static void
+test_insert_many (void)
+{
+  GtkColumnStore *store;
+  gint columns[] = { COLUMN_INT };
+  GValue values[3] = { G_VALUE_INIT, G_VALUE_INIT, G_VALUE_INIT };
+  gint i;
+
+  store = new_store ();
+  append_row (store, 0, NULL);
+  append_row (store, 4, NULL);
+
+  for (i = 0; i < 3; i++)
+    {
+      g_value_init (&values[i], G_TYPE_INT);
+      g_value_set_int (&values[i], i + 1);
+    }
+
+  gtk_column_store_insert_many_with_valuesv (store, 1, 3, columns, values, 1);
+  assert_model (store, "0 1 2 3 4");
+
+  for (i = 0; i < 3; i++)
+    g_value_unset (&values[i]);
+
+  g_object_unref (store);
+}
+
+int
+main (int argc, char *argv[])
+{
+  g_test_init (&argc, &argv, NULL);
+  setlocale (LC_ALL, "C");
+
+  g_test_add_func ("/columnstore/get-set", test_get_set);
+  g_test_add_func ("/columnstore/shared-strings", test_shared_strings);
+  g_test_add_func ("/columnstore/remove", test_remove);
+  g_test_add_func ("/columnstore/sort", test_sort);
+  g_test_add_func ("/columnstore/insert-many", test_insert_many);
+
+  return g_test_run ();
+}
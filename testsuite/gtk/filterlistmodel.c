@@ -306,6 +306,93 @@ test_change_filter_func (void)
   g_object_unref (filter);
 }
 
+static void
+wait_for_filter (GtkFilterListModel *filter)
+{
+  while (gtk_filter_list_model_get_pending (filter) > 0)
+    g_main_context_iteration (NULL, TRUE);
+}
+
+static void
+test_incremental (void)
+{
+  GtkFilterListModel *filter;
+  GListStore *store;
+
+  filter = new_model (10, NULL, NULL);
+  gtk_filter_list_model_set_incremental (filter, TRUE);
+
+  /* items stay visible until they have been filtered */
+  gtk_filter_list_model_set_filter_func (filter, is_smaller_than, GUINT_TO_POINTER (7), NULL);
+  assert_model (filter, "1 2 3 4 5 6 7 8 9 10");
+  assert_changes (filter, "");
+  g_assert_cmpuint (gtk_filter_list_model_get_pending (filter), ==, 10);
+
+  wait_for_filter (filter);
+  assert_model (filter, "1 2 3 4 5 6");
+  assert_changes (filter, "6-4");
+
+  gtk_filter_list_model_set_filter_func (filter, is_larger_than, GUINT_TO_POINTER (3), NULL);
+  assert_model (filter, "1 2 3 4 5 6");
+  assert_changes (filter, "");
+
+  wait_for_filter (filter);
+  assert_model (filter, "4 5 6 7 8 9 10");
+  assert_changes (filter, "0-6+7");
+
+  /* turning it off finishes the filtering */
+  gtk_filter_list_model_set_filter_func (filter, is_near, GUINT_TO_POINTER (5), NULL);
+  gtk_filter_list_model_set_incremental (filter, FALSE);
+  g_assert_cmpuint (gtk_filter_list_model_get_pending (filter), ==, 0);
+  assert_model (filter, "3 4 5 6 7");
+  assert_changes (filter, "0-7+5");
+
+  g_object_unref (filter);
+
+  /* enough items to need more than one time slice */
+  store = new_store (1, 100000, 1);
+  filter = gtk_filter_list_model_new (G_LIST_MODEL (store), NULL, NULL, NULL);
+  gtk_filter_list_model_set_incremental (filter, TRUE);
+  gtk_filter_list_model_set_filter_func (filter, is_smaller_than, GUINT_TO_POINTER (50001), NULL);
+  g_assert_cmpuint (gtk_filter_list_model_get_pending (filter), >, 0);
+
+  /* items added while filtering are filtered right away */
+  add (store, 1);
+  add (store, 100001);
+
+  wait_for_filter (filter);
+  g_assert_cmpuint (g_list_model_get_n_items (G_LIST_MODEL (filter)), ==, 50001);
+  g_assert_cmpuint (get (G_LIST_MODEL (filter), 49999), ==, 50000);
+  g_assert_cmpuint (get (G_LIST_MODEL (filter), 50000), ==, 1);
+
+  g_object_unref (store);
+  g_object_unref (filter);
+}
+
+static void
+test_thread_safe (void)
+{
+  GtkFilterListModel *filter;
+  GListStore *store;
+
+  store = new_store (1, 10000, 1);
+  filter = gtk_filter_list_model_new_for_type (G_TYPE_OBJECT);
+  gtk_filter_list_model_set_thread_safe (filter, TRUE);
+  gtk_filter_list_model_set_filter_func (filter, is_smaller_than, GUINT_TO_POINTER (5001), NULL);
+
+  gtk_filter_list_model_set_model (filter, G_LIST_MODEL (store));
+  g_assert_cmpuint (g_list_model_get_n_items (G_LIST_MODEL (filter)), ==, 5000);
+  g_assert_cmpuint (get (G_LIST_MODEL (filter), 4999), ==, 5000);
+
+  gtk_filter_list_model_set_filter_func (filter, is_larger_than, GUINT_TO_POINTER (2500), NULL);
+  g_assert_cmpuint (g_list_model_get_n_items (G_LIST_MODEL (filter)), ==, 7500);
+  g_assert_cmpuint (get (G_LIST_MODEL (filter), 0), ==, 2501);
+  g_assert_cmpuint (get (G_LIST_MODEL (filter), 7499), ==, 10000);
+
+  g_object_unref (store);
+  g_object_unref (filter);
+}
+
 int
 main (int argc, char *argv[])
 {
@@ -319,6 +406,8 @@ main (int argc, char *argv[])
   g_test_add_func ("/filterlistmodel/create", test_create);
   g_test_add_func ("/filterlistmodel/empty_set_filter_func", test_empty_set_filter_func);
   g_test_add_func ("/filterlistmodel/change_filter_func", test_change_filter_func);
+  g_test_add_func ("/filterlistmodel/incremental", test_incremental);
+  g_test_add_func ("/filterlistmodel/thread-safe", test_thread_safe);
 
   return g_test_run ();
 }
@@ -223,6 +223,75 @@ test_add (void)
   g_assert_cmpint (height, ==, 1);
 }
 
+static void
+measure_item (GtkLayoutItem   *item,
+              GtkStyleContext *context,
+              GtkOrientation   orientation,
+              int              for_size,
+              int             *minimum,
+              int             *natural,
+              gpointer         user_data)
+{
+  *minimum = *natural = GPOINTER_TO_INT (user_data);
+}
+
+static void
+snapshot_item (GtkLayoutItem   *item,
+               GtkStyleContext *context,
+               GtkSnapshot     *snapshot,
+               int              width,
+               int              height,
+               gpointer         user_data)
+{
+}
+
+/* test that layout items take part in the layout
+ * and follow row and column changes
+ */
+static void
+test_items (void)
+{
+  GtkGrid *g;
+  GtkLayoutItem *a, *b;
+  GtkWidget *child;
+  gint minimum, natural;
+  gint left;
+
+  g = (GtkGrid *)gtk_grid_new ();
+  g_object_ref_sink (g);
+
+  a = gtk_layout_item_new (measure_item, snapshot_item, GINT_TO_POINTER (20), NULL);
+  b = gtk_layout_item_new (measure_item, snapshot_item, GINT_TO_POINTER (30), NULL);
+
+  gtk_grid_attach_item (g, a, 0, 0, 1, 1);
+  gtk_grid_attach_item (g, b, 1, 0, 1, 1);
+  g_assert (gtk_layout_item_get_host (a) == GTK_WIDGET (g));
+
+  gtk_widget_measure (GTK_WIDGET (g), GTK_ORIENTATION_HORIZONTAL, -1,
+                      &minimum, &natural, NULL, NULL);
+  g_assert_cmpint (minimum, ==, 50);
+  g_assert_cmpint (natural, ==, 50);
+
+  /* widgets are placed after items */
+  child = gtk_label_new ("a");
+  gtk_container_add (GTK_CONTAINER (g), child);
+  gtk_container_child_get (GTK_CONTAINER (g), child,
+                           "left-attach", &left,
+                           NULL);
+  g_assert_cmpint (left, ==, 2);
+
+  gtk_grid_remove_column (g, 0);
+  g_assert (gtk_layout_item_get_host (a) == NULL);
+  g_assert (gtk_layout_item_get_host (b) == GTK_WIDGET (g));
+
+  gtk_grid_remove_item (g, b);
+  g_assert (gtk_layout_item_get_host (b) == NULL);
+
+  gtk_layout_item_unref (a);
+  gtk_layout_item_unref (b);
+  g_object_unref (g);
+}
+
 int
 main (int   argc,
       char *argv[])
@@ -231,6 +300,7 @@ main (int   argc,
 
   g_test_add_func ("/grid/attach", test_attach);
   g_test_add_func ("/grid/add", test_add);
+  g_test_add_func ("/grid/items", test_items);
 
   return g_test_run();
 }
@@ -80,6 +80,16 @@ test_sort (void)
   gtk_list_box_row_changed (row);
   g_assert_cmpint (count, >, 0);
 
+  /* A changed row moves without resorting the whole list */
+  count = 0;
+  label = gtk_bin_get_child (GTK_BIN (row));
+  g_object_set_data (G_OBJECT (label), "data", GINT_TO_POINTER (2000));
+  gtk_list_box_row_changed (row);
+  g_assert_cmpint (count, <, 50);
+  g_assert_cmpint (gtk_list_box_row_get_index (row), ==, 99);
+
+  check_sorted (list);
+
   g_object_unref (list);
 }
 
@@ -434,6 +444,66 @@ test_header (void)
   g_object_unref (list);
 }
 
+static GtkWidget *
+create_label (gpointer item,
+              gpointer data)
+{
+  gint *count = data;
+
+  (*count)++;
+
+  return gtk_label_new ("row");
+}
+
+static void
+test_lazy_rows (void)
+{
+  GtkListBox *list;
+  GListStore *store;
+  GtkListBoxRow *row;
+  GObject *item;
+  gint i;
+  gint count;
+
+  list = GTK_LIST_BOX (gtk_list_box_new ());
+  g_object_ref_sink (list);
+  gtk_widget_show (GTK_WIDGET (list));
+
+  store = g_list_store_new (G_TYPE_OBJECT);
+  for (i = 0; i < 100; i++)
+    {
+      item = g_object_new (G_TYPE_OBJECT, NULL);
+      g_list_store_append (store, item);
+      g_object_unref (item);
+    }
+
+  count = 0;
+  gtk_list_box_set_lazy_rows (list, TRUE);
+  gtk_list_box_bind_model (list, G_LIST_MODEL (store), create_label, &count, NULL);
+
+  /* Rows exist right away, their widgets do not */
+  g_assert_cmpint (count, ==, 0);
+  row = gtk_list_box_get_row_at_index (list, 99);
+  g_assert_nonnull (row);
+  g_assert_null (gtk_bin_get_child (GTK_BIN (row)));
+
+  item = g_object_new (G_TYPE_OBJECT, NULL);
+  g_list_store_insert (store, 0, item);
+  g_object_unref (item);
+  g_assert_cmpint (count, ==, 0);
+  g_assert_nonnull (gtk_list_box_get_row_at_index (list, 100));
+
+  /* Turning lazy rows off creates all widgets */
+  gtk_list_box_set_lazy_rows (list, FALSE);
+  g_assert_cmpint (count, ==, 101);
+  row = gtk_list_box_get_row_at_index (list, 100);
+  g_assert_true (GTK_IS_LABEL (gtk_bin_get_child (GTK_BIN (row))));
+
+  gtk_list_box_bind_model (list, NULL, NULL, NULL, NULL);
+  g_object_unref (store);
+  g_object_unref (list);
+}
+
 int
 main (int argc, char *argv[])
 {
@@ -444,6 +514,7 @@ main (int argc, char *argv[])
   g_test_add_func ("/listbox/multi-selection", test_multi_selection);
   g_test_add_func ("/listbox/filter", test_filter);
   g_test_add_func ("/listbox/header", test_header);
+  g_test_add_func ("/listbox/lazy-rows", test_lazy_rows);
 
   return g_test_run ();
 }
@@ -455,6 +455,116 @@ list_store_test_insert_before_NULL (void)
   g_object_unref (store);
 }
 
+/* bulk insertion */
+static void
+log_inserted (GtkTreeModel *model,
+              GtkTreePath  *path,
+              GtkTreeIter  *iter,
+              GString      *inserted)
+{
+  gchar *str = gtk_tree_path_to_string (path);
+
+  if (inserted->len)
+    g_string_append_c (inserted, ' ');
+  g_string_append (inserted, str);
+  g_free (str);
+}
+
+/* Inserts @n_rows rows with the values 10, 11, ... at @position and
+ * checks the paths of the row-inserted signals and the values of all
+ * rows afterwards */
+static void
+check_insert_many (GtkListStore *store,
+                   gint          position,
+                   gint          n_rows,
+                   const gchar  *expected_inserted,
+                   const gchar  *expected_values)
+{
+  GString *inserted, *string;
+  GValue *values;
+  GtkTreeIter iter;
+  gint column = 0;
+  gboolean valid;
+  gint i, value;
+
+  values = g_new0 (GValue, n_rows);
+  for (i = 0; i < n_rows; i++)
+    {
+      g_value_init (&values[i], G_TYPE_INT);
+      g_value_set_int (&values[i], 10 + i);
+    }
+
+  inserted = g_string_new (NULL);
+  g_signal_connect (store, "row-inserted", G_CALLBACK (log_inserted), inserted);
+  gtk_list_store_insert_many_with_valuesv (store, position, n_rows, &column, values, 1);
+  g_signal_handlers_disconnect_by_func (store, log_inserted, inserted);
+
+  g_assert_cmpstr (inserted->str, ==, expected_inserted);
+
+  string = g_string_new (NULL);
+  for (valid = gtk_tree_model_iter_children (GTK_TREE_MODEL (store), &iter, NULL);
+       valid;
+       valid = gtk_tree_model_iter_next (GTK_TREE_MODEL (store), &iter))
+    {
+      gtk_tree_model_get (GTK_TREE_MODEL (store), &iter, 0, &value, -1);
+      if (string->len)
+        g_string_append_c (string, ' ');
+      g_string_append_printf (string, "%d", value);
+    }
+
+  g_assert_cmpstr (string->str, ==, expected_values);
+
+  for (i = 0; i < n_rows; i++)
+    g_value_unset (&values[i]);
+  g_free (values);
+  g_string_free (inserted, TRUE);
+  g_string_free (string, TRUE);
+}
+
+static GtkListStore *
+new_store_with_two_rows (void)
+{
+  GtkListStore *store;
+
+  store = gtk_list_store_new (1, G_TYPE_INT);
+  gtk_list_store_insert_with_values (store, NULL, -1, 0, 1, -1);
+  gtk_list_store_insert_with_values (store, NULL, -1, 0, 2, -1);
+
+  return store;
+}
+
+static void
+list_store_test_insert_many (void)
+{
+  GtkListStore *store = new_store_with_two_rows ();
+
+  check_insert_many (store, 1, 3, "1 2 3", "1 10 11 12 2");
+
+  g_object_unref (store);
+}
+
+static void
+list_store_test_insert_many_append (void)
+{
+  GtkListStore *store = new_store_with_two_rows ();
+
+  check_insert_many (store, -1, 2, "2 3", "1 2 10 11");
+
+  g_object_unref (store);
+}
+
+static void
+list_store_test_insert_many_sorted (void)
+{
+  GtkListStore *store = new_store_with_two_rows ();
+
+  /* sorted stores put every row in its place */
+  gtk_tree_sortable_set_sort_column_id (GTK_TREE_SORTABLE (store), 0, GTK_SORT_DESCENDING);
+  check_insert_many (store, 2, 3, "0 0 0", "12 11 10 2 1");
+
+  g_object_unref (store);
+}
+
 /* setting values */
 static void
 list_store_set_gvalue_to_transform (void)
@@ -1034,6 +1144,14 @@ register_list_store_tests (void)
   g_test_add_func ("/ListStore/insert-before-NULL",
 		   list_store_test_insert_before_NULL);
 
+  /* bulk insertion */
+  g_test_add_func ("/ListStore/insert-many",
+                   list_store_test_insert_many);
+  g_test_add_func ("/ListStore/insert-many-append",
+                   list_store_test_insert_many_append);
+  g_test_add_func ("/ListStore/insert-many-sorted",
+                   list_store_test_insert_many_sorted);
+
   /* setting values (FIXME) */
   g_test_add_func ("/ListStore/set-gvalue-to-transform",
                    list_store_set_gvalue_to_transform);
@@ -0,0 +1,429 @@
+/*
+ * Copyright (C) 2019, Red Hat, Inc.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <locale.h>
+
+#include <gtk/gtk.h>
+
+#define ROW_HEIGHT 20
+#define VIEW_WIDTH 200
+#define VIEW_HEIGHT 100
+
+static GQuark number_quark;
+
+typedef struct
+{
+  guint n_setup;
+  guint n_bind;
+} Counts;
+
+static GObject *
+make_object (guint number)
+{
+  GObject *object;
+
+  /* 0 cannot be differentiated from NULL, so don't use it */
+  g_assert (number != 0);
+
+  object = g_object_new (G_TYPE_OBJECT, NULL);
+  g_object_set_qdata (object, number_quark, GUINT_TO_POINTER (number));
+
+  return object;
+}
+
+static GListStore *
+new_store (guint start,
+           guint end)
+{
+  GListStore *store = g_list_store_new (G_TYPE_OBJECT);
+  guint i;
+
+  for (i = start; i <= end; i++)
+    {
+      GObject *object = make_object (i);
+      g_list_store_append (store, object);
+      g_object_unref (object);
+    }
+
+  return store;
+}
+
+static void
+insert (GListStore *store,
+        guint       position,
+        guint       number)
+{
+  GObject *object = make_object (number);
+  g_list_store_insert (store, position, object);
+  g_object_unref (object);
+}
+
+static void
+setup_item (GtkListItem *list_item,
+            gpointer     data)
+{
+  Counts *counts = data;
+
+  gtk_widget_set_size_request (GTK_WIDGET (list_item), -1, ROW_HEIGHT);
+  counts->n_setup++;
+}
+
+static void
+bind_item (GtkListItem *list_item,
+           gpointer     data)
+{
+  Counts *counts = data;
+
+  counts->n_bind++;
+}
+
+/* Returns a scrolled window containing a list view for @model */
+static GtkWidget *
+new_list_view (GListModel  *model,
+               Counts      *counts,
+               GtkWidget  **list)
+{
+  GtkWidget *sw;
+
+  *list = gtk_list_view_new ();
+  gtk_list_view_set_functions (GTK_LIST_VIEW (*list), setup_item, bind_item, counts, NULL);
+  gtk_list_view_set_model (GTK_LIST_VIEW (*list), model);
+
+  sw = gtk_scrolled_window_new (NULL, NULL);
+  gtk_container_add (GTK_CONTAINER (sw), *list);
+  g_object_ref_sink (sw);
+
+  return sw;
+}
+
+static void
+allocate (GtkWidget *sw)
+{
+  gtk_widget_measure (sw, GTK_ORIENTATION_HORIZONTAL, -1, NULL, NULL, NULL, NULL);
+  gtk_widget_measure (sw, GTK_ORIENTATION_VERTICAL, VIEW_WIDTH, NULL, NULL, NULL, NULL);
+  gtk_widget_size_allocate (sw, &(GtkAllocation) { 0, 0, VIEW_WIDTH, VIEW_HEIGHT }, -1);
+}
+
+static void
+scroll_to (GtkWidget *list,
+           double     value)
+{
+  GtkAdjustment *vadjustment = gtk_scrollable_get_vadjustment (GTK_SCROLLABLE (list));
+
+  gtk_adjustment_set_value (vadjustment, value);
+}
+
+/* Checks that the list items are the children of @list in the order of
+ * their items, that they display a contiguous range of the model and
+ * that they show the items at their positions. Returns the number of
+ * list items and sets @first to the position of the first one.
+ */
+static guint
+check_list_items (GtkWidget *list,
+                  guint     *first)
+{
+  GListModel *model = gtk_list_view_get_model (GTK_LIST_VIEW (list));
+  GtkWidget *child;
+  guint n, position;
+
+  n = 0;
+  position = 0;
+  for (child = gtk_widget_get_first_child (list);
+       child != NULL;
+       child = gtk_widget_get_next_sibling (child))
+    {
+      GtkListItem *list_item;
+      GObject *item;
+
+      g_assert (GTK_IS_LIST_ITEM (child));
+      list_item = GTK_LIST_ITEM (child);
+
+      if (n == 0)
+        position = gtk_list_item_get_position (list_item);
+      else
+        g_assert_cmpuint (gtk_list_item_get_position (list_item), ==, position + n);
+
+      item = g_list_model_get_item (model, gtk_list_item_get_position (list_item));
+      g_assert (item != NULL);
+      g_assert (gtk_list_item_get_item (list_item) == item);
+      g_object_unref (item);
+
+      n++;
+    }
+
+  if (first)
+    *first = position;
+
+  return n;
+}
+
+/* The most list items a list view of VIEW_HEIGHT can need: the rows
+ * for the visible area plus half a page above and below it */
+static guint
+max_list_items (void)
+{
+  return 2 * VIEW_HEIGHT / ROW_HEIGHT + 2;
+}
+
+static GtkListItem *
+find_list_item (GtkWidget *list,
+                guint      number)
+{
+  GtkWidget *child;
+
+  for (child = gtk_widget_get_first_child (list);
+       child != NULL;
+       child = gtk_widget_get_next_sibling (child))
+    {
+      GObject *item = gtk_list_item_get_item (GTK_LIST_ITEM (child));
+
+      if (GPOINTER_TO_UINT (g_object_get_qdata (item, number_quark)) == number)
+        return GTK_LIST_ITEM (child);
+    }
+
+  return NULL;
+}
+
+/* Checks that going from @n_before to @n list items only set up the
+ * list items that were missing */
+static void
+assert_recycled (Counts *counts,
+                 guint   n_setup,
+                 guint   n_before,
+                 guint   n)
+{
+  g_assert_cmpuint (counts->n_setup - n_setup, ==, n > n_before ? n - n_before : 0);
+}
+
+static void
+test_create_empty (void)
+{
+  GtkWidget *sw, *list;
+  GListStore *store;
+  Counts counts = { 0, };
+
+  store = g_list_store_new (G_TYPE_OBJECT);
+  sw = new_list_view (G_LIST_MODEL (store), &counts, &list);
+  allocate (sw);
+
+  g_assert_cmpuint (check_list_items (list, NULL), ==, 0);
+  g_assert_cmpuint (counts.n_setup, ==, 0);
+  g_assert_cmpuint (counts.n_bind, ==, 0);
+
+  g_object_unref (store);
+  g_object_unref (sw);
+}
+
+static void
+test_create (void)
+{
+  GtkWidget *sw, *list;
+  GListStore *store;
+  Counts counts = { 0, };
+  guint n, first;
+
+  store = new_store (1, 1000);
+  sw = new_list_view (G_LIST_MODEL (store), &counts, &list);
+  allocate (sw);
+
+  n = check_list_items (list, &first);
+  g_assert_cmpuint (first, ==, 0);
+  g_assert_cmpuint (n, >, 0);
+  g_assert_cmpuint (n, <=, max_list_items ());
+  g_assert_cmpuint (counts.n_setup, ==, n);
+  g_assert_cmpuint (counts.n_bind, ==, n);
+
+  g_object_unref (store);
+  g_object_unref (sw);
+}
+
+static void
+test_recycle (void)
+{
+  GtkWidget *sw, *list;
+  GListStore *store;
+  GtkListItem *list_item;
+  Counts counts = { 0, };
+  guint n, n_before, first, n_setup;
+
+  store = new_store (1, 1000);
+  sw = new_list_view (G_LIST_MODEL (store), &counts, &list);
+  allocate (sw);
+  n = check_list_items (list, NULL);
+  list_item = find_list_item (list, 2);
+  g_assert (list_item != NULL);
+
+  /* Scrolling a bit keeps the list items of the items that are
+   * still visible */
+  n_setup = counts.n_setup;
+  n_before = n;
+  scroll_to (list, ROW_HEIGHT / 2);
+  allocate (sw);
+  n = check_list_items (list, &first);
+  g_assert_cmpuint (first, ==, 0);
+  g_assert (find_list_item (list, 2) == list_item);
+  g_assert_cmpuint (n, <=, max_list_items ());
+  assert_recycled (&counts, n_setup, n_before, n);
+
+  /* Scrolling far away rebinds the list items instead of creating
+   * new ones */
+  n_setup = counts.n_setup;
+  n_before = n;
+  scroll_to (list, 500 * ROW_HEIGHT);
+  allocate (sw);
+  n = check_list_items (list, &first);
+  g_assert_cmpuint (first, >, 0);
+  g_assert_cmpuint (n, <=, max_list_items ());
+  assert_recycled (&counts, n_setup, n_before, n);
+
+  n_setup = counts.n_setup;
+  n_before = n;
+  scroll_to (list, 0);
+  allocate (sw);
+  n = check_list_items (list, &first);
+  g_assert_cmpuint (first, ==, 0);
+  assert_recycled (&counts, n_setup, n_before, n);
+
+  /* The list items are reused for a new model, too */
+  n_setup = counts.n_setup;
+  n_before = n;
+  g_object_unref (store);
+  store = new_store (1001, 2000);
+  gtk_list_view_set_model (GTK_LIST_VIEW (list), G_LIST_MODEL (store));
+  allocate (sw);
+  n = check_list_items (list, &first);
+  g_assert_cmpuint (first, ==, 0);
+  assert_recycled (&counts, n_setup, n_before, n);
+  g_assert (find_list_item (list, 1001) != NULL);
+
+  g_object_unref (store);
+  g_object_unref (sw);
+}
+
+static void
+test_items_changed_scrolled (void)
+{
+  GtkWidget *sw, *list;
+  GListStore *store;
+  GtkListItem *list_item;
+  Counts counts = { 0, };
+  guint n, first, n_bind;
+
+  store = new_store (1, 1000);
+  sw = new_list_view (G_LIST_MODEL (store), &counts, &list);
+  allocate (sw);
+  scroll_to (list, 500 * ROW_HEIGHT);
+  allocate (sw);
+  n = check_list_items (list, &first);
+  g_assert_cmpuint (first, >, 0);
+
+  /* Pick an item in the middle of the visible ones, so it is still
+   * visible after the changes below */
+  list_item = GTK_LIST_ITEM (gtk_widget_get_first_child (list));
+  while (gtk_list_item_get_position (list_item) < first + n / 2)
+    list_item = GTK_LIST_ITEM (gtk_widget_get_next_sibling (GTK_WIDGET (list_item)));
+  g_assert_cmpuint (gtk_list_item_get_position (list_item), ==, first + n / 2);
+
+  /* Inserting above the visible items moves them, but they keep their
+   * list items and only get new positions */
+  n_bind = counts.n_bind;
+  insert (store, 0, 1001);
+  insert (store, 0, 1002);
+  allocate (sw);
+  check_list_items (list, NULL);
+  g_assert (find_list_item (list, first + n / 2 + 1) == list_item);
+  g_assert_cmpuint (gtk_list_item_get_position (list_item), ==, first + n / 2 + 2);
+  g_assert_cmpuint (counts.n_bind - n_bind, <=, 2);
+
+  /* Removing above the visible items moves them back */
+  n_bind = counts.n_bind;
+  g_list_store_remove (store, 0);
+  g_list_store_remove (store, 0);
+  allocate (sw);
+  check_list_items (list, NULL);
+  g_assert (find_list_item (list, first + n / 2 + 1) == list_item);
+  g_assert_cmpuint (gtk_list_item_get_position (list_item), ==, first + n / 2);
+  g_assert_cmpuint (counts.n_bind - n_bind, <=, 2);
+
+  /* Inserting between the visible items binds a list item for the
+   * new item only */
+  n_bind = counts.n_bind;
+  insert (store, first + n / 2, 1003);
+  allocate (sw);
+  check_list_items (list, NULL);
+  g_assert (find_list_item (list, 1003) != NULL);
+  g_assert (find_list_item (list, first + n / 2 + 1) == list_item);
+  g_assert_cmpuint (gtk_list_item_get_position (list_item), ==, first + n / 2 + 1);
+  g_assert_cmpuint (counts.n_bind - n_bind, <=, 2);
+
+  /* Removing a visible item doesn't leave its list item behind */
+  g_list_store_remove (store, first + n / 2 + 1);
+  allocate (sw);
+  check_list_items (list, NULL);
+  g_assert (find_list_item (list, first + n / 2 + 1) == NULL);
+  g_assert (find_list_item (list, 1003) != NULL);
+
+  /* Removing all items removes all list items */
+  g_list_store_remove_all (store);
+  allocate (sw);
+  g_assert_cmpuint (check_list_items (list, NULL), ==, 0);
+
+  g_object_unref (store);
+  g_object_unref (sw);
+}
+
+static void
+test_set_functions (void)
+{
+  GtkWidget *sw, *list;
+  GListStore *store;
+  Counts counts = { 0, };
+  Counts new_counts = { 0, };
+  guint n;
+
+  store = new_store (1, 1000);
+  sw = new_list_view (G_LIST_MODEL (store), &counts, &list);
+  allocate (sw);
+
+  /* The list items were set up by the old functions, so they can't
+   * be reused */
+  gtk_list_view_set_functions (GTK_LIST_VIEW (list), setup_item, bind_item, &new_counts, NULL);
+  allocate (sw);
+  n = check_list_items (list, NULL);
+  g_assert_cmpuint (new_counts.n_setup, ==, n);
+  g_assert_cmpuint (new_counts.n_bind, ==, n);
+
+  g_object_unref (store);
+  g_object_unref (sw);
+}
+
+int
+main (int argc, char *argv[])
+{
+  gtk_test_init (&argc, &argv, NULL);
+  setlocale (LC_ALL, "C");
+
+  number_quark = g_quark_from_static_string ("Like a trumpet blast, the sound of victory.");
+
+  g_test_add_func ("/listview/create_empty", test_create_empty);
+  g_test_add_func ("/listview/create", test_create);
+  g_test_add_func ("/listview/recycle", test_recycle);
+  g_test_add_func ("/listview/set-functions", test_set_functions);
+  g_test_add_func ("/listview/items-changed-scrolled", test_items_changed_scrolled);
+
+  return g_test_run ();
+}
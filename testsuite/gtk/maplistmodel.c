@@ -187,6 +187,38 @@ map_multiply (gpointer item,
   return object;
 }
 
+static guint n_mapped;
+static guint n_batches;
+
+static gpointer
+map_counting (gpointer item,
+              gpointer factor)
+{
+  n_mapped++;
+
+  return map_multiply (item, factor);
+}
+
+static void
+batch_map_counting (gpointer *items,
+                    guint     n_items,
+                    gpointer  factor)
+{
+  guint i;
+
+  n_batches++;
+
+  for (i = 0; i < n_items; i++)
+    items[i] = map_counting (items[i], factor);
+}
+
+static void
+get_and_unref (GtkMapListModel *map,
+               guint            position)
+{
+  g_object_unref (g_list_model_get_item (G_LIST_MODEL (map), position));
+}
+
 static GtkMapListModel *
 new_model (GListStore *store)
 {
@@ -281,6 +313,114 @@ test_set_map_func (void)
   g_object_unref (map);
 }
 
+static void
+test_cache (void)
+{
+  GtkMapListModel *map;
+  GListStore *store;
+  GObject *object;
+
+  store = new_store (1, 10, 1);
+  map = new_model (store);
+  gtk_map_list_model_set_map_func (map, map_counting, GUINT_TO_POINTER (2), NULL);
+  assert_changes (map, "0-10+10");
+  n_mapped = 0;
+
+  /* without a cache, unused items get mapped again */
+  get_and_unref (map, 0);
+  get_and_unref (map, 0);
+  g_assert_cmpuint (n_mapped, ==, 2);
+
+  gtk_map_list_model_set_cache_size (map, 3);
+  n_mapped = 0;
+  get_and_unref (map, 0);
+  get_and_unref (map, 0);
+  g_assert_cmpuint (n_mapped, ==, 1);
+
+  get_and_unref (map, 1);
+  get_and_unref (map, 2);
+  get_and_unref (map, 0);
+  g_assert_cmpuint (n_mapped, ==, 3);
+
+  /* 1 is the least recently used item now */
+  get_and_unref (map, 3);
+  get_and_unref (map, 0);
+  get_and_unref (map, 2);
+  g_assert_cmpuint (n_mapped, ==, 4);
+  get_and_unref (map, 1);
+  g_assert_cmpuint (n_mapped, ==, 5);
+
+  /* items still referenced elsewhere survive eviction */
+  object = g_list_model_get_item (G_LIST_MODEL (map), 5);
+  gtk_map_list_model_set_cache_size (map, 0);
+  g_assert_true (g_list_model_get_item (G_LIST_MODEL (map), 5) == object);
+  g_object_unref (object);
+  g_object_unref (object);
+  g_assert_cmpuint (n_mapped, ==, 6);
+
+  /* the cache follows changes of the model */
+  gtk_map_list_model_set_cache_size (map, 10);
+  get_and_unref (map, 1);
+  get_and_unref (map, 2);
+  add (store, 11);
+  g_list_store_remove (store, 0);
+  object = g_list_model_get_item (G_LIST_MODEL (store), 9);
+  g_list_store_insert (store, 1, object);
+  g_object_unref (object);
+  assert_changes (map, "+10, -0, +1");
+  assert_model (map, "4 22 6 8 10 12 14 16 18 20 22");
+
+  g_object_unref (store);
+  g_object_unref (map);
+}
+
+static void
+test_prefetch (void)
+{
+  GtkMapListModel *map;
+  GListStore *store;
+
+  store = new_store (1, 10, 1);
+  map = new_model (store);
+  gtk_map_list_model_set_map_func (map, map_counting, GUINT_TO_POINTER (2), NULL);
+  assert_changes (map, "0-10+10");
+  gtk_map_list_model_set_prefetch (map, 2);
+  n_mapped = 0;
+
+  /* prefetching requires a cache */
+  get_and_unref (map, 5);
+  g_assert_cmpuint (n_mapped, ==, 1);
+
+  gtk_map_list_model_set_cache_size (map, 5);
+  n_mapped = 0;
+  get_and_unref (map, 5);
+  g_assert_cmpuint (n_mapped, ==, 5);
+  get_and_unref (map, 3);
+  get_and_unref (map, 7);
+  g_assert_cmpuint (n_mapped, ==, 5);
+
+  /* the window is clamped at the ends of the model */
+  n_mapped = 0;
+  get_and_unref (map, 0);
+  g_assert_cmpuint (n_mapped, ==, 3);
+  n_mapped = 0;
+  get_and_unref (map, 9);
+  g_assert_cmpuint (n_mapped, ==, 2); /* 7 is still cached */
+
+  /* batches only map items that are not mapped yet */
+  gtk_map_list_model_set_batch_map_func (map, batch_map_counting);
+  n_mapped = 0;
+  n_batches = 0;
+  get_and_unref (map, 3);
+  g_assert_cmpuint (n_batches, ==, 1);
+  g_assert_cmpuint (n_mapped, ==, 3);
+
+  assert_model (map, "2 4 6 8 10 12 14 16 18 20");
+
+  g_object_unref (store);
+  g_object_unref (map);
+}
+
 int
 main (int argc, char *argv[])
 {
@@ -295,6 +435,8 @@ main (int argc, char *argv[])
   g_test_add_func ("/maplistmodel/create", test_create);
   g_test_add_func ("/maplistmodel/set-model", test_set_model);
   g_test_add_func ("/maplistmodel/set-map-func", test_set_map_func);
+  g_test_add_func ("/maplistmodel/cache", test_cache);
+  g_test_add_func ("/maplistmodel/prefetch", test_prefetch);
 
   return g_test_run ();
 }
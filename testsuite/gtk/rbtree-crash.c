@@ -287,6 +287,114 @@ test_crash2 (void)
   gtk_rb_tree_unref (tree);
 }
 
+static guint
+n_items (GtkRbTree *tree)
+{
+  Node *root = gtk_rb_tree_get_root (tree);
+  Aug *aug;
+
+  if (root == NULL)
+    return 0;
+
+  aug = gtk_rb_tree_get_augment (tree, root);
+
+  return aug->n_items;
+}
+
+static void
+mark (GtkRbTree *tree,
+      guint      value)
+{
+  Node *node;
+
+  for (node = gtk_rb_tree_get_first (tree);
+       node;
+       node = gtk_rb_tree_node_get_next (node))
+    node->unused = value;
+}
+
+static void
+assert_marks (GtkRbTree *tree,
+              guint      value,
+              guint      position,
+              guint      n)
+{
+  Node *node;
+  guint i;
+
+  i = 0;
+  for (node = gtk_rb_tree_get_first (tree);
+       node;
+       node = gtk_rb_tree_node_get_next (node))
+    {
+      if (i >= position && i < position + n)
+        g_assert_cmpuint (node->unused, ==, value);
+      else
+        g_assert_cmpuint (node->unused, !=, value);
+      i++;
+    }
+  g_assert_cmpuint (i, ==, n_items (tree));
+}
+
+static void
+test_many (void)
+{
+  GtkRbTree *tree;
+  guint i;
+
+  tree = gtk_rb_tree_new (Node, Aug, augment, NULL, NULL);
+
+  /* into an empty tree */
+  gtk_rb_tree_insert_many_before (tree, NULL, 1000);
+  g_assert_cmpuint (n_items (tree), ==, 1000);
+  mark (tree, 1);
+
+  /* few nodes get inserted one by one */
+  gtk_rb_tree_insert_many_before (tree, get (tree, 500), 5);
+  g_assert_cmpuint (n_items (tree), ==, 1005);
+  assert_marks (tree, 0, 500, 5);
+  mark (tree, 1);
+
+  /* many nodes rebuild the tree */
+  gtk_rb_tree_insert_many_before (tree, get (tree, 100), 2000);
+  g_assert_cmpuint (n_items (tree), ==, 3005);
+  assert_marks (tree, 0, 100, 2000);
+  gtk_rb_tree_insert_many_before (tree, NULL, 3000);
+  g_assert_cmpuint (n_items (tree), ==, 6005);
+  assert_marks (tree, 0, 100, 2000);
+  mark (tree, 1);
+
+  /* the rebuilt tree must still be valid */
+  for (i = 0; i < 300; i++)
+    add (tree, i * 7);
+  for (i = 0; i < 300; i++)
+    delete (tree, i * 5);
+  g_assert_cmpuint (n_items (tree), ==, 6005);
+
+  get (tree, 10)->unused = 2;
+  gtk_rb_tree_remove_many (tree, get (tree, 10), 3);
+  g_assert_cmpuint (n_items (tree), ==, 6002);
+  assert_marks (tree, 2, 0, 0);
+
+  for (i = 20; i < 4020; i++)
+    get (tree, i)->unused = 2;
+  gtk_rb_tree_remove_many (tree, get (tree, 20), 4000);
+  g_assert_cmpuint (n_items (tree), ==, 2002);
+  assert_marks (tree, 2, 0, 0);
+
+  for (i = 0; i < 300; i++)
+    add (tree, i * 3);
+  for (i = 0; i < 300; i++)
+    delete (tree, i * 2);
+  g_assert_cmpuint (n_items (tree), ==, 2002);
+
+  gtk_rb_tree_remove_many (tree, gtk_rb_tree_get_first (tree), 2002);
+  g_assert_cmpuint (n_items (tree), ==, 0);
+  g_assert (gtk_rb_tree_get_root (tree) == NULL);
+
+  gtk_rb_tree_unref (tree);
+}
+
 int
 main (int argc, char *argv[])
 {
@@ -296,6 +404,7 @@ main (int argc, char *argv[])
 
   g_test_add_func ("/rbtree/crash", test_crash);
   g_test_add_func ("/rbtree/crash2", test_crash2);
+  g_test_add_func ("/rbtree/many", test_many);
 
   return g_test_run ();
 }
@@ -380,6 +380,99 @@ test_remove_items (void)
   g_object_unref (sort);
 }
 
+static void
+test_remove_changed_item (void)
+{
+  GtkSortListModel *sort;
+  GListStore *store;
+  GObject *object;
+
+  store = new_store ((guint[]) { 4, 8, 2, 6, 10, 0 });
+  sort = new_model (store);
+  assert_model (sort, "2 4 6 8 10");
+  assert_changes (sort, "");
+
+  /* change what the sort function looks at without resorting */
+  object = g_list_model_get_item (G_LIST_MODEL (store), 0);
+  g_object_set_qdata (object, number_quark, GUINT_TO_POINTER (12));
+  g_object_unref (object);
+  assert_model (sort, "2 12 6 8 10");
+
+  g_list_store_remove (store, 0);
+  assert_model (sort, "2 6 8 10");
+  assert_changes (sort, "-1");
+
+  g_object_unref (store);
+  g_object_unref (sort);
+}
+
+static void
+wait_for_sort (GtkSortListModel *sort)
+{
+  while (gtk_sort_list_model_get_pending (sort) > 0)
+    g_main_context_iteration (NULL, TRUE);
+}
+
+static void
+test_incremental (void)
+{
+  GtkSortListModel *sort;
+  GListStore *store;
+  guint i;
+
+  sort = new_model (NULL);
+  gtk_sort_list_model_set_incremental (sort, TRUE);
+  gtk_sort_list_model_set_sort_func (sort, compare, NULL, NULL);
+  assert_changes (sort, "");
+
+  store = new_store ((guint[]) { 4, 8, 2, 6, 10, 0 });
+  gtk_sort_list_model_set_model (sort, G_LIST_MODEL (store));
+  assert_model (sort, "4 8 2 6 10");
+  assert_changes (sort, "0+5");
+  g_assert_cmpuint (gtk_sort_list_model_get_pending (sort), >, 0);
+
+  wait_for_sort (sort);
+  assert_model (sort, "2 4 6 8 10");
+  assert_changes (sort, "0-5+5");
+
+  /* the old order stays until the new one is ready */
+  gtk_sort_list_model_set_sort_func (sort, compare_modulo, GUINT_TO_POINTER (5), NULL);
+  assert_model (sort, "2 4 6 8 10");
+  assert_changes (sort, "");
+
+  wait_for_sort (sort);
+  assert_model (sort, "10 6 2 8 4");
+  assert_changes (sort, "0-5+5");
+
+  /* turning it off finishes the sort */
+  gtk_sort_list_model_set_sort_func (sort, compare, NULL, NULL);
+  gtk_sort_list_model_set_incremental (sort, FALSE);
+  g_assert_cmpuint (gtk_sort_list_model_get_pending (sort), ==, 0);
+  assert_model (sort, "2 4 6 8 10");
+  assert_changes (sort, "0-5+5");
+
+  g_object_unref (store);
+  g_object_unref (sort);
+
+  /* enough items to need more than one time slice */
+  store = new_empty_store ();
+  for (i = 0; i < 100000; i++)
+    add (store, (i * 7919) % 100000 + 1);
+  sort = new_model (NULL);
+  gtk_sort_list_model_set_incremental (sort, TRUE);
+  gtk_sort_list_model_set_model (sort, G_LIST_MODEL (store));
+  assert_changes (sort, "0+100000");
+  gtk_sort_list_model_set_sort_func (sort, compare, NULL, NULL);
+
+  wait_for_sort (sort);
+  assert_changes (sort, "0-100000+100000");
+  for (i = 0; i < 100000; i++)
+    g_assert_cmpuint (get (G_LIST_MODEL (sort), i), ==, i + 1);
+
+  g_object_unref (store);
+  g_object_unref (sort);
+}
+
 int
 main (int argc, char *argv[])
 {
@@ -394,6 +487,8 @@ main (int argc, char *argv[])
   g_test_add_func ("/sortlistmodel/create", test_create);
   g_test_add_func ("/sortlistmodel/set-model", test_set_model);
   g_test_add_func ("/sortlistmodel/set-sort-func", test_set_sort_func);
+  g_test_add_func ("/sortlistmodel/remove-changed-item", test_remove_changed_item);
+  g_test_add_func ("/sortlistmodel/incremental", test_incremental);
 #if GLIB_CHECK_VERSION (2, 58, 0) /* g_list_store_splice() is broken before 2.58 */
   g_test_add_func ("/sortlistmodel/add_items", test_add_items);
   g_test_add_func ("/sortlistmodel/remove_items", test_remove_items);
@@ -15,6 +15,8 @@
  * License along with this library. If not, see <http://www.gnu.org/licenses/>.
  */
 
+#include <string.h>
+
 #include <gtk/gtk.h>
 
 #include "treemodel.h"
@@ -1289,6 +1291,99 @@ sort_column_change (void)
   g_assert (order == GTK_SORT_ASCENDING);
 }
 
+static void
+check_large_level_sorted (GtkTreeModel *sort_model,
+                          gint          column,
+                          GtkSortType   order)
+{
+  GtkTreeModel *child_model;
+  GtkTreeIter iter, child_iter;
+  GtkTreePath *path;
+  GValue value = G_VALUE_INIT, last = G_VALUE_INIT;
+  gint last_offset = -1;
+  gint n = 0;
+  gboolean valid;
+
+  child_model = gtk_tree_model_sort_get_model (GTK_TREE_MODEL_SORT (sort_model));
+
+  for (valid = gtk_tree_model_get_iter_first (sort_model, &iter);
+       valid;
+       valid = gtk_tree_model_iter_next (sort_model, &iter))
+    {
+      gint offset, cmp = 0;
+
+      gtk_tree_model_sort_convert_iter_to_child_iter (GTK_TREE_MODEL_SORT (sort_model),
+                                                      &child_iter, &iter);
+      path = gtk_tree_model_get_path (child_model, &child_iter);
+      offset = gtk_tree_path_get_indices (path)[0];
+      gtk_tree_path_free (path);
+
+      gtk_tree_model_get_value (child_model, &child_iter, column, &value);
+      if (G_IS_VALUE (&last))
+        {
+          if (G_VALUE_TYPE (&value) == G_TYPE_INT)
+            cmp = g_value_get_int (&value) - g_value_get_int (&last);
+          else
+            cmp = g_utf8_collate (g_value_get_string (&value), g_value_get_string (&last));
+
+          if (order == GTK_SORT_DESCENDING)
+            cmp = -cmp;
+          g_assert_cmpint (cmp, >=, 0);
+          /* The sort is stable */
+          if (cmp == 0)
+            g_assert_cmpint (offset, >, last_offset);
+          g_value_unset (&last);
+        }
+
+      last = value;
+      memset (&value, 0, sizeof (GValue));
+      last_offset = offset;
+      n++;
+    }
+
+  g_value_unset (&last);
+  g_assert_cmpint (n, ==, gtk_tree_model_iter_n_children (child_model, NULL));
+}
+
+static void
+sort_large_level (void)
+{
+  GtkListStore *store;
+  GtkTreeModel *sorted;
+  gint i;
+
+  /* Enough rows to be sorted in parallel */
+  store = gtk_list_store_new (2, G_TYPE_INT, G_TYPE_STRING);
+  for (i = 0; i < 20000; i++)
+    {
+      gchar *str = g_strdup_printf ("row %d", (i * 7919) % 1009);
+
+      gtk_list_store_insert_with_values (store, NULL, -1,
+                                         0, (i * 7919) % 997,
+                                         1, str,
+                                         -1);
+      g_free (str);
+    }
+
+  sorted = gtk_tree_model_sort_new_with_model (GTK_TREE_MODEL (store));
+
+  gtk_tree_sortable_set_sort_column_id (GTK_TREE_SORTABLE (sorted), 0, GTK_SORT_ASCENDING);
+  check_large_level_sorted (sorted, 0, GTK_SORT_ASCENDING);
+
+  gtk_tree_sortable_set_sort_column_id (GTK_TREE_SORTABLE (sorted), 0, GTK_SORT_DESCENDING);
+  check_large_level_sorted (sorted, 0, GTK_SORT_DESCENDING);
+
+  /* Ties keep the order of the previous sort, so start over */
+  g_object_unref (sorted);
+  sorted = gtk_tree_model_sort_new_with_model (GTK_TREE_MODEL (store));
+
+  gtk_tree_sortable_set_sort_column_id (GTK_TREE_SORTABLE (sorted), 1, GTK_SORT_ASCENDING);
+  check_large_level_sorted (sorted, 1, GTK_SORT_ASCENDING);
+
+  g_object_unref (sorted);
+  g_object_unref (store);
+}
+
 /* main */
 
 void
@@ -1317,6 +1412,8 @@ register_sort_model_tests (void)
                    rows_reordered_two_levels);
   g_test_add_func ("/TreeModelSort/sorted-insert",
                    sorted_insert);
+  g_test_add_func ("/TreeModelSort/large-level",
+                   sort_large_level);
 
   g_test_add_func ("/TreeModelSort/specific/bug-300089",
                    specific_bug_300089);
@@ -1580,6 +1580,99 @@ test_get_iter (void)
   g_object_unref (buffer);
 }
 
+static void
+check_buffer_text (GtkTextBuffer *buffer,
+                   const gchar   *expected)
+{
+  GtkTextIter start, end;
+  gchar *text;
+
+  gtk_text_buffer_get_bounds (buffer, &start, &end);
+  text = gtk_text_buffer_get_text (buffer, &start, &end, TRUE);
+  g_assert_cmpstr (text, ==, expected);
+  g_free (text);
+}
+
+static void
+type_text (GtkTextBuffer *buffer,
+           const gchar   *text)
+{
+  const gchar *p;
+
+  for (p = text; *p; p = g_utf8_next_char (p))
+    gtk_text_buffer_insert_interactive_at_cursor (buffer, p, g_utf8_next_char (p) - p, TRUE);
+}
+
+static void
+test_undo (void)
+{
+  GtkTextBuffer *buffer;
+  GtkTextIter start, end;
+
+  buffer = gtk_text_buffer_new (NULL);
+  gtk_text_buffer_set_enable_undo (buffer, TRUE);
+  g_assert (!gtk_text_buffer_get_can_undo (buffer));
+
+  /* Typing is undone a word at a time */
+  type_text (buffer, "hello world");
+  g_assert (gtk_text_buffer_get_can_undo (buffer));
+  gtk_text_buffer_undo (buffer);
+  check_buffer_text (buffer, "hello ");
+  gtk_text_buffer_undo (buffer);
+  check_buffer_text (buffer, "");
+  g_assert (!gtk_text_buffer_get_can_undo (buffer));
+  g_assert (!gtk_text_buffer_get_modified (buffer));
+
+  gtk_text_buffer_redo (buffer);
+  gtk_text_buffer_redo (buffer);
+  check_buffer_text (buffer, "hello world");
+  g_assert (!gtk_text_buffer_get_can_redo (buffer));
+
+  /* A user action is undone as a whole */
+  gtk_text_buffer_set_modified (buffer, FALSE);
+  gtk_text_buffer_begin_user_action (buffer);
+  gtk_text_buffer_get_iter_at_offset (buffer, &start, 0);
+  gtk_text_buffer_get_iter_at_offset (buffer, &end, 6);
+  gtk_text_buffer_delete (buffer, &start, &end);
+  gtk_text_buffer_get_end_iter (buffer, &end);
+  gtk_text_buffer_insert (buffer, &end, "!\n", -1);
+  gtk_text_buffer_end_user_action (buffer);
+  check_buffer_text (buffer, "world!\n");
+  g_assert (gtk_text_buffer_get_modified (buffer));
+
+  gtk_text_buffer_undo (buffer);
+  check_buffer_text (buffer, "hello world");
+  g_assert (!gtk_text_buffer_get_modified (buffer));
+
+  /* Any change drops what could be redone */
+  gtk_text_buffer_get_end_iter (buffer, &end);
+  gtk_text_buffer_insert (buffer, &end, "?", -1);
+  g_assert (!gtk_text_buffer_get_can_redo (buffer));
+
+  /* Backspacing is merged like typing */
+  gtk_text_buffer_get_end_iter (buffer, &end);
+  gtk_text_buffer_backspace (buffer, &end, TRUE, TRUE);
+  gtk_text_buffer_get_end_iter (buffer, &end);
+  gtk_text_buffer_backspace (buffer, &end, TRUE, TRUE);
+  gtk_text_buffer_get_end_iter (buffer, &end);
+  gtk_text_buffer_backspace (buffer, &end, TRUE, TRUE);
+  check_buffer_text (buffer, "hello wor");
+  gtk_text_buffer_undo (buffer);
+  check_buffer_text (buffer, "hello world?");
+
+  /* The oldest changes are dropped to stay below the limit */
+  gtk_text_buffer_set_max_undo_bytes (buffer, 1);
+  g_assert (!gtk_text_buffer_get_can_undo (buffer));
+  g_assert (!gtk_text_buffer_get_can_redo (buffer));
+  gtk_text_buffer_set_max_undo_bytes (buffer, 0);
+
+  gtk_text_buffer_set_enable_undo (buffer, FALSE);
+  type_text (buffer, "x");
+  g_assert (!gtk_text_buffer_get_can_undo (buffer));
+
+  g_object_unref (buffer);
+}
+
 int
 main (int argc, char** argv)
 {
@@ -1599,6 +1692,7 @@ main (int argc, char** argv)
   g_test_add_func ("/TextBuffer/Tag", test_tag);
   g_test_add_func ("/TextBuffer/Clipboard", test_clipboard);
   g_test_add_func ("/TextBuffer/Get iter", test_get_iter);
+  g_test_add_func ("/TextBuffer/Undo", test_undo);
 
   return g_test_run();
 }
@@ -187,6 +187,10 @@ test_search (void)
   check_found_backward ("This is some \303\240 text", "\303\240 text", 0, 13, 19, "\303\240 text");
   check_found_backward ("This is some \303\240 text", "some \303\240 text", 0, 8, 19, "some \303\240 text");
 
+  /* lines that can't match are skipped */
+  check_found_forward ("xyz\nxyz\nxyz foo", "foo", 0, 12, 15, "foo");
+  check_found_forward ("xyz\nxyz\n\357\277\274foo", "foo", 0, 9, 12, "foo");
+
   /* multi-byte characters outside the needle */
   check_found_forward ("\303\200 aa", "aa", 0, 2, 4, "aa");
   check_found_forward ("aa \303\200", "aa", 0, 0, 2, "aa");
@@ -226,6 +230,10 @@ test_search_caseless (void)
   check_found_backward ("This is some \303\200 \303\240 text", "\303\200", flags, 15, 16, "\303\240");
   check_found_backward ("This is some \303\200 \303\240 text", "a\314\200", flags, 15, 16, "\303\240");
 
+  /* lines that can't match are skipped, but only if they are ASCII */
+  check_found_forward ("xyz\nxyz\nFOO", "foo", flags, 8, 11, "FOO");
+  check_found_forward ("xyz\nxyz\n\342\204\252elvin", "kelvin", flags, 8, 14, "\342\204\252elvin");
+
   /* new lines in the haystack */
   check_found_forward ("This is some\nfoo text", "foo", flags, 13, 16, "foo");
   check_found_forward ("This is some\nfoo text", "Foo", flags, 13, 16, "foo");
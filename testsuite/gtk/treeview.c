@@ -228,6 +228,67 @@ test_row_separator_height (void)
   gtk_widget_destroy (tree_view);
 }
 
+static gint
+test_estimate_row_heights_func (GtkTreeModel *model,
+                                GtkTreeIter  *iter,
+                                gpointer      data)
+{
+  return 50;
+}
+
+static void
+test_estimate_row_heights (void)
+{
+  GtkListStore *store;
+  GtkWidget *window;
+  GtkWidget *sw;
+  GtkWidget *tree_view;
+  GtkTreePath *path;
+  GdkRectangle rect = { 0, };
+  gint i;
+
+  store = gtk_list_store_new (1, G_TYPE_STRING);
+  for (i = 0; i < 10000; i++)
+    gtk_list_store_insert_with_values (store, NULL, i, 0, "Row content", -1);
+
+  window = gtk_window_new (GTK_WINDOW_TOPLEVEL);
+  gtk_window_set_default_size (GTK_WINDOW (window), 200, 200);
+  sw = gtk_scrolled_window_new (NULL, NULL);
+  gtk_container_add (GTK_CONTAINER (window), sw);
+
+  tree_view = gtk_tree_view_new ();
+  gtk_tree_view_set_estimate_row_heights (GTK_TREE_VIEW (tree_view), TRUE);
+  gtk_tree_view_set_row_height_func (GTK_TREE_VIEW (tree_view),
+                                     test_estimate_row_heights_func,
+                                     NULL, NULL);
+  gtk_tree_view_insert_column_with_attributes (GTK_TREE_VIEW (tree_view),
+                                               0,
+                                               "Test",
+                                               gtk_cell_renderer_text_new (),
+                                               "text", 0,
+                                               NULL);
+  gtk_tree_view_set_model (GTK_TREE_VIEW (tree_view), GTK_TREE_MODEL (store));
+  gtk_container_add (GTK_CONTAINER (sw), tree_view);
+
+  gtk_widget_show (window);
+  gtk_test_widget_wait_for_draw (window);
+
+  /* Visible rows are measured, rows far away keep the estimate */
+  path = gtk_tree_path_new_from_indices (0, -1);
+  gtk_tree_view_get_background_area (GTK_TREE_VIEW (tree_view), path, NULL, &rect);
+  gtk_tree_path_free (path);
+  g_assert_cmpint (rect.height, >, 0);
+  g_assert_cmpint (rect.height, <, 50);
+
+  path = gtk_tree_path_new_from_indices (9999, -1);
+  gtk_tree_view_get_background_area (GTK_TREE_VIEW (tree_view), path, NULL, &rect);
+  gtk_tree_path_free (path);
+  g_assert_cmpint (rect.height, ==, 50);
+
+  gtk_widget_destroy (window);
+  g_object_unref (store);
+}
+
 static void
 test_selection_count (void)
 {
@@ -335,6 +396,57 @@ test_selection_empty (void)
   gtk_widget_destroy (view);
 }
 
+static void
+test_insert_many (void)
+{
+  GtkTreeRowReference *reference;
+  GtkTreeSelection *selection;
+  GtkListStore *list_store;
+  GtkTreePath *path;
+  GtkWidget *view;
+  GValue values[10] = { G_VALUE_INIT, };
+  gint column = 0;
+  guint i;
+
+  list_store = gtk_list_store_new (1, G_TYPE_INT);
+  view = gtk_tree_view_new_with_model (GTK_TREE_MODEL (list_store));
+
+  gtk_list_store_insert_with_values (list_store, NULL, 0, 0, -1, -1);
+  gtk_list_store_insert_with_values (list_store, NULL, 1, 0, -2, -1);
+
+  path = gtk_tree_path_new_from_indices (1, -1);
+  reference = gtk_tree_row_reference_new (GTK_TREE_MODEL (list_store), path);
+  gtk_tree_path_free (path);
+
+  for (i = 0; i < G_N_ELEMENTS (values); i++)
+    {
+      g_value_init (&values[i], G_TYPE_INT);
+      g_value_set_int (&values[i], i);
+    }
+
+  /* Only the view listens to the store, so it gets all rows at once */
+  gtk_list_store_insert_many_with_valuesv (list_store, 1, G_N_ELEMENTS (values),
+                                           &column, values, 1);
+
+  path = gtk_tree_row_reference_get_path (reference);
+  g_assert_cmpint (gtk_tree_path_get_indices (path)[0], ==, 11);
+  gtk_tree_path_free (path);
+
+  selection = gtk_tree_view_get_selection (GTK_TREE_VIEW (view));
+  gtk_tree_selection_set_mode (selection, GTK_SELECTION_MULTIPLE);
+  gtk_tree_selection_select_all (selection);
+  g_assert_cmpint (gtk_tree_selection_count_selected_rows (selection), ==, 12);
+
+  path = gtk_tree_path_new_from_indices (10, -1);
+  g_assert_true (gtk_tree_selection_path_is_selected (selection, path));
+  gtk_tree_path_free (path);
+
+  for (i = 0; i < G_N_ELEMENTS (values); i++)
+    g_value_unset (&values[i]);
+  gtk_tree_row_reference_free (reference);
+  gtk_widget_destroy (view);
+}
+
 int
 main (int    argc,
       char **argv)
@@ -348,8 +460,11 @@ main (int    argc,
                    test_select_collapsed_row);
   g_test_add_func ("/TreeView/sizing/row-separator-height",
                    test_row_separator_height);
+  g_test_add_func ("/TreeView/sizing/estimate-row-heights",
+                   test_estimate_row_heights);
   g_test_add_func ("/TreeView/selection/count", test_selection_count);
   g_test_add_func ("/TreeView/selection/empty", test_selection_empty);
+  g_test_add_func ("/TreeView/model/insert-many", test_insert_many);
 
   return g_test_run ();
 }